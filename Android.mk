@@ -41,6 +41,7 @@ LOCAL_SRC_FILES := \
     android/net/android_network_library_impl.cc \
     android/ui/base/l10n/l10n_util.cc \
     \
+    app/sql/async_connection.cc \
     app/sql/connection.cc \
     app/sql/meta_table.cc \
     app/sql/statement.cc \
@@ -111,10 +112,13 @@ LOCAL_SRC_FILES += \
     base/i18n/time_formatting.cc \
     \
     base/json/json_reader.cc \
+    base/json/json_stream_parser.cc \
     base/json/json_writer.cc \
     base/json/string_escape.cc \
     \
+    base/memory/arena.cc \
     base/memory/ref_counted.cc \
+    base/memory/small_object_pool.cc \
     base/memory/weak_ptr.cc \
     \
     base/metrics/field_trial.cc \
@@ -124,6 +128,7 @@ LOCAL_SRC_FILES += \
     \
     base/synchronization/cancellation_flag.cc \
     base/synchronization/condition_variable_posix.cc \
+    base/synchronization/lock_contention_posix.cc \
     base/synchronization/lock_impl_posix.cc \
     base/synchronization/waitable_event_posix.cc \
     \
@@ -134,6 +139,7 @@ LOCAL_SRC_FILES += \
     base/threading/thread_local_posix.cc \
     base/threading/thread_local_storage_posix.cc \
     base/threading/worker_pool_posix.cc \
+    base/threading/worker_pool_sequence.cc \
     \
     base/third_party/icu/icu_utf.cc \
     \
@@ -149,6 +155,7 @@ LOCAL_SRC_FILES += \
     \
     net/base/address_list.cc \
     net/base/address_list_net_log_param.cc \
+    net/base/async_dns_resolver.cc \
     net/base/android_network_library.cc \
     net/base/auth.cc \
     net/base/backoff_entry.cc \
@@ -163,6 +170,7 @@ LOCAL_SRC_FILES += \
     net/base/cookie_store.cc \
     net/base/data_url.cc \
     net/base/directory_lister.cc \
+    net/base/dns_config.cc \
     net/base/dns_util.cc \
     net/base/dnsrr_resolver.cc \
     net/base/escape.cc \
@@ -172,16 +180,19 @@ LOCAL_SRC_FILES += \
     net/base/gzip_header.cc \
     net/base/host_cache.cc \
     net/base/host_mapping_rules.cc \
+    net/base/host_pattern_matcher.cc \
     net/base/host_port_pair.cc \
     net/base/host_resolver.cc \
     net/base/host_resolver_impl.cc \
     net/base/host_resolver_proc.cc \
     net/base/io_buffer.cc \
     net/base/ip_endpoint.cc \
+    net/base/load_timing_info.cc \
     net/base/mime_util.cc \
     net/base/net_errors.cc \
     net/base/net_errors_posix.cc \
     net/base/net_log.cc \
+    net/base/net_log_binary.cc \
     net/base/net_module.cc \
     net/base/net_util.cc \
     net/base/net_util_posix.cc \
@@ -189,6 +200,8 @@ LOCAL_SRC_FILES += \
     net/base/network_change_notifier_linux.cc \
     net/base/network_change_notifier_netlink_linux.cc \
     net/base/network_delegate.cc \
+    net/base/network_quality_estimator.cc \
+    net/base/network_tuning_profile.cc \
     net/base/openssl_memory_private_key_store.cc \
     net/base/pem_tokenizer.cc \
     net/base/platform_mime_util_android.cc \
@@ -215,24 +228,31 @@ LOCAL_SRC_FILES += \
     net/disk_cache/block_files.cc \
     net/disk_cache/cache_util_posix.cc \
     net/disk_cache/disk_format.cc \
+    net/disk_cache/entry_filter.cc \
     net/disk_cache/entry_impl.cc \
     net/disk_cache/eviction.cc \
     net/disk_cache/file.cc \
     net/disk_cache/file_lock.cc \
     net/disk_cache/file_posix.cc \
+    net/disk_cache/frequency_sketch.cc \
     net/disk_cache/hash.cc \
+    net/disk_cache/hot_set.cc \
     net/disk_cache/in_flight_backend_io.cc \
     net/disk_cache/in_flight_io.cc \
+    net/disk_cache/journal.cc \
     net/disk_cache/mapped_file_posix.cc \
     net/disk_cache/mem_backend_impl.cc \
     net/disk_cache/mem_entry_impl.cc \
     net/disk_cache/mem_rankings.cc \
+    net/disk_cache/mem_slab_allocator.cc \
     net/disk_cache/net_log_parameters.cc \
     net/disk_cache/rankings.cc \
+    net/disk_cache/sharded_backend.cc \
     net/disk_cache/stats.cc \
     net/disk_cache/stats_histogram.cc \
     net/disk_cache/sparse_control.cc \
     net/disk_cache/trace.cc \
+    net/disk_cache/verifier.cc \
     \
     net/ftp/ftp_auth_cache.cc \
     \
@@ -253,12 +273,16 @@ LOCAL_SRC_FILES += \
     net/http/http_basic_stream.cc \
     net/http/http_byte_range.cc \
     net/http/http_cache.cc \
+    net/http/http_cache_body_codec.cc \
     net/http/http_cache_transaction.cc \
     net/http/http_chunked_decoder.cc \
     net/http/http_net_log_params.cc \
     net/http/http_network_layer.cc \
     net/http/http_network_session.cc \
     net/http/http_network_transaction.cc \
+    net/http/http_pipelined_connection.cc \
+    net/http/http_pipelined_host_pool.cc \
+    net/http/http_pipelined_stream.cc \
     net/http/http_proxy_client_socket.cc \
     net/http/http_proxy_client_socket_pool.cc \
     net/http/http_proxy_utils.cc \
@@ -276,6 +300,7 @@ LOCAL_SRC_FILES += \
     net/http/http_util_icu.cc \
     net/http/http_vary_data.cc \
     net/http/md4.cc \
+    net/http/network_tuner.cc \
     net/http/partial_data.cc \
     \
     net/proxy/init_proxy_resolver.cc \
@@ -287,6 +312,7 @@ LOCAL_SRC_FILES += \
     net/proxy/proxy_info.cc \
     net/proxy/proxy_list.cc \
     net/proxy/proxy_resolver_js_bindings.cc \
+    net/proxy/proxy_resolver_script_cache.cc \
     net/proxy/proxy_resolver_script_data.cc \
     net/proxy/proxy_server.cc \
     net/proxy/proxy_service.cc \
@@ -307,8 +333,10 @@ LOCAL_SRC_FILES += \
     net/socket/ssl_client_socket_pool.cc \
     net/socket/ssl_error_params.cc \
     net/socket/ssl_host_info.cc \
+    net/socket/ssl_host_info_prefetcher.cc \
     net/socket/tcp_client_socket.cc \
     net/socket/tcp_client_socket_libevent.cc \
+    net/socket/tcp_info.cc \
     net/socket/transport_client_socket_pool.cc \
     \
     net/spdy/spdy_framer.cc \
@@ -321,6 +349,11 @@ LOCAL_SRC_FILES += \
     net/spdy/spdy_session_pool.cc \
     net/spdy/spdy_settings_storage.cc \
     net/spdy/spdy_stream.cc \
+    net/spdy/spdy_write_queue.cc \
+    \
+    net/udp/udp_client_socket.cc \
+    net/udp/udp_server_socket.cc \
+    net/udp/udp_socket_libevent.cc \
     \
     net/url_request/https_prober.cc \
     net/url_request/url_request.cc \
@@ -88,6 +88,16 @@ jstring ConvertUTF8ToJavaString(JNIEnv* env, std::string str)
     return env->NewStringUTF(str.c_str());
 }
 
+jclass FindClassGlobal(JNIEnv* env, const char* name)
+{
+    jclass local_class = env->FindClass(name);
+    if (checkException(env) || !local_class)
+        return NULL;
+    jclass global_class = static_cast<jclass>(env->NewGlobalRef(local_class));
+    env->DeleteLocalRef(local_class);
+    return global_class;
+}
+
 void DetachFromVM()
 {
     JavaVM* vm = getJavaVM();
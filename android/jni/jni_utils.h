@@ -27,6 +27,11 @@ jstring ConvertUTF8ToJavaString(JNIEnv* env, std::string str);
 
 bool CheckException(JNIEnv*);
 
+// Returns a global reference to the class |name|, or NULL if it is not found.
+// Meant to be kept for the lifetime of the process, so that the class and the
+// IDs of its members are looked up only once.
+jclass FindClassGlobal(JNIEnv* env, const char* name);
+
 void DetachFromVM();
 
 } // namespace jni
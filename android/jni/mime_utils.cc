@@ -5,25 +5,105 @@
 #include "android/jni/mime_utils.h"
 
 #include "android/jni/jni_utils.h"
+#include "base/hash_tables.h"
+#include "base/lazy_instance.h"
+#include "base/synchronization/lock.h"
 
-// Accessors for the various JNI binding objects.
 namespace {
 
-static jclass get_class(JNIEnv* env) {
-  static jclass clazz = env->FindClass("libcore/net/MimeUtils");
-  return clazz;
-}
+// The maximum number of answers that are kept for each direction. The tables
+// of libcore.net.MimeUtils never change, but the extensions come from URLs,
+// so the cache is dropped when it gets too big.
+const size_t kMaxCachedLookups = 500;
 
-static jmethodID guess_mime_type_from_extension(JNIEnv* env) {
-  static jmethodID method = env->GetStaticMethodID(get_class(env),
-      "guessMimeTypeFromExtension", "(Ljava/lang/String;)Ljava/lang/String;");
-  return method;
-}
+// The JNI binding objects, looked up the first time they are needed.
+class MimeUtilsJNI {
+ public:
+  MimeUtilsJNI() {
+    JNIEnv* env = android::jni::GetJNIEnv();
+    clazz_ = android::jni::FindClassGlobal(env, "libcore/net/MimeUtils");
+    guess_mime_type_from_extension_ = env->GetStaticMethodID(clazz_,
+        "guessMimeTypeFromExtension", "(Ljava/lang/String;)Ljava/lang/String;");
+    guess_extension_from_mime_type_ = env->GetStaticMethodID(clazz_,
+        "guessExtensionFromMimeType", "(Ljava/lang/String;)Ljava/lang/String;");
+  }
+
+  jclass clazz() const { return clazz_; }
+  jmethodID guess_mime_type_from_extension() const {
+    return guess_mime_type_from_extension_;
+  }
+  jmethodID guess_extension_from_mime_type() const {
+    return guess_extension_from_mime_type_;
+  }
+
+ private:
+  jclass clazz_;
+  jmethodID guess_mime_type_from_extension_;
+  jmethodID guess_extension_from_mime_type_;
+
+  DISALLOW_COPY_AND_ASSIGN(MimeUtilsJNI);
+};
+
+base::LazyInstance<MimeUtilsJNI> g_jni(base::LINKER_INITIALIZED);
+
+// Answers from Java, so that each key crosses JNI only once. An empty value
+// means that Java had no answer.
+class LookupCache {
+ public:
+  LookupCache() {}
+
+  bool Get(const std::string& key, std::string* value) {
+    base::AutoLock lock(lock_);
+    Map::const_iterator it = map_.find(key);
+    if (it == map_.end())
+      return false;
+    *value = it->second;
+    return true;
+  }
 
-static jmethodID guess_extension_from_mime_type(JNIEnv* env) {
-  static jmethodID method = env->GetStaticMethodID(get_class(env),
-      "guessExtensionFromMimeType", "(Ljava/lang/String;)Ljava/lang/String;");
-  return method;
+  void Put(const std::string& key, const std::string& value) {
+    base::AutoLock lock(lock_);
+    if (map_.size() >= kMaxCachedLookups)
+      map_.clear();
+    map_[key] = value;
+  }
+
+ private:
+  typedef base::hash_map<std::string, std::string> Map;
+
+  base::Lock lock_;
+  Map map_;
+
+  DISALLOW_COPY_AND_ASSIGN(LookupCache);
+};
+
+base::LazyInstance<LookupCache> g_mime_types(base::LINKER_INITIALIZED);
+base::LazyInstance<LookupCache> g_extensions(base::LINKER_INITIALIZED);
+
+// Calls |method| with |key|, going through |cache| first.
+bool Lookup(LookupCache* cache, jmethodID method, const std::string& key,
+            std::string* result) {
+  std::string value;
+  if (!cache->Get(key, &value)) {
+    JNIEnv* env = android::jni::GetJNIEnv();
+    jstring jKey = env->NewStringUTF(key.c_str());
+    jobject jResult = env->CallStaticObjectMethod(g_jni.Get().clazz(), method,
+                                                  jKey);
+    env->DeleteLocalRef(jKey);
+    if (android::jni::CheckException(env))
+      return false;
+    if (jResult) {
+      value = android::jni::JstringToStdString(env,
+                                               static_cast<jstring>(jResult));
+      env->DeleteLocalRef(jResult);
+    }
+    cache->Put(key, value);
+  }
+
+  if (value.empty())
+    return false;
+  *result = value;
+  return true;
 }
 
 } // namespace
@@ -32,31 +112,16 @@ namespace android {
 
 bool MimeUtils::GuessMimeTypeFromExtension(const std::string& extension,
     std::string* result) {
-  JNIEnv* env = jni::GetJNIEnv();
-  jstring jExtension = env->NewStringUTF(extension.c_str());
-  jobject jResult = env->CallStaticObjectMethod(
-      get_class(env), guess_mime_type_from_extension(env), jExtension);
-  env->DeleteLocalRef(jExtension);
-  if (jResult) {
-    *result = jni::JstringToStdString(env, static_cast<jstring>(jResult));
-    env->DeleteLocalRef(jResult);
-  }
-  return jResult;
+  return Lookup(g_mime_types.Pointer(),
+                g_jni.Get().guess_mime_type_from_extension(), extension,
+                result);
 }
 
 bool MimeUtils::GuessExtensionFromMimeType(const std::string& mimeType,
     std::string* result) {
-  JNIEnv* env = jni::GetJNIEnv();
-  jstring jMimeType = env->NewStringUTF(mimeType.c_str());
-  jobject jResult = env->CallStaticObjectMethod(
-      get_class(env), guess_extension_from_mime_type(env), jMimeType);
-  env->DeleteLocalRef(jMimeType);
-  if (jResult) {
-    *result = jni::JstringToStdString(env, static_cast<jstring>(jResult));
-    env->DeleteLocalRef(jResult);
-  }
-  return jResult;
+  return Lookup(g_extensions.Pointer(),
+                g_jni.Get().guess_extension_from_mime_type(), mimeType,
+                result);
 }
 
 } // namespace android
-
@@ -5,66 +5,124 @@
 #include "android/jni/jni_utils.h"
 #include "android/jni/platform_file_jni.h"
 #include "base/file_path.h"
+#include "base/lazy_instance.h"
 #include "base/logging.h"
 
+namespace {
+
+// The JNI binding objects, looked up the first time a content:// URL is used
+// instead of for every stream.
+class JniUtilJNI {
+ public:
+  JniUtilJNI() {
+    JNIEnv* env = android::jni::GetJNIEnv();
+    jclass inputStreamClass = env->FindClass("java/io/InputStream");
+    read_ = env->GetMethodID(inputStreamClass, "read", "([BII)I");
+    close_ = env->GetMethodID(inputStreamClass, "close", "()V");
+    env->DeleteLocalRef(inputStreamClass);
+
+    bridge_class_ = android::jni::FindClassGlobal(env,
+                                                  "android/webkit/JniUtil");
+    content_url_stream_ = env->GetStaticMethodID(
+        bridge_class_,
+        "contentUrlStream",
+        "(Ljava/lang/String;)Ljava/io/InputStream;");
+    content_url_size_ = env->GetStaticMethodID(
+        bridge_class_,
+        "contentUrlSize",
+        "(Ljava/lang/String;)J");
+  }
+
+  jclass bridge_class() const { return bridge_class_; }
+  jmethodID content_url_stream() const { return content_url_stream_; }
+  jmethodID content_url_size() const { return content_url_size_; }
+  jmethodID read() const { return read_; }
+  jmethodID close() const { return close_; }
+
+ private:
+  jclass bridge_class_;
+  jmethodID content_url_stream_;
+  jmethodID content_url_size_;
+  jmethodID read_;
+  jmethodID close_;
+
+  DISALLOW_COPY_AND_ASSIGN(JniUtilJNI);
+};
+
+base::LazyInstance<JniUtilJNI> g_jni(base::LINKER_INITIALIZED);
+
+}  // namespace
+
 namespace android {
 
-JavaISWrapper::JavaISWrapper(const FilePath& path) {
+JavaISWrapper::JavaISWrapper(const FilePath& path)
+    : m_inputStream(NULL),
+      m_buffer(NULL),
+      m_bufferLength(0) {
   JNIEnv* env = jni::GetJNIEnv();
-  jclass inputStreamClass = env->FindClass("java/io/InputStream");
-  m_read = env->GetMethodID(inputStreamClass, "read", "([B)I");
-  m_close = env->GetMethodID(inputStreamClass, "close", "()V");
-
-  jclass bridgeClass = env->FindClass("android/webkit/JniUtil");
-  jmethodID method = env->GetStaticMethodID(
-      bridgeClass,
-      "contentUrlStream",
-      "(Ljava/lang/String;)Ljava/io/InputStream;");
-  m_inputStream = env->NewGlobalRef(env->CallStaticObjectMethod(
-      bridgeClass,
-      method,
-      jni::ConvertUTF8ToJavaString(env, path.value())));
-  env->DeleteLocalRef(bridgeClass);
-  env->DeleteLocalRef(inputStreamClass);
+  const JniUtilJNI& bindings = g_jni.Get();
+  jstring jPath = jni::ConvertUTF8ToJavaString(env, path.value());
+  jobject inputStream = env->CallStaticObjectMethod(
+      bindings.bridge_class(), bindings.content_url_stream(), jPath);
+  env->DeleteLocalRef(jPath);
+  if (jni::CheckException(env) || !inputStream)
+    return;
+  m_inputStream = env->NewGlobalRef(inputStream);
+  env->DeleteLocalRef(inputStream);
 }
 
 JavaISWrapper::~JavaISWrapper() {
   JNIEnv* env = jni::GetJNIEnv();
-  env->CallVoidMethod(m_inputStream, m_close);
+  if (m_buffer)
+    env->DeleteGlobalRef(m_buffer);
+  if (!m_inputStream)
+    return;
+  env->CallVoidMethod(m_inputStream, g_jni.Get().close());
   jni::CheckException(env);
   env->DeleteGlobalRef(m_inputStream);
 }
 
 int JavaISWrapper::Read(char* out, int length) {
-  JNIEnv* env = jni::GetJNIEnv();
-  jbyteArray buffer = env->NewByteArray(length);
+  if (!m_inputStream || length <= 0)
+    return 0;
 
-  int size = (int) env->CallIntMethod(m_inputStream, m_read, buffer);
-  if (jni::CheckException(env) || size < 0) {
+  JNIEnv* env = jni::GetJNIEnv();
+  if (length > m_bufferLength) {
+    if (m_buffer)
+      env->DeleteGlobalRef(m_buffer);
+    jbyteArray buffer = env->NewByteArray(length);
+    if (jni::CheckException(env) || !buffer) {
+      m_buffer = NULL;
+      m_bufferLength = 0;
+      return 0;
+    }
+    m_buffer = static_cast<jbyteArray>(env->NewGlobalRef(buffer));
+    m_bufferLength = length;
     env->DeleteLocalRef(buffer);
-    return 0;
   }
 
-  env->GetByteArrayRegion(buffer, 0, size, (jbyte*)out);
-  env->DeleteLocalRef(buffer);
+  int size = (int) env->CallIntMethod(m_inputStream, g_jni.Get().read(),
+                                      m_buffer, 0, length);
+  if (jni::CheckException(env) || size < 0)
+    return 0;
+
+  env->GetByteArrayRegion(m_buffer, 0, size, (jbyte*)out);
   return size;
 }
 
 uint64 contentUrlSize(const FilePath& name) {
   JNIEnv* env = jni::GetJNIEnv();
-  jclass bridgeClass = env->FindClass("android/webkit/JniUtil");
-  jmethodID method = env->GetStaticMethodID(
-      bridgeClass,
-      "contentUrlSize",
-      "(Ljava/lang/String;)J");
+  const JniUtilJNI& bindings = g_jni.Get();
+  jstring jName = jni::ConvertUTF8ToJavaString(env, name.value());
   jlong length = env->CallStaticLongMethod(
-      bridgeClass,
-      method,
-      jni::ConvertUTF8ToJavaString(env, name.value()));
-  env->DeleteLocalRef(bridgeClass);
+      bindings.bridge_class(),
+      bindings.content_url_size(),
+      jName);
+  env->DeleteLocalRef(jName);
+  if (jni::CheckException(env))
+    return 0;
 
   return static_cast<uint64>(length);
 }
 
 }
-
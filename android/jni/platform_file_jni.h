@@ -20,8 +20,9 @@ public:
 
 private:
   jobject    m_inputStream;
-  jmethodID  m_read;
-  jmethodID  m_close;
+  // Reused by all the reads, and only replaced when a bigger one is needed.
+  jbyteArray m_buffer;
+  int        m_bufferLength;
 };
 
 }
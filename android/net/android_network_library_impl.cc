@@ -13,6 +13,35 @@ namespace {
 
 const char* const kClassPathName = "android/net/http/CertificateChainValidator";
 
+// From android.net.ConnectivityManager.
+const int kTypeMobile = 0;
+const int kTypeWifi = 1;
+const int kTypeWimax = 6;
+const int kTypeEthernet = 9;
+
+// From android.telephony.TelephonyManager.
+const int kNetworkTypeGprs = 1;
+const int kNetworkTypeEdge = 2;
+const int kNetworkTypeCdma = 4;
+const int kNetworkType1xRtt = 7;
+const int kNetworkTypeIden = 11;
+const int kNetworkTypeLte = 13;
+
+net::NetworkTuningProfile::ConnectionType MobileConnectionType(int subtype) {
+  switch (subtype) {
+    case kNetworkTypeGprs:
+    case kNetworkTypeEdge:
+    case kNetworkTypeCdma:
+    case kNetworkType1xRtt:
+    case kNetworkTypeIden:
+      return net::NetworkTuningProfile::CONNECTION_2G;
+    case kNetworkTypeLte:
+      return net::NetworkTuningProfile::CONNECTION_4G;
+    default:
+      return net::NetworkTuningProfile::CONNECTION_3G;
+  }
+}
+
 // Convert X509 chain to DER format bytes.
 jobjectArray GetCertificateByteArray(
     JNIEnv* env,
@@ -120,18 +149,41 @@ AndroidNetworkLibraryImpl::VerifyResult
   return result;
 }
 
+net::NetworkTuningProfile::ConnectionType
+    AndroidNetworkLibraryImpl::GetConnectionType() {
+  JNIEnv* env = jni::GetJNIEnv();
+  DCHECK(env);
+  net::NetworkTuningProfile::ConnectionType type =
+      GetConnectionTypeWithEnv(env);
+  // See VerifyX509CertChain() about detaching.
+  jni::DetachFromVM();
+  return type;
+}
+
 // static
 void AndroidNetworkLibraryImpl::InitWithApplicationContext(JNIEnv* env,
                                                            jobject context) {
-  // Currently ignoring |context| as it is not needed (but remains in signature
-  // for API consistency with the equivalent method on class AndroidOS).
   if (!net::AndroidNetworkLibrary::GetSharedInstance())
     net::AndroidNetworkLibrary::RegisterSharedInstance(
-        new AndroidNetworkLibraryImpl(env));
+        new AndroidNetworkLibraryImpl(env, context));
+}
+
+// static
+void AndroidNetworkLibraryImpl::OnConnectivityChanged(JNIEnv* env) {
+  // The shared instance is ours unless someone registered theirs before
+  // InitWithApplicationContext().
+  AndroidNetworkLibraryImpl* lib = static_cast<AndroidNetworkLibraryImpl*>(
+      net::AndroidNetworkLibrary::GetSharedInstance());
+  if (!lib)
+    return;
+  net::AndroidNetworkLibrary::NotifyConnectionTypeChanged(
+      lib->GetConnectionTypeWithEnv(env));
 }
 
-AndroidNetworkLibraryImpl::AndroidNetworkLibraryImpl(JNIEnv* env)
-    : cert_verifier_class_(NULL) {
+AndroidNetworkLibraryImpl::AndroidNetworkLibraryImpl(JNIEnv* env,
+                                                     jobject context)
+    : cert_verifier_class_(NULL),
+      connectivity_manager_(NULL) {
   jclass cls = env->FindClass(kClassPathName);
   if (jni::CheckException(env) || !cls) {
       NOTREACHED() << "Unable to load class " << kClassPathName;
@@ -139,10 +191,89 @@ AndroidNetworkLibraryImpl::AndroidNetworkLibraryImpl(JNIEnv* env)
     cert_verifier_class_ = static_cast<jclass>(env->NewGlobalRef(cls));
     env->DeleteLocalRef(cls);
   }
+
+  if (!context)
+    return;
+  jclass context_class = env->GetObjectClass(context);
+  jmethodID get_service_fn = env->GetMethodID(
+      context_class, "getSystemService",
+      "(Ljava/lang/String;)Ljava/lang/Object;");
+  env->DeleteLocalRef(context_class);
+  if (jni::CheckException(env) || !get_service_fn) {
+    env->ExceptionClear();
+    LOG(ERROR) << "getSystemService method not found";
+    return;
+  }
+  jstring service_name = jni::ConvertUTF8ToJavaString(env, "connectivity");
+  jobject manager = env->CallObjectMethod(context, get_service_fn,
+                                          service_name);
+  env->DeleteLocalRef(service_name);
+  if (jni::CheckException(env) || !manager) {
+    env->ExceptionClear();
+    LOG(ERROR) << "Unable to get the ConnectivityManager";
+    return;
+  }
+  connectivity_manager_ = env->NewGlobalRef(manager);
+  env->DeleteLocalRef(manager);
 }
 
 AndroidNetworkLibraryImpl::~AndroidNetworkLibraryImpl() {
   if (cert_verifier_class_)
     jni::GetJNIEnv()->DeleteGlobalRef(cert_verifier_class_);
+  if (connectivity_manager_)
+    jni::GetJNIEnv()->DeleteGlobalRef(connectivity_manager_);
+}
+
+net::NetworkTuningProfile::ConnectionType
+    AndroidNetworkLibraryImpl::GetConnectionTypeWithEnv(JNIEnv* env) {
+  if (!connectivity_manager_)
+    return net::NetworkTuningProfile::CONNECTION_UNKNOWN;
+
+  jclass manager_class = env->GetObjectClass(connectivity_manager_);
+  jmethodID get_info_fn = env->GetMethodID(
+      manager_class, "getActiveNetworkInfo", "()Landroid/net/NetworkInfo;");
+  env->DeleteLocalRef(manager_class);
+  if (jni::CheckException(env) || !get_info_fn) {
+    env->ExceptionClear();
+    return net::NetworkTuningProfile::CONNECTION_UNKNOWN;
+  }
+  jobject info = env->CallObjectMethod(connectivity_manager_, get_info_fn);
+  if (jni::CheckException(env)) {
+    env->ExceptionClear();
+    return net::NetworkTuningProfile::CONNECTION_UNKNOWN;
+  }
+  // There is no active network.
+  if (!info)
+    return net::NetworkTuningProfile::CONNECTION_NONE;
+
+  net::NetworkTuningProfile::ConnectionType result =
+      net::NetworkTuningProfile::CONNECTION_UNKNOWN;
+  jclass info_class = env->GetObjectClass(info);
+  jmethodID get_type_fn = env->GetMethodID(info_class, "getType", "()I");
+  jmethodID get_subtype_fn = env->GetMethodID(info_class, "getSubtype", "()I");
+  env->DeleteLocalRef(info_class);
+  if (!jni::CheckException(env) && get_type_fn && get_subtype_fn) {
+    int type = env->CallIntMethod(info, get_type_fn);
+    int subtype = env->CallIntMethod(info, get_subtype_fn);
+    if (!jni::CheckException(env)) {
+      switch (type) {
+        case kTypeMobile:
+          result = MobileConnectionType(subtype);
+          break;
+        case kTypeWifi:
+          result = net::NetworkTuningProfile::CONNECTION_WIFI;
+          break;
+        case kTypeWimax:
+          result = net::NetworkTuningProfile::CONNECTION_4G;
+          break;
+        case kTypeEthernet:
+          result = net::NetworkTuningProfile::CONNECTION_ETHERNET;
+          break;
+      }
+    }
+  }
+  env->ExceptionClear();
+  env->DeleteLocalRef(info);
+  return result;
 }
 
@@ -19,17 +19,29 @@ class NET_EXPORT AndroidNetworkLibraryImpl : public net::AndroidNetworkLibrary {
  public:
   static void InitWithApplicationContext(JNIEnv* env, jobject context);
 
+  // Called by the embedder, from a Java thread, when the platform reports a
+  // connectivity change.  Notifies the ConnectionTypeObservers.
+  static void OnConnectivityChanged(JNIEnv* env);
+
   virtual VerifyResult VerifyX509CertChain(
       const std::vector<std::string>& cert_chain,
       const std::string& hostname,
       const std::string& auth_type);
 
+  virtual net::NetworkTuningProfile::ConnectionType GetConnectionType();
+
  private:
-  explicit AndroidNetworkLibraryImpl(JNIEnv* env);
+  AndroidNetworkLibraryImpl(JNIEnv* env, jobject context);
   virtual ~AndroidNetworkLibraryImpl();
 
+  net::NetworkTuningProfile::ConnectionType GetConnectionTypeWithEnv(
+      JNIEnv* env);
+
   jclass cert_verifier_class_;
 
+  // The android.net.ConnectivityManager of the application context.
+  jobject connectivity_manager_;
+
   DISALLOW_COPY_AND_ASSIGN(AndroidNetworkLibraryImpl);
 };
 
@@ -0,0 +1,166 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "app/sql/async_connection.h"
+
+#include "base/file_path.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/message_loop_proxy.h"
+#include "base/metrics/histogram.h"
+
+namespace sql {
+
+AsyncConnection::AsyncConnection(const std::string& name,
+                                 base::TimeDelta commit_interval)
+    : commit_interval_(commit_interval),
+      queue_time_histogram_(base::Histogram::FactoryTimeGet(
+          "Sqlite." + name + ".QueueTime",
+          base::TimeDelta::FromMilliseconds(1),
+          base::TimeDelta::FromSeconds(10), 50,
+          base::Histogram::kUmaTargetedHistogramFlag)),
+      commit_time_histogram_(base::Histogram::FactoryTimeGet(
+          "Sqlite." + name + ".CommitTime",
+          base::TimeDelta::FromMilliseconds(1),
+          base::TimeDelta::FromSeconds(10), 50,
+          base::Histogram::kUmaTargetedHistogramFlag)),
+      thread_((name + "DBThread").c_str()),
+      batch_writes_(0),
+      batch_number_(0) {
+}
+
+AsyncConnection::~AsyncConnection() {
+  if (thread_.message_loop()) {
+    thread_.message_loop()->PostTask(
+        FROM_HERE,
+        NewRunnableMethod(this, &AsyncConnection::CloseOnDBThread));
+    // Runs the tasks posted before, and the one above.
+    thread_.Stop();
+  }
+}
+
+bool AsyncConnection::Start(const FilePath& path) {
+  DCHECK(!thread_.message_loop());
+  if (!thread_.Start())
+    return false;
+  thread_.message_loop()->PostTask(
+      FROM_HERE,
+      NewRunnableMethod(this, &AsyncConnection::OpenOnDBThread, path));
+  return true;
+}
+
+void AsyncConnection::Read(Operation* read, Task* reply) {
+  if (!thread_.message_loop()) {
+    NOTREACHED() << "AsyncConnection is not started.";
+    delete read;
+    delete reply;
+    return;
+  }
+  thread_.message_loop()->PostTask(
+      FROM_HERE,
+      NewRunnableMethod(this, &AsyncConnection::ReadOnDBThread, read,
+                        base::TimeTicks::Now(), reply,
+                        base::MessageLoopProxy::CreateForCurrentThread()));
+}
+
+void AsyncConnection::Write(Operation* write) {
+  if (!thread_.message_loop()) {
+    NOTREACHED() << "AsyncConnection is not started.";
+    delete write;
+    return;
+  }
+  thread_.message_loop()->PostTask(
+      FROM_HERE,
+      NewRunnableMethod(this, &AsyncConnection::WriteOnDBThread, write,
+                        base::TimeTicks::Now()));
+}
+
+void AsyncConnection::Flush(Task* reply) {
+  if (!thread_.message_loop()) {
+    NOTREACHED() << "AsyncConnection is not started.";
+    delete reply;
+    return;
+  }
+  thread_.message_loop()->PostTask(
+      FROM_HERE,
+      NewRunnableMethod(this, &AsyncConnection::FlushOnDBThread, reply,
+                        base::MessageLoopProxy::CreateForCurrentThread()));
+}
+
+void AsyncConnection::OpenOnDBThread(const FilePath& path) {
+  if (!connection_.Open(path))
+    LOG(ERROR) << "Could not open " << path.value();
+}
+
+void AsyncConnection::ReadOnDBThread(
+    Operation* read,
+    base::TimeTicks queued,
+    Task* reply,
+    scoped_refptr<base::MessageLoopProxy> reply_loop) {
+  scoped_ptr<Operation> scoped_read(read);
+  queue_time_histogram_->AddTime(base::TimeTicks::Now() - queued);
+  read->Run(&connection_);
+  PostReply(reply, reply_loop);
+}
+
+void AsyncConnection::WriteOnDBThread(Operation* write,
+                                      base::TimeTicks queued) {
+  scoped_ptr<Operation> scoped_write(write);
+  queue_time_histogram_->AddTime(base::TimeTicks::Now() - queued);
+  if (!batch_writes_ && connection_.is_open()) {
+    if (connection_.BeginTransaction()) {
+      MessageLoop::current()->PostDelayedTask(
+          FROM_HERE,
+          NewRunnableMethod(this, &AsyncConnection::CommitBatchOnDBThread,
+                            batch_number_),
+          commit_interval_.InMilliseconds());
+    }
+  }
+  batch_writes_++;
+  write->Run(&connection_);
+  if (batch_writes_ >= kMaxWritesPerCommit)
+    CommitOnDBThread();
+}
+
+void AsyncConnection::FlushOnDBThread(
+    Task* reply,
+    scoped_refptr<base::MessageLoopProxy> reply_loop) {
+  CommitOnDBThread();
+  PostReply(reply, reply_loop);
+}
+
+void AsyncConnection::CloseOnDBThread() {
+  CommitOnDBThread();
+  connection_.Close();
+}
+
+void AsyncConnection::CommitBatchOnDBThread(int batch) {
+  if (batch == batch_number_)
+    CommitOnDBThread();
+}
+
+void AsyncConnection::CommitOnDBThread() {
+  if (!batch_writes_)
+    return;
+  batch_writes_ = 0;
+  batch_number_++;
+  if (!connection_.transaction_nesting())
+    return;  // The transaction couldn't be started.
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  if (!connection_.CommitTransaction())
+    LOG(WARNING) << "Could not commit: " << connection_.GetErrorMessage();
+  commit_time_histogram_->AddTime(base::TimeTicks::Now() - start);
+}
+
+// static
+void AsyncConnection::PostReply(
+    Task* reply,
+    scoped_refptr<base::MessageLoopProxy> reply_loop) {
+  if (reply)
+    reply_loop->PostTask(FROM_HERE, reply);
+}
+
+}  // namespace sql
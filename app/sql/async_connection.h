@@ -0,0 +1,126 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef APP_SQL_ASYNC_CONNECTION_H_
+#define APP_SQL_ASYNC_CONNECTION_H_
+#pragma once
+
+#include <string>
+
+#include "app/sql/connection.h"
+#include "base/basictypes.h"
+#include "base/callback.h"
+#include "base/memory/ref_counted.h"
+#include "base/task.h"
+#include "base/threading/thread.h"
+#include "base/time.h"
+
+class FilePath;
+
+namespace base {
+class Histogram;
+class MessageLoopProxy;
+}
+
+namespace sql {
+
+// AsyncConnection runs a Connection on a thread of its own, so that the
+// threads using the database never wait on the disk.  Reads and writes are
+// operations run on that thread in the order they were given.
+//
+// Writes are grouped into one transaction, which is committed
+// |commit_interval| after its first write, or as soon as it holds
+// kMaxWritesPerCommit writes, so that many small writes share the cost of a
+// commit.  Reads run inside the same transaction, so they see every write
+// given before them, committed or not.
+//
+//   sql::AsyncConnection db("History", base::TimeDelta::FromSeconds(1));
+//   db.connection()->set_page_size(4096);
+//   db.Start(path);
+//   db.Write(NewCallback(this, &Foo::AddRowOnDBThread));
+//   db.Read(NewCallback(this, &Foo::ReadRowsOnDBThread),
+//           NewRunnableMethod(this, &Foo::OnRowsRead));
+//
+// Since sqlite can't nest transactions, a write that rolls back its own
+// sql::Transaction rolls back the rest of its batch as well.
+//
+// How long operations waited for the database thread, and how long commits
+// took, are recorded in the histograms "Sqlite.<name>.QueueTime" and
+// "Sqlite.<name>.CommitTime".
+class AsyncConnection {
+ public:
+  // Run on the database thread with the connection, which is open unless
+  // opening it failed.
+  typedef Callback1<Connection*>::Type Operation;
+
+  static const int kMaxWritesPerCommit = 100;
+
+  // |name| names the database thread and the histograms.
+  AsyncConnection(const std::string& name, base::TimeDelta commit_interval);
+
+  // Commits the waiting writes and closes the database, waiting for both.
+  ~AsyncConnection();
+
+  // For setting the options of the connection before Start().  After that,
+  // the connection may only be used by operations.
+  Connection* connection() { return &connection_; }
+
+  // Starts the database thread and opens |path| there.  Returns false if the
+  // thread couldn't be started.
+  bool Start(const FilePath& path);
+
+  // Runs |read| on the database thread, and then |reply|, which may be NULL,
+  // on the calling thread.  Takes ownership of both.
+  void Read(Operation* read, Task* reply);
+
+  // Runs |write| on the database thread as part of the current batch of
+  // writes.  Takes ownership of |write|.
+  void Write(Operation* write);
+
+  // Commits the current batch of writes, and then runs |reply|, which may be
+  // NULL, on the calling thread.  Takes ownership of |reply|.
+  void Flush(Task* reply);
+
+ private:
+  void OpenOnDBThread(const FilePath& path);
+  void ReadOnDBThread(Operation* read,
+                      base::TimeTicks queued,
+                      Task* reply,
+                      scoped_refptr<base::MessageLoopProxy> reply_loop);
+  void WriteOnDBThread(Operation* write, base::TimeTicks queued);
+  void FlushOnDBThread(Task* reply,
+                       scoped_refptr<base::MessageLoopProxy> reply_loop);
+  void CloseOnDBThread();
+
+  // Commits the current batch, if it is still batch number |batch|.
+  void CommitBatchOnDBThread(int batch);
+  void CommitOnDBThread();
+
+  // Posts |reply|, if there is one, to |reply_loop|.
+  static void PostReply(Task* reply,
+                        scoped_refptr<base::MessageLoopProxy> reply_loop);
+
+  const base::TimeDelta commit_interval_;
+  base::Histogram* queue_time_histogram_;
+  base::Histogram* commit_time_histogram_;
+
+  base::Thread thread_;
+
+  // Only used on |thread_| once it is started.
+  Connection connection_;
+
+  // The writes in the open transaction, and which batch it is.  Only used on
+  // |thread_|.
+  int batch_writes_;
+  int batch_number_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncConnection);
+};
+
+}  // namespace sql
+
+// The thread of an AsyncConnection, and so its tasks, never outlive it.
+DISABLE_RUNNABLE_METHOD_REFCOUNT(sql::AsyncConnection);
+
+#endif  // APP_SQL_ASYNC_CONNECTION_H_
@@ -0,0 +1,140 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "app/sql/async_connection.h"
+#include "app/sql/statement.h"
+#include "base/file_util.h"
+#include "base/memory/scoped_temp_dir.h"
+#include "base/message_loop.h"
+#include "base/threading/platform_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+// The operations the tests run.  |rows_| is set on the database thread and
+// read on the test thread once the reply has come back.
+class Operations {
+ public:
+  Operations() : rows_(-1) {}
+
+  void CreateTable(sql::Connection* db) {
+    EXPECT_TRUE(db->Execute("CREATE TABLE foo (a)"));
+  }
+
+  void InsertRow(sql::Connection* db) {
+    EXPECT_TRUE(db->Execute("INSERT INTO foo (a) VALUES (12)"));
+  }
+
+  void CountRows(sql::Connection* db) {
+    sql::Statement s(db->GetUniqueStatement("SELECT COUNT(*) FROM foo"));
+    rows_ = s && s.Step() ? s.ColumnInt(0) : -1;
+  }
+
+  int rows() const { return rows_; }
+
+ private:
+  int rows_;
+};
+
+// Returns how many rows another connection sees, or -1 if it doesn't see the
+// table.
+int CountCommittedRows(const FilePath& path) {
+  sql::Connection db;
+  if (!db.Open(path) || !db.DoesTableExist("foo"))
+    return -1;
+  sql::Statement s(db.GetUniqueStatement("SELECT COUNT(*) FROM foo"));
+  return s && s.Step() ? s.ColumnInt(0) : -1;
+}
+
+class SQLAsyncConnectionTest : public testing::Test {
+ public:
+  void SetUp() {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  }
+
+  FilePath db_path() {
+    return temp_dir_.path().AppendASCII("SQLAsyncConnectionTest.db");
+  }
+
+  // Waits for the operations given to |db| so far.
+  void Read(sql::AsyncConnection* db, Operations* operations) {
+    db->Read(NewCallback(operations, &Operations::CountRows),
+             new MessageLoop::QuitTask());
+    MessageLoop::current()->Run();
+  }
+
+  void Flush(sql::AsyncConnection* db) {
+    db->Flush(new MessageLoop::QuitTask());
+    MessageLoop::current()->Run();
+  }
+
+ private:
+  MessageLoop message_loop_;
+  ScopedTempDir temp_dir_;
+};
+
+}  // namespace
+
+TEST_F(SQLAsyncConnectionTest, ReadsSeeBatchedWrites) {
+  // Long enough that the batch is only committed when asked.
+  sql::AsyncConnection db("Test", base::TimeDelta::FromHours(1));
+  ASSERT_TRUE(db.Start(db_path()));
+  Operations operations;
+
+  db.Write(NewCallback(&operations, &Operations::CreateTable));
+  db.Write(NewCallback(&operations, &Operations::InsertRow));
+  db.Write(NewCallback(&operations, &Operations::InsertRow));
+  Read(&db, &operations);
+  EXPECT_EQ(2, operations.rows());
+
+  // Nothing is committed yet.
+  EXPECT_EQ(-1, CountCommittedRows(db_path()));
+
+  Flush(&db);
+  EXPECT_EQ(2, CountCommittedRows(db_path()));
+
+  // A later write starts another batch.
+  db.Write(NewCallback(&operations, &Operations::InsertRow));
+  Read(&db, &operations);
+  EXPECT_EQ(3, operations.rows());
+  EXPECT_EQ(2, CountCommittedRows(db_path()));
+}
+
+TEST_F(SQLAsyncConnectionTest, CommitsFullBatches) {
+  sql::AsyncConnection db("Test", base::TimeDelta::FromHours(1));
+  ASSERT_TRUE(db.Start(db_path()));
+  Operations operations;
+
+  db.Write(NewCallback(&operations, &Operations::CreateTable));
+  for (int i = 1; i < sql::AsyncConnection::kMaxWritesPerCommit + 10; ++i)
+    db.Write(NewCallback(&operations, &Operations::InsertRow));
+  Read(&db, &operations);
+  EXPECT_EQ(sql::AsyncConnection::kMaxWritesPerCommit + 9, operations.rows());
+  EXPECT_EQ(sql::AsyncConnection::kMaxWritesPerCommit - 1,
+            CountCommittedRows(db_path()));
+}
+
+TEST_F(SQLAsyncConnectionTest, CommitsAfterInterval) {
+  sql::AsyncConnection db("Test", base::TimeDelta::FromMilliseconds(10));
+  ASSERT_TRUE(db.Start(db_path()));
+  Operations operations;
+
+  db.Write(NewCallback(&operations, &Operations::CreateTable));
+  db.Write(NewCallback(&operations, &Operations::InsertRow));
+  // The commit is due well before the read, so it runs first.
+  base::PlatformThread::Sleep(100);
+  Read(&db, &operations);
+  EXPECT_EQ(1, CountCommittedRows(db_path()));
+}
+
+TEST_F(SQLAsyncConnectionTest, CommitsWhenDeleted) {
+  {
+    sql::AsyncConnection db("Test", base::TimeDelta::FromHours(1));
+    ASSERT_TRUE(db.Start(db_path()));
+    Operations operations;
+    db.Write(NewCallback(&operations, &Operations::CreateTable));
+    db.Write(NewCallback(&operations, &Operations::InsertRow));
+  }
+  EXPECT_EQ(1, CountCommittedRows(db_path()));
+}
@@ -8,6 +8,7 @@
 
 #include "app/sql/statement.h"
 #include "base/file_path.h"
+#include "base/format_macros.h"
 #include "base/logging.h"
 #include "base/string_util.h"
 #include "base/utf_string_conversions.h"
@@ -90,6 +91,13 @@ Connection::Connection()
       page_size_(0),
       cache_size_(0),
       exclusive_locking_(false),
+      write_ahead_log_(false),
+      synchronous_(SYNCHRONOUS_DEFAULT),
+      mmap_size_(0),
+      max_cached_statements_(kDefaultStatementCacheSize),
+      statement_cache_hits_(0),
+      statement_cache_misses_(0),
+      statement_cache_evictions_(0),
       transaction_nesting_(0),
       needs_rollback_(false) {
 }
@@ -110,8 +118,14 @@ bool Connection::OpenInMemory() {
   return OpenInternal(":memory:");
 }
 
+void Connection::set_statement_cache_size(size_t size) {
+  max_cached_statements_ = size;
+  TrimCache();
+}
+
 void Connection::Close() {
   statement_cache_.clear();
+  statement_lru_.clear();
   DCHECK(open_statements_.empty());
   if (db_) {
     sqlite3_close(db_);
@@ -230,14 +244,22 @@ scoped_refptr<Connection::StatementRef> Connection::GetCachedStatement(
     // one invalidating cached statements, and we'll remove it from the cache
     // if we do that. Make sure we reset it before giving out the cached one in
     // case it still has some stuff bound.
-    DCHECK(i->second->is_valid());
-    sqlite3_reset(i->second->stmt());
-    return i->second;
+    statement_cache_hits_++;
+    statement_lru_.splice(statement_lru_.begin(), statement_lru_, i->second);
+    scoped_refptr<StatementRef> statement = i->second->second;
+    DCHECK(statement->is_valid());
+    sqlite3_reset(statement->stmt());
+    return statement;
   }
 
+  statement_cache_misses_++;
   scoped_refptr<StatementRef> statement = GetUniqueStatement(sql);
-  if (statement->is_valid())
-    statement_cache_[id] = statement;  // Only cache valid statements.
+  if (statement->is_valid()) {
+    // Only cache valid statements.
+    statement_lru_.push_front(std::make_pair(id, statement));
+    statement_cache_[id] = statement_lru_.begin();
+    TrimCache();
+  }
   return statement;
 }
 
@@ -379,6 +401,31 @@ bool Connection::OpenInternal(const std::string& file_name) {
       NOTREACHED() << "Could not set cache size: " << GetErrorMessage();
   }
 
+  if (write_ahead_log_) {
+    // Not fatal: sqlite falls back to the rollback journal, e.g. for
+    // databases on filesystems without shared memory.
+    if (!ExecuteWithTimeout("PRAGMA journal_mode=WAL", kBusyTimeout))
+      LOG(WARNING) << "Could not use a write-ahead log: " << GetErrorMessage();
+  }
+
+  if (mmap_size_ != 0) {
+    // Not fatal: sqlite builds without memory mapping just read.
+    const std::string sql =
+        StringPrintf("PRAGMA mmap_size=%" PRId64, mmap_size_);
+    if (!ExecuteWithTimeout(sql.c_str(), kBusyTimeout))
+      LOG(WARNING) << "Could not set mmap size: " << GetErrorMessage();
+  }
+
+  if (synchronous_ != SYNCHRONOUS_DEFAULT) {
+    static const char* const kSynchronousModes[] = {
+      NULL, "OFF", "NORMAL", "FULL",
+    };
+    const std::string sql =
+        StringPrintf("PRAGMA synchronous=%s", kSynchronousModes[synchronous_]);
+    if (!ExecuteWithTimeout(sql.c_str(), kBusyTimeout))
+      NOTREACHED() << "Could not set synchronous mode: " << GetErrorMessage();
+  }
+
   return true;
 }
 
@@ -403,6 +450,7 @@ void Connection::StatementRefDeleted(StatementRef* ref) {
 
 void Connection::ClearCache() {
   statement_cache_.clear();
+  statement_lru_.clear();
 
   // The cache clear will get most statements. There may be still be references
   // to some statements that are held by others (including one-shot statements).
@@ -412,6 +460,17 @@ void Connection::ClearCache() {
     (*i)->Close();
 }
 
+void Connection::TrimCache() {
+  if (!max_cached_statements_)
+    return;
+  while (statement_cache_.size() > max_cached_statements_) {
+    // Anyone still holding the statement keeps it alive until they're done.
+    statement_cache_.erase(statement_lru_.back().first);
+    statement_lru_.pop_back();
+    statement_cache_evictions_++;
+  }
+}
+
 int Connection::OnSqliteError(int err, sql::Statement *stmt) {
   if (error_delegate_.get())
     return error_delegate_->OnError(err, this, stmt);
@@ -6,9 +6,11 @@
 #define APP_SQL_CONNECTION_H_
 #pragma once
 
+#include <list>
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
 
 #include "base/basictypes.h"
 #include "base/memory/ref_counted.h"
@@ -137,6 +139,42 @@ class Connection {
   // This must be called before Open() to have an effect.
   void set_exclusive_locking() { exclusive_locking_ = true; }
 
+  // Call to use a write-ahead log rather than a rollback journal.  Readers
+  // and a writer can then proceed at the same time, and a commit appends to
+  // the log rather than rewriting pages in the database, which needs fewer
+  // syncs.  Like exclusive locking, there is no way back.
+  //
+  // This must be called before Open() to have an effect.
+  void set_write_ahead_log() { write_ahead_log_ = true; }
+
+  // How often sqlite waits for data to reach the disk; see "PRAGMA
+  // synchronous" on sqlite.org.  With a write-ahead log, SYNCHRONOUS_NORMAL
+  // only syncs at checkpoints, at the risk of losing the last commits (but
+  // not corrupting the database) on power loss.
+  enum SynchronousMode {
+    SYNCHRONOUS_DEFAULT,  // Whatever sqlite was built with.
+    SYNCHRONOUS_OFF,
+    SYNCHRONOUS_NORMAL,
+    SYNCHRONOUS_FULL,
+  };
+
+  // This must be called before Open() to have an effect.
+  void set_synchronous(SynchronousMode mode) { synchronous_ = mode; }
+
+  // Sets how many bytes of the database file sqlite may map into memory.
+  // Reads of the mapped part then come straight from the OS page cache
+  // instead of being copied into sqlite's own.  Versions of sqlite before
+  // 3.7.17 ignore this.  Zero means use the default, which is usually no
+  // mapping.
+  //
+  // This must be called before Open() to have an effect.
+  void set_mmap_size(int64 mmap_size) { mmap_size_ = mmap_size; }
+
+  // Sets how many statements GetCachedStatement() keeps compiled.  When the
+  // cache is full, the least recently used statement is dropped to make
+  // room.  Zero means no limit.  Defaults to kDefaultStatementCacheSize.
+  void set_statement_cache_size(size_t size);
+
   // Sets the object that will handle errors. Recomended that it should be set
   // before calling Open(). If not set, the default is to ignore errors on
   // release and assert on debug builds.
@@ -242,6 +280,14 @@ class Connection {
   // See GetCachedStatement above for examples and error information.
   scoped_refptr<StatementRef> GetUniqueStatement(const char* sql);
 
+  static const size_t kDefaultStatementCacheSize = 64;
+
+  // How many times GetCachedStatement() found the statement in the cache,
+  // had to compile it, and dropped another statement to make room for it.
+  int statement_cache_hits() const { return statement_cache_hits_; }
+  int statement_cache_misses() const { return statement_cache_misses_; }
+  int statement_cache_evictions() const { return statement_cache_evictions_; }
+
   // Info querying -------------------------------------------------------------
 
   // Returns true if the given table exists.
@@ -338,6 +384,10 @@ class Connection {
   // Frees all cached statements from statement_cache_.
   void ClearCache();
 
+  // Drops the least recently used statements until there are no more than
+  // |max_cached_statements_|.
+  void TrimCache();
+
   // Called by Statement objects when an sqlite function returns an error.
   // The return value is the error code reflected back to client code.
   int OnSqliteError(int err, Statement* stmt);
@@ -354,13 +404,26 @@ class Connection {
   int page_size_;
   int cache_size_;
   bool exclusive_locking_;
-
-  // All cached statements. Keeping a reference to these statements means that
-  // they'll remain active.
-  typedef std::map<StatementID, scoped_refptr<StatementRef> >
+  bool write_ahead_log_;
+  SynchronousMode synchronous_;
+  int64 mmap_size_;
+
+  // All cached statements, the most recently used first. Keeping a reference
+  // to these statements means that they'll remain active.
+  typedef std::list<std::pair<StatementID, scoped_refptr<StatementRef> > >
+      CachedStatementList;
+  CachedStatementList statement_lru_;
+
+  // Where each cached statement is in |statement_lru_|.
+  typedef std::map<StatementID, CachedStatementList::iterator>
       CachedStatementMap;
   CachedStatementMap statement_cache_;
 
+  size_t max_cached_statements_;
+  int statement_cache_hits_;
+  int statement_cache_misses_;
+  int statement_cache_evictions_;
+
   // A list of all StatementRefs we've given out. Each ref must register with
   // us when it's created or destroyed. This allows us to potentially close
   // any open statements when we encounter an error.
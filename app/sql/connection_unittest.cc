@@ -15,7 +15,7 @@ class SQLConnectionTest : public testing::Test {
 
   void SetUp() {
     ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
-    ASSERT_TRUE(db_.Open(temp_dir_.path().AppendASCII("SQLConnectionTest.db")));
+    ASSERT_TRUE(db_.Open(db_path()));
   }
 
   void TearDown() {
@@ -24,6 +24,10 @@ class SQLConnectionTest : public testing::Test {
 
   sql::Connection& db() { return db_; }
 
+  FilePath db_path() {
+    return temp_dir_.path().AppendASCII("SQLConnectionTest.db");
+  }
+
  private:
   ScopedTempDir temp_dir_;
   sql::Connection db_;
@@ -104,3 +108,90 @@ TEST_F(SQLConnectionTest, GetLastInsertRowId) {
   EXPECT_EQ(12, s.ColumnInt(0));
 }
 
+
+TEST_F(SQLConnectionTest, WriteAheadLog) {
+  db().Close();
+
+  sql::Connection wal_db;
+  wal_db.set_write_ahead_log();
+  wal_db.set_synchronous(sql::Connection::SYNCHRONOUS_NORMAL);
+  ASSERT_TRUE(wal_db.Open(db_path()));
+
+  // The statements are scoped so that they don't hold a transaction open.
+  {
+    sql::Statement journal_mode(
+        wal_db.GetUniqueStatement("PRAGMA journal_mode"));
+    ASSERT_TRUE(journal_mode.Step());
+    EXPECT_EQ("wal", journal_mode.ColumnString(0));
+
+    // 1 is NORMAL.
+    sql::Statement synchronous(wal_db.GetUniqueStatement("PRAGMA synchronous"));
+    ASSERT_TRUE(synchronous.Step());
+    EXPECT_EQ(1, synchronous.ColumnInt(0));
+  }
+
+  // Writes still work, and are seen by other connections.
+  ASSERT_TRUE(wal_db.Execute("CREATE TABLE foo (a, b)"));
+  ASSERT_TRUE(wal_db.Execute("INSERT INTO foo (a, b) VALUES (12, 13)"));
+  sql::Connection other_db;
+  ASSERT_TRUE(other_db.Open(db_path()));
+  sql::Statement s(other_db.GetUniqueStatement("SELECT b FROM foo"));
+  ASSERT_TRUE(s.Step());
+  EXPECT_EQ(13, s.ColumnInt(0));
+}
+
+TEST_F(SQLConnectionTest, StatementCacheLimit) {
+  sql::StatementID id1("foo", 1);
+  sql::StatementID id2("foo", 2);
+  sql::StatementID id3("foo", 3);
+
+  ASSERT_TRUE(db().Execute("CREATE TABLE foo (a, b)"));
+  db().set_statement_cache_size(2);
+  const int misses = db().statement_cache_misses();
+
+  {
+    sql::Statement s1(db().GetCachedStatement(id1, "SELECT a FROM foo"));
+    sql::Statement s2(db().GetCachedStatement(id2, "SELECT b FROM foo"));
+    ASSERT_TRUE(s1 && s2);
+  }
+  // Using |id1| again makes |id2| the least recently used.
+  {
+    sql::Statement s1(db().GetCachedStatement(id1, "SELECT a FROM foo"));
+    ASSERT_TRUE(s1);
+  }
+  EXPECT_EQ(1, db().statement_cache_hits());
+
+  // A statement still in use when it's dropped from the cache keeps working.
+  sql::Statement s2(db().GetCachedStatement(id2, "SELECT b FROM foo"));
+  ASSERT_TRUE(db().Execute("INSERT INTO foo (a, b) VALUES (12, 13)"));
+  {
+    sql::Statement s3(db().GetCachedStatement(id3, "SELECT a, b FROM foo"));
+    ASSERT_TRUE(s3);
+  }
+  EXPECT_TRUE(db().HasCachedStatement(id3));
+  EXPECT_TRUE(db().HasCachedStatement(id2));
+  EXPECT_FALSE(db().HasCachedStatement(id1));
+  EXPECT_EQ(1, db().statement_cache_evictions());
+  EXPECT_EQ(misses + 3, db().statement_cache_misses());
+  ASSERT_TRUE(s2.Step());
+  EXPECT_EQ(13, s2.ColumnInt(0));
+
+  // Shrinking the cache drops the oldest statements right away.
+  db().set_statement_cache_size(1);
+  EXPECT_TRUE(db().HasCachedStatement(id3));
+  EXPECT_FALSE(db().HasCachedStatement(id2));
+  EXPECT_EQ(2, db().statement_cache_evictions());
+}
+
+TEST_F(SQLConnectionTest, MmapSize) {
+  db().Close();
+
+  sql::Connection mmap_db;
+  mmap_db.set_mmap_size(1024 * 1024);
+  ASSERT_TRUE(mmap_db.Open(db_path()));
+  ASSERT_TRUE(mmap_db.Execute("CREATE TABLE foo (a, b)"));
+  ASSERT_TRUE(mmap_db.Execute("INSERT INTO foo (a, b) VALUES (12, 13)"));
+  sql::Statement s(mmap_db.GetUniqueStatement("SELECT b FROM foo"));
+  ASSERT_TRUE(s.Step());
+  EXPECT_EQ(13, s.ColumnInt(0));
+}
@@ -121,6 +121,7 @@
         'file_path_unittest.cc',
         'file_util_unittest.cc',
         'file_version_info_unittest.cc',
+        'flat_hash_map_unittest.cc',
         'gmock_unittest.cc',
         'id_map_unittest.cc',
         'i18n/break_iterator_unittest.cc',
@@ -129,12 +130,14 @@
         'i18n/icu_string_conversions_unittest.cc',
         'i18n/rtl_unittest.cc',
         'json/json_reader_unittest.cc',
+        'json/json_stream_parser_unittest.cc',
         'json/json_writer_unittest.cc',
         'json/string_escape_unittest.cc',
         'lazy_instance_unittest.cc',
         'linked_list_unittest.cc',
         'logging_unittest.cc',
         'mac/mac_util_unittest.mm',
+        'memory/arena_unittest.cc',
         'memory/linked_ptr_unittest.cc',
         'memory/ref_counted_unittest.cc',
         'memory/scoped_native_library_unittest.cc',
@@ -142,6 +145,7 @@
         'memory/scoped_temp_dir_unittest.cc',
         'memory/scoped_vector_unittest.cc',
         'memory/singleton_unittest.cc',
+        'memory/small_object_pool_unittest.cc',
         'memory/weak_ptr_unittest.cc',
         'message_loop_proxy_impl_unittest.cc',
         'message_loop_unittest.cc',
@@ -190,6 +194,7 @@
         'threading/thread_unittest.cc',
         'threading/watchdog_unittest.cc',
         'threading/worker_pool_posix_unittest.cc',
+        'threading/worker_pool_sequence_unittest.cc',
         'threading/worker_pool_unittest.cc',
         'time_unittest.cc',
         'time_win_unittest.cc',
@@ -273,6 +278,19 @@
         }],
       ],
     },
+    {
+      'target_name': 'base_perftests',
+      'type': 'executable',
+      'dependencies': [
+        'base',
+        'test_support_perf',
+        '../testing/gtest.gyp:gtest',
+      ],
+      'sources': [
+        'digest_perftest.cc',
+        'string_util_perftest.cc',
+      ],
+    },
     {
       'target_name': 'test_support_base',
       'type': '<(library)',
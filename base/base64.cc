@@ -1,41 +1,139 @@
-// Copyright (c) 2006-2008 The Chromium Authors. All rights reserved.
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
 #include "base/base64.h"
 
+#include "base/basictypes.h"
+#include "base/logging.h"
 #include "third_party/modp_b64/modp_b64.h"
 
 namespace base {
 
-bool Base64Encode(const std::string& input, std::string* output) {
+namespace {
+
+const int8 kInvalid = -1;
+const int8 kWhitespace = -2;
+const int8 kPad = -3;
+
+// The value of each base64 character, or one of the above.
+const int8 kDecodeTable[256] = {
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -2, -2, -1, -1, -2, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+  52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -3, -1, -1,
+  -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+  15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+  -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+  41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+}  // namespace
+
+bool Base64Encode(const StringPiece& input, std::string* output) {
   std::string temp;
   temp.resize(modp_b64_encode_len(input.size()));  // makes room for null byte
+  temp.resize(Base64EncodeToBuffer(input, &temp[0]));  // strips off null byte
+  output->swap(temp);
+  return true;
+}
 
-  // null terminates result since result is base64 text!
-  int input_size = static_cast<int>(input.size());
-  int output_size= modp_b64_encode(&(temp[0]), input.data(), input_size);
-  if (output_size < 0)
+bool Base64Decode(const StringPiece& input, std::string* output) {
+  std::string temp;
+  temp.resize(Base64DecodeBufferSize(input.size()));
+
+  size_t output_size;
+  if (!Base64DecodeToBuffer(input, &temp[0], &output_size))
     return false;
 
-  temp.resize(output_size);  // strips off null byte
+  temp.resize(output_size);
   output->swap(temp);
   return true;
 }
 
-bool Base64Decode(const std::string& input, std::string* output) {
+bool Base64DecodeIgnoringWhitespace(const StringPiece& input,
+                                    std::string* output) {
+  // Decode in one pass, a character at a time, rather than stripping the
+  // whitespace into a copy first.
   std::string temp;
-  temp.resize(modp_b64_decode_len(input.size()));
+  temp.resize(Base64DecodeBufferSize(input.size()));
+  char* out = &temp[0];
 
-  // does not null terminate result since result is binary data!
-  int input_size = static_cast<int>(input.size());
-  int output_size = modp_b64_decode(&(temp[0]), input.data(), input_size);
-  if (output_size < 0)
+  uint32 bits = 0;
+  int sextets = 0;  // The characters in |bits|.
+  int pads = 0;
+  for (size_t i = 0; i < input.size(); ++i) {
+    int8 value = kDecodeTable[static_cast<uint8>(input[i])];
+    if (value >= 0) {
+      if (pads)
+        return false;
+      bits = (bits << 6) | value;
+      if (++sextets == 4) {
+        *out++ = static_cast<char>(bits >> 16);
+        *out++ = static_cast<char>(bits >> 8);
+        *out++ = static_cast<char>(bits);
+        sextets = 0;
+      }
+    } else if (value == kPad) {
+      // Padding ends a group of at least two characters.
+      if (sextets + pads < 2 || ++pads > 2)
+        return false;
+    } else if (value != kWhitespace) {
+      return false;
+    }
+  }
+
+  if (pads) {
+    if (sextets + pads != 4)
+      return false;
+  } else if (sextets) {
     return false;
+  }
+  if (sextets == 2) {
+    *out++ = static_cast<char>(bits >> 4);
+  } else if (sextets == 3) {
+    *out++ = static_cast<char>(bits >> 10);
+    *out++ = static_cast<char>(bits >> 2);
+  }
 
-  temp.resize(output_size);
+  temp.resize(out - temp.data());
   output->swap(temp);
   return true;
 }
 
+size_t Base64EncodedLength(size_t length) {
+  return modp_b64_encode_strlen(length);
+}
+
+size_t Base64EncodeToBuffer(const StringPiece& input, char* output) {
+  // modp_b64 only fails on negative lengths.
+  int output_size = modp_b64_encode(output, input.data(),
+                                    static_cast<int>(input.size()));
+  DCHECK_GE(output_size, 0);
+  return output_size;
+}
+
+size_t Base64DecodeBufferSize(size_t length) {
+  return modp_b64_decode_len(length);
+}
+
+bool Base64DecodeToBuffer(const StringPiece& input, char* output,
+                          size_t* output_length) {
+  // does not null terminate result since result is binary data!
+  int output_size = modp_b64_decode(output, input.data(),
+                                    static_cast<int>(input.size()));
+  if (output_size < 0)
+    return false;
+  *output_length = output_size;
+  return true;
+}
+
 }  // namespace base
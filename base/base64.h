@@ -9,16 +9,44 @@
 #include <string>
 
 #include "base/base_api.h"
+#include "base/string_piece.h"
 
 namespace base {
 
 // Encodes the input string in base64.  Returns true if successful and false
 // otherwise.  The output string is only modified if successful.
-BASE_API bool Base64Encode(const std::string& input, std::string* output);
+BASE_API bool Base64Encode(const StringPiece& input, std::string* output);
 
 // Decodes the base64 input string.  Returns true if successful and false
 // otherwise.  The output string is only modified if successful.
-BASE_API bool Base64Decode(const std::string& input, std::string* output);
+BASE_API bool Base64Decode(const StringPiece& input, std::string* output);
+
+// Like Base64Decode(), but skips ASCII whitespace anywhere in the input, as
+// is found in line-wrapped base64 and in data: URLs.
+BASE_API bool Base64DecodeIgnoringWhitespace(const StringPiece& input,
+                                             std::string* output);
+
+// The functions below encode and decode into buffers of the caller, to
+// avoid allocating a string for each call.
+
+// Returns the length of the base64 encoding of |length| bytes.
+BASE_API size_t Base64EncodedLength(size_t length);
+
+// Encodes |input| into |output|, which must have room for
+// Base64EncodedLength(input.size()) + 1 bytes, the last for a terminating
+// null.  Returns the length of the encoding.
+BASE_API size_t Base64EncodeToBuffer(const StringPiece& input, char* output);
+
+// Returns the size of a buffer that is large enough to decode |length|
+// characters of base64 into.  It is slightly larger than the decoded data.
+BASE_API size_t Base64DecodeBufferSize(size_t length);
+
+// Decodes |input| into |output|, which must be at least
+// Base64DecodeBufferSize(input.size()) bytes.  Returns false if |input| isn't
+// valid base64, and otherwise sets |output_length| to the number of decoded
+// bytes.
+BASE_API bool Base64DecodeToBuffer(const StringPiece& input, char* output,
+                                   size_t* output_length);
 
 }  // namespace base
 
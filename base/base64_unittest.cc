@@ -27,3 +27,54 @@ TEST(Base64Test, Basic) {
   EXPECT_TRUE(ok);
   EXPECT_EQ(kText, decoded);
 }
+
+TEST(Base64Test, DecodeIgnoringWhitespace) {
+  std::string decoded;
+  EXPECT_TRUE(base::Base64DecodeIgnoringWhitespace(" aGVs\r\nbG8g d29y\tbGQ= ",
+                                                   &decoded));
+  EXPECT_EQ("hello world", decoded);
+  EXPECT_TRUE(base::Base64DecodeIgnoringWhitespace("aGk=", &decoded));
+  EXPECT_EQ("hi", decoded);
+  EXPECT_TRUE(base::Base64DecodeIgnoringWhitespace("aA = =", &decoded));
+  EXPECT_EQ("h", decoded);
+  EXPECT_TRUE(base::Base64DecodeIgnoringWhitespace("", &decoded));
+  EXPECT_EQ("", decoded);
+
+  // Every string of 0 to 256 bytes decodes back to itself, as with
+  // Base64Decode().
+  std::string input;
+  for (int i = 0; i <= 256; ++i) {
+    std::string encoded;
+    EXPECT_TRUE(base::Base64Encode(input, &encoded));
+    EXPECT_TRUE(base::Base64DecodeIgnoringWhitespace(encoded, &decoded));
+    EXPECT_EQ(input, decoded);
+    input.push_back(static_cast<char>(i * 7));
+  }
+
+  // The output is left alone on errors.
+  decoded = "unchanged";
+  EXPECT_FALSE(base::Base64DecodeIgnoringWhitespace("aGk", &decoded));
+  EXPECT_FALSE(base::Base64DecodeIgnoringWhitespace("aGk==", &decoded));
+  EXPECT_FALSE(base::Base64DecodeIgnoringWhitespace("a===", &decoded));
+  EXPECT_FALSE(base::Base64DecodeIgnoringWhitespace("aG=k", &decoded));
+  EXPECT_FALSE(base::Base64DecodeIgnoringWhitespace("aGk=aGk=", &decoded));
+  EXPECT_FALSE(base::Base64DecodeIgnoringWhitespace("aG!k", &decoded));
+  EXPECT_EQ("unchanged", decoded);
+}
+
+TEST(Base64Test, Buffers) {
+  const std::string kText = "hello world";
+  char encoded[32];
+  ASSERT_LE(base::Base64EncodedLength(kText.size()) + 1, sizeof(encoded));
+  size_t encoded_length = base::Base64EncodeToBuffer(kText, encoded);
+  EXPECT_EQ(base::Base64EncodedLength(kText.size()), encoded_length);
+  EXPECT_EQ("aGVsbG8gd29ybGQ=", std::string(encoded, encoded_length));
+
+  char decoded[32];
+  ASSERT_LE(base::Base64DecodeBufferSize(encoded_length), sizeof(decoded));
+  size_t decoded_length = 0;
+  EXPECT_TRUE(base::Base64DecodeToBuffer(
+      base::StringPiece(encoded, encoded_length), decoded, &decoded_length));
+  EXPECT_EQ(kText, std::string(decoded, decoded_length));
+  EXPECT_FALSE(base::Base64DecodeToBuffer("aGk", decoded, &decoded_length));
+}
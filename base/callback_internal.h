@@ -13,6 +13,7 @@
 
 #include "base/base_api.h"
 #include "base/memory/ref_counted.h"
+#include "base/memory/small_object_pool.h"
 
 namespace base {
 namespace internal {
@@ -23,7 +24,17 @@ namespace internal {
 // DoInvoke function to perform the function execution.  This allows
 // us to shield the Callback class from the types of the bound argument via
 // "type erasure."
+//
+// One is created for every Bind(), so they come from SmallObjectPool.
 class InvokerStorageBase : public RefCountedThreadSafe<InvokerStorageBase> {
+ public:
+  static void* operator new(size_t size) {
+    return SmallObjectPool::Allocate(size);
+  }
+  static void operator delete(void* pointer, size_t size) {
+    SmallObjectPool::Free(pointer, size);
+  }
+
  protected:
   friend class RefCountedThreadSafe<InvokerStorageBase>;
   virtual ~InvokerStorageBase() {}
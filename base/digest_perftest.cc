@@ -0,0 +1,68 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Measures one-shot SHA-1 and MD5 hashing of buffers from the size of a key
+// to the size of a disk cache entry.
+
+#include <string>
+
+#include "base/md5.h"
+#include "base/perftimer.h"
+#include "base/sha1.h"
+#include "base/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const size_t kLengths[] = { 64, 1024, 1024 * 1024 };
+
+// How many bytes each measurement goes over, whatever the buffer length.
+const size_t kBytesPerMeasurement = 64 * 1024 * 1024;
+
+std::string MakeData(size_t length) {
+  std::string result;
+  result.reserve(length);
+  for (size_t i = 0; i < length; ++i)
+    result.push_back(static_cast<char>(i * 131));
+  return result;
+}
+
+void LogRate(const char* name, size_t length, size_t bytes,
+             base::TimeDelta elapsed) {
+  LogPerfResult(base::StringPrintf("%s_%d", name,
+                                   static_cast<int>(length)).c_str(),
+                bytes / 1048576.0 / elapsed.InSecondsF(), "MB/s");
+}
+
+TEST(DigestPerfTest, SHA1) {
+  for (size_t i = 0; i < arraysize(kLengths); ++i) {
+    const std::string data = MakeData(kLengths[i]);
+    const size_t iterations = kBytesPerMeasurement / data.length();
+    unsigned char hash[base::SHA1_LENGTH];
+
+    PerfTimer timer;
+    for (size_t j = 0; j < iterations; ++j) {
+      base::SHA1HashBytes(reinterpret_cast<const unsigned char*>(data.data()),
+                          data.length(), hash);
+    }
+    LogRate("SHA1", data.length(), iterations * data.length(),
+            timer.Elapsed());
+  }
+}
+
+TEST(DigestPerfTest, MD5) {
+  for (size_t i = 0; i < arraysize(kLengths); ++i) {
+    const std::string data = MakeData(kLengths[i]);
+    const size_t iterations = kBytesPerMeasurement / data.length();
+    MD5Digest digest;
+
+    PerfTimer timer;
+    for (size_t j = 0; j < iterations; ++j)
+      MD5Sum(data.data(), data.length(), &digest);
+    LogRate("MD5", data.length(), iterations * data.length(),
+            timer.Elapsed());
+  }
+}
+
+}  // namespace
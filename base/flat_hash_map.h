@@ -0,0 +1,685 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// base::flat_hash_map and base::flat_hash_set are hash tables with open
+// addressing, for maps that are looked up in hot paths.  Where
+// base::hash_map allocates a node for each element and chases pointers to
+// find it, these keep all elements in one array, next to an array of one
+// control byte per slot that says whether the slot is empty, and if not, holds
+// seven bits of the element's hash.  A lookup compares eight control bytes at
+// once, a machine word at a time, and only compares keys whose bits match.
+//
+//   base::flat_hash_map<std::string, int> map;
+//   map["foo"] = 1;
+//   if (map.find(StringPiece("foo")) != map.end())
+//     ...
+//
+// The interface is the one of base::hash_map and base::hash_set, except that:
+// - Inserting may move the elements, so it invalidates all iterators, pointers
+//   and references.  Erasing only invalidates those to the erased element, so
+//   |map.erase(it++)| works.
+// - Keys and values are copied when the table grows, so they must be
+//   copyable, and had better be cheap to copy.
+// - find() and count() take any type that the hasher and the key comparison
+//   take.  With the default FlatHash and FlatHashEqual, a std::string keyed
+//   table can be looked up with a StringPiece or a const char* without making
+//   a string.
+
+#ifndef BASE_FLAT_HASH_MAP_H_
+#define BASE_FLAT_HASH_MAP_H_
+#pragma once
+
+#include <string.h>
+
+#include <algorithm>
+#include <iterator>
+#include <new>
+#include <string>
+#include <utility>
+
+#include "base/basictypes.h"
+#include "base/hash_tables.h"
+#include "base/logging.h"
+#include "base/string_piece.h"
+
+namespace base {
+
+// The default hasher.  Strings are hashed from their bytes, so that a
+// std::string and a StringPiece with the same characters hash alike; other
+// types use the platform's hash.
+#if defined(COMPILER_MSVC)
+template <typename Key>
+struct FlatHash {
+  size_t operator()(const Key& key) const {
+    return stdext::hash_value(key);
+  }
+};
+#elif defined(COMPILER_GCC)
+template <typename Key>
+struct FlatHash : public __gnu_cxx::hash<Key> {
+};
+#endif
+
+struct FlatHashStringPiece {
+  size_t operator()(const StringPiece& key) const {
+    // The FNV-1a hash.
+    uint32 hash = 2166136261u;
+    for (size_t i = 0; i < key.size(); ++i) {
+      hash ^= static_cast<uint8>(key[i]);
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+};
+
+template <>
+struct FlatHash<std::string> : public FlatHashStringPiece {
+};
+
+template <>
+struct FlatHash<StringPiece> : public FlatHashStringPiece {
+};
+
+// The default key comparison, which compares keys of different types with
+// their operator==.
+struct FlatHashEqual {
+  template <typename A, typename B>
+  bool operator()(const A& a, const B& b) const {
+    return a == b;
+  }
+};
+
+namespace internal {
+
+// A control byte is kFlatHashEmpty, kFlatHashDeleted, or the low seven bits
+// of the hash of a full slot.
+typedef int8 FlatHashCtrl;
+const FlatHashCtrl kFlatHashEmpty = -128;
+const FlatHashCtrl kFlatHashDeleted = -2;
+
+// The number of control bytes compared at once.  The control bytes of the
+// first kFlatHashGroupWidth slots are repeated after the last one, so that
+// a group can start at any slot.
+const size_t kFlatHashGroupWidth = 8;
+
+// Eight control bytes, compared at once.  The matches are returned as a mask
+// with the top bit of each matching byte set.  All the platforms in
+// build_config.h are little-endian, so byte i of the group is byte i of the
+// word.
+class FlatHashGroup {
+ public:
+  explicit FlatHashGroup(const FlatHashCtrl* ctrl) {
+    memcpy(&word_, ctrl, sizeof(word_));
+  }
+
+  // Returns the bytes that are |h2|.  Can also return a byte that is not,
+  // just above one that is, which the key comparison then rejects.
+  uint64 Match(uint8 h2) const {
+    uint64 x = word_ ^ (kLowBits * h2);
+    return (x - kLowBits) & ~x & kHighBits;
+  }
+
+  // Returns the bytes that are kFlatHashEmpty, the only control byte with
+  // the top bit set and bit 1 clear.
+  uint64 MatchEmpty() const {
+    return word_ & (~word_ << 6) & kHighBits;
+  }
+
+  // Returns the bytes that are kFlatHashEmpty or kFlatHashDeleted, the only
+  // control bytes with the top bit set and bit 0 clear.
+  uint64 MatchEmptyOrDeleted() const {
+    return word_ & ~(word_ << 7) & kHighBits;
+  }
+
+  // Returns the index of the lowest byte in the non-zero |mask|.
+  static size_t LowestIndex(uint64 mask) {
+#if defined(COMPILER_GCC)
+    return __builtin_ctzll(mask) >> 3;
+#else
+    size_t index = 0;
+    while (!(mask & 0x80)) {
+      mask >>= 8;
+      ++index;
+    }
+    return index;
+#endif
+  }
+
+  // Returns the number of bytes above the highest byte in the non-zero
+  // |mask|.
+  static size_t BytesAboveHighest(uint64 mask) {
+#if defined(COMPILER_GCC)
+    return __builtin_clzll(mask) >> 3;
+#else
+    size_t count = 0;
+    while (!(mask & (kHighBits & ~(kHighBits >> 8)))) {
+      mask <<= 8;
+      ++count;
+    }
+    return count;
+#endif
+  }
+
+ private:
+  static const uint64 kLowBits = GG_UINT64_C(0x0101010101010101);
+  static const uint64 kHighBits = GG_UINT64_C(0x8080808080808080);
+
+  uint64 word_;
+};
+
+// Iterates over the full slots of a table.  |Stored| is |Value| or
+// const |Value|.
+template <typename Value, typename Stored>
+class FlatHashIterator {
+ public:
+  typedef std::forward_iterator_tag iterator_category;
+  typedef Value value_type;
+  typedef ptrdiff_t difference_type;
+  typedef Stored* pointer;
+  typedef Stored& reference;
+
+  FlatHashIterator() : ctrl_(NULL), slot_(NULL), end_(NULL) {}
+
+  // Makes the const_iterator of an iterator.
+  template <typename OtherStored>
+  FlatHashIterator(const FlatHashIterator<Value, OtherStored>& other)
+      : ctrl_(other.ctrl_), slot_(other.slot_), end_(other.end_) {
+  }
+
+  reference operator*() const { return *slot_; }
+  pointer operator->() const { return slot_; }
+
+  FlatHashIterator& operator++() {
+    ++ctrl_;
+    ++slot_;
+    SkipEmptySlots();
+    return *this;
+  }
+
+  FlatHashIterator operator++(int) {
+    FlatHashIterator result(*this);
+    ++*this;
+    return result;
+  }
+
+  template <typename OtherStored>
+  bool operator==(const FlatHashIterator<Value, OtherStored>& other) const {
+    return slot_ == other.slot_;
+  }
+
+  template <typename OtherStored>
+  bool operator!=(const FlatHashIterator<Value, OtherStored>& other) const {
+    return slot_ != other.slot_;
+  }
+
+ private:
+  template <typename, typename, typename, typename, typename>
+  friend class FlatHashTable;
+  template <typename, typename>
+  friend class FlatHashIterator;
+
+  // Points at the slot with control byte |ctrl|, or at the first full slot
+  // after it, of a table whose control bytes end at |end|.
+  FlatHashIterator(const FlatHashCtrl* ctrl, Stored* slot,
+                   const FlatHashCtrl* end)
+      : ctrl_(ctrl), slot_(slot), end_(end) {
+    SkipEmptySlots();
+  }
+
+  void SkipEmptySlots() {
+    while (ctrl_ != end_ && *ctrl_ < 0) {
+      ++ctrl_;
+      ++slot_;
+    }
+  }
+
+  const FlatHashCtrl* ctrl_;
+  Stored* slot_;
+  const FlatHashCtrl* end_;
+};
+
+template <typename Value>
+struct FlatHashIdentity {
+  const Value& operator()(const Value& value) const { return value; }
+};
+
+template <typename Pair>
+struct FlatHashSelectFirst {
+  const typename Pair::first_type& operator()(const Pair& pair) const {
+    return pair.first;
+  }
+};
+
+// The table behind flat_hash_map and flat_hash_set.  |KeyOfValue| returns
+// the key of a |Value|.
+template <typename Value, typename Key, typename KeyOfValue, typename Hash,
+          typename KeyEqual>
+class FlatHashTable {
+ public:
+  typedef Key key_type;
+  typedef Value value_type;
+  typedef Hash hasher;
+  typedef KeyEqual key_equal;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef Value& reference;
+  typedef const Value& const_reference;
+  typedef Value* pointer;
+  typedef const Value* const_pointer;
+  typedef FlatHashIterator<Value, Value> iterator;
+  typedef FlatHashIterator<Value, const Value> const_iterator;
+
+  explicit FlatHashTable(size_type bucket_count = 0,
+                         const Hash& hash = Hash(),
+                         const KeyEqual& equal = KeyEqual())
+      : ctrl_(NULL),
+        slots_(NULL),
+        capacity_(0),
+        size_(0),
+        growth_left_(0),
+        hash_(hash),
+        equal_(equal) {
+    reserve(bucket_count);
+  }
+
+  FlatHashTable(const FlatHashTable& other)
+      : ctrl_(NULL),
+        slots_(NULL),
+        capacity_(0),
+        size_(0),
+        growth_left_(0),
+        hash_(other.hash_),
+        equal_(other.equal_) {
+    reserve(other.size());
+    for (const_iterator it = other.begin(); it != other.end(); ++it)
+      insert(*it);
+  }
+
+  ~FlatHashTable() {
+    DestroySlots(ctrl_, slots_, capacity_);
+  }
+
+  FlatHashTable& operator=(const FlatHashTable& other) {
+    if (this != &other) {
+      FlatHashTable copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  iterator begin() {
+    return iterator(ctrl_, slots_, ctrl_ + capacity_);
+  }
+  const_iterator begin() const {
+    return const_iterator(ctrl_, slots_, ctrl_ + capacity_);
+  }
+  iterator end() {
+    return iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_);
+  }
+  const_iterator end() const {
+    return const_iterator(ctrl_ + capacity_, slots_ + capacity_,
+                          ctrl_ + capacity_);
+  }
+
+  bool empty() const { return size_ == 0; }
+  size_type size() const { return size_; }
+  size_type max_size() const { return static_cast<size_type>(-1) / 2; }
+
+  // The number of slots.
+  size_type bucket_count() const { return capacity_; }
+
+  hasher hash_function() const { return hash_; }
+  key_equal key_eq() const { return equal_; }
+
+  // Makes room for |count| elements without growing again.
+  void reserve(size_type count) {
+    size_type capacity = capacity_ ? capacity_ : kFlatHashGroupWidth;
+    while (MaxLoad(capacity) < count)
+      capacity *= 2;
+    if (count && capacity != capacity_)
+      Resize(capacity);
+  }
+
+  void clear() {
+    DestroySlots(ctrl_, slots_, capacity_);
+    ctrl_ = NULL;
+    slots_ = NULL;
+    capacity_ = 0;
+    size_ = 0;
+    growth_left_ = 0;
+  }
+
+  void swap(FlatHashTable& other) {
+    std::swap(ctrl_, other.ctrl_);
+    std::swap(slots_, other.slots_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(size_, other.size_);
+    std::swap(growth_left_, other.growth_left_);
+    std::swap(hash_, other.hash_);
+    std::swap(equal_, other.equal_);
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    std::pair<size_type, bool> slot = FindOrPrepareInsert(KeyOfValue()(value));
+    if (slot.second)
+      new (slots_ + slot.first) value_type(value);
+    return std::make_pair(IteratorAt(slot.first), slot.second);
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    for (; first != last; ++first)
+      insert(*first);
+  }
+
+  template <typename K>
+  iterator find(const K& key) {
+    return IteratorAt(FindIndex(key));
+  }
+
+  template <typename K>
+  const_iterator find(const K& key) const {
+    size_type index = FindIndex(key);
+    return const_iterator(ctrl_ + index, slots_ + index, ctrl_ + capacity_);
+  }
+
+  template <typename K>
+  size_type count(const K& key) const {
+    return FindIndex(key) != capacity_ ? 1 : 0;
+  }
+
+  void erase(const_iterator position) {
+    EraseAt(position.ctrl_ - ctrl_);
+  }
+
+  void erase(const_iterator first, const_iterator last) {
+    while (first != last)
+      erase(first++);
+  }
+
+  size_type erase(const key_type& key) {
+    size_type index = FindIndex(key);
+    if (index == capacity_)
+      return 0;
+    EraseAt(index);
+    return 1;
+  }
+
+ protected:
+  // Returns the slot of |key| and false if it is in the table.  Otherwise
+  // marks a slot full for it and returns the slot and true; the caller must
+  // then construct the element in the slot.
+  std::pair<size_type, bool> FindOrPrepareInsert(const key_type& key) {
+    size_t hash = HashOf(key);
+    size_type index = FindIndex(key, hash);
+    if (index != capacity_)
+      return std::make_pair(index, false);
+
+    if (!growth_left_)
+      RehashForInsert();
+    index = FindFirstNonFull(hash);
+    if (ctrl_[index] == kFlatHashEmpty)
+      --growth_left_;
+    SetCtrl(index, H2(hash));
+    ++size_;
+    return std::make_pair(index, true);
+  }
+
+  value_type* slot(size_type index) { return slots_ + index; }
+
+ private:
+  // The number of elements that a table of |capacity| slots holds before it
+  // grows: seven eighths of the slots, so that probing stays short and there
+  // is always an empty slot to end it.
+  static size_type MaxLoad(size_type capacity) {
+    return capacity - capacity / 8;
+  }
+
+  // Spreads the bits of the hash, since identity hashes of integers keep all
+  // of them in the low bits.
+  template <typename K>
+  size_t HashOf(const K& key) const {
+    size_t hash = hash_(key);
+#if defined(ARCH_CPU_64_BITS)
+    uint64 mixed = static_cast<uint64>(hash) * GG_UINT64_C(0x9E3779B97F4A7C15);
+    return static_cast<size_t>(mixed ^ (mixed >> 32));
+#else
+    uint32 mixed = static_cast<uint32>(hash) * 0x9E3779B9u;
+    return mixed ^ (mixed >> 16);
+#endif
+  }
+
+  // The part of the hash that picks the first group to probe, and the part
+  // kept in the control byte.
+  static size_t H1(size_t hash) { return hash >> 7; }
+  static FlatHashCtrl H2(size_t hash) {
+    return static_cast<FlatHashCtrl>(hash & 0x7F);
+  }
+
+  iterator IteratorAt(size_type index) {
+    return iterator(ctrl_ + index, slots_ + index, ctrl_ + capacity_);
+  }
+
+  template <typename K>
+  size_type FindIndex(const K& key) const {
+    if (!capacity_)
+      return 0;
+    return FindIndex(key, HashOf(key));
+  }
+
+  // Returns the slot of |key|, whose hash is |hash|, or capacity_ if it is
+  // not in the table.  The groups probed are at triangular offsets from
+  // H1(hash), which visits every slot once the table is a power of two.
+  template <typename K>
+  size_type FindIndex(const K& key, size_t hash) const {
+    if (!capacity_)
+      return 0;
+    size_type mask = capacity_ - 1;
+    size_type offset = H1(hash) & mask;
+    size_type stride = 0;
+    while (true) {
+      FlatHashGroup group(ctrl_ + offset);
+      for (uint64 match = group.Match(H2(hash)); match; match &= match - 1) {
+        size_type index =
+            (offset + FlatHashGroup::LowestIndex(match)) & mask;
+        if (equal_(KeyOfValue()(slots_[index]), key))
+          return index;
+      }
+      if (group.MatchEmpty())
+        return capacity_;
+      stride += kFlatHashGroupWidth;
+      offset = (offset + stride) & mask;
+    }
+  }
+
+  // Returns the first empty or deleted slot in the probe sequence of |hash|.
+  size_type FindFirstNonFull(size_t hash) const {
+    size_type mask = capacity_ - 1;
+    size_type offset = H1(hash) & mask;
+    size_type stride = 0;
+    while (true) {
+      FlatHashGroup group(ctrl_ + offset);
+      uint64 match = group.MatchEmptyOrDeleted();
+      if (match)
+        return (offset + FlatHashGroup::LowestIndex(match)) & mask;
+      stride += kFlatHashGroupWidth;
+      offset = (offset + stride) & mask;
+    }
+  }
+
+  void SetCtrl(size_type index, FlatHashCtrl ctrl) {
+    ctrl_[index] = ctrl;
+    if (index < kFlatHashGroupWidth)
+      ctrl_[capacity_ + index] = ctrl;
+  }
+
+  void EraseAt(size_type index) {
+    DCHECK_LT(index, capacity_);
+    DCHECK_GE(ctrl_[index], 0);
+    slots_[index].~value_type();
+    --size_;
+
+    // The slot can be made empty again, rather than deleted, if no probe
+    // ever went past it: that is, if every group it is in has an empty slot
+    // on both sides of it.
+    size_type mask = capacity_ - 1;
+    uint64 empty_after = FlatHashGroup(ctrl_ + index).MatchEmpty();
+    uint64 empty_before = FlatHashGroup(
+        ctrl_ + ((index - kFlatHashGroupWidth) & mask)).MatchEmpty();
+    if (empty_after && empty_before &&
+        FlatHashGroup::LowestIndex(empty_after) +
+        FlatHashGroup::BytesAboveHighest(empty_before) < kFlatHashGroupWidth) {
+      SetCtrl(index, kFlatHashEmpty);
+      ++growth_left_;
+    } else {
+      SetCtrl(index, kFlatHashDeleted);
+    }
+  }
+
+  // Makes room for one more element: in place if enough of the used slots
+  // are deleted ones, by doubling the size otherwise.
+  void RehashForInsert() {
+    if (!capacity_)
+      Resize(kFlatHashGroupWidth);
+    else if (size_ <= MaxLoad(capacity_) / 2)
+      Resize(capacity_);
+    else
+      Resize(capacity_ * 2);
+  }
+
+  // Moves the elements to new arrays of |capacity| slots, dropping the
+  // deleted ones.
+  void Resize(size_type capacity) {
+    DCHECK_GE(MaxLoad(capacity), size_);
+    FlatHashCtrl* old_ctrl = ctrl_;
+    value_type* old_slots = slots_;
+    size_type old_capacity = capacity_;
+
+    ctrl_ = new FlatHashCtrl[capacity + kFlatHashGroupWidth];
+    memset(ctrl_, kFlatHashEmpty, capacity + kFlatHashGroupWidth);
+    slots_ = static_cast<value_type*>(
+        ::operator new(capacity * sizeof(value_type)));
+    capacity_ = capacity;
+    growth_left_ = MaxLoad(capacity) - size_;
+
+    for (size_type i = 0; i < old_capacity; ++i) {
+      if (old_ctrl[i] < 0)
+        continue;
+      size_t hash = HashOf(KeyOfValue()(old_slots[i]));
+      size_type index = FindFirstNonFull(hash);
+      SetCtrl(index, H2(hash));
+      new (slots_ + index) value_type(old_slots[i]);
+    }
+    DestroySlots(old_ctrl, old_slots, old_capacity);
+  }
+
+  static void DestroySlots(FlatHashCtrl* ctrl, value_type* slots,
+                           size_type capacity) {
+    for (size_type i = 0; i < capacity; ++i) {
+      if (ctrl[i] >= 0)
+        slots[i].~value_type();
+    }
+    delete[] ctrl;
+    ::operator delete(slots);
+  }
+
+  FlatHashCtrl* ctrl_;
+  value_type* slots_;
+  size_type capacity_;  // 0 or a power of two, at least kFlatHashGroupWidth.
+  size_type size_;
+  // The number of empty slots that can still be filled before growing.
+  size_type growth_left_;
+  Hash hash_;
+  KeyEqual equal_;
+};
+
+}  // namespace internal
+
+template <typename Key, typename T, typename Hash = FlatHash<Key>,
+          typename KeyEqual = FlatHashEqual>
+class flat_hash_map
+    : public internal::FlatHashTable<
+          std::pair<const Key, T>, Key,
+          internal::FlatHashSelectFirst<std::pair<const Key, T> >,
+          Hash, KeyEqual> {
+ private:
+  typedef internal::FlatHashTable<
+      std::pair<const Key, T>, Key,
+      internal::FlatHashSelectFirst<std::pair<const Key, T> >,
+      Hash, KeyEqual> Table;
+
+ public:
+  typedef T mapped_type;
+  typedef typename Table::size_type size_type;
+  typedef typename Table::value_type value_type;
+
+  explicit flat_hash_map(size_type bucket_count = 0,
+                         const Hash& hash = Hash(),
+                         const KeyEqual& equal = KeyEqual())
+      : Table(bucket_count, hash, equal) {
+  }
+
+  template <typename InputIterator>
+  flat_hash_map(InputIterator first, InputIterator last) {
+    this->insert(first, last);
+  }
+
+  T& operator[](const Key& key) {
+    std::pair<size_type, bool> slot = this->FindOrPrepareInsert(key);
+    if (slot.second)
+      new (this->slot(slot.first)) value_type(key, T());
+    return this->slot(slot.first)->second;
+  }
+};
+
+template <typename Key, typename Hash = FlatHash<Key>,
+          typename KeyEqual = FlatHashEqual>
+class flat_hash_set
+    : public internal::FlatHashTable<Key, Key,
+                                     internal::FlatHashIdentity<Key>,
+                                     Hash, KeyEqual> {
+ private:
+  typedef internal::FlatHashTable<Key, Key, internal::FlatHashIdentity<Key>,
+                                  Hash, KeyEqual> Table;
+
+ public:
+  // The elements of a set are its keys, so they can't be modified.
+  typedef typename Table::const_iterator iterator;
+  typedef typename Table::const_iterator const_iterator;
+  typedef typename Table::size_type size_type;
+  typedef typename Table::value_type value_type;
+
+  explicit flat_hash_set(size_type bucket_count = 0,
+                         const Hash& hash = Hash(),
+                         const KeyEqual& equal = KeyEqual())
+      : Table(bucket_count, hash, equal) {
+  }
+
+  template <typename InputIterator>
+  flat_hash_set(InputIterator first, InputIterator last) {
+    Table::insert(first, last);
+  }
+
+  const_iterator begin() const { return Table::begin(); }
+  const_iterator end() const { return Table::end(); }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    std::pair<typename Table::iterator, bool> result = Table::insert(value);
+    return std::make_pair(iterator(result.first), result.second);
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    Table::insert(first, last);
+  }
+
+  template <typename K>
+  const_iterator find(const K& key) const {
+    return Table::find(key);
+  }
+};
+
+}  // namespace base
+
+#endif  // BASE_FLAT_HASH_MAP_H_
@@ -0,0 +1,205 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/flat_hash_map.h"
+
+#include <map>
+#include <string>
+
+#include "base/string_number_conversions.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Sends every key to the same slot, so that every insert collides.
+struct CollidingHash {
+  size_t operator()(int key) const { return 0; }
+};
+
+}  // namespace
+
+TEST(FlatHashMapTest, InsertFindErase) {
+  flat_hash_map<int, int> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.find(1) == map.end());
+  EXPECT_EQ(0u, map.erase(1));
+
+  std::pair<flat_hash_map<int, int>::iterator, bool> result =
+      map.insert(std::make_pair(1, 10));
+  EXPECT_TRUE(result.second);
+  EXPECT_EQ(1, result.first->first);
+  EXPECT_EQ(10, result.first->second);
+
+  // An existing key is not replaced.
+  result = map.insert(std::make_pair(1, 20));
+  EXPECT_FALSE(result.second);
+  EXPECT_EQ(10, result.first->second);
+
+  map[2] = 20;
+  map[3];
+  EXPECT_EQ(3u, map.size());
+  EXPECT_EQ(20, map.find(2)->second);
+  EXPECT_EQ(0, map[3]);
+  EXPECT_EQ(1u, map.count(3));
+
+  EXPECT_EQ(1u, map.erase(2));
+  EXPECT_EQ(0u, map.erase(2));
+  EXPECT_TRUE(map.find(2) == map.end());
+  EXPECT_EQ(2u, map.size());
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.begin() == map.end());
+  map[4] = 40;
+  EXPECT_EQ(40, map[4]);
+}
+
+TEST(FlatHashMapTest, Growth) {
+  flat_hash_map<int, int> map;
+  for (int i = 0; i < 10000; ++i)
+    map[i] = i * 2;
+  EXPECT_EQ(10000u, map.size());
+  // The table is a power of two at most seven eighths full.
+  EXPECT_EQ(0u, map.bucket_count() & (map.bucket_count() - 1));
+  EXPECT_LE(map.size(), map.bucket_count() - map.bucket_count() / 8);
+  for (int i = 0; i < 10000; ++i) {
+    ASSERT_TRUE(map.find(i) != map.end()) << i;
+    EXPECT_EQ(i * 2, map.find(i)->second);
+  }
+  EXPECT_TRUE(map.find(10000) == map.end());
+}
+
+TEST(FlatHashMapTest, Reserve) {
+  flat_hash_map<int, int> map(100);
+  size_t bucket_count = map.bucket_count();
+  EXPECT_LE(100u, bucket_count - bucket_count / 8);
+  for (int i = 0; i < 100; ++i)
+    map[i] = i;
+  EXPECT_EQ(bucket_count, map.bucket_count());
+}
+
+// Check that erasing and inserting over and over reuses the deleted slots
+// instead of growing the table.
+TEST(FlatHashMapTest, DeletedSlotsAreReused) {
+  flat_hash_map<int, int, CollidingHash> map;
+  for (int i = 0; i < 5; ++i)
+    map[i] = i;
+  size_t bucket_count = map.bucket_count();
+  for (int i = 5; i < 1000; ++i) {
+    map.erase(i - 5);
+    map[i] = i;
+    ASSERT_EQ(5u, map.size());
+  }
+  EXPECT_EQ(bucket_count, map.bucket_count());
+  for (int i = 995; i < 1000; ++i)
+    EXPECT_EQ(i, map[i]);
+}
+
+TEST(FlatHashMapTest, EraseWhileIterating) {
+  flat_hash_map<int, int> map;
+  for (int i = 0; i < 100; ++i)
+    map[i] = i;
+  for (flat_hash_map<int, int>::iterator it = map.begin(); it != map.end();) {
+    if (it->first % 2)
+      map.erase(it++);
+    else
+      ++it;
+  }
+  EXPECT_EQ(50u, map.size());
+  int sum = 0;
+  for (flat_hash_map<int, int>::const_iterator it = map.begin();
+       it != map.end(); ++it) {
+    EXPECT_EQ(0, it->first % 2);
+    sum += it->second;
+  }
+  EXPECT_EQ(2450, sum);
+}
+
+TEST(FlatHashMapTest, StringKeys) {
+  flat_hash_map<std::string, int> map;
+  map["one"] = 1;
+  map[std::string("two")] = 2;
+  EXPECT_EQ(1, map.find(StringPiece("one"))->second);
+  EXPECT_EQ(2, map.find("two")->second);
+  EXPECT_TRUE(map.find(StringPiece("three")) == map.end());
+  EXPECT_EQ(1u, map.count(StringPiece("one", 3)));
+  EXPECT_EQ(0u, map.count(StringPiece("one", 2)));
+  // FlatHash must hash a string like its StringPiece.
+  EXPECT_EQ(FlatHash<std::string>()(std::string("abc")),
+            FlatHash<StringPiece>()(StringPiece("abc")));
+}
+
+TEST(FlatHashMapTest, CopyAndSwap) {
+  flat_hash_map<std::string, int> map;
+  for (int i = 0; i < 50; ++i)
+    map[IntToString(i)] = i;
+
+  flat_hash_map<std::string, int> copy(map);
+  EXPECT_EQ(50u, copy.size());
+  copy.erase("0");
+  EXPECT_EQ(1u, map.count("0"));
+
+  flat_hash_map<std::string, int> other;
+  other["x"] = 1;
+  other = copy;
+  EXPECT_EQ(49u, other.size());
+  EXPECT_EQ(0u, other.count("x"));
+
+  other.swap(map);
+  EXPECT_EQ(50u, other.size());
+  EXPECT_EQ(49u, map.size());
+}
+
+// Check random operations against std::map.
+TEST(FlatHashMapTest, MatchesStdMap) {
+  flat_hash_map<int, int> map;
+  std::map<int, int> expected;
+  uint32 random = 1;
+  for (int i = 0; i < 100000; ++i) {
+    random = random * 1103515245 + 12345;
+    int key = (random >> 16) % 2000;
+    if ((random >> 8) & 1) {
+      map[key] = i;
+      expected[key] = i;
+    } else {
+      EXPECT_EQ(expected.erase(key), map.erase(key));
+    }
+    ASSERT_EQ(expected.size(), map.size());
+  }
+  for (std::map<int, int>::iterator it = expected.begin();
+       it != expected.end(); ++it) {
+    ASSERT_TRUE(map.find(it->first) != map.end());
+    EXPECT_EQ(it->second, map.find(it->first)->second);
+  }
+  size_t count = 0;
+  for (flat_hash_map<int, int>::iterator it = map.begin(); it != map.end();
+       ++it) {
+    EXPECT_EQ(expected[it->first], it->second);
+    ++count;
+  }
+  EXPECT_EQ(expected.size(), count);
+}
+
+TEST(FlatHashSetTest, Basic) {
+  flat_hash_set<std::string> set;
+  EXPECT_TRUE(set.insert("a").second);
+  EXPECT_FALSE(set.insert("a").second);
+  EXPECT_TRUE(set.insert("b").second);
+  EXPECT_EQ(2u, set.size());
+  EXPECT_TRUE(set.find(StringPiece("a")) != set.end());
+  EXPECT_EQ("b", *set.find("b"));
+  EXPECT_EQ(0u, set.count("c"));
+
+  set.erase(set.find("a"));
+  EXPECT_EQ(1u, set.size());
+  EXPECT_EQ("b", *set.begin());
+
+  const char* kItems[] = { "x", "y", "x" };
+  flat_hash_set<std::string> from_range(kItems, kItems + arraysize(kItems));
+  EXPECT_EQ(2u, from_range.size());
+}
+
+}  // namespace base
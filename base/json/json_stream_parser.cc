@@ -0,0 +1,455 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_stream_parser.h"
+
+#include <string.h>
+
+#include "base/logging.h"
+#include "base/string_util.h"
+#include "base/utf_string_conversion_utils.h"
+
+namespace {
+
+// Same as JSONReader.
+const size_t kStackLimit = 100;
+
+const uint32 kReplacementCharacter = 0xFFFD;
+
+bool IsHighSurrogate(uint32 code_point) {
+  return (code_point & 0xFC00) == 0xD800;
+}
+
+bool IsLowSurrogate(uint32 code_point) {
+  return (code_point & 0xFC00) == 0xDC00;
+}
+
+bool IsNumberChar(char c) {
+  return IsAsciiDigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' ||
+         c == 'E';
+}
+
+// Returns true if |text| is a number in the JSON grammar:
+// -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+bool IsValidNumber(const base::StringPiece& text) {
+  base::StringPiece::const_iterator it = text.begin();
+  base::StringPiece::const_iterator end = text.end();
+  if (it != end && *it == '-')
+    ++it;
+  if (it == end || !IsAsciiDigit(*it))
+    return false;
+  if (*it++ == '0' && it != end && IsAsciiDigit(*it))
+    return false;
+  while (it != end && IsAsciiDigit(*it))
+    ++it;
+  if (it != end && *it == '.') {
+    if (++it == end || !IsAsciiDigit(*it))
+      return false;
+    while (it != end && IsAsciiDigit(*it))
+      ++it;
+  }
+  if (it != end && (*it == 'e' || *it == 'E')) {
+    ++it;
+    if (it != end && (*it == '+' || *it == '-'))
+      ++it;
+    if (it == end || !IsAsciiDigit(*it))
+      return false;
+    while (it != end && IsAsciiDigit(*it))
+      ++it;
+  }
+  return it == end;
+}
+
+}  // namespace
+
+namespace base {
+
+JSONStreamParser::JSONStreamParser(Delegate* delegate,
+                                   bool allow_trailing_comma)
+    : delegate_(delegate),
+      allow_trailing_comma_(allow_trailing_comma),
+      state_(STATE_ROOT),
+      token_(TOKEN_NONE),
+      token_start_(NULL),
+      string_is_key_(false),
+      literal_(NULL),
+      hex_digits_left_(0),
+      hex_value_(0),
+      pending_surrogate_(0),
+      at_start_(true),
+      error_code_(JSONReader::JSON_NO_ERROR) {
+  DCHECK(delegate_);
+}
+
+JSONStreamParser::~JSONStreamParser() {
+}
+
+bool JSONStreamParser::Parse(const char* data, size_t length) {
+  if (state_ == STATE_ERROR)
+    return false;
+
+  const char* pos = data;
+  const char* end = data + length;
+  if (at_start_ && length) {
+    at_start_ = false;
+    if (length >= 3 && memcmp(pos, "\xEF\xBB\xBF", 3) == 0)
+      pos += 3;
+  }
+
+  while (pos < end) {
+    switch (token_) {
+      case TOKEN_NONE:
+        if (!ParseStructural(pos))
+          return false;
+        ++pos;
+        break;
+
+      case TOKEN_STRING:
+      case TOKEN_STRING_ESCAPE:
+      case TOKEN_STRING_HEX:
+        if (!ParseStringChar(&pos, end))
+          return false;
+        break;
+
+      case TOKEN_NUMBER:
+        if (IsNumberChar(*pos)) {
+          if (!token_start_)
+            buffer_.push_back(*pos);
+          ++pos;
+        } else if (!EndNumber(pos)) {
+          return false;
+        }
+        // The character after the number is handled as TOKEN_NONE.
+        break;
+
+      case TOKEN_TRUE:
+      case TOKEN_FALSE:
+      case TOKEN_NULL:
+        if (*pos != *literal_)
+          return SetError(JSONReader::JSON_SYNTAX_ERROR);
+        ++pos;
+        if (!*++literal_)
+          EndLiteral();
+        break;
+    }
+  }
+
+  BufferToken(end);
+  return true;
+}
+
+bool JSONStreamParser::Finish() {
+  if (state_ == STATE_ERROR)
+    return false;
+  if (state_ != STATE_DONE)
+    return SetError(JSONReader::JSON_SYNTAX_ERROR);
+  return true;
+}
+
+bool JSONStreamParser::ParseStructural(const char* pos) {
+  char c = *pos;
+  if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+    return true;
+
+  switch (state_) {
+    case STATE_ROOT:
+    case STATE_MEMBER_VALUE:
+      return BeginValue(pos);
+
+    case STATE_ARRAY_VALUE:
+      if (c == ']') {
+        if (!allow_trailing_comma_)
+          return SetError(JSONReader::JSON_TRAILING_COMMA);
+        EndContainer();
+        return true;
+      }
+      return BeginValue(pos);
+
+    case STATE_FIRST_ARRAY_VALUE:
+      if (c == ']') {
+        EndContainer();
+        return true;
+      }
+      return BeginValue(pos);
+
+    case STATE_KEY:
+    case STATE_FIRST_KEY:
+      if (c == '"') {
+        string_is_key_ = true;
+        BeginToken(TOKEN_STRING, pos + 1);
+        return true;
+      }
+      if (c == '}') {
+        if (state_ == STATE_KEY && !allow_trailing_comma_)
+          return SetError(JSONReader::JSON_TRAILING_COMMA);
+        EndContainer();
+        return true;
+      }
+      if (IsAsciiAlpha(c) || IsAsciiDigit(c) || c == '_')
+        return SetError(JSONReader::JSON_UNQUOTED_DICTIONARY_KEY);
+      return SetError(JSONReader::JSON_SYNTAX_ERROR);
+
+    case STATE_COLON:
+      if (c != ':')
+        return SetError(JSONReader::JSON_SYNTAX_ERROR);
+      state_ = STATE_MEMBER_VALUE;
+      return true;
+
+    case STATE_AFTER_VALUE:
+      if (c == ',') {
+        state_ = stack_.back() == '{' ? STATE_KEY : STATE_ARRAY_VALUE;
+        return true;
+      }
+      if (c == (stack_.back() == '{' ? '}' : ']')) {
+        EndContainer();
+        return true;
+      }
+      return SetError(JSONReader::JSON_SYNTAX_ERROR);
+
+    case STATE_DONE:
+      return SetError(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT);
+
+    case STATE_ERROR:
+      break;
+  }
+  NOTREACHED();
+  return false;
+}
+
+bool JSONStreamParser::BeginValue(const char* pos) {
+  char c = *pos;
+  if (state_ == STATE_ROOT && c != '{' && c != '[')
+    return SetError(JSONReader::JSON_BAD_ROOT_ELEMENT_TYPE);
+
+  switch (c) {
+    case '{':
+    case '[':
+      if (stack_.size() == kStackLimit)
+        return SetError(JSONReader::JSON_TOO_MUCH_NESTING);
+      stack_.push_back(c);
+      if (c == '{') {
+        state_ = STATE_FIRST_KEY;
+        delegate_->OnObjectBegin();
+      } else {
+        state_ = STATE_FIRST_ARRAY_VALUE;
+        delegate_->OnArrayBegin();
+      }
+      return true;
+
+    case '"':
+      string_is_key_ = false;
+      BeginToken(TOKEN_STRING, pos + 1);
+      return true;
+
+    case 't':
+      token_ = TOKEN_TRUE;
+      literal_ = "true" + 1;
+      return true;
+
+    case 'f':
+      token_ = TOKEN_FALSE;
+      literal_ = "false" + 1;
+      return true;
+
+    case 'n':
+      token_ = TOKEN_NULL;
+      literal_ = "null" + 1;
+      return true;
+
+    default:
+      if (c == '-' || IsAsciiDigit(c)) {
+        BeginToken(TOKEN_NUMBER, pos);
+        return true;
+      }
+      return SetError(JSONReader::JSON_SYNTAX_ERROR);
+  }
+}
+
+void JSONStreamParser::EndContainer() {
+  char container = stack_.back();
+  stack_.pop_back();
+  if (container == '{')
+    delegate_->OnObjectEnd();
+  else
+    delegate_->OnArrayEnd();
+  EndValue();
+}
+
+bool JSONStreamParser::ParseStringChar(const char** pos, const char* end) {
+  if (token_ == TOKEN_STRING) {
+    // Take the characters up to the next quote or escape in one go.
+    const char* run_end = *pos;
+    while (run_end < end && *run_end != '"' && *run_end != '\\')
+      ++run_end;
+    if (run_end != *pos)
+      FlushPendingSurrogate();
+    if (!token_start_)
+      buffer_.append(*pos, run_end - *pos);
+    *pos = run_end;
+    if (run_end == end)
+      return true;
+
+    ++*pos;
+    if (*run_end == '"') {
+      EndString(run_end);
+    } else {
+      BufferToken(run_end);
+      token_ = TOKEN_STRING_ESCAPE;
+    }
+    return true;
+  }
+
+  char c = *(*pos)++;
+  if (token_ == TOKEN_STRING_HEX) {
+    int digit;
+    if (IsAsciiDigit(c))
+      digit = c - '0';
+    else if (c >= 'a' && c <= 'f')
+      digit = c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F')
+      digit = c - 'A' + 10;
+    else
+      return SetError(JSONReader::JSON_INVALID_ESCAPE);
+    hex_value_ = hex_value_ * 16 + digit;
+    if (--hex_digits_left_ == 0) {
+      AppendEscapedCodePoint(hex_value_);
+      token_ = TOKEN_STRING;
+    }
+    return true;
+  }
+
+  DCHECK_EQ(TOKEN_STRING_ESCAPE, token_);
+  if (c == 'u' || c == 'x') {
+    token_ = TOKEN_STRING_HEX;
+    hex_digits_left_ = c == 'u' ? 4 : 2;
+    hex_value_ = 0;
+    return true;
+  }
+
+  char unescaped;
+  switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+      unescaped = c;
+      break;
+    case 'b':
+      unescaped = '\b';
+      break;
+    case 'f':
+      unescaped = '\f';
+      break;
+    case 'n':
+      unescaped = '\n';
+      break;
+    case 'r':
+      unescaped = '\r';
+      break;
+    case 't':
+      unescaped = '\t';
+      break;
+    case 'v':
+      unescaped = '\v';
+      break;
+    default:
+      return SetError(JSONReader::JSON_INVALID_ESCAPE);
+  }
+  FlushPendingSurrogate();
+  buffer_.push_back(unescaped);
+  token_ = TOKEN_STRING;
+  return true;
+}
+
+void JSONStreamParser::BeginToken(Token token, const char* pos) {
+  token_ = token;
+  token_start_ = pos;
+  buffer_.clear();
+}
+
+StringPiece JSONStreamParser::TokenText(const char* end) {
+  if (token_start_)
+    return StringPiece(token_start_, end - token_start_);
+  return StringPiece(buffer_);
+}
+
+void JSONStreamParser::BufferToken(const char* end) {
+  if (token_start_) {
+    buffer_.append(token_start_, end - token_start_);
+    token_start_ = NULL;
+  }
+}
+
+void JSONStreamParser::EndString(const char* end) {
+  FlushPendingSurrogate();
+  StringPiece text = TokenText(end);
+  token_ = TOKEN_NONE;
+  token_start_ = NULL;
+  if (string_is_key_) {
+    state_ = STATE_COLON;
+    delegate_->OnKey(text);
+  } else {
+    EndValue();
+    delegate_->OnString(text);
+  }
+}
+
+bool JSONStreamParser::EndNumber(const char* end) {
+  StringPiece text = TokenText(end);
+  if (!IsValidNumber(text))
+    return SetError(JSONReader::JSON_SYNTAX_ERROR);
+  token_ = TOKEN_NONE;
+  token_start_ = NULL;
+  EndValue();
+  delegate_->OnNumber(text);
+  return true;
+}
+
+void JSONStreamParser::EndLiteral() {
+  Token token = token_;
+  token_ = TOKEN_NONE;
+  EndValue();
+  if (token == TOKEN_NULL)
+    delegate_->OnNull();
+  else
+    delegate_->OnBool(token == TOKEN_TRUE);
+}
+
+void JSONStreamParser::AppendEscapedCodePoint(uint32 code_point) {
+  if (pending_surrogate_) {
+    if (IsLowSurrogate(code_point)) {
+      code_point = 0x10000 + ((pending_surrogate_ - 0xD800) << 10) +
+          (code_point - 0xDC00);
+      pending_surrogate_ = 0;
+      WriteUnicodeCharacter(code_point, &buffer_);
+      return;
+    }
+    FlushPendingSurrogate();
+  }
+  if (IsHighSurrogate(code_point)) {
+    pending_surrogate_ = code_point;
+    return;
+  }
+  if (IsLowSurrogate(code_point))
+    code_point = kReplacementCharacter;
+  WriteUnicodeCharacter(code_point, &buffer_);
+}
+
+void JSONStreamParser::FlushPendingSurrogate() {
+  if (pending_surrogate_) {
+    pending_surrogate_ = 0;
+    WriteUnicodeCharacter(kReplacementCharacter, &buffer_);
+  }
+}
+
+void JSONStreamParser::EndValue() {
+  state_ = stack_.empty() ? STATE_DONE : STATE_AFTER_VALUE;
+}
+
+bool JSONStreamParser::SetError(JSONReader::JsonParseError error) {
+  state_ = STATE_ERROR;
+  error_code_ = error;
+  return false;
+}
+
+}  // namespace base
@@ -0,0 +1,183 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// An event-driven JSON parser.  Where JSONReader builds a Value tree of the
+// whole document, JSONStreamParser tells a Delegate about each value as it is
+// parsed, and can be fed the document in pieces as they arrive.  It is meant
+// for large documents of which only a few fields are wanted.
+//
+// Strings are handed out as StringPieces.  They point into the input when the
+// string has no escapes and came in a single piece, and into a buffer of the
+// parser otherwise; either way they are only valid during the call.  Numbers
+// are handed out as their text, to be converted with StringToInt() or
+// StringToDouble() if they are wanted.
+//
+// The grammar is the one JSONReader accepts, with these differences:
+// - Comments are not allowed.
+// - The input is not checked to be valid UTF-8.
+// - A UTF-8 BOM is only skipped if it is at the start of the first piece.
+
+#ifndef BASE_JSON_JSON_STREAM_PARSER_H_
+#define BASE_JSON_JSON_STREAM_PARSER_H_
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "base/base_api.h"
+#include "base/basictypes.h"
+#include "base/json/json_reader.h"
+#include "base/string_piece.h"
+
+namespace base {
+
+class BASE_API JSONStreamParser {
+ public:
+  class Delegate {
+   public:
+    virtual ~Delegate() {}
+
+    virtual void OnObjectBegin() = 0;
+    virtual void OnObjectEnd() = 0;
+    virtual void OnArrayBegin() = 0;
+    virtual void OnArrayEnd() = 0;
+
+    // Called with the key of each member of an object, before its value.
+    virtual void OnKey(const StringPiece& key) = 0;
+
+    virtual void OnString(const StringPiece& value) = 0;
+    virtual void OnNumber(const StringPiece& number) = 0;
+    virtual void OnBool(bool value) = 0;
+    virtual void OnNull() = 0;
+  };
+
+  // |delegate| must outlive the parser.  If |allow_trailing_comma| is true,
+  // a comma before the end of an object or an array is ignored, as with
+  // JSONReader::Read().
+  JSONStreamParser(Delegate* delegate, bool allow_trailing_comma);
+  ~JSONStreamParser();
+
+  // Parses the next |length| bytes of the document.  Returns false once the
+  // document is found to be invalid; error_code() tells why, and further
+  // calls fail without calling the delegate.
+  bool Parse(const char* data, size_t length);
+  bool Parse(const StringPiece& data) {
+    return Parse(data.data(), data.size());
+  }
+
+  // Tells the parser that the whole document has been passed to Parse().
+  // Returns false if the document is invalid or incomplete.
+  bool Finish();
+
+  JSONReader::JsonParseError error_code() const { return error_code_; }
+
+ private:
+  // What the parser expects next, outside of tokens.
+  enum State {
+    STATE_ROOT,               // The root value.
+    STATE_MEMBER_VALUE,       // A value, after a ':'.
+    STATE_FIRST_ARRAY_VALUE,  // A value or ']', after '['.
+    STATE_ARRAY_VALUE,        // A value, after an array ','.
+    STATE_FIRST_KEY,          // A key or '}', after '{'.
+    STATE_KEY,                // A key, after an object ','.
+    STATE_COLON,              // The ':' after a key.
+    STATE_AFTER_VALUE,        // A ',' or the end of the container.
+    STATE_DONE,               // Only whitespace, after the root value.
+    STATE_ERROR,
+  };
+
+  // The token being read, which may span several calls to Parse().
+  enum Token {
+    TOKEN_NONE,
+    TOKEN_STRING,
+    TOKEN_STRING_ESCAPE,  // After a '\'.
+    TOKEN_STRING_HEX,     // In the digits of a \u or \x escape.
+    TOKEN_NUMBER,
+    TOKEN_TRUE,
+    TOKEN_FALSE,
+    TOKEN_NULL,
+  };
+
+  // Handles the character at |pos|, outside of a token.  Returns false on
+  // error.
+  bool ParseStructural(const char* pos);
+
+  // Handles the first character of a value at |pos|.  Returns false on
+  // error.
+  bool BeginValue(const char* pos);
+
+  // Handles the end of the innermost object or array.
+  void EndContainer();
+
+  // Handles the character at |pos| as part of a string.  |pos| is advanced
+  // past what was used.  Returns false on error.
+  bool ParseStringChar(const char** pos, const char* end);
+
+  // Starts a token at |pos|, whose text is in the current piece of input.
+  void BeginToken(Token token, const char* pos);
+
+  // Returns the text of the token, which ends at |end|.
+  StringPiece TokenText(const char* end);
+
+  // Moves the text of the token from the input to |buffer_|, if it isn't
+  // there yet.  Called at the end of a piece of input and on the first
+  // escape of a string.
+  void BufferToken(const char* end);
+
+  // Ends a string token at |end|, the position of the closing quote.
+  void EndString(const char* end);
+
+  // Ends a number token at |end|.  Returns false if it isn't a valid number.
+  bool EndNumber(const char* end);
+
+  // Ends a true, false or null token.
+  void EndLiteral();
+
+  // Appends the code point of a finished \u or \x escape to |buffer_|,
+  // pairing surrogates.
+  void AppendEscapedCodePoint(uint32 code_point);
+
+  // Appends a replacement character for a high surrogate that wasn't
+  // followed by a low one.
+  void FlushPendingSurrogate();
+
+  // Called after a value is finished.
+  void EndValue();
+
+  bool SetError(JSONReader::JsonParseError error);
+
+  Delegate* delegate_;
+  const bool allow_trailing_comma_;
+
+  State state_;
+  Token token_;
+
+  // The token started in the current piece of input at |token_start_|, or,
+  // if NULL, its text so far is in |buffer_|.
+  const char* token_start_;
+  std::string buffer_;
+
+  // Whether the string being read is a key.
+  bool string_is_key_;
+
+  // The rest of the literal being read.
+  const char* literal_;
+  // The digits still to be read of a \u or \x escape, and the value so far.
+  int hex_digits_left_;
+  uint32 hex_value_;
+  // A high surrogate waiting for its pair, or 0.
+  uint32 pending_surrogate_;
+
+  // '{' or '[' for each container being read.
+  std::vector<char> stack_;
+
+  bool at_start_;
+  JSONReader::JsonParseError error_code_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONStreamParser);
+};
+
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_STREAM_PARSER_H_
@@ -0,0 +1,199 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/json/json_stream_parser.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Writes the events it gets as text, e.g. {k(a),s(b),k(c),n(1),}.
+class RecordingDelegate : public JSONStreamParser::Delegate {
+ public:
+  RecordingDelegate() : input_begin_(NULL), input_end_(NULL), in_input_(0) {}
+
+  virtual void OnObjectBegin() { events_ += "{"; }
+  virtual void OnObjectEnd() { events_ += "}"; }
+  virtual void OnArrayBegin() { events_ += "["; }
+  virtual void OnArrayEnd() { events_ += "]"; }
+  virtual void OnKey(const StringPiece& key) {
+    Record("k", key);
+  }
+  virtual void OnString(const StringPiece& value) {
+    Record("s", value);
+  }
+  virtual void OnNumber(const StringPiece& number) {
+    Record("n", number);
+  }
+  virtual void OnBool(bool value) { events_ += value ? "true," : "false,"; }
+  virtual void OnNull() { events_ += "null,"; }
+
+  // Counts the strings that point into [begin, end).
+  void set_input(const char* begin, const char* end) {
+    input_begin_ = begin;
+    input_end_ = end;
+  }
+
+  const std::string& events() const { return events_; }
+  int in_input() const { return in_input_; }
+
+ private:
+  void Record(const char* type, const StringPiece& value) {
+    events_ += type;
+    events_ += "(";
+    value.AppendToString(&events_);
+    events_ += "),";
+    if (value.data() >= input_begin_ && value.data() < input_end_)
+      ++in_input_;
+  }
+
+  std::string events_;
+  const char* input_begin_;
+  const char* input_end_;
+  int in_input_;
+};
+
+// Parses |json| in one piece and returns the events, or "error".
+std::string ParseInOnePiece(const std::string& json) {
+  RecordingDelegate delegate;
+  JSONStreamParser parser(&delegate, false);
+  if (!parser.Parse(json) || !parser.Finish())
+    return "error";
+  return delegate.events();
+}
+
+// Parses |json| in pieces of |piece_size| bytes and returns the events, or
+// "error".
+std::string ParseInPieces(const std::string& json, size_t piece_size) {
+  RecordingDelegate delegate;
+  JSONStreamParser parser(&delegate, false);
+  for (size_t i = 0; i < json.size(); i += piece_size) {
+    // Copy each piece, so that it is gone after the call, as it would be for
+    // data read from the network.
+    std::string piece(json.substr(i, piece_size));
+    if (!parser.Parse(piece))
+      return "error";
+  }
+  if (!parser.Finish())
+    return "error";
+  return delegate.events();
+}
+
+JSONReader::JsonParseError ParseError(const std::string& json,
+                                      bool allow_trailing_comma) {
+  RecordingDelegate delegate;
+  JSONStreamParser parser(&delegate, allow_trailing_comma);
+  if (parser.Parse(json))
+    parser.Finish();
+  return parser.error_code();
+}
+
+}  // namespace
+
+TEST(JSONStreamParserTest, Values) {
+  EXPECT_EQ("{}", ParseInOnePiece("{}"));
+  EXPECT_EQ("[]", ParseInOnePiece(" [ ] "));
+  EXPECT_EQ("[true,false,null,]", ParseInOnePiece("[true, false, null]"));
+  EXPECT_EQ("[n(0),n(-1),n(12.5),n(1e10),n(-0.5E-3),]",
+            ParseInOnePiece("[0,-1,12.5,1e10,-0.5E-3]"));
+  EXPECT_EQ("{k(a),s(b),k(c),[{k(d),[]}]k(),s(),}",
+            ParseInOnePiece(
+                "{\"a\": \"b\", \"c\": [{\"d\": []}], \"\": \"\"}"));
+  // A UTF-8 BOM at the start is skipped.
+  EXPECT_EQ("[]", ParseInOnePiece("\xEF\xBB\xBF[]"));
+}
+
+TEST(JSONStreamParserTest, Escapes) {
+  EXPECT_EQ("[s(\"\\/\b\f\n\r\t\v),]",
+            ParseInOnePiece("[\"\\\"\\\\\\/\\b\\f\\n\\r\\t\\v\"]"));
+  EXPECT_EQ("[s(a\xC3\xA9" "b),]", ParseInOnePiece("[\"a\\u00e9b\"]"));
+  EXPECT_EQ("[s(A),]", ParseInOnePiece("[\"\\x41\"]"));
+  // A surrogate pair makes one UTF-8 character.
+  EXPECT_EQ("[s(\xF0\x9D\x84\x9E),]",
+            ParseInOnePiece("[\"\\uD834\\uDD1E\"]"));
+  // Lone surrogates are replaced.
+  EXPECT_EQ("[s(\xEF\xBF\xBDx),s(\xEF\xBF\xBD),]",
+            ParseInOnePiece("[\"\\uD834x\", \"\\uDD1E\"]"));
+}
+
+// Check that a document gives the same events however it is split.
+TEST(JSONStreamParserTest, Pieces) {
+  const std::string json(
+      "{\"name\": \"value\", \"escaped\": \"a\\tb\\u00e9\\uD834\\uDD1E\","
+      " \"numbers\": [0, -12, 3.25e-2], \"literals\": [true, false, null],"
+      " \"nested\": {\"a\": [{}, []]}}");
+  const std::string expected = ParseInOnePiece(json);
+  EXPECT_NE("error", expected);
+  for (size_t piece_size = 1; piece_size <= json.size(); ++piece_size)
+    EXPECT_EQ(expected, ParseInPieces(json, piece_size)) << piece_size;
+}
+
+// Check that strings without escapes are not copied.
+TEST(JSONStreamParserTest, StringsPointIntoInput) {
+  const std::string json("{\"key\": \"value\", \"other\": \"a\\nb\"}");
+  RecordingDelegate delegate;
+  delegate.set_input(json.data(), json.data() + json.size());
+  JSONStreamParser parser(&delegate, false);
+  EXPECT_TRUE(parser.Parse(json));
+  EXPECT_TRUE(parser.Finish());
+  // "key", "value" and "other", but not the escaped string.
+  EXPECT_EQ(3, delegate.in_input());
+}
+
+TEST(JSONStreamParserTest, Errors) {
+  EXPECT_EQ(JSONReader::JSON_NO_ERROR, ParseError("[1]", false));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, ParseError("", false));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, ParseError("[1", false));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, ParseError("[\"abc", false));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, ParseError("[1 2]", false));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, ParseError("[tru]", false));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, ParseError("[truex]", false));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, ParseError("{\"a\" 1}", false));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, ParseError("[1}", false));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, ParseError("[01]", false));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, ParseError("[1.]", false));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, ParseError("[-]", false));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, ParseError("[1e]", false));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, ParseError("[1-2]", false));
+  EXPECT_EQ(JSONReader::JSON_BAD_ROOT_ELEMENT_TYPE, ParseError("1", false));
+  EXPECT_EQ(JSONReader::JSON_BAD_ROOT_ELEMENT_TYPE,
+            ParseError("\"a\"", false));
+  EXPECT_EQ(JSONReader::JSON_INVALID_ESCAPE, ParseError("[\"\\q\"]", false));
+  EXPECT_EQ(JSONReader::JSON_INVALID_ESCAPE,
+            ParseError("[\"\\u12g4\"]", false));
+  EXPECT_EQ(JSONReader::JSON_UNQUOTED_DICTIONARY_KEY,
+            ParseError("{a: 1}", false));
+  EXPECT_EQ(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT,
+            ParseError("[] []", false));
+
+  EXPECT_EQ(JSONReader::JSON_TRAILING_COMMA, ParseError("[1,]", false));
+  EXPECT_EQ(JSONReader::JSON_TRAILING_COMMA,
+            ParseError("{\"a\": 1,}", false));
+  EXPECT_EQ(JSONReader::JSON_NO_ERROR, ParseError("[1,]", true));
+  EXPECT_EQ(JSONReader::JSON_NO_ERROR, ParseError("{\"a\": 1,}", true));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, ParseError("[,]", true));
+
+  std::string nested;
+  for (int i = 0; i < 100; ++i)
+    nested = "[" + nested + "]";
+  EXPECT_EQ(JSONReader::JSON_NO_ERROR, ParseError(nested, false));
+  EXPECT_EQ(JSONReader::JSON_TOO_MUCH_NESTING,
+            ParseError("[" + nested + "]", false));
+}
+
+// Check that nothing more is parsed after an error.
+TEST(JSONStreamParserTest, StopsAfterError) {
+  RecordingDelegate delegate;
+  JSONStreamParser parser(&delegate, false);
+  EXPECT_FALSE(parser.Parse("[1,,"));
+  EXPECT_FALSE(parser.Parse("2]"));
+  EXPECT_FALSE(parser.Finish());
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, parser.error_code());
+  EXPECT_EQ("[n(1),", delegate.events());
+}
+
+}  // namespace base
@@ -4,10 +4,12 @@
 
 #include "base/json/json_writer.h"
 
+#include <string.h>
+
 #include "base/json/string_escape.h"
 #include "base/logging.h"
 #include "base/string_util.h"
-#include "base/string_number_conversions.h"
+#include "base/third_party/dmg_fp/dmg_fp.h"
 #include "base/values.h"
 #include "base/utf_string_conversions.h"
 
@@ -19,6 +21,9 @@ static const char kPrettyPrintLineEnding[] = "\r\n";
 static const char kPrettyPrintLineEnding[] = "\n";
 #endif
 
+// How much JSON WriteToFile() keeps before writing it out.
+static const size_t kFileBufferSize = 64 * 1024;
+
 /* static */
 const char* JSONWriter::kEmptyArray = "[]";
 
@@ -35,20 +40,86 @@ void JSONWriter::WriteWithOptionalEscape(const Value* const node,
                                          bool escape,
                                          std::string* json) {
   json->clear();
-  // Is there a better way to estimate the size of the output?
-  json->reserve(1024);
-  JSONWriter writer(pretty_print, json);
+  json->reserve(EstimateSize(node, pretty_print, 0));
+  JSONWriter writer(pretty_print, json, NULL);
   writer.BuildJSONString(node, 0, escape);
   if (pretty_print)
     json->append(kPrettyPrintLineEnding);
 }
 
-JSONWriter::JSONWriter(bool pretty_print, std::string* json)
+/* static */
+bool JSONWriter::WriteToFile(const Value* const node,
+                             bool pretty_print,
+                             FILE* file) {
+  DCHECK(file);
+  std::string buffer;
+  buffer.reserve(kFileBufferSize + 1024);
+  JSONWriter writer(pretty_print, &buffer, file);
+  writer.BuildJSONString(node, 0, true);
+  if (pretty_print)
+    buffer.append(kPrettyPrintLineEnding);
+  writer.Flush();
+  return !writer.file_error_;
+}
+
+JSONWriter::JSONWriter(bool pretty_print, std::string* json, FILE* file)
     : json_string_(json),
-      pretty_print_(pretty_print) {
+      pretty_print_(pretty_print),
+      file_(file),
+      file_error_(false) {
   DCHECK(json);
 }
 
+/* static */
+size_t JSONWriter::EstimateSize(const Value* const node,
+                                bool pretty_print,
+                                int depth) {
+  switch (node->GetType()) {
+    case Value::TYPE_INTEGER:
+      return 11;
+
+    case Value::TYPE_DOUBLE:
+      return 24;
+
+    case Value::TYPE_STRING:
+      // Leave a little room for escapes.
+      return static_cast<const StringValue*>(node)->GetString().size() * 9 / 8 +
+          2;
+
+    case Value::TYPE_LIST: {
+      const ListValue* list = static_cast<const ListValue*>(node);
+      size_t size = 4;
+      for (ListValue::const_iterator it = list->begin(); it != list->end();
+           ++it) {
+        size += 2 + EstimateSize(*it, pretty_print, depth);
+      }
+      return size;
+    }
+
+    case Value::TYPE_DICTIONARY: {
+      const DictionaryValue* dict = static_cast<const DictionaryValue*>(node);
+      size_t size = 2;
+      if (pretty_print)
+        size += 2 + 3 * depth;
+      for (DictionaryValue::key_iterator key_itr = dict->begin_keys();
+           key_itr != dict->end_keys();
+           ++key_itr) {
+        Value* value = NULL;
+        dict->GetWithoutPathExpansion(*key_itr, &value);
+        size += (*key_itr).size() + 4 + EstimateSize(value, pretty_print,
+                                                      depth + 1);
+        if (pretty_print)
+          size += 2 + 3 * (depth + 1);
+      }
+      return size;
+    }
+
+    default:
+      // null, true, false.
+      return 5;
+  }
+}
+
 void JSONWriter::BuildJSONString(const Value* const node,
                                  int depth,
                                  bool escape) {
@@ -71,7 +142,7 @@ void JSONWriter::BuildJSONString(const Value* const node,
         int value;
         bool result = node->GetAsInteger(&value);
         DCHECK(result);
-        StringAppendF(json_string_, "%d", value);
+        AppendInteger(value);
         break;
       }
 
@@ -80,37 +151,14 @@ void JSONWriter::BuildJSONString(const Value* const node,
         double value;
         bool result = node->GetAsDouble(&value);
         DCHECK(result);
-        std::string real = DoubleToString(value);
-        // Ensure that the number has a .0 if there's no decimal or 'e'.  This
-        // makes sure that when we read the JSON back, it's interpreted as a
-        // real rather than an int.
-        if (real.find('.') == std::string::npos &&
-            real.find('e') == std::string::npos &&
-            real.find('E') == std::string::npos) {
-          real.append(".0");
-        }
-        // The JSON spec requires that non-integer values in the range (-1,1)
-        // have a zero before the decimal point - ".52" is not valid, "0.52" is.
-        if (real[0] == '.') {
-          real.insert(0, "0");
-        } else if (real.length() > 1 && real[0] == '-' && real[1] == '.') {
-          // "-.1" bad "-0.1" good
-          real.insert(1, "0");
-        }
-        json_string_->append(real);
+        AppendDouble(value);
         break;
       }
 
     case Value::TYPE_STRING:
       {
-        std::string value;
-        bool result = node->GetAsString(&value);
-        DCHECK(result);
-        if (escape) {
-          JsonDoubleQuote(UTF8ToUTF16(value), true, json_string_);
-        } else {
-          JsonDoubleQuote(value, true, json_string_);
-        }
+        AppendQuotedString(static_cast<const StringValue*>(node)->GetString(),
+                           escape);
         break;
       }
 
@@ -121,17 +169,16 @@ void JSONWriter::BuildJSONString(const Value* const node,
           json_string_->append(" ");
 
         const ListValue* list = static_cast<const ListValue*>(node);
-        for (size_t i = 0; i < list->GetSize(); ++i) {
-          if (i != 0) {
+        for (ListValue::const_iterator it = list->begin(); it != list->end();
+             ++it) {
+          if (it != list->begin()) {
             json_string_->append(",");
             if (pretty_print_)
               json_string_->append(" ");
           }
 
-          Value* value = NULL;
-          bool result = list->Get(i, &value);
-          DCHECK(result);
-          BuildJSONString(value, depth, escape);
+          BuildJSONString(*it, depth, escape);
+          MaybeFlush();
         }
 
         if (pretty_print_)
@@ -163,13 +210,14 @@ void JSONWriter::BuildJSONString(const Value* const node,
 
           if (pretty_print_)
             IndentLine(depth + 1);
-          AppendQuotedString(*key_itr);
+          AppendQuotedString(*key_itr, true);
           if (pretty_print_) {
             json_string_->append(": ");
           } else {
             json_string_->append(":");
           }
           BuildJSONString(value, depth + 1, escape);
+          MaybeFlush();
         }
 
         if (pretty_print_) {
@@ -188,16 +236,71 @@ void JSONWriter::BuildJSONString(const Value* const node,
   }
 }
 
-void JSONWriter::AppendQuotedString(const std::string& str) {
-  // TODO(viettrungluu): |str| is UTF-8, not ASCII, so to properly escape it we
-  // have to convert it to UTF-16. This round-trip is suboptimal.
-  JsonDoubleQuote(UTF8ToUTF16(str), true, json_string_);
+void JSONWriter::AppendQuotedString(const std::string& str, bool escape) {
+  // |str| is UTF-8, so to escape its non-ASCII characters it has to be
+  // converted to UTF-16.  ASCII strings, the usual case, escape the same
+  // either way.
+  if (escape && !IsStringASCII(str))
+    JsonDoubleQuote(UTF8ToUTF16(str), true, json_string_);
+  else
+    JsonDoubleQuote(str, true, json_string_);
+}
+
+void JSONWriter::AppendInteger(int value) {
+  char buffer[12];
+  char* end = buffer + arraysize(buffer);
+  char* digits = end;
+  // Negate as unsigned, which works for INT_MIN.
+  unsigned int magnitude = value < 0 ? 0U - static_cast<unsigned int>(value) :
+      static_cast<unsigned int>(value);
+  do {
+    *--digits = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude);
+  if (value < 0)
+    *--digits = '-';
+  json_string_->append(digits, end - digits);
+}
+
+void JSONWriter::AppendDouble(double value) {
+  // g_fmt() writes the shortest string that reads back as |value|; it needs
+  // at most 32 bytes.
+  char buffer[32];
+  dmg_fp::g_fmt(buffer, value);
+
+  const char* real = buffer;
+  if (*real == '-') {
+    json_string_->push_back('-');
+    ++real;
+  }
+  // The JSON spec requires that non-integer values in the range (-1,1)
+  // have a zero before the decimal point - ".52" is not valid, "0.52" is.
+  if (*real == '.')
+    json_string_->push_back('0');
+  json_string_->append(real);
+  // Ensure that the number has a .0 if there's no decimal or 'e'.  This
+  // makes sure that when we read the JSON back, it's interpreted as a
+  // real rather than an int.
+  if (!strpbrk(real, ".eE"))
+    json_string_->append(".0");
 }
 
 void JSONWriter::IndentLine(int depth) {
-  // It may be faster to keep an indent string so we don't have to keep
-  // reallocating.
-  json_string_->append(std::string(depth * 3, ' '));
+  json_string_->append(depth * 3, ' ');
+}
+
+void JSONWriter::MaybeFlush() {
+  if (file_ && json_string_->size() >= kFileBufferSize)
+    Flush();
+}
+
+void JSONWriter::Flush() {
+  if (!file_error_ && !json_string_->empty() &&
+      fwrite(json_string_->data(), 1, json_string_->size(), file_) !=
+          json_string_->size()) {
+    file_error_ = true;
+  }
+  json_string_->clear();
 }
 
 }  // namespace base
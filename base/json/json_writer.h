@@ -6,6 +6,8 @@
 #define BASE_JSON_JSON_WRITER_H_
 #pragma once
 
+#include <stdio.h>
+
 #include <string>
 
 #include "base/base_api.h"
@@ -35,28 +37,53 @@ class BASE_API JSONWriter {
                                       bool escape,
                                       std::string* json);
 
+  // Same as Write(), but writes the JSON to |file| as it is generated, so
+  // that writing a large value doesn't need a string of its size.  Returns
+  // false if writing to |file| failed.
+  static bool WriteToFile(const Value* const node, bool pretty_print,
+                          FILE* file);
+
   // A static, constant JSON string representing an empty array.  Useful
   // for empty JSON argument passing.
   static const char* kEmptyArray;
 
  private:
-  JSONWriter(bool pretty_print, std::string* json);
+  JSONWriter(bool pretty_print, std::string* json, FILE* file);
+
+  // Returns about how many bytes of JSON |node| makes, to size the output.
+  static size_t EstimateSize(const Value* const node, bool pretty_print,
+                             int depth);
 
   // Called recursively to build the JSON string.  Whe completed, value is
   // json_string_ will contain the JSON.
   void BuildJSONString(const Value* const node, int depth, bool escape);
 
-  // Appends a quoted, escaped, version of (UTF-8) str to json_string_.
-  void AppendQuotedString(const std::string& str);
+  // Appends a quoted version of (UTF-8) str to json_string_.  If |escape| is
+  // true, non-ASCII characters are escaped.
+  void AppendQuotedString(const std::string& str, bool escape);
+
+  void AppendInteger(int value);
+  void AppendDouble(double value);
 
   // Adds space to json_string_ for the indent level.
   void IndentLine(int depth);
 
+  // When writing to a file, writes json_string_ out once it is large enough.
+  void MaybeFlush();
+
+  // Writes json_string_ to |file_| and clears it.
+  void Flush();
+
   // Where we write JSON data as we generate it.
   std::string* json_string_;
 
   bool pretty_print_;
 
+  // The file json_string_ is written to, if any, and whether writing to it
+  // failed.
+  FILE* file_;
+  bool file_error_;
+
   DISALLOW_COPY_AND_ASSIGN(JSONWriter);
 };
 
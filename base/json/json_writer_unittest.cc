@@ -2,7 +2,11 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <limits.h>
+#include <stdio.h>
+
 #include "base/json/json_writer.h"
+#include "base/string_number_conversions.h"
 #include "base/values.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -95,4 +99,57 @@ TEST(JSONWriterTest, Writing) {
   ASSERT_EQ("{\"a\":{\"b\":2},\"a.b\":1}", output_js);
 }
 
+TEST(JSONWriterTest, Numbers) {
+  ListValue list;
+  list.Append(Value::CreateIntegerValue(0));
+  list.Append(Value::CreateIntegerValue(-7));
+  list.Append(Value::CreateIntegerValue(INT_MAX));
+  list.Append(Value::CreateIntegerValue(INT_MIN));
+  list.Append(Value::CreateDoubleValue(-0.25));
+  list.Append(Value::CreateDoubleValue(1e100));
+  list.Append(Value::CreateDoubleValue(0.1));
+  std::string output_js;
+  JSONWriter::Write(&list, false, &output_js);
+  EXPECT_EQ("[0,-7,2147483647,-2147483648,-0.25,1e+100,0.1]", output_js);
+}
+
+TEST(JSONWriterTest, Strings) {
+  DictionaryValue dict;
+  dict.SetString("ascii", "a\"b\\c<d>\n");
+  dict.SetString("utf8", "caf\xC3\xA9");
+  std::string output_js;
+  JSONWriter::Write(&dict, false, &output_js);
+  EXPECT_EQ("{\"ascii\":\"a\\\"b\\\\c\\u003Cd\\u003E\\n\","
+            "\"utf8\":\"caf\\u00E9\"}", output_js);
+}
+
+// Check that writing to a file gives the same JSON as writing to a string,
+// for a value large enough to be written out in several pieces.
+TEST(JSONWriterTest, WriteToFile) {
+  ListValue list;
+  for (int i = 0; i < 10000; ++i) {
+    DictionaryValue* dict = new DictionaryValue;
+    dict->SetInteger("id", i);
+    dict->SetString("name", "entry " + IntToString(i));
+    list.Append(dict);
+  }
+
+  for (int pretty_print = 0; pretty_print < 2; ++pretty_print) {
+    std::string expected;
+    JSONWriter::Write(&list, pretty_print != 0, &expected);
+
+    FILE* file = tmpfile();
+    ASSERT_TRUE(file);
+    EXPECT_TRUE(JSONWriter::WriteToFile(&list, pretty_print != 0, file));
+    rewind(file);
+    std::string written;
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+      written.append(buffer, read);
+    fclose(file);
+    EXPECT_EQ(expected, written);
+  }
+}
+
 }  // namespace base
@@ -48,28 +48,45 @@ static bool JsonSingleEscapeChar(const CHAR c, std::string* dst) {
   return true;
 }
 
+// Returns true if |c| is copied to the output as it is.
+template<typename CHAR>
+static bool IsUnescapedChar(const CHAR c) {
+  // 1. Escaping <, > to prevent script execution.
+  // 2. Technically, we could also pass through c > 126 as UTF8, but this
+  //    is also optional.  It would also be a pain to implement here.
+  return c >= 32 && c <= 126 && c != '"' && c != '\\' && c != '<' &&
+      c != '>';
+}
+
+// Appends \uXXXX for |c|.
+static void AppendUnicodeEscape(unsigned int c, std::string* dst) {
+  static const char kHexDigits[] = "0123456789ABCDEF";
+  char escape[6] = { '\\', 'u', kHexDigits[(c >> 12) & 0xF],
+                     kHexDigits[(c >> 8) & 0xF], kHexDigits[(c >> 4) & 0xF],
+                     kHexDigits[c & 0xF] };
+  dst->append(escape, sizeof(escape));
+}
+
 template <class STR>
 void JsonDoubleQuoteT(const STR& str,
                       bool put_in_quotes,
                       std::string* dst) {
+  dst->reserve(dst->size() + str.size() + 2);
   if (put_in_quotes)
     dst->push_back('"');
 
+  // Characters that need no escaping are copied a run at a time.
+  typename STR::const_iterator run_begin = str.begin();
   for (typename STR::const_iterator it = str.begin(); it != str.end(); ++it) {
     typename ToUnsigned<typename STR::value_type>::Unsigned c = *it;
-    if (!JsonSingleEscapeChar(c, dst)) {
-      if (c < 32 || c > 126 || c == '<' || c == '>') {
-        // 1. Escaping <, > to prevent script execution.
-        // 2. Technically, we could also pass through c > 126 as UTF8, but this
-        //    is also optional.  It would also be a pain to implement here.
-        unsigned int as_uint = static_cast<unsigned int>(c);
-        StringAppendF(dst, "\\u%04X", as_uint);
-      } else {
-        unsigned char ascii = static_cast<unsigned char>(*it);
-        dst->push_back(ascii);
-      }
-    }
+    if (IsUnescapedChar(c))
+      continue;
+    dst->append(run_begin, it);
+    run_begin = it + 1;
+    if (!JsonSingleEscapeChar(c, dst))
+      AppendUnicodeEscape(static_cast<unsigned int>(c), dst);
   }
+  dst->append(run_begin, str.end());
 
   if (put_in_quotes)
     dst->push_back('"');
@@ -0,0 +1,122 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/arena.h"
+
+#include <string.h>
+
+#include "base/logging.h"
+
+namespace base {
+
+namespace {
+
+size_t AlignSize(size_t size) {
+  return (size + Arena::kAlignment - 1) & ~(Arena::kAlignment - 1);
+}
+
+}  // namespace
+
+struct Arena::Block {
+  Block* next;
+  size_t size;
+};
+
+struct Arena::Destructor {
+  void (*function)(void*);
+  void* object;
+  Destructor* next;
+};
+
+Arena::Arena(size_t block_size)
+    : block_size_(AlignSize(block_size)),
+      blocks_(NULL),
+      next_(NULL),
+      end_(NULL),
+      destructors_(NULL),
+      bytes_reserved_(0) {
+  DCHECK_GT(block_size, 0u);
+}
+
+Arena::~Arena() {
+  Reset();
+}
+
+void* Arena::Allocate(size_t size) {
+  size = AlignSize(size);
+  if (size > static_cast<size_t>(end_ - next_))
+    return AllocateInNewBlock(size);
+  void* result = next_;
+  next_ += size;
+  return result;
+}
+
+char* Arena::CopyBytes(const char* data, size_t length) {
+  char* copy = static_cast<char*>(Allocate(length));
+  memcpy(copy, data, length);
+  return copy;
+}
+
+void Arena::RegisterDestructor(void (*destructor)(void*), void* object) {
+  Destructor* entry = static_cast<Destructor*>(Allocate(sizeof(Destructor)));
+  entry->function = destructor;
+  entry->object = object;
+  entry->next = destructors_;
+  destructors_ = entry;
+}
+
+void Arena::Reset() {
+  RunDestructors();
+  while (blocks_) {
+    Block* block = blocks_;
+    blocks_ = block->next;
+    ::operator delete(block);
+  }
+  next_ = NULL;
+  end_ = NULL;
+  bytes_reserved_ = 0;
+}
+
+void* Arena::AllocateInNewBlock(size_t size) {
+  // A large allocation gets a block of its own, so that the rest of the
+  // current block isn't wasted.
+  bool dedicated = size > block_size_ / 4;
+  size_t block_size = dedicated ? size : block_size_;
+
+  // The memory of a block starts after its header.
+  const size_t header_size = AlignSize(sizeof(Block));
+  Block* block = static_cast<Block*>(
+      ::operator new(header_size + block_size));
+  block->size = block_size;
+  bytes_reserved_ += header_size + block_size;
+  char* data = reinterpret_cast<char*>(block) + header_size;
+
+  if (dedicated && blocks_) {
+    // Keep the current block first.
+    block->next = blocks_->next;
+    blocks_->next = block;
+    return data;
+  }
+
+  block->next = blocks_;
+  blocks_ = block;
+  if (dedicated) {
+    next_ = NULL;
+    end_ = NULL;
+  } else {
+    next_ = data + size;
+    end_ = data + block_size;
+  }
+  return data;
+}
+
+void Arena::RunDestructors() {
+  while (destructors_) {
+    Destructor* entry = destructors_;
+    destructors_ = entry->next;
+    entry->function(entry->object);
+  }
+}
+
+}  // namespace base
@@ -0,0 +1,171 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Arena hands out memory for objects that all die together, such as the
+// temporaries of one URLRequest.  Memory is taken from large blocks by
+// bumping a pointer, and is only given back, all at once, when the arena is
+// destroyed or Reset().  Objects made with New() have their destructors run
+// then, in the reverse order of their creation.
+//
+//   base::Arena arena;
+//   Foo* foo = arena.New<Foo>(1, "bar");
+//   std::vector<int, base::ArenaAllocator<int> > ints(
+//       base::ArenaAllocator<int>(&arena));
+//
+// An arena is not thread safe.
+
+#ifndef BASE_MEMORY_ARENA_H_
+#define BASE_MEMORY_ARENA_H_
+#pragma once
+
+#include <stddef.h>
+
+#include <new>
+
+#include "base/base_api.h"
+#include "base/basictypes.h"
+
+namespace base {
+
+class BASE_API Arena {
+ public:
+  // Memory is returned aligned to this, which is enough for any object
+  // other than those with explicit alignment, such as SIMD types.
+  static const size_t kAlignment = 8;
+
+  static const size_t kDefaultBlockSize = 4096;
+
+  // Memory is taken from the general allocator |block_size| bytes at a time.
+  explicit Arena(size_t block_size = kDefaultBlockSize);
+
+  // Runs the registered destructors and frees the memory.
+  ~Arena();
+
+  // Returns |size| bytes, aligned to kAlignment.  Never returns NULL.
+  void* Allocate(size_t size);
+
+  // Makes a copy of |length| bytes at |data|.
+  char* CopyBytes(const char* data, size_t length);
+
+  // Has |destructor| called with |object| when the arena is destroyed or
+  // Reset().
+  void RegisterDestructor(void (*destructor)(void*), void* object);
+
+  // Makes a T that is destroyed with the arena.
+  template <typename T>
+  T* New() {
+    return Register(new (Allocate(sizeof(T))) T());
+  }
+  template <typename T, typename A1>
+  T* New(const A1& a1) {
+    return Register(new (Allocate(sizeof(T))) T(a1));
+  }
+  template <typename T, typename A1, typename A2>
+  T* New(const A1& a1, const A2& a2) {
+    return Register(new (Allocate(sizeof(T))) T(a1, a2));
+  }
+  template <typename T, typename A1, typename A2, typename A3>
+  T* New(const A1& a1, const A2& a2, const A3& a3) {
+    return Register(new (Allocate(sizeof(T))) T(a1, a2, a3));
+  }
+
+  // Runs the registered destructors and frees all the memory, for the arena
+  // to be used again.
+  void Reset();
+
+  // The number of bytes taken from the general allocator.
+  size_t bytes_reserved() const { return bytes_reserved_; }
+
+ private:
+  struct Block;
+  struct Destructor;
+
+  template <typename T>
+  static void Destroy(void* object) {
+    static_cast<T*>(object)->~T();
+  }
+
+  template <typename T>
+  T* Register(T* object) {
+    RegisterDestructor(&Destroy<T>, object);
+    return object;
+  }
+
+  // Allocates a new block holding at least |size| bytes.
+  void* AllocateInNewBlock(size_t size);
+
+  void RunDestructors();
+
+  const size_t block_size_;
+
+  // The blocks, the current one first.
+  Block* blocks_;
+
+  // The free part of the current block.
+  char* next_;
+  char* end_;
+
+  // The destructors to run, the last registered first.
+  Destructor* destructors_;
+
+  size_t bytes_reserved_;
+
+  DISALLOW_COPY_AND_ASSIGN(Arena);
+};
+
+// An STL allocator that allocates from an Arena.  Memory freed by the
+// container is only reclaimed with the arena, so it suits containers that
+// are filled and then dropped, rather than ones that grow and shrink.
+template <typename T>
+class ArenaAllocator {
+ public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+
+  template <typename U>
+  struct rebind {
+    typedef ArenaAllocator<U> other;
+  };
+
+  explicit ArenaAllocator(Arena* arena) : arena_(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+  pointer address(reference value) const { return &value; }
+  const_pointer address(const_reference value) const { return &value; }
+
+  pointer allocate(size_type count, const void* hint = 0) {
+    return static_cast<pointer>(arena_->Allocate(count * sizeof(T)));
+  }
+  void deallocate(pointer p, size_type count) {}
+
+  size_type max_size() const { return static_cast<size_type>(-1) / sizeof(T); }
+
+  void construct(pointer p, const T& value) { new (p) T(value); }
+  void destroy(pointer p) { p->~T(); }
+
+  Arena* arena() const { return arena_; }
+
+ private:
+  Arena* arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.arena() != b.arena();
+}
+
+}  // namespace base
+
+#endif  // BASE_MEMORY_ARENA_H_
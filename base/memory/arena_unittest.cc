@@ -0,0 +1,129 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/arena.h"
+
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Appends its id to |log| when destroyed.
+class Logger {
+ public:
+  Logger(std::string* log, char id) : log_(log), id_(id) {}
+  ~Logger() { *log_ += id_; }
+
+ private:
+  std::string* log_;
+  char id_;
+
+  DISALLOW_COPY_AND_ASSIGN(Logger);
+};
+
+bool IsAligned(void* pointer) {
+  return reinterpret_cast<uintptr_t>(pointer) % Arena::kAlignment == 0;
+}
+
+}  // namespace
+
+TEST(ArenaTest, Allocate) {
+  Arena arena(1024);
+  EXPECT_EQ(0u, arena.bytes_reserved());
+
+  char* a = static_cast<char*>(arena.Allocate(3));
+  char* b = static_cast<char*>(arena.Allocate(10));
+  EXPECT_TRUE(IsAligned(a));
+  EXPECT_TRUE(IsAligned(b));
+  // Allocations are bumped from the same block.
+  EXPECT_EQ(a + Arena::kAlignment, b);
+  memset(a, 'a', 3);
+  memset(b, 'b', 10);
+  size_t reserved = arena.bytes_reserved();
+  EXPECT_LT(1024u, reserved);
+
+  // Filling the block starts another one.
+  for (int i = 0; i < 100; ++i)
+    EXPECT_TRUE(IsAligned(arena.Allocate(17)));
+  EXPECT_LT(reserved, arena.bytes_reserved());
+  EXPECT_EQ('a', a[2]);
+  EXPECT_EQ('b', b[9]);
+}
+
+// Check that a large allocation gets its own block and doesn't use up the
+// current one.
+TEST(ArenaTest, LargeAllocation) {
+  Arena arena(1024);
+  char* a = static_cast<char*>(arena.Allocate(8));
+  char* large = static_cast<char*>(arena.Allocate(10000));
+  memset(large, 0, 10000);
+  char* b = static_cast<char*>(arena.Allocate(8));
+  EXPECT_EQ(a + 8, b);
+  EXPECT_LT(10000u + 1024u, arena.bytes_reserved());
+}
+
+TEST(ArenaTest, DestructorsRunInReverseOrder) {
+  std::string log;
+  {
+    Arena arena;
+    arena.New<Logger>(&log, '1');
+    Logger* second = arena.New<Logger>(&log, '2');
+    std::string* string = arena.New<std::string>(1000, 'x');
+    EXPECT_EQ(1000u, string->size());
+    EXPECT_TRUE(second);
+    arena.New<Logger>(&log, '3');
+    EXPECT_EQ("", log);
+  }
+  EXPECT_EQ("321", log);
+}
+
+TEST(ArenaTest, Reset) {
+  std::string log;
+  Arena arena;
+  arena.New<Logger>(&log, '1');
+  arena.Reset();
+  EXPECT_EQ("1", log);
+  EXPECT_EQ(0u, arena.bytes_reserved());
+
+  arena.New<Logger>(&log, '2');
+  EXPECT_EQ("1", log);
+  arena.Reset();
+  EXPECT_EQ("12", log);
+}
+
+TEST(ArenaTest, CopyBytes) {
+  Arena arena;
+  const char kData[] = "some bytes";
+  char* copy = arena.CopyBytes(kData, sizeof(kData));
+  EXPECT_NE(kData, copy);
+  EXPECT_STREQ(kData, copy);
+}
+
+TEST(ArenaTest, Allocator) {
+  Arena arena(256);
+  {
+    std::vector<int, ArenaAllocator<int> > ints((ArenaAllocator<int>(&arena)));
+    for (int i = 0; i < 1000; ++i)
+      ints.push_back(i);
+    EXPECT_EQ(999, ints.back());
+
+    typedef ArenaAllocator<std::pair<const int, std::string> > MapAllocator;
+    MapAllocator allocator(&arena);
+    std::map<int, std::string, std::less<int>, MapAllocator> map(
+        std::less<int>(), allocator);
+    map[1] = "one";
+    map[2] = "two";
+    EXPECT_EQ("two", map[2]);
+  }
+  EXPECT_LT(1000 * sizeof(int), arena.bytes_reserved());
+}
+
+}  // namespace base
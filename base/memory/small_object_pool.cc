@@ -0,0 +1,114 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/small_object_pool.h"
+
+#include <new>
+
+#include "base/lazy_instance.h"
+#include "base/threading/thread_local_storage.h"
+
+namespace base {
+
+namespace {
+
+// Sizes are rounded up to a multiple of this, which is enough for the
+// alignment of any object Task or a callback holds.
+const size_t kGranularity = 16;
+const size_t kNumSizeClasses = SmallObjectPool::kMaxPooledSize / kGranularity;
+
+// How many free blocks of each size class a thread keeps.
+const int kMaxFreeBlocksPerSizeClass = 64;
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+struct ThreadCache {
+  FreeBlock* free_lists[kNumSizeClasses];
+  int free_counts[kNumSizeClasses];
+};
+
+size_t SizeClassOf(size_t size) {
+  return size ? (size - 1) / kGranularity : 0;
+}
+
+// Called on thread exit with the cache of the exiting thread.
+void DeleteThreadCache(void* value) {
+  ThreadCache* cache = static_cast<ThreadCache*>(value);
+  for (size_t i = 0; i < kNumSizeClasses; ++i) {
+    while (cache->free_lists[i]) {
+      FreeBlock* block = cache->free_lists[i];
+      cache->free_lists[i] = block->next;
+      ::operator delete(block);
+    }
+  }
+  delete cache;
+}
+
+class ThreadCacheSlot {
+ public:
+  ThreadCacheSlot() : slot_(&DeleteThreadCache) {}
+
+  // Returns the cache of the calling thread, creating it if needed.
+  ThreadCache* Get() {
+    ThreadCache* cache = static_cast<ThreadCache*>(slot_.Get());
+    if (!cache) {
+      // If the thread is exiting, its cache may be created again after
+      // DeleteThreadCache() ran; the TLS destructors are run again for it.
+      cache = new ThreadCache();
+      slot_.Set(cache);
+    }
+    return cache;
+  }
+
+ private:
+  ThreadLocalStorage::Slot slot_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadCacheSlot);
+};
+
+// Leaky, since tasks are also run and freed on non-joinable threads.
+LazyInstance<ThreadCacheSlot, LeakyLazyInstanceTraits<ThreadCacheSlot> >
+    g_thread_cache_slot(LINKER_INITIALIZED);
+
+}  // namespace
+
+// static
+void* SmallObjectPool::Allocate(size_t size) {
+  if (size > kMaxPooledSize)
+    return ::operator new(size);
+
+  const size_t size_class = SizeClassOf(size);
+  ThreadCache* cache = g_thread_cache_slot.Pointer()->Get();
+  FreeBlock* block = cache->free_lists[size_class];
+  if (!block)
+    return ::operator new((size_class + 1) * kGranularity);
+  cache->free_lists[size_class] = block->next;
+  --cache->free_counts[size_class];
+  return block;
+}
+
+// static
+void SmallObjectPool::Free(void* pointer, size_t size) {
+  if (!pointer)
+    return;
+  if (size > kMaxPooledSize) {
+    ::operator delete(pointer);
+    return;
+  }
+
+  const size_t size_class = SizeClassOf(size);
+  ThreadCache* cache = g_thread_cache_slot.Pointer()->Get();
+  if (cache->free_counts[size_class] >= kMaxFreeBlocksPerSizeClass) {
+    ::operator delete(pointer);
+    return;
+  }
+  FreeBlock* block = static_cast<FreeBlock*>(pointer);
+  block->next = cache->free_lists[size_class];
+  cache->free_lists[size_class] = block;
+  ++cache->free_counts[size_class];
+}
+
+}  // namespace base
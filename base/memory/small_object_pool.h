@@ -0,0 +1,50 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// SmallObjectPool hands out memory for the small, short-lived objects that
+// are created for every posted task and bound callback, and freed right after
+// they run.  Freed blocks are kept on per-thread free lists, one for each
+// size class, and handed out again by the next allocation of that size class
+// on the same thread, without going through the general allocator or taking
+// any lock.
+//
+// A block may be freed on a different thread than the one that allocated it,
+// as tasks are, in which case it moves to the free list of the freeing
+// thread.  Each free list is bounded, so a thread that only frees sends the
+// extra blocks back to the general allocator.
+//
+// Classes use it by declaring their own operator new and operator delete, as
+// Task does.  Their destructor must be virtual if subclasses are deleted
+// through a base pointer, so that operator delete is given the right size.
+
+#ifndef BASE_MEMORY_SMALL_OBJECT_POOL_H_
+#define BASE_MEMORY_SMALL_OBJECT_POOL_H_
+#pragma once
+
+#include <stddef.h>
+
+#include "base/base_api.h"
+#include "base/basictypes.h"
+
+namespace base {
+
+class BASE_API SmallObjectPool {
+ public:
+  // Objects larger than this come from the general allocator.
+  static const size_t kMaxPooledSize = 128;
+
+  // Returns memory for an object of |size| bytes.  Never returns NULL.
+  static void* Allocate(size_t size);
+
+  // Frees |pointer|, which was returned by Allocate(|size|).  |pointer| may be
+  // NULL.
+  static void Free(void* pointer, size_t size);
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(SmallObjectPool);
+};
+
+}  // namespace base
+
+#endif  // BASE_MEMORY_SMALL_OBJECT_POOL_H_
@@ -0,0 +1,96 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/small_object_pool.h"
+
+#include <string.h>
+
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Frees the blocks it is given on its own thread.
+class FreeingThread : public SimpleThread {
+ public:
+  FreeingThread(void** blocks, int count, size_t size)
+      : SimpleThread("FreeingThread"),
+        blocks_(blocks),
+        count_(count),
+        size_(size) {}
+
+  virtual void Run() {
+    for (int i = 0; i < count_; ++i)
+      SmallObjectPool::Free(blocks_[i], size_);
+  }
+
+ private:
+  void** blocks_;
+  int count_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(FreeingThread);
+};
+
+}  // namespace
+
+TEST(SmallObjectPoolTest, ReusesFreedBlocks) {
+  void* first = SmallObjectPool::Allocate(40);
+  ASSERT_TRUE(first);
+  memset(first, 0xab, 40);
+  SmallObjectPool::Free(first, 40);
+
+  // Any size in the same size class gets the block back.
+  void* second = SmallObjectPool::Allocate(33);
+  EXPECT_EQ(first, second);
+  SmallObjectPool::Free(second, 33);
+}
+
+TEST(SmallObjectPoolTest, SizeClassesAreSeparate) {
+  void* small = SmallObjectPool::Allocate(8);
+  SmallObjectPool::Free(small, 8);
+
+  void* large = SmallObjectPool::Allocate(100);
+  EXPECT_NE(small, large);
+  memset(large, 0, 100);
+  SmallObjectPool::Free(large, 100);
+}
+
+TEST(SmallObjectPoolTest, LargeAndEmptyObjects) {
+  const size_t kLargeSize = SmallObjectPool::kMaxPooledSize + 1;
+  void* large = SmallObjectPool::Allocate(kLargeSize);
+  ASSERT_TRUE(large);
+  memset(large, 0, kLargeSize);
+  SmallObjectPool::Free(large, kLargeSize);
+
+  void* empty = SmallObjectPool::Allocate(0);
+  EXPECT_TRUE(empty);
+  SmallObjectPool::Free(empty, 0);
+
+  SmallObjectPool::Free(NULL, 16);
+}
+
+TEST(SmallObjectPoolTest, FreeOnAnotherThread) {
+  const int kNumBlocks = 200;
+  const size_t kSize = 48;
+  void* blocks[kNumBlocks];
+  for (int i = 0; i < kNumBlocks; ++i) {
+    blocks[i] = SmallObjectPool::Allocate(kSize);
+    memset(blocks[i], i, kSize);
+  }
+
+  // More blocks than a thread keeps, so some go back to the allocator, and
+  // the rest are released when the thread exits.
+  FreeingThread thread(blocks, kNumBlocks, kSize);
+  thread.Start();
+  thread.Join();
+
+  void* block = SmallObjectPool::Allocate(kSize);
+  EXPECT_TRUE(block);
+  SmallObjectPool::Free(block, kSize);
+}
+
+}  // namespace base
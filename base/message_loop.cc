@@ -81,6 +81,8 @@ const base::LinearHistogram::DescriptionPair event_descriptions_[] = {
 
 bool enable_histogrammer_ = false;
 
+bool enable_task_timing_ = false;
+
 }  // namespace
 
 //------------------------------------------------------------------------------
@@ -164,6 +166,7 @@ MessageLoop::MessageLoop(Type type)
     DCHECK_EQ(TYPE_DEFAULT, type_);
     pump_ = new base::MessagePumpDefault();
   }
+  incoming_queue_ = new IncomingTaskQueue(pump_);
 }
 
 MessageLoop::~MessageLoop() {
@@ -209,6 +212,22 @@ void MessageLoop::EnableHistogrammer(bool enable) {
   enable_histogrammer_ = enable;
 }
 
+// static
+void MessageLoop::EnableTaskTiming(bool enable) {
+  enable_task_timing_ = enable;
+}
+
+MessageLoop::TaskTiming::TaskTiming() : count(0) {
+}
+
+void MessageLoop::TaskTiming::Record(TimeDelta queue_time, TimeDelta run_time) {
+  ++count;
+  total_queue_time += queue_time;
+  max_queue_time = std::max(max_queue_time, queue_time);
+  total_run_time += run_time;
+  max_run_time = std::max(max_run_time, run_time);
+}
+
 void MessageLoop::AddDestructionObserver(
     DestructionObserver* destruction_observer) {
   DCHECK_EQ(this, current());
@@ -300,8 +319,7 @@ void MessageLoop::RemoveTaskObserver(TaskObserver* task_observer) {
 
 void MessageLoop::AssertIdle() const {
   // We only check |incoming_queue_|, since we don't want to lock |work_queue_|.
-  base::AutoLock lock(incoming_queue_lock_);
-  DCHECK(incoming_queue_.empty());
+  DCHECK(incoming_queue_->IsEmpty());
 }
 
 //------------------------------------------------------------------------------
@@ -358,31 +376,56 @@ bool MessageLoop::ProcessNextDelayedNonNestableTask() {
   if (deferred_non_nestable_work_queue_.empty())
     return false;
 
-  Task* task = deferred_non_nestable_work_queue_.front().task;
+  PendingTask pending_task = deferred_non_nestable_work_queue_.front();
   deferred_non_nestable_work_queue_.pop();
 
-  RunTask(task);
+  RunTask(pending_task);
   return true;
 }
 
-void MessageLoop::RunTask(Task* task) {
+void MessageLoop::RunTask(const PendingTask& pending_task) {
   DCHECK(nestable_tasks_allowed_);
   // Execute the task and assume the worst: It is probably not reentrant.
   nestable_tasks_allowed_ = false;
 
+  Task* task = pending_task.task;
   HistogramEvent(kTaskRunEvent);
   FOR_EACH_OBSERVER(TaskObserver, task_observers_,
                     WillProcessTask(task));
-  task->Run();
+  if (pending_task.time_posted.is_null()) {
+    task->Run();
+  } else {
+    TimeTicks start_time = TimeTicks::Now();
+    task->Run();
+    RecordTaskTiming(pending_task, start_time, TimeTicks::Now());
+  }
   FOR_EACH_OBSERVER(TaskObserver, task_observers_, DidProcessTask(task));
   delete task;
 
   nestable_tasks_allowed_ = true;
 }
 
+void MessageLoop::RecordTaskTiming(const PendingTask& pending_task,
+                                   TimeTicks start_time,
+                                   TimeTicks end_time) {
+  TimeTicks ready_time =
+      std::max(pending_task.time_posted, pending_task.delayed_run_time);
+  tracked_objects::Location posted_from(pending_task.posted_from_function,
+                                        pending_task.posted_from_file,
+                                        pending_task.posted_from_line);
+  task_timings_[posted_from].Record(start_time - ready_time,
+                                    end_time - start_time);
+}
+
+void MessageLoop::TakeTaskTimings(TaskTimingMap* timings) {
+  DCHECK_EQ(this, current());
+  timings->clear();
+  timings->swap(task_timings_);
+}
+
 bool MessageLoop::DeferOrRunPendingTask(const PendingTask& pending_task) {
   if (pending_task.nestable || state_->run_depth == 1) {
-    RunTask(pending_task.task);
+    RunTask(pending_task);
     // Show that we ran a task (Note: a new one might arrive as a
     // consequence!).
     return true;
@@ -412,14 +455,8 @@ void MessageLoop::ReloadWorkQueue() {
   if (!work_queue_.empty())
     return;  // Wait till we *really* need to lock and load.
 
-  // Acquire all we can from the inter-thread queue with one lock acquisition.
-  {
-    base::AutoLock lock(incoming_queue_lock_);
-    if (incoming_queue_.empty())
-      return;
-    incoming_queue_.Swap(&work_queue_);  // Constant time
-    DCHECK(incoming_queue_.empty());
-  }
+  // Acquire all we can from the inter-thread queue.
+  incoming_queue_->ReloadInto(&work_queue_);
 }
 
 bool MessageLoop::DeletePendingTasks() {
@@ -475,6 +512,11 @@ void MessageLoop::PostTask_Helper(
   task->SetBirthPlace(from_here);
 
   PendingTask pending_task(task, nestable);
+  pending_task.posted_from_function = from_here.function_name();
+  pending_task.posted_from_file = from_here.file_name();
+  pending_task.posted_from_line = from_here.line_number();
+  if (enable_task_timing_)
+    pending_task.time_posted = TimeTicks::Now();
 
   if (delay_ms > 0) {
     pending_task.delayed_run_time =
@@ -513,23 +555,106 @@ void MessageLoop::PostTask_Helper(
   // directly, as it could starve handling of foreign threads.  Put every task
   // into this queue.
 
-  scoped_refptr<base::MessagePump> pump;
-  {
-    base::AutoLock locked(incoming_queue_lock_);
+  // Since the incoming_queue_ may contain a task that destroys this message
+  // loop as soon as the task is pushed, we must not touch |this| afterwards.
+  // We use a stack-based reference to the queue, which holds the pump, so that
+  // the push can finish and wake the pump up regardless.
+  scoped_refptr<IncomingTaskQueue> incoming_queue(incoming_queue_);
+  incoming_queue->Push(pending_task);
+}
 
-    bool was_empty = incoming_queue_.empty();
-    incoming_queue_.push(pending_task);
-    if (!was_empty)
-      return;  // Someone else should have started the sub-pump.
+//------------------------------------------------------------------------------
+// MessageLoop::IncomingTaskQueue
 
-    pump = pump_;
+MessageLoop::IncomingTaskQueue::Node::Node(const PendingTask& pending_task)
+    : pending_task(pending_task),
+      next(0) {
+}
+
+MessageLoop::IncomingTaskQueue::IncomingTaskQueue(base::MessagePump* pump)
+    : head_(reinterpret_cast<base::subtle::AtomicWord>(&stub_)),
+      tail_(&stub_),
+      stub_(PendingTask(NULL, false)),
+      wakeup_pending_(0),
+      pump_(pump) {
+}
+
+// Possibly called on a background thread!
+void MessageLoop::IncomingTaskQueue::Push(const PendingTask& pending_task) {
+  PushNode(new Node(pending_task));
+
+  // Wake the pump up unless someone else already did since the loop last
+  // emptied the queue; the loop will find this task when it gets to it.  The
+  // barrier orders the link made by PushNode() before the check, pairing with
+  // the one in ReloadInto().
+  base::subtle::MemoryBarrier();
+  if (base::subtle::NoBarrier_CompareAndSwap(&wakeup_pending_, 0, 1) == 0)
+    pump_->ScheduleWork();
+}
+
+void MessageLoop::IncomingTaskQueue::ReloadInto(TaskQueue* work_queue) {
+  // Clear the flag before looking at the queue, so that a task we miss because
+  // it is being posted right now wakes the pump up again.
+  base::subtle::NoBarrier_Store(&wakeup_pending_, 0);
+  base::subtle::MemoryBarrier();
+
+  while (Node* node = PopNode()) {
+    work_queue->push(node->pending_task);
+    delete node;
   }
-  // Since the incoming_queue_ may contain a task that destroys this message
-  // loop, we cannot exit incoming_queue_lock_ until we are done with |this|.
-  // We use a stack-based reference to the message pump so that we can call
-  // ScheduleWork outside of incoming_queue_lock_.
+}
 
-  pump->ScheduleWork();
+bool MessageLoop::IncomingTaskQueue::IsEmpty() const {
+  return tail_ == &stub_ && !base::subtle::Acquire_Load(&stub_.next);
+}
+
+MessageLoop::IncomingTaskQueue::~IncomingTaskQueue() {
+  // Nobody posts any more.  The tasks themselves are leaked, like any task
+  // posted to a loop that is gone.
+  while (Node* node = PopNode())
+    delete node;
+}
+
+void MessageLoop::IncomingTaskQueue::PushNode(Node* node) {
+  base::subtle::NoBarrier_Store(&node->next, 0);
+  Node* previous = reinterpret_cast<Node*>(
+      base::subtle::NoBarrier_AtomicExchange(
+          &head_, reinterpret_cast<base::subtle::AtomicWord>(node)));
+  // Until this store, the loop sees the queue as ending at |previous|.  The
+  // release makes |node|'s contents visible along with the link.
+  base::subtle::Release_Store(&previous->next,
+                              reinterpret_cast<base::subtle::AtomicWord>(node));
+}
+
+MessageLoop::IncomingTaskQueue::Node*
+MessageLoop::IncomingTaskQueue::PopNode() {
+  Node* tail = tail_;
+  Node* next = reinterpret_cast<Node*>(base::subtle::Acquire_Load(&tail->next));
+  if (tail == &stub_) {
+    if (!next)
+      return NULL;
+    tail_ = next;
+    tail = next;
+    next = reinterpret_cast<Node*>(base::subtle::Acquire_Load(&tail->next));
+  }
+  if (next) {
+    tail_ = next;
+    return tail;
+  }
+
+  // |tail| is the last node linked in.  Unless a poster has already swapped in
+  // a newer head and is about to link it, put the stub back behind |tail| so
+  // that |tail| can be handed out.
+  Node* head = reinterpret_cast<Node*>(base::subtle::Acquire_Load(&head_));
+  if (tail != head)
+    return NULL;
+  PushNode(&stub_);
+  next = reinterpret_cast<Node*>(base::subtle::Acquire_Load(&tail->next));
+  if (next) {
+    tail_ = next;
+    return tail;
+  }
+  return NULL;
 }
 
 //------------------------------------------------------------------------------
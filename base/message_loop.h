@@ -6,9 +6,11 @@
 #define BASE_MESSAGE_LOOP_H_
 #pragma once
 
+#include <map>
 #include <queue>
 #include <string>
 
+#include "base/atomicops.h"
 #include "base/base_api.h"
 #include "base/basictypes.h"
 #include "base/memory/ref_counted.h"
@@ -110,6 +112,27 @@ class BASE_API MessageLoop : public base::MessagePump::Delegate {
 
   static void EnableHistogrammer(bool enable_histogrammer);
 
+  // Starts or stops timing the tasks posted to all MessageLoops, see
+  // TakeTaskTimings().  Only tasks posted while timing is enabled are timed.
+  // Timing costs reading the clock once when a task is posted and twice when
+  // it runs, so it can be left on.
+  static void EnableTaskTiming(bool enable);
+
+  // How long the tasks posted from one location waited to run, and how long
+  // they ran.  A delayed task waits from the time it was due.
+  struct BASE_API TaskTiming {
+    TaskTiming();
+
+    void Record(base::TimeDelta queue_time, base::TimeDelta run_time);
+
+    int count;
+    base::TimeDelta total_queue_time;
+    base::TimeDelta max_queue_time;
+    base::TimeDelta total_run_time;
+    base::TimeDelta max_run_time;
+  };
+  typedef std::map<tracked_objects::Location, TaskTiming> TaskTimingMap;
+
   // A DestructionObserver is notified when the current MessageLoop is being
   // destroyed.  These obsevers are notified prior to MessageLoop::current()
   // being changed to return NULL.  This gives interested parties the chance to
@@ -303,6 +326,12 @@ class BASE_API MessageLoop : public base::MessagePump::Delegate {
   void AddTaskObserver(TaskObserver* task_observer);
   void RemoveTaskObserver(TaskObserver* task_observer);
 
+  // Moves the timings of the tasks that ran on this loop since the last call
+  // into |timings|, by the location they were posted from.  This can only be
+  // called on the thread |this| is running on; exporting the timings
+  // periodically is a matter of posting a task that calls this.
+  void TakeTaskTimings(TaskTimingMap* timings);
+
   // Returns true if the message loop has high resolution timers enabled.
   // Provided for testing.
   bool high_resolution_timers_enabled() {
@@ -357,7 +386,9 @@ class BASE_API MessageLoop : public base::MessagePump::Delegate {
   // This structure is copied around by value.
   struct PendingTask {
     PendingTask(Task* task, bool nestable)
-        : task(task), sequence_num(0), nestable(nestable) {
+        : task(task), sequence_num(0), nestable(nestable),
+          posted_from_function(NULL), posted_from_file(NULL),
+          posted_from_line(0) {
     }
 
     // Used to support sorting.
@@ -367,6 +398,13 @@ class BASE_API MessageLoop : public base::MessagePump::Delegate {
     base::TimeTicks delayed_run_time;  // The time when the task should be run.
     int sequence_num;                  // Secondary sort key for run time.
     bool nestable;                     // OK to dispatch from a nested loop.
+
+    // When the task was posted, if task timing was enabled then, and where
+    // from.  The location is kept in pieces, as Location can't be assigned.
+    base::TimeTicks time_posted;
+    const char* posted_from_function;
+    const char* posted_from_file;
+    int posted_from_line;
   };
 
   class TaskQueue : public std::queue<PendingTask> {
@@ -378,6 +416,69 @@ class BASE_API MessageLoop : public base::MessagePump::Delegate {
 
   typedef std::priority_queue<PendingTask> DelayedTaskQueue;
 
+  // The queue of tasks posted from any thread and not yet loaded into
+  // |work_queue_|.  Posting does not take a lock: it is an intrusive
+  // multi-producer, single-consumer queue, where a push swaps the head and
+  // links the previous one to it.  It also decides when the pump has to be
+  // woken up, which is only for the first task posted since the loop last
+  // emptied the queue.
+  //
+  // It is reference counted, and holds the pump, so that a poster can finish
+  // its push and wake-up even if a task it queued destroys the loop first.
+  class IncomingTaskQueue
+      : public base::RefCountedThreadSafe<IncomingTaskQueue> {
+   public:
+    explicit IncomingTaskQueue(base::MessagePump* pump);
+
+    // Queues |pending_task| and wakes the pump up if that is needed.  May be
+    // called on any thread.
+    void Push(const PendingTask& pending_task);
+
+    // Moves the tasks queued so far to the end of |work_queue|, in the order
+    // they were posted.  Only called on the loop's thread.
+    void ReloadInto(TaskQueue* work_queue);
+
+    // True if no task is queued.  Only called on the loop's thread; a task
+    // being posted concurrently may or may not be counted.
+    bool IsEmpty() const;
+
+   private:
+    friend class base::RefCountedThreadSafe<IncomingTaskQueue>;
+
+    struct Node {
+      explicit Node(const PendingTask& pending_task);
+
+      PendingTask pending_task;
+      base::subtle::AtomicWord next;  // Node*
+    };
+
+    ~IncomingTaskQueue();
+
+    void PushNode(Node* node);
+
+    // Returns the oldest node, which the caller then owns, or NULL if there is
+    // none or the oldest is still being linked in by its poster.
+    Node* PopNode();
+
+    // The most recently pushed node.  Written by every poster.
+    base::subtle::AtomicWord head_;  // Node*
+
+    // The oldest node not yet popped, or |stub_|.  Only used by the loop.
+    Node* tail_;
+
+    // Keeps the queue from ever being empty of nodes, so that pushes and pops
+    // never touch the same node's fields at once.
+    Node stub_;
+
+    // Set by the poster that wakes the pump up, cleared by the loop before it
+    // empties the queue.
+    base::subtle::Atomic32 wakeup_pending_;
+
+    scoped_refptr<base::MessagePump> pump_;
+
+    DISALLOW_COPY_AND_ASSIGN(IncomingTaskQueue);
+  };
+
 #if defined(OS_WIN)
   base::MessagePumpWin* pump_win() {
     return static_cast<base::MessagePumpWin*>(pump_.get());
@@ -407,7 +508,13 @@ class BASE_API MessageLoop : public base::MessagePump::Delegate {
   bool ProcessNextDelayedNonNestableTask();
 
   // Runs the specified task and deletes it.
-  void RunTask(Task* task);
+  void RunTask(const PendingTask& pending_task);
+
+  // Adds the timing of |pending_task|, which started running at |start_time|
+  // and stopped at |end_time|, to task_timings_.
+  void RecordTaskTiming(const PendingTask& pending_task,
+                        base::TimeTicks start_time,
+                        base::TimeTicks end_time);
 
   // Calls RunTask or queues the pending_task on the deferred task list if it
   // cannot be run right now.  Returns true if the task was run.
@@ -417,8 +524,8 @@ class BASE_API MessageLoop : public base::MessagePump::Delegate {
   void AddToDelayedWorkQueue(const PendingTask& pending_task);
 
   // Load tasks from the incoming_queue_ into work_queue_ if the latter is
-  // empty.  The former requires a lock to access, while the latter is directly
-  // accessible on this thread.
+  // empty.  The former is shared with the posting threads, while the latter is
+  // directly accessible on this thread.
   void ReloadWorkQueue();
 
   // Delete tasks that haven't run yet without running them.  Used in the
@@ -475,13 +582,11 @@ class BASE_API MessageLoop : public base::MessagePump::Delegate {
   // A profiling histogram showing the counts of various messages and events.
   base::Histogram* message_histogram_;
 
-  // A null terminated list which creates an incoming_queue of tasks that are
-  // acquired under a mutex for processing on this instance's thread. These
-  // tasks have not yet been sorted out into items for our work_queue_ vs
-  // items that will be handled by the TimerManager.
-  TaskQueue incoming_queue_;
-  // Protect access to incoming_queue_.
-  mutable base::Lock incoming_queue_lock_;
+  // The tasks posted to this instance, from any thread, for processing on
+  // this instance's thread. These tasks have not yet been sorted out into
+  // items for our work_queue_ vs items that will be handled by the
+  // TimerManager.
+  scoped_refptr<IncomingTaskQueue> incoming_queue_;
 
   RunState* state_;
 
@@ -497,6 +602,9 @@ class BASE_API MessageLoop : public base::MessagePump::Delegate {
 
   ObserverList<TaskObserver> task_observers_;
 
+  // The timings of the tasks that ran since the last TakeTaskTimings().
+  TaskTimingMap task_timings_;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(MessageLoop);
 };
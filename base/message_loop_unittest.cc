@@ -1584,6 +1584,47 @@ TEST(MessageLoopTest, TaskObserver) {
   EXPECT_EQ(kNumTasks, observer.num_tasks_processed());
 }
 
+class SleepingTask : public Task {
+ public:
+  explicit SleepingTask(int sleep_ms) : sleep_ms_(sleep_ms) {}
+
+  virtual void Run() {
+    base::PlatformThread::Sleep(sleep_ms_);
+  }
+
+ private:
+  const int sleep_ms_;
+};
+
+TEST(MessageLoopTest, TaskTiming) {
+  const int kSleepMs = 20;
+
+  MessageLoop loop;
+  MessageLoop::EnableTaskTiming(true);
+  const tracked_objects::Location posted_from = FROM_HERE;
+  loop.PostTask(posted_from, new SleepingTask(kSleepMs));
+  loop.PostTask(posted_from, new SleepingTask(kSleepMs));
+  MessageLoop::EnableTaskTiming(false);
+  // Posted while timing is disabled, so not timed.
+  loop.PostTask(FROM_HERE, new MessageLoop::QuitTask());
+  loop.Run();
+
+  MessageLoop::TaskTimingMap timings;
+  loop.TakeTaskTimings(&timings);
+  ASSERT_EQ(1U, timings.size());
+  MessageLoop::TaskTimingMap::const_iterator it = timings.find(posted_from);
+  ASSERT_TRUE(it != timings.end());
+  EXPECT_EQ(2, it->second.count);
+  EXPECT_GE(it->second.total_run_time.InMilliseconds(), 2 * kSleepMs - 2);
+  EXPECT_GE(it->second.max_run_time.InMilliseconds(), kSleepMs - 1);
+  // The second task waited for the first to run.
+  EXPECT_GE(it->second.max_queue_time.InMilliseconds(), kSleepMs - 1);
+
+  // The timings were moved out of the loop.
+  loop.TakeTaskTimings(&timings);
+  EXPECT_TRUE(timings.empty());
+}
+
 #if defined(OS_WIN)
 TEST(MessageLoopTest, Dispatcher) {
   // This test requires a UI loop
@@ -1701,6 +1742,31 @@ TEST(MessageLoopTest, FileDescriptorWatcherDoubleStop) {
     PLOG(ERROR) << "close";
 }
 
+TEST(MessageLoopTest, FileDescriptorWatcherWatchAfterStop) {
+  // Verify that a controller that was stopped can watch a FD again, as
+  // sockets do on every read and write that would block.
+  int pipefds[2];
+  int err = pipe(pipefds);
+  ASSERT_EQ(0, err);
+  int fd = pipefds[1];
+  {
+    MessageLoopForIO message_loop;
+    base::MessagePumpLibevent::FileDescriptorWatcher controller;
+    QuitDelegate delegate;
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_TRUE(message_loop.WatchFileDescriptor(fd,
+          false, MessageLoopForIO::WATCH_WRITE, &controller, &delegate));
+      // The write end of an empty pipe is writable, so this returns.
+      message_loop.Run();
+      EXPECT_TRUE(controller.StopWatchingFileDescriptor());
+    }
+  }
+  if (HANDLE_EINTR(close(pipefds[0])) < 0)
+    PLOG(ERROR) << "close";
+  if (HANDLE_EINTR(close(pipefds[1])) < 0)
+    PLOG(ERROR) << "close";
+}
+
 }  // namespace
 
 #endif  // defined(OS_POSIX) && !defined(OS_NACL)
@@ -26,8 +26,10 @@
 // struct event (of which there is roughly one per socket).
 // The socket's struct event is created in
 // MessagePumpLibevent::WatchFileDescriptor(),
-// is owned by the FileDescriptorWatcher, and is destroyed in
-// StopWatchingFileDescriptor().
+// is owned by the FileDescriptorWatcher, and is kept by
+// StopWatchingFileDescriptor() for the next WatchFileDescriptor() with the
+// same FileDescriptorWatcher.  It is destroyed with the
+// FileDescriptorWatcher.
 // It is moved into and out of lists in struct event_base by
 // the libevent functions event_add() and event_del().
 //
@@ -52,6 +54,7 @@ static int SetNonBlocking(int fd) {
 MessagePumpLibevent::FileDescriptorWatcher::FileDescriptorWatcher()
     : is_persistent_(false),
       event_(NULL),
+      spare_event_(NULL),
       pump_(NULL),
       watcher_(NULL) {
 }
@@ -60,6 +63,7 @@ MessagePumpLibevent::FileDescriptorWatcher::~FileDescriptorWatcher() {
   if (event_) {
     StopWatchingFileDescriptor();
   }
+  delete spare_event_;
 }
 
 bool MessagePumpLibevent::FileDescriptorWatcher::StopWatchingFileDescriptor() {
@@ -69,7 +73,8 @@ bool MessagePumpLibevent::FileDescriptorWatcher::StopWatchingFileDescriptor() {
 
   // event_del() is a no-op if the event isn't active.
   int rv = event_del(e);
-  delete e;
+  DCHECK(!spare_event_);
+  spare_event_ = e;
   pump_ = NULL;
   watcher_ = NULL;
   return (rv == 0);
@@ -90,6 +95,12 @@ event *MessagePumpLibevent::FileDescriptorWatcher::ReleaseEvent() {
   return e;
 }
 
+event* MessagePumpLibevent::FileDescriptorWatcher::ReleaseSpareEvent() {
+  struct event* e = spare_event_;
+  spare_event_ = NULL;
+  return e;
+}
+
 void MessagePumpLibevent::FileDescriptorWatcher::OnFileCanReadWithoutBlocking(
     int fd, MessagePumpLibevent* pump) {
   pump->WillProcessIOEvent();
@@ -150,8 +161,11 @@ bool MessagePumpLibevent::WatchFileDescriptor(int fd,
 
   scoped_ptr<event> evt(controller->ReleaseEvent());
   if (evt.get() == NULL) {
-    // Ownership is transferred to the controller.
-    evt.reset(new event);
+    // Ownership is transferred to the controller.  event_set() below
+    // initializes the event whether or not it was used before.
+    evt.reset(controller->ReleaseSpareEvent());
+    if (evt.get() == NULL)
+      evt.reset(new event);
   } else {
     // Make sure we don't pick up any funky internal libevent masks.
     int old_interest_mask = evt.get()->ev_events &
@@ -344,10 +358,13 @@ void MessagePumpLibevent::OnWakeup(int socket, short flags, void* context) {
               static_cast<base::MessagePumpLibevent*>(context);
   DCHECK(that->wakeup_pipe_out_ == socket);
 
-  // Remove and discard the wakeup byte.
-  char buf;
-  int nread = HANDLE_EINTR(read(socket, &buf, 1));
-  DCHECK_EQ(nread, 1);
+  // Remove and discard the wakeup bytes.  Several ScheduleWork() calls may
+  // have been made since the last wakeup; reading all of their bytes at once
+  // keeps the pipe from waking up the following loop iterations too, which
+  // have nothing left to do for them.
+  char buf[64];
+  int nread = HANDLE_EINTR(read(socket, buf, sizeof(buf)));
+  DCHECK_GT(nread, 0);
   // Tell libevent to break out of inner loop.
   event_base_loopbreak(that->event_base_);
 }
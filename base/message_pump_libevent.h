@@ -70,6 +70,10 @@ class MessagePumpLibevent : public MessagePump {
     // Used by MessagePumpLibevent to take ownership of event_.
     event *ReleaseEvent();
 
+    // Used by MessagePumpLibevent to take ownership of spare_event_, which may
+    // be NULL.
+    event* ReleaseSpareEvent();
+
     void set_pump(MessagePumpLibevent* pump) { pump_ = pump; }
     MessagePumpLibevent* pump() { return pump_; }
 
@@ -80,6 +84,10 @@ class MessagePumpLibevent : public MessagePump {
 
     bool is_persistent_;  // false if this event is one-shot.
     event* event_;
+    // The event of the last watch, kept by StopWatchingFileDescriptor() so
+    // that watching the FD again, as sockets do on every read and write that
+    // would block, does not allocate a new one.
+    event* spare_event_;
     MessagePumpLibevent* pump_;
     Watcher* watcher_;
 
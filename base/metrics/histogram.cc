@@ -289,6 +289,10 @@ bool Histogram::DeserializeHistogramInfo(const std::string& histogram_info) {
   DCHECK_EQ(render_histogram->bucket_count(), bucket_count);
   DCHECK_EQ(render_histogram->range_checksum(), range_checksum);
   DCHECK_EQ(render_histogram->histogram_type(), histogram_type);
+  if (sample.size() != render_histogram->bucket_count()) {
+    LOG(ERROR) << "Size error decoding Histogram: " << histogram_name;
+    return false;
+  }
 
   if (render_histogram->flags() & kIPCSerializationSourceFlag) {
     DVLOG(1) << "Single process mode, histogram observed and not copied: "
@@ -396,7 +400,8 @@ Histogram::Histogram(const std::string& name, Sample minimum,
     flags_(kNoFlags),
     ranges_(bucket_count + 1, 0),
     range_checksum_(0),
-    sample_() {
+    sample_(),
+    registry_next_(NULL) {
   Initialize();
 }
 
@@ -409,7 +414,8 @@ Histogram::Histogram(const std::string& name, TimeDelta minimum,
     flags_(kNoFlags),
     ranges_(bucket_count + 1, 0),
     range_checksum_(0),
-    sample_() {
+    sample_(),
+    registry_next_(NULL) {
   Initialize();
 }
 
@@ -683,12 +689,25 @@ void Histogram::SampleSet::CheckSize(const Histogram& histogram) const {
 void Histogram::SampleSet::Accumulate(Sample value,  Count count,
                                       size_t index) {
   DCHECK(count == 1 || count == -1);
-  counts_[index] += count;
-  sum_ += count * value;
-  redundant_count_ += count;
-  DCHECK_GE(counts_[index], 0);
-  DCHECK_GE(sum_, 0);
-  DCHECK_GE(redundant_count_, 0);
+  COMPILE_ASSERT(sizeof(Count) == sizeof(subtle::Atomic32),
+                 counts_must_be_atomic32);
+  Count bucket_count = subtle::NoBarrier_AtomicIncrement(
+      reinterpret_cast<subtle::Atomic32*>(&counts_[index]), count);
+#if defined(ARCH_CPU_64_BITS)
+  int64 sum = subtle::NoBarrier_AtomicIncrement(
+      reinterpret_cast<subtle::Atomic64*>(&sum_),
+      static_cast<int64>(count) * value);
+  int64 redundant_count = subtle::NoBarrier_AtomicIncrement(
+      reinterpret_cast<subtle::Atomic64*>(&redundant_count_), count);
+#else
+  // Without 64-bit atomics a race can still lose an update of these, which
+  // FindCorruption() allows some slop for.
+  int64 sum = sum_ += count * value;
+  int64 redundant_count = redundant_count_ += count;
+#endif
+  DCHECK_GE(bucket_count, 0);
+  DCHECK_GE(sum, 0);
+  DCHECK_GE(redundant_count, 0);
 }
 
 Count Histogram::SampleSet::TotalCount() const {
@@ -727,7 +746,19 @@ bool Histogram::SampleSet::Serialize(Pickle* pickle) const {
   pickle->WriteInt64(redundant_count_);
   pickle->WriteSize(counts_.size());
 
+  // Most buckets of a delta are empty, so only the others are sent, as pairs
+  // of index and count.
+  size_t used_buckets = 0;
   for (size_t index = 0; index < counts_.size(); ++index) {
+    if (counts_[index])
+      used_buckets++;
+  }
+  pickle->WriteSize(used_buckets);
+
+  for (size_t index = 0; index < counts_.size(); ++index) {
+    if (!counts_[index])
+      continue;
+    pickle->WriteSize(index);
     pickle->WriteInt(counts_[index]);
   }
 
@@ -740,23 +771,32 @@ bool Histogram::SampleSet::Deserialize(void** iter, const Pickle& pickle) {
   DCHECK_EQ(redundant_count_, 0);
 
   size_t counts_size;
+  size_t used_buckets;
 
   if (!pickle.ReadInt64(iter, &sum_) ||
       !pickle.ReadInt64(iter, &redundant_count_) ||
-      !pickle.ReadSize(iter, &counts_size)) {
+      !pickle.ReadSize(iter, &counts_size) ||
+      !pickle.ReadSize(iter, &used_buckets)) {
     return false;
   }
 
-  if (counts_size == 0)
+  if (counts_size == 0 || counts_size > kBucketCount_MAX ||
+      used_buckets > counts_size)
     return false;
 
+  counts_.resize(counts_size, 0);
   int count = 0;
-  for (size_t index = 0; index < counts_size; ++index) {
+  size_t next_index = 0;  // Indices must be growing, to prevent duplicates.
+  for (size_t bucket = 0; bucket < used_buckets; ++bucket) {
+    size_t index;
     int i;
-    if (!pickle.ReadInt(iter, &i))
+    if (!pickle.ReadSize(iter, &index) || !pickle.ReadInt(iter, &i) ||
+        index < next_index || index >= counts_size) {
       return false;
-    counts_.push_back(i);
+    }
+    counts_[index] = i;
     count += i;
+    next_index = index + 1;
   }
   DCHECK_EQ(count, redundant_count_);
   return count == redundant_count_;
@@ -983,6 +1023,7 @@ StatisticsRecorder::StatisticsRecorder() {
   }
   base::AutoLock auto_lock(*lock_);
   histograms_ = new HistogramMap;
+  ClearRegistry();
 }
 
 StatisticsRecorder::~StatisticsRecorder() {
@@ -999,6 +1040,7 @@ StatisticsRecorder::~StatisticsRecorder() {
     base::AutoLock auto_lock(*lock_);
     histograms = histograms_;
     histograms_ = NULL;
+    ClearRegistry();
   }
   delete histograms;
   // We don't delete lock_ on purpose to avoid having to properly protect
@@ -1025,6 +1067,12 @@ Histogram* StatisticsRecorder::RegisterOrDeleteDuplicate(Histogram* histogram) {
   // Avoid overwriting a previous registration.
   if (histograms_->end() == it) {
     (*histograms_)[name] = histogram;
+    // Publish the histogram for FindHistogram() once it is linked in.
+    subtle::AtomicWord* bucket = &registry_[RegistryBucket(name)];
+    histogram->registry_next_ =
+        reinterpret_cast<Histogram*>(subtle::NoBarrier_Load(bucket));
+    subtle::Release_Store(bucket, reinterpret_cast<subtle::AtomicWord>(
+        histogram));
   } else {
     delete histogram;  // We already have one by this name.
     histogram = it->second;
@@ -1093,16 +1141,15 @@ void StatisticsRecorder::GetHistograms(Histograms* output) {
 
 bool StatisticsRecorder::FindHistogram(const std::string& name,
                                        Histogram** histogram) {
-  if (lock_ == NULL)
-    return false;
-  base::AutoLock auto_lock(*lock_);
-  if (!histograms_)
-    return false;
-  HistogramMap::iterator it = histograms_->find(name);
-  if (histograms_->end() == it)
-    return false;
-  *histogram = it->second;
-  return true;
+  Histogram* it = reinterpret_cast<Histogram*>(
+      subtle::Acquire_Load(&registry_[RegistryBucket(name)]));
+  for (; it; it = it->registry_next_) {
+    if (it->histogram_name() == name) {
+      *histogram = it;
+      return true;
+    }
+  }
+  return false;
 }
 
 // private static
@@ -1121,9 +1168,29 @@ void StatisticsRecorder::GetSnapshot(const std::string& query,
   }
 }
 
+// static
+size_t StatisticsRecorder::RegistryBucket(const std::string& name) {
+  // The FNV-1a hash.
+  uint32 hash = 2166136261u;
+  for (size_t i = 0; i < name.length(); ++i) {
+    hash ^= static_cast<uint8>(name[i]);
+    hash *= 16777619u;
+  }
+  return hash % kRegistryBuckets;
+}
+
+// static
+void StatisticsRecorder::ClearRegistry() {
+  lock_->AssertAcquired();
+  for (size_t i = 0; i < kRegistryBuckets; ++i)
+    subtle::Release_Store(&registry_[i], 0);
+}
+
 // static
 StatisticsRecorder::HistogramMap* StatisticsRecorder::histograms_ = NULL;
 // static
+subtle::AtomicWord StatisticsRecorder::registry_[kRegistryBuckets];
+// static
 base::Lock* StatisticsRecorder::lock_ = NULL;
 // static
 bool StatisticsRecorder::dump_on_exit_ = false;
@@ -45,6 +45,7 @@
 #include <string>
 #include <vector>
 
+#include "base/atomicops.h"
 #include "base/base_api.h"
 #include "base/gtest_prod_util.h"
 #include "base/logging.h"
@@ -331,11 +332,15 @@ class BASE_API Histogram {
     void Resize(const Histogram& histogram);
     void CheckSize(const Histogram& histogram) const;
 
-    // Accessor for histogram to make routine additions.
+    // Accessor for histogram to make routine additions.  The bucket counts
+    // are updated atomically, so that samples added on several threads at
+    // once are not lost, and the sum and the redundant count are too where
+    // there are 64-bit atomics.
     void Accumulate(Sample value, Count count, size_t index);
 
     // Accessor methods.
     Count counts(size_t i) const { return counts_[i]; }
+    size_t size() const { return counts_.size(); }
     Count TotalCount() const;
     int64 sum() const { return sum_; }
     int64 redundant_count() const { return redundant_count_; }
@@ -418,7 +423,8 @@ class BASE_API Histogram {
   // histograms created in the renderer).
 
   // Serialize the given snapshot of a Histogram into a String. Uses
-  // Pickle class to flatten the object.
+  // Pickle class to flatten the object. Only the buckets that are not empty
+  // are written, so a small delta is cheap to send.
   static std::string SerializeHistogramInfo(const Histogram& histogram,
                                             const SampleSet& snapshot);
   // The following method accepts a list of pickled histograms and
@@ -574,6 +580,10 @@ class BASE_API Histogram {
   // sample.
   SampleSet sample_;
 
+  // The next histogram in the same bucket of StatisticsRecorder::registry_.
+  // Set once, before the histogram is published in the registry.
+  Histogram* registry_next_;
+
   DISALLOW_COPY_AND_ASSIGN(Histogram);
 };
 
@@ -707,8 +717,8 @@ class BASE_API StatisticsRecorder {
   static void GetHistograms(Histograms* output);
 
   // Find a histogram by name. It matches the exact name. This method is thread
-  // safe.  If a matching histogram is not found, then the |histogram| is
-  // not changed.
+  // safe, and does not take the lock.  If a matching histogram is not found,
+  // then the |histogram| is not changed.
   static bool FindHistogram(const std::string& query, Histogram** histogram);
 
   static bool dump_on_exit() { return dump_on_exit_; }
@@ -728,7 +738,23 @@ class BASE_API StatisticsRecorder {
 
   static HistogramMap* histograms_;
 
-  // lock protects access to the above map.
+  // The number of buckets in |registry_|.
+  static const size_t kRegistryBuckets = 512;
+
+  // Returns the bucket of |registry_| for |name|.
+  static size_t RegistryBucket(const std::string& name);
+
+  // Sets all the buckets of |registry_| to NULL.  Called with the lock held.
+  static void ClearRegistry();
+
+  // The registered histograms again, as a hash table of singly linked lists
+  // through Histogram::registry_next_, in which FindHistogram() looks names
+  // up without the lock.  Histograms are only ever added at the head of a
+  // bucket, with the lock held, and are leaked rather than deleted, so a
+  // reader can always finish walking the list it started on.
+  static subtle::AtomicWord registry_[kRegistryBuckets];
+
+  // lock protects access to the above map, and to changes of |registry_|.
   static base::Lock* lock_;
 
   // Dump all known histograms to log.
@@ -5,7 +5,10 @@
 // Test of Histogram class
 
 #include "base/metrics/histogram.h"
+#include "base/pickle.h"
 #include "base/scoped_ptr.h"
+#include "base/stringprintf.h"
+#include "base/threading/platform_thread.h"
 #include "base/time.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -147,6 +150,80 @@ TEST(HistogramTest, RecordedStartupTest) {
 #endif
 }
 
+// Check that histograms are found by name, without the lock, among more
+// histograms than the registry has buckets.
+TEST(HistogramTest, FindHistogramTest) {
+  const int kHistogramCount = 1500;
+  {
+    StatisticsRecorder recorder;
+    std::vector<Histogram*> created;
+    for (int i = 0; i < kHistogramCount; ++i) {
+      created.push_back(Histogram::FactoryGet(
+          StringPrintf("FindHistogram%d", i), 1, 1000, 10,
+          Histogram::kNoFlags));
+    }
+    for (int i = 0; i < kHistogramCount; ++i) {
+      Histogram* found = NULL;
+      EXPECT_TRUE(StatisticsRecorder::FindHistogram(
+          StringPrintf("FindHistogram%d", i), &found));
+      EXPECT_EQ(created[i], found);
+    }
+    Histogram* found = NULL;
+    EXPECT_FALSE(StatisticsRecorder::FindHistogram("FindHistogram", &found));
+    EXPECT_EQ(reinterpret_cast<Histogram*>(NULL), found);
+  }
+
+  // Nothing is found once the recorder is gone, or in a new one.
+  Histogram* found = NULL;
+  EXPECT_FALSE(StatisticsRecorder::FindHistogram("FindHistogram0", &found));
+  StatisticsRecorder recorder;
+  EXPECT_FALSE(StatisticsRecorder::FindHistogram("FindHistogram0", &found));
+  EXPECT_EQ(reinterpret_cast<Histogram*>(NULL), found);
+}
+
+class AddSamplesThread : public PlatformThread::Delegate {
+ public:
+  AddSamplesThread(Histogram* histogram, int count)
+      : histogram_(histogram), count_(count) {}
+
+  virtual void ThreadMain() {
+    for (int i = 0; i < count_; ++i)
+      histogram_->Add(i % 100);
+  }
+
+ private:
+  Histogram* histogram_;
+  int count_;
+
+  DISALLOW_COPY_AND_ASSIGN(AddSamplesThread);
+};
+
+// Check that no sample is lost when threads add to a histogram at once.
+TEST(HistogramTest, ConcurrentAddTest) {
+  const int kThreadCount = 4;
+  const int kSamplesPerThread = 20000;
+  Histogram* histogram(LinearHistogram::FactoryGet(
+      "ConcurrentAdd", 1, 100, 101, Histogram::kNoFlags));
+
+  AddSamplesThread delegate(histogram, kSamplesPerThread);
+  PlatformThreadHandle handles[kThreadCount];
+  for (int i = 0; i < kThreadCount; ++i)
+    ASSERT_TRUE(PlatformThread::Create(0, &delegate, &handles[i]));
+  for (int i = 0; i < kThreadCount; ++i)
+    PlatformThread::Join(handles[i]);
+
+  Histogram::SampleSet sample;
+  histogram->SnapshotSample(&sample);
+  EXPECT_EQ(kThreadCount * kSamplesPerThread, sample.TotalCount());
+  for (size_t i = 1; i <= 99; ++i)
+    EXPECT_EQ(kThreadCount * kSamplesPerThread / 100, sample.counts(i)) << i;
+#if defined(ARCH_CPU_64_BITS)
+  EXPECT_EQ(kThreadCount * kSamplesPerThread, sample.redundant_count());
+  EXPECT_EQ(static_cast<int64>(kThreadCount) * (kSamplesPerThread / 100) *
+            (99 * 100 / 2), sample.sum());
+#endif
+}
+
 TEST(HistogramTest, RangeTest) {
   StatisticsRecorder recorder;
   StatisticsRecorder::Histograms histograms;
@@ -383,6 +460,44 @@ TEST(HistogramTest, CorruptBucketBounds) {
   ++histogram->ranges_[4];
 }
 
+// Only the buckets that are not empty are serialized.
+TEST(HistogramTest, SerializeSampleSet) {
+  Histogram* histogram(Histogram::FactoryGet(
+      "SparseHistogram", 1, 1000, 100, Histogram::kNoFlags));
+  histogram->Add(5);
+  histogram->Add(5);
+  histogram->Add(500);
+
+  Histogram::SampleSet snapshot;
+  histogram->SnapshotSample(&snapshot);
+  Pickle pickle;
+  EXPECT_TRUE(snapshot.Serialize(&pickle));
+  EXPECT_LT(pickle.size(), 100 * sizeof(Histogram::Count));
+
+  Histogram::SampleSet copy;
+  void* iter = NULL;
+  EXPECT_TRUE(copy.Deserialize(&iter, pickle));
+  ASSERT_EQ(snapshot.size(), copy.size());
+  for (size_t i = 0; i < snapshot.size(); ++i)
+    EXPECT_EQ(snapshot.counts(i), copy.counts(i));
+  EXPECT_EQ(snapshot.sum(), copy.sum());
+  EXPECT_EQ(3, copy.redundant_count());
+
+  // A bucket that is repeated or out of range is rejected.
+  Pickle bad_pickle;
+  bad_pickle.WriteInt64(10);
+  bad_pickle.WriteInt64(2);
+  bad_pickle.WriteSize(snapshot.size());
+  bad_pickle.WriteSize(2);
+  bad_pickle.WriteSize(3);
+  bad_pickle.WriteInt(1);
+  bad_pickle.WriteSize(3);
+  bad_pickle.WriteInt(1);
+  Histogram::SampleSet bad_copy;
+  iter = NULL;
+  EXPECT_FALSE(bad_copy.Deserialize(&iter, bad_pickle));
+}
+
 // Table was generated similarly to sample code for CRC-32 given on:
 // http://www.w3.org/TR/PNG/#D-CRCAppendix.
 TEST(HistogramTest, Crc32TableTest) {
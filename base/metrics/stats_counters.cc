@@ -32,6 +32,30 @@ void StatsCounter::Add(int value) {
     (*loc) += value;
 }
 
+// static
+void StatsCounter::AddToCounter(const char* name, int value,
+                                subtle::Atomic32* cache) {
+  StatsTable* table = StatsTable::current();
+  if (!table)
+    return;
+
+  int slot = table->GetSlot();
+  if (!slot && !(slot = table->RegisterThread("")))
+    return;
+
+  int counter_id = table->GetCachedCounterId(cache);
+  if (!counter_id) {
+    counter_id = table->FindCounter(std::string("c:").append(name));
+    if (!counter_id)
+      return;
+    table->CacheCounterId(counter_id, cache);
+  }
+
+  int* loc = table->GetLocation(counter_id, slot);
+  if (loc)
+    (*loc) += value;
+}
+
 StatsCounter::StatsCounter()
     : counter_id_(-1) {
 }
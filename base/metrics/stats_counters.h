@@ -46,9 +46,12 @@ namespace base {
 // as the implementation varies, or depending on compile options.
 //------------------------------------------------------------------------------
 // First provide generic macros, which exist in production as well as debug.
+// The counter id is cached at each place the macro is used, so that the
+// counter is only looked up by name the first time.  |name| must be a
+// const char*.
 #define STATS_COUNTER(name, delta) do { \
-  base::StatsCounter counter(name); \
-  counter.Add(delta); \
+  static base::subtle::Atomic32 counter_id_cache = 0; \
+  base::StatsCounter::AddToCounter(name, delta, &counter_id_cache); \
 } while (0)
 
 #define SIMPLE_STATS_COUNTER(name) STATS_COUNTER(name, 1)
@@ -112,6 +115,12 @@ class BASE_API StatsCounter {
     return 0;
   }
 
+  // Adds |value| to the counter |name| for the calling thread, with the
+  // counter id cached in |cache|.  See StatsTable::GetCachedCounterId().
+  // This is what STATS_COUNTER uses.
+  static void AddToCounter(const char* name, int value,
+                           subtle::Atomic32* cache);
+
  protected:
   StatsCounter();
 
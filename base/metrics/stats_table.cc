@@ -37,7 +37,10 @@ namespace base {
 // +-------------------------------------------+
 //
 // The data layout is a grid, where the columns are the thread_ids and the
-// rows are the counter_ids.
+// rows are the counter_ids.  The grid is stored a column at a time, and each
+// column starts on its own cache line, so that the counters a thread writes
+// are not on the same cache lines as the ones other threads write.  The
+// columns are only added up when a row's value is read.
 //
 // If the first character of the thread_name is '\0', then that column is
 // empty.
@@ -72,7 +75,16 @@ namespace {
 
 // An internal version in case we ever change the format of this
 // file, and so that we can identify our table.
-const int kTableVersion = 0x13131313;
+const int kTableVersion = 0x13131314;
+
+// The size of the cache lines the columns of the data are aligned to.
+const int kCacheLineSize = 64;
+
+// A cached counter id is stored with the generation of the table that cached
+// it in the high bits.
+const int kCachedCounterIdBits = 16;
+const int kCachedCounterIdMask = (1 << kCachedCounterIdBits) - 1;
+const int kGenerationMask = (1 << (31 - kCachedCounterIdBits)) - 1;
 
 // The name for un-named counters and threads in the table.
 const char kUnknownName[] = "<unknown>";
@@ -86,6 +98,32 @@ inline int AlignedSize(int size) {
   return size + AlignOffset(size);
 }
 
+// Calculates delta to align an offset to a cache line.
+inline int AlignOffsetToCacheLine(int offset) {
+  return (kCacheLineSize - (offset % kCacheLineSize)) % kCacheLineSize;
+}
+
+// Returns the number of ints in a column of the data, including the padding
+// to the next cache line.
+inline int ColumnLength(int max_counters) {
+  int size = max_counters * sizeof(int);
+  return (size + AlignOffsetToCacheLine(size)) / sizeof(int);
+}
+
+// Returns the size of the shared memory for a table of the given size.  This
+// must match StatsTable::Private::ComputeMappedPointers().
+int TableSize(int header_size, int max_threads, int max_counters) {
+  int size = AlignedSize(header_size) +
+      AlignedSize(max_threads * sizeof(char) *
+                  StatsTable::kMaxThreadNameLength) +
+      AlignedSize(max_threads * sizeof(int)) +
+      AlignedSize(max_threads * sizeof(int)) +
+      AlignedSize(max_counters * sizeof(char) *
+                  StatsTable::kMaxCounterNameLength);
+  size += AlignOffsetToCacheLine(size);
+  return size + max_threads * ColumnLength(max_counters) * sizeof(int);
+}
+
 }  // namespace
 
 // The StatsTable::Private maintains convenience pointers into the
@@ -130,8 +168,8 @@ class StatsTable::Private {
     return &counter_names_table_[
       (counter_id-1) * (StatsTable::kMaxCounterNameLength)];
   }
-  int* row(int counter_id) const {
-    return &data_table_[(counter_id-1) * max_threads()];
+  int* column(int slot_id) const {
+    return &data_table_[(slot_id-1) * ColumnLength(max_counters())];
   }
 
  private:
@@ -234,8 +272,10 @@ void StatsTable::Private::ComputeMappedPointers(void* memory) {
             max_counters() * StatsTable::kMaxCounterNameLength;
   offset += AlignOffset(offset);
 
+  // The mapping starts on a page, so this aligns the columns to cache lines.
+  offset += AlignOffsetToCacheLine(offset);
   data_table_ = reinterpret_cast<int*>(data + offset);
-  offset += sizeof(int) * max_threads() * max_counters();
+  offset += sizeof(int) * max_threads() * ColumnLength(max_counters());
 
   DCHECK_EQ(offset, size());
 }
@@ -254,17 +294,22 @@ struct StatsTable::TLSData {
 // We keep a singleton table which can be easily accessed.
 StatsTable* StatsTable::global_table_ = NULL;
 
+subtle::Atomic32 StatsTable::last_generation_ = 0;
+
 StatsTable::StatsTable(const std::string& name, int max_threads,
                        int max_counters)
     : impl_(NULL),
+      generation_(0),
       tls_index_(SlotReturnFunction) {
+  // Generations wrap around, skipping 0, which is what an empty cache holds.
+  while (!generation_) {
+    generation_ =
+        subtle::NoBarrier_AtomicIncrement(&last_generation_, 1) &
+        kGenerationMask;
+  }
+
   int table_size =
-    AlignedSize(sizeof(Private::TableHeader)) +
-    AlignedSize((max_counters * sizeof(char) * kMaxCounterNameLength)) +
-    AlignedSize((max_threads * sizeof(char) * kMaxThreadNameLength)) +
-    AlignedSize(max_threads * sizeof(int)) +
-    AlignedSize(max_threads * sizeof(int)) +
-    AlignedSize((sizeof(int) * (max_counters * max_threads)));
+      TableSize(sizeof(Private::TableHeader), max_threads, max_counters);
 
   impl_ = Private::New(name, table_size, max_threads, max_counters);
 
@@ -370,14 +415,29 @@ int StatsTable::FindCounter(const std::string& name) {
   return AddCounter(name);
 }
 
+int StatsTable::GetCachedCounterId(const subtle::Atomic32* cache) const {
+  subtle::Atomic32 value = subtle::Acquire_Load(cache);
+  if ((value >> kCachedCounterIdBits) != generation_)
+    return 0;
+  return value & kCachedCounterIdMask;
+}
+
+void StatsTable::CacheCounterId(int counter_id,
+                                subtle::Atomic32* cache) const {
+  // Ids that don't fit are looked up every time.
+  if (counter_id <= 0 || counter_id > kCachedCounterIdMask)
+    return;
+  subtle::Release_Store(cache,
+                        (generation_ << kCachedCounterIdBits) | counter_id);
+}
+
 int* StatsTable::GetLocation(int counter_id, int slot_id) const {
   if (!impl_)
     return NULL;
   if (slot_id > impl_->max_threads())
     return NULL;
 
-  int* row = impl_->row(counter_id);
-  return &(row[slot_id-1]);
+  return &(impl_->column(slot_id)[counter_id-1]);
 }
 
 const char* StatsTable::GetRowName(int index) const {
@@ -396,10 +456,9 @@ int StatsTable::GetRowValue(int index, int pid) const {
     return 0;
 
   int rv = 0;
-  int* row = impl_->row(index);
-  for (int slot_id = 0; slot_id < impl_->max_threads(); slot_id++) {
+  for (int slot_id = 1; slot_id <= impl_->max_threads(); slot_id++) {
     if (pid == 0 || *impl_->thread_pid(slot_id) == pid)
-      rv += row[slot_id];
+      rv += impl_->column(slot_id)[index-1];
   }
   return rv;
 }
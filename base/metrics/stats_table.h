@@ -23,6 +23,7 @@
 
 #include <string>
 
+#include "base/atomicops.h"
 #include "base/base_api.h"
 #include "base/basictypes.h"
 #include "base/hash_tables.h"
@@ -89,6 +90,15 @@ class BASE_API StatsTable {
 
   // TODO(mbelshe): implement RemoveCounter.
 
+  // A counter id can be cached where the counter is used, so that it is only
+  // looked up by name once per table.  The cache is a statically allocated
+  // Atomic32 that starts out as zero.  Returns the counter id cached in
+  // |cache| by this table, or 0 if there is none.
+  int GetCachedCounterId(const subtle::Atomic32* cache) const;
+
+  // Caches |counter_id|, as returned by FindCounter(), in |cache|.
+  void CacheCounterId(int counter_id, subtle::Atomic32* cache) const;
+
   // Gets the location of a particular value in the table based on
   // the counter id and slot id.
   int* GetLocation(int counter_id, int slot_id) const;
@@ -175,6 +185,9 @@ class BASE_API StatsTable {
 
   Private* impl_;
 
+  // Tells the ids that this table cached from those of earlier tables.
+  int32 generation_;
+
   // The counters_lock_ protects the counters_ hash table.
   base::Lock counters_lock_;
 
@@ -188,6 +201,9 @@ class BASE_API StatsTable {
 
   static StatsTable* global_table_;
 
+  // The generation of the newest table.
+  static subtle::Atomic32 last_generation_;
+
   DISALLOW_COPY_AND_ASSIGN(StatsTable);
 };
 
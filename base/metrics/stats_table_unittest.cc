@@ -58,6 +58,30 @@ TEST_F(StatsTableTest, VerifySlots) {
   DeleteShmem(kTableName);
 }
 
+// Check that the counters of different threads are on different cache lines.
+TEST_F(StatsTableTest, ThreadsDoNotShareCacheLines) {
+  const std::string kTableName = "CacheLinesStatTable";
+  const int kMaxThreads = 3;
+  const int kMaxCounter = 3;
+  DeleteShmem(kTableName);
+  StatsTable table(kTableName, kMaxThreads, kMaxCounter);
+
+  for (int slot_id = 1; slot_id <= kMaxThreads; slot_id++) {
+    int* first = table.GetLocation(1, slot_id);
+    ASSERT_TRUE(first);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(first) % 64);
+    // A thread's own counters are next to each other.
+    EXPECT_EQ(first + 1, table.GetLocation(2, slot_id));
+    if (slot_id > 1) {
+      uintptr_t previous_last = reinterpret_cast<uintptr_t>(
+          table.GetLocation(kMaxCounter, slot_id - 1));
+      EXPECT_LT(previous_last / 64, reinterpret_cast<uintptr_t>(first) / 64);
+    }
+  }
+
+  DeleteShmem(kTableName);
+}
+
 // CounterZero will continually be set to 0.
 const std::string kCounterZero = "CounterZero";
 // Counter1313 will continually be set to 1313.
@@ -290,6 +314,36 @@ TEST_F(StatsTableTest, StatsCounter) {
   DeleteShmem(kTableName);
 }
 
+void CountWithMacro() {
+  SIMPLE_STATS_COUNTER("macro");
+}
+
+// Test that STATS_COUNTER looks the counter up again in a new table.
+TEST_F(StatsTableTest, StatsCounterMacro) {
+  const std::string kTableName = "MacroStatTable";
+  const int kMaxThreads = 20;
+  const int kMaxCounter = 5;
+  DeleteShmem(kTableName);
+  {
+    StatsTable table(kTableName, kMaxThreads, kMaxCounter);
+    StatsTable::set_current(&table);
+    // Take up a row, so that "c:macro" has a different id in the next table.
+    table.FindCounter("other");
+    for (int i = 0; i < 3; i++)
+      CountWithMacro();
+    EXPECT_EQ(3, table.GetCounterValue("c:macro"));
+  }
+  DeleteShmem(kTableName);
+
+  StatsTable table(kTableName, kMaxThreads, kMaxCounter);
+  StatsTable::set_current(&table);
+  CountWithMacro();
+  EXPECT_EQ(1, table.GetCounterValue("c:macro"));
+  EXPECT_EQ(0, table.GetCounterValue("other"));
+
+  DeleteShmem(kTableName);
+}
+
 class MockStatsCounterTimer : public StatsCounterTimer {
  public:
   explicit MockStatsCounterTimer(const std::string& name)
@@ -20,22 +20,21 @@ static const size_t kCapacityReadOnly = std::numeric_limits<size_t>::max();
 // Payload is uint32 aligned.
 
 Pickle::Pickle()
-    : header_(NULL),
+    : header_(reinterpret_cast<Header*>(&inline_buffer_)),
       header_size_(sizeof(Header)),
-      capacity_(0),
+      capacity_(kInlineCapacity),
       variable_buffer_offset_(0) {
-  Resize(kPayloadUnit);
   header_->payload_size = 0;
 }
 
 Pickle::Pickle(int header_size)
-    : header_(NULL),
+    : header_(reinterpret_cast<Header*>(&inline_buffer_)),
       header_size_(AlignInt(header_size, sizeof(uint32))),
-      capacity_(0),
+      capacity_(kInlineCapacity),
       variable_buffer_offset_(0) {
   DCHECK_GE(static_cast<size_t>(header_size), sizeof(Header));
   DCHECK(header_size <= kPayloadUnit);
-  Resize(kPayloadUnit);
+  COMPILE_ASSERT(kInlineCapacity % sizeof(uint32) == 0, inline_unaligned);
   header_->payload_size = 0;
 }
 
@@ -59,18 +58,19 @@ Pickle::Pickle(const char* data, int data_len)
 }
 
 Pickle::Pickle(const Pickle& other)
-    : header_(NULL),
+    : header_(reinterpret_cast<Header*>(&inline_buffer_)),
       header_size_(other.header_size_),
-      capacity_(0),
+      capacity_(kInlineCapacity),
       variable_buffer_offset_(other.variable_buffer_offset_) {
   size_t payload_size = header_size_ + other.header_->payload_size;
+  header_->payload_size = 0;
   bool resized = Resize(payload_size);
   CHECK(resized);  // Realloc failed.
   memcpy(header_, other.header_, payload_size);
 }
 
 Pickle::~Pickle() {
-  if (capacity_ != kCapacityReadOnly)
+  if (capacity_ != kCapacityReadOnly && !is_inline())
     free(header_);
 }
 
@@ -79,13 +79,12 @@ Pickle& Pickle::operator=(const Pickle& other) {
     NOTREACHED();
     return *this;
   }
-  if (capacity_ == kCapacityReadOnly) {
-    header_ = NULL;
-    capacity_ = 0;
-  }
-  if (header_size_ != other.header_size_) {
-    free(header_);
-    header_ = NULL;
+  if (capacity_ == kCapacityReadOnly || header_size_ != other.header_size_) {
+    if (capacity_ != kCapacityReadOnly && !is_inline())
+      free(header_);
+    header_ = reinterpret_cast<Header*>(&inline_buffer_);
+    header_->payload_size = 0;
+    capacity_ = kInlineCapacity;
     header_size_ = other.header_size_;
   }
   bool resized = Resize(other.header_size_ + other.header_->payload_size);
@@ -401,10 +400,21 @@ void Pickle::EndWrite(char* dest, int length) {
 }
 
 bool Pickle::Resize(size_t new_capacity) {
+  CHECK_NE(capacity_, kCapacityReadOnly);
+  if (is_inline() && new_capacity <= capacity_)
+    return true;
+
   new_capacity = AlignInt(new_capacity, kPayloadUnit);
 
-  CHECK_NE(capacity_, kCapacityReadOnly);
-  void* p = realloc(header_, new_capacity);
+  void* p;
+  if (is_inline()) {
+    // Leaving the inline buffer: copy what has been written so far.
+    p = malloc(new_capacity);
+    if (p)
+      memcpy(p, header_, header_size_ + header_->payload_size);
+  } else {
+    p = realloc(header_, new_capacity);
+  }
   if (!p)
     return false;
 
@@ -413,6 +423,20 @@ bool Pickle::Resize(size_t new_capacity) {
   return true;
 }
 
+PickleReader::PickleReader(const Pickle& pickle)
+    : pickle_(static_cast<const char*>(pickle.data()),
+              static_cast<int>(pickle.size())),
+      iter_(NULL) {
+}
+
+PickleReader::PickleReader(const char* data, int data_len)
+    : pickle_(data, data_len),
+      iter_(NULL) {
+}
+
+PickleReader::~PickleReader() {
+}
+
 // static
 const char* Pickle::FindNext(size_t header_size,
                              const char* start,
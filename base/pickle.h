@@ -31,6 +31,9 @@
 // space is controlled by the header_size parameter passed to the Pickle
 // constructor.
 //
+// A Pickle keeps up to kInlineCapacity bytes of header and payload inside the
+// object itself, so that small pickles don't allocate.
+//
 class BASE_API Pickle {
  public:
   // Initialize a Pickle object using the default header size.
@@ -138,6 +141,9 @@ class BASE_API Pickle {
   // not been changed.
   void TrimWriteData(int length);
 
+  // The number of bytes of header and payload stored without allocating.
+  enum { kInlineCapacity = 64 };
+
   // Payload follows after allocation of Header (header size is customizable).
   struct Header {
     uint32 payload_size;  // Specifies the size of the payload.
@@ -210,6 +216,11 @@ class BASE_API Pickle {
   // the return result for true (i.e., successful resizing).
   bool Resize(size_t new_capacity);
 
+  // Returns true if the data is in |inline_buffer_|.
+  bool is_inline() const {
+    return header_ == reinterpret_cast<const Header*>(&inline_buffer_);
+  }
+
   // Aligns 'i' by rounding it up to the next multiple of 'alignment'
   static size_t AlignInt(size_t i, int alignment) {
     return i + (alignment - (i % alignment)) % alignment;
@@ -238,10 +249,83 @@ class BASE_API Pickle {
   size_t capacity_;
   size_t variable_buffer_offset_;  // IF non-zero, then offset to a buffer.
 
+  // Holds the data while it fits; the union keeps it aligned for Header.
+  union {
+    uint64 alignment;
+    char bytes[kInlineCapacity];
+  } inline_buffer_;
+
   FRIEND_TEST_ALL_PREFIXES(PickleTest, Resize);
   FRIEND_TEST_ALL_PREFIXES(PickleTest, FindNext);
   FRIEND_TEST_ALL_PREFIXES(PickleTest, FindNextWithIncompleteHeader);
   FRIEND_TEST_ALL_PREFIXES(PickleTest, IteratorHasRoom);
+  FRIEND_TEST_ALL_PREFIXES(PickleTest, InlineBuffer);
+};
+
+// PickleReader reads the values of a Pickle in order, keeping its own
+// position, without copying the pickled data.  The data must outlive the
+// reader and must not be written to while it is being read.
+//
+//   PickleReader reader(data, data_len);
+//   int version;
+//   std::string name;
+//   if (!reader.ReadInt(&version) || !reader.ReadString(&name))
+//     return false;
+class BASE_API PickleReader {
+ public:
+  // Reads |pickle|, from the start of its payload.
+  explicit PickleReader(const Pickle& pickle);
+
+  // Reads the pickle in |data|, e.g. a buffer received from disk or from
+  // another process.  Invalid data makes every read fail.
+  PickleReader(const char* data, int data_len);
+
+  ~PickleReader();
+
+  // The same as the Pickle methods of the same names.
+  bool ReadBool(bool* result) { return pickle_.ReadBool(&iter_, result); }
+  bool ReadInt(int* result) { return pickle_.ReadInt(&iter_, result); }
+  bool ReadLong(long* result) { return pickle_.ReadLong(&iter_, result); }
+  bool ReadSize(size_t* result) { return pickle_.ReadSize(&iter_, result); }
+  bool ReadUInt16(uint16* result) {
+    return pickle_.ReadUInt16(&iter_, result);
+  }
+  bool ReadUInt32(uint32* result) {
+    return pickle_.ReadUInt32(&iter_, result);
+  }
+  bool ReadInt64(int64* result) { return pickle_.ReadInt64(&iter_, result); }
+  bool ReadUInt64(uint64* result) {
+    return pickle_.ReadUInt64(&iter_, result);
+  }
+  bool ReadString(std::string* result) {
+    return pickle_.ReadString(&iter_, result);
+  }
+  bool ReadWString(std::wstring* result) {
+    return pickle_.ReadWString(&iter_, result);
+  }
+  bool ReadString16(string16* result) {
+    return pickle_.ReadString16(&iter_, result);
+  }
+  // |data| points into the pickled data.
+  bool ReadData(const char** data, int* length) {
+    return pickle_.ReadData(&iter_, data, length);
+  }
+  bool ReadBytes(const char** data, int length) {
+    return pickle_.ReadBytes(&iter_, data, length);
+  }
+  bool ReadLength(int* result) { return pickle_.ReadLength(&iter_, result); }
+
+  // For the code that still takes a Pickle and an iterator, e.g. to read a
+  // FilePath or an X509Certificate.
+  const Pickle& pickle() const { return pickle_; }
+  void** iter() { return &iter_; }
+
+ private:
+  // A read-only Pickle over the data.
+  const Pickle pickle_;
+  void* iter_;
+
+  DISALLOW_COPY_AND_ASSIGN(PickleReader);
 };
 
 #endif  // BASE_PICKLE_H__
@@ -323,3 +323,79 @@ TEST(PickleTest, ReadBytes) {
   memcpy(&outdata, outdata_char, sizeof(outdata));
   EXPECT_EQ(data, outdata);
 }
+
+// Check that small pickles stay in the object, and that copies move between
+// the inline buffer and the heap.
+TEST(PickleTest, InlineBuffer) {
+  Pickle small;
+  small.WriteInt(testint);
+  small.WriteString(teststr);
+  EXPECT_EQ(static_cast<size_t>(Pickle::kInlineCapacity), small.capacity());
+  EXPECT_TRUE(small.data() >= static_cast<const void*>(&small) &&
+              small.data() < static_cast<const void*>(&small + 1));
+
+  Pickle big;
+  std::string str(Pickle::kInlineCapacity * 2, 'A');
+  big.WriteString(str);
+  EXPECT_GT(big.capacity(), static_cast<size_t>(Pickle::kInlineCapacity));
+
+  Pickle copy(small);
+  EXPECT_EQ(small.capacity(), copy.capacity());
+  copy = big;
+  ASSERT_EQ(big.size(), copy.size());
+  copy = small;
+  ASSERT_EQ(small.size(), copy.size());
+
+  void* iter = NULL;
+  int outint;
+  std::string outstr;
+  EXPECT_TRUE(copy.ReadInt(&iter, &outint));
+  EXPECT_EQ(testint, outint);
+  EXPECT_TRUE(copy.ReadString(&iter, &outstr));
+  EXPECT_EQ(teststr, outstr);
+
+  // Growing an inline pickle keeps what was written.
+  copy.WriteString(str);
+  iter = NULL;
+  EXPECT_TRUE(copy.ReadInt(&iter, &outint));
+  EXPECT_EQ(testint, outint);
+  EXPECT_TRUE(copy.ReadString(&iter, &outstr));
+  EXPECT_EQ(teststr, outstr);
+  EXPECT_TRUE(copy.ReadString(&iter, &outstr));
+  EXPECT_EQ(str, outstr);
+}
+
+TEST(PickleTest, Reader) {
+  Pickle pickle;
+  pickle.WriteInt(testint);
+  pickle.WriteString(teststr);
+  pickle.WriteData(testdata, testdatalen);
+
+  PickleReader reader(static_cast<const char*>(pickle.data()),
+                      static_cast<int>(pickle.size()));
+  int outint;
+  EXPECT_TRUE(reader.ReadInt(&outint));
+  EXPECT_EQ(testint, outint);
+  std::string outstr;
+  EXPECT_TRUE(reader.ReadString(&outstr));
+  EXPECT_EQ(teststr, outstr);
+
+  // The data is read in place.
+  const char* outdata;
+  int outdatalen;
+  EXPECT_TRUE(reader.ReadData(&outdata, &outdatalen));
+  EXPECT_EQ(testdatalen, outdatalen);
+  EXPECT_TRUE(outdata > pickle.data() &&
+              outdata < static_cast<const char*>(pickle.data()) +
+                  pickle.size());
+
+  EXPECT_FALSE(reader.ReadInt(&outint));
+
+  PickleReader from_pickle(pickle);
+  EXPECT_TRUE(from_pickle.ReadInt(&outint));
+  EXPECT_EQ(testint, outint);
+
+  // Invalid data fails to read.
+  PickleReader truncated(static_cast<const char*>(pickle.data()), 2);
+  EXPECT_FALSE(truncated.ReadInt(&outint));
+}
@@ -10,8 +10,7 @@
 
 namespace base {
 
-// Implementation of SHA-1. Only handles data in byte-sized blocks,
-// which simplifies the code a fair bit.
+// Implementation of SHA-1.
 
 // Identifier names follow notation in FIPS PUB 180-3, where you'll
 // also find a description of the algorithm:
@@ -42,72 +41,48 @@ class SecureHashAlgorithm {
   void Final();
 
   // 20 bytes of message digest.
-  const unsigned char* Digest() const {
-    return reinterpret_cast<const unsigned char*>(H);
-  }
+  const unsigned char* Digest() const { return digest_; }
 
  private:
-  void Pad();
-  void Process();
-
-  uint32 A, B, C, D, E;
+  // Hashes the 64 bytes at |block| into H.  Whole blocks of the input are
+  // hashed where they are, and only the ends are copied to M.
+  void ProcessBlock(const uint8* block);
 
   uint32 H[5];
 
-  union {
-    uint32 W[80];
-    uint8 M[64];
-  };
-
+  // The bytes of the current block, of which |cursor| are filled.
+  uint8 M[64];
   uint32 cursor;
-  uint32 l;
-};
 
-static inline uint32 f(uint32 t, uint32 B, uint32 C, uint32 D) {
-  if (t < 20) {
-    return (B & C) | ((~B) & D);
-  } else if (t < 40) {
-    return B ^ C ^ D;
-  } else if (t < 60) {
-    return (B & C) | (B & D) | (C & D);
-  } else {
-    return B ^ C ^ D;
-  }
-}
+  // The length of the message in bytes.
+  uint64 length;
+
+  uint8 digest_[20];
+};
 
 static inline uint32 S(uint32 n, uint32 X) {
   return (X << n) | (X >> (32-n));
 }
 
-static inline uint32 K(uint32 t) {
-  if (t < 20) {
-    return 0x5a827999;
-  } else if (t < 40) {
-    return 0x6ed9eba1;
-  } else if (t < 60) {
-    return 0x8f1bbcdc;
-  } else {
-    return 0xca62c1d6;
-  }
+static inline uint32 LoadBigEndian(const uint8* p) {
+  return (static_cast<uint32>(p[0]) << 24) |
+         (static_cast<uint32>(p[1]) << 16) |
+         (static_cast<uint32>(p[2]) << 8) |
+         static_cast<uint32>(p[3]);
 }
 
-static inline void swapends(uint32* t) {
-  *t = ((*t & 0xff000000) >> 24) |
-       ((*t & 0xff0000) >> 8) |
-       ((*t & 0xff00) << 8) |
-       ((*t & 0xff) << 24);
+static inline void StoreBigEndian(uint32 value, uint8* p) {
+  p[0] = static_cast<uint8>(value >> 24);
+  p[1] = static_cast<uint8>(value >> 16);
+  p[2] = static_cast<uint8>(value >> 8);
+  p[3] = static_cast<uint8>(value);
 }
 
 const int SecureHashAlgorithm::kDigestSizeBytes = 20;
 
 void SecureHashAlgorithm::Init() {
-  A = 0;
-  B = 0;
-  C = 0;
-  D = 0;
-  E = 0;
   cursor = 0;
-  l = 0;
+  length = 0;
   H[0] = 0x67452301;
   H[1] = 0xefcdab89;
   H[2] = 0x98badcfe;
@@ -116,86 +91,131 @@ void SecureHashAlgorithm::Init() {
 }
 
 void SecureHashAlgorithm::Final() {
-  Pad();
-  Process();
+  uint64 bits = length * 8;
+
+  // Pad with 0x80, then zeros up to the last 8 bytes of a block, which hold
+  // the length in bits.
+  M[cursor++] = 0x80;
+  if (cursor > 64 - 8) {
+    memset(M + cursor, 0, 64 - cursor);
+    ProcessBlock(M);
+    cursor = 0;
+  }
+  memset(M + cursor, 0, 64 - 8 - cursor);
+  StoreBigEndian(static_cast<uint32>(bits >> 32), M + 64 - 8);
+  StoreBigEndian(static_cast<uint32>(bits), M + 64 - 4);
+  ProcessBlock(M);
+  cursor = 0;
 
   for (int t = 0; t < 5; ++t)
-    swapends(&H[t]);
+    StoreBigEndian(H[t], digest_ + t * 4);
 }
 
 void SecureHashAlgorithm::Update(const void* data, size_t nbytes) {
   const uint8* d = reinterpret_cast<const uint8*>(data);
-  while (nbytes--) {
-    M[cursor++] = *d++;
-    if (cursor >= 64)
-      Process();
-    l += 8;
-  }
-}
-
-void SecureHashAlgorithm::Pad() {
-  M[cursor++] = 0x80;
-
-  if (cursor > 64-8) {
-    // pad out to next block
-    while (cursor < 64)
-      M[cursor++] = 0;
-
-    Process();
+  length += nbytes;
+
+  if (cursor) {
+    size_t needed = 64 - cursor;
+    if (nbytes < needed) {
+      memcpy(M + cursor, d, nbytes);
+      cursor += static_cast<uint32>(nbytes);
+      return;
+    }
+    memcpy(M + cursor, d, needed);
+    ProcessBlock(M);
+    cursor = 0;
+    d += needed;
+    nbytes -= needed;
   }
 
-  while (cursor < 64-4)
-    M[cursor++] = 0;
+  for (; nbytes >= 64; d += 64, nbytes -= 64)
+    ProcessBlock(d);
 
-  M[64-4] = (l & 0xff000000) >> 24;
-  M[64-3] = (l & 0xff0000) >> 16;
-  M[64-2] = (l & 0xff00) >> 8;
-  M[64-1] = (l & 0xff);
+  memcpy(M, d, nbytes);
+  cursor = static_cast<uint32>(nbytes);
 }
 
-void SecureHashAlgorithm::Process() {
-  uint32 t;
-
-  // Each a...e corresponds to a section in the FIPS 180-3 algorithm.
-
-  // a.
-  //
-  // W and M are in a union, so no need to memcpy.
-  // memcpy(W, M, sizeof(M));
-  for (t = 0; t < 16; ++t)
-    swapends(&W[t]);
-
-  // b.
-  for (t = 16; t < 80; ++t)
-    W[t] = S(1, W[t - 3] ^ W[t - 8] ^ W[t - 14] ^ W[t - 16]);
-
-  // c.
-  A = H[0];
-  B = H[1];
-  C = H[2];
-  D = H[3];
-  E = H[4];
-
-  // d.
-  for (t = 0; t < 80; ++t) {
-    uint32 TEMP = S(5, A) + f(t, B, C, D) + E + W[t] + K(t);
-    E = D;
-    D = C;
-    C = S(30, B);
-    B = A;
-    A = TEMP;
+// One step of each of the four rounds of 20 steps, with the function and
+// constant of that round.  Rather than moving each of a...e down a variable
+// after a step, the steps name them in turn.  W is kept as the last 16 words
+// of the schedule.
+#define SHA1_W(t) W[(t) & 15]
+#define SHA1_SCHEDULE(t) \
+    (SHA1_W(t) = S(1, SHA1_W((t) - 3) ^ SHA1_W((t) - 8) ^ \
+                      SHA1_W((t) - 14) ^ SHA1_W(t)))
+#define SHA1_STEP(f, k, w, a, b, c, d, e) \
+    do { \
+      e += S(5, a) + f(b, c, d) + (w) + (k); \
+      b = S(30, b); \
+    } while (0)
+#define SHA1_F0(b, c, d) ((d) ^ ((b) & ((c) ^ (d))))
+#define SHA1_F1(b, c, d) ((b) ^ (c) ^ (d))
+#define SHA1_F2(b, c, d) (((b) & (c)) | ((d) & ((b) | (c))))
+#define SHA1_F3(b, c, d) ((b) ^ (c) ^ (d))
+
+void SecureHashAlgorithm::ProcessBlock(const uint8* block) {
+  uint32 W[16];
+  for (int t = 0; t < 16; ++t)
+    W[t] = LoadBigEndian(block + t * 4);
+
+  uint32 A = H[0];
+  uint32 B = H[1];
+  uint32 C = H[2];
+  uint32 D = H[3];
+  uint32 E = H[4];
+
+  // Five steps at a time, after which a...e are back in their places.
+  int t = 0;
+  for (; t < 15; t += 5) {
+    SHA1_STEP(SHA1_F0, 0x5a827999, W[t], A, B, C, D, E);
+    SHA1_STEP(SHA1_F0, 0x5a827999, W[t + 1], E, A, B, C, D);
+    SHA1_STEP(SHA1_F0, 0x5a827999, W[t + 2], D, E, A, B, C);
+    SHA1_STEP(SHA1_F0, 0x5a827999, W[t + 3], C, D, E, A, B);
+    SHA1_STEP(SHA1_F0, 0x5a827999, W[t + 4], B, C, D, E, A);
+  }
+  SHA1_STEP(SHA1_F0, 0x5a827999, W[15], A, B, C, D, E);
+  SHA1_STEP(SHA1_F0, 0x5a827999, SHA1_SCHEDULE(16), E, A, B, C, D);
+  SHA1_STEP(SHA1_F0, 0x5a827999, SHA1_SCHEDULE(17), D, E, A, B, C);
+  SHA1_STEP(SHA1_F0, 0x5a827999, SHA1_SCHEDULE(18), C, D, E, A, B);
+  SHA1_STEP(SHA1_F0, 0x5a827999, SHA1_SCHEDULE(19), B, C, D, E, A);
+  for (t = 20; t < 40; t += 5) {
+    SHA1_STEP(SHA1_F1, 0x6ed9eba1, SHA1_SCHEDULE(t), A, B, C, D, E);
+    SHA1_STEP(SHA1_F1, 0x6ed9eba1, SHA1_SCHEDULE(t + 1), E, A, B, C, D);
+    SHA1_STEP(SHA1_F1, 0x6ed9eba1, SHA1_SCHEDULE(t + 2), D, E, A, B, C);
+    SHA1_STEP(SHA1_F1, 0x6ed9eba1, SHA1_SCHEDULE(t + 3), C, D, E, A, B);
+    SHA1_STEP(SHA1_F1, 0x6ed9eba1, SHA1_SCHEDULE(t + 4), B, C, D, E, A);
+  }
+  for (; t < 60; t += 5) {
+    SHA1_STEP(SHA1_F2, 0x8f1bbcdc, SHA1_SCHEDULE(t), A, B, C, D, E);
+    SHA1_STEP(SHA1_F2, 0x8f1bbcdc, SHA1_SCHEDULE(t + 1), E, A, B, C, D);
+    SHA1_STEP(SHA1_F2, 0x8f1bbcdc, SHA1_SCHEDULE(t + 2), D, E, A, B, C);
+    SHA1_STEP(SHA1_F2, 0x8f1bbcdc, SHA1_SCHEDULE(t + 3), C, D, E, A, B);
+    SHA1_STEP(SHA1_F2, 0x8f1bbcdc, SHA1_SCHEDULE(t + 4), B, C, D, E, A);
+  }
+  for (; t < 80; t += 5) {
+    SHA1_STEP(SHA1_F3, 0xca62c1d6, SHA1_SCHEDULE(t), A, B, C, D, E);
+    SHA1_STEP(SHA1_F3, 0xca62c1d6, SHA1_SCHEDULE(t + 1), E, A, B, C, D);
+    SHA1_STEP(SHA1_F3, 0xca62c1d6, SHA1_SCHEDULE(t + 2), D, E, A, B, C);
+    SHA1_STEP(SHA1_F3, 0xca62c1d6, SHA1_SCHEDULE(t + 3), C, D, E, A, B);
+    SHA1_STEP(SHA1_F3, 0xca62c1d6, SHA1_SCHEDULE(t + 4), B, C, D, E, A);
   }
 
-  // e.
   H[0] += A;
   H[1] += B;
   H[2] += C;
   H[3] += D;
   H[4] += E;
-
-  cursor = 0;
 }
 
+#undef SHA1_W
+#undef SHA1_SCHEDULE
+#undef SHA1_STEP
+#undef SHA1_F0
+#undef SHA1_F1
+#undef SHA1_F2
+#undef SHA1_F3
+
 std::string SHA1HashString(const std::string& str) {
   char hash[SecureHashAlgorithm::kDigestSizeBytes];
   SHA1HashBytes(reinterpret_cast<const unsigned char*>(str.c_str()),
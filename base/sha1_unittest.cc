@@ -7,6 +7,7 @@
 #include <string>
 
 #include "base/basictypes.h"
+#include "base/string_number_conversions.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 TEST(SHA1Test, Test1) {
@@ -106,3 +107,29 @@ TEST(SHA1Test, Test3Bytes) {
   for (size_t i = 0; i < base::SHA1_LENGTH; i++)
     EXPECT_EQ(expected[i], output[i]);
 }
+
+TEST(SHA1Test, PaddingBoundaries) {
+  // Messages that end around the 56 bytes after which the length no longer
+  // fits in the last block.
+  const struct {
+    size_t length;
+    const char* expected;
+  } kCases[] = {
+    { 0, "DA39A3EE5E6B4B0D3255BFEF95601890AFD80709" },
+    { 55, "CEF734BA81A024479E09EB5A75B6DDAE62E6ABF1" },
+    { 56, "901305367C259952F4E7AF8323F480D59F81335B" },
+    { 63, "0DDC4E0CCCD9A12850DEB5ABB0853A4425559FEC" },
+    { 64, "BB2FA3EE7AFB9F54C6DFB5D021F14B1FFE40C163" },
+    { 65, "78C741DDC482E4CDF8C474A0876347A0905B6233" },
+    { 119, "4300320394F7EE239BCDCE7D3B8BCEE173A0CD5C" },
+    { 120, "CEB2821639C4B6DCB10BCE0E522CA2E608CE056D" },
+    { 128, "150FA3FBDC899BD0B8F95A9FB6027F564D953762" },
+  };
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(kCases); ++i) {
+    std::string output = base::SHA1HashString(std::string(kCases[i].length,
+                                                          'x'));
+    EXPECT_EQ(kCases[i].expected,
+              base::HexEncode(output.data(), output.size()))
+        << kCases[i].length;
+  }
+}
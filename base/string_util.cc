@@ -63,6 +63,75 @@ static bool CompareParameter(const ReplacementOffset& elem1,
   return elem1.parameter < elem2.parameter;
 }
 
+// The ASCII checks and case folding below work a machine word at a time
+// rather than a character at a time.  Words are loaded with memcpy, which
+// compiles to a plain load and is safe whatever the alignment.
+typedef uintptr_t MachineWord;
+
+inline MachineWord LoadMachineWord(const void* p) {
+  MachineWord word;
+  memcpy(&word, p, sizeof(word));
+  return word;
+}
+
+inline void StoreMachineWord(void* p, MachineWord word) {
+  memcpy(p, &word, sizeof(word));
+}
+
+// The bits that are set in a word of characters if any of them is not ASCII,
+// for characters of |Size| bytes.  The constants are truncated on 32-bit
+// platforms, which leaves the same pattern.
+template<size_t Size> struct NonASCIIMask;
+template<> struct NonASCIIMask<1> {
+  static MachineWord value() {
+    return static_cast<MachineWord>(GG_UINT64_C(0x8080808080808080));
+  }
+};
+template<> struct NonASCIIMask<2> {
+  static MachineWord value() {
+    return static_cast<MachineWord>(GG_UINT64_C(0xFF80FF80FF80FF80));
+  }
+};
+template<> struct NonASCIIMask<4> {
+  static MachineWord value() {
+    return static_cast<MachineWord>(GG_UINT64_C(0xFFFFFF80FFFFFF80));
+  }
+};
+
+// Returns a word with |byte| in each of its bytes.
+inline MachineWord RepeatByte(uint8 byte) {
+  return (~static_cast<MachineWord>(0) / 0xFF) * byte;
+}
+
+// Returns |word| with the bytes 'A' to 'Z' lowered, as base::ToLowerASCII()
+// does for each byte.  Per byte, the two additions set the top bit when the
+// low seven bits are above 'Z' and at least 'A' respectively, without
+// carrying into the next byte; bytes with the top bit set are left alone.
+inline MachineWord ToLowerASCIIWord(MachineWord word) {
+  const MachineWord high_bits = RepeatByte(0x80);
+  MachineWord heptets = word & ~high_bits;
+  MachineWord above_z = heptets + RepeatByte(0x7F - 'Z');
+  MachineWord at_least_a = heptets + RepeatByte(0x80 - 'A');
+  MachineWord upper = ~word & (at_least_a ^ above_z) & high_bits;
+  return word | (upper >> 2);
+}
+
+// Compares the |length| bytes at |a|, lowered, with the NUL-terminated |b|.
+bool LowerCaseEqualsASCIIBytes(const char* a, size_t length, const char* b) {
+  if (strlen(b) != length)
+    return false;
+  size_t i = 0;
+  for (; length - i >= sizeof(MachineWord); i += sizeof(MachineWord)) {
+    if (ToLowerASCIIWord(LoadMachineWord(a + i)) != LoadMachineWord(b + i))
+      return false;
+  }
+  for (; i < length; ++i) {
+    if (base::ToLowerASCII(a[i]) != b[i])
+      return false;
+  }
+  return true;
+}
+
 }  // namespace
 
 namespace base {
@@ -445,14 +514,33 @@ bool WideToLatin1(const std::wstring& wide, std::string* latin1) {
   return true;
 }
 
+// The characters are ORed together so that the loop has no branch but its
+// own; a word at a time once |chars| is aligned to one.
+template<typename Char>
+static bool DoIsStringASCII(const Char* chars, size_t length) {
+  typedef typename ToUnsigned<Char>::Unsigned UnsignedChar;
+  const Char* end = chars + length;
+  MachineWord all_char_bits = 0;
+  while (chars != end &&
+         reinterpret_cast<uintptr_t>(chars) % sizeof(MachineWord) != 0) {
+    all_char_bits |= static_cast<UnsignedChar>(*chars);
+    ++chars;
+  }
+  const size_t chars_per_word = sizeof(MachineWord) / sizeof(Char);
+  while (static_cast<size_t>(end - chars) >= chars_per_word) {
+    all_char_bits |= LoadMachineWord(chars);
+    chars += chars_per_word;
+  }
+  while (chars != end) {
+    all_char_bits |= static_cast<UnsignedChar>(*chars);
+    ++chars;
+  }
+  return !(all_char_bits & NonASCIIMask<sizeof(Char)>::value());
+}
+
 template<class STR>
 static bool DoIsStringASCII(const STR& str) {
-  for (size_t i = 0; i < str.length(); i++) {
-    typename ToUnsigned<typename STR::value_type>::Unsigned c = str[i];
-    if (c > 0x7F)
-      return false;
-  }
-  return true;
+  return DoIsStringASCII(str.data(), str.length());
 }
 
 bool IsStringASCII(const std::wstring& str) {
@@ -474,7 +562,15 @@ bool IsStringUTF8(const std::string& str) {
   int32 src_len = static_cast<int32>(str.length());
   int32 char_index = 0;
 
+  const MachineWord non_ascii_mask = NonASCIIMask<1>::value();
+
   while (char_index < src_len) {
+    // Every ASCII character is valid, so skip a word of them at a time.
+    if (src_len - char_index >= static_cast<int32>(sizeof(MachineWord)) &&
+        !(LoadMachineWord(src + char_index) & non_ascii_mask)) {
+      char_index += sizeof(MachineWord);
+      continue;
+    }
     int32 code_point;
     CBU8_NEXT(src, char_index, src_len, code_point);
     if (!base::IsValidCharacter(code_point))
@@ -483,6 +579,18 @@ bool IsStringUTF8(const std::string& str) {
   return true;
 }
 
+void StringToLowerASCII(std::string* s) {
+  if (s->empty())
+    return;
+  char* chars = &(*s)[0];
+  size_t length = s->length();
+  size_t i = 0;
+  for (; length - i >= sizeof(MachineWord); i += sizeof(MachineWord))
+    StoreMachineWord(chars + i, ToLowerASCIIWord(LoadMachineWord(chars + i)));
+  for (; i < length; ++i)
+    chars[i] = base::ToLowerASCII(chars[i]);
+}
+
 template<typename Iter>
 static inline bool DoLowerCaseEqualsASCII(Iter a_begin,
                                           Iter a_end,
@@ -496,7 +604,7 @@ static inline bool DoLowerCaseEqualsASCII(Iter a_begin,
 
 // Front-ends for LowerCaseEqualsASCII.
 bool LowerCaseEqualsASCII(const std::string& a, const char* b) {
-  return DoLowerCaseEqualsASCII(a.begin(), a.end(), b);
+  return LowerCaseEqualsASCIIBytes(a.data(), a.length(), b);
 }
 
 bool LowerCaseEqualsASCII(const std::wstring& a, const char* b) {
@@ -512,7 +620,9 @@ bool LowerCaseEqualsASCII(const string16& a, const char* b) {
 bool LowerCaseEqualsASCII(std::string::const_iterator a_begin,
                           std::string::const_iterator a_end,
                           const char* b) {
-  return DoLowerCaseEqualsASCII(a_begin, a_end, b);
+  if (a_begin == a_end)
+    return *b == 0;
+  return LowerCaseEqualsASCIIBytes(&*a_begin, a_end - a_begin, b);
 }
 
 bool LowerCaseEqualsASCII(std::wstring::const_iterator a_begin,
@@ -533,7 +643,7 @@ bool LowerCaseEqualsASCII(string16::const_iterator a_begin,
 bool LowerCaseEqualsASCII(const char* a_begin,
                           const char* a_end,
                           const char* b) {
-  return DoLowerCaseEqualsASCII(a_begin, a_end, b);
+  return LowerCaseEqualsASCIIBytes(a_begin, a_end - a_begin, b);
 }
 #endif // !ANDROID
 
@@ -293,7 +293,10 @@ BASE_API bool IsStringASCII(const base::StringPiece& str);
 BASE_API bool IsStringASCII(const string16& str);
 
 // Converts the elements of the given string.  This version uses a pointer to
-// clearly differentiate it from the non-pointer variant.
+// clearly differentiate it from the non-pointer variant.  The std::string
+// overload works on a word of characters at a time.
+BASE_API void StringToLowerASCII(std::string* s);
+
 template <class str> inline void StringToLowerASCII(str* s) {
   for (typename str::iterator i = s->begin(); i != s->end(); ++i)
     *i = base::ToLowerASCII(*i);
@@ -0,0 +1,110 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Measures the ASCII and UTF-8 checks and the ASCII case folding of
+// string_util, on strings about the size of header values and of small
+// documents.
+
+#include <string>
+
+#include "base/perftimer.h"
+#include "base/string_util.h"
+#include "base/stringprintf.h"
+#include "base/utf_string_conversions.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const size_t kLengths[] = { 16, 256, 64 * 1024 };
+
+// How many bytes each measurement goes over, whatever the string length.
+const size_t kBytesPerMeasurement = 64 * 1024 * 1024;
+
+// Returns printable ASCII of |length| with a mix of cases.
+std::string MakeASCII(size_t length) {
+  std::string result;
+  result.reserve(length);
+  for (size_t i = 0; i < length; ++i)
+    result.push_back(static_cast<char>(' ' + (i * 7) % 95));
+  return result;
+}
+
+// Logs how fast |bytes| were handled in |elapsed|.
+void LogRate(const char* name, size_t length, size_t bytes,
+             base::TimeDelta elapsed) {
+  LogPerfResult(base::StringPrintf("%s_%d", name,
+                                   static_cast<int>(length)).c_str(),
+                bytes / 1048576.0 / elapsed.InSecondsF(), "MB/s");
+}
+
+TEST(StringUtilPerfTest, IsStringASCII) {
+  for (size_t i = 0; i < arraysize(kLengths); ++i) {
+    const std::string ascii = MakeASCII(kLengths[i]);
+    const string16 ascii16 = ASCIIToUTF16(ascii);
+    const size_t iterations = kBytesPerMeasurement / ascii.length();
+
+    PerfTimer timer;
+    for (size_t j = 0; j < iterations; ++j)
+      EXPECT_TRUE(IsStringASCII(ascii));
+    LogRate("IsStringASCII", ascii.length(), iterations * ascii.length(),
+            timer.Elapsed());
+
+    PerfTimer timer16;
+    for (size_t j = 0; j < iterations; ++j)
+      EXPECT_TRUE(IsStringASCII(ascii16));
+    LogRate("IsStringASCII16", ascii.length(), iterations * ascii.length(),
+            timer16.Elapsed());
+  }
+}
+
+TEST(StringUtilPerfTest, IsStringUTF8) {
+  for (size_t i = 0; i < arraysize(kLengths); ++i) {
+    const std::string ascii = MakeASCII(kLengths[i]);
+    const size_t iterations = kBytesPerMeasurement / ascii.length();
+
+    PerfTimer timer;
+    for (size_t j = 0; j < iterations; ++j)
+      EXPECT_TRUE(IsStringUTF8(ascii));
+    LogRate("IsStringUTF8_ascii", ascii.length(), iterations * ascii.length(),
+            timer.Elapsed());
+
+    // Two-byte characters every so often, as in most European text.
+    std::string text(ascii);
+    for (size_t j = 0; j + 2 <= text.length(); j += 16) {
+      text[j] = '\xC3';
+      text[j + 1] = '\xA9';
+    }
+    PerfTimer text_timer;
+    for (size_t j = 0; j < iterations; ++j)
+      EXPECT_TRUE(IsStringUTF8(text));
+    LogRate("IsStringUTF8_text", text.length(), iterations * text.length(),
+            text_timer.Elapsed());
+  }
+}
+
+TEST(StringUtilPerfTest, CaseFolding) {
+  for (size_t i = 0; i < arraysize(kLengths); ++i) {
+    const std::string mixed = MakeASCII(kLengths[i]);
+    const std::string lower = StringToLowerASCII(mixed);
+    const size_t iterations = kBytesPerMeasurement / mixed.length();
+
+    PerfTimer timer;
+    for (size_t j = 0; j < iterations; ++j)
+      EXPECT_TRUE(LowerCaseEqualsASCII(mixed, lower.c_str()));
+    LogRate("LowerCaseEqualsASCII", mixed.length(),
+            iterations * mixed.length(), timer.Elapsed());
+
+    std::string lowered;
+    PerfTimer lower_timer;
+    for (size_t j = 0; j < iterations; ++j) {
+      lowered = mixed;
+      StringToLowerASCII(&lowered);
+    }
+    EXPECT_EQ(lower, lowered);
+    LogRate("StringToLowerASCII", mixed.length(), iterations * mixed.length(),
+            lower_timer.Elapsed());
+  }
+}
+
+}  // namespace
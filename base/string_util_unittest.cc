@@ -342,6 +342,16 @@ TEST(StringUtilTest, IsStringUTF8) {
   EXPECT_TRUE(IsStringUTF8("a\xc2\x81\xe1\x80\xbf\xf1\x80\xa0\xbf"));
   EXPECT_TRUE(IsStringUTF8("\xef\xbb\xbf" "abc"));  // UTF-8 BOM
 
+  // Runs of ASCII are skipped a word at a time; check that what follows them
+  // is still looked at, wherever it is.
+  for (size_t i = 0; i < 20; ++i) {
+    std::string ascii(i, 'a');
+    EXPECT_TRUE(IsStringUTF8(ascii + "\xe1\x80\xbf" + ascii)) << i;
+    EXPECT_FALSE(IsStringUTF8(ascii + "\xe1\x80" + ascii)) << i;
+    EXPECT_FALSE(IsStringUTF8(ascii + "\xef\xbf\xbe" + ascii)) << i;
+    EXPECT_FALSE(IsStringUTF8(ascii + "\xc0")) << i;
+  }
+
   // surrogate code points
   EXPECT_FALSE(IsStringUTF8("\xed\xa0\x80\xed\xbf\xbf"));
   EXPECT_FALSE(IsStringUTF8("\xed\xa0\x8f"));
@@ -426,6 +436,29 @@ TEST(StringUtilTest, ConvertASCII) {
   EXPECT_FALSE(IsStringASCII("Google \x80Video"));
   EXPECT_FALSE(IsStringASCII(L"Google \x80Video"));
 
+  // The ASCII check works on words, so put the non-ASCII character at every
+  // offset of strings that start at every alignment.
+  const std::string long_ascii(67, 'a');
+  const std::wstring long_wide_ascii(67, L'a');
+  const string16 long_ascii16(67, 'a');
+  for (size_t start = 0; start < 8; ++start) {
+    EXPECT_TRUE(IsStringASCII(base::StringPiece(long_ascii).substr(start)));
+    EXPECT_TRUE(IsStringASCII(long_wide_ascii.substr(start)));
+    EXPECT_TRUE(IsStringASCII(long_ascii16.substr(start)));
+    for (size_t i = start; i < long_ascii.length(); ++i) {
+      std::string narrow(long_ascii);
+      narrow[i] = '\x80';
+      EXPECT_FALSE(IsStringASCII(base::StringPiece(narrow).substr(start)))
+          << start << " " << i;
+      std::wstring wide(long_wide_ascii);
+      wide[i] = 0x100;
+      EXPECT_FALSE(IsStringASCII(wide.substr(start))) << start << " " << i;
+      string16 utf16(long_ascii16);
+      utf16[i] = 0x80;
+      EXPECT_FALSE(IsStringASCII(utf16.substr(start))) << start << " " << i;
+    }
+  }
+
   // Convert empty strings.
   std::wstring wempty;
   std::string empty;
@@ -445,6 +478,29 @@ TEST(StringUtilTest, ConvertASCII) {
   EXPECT_EQ(0, string_with_nul.compare(narrow_with_nul));
 }
 
+TEST(StringUtilTest, ToLowerASCII) {
+  std::string in_place_a("Cc2");
+  StringToLowerASCII(&in_place_a);
+  EXPECT_EQ("cc2", in_place_a);
+
+  std::wstring in_place_w(L"Cc2");
+  StringToLowerASCII(&in_place_w);
+  EXPECT_EQ(L"cc2", in_place_w);
+
+  // Every byte, at every offset of a word, is lowered the way ToLowerASCII()
+  // lowers it on its own.
+  std::string all_bytes;
+  for (int i = 0; i < 256; ++i)
+    all_bytes.push_back(static_cast<char>(i));
+  for (size_t start = 0; start < 8; ++start) {
+    std::string lowered(all_bytes.substr(start));
+    StringToLowerASCII(&lowered);
+    ASSERT_EQ(all_bytes.length() - start, lowered.length());
+    for (size_t i = 0; i < lowered.length(); ++i)
+      EXPECT_EQ(ToLowerASCII(all_bytes[start + i]), lowered[i]) << i;
+  }
+}
+
 TEST(StringUtilTest, ToUpperASCII) {
   EXPECT_EQ('C', ToUpperASCII('C'));
   EXPECT_EQ('C', ToUpperASCII('c'));
@@ -488,6 +544,27 @@ TEST(StringUtilTest, LowerCaseEqualsASCII) {
     EXPECT_TRUE(LowerCaseEqualsASCII(lowercase_cases[i].src_a,
                                      lowercase_cases[i].dst));
   }
+
+  // Longer strings are compared a word at a time.
+  const std::string mixed("Content-Type: Text/HTML; Charset=UTF-8");
+  const std::string lower("content-type: text/html; charset=utf-8");
+  EXPECT_TRUE(LowerCaseEqualsASCII(mixed, lower.c_str()));
+  EXPECT_TRUE(LowerCaseEqualsASCII(mixed.begin() + 3, mixed.end(),
+                                   lower.c_str() + 3));
+  EXPECT_FALSE(LowerCaseEqualsASCII(mixed, mixed.c_str()));
+  EXPECT_FALSE(LowerCaseEqualsASCII(mixed, (lower + "x").c_str()));
+  EXPECT_FALSE(LowerCaseEqualsASCII(mixed + "x", lower.c_str()));
+  for (size_t i = 0; i < lower.length(); ++i) {
+    std::string different(lower);
+    different[i] = '\xC0';
+    EXPECT_FALSE(LowerCaseEqualsASCII(mixed, different.c_str())) << i;
+  }
+  // Only 'A' to 'Z' are lowered, so the bytes around them don't match.
+  EXPECT_FALSE(LowerCaseEqualsASCII("@[\xC1", "`{\xE1"));
+  EXPECT_TRUE(LowerCaseEqualsASCII(std::string("@[\xC1AZ@[\xC1AZ"),
+                                   "@[\xC1az@[\xC1az"));
+  EXPECT_TRUE(LowerCaseEqualsASCII(std::string(), ""));
+  EXPECT_FALSE(LowerCaseEqualsASCII(std::string(), "a"));
 }
 
 TEST(StringUtilTest, GetByteDisplayUnits) {
@@ -0,0 +1,76 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// LockContention records how long threads wait for a base::Lock that another
+// thread holds, by the code address the lock was acquired from.  It shows
+// which locks are worth removing or splitting.
+//
+// Recording is off by default and only costs a flag check when a lock is
+// contended.  When it is on, each wait that did not end while spinning costs
+// two clock reads and an update of a global table, which is small next to the
+// wait itself.  Uncontended acquisitions are never recorded.
+//
+// The sites are return addresses into the functions that called Acquire(),
+// or that used an AutoLock; symbolize them against the binary, e.g. with
+// addr2line.
+//
+// Only implemented on POSIX.
+
+#ifndef BASE_SYNCHRONIZATION_LOCK_CONTENTION_H_
+#define BASE_SYNCHRONIZATION_LOCK_CONTENTION_H_
+#pragma once
+
+#include "build/build_config.h"
+
+#if defined(OS_POSIX)
+
+#include <vector>
+
+#include "base/base_api.h"
+#include "base/basictypes.h"
+
+namespace base {
+
+class BASE_API LockContention {
+ public:
+  // The number of buckets in the histogram of each site.
+  static const int kNumBuckets = 16;
+
+  struct BASE_API Site {
+    Site();
+
+    const void* acquired_from;
+    int count;
+    int64 total_wait_us;
+    int64 max_wait_us;
+    // buckets[i] counts the waits of at least 2^(i-1) and less than 2^i
+    // microseconds; buckets[0] counts the waits of less than 1 microsecond and
+    // the last bucket all the waits that are longer.
+    int buckets[kNumBuckets];
+  };
+
+  // Starts or stops recording.  Recording that stopped can be started again,
+  // and adds to the sites recorded before.
+  static void SetEnabled(bool enabled);
+  static bool IsEnabled();
+
+  // Returns the recorded sites in |sites|, the longest total wait first.
+  static void GetSites(std::vector<Site>* sites);
+
+  // Forgets all the recorded sites.
+  static void Reset();
+
+  // Records that acquiring a lock at |acquired_from| waited for |wait_us|
+  // microseconds.  Called by the lock implementation.
+  static void RecordWait(const void* acquired_from, int64 wait_us);
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(LockContention);
+};
+
+}  // namespace base
+
+#endif  // defined(OS_POSIX)
+
+#endif  // BASE_SYNCHRONIZATION_LOCK_CONTENTION_H_
@@ -0,0 +1,108 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/synchronization/lock_contention.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/atomicops.h"
+
+namespace base {
+
+namespace {
+
+// The table of sites is fixed in size, so that recording never allocates.
+// Waits at sites that find the table full are dropped.
+const size_t kMaxSites = 512;
+
+subtle::Atomic32 g_enabled = 0;
+
+// A raw mutex rather than a Lock, which would record its own contention.
+pthread_mutex_t g_sites_lock = PTHREAD_MUTEX_INITIALIZER;
+LockContention::Site g_sites[kMaxSites];
+
+size_t HashSite(const void* acquired_from) {
+  uintptr_t value = reinterpret_cast<uintptr_t>(acquired_from);
+  return (value ^ (value >> 9)) % kMaxSites;
+}
+
+int BucketOf(int64 wait_us) {
+  int bucket = 0;
+  while (bucket < LockContention::kNumBuckets - 1 &&
+         wait_us >= (GG_INT64_C(1) << bucket)) {
+    ++bucket;
+  }
+  return bucket;
+}
+
+bool CompareTotalWait(const LockContention::Site& a,
+                      const LockContention::Site& b) {
+  return a.total_wait_us > b.total_wait_us;
+}
+
+}  // namespace
+
+LockContention::Site::Site()
+    : acquired_from(NULL),
+      count(0),
+      total_wait_us(0),
+      max_wait_us(0) {
+  memset(buckets, 0, sizeof(buckets));
+}
+
+// static
+void LockContention::SetEnabled(bool enabled) {
+  subtle::NoBarrier_Store(&g_enabled, enabled ? 1 : 0);
+}
+
+// static
+bool LockContention::IsEnabled() {
+  return subtle::NoBarrier_Load(&g_enabled) != 0;
+}
+
+// static
+void LockContention::GetSites(std::vector<Site>* sites) {
+  sites->clear();
+  pthread_mutex_lock(&g_sites_lock);
+  for (size_t i = 0; i < kMaxSites; ++i) {
+    if (g_sites[i].acquired_from)
+      sites->push_back(g_sites[i]);
+  }
+  pthread_mutex_unlock(&g_sites_lock);
+  std::sort(sites->begin(), sites->end(), CompareTotalWait);
+}
+
+// static
+void LockContention::Reset() {
+  pthread_mutex_lock(&g_sites_lock);
+  for (size_t i = 0; i < kMaxSites; ++i)
+    g_sites[i] = Site();
+  pthread_mutex_unlock(&g_sites_lock);
+}
+
+// static
+void LockContention::RecordWait(const void* acquired_from, int64 wait_us) {
+  pthread_mutex_lock(&g_sites_lock);
+  // Open addressing with linear probing.
+  size_t index = HashSite(acquired_from);
+  for (size_t probes = 0; probes < kMaxSites; ++probes) {
+    Site* site = &g_sites[index];
+    if (!site->acquired_from)
+      site->acquired_from = acquired_from;
+    if (site->acquired_from == acquired_from) {
+      ++site->count;
+      site->total_wait_us += wait_us;
+      site->max_wait_us = std::max(site->max_wait_us, wait_us);
+      ++site->buckets[BucketOf(wait_us)];
+      break;
+    }
+    index = (index + 1) % kMaxSites;
+  }
+  pthread_mutex_unlock(&g_sites_lock);
+}
+
+}  // namespace base
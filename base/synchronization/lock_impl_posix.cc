@@ -5,12 +5,49 @@
 #include "base/synchronization/lock_impl.h"
 
 #include <errno.h>
+#include <unistd.h>
 
+#include "base/atomicops.h"
 #include "base/logging.h"
+#include "base/synchronization/lock_contention.h"
+#include "base/time.h"
 
 namespace base {
 namespace internal {
 
+namespace {
+
+// How many times Lock() tries again to take a contended lock before it
+// sleeps.  Critical sections are mostly short, so spinning for a few
+// microseconds usually gets the lock without the cost of sleeping and being
+// woken up.  The Windows implementation gets the same from the spin count of
+// its critical section.
+const int kSpinCount = 100;
+
+// The spin count for this machine: spinning is pointless with one CPU, as
+// the holder can't run while we spin.  Computed on first use; racing threads
+// compute the same value.
+subtle::Atomic32 g_spin_count = -1;
+
+int SpinCount() {
+  int spin_count = subtle::NoBarrier_Load(&g_spin_count);
+  if (spin_count < 0) {
+    spin_count = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? kSpinCount : 0;
+    subtle::NoBarrier_Store(&g_spin_count, spin_count);
+  }
+  return spin_count;
+}
+
+inline void SpinPause() {
+#if defined(ARCH_CPU_X86_FAMILY)
+  __asm__ __volatile__("pause");
+#else
+  __asm__ __volatile__("" : : : "memory");
+#endif
+}
+
+}  // namespace
+
 LockImpl::LockImpl() {
 #ifndef NDEBUG
   // In debug, setup attributes for lock error checking.
@@ -41,8 +78,28 @@ bool LockImpl::Try() {
 }
 
 void LockImpl::Lock() {
+  if (pthread_mutex_trylock(&os_lock_) == 0)
+    return;
+
+  for (int i = SpinCount(); i > 0; --i) {
+    SpinPause();
+    if (pthread_mutex_trylock(&os_lock_) == 0)
+      return;
+  }
+
+  if (!LockContention::IsEnabled()) {
+    int rv = pthread_mutex_lock(&os_lock_);
+    DCHECK_EQ(rv, 0);
+    return;
+  }
+
+  // Lock::Acquire() is inlined, so our return address is in the function
+  // that acquired the lock.
+  const TimeTicks start = TimeTicks::Now();
   int rv = pthread_mutex_lock(&os_lock_);
   DCHECK_EQ(rv, 0);
+  LockContention::RecordWait(__builtin_return_address(0),
+                             (TimeTicks::Now() - start).InMicroseconds());
 }
 
 void LockImpl::Unlock() {
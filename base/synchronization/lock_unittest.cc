@@ -4,7 +4,11 @@
 
 #include <stdlib.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "base/synchronization/lock.h"
+#include "base/synchronization/lock_contention.h"
 #include "base/threading/platform_thread.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -211,4 +215,61 @@ TEST(LockTest, MutexFourThreads) {
   EXPECT_EQ(4 * 40, value);
 }
 
+#if defined(OS_POSIX)
+
+// Test that waits for a held lock are recorded -------------------------------
+
+class HoldLockTestThread : public PlatformThread::Delegate {
+ public:
+  HoldLockTestThread(Lock* lock, int hold_ms)
+      : lock_(lock), hold_ms_(hold_ms) {}
+
+  virtual void ThreadMain() {
+    lock_->Acquire();
+    PlatformThread::Sleep(hold_ms_);
+    lock_->Release();
+  }
+
+ private:
+  Lock* lock_;
+  int hold_ms_;
+
+  DISALLOW_COPY_AND_ASSIGN(HoldLockTestThread);
+};
+
+TEST(LockTest, ContentionIsRecorded) {
+  LockContention::Reset();
+  LockContention::SetEnabled(true);
+
+  Lock lock;
+  HoldLockTestThread thread(&lock, 50);
+  PlatformThreadHandle handle = kNullThreadHandle;
+  lock.Acquire();
+  ASSERT_TRUE(PlatformThread::Create(0, &thread, &handle));
+  lock.Release();
+
+  // Give the thread the time to take the lock, then wait for it.
+  PlatformThread::Sleep(10);
+  lock.Acquire();
+  lock.Release();
+  PlatformThread::Join(handle);
+
+  LockContention::SetEnabled(false);
+  std::vector<LockContention::Site> sites;
+  LockContention::GetSites(&sites);
+  LockContention::Reset();
+
+  // The main thread waited for about 40ms.  Look at every site, as the
+  // thread may have waited in Create() too.
+  ASSERT_FALSE(sites.empty());
+  int64 max_wait_us = 0;
+  for (size_t i = 0; i < sites.size(); ++i) {
+    EXPECT_GT(sites[i].count, 0);
+    max_wait_us = std::max(max_wait_us, sites[i].max_wait_us);
+  }
+  EXPECT_GE(max_wait_us, 10000);
+}
+
+#endif  // defined(OS_POSIX)
+
 }  // namespace base
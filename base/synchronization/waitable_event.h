@@ -14,8 +14,8 @@
 #endif
 
 #if defined(OS_POSIX)
-#include <list>
 #include <utility>
+#include <vector>
 #include "base/memory/ref_counted.h"
 #include "base/synchronization/lock.h"
 #endif
@@ -153,7 +153,10 @@ class BASE_API WaitableEvent {
     base::Lock lock_;
     const bool manual_reset_;
     bool signaled_;
-    std::list<Waiter*> waiters_;
+    // A vector rather than a list, as there are rarely more than a couple of
+    // waiters, and a vector keeps its storage when they leave: enqueuing a
+    // waiter for every blocking wait doesn't allocate.
+    std::vector<Waiter*> waiters_;
   };
 
   typedef std::pair<WaitableEvent*, size_t> WaiterAndIndex;
@@ -4,6 +4,8 @@
 
 #include "base/synchronization/waitable_event.h"
 
+#include <algorithm>
+
 #include "base/synchronization/condition_variable.h"
 #include "base/synchronization/lock.h"
 #include "base/message_loop.h"
@@ -154,8 +156,9 @@ bool WaitableEvent::Wait() {
 }
 
 bool WaitableEvent::TimedWait(const TimeDelta& max_time) {
-  const Time end_time(Time::Now() + max_time);
   const bool finite_time = max_time.ToInternalValue() >= 0;
+  // Wait() doesn't need to read the clock, here or in the loop below.
+  const Time end_time(finite_time ? Time::Now() + max_time : Time());
 
   kernel_->lock_.Acquire();
     if (kernel_->signaled_) {
@@ -179,7 +182,7 @@ bool WaitableEvent::TimedWait(const TimeDelta& max_time) {
   // again before unlocking it.
 
   for (;;) {
-    const Time current_time(Time::Now());
+    const Time current_time(finite_time ? Time::Now() : Time());
 
     if (sw.fired() || (finite_time && current_time >= end_time)) {
       const bool return_value = sw.fired();
@@ -212,8 +215,8 @@ bool WaitableEvent::TimedWait(const TimeDelta& max_time) {
 // Synchronous waiting on multiple objects.
 
 static bool  // StrictWeakOrdering
-cmp_fst_addr(const std::pair<WaitableEvent*, unsigned> &a,
-             const std::pair<WaitableEvent*, unsigned> &b) {
+cmp_fst_addr(const std::pair<WaitableEvent*, size_t> &a,
+             const std::pair<WaitableEvent*, size_t> &b) {
   return a.first < b.first;
 }
 
@@ -224,26 +227,31 @@ size_t WaitableEvent::WaitMany(WaitableEvent** raw_waitables,
 
   // We need to acquire the locks in a globally consistent order. Thus we sort
   // the array of waitables by address. We actually sort a pairs so that we can
-  // map back to the original index values later.
-  std::vector<std::pair<WaitableEvent*, size_t> > waitables;
-  waitables.reserve(count);
+  // map back to the original index values later.  Callers wait on a handful
+  // of events, which fit on the stack.
+  const size_t kMaxStackWaitables = 16;
+  WaiterAndIndex stack_waitables[kMaxStackWaitables];
+  std::vector<WaiterAndIndex> heap_waitables;
+  WaiterAndIndex* waitables = stack_waitables;
+  if (count > kMaxStackWaitables) {
+    heap_waitables.resize(count);
+    waitables = &heap_waitables[0];
+  }
   for (size_t i = 0; i < count; ++i)
-    waitables.push_back(std::make_pair(raw_waitables[i], i));
-
-  DCHECK_EQ(count, waitables.size());
+    waitables[i] = std::make_pair(raw_waitables[i], i);
 
-  sort(waitables.begin(), waitables.end(), cmp_fst_addr);
+  std::sort(waitables, waitables + count, cmp_fst_addr);
 
   // The set of waitables must be distinct. Since we have just sorted by
   // address, we can check this cheaply by comparing pairs of consecutive
   // elements.
-  for (size_t i = 0; i < waitables.size() - 1; ++i) {
+  for (size_t i = 0; i < count - 1; ++i) {
     DCHECK(waitables[i].first != waitables[i+1].first);
   }
 
   SyncWaiter sw;
 
-  const size_t r = EnqueueMany(&waitables[0], count, &sw);
+  const size_t r = EnqueueMany(waitables, count, &sw);
   if (r) {
     // One of the events is already signaled. The SyncWaiter has not been
     // enqueued anywhere. EnqueueMany returns the count of remaining waitables
@@ -347,7 +355,7 @@ WaitableEvent::WaitableEventKernel::~WaitableEventKernel() {
 bool WaitableEvent::SignalAll() {
   bool signaled_at_least_one = false;
 
-  for (std::list<Waiter*>::iterator
+  for (std::vector<Waiter*>::iterator
        i = kernel_->waiters_.begin(); i != kernel_->waiters_.end(); ++i) {
     if ((*i)->Fire(this))
       signaled_at_least_one = true;
@@ -366,8 +374,8 @@ bool WaitableEvent::SignalOne() {
     if (kernel_->waiters_.empty())
       return false;
 
-    const bool r = (*kernel_->waiters_.begin())->Fire(this);
-    kernel_->waiters_.pop_front();
+    const bool r = kernel_->waiters_.front()->Fire(this);
+    kernel_->waiters_.erase(kernel_->waiters_.begin());
     if (r)
       return true;
   }
@@ -385,7 +393,7 @@ void WaitableEvent::Enqueue(Waiter* waiter) {
 // actually removed. Called with lock held.
 // -----------------------------------------------------------------------------
 bool WaitableEvent::WaitableEventKernel::Dequeue(Waiter* waiter, void* tag) {
-  for (std::list<Waiter*>::iterator
+  for (std::vector<Waiter*>::iterator
        i = waiters_.begin(); i != waiters_.end(); ++i) {
     if (*i == waiter && (*i)->Compare(tag)) {
       waiters_.erase(i);
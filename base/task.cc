@@ -4,12 +4,24 @@
 
 #include "base/task.h"
 
+#include "base/memory/small_object_pool.h"
+
 Task::Task() {
 }
 
 Task::~Task() {
 }
 
+// static
+void* Task::operator new(size_t size) {
+  return base::SmallObjectPool::Allocate(size);
+}
+
+// static
+void Task::operator delete(void* pointer, size_t size) {
+  base::SmallObjectPool::Free(pointer, size);
+}
+
 CancelableTask::CancelableTask() {
 }
 
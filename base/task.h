@@ -6,6 +6,8 @@
 #define BASE_TASK_H_
 #pragma once
 
+#include <stddef.h>
+
 #include "base/base_api.h"
 #include "base/memory/raw_scoped_refptr_mismatch_checker.h"
 #include "base/memory/weak_ptr.h"
@@ -24,6 +26,12 @@ class BASE_API Task : public tracked_objects::Tracked {
 
   // Tasks are automatically deleted after Run is called.
   virtual void Run() = 0;
+
+  // One task is created for every PostTask() and deleted right after it runs,
+  // so tasks come from base::SmallObjectPool rather than the general
+  // allocator.
+  static void* operator new(size_t size);
+  static void operator delete(void* pointer, size_t size);
 };
 
 class BASE_API CancelableTask : public Task {
@@ -47,6 +47,15 @@ typedef pid_t PlatformThreadId;
 
 const PlatformThreadId kInvalidThreadId = 0;
 
+// Valid values for SetCurrentThreadPriority().
+enum ThreadPriority {
+  kThreadPriority_Normal,
+  // For threads whose tasks someone is waiting on, like the IO thread.
+  kThreadPriority_LatencySensitive,
+  // For threads that do work nobody is waiting on, like writing history.
+  kThreadPriority_Background
+};
+
 // A namespace for low-level thread functions.
 class BASE_API PlatformThread {
  public:
@@ -70,6 +79,16 @@ class BASE_API PlatformThread {
   // Sets the thread name visible to a debugger.  This has no effect otherwise.
   static void SetName(const char* name);
 
+  // Sets the scheduling priority of the current thread.  Raising the priority
+  // may need privileges the process does not have.  Returns false if the
+  // priority could not be set.
+  static bool SetCurrentThreadPriority(ThreadPriority priority);
+
+  // Restricts the current thread to run on the CPUs whose bits are set in
+  // |cpu_mask|, bit 0 being the first CPU.  Returns false if this is not
+  // supported or |cpu_mask| has no CPU that is online.
+  static bool SetCurrentThreadAffinity(uint64 cpu_mask);
+
   // Creates a new thread.  The |stack_size| parameter can be 0 to indicate
   // that the default stack size should be used.  Upon success,
   // |*thread_handle| will be assigned a handle to the newly created thread,
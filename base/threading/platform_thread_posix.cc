@@ -21,6 +21,7 @@
 #if defined(OS_LINUX)
 #include <dlfcn.h>
 #include <sys/prctl.h>
+#include <sys/resource.h>
 #include <sys/syscall.h>
 #include <unistd.h>
 #endif
@@ -197,6 +198,60 @@ void PlatformThread::SetName(const char* /*name*/) {
 }
 #endif  // defined(OS_LINUX)
 
+#if defined(OS_LINUX)
+// static
+bool PlatformThread::SetCurrentThreadPriority(ThreadPriority priority) {
+  // Linux schedules threads as separate tasks, so the nice value of the
+  // thread's own id only affects this thread.  These are the values Android
+  // uses for its display and background threads.
+  int nice_value = 0;
+  switch (priority) {
+    case kThreadPriority_Normal:
+      nice_value = 0;
+      break;
+    case kThreadPriority_LatencySensitive:
+      nice_value = -4;
+      break;
+    case kThreadPriority_Background:
+      nice_value = 10;
+      break;
+    default:
+      NOTREACHED();
+      return false;
+  }
+  if (setpriority(PRIO_PROCESS, CurrentId(), nice_value) != 0) {
+    DPLOG(ERROR) << "setpriority(" << nice_value << ")";
+    return false;
+  }
+  return true;
+}
+
+// static
+bool PlatformThread::SetCurrentThreadAffinity(uint64 cpu_mask) {
+  // Call the kernel directly, as not every libc we build against wraps
+  // sched_setaffinity().  The kernel takes the mask as an array of longs.
+  unsigned long mask[sizeof(cpu_mask) / sizeof(unsigned long)];
+  for (size_t i = 0; i < arraysize(mask); ++i)
+    mask[i] = static_cast<unsigned long>(cpu_mask >> (i * 8 * sizeof(long)));
+  if (syscall(__NR_sched_setaffinity, 0, sizeof(mask), mask) != 0) {
+    DPLOG(ERROR) << "sched_setaffinity(" << cpu_mask << ")";
+    return false;
+  }
+  return true;
+}
+#else
+// static
+bool PlatformThread::SetCurrentThreadPriority(ThreadPriority priority) {
+  // Other POSIX systems only have a priority per process.
+  return priority == kThreadPriority_Normal;
+}
+
+// static
+bool PlatformThread::SetCurrentThreadAffinity(uint64 cpu_mask) {
+  return false;
+}
+#endif  // defined(OS_LINUX)
+
 // static
 bool PlatformThread::Create(size_t stack_size, Delegate* delegate,
                             PlatformThreadHandle* thread_handle) {
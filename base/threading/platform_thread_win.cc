@@ -124,6 +124,40 @@ bool PlatformThread::CreateNonJoinable(size_t stack_size, Delegate* delegate) {
   return CreateThreadInternal(stack_size, delegate, NULL);
 }
 
+// static
+bool PlatformThread::SetCurrentThreadPriority(ThreadPriority priority) {
+  int win_priority = THREAD_PRIORITY_NORMAL;
+  switch (priority) {
+    case kThreadPriority_Normal:
+      win_priority = THREAD_PRIORITY_NORMAL;
+      break;
+    case kThreadPriority_LatencySensitive:
+      win_priority = THREAD_PRIORITY_ABOVE_NORMAL;
+      break;
+    case kThreadPriority_Background:
+      win_priority = THREAD_PRIORITY_LOWEST;
+      break;
+    default:
+      NOTREACHED();
+      return false;
+  }
+  if (!::SetThreadPriority(GetCurrentThread(), win_priority)) {
+    DPLOG(ERROR) << "SetThreadPriority(" << win_priority << ")";
+    return false;
+  }
+  return true;
+}
+
+// static
+bool PlatformThread::SetCurrentThreadAffinity(uint64 cpu_mask) {
+  if (!SetThreadAffinityMask(GetCurrentThread(),
+                             static_cast<DWORD_PTR>(cpu_mask))) {
+    DPLOG(ERROR) << "SetThreadAffinityMask(" << cpu_mask << ")";
+    return false;
+  }
+  return true;
+}
+
 // static
 void PlatformThread::Join(PlatformThreadHandle thread_handle) {
   DCHECK(thread_handle);
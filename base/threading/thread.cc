@@ -149,6 +149,12 @@ void Thread::ThreadMain() {
     thread_id_ = PlatformThread::CurrentId();
     PlatformThread::SetName(name_.c_str());
     ANNOTATE_THREAD_NAME(name_.c_str());  // Tell the name to race detector.
+    if (startup_data_->options.priority != kThreadPriority_Normal)
+      PlatformThread::SetCurrentThreadPriority(startup_data_->options.priority);
+    if (startup_data_->options.cpu_affinity_mask) {
+      PlatformThread::SetCurrentThreadAffinity(
+          startup_data_->options.cpu_affinity_mask);
+    }
     message_loop.set_thread_name(name_);
     message_loop_ = &message_loop;
     message_loop_proxy_ = MessageLoopProxy::CreateForCurrentThread();
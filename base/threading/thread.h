@@ -29,9 +29,16 @@ namespace base {
 class BASE_API Thread : PlatformThread::Delegate {
  public:
   struct Options {
-    Options() : message_loop_type(MessageLoop::TYPE_DEFAULT), stack_size(0) {}
+    Options()
+        : message_loop_type(MessageLoop::TYPE_DEFAULT),
+          stack_size(0),
+          priority(kThreadPriority_Normal),
+          cpu_affinity_mask(0) {}
     Options(MessageLoop::Type type, size_t size)
-        : message_loop_type(type), stack_size(size) {}
+        : message_loop_type(type),
+          stack_size(size),
+          priority(kThreadPriority_Normal),
+          cpu_affinity_mask(0) {}
 
     // Specifies the type of message loop that will be allocated on the thread.
     MessageLoop::Type message_loop_type;
@@ -40,6 +47,15 @@ class BASE_API Thread : PlatformThread::Delegate {
     // This does not necessarily correspond to the thread's initial stack size.
     // A value of 0 indicates that the default maximum should be used.
     size_t stack_size;
+
+    // The scheduling priority the thread sets for itself when it starts.  The
+    // thread runs at normal priority if it cannot be set.
+    ThreadPriority priority;
+
+    // If not 0, the CPUs the thread runs on, see
+    // PlatformThread::SetCurrentThreadAffinity().  The thread runs on any CPU
+    // if the affinity cannot be set.
+    uint64 cpu_affinity_mask;
   };
 
   // Constructor.
@@ -179,6 +179,23 @@ TEST_F(ThreadTest, StartWithOptions_StackSize) {
   EXPECT_TRUE(was_invoked);
 }
 
+TEST_F(ThreadTest, StartWithOptions_PriorityAndAffinity) {
+  Thread a("StartWithPriorityAndAffinity");
+  // Lowering the priority and running on the first CPU are allowed even
+  // where the settings are not supported, as the thread only runs at its
+  // default priority on any CPU then.
+  Thread::Options options;
+  options.priority = base::kThreadPriority_Background;
+  options.cpu_affinity_mask = 1;
+  EXPECT_TRUE(a.StartWithOptions(options));
+  EXPECT_TRUE(a.IsRunning());
+
+  bool was_invoked = false;
+  a.message_loop()->PostTask(FROM_HERE, new ToggleValue(&was_invoked));
+  a.Stop();
+  EXPECT_TRUE(was_invoked);
+}
+
 TEST_F(ThreadTest, TwoTasks) {
   bool was_invoked = false;
   {
@@ -121,14 +121,24 @@ void PosixDynamicThreadPool::Terminate() {
 }
 
 void PosixDynamicThreadPool::PostTask(Task* task) {
-  AutoLock locked(lock_);
-  DCHECK(!terminated_) <<
-      "This thread pool is already terminated.  Do not post new tasks.";
+  bool need_new_thread;
+  {
+    AutoLock locked(lock_);
+    DCHECK(!terminated_) <<
+        "This thread pool is already terminated.  Do not post new tasks.";
 
-  tasks_.push(task);
+    tasks_.push(task);
+
+    // We have enough worker threads.
+    need_new_thread =
+        static_cast<size_t>(num_idle_threads_) < tasks_.size();
+  }
 
-  // We have enough worker threads.
-  if (static_cast<size_t>(num_idle_threads_) >= tasks_.size()) {
+  // Neither waking a worker nor creating a thread needs |lock_|.  Doing them
+  // after releasing it keeps other threads posting tasks from queueing up
+  // behind thread creation, and lets the woken worker take the lock right
+  // away instead of blocking on it again.
+  if (!need_new_thread) {
     tasks_available_cv_.Signal();
   } else {
     // The new PlatformThread will take ownership of the WorkerThread object,
@@ -150,7 +160,7 @@ Task* PosixDynamicThreadPool::WaitForTask() {
     if (num_idle_threads_cv_.get())
       num_idle_threads_cv_->Signal();
     tasks_available_cv_.TimedWait(
-        TimeDelta::FromSeconds(kIdleSecondsBeforeExit));
+        TimeDelta::FromSeconds(idle_seconds_before_exit_));
     num_idle_threads_--;
     if (num_idle_threads_cv_.get())
       num_idle_threads_cv_->Signal();
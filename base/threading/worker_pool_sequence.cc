@@ -0,0 +1,93 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/threading/worker_pool_sequence.h"
+
+#include "base/logging.h"
+#include "base/task.h"
+#include "base/threading/worker_pool.h"
+
+namespace base {
+
+WorkerPoolSequence::WorkerPoolSequence(bool tasks_are_slow)
+    : tasks_are_slow_(tasks_are_slow),
+      running_(false),
+      running_thread_id_(kInvalidThreadId) {
+}
+
+WorkerPoolSequence::~WorkerPoolSequence() {
+  // RunTasks() holds a reference while it runs, so there is nothing left to
+  // run unless starting it failed.
+  DCHECK(!running_);
+  while (!tasks_.empty()) {
+    delete tasks_.front();
+    tasks_.pop();
+  }
+}
+
+bool WorkerPoolSequence::PostTask(const tracked_objects::Location& from_here,
+                                  Task* task) {
+  task->SetBirthPlace(from_here);
+  {
+    AutoLock locked(lock_);
+    tasks_.push(task);
+    if (running_)
+      return true;  // The running RunTasks() picks |task| up.
+    running_ = true;
+  }
+
+  if (WorkerPool::PostTask(from_here,
+                           NewRunnableMethod(this,
+                                             &WorkerPoolSequence::RunTasks),
+                           tasks_are_slow_)) {
+    return true;
+  }
+
+  // Nothing will run the tasks; drop them all, since running the later ones
+  // without this one would break the order.
+  std::queue<Task*> tasks;
+  {
+    AutoLock locked(lock_);
+    while (!tasks_.empty()) {
+      tasks.push(tasks_.front());
+      tasks_.pop();
+    }
+    running_ = false;
+  }
+  while (!tasks.empty()) {
+    delete tasks.front();
+    tasks.pop();
+  }
+  return false;
+}
+
+bool WorkerPoolSequence::RunsTasksOnCurrentThread() const {
+  AutoLock locked(lock_);
+  return running_thread_id_ == PlatformThread::CurrentId();
+}
+
+void WorkerPoolSequence::RunTasks() {
+  // Draining the queue on this worker keeps the sequence from paying for a
+  // WorkerPool::PostTask() per task.  Taking |lock_| for each task also makes
+  // everything a task did visible to the next one, whichever thread runs it.
+  for (;;) {
+    Task* task;
+    {
+      AutoLock locked(lock_);
+      DCHECK(running_);
+      if (tasks_.empty()) {
+        running_ = false;
+        running_thread_id_ = kInvalidThreadId;
+        return;
+      }
+      task = tasks_.front();
+      tasks_.pop();
+      running_thread_id_ = PlatformThread::CurrentId();
+    }
+    task->Run();
+    delete task;
+  }
+}
+
+}  // namespace base
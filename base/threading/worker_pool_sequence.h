@@ -0,0 +1,84 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_THREADING_WORKER_POOL_SEQUENCE_H_
+#define BASE_THREADING_WORKER_POOL_SEQUENCE_H_
+#pragma once
+
+#include <queue>
+
+#include "base/base_api.h"
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/platform_thread.h"
+#include "base/tracked.h"
+
+class Task;
+
+namespace base {
+
+// A WorkerPoolSequence runs the tasks posted to it on the WorkerPool, in the
+// order they were posted, one at a time.  It is for code that needs its
+// background work to be ordered, such as a store writing to one file, and
+// would otherwise start a Thread of its own that sits idle most of the time.
+// Tasks of different sequences run in parallel.
+//
+// Each task may run on a different worker thread, but a task sees everything
+// the tasks before it in the sequence did.  The sequence takes one worker
+// thread while it has tasks to run, and none while it has not.
+//
+// The same caveats as for WorkerPool apply: worker threads are not joined on
+// shutdown, so tasks still pending or running then must not depend on objects
+// that go away during shutdown.
+//
+// Example:
+//
+//   scoped_refptr<WorkerPoolSequence> sequence(new WorkerPoolSequence(false));
+//   sequence->PostTask(FROM_HERE, NewRunnableMethod(store, &Store::Open));
+//   sequence->PostTask(FROM_HERE, NewRunnableMethod(store, &Store::Write));
+//
+// WorkerPoolSequence is thread safe.  Tasks may be posted from any thread,
+// including from tasks of the sequence.
+class BASE_API WorkerPoolSequence
+    : public RefCountedThreadSafe<WorkerPoolSequence> {
+ public:
+  // |tasks_are_slow| is passed on to WorkerPool::PostTask().
+  explicit WorkerPoolSequence(bool tasks_are_slow);
+
+  // Posts |task| to run after all the tasks posted before it.  Takes ownership
+  // of |task|.  Returns false if the sequence could not be started on the
+  // WorkerPool, in which case |task| and the other tasks that have not run
+  // are deleted.
+  bool PostTask(const tracked_objects::Location& from_here, Task* task);
+
+  // Returns true if the calling thread is running a task of this sequence.
+  bool RunsTasksOnCurrentThread() const;
+
+ private:
+  friend class RefCountedThreadSafe<WorkerPoolSequence>;
+
+  ~WorkerPoolSequence();
+
+  // Runs on a worker thread until there are no more tasks to run.
+  void RunTasks();
+
+  const bool tasks_are_slow_;
+
+  mutable Lock lock_;  // Protects all the variables below.
+
+  std::queue<Task*> tasks_;
+
+  // True while a worker thread is running, or is about to run, RunTasks().
+  bool running_;
+
+  // The thread running the current task, or kInvalidThreadId.
+  PlatformThreadId running_thread_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkerPoolSequence);
+};
+
+}  // namespace base
+
+#endif  // BASE_THREADING_WORKER_POOL_SEQUENCE_H_
@@ -0,0 +1,144 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/threading/worker_pool_sequence.h"
+
+#include <vector>
+
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/task.h"
+#include "base/threading/platform_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Records the order the tasks of a sequence ran in, and whether any two of
+// them ran at the same time.
+class SequenceRecorder {
+ public:
+  SequenceRecorder() : running_(false), overlapped_(false) {}
+
+  void Record(int index) {
+    {
+      AutoLock locked(lock_);
+      if (running_)
+        overlapped_ = true;
+      running_ = true;
+    }
+    // Give a concurrent task the chance to show up.
+    PlatformThread::YieldCurrentThread();
+    {
+      AutoLock locked(lock_);
+      order_.push_back(index);
+      running_ = false;
+    }
+  }
+
+  std::vector<int> order() {
+    AutoLock locked(lock_);
+    return order_;
+  }
+
+  bool overlapped() {
+    AutoLock locked(lock_);
+    return overlapped_;
+  }
+
+ private:
+  Lock lock_;
+  bool running_;
+  bool overlapped_;
+  std::vector<int> order_;
+};
+
+class RecordTask : public Task {
+ public:
+  RecordTask(SequenceRecorder* recorder, int index)
+      : recorder_(recorder), index_(index) {}
+
+  virtual void Run() {
+    recorder_->Record(index_);
+  }
+
+ private:
+  SequenceRecorder* recorder_;
+  int index_;
+};
+
+class SignalTask : public Task {
+ public:
+  explicit SignalTask(WaitableEvent* event) : event_(event) {}
+
+  virtual void Run() {
+    event_->Signal();
+  }
+
+ private:
+  WaitableEvent* event_;
+};
+
+class CheckCurrentThreadTask : public Task {
+ public:
+  CheckCurrentThreadTask(WorkerPoolSequence* sequence, bool* result)
+      : sequence_(sequence), result_(result) {}
+
+  virtual void Run() {
+    *result_ = sequence_->RunsTasksOnCurrentThread();
+  }
+
+ private:
+  WorkerPoolSequence* sequence_;
+  bool* result_;
+};
+
+}  // namespace
+
+TEST(WorkerPoolSequenceTest, RunsTasksInOrderOneAtATime) {
+  const int kNumTasks = 100;
+  const int kNumSequences = 3;
+
+  scoped_refptr<WorkerPoolSequence> sequences[kNumSequences];
+  SequenceRecorder recorders[kNumSequences];
+  for (int i = 0; i < kNumSequences; ++i)
+    sequences[i] = new WorkerPoolSequence(false);
+
+  // Interleave the sequences, so that they run in parallel.
+  for (int task = 0; task < kNumTasks; ++task) {
+    for (int i = 0; i < kNumSequences; ++i) {
+      EXPECT_TRUE(sequences[i]->PostTask(FROM_HERE,
+                                         new RecordTask(&recorders[i], task)));
+    }
+  }
+
+  for (int i = 0; i < kNumSequences; ++i) {
+    WaitableEvent done(false, false);
+    EXPECT_TRUE(sequences[i]->PostTask(FROM_HERE, new SignalTask(&done)));
+    EXPECT_TRUE(done.Wait());
+
+    std::vector<int> order = recorders[i].order();
+    ASSERT_EQ(static_cast<size_t>(kNumTasks), order.size());
+    for (int task = 0; task < kNumTasks; ++task)
+      EXPECT_EQ(task, order[task]);
+    EXPECT_FALSE(recorders[i].overlapped());
+  }
+}
+
+TEST(WorkerPoolSequenceTest, RunsTasksOnCurrentThread) {
+  scoped_refptr<WorkerPoolSequence> sequence(new WorkerPoolSequence(false));
+  EXPECT_FALSE(sequence->RunsTasksOnCurrentThread());
+
+  bool runs_tasks_on_current_thread = false;
+  sequence->PostTask(FROM_HERE,
+                     new CheckCurrentThreadTask(sequence.get(),
+                                                &runs_tasks_on_current_thread));
+  WaitableEvent done(false, false);
+  sequence->PostTask(FROM_HERE, new SignalTask(&done));
+  EXPECT_TRUE(done.Wait());
+  EXPECT_TRUE(runs_tasks_on_current_thread);
+}
+
+}  // namespace base
@@ -16,13 +16,29 @@ void BaseTimer_Helper::OrphanDelayedTask() {
 }
 
 void BaseTimer_Helper::InitiateDelayedTask(TimerTask* timer_task) {
+  timer_task->desired_run_time_ = TimeTicks::Now() + timer_task->delay_;
+  PostDelayedTask(timer_task, timer_task->delay_);
+}
+
+void BaseTimer_Helper::PostDelayedTask(TimerTask* timer_task,
+                                       TimeDelta delay) {
   OrphanDelayedTask();
 
   delayed_task_ = timer_task;
   delayed_task_->timer_ = this;
+  delayed_task_->scheduled_run_time_ = TimeTicks::Now() + delay;
   MessageLoop::current()->PostDelayedTask(
       FROM_HERE, timer_task,
-      static_cast<int>(timer_task->delay_.InMillisecondsRoundedUp()));
+      static_cast<int>(delay.InMillisecondsRoundedUp()));
+}
+
+bool BaseTimer_Helper::PostponeDelayedTask() {
+  DCHECK(delayed_task_);
+  const TimeTicks desired_run_time = TimeTicks::Now() + delayed_task_->delay_;
+  if (desired_run_time < delayed_task_->scheduled_run_time_)
+    return false;
+  delayed_task_->desired_run_time_ = desired_run_time;
+  return true;
 }
 
 }  // namespace base
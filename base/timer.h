@@ -37,6 +37,12 @@
 // calling Reset on timer_ would postpone DoStuff by another 1 second.  In
 // other words, Reset is shorthand for calling Stop and then Start again with
 // the same arguments.
+//
+// Reset does not post a new task while the pending one is due no later than
+// the new deadline.  The pending task instead notices that the deadline moved
+// when it runs, and posts a task for the remaining time, so that a timer that
+// is reset on every bit of activity (e.g. an idle timeout) does not leave a
+// trail of dead tasks in the MessageLoop.
 
 #ifndef BASE_TIMER_H_
 #define BASE_TIMER_H_
@@ -92,6 +98,11 @@ class BASE_API BaseTimer_Helper {
     virtual ~TimerTask() {}
     BaseTimer_Helper* timer_;
     TimeDelta delay_;
+    // When the MessageLoop will run this task.
+    TimeTicks scheduled_run_time_;
+    // When the timer should fire, which Reset() may have moved past
+    // |scheduled_run_time_|.
+    TimeTicks desired_run_time_;
   };
 
   // Used to orphan delayed_task_ so that when it runs it does nothing.
@@ -101,6 +112,15 @@ class BASE_API BaseTimer_Helper {
   // orphaning delayed_task_ if it is non-null.
   void InitiateDelayedTask(TimerTask* timer_task);
 
+  // Like InitiateDelayedTask(), but posts |timer_task| to run after |delay|
+  // rather than its own delay, leaving its |desired_run_time_| alone.
+  void PostDelayedTask(TimerTask* timer_task, TimeDelta delay);
+
+  // Moves the deadline of delayed_task_ to its delay from now.  Returns false,
+  // doing nothing, if that is earlier than the task is due to run, in which
+  // case a new task is needed.
+  bool PostponeDelayedTask();
+
   TimerTask* delayed_task_;
 
   DISALLOW_COPY_AND_ASSIGN(BaseTimer_Helper);
@@ -130,7 +150,8 @@ class BaseTimer : public BaseTimer_Helper {
   // Call this method to reset the timer delay of an already running timer.
   void Reset() {
     DCHECK(IsRunning());
-    InitiateDelayedTask(static_cast<TimerTask*>(delayed_task_)->Clone());
+    if (!PostponeDelayedTask())
+      InitiateDelayedTask(static_cast<TimerTask*>(delayed_task_)->Clone());
   }
 
  private:
@@ -154,6 +175,16 @@ class BaseTimer : public BaseTimer_Helper {
     virtual void Run() {
       if (!timer_)  // timer_ is null if we were orphaned.
         return;
+      // If the timer was reset after we were posted, wait out the rest of the
+      // delay with a new task; posting it orphans this one.
+      const TimeTicks now = TimeTicks::Now();
+      if (now < desired_run_time_) {
+        TimerTask* rest = Clone();
+        rest->desired_run_time_ = desired_run_time_;
+        static_cast<SelfType*>(timer_)->PostDelayedTask(
+            rest, desired_run_time_ - now);
+        return;
+      }
       if (kIsRepeating)
         ResetBaseTimer();
       else
@@ -182,12 +213,13 @@ class BaseTimer : public BaseTimer_Helper {
       }
     }
 
-    // Inform the Base that we're resetting the timer.
+    // Inform the Base that we're resetting the timer.  This always posts a
+    // new task, since this one is done.
     void ResetBaseTimer() {
       DCHECK(timer_);
       DCHECK(kIsRepeating);
       SelfType* self = static_cast<SelfType*>(timer_);
-      self->Reset();
+      self->InitiateDelayedTask(Clone());
     }
 
     Receiver* receiver_;
@@ -108,6 +108,61 @@ void RunTest_OneShotTimer_Cancel(MessageLoop::Type message_loop_type) {
   EXPECT_TRUE(did_run_b);
 }
 
+// Resets a one shot timer every few milliseconds for a while, then records
+// when it finally fires.
+class OneShotResetTester {
+ public:
+  OneShotResetTester() : resets_left_(10), fire_count_(0) {}
+
+  void Start() {
+    timer_.Start(TimeDelta::FromMilliseconds(30), this,
+                 &OneShotResetTester::Fire);
+    resetter_.Start(TimeDelta::FromMilliseconds(5), this,
+                    &OneShotResetTester::ResetTimer);
+  }
+
+  int fire_count() const { return fire_count_; }
+  base::TimeTicks last_reset_time() const { return last_reset_time_; }
+  base::TimeTicks fire_time() const { return fire_time_; }
+
+ private:
+  void ResetTimer() {
+    ASSERT_TRUE(timer_.IsRunning());
+    timer_.Reset();
+    last_reset_time_ = base::TimeTicks::Now();
+    if (--resets_left_ == 0)
+      resetter_.Stop();
+  }
+
+  void Fire() {
+    ++fire_count_;
+    fire_time_ = base::TimeTicks::Now();
+    MessageLoop::current()->Quit();
+  }
+
+  int resets_left_;
+  int fire_count_;
+  base::TimeTicks last_reset_time_;
+  base::TimeTicks fire_time_;
+  base::OneShotTimer<OneShotResetTester> timer_;
+  base::RepeatingTimer<OneShotResetTester> resetter_;
+};
+
+void RunTest_OneShotTimer_Reset(MessageLoop::Type message_loop_type) {
+  MessageLoop loop(message_loop_type);
+
+  OneShotResetTester tester;
+  tester.Start();
+  MessageLoop::current()->Run();
+
+  // Resets postpone the task that was already posted instead of posting new
+  // ones; it must still fire once, and not before the delay has passed since
+  // the last reset.
+  EXPECT_EQ(1, tester.fire_count());
+  EXPECT_GE((tester.fire_time() - tester.last_reset_time()).InMilliseconds(),
+            30);
+}
+
 void RunTest_OneShotSelfDeletingTimer(MessageLoop::Type message_loop_type) {
   MessageLoop loop(message_loop_type);
 
@@ -288,6 +343,12 @@ TEST(TimerTest, OneShotTimer_Cancel) {
   RunTest_OneShotTimer_Cancel(MessageLoop::TYPE_IO);
 }
 
+TEST(TimerTest, OneShotTimer_Reset) {
+  RunTest_OneShotTimer_Reset(MessageLoop::TYPE_DEFAULT);
+  RunTest_OneShotTimer_Reset(MessageLoop::TYPE_UI);
+  RunTest_OneShotTimer_Reset(MessageLoop::TYPE_IO);
+}
+
 // If underline timer does not handle properly, we will crash or fail
 // in full page heap or purify environment.
 TEST(TimerTest, OneShotSelfDeletingTimer) {
@@ -79,7 +79,15 @@ Tracked::Tracked()
       tracked_birth_time_(TimeTicks::Now()) {
   if (!ThreadData::IsActive())
     return;
-  SetBirthPlace(Location("NoFunctionName", "NeedToSetBirthPlace", -1));
+  ThreadData* current_thread_data = ThreadData::current();
+  if (!current_thread_data)
+    return;  // Shutdown started, and this thread wasn't registered.
+  // Whether the instance is sampled is decided once, here.  Instances that
+  // aren't keep a NULL tracked_births_, and are ignored from then on.
+  if (!current_thread_data->ShouldTrackNextBirth())
+    return;
+  tracked_births_ = current_thread_data->TallyABirth(
+      Location("NoFunctionName", "NeedToSetBirthPlace", -1));
 }
 
 Tracked::~Tracked() {
@@ -90,10 +98,9 @@ Tracked::~Tracked() {
 }
 
 void Tracked::SetBirthPlace(const Location& from_here) {
-  if (!ThreadData::IsActive())
+  if (!ThreadData::IsActive() || !tracked_births_)
     return;
-  if (tracked_births_)
-    tracked_births_->ForgetBirth();
+  tracked_births_->ForgetBirth();
   ThreadData* current_thread_data = ThreadData::current();
   if (!current_thread_data)
     return;  // Shutdown started, and this thread wasn't registered.
@@ -101,6 +108,8 @@ void Tracked::SetBirthPlace(const Location& from_here) {
 }
 
 const Location Tracked::GetBirthPlace() const {
+  if (!tracked_births_)
+    return Location("NoFunctionName", "NotSampled", -1);
   return tracked_births_->location();
 }
 
@@ -109,7 +118,7 @@ void Tracked::ResetBirthTime() {
 }
 
 bool Tracked::MissingBirthplace() const {
-  return -1 == tracked_births_->location().line_number();
+  return tracked_births_ && -1 == tracked_births_->location().line_number();
 }
 
 #endif  // NDEBUG
@@ -90,7 +90,10 @@ base::Lock ThreadData::list_lock_;
 // static
 ThreadData::Status ThreadData::status_ = ThreadData::UNINITIALIZED;
 
-ThreadData::ThreadData() : next_(NULL) {
+// static
+int ThreadData::sampling_interval_ = 1;
+
+ThreadData::ThreadData() : next_(NULL), births_until_sample_(1) {
   // This shouldn't use the MessageLoop::current() LazyInstance since this might
   // be used on a non-joinable thread.
   // http://crbug.com/62728
@@ -168,6 +171,10 @@ void ThreadData::WriteHTML(const std::string& query, std::string* output) {
   if (!escaped_query.empty())
     output->append(" - " + escaped_query);
   output->append("</title></head><body><pre>");
+  if (sampling_interval_ > 1) {
+    base::StringAppendF(output, "Tracking 1 in %d tasks.\n\n",
+                        sampling_interval_);
+  }
 
   DataCollector collected_data;  // Gather data.
   collected_data.AddListOfLivingObjects();  // Add births that are still alive.
@@ -478,6 +485,12 @@ bool ThreadData::IsActive() {
   return status_ == ACTIVE;
 }
 
+// static
+void ThreadData::SetSamplingInterval(int interval) {
+  DCHECK_GE(interval, 1);
+  sampling_interval_ = interval;
+}
+
 #ifdef OS_WIN
 // static
 void ThreadData::ShutdownMultiThreadTracking() {
@@ -139,6 +139,13 @@
 // that set? etc.).  Aggregation instances collect running sums of any set of
 // snapshot instances, and are used to print sub-totals in an about:tasks page.
 //
+// Tracking every instance costs two map lookups per task, which is too much
+// to leave on in release builds.  ThreadData::SetSamplingInterval() makes each
+// thread track only one in N of the instances born on it; the others carry no
+// Births pointer, and cost a thread local lookup and a decrement.  The counts
+// then shown on about:tasks are those of the sampled instances, and the
+// durations are unbiased.
+//
 // TODO(jar): I need to store DataCollections, and provide facilities for taking
 // the difference between two gathered DataCollections.  For now, I'm just
 // adding a hack that Reset()'s to zero all counts and stats.  This is also
@@ -489,6 +496,15 @@ class BASE_API ThreadData {
       const DataCollector::Collection& match_array,
       const Comparator& comparator, std::string* output);
 
+  // Returns whether the next instance born on this thread is one of the
+  // sampled ones that should be tracked.  Only called on this thread.
+  bool ShouldTrackNextBirth() {
+    if (--births_until_sample_ > 0)
+      return false;
+    births_until_sample_ = sampling_interval_;
+    return true;
+  }
+
   // In this thread's data, record a new birth.
   Births* TallyABirth(const Location& location);
 
@@ -530,6 +546,13 @@ class BASE_API ThreadData {
   static bool StartTracking(bool status);
   static bool IsActive();
 
+  // Tracks one in |interval| instances on each thread from now on, or all of
+  // them if |interval| is 1, the default.  Meant to be called at startup;
+  // threads that are already tracking pick up the new interval after their
+  // next sample.
+  static void SetSamplingInterval(int interval);
+  static int sampling_interval() { return sampling_interval_; }
+
 #ifdef OS_WIN
   // WARNING: ONLY call this function when all MessageLoops are still intact for
   // all registered threads.  IF you call it later, you will crash.
@@ -585,6 +608,9 @@ class BASE_API ThreadData {
   // and avoid additional calls into the  service.
   static Status status_;
 
+  // One in this many births on each thread are tracked.
+  static int sampling_interval_;
+
   // Link to next instance (null terminated list). Used to globally track all
   // registered instances (corresponds to all registered threads where we keep
   // data).
@@ -595,6 +621,9 @@ class BASE_API ThreadData {
   // instances have data that can't be (safely) modified externally.
   MessageLoop* message_loop_;
 
+  // Counts down the births until the next one that is tracked.
+  int births_until_sample_;
+
   // A map used on each thread to keep track of Births on this thread.
   // This map should only be accessed on the thread it was constructed on.
   // When a snapshot is needed, this structure can be locked in place for the
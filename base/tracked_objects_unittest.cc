@@ -93,4 +93,28 @@ TEST_F(TrackedObjectsTest, TinyStartupShutdown) {
   ThreadData::ShutdownSingleThreadedCleanup();
 }
 
+TEST_F(TrackedObjectsTest, Sampling) {
+  if (!ThreadData::StartTracking(true))
+    return;
+  ThreadData::SetSamplingInterval(3);
+
+  // The first birth is sampled, then one in three.
+  for (int i = 0; i < 9; ++i)
+    delete new NoopTracked;
+
+  const ThreadData* data = ThreadData::first();
+  ASSERT_TRUE(data);
+  ThreadData::BirthMap birth_map;
+  data->SnapshotBirthMap(&birth_map);
+  EXPECT_EQ(1u, birth_map.size());
+  EXPECT_EQ(3, birth_map.begin()->second->birth_count());
+  ThreadData::DeathMap death_map;
+  data->SnapshotDeathMap(&death_map);
+  EXPECT_EQ(1u, death_map.size());
+  EXPECT_EQ(3, death_map.begin()->second.count());
+
+  ThreadData::SetSamplingInterval(1);
+  ThreadData::ShutdownSingleThreadedCleanup();
+}
+
 }  // namespace tracked_objects
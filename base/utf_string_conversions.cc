@@ -4,6 +4,8 @@
 
 #include "base/utf_string_conversions.h"
 
+#include <string.h>
+
 #include "base/string_piece.h"
 #include "base/string_util.h"
 #include "base/utf_string_conversion_utils.h"
@@ -15,6 +17,55 @@ using base::WriteUnicodeCharacter;
 
 namespace {
 
+// ASCII runs ------------------------------------------------------------------
+
+// ASCII is the same in every one of the encodings, so runs of it are copied
+// rather than decoded and encoded again.  The runs are found a machine word of
+// characters at a time.
+typedef uintptr_t MachineWord;
+
+// The bits of a word of characters of |Size| bytes that are only set if one of
+// them is not ASCII.  The constants are truncated on 32-bit platforms, which
+// leaves the same pattern.
+template<size_t Size> struct NonASCIIMask;
+template<> struct NonASCIIMask<1> {
+  static MachineWord value() {
+    return static_cast<MachineWord>(GG_UINT64_C(0x8080808080808080));
+  }
+};
+template<> struct NonASCIIMask<2> {
+  static MachineWord value() {
+    return static_cast<MachineWord>(GG_UINT64_C(0xFF80FF80FF80FF80));
+  }
+};
+template<> struct NonASCIIMask<4> {
+  static MachineWord value() {
+    return static_cast<MachineWord>(GG_UINT64_C(0xFFFFFF80FFFFFF80));
+  }
+};
+
+template<typename CHAR>
+inline bool IsASCIIChar(CHAR c) {
+  return static_cast<typename ToUnsigned<CHAR>::Unsigned>(c) < 0x80;
+}
+
+// Returns how many of the |src_len| characters at |src| are ASCII before the
+// first one that isn't.
+template<typename CHAR>
+int32 ASCIIPrefixLength(const CHAR* src, int32 src_len) {
+  const int32 chars_per_word = sizeof(MachineWord) / sizeof(CHAR);
+  int32 i = 0;
+  for (; src_len - i >= chars_per_word; i += chars_per_word) {
+    MachineWord word;
+    memcpy(&word, src + i, sizeof(word));
+    if (word & NonASCIIMask<sizeof(CHAR)>::value())
+      break;
+  }
+  while (i < src_len && IsASCIIChar(src[i]))
+    i++;
+  return i;
+}
+
 // Generalized Unicode converter -----------------------------------------------
 
 // Converts the given source Unicode character type to the given destination
@@ -29,6 +80,12 @@ bool ConvertUnicode(const SRC_CHAR* src,
   bool success = true;
   int32 src_len32 = static_cast<int32>(src_len);
   for (int32 i = 0; i < src_len32; i++) {
+    if (IsASCIIChar(src[i])) {
+      int32 ascii_length = ASCIIPrefixLength(src + i, src_len32 - i);
+      output->append(src + i, src + i + ascii_length);
+      i += ascii_length - 1;
+      continue;
+    }
     uint32 code_point;
     if (ReadUnicodeCharacter(src, src_len32, &i, &code_point)) {
       WriteUnicodeCharacter(code_point, output);
@@ -208,4 +208,35 @@ TEST(UTFStringConversionsTest, ConvertMultiString) {
   EXPECT_EQ(expected, converted);
 }
 
+// Runs of ASCII are copied a word at a time; check that the characters
+// around them convert the same wherever the runs start and end.
+TEST(UTFStringConversionsTest, ConvertASCIIRuns) {
+  for (size_t before = 0; before < 20; ++before) {
+    for (size_t after = 0; after < 20; after += 3) {
+      std::string utf8(before, 'a');
+      utf8.append("\xc3\xa9");  // U+00E9 LATIN SMALL LETTER E WITH ACUTE.
+      utf8.append(after, 'b');
+      utf8.append("\xf0\x90\x8c\x80");  // U+10300 OLD ITALIC LETTER A.
+      utf8.append(before, '\x7f');
+
+      string16 utf16(before, 'a');
+      utf16.push_back(0xE9);
+      utf16.append(after, 'b');
+      utf16.push_back(0xD800);
+      utf16.push_back(0xDF00);
+      utf16.append(before, 0x7F);
+
+      EXPECT_EQ(utf16, UTF8ToUTF16(utf8)) << before << " " << after;
+      EXPECT_EQ(utf8, UTF16ToUTF8(utf16)) << before << " " << after;
+      EXPECT_EQ(utf8, WideToUTF8(UTF8ToWide(utf8))) << before << " " << after;
+    }
+  }
+
+  // Invalid characters after a run are still replaced.
+  string16 converted;
+  EXPECT_FALSE(UTF8ToUTF16("abcdefghij\xffklmnopq", 18, &converted));
+  EXPECT_EQ(ASCIIToUTF16("abcdefghij") + string16(1, 0xFFFD) +
+            ASCIIToUTF16("klmnopq"), converted);
+}
+
 }  // base
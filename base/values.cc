@@ -4,6 +4,8 @@
 
 #include "base/values.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/string_util.h"
 #include "base/utf_string_conversions.h"
@@ -57,6 +59,14 @@ Value* CopyWithoutEmptyChildren(Value* node) {
   }
 }
 
+// Orders the entries of a ValueMap by key.
+struct EntryKeyLess {
+  bool operator()(const ValueMap::value_type& entry,
+                  const std::string& key) const {
+    return entry.first < key;
+  }
+};
+
 }  // namespace
 
 ///////////////////// Value ////////////////////
@@ -308,6 +318,58 @@ BinaryValue::BinaryValue(char* buffer, size_t size)
   DCHECK(buffer_);
 }
 
+///////////////////// ValueMap ////////////////////
+
+ValueMap::ValueMap() {
+}
+
+ValueMap::~ValueMap() {
+}
+
+ValueMap::iterator ValueMap::find(const std::string& key) {
+  iterator it = std::lower_bound(entries_.begin(), entries_.end(), key,
+                                 EntryKeyLess());
+  return (it != entries_.end() && it->first == key) ? it : entries_.end();
+}
+
+ValueMap::const_iterator ValueMap::find(const std::string& key) const {
+  const_iterator it = std::lower_bound(entries_.begin(), entries_.end(), key,
+                                       EntryKeyLess());
+  return (it != entries_.end() && it->first == key) ? it : entries_.end();
+}
+
+Value*& ValueMap::operator[](const std::string& key) {
+  // Keys added in order, the common case, go at the end.
+  size_t index = entries_.size();
+  if (!entries_.empty() && !(entries_.back().first < key)) {
+    iterator it = std::lower_bound(entries_.begin(), entries_.end(), key,
+                                   EntryKeyLess());
+    if (it->first == key)
+      return it->second;
+    index = it - entries_.begin();
+  }
+
+  // Make room at |index| by swapping the entries after it one place up,
+  // which doesn't copy their keys.
+  entries_.push_back(value_type());
+  for (size_t i = entries_.size() - 1; i > index; --i) {
+    entries_[i].first.swap(entries_[i - 1].first);
+    entries_[i].second = entries_[i - 1].second;
+  }
+  entries_[index].first = key;
+  entries_[index].second = NULL;
+  return entries_[index].second;
+}
+
+void ValueMap::erase(iterator position) {
+  for (iterator next = position + 1; next != entries_.end();
+       ++position, ++next) {
+    position->first.swap(next->first);
+    position->second = next->second;
+  }
+  entries_.pop_back();
+}
+
 ///////////////////// DictionaryValue ////////////////////
 
 DictionaryValue::DictionaryValue()
@@ -385,12 +447,10 @@ void DictionaryValue::SetWithoutPathExpansion(const std::string& key,
                                               Value* in_value) {
   // If there's an existing value here, we need to delete it, because
   // we own all our children.
-  if (HasKey(key)) {
-    DCHECK(dictionary_[key] != in_value);  // This would be bogus
-    delete dictionary_[key];
-  }
-
-  dictionary_[key] = in_value;
+  Value*& entry = dictionary_[key];
+  DCHECK(entry != in_value);  // This would be bogus
+  delete entry;
+  entry = in_value;
 }
 
 bool DictionaryValue::Get(const std::string& path, Value** out_value) const {
@@ -648,6 +708,7 @@ void DictionaryValue::MergeDictionary(const DictionaryValue* dictionary) {
 
 DictionaryValue* DictionaryValue::DeepCopy() const {
   DictionaryValue* result = new DictionaryValue;
+  result->dictionary_.reserve(dictionary_.size());
 
   for (ValueMap::const_iterator current_entry(dictionary_.begin());
        current_entry != dictionary_.end(); ++current_entry) {
@@ -25,6 +25,7 @@
 #include <iterator>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/base_api.h"
@@ -40,7 +41,43 @@ class StringValue;
 class Value;
 
 typedef std::vector<Value*> ValueVector;
-typedef std::map<std::string, Value*> ValueMap;
+
+// The storage of a DictionaryValue: the subset of std::map<std::string,
+// Value*> it needs, as a vector of entries sorted by key.  Dictionaries are
+// mostly small and mostly built in key order, e.g. by copying or parsing, so
+// keeping the entries together saves an allocation per key and makes lookups
+// and iteration touch less memory.  Adding or removing a key moves the
+// entries after it.
+class BASE_API ValueMap {
+ public:
+  typedef std::pair<std::string, Value*> value_type;
+  typedef std::vector<value_type>::iterator iterator;
+  typedef std::vector<value_type>::const_iterator const_iterator;
+
+  ValueMap();
+  ~ValueMap();
+
+  iterator begin() { return entries_.begin(); }
+  iterator end() { return entries_.end(); }
+  const_iterator begin() const { return entries_.begin(); }
+  const_iterator end() const { return entries_.end(); }
+
+  size_t size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+  void clear() { entries_.clear(); }
+  void reserve(size_t size) { entries_.reserve(size); }
+
+  iterator find(const std::string& key);
+  const_iterator find(const std::string& key) const;
+
+  // Returns the value for |key|, adding a NULL one if there is none.
+  Value*& operator[](const std::string& key);
+
+  void erase(iterator position);
+
+ private:
+  std::vector<value_type> entries_;
+};
 
 // The Value class is the base class for Values.  A Value can be
 // instantiated via the Create*Value() factory methods, or by directly
@@ -157,6 +194,9 @@ class BASE_API StringValue : public Value {
 
   virtual ~StringValue();
 
+  // Returns the string, without the copy GetAsString() makes.
+  const std::string& GetString() const { return value_; }
+
   // Subclassed methods
   virtual bool GetAsString(std::string* out_value) const;
   virtual bool GetAsString(string16* out_value) const;
@@ -686,3 +686,44 @@ TEST_F(ValuesTest, MergeDictionary) {
   EXPECT_TRUE(res_sub_dict->GetString("sub_merge_key", &sub_merge_key_value));
   EXPECT_EQ("sub_merge_key_value_merge", sub_merge_key_value); // Merged in.
 }
+
+// Check that keys stay sorted and findable however they are added and
+// removed.
+TEST_F(ValuesTest, DictionaryKeyOrder) {
+  const char* const kKeys[] = { "m", "c", "x", "a", "q", "b", "z", "n" };
+  DictionaryValue dict;
+  for (size_t i = 0; i < arraysize(kKeys); ++i) {
+    dict.SetWithoutPathExpansion(
+        kKeys[i], Value::CreateIntegerValue(static_cast<int>(i)));
+  }
+  // Replacing keeps a single entry.
+  dict.SetWithoutPathExpansion("q", Value::CreateStringValue("replaced"));
+  EXPECT_EQ(arraysize(kKeys), dict.size());
+
+  for (size_t i = 0; i < arraysize(kKeys); ++i) {
+    Value* value = NULL;
+    ASSERT_TRUE(dict.GetWithoutPathExpansion(kKeys[i], &value)) << kKeys[i];
+    if (std::string(kKeys[i]) != "q") {
+      int integer = -1;
+      EXPECT_TRUE(value->GetAsInteger(&integer));
+      EXPECT_EQ(static_cast<int>(i), integer);
+    }
+  }
+
+  EXPECT_TRUE(dict.RemoveWithoutPathExpansion("c", NULL));
+  EXPECT_TRUE(dict.RemoveWithoutPathExpansion("z", NULL));
+  EXPECT_TRUE(dict.RemoveWithoutPathExpansion("a", NULL));
+  EXPECT_FALSE(dict.RemoveWithoutPathExpansion("c", NULL));
+
+  std::string keys;
+  for (DictionaryValue::key_iterator it = dict.begin_keys();
+       it != dict.end_keys(); ++it) {
+    keys += *it;
+  }
+  EXPECT_EQ("bmnqx", keys);
+
+  scoped_ptr<DictionaryValue> copy(dict.DeepCopy());
+  EXPECT_TRUE(dict.Equals(copy.get()));
+  EXPECT_FALSE(dict.HasKey("a"));
+  EXPECT_TRUE(copy->HasKey("x"));
+}
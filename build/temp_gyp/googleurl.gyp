@@ -106,6 +106,21 @@
         }],
       ],
     },
+    {
+      'target_name': 'googleurl_perftests',
+      'type': 'executable',
+      'dependencies': [
+        'googleurl',
+        '../../base/base.gyp:base',
+        '../../base/base.gyp:test_support_perf',
+        '../../testing/gtest.gyp:gtest',
+      ],
+      'sources': [
+        # Replaces operator new to count allocations, so this target must not
+        # depend on the allocator shim.
+        '../../googleurl/src/url_perftest.cc',
+      ],
+    },
   ],
 }
 
@@ -36,6 +36,9 @@
 
 namespace {
 const size_t kMaxFormCacheSize = 16;
+
+// How long a query waits for the page to add more forms.
+const int kQueryDelayMs = 250;
 };
 
 struct AutofillDownloadManager::FormRequestData {
@@ -52,7 +55,9 @@ const double kAutoFillNegativeUploadRateDefaultValue = 0.01;
 AutofillDownloadManager::AutofillDownloadManager(Profile* profile)
     : profile_(profile),
       observer_(NULL),
+      cached_forms_(QueryRequestCache::NO_AUTO_EVICT),
       max_form_cache_size_(kMaxFormCacheSize),
+      query_delay_(base::TimeDelta::FromMilliseconds(kQueryDelayMs)),
       next_query_request_(base::Time::Now()),
       next_upload_request_(base::Time::Now()),
       positive_upload_rate_(0),
@@ -105,6 +110,11 @@ bool AutofillDownloadManager::StartQueryRequest(
   request_data.request_type = AutofillDownloadManager::REQUEST_QUERY;
   metric_logger.Log(AutofillMetrics::QUERY_SENT);
 
+  // This query covers the forms of the one waiting, if any.
+  query_timer_.Stop();
+  pending_query_signatures_.clear();
+  pending_query_xml_.clear();
+
   std::string query_data;
   if (CheckCacheForQueryRequest(request_data.form_signatures, &query_data)) {
     VLOG(1) << "AutofillDownloadManager: query request has been retrieved from"
@@ -114,7 +124,14 @@ bool AutofillDownloadManager::StartQueryRequest(
     return true;
   }
 
-  return StartRequest(form_xml, request_data);
+  if (query_delay_ == base::TimeDelta())
+    return StartRequest(form_xml, request_data);
+
+  pending_query_xml_.swap(form_xml);
+  pending_query_signatures_.swap(request_data.form_signatures);
+  query_timer_.Start(query_delay_, this,
+                     &AutofillDownloadManager::StartPendingQuery);
+  return true;
 }
 
 bool AutofillDownloadManager::StartUploadRequest(
@@ -146,6 +163,16 @@ bool AutofillDownloadManager::StartUploadRequest(
 bool AutofillDownloadManager::CancelRequest(
     const std::string& form_signature,
     AutofillDownloadManager::AutofillRequestType request_type) {
+  if (request_type == AutofillDownloadManager::REQUEST_QUERY &&
+      std::find(pending_query_signatures_.begin(),
+                pending_query_signatures_.end(), form_signature) !=
+          pending_query_signatures_.end()) {
+    query_timer_.Stop();
+    pending_query_signatures_.clear();
+    pending_query_xml_.clear();
+    return true;
+  }
+
   for (std::map<URLFetcher *, FormRequestData>::iterator it =
        url_fetchers_.begin();
        it != url_fetchers_.end();
@@ -247,41 +274,36 @@ bool AutofillDownloadManager::StartRequest(
   return true;
 }
 
+void AutofillDownloadManager::StartPendingQuery() {
+  FormRequestData request_data;
+  request_data.form_signatures.swap(pending_query_signatures_);
+  request_data.request_type = AutofillDownloadManager::REQUEST_QUERY;
+  std::string form_xml;
+  form_xml.swap(pending_query_xml_);
+  StartRequest(form_xml, request_data);
+}
+
 void AutofillDownloadManager::CacheQueryRequest(
     const std::vector<std::string>& forms_in_query,
     const std::string& query_data) {
   std::string signature = GetCombinedSignature(forms_in_query);
-  for (QueryRequestCache::iterator it = cached_forms_.begin();
-       it != cached_forms_.end(); ++it) {
-    if (it->first == signature) {
-      // We hit the cache, move to the first position and return.
-      std::pair<std::string, std::string> data = *it;
-      cached_forms_.erase(it);
-      cached_forms_.push_front(data);
-      return;
-    }
-  }
-  std::pair<std::string, std::string> data;
-  data.first = signature;
-  data.second = query_data;
-  cached_forms_.push_front(data);
-  while (cached_forms_.size() > max_form_cache_size_)
-    cached_forms_.pop_back();
+  // If we hit the cache, only move the entry to the first position.
+  if (cached_forms_.Get(signature) != cached_forms_.end())
+    return;
+  cached_forms_.Put(signature, query_data);
+  cached_forms_.ShrinkToSize(max_form_cache_size_);
 }
 
 bool AutofillDownloadManager::CheckCacheForQueryRequest(
     const std::vector<std::string>& forms_in_query,
     std::string* query_data) const {
-  std::string signature = GetCombinedSignature(forms_in_query);
-  for (QueryRequestCache::const_iterator it = cached_forms_.begin();
-       it != cached_forms_.end(); ++it) {
-    if (it->first == signature) {
-      // We hit the cache, fill the data and return.
-      *query_data = it->second;
-      return true;
-    }
-  }
-  return false;
+  QueryRequestCache::const_iterator it =
+      cached_forms_.Peek(GetCombinedSignature(forms_in_query));
+  if (it == cached_forms_.end())
+    return false;
+  // We hit the cache, fill the data and return.
+  *query_data = it->second;
+  return true;
 }
 
 std::string AutofillDownloadManager::GetCombinedSignature(
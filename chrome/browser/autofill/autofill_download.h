@@ -7,7 +7,6 @@
 #pragma once
 
 #include <stddef.h>
-#include <list>
 #include <map>
 #include <string>
 #include <utility>
@@ -15,7 +14,9 @@
 
 #include "base/memory/scoped_vector.h"
 #include "base/time.h"
+#include "base/timer.h"
 #include "chrome/common/net/url_fetcher.h"
+#include "content/common/mru_cache.h"
 
 #ifdef ANDROID
 #include "android/autofill/url_fetcher_proxy.h"
@@ -70,8 +71,11 @@ class AutofillDownloadManager : public URLFetcher::Delegate {
   void SetObserver(AutofillDownloadManager::Observer *observer);
 
   // Starts a query request to Autofill servers. The observer is called with the
-  // list of the fields of all requested forms.
-  // |forms| - array of forms aggregated in this request.
+  // list of the fields of all requested forms. The request is sent after a
+  // short delay, and a later query made in the meantime replaces it, so that
+  // a page adding its forms one by one makes only one trip over the wire.
+  // |forms| - array of forms aggregated in this request, which should include
+  // the forms of the earlier queries from the same page.
   bool StartQueryRequest(const ScopedVector<FormStructure>& forms,
                          const AutofillMetrics& metric_logger);
 
@@ -107,7 +111,7 @@ class AutofillDownloadManager : public URLFetcher::Delegate {
   friend class AutofillDownloadTestHelper;  // unit-test.
 
   struct FormRequestData;
-  typedef std::list<std::pair<std::string, std::string> > QueryRequestCache;
+  typedef MRUCache<std::string, std::string> QueryRequestCache;
 
   // Initiates request to Autofill servers to download/upload heuristics.
   // |form_xml| - form structure XML to upload/download.
@@ -119,12 +123,21 @@ class AutofillDownloadManager : public URLFetcher::Delegate {
                     const FormRequestData& request_data);
 
   // Each request is page visited. We store last |max_form_cache_size|
-  // request, to avoid going over the wire. Set to 16 in constructor. Warning:
-  // the search is linear (newest first), so do not make the constant very big.
+  // request, to avoid going over the wire. Set to 16 in constructor.
   void set_max_form_cache_size(size_t max_form_cache_size) {
     max_form_cache_size_ = max_form_cache_size;
+    cached_forms_.ShrinkToSize(max_form_cache_size_);
   }
 
+  // How long a query waits for a later one to replace it. Zero sends queries
+  // right away.
+  void set_query_delay(base::TimeDelta query_delay) {
+    query_delay_ = query_delay;
+  }
+
+  // Sends the query waiting for |query_timer_|.
+  void StartPendingQuery();
+
   // Caches query request. |forms_in_query| is a vector of form signatures in
   // the query. |query_data| is the successful data returned over the wire.
   void CacheQueryRequest(const std::vector<std::string>& forms_in_query,
@@ -154,10 +167,16 @@ class AutofillDownloadManager : public URLFetcher::Delegate {
   std::map<URLFetcher*, FormRequestData> url_fetchers_;
   AutofillDownloadManager::Observer *observer_;
 
-  // Cached QUERY requests.
+  // Cached QUERY requests, by their combined signature.
   QueryRequestCache cached_forms_;
   size_t max_form_cache_size_;
 
+  // The query waiting to be sent, as the XML to send and its form signatures.
+  std::string pending_query_xml_;
+  std::vector<std::string> pending_query_signatures_;
+  base::TimeDelta query_delay_;
+  base::OneShotTimer<AutofillDownloadManager> query_timer_;
+
   // Time when next query/upload requests are allowed. If 50x HTTP received,
   // exponential back off is initiated, so this times will be in the future
   // for awhile.
@@ -52,6 +52,8 @@ class AutofillDownloadTestHelper : public AutofillDownloadManager::Observer {
       : download_manager(&profile),
         request_context_getter(new TestURLRequestContextGetter()) {
     download_manager.SetObserver(this);
+    // Send queries right away, unless a test asks otherwise.
+    download_manager.set_query_delay(base::TimeDelta());
   }
   ~AutofillDownloadTestHelper() {
     Profile::set_default_request_context(NULL);
@@ -66,6 +68,10 @@ class AutofillDownloadTestHelper : public AutofillDownloadManager::Observer {
     download_manager.set_max_form_cache_size(cache_size);
   }
 
+  void SetQueryDelay(base::TimeDelta query_delay) {
+    download_manager.set_query_delay(query_delay);
+  }
+
   // AutofillDownloadManager::Observer overridables:
   virtual void OnLoadedAutofillHeuristics(
       const std::string& heuristic_xml) {
@@ -534,3 +540,85 @@ TEST_F(AutofillDownloadTest, CacheQueryTest) {
   URLFetcher::set_factory(NULL);
 }
 
+TEST_F(AutofillDownloadTest, CoalesceQueryTest) {
+  MessageLoopForUI message_loop;
+  AutofillDownloadTestHelper helper;
+  // Create and register factory.
+  TestURLFetcherFactory factory;
+  URLFetcher::set_factory(&factory);
+  helper.InitContextGetter();
+  helper.SetQueryDelay(base::TimeDelta::FromMilliseconds(1));
+
+  FormData form;
+  form.method = ASCIIToUTF16("post");
+  form.fields.push_back(webkit_glue::FormField(ASCIIToUTF16("First Name"),
+                                               ASCIIToUTF16("firstname"),
+                                               string16(),
+                                               ASCIIToUTF16("text"),
+                                               0,
+                                               false));
+  form.fields.push_back(webkit_glue::FormField(ASCIIToUTF16("Last Name"),
+                                               ASCIIToUTF16("lastname"),
+                                               string16(),
+                                               ASCIIToUTF16("text"),
+                                               0,
+                                               false));
+  ScopedVector<FormStructure> form_structures0;
+  form_structures0.push_back(new FormStructure(form));
+
+  // The page then adds a form, and queries for both.
+  FormData form2(form);
+  form2.fields.push_back(webkit_glue::FormField(ASCIIToUTF16("email"),
+                                                ASCIIToUTF16("email"),
+                                                string16(),
+                                                ASCIIToUTF16("text"),
+                                                0,
+                                                false));
+  ScopedVector<FormStructure> form_structures1;
+  form_structures1.push_back(new FormStructure(form));
+  form_structures1.push_back(new FormStructure(form2));
+
+  MockAutofillMetrics mock_metric_logger;
+  EXPECT_CALL(mock_metric_logger, Log(AutofillMetrics::QUERY_SENT)).Times(3);
+  EXPECT_TRUE(helper.download_manager.StartQueryRequest(form_structures0,
+                                                        mock_metric_logger));
+  EXPECT_TRUE(helper.download_manager.StartQueryRequest(form_structures1,
+                                                        mock_metric_logger));
+  // Nothing is sent before the delay.
+  EXPECT_TRUE(factory.GetFetcherByID(0) == NULL);
+
+  MessageLoop::current()->PostDelayedTask(FROM_HERE,
+                                          new MessageLoop::QuitTask(),
+                                          TestTimeouts::tiny_timeout_ms());
+  MessageLoop::current()->Run();
+
+  // Only the second query went over the wire.
+  TestURLFetcher* fetcher = factory.GetFetcherByID(0);
+  ASSERT_TRUE(fetcher);
+  EXPECT_TRUE(factory.GetFetcherByID(1) == NULL);
+  const char kResponse[] =
+      "<autofillqueryresponse>"
+        "<field autofilltype=\"3\" />"
+        "<field autofilltype=\"5\" />"
+        "<field autofilltype=\"3\" />"
+        "<field autofilltype=\"5\" />"
+        "<field autofilltype=\"9\" />"
+      "</autofillqueryresponse>";
+  fetcher->delegate()->OnURLFetchComplete(fetcher, GURL(),
+                                          net::URLRequestStatus(),
+                                          200, ResponseCookies(),
+                                          std::string(kResponse));
+  ASSERT_EQ(static_cast<size_t>(1), helper.responses_.size());
+  EXPECT_EQ(kResponse, helper.responses_.front().response);
+  helper.responses_.clear();
+
+  // Its response was cached.
+  EXPECT_TRUE(helper.download_manager.StartQueryRequest(form_structures1,
+                                                        mock_metric_logger));
+  ASSERT_EQ(static_cast<size_t>(1), helper.responses_.size());
+  EXPECT_EQ(kResponse, helper.responses_.front().response);
+
+  // Make sure consumer of URLFetcher does the right thing.
+  URLFetcher::set_factory(NULL);
+}
+
@@ -842,27 +842,21 @@ void AutofillManager::GetProfileSuggestions(FormStructure* form,
                                             std::vector<string16>* labels,
                                             std::vector<string16>* icons,
                                             std::vector<int>* unique_ids) {
-  const std::vector<AutofillProfile*>& profiles = personal_data_->profiles();
   if (!field.is_autofilled) {
     std::vector<AutofillProfile*> matched_profiles;
-    for (std::vector<AutofillProfile*>::const_iterator iter = profiles.begin();
-         iter != profiles.end(); ++iter) {
-      AutofillProfile* profile = *iter;
+    std::vector<size_t> variants;
+    personal_data_->GetProfilesWithPrefix(type, field.value, &matched_profiles,
+                                          &variants);
+    for (size_t i = 0; i < matched_profiles.size(); ++i) {
+      AutofillProfile* profile = matched_profiles[i];
 
       // The value of the stored data for this field type in the |profile|.
       std::vector<string16> multi_values;
       profile->GetMultiInfo(type, &multi_values);
 
-      for (size_t i = 0; i < multi_values.size(); ++i) {
-        if (!multi_values[i].empty() &&
-            StartsWith(multi_values[i], field.value, false)) {
-          matched_profiles.push_back(profile);
-          values->push_back(multi_values[i]);
-          unique_ids->push_back(PackGUIDs(GUIDPair(std::string(), 0),
-                                          GUIDPair(profile->guid(), i)));
-          break;
-        }
-      }
+      values->push_back(multi_values[variants[i]]);
+      unique_ids->push_back(PackGUIDs(GUIDPair(std::string(), 0),
+                                      GUIDPair(profile->guid(), variants[i])));
     }
 
     std::vector<AutofillFieldType> form_fields;
@@ -882,6 +876,8 @@ void AutofillManager::GetProfileSuggestions(FormStructure* form,
     // No icons for profile suggestions.
     icons->resize(values->size());
   } else {
+    const std::vector<AutofillProfile*>& profiles =
+        personal_data_->profiles();
     for (std::vector<AutofillProfile*>::const_iterator iter = profiles.begin();
          iter != profiles.end(); ++iter) {
       AutofillProfile* profile = *iter;
@@ -922,33 +918,33 @@ void AutofillManager::GetCreditCardSuggestions(FormStructure* form,
                                                std::vector<string16>* labels,
                                                std::vector<string16>* icons,
                                                std::vector<int>* unique_ids) {
+  std::vector<CreditCard*> matched_credit_cards;
+  personal_data_->GetCreditCardsWithPrefix(type, field.value,
+                                           &matched_credit_cards);
   for (std::vector<CreditCard*>::const_iterator iter =
-           personal_data_->credit_cards().begin();
-       iter != personal_data_->credit_cards().end(); ++iter) {
+           matched_credit_cards.begin();
+       iter != matched_credit_cards.end(); ++iter) {
     CreditCard* credit_card = *iter;
 
     // The value of the stored data for this field type in the |credit_card|.
     string16 creditcard_field_value = credit_card->GetInfo(type);
-    if (!creditcard_field_value.empty() &&
-        StartsWith(creditcard_field_value, field.value, false)) {
-      if (type == CREDIT_CARD_NUMBER)
-        creditcard_field_value = credit_card->ObfuscatedNumber();
-
-      string16 label;
-      if (credit_card->number().empty()) {
-        // If there is no CC number, return name to show something.
-        label = credit_card->GetInfo(CREDIT_CARD_NAME);
-      } else {
-        label = kCreditCardPrefix;
-        label.append(credit_card->LastFourDigits());
-      }
+    if (type == CREDIT_CARD_NUMBER)
+      creditcard_field_value = credit_card->ObfuscatedNumber();
 
-      values->push_back(creditcard_field_value);
-      labels->push_back(label);
-      icons->push_back(UTF8ToUTF16(credit_card->type()));
-      unique_ids->push_back(PackGUIDs(GUIDPair(credit_card->guid(), 0),
-                                      GUIDPair(std::string(), 0)));
+    string16 label;
+    if (credit_card->number().empty()) {
+      // If there is no CC number, return name to show something.
+      label = credit_card->GetInfo(CREDIT_CARD_NAME);
+    } else {
+      label = kCreditCardPrefix;
+      label.append(credit_card->LastFourDigits());
     }
+
+    values->push_back(creditcard_field_value);
+    labels->push_back(label);
+    icons->push_back(UTF8ToUTF16(credit_card->type()));
+    unique_ids->push_back(PackGUIDs(GUIDPair(credit_card->guid(), 0),
+                                    GUIDPair(std::string(), 0)));
   }
 }
 
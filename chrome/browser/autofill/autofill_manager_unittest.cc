@@ -71,18 +71,22 @@ class TestPersonalDataManager : public PersonalDataManager {
 
   void AddProfile(AutofillProfile* profile) {
     web_profiles_->push_back(profile);
+    ClearPrefixIndices();
   }
 
   void AddCreditCard(CreditCard* credit_card) {
     credit_cards_->push_back(credit_card);
+    ClearPrefixIndices();
   }
 
   void ClearAutofillProfiles() {
     web_profiles_.reset();
+    ClearPrefixIndices();
   }
 
   void ClearCreditCards() {
     credit_cards_.reset();
+    ClearPrefixIndices();
   }
 
   void CreateTestCreditCardsYearAndMonth(const char* year, const char* month) {
@@ -93,6 +97,7 @@ class TestPersonalDataManager : public PersonalDataManager {
                                      month, year);
     credit_card->set_guid("00000000-0000-0000-0000-000000000007");
     credit_cards_->push_back(credit_card);
+    ClearPrefixIndices();
  }
 
  private:
@@ -75,6 +75,7 @@ class TestPersonalDataManager : public PersonalDataManager {
   // memory.
   virtual void AddProfile(AutofillProfile* profile) {
     web_profiles_.push_back(profile);
+    ClearPrefixIndices();
   }
 
   const MockAutofillMetrics* metric_logger() const {
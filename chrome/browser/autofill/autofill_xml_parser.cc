@@ -27,6 +27,16 @@ void AutofillXmlParser::Error(buzz::XmlParseContext* context,
   succeeded_ = false;
 }
 
+// static
+bool AutofillXmlParser::NameIs(buzz::XmlParseContext* context,
+                               const char* name,
+                               bool is_attribute,
+                               const char* local_name) {
+  if (!strchr(name, ':'))
+    return strcmp(name, local_name) == 0;
+  return context->ResolveQName(name, is_attribute).LocalPart() == local_name;
+}
+
 AutofillQueryXmlParser::AutofillQueryXmlParser(
     std::vector<AutofillFieldType>* field_types,
     UploadRequired* upload_required,
@@ -41,9 +51,7 @@ AutofillQueryXmlParser::AutofillQueryXmlParser(
 void AutofillQueryXmlParser::StartElement(buzz::XmlParseContext* context,
                                           const char* name,
                                           const char** attrs) {
-  buzz::QName qname = context->ResolveQName(name, false);
-  const std::string& element = qname.LocalPart();
-  if (element.compare("autofillqueryresponse") == 0) {
+  if (NameIs(context, name, false, "autofillqueryresponse")) {
     // We check for the upload required attribute below, but if it's not
     // present, we use the default upload rates. Likewise, by default we assume
     // an empty experiment id.
@@ -52,21 +60,19 @@ void AutofillQueryXmlParser::StartElement(buzz::XmlParseContext* context,
 
     // |attrs| is a NULL-terminated list of (attribute, value) pairs.
     while (*attrs) {
-      buzz::QName attribute_qname = context->ResolveQName(attrs[0], true);
-      const std::string& attribute_name = attribute_qname.LocalPart();
-      if (attribute_name.compare("uploadrequired") == 0) {
+      if (NameIs(context, attrs[0], true, "uploadrequired")) {
         if (strcmp(attrs[1], "true") == 0)
           *upload_required_ = UPLOAD_REQUIRED;
         else if (strcmp(attrs[1], "false") == 0)
           *upload_required_ = UPLOAD_NOT_REQUIRED;
-      } else if (attribute_name.compare("experimentid") == 0) {
+      } else if (NameIs(context, attrs[0], true, "experimentid")) {
         *experiment_id_ = attrs[1];
       }
 
       // Advance to the next (attribute, value) pair.
       attrs += 2;
     }
-  } else if (element.compare("field") == 0) {
+  } else if (NameIs(context, name, false, "field")) {
     if (!attrs[0]) {
       // Missing the "autofilltype" attribute, abort.
       context->RaiseError(XML_ERROR_ABORTED);
@@ -76,10 +82,7 @@ void AutofillQueryXmlParser::StartElement(buzz::XmlParseContext* context,
     // Determine the field type from the attribute value.  There should be one
     // attribute (autofilltype) with an integer value.
     AutofillFieldType field_type = UNKNOWN_TYPE;
-    buzz::QName attribute_qname = context->ResolveQName(attrs[0], true);
-    const std::string& attribute_name = attribute_qname.LocalPart();
-
-    if (attribute_name.compare("autofilltype") == 0) {
+    if (NameIs(context, attrs[0], true, "autofilltype")) {
       int value = GetIntValue(context, attrs[1]);
       field_type = static_cast<AutofillFieldType>(value);
       if (field_type < 0 || field_type > MAX_VALID_FIELD_TYPE) {
@@ -115,16 +118,12 @@ AutofillUploadXmlParser::AutofillUploadXmlParser(double* positive_upload_rate,
 void AutofillUploadXmlParser::StartElement(buzz::XmlParseContext* context,
                                            const char* name,
                                            const char** attrs) {
-  buzz::QName qname = context->ResolveQName(name, false);
-  const std::string &element = qname.LocalPart();
-  if (element.compare("autofilluploadresponse") == 0) {
+  if (NameIs(context, name, false, "autofilluploadresponse")) {
     // Loop over all attributes to get the upload rates.
     while (*attrs) {
-      buzz::QName attribute_qname = context->ResolveQName(attrs[0], true);
-      const std::string &attribute_name = attribute_qname.LocalPart();
-      if (attribute_name.compare("positiveuploadrate") == 0) {
+      if (NameIs(context, attrs[0], true, "positiveuploadrate")) {
         *positive_upload_rate_ = GetDoubleValue(context, attrs[1]);
-      } else if (attribute_name.compare("negativeuploadrate") == 0) {
+      } else if (NameIs(context, attrs[0], true, "negativeuploadrate")) {
         *negative_upload_rate_ = GetDoubleValue(context, attrs[1]);
       }
       attrs += 2;  // We peeked at attrs[0] and attrs[1], skip past both.
@@ -24,6 +24,15 @@ class AutofillXmlParser : public buzz::XmlParseHandler {
   // Returns true if no parsing errors were encountered.
   bool succeeded() const { return succeeded_; }
 
+ protected:
+  // Returns true if the local part of the element or attribute name |name| is
+  // |local_name|.  The responses use unprefixed names, which are compared
+  // as they are; only prefixed names are resolved, as that builds a QName.
+  static bool NameIs(buzz::XmlParseContext* context,
+                     const char* name,
+                     bool is_attribute,
+                     const char* local_name);
+
  private:
   // A callback for the end of an </element>, called by Expat.
   // |context| is a parsing context used to resolve element/attribute names.
@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -41,6 +42,37 @@ TEST(AutofillQueryXmlParserTest, BasicQuery) {
   EXPECT_EQ(std::string(), experiment_id);
 }
 
+// Test a response given to the parser a few bytes at a time, some of its names
+// having a namespace prefix.
+TEST(AutofillQueryXmlParserTest, QueryInChunks) {
+  std::string xml = "<autofillqueryresponse xmlns:af=\"urn:autofill\" "
+                    "experimentid=\"ar1\">"
+                    "<field autofilltype=\"3\" />"
+                    "<af:field af:autofilltype=\"5\" />"
+                    "<undeclared:field autofilltype=\"9\" />"
+                    "<field autofilltype=\"9\" />"
+                    "</autofillqueryresponse>";
+
+  std::vector<AutofillFieldType> field_types;
+  UploadRequired upload_required = USE_UPLOAD_RATES;
+  std::string experiment_id;
+  AutofillQueryXmlParser parse_handler(&field_types, &upload_required,
+                                       &experiment_id);
+  buzz::XmlParser parser(&parse_handler);
+  const size_t kChunkSize = 7;
+  for (size_t i = 0; i < xml.length(); i += kChunkSize) {
+    size_t length = std::min(kChunkSize, xml.length() - i);
+    parser.Parse(xml.data() + i, length, i + length == xml.length());
+  }
+  EXPECT_TRUE(parse_handler.succeeded());
+  EXPECT_EQ(std::string("ar1"), experiment_id);
+  // The element with an undeclared prefix isn't a field.
+  ASSERT_EQ(3U, field_types.size());
+  EXPECT_EQ(NAME_FIRST, field_types[0]);
+  EXPECT_EQ(NAME_LAST, field_types[1]);
+  EXPECT_EQ(EMAIL_ADDRESS, field_types[2]);
+}
+
 // Test parsing the upload required attribute.
 TEST(AutofillQueryXmlParserTest, TestUploadRequired) {
   std::vector<AutofillFieldType> field_types;
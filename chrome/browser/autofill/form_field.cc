@@ -5,12 +5,17 @@
 #include "chrome/browser/autofill/form_field.h"
 
 #include <stddef.h>
+#include <map>
 #include <string>
 #include <utility>
 
 #include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/singleton.h"
+#include "base/stl_util-inl.h"
 #include "base/string_util.h"
 #include "base/stringprintf.h"
+#include "base/synchronization/lock.h"
 #include "base/utf_string_conversions.h"
 #include "chrome/browser/autofill/address_field.h"
 #include "chrome/browser/autofill/autofill_field.h"
@@ -70,17 +75,69 @@ const char kEcmlCardExpireDay[] = "ecom_payment_card_expdate_day";
 const char kEcmlCardExpireMonth[] = "ecom_payment_card_expdate_month";
 const char kEcmlCardExpireYear[] = "ecom_payment_card_expdate_year";
 
+namespace {
+
+// Compiles each pattern once. The heuristics only use a fixed set of
+// patterns, from the resources and the ECML names, so the cache is never
+// trimmed. A compiled pattern may be shared by matchers on any thread.
+class CompiledPatterns {
+ public:
+  static CompiledPatterns* GetInstance() {
+    return Singleton<CompiledPatterns>::get();
+  }
+
+  // Returns the compiled |pattern|, or NULL if it is not a valid pattern.
+  const icu::RegexPattern* Get(const string16& pattern) {
+    base::AutoLock lock(lock_);
+    PatternMap::const_iterator found = patterns_.find(pattern);
+    if (found != patterns_.end())
+      return found->second;
+
+    UErrorCode status = U_ZERO_ERROR;
+    icu::UnicodeString icu_pattern(pattern.data(), pattern.length());
+    icu::RegexPattern* compiled = icu::RegexPattern::compile(
+        icu_pattern, UREGEX_CASE_INSENSITIVE, status);
+    DCHECK(U_SUCCESS(status));
+    if (U_FAILURE(status)) {
+      delete compiled;
+      compiled = NULL;
+    }
+    patterns_[pattern] = compiled;
+    return compiled;
+  }
+
+ private:
+  friend struct DefaultSingletonTraits<CompiledPatterns>;
+
+  typedef std::map<string16, icu::RegexPattern*> PatternMap;
+
+  CompiledPatterns() {}
+  ~CompiledPatterns() { STLDeleteValues(&patterns_); }
+
+  base::Lock lock_;
+  PatternMap patterns_;
+
+  DISALLOW_COPY_AND_ASSIGN(CompiledPatterns);
+};
+
+}  // namespace
+
 namespace autofill {
 
 bool MatchString(const string16& input, const string16& pattern) {
+  const icu::RegexPattern* compiled =
+      CompiledPatterns::GetInstance()->Get(pattern);
+  if (!compiled)
+    return false;
+
   UErrorCode status = U_ZERO_ERROR;
-  icu::UnicodeString icu_pattern(pattern.data(), pattern.length());
   icu::UnicodeString icu_input(input.data(), input.length());
-  icu::RegexMatcher matcher(icu_pattern, icu_input,
-                            UREGEX_CASE_INSENSITIVE, status);
+  scoped_ptr<icu::RegexMatcher> matcher(compiled->matcher(icu_input, status));
   DCHECK(U_SUCCESS(status));
+  if (U_FAILURE(status))
+    return false;
 
-  UBool match = matcher.find(0, status);
+  UBool match = matcher->find(0, status);
   DCHECK(U_SUCCESS(status));
   return !!match;
 }
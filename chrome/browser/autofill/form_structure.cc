@@ -6,13 +6,16 @@
 
 #include "base/basictypes.h"
 #include "base/logging.h"
+#include "base/memory/singleton.h"
 #include "base/sha1.h"
 #include "base/string_number_conversions.h"
+#include "base/synchronization/lock.h"
 #include "base/utf_string_conversions.h"
 #include "chrome/browser/autofill/autofill_metrics.h"
 #include "chrome/browser/autofill/autofill_xml_parser.h"
 #include "chrome/browser/autofill/field_types.h"
 #include "chrome/browser/autofill/form_field.h"
+#include "content/common/mru_cache.h"
 #include "third_party/libjingle/source/talk/xmllite/xmlelement.h"
 #include "webkit/glue/form_field.h"
 
@@ -47,6 +50,47 @@ const size_t kRequiredFillableFields = 2;
 const size_t kRequiredFillableFields = 3;
 #endif
 
+// The number of forms whose heuristic types are remembered.
+const size_t kHeuristicTypeCacheSize = 100;
+
+// Remembers the heuristic types of recently parsed forms, so that a form seen
+// again, on this page or another one, isn't parsed again.
+class HeuristicTypeCache {
+ public:
+  static HeuristicTypeCache* GetInstance() {
+    return Singleton<HeuristicTypeCache>::get();
+  }
+
+  // Fills |types| and returns true if the form with |signature| is cached.
+  bool Get(const std::string& signature,
+           std::vector<AutofillFieldType>* types) {
+    base::AutoLock lock(lock_);
+    Cache::iterator found = cache_.Get(signature);
+    if (found == cache_.end())
+      return false;
+    *types = found->second;
+    return true;
+  }
+
+  void Put(const std::string& signature,
+           const std::vector<AutofillFieldType>& types) {
+    base::AutoLock lock(lock_);
+    cache_.Put(signature, types);
+  }
+
+ private:
+  friend struct DefaultSingletonTraits<HeuristicTypeCache>;
+
+  typedef MRUCache<std::string, std::vector<AutofillFieldType> > Cache;
+
+  HeuristicTypeCache() : cache_(kHeuristicTypeCacheSize) {}
+
+  base::Lock lock_;
+  Cache cache_;
+
+  DISALLOW_COPY_AND_ASSIGN(HeuristicTypeCache);
+};
+
 }  // namespace
 
 FormStructure::FormStructure(const FormData& form)
@@ -92,21 +136,28 @@ void FormStructure::DetermineHeuristicTypes() {
   has_autofillable_field_ = false;
   autofill_count_ = 0;
 
-  FieldTypeMap field_type_map;
-  GetHeuristicFieldInfo(&field_type_map);
+  std::vector<AutofillFieldType> heuristic_types;
+  std::string signature = HeuristicSignature();
+  HeuristicTypeCache* cache = HeuristicTypeCache::GetInstance();
+  if (!cache->Get(signature, &heuristic_types)) {
+    FieldTypeMap field_type_map;
+    GetHeuristicFieldInfo(&field_type_map);
+    for (size_t index = 0; index < field_count(); index++) {
+      FieldTypeMap::iterator iter =
+          field_type_map.find(fields_[index]->unique_name());
+      heuristic_types.push_back(
+          iter == field_type_map.end() ? UNKNOWN_TYPE : iter->second);
+    }
+    cache->Put(signature, heuristic_types);
+  }
+  DCHECK_EQ(field_count(), heuristic_types.size());
 
   for (size_t index = 0; index < field_count(); index++) {
     AutofillField* field = fields_[index];
     DCHECK(field);
-    FieldTypeMap::iterator iter = field_type_map.find(field->unique_name());
-
-    AutofillFieldType heuristic_autofill_type;
-    if (iter == field_type_map.end()) {
-      heuristic_autofill_type = UNKNOWN_TYPE;
-    } else {
-      heuristic_autofill_type = iter->second;
+    AutofillFieldType heuristic_autofill_type = heuristic_types[index];
+    if (heuristic_autofill_type != UNKNOWN_TYPE)
       ++autofill_count_;
-    }
 
     field->set_heuristic_type(heuristic_autofill_type);
 
@@ -207,8 +258,15 @@ void FormStructure::ParseQueryResponse(const std::string& response_xml,
                                        const AutofillMetrics& metric_logger) {
   metric_logger.Log(AutofillMetrics::QUERY_RESPONSE_RECEIVED);
 
-  // Parse the field types from the server response to the query.
+  // Parse the field types from the server response to the query.  There is
+  // one for each field that was sent.
+  size_t field_count = 0;
+  for (std::vector<FormStructure*>::const_iterator iter = forms.begin();
+       iter != forms.end(); ++iter) {
+    field_count += (*iter)->field_count();
+  }
   std::vector<AutofillFieldType> field_types;
+  field_types.reserve(field_count);
   std::string experiment_id;
   AutofillQueryXmlParser parse_handler(&field_types, upload_required,
                                        &experiment_id);
@@ -521,6 +579,18 @@ std::string FormStructure::Hash64Bit(const std::string& str) {
   return base::Uint64ToString(hash64);
 }
 
+std::string FormStructure::HeuristicSignature() const {
+  // The heuristics look at the labels, and at which fields are empty, as well
+  // as the names.
+  std::string heuristic_string = form_signature_field_names_;
+  for (size_t index = 0; index < field_count(); ++index) {
+    const AutofillField* field = fields_[index];
+    heuristic_string.append(field->IsEmpty() ? "&" : "&+");
+    heuristic_string.append(UTF16ToUTF8(field->label));
+  }
+  return Hash64Bit(heuristic_string);
+}
+
 void FormStructure::GetHeuristicFieldInfo(FieldTypeMap* field_type_map) {
   FormFieldSet fields(this);
 
@@ -41,7 +41,8 @@ class FormStructure {
   virtual ~FormStructure();
 
   // Runs several heuristics against the form fields to determine their possible
-  // types.
+  // types. The types are cached for the form's heuristic signature, so a form
+  // seen before isn't parsed again.
   void DetermineHeuristicTypes();
 
   // Encodes the XML upload request from this FormStructure.
@@ -129,6 +130,11 @@ class FormStructure {
     UPLOAD,
   };
 
+  // Returns a 64-bit hash of everything the heuristics look at, which is more
+  // than FormSignature() covers. Forms with the same heuristic signature get
+  // the same heuristic types.
+  std::string HeuristicSignature() const;
+
   // Associates the field with the heuristic type for each of the field views.
   void GetHeuristicFieldInfo(FieldTypeMap* field_types_map);
 
@@ -44,6 +44,10 @@ class FormStructureTest {
   static std::string Hash64Bit(const std::string& str) {
     return FormStructure::Hash64Bit(str);
   }
+
+  static std::string HeuristicSignature(const FormStructure& form) {
+    return form.HeuristicSignature();
+  }
 };
 
 namespace {
@@ -284,6 +288,59 @@ TEST(FormStructureTest, HeuristicsContactInfo) {
   EXPECT_EQ(UNKNOWN_TYPE, form_structure->field(8)->heuristic_type());
 }
 
+// Forms with the same field names but different labels share a form signature,
+// but must not share cached heuristic types.
+TEST(FormStructureTest, HeuristicsCachedBySignature) {
+  FormData form;
+  form.method = ASCIIToUTF16("post");
+  form.fields.push_back(webkit_glue::FormField(ASCIIToUTF16("First Name"),
+                                               ASCIIToUTF16("field1"),
+                                               string16(),
+                                               ASCIIToUTF16("text"),
+                                               0,
+                                               false));
+  form.fields.push_back(webkit_glue::FormField(ASCIIToUTF16("Last Name"),
+                                               ASCIIToUTF16("field2"),
+                                               string16(),
+                                               ASCIIToUTF16("text"),
+                                               0,
+                                               false));
+  form.fields.push_back(webkit_glue::FormField(ASCIIToUTF16("EMail"),
+                                               ASCIIToUTF16("field3"),
+                                               string16(),
+                                               ASCIIToUTF16("text"),
+                                               0,
+                                               false));
+  FormStructure form_structure(form);
+  form_structure.DetermineHeuristicTypes();
+  EXPECT_EQ(NAME_FIRST, form_structure.field(0)->heuristic_type());
+  EXPECT_EQ(NAME_LAST, form_structure.field(1)->heuristic_type());
+  EXPECT_EQ(EMAIL_ADDRESS, form_structure.field(2)->heuristic_type());
+
+  // The same form again gets the same types.
+  FormStructure same_form_structure(form);
+  EXPECT_EQ(FormStructureTest::HeuristicSignature(form_structure),
+            FormStructureTest::HeuristicSignature(same_form_structure));
+  same_form_structure.DetermineHeuristicTypes();
+  EXPECT_EQ(NAME_FIRST, same_form_structure.field(0)->heuristic_type());
+  EXPECT_EQ(NAME_LAST, same_form_structure.field(1)->heuristic_type());
+  EXPECT_EQ(EMAIL_ADDRESS, same_form_structure.field(2)->heuristic_type());
+
+  // Relabeling the fields changes their types.
+  form.fields[0].label = ASCIIToUTF16("Address");
+  form.fields[1].label = ASCIIToUTF16("City");
+  FormStructure relabeled_form_structure(form);
+  EXPECT_EQ(form_structure.FormSignature(),
+            relabeled_form_structure.FormSignature());
+  EXPECT_NE(FormStructureTest::HeuristicSignature(form_structure),
+            FormStructureTest::HeuristicSignature(relabeled_form_structure));
+  relabeled_form_structure.DetermineHeuristicTypes();
+  EXPECT_EQ(ADDRESS_HOME_LINE1,
+            relabeled_form_structure.field(0)->heuristic_type());
+  EXPECT_EQ(ADDRESS_HOME_CITY,
+            relabeled_form_structure.field(1)->heuristic_type());
+}
+
 TEST(FormStructureTest, HeuristicsSample8) {
   scoped_ptr<FormStructure> form_structure;
   FormData form;
@@ -4,6 +4,8 @@
 
 #include "chrome/browser/autofill/personal_data_manager.h"
 
+#include <ctype.h>
+
 #include <algorithm>
 #include <iterator>
 
@@ -100,6 +102,16 @@ bool IsMinimumAddress(const AutofillProfile& profile) {
          !profile.GetInfo(ADDRESS_HOME_ZIP).empty();
 }
 
+// Folds the case of |value| the way StartsWith() does when ignoring case, so
+// that a folded value starts with a folded prefix exactly when StartsWith()
+// would match them.
+string16 FoldCase(const string16& value) {
+  string16 folded(value);
+  for (string16::iterator iter = folded.begin(); iter != folded.end(); ++iter)
+    *iter = tolower(*iter);
+  return folded;
+}
+
 }  // namespace
 
 PersonalDataManager::~PersonalDataManager() {
@@ -401,6 +413,7 @@ void PersonalDataManager::SetProfiles(std::vector<AutofillProfile>* profiles) {
        iter != profiles->end(); ++iter) {
     web_profiles_.push_back(new AutofillProfile(*iter));
   }
+  ClearPrefixIndices();
 
   // Read our writes to ensure consistency with the database.
   Refresh();
@@ -455,6 +468,7 @@ void PersonalDataManager::SetCreditCards(
        iter != credit_cards->end(); ++iter) {
     credit_cards_.push_back(new CreditCard(*iter));
   }
+  ClearPrefixIndices();
 
   // Read our writes to ensure consistency with the database.
   Refresh();
@@ -495,6 +509,8 @@ void PersonalDataManager::UpdateProfile(const AutofillProfile& profile) {
     }
   }
 
+  ClearPrefixIndices();
+
   // Ensure that profile labels are up to date.
   AutofillProfile::AdjustInferredLabels(&web_profiles_.get());
 
@@ -555,6 +571,7 @@ void PersonalDataManager::UpdateCreditCard(const CreditCard& credit_card) {
       break;
     }
   }
+  ClearPrefixIndices();
 
   wds->UpdateCreditCard(credit_card);
   FOR_EACH_OBSERVER(Observer, observers_, OnPersonalDataChanged());
@@ -621,6 +638,60 @@ void PersonalDataManager::GetPossibleFieldTypes(const string16& text,
     possible_types->insert(UNKNOWN_TYPE);
 }
 
+void PersonalDataManager::GetProfilesWithPrefix(
+    AutofillFieldType type,
+    const string16& prefix,
+    std::vector<AutofillProfile*>* matched_profiles,
+    std::vector<size_t>* variants) {
+  const std::vector<AutofillProfile*>& profiles = this->profiles();
+  PrefixIndex& index = profile_indices_[type];
+  if (index.empty()) {
+    for (size_t i = 0; i < profiles.size(); ++i) {
+      std::vector<string16> multi_values;
+      profiles[i]->GetMultiInfo(type, &multi_values);
+      for (size_t j = 0; j < multi_values.size(); ++j) {
+        if (multi_values[j].empty())
+          continue;
+        PrefixIndexEntry entry = { FoldCase(multi_values[j]), i, j };
+        index.push_back(entry);
+      }
+    }
+    std::sort(index.begin(), index.end());
+  }
+
+  std::vector<std::pair<size_t, size_t> > matches;
+  FindPrefix(index, prefix, &matches);
+  for (size_t i = 0; i < matches.size(); ++i) {
+    // Only the first matching value of each profile is suggested.
+    if (i > 0 && matches[i].first == matches[i - 1].first)
+      continue;
+    matched_profiles->push_back(profiles[matches[i].first]);
+    variants->push_back(matches[i].second);
+  }
+}
+
+void PersonalDataManager::GetCreditCardsWithPrefix(
+    AutofillFieldType type,
+    const string16& prefix,
+    std::vector<CreditCard*>* matched_credit_cards) {
+  PrefixIndex& index = credit_card_indices_[type];
+  if (index.empty()) {
+    for (size_t i = 0; i < credit_cards_.size(); ++i) {
+      string16 value = credit_cards_[i]->GetInfo(type);
+      if (value.empty())
+        continue;
+      PrefixIndexEntry entry = { FoldCase(value), i, 0 };
+      index.push_back(entry);
+    }
+    std::sort(index.begin(), index.end());
+  }
+
+  std::vector<std::pair<size_t, size_t> > matches;
+  FindPrefix(index, prefix, &matches);
+  for (size_t i = 0; i < matches.size(); ++i)
+    matched_credit_cards->push_back(credit_cards_[matches[i].first]);
+}
+
 bool PersonalDataManager::HasPassword() {
   return !password_hash_.empty();
 }
@@ -646,8 +717,9 @@ const std::vector<AutofillProfile*>& PersonalDataManager::profiles() {
 
   profiles_.clear();
 
-  // Populates |auxiliary_profiles_|.
+  // Populates |auxiliary_profiles_|, which are loaded anew each time.
   LoadAuxiliaryProfiles();
+  profile_indices_.clear();
 
   profiles_.insert(profiles_.end(), web_profiles_.begin(), web_profiles_.end());
   profiles_.insert(profiles_.end(),
@@ -693,6 +765,27 @@ bool PersonalDataManager::IsAutofillEnabled() const {
 #endif
 }
 
+void PersonalDataManager::ClearPrefixIndices() {
+  profile_indices_.clear();
+  credit_card_indices_.clear();
+}
+
+// static
+void PersonalDataManager::FindPrefix(
+    const PrefixIndex& index,
+    const string16& prefix,
+    std::vector<std::pair<size_t, size_t> >* matches) {
+  PrefixIndexEntry key = { FoldCase(prefix), 0, 0 };
+  for (PrefixIndex::const_iterator iter =
+           std::lower_bound(index.begin(), index.end(), key);
+       iter != index.end() &&
+           iter->value.compare(0, key.value.size(), key.value) == 0;
+       ++iter) {
+    matches->push_back(std::make_pair(iter->position, iter->variant));
+  }
+  std::sort(matches->begin(), matches->end());
+}
+
 // static
 bool PersonalDataManager::IsValidLearnableProfile(
     const AutofillProfile& profile) {
@@ -834,6 +927,7 @@ void PersonalDataManager::ReceiveLoadedProfiles(WebDataService::Handle h,
     web_profiles_.push_back(*iter);
   }
 
+  ClearPrefixIndices();
   LogProfileCount();
   EmptyMigrationTrash();
 }
@@ -853,6 +947,7 @@ void PersonalDataManager::ReceiveLoadedCreditCards(
        iter != credit_cards.end(); ++iter) {
     credit_cards_.push_back(*iter);
   }
+  ClearPrefixIndices();
 }
 
 void PersonalDataManager::CancelPendingQuery(WebDataService::Handle* handle) {
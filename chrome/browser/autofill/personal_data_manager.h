@@ -6,6 +6,7 @@
 #define CHROME_BROWSER_AUTOFILL_PERSONAL_DATA_MANAGER_H_
 #pragma once
 
+#include <map>
 #include <set>
 #include <vector>
 
@@ -133,6 +134,21 @@ BASE_API
   void GetPossibleFieldTypes(const string16& text,
                              FieldTypeSet* possible_types);
 
+  // Fills |matched_profiles| with the profiles, in the order of |profiles()|,
+  // that have a value of |type| starting with |prefix|, ignoring case, and
+  // |variants| with the first such value of each.
+  void GetProfilesWithPrefix(AutofillFieldType type,
+                             const string16& prefix,
+                             std::vector<AutofillProfile*>* matched_profiles,
+                             std::vector<size_t>* variants);
+
+  // Fills |matched_credit_cards| with the credit cards, in the order of
+  // |credit_cards()|, whose value of |type| starts with |prefix|, ignoring
+  // case.
+  void GetCreditCardsWithPrefix(AutofillFieldType type,
+                                const string16& prefix,
+                                std::vector<CreditCard*>* matched_credit_cards);
+
   // Returns true if the credit card information is stored with a password.
   bool HasPassword();
 
@@ -222,6 +238,10 @@ BASE_API
   // Returns the value of the AutofillEnabled pref.
   virtual bool IsAutofillEnabled() const;
 
+  // Drops the prefix indices.  Must be called whenever the profiles or credit
+  // cards change.
+  void ClearPrefixIndices();
+
   // For tests.
   const AutofillMetrics* metric_logger() const;
   void set_metric_logger(const AutofillMetrics* metric_logger);
@@ -266,6 +286,31 @@ BASE_API
   // Whether we have already logged the number of profiles this session.
   mutable bool has_logged_profile_count_;
 
+  // A value in a prefix index, case-folded, with the position of the profile
+  // or credit card it belongs to and which of its values of the type it is.
+  struct PrefixIndexEntry {
+    string16 value;
+    size_t position;
+    size_t variant;
+
+    bool operator<(const PrefixIndexEntry& other) const {
+      return value < other.value;
+    }
+  };
+  typedef std::vector<PrefixIndexEntry> PrefixIndex;
+
+  // Fills |matches| with the pairs of position and variant of the entries of
+  // the sorted |index| that start with |prefix|, ordered by position.
+  static void FindPrefix(const PrefixIndex& index,
+                         const string16& prefix,
+                         std::vector<std::pair<size_t, size_t> >* matches);
+
+  // For each field type suggestions were asked for, the sorted values of that
+  // type in |profiles()| and |credit_cards()|, so that a prefix is found in
+  // logarithmic time.  Built on first use.
+  std::map<AutofillFieldType, PrefixIndex> profile_indices_;
+  std::map<AutofillFieldType, PrefixIndex> credit_card_indices_;
+
   DISALLOW_COPY_AND_ASSIGN(PersonalDataManager);
 };
 
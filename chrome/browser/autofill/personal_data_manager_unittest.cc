@@ -161,6 +161,74 @@ TEST_F(PersonalDataManagerTest, SetProfiles) {
   EXPECT_EQ(0, profile2.Compare(*results3.at(1)));
 }
 
+TEST_F(PersonalDataManagerTest, GetProfilesWithPrefix) {
+  AutofillProfile profile0;
+  autofill_test::SetProfileInfo(&profile0,
+      "Marion", "Mitchell", "Morrison",
+      "johnwayne@me.xyz", "Fox", "123 Zoo St.", "unit 5", "Hollywood", "CA",
+      "91601", "US", "12345678910", "01987654321");
+
+  AutofillProfile profile1;
+  autofill_test::SetProfileInfo(&profile1,
+      "Josephine", "Alicia", "Saenz",
+      "joewayne@me.xyz", "Fox", "903 Apple Ct.", NULL, "Orlando", "FL", "32801",
+      "US", "19482937549", "13502849239");
+
+  AutofillProfile profile2;
+  autofill_test::SetProfileInfo(&profile2,
+      "josh", "Alicia", "Saenz",
+      "joewayne@me.xyz", "Fox", "1212 Center.", "Bld. 5", "Orlando", "FL",
+      "32801", "US", "19482937549", "13502849239");
+
+  EXPECT_CALL(personal_data_observer_,
+              OnPersonalDataLoaded()).WillOnce(QuitUIMessageLoop());
+  MessageLoop::current()->Run();
+
+  std::vector<AutofillProfile> update;
+  update.push_back(profile0);
+  update.push_back(profile1);
+  update.push_back(profile2);
+  personal_data_->SetProfiles(&update);
+
+  // Matches ignore case, and come in the order of the profiles.
+  std::vector<AutofillProfile*> matched_profiles;
+  std::vector<size_t> variants;
+  personal_data_->GetProfilesWithPrefix(NAME_FIRST, ASCIIToUTF16("JO"),
+                                        &matched_profiles, &variants);
+  ASSERT_EQ(2U, matched_profiles.size());
+  EXPECT_EQ(0, profile1.Compare(*matched_profiles[0]));
+  EXPECT_EQ(0, profile2.Compare(*matched_profiles[1]));
+  EXPECT_EQ(0U, variants[0]);
+  EXPECT_EQ(0U, variants[1]);
+
+  matched_profiles.clear();
+  variants.clear();
+  personal_data_->GetProfilesWithPrefix(NAME_FIRST, ASCIIToUTF16("Josh"),
+                                        &matched_profiles, &variants);
+  ASSERT_EQ(1U, matched_profiles.size());
+  EXPECT_EQ(0, profile2.Compare(*matched_profiles[0]));
+
+  // An empty prefix matches every profile with a value.
+  matched_profiles.clear();
+  variants.clear();
+  personal_data_->GetProfilesWithPrefix(NAME_FIRST, string16(),
+                                        &matched_profiles, &variants);
+  EXPECT_EQ(3U, matched_profiles.size());
+
+  // The index follows changes to the profiles.
+  profile0.SetInfo(NAME_FIRST, ASCIIToUTF16("John"));
+  update.clear();
+  update.push_back(profile0);
+  personal_data_->SetProfiles(&update);
+
+  matched_profiles.clear();
+  variants.clear();
+  personal_data_->GetProfilesWithPrefix(NAME_FIRST, ASCIIToUTF16("jo"),
+                                        &matched_profiles, &variants);
+  ASSERT_EQ(1U, matched_profiles.size());
+  EXPECT_EQ(0, profile0.Compare(*matched_profiles[0]));
+}
+
 // TODO(jhawkins): Test SetCreditCards w/out a WebDataService in the profile.
 TEST_F(PersonalDataManagerTest, SetCreditCards) {
   CreditCard creditcard0;
@@ -105,11 +105,11 @@
 #include "net/http/http_stream_factory.h"
 #include "net/socket/client_socket_pool_base.h"
 #include "net/socket/client_socket_pool_manager.h"
+#include "net/socket/socks5_client_socket.h"
 #include "net/socket/tcp_client_socket.h"
 #include "net/spdy/spdy_session.h"
 #include "net/spdy/spdy_session_pool.h"
 #include "net/url_request/url_request.h"
-#include "net/url_request/url_request_throttler_manager.h"
 #include "ui/base/l10n/l10n_util.h"
 #include "ui/base/resource/resource_bundle.h"
 #include "ui/base/system_monitor/system_monitor.h"
@@ -240,6 +240,11 @@ void BrowserMainParts::EarlyInitialization() {
   if (parsed_command_line().HasSwitch(switches::kEnableTcpFastOpen))
     net::set_tcp_fastopen_enabled(true);
 
+  if (parsed_command_line().HasSwitch(
+          switches::kEnablePipelinedSocks5Handshake)) {
+    net::SOCKS5ClientSocket::set_pipelined_handshake(true);
+  }
+
   PostEarlyInitialization();
 }
 
@@ -648,9 +653,6 @@ void InitializeNetworkOptions(const CommandLine& parsed_command_line) {
     net::SpdySessionPool::set_max_sessions_per_domain(value);
   }
 
-  net::URLRequestThrottlerManager::GetInstance()->set_enable_thread_checks(
-      true);
-
   SetDnsCertProvenanceCheckerFactory(CreateChromeDnsCertProvenanceChecker);
 }
 
@@ -10,6 +10,7 @@
 #include "base/compiler_specific.h"
 #include "base/file_util.h"
 #include "base/message_loop.h"
+#include "base/metrics/histogram.h"
 #include "chrome/browser/bookmarks/bookmark_service.h"
 #include "chrome/browser/history/archived_database.h"
 #include "chrome/browser/history/history_database.h"
@@ -21,6 +22,7 @@
 
 using base::Time;
 using base::TimeDelta;
+using base::TimeTicks;
 
 namespace history {
 
@@ -108,14 +110,21 @@ bool ShouldArchiveVisit(const VisitRow& visit) {
   return false;
 }
 
-// The number of visits we will expire very time we check for old items. This
-// Prevents us from doing too much work any given time.
-const int kNumExpirePerIteration = 10;
+// The range of the number of visits we will expire in one batch. The batch
+// size starts at the minimum, doubles while batches are quick and halves when
+// one takes longer than kTargetBatchMs. This prevents us from doing too much
+// work any given time, while catching up quickly on a large backlog.
+const int kMinExpirePerBatch = 10;
+const int kMaxExpirePerBatch = 320;
+const int kTargetBatchMs = 20;
+
+// How long one slice of archiving keeps posting batches before it waits for
+// kExpirationDelaySec.
+const int kExpirationSliceMs = 200;
 
 // The number of seconds between checking for items that should be expired when
 // we think there might be more items to expire. This timeout is used when the
-// last expiration found at least kNumExpirePerIteration and we want to check
-// again "soon."
+// last slice found a full batch and we want to check again "soon."
 const int kExpirationDelaySec = 30;
 
 // The number of minutes between checking, as with kExpirationDelaySec, but
@@ -169,6 +178,7 @@ ExpireHistoryBackend::ExpireHistoryBackend(
       thumb_db_(NULL),
       text_db_(NULL),
       ALLOW_THIS_IN_INITIALIZER_LIST(factory_(this)),
+      batch_size_(kMinExpirePerBatch),
       bookmark_service_(bookmark_service) {
 }
 
@@ -589,9 +599,17 @@ void ExpireHistoryBackend::ScheduleArchive() {
 void ExpireHistoryBackend::DoArchiveIteration() {
   DCHECK(!work_queue_.empty()) << "queue has to be non-empty";
 
+  TimeTicks batch_start = TimeTicks::Now();
+  if (slice_end_.is_null())
+    slice_end_ = batch_start + TimeDelta::FromMilliseconds(kExpirationSliceMs);
+
   const ExpiringVisitsReader* reader = work_queue_.front();
   bool more_to_expire = ArchiveSomeOldHistory(GetCurrentArchiveTime(), reader,
-                                              kNumExpirePerIteration);
+                                              batch_size_);
+
+  TimeTicks batch_end = TimeTicks::Now();
+  UMA_HISTOGRAM_TIMES("History.ExpireBatchTime", batch_end - batch_start);
+  AdaptBatchSize(batch_end - batch_start, more_to_expire);
 
   work_queue_.pop();
   // If there are more items to expire, add the reader back to the queue, thus
@@ -599,9 +617,25 @@ void ExpireHistoryBackend::DoArchiveIteration() {
   if (more_to_expire)
     work_queue_.push(reader);
 
+  // Continue the slice in a new task, which lets anything else waiting for
+  // the history thread go first.
+  if (!work_queue_.empty() && batch_end < slice_end_) {
+    MessageLoop::current()->PostTask(FROM_HERE, factory_.NewRunnableMethod(
+        &ExpireHistoryBackend::DoArchiveIteration));
+    return;
+  }
+
+  slice_end_ = TimeTicks();
   ScheduleArchive();
 }
 
+void ExpireHistoryBackend::AdaptBatchSize(TimeDelta batch_time, bool full) {
+  if (batch_time > TimeDelta::FromMilliseconds(kTargetBatchMs))
+    batch_size_ = std::max(batch_size_ / 2, kMinExpirePerBatch);
+  else if (full && batch_time * 2 < TimeDelta::FromMilliseconds(kTargetBatchMs))
+    batch_size_ = std::min(batch_size_ * 2, kMaxExpirePerBatch);
+}
+
 bool ExpireHistoryBackend::ArchiveSomeOldHistory(
     base::Time end_time,
     const ExpiringVisitsReader* reader,
@@ -59,7 +59,10 @@ typedef std::vector<const ExpiringVisitsReader*> ExpiringVisitsReaders;
 // database as it gets old.
 //
 // It will automatically start periodically archiving old history once you call
-// StartArchivingOldStuff().
+// StartArchivingOldStuff(). Each round of archiving is a time slice made of
+// small batches, each run as its own task so that history queries waiting
+// behind it run in between. The batch size adapts to how long recent batches
+// took.
 class ExpireHistoryBackend {
  public:
   // The delegate pointer must be non-NULL. We will NOT take ownership of it.
@@ -107,6 +110,7 @@ class ExpireHistoryBackend {
   FRIEND_TEST_ALL_PREFIXES(ExpireHistoryTest, ArchiveSomeOldHistory);
   FRIEND_TEST_ALL_PREFIXES(ExpireHistoryTest, ExpiringVisitsReader);
   FRIEND_TEST_ALL_PREFIXES(ExpireHistoryTest, ArchiveSomeOldHistoryWithSource);
+  FRIEND_TEST_ALL_PREFIXES(ExpireHistoryTest, AdaptsArchiveBatchSize);
   friend class ::TestingProfile;
 
   struct DeleteDependencies;
@@ -207,11 +211,16 @@ class ExpireHistoryBackend {
   // Schedules a call to DoArchiveIteration.
   void ScheduleArchive();
 
-  // Calls ArchiveSomeOldHistory to expire some amount of old history, according
-  // to the items in work queue, and schedules another call to happen in the
-  // future.
+  // Calls ArchiveSomeOldHistory to expire one batch of old history, according
+  // to the items in work queue. The next batch is posted right away while the
+  // current time slice lasts, otherwise another slice is scheduled to happen in
+  // the future.
   void DoArchiveIteration();
 
+  // Grows or shrinks batch_size_ according to how long the last batch took,
+  // which was |full| if it expired batch_size_ visits.
+  void AdaptBatchSize(base::TimeDelta batch_time, bool full);
+
   // Tries to expire the oldest |max_visits| visits from history that are older
   // than |time_threshold|. The return value indicates if we think there might
   // be more history to expire with the current time threshold (it does not
@@ -272,6 +281,12 @@ class ExpireHistoryBackend {
   // iterations.
   std::queue<const ExpiringVisitsReader*> work_queue_;
 
+  // The number of visits DoArchiveIteration expires at a time.
+  int batch_size_;
+
+  // When the current time slice of archiving ends, or null between slices.
+  base::TimeTicks slice_end_;
+
   // Readers for various types of visits.
   // TODO(dglazkov): If you are adding another one, please consider reorganizing
   // into a map.
@@ -929,6 +929,27 @@ TEST_F(ExpireHistoryTest, ArchiveSomeOldHistoryWithSource) {
   EXPECT_EQ(0U, archived_visits.size());
 }
 
+// Tests that batches grow while they are quick and full, and shrink when slow.
+TEST_F(ExpireHistoryTest, AdaptsArchiveBatchSize) {
+  int initial_size = expirer_.batch_size_;
+  expirer_.AdaptBatchSize(TimeDelta(), false);
+  EXPECT_EQ(initial_size, expirer_.batch_size_);
+
+  expirer_.AdaptBatchSize(TimeDelta(), true);
+  EXPECT_EQ(initial_size * 2, expirer_.batch_size_);
+  for (int i = 0; i < 20; ++i)
+    expirer_.AdaptBatchSize(TimeDelta(), true);
+  int max_size = expirer_.batch_size_;
+  expirer_.AdaptBatchSize(TimeDelta(), true);
+  EXPECT_EQ(max_size, expirer_.batch_size_);
+
+  expirer_.AdaptBatchSize(TimeDelta::FromSeconds(1), true);
+  EXPECT_EQ(max_size / 2, expirer_.batch_size_);
+  for (int i = 0; i < 20; ++i)
+    expirer_.AdaptBatchSize(TimeDelta::FromSeconds(1), true);
+  EXPECT_EQ(initial_size, expirer_.batch_size_);
+}
+
 // TODO(brettw) add some visits with no URL to make sure everything is updated
 // properly. Have the visits also refer to nonexistent FTS rows.
 //
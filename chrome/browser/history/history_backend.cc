@@ -215,6 +215,10 @@ HistoryBackend::~HistoryBackend() {
   DCHECK(!scheduled_commit_) << "Deleting without cleanup";
   ReleaseDBTasks();
 
+  // Index the pages still waiting for it while the visits can be updated.
+  if (text_database_.get() && db_.get())
+    text_database_->IndexCompletePages();
+
   // First close the databases before optionally running the "destroy" task.
   if (db_.get()) {
     // Commit the long-running transaction.
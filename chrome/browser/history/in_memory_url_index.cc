@@ -4,6 +4,8 @@
 
 #include "chrome/browser/history/in_memory_url_index.h"
 
+#include <string.h>
+
 #include <algorithm>
 #include <iterator>
 #include <limits>
@@ -12,6 +14,7 @@
 #include "base/file_util.h"
 #include "base/i18n/break_iterator.h"
 #include "base/metrics/histogram.h"
+#include "base/pickle.h"
 #include "base/string_util.h"
 #include "base/time.h"
 #include "base/utf_string_conversions.h"
@@ -23,32 +26,102 @@
 #include "googleurl/src/url_util.h"
 #include "net/base/escape.h"
 #include "net/base/net_util.h"
-#include "third_party/protobuf/src/google/protobuf/repeated_field.h"
 #include "ui/base/l10n/l10n_util.h"
 
-using google::protobuf::RepeatedField;
-using google::protobuf::RepeatedPtrField;
-using in_memory_url_index::InMemoryURLIndexCacheItem;
-
 namespace history {
 
-typedef imui::InMemoryURLIndexCacheItem_WordListItem WordListItem;
-typedef imui::InMemoryURLIndexCacheItem_WordMapItem_WordMapEntry WordMapEntry;
-typedef imui::InMemoryURLIndexCacheItem_WordMapItem WordMapItem;
-typedef imui::InMemoryURLIndexCacheItem_CharWordMapItem CharWordMapItem;
-typedef imui::InMemoryURLIndexCacheItem_CharWordMapItem_CharWordMapEntry
-    CharWordMapEntry;
-typedef imui::InMemoryURLIndexCacheItem_WordIDHistoryMapItem
-    WordIDHistoryMapItem;
-typedef imui::
-    InMemoryURLIndexCacheItem_WordIDHistoryMapItem_WordIDHistoryMapEntry
-    WordIDHistoryMapEntry;
-typedef imui::InMemoryURLIndexCacheItem_HistoryInfoMapItem HistoryInfoMapItem;
-typedef imui::InMemoryURLIndexCacheItem_HistoryInfoMapItem_HistoryInfoMapEntry
-    HistoryInfoMapEntry;
-
 const size_t InMemoryURLIndex::kNoCachedResultForTerm = -1;
 
+namespace {
+
+// When one sorted set is this many times larger than the other, intersecting
+// them looks each element of the smaller one up in the larger one rather
+// than walking both.
+const size_t kBinarySearchIntersectionRatio = 16;
+
+// Adds |id| to the sorted |ids| unless it is already there. IDs are mostly
+// added in increasing order, so the end is checked first.
+template <typename ID>
+void InsertSortedID(ID id, std::vector<ID>* ids) {
+  if (ids->empty() || ids->back() < id) {
+    ids->push_back(id);
+    return;
+  }
+  typename std::vector<ID>::iterator it =
+      std::lower_bound(ids->begin(), ids->end(), id);
+  if (*it != id)
+    ids->insert(it, id);
+}
+
+// Sets |result| to the IDs found in both of the sorted |a| and |b|.
+template <typename ID>
+void IntersectSortedIDs(const std::vector<ID>& a,
+                        const std::vector<ID>& b,
+                        std::vector<ID>* result) {
+  result->clear();
+  const std::vector<ID>& smaller = a.size() < b.size() ? a : b;
+  const std::vector<ID>& larger = a.size() < b.size() ? b : a;
+  if (smaller.size() * kBinarySearchIntersectionRatio < larger.size()) {
+    typename std::vector<ID>::const_iterator it = larger.begin();
+    for (typename std::vector<ID>::const_iterator small_it = smaller.begin();
+         small_it != smaller.end() && it != larger.end(); ++small_it) {
+      it = std::lower_bound(it, larger.end(), *small_it);
+      if (it != larger.end() && *it == *small_it)
+        result->push_back(*small_it);
+    }
+    return;
+  }
+  std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                        std::back_inserter(*result));
+}
+
+// Sorts |ids| and removes the duplicates.
+template <typename ID>
+void SortAndUniqueIDs(std::vector<ID>* ids) {
+  std::sort(ids->begin(), ids->end());
+  ids->erase(std::unique(ids->begin(), ids->end()), ids->end());
+}
+
+// The version of the cache file layout. A cache of any other version is
+// ignored and the index is rebuilt from the history database.
+const int kCurrentCacheFileVersion = 1;
+
+// Saves the sorted |ids| as a count followed by the IDs as raw bytes.
+template <typename ID>
+void WriteIDs(const std::vector<ID>& ids, Pickle* pickle) {
+  pickle->WriteInt(ids.size());
+  if (!ids.empty())
+    pickle->WriteBytes(&ids[0], ids.size() * sizeof(ID));
+}
+
+// Restores IDs saved by WriteIDs(). Returns false unless they are strictly
+// increasing, as saved.
+template <typename ID>
+bool ReadIDs(const Pickle& pickle, void** iter, std::vector<ID>* ids) {
+  int count;
+  const char* bytes;
+  if (!pickle.ReadLength(iter, &count) ||
+      static_cast<size_t>(count) > std::numeric_limits<int>::max() / sizeof(ID))
+    return false;
+  if (!count) {
+    ids->clear();
+    return true;
+  }
+  if (!pickle.ReadBytes(iter, &bytes, count * sizeof(ID)))
+    return false;
+  // The bytes are only four-byte aligned in the pickle, so they are copied
+  // out rather than used in place.
+  ids->resize(count);
+  memcpy(&(*ids)[0], bytes, count * sizeof(ID));
+  for (int i = 1; i < count; ++i) {
+    if (!((*ids)[i - 1] < (*ids)[i]))
+      return false;
+  }
+  return true;
+}
+
+}  // namespace
+
 // Score ranges used to get a 'base' score for each of the scoring factors
 // (such as recency of last visit, times visited, times the URL was typed,
 // and the quality of the string match). There is a matching value range for
@@ -238,21 +311,23 @@ bool InMemoryURLIndex::RestoreFromCacheFile() {
   FilePath file_path;
   if (!GetCacheFilePath(&file_path) || !file_util::PathExists(file_path))
     return false;
-  std::string data;
-  if (!file_util::ReadFileToString(file_path, &data)) {
-    LOG(WARNING) << "Failed to read InMemoryURLIndex cache from "
+  // The tables are read straight out of the mapping, so the file is never
+  // copied into memory as a whole.
+  file_util::MemoryMappedFile file;
+  if (!file.Initialize(file_path)) {
+    LOG(WARNING) << "Failed to map InMemoryURLIndex cache from "
                  << file_path.value();
     return false;
   }
 
-  InMemoryURLIndexCacheItem index_cache;
-  if (!index_cache.ParseFromArray(data.c_str(), data.size())) {
+  Pickle pickle(reinterpret_cast<const char*>(file.data()), file.length());
+  if (!pickle.data()) {
     LOG(WARNING) << "Failed to parse InMemoryURLIndex cache data read from "
                  << file_path.value();
     return false;
   }
 
-  if (!RestorePrivateData(index_cache)) {
+  if (!RestorePrivateData(pickle)) {
     ClearPrivateData();  // Back to square one -- must build from scratch.
     return false;
   }
@@ -260,7 +335,7 @@ bool InMemoryURLIndex::RestoreFromCacheFile() {
   UMA_HISTOGRAM_TIMES("History.InMemoryURLIndexRestoreCacheTime",
                       base::TimeTicks::Now() - beginning_time);
   UMA_HISTOGRAM_COUNTS("History.InMemoryURLHistoryItems", history_item_count_);
-  UMA_HISTOGRAM_COUNTS("History.InMemoryURLCacheSize", data.size());
+  UMA_HISTOGRAM_COUNTS("History.InMemoryURLCacheSize", file.length());
   UMA_HISTOGRAM_COUNTS_10000("History.InMemoryURLWords", word_map_.size());
   UMA_HISTOGRAM_COUNTS_10000("History.InMemoryURLChars", char_word_map_.size());
   return true;
@@ -268,13 +343,8 @@ bool InMemoryURLIndex::RestoreFromCacheFile() {
 
 bool InMemoryURLIndex::SaveToCacheFile() {
   base::TimeTicks beginning_time = base::TimeTicks::Now();
-  InMemoryURLIndexCacheItem index_cache;
-  SavePrivateData(&index_cache);
-  std::string data;
-  if (!index_cache.SerializeToString(&data)) {
-    LOG(WARNING) << "Failed to serialize the InMemoryURLIndex cache.";
-    return false;
-  }
+  Pickle pickle;
+  SavePrivateData(&pickle);
 
   // Write the cache to a file then swap it for the old cache, if any, and
   // delete the old cache.
@@ -285,8 +355,9 @@ bool InMemoryURLIndex::SaveToCacheFile() {
   if (!file.get())
     return false;
 
-  int size = data.size();
-  if (file_util::WriteFile(file_path, data.c_str(), size) != size) {
+  int size = pickle.size();
+  if (file_util::WriteFile(file_path, static_cast<const char*>(pickle.data()),
+                           size) != size) {
     LOG(WARNING) << "Failed to write " << file_path.value();
     return false;
   }
@@ -419,14 +490,10 @@ InMemoryURLIndex::HistoryIDSet InMemoryURLIndex::HistoryIDSetFromWords(
       history_id_set.swap(term_history_id_set);
       first_word = false;
     } else {
-      HistoryIDSet old_history_id_set(history_id_set);
-      history_id_set.clear();
-      std::set_intersection(old_history_id_set.begin(),
-                            old_history_id_set.end(),
-                            term_history_id_set.begin(),
-                            term_history_id_set.end(),
-                            std::inserter(history_id_set,
-                                          history_id_set.begin()));
+      HistoryIDSet old_history_id_set;
+      old_history_id_set.swap(history_id_set);
+      IntersectSortedIDs(old_history_id_set, term_history_id_set,
+                         &history_id_set);
     }
   }
   return history_id_set;
@@ -458,10 +525,13 @@ InMemoryURLIndex::HistoryIDSet InMemoryURLIndex::HistoryIDsForTerm(
       WordIDHistoryMap::iterator word_iter = word_id_history_map_.find(word_id);
       if (word_iter != word_id_history_map_.end()) {
         HistoryIDSet& word_history_id_set(word_iter->second);
-        history_id_set.insert(word_history_id_set.begin(),
+        history_id_set.insert(history_id_set.end(),
+                              word_history_id_set.begin(),
                               word_history_id_set.end());
       }
     }
+    if (word_id_set.size() > 1)
+      SortAndUniqueIDs(&history_id_set);
   }
 
   return history_id_set;
@@ -539,7 +609,7 @@ void InMemoryURLIndex::UpdateWordHistory(WordID word_id, HistoryID history_id) {
     WordIDHistoryMap::iterator history_pos = word_id_history_map_.find(word_id);
     DCHECK(history_pos != word_id_history_map_.end());
     HistoryIDSet& history_id_set(history_pos->second);
-    history_id_set.insert(history_id);
+    InsertSortedID(history_id, &history_id_set);
 }
 
 // Add a new word to the word list and the word map, and then create a
@@ -549,9 +619,7 @@ void InMemoryURLIndex::AddWordHistory(const string16& uni_word,
   word_list_.push_back(uni_word);
   WordID word_id = word_list_.size() - 1;
   word_map_[uni_word] = word_id;
-  HistoryIDSet history_id_set;
-  history_id_set.insert(history_id);
-  word_id_history_map_[word_id] = history_id_set;
+  word_id_history_map_[word_id] = HistoryIDSet(1, history_id);
   // For each character in the newly added word (i.e. a word that is not
   // already in the word index), add the word to the character index.
   Char16Set characters = Char16SetFromString16(uni_word);
@@ -560,14 +628,13 @@ void InMemoryURLIndex::AddWordHistory(const string16& uni_word,
     Char16Set::value_type uni_char = *uni_char_iter;
     CharWordIDMap::iterator char_iter = char_word_map_.find(uni_char);
     if (char_iter != char_word_map_.end()) {
-      // Update existing entry in the char/word index.
+      // Update existing entry in the char/word index. New words have the
+      // largest ID, so this appends.
       WordIDSet& word_id_set(char_iter->second);
-      word_id_set.insert(word_id);
+      InsertSortedID(word_id, &word_id_set);
     } else {
       // Create a new entry in the char/word index.
-      WordIDSet word_id_set;
-      word_id_set.insert(word_id);
-      char_word_map_[uni_char] = word_id_set;
+      char_word_map_[uni_char] = WordIDSet(1, word_id);
     }
   }
 }
@@ -612,14 +679,9 @@ InMemoryURLIndex::WordIDSet InMemoryURLIndex::WordIDSetForTermChars(
     if (word_id_set.empty()) {
       word_id_set = char_word_id_set;
     } else {
-      WordIDSet old_word_id_set(word_id_set);
-      word_id_set.clear();
-      std::set_intersection(old_word_id_set.begin(),
-                            old_word_id_set.end(),
-                            char_word_id_set.begin(),
-                            char_word_id_set.end(),
-                            std::inserter(word_id_set,
-                            word_id_set.begin()));
+      WordIDSet old_word_id_set;
+      old_word_id_set.swap(word_id_set);
+      IntersectSortedIDs(old_word_id_set, char_word_id_set, &word_id_set);
     }
     // Add this new char/set instance to the cache.
     term_char_word_set_cache_.push_back(TermCharWordSet(
@@ -863,217 +925,155 @@ bool InMemoryURLIndex::GetCacheFilePath(FilePath* file_path) {
   return true;
 }
 
-void InMemoryURLIndex::SavePrivateData(InMemoryURLIndexCacheItem* cache) const {
-  DCHECK(cache);
-  cache->set_timestamp(base::Time::Now().ToInternalValue());
-  cache->set_history_item_count(history_item_count_);
-  SaveWordList(cache);
-  SaveWordMap(cache);
-  SaveCharWordMap(cache);
-  SaveWordIDHistoryMap(cache);
-  SaveHistoryInfoMap(cache);
+void InMemoryURLIndex::SavePrivateData(Pickle* pickle) const {
+  DCHECK(pickle);
+  pickle->WriteInt(kCurrentCacheFileVersion);
+  pickle->WriteInt64(base::Time::Now().ToInternalValue());
+  pickle->WriteInt(history_item_count_);
+  SaveWordList(pickle);
+  SaveCharWordMap(pickle);
+  SaveWordIDHistoryMap(pickle);
+  SaveHistoryInfoMap(pickle);
 }
 
-bool InMemoryURLIndex::RestorePrivateData(
-    const InMemoryURLIndexCacheItem& cache) {
-  last_saved_ = base::Time::FromInternalValue(cache.timestamp());
-  history_item_count_ = cache.history_item_count();
-  return (history_item_count_ == 0) || (RestoreWordList(cache) &&
-      RestoreWordMap(cache) && RestoreCharWordMap(cache) &&
-      RestoreWordIDHistoryMap(cache) && RestoreHistoryInfoMap(cache));
+bool InMemoryURLIndex::RestorePrivateData(const Pickle& pickle) {
+  void* iter = NULL;
+  int version;
+  int64 timestamp;
+  if (!pickle.ReadInt(&iter, &version) ||
+      version != kCurrentCacheFileVersion ||
+      !pickle.ReadInt64(&iter, &timestamp) ||
+      !pickle.ReadLength(&iter, &history_item_count_)) {
+    return false;
+  }
+  last_saved_ = base::Time::FromInternalValue(timestamp);
+  return RestoreWordList(pickle, &iter) &&
+      RestoreCharWordMap(pickle, &iter) &&
+      RestoreWordIDHistoryMap(pickle, &iter) &&
+      RestoreHistoryInfoMap(pickle, &iter);
 }
 
-
-void InMemoryURLIndex::SaveWordList(InMemoryURLIndexCacheItem* cache) const {
-  if (word_list_.empty())
-    return;
-  WordListItem* list_item = cache->mutable_word_list();
-  list_item->set_word_count(word_list_.size());
+void InMemoryURLIndex::SaveWordList(Pickle* pickle) const {
+  pickle->WriteInt(word_list_.size());
   for (String16Vector::const_iterator iter = word_list_.begin();
        iter != word_list_.end(); ++iter)
-    list_item->add_word(UTF16ToUTF8(*iter));
+    pickle->WriteString16(*iter);
 }
 
-bool InMemoryURLIndex::RestoreWordList(const InMemoryURLIndexCacheItem& cache) {
-  if (!cache.has_word_list())
+bool InMemoryURLIndex::RestoreWordList(const Pickle& pickle, void** iter) {
+  int count;
+  if (!pickle.ReadLength(iter, &count))
     return false;
-  const WordListItem& list_item(cache.word_list());
-  uint32 expected_item_count = list_item.word_count();
-  uint32 actual_item_count = list_item.word_size();
-  if (actual_item_count == 0 || actual_item_count != expected_item_count)
-    return false;
-  const RepeatedPtrField<std::string>& words(list_item.word());
-  for (RepeatedPtrField<std::string>::const_iterator iter = words.begin();
-       iter != words.end(); ++iter)
-    word_list_.push_back(UTF8ToUTF16(*iter));
-  return true;
-}
-
-void InMemoryURLIndex::SaveWordMap(InMemoryURLIndexCacheItem* cache) const {
-  if (word_map_.empty())
-    return;
-  WordMapItem* map_item = cache->mutable_word_map();
-  map_item->set_item_count(word_map_.size());
-  for (WordMap::const_iterator iter = word_map_.begin();
-       iter != word_map_.end(); ++iter) {
-    WordMapEntry* map_entry = map_item->add_word_map_entry();
-    map_entry->set_word(UTF16ToUTF8(iter->first));
-    map_entry->set_word_id(iter->second);
+  word_list_.resize(count);
+  for (int i = 0; i < count; ++i) {
+    if (!pickle.ReadString16(iter, &word_list_[i]))
+      return false;
+    // The word map is the inverse of the word list, so it isn't saved.
+    if (!word_map_.insert(std::make_pair(word_list_[i], i)).second)
+      return false;
   }
-}
-
-bool InMemoryURLIndex::RestoreWordMap(const InMemoryURLIndexCacheItem& cache) {
-  if (!cache.has_word_map())
-    return false;
-  const WordMapItem& list_item(cache.word_map());
-  uint32 expected_item_count = list_item.item_count();
-  uint32 actual_item_count = list_item.word_map_entry_size();
-  if (actual_item_count == 0 || actual_item_count != expected_item_count)
-    return false;
-  const RepeatedPtrField<WordMapEntry>& entries(list_item.word_map_entry());
-  for (RepeatedPtrField<WordMapEntry>::const_iterator iter = entries.begin();
-       iter != entries.end(); ++iter)
-    word_map_[UTF8ToUTF16(iter->word())] = iter->word_id();
   return true;
 }
 
-void InMemoryURLIndex::SaveCharWordMap(InMemoryURLIndexCacheItem* cache) const {
-  if (char_word_map_.empty())
-    return;
-  CharWordMapItem* map_item = cache->mutable_char_word_map();
-  map_item->set_item_count(char_word_map_.size());
+void InMemoryURLIndex::SaveCharWordMap(Pickle* pickle) const {
+  pickle->WriteInt(char_word_map_.size());
   for (CharWordIDMap::const_iterator iter = char_word_map_.begin();
        iter != char_word_map_.end(); ++iter) {
-    CharWordMapEntry* map_entry = map_item->add_char_word_map_entry();
-    map_entry->set_char_16(iter->first);
-    const WordIDSet& word_id_set(iter->second);
-    map_entry->set_item_count(word_id_set.size());
-    for (WordIDSet::const_iterator set_iter = word_id_set.begin();
-         set_iter != word_id_set.end(); ++set_iter)
-      map_entry->add_word_id(*set_iter);
+    pickle->WriteInt(iter->first);
+    WriteIDs(iter->second, pickle);
   }
 }
 
-bool InMemoryURLIndex::RestoreCharWordMap(
-    const InMemoryURLIndexCacheItem& cache) {
-  if (!cache.has_char_word_map())
-    return false;
-  const CharWordMapItem& list_item(cache.char_word_map());
-  uint32 expected_item_count = list_item.item_count();
-  uint32 actual_item_count = list_item.char_word_map_entry_size();
-  if (actual_item_count == 0 || actual_item_count != expected_item_count)
+bool InMemoryURLIndex::RestoreCharWordMap(const Pickle& pickle, void** iter) {
+  int count;
+  if (!pickle.ReadLength(iter, &count))
     return false;
-  const RepeatedPtrField<CharWordMapEntry>&
-      entries(list_item.char_word_map_entry());
-  for (RepeatedPtrField<CharWordMapEntry>::const_iterator iter =
-       entries.begin(); iter != entries.end(); ++iter) {
-    expected_item_count = iter->item_count();
-    actual_item_count = iter->word_id_size();
-    if (actual_item_count == 0 || actual_item_count != expected_item_count)
-      return false;
-    char16 uni_char = static_cast<char16>(iter->char_16());
+  const WordID word_count = static_cast<WordID>(word_list_.size());
+  for (int i = 0; i < count; ++i) {
+    int uni_char;
     WordIDSet word_id_set;
-    const RepeatedField<int32>& word_ids(iter->word_id());
-    for (RepeatedField<int32>::const_iterator jiter = word_ids.begin();
-         jiter != word_ids.end(); ++jiter)
-      word_id_set.insert(*jiter);
-    char_word_map_[uni_char] = word_id_set;
+    if (!pickle.ReadInt(iter, &uni_char) ||
+        !ReadIDs(pickle, iter, &word_id_set) ||
+        word_id_set.empty() || word_id_set.front() < 0 ||
+        word_id_set.back() >= word_count) {
+      return false;
+    }
+    char_word_map_[static_cast<char16>(uni_char)].swap(word_id_set);
   }
   return true;
 }
 
-void InMemoryURLIndex::SaveWordIDHistoryMap(InMemoryURLIndexCacheItem* cache)
-    const {
-  if (word_id_history_map_.empty())
-    return;
-  WordIDHistoryMapItem* map_item = cache->mutable_word_id_history_map();
-  map_item->set_item_count(word_id_history_map_.size());
+void InMemoryURLIndex::SaveWordIDHistoryMap(Pickle* pickle) const {
+  pickle->WriteInt(word_id_history_map_.size());
   for (WordIDHistoryMap::const_iterator iter = word_id_history_map_.begin();
        iter != word_id_history_map_.end(); ++iter) {
-    WordIDHistoryMapEntry* map_entry =
-        map_item->add_word_id_history_map_entry();
-    map_entry->set_word_id(iter->first);
-    const HistoryIDSet& history_id_set(iter->second);
-    map_entry->set_item_count(history_id_set.size());
-    for (HistoryIDSet::const_iterator set_iter = history_id_set.begin();
-         set_iter != history_id_set.end(); ++set_iter)
-      map_entry->add_history_id(*set_iter);
+    pickle->WriteInt(iter->first);
+    WriteIDs(iter->second, pickle);
   }
 }
 
-bool InMemoryURLIndex::RestoreWordIDHistoryMap(
-    const InMemoryURLIndexCacheItem& cache) {
-  if (!cache.has_word_id_history_map())
+bool InMemoryURLIndex::RestoreWordIDHistoryMap(const Pickle& pickle,
+                                               void** iter) {
+  int count;
+  if (!pickle.ReadLength(iter, &count))
     return false;
-  const WordIDHistoryMapItem& list_item(cache.word_id_history_map());
-  uint32 expected_item_count = list_item.item_count();
-  uint32 actual_item_count = list_item.word_id_history_map_entry_size();
-  if (actual_item_count == 0 || actual_item_count != expected_item_count)
-    return false;
-  const RepeatedPtrField<WordIDHistoryMapEntry>&
-      entries(list_item.word_id_history_map_entry());
-  for (RepeatedPtrField<WordIDHistoryMapEntry>::const_iterator iter =
-       entries.begin(); iter != entries.end(); ++iter) {
-    expected_item_count = iter->item_count();
-    actual_item_count = iter->history_id_size();
-    if (actual_item_count == 0 || actual_item_count != expected_item_count)
-      return false;
-    WordID word_id = iter->word_id();
+  const WordID word_count = static_cast<WordID>(word_list_.size());
+  for (int i = 0; i < count; ++i) {
+    WordID word_id;
     HistoryIDSet history_id_set;
-    const RepeatedField<int64>& history_ids(iter->history_id());
-    for (RepeatedField<int64>::const_iterator jiter = history_ids.begin();
-         jiter != history_ids.end(); ++jiter)
-      history_id_set.insert(*jiter);
-    word_id_history_map_[word_id] = history_id_set;
+    if (!pickle.ReadInt(iter, &word_id) || word_id < 0 ||
+        word_id >= word_count ||
+        !ReadIDs(pickle, iter, &history_id_set) ||
+        history_id_set.empty()) {
+      return false;
+    }
+    word_id_history_map_[word_id].swap(history_id_set);
   }
   return true;
 }
 
-void InMemoryURLIndex::SaveHistoryInfoMap(
-    InMemoryURLIndexCacheItem* cache) const {
-  if (history_info_map_.empty())
-    return;
-  HistoryInfoMapItem* map_item = cache->mutable_history_info_map();
-  map_item->set_item_count(history_info_map_.size());
+void InMemoryURLIndex::SaveHistoryInfoMap(Pickle* pickle) const {
+  pickle->WriteInt(history_info_map_.size());
   for (HistoryInfoMap::const_iterator iter = history_info_map_.begin();
        iter != history_info_map_.end(); ++iter) {
-    HistoryInfoMapEntry* map_entry = map_item->add_history_info_map_entry();
-    map_entry->set_history_id(iter->first);
     const URLRow& url_row(iter->second);
     // Note: We only save information that contributes to the index so there
     // is no need to save term_char_word_set_cache_ (not persistent),
     // languages_, etc.
-    map_entry->set_visit_count(url_row.visit_count());
-    map_entry->set_typed_count(url_row.typed_count());
-    map_entry->set_last_visit(url_row.last_visit().ToInternalValue());
-    map_entry->set_url(url_row.url().spec());
-    map_entry->set_title(UTF16ToUTF8(url_row.title()));
+    pickle->WriteInt64(iter->first);
+    pickle->WriteInt(url_row.visit_count());
+    pickle->WriteInt(url_row.typed_count());
+    pickle->WriteInt64(url_row.last_visit().ToInternalValue());
+    pickle->WriteString(url_row.url().spec());
+    pickle->WriteString16(url_row.title());
   }
 }
 
-bool InMemoryURLIndex::RestoreHistoryInfoMap(
-    const InMemoryURLIndexCacheItem& cache) {
-  if (!cache.has_history_info_map())
-    return false;
-  const HistoryInfoMapItem& list_item(cache.history_info_map());
-  uint32 expected_item_count = list_item.item_count();
-  uint32 actual_item_count = list_item.history_info_map_entry_size();
-  if (actual_item_count == 0 || actual_item_count != expected_item_count)
+bool InMemoryURLIndex::RestoreHistoryInfoMap(const Pickle& pickle,
+                                             void** iter) {
+  int count;
+  if (!pickle.ReadLength(iter, &count))
     return false;
-  const RepeatedPtrField<HistoryInfoMapEntry>&
-      entries(list_item.history_info_map_entry());
-  for (RepeatedPtrField<HistoryInfoMapEntry>::const_iterator iter =
-       entries.begin(); iter != entries.end(); ++iter) {
-    HistoryID history_id = iter->history_id();
-    GURL url(iter->url());
-    URLRow url_row(url, history_id);
-    url_row.set_visit_count(iter->visit_count());
-    url_row.set_typed_count(iter->typed_count());
-    url_row.set_last_visit(base::Time::FromInternalValue(iter->last_visit()));
-    if (iter->has_title()) {
-      string16 title(UTF8ToUTF16(iter->title()));
-      url_row.set_title(title);
+  for (int i = 0; i < count; ++i) {
+    int64 history_id;
+    int visit_count;
+    int typed_count;
+    int64 last_visit;
+    std::string url;
+    string16 title;
+    if (!pickle.ReadInt64(iter, &history_id) ||
+        !pickle.ReadInt(iter, &visit_count) ||
+        !pickle.ReadInt(iter, &typed_count) ||
+        !pickle.ReadInt64(iter, &last_visit) ||
+        !pickle.ReadString(iter, &url) ||
+        !pickle.ReadString16(iter, &title)) {
+      return false;
     }
+    URLRow url_row(GURL(url), history_id);
+    url_row.set_visit_count(visit_count);
+    url_row.set_typed_count(typed_count);
+    url_row.set_last_visit(base::Time::FromInternalValue(last_visit));
+    url_row.set_title(title);
     history_info_map_[history_id] = url_row;
   }
   return true;
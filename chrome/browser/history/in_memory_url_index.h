@@ -22,23 +22,17 @@
 #include "chrome/browser/autocomplete/autocomplete_match.h"
 #include "chrome/browser/autocomplete/history_provider_util.h"
 #include "chrome/browser/history/history_types.h"
-#include "chrome/browser/history/in_memory_url_index_cache.pb.h"
 #include "testing/gtest/include/gtest/gtest_prod.h"
 
+class Pickle;
 class Profile;
 
 namespace base {
 class Time;
 }
 
-namespace in_memory_url_index {
-class InMemoryURLIndexCacheItem;
-}
-
 namespace history {
 
-namespace imui = in_memory_url_index;
-
 class URLDatabase;
 
 // Specifies where an omnibox term occurs within a string. Used for specifying
@@ -178,6 +172,7 @@ class InMemoryURLIndex {
   friend class AddHistoryMatch;
   FRIEND_TEST_ALL_PREFIXES(LimitedInMemoryURLIndexTest, Initialization);
   FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, CacheFilePath);
+  FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, CacheRestoreRejectsBadData);
   FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, CacheSaveRestore);
   FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, Char16Utilities);
   FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, Scoring);
@@ -202,15 +197,19 @@ class InMemoryURLIndex {
   // A map allowing a WordID to be determined given a word.
   typedef std::map<string16, WordID> WordMap;
 
+  // The ID sets of the index are sorted vectors without duplicates. They
+  // take a fraction of the memory of std::sets, and are intersected by
+  // walking or binary searching contiguous memory rather than trees.
+
   // A map from character to word_ids.
-  typedef std::set<WordID> WordIDSet;  // An index into the WordList.
+  typedef std::vector<WordID> WordIDSet;  // Indices into the WordList.
   typedef std::map<char16, WordIDSet> CharWordIDMap;
 
   // A map from word_id to history item.
   // TODO(mrossetti): URLID is 64 bit: a memory bloat and performance hit.
   // Consider using a smaller type.
   typedef URLID HistoryID;
-  typedef std::set<HistoryID> HistoryIDSet;
+  typedef std::vector<HistoryID> HistoryIDSet;
   typedef std::map<WordID, HistoryIDSet> WordIDHistoryMap;
 
   // Support caching of term character results so that we can optimize
@@ -356,22 +355,22 @@ class InMemoryURLIndex {
   // provided as a hook for unit testing.)
   bool GetCacheFilePath(FilePath* file_path);
 
-  // Encode a data structure into the protobuf |cache|.
-  void SavePrivateData(imui::InMemoryURLIndexCacheItem* cache) const;
-  void SaveWordList(imui::InMemoryURLIndexCacheItem* cache) const;
-  void SaveWordMap(imui::InMemoryURLIndexCacheItem* cache) const;
-  void SaveCharWordMap(imui::InMemoryURLIndexCacheItem* cache) const;
-  void SaveWordIDHistoryMap(imui::InMemoryURLIndexCacheItem* cache) const;
-  void SaveHistoryInfoMap(imui::InMemoryURLIndexCacheItem* cache) const;
-
-  // Decode a data structure from the protobuf |cache|. Return false if there
-  // is any kind of failure.
-  bool RestorePrivateData(const imui::InMemoryURLIndexCacheItem& cache);
-  bool RestoreWordList(const imui::InMemoryURLIndexCacheItem& cache);
-  bool RestoreWordMap(const imui::InMemoryURLIndexCacheItem& cache);
-  bool RestoreCharWordMap(const imui::InMemoryURLIndexCacheItem& cache);
-  bool RestoreWordIDHistoryMap(const imui::InMemoryURLIndexCacheItem& cache);
-  bool RestoreHistoryInfoMap(const imui::InMemoryURLIndexCacheItem& cache);
+  // Encode the index's private data into |pickle|, one table after another.
+  // The word map is the inverse of the word list and so isn't saved.
+  void SavePrivateData(Pickle* pickle) const;
+  void SaveWordList(Pickle* pickle) const;
+  void SaveCharWordMap(Pickle* pickle) const;
+  void SaveWordIDHistoryMap(Pickle* pickle) const;
+  void SaveHistoryInfoMap(Pickle* pickle) const;
+
+  // Decode the index's private data from |pickle|, reading each table from
+  // |iter|. Return false if there is any kind of failure, including a cache
+  // of another version or one whose tables don't agree with each other.
+  bool RestorePrivateData(const Pickle& pickle);
+  bool RestoreWordList(const Pickle& pickle, void** iter);
+  bool RestoreCharWordMap(const Pickle& pickle, void** iter);
+  bool RestoreWordIDHistoryMap(const Pickle& pickle, void** iter);
+  bool RestoreHistoryInfoMap(const Pickle& pickle, void** iter);
 
   // Directory where cache file resides. This is, except when unit testing,
   // the same directory in which the profile's history database is found. It
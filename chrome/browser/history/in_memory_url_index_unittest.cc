@@ -15,6 +15,7 @@
 #include "base/file_util.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/path_service.h"
+#include "base/pickle.h"
 #include "base/string_util.h"
 #include "base/time.h"
 #include "base/utf_string_conversions.h"
@@ -532,12 +533,12 @@ TEST_F(InMemoryURLIndexTest, CacheFilePath) {
 }
 
 TEST_F(InMemoryURLIndexTest, CacheSaveRestore) {
-  // Save the cache to a protobuf, restore it, and compare the results.
+  // Save the cache to a pickle, restore it, and compare the results.
   url_index_.reset(new InMemoryURLIndex(FilePath(FILE_PATH_LITERAL("/dummy"))));
   InMemoryURLIndex& url_index(*(url_index_.get()));
   url_index.Init(this, "en,ja,hi,zh");
-  in_memory_url_index::InMemoryURLIndexCacheItem index_cache;
-  url_index.SavePrivateData(&index_cache);
+  Pickle pickle;
+  url_index.SavePrivateData(&pickle);
 
   // Capture our private data so we can later compare for equality.
   int history_item_count(url_index.history_item_count_);
@@ -567,7 +568,7 @@ TEST_F(InMemoryURLIndexTest, CacheSaveRestore) {
   EXPECT_TRUE(url_index.history_info_map_.empty());
 
   // Restore the cache.
-  EXPECT_TRUE(url_index.RestorePrivateData(index_cache));
+  EXPECT_TRUE(url_index.RestorePrivateData(pickle));
 
   // Compare the restored and captured for equality.
   EXPECT_EQ(history_item_count, url_index.history_item_count_);
@@ -588,9 +589,7 @@ TEST_F(InMemoryURLIndexTest, CacheSaveRestore) {
     const InMemoryURLIndex::WordIDSet& expected_set(expected->second);
     const InMemoryURLIndex::WordIDSet& actual_set(actual->second);
     ASSERT_EQ(expected_set.size(), actual_set.size());
-    for (InMemoryURLIndex::WordIDSet::const_iterator set_iter =
-        expected_set.begin(); set_iter != expected_set.end(); ++set_iter)
-      EXPECT_GT(actual_set.count(*set_iter), 0U);
+    EXPECT_TRUE(expected_set == actual_set);
   }
   for (InMemoryURLIndex::WordIDHistoryMap::const_iterator expected =
       word_id_history_map.begin(); expected != word_id_history_map.end();
@@ -601,9 +600,7 @@ TEST_F(InMemoryURLIndexTest, CacheSaveRestore) {
     const InMemoryURLIndex::HistoryIDSet& expected_set(expected->second);
     const InMemoryURLIndex::HistoryIDSet& actual_set(actual->second);
     ASSERT_EQ(expected_set.size(), actual_set.size());
-    for (InMemoryURLIndex::HistoryIDSet::const_iterator set_iter =
-        expected_set.begin(); set_iter != expected_set.end(); ++set_iter)
-      EXPECT_GT(actual_set.count(*set_iter), 0U);
+    EXPECT_TRUE(expected_set == actual_set);
   }
   for (InMemoryURLIndex::HistoryInfoMap::const_iterator expected =
       history_info_map.begin(); expected != history_info_map.end();
@@ -620,4 +617,41 @@ TEST_F(InMemoryURLIndexTest, CacheSaveRestore) {
   }
 }
 
+TEST_F(InMemoryURLIndexTest, CacheRestoreRejectsBadData) {
+  url_index_.reset(new InMemoryURLIndex(FilePath(FILE_PATH_LITERAL("/dummy"))));
+  InMemoryURLIndex& url_index(*(url_index_.get()));
+  Pickle saved;
+  url_index.SavePrivateData(&saved);
+  EXPECT_TRUE(url_index.RestorePrivateData(saved));
+
+  // A cache of another version is rejected.
+  Pickle other_version;
+  other_version.WriteInt(-1);
+  url_index.ClearPrivateData();
+  EXPECT_FALSE(url_index.RestorePrivateData(other_version));
+
+  // So is one cut short.
+  Pickle truncated;
+  void* iter = NULL;
+  int version;
+  ASSERT_TRUE(saved.ReadInt(&iter, &version));
+  truncated.WriteInt(version);
+  url_index.ClearPrivateData();
+  EXPECT_FALSE(url_index.RestorePrivateData(truncated));
+
+  // And so is one whose character map names a word that isn't in the list.
+  Pickle bad_word;
+  bad_word.WriteInt(version);
+  bad_word.WriteInt64(0);
+  bad_word.WriteInt(0);  // History items.
+  bad_word.WriteInt(0);  // Words.
+  bad_word.WriteInt(1);  // Characters.
+  bad_word.WriteInt('a');
+  bad_word.WriteInt(1);
+  const int word_id = 0;
+  bad_word.WriteBytes(&word_id, sizeof(word_id));
+  url_index.ClearPrivateData();
+  EXPECT_FALSE(url_index.RestorePrivateData(bad_word));
+}
+
 }  // namespace history
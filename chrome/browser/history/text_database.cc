@@ -291,6 +291,38 @@ void TextDatabase::DeletePageData(base::Time time, const std::string& url) {
   }
 }
 
+bool TextDatabase::UpdatePageTime(base::Time old_time,
+                                  base::Time new_time,
+                                  const std::string& url,
+                                  const std::string& title,
+                                  const std::string& contents) {
+  // As in DeletePageData, the time index finds the rows, so the full text
+  // columns are only compared for them.
+  sql::Statement select_id(db_.GetCachedStatement(SQL_FROM_HERE,
+      "SELECT info.rowid "
+      "FROM info JOIN pages ON info.rowid = pages.rowid "
+      "WHERE info.time=? AND pages.url=? AND pages.title=? AND pages.body=?"));
+  if (!select_id)
+    return false;
+  select_id.BindInt64(0, old_time.ToInternalValue());
+  select_id.BindString(1, url);
+  select_id.BindString(2, title);
+  select_id.BindString(3, contents);
+  if (!select_id.Step())
+    return false;
+  int64 rowid = select_id.ColumnInt64(0);
+  select_id.Reset();
+
+  // Only the info table holds the time, so the full text index is untouched.
+  sql::Statement update_time(db_.GetCachedStatement(SQL_FROM_HERE,
+      "UPDATE info SET time=? WHERE rowid=?"));
+  if (!update_time)
+    return false;
+  update_time.BindInt64(0, new_time.ToInternalValue());
+  update_time.BindInt64(1, rowid);
+  return update_time.Run();
+}
+
 void TextDatabase::Optimize() {
   sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE,
       "SELECT OPTIMIZE(pages) FROM pages LIMIT 1"));
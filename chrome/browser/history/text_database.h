@@ -110,6 +110,16 @@ class TextDatabase {
   // Deletes the indexed data exactly matching the given URL/time pair.
   void DeletePageData(base::Time time, const std::string& url);
 
+  // Moves the indexed data for the given URL/time pair to |new_time|, if it
+  // has exactly the given title and contents, saving a delete and re-add of
+  // the same text. Returns true if it was moved. The strings should already be
+  // converted to UTF-8.
+  bool UpdatePageTime(base::Time old_time,
+                      base::Time new_time,
+                      const std::string& url,
+                      const std::string& title,
+                      const std::string& contents);
+
   // Optimizes the tree inside the database. This will, in addition to making
   // access faster, remove any deleted data from the database (normally it is
   // added again as "removed" and it is manually cleaned up when it decides to
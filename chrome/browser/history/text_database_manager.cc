@@ -35,6 +35,16 @@ std::string ConvertStringForIndexer(const string16& input) {
 // haven't gotten a title and/or body.
 const int kExpirationSec = 20;
 
+// Complete pages are indexed once no page has completed for this long, or
+// as soon as this many of them are waiting.
+const int kIndexDelayMs = 2000;
+const int kMaxQueuedPages = 20;
+
+// A database that has had this many pages added is optimized once nothing
+// has been indexed for kOptimizeDelaySec.
+const int kPagesPerOptimize = 100;
+const int kOptimizeDelaySec = 5 * 60;
+
 }  // namespace
 
 // TextDatabaseManager::ChangeSet ----------------------------------------------
@@ -83,10 +93,13 @@ TextDatabaseManager::TextDatabaseManager(const FilePath& dir,
       url_database_(url_database),
       visit_database_(visit_database),
       recent_changes_(RecentChangeList::NO_AUTO_EVICT),
+      queued_pages_(0),
       transaction_nesting_(0),
       db_cache_(DBCache::NO_AUTO_EVICT),
       present_databases_loaded_(false),
       ALLOW_THIS_IN_INITIALIZER_LIST(factory_(this)),
+      ALLOW_THIS_IN_INITIALIZER_LIST(index_factory_(this)),
+      ALLOW_THIS_IN_INITIALIZER_LIST(optimize_factory_(this)),
       history_publisher_(NULL) {
 }
 
@@ -219,15 +232,9 @@ void TextDatabaseManager::AddPageTitle(const GURL& url,
   }
 
   PageInfo& info = found->second;
-  if (info.has_body()) {
-    // This info is complete, write to the database.
-    AddPageData(url, info.url_id(), info.visit_id(), info.visit_time(),
-                title, info.body());
-    recent_changes_.Erase(found);
-    return;
-  }
-
   info.set_title(title);
+  if (info.complete())
+    QueueCompletePage();
 }
 
 void TextDatabaseManager::AddPageContents(const GURL& url,
@@ -255,15 +262,33 @@ void TextDatabaseManager::AddPageContents(const GURL& url,
   }
 
   PageInfo& info = found->second;
-  if (info.has_title()) {
-    // This info is complete, write to the database.
-    AddPageData(url, info.url_id(), info.visit_id(), info.visit_time(),
-                info.title(), body);
-    recent_changes_.Erase(found);
-    return;
-  }
-
   info.set_body(body);
+  if (info.complete())
+    QueueCompletePage();
+}
+
+void TextDatabaseManager::IndexCompletePages() {
+  index_factory_.RevokeAll();
+  queued_pages_ = 0;
+
+  // Index from the oldest, so that the visits are added in order.
+  int indexed = 0;
+  RecentChangeList::reverse_iterator i = recent_changes_.rbegin();
+  while (i != recent_changes_.rend()) {
+    if (!i->second.complete()) {
+      ++i;
+      continue;
+    }
+    if (!indexed++)
+      BeginTransaction();
+    AddPageData(i->first, i->second.url_id(), i->second.visit_id(),
+                i->second.visit_time(), i->second.title(), i->second.body());
+    i = recent_changes_.Erase(i);
+  }
+  if (indexed) {
+    CommitTransaction();
+    UMA_HISTOGRAM_COUNTS_100("History.FTSPagesPerBatch", indexed);
+  }
 }
 
 bool TextDatabaseManager::AddPageData(const GURL& url,
@@ -272,18 +297,26 @@ bool TextDatabaseManager::AddPageData(const GURL& url,
                                       Time visit_time,
                                       const string16& title,
                                       const string16& body) {
-  TextDatabase* db = GetDBForTime(visit_time, true);
+  TextDatabase::DBIdent db_ident = TimeToID(visit_time);
+  TextDatabase* db = GetDB(db_ident, true);
   if (!db)
     return false;
 
   TimeTicks beginning_time = TimeTicks::Now();
 
+  std::string url_str = URLDatabase::GURLToDatabaseURL(url);
+  std::string title_str = ConvertStringForIndexer(title);
+  std::string body_str = ConvertStringForIndexer(body);
+
   // First delete any recently-indexed data for this page. This will delete
   // anything in the main database, but we don't bother looking through the
-  // archived database.
+  // archived database. An entry in the same database with the same title and
+  // body is kept and moved to this visit instead, which saves rewriting the
+  // full text index for pages that haven't changed.
   VisitVector visits;
   visit_database_->GetVisitsForURL(url_id, &visits);
   size_t our_visit_row_index = visits.size();
+  bool reused_entry = false;
   for (size_t i = 0; i < visits.size(); i++) {
     // While we're going trough all the visits, also find our row so we can
     // avoid another DB query.
@@ -292,7 +325,13 @@ bool TextDatabaseManager::AddPageData(const GURL& url,
     } else if (visits[i].is_indexed) {
       visits[i].is_indexed = false;
       visit_database_->UpdateVisitRow(visits[i]);
-      DeletePageData(visits[i].visit_time, url, NULL);
+      if (!reused_entry && TimeToID(visits[i].visit_time) == db_ident &&
+          db->UpdatePageTime(visits[i].visit_time, visit_time, url_str,
+                             title_str, body_str)) {
+        reused_entry = true;
+      } else {
+        DeletePageData(visits[i].visit_time, url, NULL);
+      }
     }
   }
 
@@ -312,13 +351,16 @@ bool TextDatabaseManager::AddPageData(const GURL& url,
   }
 
   // Now index the data.
-  std::string url_str = URLDatabase::GURLToDatabaseURL(url);
-  bool success = db->AddPageData(visit_time, url_str,
-                                 ConvertStringForIndexer(title),
-                                 ConvertStringForIndexer(body));
+  bool success = true;
+  if (!reused_entry) {
+    success = db->AddPageData(visit_time, url_str, title_str, body_str);
+    if (success)
+      NotePageIndexed(db_ident);
+  }
 
   UMA_HISTOGRAM_TIMES("History.AddFTSData",
                       TimeTicks::Now() - beginning_time);
+  UMA_HISTOGRAM_BOOLEAN("History.FTSReusedEntry", reused_entry);
 
   if (history_publisher_)
     history_publisher_->PublishPageContent(visit_time, url, title, body);
@@ -381,6 +423,8 @@ void TextDatabaseManager::DeleteAll() {
 
   // Close all open databases.
   db_cache_.Clear();
+  pages_since_optimize_.clear();
+  optimize_factory_.RevokeAll();
 
   // Now go through and delete all the files.
   for (DBIdentSet::iterator i = present_databases_.begin();
@@ -406,6 +450,7 @@ void TextDatabaseManager::OptimizeChangedDatabases(
     if (!db)
       continue;  // The file may have changed or something.
     db->Optimize();
+    pages_since_optimize_.erase(*i);
   }
 }
 
@@ -416,6 +461,9 @@ void TextDatabaseManager::GetTextMatches(
     Time* first_time_searched) {
   results->clear();
 
+  // Pages waiting to be indexed should be found as well.
+  IndexCompletePages();
+
   InitDBList();
   if (present_databases_.empty()) {
     // Nothing to search.
@@ -555,4 +603,35 @@ void TextDatabaseManager::FlushOldChangesForTime(TimeTicks now) {
   ScheduleFlushOldChanges();
 }
 
+void TextDatabaseManager::QueueCompletePage() {
+  if (++queued_pages_ >= kMaxQueuedPages) {
+    IndexCompletePages();
+    return;
+  }
+  index_factory_.RevokeAll();
+  MessageLoop::current()->PostDelayedTask(FROM_HERE,
+      index_factory_.NewRunnableMethod(
+          &TextDatabaseManager::IndexCompletePages),
+      kIndexDelayMs);
+}
+
+void TextDatabaseManager::NotePageIndexed(TextDatabase::DBIdent id) {
+  pages_since_optimize_[id]++;
+  optimize_factory_.RevokeAll();
+  MessageLoop::current()->PostDelayedTask(FROM_HERE,
+      optimize_factory_.NewRunnableMethod(
+          &TextDatabaseManager::OptimizeIdleDatabases),
+      kOptimizeDelaySec * Time::kMillisecondsPerSecond);
+}
+
+void TextDatabaseManager::OptimizeIdleDatabases() {
+  ChangeSet change_set;
+  for (DBPageCounts::const_iterator i = pages_since_optimize_.begin();
+       i != pages_since_optimize_.end(); ++i) {
+    if (i->second >= kPagesPerOptimize)
+      change_set.Add(i->first);
+  }
+  OptimizeChangedDatabases(change_set);
+}
+
 }  // namespace history
@@ -6,6 +6,7 @@
 #define CHROME_BROWSER_HISTORY_TEXT_DATABASE_MANAGER_H_
 #pragma once
 
+#include <map>
 #include <set>
 #include <vector>
 
@@ -37,6 +38,14 @@ class VisitDatabase;
 // This allows us to minimize inserts and modifications, which are slow for the
 // full text database, since each page's information is added exactly once.
 //
+// Complete pages are not indexed as soon as they arrive either, since that is
+// while the page is loading and the user is waiting. They are queued and
+// indexed together once page loads have been quiet for a moment, or when the
+// queue gets long, or before a query. A page visited again with the same title
+// and body keeps its existing index entry, which just moves to the new visit.
+// Databases that have had many pages added are optimized (which merges their
+// index segments) once indexing has been idle for a while.
+//
 // Note: be careful to delete the relevant entries from this uncommitted list
 // when clearing history or this information may get added to the database soon
 // after the clear.
@@ -118,6 +127,11 @@ class TextDatabaseManager {
                    const string16& title,
                    const string16& body);
 
+  // Indexes the complete pages that are waiting for the indexing timer now.
+  // Called when the pages must be in the database, for example before the
+  // visit database is closed.
+  void IndexCompletePages();
+
   // Deletes the instance of indexed data identified by the given time and URL.
   // Any changes will be tracked in the optional change set for use when calling
   // OptimizeChangedDatabases later. change_set can be NULL.
@@ -162,6 +176,8 @@ class TextDatabaseManager {
   // These tests call ExpireRecentChangesForTime to force expiration.
   FRIEND_TEST_ALL_PREFIXES(TextDatabaseManagerTest, InsertPartial);
   FRIEND_TEST_ALL_PREFIXES(TextDatabaseManagerTest, PartialComplete);
+  FRIEND_TEST_ALL_PREFIXES(TextDatabaseManagerTest, BatchesCompletePages);
+  FRIEND_TEST_ALL_PREFIXES(TextDatabaseManagerTest, RepeatVisitKeepsEntry);
   FRIEND_TEST_ALL_PREFIXES(ExpireHistoryTest, DeleteURLAndFavicon);
   FRIEND_TEST_ALL_PREFIXES(ExpireHistoryTest, FlushRecentURLsUnstarred);
   FRIEND_TEST_ALL_PREFIXES(ExpireHistoryTest,
@@ -189,7 +205,8 @@ class TextDatabaseManager {
     // both the title and body setters will "fix" empty strings to be a space,
     // these indicate if the setter was ever called.
     bool has_title() const { return !title_.empty(); }
-    bool has_body() { return !body_.empty(); }
+    bool has_body() const { return !body_.empty(); }
+    bool complete() const { return has_title() && has_body(); }
 
     // Returns true if this entry was added too long ago and we should give up
     // waiting for more data. The current time is passed in as an argument so we
@@ -247,6 +264,19 @@ class TextDatabaseManager {
   // by the unit tests with fake times.
   void FlushOldChangesForTime(base::TimeTicks now);
 
+  // Called when a page in recent_changes_ has been given both its title and
+  // body. Indexing it is put off until IndexCompletePages() runs, which is
+  // (re)scheduled here, or run now if enough pages are waiting.
+  void QueueCompletePage();
+
+  // Counts a page added to database |id| towards optimizing it, and
+  // (re)schedules OptimizeIdleDatabases.
+  void NotePageIndexed(TextDatabase::DBIdent id);
+
+  // Optimizes the databases that have had enough pages added since they were
+  // last optimized.
+  void OptimizeIdleDatabases();
+
   // Directory holding our index files.
   const FilePath dir_;
 
@@ -265,6 +295,14 @@ class TextDatabaseManager {
   typedef MRUCache<GURL, PageInfo> RecentChangeList;
   RecentChangeList recent_changes_;
 
+  // Pages queued by QueueCompletePage() since the last IndexCompletePages().
+  // Some may since have been deleted from recent_changes_.
+  int queued_pages_;
+
+  // Pages added to each database since it was last optimized.
+  typedef std::map<TextDatabase::DBIdent, int> DBPageCounts;
+  DBPageCounts pages_since_optimize_;
+
   // Nesting levels of transactions. Since sqlite only allows one open
   // transaction, we simulate nested transactions by mapping the outermost one
   // to a real transaction. Since this object never needs to do ROLLBACK, losing
@@ -298,6 +336,12 @@ class TextDatabaseManager {
   // Generates tasks for our periodic checking of expired "recent changes".
   ScopedRunnableMethodFactory<TextDatabaseManager> factory_;
 
+  // Generate the tasks for indexing complete pages, and for optimizing the
+  // databases once indexing is idle. Both are revoked and posted again on
+  // each change, so they only run after a quiet period.
+  ScopedRunnableMethodFactory<TextDatabaseManager> index_factory_;
+  ScopedRunnableMethodFactory<TextDatabaseManager> optimize_factory_;
+
   // This object is created and managed by the history backend. We maintain an
   // opaque pointer to the object for our use.
   // This can be NULL if there are no indexers registered to receive indexing
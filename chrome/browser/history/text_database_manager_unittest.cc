@@ -368,6 +368,107 @@ TEST_F(TextDatabaseManagerTest, PartialComplete) {
   EXPECT_EQ(1U, results.size());
 }
 
+// Tests that complete pages wait to be indexed together.
+TEST_F(TextDatabaseManagerTest, BatchesCompletePages) {
+  ASSERT_TRUE(Init());
+  InMemDB visit_db;
+  TextDatabaseManager manager(dir_, &visit_db, &visit_db);
+  ASSERT_TRUE(manager.Init(NULL));
+
+  VisitRow visit;
+  visit.url_id = 1;
+  visit.visit_time = Time::Now();
+  visit.referring_visit = 0;
+  visit.transition = PageTransition::LINK;
+  visit.segment_id = 0;
+  visit.is_indexed = false;
+  visit_db.AddVisit(&visit, SOURCE_BROWSED);
+
+  const GURL url(kURL2);
+  manager.AddPageURL(url, visit.url_id, visit.visit_id, visit.visit_time);
+  manager.AddPageTitle(url, UTF8ToUTF16(kTitle2));
+  manager.AddPageContents(url, UTF8ToUTF16(kBody2));
+
+  // The page is complete, but not indexed yet.
+  VisitRow out_visit;
+  ASSERT_TRUE(visit_db.GetRowForVisit(visit.visit_id, &out_visit));
+  EXPECT_FALSE(out_visit.is_indexed);
+  EXPECT_EQ(1U, manager.recent_changes_.size());
+
+  manager.IndexCompletePages();
+  ASSERT_TRUE(visit_db.GetRowForVisit(visit.visit_id, &out_visit));
+  EXPECT_TRUE(out_visit.is_indexed);
+  EXPECT_EQ(0U, manager.recent_changes_.size());
+}
+
+// Tests that visiting a page again with the same title and body keeps its
+// indexed entry, moved to the new visit.
+TEST_F(TextDatabaseManagerTest, RepeatVisitKeepsEntry) {
+  ASSERT_TRUE(Init());
+  InMemDB visit_db;
+  TextDatabaseManager manager(dir_, &visit_db, &visit_db);
+  ASSERT_TRUE(manager.Init(NULL));
+
+  Time::Exploded exploded;
+  memset(&exploded, 0, sizeof(Time::Exploded));
+  exploded.year = 2008;
+  exploded.month = 1;
+  exploded.day_of_month = 3;
+
+  VisitRow first_visit;
+  first_visit.url_id = 1;
+  first_visit.visit_time = Time::FromUTCExploded(exploded);
+  first_visit.referring_visit = 0;
+  first_visit.transition = 0;
+  first_visit.segment_id = 0;
+  first_visit.is_indexed = false;
+  visit_db.AddVisit(&first_visit, SOURCE_BROWSED);
+  EXPECT_TRUE(manager.AddPageData(GURL(kURL1), first_visit.url_id,
+                                  first_visit.visit_id, first_visit.visit_time,
+                                  UTF8ToUTF16(kTitle1), UTF8ToUTF16(kBody1)));
+
+  exploded.day_of_month++;
+  VisitRow second_visit(first_visit);
+  second_visit.visit_time = Time::FromUTCExploded(exploded);
+  visit_db.AddVisit(&second_visit, SOURCE_BROWSED);
+  EXPECT_TRUE(manager.AddPageData(GURL(kURL1), second_visit.url_id,
+                                  second_visit.visit_id,
+                                  second_visit.visit_time,
+                                  UTF8ToUTF16(kTitle1), UTF8ToUTF16(kBody1)));
+
+  // Only the second visit is indexed, and the text was only added once.
+  VisitRow out_visit;
+  ASSERT_TRUE(visit_db.GetRowForVisit(first_visit.visit_id, &out_visit));
+  EXPECT_FALSE(out_visit.is_indexed);
+  ASSERT_TRUE(visit_db.GetRowForVisit(second_visit.visit_id, &out_visit));
+  EXPECT_TRUE(out_visit.is_indexed);
+  TextDatabase::DBIdent id =
+      TextDatabaseManager::TimeToID(first_visit.visit_time);
+  EXPECT_EQ(1, manager.pages_since_optimize_[id]);
+
+  QueryOptions options;
+  std::vector<TextDatabase::Match> results;
+  Time first_time_searched;
+  manager.GetTextMatches(UTF8ToUTF16("FOO"), options,
+                         &results, &first_time_searched);
+  ASSERT_EQ(1U, results.size());
+  EXPECT_TRUE(results[0].time == second_visit.visit_time);
+
+  // A changed body is indexed again.
+  exploded.day_of_month++;
+  VisitRow third_visit(first_visit);
+  third_visit.visit_time = Time::FromUTCExploded(exploded);
+  visit_db.AddVisit(&third_visit, SOURCE_BROWSED);
+  EXPECT_TRUE(manager.AddPageData(GURL(kURL1), third_visit.url_id,
+                                  third_visit.visit_id, third_visit.visit_time,
+                                  UTF8ToUTF16(kTitle1), UTF8ToUTF16(kBody2)));
+  EXPECT_EQ(2, manager.pages_since_optimize_[id]);
+  manager.GetTextMatches(UTF8ToUTF16("FOO"), options,
+                         &results, &first_time_searched);
+  ASSERT_EQ(1U, results.size());
+  EXPECT_TRUE(results[0].time == third_visit.visit_time);
+}
+
 // Tests that changes get properly committed to disk.
 TEST_F(TextDatabaseManagerTest, Writing) {
   ASSERT_TRUE(Init());
@@ -10,6 +10,7 @@
 #include "base/debug/leak_tracker.h"
 #include "base/logging.h"
 #include "base/metrics/field_trial.h"
+#include "base/path_service.h"
 #include "base/stl_util-inl.h"
 #include "base/string_number_conversions.h"
 #include "base/string_split.h"
@@ -21,11 +22,14 @@
 #include "chrome/browser/net/chrome_net_log.h"
 #include "chrome/browser/net/chrome_url_request_context.h"
 #include "chrome/browser/net/connect_interceptor.h"
+#include "chrome/browser/net/host_cache_persister.h"
 #include "chrome/browser/net/passive_log_collector.h"
 #include "chrome/browser/net/predictor_api.h"
 #include "chrome/browser/net/pref_proxy_config_service.h"
 #include "chrome/browser/net/proxy_service_factory.h"
 #include "chrome/browser/prefs/pref_service.h"
+#include "chrome/common/chrome_constants.h"
+#include "chrome/common/chrome_paths.h"
 #include "chrome/common/chrome_switches.h"
 #include "chrome/common/net/raw_host_resolver_proc.h"
 #include "chrome/common/net/url_fetcher.h"
@@ -33,6 +37,7 @@
 #include "content/browser/browser_thread.h"
 #include "content/browser/gpu_process_host.h"
 #include "content/browser/in_process_webkit/indexed_db_key_utility_client.h"
+#include "net/base/async_dns_resolver.h"
 #include "net/base/cert_verifier.h"
 #include "net/base/cookie_monster.h"
 #include "net/base/dnsrr_resolver.h"
@@ -47,6 +52,7 @@
 #include "net/http/http_auth_handler_factory.h"
 #include "net/http/http_network_layer.h"
 #include "net/http/http_network_session.h"
+#include "net/http/network_tuner.h"
 #if defined(USE_NSS)
 #include "net/ocsp/nss_ocsp.h"
 #endif  // defined(USE_NSS)
@@ -66,6 +72,9 @@ class URLRequestContextWithUserAgent : public net::URLRequestContext {
   }
 };
 
+// The number of concurrent lookups with --enable-async-dns.
+const size_t kAsyncDnsParallelism = 64;
+
 net::HostResolver* CreateGlobalHostResolver(net::NetLog* net_log) {
   const CommandLine& command_line = *CommandLine::ForCurrentProcess();
 
@@ -83,6 +92,10 @@ net::HostResolver* CreateGlobalHostResolver(net::NetLog* net_log) {
     } else {
       LOG(ERROR) << "Invalid switch for host resolver parallelism: " << s;
     }
+  } else if (command_line.HasSwitch(switches::kEnableAsyncDns)) {
+    // Asynchronous lookups don't hold a thread each, so many more of them can
+    // be in flight.
+    parallelism = kAsyncDnsParallelism;
   } else {
     // Set up a field trial to see what impact the total number of concurrent
     // resolutions have on DNS resolutions.
@@ -141,6 +154,31 @@ net::HostResolver* CreateGlobalHostResolver(net::NetLog* net_log) {
   net::HostResolver* global_host_resolver =
       net::CreateSystemHostResolver(parallelism, resolver_proc.get(), net_log);
 
+  if (command_line.HasSwitch(switches::kEnableAsyncDns)) {
+    net::HostResolverImpl* host_resolver_impl =
+        global_host_resolver->GetAsHostResolverImpl();
+    if (host_resolver_impl != NULL) {
+      net::AsyncDnsResolver* async_resolver =
+          new net::AsyncDnsResolver(net_log);
+      async_resolver->LoadSystemConfig();
+      host_resolver_impl->SetAsyncDnsResolver(async_resolver);
+    }
+  }
+
+  if (command_line.HasSwitch(switches::kHostResolverStaleGrace)) {
+    std::string s =
+        command_line.GetSwitchValueASCII(switches::kHostResolverStaleGrace);
+    net::HostResolverImpl* host_resolver_impl =
+        global_host_resolver->GetAsHostResolverImpl();
+    int seconds;
+    if (!base::StringToInt(s, &seconds) || seconds < 0) {
+      LOG(ERROR) << "Invalid switch for host resolver stale grace: " << s;
+    } else if (host_resolver_impl != NULL && host_resolver_impl->cache()) {
+      host_resolver_impl->cache()->set_stale_grace_period(
+          base::TimeDelta::FromSeconds(seconds));
+    }
+  }
+
   // Determine if we should disable IPv6 support.
   if (!command_line.HasSwitch(switches::kEnableIPv6)) {
     if (command_line.HasSwitch(switches::kDisableIPv6)) {
@@ -314,6 +352,9 @@ IOThread::IOThread(
   pref_proxy_config_tracker_ = new PrefProxyConfigTracker(local_state);
   ChromeNetworkDelegate::InitializeReferrersEnabled(&system_enable_referrers_,
                                                     local_state);
+  FilePath user_data_dir;
+  if (PathService::Get(chrome::DIR_USER_DATA, &user_data_dir))
+    host_cache_path_ = user_data_dir.Append(chrome::kHostCacheFilename);
 }
 
 IOThread::~IOThread() {
@@ -385,6 +426,15 @@ void IOThread::ChangedToOnTheRecord() {
           &IOThread::ChangedToOnTheRecordOnIOThread));
 }
 
+void IOThread::ChangedToOffTheRecord() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  message_loop()->PostTask(
+      FROM_HERE,
+      NewRunnableMethod(
+          this,
+          &IOThread::ChangedToOffTheRecordOnIOThread));
+}
+
 net::URLRequestContextGetter* IOThread::system_url_request_context_getter() {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
   if (!system_url_request_context_getter_) {
@@ -422,6 +472,10 @@ void IOThread::Init() {
   DCHECK(!globals_);
   globals_ = new Globals;
 
+  // The socket pools only read their limits when they are created, so the
+  // tuning has to be in place before any session is.
+  globals_->network_tuner.reset(new net::NetworkTuner);
+
   // Add an observer that will emit network change events to the ChromeNetLog.
   // Assuming NetworkChangeNotifier dispatches in FIFO order, we should be
   // logging the network change before other IO thread consumers respond to it.
@@ -439,6 +493,13 @@ void IOThread::Init() {
       CreateGlobalHostResolver(net_log_));
   globals_->cert_verifier.reset(new net::CertVerifier);
   globals_->dnsrr_resolver.reset(new net::DnsRRResolver);
+  net::HostResolverImpl* host_resolver_impl =
+      globals_->host_resolver->GetAsHostResolverImpl();
+  if (host_resolver_impl != NULL && host_resolver_impl->async_dns_resolver()) {
+    // The record lookups share the transport of the address lookups.
+    globals_->dnsrr_resolver->set_async_dns_resolver(
+        host_resolver_impl->async_dns_resolver());
+  }
   // TODO(willchan): Use the real SSLConfigService.
   globals_->ssl_config_service =
       net::SSLConfigService::CreateSystemSSLConfigService();
@@ -464,6 +525,8 @@ void IOThread::Init() {
   globals_->proxy_script_fetcher_ftp_transaction_factory.reset(
       new net::FtpNetworkLayer(globals_->host_resolver.get()));
 
+  InitHostCachePersister();
+
   scoped_refptr<net::URLRequestContext> proxy_script_fetcher_context =
       ConstructProxyScriptFetcherContext(globals_, net_log_);
   globals_->proxy_script_fetcher_context = proxy_script_fetcher_context;
@@ -524,6 +587,11 @@ void IOThread::CleanUp() {
   delete speculative_interceptor_;
   speculative_interceptor_ = NULL;
 
+  if (host_cache_persister_) {
+    host_cache_persister_->Shutdown();
+    host_cache_persister_ = NULL;
+  }
+
   // TODO(eroman): hack for http://crbug.com/15513
   if (globals_->host_resolver->GetAsHostResolverImpl()) {
     globals_->host_resolver.get()->GetAsHostResolverImpl()->Shutdown();
@@ -623,12 +691,40 @@ void IOThread::ChangedToOnTheRecordOnIOThread() {
   // in about:net-internals.
   ClearHostCache();
 
+  // The cleared cache can be saved again.
+  if (host_cache_persister_)
+    host_cache_persister_->SetOffTheRecord(false);
+
   // Clear all of the passively logged data.
   // TODO(eroman): this is a bit heavy handed, really all we need to do is
   //               clear the data pertaining to incognito context.
   net_log_->ClearAllPassivelyCapturedEvents();
 }
 
+void IOThread::ChangedToOffTheRecordOnIOThread() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  // Keep the hosts visited off the record from being written to disk.
+  if (host_cache_persister_)
+    host_cache_persister_->SetOffTheRecord(true);
+}
+
+void IOThread::InitHostCachePersister() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  net::HostResolverImpl* host_resolver_impl =
+      globals_->host_resolver->GetAsHostResolverImpl();
+  if (!host_resolver_impl || host_cache_path_.empty())
+    return;
+
+  // The saved entries are only ever served stale.
+  net::HostCache* host_cache = host_resolver_impl->cache();
+  if (!host_cache || host_cache->stale_grace_period() <= base::TimeDelta())
+    return;
+
+  host_cache_persister_ = new HostCachePersister(host_cache_path_);
+  host_cache_persister_->Initialize(host_cache);
+}
+
 void IOThread::ClearHostCache() {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
 
@@ -9,6 +9,7 @@
 #include <list>
 #include <string>
 #include "base/basictypes.h"
+#include "base/file_path.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "chrome/browser/browser_process_sub_thread.h"
@@ -19,6 +20,7 @@
 class ChromeNetLog;
 class ChromeURLRequestContextGetter;
 class ExtensionEventRouterForwarder;
+class HostCachePersister;
 class ListValue;
 class PrefProxyConfigTracker;
 class PrefService;
@@ -37,6 +39,7 @@ class HostResolver;
 class HttpAuthHandlerFactory;
 class HttpTransactionFactory;
 class NetworkDelegate;
+class NetworkTuner;
 class ProxyConfigService;
 class ProxyScriptFetcher;
 class ProxyService;
@@ -75,6 +78,9 @@ class IOThread : public BrowserProcessSubThread {
     scoped_refptr<net::URLRequestContext> system_request_context;
     scoped_refptr<ExtensionEventRouterForwarder>
         extension_event_router_forwarder;
+    // Follows the connection type, for the socket limits and timeouts of the
+    // whole network stack.
+    scoped_ptr<net::NetworkTuner> network_tuner;
   };
 
   // |net_log| must either outlive the IOThread or be NULL.
@@ -119,6 +125,10 @@ class IOThread : public BrowserProcessSubThread {
   // Handles changing to On The Record mode, discarding confidential data.
   void ChangedToOnTheRecord();
 
+  // Handles changing to Off The Record mode, when the first off the record
+  // window opens.
+  void ChangedToOffTheRecord();
+
   // Returns a getter for the URLRequestContext.  Only called on the UI thread.
   net::URLRequestContextGetter* system_url_request_context_getter();
 
@@ -154,6 +164,10 @@ class IOThread : public BrowserProcessSubThread {
       bool preconnect_enabled);
 
   void ChangedToOnTheRecordOnIOThread();
+  void ChangedToOffTheRecordOnIOThread();
+
+  // Starts saving the host cache across restarts, if it can be served stale.
+  void InitHostCachePersister();
 
   // Clears the host cache.  Intended to be used to prevent exposing recently
   // visited sites on about:net-internals/#dns and about:dns pages.  Must be
@@ -192,6 +206,9 @@ class IOThread : public BrowserProcessSubThread {
   std::string auth_delegate_whitelist_;
   std::string gssapi_library_name_;
 
+  // Where the host cache is saved across restarts.
+  FilePath host_cache_path_;
+
   // These member variables are initialized by a task posted to the IO thread,
   // which gets posted by calling certain member functions of IOThread.
 
@@ -202,6 +219,9 @@ class IOThread : public BrowserProcessSubThread {
   chrome_browser_net::ConnectInterceptor* speculative_interceptor_;
   chrome_browser_net::Predictor* predictor_;
 
+  // Initialized in Init(), if the host cache is saved.
+  scoped_refptr<HostCachePersister> host_cache_persister_;
+
   scoped_ptr<net::ProxyConfigService> system_proxy_config_service_;
 
   scoped_refptr<PrefProxyConfigTracker> pref_proxy_config_tracker_;
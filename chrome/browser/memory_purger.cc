@@ -9,6 +9,7 @@
 #include "base/threading/thread.h"
 #include "chrome/browser/browser_process.h"
 #include "chrome/browser/history/history.h"
+#include "chrome/browser/net/chrome_net_log.h"
 #include "chrome/browser/profiles/profile_manager.h"
 #include "chrome/browser/safe_browsing/safe_browsing_service.h"
 #include "chrome/browser/ui/browser_list.h"
@@ -19,7 +20,6 @@
 #include "content/browser/renderer_host/render_process_host.h"
 #include "content/browser/renderer_host/resource_dispatcher_host.h"
 #include "content/common/notification_service.h"
-#include "net/proxy/proxy_resolver.h"
 #include "net/url_request/url_request_context.h"
 #include "net/url_request/url_request_context_getter.h"
 #include "third_party/tcmalloc/chromium/src/google/malloc_extension.h"
@@ -58,12 +58,18 @@ void PurgeMemoryIOHelper::AddRequestContextGetter(
 }
 
 void PurgeMemoryIOHelper::PurgeMemoryOnIOThread() {
-  // Ask ProxyServices to purge any memory they can (generally garbage in the
-  // wrapped ProxyResolver's JS engine).
+  // Ask the network stacks to give back everything they can rebuild: host
+  // and HTTP memory caches, idle sockets and SPDY sessions, SSL sessions,
+  // and garbage in the ProxyResolvers' JS engines.
   for (RequestContextGetters::const_iterator i(
            request_context_getters_.begin());
-       i != request_context_getters_.end(); ++i)
-    (*i)->GetURLRequestContext()->proxy_service()->PurgeMemory();
+       i != request_context_getters_.end(); ++i) {
+    (*i)->GetURLRequestContext()->PurgeMemory(
+        net::MEMORY_PRESSURE_CRITICAL);
+  }
+
+  // The passively captured events are only kept for about:net-internals.
+  g_browser_process->net_log()->ClearAllPassivelyCapturedEvents();
 
   // Close the Safe Browsing database, freeing memory used to cache sqlite as
   // well as a number of in-memory structures.
@@ -0,0 +1,104 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/net/alternate_protocols_persister.h"
+
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/message_loop.h"
+#include "content/browser/browser_thread.h"
+
+namespace {
+
+// How long the changes to the map are coalesced before being written.
+const int kSaveDelayMs = 10 * 1000;
+
+}  // namespace
+
+AlternateProtocolsPersister::AlternateProtocolsPersister(
+    const FilePath& state_file)
+    : ALLOW_THIS_IN_INITIALIZER_LIST(save_coalescer_(this)),
+      protocols_(NULL),
+      state_file_(state_file) {
+}
+
+AlternateProtocolsPersister::~AlternateProtocolsPersister() {
+  DCHECK(!protocols_);
+}
+
+void AlternateProtocolsPersister::Initialize(
+    net::HttpAlternateProtocols* protocols) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  DCHECK(!protocols_);
+  protocols_ = protocols;
+  protocols_->set_delegate(this);
+
+  BrowserThread::PostTask(BrowserThread::FILE, FROM_HERE,
+      NewRunnableMethod(this, &AlternateProtocolsPersister::Load));
+}
+
+void AlternateProtocolsPersister::Shutdown() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if (!protocols_)
+    return;
+
+  if (!save_coalescer_.empty()) {
+    save_coalescer_.RevokeAll();
+    Save();
+  }
+  protocols_->set_delegate(NULL);
+  protocols_ = NULL;
+}
+
+void AlternateProtocolsPersister::ProtocolsAreDirty(
+    net::HttpAlternateProtocols* protocols) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  DCHECK(protocols == protocols_);
+
+  if (!save_coalescer_.empty())
+    return;
+
+  MessageLoop::current()->PostDelayedTask(FROM_HERE,
+      save_coalescer_.NewRunnableMethod(&AlternateProtocolsPersister::Save),
+      kSaveDelayMs);
+}
+
+void AlternateProtocolsPersister::Load() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+
+  std::string state;
+  if (!file_util::ReadFileToString(state_file_, &state))
+    return;
+
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
+      NewRunnableMethod(this, &AlternateProtocolsPersister::CompleteLoad,
+                        state));
+}
+
+void AlternateProtocolsPersister::CompleteLoad(const std::string& state) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if (!protocols_)
+    return;
+
+  if (!protocols_->LoadEntries(state))
+    LOG(WARNING) << "Failed to load the saved alternate protocols";
+}
+
+void AlternateProtocolsPersister::Save() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  DCHECK(protocols_);
+
+  std::string state;
+  protocols_->Serialize(&state);
+
+  BrowserThread::PostTask(BrowserThread::FILE, FROM_HERE,
+      NewRunnableMethod(this, &AlternateProtocolsPersister::CompleteSave,
+                        state));
+}
+
+void AlternateProtocolsPersister::CompleteSave(const std::string& state) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+
+  file_util::WriteFile(state_file_, state.data(), state.size());
+}
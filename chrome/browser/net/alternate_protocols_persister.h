@@ -0,0 +1,63 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// AlternateProtocolsPersister keeps the Alternate-Protocol announcements of
+// HTTP servers across restarts, so that the first request to a server that is
+// known to speak SPDY can race a SPDY connection right away.
+//
+// The map is loaded on the file thread when the network session is created,
+// and merged into its HttpAlternateProtocols on the IO thread. Changes are
+// coalesced for a while before being written on the file thread.
+
+#ifndef CHROME_BROWSER_NET_ALTERNATE_PROTOCOLS_PERSISTER_H_
+#define CHROME_BROWSER_NET_ALTERNATE_PROTOCOLS_PERSISTER_H_
+#pragma once
+
+#include <string>
+
+#include "base/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/task.h"
+#include "net/http/http_alternate_protocols.h"
+
+class AlternateProtocolsPersister
+    : public base::RefCountedThreadSafe<AlternateProtocolsPersister>,
+      public net::HttpAlternateProtocols::Delegate {
+ public:
+  explicit AlternateProtocolsPersister(const FilePath& state_file);
+
+  // Starts loading the saved map into |protocols|, and saving its changes.
+  // Must be called on the IO thread.
+  void Initialize(net::HttpAlternateProtocols* protocols);
+
+  // Writes the pending changes and stops using the map. Must be called on
+  // the IO thread before the map goes away.
+  void Shutdown();
+
+  // net::HttpAlternateProtocols::Delegate implementation:
+  virtual void ProtocolsAreDirty(net::HttpAlternateProtocols* protocols);
+
+ private:
+  friend class base::RefCountedThreadSafe<AlternateProtocolsPersister>;
+
+  virtual ~AlternateProtocolsPersister();
+
+  void Load();
+  void CompleteLoad(const std::string& state);
+
+  void Save();
+  void CompleteSave(const std::string& state);
+
+  // Used on the IO thread to coalesce writes to disk.
+  ScopedRunnableMethodFactory<AlternateProtocolsPersister> save_coalescer_;
+
+  net::HttpAlternateProtocols* protocols_;  // IO thread only.
+
+  // The path to the file in which we store the serialised map.
+  const FilePath state_file_;
+
+  DISALLOW_COPY_AND_ASSIGN(AlternateProtocolsPersister);
+};
+
+#endif  // CHROME_BROWSER_NET_ALTERNATE_PROTOCOLS_PERSISTER_H_
@@ -8,6 +8,7 @@
 
 #include "base/command_line.h"
 #include "base/logging.h"
+#include "base/stl_util-inl.h"
 #include "base/string_util.h"
 #include "base/values.h"
 #include "chrome/browser/net/load_timing_observer.h"
@@ -15,6 +16,97 @@
 #include "chrome/browser/net/passive_log_collector.h"
 #include "chrome/common/chrome_switches.h"
 
+// The events of one thread, on their way to PassiveLogCollector.  Events are
+// written by that thread only, and read with |lock_| acquired, so the two
+// share only the indices, which are updated with barriers instead of a lock.
+class ChromeNetLog::EventRing {
+ public:
+  // A power of two, so that the indices can wrap around.
+  static const uint32 kCapacity = 256;
+
+  EventRing() : read_index_(0), write_index_(0) {}
+
+  ~EventRing() {
+    for (uint32 i = read_index_; i != write_index_; ++i) {
+      if (events_[i % kCapacity].params)
+        events_[i % kCapacity].params->Release();
+    }
+  }
+
+  // Called on the thread of the ring.  Returns false if it is full.
+  bool Push(net::NetLog::EventType type,
+            const base::TimeTicks& time,
+            const net::NetLog::Source& source,
+            net::NetLog::EventPhase phase,
+            net::NetLog::EventParameters* params) {
+    uint32 write_index = base::subtle::NoBarrier_Load(&write_index_);
+    uint32 read_index = base::subtle::Acquire_Load(&read_index_);
+    if (write_index - read_index == kCapacity)
+      return false;
+
+    Event& event = events_[write_index % kCapacity];
+    event.type = type;
+    event.time = time;
+    event.source = source;
+    event.phase = phase;
+    event.params = params;
+    if (params)
+      params->AddRef();
+    base::subtle::Release_Store(&write_index_, write_index + 1);
+    return true;
+  }
+
+  // Called with |lock_| acquired.  Returns false if the ring is empty, or
+  // sets |time| to the time of its oldest event.
+  bool GetOldestEventTime(base::TimeTicks* time) const {
+    uint32 read_index = base::subtle::NoBarrier_Load(&read_index_);
+    uint32 write_index = base::subtle::Acquire_Load(&write_index_);
+    if (read_index == write_index)
+      return false;
+    *time = events_[read_index % kCapacity].time;
+    return true;
+  }
+
+  // Called with |lock_| acquired, when the ring isn't empty.  Passes its
+  // oldest event to |observer| and removes it.
+  void PassOldestEvent(ChromeNetLog::ThreadSafeObserver* observer) {
+    uint32 read_index = base::subtle::NoBarrier_Load(&read_index_);
+    DCHECK_NE(read_index,
+              static_cast<uint32>(base::subtle::Acquire_Load(&write_index_)));
+    Event& event = events_[read_index % kCapacity];
+    observer->OnAddEntry(event.type, event.time, event.source, event.phase,
+                         event.params);
+    if (event.params) {
+      event.params->Release();
+      event.params = NULL;
+    }
+    base::subtle::Release_Store(&read_index_, read_index + 1);
+  }
+
+ private:
+  // Unlike ChromeNetLog::Entry, it holds its reference to |params| by hand,
+  // so that it can be written in place.
+  struct Event {
+    net::NetLog::EventType type;
+    base::TimeTicks time;
+    net::NetLog::Source source;
+    net::NetLog::EventPhase phase;
+    net::NetLog::EventParameters* params;
+  };
+
+  Event events_[kCapacity];
+
+  // Number of events read and written.  Only the reader changes
+  // |read_index_|, and only the writer changes |write_index_|.
+  base::subtle::Atomic32 read_index_;
+  base::subtle::Atomic32 write_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(EventRing);
+};
+
+// static
+const uint32 ChromeNetLog::EventRing::kCapacity;
+
 ChromeNetLog::ThreadSafeObserver::ThreadSafeObserver(LogLevel log_level)
     : net_log_(NULL),
       log_level_(log_level) {
@@ -61,24 +153,31 @@ ChromeNetLog::ChromeNetLog()
     : last_id_(0),
       log_level_(LOG_BASIC),
       passive_collector_(new PassiveLogCollector),
-      load_timing_observer_(new LoadTimingObserver) {
-  AddObserver(passive_collector_.get());
-  AddObserver(load_timing_observer_.get());
+      load_timing_observer_(new LoadTimingObserver),
+      num_observers_(0) {
+  passive_collector_->net_log_ = this;
+  load_timing_observer_->net_log_ = this;
+  {
+    base::AutoLock lock(lock_);
+    UpdateLogLevel_();
+  }
 
   const CommandLine& command_line = *CommandLine::ForCurrentProcess();
   if (command_line.HasSwitch(switches::kLogNetLog)) {
     net_log_logger_.reset(new NetLogLogger(
-            command_line.GetSwitchValuePath(switches::kLogNetLog)));
+            command_line.GetSwitchValuePath(switches::kLogNetLog),
+            command_line.HasSwitch(switches::kLogNetLogBinary)));
     AddObserver(net_log_logger_.get());
   }
 }
 
 ChromeNetLog::~ChromeNetLog() {
-  RemoveObserver(passive_collector_.get());
-  RemoveObserver(load_timing_observer_.get());
+  passive_collector_->net_log_ = NULL;
+  load_timing_observer_->net_log_ = NULL;
   if (net_log_logger_.get()) {
     RemoveObserver(net_log_logger_.get());
   }
+  STLDeleteElements(&event_rings_);
 }
 
 void ChromeNetLog::AddEntry(EventType type,
@@ -86,6 +185,19 @@ void ChromeNetLog::AddEntry(EventType type,
                             const Source& source,
                             EventPhase phase,
                             EventParameters* params) {
+  load_timing_observer_->OnAddEntry(type, time, source, phase, params);
+
+  EventRing* event_ring = GetEventRingForCurrentThread();
+  if (!event_ring->Push(type, time, source, phase, params)) {
+    base::AutoLock lock(lock_);
+    DrainEventRings();
+    bool pushed = event_ring->Push(type, time, source, phase, params);
+    DCHECK(pushed);
+  }
+
+  if (base::subtle::Acquire_Load(&num_observers_) == 0)
+    return;
+
   base::AutoLock lock(lock_);
 
   // Notify all of the log observers.
@@ -112,23 +224,27 @@ void ChromeNetLog::RemoveObserver(ThreadSafeObserver* observer) {
   DCHECK_EQ(observer->net_log_, this);
   observer->net_log_ = NULL;
   observers_.RemoveObserver(observer);
+  base::subtle::Release_Store(&num_observers_, observers_.size());
   UpdateLogLevel_();
 }
 
 void ChromeNetLog::AddObserverAndGetAllPassivelyCapturedEvents(
     ThreadSafeObserver* observer, EntryList* passive_entries) {
   base::AutoLock lock(lock_);
+  DrainEventRings();
   AddObserverWhileLockHeld(observer);
   passive_collector_->GetAllCapturedEvents(passive_entries);
 }
 
 void ChromeNetLog::GetAllPassivelyCapturedEvents(EntryList* passive_entries) {
   base::AutoLock lock(lock_);
+  DrainEventRings();
   passive_collector_->GetAllCapturedEvents(passive_entries);
 }
 
 void ChromeNetLog::ClearAllPassivelyCapturedEvents() {
   base::AutoLock lock(lock_);
+  DrainEventRings();
   passive_collector_->Clear();
 }
 
@@ -137,7 +253,8 @@ void ChromeNetLog::UpdateLogLevel_() {
 
   // Look through all the observers and find the finest granularity
   // log level (higher values of the enum imply *lower* log levels).
-  LogLevel new_log_level = LOG_BASIC;
+  LogLevel new_log_level = std::min(passive_collector_->log_level(),
+                                    load_timing_observer_->log_level());
   ObserverListBase<ThreadSafeObserver>::Iterator it(observers_);
   ThreadSafeObserver* observer;
   while ((observer = it.GetNext()) != NULL) {
@@ -150,5 +267,39 @@ void ChromeNetLog::AddObserverWhileLockHeld(ThreadSafeObserver* observer) {
   DCHECK(!observer->net_log_);
   observer->net_log_ = this;
   observers_.AddObserver(observer);
+  base::subtle::Release_Store(&num_observers_, observers_.size());
   UpdateLogLevel_();
 }
+
+ChromeNetLog::EventRing* ChromeNetLog::GetEventRingForCurrentThread() {
+  EventRing* event_ring = event_ring_.Get();
+  if (!event_ring) {
+    event_ring = new EventRing;
+    event_ring_.Set(event_ring);
+    base::AutoLock lock(lock_);
+    event_rings_.push_back(event_ring);
+  }
+  return event_ring;
+}
+
+void ChromeNetLog::DrainEventRings() {
+  lock_.AssertAcquired();
+
+  // Merge the rings by time, so that the events of different threads reach
+  // |passive_collector_| in about the order they were added.
+  while (true) {
+    EventRing* oldest_ring = NULL;
+    base::TimeTicks oldest_time;
+    for (size_t i = 0; i < event_rings_.size(); ++i) {
+      base::TimeTicks time;
+      if (event_rings_[i]->GetOldestEventTime(&time) &&
+          (!oldest_ring || time < oldest_time)) {
+        oldest_ring = event_rings_[i];
+        oldest_time = time;
+      }
+    }
+    if (!oldest_ring)
+      break;
+    oldest_ring->PassOldestEvent(passive_collector_.get());
+  }
+}
@@ -12,6 +12,7 @@
 #include "base/memory/scoped_ptr.h"
 #include "base/observer_list.h"
 #include "base/synchronization/lock.h"
+#include "base/threading/thread_local.h"
 #include "base/time.h"
 #include "net/base/net_log.h"
 
@@ -30,6 +31,13 @@ class PassiveLogCollector;
 // will keep track of recent request information (which used when displaying
 // the about:net-internals page).
 //
+// Since PassiveLogCollector is always attached, it is not called as events
+// are added.  Instead, each thread writes its events to a ring buffer of its
+// own without locking, and the rings are drained into PassiveLogCollector
+// when one is full, or when its events are asked for.  Only added observers
+// are called as events are added, with |lock_| held, and only while there
+// are any.
+//
 class ChromeNetLog : public net::NetLog {
  public:
   // This structure encapsulates all of the parameters of an event,
@@ -120,8 +128,9 @@ class ChromeNetLog : public net::NetLog {
 
   // Adds |observer| and writes all passively captured events to
   // |passive_entries|. Guarantees that no events in |passive_entries| will be
-  // sent to |observer| and all future events that have yet been sent to the
-  // PassiveLogCollector will be sent to |observer|.
+  // sent to |observer|.  Events added after this returns will be sent to
+  // |observer|.  Events added by other threads while it runs may be in
+  // neither.
   void AddObserverAndGetAllPassivelyCapturedEvents(ThreadSafeObserver* observer,
                                                    EntryList* passive_entries);
 
@@ -134,8 +143,18 @@ class ChromeNetLog : public net::NetLog {
   }
 
  private:
+  class EventRing;
+
   void AddObserverWhileLockHeld(ThreadSafeObserver* observer);
 
+  // Returns the ring the current thread writes its events to, creating it
+  // on the first call from the thread.
+  EventRing* GetEventRingForCurrentThread();
+
+  // Passes the events written to the rings of all threads to
+  // |passive_collector_|.  Must have acquired |lock_| prior to calling.
+  void DrainEventRings();
+
   // Called whenever an observer is added or removed, or changes its log level.
   // Must have acquired |lock_| prior to calling.
   void UpdateLogLevel_();
@@ -149,15 +168,29 @@ class ChromeNetLog : public net::NetLog {
 
   base::subtle::Atomic32 log_level_;
 
-  // Not thread safe.  Must only be used when |lock_| is acquired.
+  // Not thread safe.  Must only be used when |lock_| is acquired.  Not in
+  // |observers_|.
   scoped_ptr<PassiveLogCollector> passive_collector_;
 
+  // Only looks at events of the IO thread, which it lives on, so it is
+  // called as they are added without |lock_|.  Not in |observers_|.
   scoped_ptr<LoadTimingObserver> load_timing_observer_;
+
   scoped_ptr<NetLogLogger> net_log_logger_;
 
   // |lock_| must be acquired whenever reading or writing to this.
   ObserverList<ThreadSafeObserver, true> observers_;
 
+  // Number of observers in |observers_|, read without |lock_| to skip it
+  // when there are none.
+  base::subtle::Atomic32 num_observers_;
+
+  // The ring of each thread which added events.  The rings are owned by
+  // |event_rings_|, which is only modified with |lock_| acquired.  The ring
+  // of a thread which exits is kept, empty once drained.
+  base::ThreadLocalPointer<EventRing> event_ring_;
+  std::vector<EventRing*> event_rings_;
+
   DISALLOW_COPY_AND_ASSIGN(ChromeNetLog);
 };
 
@@ -13,6 +13,57 @@ namespace {
 const int kThreads = 10;
 const int kEvents = 100;
 
+class CountingObserver : public ChromeNetLog::ThreadSafeObserver {
+ public:
+  CountingObserver()
+      : ChromeNetLog::ThreadSafeObserver(net::NetLog::LOG_BASIC),
+        count_(0) {
+  }
+
+  virtual void OnAddEntry(net::NetLog::EventType type,
+                          const base::TimeTicks& time,
+                          const net::NetLog::Source& source,
+                          net::NetLog::EventPhase phase,
+                          net::NetLog::EventParameters* params) {
+    count_++;
+  }
+
+  int count() const { return count_; }
+
+ private:
+  int count_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingObserver);
+};
+
+class ChromeNetLogCaptureThread : public base::SimpleThread {
+ public:
+  ChromeNetLogCaptureThread() : base::SimpleThread("ChromeNetLogTest"),
+                                log_(NULL),
+                                num_events_(0) {
+  }
+
+  void Init(ChromeNetLog* log, int num_events) {
+    log_ = log;
+    num_events_ = num_events;
+  }
+
+  // Adds events for |num_events_| new sockets.
+  virtual void Run() {
+    for (int i = 0; i < num_events_; ++i) {
+      net::NetLog::Source source(net::NetLog::SOURCE_SOCKET, log_->NextID());
+      log_->AddEntry(net::NetLog::TYPE_SOCKET_ALIVE, base::TimeTicks(),
+                     source, net::NetLog::PHASE_BEGIN, NULL);
+    }
+  }
+
+ private:
+  ChromeNetLog* log_;
+  int num_events_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChromeNetLogCaptureThread);
+};
+
 class ChromeNetLogTestThread : public base::SimpleThread {
  public:
   ChromeNetLogTestThread() : base::SimpleThread("ChromeNetLogTest"),
@@ -71,3 +122,77 @@ TEST(ChromeNetLogTest, NetLogThreads) {
   log.GetAllPassivelyCapturedEvents(&entries);
   EXPECT_EQ(0u, entries.size());
 }
+
+// Events of all threads reach PassiveLogCollector.
+TEST(ChromeNetLogTest, PassiveCaptureThreads) {
+  const int kEventsPerThread = 15;
+
+  ChromeNetLog log;
+  ChromeNetLogCaptureThread threads[kThreads];
+
+  for (int i = 0; i < kThreads; ++i) {
+    threads[i].Init(&log, kEventsPerThread);
+    threads[i].Start();
+  }
+
+  for (int i = 0; i < kThreads; ++i)
+    threads[i].Join();
+
+  ChromeNetLog::EntryList entries;
+  log.GetAllPassivelyCapturedEvents(&entries);
+  EXPECT_EQ(static_cast<size_t>(kThreads * kEventsPerThread), entries.size());
+}
+
+// Events keep their order when there are more of them than fit in the ring
+// of their thread.
+TEST(ChromeNetLogTest, PassiveCaptureOverflow) {
+  const int kNumEvents = 1000;
+
+  ChromeNetLog log;
+  net::NetLog::Source source(net::NetLog::SOURCE_SOCKET, log.NextID());
+  for (int i = 0; i < kNumEvents; ++i) {
+    log.AddEntry(net::NetLog::TYPE_SOCKET_ALIVE,
+                 base::TimeTicks() + base::TimeDelta::FromMicroseconds(i),
+                 source, net::NetLog::PHASE_NONE, NULL);
+  }
+
+  // PassiveLogCollector keeps the first events of a source, and its last.
+  ChromeNetLog::EntryList entries;
+  log.GetAllPassivelyCapturedEvents(&entries);
+  ASSERT_LT(1u, entries.size());
+  for (size_t i = 0; i < entries.size() - 1; ++i) {
+    EXPECT_EQ(base::TimeDelta::FromMicroseconds(i),
+              entries[i].time - base::TimeTicks());
+  }
+  EXPECT_EQ(base::TimeDelta::FromMicroseconds(kNumEvents - 1),
+            entries.back().time - base::TimeTicks());
+
+  log.ClearAllPassivelyCapturedEvents();
+  log.GetAllPassivelyCapturedEvents(&entries);
+  EXPECT_EQ(0u, entries.size());
+}
+
+// Added observers are called as events are added.
+TEST(ChromeNetLogTest, ObserverCalledOnAddEntry) {
+  ChromeNetLog log;
+  CountingObserver observer;
+  ChromeNetLog::EntryList entries;
+  log.AddObserverAndGetAllPassivelyCapturedEvents(&observer, &entries);
+  EXPECT_EQ(0u, entries.size());
+
+  net::NetLog::Source source(net::NetLog::SOURCE_SOCKET, log.NextID());
+  log.AddEntry(net::NetLog::TYPE_SOCKET_ALIVE, base::TimeTicks(), source,
+               net::NetLog::PHASE_BEGIN, NULL);
+  EXPECT_EQ(1, observer.count());
+  log.AddEntry(net::NetLog::TYPE_SOCKET_ALIVE, base::TimeTicks(), source,
+               net::NetLog::PHASE_END, NULL);
+  EXPECT_EQ(2, observer.count());
+
+  log.RemoveObserver(&observer);
+  log.AddEntry(net::NetLog::TYPE_SOCKET_ALIVE, base::TimeTicks(), source,
+               net::NetLog::PHASE_BEGIN, NULL);
+  EXPECT_EQ(2, observer.count());
+
+  log.GetAllPassivelyCapturedEvents(&entries);
+  EXPECT_EQ(3u, entries.size());
+}
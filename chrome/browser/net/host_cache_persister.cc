@@ -0,0 +1,111 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/net/host_cache_persister.h"
+
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/message_loop.h"
+#include "content/browser/browser_thread.h"
+
+namespace {
+
+// How long the changes to the cache are coalesced before being written. Host
+// lookups never stop while browsing, so this bounds the rate of writes.
+const int kSaveDelayMs = 5 * 60 * 1000;
+
+}  // namespace
+
+HostCachePersister::HostCachePersister(const FilePath& state_file)
+    : ALLOW_THIS_IN_INITIALIZER_LIST(save_coalescer_(this)),
+      cache_(NULL),
+      off_the_record_(false),
+      state_file_(state_file) {
+}
+
+HostCachePersister::~HostCachePersister() {
+  DCHECK(!cache_);
+}
+
+void HostCachePersister::Initialize(net::HostCache* cache) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  DCHECK(!cache_);
+  cache_ = cache;
+  cache_->set_delegate(this);
+
+  BrowserThread::PostTask(BrowserThread::FILE, FROM_HERE,
+      NewRunnableMethod(this, &HostCachePersister::Load));
+}
+
+void HostCachePersister::Shutdown() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if (!cache_)
+    return;
+
+  if (!save_coalescer_.empty()) {
+    save_coalescer_.RevokeAll();
+    Save();
+  }
+  cache_->set_delegate(NULL);
+  cache_ = NULL;
+}
+
+void HostCachePersister::SetOffTheRecord(bool off_the_record) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  off_the_record_ = off_the_record;
+}
+
+void HostCachePersister::EntriesAreDirty(net::HostCache* cache) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  DCHECK(cache == cache_);
+
+  if (!save_coalescer_.empty())
+    return;
+
+  MessageLoop::current()->PostDelayedTask(FROM_HERE,
+      save_coalescer_.NewRunnableMethod(&HostCachePersister::Save),
+      kSaveDelayMs);
+}
+
+void HostCachePersister::Load() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+
+  std::string state;
+  if (!file_util::ReadFileToString(state_file_, &state))
+    return;
+
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
+      NewRunnableMethod(this, &HostCachePersister::CompleteLoad, state));
+}
+
+void HostCachePersister::CompleteLoad(const std::string& state) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if (!cache_)
+    return;
+
+  if (!cache_->LoadEntries(state))
+    LOG(WARNING) << "Failed to load the saved host cache";
+}
+
+void HostCachePersister::Save() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  DCHECK(cache_);
+
+  // The changes made while off the record are dropped; going back on the
+  // record clears the cache, which schedules the next write.
+  if (off_the_record_)
+    return;
+
+  std::string state;
+  cache_->Serialize(&state);
+
+  BrowserThread::PostTask(BrowserThread::FILE, FROM_HERE,
+      NewRunnableMethod(this, &HostCachePersister::CompleteSave, state));
+}
+
+void HostCachePersister::CompleteSave(const std::string& state) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+
+  file_util::WriteFile(state_file_, state.data(), state.size());
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// HostCachePersister keeps a snapshot of the global host cache across
+// restarts, so the first navigations after startup don't have to wait for DNS.
+//
+// The snapshot is loaded on the file thread when the IO thread starts, and
+// merged into the HostCache on the IO thread. The restored entries are stale,
+// so HostResolverImpl serves them while refreshing them in the background.
+// When the cache changes, the writes are coalesced for a few minutes before
+// the entries are serialised and written on the file thread, and pending
+// changes are written at shutdown. Nothing is written while an off the record
+// window is open, since the cache is shared with it.
+
+#ifndef CHROME_BROWSER_NET_HOST_CACHE_PERSISTER_H_
+#define CHROME_BROWSER_NET_HOST_CACHE_PERSISTER_H_
+#pragma once
+
+#include <string>
+
+#include "base/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/task.h"
+#include "net/base/host_cache.h"
+
+class HostCachePersister
+    : public base::RefCountedThreadSafe<HostCachePersister>,
+      public net::HostCache::Delegate {
+ public:
+  explicit HostCachePersister(const FilePath& state_file);
+
+  // Starts loading the saved entries into |cache|, and saving its changes.
+  // Must be called on the IO thread.
+  void Initialize(net::HostCache* cache);
+
+  // Writes the pending changes and stops using the cache. Must be called on
+  // the IO thread before the cache goes away.
+  void Shutdown();
+
+  // Stops or resumes writing the cache to disk. Must be called on the IO
+  // thread.
+  void SetOffTheRecord(bool off_the_record);
+
+  // net::HostCache::Delegate implementation:
+  virtual void EntriesAreDirty(net::HostCache* cache);
+
+ private:
+  friend class base::RefCountedThreadSafe<HostCachePersister>;
+
+  virtual ~HostCachePersister();
+
+  void Load();
+  void CompleteLoad(const std::string& state);
+
+  void Save();
+  void CompleteSave(const std::string& state);
+
+  // Used on the IO thread to coalesce writes to disk.
+  ScopedRunnableMethodFactory<HostCachePersister> save_coalescer_;
+
+  net::HostCache* cache_;  // IO thread only.
+  bool off_the_record_;  // IO thread only.
+
+  // The path to the file in which we store the serialised entries.
+  const FilePath state_file_;
+
+  DISALLOW_COPY_AND_ASSIGN(HostCachePersister);
+};
+
+#endif  // CHROME_BROWSER_NET_HOST_CACHE_PERSISTER_H_
@@ -1,4 +1,4 @@
-// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
@@ -8,24 +8,64 @@
 
 #include "base/file_util.h"
 #include "base/json/json_writer.h"
+#include "base/task.h"
+#include "base/threading/thread.h"
 #include "base/threading/thread_restrictions.h"
 #include "base/values.h"
 
-NetLogLogger::NetLogLogger(const FilePath &log_path)
+namespace {
+
+// Binary entries are passed to the file thread once this many bytes are
+// buffered.
+const size_t kBinaryBufferSize = 64 * 1024;
+
+// Runs on the file thread.  Takes ownership of |data|.
+void WriteToFile(FILE* file, std::string* data) {
+  fwrite(data->data(), 1, data->size(), file);
+  delete data;
+}
+
+}  // namespace
+
+NetLogLogger::NetLogLogger(const FilePath &log_path, bool binary)
     : ThreadSafeObserver(net::NetLog::LOG_ALL_BUT_BYTES) {
   if (!log_path.empty()) {
     base::ThreadRestrictions::ScopedAllowIO allow_io;
-    file_.Set(file_util::OpenFile(log_path, "w"));
+    file_.Set(file_util::OpenFile(log_path, binary ? "wb" : "w"));
+  }
+  if (binary && file_.get()) {
+    file_thread_.reset(new base::Thread("NetLogLogger"));
+    if (file_thread_->Start()) {
+      binary_writer_.reset(new net::NetLogBinaryWriter());
+      binary_buffer_.reserve(kBinaryBufferSize);
+    } else {
+      file_thread_.reset();
+    }
   }
 }
 
-NetLogLogger::~NetLogLogger() {}
+NetLogLogger::~NetLogLogger() {
+  if (file_thread_.get()) {
+    FlushBinaryBuffer();
+    // Writes what is still queued before returning.
+    base::ThreadRestrictions::ScopedAllowIO allow_io;
+    file_thread_->Stop();
+  }
+}
 
 void NetLogLogger::OnAddEntry(net::NetLog::EventType type,
                               const base::TimeTicks& time,
                               const net::NetLog::Source& source,
                               net::NetLog::EventPhase phase,
                               net::NetLog::EventParameters* params) {
+  if (binary_writer_.get()) {
+    binary_writer_->AppendEntry(type, time, source, phase, params,
+                                &binary_buffer_);
+    if (binary_buffer_.size() >= kBinaryBufferSize)
+      FlushBinaryBuffer();
+    return;
+  }
+
   scoped_ptr<Value> value(net::NetLog::EntryToDictionaryValue(type, time,
                                                               source, phase,
                                                               params, true));
@@ -42,3 +82,12 @@ void NetLogLogger::OnAddEntry(net::NetLog::EventType type,
   }
 }
 
+void NetLogLogger::FlushBinaryBuffer() {
+  if (binary_buffer_.empty())
+    return;
+  std::string* data = new std::string();
+  data->reserve(kBinaryBufferSize);
+  data->swap(binary_buffer_);
+  file_thread_->message_loop()->PostTask(
+      FROM_HERE, NewRunnableFunction(&WriteToFile, file_.get(), data));
+}
@@ -6,11 +6,19 @@
 #define CHROME_BROWSER_NET_NET_LOG_LOGGER_H_
 #pragma once
 
+#include <string>
+
 #include "base/memory/scoped_handle.h"
+#include "base/memory/scoped_ptr.h"
 #include "chrome/browser/net/chrome_net_log.h"
+#include "net/base/net_log_binary.h"
 
 class FilePath;
 
+namespace base {
+class Thread;
+}
+
 // NetLogLogger watches the NetLog event stream, and sends all entries to
 // VLOG(1) or a path specified on creation.  This is to debug errors that
 // prevent getting to the about:net-internals page.
@@ -22,7 +30,14 @@ class NetLogLogger : public ChromeNetLog::ThreadSafeObserver {
   // If |log_path| is empty or file creation fails, writes to VLOG(1).
   // Otherwise, writes to |log_path|.  Uses one line per entry, for
   // easy parsing.
-  explicit NetLogLogger(const FilePath &log_path);
+  //
+  // If |binary| is true and |log_path| can be opened, entries are instead
+  // written in the format of net::NetLogBinaryWriter, which is much cheaper
+  // to produce for long traces.  They are buffered, and written to the file
+  // by a thread of the logger's own, so that writing them doesn't slow down
+  // the threads adding them.  net_log_to_json converts them to the format
+  // used otherwise.
+  NetLogLogger(const FilePath &log_path, bool binary);
   ~NetLogLogger();
 
   // ThreadSafeObserver implementation:
@@ -33,10 +48,18 @@ class NetLogLogger : public ChromeNetLog::ThreadSafeObserver {
                           net::NetLog::EventParameters* params);
 
  private:
+  // Passes what |binary_buffer_| holds to |file_thread_| to be written.
+  void FlushBinaryBuffer();
+
   ScopedStdioHandle file_;
 
+  // Only used to write binary logs.  Once created, |file_| is only used on
+  // |file_thread_|.
+  scoped_ptr<net::NetLogBinaryWriter> binary_writer_;
+  std::string binary_buffer_;
+  scoped_ptr<base::Thread> file_thread_;
+
   DISALLOW_COPY_AND_ASSIGN(NetLogLogger);
 };
 
 #endif  // CHROME_BROWSER_NET_NET_LOG_LOGGER_H_
-
@@ -7,8 +7,10 @@
 #include <algorithm>
 
 #include "base/compiler_specific.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/string_util.h"
 #include "base/format_macros.h"
+#include "base/values.h"
 #include "net/url_request/url_request_netlog_params.h"
 
 namespace {
@@ -17,6 +19,18 @@ namespace {
 
 const size_t kMaxNumEntriesPerLog = 30;
 
+// The size of parameters isn't known, so they are all counted as this many
+// bytes.
+const size_t kEstimatedParamsSize = 64;
+
+// The number of entries at the start of a source which are kept whole when
+// it is compacted, as they identify it (See SourceInfo::GetURL()).
+const size_t kNumEntriesKeptWhenCompacted = 2;
+
+size_t EstimateEntrySize(const ChromeNetLog::Entry& entry) {
+  return sizeof(entry) + (entry.params ? kEstimatedParamsSize : 0);
+}
+
 void AddEntryToSourceInfo(const ChromeNetLog::Entry& entry,
                           PassiveLogCollector::SourceInfo* out_info) {
   // Start dropping new entries when the log has gotten too big.
@@ -24,8 +38,26 @@ void AddEntryToSourceInfo(const ChromeNetLog::Entry& entry,
     out_info->entries.push_back(entry);
   } else {
     out_info->num_entries_truncated += 1;
+    out_info->num_bytes -=
+        EstimateEntrySize(out_info->entries[kMaxNumEntriesPerLog - 1]);
     out_info->entries[kMaxNumEntriesPerLog - 1] = entry;
   }
+  out_info->num_bytes += EstimateEntrySize(entry);
+}
+
+// Returns true if |entry| reports an error, with a negative "net_error"
+// parameter, or a cancellation.
+bool IsErrorEntry(const ChromeNetLog::Entry& entry) {
+  if (entry.type == net::NetLog::TYPE_CANCELLED)
+    return true;
+  if (!entry.params || entry.phase == net::NetLog::PHASE_BEGIN)
+    return false;
+  scoped_ptr<Value> params(entry.params->ToValue());
+  if (!params.get() || !params->IsType(Value::TYPE_DICTIONARY))
+    return false;
+  int net_error;
+  return static_cast<DictionaryValue*>(params.get())->GetInteger(
+      "net_error", &net_error) && net_error < 0;
 }
 
 // Comparator to sort entries by their |order| property, ascending.
@@ -39,6 +71,8 @@ bool SortByOrderComparator(const ChromeNetLog::Entry& a,
 PassiveLogCollector::SourceInfo::SourceInfo()
     : source_id(net::NetLog::Source::kInvalidId),
       num_entries_truncated(0),
+      num_bytes(0),
+      is_compacted(false),
       reference_count(0),
       is_alive(true) {
 }
@@ -49,13 +83,17 @@ PassiveLogCollector::SourceInfo::~SourceInfo() {}
 // PassiveLogCollector
 //----------------------------------------------------------------------------
 
+// static
+const size_t PassiveLogCollector::kMaxBytes = 1024 * 1024;
+
 PassiveLogCollector::PassiveLogCollector()
     : ThreadSafeObserver(net::NetLog::LOG_BASIC),
       ALLOW_THIS_IN_INITIALIZER_LIST(connect_job_tracker_(this)),
       ALLOW_THIS_IN_INITIALIZER_LIST(url_request_tracker_(this)),
       ALLOW_THIS_IN_INITIALIZER_LIST(socket_stream_tracker_(this)),
       ALLOW_THIS_IN_INITIALIZER_LIST(http_stream_job_tracker_(this)),
-      num_events_seen_(0) {
+      num_events_seen_(0),
+      max_bytes_(kMaxBytes) {
 
   // Define the mapping between source types and the tracker objects.
   memset(&trackers_[0], 0, sizeof(trackers_));
@@ -73,6 +111,8 @@ PassiveLogCollector::PassiveLogCollector()
   trackers_[net::NetLog::SOURCE_DISK_CACHE_ENTRY] = &disk_cache_entry_tracker_;
   trackers_[net::NetLog::SOURCE_MEMORY_CACHE_ENTRY] = &mem_cache_entry_tracker_;
   trackers_[net::NetLog::SOURCE_HTTP_STREAM_JOB] = &http_stream_job_tracker_;
+  trackers_[net::NetLog::SOURCE_HTTP_CACHE_ASYNC_VALIDATION] =
+      &async_validation_tracker_;
   // Make sure our mapping is up-to-date.
   for (size_t i = 0; i < arraysize(trackers_); ++i)
     DCHECK(trackers_[i]) << "Unhandled SourceType: " << i;
@@ -95,6 +135,8 @@ void PassiveLogCollector::OnAddEntry(
   SourceTrackerInterface* tracker = GetTrackerForSourceType(entry.source.type);
   if (tracker)
     tracker->OnAddEntry(entry);
+
+  EnforceMemoryBudget();
 }
 
 void PassiveLogCollector::Clear() {
@@ -125,6 +167,40 @@ void PassiveLogCollector::GetAllCapturedEvents(
   std::sort(out->begin(), out->end(), &SortByOrderComparator);
 }
 
+size_t PassiveLogCollector::GetMemoryUsage() const {
+  size_t num_bytes = 0;
+  for (size_t i = 0; i < arraysize(trackers_); ++i)
+    num_bytes += trackers_[i]->GetMemoryUsage();
+  return num_bytes;
+}
+
+void PassiveLogCollector::EnforceMemoryBudget() {
+  // Deleting a source can release references held to sources of other
+  // trackers, so the usage is summed up again after each deletion.
+  for (size_t num_bytes = GetMemoryUsage(); num_bytes > max_bytes_;
+       num_bytes = GetMemoryUsage()) {
+    SourceTrackerInterface* largest_tracker = NULL;
+    for (size_t i = 0; i < arraysize(trackers_); ++i) {
+      if (!largest_tracker || trackers_[i]->GetMemoryUsage() >
+                                  largest_tracker->GetMemoryUsage()) {
+        largest_tracker = trackers_[i];
+      }
+    }
+    if (largest_tracker->DeleteOldestSource())
+      continue;
+
+    bool deleted_source = false;
+    for (size_t i = 0; i < arraysize(trackers_) && !deleted_source; ++i)
+      deleted_source = trackers_[i]->DeleteOldestSource();
+    if (!deleted_source) {
+      // Only sources which are still alive are left.
+      LOG(WARNING) << "The passive log data has grown larger "
+                      "than expected, resetting";
+      largest_tracker->Clear();
+    }
+  }
+}
+
 std::string PassiveLogCollector::SourceInfo::GetURL() const {
   // Note: we look at the first *two* entries, since the outer REQUEST_ALIVE
   // doesn't actually contain any data.
@@ -150,19 +226,24 @@ std::string PassiveLogCollector::SourceInfo::GetURL() const {
 // GlobalSourceTracker
 //----------------------------------------------------------------------------
 
-PassiveLogCollector::GlobalSourceTracker::GlobalSourceTracker() {}
+PassiveLogCollector::GlobalSourceTracker::GlobalSourceTracker()
+    : num_bytes_(0) {
+}
+
 PassiveLogCollector::GlobalSourceTracker::~GlobalSourceTracker() {}
 
 void PassiveLogCollector::GlobalSourceTracker::OnAddEntry(
     const ChromeNetLog::Entry& entry) {
   const size_t kMaxEntries = 30u;
   entries_.push_back(entry);
+  num_bytes_ += EstimateEntrySize(entry);
   if (entries_.size() > kMaxEntries)
-    entries_.pop_front();
+    DeleteOldestSource();
 }
 
 void PassiveLogCollector::GlobalSourceTracker::Clear() {
   entries_.clear();
+  num_bytes_ = 0;
 }
 
 void PassiveLogCollector::GlobalSourceTracker::AppendAllEntries(
@@ -170,6 +251,18 @@ void PassiveLogCollector::GlobalSourceTracker::AppendAllEntries(
   out->insert(out->end(), entries_.begin(), entries_.end());
 }
 
+size_t PassiveLogCollector::GlobalSourceTracker::GetMemoryUsage() const {
+  return num_bytes_;
+}
+
+bool PassiveLogCollector::GlobalSourceTracker::DeleteOldestSource() {
+  if (entries_.empty())
+    return false;
+  num_bytes_ -= EstimateEntrySize(entries_.front());
+  entries_.pop_front();
+  return true;
+}
+
 //----------------------------------------------------------------------------
 // SourceTracker
 //----------------------------------------------------------------------------
@@ -180,6 +273,7 @@ PassiveLogCollector::SourceTracker::SourceTracker(
     PassiveLogCollector* parent)
     : max_num_sources_(max_num_sources),
       max_graveyard_size_(max_graveyard_size),
+      num_bytes_(0),
       parent_(parent) {
 }
 
@@ -201,7 +295,11 @@ void PassiveLogCollector::SourceTracker::OnAddEntry(
   }
 
   SourceInfo& info = it->second;
+  size_t old_num_bytes = info.num_bytes;
   Action result = DoAddEntry(entry, &info);
+  if (result == ACTION_MOVE_TO_GRAVEYARD && info.is_alive)
+    CompactSourceInfo(&info);
+  num_bytes_ += info.num_bytes - old_num_bytes;
 
   if (result != ACTION_NONE) {
     // We are either queuing it for deletion, or deleting it immediately.
@@ -237,6 +335,7 @@ void PassiveLogCollector::SourceTracker::DeleteSourceInfo(
   CHECK(std::find(deletion_queue_.begin(), deletion_queue_.end(),
                   source_id) == deletion_queue_.end());
   ReleaseAllReferencesToDependencies(&(it->second));
+  num_bytes_ -= it->second.num_bytes;
   sources_.erase(it);
 }
 
@@ -250,6 +349,7 @@ void PassiveLogCollector::SourceTracker::Clear() {
     ReleaseAllReferencesToDependencies(&(it->second));
   }
   sources_.clear();
+  num_bytes_ = 0;
 }
 
 void PassiveLogCollector::SourceTracker::AppendAllEntries(
@@ -263,6 +363,19 @@ void PassiveLogCollector::SourceTracker::AppendAllEntries(
   }
 }
 
+size_t PassiveLogCollector::SourceTracker::GetMemoryUsage() const {
+  return num_bytes_;
+}
+
+bool PassiveLogCollector::SourceTracker::DeleteOldestSource() {
+  if (deletion_queue_.empty())
+    return false;
+  uint32 oldest = deletion_queue_.front();
+  deletion_queue_.pop_front();
+  DeleteSourceInfo(oldest);
+  return true;
+}
+
 void PassiveLogCollector::SourceTracker::AddToDeletionQueue(
     uint32 source_id) {
   DCHECK(sources_.find(source_id) != sources_.end());
@@ -276,11 +389,8 @@ void PassiveLogCollector::SourceTracker::AddToDeletionQueue(
 
   // After the deletion queue has reached its maximum size, start
   // deleting sources in FIFO order.
-  if (deletion_queue_.size() > max_graveyard_size_) {
-    uint32 oldest = deletion_queue_.front();
-    deletion_queue_.pop_front();
-    DeleteSourceInfo(oldest);
-  }
+  if (deletion_queue_.size() > max_graveyard_size_)
+    DeleteOldestSource();
 }
 
 void PassiveLogCollector::SourceTracker::EraseFromDeletionQueue(
@@ -369,6 +479,29 @@ void PassiveLogCollector::SourceTracker::ReleaseAllReferencesToDependencies(
   info->dependencies.clear();
 }
 
+void PassiveLogCollector::SourceTracker::CompactSourceInfo(SourceInfo* info) {
+  ChromeNetLog::EntryList& entries = info->entries;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    // Failures are kept in full detail.
+    if (IsErrorEntry(entries[i]))
+      return;
+  }
+
+  ChromeNetLog::EntryList::iterator compacted_end = entries.begin();
+  info->num_bytes = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (i >= kNumEntriesKeptWhenCompacted) {
+      if (entries[i].phase == net::NetLog::PHASE_NONE)
+        continue;
+      entries[i].params = NULL;
+    }
+    info->num_bytes += EstimateEntrySize(entries[i]);
+    *compacted_end++ = entries[i];
+  }
+  entries.erase(compacted_end, entries.end());
+  info->is_compacted = true;
+}
+
 //----------------------------------------------------------------------------
 // ConnectJobTracker
 //----------------------------------------------------------------------------
@@ -644,3 +777,29 @@ PassiveLogCollector::HttpStreamJobTracker::DoAddEntry(
 
   return ACTION_NONE;
 }
+
+//----------------------------------------------------------------------------
+// AsyncValidationTracker
+//----------------------------------------------------------------------------
+
+const size_t PassiveLogCollector::AsyncValidationTracker::kMaxNumSources = 100;
+const size_t PassiveLogCollector::AsyncValidationTracker::kMaxGraveyardSize =
+    25;
+
+PassiveLogCollector::AsyncValidationTracker::AsyncValidationTracker()
+    : SourceTracker(kMaxNumSources, kMaxGraveyardSize, NULL) {
+}
+
+PassiveLogCollector::SourceTracker::Action
+PassiveLogCollector::AsyncValidationTracker::DoAddEntry(
+    const ChromeNetLog::Entry& entry, SourceInfo* out_info) {
+  AddEntryToSourceInfo(entry, out_info);
+
+  // If the validation has ended, move it to the graveyard.
+  if (entry.type == net::NetLog::TYPE_HTTP_CACHE_ASYNC_VALIDATION &&
+      entry.phase == net::NetLog::PHASE_END) {
+    return ACTION_MOVE_TO_GRAVEYARD;
+  }
+
+  return ACTION_NONE;
+}
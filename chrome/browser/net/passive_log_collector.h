@@ -33,6 +33,12 @@
 // a SourceInfo structure. These in turn are grouped by NetLog::SourceType, and
 // owned by a SourceTracker instance for the specific source type.
 //
+// All the trackers together hold at most max_bytes() of entries, estimated.
+// To fit more sources in, the entries of a finished source are compacted:
+// only the timings of its events are kept.  Sources which failed are kept in
+// full detail.  When the budget is still exceeded, the oldest finished
+// sources are deleted first.
+//
 // The PassiveLogCollector is owned by the ChromeNetLog itself, and is not
 // thread safe.  The ChromeNetLog is responsible for calling it in a thread safe
 // manner.
@@ -53,6 +59,13 @@ class PassiveLogCollector : public ChromeNetLog::ThreadSafeObserver {
     ChromeNetLog::EntryList entries;
     size_t num_entries_truncated;
 
+    // Estimate of the memory used by |entries|.
+    size_t num_bytes;
+
+    // True once |entries| only keeps the timings of the source, after it
+    // finished without error.
+    bool is_compacted;
+
     // List of other sources which contain information relevant to this
     // source (for example, a url request might depend on the log items
     // for a connect job and for a socket that were bound to it.)
@@ -83,6 +96,14 @@ class PassiveLogCollector : public ChromeNetLog::ThreadSafeObserver {
 
     // Appends all the captured entries to |out|. The ordering is undefined.
     virtual void AppendAllEntries(ChromeNetLog::EntryList* out) const = 0;
+
+    // Returns an estimate of the memory used by the captured entries.
+    virtual size_t GetMemoryUsage() const = 0;
+
+    // Deletes the oldest data which isn't needed any more: the oldest source
+    // in the graveyard, or the oldest entry for GlobalSourceTracker.  Returns
+    // false if there is none.
+    virtual bool DeleteOldestSource() = 0;
   };
 
   // This source tracker is intended for TYPE_NONE. All entries go into a
@@ -96,10 +117,13 @@ class PassiveLogCollector : public ChromeNetLog::ThreadSafeObserver {
     virtual void OnAddEntry(const ChromeNetLog::Entry& entry);
     virtual void Clear();
     virtual void AppendAllEntries(ChromeNetLog::EntryList* out) const;
+    virtual size_t GetMemoryUsage() const;
+    virtual bool DeleteOldestSource();
 
    private:
     typedef std::deque<ChromeNetLog::Entry> CircularEntryList;
     CircularEntryList entries_;
+    size_t num_bytes_;
     DISALLOW_COPY_AND_ASSIGN(GlobalSourceTracker);
   };
 
@@ -122,6 +146,8 @@ class PassiveLogCollector : public ChromeNetLog::ThreadSafeObserver {
     virtual void OnAddEntry(const ChromeNetLog::Entry& entry);
     virtual void Clear();
     virtual void AppendAllEntries(ChromeNetLog::EntryList* out) const;
+    virtual size_t GetMemoryUsage() const;
+    virtual bool DeleteOldestSource();
 
 #ifdef UNIT_TEST
     // Helper used to inspect the current state by unit-tests.
@@ -175,6 +201,10 @@ class PassiveLogCollector : public ChromeNetLog::ThreadSafeObserver {
     // Releases all the references to sources held by |info|.
     void ReleaseAllReferencesToDependencies(SourceInfo* info);
 
+    // Drops all but the timings from the entries of |info|, which has just
+    // finished, unless it failed.
+    void CompactSourceInfo(SourceInfo* info);
+
     // This map contains all of the sources being tracked by this tracker.
     // (It includes both the "live" sources, and the "dead" ones.)
     SourceIDToInfoMap sources_;
@@ -187,6 +217,9 @@ class PassiveLogCollector : public ChromeNetLog::ThreadSafeObserver {
     // queue sources for deletion so they can persist a bit longer.
     DeletionQueue deletion_queue_;
 
+    // Sum of the |num_bytes| of |sources_|.
+    size_t num_bytes_;
+
     PassiveLogCollector* parent_;
 
     DISALLOW_COPY_AND_ASSIGN(SourceTracker);
@@ -341,6 +374,25 @@ class PassiveLogCollector : public ChromeNetLog::ThreadSafeObserver {
     DISALLOW_COPY_AND_ASSIGN(HttpStreamJobTracker);
   };
 
+  // Tracks the log entries for the last seen
+  // SOURCE_HTTP_CACHE_ASYNC_VALIDATION.
+  class AsyncValidationTracker : public SourceTracker {
+   public:
+    static const size_t kMaxNumSources;
+    static const size_t kMaxGraveyardSize;
+
+    AsyncValidationTracker();
+
+   private:
+    virtual Action DoAddEntry(const ChromeNetLog::Entry& entry,
+                              SourceInfo* out_info);
+
+    DISALLOW_COPY_AND_ASSIGN(AsyncValidationTracker);
+  };
+
+
+  // Default for max_bytes().
+  static const size_t kMaxBytes;
 
   PassiveLogCollector();
   ~PassiveLogCollector();
@@ -359,15 +411,26 @@ class PassiveLogCollector : public ChromeNetLog::ThreadSafeObserver {
   // captured. The list is ordered by capture time.
   void GetAllCapturedEvents(ChromeNetLog::EntryList* out) const;
 
+  // Returns an estimate of the memory used by the passively logged data.
+  size_t GetMemoryUsage() const;
+
+  size_t max_bytes() const { return max_bytes_; }
+  void set_max_bytes(size_t max_bytes) { max_bytes_ = max_bytes; }
+
  private:
   // Returns the tracker to use for sources of type |source_type|, or NULL.
   SourceTrackerInterface* GetTrackerForSourceType(
       net::NetLog::SourceType source_type);
 
+  // Deletes the oldest data of the trackers using the most memory until the
+  // total fits in |max_bytes_|.
+  void EnforceMemoryBudget();
+
   FRIEND_TEST_ALL_PREFIXES(PassiveLogCollectorTest,
                            HoldReferenceToDependentSource);
   FRIEND_TEST_ALL_PREFIXES(PassiveLogCollectorTest,
                            HoldReferenceToDeletedSource);
+  FRIEND_TEST_ALL_PREFIXES(PassiveLogCollectorTest, MemoryBudget);
 
   GlobalSourceTracker global_source_tracker_;
   ConnectJobTracker connect_job_tracker_;
@@ -381,6 +444,7 @@ class PassiveLogCollector : public ChromeNetLog::ThreadSafeObserver {
   DiskCacheEntryTracker disk_cache_entry_tracker_;
   MemCacheEntryTracker mem_cache_entry_tracker_;
   HttpStreamJobTracker http_stream_job_tracker_;
+  AsyncValidationTracker async_validation_tracker_;
 
   // This array maps each NetLog::SourceType to one of the tracker instances
   // defined above. Use of this array avoid duplicating the list of trackers
@@ -391,6 +455,8 @@ class PassiveLogCollector : public ChromeNetLog::ThreadSafeObserver {
   // "order" field on captured events.
   uint32 num_events_seen_;
 
+  size_t max_bytes_;
+
   DISALLOW_COPY_AND_ASSIGN(PassiveLogCollector);
 };
 
@@ -172,6 +172,83 @@ TEST(RequestTrackerTest, GraveyardIsFiltered) {
   EXPECT_EQ(url3, GetDeadSources(tracker)[1].GetURL());
 }
 
+// Check that only the timings of a request are kept once it has finished,
+// besides the entries identifying it.
+TEST(RequestTrackerTest, GraveyardIsCompacted) {
+  RequestTracker tracker(NULL);
+
+  tracker.OnAddEntry(MakeStartLogEntry(1));
+  tracker.OnAddEntry(ChromeNetLog::Entry(
+      0, NetLog::TYPE_URL_REQUEST_START_JOB, base::TimeTicks(),
+      NetLog::Source(kSourceType, 1), NetLog::PHASE_END, NULL));
+  tracker.OnAddEntry(ChromeNetLog::Entry(
+      0, NetLog::TYPE_HTTP_TRANSACTION_READ_HEADERS, base::TimeTicks(),
+      NetLog::Source(kSourceType, 1), NetLog::PHASE_BEGIN,
+      new net::NetLogStringParameter("x", "y")));
+  tracker.OnAddEntry(ChromeNetLog::Entry(
+      0, NetLog::TYPE_HTTP_TRANSACTION_READ_HEADERS, base::TimeTicks(),
+      NetLog::Source(kSourceType, 1), NetLog::PHASE_END, NULL));
+  tracker.OnAddEntry(ChromeNetLog::Entry(
+      0, NetLog::TYPE_URL_REQUEST_REDIRECTED, base::TimeTicks(),
+      NetLog::Source(kSourceType, 1), NetLog::PHASE_NONE,
+      new net::NetLogStringParameter("location", "http://req1/")));
+
+  SourceInfoList live_reqs = GetLiveSources(tracker);
+  ASSERT_EQ(1u, live_reqs.size());
+  EXPECT_FALSE(live_reqs[0].is_compacted);
+  EXPECT_EQ(5u, live_reqs[0].entries.size());
+  size_t live_num_bytes = tracker.GetMemoryUsage();
+
+  tracker.OnAddEntry(MakeEndLogEntry(1));
+
+  SourceInfoList dead_reqs = GetDeadSources(tracker);
+  ASSERT_EQ(1u, dead_reqs.size());
+  const PassiveLogCollector::SourceInfo& info = dead_reqs[0];
+  EXPECT_TRUE(info.is_compacted);
+  EXPECT_EQ("http://req1/", info.GetURL());
+  ASSERT_EQ(5u, info.entries.size());
+  EXPECT_EQ(NetLog::TYPE_URL_REQUEST_START_JOB, info.entries[1].type);
+  EXPECT_EQ(NetLog::TYPE_HTTP_TRANSACTION_READ_HEADERS, info.entries[2].type);
+  EXPECT_FALSE(info.entries[2].params);
+  EXPECT_EQ(NetLog::TYPE_HTTP_TRANSACTION_READ_HEADERS, info.entries[3].type);
+  EXPECT_EQ(NetLog::TYPE_REQUEST_ALIVE, info.entries[4].type);
+  EXPECT_EQ(info.num_bytes, tracker.GetMemoryUsage());
+  EXPECT_GT(live_num_bytes, tracker.GetMemoryUsage());
+}
+
+// Check that requests which failed are kept in full detail.
+TEST(RequestTrackerTest, FailuresAreNotCompacted) {
+  RequestTracker tracker(NULL);
+
+  tracker.OnAddEntry(MakeStartLogEntry(1));
+  tracker.OnAddEntry(ChromeNetLog::Entry(
+      0, NetLog::TYPE_URL_REQUEST_REDIRECTED, base::TimeTicks(),
+      NetLog::Source(kSourceType, 1), NetLog::PHASE_NONE,
+      new net::NetLogStringParameter("location", "http://req1/")));
+  tracker.OnAddEntry(ChromeNetLog::Entry(
+      0, NetLog::TYPE_URL_REQUEST_START_JOB, base::TimeTicks(),
+      NetLog::Source(kSourceType, 1), NetLog::PHASE_END,
+      new net::NetLogIntegerParameter("net_error", -2)));
+  tracker.OnAddEntry(MakeEndLogEntry(1));
+
+  tracker.OnAddEntry(MakeStartLogEntry(2));
+  tracker.OnAddEntry(ChromeNetLog::Entry(
+      0, NetLog::TYPE_URL_REQUEST_REDIRECTED, base::TimeTicks(),
+      NetLog::Source(kSourceType, 2), NetLog::PHASE_NONE,
+      new net::NetLogStringParameter("location", "http://req2/")));
+  tracker.OnAddEntry(ChromeNetLog::Entry(
+      0, NetLog::TYPE_CANCELLED, base::TimeTicks(),
+      NetLog::Source(kSourceType, 2), NetLog::PHASE_NONE, NULL));
+  tracker.OnAddEntry(MakeEndLogEntry(2));
+
+  SourceInfoList dead_reqs = GetDeadSources(tracker);
+  ASSERT_EQ(2u, dead_reqs.size());
+  for (size_t i = 0; i < dead_reqs.size(); ++i) {
+    EXPECT_FALSE(dead_reqs[i].is_compacted);
+    EXPECT_EQ(4u, dead_reqs[i].entries.size());
+  }
+}
+
 TEST(SpdySessionTracker, MovesToGraveyard) {
   PassiveLogCollector::SpdySessionTracker tracker;
   EXPECT_EQ(0u, GetLiveSources(tracker).size());
@@ -492,3 +569,32 @@ TEST(PassiveLogCollectorTest, ReleaseDependencyToUnreferencedSource) {
 
   // To pass, this should simply not have DCHECK-ed above.
 }
+
+// Check that the oldest finished sources are deleted to stay within the
+// memory budget.
+TEST(PassiveLogCollectorTest, MemoryBudget) {
+  const size_t kNumSources = 25;
+  const size_t kNumSourcesInBudget = 10;
+
+  PassiveLogCollector log;
+  for (uint32 i = 0; i < kNumSources; ++i) {
+    NetLog::Source source(NetLog::SOURCE_URL_REQUEST, i);
+    log.OnAddEntry(NetLog::TYPE_URL_REQUEST_START_JOB, base::TimeTicks(),
+                   source, NetLog::PHASE_BEGIN,
+                   new net::URLRequestStartEventParameters(
+                       GURL(StringPrintf("http://req%d/", i)), "GET", 0,
+                       net::LOW));
+    log.OnAddEntry(NetLog::TYPE_REQUEST_ALIVE, base::TimeTicks(), source,
+                   NetLog::PHASE_END, NULL);
+    // All the sources use as much memory as the first one.
+    if (i == 0)
+      log.set_max_bytes(kNumSourcesInBudget * log.GetMemoryUsage());
+    EXPECT_LE(log.GetMemoryUsage(), log.max_bytes());
+  }
+
+  SourceInfoList dead_reqs = GetDeadSources(log.url_request_tracker_);
+  ASSERT_EQ(kNumSourcesInBudget, dead_reqs.size());
+  for (size_t i = 0; i < kNumSourcesInBudget; ++i) {
+    EXPECT_EQ(kNumSources - kNumSourcesInBudget + i, dead_reqs[i].source_id);
+  }
+}
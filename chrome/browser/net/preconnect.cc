@@ -4,11 +4,15 @@
 
 #include "chrome/browser/net/preconnect.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/metrics/histogram.h"
 #include "chrome/browser/profiles/profile.h"
 #include "content/browser/browser_thread.h"
+#include "net/base/host_port_pair.h"
 #include "net/base/net_log.h"
+#include "net/base/network_tuning_profile.h"
 #include "net/base/ssl_config_service.h"
 #include "net/http/http_network_session.h"
 #include "net/http/http_request_info.h"
@@ -45,6 +49,11 @@ void PreconnectOnIOThread(
     return;
   }
 
+  // Slow connections have little bandwidth to spare on speculation.
+  count = std::min(
+      count,
+      net::NetworkTuningProfile::GetCurrent().max_preconnects_per_host);
+
   // We are now commited to doing the async preconnection call.
   UMA_HISTOGRAM_ENUMERATION("Net.PreconnectMotivation", motivation,
                             UrlInfo::MAX_MOTIVATED);
@@ -104,4 +113,41 @@ void PreconnectOnIOThread(
       count, request_info, ssl_config, net::BoundNetLog());
 }
 
+int TakePeakSocketCountOnIOThread(const GURL& url) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  net::URLRequestContextGetter* getter = Profile::GetDefaultRequestContext();
+  if (!getter)
+    return 0;
+
+  net::URLRequestContext* context = getter->GetURLRequestContext();
+  net::HttpTransactionFactory* factory = context->http_transaction_factory();
+  net::HttpNetworkSession* session = factory->GetSession();
+  if (!session)
+    return 0;
+
+  net::HostPortPair origin(url.HostNoBrackets(), url.EffectiveIntPort());
+  return session->TakePeakSocketCount(origin, url.SchemeIs("https"));
+}
+
+void PrefetchSSLHostInfoOnIOThread(const GURL& url) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if (!url.SchemeIs("https"))
+    return;
+  net::URLRequestContextGetter* getter = Profile::GetDefaultRequestContext();
+  if (!getter)
+    return;
+
+  net::URLRequestContext* context = getter->GetURLRequestContext();
+  net::HttpTransactionFactory* factory = context->http_transaction_factory();
+  net::HttpNetworkSession* session = factory->GetSession();
+  if (!session)
+    return;
+
+  // Verify the way a preconnect would, so that the result is found again.
+  net::SSLConfig ssl_config;
+  session->ssl_config_service()->GetSSLConfig(&ssl_config);
+  ssl_config.verify_ev_cert = true;
+  session->PrefetchSSLHostInfo(url.HostNoBrackets(), ssl_config);
+}
+
 }  // namespace chrome_browser_net
@@ -29,6 +29,16 @@ void PreconnectOnIOThread(const GURL& url,
                           UrlInfo::ResolutionMotivation motivation,
                           int count);
 
+// Returns the largest number of sockets that were used at the same time for
+// direct connections to the origin of |url| since the last call, and starts a
+// new measurement.  Returns 0 when nothing is known about that origin.
+int TakePeakSocketCountOnIOThread(const GURL& url);
+
+// Loads the saved SSL state of the host of |url| and starts verifying its
+// certificates, so that a later connection to it can skip both.  Does nothing
+// unless |url| is https.
+void PrefetchSSLHostInfoOnIOThread(const GURL& url);
+
 }  // namespace chrome_browser_net
 
 #endif  // CHROME_BROWSER_NET_PRECONNECT_H_
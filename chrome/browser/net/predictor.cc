@@ -48,6 +48,8 @@ const double Predictor::kReferrerTrimRatio = 0.97153;
 // static
 const TimeDelta Predictor::kDurationBetweenTrimmings = TimeDelta::FromHours(1);
 // static
+const TimeDelta Predictor::kPeakSocketCountWindow = TimeDelta::FromSeconds(10);
+// static
 const TimeDelta Predictor::kDurationBetweenTrimmingIncrements =
     TimeDelta::FromSeconds(15);
 // static
@@ -282,13 +284,21 @@ void Predictor::PrepareFrameSubresources(const GURL& url) {
                                 static_cast<int>(connection_expectation * 100),
                                 10, 5000, 50);
     future_url->second.ReferrerWasObserved();
+    // Start a new measurement of the sockets this navigation will use.
+    if (preconnect_enabled_)
+      TakePeakSocketCountOnIOThread(future_url->first);
     if (preconnect_enabled_ &&
         connection_expectation > kPreconnectWorthyExpectedValue) {
       evalution = PRECONNECTION;
       future_url->second.IncrementPreconnectionCount();
-      int count = static_cast<int>(std::ceil(connection_expectation));
-      if (url.host() == future_url->first.host())
-        ++count;
+      // When we saw how many sockets the last visit needed, open exactly that
+      // many.  That count already includes the connections of the page itself.
+      int count = future_url->second.peak_socket_count();
+      if (count <= 0) {
+        count = static_cast<int>(std::ceil(connection_expectation));
+        if (url.host() == future_url->first.host())
+          ++count;
+      }
       PreconnectOnIOThread(future_url->first, motivation, count);
     } else if (connection_expectation > kDNSPreresolutionWorthyExpectedValue) {
       evalution = PRERESOLUTION;
@@ -297,10 +307,39 @@ void Predictor::PrepareFrameSubresources(const GURL& url) {
                                                      motivation);
       if (queued_info)
         queued_info->SetReferringHostname(url);
+      // Not worth a connection, but worth getting the certificates checked.
+      if (preconnect_enabled_)
+        PrefetchSSLHostInfoOnIOThread(future_url->first);
     }
     UMA_HISTOGRAM_ENUMERATION("Net.PreconnectSubresourceEval", evalution,
                               SUBRESOURCE_VALUE_MAX);
   }
+
+  if (preconnect_enabled_) {
+    MessageLoop::current()->PostDelayedTask(
+        FROM_HERE,
+        NewRunnableMethod(this, &Predictor::LearnPeakSocketCounts, url),
+        kPeakSocketCountWindow.InMilliseconds());
+  }
+}
+
+void Predictor::LearnPeakSocketCounts(const GURL& url) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if (shutdown_)
+    return;
+  Referrers::iterator it = referrers_.find(url);
+  if (it == referrers_.end())
+    return;  // Trimmed away meanwhile.
+
+  Referrer* referrer = &(it->second);
+  for (Referrer::iterator future_url = referrer->begin();
+       future_url != referrer->end(); ++future_url) {
+    int count = TakePeakSocketCountOnIOThread(future_url->first);
+    if (count <= 0)
+      continue;
+    UMA_HISTOGRAM_COUNTS_100("Net.PreconnectPeakSocketCount", count);
+    future_url->second.set_peak_socket_count(count);
+  }
 }
 
 // Provide sort order so all .com's are together, etc.
@@ -618,6 +657,8 @@ void Predictor::SerializeReferrers(ListValue* referral_list) {
     ListValue* motivator(new ListValue);
     motivator->Append(new StringValue(it->first.spec()));
     motivator->Append(subresource_list);
+    // The peak socket counts are optional, so that older lists still load.
+    motivator->Append(it->second.SerializePeakSocketCounts());
 
     referral_list->Append(motivator);
   }
@@ -647,7 +688,12 @@ void Predictor::DeserializeReferrers(const ListValue& referral_list) {
         return;
       }
 
-      referrers_[GURL(motivating_url_spec)].Deserialize(*subresource_list);
+      Referrer& referrer = referrers_[GURL(motivating_url_spec)];
+      referrer.Deserialize(*subresource_list);
+
+      Value* peak_socket_counts;
+      if (motivator->Get(2, &peak_socket_counts))
+        referrer.DeserializePeakSocketCounts(*peak_socket_counts);
     }
   }
 }
@@ -203,6 +203,9 @@ class Predictor : public base::RefCountedThreadSafe<Predictor> {
   static const base::TimeDelta kDurationBetweenTrimmingIncrements;
   // Number of referring URLs processed in an incremental trimming.
   static const size_t kUrlsTrimmedPerIncrement;
+  // How long after a navigation we sample the socket pools to learn how many
+  // connections each of its subresource hosts really needed.
+  static const base::TimeDelta kPeakSocketCountWindow;
 
   ~Predictor();
 
@@ -211,6 +214,11 @@ class Predictor : public base::RefCountedThreadSafe<Predictor> {
   // PredictFrameSubresources().
   void PrepareFrameSubresources(const GURL& url);
 
+  // Records, for each subresource of |url|, the peak number of sockets used
+  // since PrepareFrameSubresources() ran.  Those counts become the size of the
+  // next preconnection to these subresources.
+  void LearnPeakSocketCounts(const GURL& url);
+
   // Only for testing. Returns true if hostname has been successfully resolved
   // (name found).
   bool WasFound(const GURL& url) const {
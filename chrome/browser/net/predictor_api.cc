@@ -136,6 +136,8 @@ void OnTheRecord(bool enable) {
   on_the_record_switch = enable;
   if (on_the_record_switch)
     g_browser_process->io_thread()->ChangedToOnTheRecord();
+  else
+    g_browser_process->io_thread()->ChangedToOffTheRecord();
 }
 
 void DiscardInitialNavigationHistory() {
@@ -438,6 +440,14 @@ void FinalizePredictorInitialization(
   // Prefetch these hostnames on startup.
   DnsPrefetchMotivatedList(startup_urls,
                            UrlInfo::STARTUP_LIST_MOTIVATED);
+  // The startup pages are about to be loaded, so have their saved SSL state
+  // read and their certificates verified meanwhile.
+  if (g_predictor->preconnect_enabled()) {
+    for (UrlList::const_iterator it = startup_urls.begin();
+         it != startup_urls.end(); ++it) {
+      PrefetchSSLHostInfoOnIOThread(*it);
+    }
+  }
   g_predictor->DeserializeReferrersThenDelete(referral_list);
 }
 
@@ -396,6 +396,53 @@ TEST_F(PredictorTest, ReferrerSerializationSingleReferrerTest) {
   predictor->Shutdown();
 }
 
+// Make sure that learned peak socket counts survive a serialization round
+// trip, and that lists saved without them are still accepted.
+TEST_F(PredictorTest, ReferrerSerializationPeakSocketCountTest) {
+  scoped_refptr<Predictor> predictor(
+      new Predictor(host_resolver_.get(),
+                    default_max_queueing_delay_,
+                    PredictorInit::kMaxSpeculativeParallelResolves,
+                    false));
+  const GURL motivation_url("http://www.google.com:91");
+  const GURL subresource_url("http://icons.google.com:90");
+  const GURL unknown_url("http://unknown.google.com:89");
+  const int kPeakSocketCount = 5;
+  scoped_ptr<ListValue> referral_list(NewEmptySerializationList());
+
+  AddToSerializedList(motivation_url, subresource_url,
+      2.0, referral_list.get());
+  ListValue* motivation_list = FindSerializationMotivation(motivation_url,
+                                                           *referral_list);
+  ASSERT_TRUE(motivation_list != NULL);
+  ListValue* count_list = new ListValue;
+  count_list->Append(new StringValue(subresource_url.spec()));
+  count_list->Append(new FundamentalValue(kPeakSocketCount));
+  // Counts for subresources that aren't listed are dropped.
+  count_list->Append(new StringValue(unknown_url.spec()));
+  count_list->Append(new FundamentalValue(kPeakSocketCount));
+  motivation_list->Append(count_list);
+
+  predictor->DeserializeReferrers(*referral_list.get());
+
+  ListValue recovered_referral_list;
+  predictor->SerializeReferrers(&recovered_referral_list);
+  motivation_list = FindSerializationMotivation(motivation_url,
+                                                recovered_referral_list);
+  ASSERT_TRUE(motivation_list != NULL);
+  ListValue* recovered_count_list;
+  ASSERT_TRUE(motivation_list->GetList(2, &recovered_count_list));
+  ASSERT_EQ(2U, recovered_count_list->GetSize());
+  std::string url_spec;
+  int count;
+  EXPECT_TRUE(recovered_count_list->GetString(0, &url_spec));
+  EXPECT_EQ(subresource_url, GURL(url_spec));
+  EXPECT_TRUE(recovered_count_list->GetInteger(1, &count));
+  EXPECT_EQ(kPeakSocketCount, count);
+
+  predictor->Shutdown();
+}
+
 // Verify that two floats are within 1% of each other in value.
 #define EXPECT_SIMILAR(a, b) do { \
     double espilon_ratio = 1.01;  \
@@ -88,6 +88,7 @@ net::ProxyService* ProxyServiceFactory::CreateProxyService(
         num_pac_threads,
         new net::ProxyScriptFetcherImpl(context),
         context->host_resolver(),
+        NULL,
         net_log);
   } else {
     proxy_service = net::ProxyService::CreateUsingSystemProxyResolver(
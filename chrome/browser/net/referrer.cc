@@ -157,6 +157,36 @@ Value* Referrer::Serialize() const {
   return subresource_list;
 }
 
+void Referrer::DeserializePeakSocketCounts(const Value& value) {
+  if (value.GetType() != Value::TYPE_LIST)
+    return;
+  const ListValue* count_list(static_cast<const ListValue*>(&value));
+  size_t index = 0;  // Bounds checking is done by count_list->Get*().
+  while (true) {
+    std::string url_spec;
+    if (!count_list->GetString(index++, &url_spec))
+      return;
+    int count;
+    if (!count_list->GetInteger(index++, &count))
+      return;
+
+    SubresourceMap::iterator it = find(GURL(url_spec));
+    if (it != end() && count > 0)
+      it->second.set_peak_socket_count(count);
+  }
+}
+
+Value* Referrer::SerializePeakSocketCounts() const {
+  ListValue* count_list(new ListValue);
+  for (const_iterator it = begin(); it != end(); ++it) {
+    if (it->second.peak_socket_count() <= 0)
+      continue;
+    count_list->Append(new StringValue(it->first.spec()));
+    count_list->Append(new FundamentalValue(it->second.peak_socket_count()));
+  }
+  return count_list;
+}
+
 //------------------------------------------------------------------------------
 
 ReferrerValue::ReferrerValue()
@@ -164,7 +194,8 @@ ReferrerValue::ReferrerValue()
       navigation_count_(0),
       preconnection_count_(0),
       preresolution_count_(0),
-      subresource_use_rate_(kInitialConnectsExpectedValue) {
+      subresource_use_rate_(kInitialConnectsExpectedValue),
+      peak_socket_count_(0) {
 }
 
 void ReferrerValue::SubresourceIsNeeded() {
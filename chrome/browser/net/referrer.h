@@ -39,6 +39,12 @@ class ReferrerValue {
   // Used during deserialization.
   void SetSubresourceUseRate(double rate) { subresource_use_rate_ = rate; }
 
+  // The largest number of connections to this subresource that were in use at
+  // the same time, the last time its referrer was navigated to.  0 when
+  // unknown.
+  int peak_socket_count() const { return peak_socket_count_; }
+  void set_peak_socket_count(int count) { peak_socket_count_ = count; }
+
   base::Time birth_time() const { return birth_time_; }
 
   // Record the fact that we navigated to the associated subresource URL.  This
@@ -81,6 +87,9 @@ class ReferrerValue {
   // A smoothed estimate of the expected number of connections that will be made
   // to this subresource.
   double subresource_use_rate_;
+
+  // See peak_socket_count().
+  int peak_socket_count_;
 };
 
 //------------------------------------------------------------------------------
@@ -118,6 +127,13 @@ class Referrer : public SubresourceMap {
   Value* Serialize() const;
   void Deserialize(const Value& referrers);
 
+  // Persist and restore the learned peak socket counts.  These are kept apart
+  // from Serialize() so that lists saved without them remain readable.
+  // DeserializePeakSocketCounts() only updates subresources that are already
+  // present.
+  Value* SerializePeakSocketCounts() const;
+  void DeserializePeakSocketCounts(const Value& value);
+
  private:
   // Helper function for pruning list.  Metric for usefulness is "large accrued
   // value," in the form of latency_ savings associated with a host name.  We
@@ -0,0 +1,100 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/net/spdy_settings_persister.h"
+
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/message_loop.h"
+#include "content/browser/browser_thread.h"
+
+namespace {
+
+// How long the changes to the settings are coalesced before being written.
+const int kSaveDelayMs = 10 * 1000;
+
+}  // namespace
+
+SpdySettingsPersister::SpdySettingsPersister(const FilePath& state_file)
+    : ALLOW_THIS_IN_INITIALIZER_LIST(save_coalescer_(this)),
+      storage_(NULL),
+      state_file_(state_file) {
+}
+
+SpdySettingsPersister::~SpdySettingsPersister() {
+  DCHECK(!storage_);
+}
+
+void SpdySettingsPersister::Initialize(net::SpdySettingsStorage* storage) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  DCHECK(!storage_);
+  storage_ = storage;
+  storage_->set_delegate(this);
+
+  BrowserThread::PostTask(BrowserThread::FILE, FROM_HERE,
+      NewRunnableMethod(this, &SpdySettingsPersister::Load));
+}
+
+void SpdySettingsPersister::Shutdown() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if (!storage_)
+    return;
+
+  if (!save_coalescer_.empty()) {
+    save_coalescer_.RevokeAll();
+    Save();
+  }
+  storage_->set_delegate(NULL);
+  storage_ = NULL;
+}
+
+void SpdySettingsPersister::SettingsAreDirty(
+    net::SpdySettingsStorage* storage) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  DCHECK(storage == storage_);
+
+  if (!save_coalescer_.empty())
+    return;
+
+  MessageLoop::current()->PostDelayedTask(FROM_HERE,
+      save_coalescer_.NewRunnableMethod(&SpdySettingsPersister::Save),
+      kSaveDelayMs);
+}
+
+void SpdySettingsPersister::Load() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+
+  std::string state;
+  if (!file_util::ReadFileToString(state_file_, &state))
+    return;
+
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
+      NewRunnableMethod(this, &SpdySettingsPersister::CompleteLoad, state));
+}
+
+void SpdySettingsPersister::CompleteLoad(const std::string& state) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if (!storage_)
+    return;
+
+  if (!storage_->LoadEntries(state))
+    LOG(WARNING) << "Failed to load the saved SPDY settings";
+}
+
+void SpdySettingsPersister::Save() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  DCHECK(storage_);
+
+  std::string state;
+  storage_->Serialize(&state);
+
+  BrowserThread::PostTask(BrowserThread::FILE, FROM_HERE,
+      NewRunnableMethod(this, &SpdySettingsPersister::CompleteSave, state));
+}
+
+void SpdySettingsPersister::CompleteSave(const std::string& state) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+
+  file_util::WriteFile(state_file_, state.data(), state.size());
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// SpdySettingsPersister keeps the SETTINGS that SPDY servers asked us to
+// persist (for instance their initial window and cwnd hints) across restarts.
+//
+// The settings are loaded on the file thread when the network session is
+// created, and merged into its SpdySettingsStorage on the IO thread. When the
+// storage changes, the writes are coalesced for a while before the settings
+// are serialised and written on the file thread, so a burst of new sessions
+// costs a single write. The storage itself bounds the number of hosts and
+// drops the settings that haven't been updated for a long time.
+
+#ifndef CHROME_BROWSER_NET_SPDY_SETTINGS_PERSISTER_H_
+#define CHROME_BROWSER_NET_SPDY_SETTINGS_PERSISTER_H_
+#pragma once
+
+#include <string>
+
+#include "base/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/task.h"
+#include "net/spdy/spdy_settings_storage.h"
+
+class SpdySettingsPersister
+    : public base::RefCountedThreadSafe<SpdySettingsPersister>,
+      public net::SpdySettingsStorage::Delegate {
+ public:
+  explicit SpdySettingsPersister(const FilePath& state_file);
+
+  // Starts loading the saved settings into |storage|, and saving its changes.
+  // Must be called on the IO thread.
+  void Initialize(net::SpdySettingsStorage* storage);
+
+  // Writes the pending changes and stops using the storage. Must be called on
+  // the IO thread before the storage goes away.
+  void Shutdown();
+
+  // net::SpdySettingsStorage::Delegate implementation:
+  virtual void SettingsAreDirty(net::SpdySettingsStorage* storage);
+
+ private:
+  friend class base::RefCountedThreadSafe<SpdySettingsPersister>;
+
+  virtual ~SpdySettingsPersister();
+
+  void Load();
+  void CompleteLoad(const std::string& state);
+
+  void Save();
+  void CompleteSave(const std::string& state);
+
+  // Used on the IO thread to coalesce writes to disk.
+  ScopedRunnableMethodFactory<SpdySettingsPersister> save_coalescer_;
+
+  net::SpdySettingsStorage* storage_;  // IO thread only.
+
+  // The path to the file in which we store the serialised settings.
+  const FilePath state_file_;
+
+  DISALLOW_COPY_AND_ASSIGN(SpdySettingsPersister);
+};
+
+#endif  // CHROME_BROWSER_NET_SPDY_SETTINGS_PERSISTER_H_
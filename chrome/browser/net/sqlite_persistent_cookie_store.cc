@@ -4,7 +4,12 @@
 
 #include "chrome/browser/net/sqlite_persistent_cookie_store.h"
 
+#include <algorithm>
+#include <deque>
 #include <list>
+#include <map>
+#include <set>
+#include <utility>
 
 #include "app/sql/meta_table.h"
 #include "app/sql/statement.h"
@@ -19,6 +24,7 @@
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/metrics/histogram.h"
+#include "base/stl_util-inl.h"
 #include "base/string_util.h"
 #include "base/threading/thread.h"
 #include "base/threading/thread_restrictions.h"
@@ -57,16 +63,26 @@ class SQLitePersistentCookieStore::Backend
       : path_(path),
         db_(NULL),
         num_pending_(0),
-        clear_local_state_on_exit_(false)
+        clear_local_state_on_exit_(false),
+        synchronous_mode_(sql::Connection::SYNCHRONOUS_NORMAL),
+        keys_read_(false)
 #if defined(ANDROID)
         , cookie_count_(0)
 #endif
   {
   }
 
-  // Creates or load the SQLite database.
+  // Creates or load the SQLite database.  Cookies already handed out by
+  // LoadCookiesForKey() are not read again.
   bool Load(std::vector<net::CookieMonster::CanonicalCookie*>* cookies);
 
+  // Reads the cookies under |key|.  The first call also starts reading the
+  // other keys on the background thread, most recently used first, so that
+  // later calls and Load() find them in memory.
+  bool LoadCookiesForKey(
+      const std::string& key,
+      std::vector<net::CookieMonster::CanonicalCookie*>* cookies);
+
   // Batch a cookie addition.
   void AddCookie(const net::CookieMonster::CanonicalCookie& cc);
 
@@ -85,6 +101,10 @@ class SQLitePersistentCookieStore::Backend
 
   void SetClearLocalStateOnExit(bool clear_local_state);
 
+  void set_synchronous_mode(sql::Connection::SynchronousMode mode) {
+    synchronous_mode_ = mode;
+  }
+
 #if defined(ANDROID)
   int get_cookie_count() const { return cookie_count_; }
   void set_cookie_count(int count) { cookie_count_ = count; }
@@ -97,11 +117,34 @@ class SQLitePersistentCookieStore::Backend
   ~Backend() {
     DCHECK(!db_.get()) << "Close should have already been called.";
     DCHECK(num_pending_ == 0 && pending_.empty());
+    DCHECK(prefetched_.empty());
   }
 
+  // Opens the database, creating or upgrading it as needed, unless that has
+  // been done already.  |db_lock_| must be held.
+  bool InitializeDatabase();
+
   // Database upgrade statements.
   bool EnsureDatabaseVersion();
 
+  // Fills |keys_to_load_| and |keys_by_priority_| from the database.
+  // |db_lock_| must be held.
+  bool ReadKeys();
+
+  // Appends the cookies whose host_key is in |host_keys| to |cookies|.
+  // |db_lock_| must be held.
+  bool LoadCookiesForHostKeys(
+      const std::set<std::string>& host_keys,
+      std::vector<net::CookieMonster::CanonicalCookie*>* cookies);
+
+  // Runs on the background thread.  Reads the cookies of the first key in
+  // |keys_by_priority_| that has not been handed out yet into |prefetched_|,
+  // then posts itself again to read the next one.
+  void PrefetchNextKey();
+
+  // Posts PrefetchNextKey() to the background thread.
+  void PostPrefetchNextKey();
+
   class PendingOperation {
    public:
     typedef enum {
@@ -140,12 +183,37 @@ class SQLitePersistentCookieStore::Backend
   sql::MetaTable meta_table_;
 
   typedef std::list<PendingOperation*> PendingOperationsList;
+
+  // Drops the operations in |ops| that a later one for the same cookie makes
+  // redundant, e.g. an add followed by a delete, so that they never reach the
+  // database.
+  static void CoalesceOperations(PendingOperationsList* ops);
+
   PendingOperationsList pending_;
   PendingOperationsList::size_type num_pending_;
   // True if the persistent store should be deleted upon destruction.
   bool clear_local_state_on_exit_;
   // Guard |pending_|, |num_pending_| and |clear_local_state_on_exit_|.
   base::Lock lock_;
+  // How often the database waits for commits to reach the disk.
+  sql::Connection::SynchronousMode synchronous_mode_;
+
+  typedef std::map<std::string, std::set<std::string> > HostKeysMap;
+  typedef std::map<std::string,
+      std::vector<net::CookieMonster::CanonicalCookie*> > CookiesPerKeyMap;
+
+  // True once the keys in the database have been read into |keys_to_load_|.
+  bool keys_read_;
+  // The keys, as from CookieMonster::GetEffectiveDomainKey(), whose cookies
+  // have not been handed out yet, each with the host_keys under it.
+  HostKeysMap keys_to_load_;
+  // The keys in |keys_to_load_|, most recently used first.
+  std::deque<std::string> keys_by_priority_;
+  // Cookies read by PrefetchNextKey() that have not been handed out yet.
+  CookiesPerKeyMap prefetched_;
+  // Guard |db_| and the loading state above, since the calling thread loads
+  // cookies by key while the background thread prefetches and commits.
+  base::Lock db_lock_;
 
 #if defined(ANDROID)
   // Number of cookies that have actually been saved. Updated during Commit().
@@ -196,15 +264,49 @@ bool InitTable(sql::Connection* db) {
   // so we want those people to get it. Ignore errors, since it may exist.
   db->Execute(
       "CREATE INDEX IF NOT EXISTS cookie_times ON cookies (creation_utc)");
+  // Cookies are loaded a host_key at a time, see LoadCookiesForKey().
+  db->Execute("CREATE INDEX IF NOT EXISTS domain ON cookies (host_key)");
   return true;
 }
 
+// Appends the cookies in the rows |smt| selects to |cookies|.  The columns
+// must be in the order of the cookies table.
+void ReadCookies(sql::Statement* smt,
+                 std::vector<net::CookieMonster::CanonicalCookie*>* cookies) {
+  while (smt->Step()) {
+#if defined(ANDROID)
+    base::Time expires = Time::FromInternalValue(smt->ColumnInt64(5));
+#endif
+    scoped_ptr<net::CookieMonster::CanonicalCookie> cc(
+        new net::CookieMonster::CanonicalCookie(
+            // The "source" URL is not used with persisted cookies.
+            GURL(),                                         // Source
+            smt->ColumnString(2),                           // name
+            smt->ColumnString(3),                           // value
+            smt->ColumnString(1),                           // domain
+            smt->ColumnString(4),                           // path
+            Time::FromInternalValue(smt->ColumnInt64(0)),   // creation_utc
+            Time::FromInternalValue(smt->ColumnInt64(5)),   // expires_utc
+            Time::FromInternalValue(smt->ColumnInt64(8)),   // last_access_utc
+            smt->ColumnInt(6) != 0,                         // secure
+            smt->ColumnInt(7) != 0,                         // httponly
+#if defined(ANDROID)
+            !expires.is_null()));                           // has_expires
+#else
+            true));                                         // has_expires
+#endif
+    DLOG_IF(WARNING,
+            cc->CreationDate() > Time::Now()) << L"CreationDate too recent";
+    cookies->push_back(cc.release());
+  }
+}
+
 }  // namespace
 
-bool SQLitePersistentCookieStore::Backend::Load(
-    std::vector<net::CookieMonster::CanonicalCookie*>* cookies) {
-  // This function should be called only once per instance.
-  DCHECK(!db_.get());
+bool SQLitePersistentCookieStore::Backend::InitializeDatabase() {
+  db_lock_.AssertAcquired();
+  if (db_.get())
+    return true;
 
   // Ensure the parent directory for storing cookies is created before reading
   // from it.  We make an exception to allow IO on the UI thread here because
@@ -218,6 +320,10 @@ bool SQLitePersistentCookieStore::Backend::Load(
   }
 
   db_.reset(new sql::Connection);
+  // With a write-ahead log, commits append to the log and only checkpoints
+  // need a full sync, so the DB thread spends much less time in fsync().
+  db_->set_write_ahead_log();
+  db_->set_synchronous(synchronous_mode_);
   if (!db_->Open(path_)) {
     NOTREACHED() << "Unable to open cookie DB.";
     db_.reset();
@@ -235,6 +341,33 @@ bool SQLitePersistentCookieStore::Backend::Load(
     db_.reset();
     return false;
   }
+  return true;
+}
+
+bool SQLitePersistentCookieStore::Backend::Load(
+    std::vector<net::CookieMonster::CanonicalCookie*>* cookies) {
+  base::AutoLock locked(db_lock_);
+  if (!InitializeDatabase())
+    return false;
+
+  if (keys_read_) {
+    // Some keys have been loaded already; hand over what has been prefetched
+    // and read the rest by host_key.
+    for (CookiesPerKeyMap::iterator it = prefetched_.begin();
+         it != prefetched_.end(); ++it) {
+      cookies->insert(cookies->end(), it->second.begin(), it->second.end());
+    }
+    prefetched_.clear();
+
+    std::set<std::string> host_keys;
+    for (HostKeysMap::const_iterator it = keys_to_load_.begin();
+         it != keys_to_load_.end(); ++it) {
+      host_keys.insert(it->second.begin(), it->second.end());
+    }
+    keys_to_load_.clear();
+    keys_by_priority_.clear();
+    return LoadCookiesForHostKeys(host_keys, cookies);
+  }
 
   db_->Preload();
 
@@ -248,40 +381,157 @@ bool SQLitePersistentCookieStore::Backend::Load(
     return false;
   }
 
-  while (smt.Step()) {
-#if defined(ANDROID)
-    base::Time expires = Time::FromInternalValue(smt.ColumnInt64(5));
-#endif
-    scoped_ptr<net::CookieMonster::CanonicalCookie> cc(
-        new net::CookieMonster::CanonicalCookie(
-            // The "source" URL is not used with persisted cookies.
-            GURL(),                                         // Source
-            smt.ColumnString(2),                            // name
-            smt.ColumnString(3),                            // value
-            smt.ColumnString(1),                            // domain
-            smt.ColumnString(4),                            // path
-            Time::FromInternalValue(smt.ColumnInt64(0)),    // creation_utc
-            Time::FromInternalValue(smt.ColumnInt64(5)),    // expires_utc
-            Time::FromInternalValue(smt.ColumnInt64(8)),    // last_access_utc
-            smt.ColumnInt(6) != 0,                          // secure
-            smt.ColumnInt(7) != 0,                          // httponly
-#if defined(ANDROID)
-            !expires.is_null()));                           // has_expires
-#else
-            true));                                         // has_expires
+  ReadCookies(&smt, cookies);
+
+#ifdef ANDROID
+  set_cookie_count(cookies->size());
 #endif
-    DLOG_IF(WARNING,
-            cc->CreationDate() > Time::Now()) << L"CreationDate too recent";
-    cookies->push_back(cc.release());
+
+  return true;
+}
+
+bool SQLitePersistentCookieStore::Backend::LoadCookiesForKey(
+    const std::string& key,
+    std::vector<net::CookieMonster::CanonicalCookie*>* cookies) {
+  base::AutoLock locked(db_lock_);
+  if (!InitializeDatabase())
+    return false;
+
+  if (!keys_read_) {
+    if (!ReadKeys())
+      return false;
+    PostPrefetchNextKey();
+  }
+
+  CookiesPerKeyMap::iterator prefetched = prefetched_.find(key);
+  if (prefetched != prefetched_.end()) {
+    cookies->insert(cookies->end(), prefetched->second.begin(),
+                    prefetched->second.end());
+    prefetched_.erase(prefetched);
+    return true;
   }
 
+  HostKeysMap::iterator it = keys_to_load_.find(key);
+  if (it == keys_to_load_.end())
+    return true;  // No cookies for |key|, or handed out already.
+  std::set<std::string> host_keys;
+  host_keys.swap(it->second);
+  keys_to_load_.erase(it);
+  return LoadCookiesForHostKeys(host_keys, cookies);
+}
+
+bool SQLitePersistentCookieStore::Backend::ReadKeys() {
+  db_lock_.AssertAcquired();
+  DCHECK(!keys_read_);
+
+  sql::Statement smt(db_->GetUniqueStatement(
+      "SELECT host_key, COUNT(*), MAX(last_access_utc) FROM cookies "
+      "GROUP BY host_key"));
+  if (!smt) {
+    NOTREACHED() << "select statement prep failed";
+    return false;
+  }
+
+  // The most recent access to any cookie under each key.
+  std::map<std::string, int64> last_access;
 #ifdef ANDROID
-  set_cookie_count(cookies->size());
+  int cookie_count = 0;
+#endif
+  while (smt.Step()) {
+    const std::string host_key(smt.ColumnString(0));
+    const std::string key(
+        net::CookieMonster::GetEffectiveDomainKey(host_key));
+    keys_to_load_[key].insert(host_key);
+    int64& key_last_access = last_access[key];
+    key_last_access = std::max(key_last_access, smt.ColumnInt64(2));
+#ifdef ANDROID
+    cookie_count += smt.ColumnInt(1);
 #endif
+  }
+#ifdef ANDROID
+  set_cookie_count(cookie_count);
+#endif
+
+  std::vector<std::pair<int64, std::string> > keys;
+  keys.reserve(last_access.size());
+  for (std::map<std::string, int64>::const_iterator it = last_access.begin();
+       it != last_access.end(); ++it) {
+    keys.push_back(std::make_pair(-it->second, it->first));
+  }
+  std::sort(keys.begin(), keys.end());
+  for (size_t i = 0; i < keys.size(); ++i)
+    keys_by_priority_.push_back(keys[i].second);
 
+  keys_read_ = true;
   return true;
 }
 
+bool SQLitePersistentCookieStore::Backend::LoadCookiesForHostKeys(
+    const std::set<std::string>& host_keys,
+    std::vector<net::CookieMonster::CanonicalCookie*>* cookies) {
+  db_lock_.AssertAcquired();
+  if (!db_.get())
+    return false;
+
+  sql::Statement smt(db_->GetCachedStatement(SQL_FROM_HERE,
+      "SELECT creation_utc, host_key, name, value, path, expires_utc, secure, "
+      "httponly, last_access_utc FROM cookies WHERE host_key = ?"));
+  if (!smt) {
+    NOTREACHED() << "select statement prep failed";
+    return false;
+  }
+
+  for (std::set<std::string>::const_iterator it = host_keys.begin();
+       it != host_keys.end(); ++it) {
+    smt.Reset();
+    smt.BindString(0, *it);
+    ReadCookies(&smt, cookies);
+  }
+  return true;
+}
+
+void SQLitePersistentCookieStore::Backend::PrefetchNextKey() {
+#ifndef ANDROID
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::DB));
+#endif
+  base::AutoLock locked(db_lock_);
+  // Maybe we are already Close()'ed.
+  if (!db_.get())
+    return;
+
+  while (!keys_by_priority_.empty()) {
+    const std::string key(keys_by_priority_.front());
+    keys_by_priority_.pop_front();
+
+    HostKeysMap::iterator it = keys_to_load_.find(key);
+    if (it == keys_to_load_.end())
+      continue;  // Handed out already.
+
+    std::vector<net::CookieMonster::CanonicalCookie*>& cookies =
+        prefetched_[key];
+    LoadCookiesForHostKeys(it->second, &cookies);
+    keys_to_load_.erase(it);
+    break;
+  }
+
+  // Read one key per task, so that commits and the calling thread are not
+  // kept waiting on |db_lock_|.
+  if (!keys_by_priority_.empty())
+    PostPrefetchNextKey();
+}
+
+void SQLitePersistentCookieStore::Backend::PostPrefetchNextKey() {
+#ifdef ANDROID
+  MessageLoop* loop = g_db_thread.Get().message_loop();
+  loop->PostTask(FROM_HERE,
+      NewRunnableMethod(this, &Backend::PrefetchNextKey));
+#else
+  BrowserThread::PostTask(
+      BrowserThread::DB, FROM_HERE,
+      NewRunnableMethod(this, &Backend::PrefetchNextKey));
+#endif
+}
+
 bool SQLitePersistentCookieStore::Backend::EnsureDatabaseVersion() {
   // Version check.
   if (!meta_table_.Init(
@@ -440,10 +690,15 @@ void SQLitePersistentCookieStore::Backend::Commit() {
     num_pending_ = 0;
   }
 
+  base::AutoLock db_locked(db_lock_);
   // Maybe an old timer fired or we are already Close()'ed.
   if (!db_.get() || ops.empty())
     return;
 
+  CoalesceOperations(&ops);
+  if (ops.empty())
+    return;
+
   sql::Statement add_smt(db_->GetCachedStatement(SQL_FROM_HERE,
       "INSERT INTO cookies (creation_utc, host_key, name, value, path, "
       "expires_utc, secure, httponly, last_access_utc) "
@@ -532,6 +787,52 @@ void SQLitePersistentCookieStore::Backend::Commit() {
                             succeeded ? 0 : 1, 2);
 }
 
+// static
+void SQLitePersistentCookieStore::Backend::CoalesceOperations(
+    PendingOperationsList* ops) {
+  // The last operation kept for each cookie, by creation time.  Once a cookie
+  // has been through add, update and delete, at most one operation is left
+  // for it, except for a delete followed by an add.
+  typedef std::map<int64, PendingOperationsList::iterator> LastOperationMap;
+  LastOperationMap last_ops;
+
+  for (PendingOperationsList::iterator it = ops->begin(); it != ops->end();) {
+    PendingOperation* po = *it;
+    const int64 creation_time = po->cc().CreationDate().ToInternalValue();
+    LastOperationMap::iterator last = last_ops.find(creation_time);
+    if (last != last_ops.end()) {
+      PendingOperation* last_po = *last->second;
+      if (po->op() == PendingOperation::COOKIE_UPDATEACCESS &&
+          last_po->op() != PendingOperation::COOKIE_DELETE) {
+        // Fold the new access time into the add or update.
+        *last->second = new PendingOperation(last_po->op(), po->cc());
+        delete last_po;
+        delete po;
+        it = ops->erase(it);
+        continue;
+      }
+      if (po->op() == PendingOperation::COOKIE_DELETE &&
+          last_po->op() == PendingOperation::COOKIE_ADD) {
+        // The cookie was never written; neither is needed.
+        delete last_po;
+        ops->erase(last->second);
+        last_ops.erase(last);
+        delete po;
+        it = ops->erase(it);
+        continue;
+      }
+      if (po->op() == PendingOperation::COOKIE_DELETE &&
+          last_po->op() == PendingOperation::COOKIE_UPDATEACCESS) {
+        // No point updating a row that is about to go.
+        delete last_po;
+        ops->erase(last->second);
+      }
+    }
+    last_ops[creation_time] = it;
+    ++it;
+  }
+}
+
 void SQLitePersistentCookieStore::Backend::Flush(Task* completion_task) {
 #if defined(ANDROID)
   MessageLoop* loop = g_db_thread.Get().message_loop();
@@ -581,7 +882,15 @@ void SQLitePersistentCookieStore::Backend::InternalBackgroundClose() {
   Commit();
 #endif
 
-  db_.reset();
+  {
+    base::AutoLock locked(db_lock_);
+    db_.reset();
+    for (CookiesPerKeyMap::iterator it = prefetched_.begin();
+         it != prefetched_.end(); ++it) {
+      STLDeleteElements(&it->second);
+    }
+    prefetched_.clear();
+  }
 
   if (clear_local_state_on_exit_)
     file_util::Delete(path_, false);
@@ -610,6 +919,12 @@ bool SQLitePersistentCookieStore::Load(
   return backend_->Load(cookies);
 }
 
+bool SQLitePersistentCookieStore::LoadCookiesForKey(
+    const std::string& key,
+    std::vector<net::CookieMonster::CanonicalCookie*>* cookies) {
+  return backend_->LoadCookiesForKey(key, cookies);
+}
+
 void SQLitePersistentCookieStore::AddCookie(
     const net::CookieMonster::CanonicalCookie& cc) {
   if (backend_.get())
@@ -634,6 +949,12 @@ void SQLitePersistentCookieStore::SetClearLocalStateOnExit(
     backend_->SetClearLocalStateOnExit(clear_local_state);
 }
 
+void SQLitePersistentCookieStore::SetSynchronousMode(
+    sql::Connection::SynchronousMode mode) {
+  if (backend_.get())
+    backend_->set_synchronous_mode(mode);
+}
+
 void SQLitePersistentCookieStore::Flush(Task* completion_task) {
   if (backend_.get())
     backend_->Flush(completion_task);
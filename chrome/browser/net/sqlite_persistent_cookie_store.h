@@ -14,6 +14,7 @@
 #ifdef ANDROID
 #include "base/base_api.h"
 #endif
+#include "app/sql/connection.h"
 #include "base/memory/ref_counted.h"
 #include "net/base/cookie_monster.h"
 
@@ -33,6 +34,9 @@ SQLitePersistentCookieStore
   virtual ~SQLitePersistentCookieStore();
 
   virtual bool Load(std::vector<net::CookieMonster::CanonicalCookie*>* cookies);
+  virtual bool LoadCookiesForKey(
+      const std::string& key,
+      std::vector<net::CookieMonster::CanonicalCookie*>* cookies);
 
   virtual void AddCookie(const net::CookieMonster::CanonicalCookie& cc);
   virtual void UpdateCookieAccessTime(
@@ -43,6 +47,11 @@ SQLitePersistentCookieStore
 
   virtual void Flush(Task* completion_task);
 
+  // Sets how often the database waits for commits to reach the disk.  The
+  // default, SYNCHRONOUS_NORMAL, can lose the last commits on power loss.
+  // Must be called before Load().
+  void SetSynchronousMode(sql::Connection::SynchronousMode mode);
+
 #if defined(ANDROID)
   int GetCookieCount();
 #endif
@@ -177,3 +177,84 @@ TEST_F(SQLitePersistentCookieStoreTest, TestFlushCompletionCallback) {
 
   ASSERT_EQ(1, counter->callback_count());
 }
+
+// Test that the cookies for one key can be loaded before the rest, and that
+// Load() then returns only the rest.
+TEST_F(SQLitePersistentCookieStoreTest, TestLoadCookiesForKey) {
+  const char* const kDomains[] = { ".google.com", "www.google.com",
+                                   "www.mit.edu" };
+  for (size_t i = 0; i < arraysize(kDomains); ++i) {
+    // Each cookie needs a unique timestamp for creation_utc (see DB schema).
+    base::Time t = base::Time::Now() + base::TimeDelta::FromMicroseconds(i);
+    store_->AddCookie(
+        net::CookieMonster::CanonicalCookie(GURL(), "A", "B", kDomains[i],
+                                            "/", t, t, t,
+                                            false, false, true));
+  }
+  store_ = NULL;
+  scoped_refptr<ThreadTestHelper> helper(
+      new ThreadTestHelper(BrowserThread::DB));
+  // Make sure we wait until the destructor has run.
+  ASSERT_TRUE(helper->Run());
+  store_ = new SQLitePersistentCookieStore(
+      temp_dir_.path().Append(chrome::kCookieFilename));
+
+  std::vector<net::CookieMonster::CanonicalCookie*> cookies;
+  ASSERT_TRUE(store_->LoadCookiesForKey("google.com", &cookies));
+  ASSERT_EQ(2U, cookies.size());
+  EXPECT_EQ("google.com",
+            net::CookieMonster::GetEffectiveDomainKey(cookies[0]->Domain()));
+  EXPECT_EQ("google.com",
+            net::CookieMonster::GetEffectiveDomainKey(cookies[1]->Domain()));
+  STLDeleteContainerPointers(cookies.begin(), cookies.end());
+  cookies.clear();
+
+  // Let the rest be prefetched; Load() must not return google.com again.
+  ASSERT_TRUE(helper->Run());
+  ASSERT_TRUE(store_->Load(&cookies));
+  ASSERT_EQ(2U, cookies.size());
+  for (size_t i = 0; i < cookies.size(); ++i) {
+    EXPECT_NE("google.com",
+              net::CookieMonster::GetEffectiveDomainKey(cookies[i]->Domain()));
+  }
+  STLDeleteContainerPointers(cookies.begin(), cookies.end());
+}
+
+// Test that operations on a cookie within one batch end up with the same
+// result as running them one by one.
+TEST_F(SQLitePersistentCookieStoreTest, TestCoalesceOperations) {
+  base::Time t = base::Time::Now();
+  base::Time later = t + base::TimeDelta::FromMinutes(1);
+  net::CookieMonster::CanonicalCookie added_then_deleted(
+      GURL(), "C", "D", "http://foo.bar", "/",
+      t + base::TimeDelta::FromMicroseconds(1), t, t, false, false, true);
+  net::CookieMonster::CanonicalCookie added_then_updated(
+      GURL(), "E", "F", "http://foo.bar", "/",
+      t + base::TimeDelta::FromMicroseconds(2), t, t, false, false, true);
+  store_->AddCookie(added_then_deleted);
+  store_->AddCookie(added_then_updated);
+  store_->DeleteCookie(added_then_deleted);
+  added_then_updated.SetLastAccessDate(later);
+  store_->UpdateCookieAccessTime(added_then_updated);
+
+  store_ = NULL;
+  scoped_refptr<ThreadTestHelper> helper(
+      new ThreadTestHelper(BrowserThread::DB));
+  // Make sure we wait until the destructor has run.
+  ASSERT_TRUE(helper->Run());
+  store_ = new SQLitePersistentCookieStore(
+      temp_dir_.path().Append(chrome::kCookieFilename));
+
+  std::vector<net::CookieMonster::CanonicalCookie*> cookies;
+  ASSERT_TRUE(store_->Load(&cookies));
+  // The cookie added in SetUp() and "E".
+  ASSERT_EQ(2U, cookies.size());
+  for (size_t i = 0; i < cookies.size(); ++i) {
+    EXPECT_NE("C", cookies[i]->Name());
+    if (cookies[i]->Name() == "E") {
+      EXPECT_EQ(later.ToInternalValue(),
+                cookies[i]->LastAccessDate().ToInternalValue());
+    }
+  }
+  STLDeleteContainerPointers(cookies.begin(), cookies.end());
+}
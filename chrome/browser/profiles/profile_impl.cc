@@ -386,11 +386,17 @@ void ProfileImpl::DoFinalInit() {
 
   FilePath app_path = GetPath().Append(chrome::kIsolatedAppStateDirname);
 
+  FilePath spdy_settings_path =
+      GetPath().Append(chrome::kSpdySettingsFilename);
+
+  FilePath alternate_protocols_path =
+      GetPath().Append(chrome::kAlternateProtocolsFilename);
+
   // Make sure we initialize the ProfileIOData after everything else has been
   // initialized that we might be reading from the IO thread.
   io_data_.Init(cookie_path, cache_path, cache_max_size,
                 media_cache_path, media_cache_max_size, extensions_cookie_path,
-                app_path);
+                app_path, spdy_settings_path, alternate_protocols_path);
 
   // Initialize the ProfilePolicyConnector after |io_data_| since it requires
   // the URLRequestContextGetter to be initialized.
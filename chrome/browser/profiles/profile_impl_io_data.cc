@@ -9,8 +9,10 @@
 #include "base/logging.h"
 #include "base/stl_util-inl.h"
 #include "chrome/browser/io_thread.h"
+#include "chrome/browser/net/alternate_protocols_persister.h"
 #include "chrome/browser/net/chrome_net_log.h"
 #include "chrome/browser/net/chrome_network_delegate.h"
+#include "chrome/browser/net/spdy_settings_persister.h"
 #include "chrome/browser/net/sqlite_persistent_cookie_store.h"
 #include "chrome/common/chrome_constants.h"
 #include "chrome/common/chrome_switches.h"
@@ -55,7 +57,9 @@ void ProfileImplIOData::Handle::Init(const FilePath& cookie_path,
                                      const FilePath& media_cache_path,
                                      int media_cache_max_size,
                                      const FilePath& extensions_cookie_path,
-                                     const FilePath& app_path) {
+                                     const FilePath& app_path,
+                                     const FilePath& spdy_settings_path,
+                                     const FilePath& alternate_protocols_path) {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
   DCHECK(!io_data_->lazy_params_.get());
   LazyParams* lazy_params = new LazyParams;
@@ -66,6 +70,8 @@ void ProfileImplIOData::Handle::Init(const FilePath& cookie_path,
   lazy_params->media_cache_path = media_cache_path;
   lazy_params->media_cache_max_size = media_cache_max_size;
   lazy_params->extensions_cookie_path = extensions_cookie_path;
+  lazy_params->spdy_settings_path = spdy_settings_path;
+  lazy_params->alternate_protocols_path = alternate_protocols_path;
 
   io_data_->lazy_params_.reset(lazy_params);
 
@@ -155,6 +161,10 @@ ProfileImplIOData::ProfileImplIOData()
     : ProfileIOData(false),
       clear_local_state_on_exit_(false) {}
 ProfileImplIOData::~ProfileImplIOData() {
+  if (spdy_settings_persister_)
+    spdy_settings_persister_->Shutdown();
+  if (alternate_protocols_persister_)
+    alternate_protocols_persister_->Shutdown();
   STLDeleteValues(&app_http_factory_map_);
 }
 
@@ -238,6 +248,14 @@ void ProfileImplIOData::LazyInitializeInternal(
           lazy_params_->media_cache_max_size,
           BrowserThread::GetMessageLoopProxyForThread(BrowserThread::CACHE));
   net::HttpNetworkSession* main_network_session = main_cache->GetSession();
+  spdy_settings_persister_ =
+      new SpdySettingsPersister(lazy_params_->spdy_settings_path);
+  spdy_settings_persister_->Initialize(
+      main_network_session->spdy_session_pool()->mutable_spdy_settings());
+  alternate_protocols_persister_ =
+      new AlternateProtocolsPersister(lazy_params_->alternate_protocols_path);
+  alternate_protocols_persister_->Initialize(
+      main_network_session->mutable_alternate_protocols());
   net::HttpCache* media_cache =
       new net::HttpCache(main_network_session, media_backend);
 
@@ -11,6 +11,9 @@
 #include "base/memory/ref_counted.h"
 #include "chrome/browser/profiles/profile_io_data.h"
 
+class AlternateProtocolsPersister;
+class SpdySettingsPersister;
+
 namespace net {
 class CookiePolicy;
 class NetworkDelegate;
@@ -37,7 +40,9 @@ class ProfileImplIOData : public ProfileIOData {
               const FilePath& media_cache_path,
               int media_cache_max_size,
               const FilePath& extensions_cookie_path,
-              const FilePath& app_path);
+              const FilePath& app_path,
+              const FilePath& spdy_settings_path,
+              const FilePath& alternate_protocols_path);
 
     const content::ResourceContext& GetResourceContext() const;
     scoped_refptr<ChromeURLRequestContextGetter>
@@ -98,6 +103,8 @@ class ProfileImplIOData : public ProfileIOData {
     FilePath media_cache_path;
     int media_cache_max_size;
     FilePath extensions_cookie_path;
+    FilePath spdy_settings_path;
+    FilePath alternate_protocols_path;
   };
 
   typedef base::hash_map<std::string, net::HttpTransactionFactory* >
@@ -125,6 +132,13 @@ class ProfileImplIOData : public ProfileIOData {
   mutable scoped_ptr<net::HttpTransactionFactory> main_http_factory_;
   mutable scoped_ptr<net::HttpTransactionFactory> media_http_factory_;
 
+  // Saves the SPDY settings of the main network session.
+  mutable scoped_refptr<SpdySettingsPersister> spdy_settings_persister_;
+
+  // Saves the alternate protocols of the main network session.
+  mutable scoped_refptr<AlternateProtocolsPersister>
+      alternate_protocols_persister_;
+
   // One HttpTransactionFactory per isolated app.
   mutable HttpTransactionFactoryMap app_http_factory_map_;
 
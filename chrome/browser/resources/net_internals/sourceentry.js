@@ -224,6 +224,7 @@ SourceEntry.prototype.getDescription = function() {
     case LogSourceType.URL_REQUEST:
     case LogSourceType.SOCKET_STREAM:
     case LogSourceType.HTTP_STREAM_JOB:
+    case LogSourceType.HTTP_CACHE_ASYNC_VALIDATION:
       description = e.params.url;
       break;
     case LogSourceType.CONNECT_JOB:
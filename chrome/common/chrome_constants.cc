@@ -85,8 +85,12 @@ const FilePath::CharType kThemePackFilename[] = FPL("Cached Theme.pak");
 const FilePath::CharType kCookieFilename[] = FPL("Cookies");
 const FilePath::CharType kExtensionsCookieFilename[] = FPL("Extension Cookies");
 const FilePath::CharType kIsolatedAppStateDirname[] = FPL("Isolated Apps");
+const FilePath::CharType kSpdySettingsFilename[] = FPL("SPDY Settings");
+const FilePath::CharType kAlternateProtocolsFilename[] =
+    FPL("Alternate Protocols");
 const FilePath::CharType kFaviconsFilename[] = FPL("Favicons");
 const FilePath::CharType kHistoryFilename[] = FPL("History");
+const FilePath::CharType kHostCacheFilename[] = FPL("Host Cache");
 const FilePath::CharType kLocalStateFilename[] = FPL("Local State");
 const FilePath::CharType kPreferencesFilename[] = FPL("Preferences");
 const FilePath::CharType kSafeBrowsingBaseFilename[] = FPL("Safe Browsing");
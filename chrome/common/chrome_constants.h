@@ -47,8 +47,11 @@ extern const FilePath::CharType kThemePackFilename[];
 extern const FilePath::CharType kCookieFilename[];
 extern const FilePath::CharType kExtensionsCookieFilename[];
 extern const FilePath::CharType kIsolatedAppStateDirname[];
+extern const FilePath::CharType kSpdySettingsFilename[];
+extern const FilePath::CharType kAlternateProtocolsFilename[];
 extern const FilePath::CharType kFaviconsFilename[];
 extern const FilePath::CharType kHistoryFilename[];
+extern const FilePath::CharType kHostCacheFilename[];
 extern const FilePath::CharType kLocalStateFilename[];
 extern const FilePath::CharType kPreferencesFilename[];
 extern const FilePath::CharType kSafeBrowsingBaseFilename[];
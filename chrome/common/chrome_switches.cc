@@ -352,6 +352,10 @@ const char kDumpHistogramsOnExit[]          = "dump-histograms-on-exit";
 // Enable displaying net log events on the command line.
 extern const char kLogNetLog[]              = "log-net-log";
 
+// With kLogNetLog, writes the events in a compact binary format, which
+// net_log_to_json converts back to the usual one.
+const char kLogNetLogBinary[]               = "log-net-log-binary";
+
 // Enable gpu-accelerated 2d canvas.
 const char kEnableAccelerated2dCanvas[]     = "enable-accelerated-2d-canvas";
 
@@ -361,6 +365,10 @@ const char kEnableAcceleratedPlugins[]      = "enable-accelerated-plugins";
 // Enables AeroPeek for each tab. (This switch only works on Windows 7).
 const char kEnableAeroPeekTabs[]            = "enable-aero-peek-tabs";
 
+// Resolves host names with the built-in asynchronous DNS client, which reads
+// the system's name servers, instead of with getaddrinfo() on worker threads.
+const char kEnableAsyncDns[]                = "enable-async-dns";
+
 // Enable the inclusion of non-standard ports when generating the Kerberos SPN
 // in response to a Negotiate challenge. See HttpAuthHandlerNegotiate::CreateSPN
 // for more background.
@@ -465,6 +473,11 @@ const char kEnableResourceContentSettings[] =
 // Enable panels (always on-top docked pop-up windows).
 const char kEnablePanels[]                  = "enable-panels";
 
+// Sends the SOCKS5 greeting, CONNECT request and first data together, instead
+// of waiting for each reply of the proxy.
+const char kEnablePipelinedSocks5Handshake[] =
+    "enable-pipelined-socks5-handshake";
+
 // Enable speculative TCP/IP preconnection.
 const char kEnablePreconnect[]              = "enable-preconnect";
 
@@ -600,6 +613,10 @@ const char kHostResolverParallelism[]       = "host-resolver-parallelism";
 // These mappings only apply to the host resolver.
 const char kHostResolverRules[]             = "host-resolver-rules";
 
+// How many seconds past their expiration cached host resolutions may still be
+// used, while they are refreshed in the background.
+const char kHostResolverStaleGrace[]        = "host-resolver-stale-grace";
+
 // Ignores GPU blacklist.
 const char kIgnoreGpuBlacklist[]            = "ignore-gpu-blacklist";
 
@@ -111,6 +111,7 @@ extern const char kDumpHistogramsOnExit[];
 extern const char kEnableAccelerated2dCanvas[];
 extern const char kEnableAcceleratedPlugins[];
 extern const char kEnableAeroPeekTabs[];
+extern const char kEnableAsyncDns[];
 extern const char kEnableAuthNegotiatePort[];
 extern const char kEnableClientSidePhishingInterstitial[];
 extern const char kEnableClearServerData[];
@@ -136,6 +137,7 @@ extern const char kEnableMemoryInfo[];
 extern const char kEnableNaCl[];
 extern const char kEnableNaClDebug[];
 extern const char kEnablePanels[];
+extern const char kEnablePipelinedSocks5Handshake[];
 extern const char kEnablePreconnect[];
 extern const char kEnablePrintPreview[];
 extern const char kEnableRemoting[];
@@ -173,6 +175,7 @@ extern const char kHomePage[];
 extern const char kHostRules[];
 extern const char kHostResolverParallelism[];
 extern const char kHostResolverRules[];
+extern const char kHostResolverStaleGrace[];
 extern const char kIgnoreGpuBlacklist[];
 extern const char kImport[];
 extern const char kImportFromFile[];
@@ -183,6 +186,7 @@ extern const char kLoadExtension[];
 extern const char kLoadOpencryptoki[];
 extern const char kUninstallExtension[];
 extern const char kLogNetLog[];
+extern const char kLogNetLogBinary[];
 extern const char kMakeDefaultBrowser[];
 extern const char kMediaCacheSize[];
 extern const char kMemoryProfiling[];
@@ -4,6 +4,8 @@
 
 #include "chrome/common/net/url_fetcher.h"
 
+#include <algorithm>
+#include <map>
 #include <set>
 
 #include "base/compiler_specific.h"
@@ -12,6 +14,7 @@
 #include "base/message_loop_proxy.h"
 #include "base/stl_util-inl.h"
 #include "base/string_util.h"
+#include "base/stringprintf.h"
 #include "base/threading/thread.h"
 #include "googleurl/src/gurl.h"
 #include "net/base/load_flags.h"
@@ -83,8 +86,14 @@ class URLFetcher::Core
       return fetchers_.size();
     }
 
+    // The GETs that coalescing fetchers may join, by GetSharedRequestKey().
+    Core* FindSharedRequest(const std::string& key) const;
+    void SetSharedRequest(const std::string& key, Core* core);
+    void RemoveSharedRequest(const std::string& key);
+
    private:
     std::set<Core*> fetchers_;
+    std::map<std::string, Core*> shared_requests_;
 
     DISALLOW_COPY_AND_ASSIGN(Registry);
   };
@@ -103,6 +112,21 @@ class URLFetcher::Core
   // destruction observer.
   void ReleaseRequest();
 
+  // Returns what identifies the fetch among coalescing ones, or an empty
+  // string if it can't be shared.
+  std::string GetSharedRequestKey() const;
+
+  // Waits for the response of an identical request that is in flight, if
+  // there is one.  Returns false if this one has to make its own.
+  bool JoinSharedRequest();
+
+  // Gives the response of |leader_|'s request to this follower.
+  void OnSharedRequestCompleted(const net::URLRequestStatus& status);
+
+  // Called when this leader is cancelled while others still wait for
+  // |request_|, which goes on for them.  The oldest follower takes over.
+  void HandOffRequest();
+
   // Returns the max value of exponential back-off release time for
   // |original_url_| and |url_|.
   base::TimeTicks GetBackoffReleaseTime();
@@ -141,6 +165,14 @@ class URLFetcher::Core
   std::string upload_content_type_;  // MIME type of POST payload
   std::string referrer_;             // HTTP Referer header value
   bool is_chunked_upload_;           // True if using chunked transfer encoding
+  bool coalesce_;                    // True to share identical GETs
+
+  // Both are only accessed on the IO thread.  A follower waits for the
+  // request of its |leader_|, which lists it in |followers_|, oldest first.
+  // Neither can go away without telling the other.
+  Core* leader_;
+  std::vector<Core*> followers_;
+  std::string shared_key_;           // Set while others may join |request_|
 
   // Used to determine how long to wait before making a request or doing a
   // retry.
@@ -191,6 +223,22 @@ void URLFetcher::Core::Registry::CancelAll() {
     (*fetchers_.begin())->CancelURLRequest();
 }
 
+URLFetcher::Core* URLFetcher::Core::Registry::FindSharedRequest(
+    const std::string& key) const {
+  std::map<std::string, Core*>::const_iterator it = shared_requests_.find(key);
+  return it == shared_requests_.end() ? NULL : it->second;
+}
+
+void URLFetcher::Core::Registry::SetSharedRequest(const std::string& key,
+                                                  Core* core) {
+  shared_requests_[key] = core;
+}
+
+void URLFetcher::Core::Registry::RemoveSharedRequest(const std::string& key) {
+  DCHECK(ContainsKey(shared_requests_, key));
+  shared_requests_.erase(key);
+}
+
 // static
 base::LazyInstance<URLFetcher::Core::Registry>
     URLFetcher::Core::g_registry(base::LINKER_INITIALIZED);
@@ -240,6 +288,8 @@ URLFetcher::Core::Core(URLFetcher* fetcher,
       response_code_(-1),
       buffer_(new net::IOBuffer(kBufferSize)),
       is_chunked_upload_(false),
+      coalesce_(false),
+      leader_(NULL),
       num_retries_(0),
       was_cancelled_(false) {
 }
@@ -248,6 +298,8 @@ URLFetcher::Core::~Core() {
   // |request_| should be NULL.  If not, it's unsafe to delete it here since we
   // may not be on the IO thread.
   DCHECK(!request_.get());
+  DCHECK(!leader_);
+  DCHECK(followers_.empty());
 }
 
 void URLFetcher::Core::Start() {
@@ -343,6 +395,11 @@ void URLFetcher::Core::OnReadCompleted(net::URLRequest* request,
   if (!request_->status().is_io_pending() || (request_type_ == HEAD)) {
     backoff_release_time_ = GetBackoffReleaseTime();
 
+    std::vector<Core*> followers;
+    followers.swap(followers_);
+    for (size_t i = 0; i < followers.size(); i++)
+      followers[i]->OnSharedRequestCompleted(request_->status());
+
     bool posted = delegate_loop_proxy_->PostTask(
         FROM_HERE,
         NewRunnableMethod(this,
@@ -367,7 +424,14 @@ void URLFetcher::Core::StartURLRequest() {
   CHECK(request_context_getter_);
   DCHECK(!request_.get());
 
+  // An identical request may have started while this one was delayed.
+  if (JoinSharedRequest())
+    return;
+
   g_registry.Get().AddURLFetcherCore(this);
+  shared_key_ = GetSharedRequestKey();
+  if (!shared_key_.empty())
+    g_registry.Get().SetSharedRequest(shared_key_, this);
   request_.reset(new net::URLRequest(original_url_, this));
   int flags = request_->load_flags() | load_flags_;
   if (!g_interception_enabled) {
@@ -425,6 +489,11 @@ void URLFetcher::Core::StartURLRequestWhenAppropriate() {
             original_url_);
   }
 
+  // Joining a request doesn't send anything, so it doesn't have to wait
+  // for the throttler.
+  if (JoinSharedRequest())
+    return;
+
   int64 delay = original_url_throttler_entry_->ReserveSendingTimeForNextRequest(
       GetBackoffReleaseTime());
   if (delay == 0) {
@@ -441,8 +510,17 @@ void URLFetcher::Core::CancelURLRequest() {
   DCHECK(io_message_loop_proxy_->BelongsToCurrentThread());
 
   if (request_.get()) {
-    request_->Cancel();
-    ReleaseRequest();
+    if (followers_.empty()) {
+      request_->Cancel();
+      ReleaseRequest();
+    } else {
+      HandOffRequest();
+    }
+  } else if (leader_) {
+    std::vector<Core*>& followers = leader_->followers_;
+    followers.erase(std::find(followers.begin(), followers.end(), this));
+    leader_ = NULL;
+    g_registry.Get().RemoveURLFetcherCore(this);
   }
   // Release the reference to the request context. There could be multiple
   // references to URLFetcher::Core at this point so it may take a while to
@@ -494,7 +572,82 @@ void URLFetcher::Core::NotifyMalformedContent() {
 }
 
 void URLFetcher::Core::ReleaseRequest() {
+  DCHECK(followers_.empty());
   request_.reset();
+  if (!shared_key_.empty()) {
+    g_registry.Get().RemoveSharedRequest(shared_key_);
+    shared_key_.clear();
+  }
+  g_registry.Get().RemoveURLFetcherCore(this);
+}
+
+std::string URLFetcher::Core::GetSharedRequestKey() const {
+  if (!coalesce_ || request_type_ != GET)
+    return std::string();
+  return base::StringPrintf("%p %d ", request_context_getter_.get(),
+                            load_flags_) +
+      original_url_.spec() + "\n" + referrer_ + "\n" +
+      extra_request_headers_.ToString();
+}
+
+bool URLFetcher::Core::JoinSharedRequest() {
+  DCHECK(!request_.get());
+  DCHECK(!leader_);
+  std::string key = GetSharedRequestKey();
+  if (key.empty())
+    return false;
+  Core* leader = g_registry.Get().FindSharedRequest(key);
+  if (!leader)
+    return false;
+
+  DCHECK_NE(this, leader);
+  g_registry.Get().AddURLFetcherCore(this);
+  leader_ = leader;
+  leader->followers_.push_back(this);
+  return true;
+}
+
+void URLFetcher::Core::OnSharedRequestCompleted(
+    const net::URLRequestStatus& status) {
+  DCHECK(io_message_loop_proxy_->BelongsToCurrentThread());
+  DCHECK(leader_);
+  url_ = leader_->url_;
+  url_throttler_entry_ = leader_->url_throttler_entry_;
+  response_code_ = leader_->response_code_;
+  response_headers_ = leader_->response_headers_;
+  cookies_ = leader_->cookies_;
+  data_ = leader_->data_;
+  backoff_release_time_ = leader_->backoff_release_time_;
+  leader_ = NULL;
+
+  bool posted = delegate_loop_proxy_->PostTask(
+      FROM_HERE, NewRunnableMethod(this, &Core::OnCompletedURLRequest, status));
+  DCHECK(posted || !delegate_);
+  g_registry.Get().RemoveURLFetcherCore(this);
+}
+
+void URLFetcher::Core::HandOffRequest() {
+  DCHECK(!followers_.empty());
+  Core* heir = followers_.front();
+  followers_.erase(followers_.begin());
+  heir->followers_.swap(followers_);
+  heir->leader_ = NULL;
+  for (size_t i = 0; i < heir->followers_.size(); i++)
+    heir->followers_[i]->leader_ = heir;
+
+  // The request may be in the middle of a read into |buffer_|.
+  heir->request_.reset(request_.release());
+  heir->request_->set_delegate(heir);
+  heir->buffer_ = buffer_;
+  heir->data_.swap(data_);
+  heir->url_ = url_;
+  heir->url_throttler_entry_ = url_throttler_entry_;
+  heir->response_code_ = response_code_;
+  heir->response_headers_ = response_headers_;
+  heir->shared_key_.swap(shared_key_);
+  g_registry.Get().SetSharedRequest(heir->shared_key_, heir);
+
+  // The heir is in the registry already, as a follower.
   g_registry.Get().RemoveURLFetcherCore(this);
 }
 
@@ -553,6 +706,10 @@ int URLFetcher::load_flags() const {
   return core_->load_flags_;
 }
 
+void URLFetcher::set_coalesce_identical_requests(bool coalesce) {
+  core_->coalesce_ = coalesce;
+}
+
 void URLFetcher::set_extra_request_headers(
     const std::string& extra_request_headers) {
   core_->extra_request_headers_.Clear();
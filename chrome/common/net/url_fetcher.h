@@ -153,6 +153,15 @@ class URLFetcher {
   // Returns the current load flags.
   int load_flags() const;
 
+  // If |coalesce| is true, a GET that is started while an identical one is
+  // in flight doesn't make a request of its own, but gets the response of
+  // the other one.  Fetches are identical if they have the same URL, load
+  // flags, referrer, extra headers and request context getter.  Each
+  // URLFetcher still gets its own callback and may still be deleted at any
+  // time; the shared request keeps going as long as one of them wants it.
+  // False by default.  Must be called before the request is started.
+  void set_coalesce_identical_requests(bool coalesce);
+
   // The referrer URL for the request. Must be called before the request is
   // started.
   void set_referrer(const std::string& referrer);
@@ -2,6 +2,9 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
+#include <vector>
+
 #include "base/message_loop_proxy.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/threading/thread.h"
@@ -290,6 +293,23 @@ class URLFetcherMultipleAttemptTest : public URLFetcherTest {
   std::string data_;
 };
 
+// Version of URLFetcherTest that starts identical fetches which share one
+// request, and cancels the one that made it.
+class URLFetcherCoalesceTest : public URLFetcherTest {
+ public:
+  virtual void CreateFetcher(const GURL& url);
+  // URLFetcher::Delegate
+  virtual void OnURLFetchComplete(const URLFetcher* source,
+                                  const GURL& url,
+                                  const net::URLRequestStatus& status,
+                                  int response_code,
+                                  const ResponseCookies& cookies,
+                                  const std::string& data);
+ private:
+  std::vector<URLFetcher*> fetchers_;
+  std::string data_;
+};
+
 // Wrapper that lets us call CreateFetcher() on a thread of our choice.  We
 // could make URLFetcherTest refcounted and use PostTask(FROM_HERE.. ) to call
 // CreateFetcher() directly, but the ownership of the URLFetcherTest is a bit
@@ -486,6 +506,47 @@ void URLFetcherCancelTest::CancelRequest() {
   // did not work.
 }
 
+void URLFetcherCoalesceTest::CreateFetcher(const GURL& url) {
+  scoped_refptr<net::URLRequestContextGetter> context_getter(
+      new TestURLRequestContextGetter(io_message_loop_proxy()));
+  for (int i = 0; i < 3; i++) {
+    URLFetcher* fetcher = new URLFetcher(url, URLFetcher::GET, this);
+    fetcher->set_request_context(context_getter);
+    fetcher->set_coalesce_identical_requests(true);
+    fetcher->Start();
+    fetchers_.push_back(fetcher);
+  }
+  // The request of the first one has to go on for the others.
+  delete fetchers_.front();
+  fetchers_.erase(fetchers_.begin());
+}
+
+void URLFetcherCoalesceTest::OnURLFetchComplete(
+    const URLFetcher* source,
+    const GURL& url,
+    const net::URLRequestStatus& status,
+    int response_code,
+    const ResponseCookies& cookies,
+    const std::string& data) {
+  EXPECT_TRUE(status.is_success());
+  EXPECT_EQ(200, response_code);  // HTTP OK
+  EXPECT_FALSE(data.empty());
+  if (data_.empty())
+    data_ = data;
+  else
+    EXPECT_EQ(data_, data);
+
+  std::vector<URLFetcher*>::iterator it =
+      std::find(fetchers_.begin(), fetchers_.end(), source);
+  ASSERT_TRUE(it != fetchers_.end());
+  delete *it;
+  fetchers_.erase(it);
+  if (fetchers_.empty()) {
+    EXPECT_EQ(0, GetNumFetcherCores());
+    io_message_loop_proxy()->PostTask(FROM_HERE, new MessageLoop::QuitTask());
+  }
+}
+
 void URLFetcherMultipleAttemptTest::OnURLFetchComplete(
     const URLFetcher* source,
     const GURL& url,
@@ -732,6 +793,15 @@ TEST_F(URLFetcherMultipleAttemptTest, SameData) {
   MessageLoop::current()->Run();
 }
 
+// All the fetchers get the one response, with the same time in it.
+TEST_F(URLFetcherCoalesceTest, SharedRequest) {
+  net::TestServer test_server(net::TestServer::TYPE_HTTP, FilePath(kDocRoot));
+  ASSERT_TRUE(test_server.Start());
+
+  CreateFetcher(test_server.GetURL("nocachetime"));
+  MessageLoop::current()->Run();
+}
+
 // Tests to make sure CancelAll() will successfully cancel existing URLFetchers.
 TEST_F(URLFetcherTest, CancelAll) {
   net::TestServer test_server(net::TestServer::TYPE_HTTP, FilePath(kDocRoot));
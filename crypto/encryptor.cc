@@ -0,0 +1,132 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "crypto/encryptor.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/string_util.h"
+
+namespace crypto {
+
+namespace {
+
+// Adds one to the big-endian number in |block|.
+void IncrementCounter(uint8* block) {
+  for (int i = Encryptor::kBlockSize - 1; i >= 0; --i) {
+    if (++block[i])
+      return;
+  }
+}
+
+}  // namespace
+
+bool Encryptor::Encrypt(const std::string& plaintext, std::string* ciphertext) {
+  // Work on the result in a local variable, and then only transfer it to
+  // |ciphertext| on success to ensure no partial data is returned.
+  std::string result;
+  const size_t max_length = MaxCiphertextLength(plaintext.size());
+  uint8* buffer = reinterpret_cast<uint8*>(WriteInto(&result, max_length + 1));
+  size_t length;
+  if (!Encrypt(reinterpret_cast<const uint8*>(plaintext.data()),
+               plaintext.size(), buffer, &length)) {
+    return false;
+  }
+  result.resize(length);
+  ciphertext->swap(result);
+  return true;
+}
+
+bool Encryptor::Decrypt(const std::string& ciphertext, std::string* plaintext) {
+  std::string result;
+  uint8* buffer = reinterpret_cast<uint8*>(
+      WriteInto(&result, ciphertext.size() + 1));
+  size_t length;
+  if (!Decrypt(reinterpret_cast<const uint8*>(ciphertext.data()),
+               ciphertext.size(), buffer, &length)) {
+    return false;
+  }
+  result.resize(length);
+  plaintext->swap(result);
+  return true;
+}
+
+size_t Encryptor::MaxCiphertextLength(size_t plaintext_length) const {
+  if (mode_ == CTR)
+    return plaintext_length;
+  // PKCS #7 padding always adds at least one byte.
+  return (plaintext_length / kBlockSize + 1) * kBlockSize;
+}
+
+bool Encryptor::Encrypt(const uint8* input, size_t input_length,
+                        uint8* output, size_t* output_length) {
+  DCHECK(key_);  // Must call Init() before En/De-crypt.
+  if (mode_ == CTR)
+    return CryptCTR(input, input_length, output, output_length);
+  return CryptCBC(true, input, input_length, output, output_length);
+}
+
+bool Encryptor::Decrypt(const uint8* input, size_t input_length,
+                        uint8* output, size_t* output_length) {
+  DCHECK(key_);  // Must call Init() before En/De-crypt.
+  if (mode_ == CTR)
+    return CryptCTR(input, input_length, output, output_length);
+  // A padded message is never empty.
+  if (input_length == 0)
+    return false;
+  return CryptCBC(false, input, input_length, output, output_length);
+}
+
+bool Encryptor::SetCounter(const base::StringPiece& counter) {
+  DCHECK_EQ(CTR, mode_);
+  if (counter.size() != kBlockSize)
+    return false;
+  memcpy(counter_, counter.data(), kBlockSize);
+  mask_offset_ = 0;
+  mask_length_ = 0;
+  return true;
+}
+
+bool Encryptor::CryptCTR(const uint8* input, size_t input_length,
+                         uint8* output, size_t* output_length) {
+  size_t done = 0;
+  while (done < input_length) {
+    if (mask_offset_ == mask_length_ &&
+        !GenerateCounterMask(input_length - done)) {
+      return false;
+    }
+    const size_t length = std::min(input_length - done,
+                                   mask_length_ - mask_offset_);
+    const uint8* mask = mask_ + mask_offset_;
+    for (size_t i = 0; i < length; ++i)
+      output[done + i] = input[done + i] ^ mask[i];
+    mask_offset_ += length;
+    done += length;
+  }
+  *output_length = input_length;
+  return true;
+}
+
+bool Encryptor::GenerateCounterMask(size_t length) {
+  // Only make as much of the key stream as is needed, so that short messages
+  // don't pay for a whole mask.
+  size_t blocks = (length + kBlockSize - 1) / kBlockSize;
+  if (blocks > kMaskBlocks)
+    blocks = kMaskBlocks;
+  for (size_t i = 0; i < blocks; ++i) {
+    memcpy(mask_ + i * kBlockSize, counter_, kBlockSize);
+    IncrementCounter(counter_);
+  }
+  mask_offset_ = 0;
+  mask_length_ = 0;
+  if (!EncryptBlocks(mask_, blocks * kBlockSize, mask_))
+    return false;
+  mask_length_ = blocks * kBlockSize;
+  return true;
+}
+
+}  // namespace crypto
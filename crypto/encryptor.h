@@ -8,10 +8,18 @@
 
 #include <string>
 
+#include "base/basictypes.h"
+#include "base/string_piece.h"
 #include "build/build_config.h"
 
-#if defined(USE_NSS)
+#if defined(USE_OPENSSL)
+#include <openssl/evp.h>
+
+#include "crypto/openssl_util.h"
+#elif defined(USE_NSS)
 #include "crypto/scoped_nss_types.h"
+#elif defined(OS_MACOSX)
+#include <CommonCrypto/CommonCryptor.h>
 #elif defined(OS_WIN)
 #include "crypto/scoped_capi_types.h"
 #endif
@@ -22,14 +30,25 @@ class SymmetricKey;
 
 class Encryptor {
  public:
+  // In CBC mode every Encrypt() or Decrypt() is a message of its own, padded
+  // with PKCS #7 and started from the IV.  In CTR mode the calls go on with
+  // one stream of key from the counter, so a message can be passed in pieces
+  // of any length, and the output is as long as the input.
   enum Mode {
-    CBC
+    CBC,
+    CTR
   };
+
+  // The AES block size, which is also the length of the IV and the counter.
+  static const size_t kBlockSize = 16;
+
   Encryptor();
   virtual ~Encryptor();
 
   // Initializes the encryptor using |key| and |iv|. Returns false if either the
-  // key or the initialization vector cannot be used.
+  // key or the initialization vector cannot be used.  In CTR mode |iv| is the
+  // initial counter block.  The cipher contexts made here are reused by every
+  // call that follows.
   bool Init(SymmetricKey* key, Mode mode, const std::string& iv);
 
   // Encrypts |plaintext| into |ciphertext|.
@@ -38,30 +57,78 @@ class Encryptor {
   // Decrypts |ciphertext| into |plaintext|.
   bool Decrypt(const std::string& ciphertext, std::string* plaintext);
 
-  // TODO(albertb): Support streaming encryption.
+  // Returns the most bytes that encrypting |plaintext_length| bytes writes.
+  size_t MaxCiphertextLength(size_t plaintext_length) const;
+
+  // Encrypts the |input_length| bytes at |input| into |output|, which must
+  // have room for MaxCiphertextLength(input_length) bytes, and sets
+  // |*output_length| to the number written.  |output| may be |input|.  Unlike
+  // the std::string versions these don't allocate.
+  bool Encrypt(const uint8* input, size_t input_length,
+               uint8* output, size_t* output_length);
+
+  // Decrypts like Encrypt() above.  |output| must have room for
+  // |input_length| bytes.
+  bool Decrypt(const uint8* input, size_t input_length,
+               uint8* output, size_t* output_length);
+
+  // Goes on in CTR mode from |counter|, which must be kBlockSize bytes, as if
+  // Init() had been given it.  Returns false if it is the wrong length.
+  bool SetCounter(const base::StringPiece& counter);
 
  private:
+  // The number of counter blocks encrypted at a time in CTR mode.
+  static const size_t kMaskBlocks = 32;
+
+  // Encrypts or decrypts in CTR mode, which are the same.
+  bool CryptCTR(const uint8* input, size_t input_length,
+                uint8* output, size_t* output_length);
+
+  // Fills |mask_| with the key stream for up to |length| more bytes.
+  bool GenerateCounterMask(size_t length);
+
+  // Implemented for each platform.  Runs the CBC cipher over one message, into
+  // an output buffer sized as for Encrypt() or Decrypt().
+  bool CryptCBC(bool do_encrypt,
+                const uint8* input, size_t input_length,
+                uint8* output, size_t* output_length);
+
+  // Implemented for each platform.  Encrypts |length| bytes, a whole number of
+  // blocks, with the bare block cipher.  |output| may be |input|.
+  bool EncryptBlocks(const uint8* input, size_t length, uint8* output);
+
   SymmetricKey* key_;
   Mode mode_;
 
+  // The next counter block, and the unused key stream from earlier ones.
+  uint8 counter_[kBlockSize];
+  uint8 mask_[kMaskBlocks * kBlockSize];
+  size_t mask_offset_;
+  size_t mask_length_;
+
 #if defined(USE_OPENSSL)
-  bool Crypt(bool encrypt,  // Pass true to encrypt, false to decrypt.
-             const std::string& input,
-             std::string* output);
   std::string iv_;
+  // The encrypting context runs the bare block cipher in CTR mode.
+  ScopedOpenSSL<EVP_CIPHER_CTX, EVP_CIPHER_CTX_free> encrypt_context_;
+  ScopedOpenSSL<EVP_CIPHER_CTX, EVP_CIPHER_CTX_free> decrypt_context_;
 #elif defined(USE_NSS)
   ScopedPK11Slot slot_;
   ScopedSECItem param_;
+  // The encrypting context runs the bare block cipher in CTR mode.
+  ScopedPK11Context encrypt_context_;
+  ScopedPK11Context decrypt_context_;
 #elif defined(OS_MACOSX)
-  bool Crypt(int /*CCOperation*/ op,
-             const std::string& input,
-             std::string* output);
-
   std::string iv_;
+  // The encryptor runs the bare block cipher in CTR mode.
+  CCCryptorRef encryptor_;
+  CCCryptorRef decryptor_;
 #elif defined(OS_WIN)
+  // A copy of the key, which also holds the mode and the feedback register.
   ScopedHCRYPTKEY capi_key_;
   DWORD block_size_;
 #endif
+
+  DISALLOW_COPY_AND_ASSIGN(Encryptor);
 };
 
 }  // namespace crypto
@@ -7,22 +7,38 @@
 #include <CommonCrypto/CommonCryptor.h>
 
 #include "base/logging.h"
-#include "base/string_util.h"
 #include "crypto/symmetric_key.h"
 
 namespace crypto {
 
+namespace {
+
+void ReleaseCryptor(CCCryptorRef* cryptor) {
+  if (*cryptor) {
+    CCCryptorRelease(*cryptor);
+    *cryptor = NULL;
+  }
+}
+
+}  // namespace
+
 Encryptor::Encryptor()
     : key_(NULL),
-      mode_(CBC) {
+      mode_(CBC),
+      mask_offset_(0),
+      mask_length_(0),
+      encryptor_(NULL),
+      decryptor_(NULL) {
 }
 
 Encryptor::~Encryptor() {
+  ReleaseCryptor(&encryptor_);
+  ReleaseCryptor(&decryptor_);
 }
 
 bool Encryptor::Init(SymmetricKey* key, Mode mode, const std::string& iv) {
   DCHECK(key);
-  DCHECK_EQ(CBC, mode) << "Unsupported mode of operation";
+  DCHECK(mode == CBC || mode == CTR) << "Unsupported mode of operation";
   CSSM_DATA raw_key = key->cssm_data();
   if (raw_key.Length != kCCKeySizeAES128 &&
       raw_key.Length != kCCKeySizeAES192 &&
@@ -31,46 +47,76 @@ bool Encryptor::Init(SymmetricKey* key, Mode mode, const std::string& iv) {
   if (iv.size() != kCCBlockSizeAES128)
     return false;
 
+  // The cryptors are made once and reset to the IV for each message.  CTR
+  // mode is built on the bare block cipher.
+  ReleaseCryptor(&encryptor_);
+  ReleaseCryptor(&decryptor_);
+  const CCOptions options =
+      mode == CTR ? kCCOptionECBMode : kCCOptionPKCS7Padding;
+  CCCryptorStatus err = CCCryptorCreate(kCCEncrypt, kCCAlgorithmAES128,
+                                        options, raw_key.Data, raw_key.Length,
+                                        iv.data(), &encryptor_);
+  if (!err && mode == CBC) {
+    err = CCCryptorCreate(kCCDecrypt, kCCAlgorithmAES128, options,
+                          raw_key.Data, raw_key.Length, iv.data(),
+                          &decryptor_);
+  }
+  if (err) {
+    LOG(ERROR) << "CCCryptorCreate returned " << err;
+    ReleaseCryptor(&encryptor_);
+    return false;
+  }
+
   key_ = key;
   mode_ = mode;
   iv_ = iv;
+  if (mode == CTR)
+    SetCounter(iv);
   return true;
 }
 
-bool Encryptor::Crypt(int /*CCOperation*/ op,
-                      const std::string& input,
-                      std::string* output) {
-  DCHECK(key_);
-  CSSM_DATA raw_key = key_->cssm_data();
+bool Encryptor::CryptCBC(bool do_encrypt,
+                         const uint8* input, size_t input_length,
+                         uint8* output, size_t* output_length) {
+  CCCryptorRef cryptor = do_encrypt ? encryptor_ : decryptor_;
+  DCHECK(cryptor);  // Already handled in Init();
+
   // CommonCryptor.h: "A general rule for the size of the output buffer which
   // must be provided by the caller is that for block ciphers, the output
   // length is never larger than the input length plus the block size."
-
-  size_t output_size = input.size() + iv_.size();
-  CCCryptorStatus err = CCCrypt(op,
-                                kCCAlgorithmAES128,
-                                kCCOptionPKCS7Padding,
-                                raw_key.Data, raw_key.Length,
-                                iv_.data(),
-                                input.data(), input.size(),
-                                WriteInto(output, output_size+1),
-                                output_size,
-                                &output_size);
+  const size_t output_size =
+      do_encrypt ? MaxCiphertextLength(input_length) : input_length;
+  size_t update_length = 0;
+  size_t final_length = 0;
+  CCCryptorStatus err = CCCryptorReset(cryptor, iv_.data());
+  if (!err) {
+    err = CCCryptorUpdate(cryptor, input, input_length, output, output_size,
+                          &update_length);
+  }
+  if (!err) {
+    err = CCCryptorFinal(cryptor, output + update_length,
+                         output_size - update_length, &final_length);
+  }
   if (err) {
-    output->resize(0);
-    LOG(ERROR) << "CCCrypt returned " << err;
+    LOG(ERROR) << "CCCryptor returned " << err;
     return false;
   }
-  output->resize(output_size);
+  *output_length = update_length + final_length;
   return true;
 }
 
-bool Encryptor::Encrypt(const std::string& plaintext, std::string* ciphertext) {
-  return Crypt(kCCEncrypt, plaintext, ciphertext);
-}
-
-bool Encryptor::Decrypt(const std::string& ciphertext, std::string* plaintext) {
-  return Crypt(kCCDecrypt, ciphertext, plaintext);
+bool Encryptor::EncryptBlocks(const uint8* input, size_t length,
+                              uint8* output) {
+  DCHECK_EQ(0u, length % kCCBlockSizeAES128);
+  size_t moved = 0;
+  CCCryptorStatus err = CCCryptorUpdate(encryptor_, input, length, output,
+                                        length, &moved);
+  if (err) {
+    LOG(ERROR) << "CCCryptorUpdate returned " << err;
+    return false;
+  }
+  DCHECK_EQ(length, moved);
+  return true;
 }
 
 }  // namespace crypto
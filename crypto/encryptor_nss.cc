@@ -5,7 +5,6 @@
 #include "crypto/encryptor.h"
 
 #include <cryptohi.h>
-#include <vector>
 
 #include "base/logging.h"
 #include "crypto/nss_util.h"
@@ -15,7 +14,9 @@ namespace crypto {
 
 Encryptor::Encryptor()
     : key_(NULL),
-      mode_(CBC) {
+      mode_(CBC),
+      mask_offset_(0),
+      mask_length_(0) {
   EnsureNSSInit();
 }
 
@@ -24,15 +25,15 @@ Encryptor::~Encryptor() {
 
 bool Encryptor::Init(SymmetricKey* key, Mode mode, const std::string& iv) {
   DCHECK(key);
-  DCHECK_EQ(CBC, mode);
-
-  key_ = key;
-  mode_ = mode;
+  DCHECK(mode == CBC || mode == CTR);
 
   if (iv.size() != AES_BLOCK_SIZE)
     return false;
 
-  slot_.reset(PK11_GetBestSlot(CKM_AES_CBC_PAD, NULL));
+  // CTR mode is built on the bare block cipher.
+  const CK_MECHANISM_TYPE mechanism =
+      mode == CTR ? CKM_AES_ECB : CKM_AES_CBC_PAD;
+  slot_.reset(PK11_GetBestSlot(mechanism, NULL));
   if (!slot_.get())
     return false;
 
@@ -42,83 +43,80 @@ bool Encryptor::Init(SymmetricKey* key, Mode mode, const std::string& iv) {
       const_cast<char *>(iv.data()));
   iv_item.len = iv.size();
 
-  param_.reset(PK11_ParamFromIV(CKM_AES_CBC_PAD, &iv_item));
+  param_.reset(PK11_ParamFromIV(mechanism, mode == CTR ? NULL : &iv_item));
   if (!param_.get())
     return false;
 
+  // The contexts are reused for every message; the CBC ones go back to the
+  // IV when they are begun again.
+  encrypt_context_.reset(PK11_CreateContextBySymKey(mechanism, CKA_ENCRYPT,
+                                                   key->key(), param_.get()));
+  if (!encrypt_context_.get())
+    return false;
+  if (mode == CTR) {
+    decrypt_context_.reset(NULL);
+  } else {
+    decrypt_context_.reset(PK11_CreateContextBySymKey(
+        mechanism, CKA_DECRYPT, key->key(), param_.get()));
+    if (!decrypt_context_.get())
+      return false;
+  }
+
+  key_ = key;
+  mode_ = mode;
+  if (mode == CTR)
+    SetCounter(iv);
   return true;
 }
 
-bool Encryptor::Encrypt(const std::string& plaintext, std::string* ciphertext) {
-  ScopedPK11Context context(PK11_CreateContextBySymKey(CKM_AES_CBC_PAD,
-                                                       CKA_ENCRYPT,
-                                                       key_->key(),
-                                                       param_.get()));
-  if (!context.get())
-    return false;
+bool Encryptor::CryptCBC(bool do_encrypt,
+                         const uint8* input, size_t input_length,
+                         uint8* output, size_t* output_length) {
+  PK11Context* context =
+      do_encrypt ? encrypt_context_.get() : decrypt_context_.get();
+  DCHECK(context);  // Already handled in Init();
 
-  size_t ciphertext_len = plaintext.size() + AES_BLOCK_SIZE;
-  std::vector<unsigned char> buffer(ciphertext_len);
+  // Start a new message from the IV, dropping anything left from the last.
+  if (SECSuccess != PK11_DigestBegin(context))
+    return false;
 
+  const size_t output_size =
+      do_encrypt ? MaxCiphertextLength(input_length) : input_length;
   int op_len;
-  SECStatus rv = PK11_CipherOp(context.get(),
-                               &buffer[0],
+  SECStatus rv = PK11_CipherOp(context,
+                               output,
                                &op_len,
-                               ciphertext_len,
-                               reinterpret_cast<unsigned char*>(
-                                   const_cast<char*>(plaintext.data())),
-                               plaintext.size());
+                               output_size,
+                               const_cast<unsigned char*>(input),
+                               input_length);
   if (SECSuccess != rv)
     return false;
 
   unsigned int digest_len;
-  rv = PK11_DigestFinal(context.get(),
-                        &buffer[op_len],
+  rv = PK11_DigestFinal(context,
+                        output + op_len,
                         &digest_len,
-                        ciphertext_len - op_len);
+                        output_size - op_len);
   if (SECSuccess != rv)
     return false;
 
-  ciphertext->assign(reinterpret_cast<char *>(&buffer[0]),
-                     op_len + digest_len);
+  *output_length = op_len + digest_len;
   return true;
 }
 
-bool Encryptor::Decrypt(const std::string& ciphertext, std::string* plaintext) {
-  if (ciphertext.empty())
-    return false;
-
-  ScopedPK11Context context(PK11_CreateContextBySymKey(CKM_AES_CBC_PAD,
-                                                       CKA_DECRYPT,
-                                                       key_->key(),
-                                                       param_.get()));
-  if (!context.get())
-    return false;
-
-  size_t plaintext_len = ciphertext.size();
-  std::vector<unsigned char> buffer(plaintext_len);
-
+bool Encryptor::EncryptBlocks(const uint8* input, size_t length,
+                              uint8* output) {
+  DCHECK_EQ(0u, length % AES_BLOCK_SIZE);
   int op_len;
-  SECStatus rv = PK11_CipherOp(context.get(),
-                               &buffer[0],
+  SECStatus rv = PK11_CipherOp(encrypt_context_.get(),
+                               output,
                                &op_len,
-                               plaintext_len,
-                               reinterpret_cast<unsigned char*>(
-                                   const_cast<char*>(ciphertext.data())),
-                               ciphertext.size());
-  if (SECSuccess != rv)
-    return false;
-
-  unsigned int digest_len;
-  rv = PK11_DigestFinal(context.get(),
-                        &buffer[op_len],
-                        &digest_len,
-                        plaintext_len - op_len);
+                               length,
+                               const_cast<unsigned char*>(input),
+                               length);
   if (SECSuccess != rv)
     return false;
-
-  plaintext->assign(reinterpret_cast<char *>(&buffer[0]),
-                    op_len + digest_len);
+  DCHECK_EQ(length, static_cast<size_t>(op_len));
   return true;
 }
 
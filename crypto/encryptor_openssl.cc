@@ -8,7 +8,6 @@
 #include <openssl/evp.h>
 
 #include "base/logging.h"
-#include "base/string_util.h"
 #include "crypto/openssl_util.h"
 #include "crypto/symmetric_key.h"
 
@@ -16,37 +15,24 @@ namespace crypto {
 
 namespace {
 
-const EVP_CIPHER* GetCipherForKey(SymmetricKey* key) {
+const EVP_CIPHER* GetCipherForKey(SymmetricKey* key, Encryptor::Mode mode) {
+  // CTR mode is built on the bare block cipher.
+  const bool cbc = mode == Encryptor::CBC;
   switch (key->key().length()) {
-    case 16: return EVP_aes_128_cbc();
-    case 24: return EVP_aes_192_cbc();
-    case 32: return EVP_aes_256_cbc();
+    case 16: return cbc ? EVP_aes_128_cbc() : EVP_aes_128_ecb();
+    case 24: return cbc ? EVP_aes_192_cbc() : EVP_aes_192_ecb();
+    case 32: return cbc ? EVP_aes_256_cbc() : EVP_aes_256_ecb();
     default: return NULL;
   }
 }
 
-// On destruction this class will cleanup the ctx, and also clear the OpenSSL
-// ERR stack as a convenience.
-class ScopedCipherCTX {
- public:
-  explicit ScopedCipherCTX() {
-    EVP_CIPHER_CTX_init(&ctx_);
-  }
-  ~ScopedCipherCTX() {
-    EVP_CIPHER_CTX_cleanup(&ctx_);
-    ClearOpenSSLERRStack(FROM_HERE);
-  }
-  EVP_CIPHER_CTX* get() { return &ctx_; }
-
- private:
-  EVP_CIPHER_CTX ctx_;
-};
-
 }  // namespace
 
 Encryptor::Encryptor()
     : key_(NULL),
-      mode_(CBC) {
+      mode_(CBC),
+      mask_offset_(0),
+      mask_length_(0) {
 }
 
 Encryptor::~Encryptor() {
@@ -54,73 +40,89 @@ Encryptor::~Encryptor() {
 
 bool Encryptor::Init(SymmetricKey* key, Mode mode, const std::string& iv) {
   DCHECK(key);
-  DCHECK_EQ(CBC, mode);
+  DCHECK(mode == CBC || mode == CTR);
 
-  EnsureOpenSSLInit();
+  OpenSSLErrStackTracer err_tracer(FROM_HERE);
   if (iv.size() != AES_BLOCK_SIZE)
     return false;
 
-  if (GetCipherForKey(key) == NULL)
+  const EVP_CIPHER* cipher = GetCipherForKey(key, mode);
+  if (cipher == NULL)
     return false;
 
+  // Setting the key up is the costly part, so it is done once here for each
+  // direction, and each message only sets the IV again.
+  const uint8* raw_key = reinterpret_cast<const uint8*>(key->key().data());
+  const uint8* raw_iv = reinterpret_cast<const uint8*>(iv.data());
+  encrypt_context_.reset(EVP_CIPHER_CTX_new());
+  if (!encrypt_context_.get() ||
+      !EVP_EncryptInit_ex(encrypt_context_.get(), cipher, NULL, raw_key,
+                          raw_iv)) {
+    return false;
+  }
+  if (mode == CTR) {
+    EVP_CIPHER_CTX_set_padding(encrypt_context_.get(), 0);
+    decrypt_context_.reset(NULL);
+  } else {
+    decrypt_context_.reset(EVP_CIPHER_CTX_new());
+    if (!decrypt_context_.get() ||
+        !EVP_DecryptInit_ex(decrypt_context_.get(), cipher, NULL, raw_key,
+                            raw_iv)) {
+      return false;
+    }
+  }
+
   key_ = key;
   mode_ = mode;
   iv_ = iv;
+  if (mode == CTR)
+    SetCounter(iv);
   return true;
 }
 
-bool Encryptor::Encrypt(const std::string& plaintext, std::string* ciphertext) {
-  return Crypt(true, plaintext, ciphertext);
-}
+bool Encryptor::CryptCBC(bool do_encrypt,
+                         const uint8* input, size_t input_length,
+                         uint8* output, size_t* output_length) {
+  OpenSSLErrStackTracer err_tracer(FROM_HERE);
+  if (input_length > static_cast<size_t>(kint32max) - AES_BLOCK_SIZE)
+    return false;
 
-bool Encryptor::Decrypt(const std::string& ciphertext, std::string* plaintext) {
-  return Crypt(false, ciphertext, plaintext);
-}
+  EVP_CIPHER_CTX* context =
+      do_encrypt ? encrypt_context_.get() : decrypt_context_.get();
+  DCHECK(context);  // Already handled in Init();
 
-bool Encryptor::Crypt(bool do_encrypt,
-                      const std::string& input,
-                      std::string* output) {
-  DCHECK(key_);  // Must call Init() before En/De-crypt.
-  // Work on the result in a local variable, and then only transfer it to
-  // |output| on success to ensure no partial data is returned.
-  std::string result;
-  output->swap(result);
-
-  const EVP_CIPHER* cipher = GetCipherForKey(key_);
-  DCHECK(cipher);  // Already handled in Init();
-
-  const std::string& key = key_->key();
-  DCHECK_EQ(EVP_CIPHER_iv_length(cipher), static_cast<int>(iv_.length()));
-  DCHECK_EQ(EVP_CIPHER_key_length(cipher), static_cast<int>(key.length()));
-
-  ScopedCipherCTX ctx;
-  if (!EVP_CipherInit_ex(ctx.get(), cipher, NULL,
-                         reinterpret_cast<const uint8*>(key.data()),
-                         reinterpret_cast<const uint8*>(iv_.data()),
-                         do_encrypt))
+  // Start a new message from the IV, keeping the key schedule.
+  if (!EVP_CipherInit_ex(context, NULL, NULL, NULL,
+                         reinterpret_cast<const uint8*>(iv_.data()), -1)) {
     return false;
+  }
 
-  // When encrypting, add another block size of space to allow for any padding.
-  const size_t output_size = input.size() + (do_encrypt ? iv_.size() : 0);
-  uint8* out_ptr = reinterpret_cast<uint8*>(WriteInto(&result,
-                                                      output_size + 1));
   int out_len;
-  if (!EVP_CipherUpdate(ctx.get(), out_ptr, &out_len,
-                        reinterpret_cast<const uint8*>(input.data()),
-                        input.length()))
+  if (!EVP_CipherUpdate(context, output, &out_len, input, input_length))
     return false;
 
   // Write out the final block plus padding (if any) to the end of the data
   // just written.
   int tail_len;
-  if (!EVP_CipherFinal_ex(ctx.get(), out_ptr + out_len, &tail_len))
+  if (!EVP_CipherFinal_ex(context, output + out_len, &tail_len))
     return false;
 
-  out_len += tail_len;
-  DCHECK_LE(out_len, static_cast<int>(output_size));
-  result.resize(out_len);
+  *output_length = out_len + tail_len;
+  DCHECK_LE(*output_length, do_encrypt ? MaxCiphertextLength(input_length) :
+                                         input_length);
+  return true;
+}
 
-  output->swap(result);
+bool Encryptor::EncryptBlocks(const uint8* input, size_t length,
+                              uint8* output) {
+  OpenSSLErrStackTracer err_tracer(FROM_HERE);
+  DCHECK_EQ(0u, length % AES_BLOCK_SIZE);
+  int out_len;
+  if (!EVP_EncryptUpdate(encrypt_context_.get(), output, &out_len, input,
+                         length)) {
+    return false;
+  }
+  DCHECK_EQ(length, static_cast<size_t>(out_len));
   return true;
 }
 
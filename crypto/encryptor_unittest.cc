@@ -4,8 +4,11 @@
 
 #include "crypto/encryptor.h"
 
+#include <string.h>
+
 #include <string>
 
+#include "base/basictypes.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/string_number_conversions.h"
 #include "crypto/symmetric_key.h"
@@ -231,3 +234,162 @@ TEST(EncryptorTest, EmptyDecrypt) {
   EXPECT_FALSE(encryptor.Decrypt("", &decrypted));
   EXPECT_EQ("", decrypted);
 }
+
+// Check that one encryptor gives the same answers message after message, in
+// place or not.
+TEST(EncryptorTest, ReuseWithBuffers) {
+  std::string key = "128=SixteenBytes";
+  std::string iv = "Sweet Sixteen IV";
+  std::string plaintext = "Plain text with a g-clef U+1D11E \360\235\204\236";
+
+  scoped_ptr<crypto::SymmetricKey> sym_key(crypto::SymmetricKey::Import(
+      crypto::SymmetricKey::AES, key));
+  ASSERT_TRUE(NULL != sym_key.get());
+
+  crypto::Encryptor encryptor;
+  EXPECT_TRUE(encryptor.Init(sym_key.get(), crypto::Encryptor::CBC, iv));
+  EXPECT_EQ(48U, encryptor.MaxCiphertextLength(plaintext.size()));
+  EXPECT_EQ(16U, encryptor.MaxCiphertextLength(0));
+  EXPECT_EQ(32U, encryptor.MaxCiphertextLength(16));
+
+  std::string expected_ciphertext;
+  EXPECT_TRUE(encryptor.Encrypt(plaintext, &expected_ciphertext));
+
+  for (int i = 0; i < 3; ++i) {
+    uint8 buffer[48];
+    memcpy(buffer, plaintext.data(), plaintext.size());
+    size_t length;
+    // Encrypted in place.
+    EXPECT_TRUE(encryptor.Encrypt(buffer, plaintext.size(), buffer, &length));
+    EXPECT_EQ(expected_ciphertext,
+              std::string(reinterpret_cast<char*>(buffer), length));
+
+    uint8 decrypted[48];
+    EXPECT_TRUE(encryptor.Decrypt(buffer, length, decrypted, &length));
+    EXPECT_EQ(plaintext,
+              std::string(reinterpret_cast<char*>(decrypted), length));
+  }
+
+  // A corrupt message fails, and doesn't stop the next one working.
+  std::string decrypted;
+  EXPECT_FALSE(encryptor.Decrypt(expected_ciphertext.substr(1), &decrypted));
+  EXPECT_TRUE(encryptor.Decrypt(expected_ciphertext, &decrypted));
+  EXPECT_EQ(plaintext, decrypted);
+}
+
+// NIST SP 800-38A test vector F.5.1 CTR-AES128.Encrypt.
+TEST(EncryptorTest, EncryptAES128CTR) {
+  static const unsigned char raw_key[] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+  };
+  static const unsigned char raw_counter[] = {
+    0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+    0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
+  };
+  static const unsigned char raw_plaintext[] = {
+    // Block #1
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+    0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    // Block #2
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+    0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    // Block #3
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11,
+    0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    // Block #4
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17,
+    0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10,
+  };
+  static const unsigned char raw_ciphertext[] = {
+    // Block #1
+    0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26,
+    0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+    // Block #2
+    0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff,
+    0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+    // Block #3
+    0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e,
+    0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+    // Block #4
+    0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1,
+    0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee,
+  };
+
+  std::string key(reinterpret_cast<const char*>(raw_key), sizeof(raw_key));
+  scoped_ptr<crypto::SymmetricKey> sym_key(crypto::SymmetricKey::Import(
+      crypto::SymmetricKey::AES, key));
+  ASSERT_TRUE(NULL != sym_key.get());
+
+  std::string counter(reinterpret_cast<const char*>(raw_counter),
+                      sizeof(raw_counter));
+  crypto::Encryptor encryptor;
+  EXPECT_TRUE(encryptor.Init(sym_key.get(), crypto::Encryptor::CTR, counter));
+  EXPECT_EQ(sizeof(raw_plaintext),
+            encryptor.MaxCiphertextLength(sizeof(raw_plaintext)));
+
+  std::string plaintext(reinterpret_cast<const char*>(raw_plaintext),
+                        sizeof(raw_plaintext));
+  std::string ciphertext;
+  EXPECT_TRUE(encryptor.Encrypt(plaintext, &ciphertext));
+  EXPECT_EQ(sizeof(raw_ciphertext), ciphertext.size());
+  EXPECT_EQ(0, memcmp(ciphertext.data(), raw_ciphertext, ciphertext.size()));
+
+  // The same again, in pieces that don't line up with the blocks.
+  EXPECT_TRUE(encryptor.SetCounter(counter));
+  uint8 buffer[sizeof(raw_plaintext)];
+  memcpy(buffer, raw_plaintext, sizeof(buffer));
+  const size_t kPieces[] = { 1, 20, 0, 15, 28 };
+  size_t offset = 0;
+  for (size_t i = 0; i < arraysize(kPieces); ++i) {
+    size_t length;
+    EXPECT_TRUE(encryptor.Encrypt(buffer + offset, kPieces[i],
+                                  buffer + offset, &length));
+    EXPECT_EQ(kPieces[i], length);
+    offset += length;
+  }
+  EXPECT_EQ(sizeof(buffer), offset);
+  EXPECT_EQ(0, memcmp(buffer, raw_ciphertext, sizeof(buffer)));
+
+  EXPECT_TRUE(encryptor.SetCounter(counter));
+  std::string decrypted;
+  EXPECT_TRUE(encryptor.Decrypt(ciphertext, &decrypted));
+  EXPECT_EQ(plaintext, decrypted);
+
+  EXPECT_FALSE(encryptor.SetCounter("too short"));
+}
+
+// Check that the counter carries from one byte into the next, over more than
+// one batch of key stream.
+TEST(EncryptorTest, CTRCounterCarries) {
+  std::string key = "128=SixteenBytes";
+  scoped_ptr<crypto::SymmetricKey> sym_key(crypto::SymmetricKey::Import(
+      crypto::SymmetricKey::AES, key));
+  ASSERT_TRUE(NULL != sym_key.get());
+
+  std::string counter(15, '\x00');
+  counter.push_back('\xfe');
+  crypto::Encryptor encryptor;
+  EXPECT_TRUE(encryptor.Init(sym_key.get(), crypto::Encryptor::CTR, counter));
+  std::string zeros(2000, '\x00');
+  std::string key_stream;
+  EXPECT_TRUE(encryptor.Encrypt(zeros, &key_stream));
+  ASSERT_EQ(zeros.size(), key_stream.size());
+
+  // The third block is the key stream for the counter 0x100.
+  std::string carried(14, '\x00');
+  carried.push_back('\x01');
+  carried.push_back('\x00');
+  EXPECT_TRUE(encryptor.SetCounter(carried));
+  std::string block;
+  EXPECT_TRUE(encryptor.Encrypt(zeros.substr(0, 16), &block));
+  EXPECT_EQ(block, key_stream.substr(32, 16));
+
+  // Counter blocks past the first batch carry on from it.
+  std::string later(14, '\x00');
+  later.push_back('\x01');
+  later.push_back('\x62');
+  EXPECT_TRUE(encryptor.SetCounter(later));
+  EXPECT_TRUE(encryptor.Encrypt(zeros.substr(0, 16), &block));
+  EXPECT_EQ(block, key_stream.substr(16 * 100, 16));
+}
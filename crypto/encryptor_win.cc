@@ -4,8 +4,9 @@
 
 #include "crypto/encryptor.h"
 
-#include <vector>
+#include <string.h>
 
+#include "base/logging.h"
 #include "crypto/symmetric_key.h"
 
 namespace crypto {
@@ -31,6 +32,8 @@ DWORD GetCipherBlockSize(HCRYPTKEY key) {
 Encryptor::Encryptor()
     : key_(NULL),
       mode_(CBC),
+      mask_offset_(0),
+      mask_length_(0),
       block_size_(0) {
 }
 
@@ -39,7 +42,7 @@ Encryptor::~Encryptor() {
 
 bool Encryptor::Init(SymmetricKey* key, Mode mode, const std::string& iv) {
   DCHECK(key);
-  DCHECK_EQ(CBC, mode) << "Unsupported mode of operation";
+  DCHECK(mode == CBC || mode == CTR) << "Unsupported mode of operation";
 
   // In CryptoAPI, the IV, padding mode, and feedback register (for a chaining
   // mode) are properties of a key, so we have to create a copy of the key for
@@ -49,8 +52,9 @@ bool Encryptor::Init(SymmetricKey* key, Mode mode, const std::string& iv) {
     return false;
 
   // CRYPT_MODE_CBC is the default for Microsoft Base Cryptographic Provider,
-  // but we set it anyway to be safe.
-  DWORD cipher_mode = CRYPT_MODE_CBC;
+  // but we set it anyway to be safe.  CTR mode is built on the bare block
+  // cipher.
+  DWORD cipher_mode = mode == CTR ? CRYPT_MODE_ECB : CRYPT_MODE_CBC;
   ok = CryptSetKeyParam(capi_key_.get(), KP_MODE,
                         reinterpret_cast<BYTE*>(&cipher_mode), 0);
   if (!ok)
@@ -63,52 +67,68 @@ bool Encryptor::Init(SymmetricKey* key, Mode mode, const std::string& iv) {
   if (iv.size() != block_size_)
     return false;
 
-  ok = CryptSetKeyParam(capi_key_.get(), KP_IV,
-                        reinterpret_cast<const BYTE*>(iv.data()), 0);
-  if (!ok)
-    return false;
-
-  DWORD padding_method = PKCS5_PADDING;
-  ok = CryptSetKeyParam(capi_key_.get(), KP_PADDING,
-                        reinterpret_cast<BYTE*>(&padding_method), 0);
-  if (!ok)
-    return false;
-
+  if (mode == CBC) {
+    ok = CryptSetKeyParam(capi_key_.get(), KP_IV,
+                          reinterpret_cast<const BYTE*>(iv.data()), 0);
+    if (!ok)
+      return false;
+
+    DWORD padding_method = PKCS5_PADDING;
+    ok = CryptSetKeyParam(capi_key_.get(), KP_PADDING,
+                          reinterpret_cast<BYTE*>(&padding_method), 0);
+    if (!ok)
+      return false;
+  }
+
+  key_ = key;
+  mode_ = mode;
+  if (mode == CTR)
+    SetCounter(iv);
   return true;
 }
 
-bool Encryptor::Encrypt(const std::string& plaintext, std::string* ciphertext) {
-  DWORD data_len = plaintext.size();
-  DWORD total_len = data_len + block_size_;
-
-  // CryptoAPI encrypts/decrypts in place.
-  std::vector<BYTE> tmp(total_len);
-  memcpy(&tmp[0], plaintext.data(), data_len);
+bool Encryptor::CryptCBC(bool do_encrypt,
+                         const uint8* input, size_t input_length,
+                         uint8* output, size_t* output_length) {
+  const size_t output_size =
+      do_encrypt ? MaxCiphertextLength(input_length) : input_length;
+  if (output_size > kuint32max)
+    return false;
 
-  BOOL ok = CryptEncrypt(capi_key_.get(), NULL, TRUE, 0, &tmp[0],
-                         &data_len, total_len);
+  // CryptoAPI encrypts/decrypts in place.  A final call leaves the key ready
+  // to start the next message from the IV.
+  if (output != input)
+    memmove(output, input, input_length);
+  DWORD data_len = input_length;
+  BOOL ok;
+  if (do_encrypt) {
+    ok = CryptEncrypt(capi_key_.get(), NULL, TRUE, 0, output, &data_len,
+                      output_size);
+  } else {
+    ok = CryptDecrypt(capi_key_.get(), NULL, TRUE, 0, output, &data_len);
+  }
   if (!ok)
     return false;
 
-  ciphertext->assign(reinterpret_cast<char*>(&tmp[0]), data_len);
+  *output_length = data_len;
   return true;
 }
 
-bool Encryptor::Decrypt(const std::string& ciphertext, std::string* plaintext) {
-  DWORD data_len = ciphertext.size();
-  if (data_len == 0)
+bool Encryptor::EncryptBlocks(const uint8* input, size_t length,
+                              uint8* output) {
+  DCHECK_EQ(0u, length % block_size_);
+  if (length > kuint32max)
     return false;
 
-  std::vector<BYTE> tmp(data_len);
-  memcpy(&tmp[0], ciphertext.data(), data_len);
-
-  BOOL ok = CryptDecrypt(capi_key_.get(), NULL, TRUE, 0, &tmp[0], &data_len);
+  // A call that isn't final adds no padding.
+  if (output != input)
+    memmove(output, input, length);
+  DWORD data_len = length;
+  BOOL ok = CryptEncrypt(capi_key_.get(), NULL, FALSE, 0, output, &data_len,
+                         length);
   if (!ok)
     return false;
-
-  DCHECK_GT(tmp.size(), data_len);
-
-  plaintext->assign(reinterpret_cast<char*>(&tmp[0]), data_len);
+  DCHECK_EQ(length, data_len);
   return true;
 }
 
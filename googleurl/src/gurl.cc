@@ -105,26 +105,67 @@ const std::string& EmptyStringForGURL() {
 
 } // namespace
 
-GURL::GURL() : is_valid_(false) {
+GURL::SharedSpec::SharedSpec() : ref_count_(1) {
+}
+
+GURL::SharedSpec::SharedSpec(const std::string& text)
+    : spec(text),
+      ref_count_(1) {
+}
+
+GURL::SharedSpec::~SharedSpec() {
+}
+
+#ifdef WIN32
+
+void GURL::SharedSpec::AddRef() {
+  InterlockedIncrement(&ref_count_);
+}
+
+void GURL::SharedSpec::Release() {
+  if (InterlockedDecrement(&ref_count_) == 0)
+    delete this;
+}
+
+#else
+
+void GURL::SharedSpec::AddRef() {
+  __sync_fetch_and_add(&ref_count_, 1);
+}
+
+void GURL::SharedSpec::Release() {
+  if (__sync_sub_and_fetch(&ref_count_, 1) == 0)
+    delete this;
+}
+
+#endif  // WIN32
+
+bool GURL::SharedSpec::HasOneRef() const {
+  return ref_count_ == 1;
+}
+
+GURL::GURL() : spec_(NULL), is_valid_(false) {
 }
 
 GURL::GURL(const GURL& other)
     : spec_(other.spec_),
       is_valid_(other.is_valid_),
       parsed_(other.parsed_) {
+  if (spec_)
+    spec_->AddRef();
 }
 
-GURL::GURL(const std::string& url_string) {
-  is_valid_ = InitCanonical(url_string, &spec_, &parsed_);
+GURL::GURL(const std::string& url_string) : spec_(NULL) {
+  is_valid_ = InitCanonical(url_string, MutableSpec(), &parsed_);
 }
 
-GURL::GURL(const string16& url_string) {
-  is_valid_ = InitCanonical(url_string, &spec_, &parsed_);
+GURL::GURL(const string16& url_string) : spec_(NULL) {
+  is_valid_ = InitCanonical(url_string, MutableSpec(), &parsed_);
 }
 
 GURL::GURL(const char* canonical_spec, size_t canonical_spec_len,
            const url_parse::Parsed& parsed, bool is_valid)
-    : spec_(canonical_spec, canonical_spec_len),
+    : spec_(new SharedSpec(std::string(canonical_spec, canonical_spec_len))),
       is_valid_(is_valid),
       parsed_(parsed) {
 #ifndef NDEBUG
@@ -132,10 +173,10 @@ GURL::GURL(const char* canonical_spec, size_t canonical_spec_len,
   // what we would have produced. Skip checking for invalid URLs have no meaning
   // and we can't always canonicalize then reproducabely.
   if (is_valid_) {
-    GURL test_url(spec_);
+    GURL test_url(raw_spec());
 
     DCHECK(test_url.is_valid_ == is_valid_);
-    DCHECK(test_url.spec_ == spec_);
+    DCHECK(test_url.raw_spec() == raw_spec());
 
     DCHECK(test_url.parsed_.scheme == parsed_.scheme);
     DCHECK(test_url.parsed_.username == parsed_.username);
@@ -149,7 +190,17 @@ GURL::GURL(const char* canonical_spec, size_t canonical_spec_len,
 #endif
 }
 
+GURL::~GURL() {
+  if (spec_)
+    spec_->Release();
+}
+
 GURL& GURL::operator=(const GURL& other) {
+  // Take the new reference first, in case this is a self-assignment.
+  if (other.spec_)
+    other.spec_->AddRef();
+  if (spec_)
+    spec_->Release();
   spec_ = other.spec_;
   is_valid_ = other.is_valid_;
   parsed_ = other.parsed_;
@@ -157,8 +208,8 @@ GURL& GURL::operator=(const GURL& other) {
 }
 
 const std::string& GURL::spec() const {
-  if (is_valid_ || spec_.empty())
-    return spec_;
+  if (is_valid_ || raw_spec().empty())
+    return raw_spec();
 
   DCHECK(false) << "Trying to get the spec of an invalid URL!";
   return EmptyStringForGURL();
@@ -183,11 +234,12 @@ GURL GURL::ResolveWithCharsetConverter(
 
   // Reserve enough room in the output for the input, plus some extra so that
   // we have room if we have to escape a few things without reallocating.
-  result.spec_.reserve(spec_.size() + 32);
-  url_canon::StdStringCanonOutput output(&result.spec_);
+  std::string* result_spec = result.MutableSpec();
+  result_spec->reserve(raw_spec().size() + 32);
+  url_canon::StdStringCanonOutput output(result_spec);
 
   if (!url_util::ResolveRelative(
-          spec_.data(), static_cast<int>(spec_.length()), parsed_,
+          raw_spec().data(), static_cast<int>(raw_spec().length()), parsed_,
           relative.data(), static_cast<int>(relative.length()),
           charset_converter, &output, &result.parsed_)) {
     // Error resolving, return an empty URL.
@@ -211,11 +263,12 @@ GURL GURL::ResolveWithCharsetConverter(
 
   // Reserve enough room in the output for the input, plus some extra so that
   // we have room if we have to escape a few things without reallocating.
-  result.spec_.reserve(spec_.size() + 32);
-  url_canon::StdStringCanonOutput output(&result.spec_);
+  std::string* result_spec = result.MutableSpec();
+  result_spec->reserve(raw_spec().size() + 32);
+  url_canon::StdStringCanonOutput output(result_spec);
 
   if (!url_util::ResolveRelative(
-          spec_.data(), static_cast<int>(spec_.length()), parsed_,
+          raw_spec().data(), static_cast<int>(raw_spec().length()), parsed_,
           relative.data(), static_cast<int>(relative.length()),
           charset_converter, &output, &result.parsed_)) {
     // Error resolving, return an empty URL.
@@ -238,12 +291,13 @@ GURL GURL::ReplaceComponents(
 
   // Reserve enough room in the output for the input, plus some extra so that
   // we have room if we have to escape a few things without reallocating.
-  result.spec_.reserve(spec_.size() + 32);
-  url_canon::StdStringCanonOutput output(&result.spec_);
+  std::string* result_spec = result.MutableSpec();
+  result_spec->reserve(raw_spec().size() + 32);
+  url_canon::StdStringCanonOutput output(result_spec);
 
   result.is_valid_ = url_util::ReplaceComponents(
-      spec_.data(), static_cast<int>(spec_.length()), parsed_, replacements,
-      NULL, &output, &result.parsed_);
+      raw_spec().data(), static_cast<int>(raw_spec().length()), parsed_,
+      replacements, NULL, &output, &result.parsed_);
 
   output.Complete();
   return result;
@@ -260,12 +314,13 @@ GURL GURL::ReplaceComponents(
 
   // Reserve enough room in the output for the input, plus some extra so that
   // we have room if we have to escape a few things without reallocating.
-  result.spec_.reserve(spec_.size() + 32);
-  url_canon::StdStringCanonOutput output(&result.spec_);
+  std::string* result_spec = result.MutableSpec();
+  result_spec->reserve(raw_spec().size() + 32);
+  url_canon::StdStringCanonOutput output(result_spec);
 
   result.is_valid_ = url_util::ReplaceComponents(
-      spec_.data(), static_cast<int>(spec_.length()), parsed_, replacements,
-      NULL, &output, &result.parsed_);
+      raw_spec().data(), static_cast<int>(raw_spec().length()), parsed_,
+      replacements, NULL, &output, &result.parsed_);
 
   output.Complete();
   return result;
@@ -304,42 +359,46 @@ GURL GURL::GetWithEmptyPath() const {
   other.parsed_.ref.reset();
 
   // Set the path, since the path is longer than one, we can just set the
-  // first character and resize.
-  other.spec_[other.parsed_.path.begin] = '/';
+  // first character and resize. The copy shares our spec, so this gives it a
+  // spec of its own.
+  std::string* other_spec = other.MutableSpec();
+  (*other_spec)[other.parsed_.path.begin] = '/';
   other.parsed_.path.len = 1;
-  other.spec_.resize(other.parsed_.path.begin + 1);
+  other_spec->resize(other.parsed_.path.begin + 1);
   return other;
 }
 
 bool GURL::IsStandard() const {
-  return url_util::IsStandard(spec_.data(), parsed_.scheme);
+  return url_util::IsStandard(raw_spec().data(), parsed_.scheme);
 }
 
 bool GURL::SchemeIs(const char* lower_ascii_scheme) const {
   if (parsed_.scheme.len <= 0)
     return lower_ascii_scheme == NULL;
-  return url_util::LowerCaseEqualsASCII(spec_.data() + parsed_.scheme.begin,
-                                        spec_.data() + parsed_.scheme.end(),
+  const char* spec = raw_spec().data();
+  return url_util::LowerCaseEqualsASCII(spec + parsed_.scheme.begin,
+                                        spec + parsed_.scheme.end(),
                                         lower_ascii_scheme);
 }
 
 int GURL::IntPort() const {
   if (parsed_.port.is_nonempty())
-    return url_parse::ParsePort(spec_.data(), parsed_.port);
+    return url_parse::ParsePort(raw_spec().data(), parsed_.port);
   return url_parse::PORT_UNSPECIFIED;
 }
 
 int GURL::EffectiveIntPort() const {
   int int_port = IntPort();
   if (int_port == url_parse::PORT_UNSPECIFIED && IsStandard())
-    return url_canon::DefaultPortForScheme(spec_.data() + parsed_.scheme.begin,
-                                           parsed_.scheme.len);
+    return url_canon::DefaultPortForScheme(
+        raw_spec().data() + parsed_.scheme.begin, parsed_.scheme.len);
   return int_port;
 }
 
 std::string GURL::ExtractFileName() const {
   url_parse::Component file_component;
-  url_parse::ExtractFileName(spec_.data(), parsed_.path, &file_component);
+  url_parse::ExtractFileName(raw_spec().data(), parsed_.path,
+                             &file_component);
   return ComponentString(file_component);
 }
 
@@ -348,18 +407,19 @@ std::string GURL::PathForRequest() const {
   if (parsed_.ref.len >= 0) {
     // Clip off the reference when it exists. The reference starts after the #
     // sign, so we have to subtract one to also remove it.
-    return std::string(spec_, parsed_.path.begin,
+    return std::string(raw_spec(), parsed_.path.begin,
                        parsed_.ref.begin - parsed_.path.begin - 1);
   }
 
   // Use everything form the path to the end.
-  return std::string(spec_, parsed_.path.begin);
+  return std::string(raw_spec(), parsed_.path.begin);
 }
 
 std::string GURL::HostNoBrackets() const {
   // If host looks like an IPv6 literal, strip the square brackets.
   url_parse::Component h(parsed_.host);
-  if (h.len >= 2 && spec_[h.begin] == '[' && spec_[h.end() - 1] == ']') {
+  const std::string& spec = raw_spec();
+  if (h.len >= 2 && spec[h.begin] == '[' && spec[h.end() - 1] == ']') {
     h.begin++;
     h.len -= 2;
   }
@@ -367,12 +427,12 @@ std::string GURL::HostNoBrackets() const {
 }
 
 bool GURL::HostIsIPAddress() const {
-  if (!is_valid_ || spec_.empty())
+  if (!is_valid_ || raw_spec().empty())
      return false;
 
   url_canon::RawCanonOutputT<char, 128> ignored_output;
   url_canon::CanonHostInfo host_info;
-  url_canon::CanonicalizeIPAddress(spec_.c_str(), parsed_.host,
+  url_canon::CanonicalizeIPAddress(raw_spec().c_str(), parsed_.host,
                                    &ignored_output, &host_info);
   return host_info.IsIPAddress();
 }
@@ -418,7 +478,7 @@ bool GURL::DomainIs(const char* lower_ascii_domain,
   // Check whether the host name is end with a dot. If yes, treat it
   // the same as no-dot unless the input comparison domain is end
   // with dot.
-  const char* last_pos = spec_.data() + parsed_.host.end() - 1;
+  const char* last_pos = raw_spec().data() + parsed_.host.end() - 1;
   int host_len = parsed_.host.len;
   if ('.' == *last_pos && '.' != lower_ascii_domain[domain_len - 1]) {
     last_pos--;
@@ -430,7 +490,7 @@ bool GURL::DomainIs(const char* lower_ascii_domain,
     return false;
 
   // Compare this url whether belong specific domain.
-  const char* start_pos = spec_.data() + parsed_.host.begin +
+  const char* start_pos = raw_spec().data() + parsed_.host.begin +
                           host_len - domain_len;
 
   if (!url_util::LowerCaseEqualsASCII(start_pos,
@@ -450,11 +510,27 @@ bool GURL::DomainIs(const char* lower_ascii_domain,
 }
 
 void GURL::Swap(GURL* other) {
-  spec_.swap(other->spec_);
+  std::swap(spec_, other->spec_);
   std::swap(is_valid_, other->is_valid_);
   std::swap(parsed_, other->parsed_);
 }
 
+// static
+const std::string& GURL::EmptySpec() {
+  return EmptyStringForGURL();
+}
+
+std::string* GURL::MutableSpec() {
+  if (!spec_) {
+    spec_ = new SharedSpec;
+  } else if (!spec_->HasOneRef()) {
+    SharedSpec* copy = new SharedSpec(spec_->spec);
+    spec_->Release();
+    spec_ = copy;
+  }
+  return &spec_->spec;
+}
+
 std::ostream& operator<<(std::ostream& out, const GURL& url) {
   return out << url.possibly_invalid_spec();
 }
@@ -47,8 +47,8 @@ class GURL {
   // Creates an empty, invalid URL.
   GURL_API GURL();
 
-  // Copy construction is relatively inexpensive, with most of the time going
-  // to reallocating the string. It does not re-parse.
+  // Copy construction is inexpensive: the copy shares the spec with |other|,
+  // so this only bumps a reference count. It does not re-parse.
   GURL_API GURL(const GURL& other);
 
   // The narrow version requires the input be UTF-8. Invalid UTF-8 input will
@@ -69,6 +69,8 @@ class GURL {
   GURL_API GURL(const char* canonical_spec, size_t canonical_spec_len,
                 const url_parse::Parsed& parsed, bool is_valid);
 
+  GURL_API ~GURL();
+
   GURL_API GURL& operator=(const GURL& other);
 
   // Returns true when this object represents a valid parsed URL. When not
@@ -84,7 +86,7 @@ class GURL {
   // invalid, and is_valid() will return false for them. This is provided
   // because some users may want to treat the empty case differently.
   bool is_empty() const {
-    return spec_.empty();
+    return raw_spec().empty();
   }
 
   // Returns the raw spec, i.e., the full text of the URL, in canonical UTF-8,
@@ -110,7 +112,7 @@ class GURL {
   //
   // The returned string is guaranteed to be valid UTF-8.
   const std::string& possibly_invalid_spec() const {
-    return spec_;
+    return raw_spec();
   }
 
   // Getter for the raw parsed structure. This allows callers to locate parts
@@ -127,15 +129,15 @@ class GURL {
 
   // Defiant equality operator!
   bool operator==(const GURL& other) const {
-    return spec_ == other.spec_;
+    return spec_ == other.spec_ || raw_spec() == other.raw_spec();
   }
   bool operator!=(const GURL& other) const {
-    return spec_ != other.spec_;
+    return !(*this == other);
   }
 
   // Allows GURL to used as a key in STL (for example, a std::set or std::map).
   bool operator<(const GURL& other) const {
-    return spec_ < other.spec_;
+    return raw_spec() < other.raw_spec();
   }
 
   // Resolves a URL that's possibly relative to this object's URL, and returns
@@ -348,15 +350,48 @@ class GURL {
   GURL_API static const GURL& EmptyGURL();
 
  private:
+  // The text of a spec, which a GURL shares with its copies so that copying
+  // doesn't allocate. The text is never changed while it is shared; see
+  // MutableSpec().
+  class SharedSpec {
+   public:
+    SharedSpec();
+    explicit SharedSpec(const std::string& text);
+
+    void AddRef();
+    // Drops a reference, deleting this object if it was the last one.
+    void Release();
+    bool HasOneRef() const;
+
+    std::string spec;
+
+   private:
+    ~SharedSpec();
+
+    volatile long ref_count_;
+  };
+
+  // Returns the empty string, for GURLs that have no spec.
+  GURL_API static const std::string& EmptySpec();
+
+  // Returns the actual text of the URL, valid or not.
+  const std::string& raw_spec() const {
+    return spec_ ? spec_->spec : EmptySpec();
+  }
+
+  // Returns the spec for writing, first copying it if it is shared.
+  std::string* MutableSpec();
+
   // Returns the substring of the input identified by the given component.
   std::string ComponentString(const url_parse::Component& comp) const {
     if (comp.len <= 0)
       return std::string();
-    return std::string(spec_, comp.begin, comp.len);
+    return std::string(raw_spec(), comp.begin, comp.len);
   }
 
-  // The actual text of the URL, in canonical ASCII form.
-  std::string spec_;
+  // The actual text of the URL, in canonical ASCII form. NULL when it is
+  // empty, so that default-constructed GURLs don't allocate.
+  SharedSpec* spec_;
 
   // Set when the given URL is valid. Otherwise, we may still have a spec and
   // components, but they may not identify valid resources (for example, an
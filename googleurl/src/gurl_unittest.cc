@@ -135,6 +135,32 @@ TEST(GURLTest, Copy) {
   EXPECT_EQ("", invalid2.ref());
 }
 
+// Copies share the spec of the original, and changing one leaves the others
+// alone.
+TEST(GURLTest, CopySharesSpec) {
+  GURL url("http://www.google.com/foo?q=a");
+  GURL copy(url);
+  EXPECT_EQ(url.spec().data(), copy.spec().data());
+
+  GURL assigned;
+  assigned = url;
+  EXPECT_EQ(url.spec().data(), assigned.spec().data());
+  assigned = assigned;
+  EXPECT_EQ("http://www.google.com/foo?q=a", assigned.spec());
+
+  GURL empty_path(copy.GetWithEmptyPath());
+  EXPECT_EQ("http://www.google.com/", empty_path.spec());
+  EXPECT_EQ("http://www.google.com/foo?q=a", url.spec());
+  EXPECT_EQ("http://www.google.com/foo?q=a", copy.spec());
+
+  GURL other("http://www.example.com/");
+  other.Swap(&copy);
+  EXPECT_EQ(url.spec().data(), other.spec().data());
+  EXPECT_EQ("http://www.example.com/", copy.spec());
+  EXPECT_TRUE(url == other);
+  EXPECT_TRUE(url != copy);
+}
+
 // Given an invalid URL, we should still get most of the components.
 TEST(GURLTest, Invalid) {
   GURL url("http:google.com:foo");
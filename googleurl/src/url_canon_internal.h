@@ -423,6 +423,12 @@ bool CanonicalizePartialPath(const char16* spec,
                              int path_begin_in_output,
                              CanonOutput* output);
 
+// Returns true if |path| is non-empty, starts with a slash, and would be
+// copied unchanged by CanonicalizePath: no characters that get escaped or
+// unescaped, no escape sequences and no "." or ".." segments. Implemented in
+// url_canon_path.cc next to the table it checks against.
+bool IsCanonicalPath(const char* spec, const url_parse::Component& path);
+
 #ifndef WIN32
 
 // Implementations of Windows' int-to-string conversions
@@ -377,4 +377,30 @@ bool CanonicalizePartialPath(const char16* spec,
                                        output);
 }
 
+bool IsCanonicalPath(const char* spec, const url_parse::Component& path) {
+  if (path.len <= 0 || spec[path.begin] != '/')
+    return false;
+
+  int end = path.end();
+  for (int i = path.begin; i < end; i++) {
+    unsigned char c = static_cast<unsigned char>(spec[i]);
+    if (c == '/') {
+      // Reject "/." and "/.." segments, which get resolved away.
+      int after_dots = i + 1;
+      if (after_dots < end && spec[after_dots] == '.') {
+        after_dots++;
+        if (after_dots < end && spec[after_dots] == '.')
+          after_dots++;
+        if (after_dots == end || spec[after_dots] == '/')
+          return false;
+      }
+    } else if (c != '.' && (kPathCharLookup[c] & SPECIAL)) {
+      // Characters to escape, '%' and backslashes all need the full
+      // canonicalizer.
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace url_canon
@@ -37,6 +37,144 @@ namespace url_canon {
 
 namespace {
 
+inline bool IsLowerAlpha(char c) {
+  return c >= 'a' && c <= 'z';
+}
+
+inline bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+// Returns true if |scheme| starts the spec and is lowercase.
+bool IsCanonicalScheme(const char* spec, const url_parse::Component& scheme) {
+  if (scheme.begin != 0 || scheme.len <= 0 || !IsLowerAlpha(spec[0]))
+    return false;
+  for (int i = 1; i < scheme.len; i++) {
+    char c = spec[i];
+    if (!IsLowerAlpha(c) && !IsDigit(c) && c != '+' && c != '-' && c != '.')
+      return false;
+  }
+  return true;
+}
+
+// Returns true if |host| is made of non-empty lowercase ASCII labels, which
+// the host canonicalizer copies as they are. A host whose last label starts
+// with a digit may be an IPv4 address in some other notation, so those are
+// left to the full canonicalizer; so are hosts with a trailing dot.
+bool IsCanonicalHost(const char* spec, const url_parse::Component& host) {
+  if (host.len <= 0)
+    return false;
+  int end = host.end();
+  int label_begin = host.begin;
+  for (int i = host.begin; i < end; i++) {
+    char c = spec[i];
+    if (c == '.') {
+      if (i == label_begin)
+        return false;
+      label_begin = i + 1;
+    } else if (!IsLowerAlpha(c) && !IsDigit(c) && c != '-') {
+      return false;
+    }
+  }
+  return label_begin < end && !IsDigit(spec[label_begin]);
+}
+
+// Returns true if |port| is a decimal number without leading zeros that is
+// in range and isn't |default_port|, which would be dropped.
+bool IsCanonicalPort(const char* spec, const url_parse::Component& port,
+                     int default_port) {
+  if (port.len <= 0 || port.len > 5 || spec[port.begin] == '0')
+    return false;
+  int value = 0;
+  for (int i = port.begin; i < port.end(); i++) {
+    if (!IsDigit(spec[i]))
+      return false;
+    value = value * 10 + (spec[i] - '0');
+  }
+  return value <= 65535 && value != default_port;
+}
+
+// Returns true if |spec| is already exactly what DoCanonicalizeStandardURL
+// would write for it, so that it can be copied to the output in one go. This
+// only recognizes the common "scheme://host[:port]/path[?query][#ref]" shape
+// in plain ASCII, and is conservative: a false return just means the URL gets
+// canonicalized component by component.
+bool IsCanonicalStandardURL(const char* spec,
+                            int spec_len,
+                            const url_parse::Parsed& parsed) {
+  if (parsed.username.is_valid() || parsed.password.is_valid())
+    return false;
+
+  if (!IsCanonicalScheme(spec, parsed.scheme))
+    return false;
+  int next = parsed.scheme.end();
+  if (spec_len < next + 3 || spec[next] != ':' ||
+      spec[next + 1] != '/' || spec[next + 2] != '/')
+    return false;
+  next += 3;
+
+  if (parsed.host.begin != next || !IsCanonicalHost(spec, parsed.host))
+    return false;
+  next = parsed.host.end();
+
+  if (parsed.port.is_valid()) {
+    int default_port = DefaultPortForScheme(spec, parsed.scheme.len);
+    if (parsed.port.begin != next + 1 ||
+        !IsCanonicalPort(spec, parsed.port, default_port))
+      return false;
+    next = parsed.port.end();
+  }
+
+  if (parsed.path.begin != next || !IsCanonicalPath(spec, parsed.path))
+    return false;
+  next = parsed.path.end();
+
+  if (parsed.query.is_valid()) {
+    if (parsed.query.begin != next + 1)
+      return false;
+    for (int i = parsed.query.begin; i < parsed.query.end(); i++) {
+      if (!IsQueryChar(static_cast<unsigned char>(spec[i])))
+        return false;
+    }
+    next = parsed.query.end();
+  }
+
+  if (parsed.ref.is_valid()) {
+    if (parsed.ref.begin != next + 1)
+      return false;
+    for (int i = parsed.ref.begin; i < parsed.ref.end(); i++) {
+      unsigned char c = static_cast<unsigned char>(spec[i]);
+      if (c < 0x20 || c >= 0x80)
+        return false;
+    }
+    next = parsed.ref.end();
+  }
+
+  return next == spec_len;
+}
+
+void OffsetComponent(int offset, url_parse::Component* component) {
+  if (component->is_valid())
+    component->begin += offset;
+}
+
+// Appends |spec|, which IsCanonicalStandardURL() accepted, to |output|.
+void AppendCanonicalStandardURL(const char* spec,
+                                int spec_len,
+                                const url_parse::Parsed& parsed,
+                                CanonOutput* output,
+                                url_parse::Parsed* new_parsed) {
+  int offset = output->length();
+  output->Append(spec, spec_len);
+  *new_parsed = parsed;
+  OffsetComponent(offset, &new_parsed->scheme);
+  OffsetComponent(offset, &new_parsed->host);
+  OffsetComponent(offset, &new_parsed->port);
+  OffsetComponent(offset, &new_parsed->path);
+  OffsetComponent(offset, &new_parsed->query);
+  OffsetComponent(offset, &new_parsed->ref);
+}
+
 template<typename CHAR, typename UCHAR>
 bool DoCanonicalizeStandardURL(const URLComponentSource<CHAR>& source,
                                const url_parse::Parsed& parsed,
@@ -154,6 +292,12 @@ bool CanonicalizeStandardURL(const char* spec,
                              CharsetConverter* query_converter,
                              CanonOutput* output,
                              url_parse::Parsed* new_parsed) {
+  // Most URLs we see are already canonical, e.g. ones that came out of a GURL
+  // before. Copying those saves rebuilding them component by component.
+  if (IsCanonicalStandardURL(spec, spec_len, parsed)) {
+    AppendCanonicalStandardURL(spec, spec_len, parsed, output, new_parsed);
+    return true;
+  }
   return DoCanonicalizeStandardURL<char, unsigned char>(
       URLComponentSource<char>(spec), parsed, query_converter,
       output, new_parsed);
@@ -1958,6 +1958,74 @@ TEST(URLCanonTest, ResolveRelativeURL) {
 // characters, we would get invalid data in the URL. This is because the buffer
 // it used to hold the UTF-8 data was resized, while some pointers were still
 // kept to the old buffer that was removed.
+// Canonical standard URLs are copied rather than rebuilt. Check that the
+// copy matches what canonicalizing produces, and that URLs that are close
+// to canonical still get fixed up.
+TEST(URLCanonTest, CanonicalizeCanonicalStandardURL) {
+  struct URLCase {
+    const char* input;
+    const char* expected;
+  } cases[] = {
+      // Already canonical.
+    {"http://www.google.com/", "http://www.google.com/"},
+    {"https://a-b.example.com:8443/x/y.html?q=1&r=%20#top",
+     "https://a-b.example.com:8443/x/y.html?q=1&r=%20#top"},
+    {"http://www.google.com/a/...b/c.", "http://www.google.com/a/...b/c."},
+    {"http://www.google.com/?", "http://www.google.com/?"},
+    {"http://www.google.com/#", "http://www.google.com/#"},
+      // Almost canonical.
+    {"HTTP://www.google.com/", "http://www.google.com/"},
+    {"http://www.Google.com/", "http://www.google.com/"},
+    {"http://www.google.com", "http://www.google.com/"},
+    {"http://www.google.com?q", "http://www.google.com/?q"},
+    {"http://www.google.com:80/", "http://www.google.com/"},
+    {"http://www.google.com:080/", "http://www.google.com/"},
+    {"http://www.google.com:/", "http://www.google.com/"},
+    {"http:/www.google.com/", "http://www.google.com/"},
+    {"http:\\\\www.google.com\\foo", "http://www.google.com/foo"},
+    {"http://user@www.google.com/", "http://user@www.google.com/"},
+    {"http://0x7f.1/", "http://127.0.0.1/"},
+    {"http://1.2.3.4/", "http://1.2.3.4/"},
+    {"http://www.google.com/a/./b/../c", "http://www.google.com/a/c"},
+    {"http://www.google.com/a/.", "http://www.google.com/a/"},
+    {"http://www.google.com/%41", "http://www.google.com/A"},
+    {"http://www.google.com/a b", "http://www.google.com/a%20b"},
+    {"http://www.google.com/?a b", "http://www.google.com/?a%20b"},
+    {"http://www.google.com/#a\x01z", "http://www.google.com/#a%01z"},
+    {"http://www.google.com/\xc2\xa9", "http://www.google.com/%C2%A9"},
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE(cases); i++) {
+    int url_len = static_cast<int>(strlen(cases[i].input));
+    url_parse::Parsed parsed;
+    url_parse::ParseStandardURL(cases[i].input, url_len, &parsed);
+
+    // Start with something in the output, which the components must skip.
+    url_parse::Parsed out_parsed;
+    std::string out_str;
+    url_canon::StdStringCanonOutput output(&out_str);
+    output.Append("prefix", 6);
+    EXPECT_TRUE(url_canon::CanonicalizeStandardURL(
+        cases[i].input, url_len, parsed, NULL, &output, &out_parsed));
+    output.Complete();
+    EXPECT_EQ(std::string("prefix") + cases[i].expected, out_str);
+
+    // The components must match parsing the output.
+    url_parse::Parsed expected_parsed;
+    url_parse::ParseStandardURL(cases[i].expected,
+                                static_cast<int>(strlen(cases[i].expected)),
+                                &expected_parsed);
+    EXPECT_EQ(expected_parsed.scheme.begin + 6, out_parsed.scheme.begin);
+    EXPECT_EQ(expected_parsed.host.begin + 6, out_parsed.host.begin);
+    EXPECT_EQ(expected_parsed.host.len, out_parsed.host.len);
+    EXPECT_EQ(expected_parsed.port.len, out_parsed.port.len);
+    EXPECT_EQ(expected_parsed.path.begin + 6, out_parsed.path.begin);
+    EXPECT_EQ(expected_parsed.path.len, out_parsed.path.len);
+    EXPECT_EQ(expected_parsed.query.len, out_parsed.query.len);
+    EXPECT_EQ(expected_parsed.ref.len, out_parsed.ref.len);
+  }
+}
+
 TEST(URLCanonTest, ReplacementOverflow) {
   const char src[] = "file:///C:/foo/bar";
   int src_len = static_cast<int>(strlen(src));
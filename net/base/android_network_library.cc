@@ -6,6 +6,7 @@
 
 #include "base/lazy_instance.h"
 #include "base/logging.h"
+#include "base/observer_list_threadsafe.h"
 #include "base/synchronization/lock.h"
 
 using base::Lock;
@@ -15,7 +16,15 @@ namespace net {
 
 class LibHolder {
  public:
-  LibHolder() : lib_(NULL) {}
+  typedef ObserverListThreadSafe<AndroidNetworkLibrary::ConnectionTypeObserver>
+      ConnectionTypeObserverList;
+
+  LibHolder()
+      : lib_(NULL),
+        connection_type_observers_(new ConnectionTypeObserverList(
+            ObserverListBase<AndroidNetworkLibrary::ConnectionTypeObserver>::
+                NOTIFY_EXISTING_ONLY)) {
+  }
   ~LibHolder() {
     Reset();
   }
@@ -37,10 +46,14 @@ class LibHolder {
     AutoLock lock(lock_);
     return lib_;
   }
+  ConnectionTypeObserverList* connection_type_observers() {
+    return connection_type_observers_;
+  }
 
  private:
   AndroidNetworkLibrary* lib_;
   Lock lock_;
+  const scoped_refptr<ConnectionTypeObserverList> connection_type_observers_;
 };
 
 base::LazyInstance<LibHolder> g_holder(base::LINKER_INITIALIZED);
@@ -60,6 +73,30 @@ AndroidNetworkLibrary* AndroidNetworkLibrary::GetSharedInstance() {
   return g_holder.Get().GetLibrary();
 }
 
+// static
+void AndroidNetworkLibrary::AddConnectionTypeObserver(
+    ConnectionTypeObserver* observer) {
+  g_holder.Get().connection_type_observers()->AddObserver(observer);
+}
+
+// static
+void AndroidNetworkLibrary::RemoveConnectionTypeObserver(
+    ConnectionTypeObserver* observer) {
+  g_holder.Get().connection_type_observers()->RemoveObserver(observer);
+}
+
+// static
+void AndroidNetworkLibrary::NotifyConnectionTypeChanged(
+    NetworkTuningProfile::ConnectionType type) {
+  g_holder.Get().connection_type_observers()->Notify(
+      &ConnectionTypeObserver::OnConnectionTypeChanged, type);
+}
+
+NetworkTuningProfile::ConnectionType
+    AndroidNetworkLibrary::GetConnectionType() {
+  return NetworkTuningProfile::CONNECTION_UNKNOWN;
+}
+
 AndroidNetworkLibrary::AndroidNetworkLibrary() {
 }
 
@@ -11,6 +11,7 @@
 
 #include "base/basictypes.h"
 #include "net/base/net_export.h"
+#include "net/base/network_tuning_profile.h"
 
 namespace net {
 
@@ -20,6 +21,30 @@ class NET_EXPORT AndroidNetworkLibrary {
   static void UnregisterSharedInstance();
   static AndroidNetworkLibrary* GetSharedInstance();
 
+  class NET_EXPORT ConnectionTypeObserver {
+   public:
+    virtual ~ConnectionTypeObserver() {}
+
+    // Called on the thread which added the observer.
+    virtual void OnConnectionTypeChanged(
+        NetworkTuningProfile::ConnectionType type) = 0;
+
+   protected:
+    ConnectionTypeObserver() {}
+
+   private:
+    DISALLOW_COPY_AND_ASSIGN(ConnectionTypeObserver);
+  };
+
+  // Observers may be added and removed on any thread with a MessageLoop.
+  static void AddConnectionTypeObserver(ConnectionTypeObserver* observer);
+  static void RemoveConnectionTypeObserver(ConnectionTypeObserver* observer);
+
+  // Called, on any thread, by the platform when the type of the active
+  // connection changes.
+  static void NotifyConnectionTypeChanged(
+      NetworkTuningProfile::ConnectionType type);
+
   enum VerifyResult {
     VERIFY_OK,
     VERIFY_BAD_HOSTNAME,
@@ -35,6 +60,9 @@ class NET_EXPORT AndroidNetworkLibrary {
       const std::string& hostname,
       const std::string& auth_type) = 0;
 
+  // Returns the type of the active connection.
+  virtual NetworkTuningProfile::ConnectionType GetConnectionType();
+
  protected:
   friend class LibHolder;
   AndroidNetworkLibrary();
@@ -0,0 +1,816 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/async_dns_resolver.h"
+
+#include <algorithm>
+
+#include "base/compiler_specific.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/rand_util.h"
+#include "base/stl_util-inl.h"
+#include "base/string_piece.h"
+#include "base/string_util.h"
+#include "base/synchronization/lock.h"
+#include "base/task.h"
+#include "base/threading/worker_pool.h"
+#include "base/timer.h"
+#include "net/base/address_list.h"
+#include "net/base/dns_util.h"
+#include "net/base/dnsrr_resolver.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_log.h"
+#include "net/udp/udp_client_socket.h"
+
+namespace net {
+
+namespace {
+
+// The largest response that fits a UDP datagram, see RFC 1035 section 4.2.1.
+const int kMaxUDPResponseSize = 512;
+
+// RFC 1035 section 4.1.1.
+const uint16 kFlagResponse = 0x8000;
+const uint16 kFlagTruncated = 0x0200;
+const uint16 kFlagRecursionDesired = 0x0100;
+// RFC 4035 section 3.2.3.
+const uint16 kFlagAuthenticData = 0x0020;
+const uint16 kRcodeMask = 0x000f;
+const uint16 kRcodeNoError = 0;
+const uint16 kRcodeNameError = 3;
+
+void AppendU16(uint16 value, std::string* out) {
+  out->push_back(static_cast<char>(value >> 8));
+  out->push_back(static_cast<char>(value & 0xff));
+}
+
+// Adds |name| to |names|, if it can be sent in a query.
+void AddQueryName(const std::string& name, std::vector<std::string>* names) {
+  std::string dns_name;
+  if (DNSDomainFromDot(name, &dns_name))
+    names->push_back(name);
+}
+
+void AppendAddress(const IPAddressNumber& address, AddressList* addresses) {
+  AddressList single(address, 0, false);
+  if (addresses->head())
+    addresses->Append(single.head());
+  else
+    *addresses = single;
+}
+
+// Returns true if the only name server is on this machine.  The AD bit of an
+// answer is no more trustworthy than the path it came over, so it only counts
+// then, as in RRResponse::ParseFromResponse().
+bool HasOnlyLocalNameServer(const DnsConfig& config) {
+  if (config.nameservers.size() != 1)
+    return false;
+  static const uint8 kIPv4Loopback[] = { 127, 0, 0, 1 };
+  static const uint8 kIPv6Loopback[] =
+      { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+  const IPAddressNumber& address = config.nameservers[0].address();
+  if (address.size() == kIPv4AddressSize)
+    return std::equal(address.begin(), address.end(), kIPv4Loopback);
+  return std::equal(address.begin(), address.end(), kIPv6Loopback);
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+// Reads the system configuration on a worker thread, and hands it to the
+// resolver on the origin thread.
+class AsyncDnsResolver::ConfigLoader
+    : public base::RefCountedThreadSafe<AsyncDnsResolver::ConfigLoader> {
+ public:
+  explicit ConfigLoader(AsyncDnsResolver* resolver)
+      : resolver_(resolver),
+        origin_loop_(MessageLoop::current()),
+        succeeded_(false) {
+  }
+
+  void Start() {
+    const bool kIsSlow = true;
+    base::WorkerPool::PostTask(
+        FROM_HERE, NewRunnableMethod(this, &ConfigLoader::DoLoad), kIsSlow);
+  }
+
+  // Called on the origin thread.
+  void Cancel() {
+    resolver_ = NULL;
+    base::AutoLock locked(origin_loop_lock_);
+    origin_loop_ = NULL;
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<AsyncDnsResolver::ConfigLoader>;
+
+  ~ConfigLoader() {}
+
+  // Runs on the worker thread.
+  void DoLoad() {
+    succeeded_ = ReadSystemDnsConfig(&config_, &hosts_);
+
+    // The origin loop could go away while we are trying to post to it, so we
+    // need to call its PostTask method inside a lock.
+    base::AutoLock locked(origin_loop_lock_);
+    if (origin_loop_) {
+      origin_loop_->PostTask(
+          FROM_HERE, NewRunnableMethod(this, &ConfigLoader::OnLoadComplete));
+    }
+  }
+
+  void OnLoadComplete() {
+    if (resolver_)
+      resolver_->OnConfigLoaded(succeeded_, config_, hosts_);
+  }
+
+  // Only used on the origin thread.
+  AsyncDnsResolver* resolver_;
+
+  base::Lock origin_loop_lock_;
+  MessageLoop* origin_loop_;
+
+  // Written on the worker thread, read on the origin thread once posted.
+  bool succeeded_;
+  DnsConfig config_;
+  DnsHosts hosts_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConfigLoader);
+};
+
+//-----------------------------------------------------------------------------
+
+// A query for one name and record type, sent to each name server in turn until
+// one of them answers.
+class AsyncDnsResolver::Transaction {
+ public:
+  Transaction(Request* request,
+              const DnsConfig& config,
+              size_t first_server,
+              const std::string& name,
+              uint16 qtype,
+              NetLog* net_log);
+  ~Transaction();
+
+  // Returns ERR_IO_PENDING if the query is on its way, in which case |request|
+  // will be told when it completes.  Otherwise returns the result.
+  int Start();
+
+  int result() const { return result_; }
+  uint16 qtype() const { return qtype_; }
+
+  // The answer, once result() is OK.  For A and AAAA queries, the records are
+  // the addresses.
+  const std::string& canonical_name() const { return canonical_name_; }
+  uint32 ttl() const { return ttl_; }
+  bool authenticated() const { return authenticated_; }
+  const std::vector<std::string>& records() const { return records_; }
+  const std::vector<std::string>& signatures() const { return signatures_; }
+
+ private:
+  enum State {
+    STATE_SEND_QUERY,
+    STATE_SEND_QUERY_COMPLETE,
+    STATE_READ_RESPONSE,
+    STATE_READ_RESPONSE_COMPLETE,
+    STATE_NONE,
+  };
+
+  int DoLoop(int result);
+  int DoSendQuery();
+  int DoSendQueryComplete(int result);
+  int DoReadResponse();
+  int DoReadResponseComplete(int result);
+
+  // Moves on to the next attempt, after the current one failed with |result|.
+  // Returns OK if there is one left, or |result| otherwise.
+  int NextAttempt(int result);
+
+  // Parses the |len| bytes in |response_buffer_|.  Returns ERR_IO_PENDING if
+  // they aren't the answer to the query, which may still come.
+  int ParseResponse(int len);
+
+  void OnIOComplete(int result);
+  void OnTimeout();
+  void DoCallback(int result);
+
+  Request* const request_;
+  const DnsConfig config_;
+  const size_t first_server_;
+  const std::string name_;
+  const uint16 qtype_;
+  NetLog* const net_log_;
+
+  // |name_| in the format of a query.
+  std::string dns_name_;
+
+  State next_state_;
+  int attempt_;
+  uint16 query_id_;
+
+  scoped_ptr<DatagramClientSocket> socket_;
+  scoped_refptr<IOBufferWithSize> query_buffer_;
+  scoped_refptr<IOBufferWithSize> response_buffer_;
+  CompletionCallbackImpl<Transaction> io_callback_;
+  base::OneShotTimer<Transaction> timer_;
+
+  int result_;
+  std::string canonical_name_;
+  // The lowest TTL of |records_|.
+  uint32 ttl_;
+  // True if the answer had the AD bit set by a name server on this machine.
+  bool authenticated_;
+  std::vector<std::string> records_;
+  std::vector<std::string> signatures_;
+
+  DISALLOW_COPY_AND_ASSIGN(Transaction);
+};
+
+//-----------------------------------------------------------------------------
+
+// Resolves a name, by trying each of its query names until one exists.  The
+// transactions for a query name, one for each record type, run in parallel.
+// The answer is either the addresses found, or the records of each type.
+class AsyncDnsResolver::Request {
+ public:
+  Request(AsyncDnsResolver* resolver,
+          const std::vector<std::string>& names,
+          const std::vector<uint16>& qtypes,
+          AddressList* addresses,
+          CompletionCallback* callback)
+      : resolver_(resolver),
+        names_(names),
+        next_name_(0),
+        qtypes_(qtypes),
+        addresses_(addresses),
+        results_(NULL),
+        responses_(NULL),
+        callback_(callback),
+        pending_transactions_(0) {
+  }
+
+  Request(AsyncDnsResolver* resolver,
+          const std::string& name,
+          const std::vector<uint16>& qtypes,
+          std::vector<int>* results,
+          std::vector<RRResponse>* responses,
+          CompletionCallback* callback)
+      : resolver_(resolver),
+        names_(1, name),
+        next_name_(0),
+        qtypes_(qtypes),
+        addresses_(NULL),
+        results_(results),
+        responses_(responses),
+        callback_(callback),
+        pending_transactions_(0) {
+  }
+
+  ~Request() {
+    STLDeleteElements(&transactions_);
+  }
+
+  int Start() {
+    return StartNextName();
+  }
+
+  // Called by a transaction that completed asynchronously.  May delete |this|.
+  void OnTransactionComplete() {
+    DCHECK_GT(pending_transactions_, 0);
+    if (--pending_transactions_ > 0)
+      return;
+    int rv = GetNameResult();
+    if (rv == ERR_NAME_NOT_RESOLVED && addresses_)
+      rv = StartNextName();
+    if (rv != ERR_IO_PENDING)
+      resolver_->OnRequestComplete(this, rv);
+  }
+
+  CompletionCallback* callback() const { return callback_; }
+
+ private:
+  int StartNextName() {
+    while (next_name_ < names_.size()) {
+      const std::string& name = names_[next_name_++];
+      STLDeleteElements(&transactions_);
+
+      for (size_t i = 0; i < qtypes_.size(); ++i)
+        AddTransaction(name, qtypes_[i]);
+
+      pending_transactions_ = 0;
+      for (size_t i = 0; i < transactions_.size(); ++i) {
+        if (transactions_[i]->Start() == ERR_IO_PENDING)
+          pending_transactions_++;
+      }
+      if (pending_transactions_ > 0)
+        return ERR_IO_PENDING;
+
+      int rv = GetNameResult();
+      if (rv != ERR_NAME_NOT_RESOLVED || !addresses_)
+        return rv;
+    }
+    return ERR_NAME_NOT_RESOLVED;
+  }
+
+  void AddTransaction(const std::string& name, uint16 qtype) {
+    transactions_.push_back(new Transaction(
+        this, resolver_->config_, resolver_->NextServerIndex(), name, qtype,
+        resolver_->net_log_));
+  }
+
+  // Returns the result for the current query name, once all its transactions
+  // are done.  Any addresses found make it a success.  A lookup of records
+  // always succeeds, with the result of each transaction handed back.
+  int GetNameResult() {
+    if (!addresses_) {
+      GetRecords();
+      return OK;
+    }
+    AddressList addresses;
+    int rv = ERR_NAME_NOT_RESOLVED;
+    for (size_t i = 0; i < transactions_.size(); ++i) {
+      const Transaction* transaction = transactions_[i];
+      if (transaction->result() == OK) {
+        const std::vector<std::string>& found = transaction->records();
+        for (size_t j = 0; j < found.size(); ++j) {
+          AppendAddress(IPAddressNumber(found[j].begin(), found[j].end()),
+                        &addresses);
+        }
+      } else if (transaction->result() != ERR_NAME_NOT_RESOLVED) {
+        rv = transaction->result();
+      }
+    }
+    if (!addresses.head())
+      return rv;
+    *addresses_ = addresses;
+    return OK;
+  }
+
+  void GetRecords() {
+    base::Time now = base::Time::Now();
+    results_->assign(transactions_.size(), ERR_UNEXPECTED);
+    responses_->assign(transactions_.size(), RRResponse());
+    for (size_t i = 0; i < transactions_.size(); ++i) {
+      const Transaction* transaction = transactions_[i];
+      RRResponse* response = &(*responses_)[i];
+      (*results_)[i] = transaction->result();
+      response->fetch_time = now;
+      if (transaction->result() != OK)
+        continue;
+      response->name = transaction->canonical_name();
+      response->ttl = transaction->ttl();
+      response->dnssec = transaction->authenticated();
+      response->rrdatas = transaction->records();
+      response->signatures = transaction->signatures();
+    }
+  }
+
+  AsyncDnsResolver* const resolver_;
+  const std::vector<std::string> names_;
+  size_t next_name_;
+  const std::vector<uint16> qtypes_;
+
+  // Where the answer goes: |addresses_| for an address lookup, or |results_|
+  // and |responses_| for a lookup of records.
+  AddressList* const addresses_;
+  std::vector<int>* const results_;
+  std::vector<RRResponse>* const responses_;
+  CompletionCallback* const callback_;
+
+  // The transactions for the current query name.
+  std::vector<Transaction*> transactions_;
+  int pending_transactions_;
+
+  DISALLOW_COPY_AND_ASSIGN(Request);
+};
+
+//-----------------------------------------------------------------------------
+
+AsyncDnsResolver::Transaction::Transaction(Request* request,
+                                           const DnsConfig& config,
+                                           size_t first_server,
+                                           const std::string& name,
+                                           uint16 qtype,
+                                           NetLog* net_log)
+    : request_(request),
+      config_(config),
+      first_server_(first_server),
+      name_(name),
+      qtype_(qtype),
+      net_log_(net_log),
+      next_state_(STATE_NONE),
+      attempt_(0),
+      query_id_(0),
+      response_buffer_(new IOBufferWithSize(kMaxUDPResponseSize)),
+      ALLOW_THIS_IN_INITIALIZER_LIST(
+          io_callback_(this, &Transaction::OnIOComplete)),
+      result_(ERR_IO_PENDING),
+      ttl_(0),
+      authenticated_(false) {
+  DCHECK(!config_.nameservers.empty());
+}
+
+AsyncDnsResolver::Transaction::~Transaction() {}
+
+int AsyncDnsResolver::Transaction::Start() {
+  if (!DNSDomainFromDot(name_, &dns_name_)) {
+    NOTREACHED() << "AddQueryName() let in " << name_;
+    result_ = ERR_UNEXPECTED;
+    return result_;
+  }
+  next_state_ = STATE_SEND_QUERY;
+  int rv = DoLoop(OK);
+  if (rv != ERR_IO_PENDING)
+    result_ = rv;
+  return rv;
+}
+
+int AsyncDnsResolver::Transaction::DoLoop(int result) {
+  DCHECK_NE(STATE_NONE, next_state_);
+  int rv = result;
+  do {
+    State state = next_state_;
+    next_state_ = STATE_NONE;
+    switch (state) {
+      case STATE_SEND_QUERY:
+        DCHECK_EQ(OK, rv);
+        rv = DoSendQuery();
+        break;
+      case STATE_SEND_QUERY_COMPLETE:
+        rv = DoSendQueryComplete(rv);
+        break;
+      case STATE_READ_RESPONSE:
+        DCHECK_EQ(OK, rv);
+        rv = DoReadResponse();
+        break;
+      case STATE_READ_RESPONSE_COMPLETE:
+        rv = DoReadResponseComplete(rv);
+        break;
+      default:
+        NOTREACHED() << "bad state";
+        rv = ERR_UNEXPECTED;
+        break;
+    }
+  } while (rv != ERR_IO_PENDING && next_state_ != STATE_NONE);
+  return rv;
+}
+
+int AsyncDnsResolver::Transaction::DoSendQuery() {
+  next_state_ = STATE_SEND_QUERY_COMPLETE;
+
+  size_t num_servers = config_.nameservers.size();
+  const IPEndPoint& server =
+      config_.nameservers[(first_server_ + attempt_) % num_servers];
+  socket_.reset(new UDPClientSocket(net_log_, NetLog::Source()));
+  int rv = socket_->Connect(server);
+  if (rv != OK)
+    return rv;
+
+  // A new ID for every attempt, so a late answer to an earlier one can't be
+  // mistaken for this one.  See RFC 1035 section 4.1.1 for the header.
+  query_id_ = static_cast<uint16>(base::RandInt(0, kuint16max));
+  std::string query;
+  AppendU16(query_id_, &query);
+  AppendU16(kFlagRecursionDesired, &query);
+  AppendU16(1, &query);  // One question.
+  AppendU16(0, &query);  // No answers,
+  AppendU16(0, &query);  // authority records,
+  AppendU16(0, &query);  // or additional records.
+  query.append(dns_name_);
+  AppendU16(qtype_, &query);
+  AppendU16(kClassIN, &query);
+
+  query_buffer_ = new IOBufferWithSize(query.size());
+  memcpy(query_buffer_->data(), query.data(), query.size());
+  return socket_->Write(query_buffer_, query_buffer_->size(), &io_callback_);
+}
+
+int AsyncDnsResolver::Transaction::DoSendQueryComplete(int result) {
+  if (result < 0)
+    return NextAttempt(result);
+  if (result != query_buffer_->size())
+    return NextAttempt(ERR_FAILED);
+
+  // Later rounds through the name servers wait longer.
+  int round = attempt_ / config_.nameservers.size();
+  timer_.Start(config_.timeout * (1 << round), this, &Transaction::OnTimeout);
+  next_state_ = STATE_READ_RESPONSE;
+  return OK;
+}
+
+int AsyncDnsResolver::Transaction::DoReadResponse() {
+  next_state_ = STATE_READ_RESPONSE_COMPLETE;
+  return socket_->Read(response_buffer_, response_buffer_->size(),
+                       &io_callback_);
+}
+
+int AsyncDnsResolver::Transaction::DoReadResponseComplete(int result) {
+  if (result >= 0)
+    result = ParseResponse(result);
+  if (result == ERR_IO_PENDING) {
+    // Keep waiting for the real answer.
+    next_state_ = STATE_READ_RESPONSE;
+    return OK;
+  }
+
+  timer_.Stop();
+  if (result == OK || result == ERR_NAME_NOT_RESOLVED ||
+      result == ERR_DNS_SERVER_REQUIRES_TCP) {
+    socket_.reset();
+    return result;
+  }
+  return NextAttempt(result);
+}
+
+int AsyncDnsResolver::Transaction::NextAttempt(int result) {
+  socket_.reset();
+  int max_attempts = config_.attempts * config_.nameservers.size();
+  if (++attempt_ >= max_attempts)
+    return result;
+  next_state_ = STATE_SEND_QUERY;
+  return OK;
+}
+
+int AsyncDnsResolver::Transaction::ParseResponse(int len) {
+  DnsResponseBuffer buf(reinterpret_cast<const uint8*>(response_buffer_->data()),
+                        len);
+  uint16 id, flags, question_count, answer_count, authority_count,
+      additional_count;
+  if (!buf.U16(&id) ||
+      !buf.U16(&flags) ||
+      !buf.U16(&question_count) ||
+      !buf.U16(&answer_count) ||
+      !buf.U16(&authority_count) ||
+      !buf.U16(&additional_count)) {
+    return ERR_IO_PENDING;
+  }
+  if (id != query_id_ || !(flags & kFlagResponse) || question_count != 1)
+    return ERR_IO_PENDING;
+
+  // The question must be ours too.
+  std::string name;
+  uint16 type, klass;
+  if (!buf.DNSName(&name) ||
+      !buf.U16(&type) ||
+      !buf.U16(&klass) ||
+      type != qtype_ ||
+      klass != kClassIN ||
+      !LowerCaseEqualsASCII(name, TrimEndingDot(name_).c_str())) {
+    return ERR_IO_PENDING;
+  }
+
+  if (flags & kFlagTruncated)
+    return ERR_DNS_SERVER_REQUIRES_TCP;
+  switch (flags & kRcodeMask) {
+    case kRcodeNoError:
+      break;
+    case kRcodeNameError:
+      return ERR_NAME_NOT_RESOLVED;
+    default:
+      return ERR_DNS_SERVER_FAILED;
+  }
+
+  // Any CNAMEs come with the records of their targets, so all the records of
+  // the type asked for belong to the name.  The first answer is for the name
+  // the CNAMEs lead to, if any.
+  size_t address_size = 0;
+  if (qtype_ == kDNS_A)
+    address_size = kIPv4AddressSize;
+  else if (qtype_ == kDNS_AAAA)
+    address_size = kIPv6AddressSize;
+  records_.clear();
+  signatures_.clear();
+  ttl_ = 0;
+  authenticated_ =
+      (flags & kFlagAuthenticData) != 0 && HasOnlyLocalNameServer(config_);
+  for (uint16 i = 0; i < answer_count; ++i) {
+    uint32 ttl;
+    uint16 rdata_len;
+    base::StringPiece rdata;
+    if (!buf.DNSName(i == 0 ? &canonical_name_ : NULL) ||
+        !buf.U16(&type) ||
+        !buf.U16(&klass) ||
+        !buf.U32(&ttl) ||
+        !buf.U16(&rdata_len) ||
+        !buf.Block(&rdata, rdata_len)) {
+      records_.clear();
+      return ERR_DNS_MALFORMED_RESPONSE;
+    }
+    if (klass != kClassIN)
+      continue;
+    if (type == kDNS_RRSIG && qtype_ != kDNS_RRSIG) {
+      signatures_.push_back(rdata.as_string());
+      continue;
+    }
+    if (type != qtype_)
+      continue;
+    if (address_size && rdata.size() != address_size) {
+      records_.clear();
+      return ERR_DNS_MALFORMED_RESPONSE;
+    }
+    if (records_.empty() || ttl < ttl_)
+      ttl_ = ttl;
+    records_.push_back(rdata.as_string());
+  }
+  return records_.empty() ? ERR_NAME_NOT_RESOLVED : OK;
+}
+
+void AsyncDnsResolver::Transaction::OnIOComplete(int result) {
+  int rv = DoLoop(result);
+  if (rv != ERR_IO_PENDING)
+    DoCallback(rv);
+}
+
+void AsyncDnsResolver::Transaction::OnTimeout() {
+  int rv = NextAttempt(ERR_DNS_TIMED_OUT);
+  if (rv == OK)
+    rv = DoLoop(OK);
+  if (rv != ERR_IO_PENDING)
+    DoCallback(rv);
+}
+
+void AsyncDnsResolver::Transaction::DoCallback(int result) {
+  result_ = result;
+  // May delete |this|.
+  request_->OnTransactionComplete();
+}
+
+//-----------------------------------------------------------------------------
+
+AsyncDnsResolver::AsyncDnsResolver(NetLog* net_log)
+    : next_server_(0),
+      net_log_(net_log) {
+}
+
+AsyncDnsResolver::~AsyncDnsResolver() {
+  if (config_loader_)
+    config_loader_->Cancel();
+  STLDeleteElements(&requests_);
+}
+
+void AsyncDnsResolver::LoadSystemConfig() {
+  DCHECK(CalledOnValidThread());
+  if (config_loader_)
+    config_loader_->Cancel();
+  config_loader_ = new ConfigLoader(this);
+  config_loader_->Start();
+}
+
+void AsyncDnsResolver::SetConfig(const DnsConfig& config,
+                                 const DnsHosts& hosts) {
+  DCHECK(CalledOnValidThread());
+  config_ = config;
+  hosts_ = hosts;
+  next_server_ = 0;
+}
+
+int AsyncDnsResolver::Resolve(const std::string& hostname,
+                              AddressFamily address_family,
+                              AddressList* addresses,
+                              CompletionCallback* callback,
+                              Request** out_req) {
+  DCHECK(CalledOnValidThread());
+  DCHECK(callback);
+  if (out_req)
+    *out_req = NULL;
+  if (!IsReady())
+    return ERR_NAME_RESOLUTION_FAILED;
+
+  std::string name = StringToLowerASCII(hostname);
+  if (LookupHosts(TrimEndingDot(name), address_family, addresses))
+    return OK;
+
+  std::vector<std::string> names;
+  GetQueryNames(name, &names);
+  if (names.empty())
+    return ERR_NAME_NOT_RESOLVED;
+
+  // AAAA goes first, so its addresses come first in the list.
+  std::vector<uint16> qtypes;
+  if (address_family != ADDRESS_FAMILY_IPV4)
+    qtypes.push_back(kDNS_AAAA);
+  if (address_family != ADDRESS_FAMILY_IPV6)
+    qtypes.push_back(kDNS_A);
+
+  return StartRequest(
+      new Request(this, names, qtypes, addresses, callback), out_req);
+}
+
+int AsyncDnsResolver::ResolveRecords(const std::string& name,
+                                     const std::vector<uint16>& rrtypes,
+                                     std::vector<int>* results,
+                                     std::vector<RRResponse>* responses,
+                                     CompletionCallback* callback,
+                                     Request** out_req) {
+  DCHECK(CalledOnValidThread());
+  DCHECK(callback);
+  DCHECK(!rrtypes.empty());
+  if (out_req)
+    *out_req = NULL;
+  if (!IsReady())
+    return ERR_NAME_RESOLUTION_FAILED;
+
+  // The name is sent as it is, without trying the search suffixes.
+  std::vector<std::string> names;
+  AddQueryName(StringToLowerASCII(name), &names);
+  if (names.empty())
+    return ERR_NAME_NOT_RESOLVED;
+
+  return StartRequest(
+      new Request(this, names[0], rrtypes, results, responses, callback),
+      out_req);
+}
+
+void AsyncDnsResolver::CancelRequest(Request* req) {
+  DCHECK(CalledOnValidThread());
+  size_t erased = requests_.erase(req);
+  DCHECK_EQ(1u, erased);
+  delete req;
+}
+
+bool AsyncDnsResolver::LookupHosts(const std::string& hostname,
+                                   AddressFamily address_family,
+                                   AddressList* addresses) const {
+  AddressList found;
+  DnsHosts::const_iterator it;
+  if (address_family != ADDRESS_FAMILY_IPV4) {
+    it = hosts_.find(DnsHostsKey(hostname, ADDRESS_FAMILY_IPV6));
+    if (it != hosts_.end())
+      AppendAddress(it->second, &found);
+  }
+  if (address_family != ADDRESS_FAMILY_IPV6) {
+    it = hosts_.find(DnsHostsKey(hostname, ADDRESS_FAMILY_IPV4));
+    if (it != hosts_.end())
+      AppendAddress(it->second, &found);
+  }
+  if (!found.head())
+    return false;
+  *addresses = found;
+  return true;
+}
+
+void AsyncDnsResolver::GetQueryNames(const std::string& hostname,
+                                     std::vector<std::string>* names) const {
+  // A trailing dot means the name is fully qualified.
+  if (!hostname.empty() && hostname[hostname.size() - 1] == '.') {
+    AddQueryName(hostname, names);
+    return;
+  }
+
+  // As the system resolver does, names with enough dots are tried as they
+  // are before the search suffixes, and other names after them.
+  int dots = std::count(hostname.begin(), hostname.end(), '.');
+  if (dots >= config_.ndots)
+    AddQueryName(hostname, names);
+  for (size_t i = 0; i < config_.search.size(); ++i)
+    AddQueryName(hostname + "." + config_.search[i], names);
+  if (dots < config_.ndots)
+    AddQueryName(hostname, names);
+}
+
+int AsyncDnsResolver::StartRequest(Request* request, Request** out_req) {
+  scoped_ptr<Request> req(request);
+  int rv = req->Start();
+  if (rv != ERR_IO_PENDING)
+    return rv;
+  requests_.insert(req.get());
+  if (out_req)
+    *out_req = req.get();
+  req.release();
+  return ERR_IO_PENDING;
+}
+
+size_t AsyncDnsResolver::NextServerIndex() {
+  if (!config_.rotate)
+    return 0;
+  return next_server_++ % config_.nameservers.size();
+}
+
+void AsyncDnsResolver::OnConfigLoaded(bool succeeded,
+                                      const DnsConfig& config,
+                                      const DnsHosts& hosts) {
+  DCHECK(CalledOnValidThread());
+  config_loader_ = NULL;
+  if (succeeded) {
+    SetConfig(config, hosts);
+  } else {
+    VLOG(1) << "No DNS configuration to use, leaving lookups to the system";
+    SetConfig(DnsConfig(), DnsHosts());
+  }
+}
+
+void AsyncDnsResolver::OnRequestComplete(Request* req, int result) {
+  DCHECK(CalledOnValidThread());
+  size_t erased = requests_.erase(req);
+  DCHECK_EQ(1u, erased);
+  CompletionCallback* callback = req->callback();
+  delete req;
+  callback->Run(result);
+}
+
+}  // namespace net
@@ -0,0 +1,138 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_BASE_ASYNC_DNS_RESOLVER_H_
+#define NET_BASE_ASYNC_DNS_RESOLVER_H_
+#pragma once
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "base/threading/non_thread_safe.h"
+#include "net/base/address_family.h"
+#include "net/base/completion_callback.h"
+#include "net/base/dns_config.h"
+
+namespace net {
+
+class AddressList;
+class NetLog;
+struct RRResponse;
+
+// A stub resolver that runs on the IO thread, instead of blocking a worker
+// thread in getaddrinfo() for each lookup.  Names are answered from the hosts
+// file, or by querying the name servers of a DnsConfig over UDP.  For names
+// that aren't fully qualified, the search suffixes are tried in turn as the
+// system resolver would.  The A and AAAA queries for a name go out in
+// parallel.  A query that isn't answered in time is sent again, to the next
+// name server, with the timeout doubled each time all servers have been
+// tried.
+//
+// Records of other types can be looked up too, for DnsRRResolver.
+//
+// There are no threads involved, so the number of lookups in flight is only
+// limited by the number of sockets.
+//
+// This class is not thread-safe, and must only be used on one IO thread.
+class AsyncDnsResolver : public base::NonThreadSafe {
+ public:
+  class Request;
+
+  // |net_log| is used for the sockets, and may be NULL.
+  explicit AsyncDnsResolver(NetLog* net_log);
+
+  // Outstanding requests are cancelled, and their callbacks are not run.
+  ~AsyncDnsResolver();
+
+  // Reads the system configuration on a worker thread, and starts using it
+  // once it has been read.  Until then, or if there is no configuration to use,
+  // the resolver is not ready.
+  void LoadSystemConfig();
+
+  // Replaces the configuration used for requests started from now on.
+  void SetConfig(const DnsConfig& config, const DnsHosts& hosts);
+
+  // Returns true once there is a name server to send queries to.
+  bool IsReady() const { return !config_.nameservers.empty(); }
+
+  // Resolves |hostname|, which must not be an IP literal, to addresses in
+  // |address_family|.  The ports of the addresses are 0.  Returns OK if the
+  // name is in the hosts file.  Otherwise returns ERR_IO_PENDING and runs
+  // |callback| with the result later, unless the request fails synchronously.
+  // If |out_req| is non-NULL, it's set to a handle for CancelRequest().
+  //
+  // ERR_NAME_NOT_RESOLVED means that the name doesn't exist.  Any other error
+  // means that the name servers couldn't be used to resolve it, and the
+  // caller may want to try another resolver.
+  int Resolve(const std::string& hostname,
+              AddressFamily address_family,
+              AddressList* addresses,
+              CompletionCallback* callback,
+              Request** out_req);
+
+  // Looks up the records of each type in |rrtypes| for |name|, which is taken
+  // to be fully qualified, with all the queries in flight at once.  Returns
+  // ERR_IO_PENDING and runs |callback| once every query is done, unless they
+  // all finish synchronously, in which case OK is returned.  The result of
+  // each query is then in |results|, and its records in |responses|, in the
+  // order of |rrtypes|.  A result of ERR_NAME_NOT_RESOLVED means there are no
+  // records of that type.  If |out_req| is non-NULL, it's set to a handle for
+  // CancelRequest().
+  int ResolveRecords(const std::string& name,
+                     const std::vector<uint16>& rrtypes,
+                     std::vector<int>* results,
+                     std::vector<RRResponse>* responses,
+                     CompletionCallback* callback,
+                     Request** out_req);
+
+  // Cancels |req|, whose callback will not be run.
+  void CancelRequest(Request* req);
+
+ private:
+  class ConfigLoader;
+  class Transaction;
+
+  // Fills in |addresses| from the hosts file.  Returns false if |hostname| is
+  // not listed for |address_family|.
+  bool LookupHosts(const std::string& hostname, AddressFamily address_family,
+                   AddressList* addresses) const;
+
+  // Returns the names to query for |hostname|, in the order to try them.
+  void GetQueryNames(const std::string& hostname,
+                     std::vector<std::string>* names) const;
+
+  // Returns the index of the name server to send the next query to first.
+  size_t NextServerIndex();
+
+  // Called by ConfigLoader once the system configuration has been read.
+  void OnConfigLoaded(bool succeeded, const DnsConfig& config,
+                      const DnsHosts& hosts);
+
+  // Starts |req|, and keeps track of it if it doesn't finish synchronously.
+  int StartRequest(Request* req, Request** out_req);
+
+  // Called by |req| once it has completed asynchronously.
+  void OnRequestComplete(Request* req, int result);
+
+  DnsConfig config_;
+  DnsHosts hosts_;
+
+  // Incremented for every transaction, when the configuration asks for
+  // rotation between the name servers.
+  size_t next_server_;
+
+  std::set<Request*> requests_;
+  scoped_refptr<ConfigLoader> config_loader_;
+
+  NetLog* const net_log_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncDnsResolver);
+};
+
+}  // namespace net
+
+#endif  // NET_BASE_ASYNC_DNS_RESOLVER_H_
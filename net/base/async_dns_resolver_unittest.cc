@@ -0,0 +1,451 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/async_dns_resolver.h"
+
+#include <map>
+#include <utility>
+
+#include "base/compiler_specific.h"
+#include "base/message_loop.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/task.h"
+#include "net/base/address_list.h"
+#include "net/base/dns_util.h"
+#include "net/base/dnsrr_resolver.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_util.h"
+#include "net/base/sys_addrinfo.h"
+#include "net/base/test_completion_callback.h"
+#include "net/udp/udp_server_socket.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const uint16 kRcodeNameError = 3;
+const uint16 kRcodeServerFailure = 2;
+
+void AppendU16(uint16 value, std::string* out) {
+  out->push_back(static_cast<char>(value >> 8));
+  out->push_back(static_cast<char>(value & 0xff));
+}
+
+// A name server on the loopback interface, answering from a table of records.
+// Names it knows nothing about are NXDOMAIN.
+class FakeDnsServer {
+ public:
+  FakeDnsServer()
+      : socket_(NULL, NetLog::Source()),
+        buffer_(new IOBufferWithSize(512)),
+        silent_(false),
+        num_queries_(0),
+        ALLOW_THIS_IN_INITIALIZER_LIST(
+            read_callback_(this, &FakeDnsServer::OnReadComplete)) {
+  }
+
+  void Start() {
+    IPAddressNumber loopback;
+    ASSERT_TRUE(ParseIPLiteralToNumber("127.0.0.1", &loopback));
+    ASSERT_EQ(OK, socket_.Listen(IPEndPoint(loopback, 0)));
+    ASSERT_EQ(OK, socket_.GetLocalAddress(&address_));
+    Read();
+  }
+
+  // Answers queries for |name| and |qtype| with the comma separated
+  // |addresses|, or with |rcode| if it isn't 0.
+  void AddAnswer(const std::string& name, uint16 qtype,
+                 const std::string& addresses, uint16 rcode) {
+    Answer& answer = answers_[std::make_pair(name, qtype)];
+    answer.rcode = rcode;
+    answer.truncated = false;
+    std::string::size_type start = 0;
+    while (start < addresses.size()) {
+      std::string::size_type end = addresses.find(',', start);
+      if (end == std::string::npos)
+        end = addresses.size();
+      IPAddressNumber address;
+      EXPECT_TRUE(ParseIPLiteralToNumber(
+          addresses.substr(start, end - start), &address));
+      answer.rdatas.push_back(std::string(address.begin(), address.end()));
+      start = end + 1;
+    }
+  }
+
+  // Adds a record with |rdata| to the answers for |name| and |qtype|.
+  void AddRecord(const std::string& name, uint16 qtype,
+                 const std::string& rdata) {
+    Answer& answer = answers_[std::make_pair(name, qtype)];
+    answer.rcode = 0;
+    answer.truncated = false;
+    answer.rdatas.push_back(rdata);
+  }
+
+  // Sets the TC bit in the answers for |name| and |qtype|.
+  void AddTruncatedAnswer(const std::string& name, uint16 qtype) {
+    Answer& answer = answers_[std::make_pair(name, qtype)];
+    answer.rcode = 0;
+    answer.truncated = true;
+  }
+
+  // Keeps the server from answering anything.
+  void set_silent(bool silent) { silent_ = silent; }
+
+  const IPEndPoint& address() const { return address_; }
+  int num_queries() const { return num_queries_; }
+
+ private:
+  struct Answer {
+    uint16 rcode;
+    bool truncated;
+    std::vector<std::string> rdatas;
+  };
+  typedef std::map<std::pair<std::string, uint16>, Answer> AnswerMap;
+
+  void Read() {
+    while (true) {
+      int rv = socket_.RecvFrom(buffer_, buffer_->size(), &peer_address_,
+                                &read_callback_);
+      if (rv == ERR_IO_PENDING)
+        return;
+      if (rv < 0)
+        return;
+      HandleQuery(rv);
+    }
+  }
+
+  void OnReadComplete(int result) {
+    if (result < 0)
+      return;
+    HandleQuery(result);
+    Read();
+  }
+
+  void HandleQuery(int len) {
+    num_queries_++;
+    if (silent_)
+      return;
+
+    // Pull the name and type out of the question of the query.
+    std::string query(buffer_->data(), len);
+    std::string name;
+    size_t pos = 12;
+    while (pos < query.size() && query[pos] != 0) {
+      size_t label_len = static_cast<uint8>(query[pos]);
+      if (!name.empty())
+        name.push_back('.');
+      name.append(query, pos + 1, label_len);
+      pos += label_len + 1;
+    }
+    ASSERT_LE(pos + 5, query.size());
+    uint16 qtype = (static_cast<uint8>(query[pos + 1]) << 8) |
+                   static_cast<uint8>(query[pos + 2]);
+
+    Answer answer;
+    answer.rcode = kRcodeNameError;
+    answer.truncated = false;
+    AnswerMap::const_iterator it = answers_.find(std::make_pair(name, qtype));
+    if (it != answers_.end())
+      answer = it->second;
+
+    std::string response(query, 0, 2);
+    AppendU16(0x8180 | answer.rcode | (answer.truncated ? 0x0200 : 0),
+              &response);
+    AppendU16(1, &response);
+    AppendU16(static_cast<uint16>(answer.rdatas.size()), &response);
+    AppendU16(0, &response);
+    AppendU16(0, &response);
+    response.append(query, 12, pos + 5 - 12);
+    for (size_t i = 0; i < answer.rdatas.size(); ++i) {
+      const std::string& rdata = answer.rdatas[i];
+      AppendU16(0xc00c, &response);  // A pointer to the question's name.
+      AppendU16(qtype, &response);
+      AppendU16(kClassIN, &response);
+      AppendU16(0, &response);
+      AppendU16(60, &response);
+      AppendU16(static_cast<uint16>(rdata.size()), &response);
+      response.append(rdata);
+    }
+
+    scoped_refptr<StringIOBuffer> buf(new StringIOBuffer(response));
+    TestCompletionCallback callback;
+    int rv = socket_.SendTo(buf, buf->size(), peer_address_, &callback);
+    EXPECT_EQ(static_cast<int>(response.size()), callback.GetResult(rv));
+  }
+
+  UDPServerSocket socket_;
+  IPEndPoint address_;
+  IPEndPoint peer_address_;
+  scoped_refptr<IOBufferWithSize> buffer_;
+  AnswerMap answers_;
+  bool silent_;
+  int num_queries_;
+  CompletionCallbackImpl<FakeDnsServer> read_callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(FakeDnsServer);
+};
+
+class AsyncDnsResolverTest : public testing::Test {
+ protected:
+  AsyncDnsResolverTest() : resolver_(NULL) {}
+
+  virtual void SetUp() {
+    server_.Start();
+    config_.nameservers.push_back(server_.address());
+    config_.timeout = base::TimeDelta::FromMilliseconds(100);
+    config_.attempts = 1;
+  }
+
+  void ApplyConfig() {
+    resolver_.SetConfig(config_, hosts_);
+  }
+
+  // Returns the addresses in |addresses| as a comma separated string.
+  static std::string ToString(const AddressList& addresses) {
+    std::string result;
+    for (const struct addrinfo* ai = addresses.head(); ai; ai = ai->ai_next) {
+      if (!result.empty())
+        result.push_back(',');
+      result.append(NetAddressToString(ai));
+    }
+    return result;
+  }
+
+  FakeDnsServer server_;
+  DnsConfig config_;
+  DnsHosts hosts_;
+  AsyncDnsResolver resolver_;
+};
+
+TEST_F(AsyncDnsResolverTest, NotReady) {
+  EXPECT_FALSE(resolver_.IsReady());
+  AddressList addresses;
+  TestCompletionCallback callback;
+  EXPECT_EQ(ERR_NAME_RESOLUTION_FAILED,
+            resolver_.Resolve("www.example.com", ADDRESS_FAMILY_UNSPECIFIED,
+                              &addresses, &callback, NULL));
+}
+
+TEST_F(AsyncDnsResolverTest, Hosts) {
+  IPAddressNumber address;
+  ASSERT_TRUE(ParseIPLiteralToNumber("10.0.0.1", &address));
+  hosts_[DnsHostsKey("myhost", ADDRESS_FAMILY_IPV4)] = address;
+  ApplyConfig();
+  ASSERT_TRUE(resolver_.IsReady());
+
+  AddressList addresses;
+  TestCompletionCallback callback;
+  EXPECT_EQ(OK, resolver_.Resolve("MyHost.", ADDRESS_FAMILY_UNSPECIFIED,
+                                  &addresses, &callback, NULL));
+  EXPECT_EQ("10.0.0.1", ToString(addresses));
+  EXPECT_EQ(0, server_.num_queries());
+
+  // The hosts file has no IPv6 address for the name, so it's sent on.
+  EXPECT_EQ(ERR_IO_PENDING,
+            resolver_.Resolve("myhost", ADDRESS_FAMILY_IPV6, &addresses,
+                              &callback, NULL));
+  EXPECT_EQ(ERR_NAME_NOT_RESOLVED, callback.WaitForResult());
+}
+
+TEST_F(AsyncDnsResolverTest, BothFamilies) {
+  server_.AddAnswer("www.example.com", kDNS_A, "10.0.0.1,10.0.0.2", 0);
+  server_.AddAnswer("www.example.com", kDNS_AAAA, "2001:db8::1", 0);
+  ApplyConfig();
+
+  AddressList addresses;
+  TestCompletionCallback callback;
+  ASSERT_EQ(ERR_IO_PENDING,
+            resolver_.Resolve("www.example.com", ADDRESS_FAMILY_UNSPECIFIED,
+                              &addresses, &callback, NULL));
+  EXPECT_EQ(OK, callback.WaitForResult());
+  // The IPv6 addresses come first.
+  EXPECT_EQ("2001:db8::1,10.0.0.1,10.0.0.2", ToString(addresses));
+  EXPECT_EQ(2, server_.num_queries());
+}
+
+TEST_F(AsyncDnsResolverTest, SingleFamily) {
+  server_.AddAnswer("www.example.com", kDNS_A, "10.0.0.1", 0);
+  server_.AddAnswer("www.example.com", kDNS_AAAA, "2001:db8::1", 0);
+  ApplyConfig();
+
+  AddressList addresses;
+  TestCompletionCallback callback;
+  ASSERT_EQ(ERR_IO_PENDING,
+            resolver_.Resolve("www.example.com", ADDRESS_FAMILY_IPV4,
+                              &addresses, &callback, NULL));
+  EXPECT_EQ(OK, callback.WaitForResult());
+  EXPECT_EQ("10.0.0.1", ToString(addresses));
+  EXPECT_EQ(1, server_.num_queries());
+}
+
+TEST_F(AsyncDnsResolverTest, OneFamilyMissing) {
+  // No AAAA record is an answer too, as long as there is an A record.
+  server_.AddAnswer("www.example.com", kDNS_A, "10.0.0.1", 0);
+  ApplyConfig();
+
+  AddressList addresses;
+  TestCompletionCallback callback;
+  ASSERT_EQ(ERR_IO_PENDING,
+            resolver_.Resolve("www.example.com", ADDRESS_FAMILY_UNSPECIFIED,
+                              &addresses, &callback, NULL));
+  EXPECT_EQ(OK, callback.WaitForResult());
+  EXPECT_EQ("10.0.0.1", ToString(addresses));
+}
+
+TEST_F(AsyncDnsResolverTest, NameNotFound) {
+  ApplyConfig();
+
+  AddressList addresses;
+  TestCompletionCallback callback;
+  ASSERT_EQ(ERR_IO_PENDING,
+            resolver_.Resolve("nowhere.example.com", ADDRESS_FAMILY_UNSPECIFIED,
+                              &addresses, &callback, NULL));
+  EXPECT_EQ(ERR_NAME_NOT_RESOLVED, callback.WaitForResult());
+}
+
+TEST_F(AsyncDnsResolverTest, SearchSuffixes) {
+  config_.search.push_back("corp.example.com");
+  config_.search.push_back("example.com");
+  server_.AddAnswer("www.example.com", kDNS_A, "10.0.0.1", 0);
+  ApplyConfig();
+
+  // "www" has fewer than |ndots| dots, so the suffixes are tried first.
+  AddressList addresses;
+  TestCompletionCallback callback;
+  ASSERT_EQ(ERR_IO_PENDING,
+            resolver_.Resolve("www", ADDRESS_FAMILY_IPV4, &addresses,
+                              &callback, NULL));
+  EXPECT_EQ(OK, callback.WaitForResult());
+  EXPECT_EQ("10.0.0.1", ToString(addresses));
+  EXPECT_EQ(2, server_.num_queries());
+
+  // A trailing dot keeps the suffixes from being tried.
+  ASSERT_EQ(ERR_IO_PENDING,
+            resolver_.Resolve("www.", ADDRESS_FAMILY_IPV4, &addresses,
+                              &callback, NULL));
+  EXPECT_EQ(ERR_NAME_NOT_RESOLVED, callback.WaitForResult());
+  EXPECT_EQ(3, server_.num_queries());
+}
+
+TEST_F(AsyncDnsResolverTest, ServerFailure) {
+  server_.AddAnswer("www.example.com", kDNS_A, "", kRcodeServerFailure);
+  ApplyConfig();
+
+  AddressList addresses;
+  TestCompletionCallback callback;
+  ASSERT_EQ(ERR_IO_PENDING,
+            resolver_.Resolve("www.example.com", ADDRESS_FAMILY_IPV4,
+                              &addresses, &callback, NULL));
+  EXPECT_EQ(ERR_DNS_SERVER_FAILED, callback.WaitForResult());
+}
+
+TEST_F(AsyncDnsResolverTest, Truncated) {
+  server_.AddTruncatedAnswer("www.example.com", kDNS_A);
+  ApplyConfig();
+
+  AddressList addresses;
+  TestCompletionCallback callback;
+  ASSERT_EQ(ERR_IO_PENDING,
+            resolver_.Resolve("www.example.com", ADDRESS_FAMILY_IPV4,
+                              &addresses, &callback, NULL));
+  EXPECT_EQ(ERR_DNS_SERVER_REQUIRES_TCP, callback.WaitForResult());
+}
+
+TEST_F(AsyncDnsResolverTest, TimeoutMovesToNextServer) {
+  FakeDnsServer second_server;
+  second_server.Start();
+  second_server.AddAnswer("www.example.com", kDNS_A, "10.0.0.1", 0);
+  server_.set_silent(true);
+  config_.nameservers.push_back(second_server.address());
+  ApplyConfig();
+
+  AddressList addresses;
+  TestCompletionCallback callback;
+  ASSERT_EQ(ERR_IO_PENDING,
+            resolver_.Resolve("www.example.com", ADDRESS_FAMILY_IPV4,
+                              &addresses, &callback, NULL));
+  EXPECT_EQ(OK, callback.WaitForResult());
+  EXPECT_EQ("10.0.0.1", ToString(addresses));
+  EXPECT_EQ(1, server_.num_queries());
+  EXPECT_EQ(1, second_server.num_queries());
+}
+
+TEST_F(AsyncDnsResolverTest, TimedOut) {
+  server_.set_silent(true);
+  config_.attempts = 2;
+  ApplyConfig();
+
+  AddressList addresses;
+  TestCompletionCallback callback;
+  ASSERT_EQ(ERR_IO_PENDING,
+            resolver_.Resolve("www.example.com", ADDRESS_FAMILY_IPV4,
+                              &addresses, &callback, NULL));
+  EXPECT_EQ(ERR_DNS_TIMED_OUT, callback.WaitForResult());
+  EXPECT_EQ(2, server_.num_queries());
+}
+
+TEST_F(AsyncDnsResolverTest, ResolveRecords) {
+  server_.AddRecord("www.example.com", kDNS_TXT, "\x05hello");
+  server_.AddRecord("www.example.com", kDNS_TXT, "\x05world");
+  ApplyConfig();
+
+  std::vector<uint16> rrtypes;
+  rrtypes.push_back(kDNS_TXT);
+  rrtypes.push_back(kDNS_CERT);
+  std::vector<int> results;
+  std::vector<RRResponse> responses;
+  TestCompletionCallback callback;
+  ASSERT_EQ(ERR_IO_PENDING,
+            resolver_.ResolveRecords("www.example.com", rrtypes, &results,
+                                     &responses, &callback, NULL));
+  EXPECT_EQ(OK, callback.WaitForResult());
+  // Both queries went out together, and each has its own result.
+  EXPECT_EQ(2, server_.num_queries());
+  ASSERT_EQ(2u, results.size());
+  ASSERT_EQ(2u, responses.size());
+  EXPECT_EQ(OK, results[0]);
+  EXPECT_EQ("www.example.com", responses[0].name);
+  EXPECT_EQ(60u, responses[0].ttl);
+  ASSERT_EQ(2u, responses[0].rrdatas.size());
+  EXPECT_EQ("\x05hello", responses[0].rrdatas[0]);
+  EXPECT_EQ("\x05world", responses[0].rrdatas[1]);
+  EXPECT_EQ(ERR_NAME_NOT_RESOLVED, results[1]);
+  EXPECT_TRUE(responses[1].rrdatas.empty());
+
+  // Names aren't expanded with the search suffixes.
+  config_.search.push_back("example.com");
+  ApplyConfig();
+  ASSERT_EQ(ERR_IO_PENDING,
+            resolver_.ResolveRecords("www", rrtypes, &results, &responses,
+                                     &callback, NULL));
+  EXPECT_EQ(OK, callback.WaitForResult());
+  EXPECT_EQ(ERR_NAME_NOT_RESOLVED, results[0]);
+  EXPECT_EQ(4, server_.num_queries());
+}
+
+TEST_F(AsyncDnsResolverTest, Cancel) {
+  server_.set_silent(true);
+  ApplyConfig();
+
+  AddressList addresses;
+  TestCompletionCallback callback;
+  AsyncDnsResolver::Request* req = NULL;
+  ASSERT_EQ(ERR_IO_PENDING,
+            resolver_.Resolve("www.example.com", ADDRESS_FAMILY_IPV4,
+                              &addresses, &callback, &req));
+  ASSERT_TRUE(req);
+  resolver_.CancelRequest(req);
+
+  // Past the timeout, nothing should have run.
+  MessageLoop::current()->PostDelayedTask(FROM_HERE, new MessageLoop::QuitTask,
+                                          300);
+  MessageLoop::current()->Run();
+  EXPECT_FALSE(callback.have_result());
+}
+
+}  // namespace
+
+}  // namespace net
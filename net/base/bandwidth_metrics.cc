@@ -25,11 +25,15 @@ void ScopedBandwidthMetrics::StartStream() {
 }
 
 void ScopedBandwidthMetrics::StopStream() {
+  if (!started_)
+    return;
   started_ = false;
   g_bandwidth_metrics.Get().StopStream();
 }
 
 void ScopedBandwidthMetrics::RecordBytes(int bytes) {
+  if (!started_)
+    return;
   g_bandwidth_metrics.Get().RecordBytes(bytes);
 }
 
@@ -11,6 +11,7 @@
 #include "base/metrics/histogram.h"
 #include "base/logging.h"
 #include "base/time.h"
+#include "net/base/network_quality_estimator.h"
 
 namespace net {
 
@@ -97,6 +98,7 @@ class BandwidthMetrics {
                   << "Kbps (avg " << bandwidth() << "Kbps)";
         int kbps_int = static_cast<int>(kbps);
         UMA_HISTOGRAM_COUNTS_10000("Net.DownloadBandwidth", kbps_int);
+        NetworkQualityEstimator::GetInstance()->AddThroughputSample(kbps);
       }
     }
   }
@@ -118,7 +120,8 @@ class BandwidthMetrics {
 
 // A utility class for managing the lifecycle of a measured stream.
 // It is important that we not leave unclosed streams, and this class helps
-// ensure we always stop them.
+// ensure we always stop them.  Bytes recorded and stops while the stream
+// isn't started are ignored.
 class ScopedBandwidthMetrics {
  public:
   ScopedBandwidthMetrics();
@@ -4,8 +4,13 @@
 
 #include "net/base/cert_verifier.h"
 
+#include <string.h>
+
+#include <vector>
+
 #include "base/compiler_specific.h"
 #include "base/message_loop.h"
+#include "base/pickle.h"
 #include "base/stl_util-inl.h"
 #include "base/synchronization/lock.h"
 #include "base/threading/worker_pool.h"
@@ -62,9 +67,13 @@ namespace net {
 // The number of CachedCertVerifyResult objects that we'll cache.
 static const unsigned kMaxCacheEntries = 256;
 
-// The number of seconds for which we'll cache a cache entry.
+// The number of seconds for which we'll cache a cache entry, which bounds
+// how stale the revocation status of a cached result can be.
 static const unsigned kTTLSecs = 1800;  // 30 minutes.
 
+// Bump this whenever the format written by SerializeCache() changes.
+static const int kCacheFormatVersion = 1;
+
 namespace {
 
 class DefaultTimeService : public CertVerifier::TimeService {
@@ -318,7 +327,7 @@ int CertVerifier::Verify(X509Certificate* cert,
 
   requests_++;
 
-  const RequestParams key = {cert->fingerprint(), hostname, flags};
+  const RequestParams key = {cert->chain_fingerprint(), hostname, flags};
   // First check the cache.
   std::map<RequestParams, CachedCertVerifyResult>::iterator i;
   i = cache_.find(key);
@@ -400,13 +409,40 @@ void CertVerifier::HandleResult(X509Certificate* cert,
   cached_result.result = verify_result;
   uint32 ttl = kTTLSecs;
   cached_result.expiry = current_time + base::TimeDelta::FromSeconds(ttl);
+  // The result changes when the certificate becomes valid or expires.
+  const base::Time validity_changes[] = {
+    cert->valid_start(), cert->valid_expiry()
+  };
+  for (size_t i = 0; i < arraysize(validity_changes); ++i) {
+    if (validity_changes[i] > current_time &&
+        validity_changes[i] < cached_result.expiry) {
+      cached_result.expiry = validity_changes[i];
+    }
+  }
+
+  const RequestParams key = {cert->chain_fingerprint(), hostname, flags};
+  AddToCache(key, cached_result);
+
+  std::map<RequestParams, CertVerifierJob*>::iterator j;
+  j = inflight_.find(key);
+  if (j == inflight_.end()) {
+    NOTREACHED();
+    return;
+  }
+  CertVerifierJob* job = j->second;
+  inflight_.erase(j);
 
-  const RequestParams key = {cert->fingerprint(), hostname, flags};
+  job->HandleResult(cached_result);
+  delete job;
+}
 
+void CertVerifier::AddToCache(const RequestParams& key,
+                              const CachedCertVerifyResult& result) {
   DCHECK_GE(kMaxCacheEntries, 1u);
   DCHECK_LE(cache_.size(), kMaxCacheEntries);
   if (cache_.size() == kMaxCacheEntries) {
     // Need to remove an element of the cache.
+    const base::Time current_time(time_service_->Now());
     std::map<RequestParams, CachedCertVerifyResult>::iterator i, cur;
     for (i = cache_.begin(); i != cache_.end(); ) {
       cur = i++;
@@ -420,19 +456,125 @@ void CertVerifier::HandleResult(X509Certificate* cert,
     cache_.erase(cache_.begin());
   }
 
-  cache_.insert(std::make_pair(key, cached_result));
+  cache_.insert(std::make_pair(key, result));
+}
 
-  std::map<RequestParams, CertVerifierJob*>::iterator j;
-  j = inflight_.find(key);
-  if (j == inflight_.end()) {
-    NOTREACHED();
-    return;
+void CertVerifier::SerializeCache(Pickle* pickle) const {
+  DCHECK(CalledOnValidThread());
+
+  const base::Time current_time(time_service_->Now());
+  std::vector<std::map<RequestParams, CachedCertVerifyResult>::const_iterator>
+      fresh;
+  for (std::map<RequestParams, CachedCertVerifyResult>::const_iterator i =
+           cache_.begin(); i != cache_.end(); ++i) {
+    if (!i->second.HasExpired(current_time))
+      fresh.push_back(i);
   }
-  CertVerifierJob* job = j->second;
-  inflight_.erase(j);
 
-  job->HandleResult(cached_result);
-  delete job;
+  pickle->WriteInt(kCacheFormatVersion);
+  pickle->WriteInt(static_cast<int>(fresh.size()));
+  for (size_t i = 0; i < fresh.size(); ++i) {
+    const RequestParams& key = fresh[i]->first;
+    const CachedCertVerifyResult& cached = fresh[i]->second;
+    pickle->WriteBytes(key.chain_fingerprint.data,
+                       sizeof(key.chain_fingerprint.data));
+    pickle->WriteString(key.hostname);
+    pickle->WriteInt(key.flags);
+    pickle->WriteInt(cached.error);
+    pickle->WriteInt64(cached.expiry.ToInternalValue());
+
+    const CertVerifyResult& result = cached.result;
+    pickle->WriteInt(result.cert_status);
+    pickle->WriteBool(result.has_md5);
+    pickle->WriteBool(result.has_md2);
+    pickle->WriteBool(result.has_md4);
+    pickle->WriteBool(result.has_md5_ca);
+    pickle->WriteBool(result.has_md2_ca);
+    pickle->WriteBool(result.is_issued_by_known_root);
+    pickle->WriteInt(static_cast<int>(result.public_key_hashes.size()));
+    for (size_t j = 0; j < result.public_key_hashes.size(); ++j) {
+      pickle->WriteBytes(result.public_key_hashes[j].data,
+                         sizeof(result.public_key_hashes[j].data));
+    }
+  }
+}
+
+namespace {
+
+bool ReadFingerprint(const Pickle& pickle, void** iter,
+                     SHA1Fingerprint* fingerprint) {
+  const char* data;
+  if (!pickle.ReadBytes(iter, &data, sizeof(fingerprint->data)))
+    return false;
+  memcpy(fingerprint->data, data, sizeof(fingerprint->data));
+  return true;
+}
+
+}  // namespace
+
+bool CertVerifier::DeserializeCache(const Pickle& pickle) {
+  DCHECK(CalledOnValidThread());
+
+  void* iter = NULL;
+  int version;
+  int count;
+  if (!pickle.ReadInt(&iter, &version) ||
+      version != kCacheFormatVersion ||
+      !pickle.ReadLength(&iter, &count)) {
+    return false;
+  }
+
+  // Read everything before adding any, so that a truncated pickle adds
+  // nothing.
+  std::vector<std::pair<RequestParams, CachedCertVerifyResult> > read;
+  bool ok = true;
+  for (int i = 0; ok && i < count; ++i) {
+    RequestParams key;
+    CachedCertVerifyResult cached;
+    CertVerifyResult& result = cached.result;
+    int64 expiry;
+    int hash_count;
+    ok = ReadFingerprint(pickle, &iter, &key.chain_fingerprint) &&
+         pickle.ReadString(&iter, &key.hostname) &&
+         pickle.ReadInt(&iter, &key.flags) &&
+         pickle.ReadInt(&iter, &cached.error) &&
+         pickle.ReadInt64(&iter, &expiry) &&
+         pickle.ReadInt(&iter, &result.cert_status) &&
+         pickle.ReadBool(&iter, &result.has_md5) &&
+         pickle.ReadBool(&iter, &result.has_md2) &&
+         pickle.ReadBool(&iter, &result.has_md4) &&
+         pickle.ReadBool(&iter, &result.has_md5_ca) &&
+         pickle.ReadBool(&iter, &result.has_md2_ca) &&
+         pickle.ReadBool(&iter, &result.is_issued_by_known_root) &&
+         pickle.ReadLength(&iter, &hash_count);
+    for (int j = 0; ok && j < hash_count; ++j) {
+      SHA1Fingerprint hash;
+      ok = ReadFingerprint(pickle, &iter, &hash);
+      result.public_key_hashes.push_back(hash);
+    }
+    if (ok) {
+      cached.expiry = base::Time::FromInternalValue(expiry);
+      read.push_back(std::make_pair(key, cached));
+    }
+  }
+  if (!ok)
+    return false;
+
+  // A result can only expire later than one cached now would if it was
+  // written with a clock that has since gone back, and then it can't be
+  // trusted to be fresh.
+  const base::Time current_time(time_service_->Now());
+  const base::Time latest_expiry =
+      current_time + base::TimeDelta::FromSeconds(kTTLSecs);
+  for (size_t i = 0; i < read.size(); ++i) {
+    const CachedCertVerifyResult& cached = read[i].second;
+    if (cached.HasExpired(current_time) || cached.expiry > latest_expiry ||
+        cache_.find(read[i].first) != cache_.end()) {
+      continue;
+    }
+    AddToCache(read[i].first, cached);
+  }
+  return true;
 }
 
 void CertVerifier::OnCertTrustChanged(const X509Certificate* cert) {
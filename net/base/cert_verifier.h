@@ -19,6 +19,8 @@
 #include "net/base/net_export.h"
 #include "net/base/x509_cert_types.h"
 
+class Pickle;
+
 namespace net {
 
 class CertVerifierJob;
@@ -112,6 +114,16 @@ class NET_EXPORT CertVerifier : public base::NonThreadSafe,
   // Clears the verification result cache.
   void ClearCache();
 
+  // Writes the unexpired cached results to |pickle|, so that an embedder can
+  // keep them across runs rather than verify every chain again after a
+  // restart.
+  void SerializeCache(Pickle* pickle) const;
+
+  // Adds the results written by SerializeCache() that are still fresh.
+  // Results already in the cache are kept.  Returns false, without adding
+  // any, if |pickle| is malformed.
+  bool DeserializeCache(const Pickle& pickle);
+
   size_t GetCacheSize() const;
 
   uint64 requests() const { return requests_; }
@@ -124,29 +136,30 @@ class NET_EXPORT CertVerifier : public base::NonThreadSafe,
   // Input parameters of a certificate verification request.
   struct RequestParams {
     bool operator==(const RequestParams& other) const {
-      // |flags| is compared before |cert_fingerprint| and |hostname| under
+      // |flags| is compared before |chain_fingerprint| and |hostname| under
       // assumption that integer comparisons are faster than memory and string
       // comparisons.
       return (flags == other.flags &&
-              memcmp(cert_fingerprint.data, other.cert_fingerprint.data,
-                     sizeof(cert_fingerprint.data)) == 0 &&
+              memcmp(chain_fingerprint.data, other.chain_fingerprint.data,
+                     sizeof(chain_fingerprint.data)) == 0 &&
               hostname == other.hostname);
     }
 
     bool operator<(const RequestParams& other) const {
-      // |flags| is compared before |cert_fingerprint| and |hostname| under
+      // |flags| is compared before |chain_fingerprint| and |hostname| under
       // assumption that integer comparisons are faster than memory and string
       // comparisons.
       if (flags != other.flags)
         return flags < other.flags;
-      int rv = memcmp(cert_fingerprint.data, other.cert_fingerprint.data,
-                      sizeof(cert_fingerprint.data));
+      int rv = memcmp(chain_fingerprint.data, other.chain_fingerprint.data,
+                      sizeof(chain_fingerprint.data));
       if (rv != 0)
         return rv < 0;
       return hostname < other.hostname;
     }
 
-    SHA1Fingerprint cert_fingerprint;
+    // The certificate and its intermediates, as the result depends on both.
+    SHA1Fingerprint chain_fingerprint;
     std::string hostname;
     int flags;
   };
@@ -160,6 +173,10 @@ class NET_EXPORT CertVerifier : public base::NonThreadSafe,
   // CertDatabase::Observer methods:
   virtual void OnCertTrustChanged(const X509Certificate* cert);
 
+  // Adds |result| for |key| to the cache, making room if it is full.
+  void AddToCache(const RequestParams& key,
+                  const CachedCertVerifyResult& result);
+
   // cache_ maps from a request to a cached result. The cached result may
   // have expired and the size of |cache_| must be <= kMaxCacheEntries.
   std::map<RequestParams, CachedCertVerifyResult> cache_;
@@ -6,6 +6,7 @@
 
 #include "base/callback.h"
 #include "base/file_path.h"
+#include "base/pickle.h"
 #include "base/stringprintf.h"
 #include "net/base/cert_test_util.h"
 #include "net/base/net_errors.h"
@@ -223,6 +224,73 @@ TEST_F(CertVerifierTest, FullCache) {
   ASSERT_EQ(0u, verifier.inflight_joins());
 }
 
+// Tests that a serialized cache gives hits in another verifier, as long as its
+// entries haven't expired.
+TEST_F(CertVerifierTest, SerializeCache) {
+  TestTimeService* time_service = new TestTimeService;
+  base::Time current_time = base::Time::Now();
+  time_service->set_current_time(current_time);
+  CertVerifier verifier(time_service);
+
+  FilePath certs_dir = GetTestCertsDirectory();
+  scoped_refptr<X509Certificate> google_cert(
+      ImportCertFromFile(certs_dir, "google.single.der"));
+  ASSERT_NE(static_cast<X509Certificate*>(NULL), google_cert);
+
+  int error;
+  CertVerifyResult verify_result;
+  TestCompletionCallback callback;
+  CertVerifier::RequestHandle request_handle;
+
+  error = verifier.Verify(google_cert, "www.example.com", 0, &verify_result,
+                          &callback, &request_handle);
+  ASSERT_EQ(ERR_IO_PENDING, error);
+  error = callback.WaitForResult();
+  ASSERT_TRUE(IsCertificateError(error));
+  ASSERT_EQ(1u, verifier.GetCacheSize());
+
+  Pickle pickle;
+  verifier.SerializeCache(&pickle);
+
+  TestTimeService* restored_time_service = new TestTimeService;
+  restored_time_service->set_current_time(current_time);
+  CertVerifier restored(restored_time_service);
+  ASSERT_TRUE(restored.DeserializeCache(pickle));
+  ASSERT_EQ(1u, restored.GetCacheSize());
+
+  CertVerifyResult restored_result;
+  int restored_error = restored.Verify(google_cert, "www.example.com", 0,
+                                       &restored_result, &callback,
+                                       &request_handle);
+  // Synchronous completion.
+  ASSERT_EQ(error, restored_error);
+  ASSERT_TRUE(request_handle == NULL);
+  ASSERT_EQ(1u, restored.cache_hits());
+  EXPECT_EQ(verify_result.cert_status, restored_result.cert_status);
+  EXPECT_EQ(verify_result.is_issued_by_known_root,
+            restored_result.is_issued_by_known_root);
+  EXPECT_EQ(verify_result.public_key_hashes.size(),
+            restored_result.public_key_hashes.size());
+
+  // Expired entries aren't restored.
+  TestTimeService* late_time_service = new TestTimeService;
+  late_time_service->set_current_time(
+      current_time + base::TimeDelta::FromMinutes(60));
+  CertVerifier late(late_time_service);
+  ASSERT_TRUE(late.DeserializeCache(pickle));
+  ASSERT_EQ(0u, late.GetCacheSize());
+
+  // Nor is anything from a truncated pickle.
+  Pickle truncated;
+  truncated.WriteInt(1);  // The format version.
+  truncated.WriteInt(2);  // The entry count.
+  truncated.WriteBytes(google_cert->chain_fingerprint().data,
+                       sizeof(google_cert->chain_fingerprint().data));
+  CertVerifier truncated_verifier;
+  ASSERT_FALSE(truncated_verifier.DeserializeCache(truncated));
+  ASSERT_EQ(0u, truncated_verifier.GetCacheSize());
+}
+
 // Tests that the callback of a canceled request is never made.
 TEST_F(CertVerifierTest, CancelRequest) {
   CertVerifier verifier;
@@ -74,10 +74,30 @@ const size_t CookieMonster::kDomainMaxCookies           = 180;
 const size_t CookieMonster::kDomainPurgeCookies         = 30;
 const size_t CookieMonster::kMaxCookies                 = 3300;
 const size_t CookieMonster::kPurgeCookies               = 300;
+const size_t CookieMonster::kGlobalPurgeBatchCookies    = 30;
 const int CookieMonster::kSafeFromGlobalPurgeDays       = 30;
 
 namespace {
 
+// Once this many cookie lines are cached, the cache is emptied.
+const size_t kMaxCachedCookieLines = 200;
+
+// Returns the key to cache the cookie line for |url| and |options| under.
+std::string GetCookieLineCacheKey(const GURL& url,
+                                  const CookieOptions& options) {
+  std::string cache_key(url.scheme());
+  cache_key.append("://");
+  cache_key.append(url.host());
+  cache_key.append(url.path());
+  cache_key.push_back('\n');
+  cache_key.push_back(options.exclude_httponly() ? '0' : '1');
+  return cache_key;
+}
+
+}  // namespace
+
+namespace {
+
 // Default minimum delay after updating a cookie's LastAccessDate before we
 // will update it again.
 const int kDefaultAccessUpdateThresholdSeconds = 60;
@@ -386,14 +406,16 @@ ChangeCausePair ChangeCauseMapping[] = {
 bool CookieMonster::enable_file_scheme_ = false;
 
 CookieMonster::CookieMonster(PersistentCookieStore* store, Delegate* delegate)
-    : initialized_(false),
+    : last_key_generation_(0),
+      initialized_(false),
       expiry_and_key_scheme_(expiry_and_key_default_),
       store_(store),
       last_access_threshold_(
           TimeDelta::FromSeconds(kDefaultAccessUpdateThresholdSeconds)),
       delegate_(delegate),
       last_statistic_record_time_(Time::Now()),
-      keep_expired_cookies_(false) {
+      keep_expired_cookies_(false),
+      global_purge_pending_(false) {
   InitializeHistograms();
   SetDefaultCookieableSchemes();
 }
@@ -401,14 +423,16 @@ CookieMonster::CookieMonster(PersistentCookieStore* store, Delegate* delegate)
 CookieMonster::CookieMonster(PersistentCookieStore* store,
                              Delegate* delegate,
                              int last_access_threshold_milliseconds)
-    : initialized_(false),
+    : last_key_generation_(0),
+      initialized_(false),
       expiry_and_key_scheme_(expiry_and_key_default_),
       store_(store),
       last_access_threshold_(base::TimeDelta::FromMilliseconds(
           last_access_threshold_milliseconds)),
       delegate_(delegate),
       last_statistic_record_time_(base::Time::Now()),
-      keep_expired_cookies_(false) {
+      keep_expired_cookies_(false),
+      global_purge_pending_(false) {
   InitializeHistograms();
   SetDefaultCookieableSchemes();
 }
@@ -544,7 +568,7 @@ bool CookieMonster::SetCookieWithDetails(
   if (!HasCookieableScheme(url))
     return false;
 
-  InitIfNecessary();
+  InitForKeyIfNecessary(GetKey(url.host()));
 
   Time creation_time = CurrentTime();
   last_time_seen_ = creation_time;
@@ -576,9 +600,7 @@ CookieList CookieMonster::GetAllCookies() {
   //
   // Note that this does not prune cookies to be below our limits (if we've
   // exceeded them) the way that calling GarbageCollect() would.
-  GarbageCollectExpired(Time::Now(),
-                        CookieMapItPair(cookies_.begin(), cookies_.end()),
-                        NULL);
+  GarbageCollectAllExpired(Time::Now());
 
   // Copy the CanonicalCookie pointers from the map so that we can use the same
   // sorter as elsewhere, then copy the result out.
@@ -601,7 +623,7 @@ CookieList CookieMonster::GetAllCookiesForURLWithOptions(
     const GURL& url,
     const CookieOptions& options) {
   base::AutoLock autolock(lock_);
-  InitIfNecessary();
+  InitForKeyIfNecessary(GetKey(url.host()));
 
   std::vector<CanonicalCookie*> cookie_ptrs;
   FindCookiesForHostAndDomain(url, options, false, &cookie_ptrs);
@@ -669,11 +691,12 @@ int CookieMonster::DeleteAllCreatedAfter(const Time& delete_begin,
 
 int CookieMonster::DeleteAllForHost(const GURL& url) {
   base::AutoLock autolock(lock_);
-  InitIfNecessary();
 
   if (!HasCookieableScheme(url))
     return 0;
 
+  InitForKeyIfNecessary(GetKey(url.host()));
+
   const std::string scheme(url.scheme());
   const std::string host(url.host());
 
@@ -700,7 +723,7 @@ int CookieMonster::DeleteAllForHost(const GURL& url) {
 
 bool CookieMonster::DeleteCanonicalCookie(const CanonicalCookie& cookie) {
   base::AutoLock autolock(lock_);
-  InitIfNecessary();
+  InitForKeyIfNecessary(GetKey(cookie.Domain()));
 
   for (CookieMapItPair its = cookies_.equal_range(GetKey(cookie.Domain()));
        its.first != its.second; ++its.first) {
@@ -718,7 +741,7 @@ void CookieMonster::SetCookieableSchemes(
   base::AutoLock autolock(lock_);
 
   // Cookieable Schemes must be set before first use of function.
-  DCHECK(!initialized_);
+  DCHECK(!initialized_ && keys_loaded_.empty());
 
   cookieable_schemes_.clear();
   cookieable_schemes_.insert(cookieable_schemes_.end(),
@@ -726,7 +749,7 @@ void CookieMonster::SetCookieableSchemes(
 }
 
 void CookieMonster::SetExpiryAndKeyScheme(ExpiryAndKeyScheme key_scheme) {
-  DCHECK(!initialized_);
+  DCHECK(!initialized_ && keys_loaded_.empty());
   expiry_and_key_scheme_ = key_scheme;
 }
 
@@ -746,7 +769,7 @@ void CookieMonster::EnableFileScheme() {
 
 void CookieMonster::FlushStore(Task* completion_task) {
   base::AutoLock autolock(lock_);
-  if (initialized_ && store_)
+  if ((initialized_ || !keys_loaded_.empty()) && store_)
     store_->Flush(completion_task);
   else if (completion_task)
     MessageLoop::current()->PostTask(FROM_HERE, completion_task);
@@ -761,7 +784,7 @@ bool CookieMonster::SetCookieWithOptions(const GURL& url,
     return false;
   }
 
-  InitIfNecessary();
+  InitForKeyIfNecessary(GetKey(url.host()));
 
   return SetCookieWithCreationTimeAndOptions(url, cookie_line, Time(), options);
 }
@@ -769,20 +792,37 @@ bool CookieMonster::SetCookieWithOptions(const GURL& url,
 std::string CookieMonster::GetCookiesWithOptions(const GURL& url,
                                                  const CookieOptions& options) {
   base::AutoLock autolock(lock_);
-  InitIfNecessary();
 
   if (!HasCookieableScheme(url)) {
     return std::string();
   }
 
+  InitForKeyIfNecessary(GetKey(url.host()));
+
   TimeTicks start_time(TimeTicks::Now());
 
+  // With the eTLD+1 scheme, all the cookies for the URL are under one key,
+  // so the line can be reused until that key changes.
+  const bool use_cache =
+      expiry_and_key_scheme_ == EKS_KEEP_RECENT_AND_PURGE_ETLDP1;
+  const std::string key(GetKey(url.host()));
+  std::string cookie_line;
+  if (use_cache) {
+    bool hit = GetCachedCookieLine(key, url, options, CurrentTime(),
+                                   &cookie_line);
+    histogram_cookie_line_cache_hit_->Add(hit ? 1 : 0);
+    if (hit) {
+      histogram_time_get_->AddTime(TimeTicks::Now() - start_time);
+      VLOG(kVlogGetCookies) << "GetCookies() result: " << cookie_line;
+      return cookie_line;
+    }
+  }
+
   // Get the cookies for this host and its domain(s).
   std::vector<CanonicalCookie*> cookies;
   FindCookiesForHostAndDomain(url, options, true, &cookies);
   std::sort(cookies.begin(), cookies.end(), CookieSorter);
 
-  std::string cookie_line;
   for (std::vector<CanonicalCookie*>::const_iterator it = cookies.begin();
        it != cookies.end(); ++it) {
     if (it != cookies.begin())
@@ -795,6 +835,9 @@ std::string CookieMonster::GetCookiesWithOptions(const GURL& url,
     cookie_line += (*it)->Value();
   }
 
+  if (use_cache)
+    CacheCookieLine(key, url, options, cookies, cookie_line);
+
   histogram_time_get_->AddTime(TimeTicks::Now() - start_time);
 
   VLOG(kVlogGetCookies) << "GetCookies() result: " << cookie_line;
@@ -805,11 +848,12 @@ std::string CookieMonster::GetCookiesWithOptions(const GURL& url,
 void CookieMonster::DeleteCookie(const GURL& url,
                                  const std::string& cookie_name) {
   base::AutoLock autolock(lock_);
-  InitIfNecessary();
 
   if (!HasCookieableScheme(url))
     return;
 
+  InitForKeyIfNecessary(GetKey(url.host()));
+
   CookieOptions options;
   options.set_include_httponly();
   // Get the cookies for this host and its domain(s).
@@ -843,6 +887,10 @@ CookieMonster::~CookieMonster() {
   DeleteAll(false);
 }
 
+CookieMonster::CachedCookieLine::CachedCookieLine() : generation(0) {}
+
+CookieMonster::CachedCookieLine::~CachedCookieLine() {}
+
 bool CookieMonster::SetCookieWithCreationTime(const GURL& url,
                                               const std::string& cookie_line,
                                               const base::Time& creation_time) {
@@ -852,11 +900,28 @@ bool CookieMonster::SetCookieWithCreationTime(const GURL& url,
     return false;
   }
 
-  InitIfNecessary();
+  InitForKeyIfNecessary(GetKey(url.host()));
   return SetCookieWithCreationTimeAndOptions(url, cookie_line, creation_time,
                                              CookieOptions());
 }
 
+void CookieMonster::InitForKeyIfNecessary(const std::string& key) {
+  lock_.AssertAcquired();
+
+  if (initialized_)
+    return;
+
+  // Only the eTLD+1 key scheme matches the keys the store loads by.
+  if (store_ && expiry_and_key_scheme_ == EKS_KEEP_RECENT_AND_PURGE_ETLDP1) {
+    if (keys_loaded_.find(key) != keys_loaded_.end())
+      return;
+    if (InitStoreForKey(key))
+      return;
+  }
+
+  InitIfNecessary();
+}
+
 void CookieMonster::InitStore() {
   DCHECK(store_) << "Store must exist to initialize";
 
@@ -870,25 +935,59 @@ void CookieMonster::InitStore() {
   // This prevents multiple vector growth / copies as we append cookies.
   cookies.reserve(kMaxCookies);
   store_->Load(&cookies);
+  StoreLoadedCookies(cookies);
+  keys_loaded_.clear();
+
+  // After importing cookies from the PersistentCookieStore, verify that
+  // none of our other constraints are violated.
+  //
+  // In particular, the backing store might have given us duplicate cookies.
+  EnsureCookiesMapIsValid();
+
+  histogram_time_load_->AddTime(TimeTicks::Now() - beginning_time);
+}
+
+bool CookieMonster::InitStoreForKey(const std::string& key) {
+  DCHECK(store_) << "Store must exist to initialize";
+
+  TimeTicks beginning_time(TimeTicks::Now());
+
+  std::vector<CanonicalCookie*> cookies;
+  if (!store_->LoadCookiesForKey(key, &cookies)) {
+    DCHECK(cookies.empty());
+    return false;
+  }
+  StoreLoadedCookies(cookies);
+  keys_loaded_.insert(key);
+
+  // Only the range for |key| has changed, so only it needs checking.
+  CookieMapItPair its = cookies_.equal_range(key);
+  histogram_cookie_deletion_cause_->Add(
+      TrimDuplicateCookiesForKey(key, its.first, its.second));
+
+  histogram_time_load_for_key_->AddTime(TimeTicks::Now() - beginning_time);
+  return true;
+}
+
+void CookieMonster::StoreLoadedCookies(
+    const std::vector<CanonicalCookie*>& cookies) {
+  lock_.AssertAcquired();
 
   // Avoid ever letting cookies with duplicate creation times into the store;
   // that way we don't have to worry about what sections of code are safe
   // to call while it's in that state.
   std::set<int64> creation_times;
 
-  // Presumably later than any access time in the store.
-  Time earliest_access_time;
-
   for (std::vector<CanonicalCookie*>::const_iterator it = cookies.begin();
        it != cookies.end(); ++it) {
     int64 cookie_creation_time = (*it)->CreationDate().ToInternalValue();
+    const std::string key(GetKey((*it)->Domain()));
 
-    if (creation_times.insert(cookie_creation_time).second) {
-      InternalInsertCookie(GetKey((*it)->Domain()), *it, false);
-      const Time cookie_access_time((*it)->LastAccessDate());
-      if (earliest_access_time.is_null() ||
-          cookie_access_time < earliest_access_time)
-        earliest_access_time = cookie_access_time;
+    if (keys_loaded_.find(key) != keys_loaded_.end()) {
+      // Read already by InitStoreForKey(), and possibly changed since.
+      delete (*it);
+    } else if (creation_times.insert(cookie_creation_time).second) {
+      InternalInsertCookie(key, *it, false);
     } else {
       LOG(ERROR) << base::StringPrintf("Found cookies with duplicate creation "
                                        "times in backing store: "
@@ -901,15 +1000,6 @@ void CookieMonster::InitStore() {
       delete (*it);
     }
   }
-  earliest_access_time_= earliest_access_time;
-
-  // After importing cookies from the PersistentCookieStore, verify that
-  // none of our other constraints are violated.
-  //
-  // In particular, the backing store might have given us duplicate cookies.
-  EnsureCookiesMapIsValid();
-
-  histogram_time_load_->AddTime(TimeTicks::Now() - beginning_time);
 }
 
 void CookieMonster::EnsureCookiesMapIsValid() {
@@ -1132,6 +1222,82 @@ void CookieMonster::FindCookiesForKey(
   }
 }
 
+bool CookieMonster::GetCachedCookieLine(const std::string& key,
+                                        const GURL& url,
+                                        const CookieOptions& options,
+                                        const Time& current,
+                                        std::string* cookie_line) {
+  lock_.AssertAcquired();
+
+  CookieLineCache::iterator it =
+      cookie_line_cache_.find(GetCookieLineCacheKey(url, options));
+  if (it == cookie_line_cache_.end())
+    return false;
+
+  const CachedCookieLine& cached = it->second;
+  std::map<std::string, uint64>::const_iterator generation =
+      key_generations_.find(key);
+  if (generation == key_generations_.end() ||
+      generation->second != cached.generation ||
+      (!cached.expires.is_null() && current >= cached.expires)) {
+    cookie_line_cache_.erase(it);
+    return false;
+  }
+
+  // Probe to save statistics, as FindCookiesForHostAndDomain() would have.
+  RecordPeriodicStats(current);
+
+  // The key has not changed, so the cookies are all still there.
+  for (std::vector<CanonicalCookie*>::const_iterator cookie =
+           cached.cookies.begin();
+       cookie != cached.cookies.end(); ++cookie) {
+    InternalUpdateCookieAccessTime(*cookie, current);
+  }
+  *cookie_line = cached.cookie_line;
+  return true;
+}
+
+void CookieMonster::CacheCookieLine(
+    const std::string& key,
+    const GURL& url,
+    const CookieOptions& options,
+    const std::vector<CanonicalCookie*>& cookies,
+    const std::string& cookie_line) {
+  lock_.AssertAcquired();
+
+  // Without cookies, the key may not be in |key_generations_|; there is
+  // nothing to be saved by caching an empty line then anyway.
+  std::map<std::string, uint64>::const_iterator generation =
+      key_generations_.find(key);
+  if (generation == key_generations_.end())
+    return;
+
+  if (cookie_line_cache_.size() >= kMaxCachedCookieLines)
+    cookie_line_cache_.clear();
+
+  CachedCookieLine& cached =
+      cookie_line_cache_[GetCookieLineCacheKey(url, options)];
+  cached.generation = generation->second;
+  cached.cookie_line = cookie_line;
+  cached.cookies = cookies;
+  cached.expires = Time();
+  for (std::vector<CanonicalCookie*>::const_iterator it = cookies.begin();
+       it != cookies.end(); ++it) {
+    if ((*it)->DoesExpire() &&
+        (cached.expires.is_null() || (*it)->ExpiryDate() < cached.expires))
+      cached.expires = (*it)->ExpiryDate();
+  }
+}
+
+void CookieMonster::BumpKeyGeneration(const std::string& key) {
+  lock_.AssertAcquired();
+
+  if (cookies_.find(key) == cookies_.end())
+    key_generations_.erase(key);
+  else
+    key_generations_[key] = ++last_key_generation_;
+}
+
 bool CookieMonster::DeleteAnyEquivalentCookie(const std::string& key,
                                               const CanonicalCookie& ecc,
                                               bool skip_httponly,
@@ -1170,7 +1336,12 @@ void CookieMonster::InternalInsertCookie(const std::string& key,
 
   if (cc->IsPersistent() && store_ && sync_to_store)
     store_->AddCookie(*cc);
-  cookies_.insert(CookieMap::value_type(key, cc));
+  CookieMap::iterator inserted =
+      cookies_.insert(CookieMap::value_type(key, cc));
+  if (cc->DoesExpire())
+    expiry_index_.insert(ExpiryIndex::value_type(cc->ExpiryDate(), inserted));
+  AddToAccessIndex(inserted);
+  BumpKeyGeneration(key);
   if (delegate_.get()) {
     delegate_->OnCookieChanged(
         *cc, false, CookieMonster::Delegate::CHANGE_COOKIE_EXPLICIT);
@@ -1278,7 +1449,21 @@ void CookieMonster::InternalUpdateCookieAccessTime(CanonicalCookie* cc,
   histogram_between_access_interval_minutes_->Add(
       (current - cc->LastAccessDate()).InMinutes());
 
+  // Move the cookie to its new place in |access_index_|.
+  std::pair<AccessIndex::iterator, AccessIndex::iterator> its =
+      access_index_.equal_range(
+          std::make_pair(cc->LastAccessDate().ToInternalValue(),
+                         cc->CreationDate().ToInternalValue()));
+  for (; its.first != its.second; ++its.first) {
+    if (its.first->second->second == cc)
+      break;
+  }
+  DCHECK(its.first != its.second);
+  CookieMap::iterator map_it = its.first->second;
+  access_index_.erase(its.first);
   cc->SetLastAccessDate(current);
+  AddToAccessIndex(map_it);
+
   if (cc->IsPersistent() && store_)
     store_->UpdateCookieAccessTime(*cc);
 }
@@ -1309,7 +1494,20 @@ void CookieMonster::InternalDeleteCookie(CookieMap::iterator it,
     if (mapping.notify)
       delegate_->OnCookieChanged(*cc, true, mapping.cause);
   }
+  if (cc->DoesExpire()) {
+    std::pair<ExpiryIndex::iterator, ExpiryIndex::iterator> its =
+        expiry_index_.equal_range(cc->ExpiryDate());
+    for (; its.first != its.second; ++its.first) {
+      if (its.first->second == it) {
+        expiry_index_.erase(its.first);
+        break;
+      }
+    }
+  }
+  RemoveFromAccessIndex(it);
+  const std::string key(it->first);
   cookies_.erase(it);
+  BumpKeyGeneration(key);
   delete cc;
 }
 
@@ -1355,48 +1553,79 @@ int CookieMonster::GarbageCollect(const Time& current,
     }
   }
 
-  // Collect garbage for everything.  With firefox style we want to
-  // preserve cookies touched in kSafeFromGlobalPurgeDays, otherwise
-  // not.
-  if (cookies_.size() > kMaxCookies &&
-      (expiry_and_key_scheme_ == EKS_DISCARD_RECENT_AND_PURGE_DOMAIN ||
-       earliest_access_time_ <
-       Time::Now() - TimeDelta::FromDays(kSafeFromGlobalPurgeDays))) {
+  // Collect garbage for everything.  Once we go over kMaxCookies this is
+  // done a batch per call, so that no single SetCookie() pays for the whole
+  // purge.
+  if (cookies_.size() > kMaxCookies)
+    global_purge_pending_ = true;
+  if (global_purge_pending_) {
     VLOG(kVlogGarbageCollection) << "GarbageCollect() everything";
-    std::vector<CookieMap::iterator> cookie_its;
-    base::Time oldest_left;
-    num_deleted += GarbageCollectExpired(
-        current, CookieMapItPair(cookies_.begin(), cookies_.end()),
-        &cookie_its);
-    if (FindLeastRecentlyAccessed(kMaxCookies, kPurgeCookies,
-                                  &oldest_left, &cookie_its)) {
-      Time oldest_safe_cookie(
-          expiry_and_key_scheme_ == EKS_KEEP_RECENT_AND_PURGE_ETLDP1 ?
-              (Time::Now() - TimeDelta::FromDays(kSafeFromGlobalPurgeDays)) :
-              Time());                  // Null time == ignore access time.
-      int num_evicted = GarbageCollectDeleteList(
-          current,
-          oldest_safe_cookie,
-          DELETE_COOKIE_EVICTED_GLOBAL,
-          cookie_its);
-
-      // If no cookies were preserved by the time limit, the global last
-      // access is set to the value returned from FindLeastRecentlyAccessed.
-      // If the time limit preserved some cookies, we use the last access of
-      // the oldest preserved cookie.
-      if (num_evicted == static_cast<int>(cookie_its.size())) {
-        earliest_access_time_ = oldest_left;
-      } else {
-        earliest_access_time_ =
-            (*(cookie_its.begin() + num_evicted))->second->LastAccessDate();
-      }
-      num_deleted += num_evicted;
-    }
+    num_deleted += GarbageCollectGlobalBatch(current);
   }
 
   return num_deleted;
 }
 
+int CookieMonster::GarbageCollectGlobalBatch(const Time& current) {
+  lock_.AssertAcquired();
+
+  int num_deleted = GarbageCollectAllExpired(current);
+
+  // With firefox style we want to preserve cookies touched in
+  // kSafeFromGlobalPurgeDays, otherwise not.
+  const Time oldest_safe_cookie(
+      expiry_and_key_scheme_ == EKS_KEEP_RECENT_AND_PURGE_ETLDP1 ?
+          (Time::Now() - TimeDelta::FromDays(kSafeFromGlobalPurgeDays)) :
+          Time());                  // Null time == ignore access time.
+  const size_t purge_goal = kMaxCookies - kPurgeCookies;
+
+  // Never leave more than kMaxCookies behind.
+  size_t batch = kGlobalPurgeBatchCookies;
+  if (cookies_.size() > kMaxCookies)
+    batch = std::max(batch, cookies_.size() - kMaxCookies);
+
+  while (cookies_.size() > purge_goal && batch > 0) {
+    CookieMap::iterator oldest = access_index_.begin()->second;
+    const Time last_access(oldest->second->LastAccessDate());
+    if (!oldest_safe_cookie.is_null() && last_access >= oldest_safe_cookie)
+      break;
+
+    histogram_evicted_last_access_minutes_->Add(
+        (current - last_access).InMinutes());
+    InternalDeleteCookie(oldest, true, DELETE_COOKIE_EVICTED_GLOBAL);
+    ++num_deleted;
+    --batch;
+  }
+
+  // Done if we reached the goal or only safe cookies are left to evict.
+  if (batch > 0)
+    global_purge_pending_ = false;
+  return num_deleted;
+}
+
+void CookieMonster::AddToAccessIndex(CookieMap::iterator it) {
+  const CanonicalCookie* cc = it->second;
+  access_index_.insert(AccessIndex::value_type(
+      std::make_pair(cc->LastAccessDate().ToInternalValue(),
+                     cc->CreationDate().ToInternalValue()),
+      it));
+}
+
+void CookieMonster::RemoveFromAccessIndex(CookieMap::iterator it) {
+  const CanonicalCookie* cc = it->second;
+  std::pair<AccessIndex::iterator, AccessIndex::iterator> its =
+      access_index_.equal_range(
+          std::make_pair(cc->LastAccessDate().ToInternalValue(),
+                         cc->CreationDate().ToInternalValue()));
+  for (; its.first != its.second; ++its.first) {
+    if (its.first->second == it) {
+      access_index_.erase(its.first);
+      return;
+    }
+  }
+  NOTREACHED();
+}
+
 int CookieMonster::GarbageCollectExpired(
     const Time& current,
     const CookieMapItPair& itpair,
@@ -1422,6 +1651,23 @@ int CookieMonster::GarbageCollectExpired(
   return num_deleted;
 }
 
+int CookieMonster::GarbageCollectAllExpired(const Time& current) {
+  if (keep_expired_cookies_)
+    return 0;
+
+  lock_.AssertAcquired();
+
+  int num_deleted = 0;
+  while (!expiry_index_.empty() &&
+         expiry_index_.begin()->second->second->IsExpired(current)) {
+    // This removes the entry from |expiry_index_|.
+    InternalDeleteCookie(expiry_index_.begin()->second, true,
+                         DELETE_COOKIE_EXPIRED);
+    ++num_deleted;
+  }
+  return num_deleted;
+}
+
 int CookieMonster::GarbageCollectDeleteList(
     const Time& current,
     const Time& keep_accessed_after,
@@ -1467,7 +1713,11 @@ int CookieMonster::GarbageCollectDeleteList(
 std::string CookieMonster::GetKey(const std::string& domain) const {
   if (expiry_and_key_scheme_ == EKS_DISCARD_RECENT_AND_PURGE_DOMAIN)
     return domain;
+  return GetEffectiveDomainKey(domain);
+}
 
+// static
+std::string CookieMonster::GetEffectiveDomainKey(const std::string& domain) {
   std::string effective_domain(
       RegistryControlledDomainService::GetDomainAndRegistry(domain));
   if (effective_domain.empty())
@@ -1619,6 +1869,12 @@ void CookieMonster::InitializeHistograms() {
   histogram_time_load_ = base::Histogram::FactoryTimeGet("Cookie.TimeLoad",
       base::TimeDelta::FromMilliseconds(1), base::TimeDelta::FromMinutes(1),
       50, base::Histogram::kUmaTargetedHistogramFlag);
+  histogram_time_load_for_key_ = base::Histogram::FactoryTimeGet(
+      "Cookie.TimeLoadForKey",
+      base::TimeDelta::FromMilliseconds(1), base::TimeDelta::FromMinutes(1),
+      50, base::Histogram::kUmaTargetedHistogramFlag);
+  histogram_cookie_line_cache_hit_ = base::BooleanHistogram::FactoryGet(
+      "Cookie.CookieLineCacheHit", base::Histogram::kUmaTargetedHistogramFlag);
 }
 
 
@@ -2133,4 +2389,10 @@ std::string CookieMonster::CanonicalCookie::DebugString() const {
       static_cast<int64>(creation_date_.ToTimeT()));
 }
 
+bool CookieMonster::PersistentCookieStore::LoadCookiesForKey(
+    const std::string& key,
+    std::vector<CookieMonster::CanonicalCookie*>* cookies) {
+  return false;
+}
+
 }  // namespace
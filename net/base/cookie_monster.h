@@ -9,6 +9,7 @@
 #pragma once
 
 #include <map>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -130,6 +131,11 @@ class NET_EXPORT CookieMonster : public CookieStore {
   // i.e. it doesn't begin with a leading '.' character.
   static bool DomainIsHostOnly(const std::string& domain_string);
 
+  // Returns the key that cookies for |domain| are kept under with
+  // EKS_KEEP_RECENT_AND_PURGE_ETLDP1: its eTLD+1, without a leading '.'.
+  // This is the key PersistentCookieStore::LoadCookiesForKey() is given.
+  static std::string GetEffectiveDomainKey(const std::string& domain);
+
   // Sets a cookie given explicit user-provided cookie attributes. The cookie
   // name, value, domain, etc. are each provided as separate strings. This
   // function expects each attribute to be well-formed. It will check for
@@ -258,7 +264,10 @@ class NET_EXPORT CookieMonster : public CookieStore {
   FRIEND_TEST_ALL_PREFIXES(CookieMonsterTest, TestHostGarbageCollection);
   FRIEND_TEST_ALL_PREFIXES(CookieMonsterTest, TestTotalGarbageCollection);
   FRIEND_TEST_ALL_PREFIXES(CookieMonsterTest, GarbageCollectionTriggers);
+  FRIEND_TEST_ALL_PREFIXES(CookieMonsterTest,
+                           GlobalGarbageCollectionIsIncremental);
   FRIEND_TEST_ALL_PREFIXES(CookieMonsterTest, TestGCTimes);
+  FRIEND_TEST_ALL_PREFIXES(CookieMonsterTest, TestGCLatency);
 
   // For validation of key values.
   FRIEND_TEST_ALL_PREFIXES(CookieMonsterTest, TestDomainTree);
@@ -324,6 +333,11 @@ class NET_EXPORT CookieMonster : public CookieStore {
   static const size_t kMaxCookies;
   static const size_t kPurgeCookies;
 
+  // Global garbage collection is spread over the calls that set cookies, each
+  // evicting at most this many cookies, or as many as it takes to get back to
+  // kMaxCookies, whichever is more.
+  static const size_t kGlobalPurgeBatchCookies;
+
   // The number of days since last access that cookies will not be subject
   // to global garbage collection.
   static const int kSafeFromGlobalPurgeDays;
@@ -353,10 +367,27 @@ class NET_EXPORT CookieMonster : public CookieStore {
     }
   }
 
+  // Like InitIfNecessary(), but for functions that only touch the cookies
+  // under |key|.  If the store can load cookies by key, only those are read
+  // (once per key), so that a lookup for one site does not wait on the whole
+  // store.  Otherwise this does a full InitIfNecessary().
+  // Note: this method should always be called with lock_ held.
+  void InitForKeyIfNecessary(const std::string& key);
+
   // Initializes the backing store and reads existing cookies from it.
   // Should only be called by InitIfNecessary().
   void InitStore();
 
+  // Reads the cookies under |key| from the backing store.  Returns false if
+  // the store can't load cookies by key.
+  // Should only be called by InitForKeyIfNecessary().
+  bool InitStoreForKey(const std::string& key);
+
+  // Adds |cookies|, just read from the backing store, to |cookies_|, taking
+  // ownership of them.  Cookies under a key in |keys_loaded_| are dropped,
+  // as those have been read already.
+  void StoreLoadedCookies(const std::vector<CanonicalCookie*>& cookies);
+
   // Checks that |cookies_| matches our invariants, and tries to repair any
   // inconsistencies. (In other words, it does not have duplicate cookies).
   void EnsureCookiesMapIsValid();
@@ -382,6 +413,28 @@ class NET_EXPORT CookieMonster : public CookieStore {
                          bool update_access_time,
                          std::vector<CanonicalCookie*>* cookies);
 
+  // Copies the cookie line cached for |url| and |options| to |cookie_line|
+  // and updates the access times of the cookies in it, if the cookies under
+  // |key| have not changed since it was cached and none of them has expired.
+  // Returns false if there is no such line.
+  bool GetCachedCookieLine(const std::string& key,
+                           const GURL& url,
+                           const CookieOptions& options,
+                           const base::Time& current,
+                           std::string* cookie_line);
+
+  // Caches |cookie_line|, made up of |cookies| under |key|, for requests to
+  // |url| with |options|.
+  void CacheCookieLine(const std::string& key,
+                       const GURL& url,
+                       const CookieOptions& options,
+                       const std::vector<CanonicalCookie*>& cookies,
+                       const std::string& cookie_line);
+
+  // Marks the cookies under |key| as changed, so that cookie lines cached
+  // for it are no longer used.
+  void BumpKeyGeneration(const std::string& key);
+
   // Delete any cookies that are equivalent to |ecc| (same path, domain, etc).
   // If |skip_httponly| is true, httponly cookies will not be deleted.  The
   // return value with be true if |skip_httponly| skipped an httponly cookie.
@@ -438,6 +491,21 @@ class NET_EXPORT CookieMonster : public CookieStore {
                             const CookieMapItPair& itpair,
                             std::vector<CookieMap::iterator>* cookie_its);
 
+  // Deletes all expired cookies, using |expiry_index_| rather than scanning
+  // |cookies_|.  Returns the number of cookies deleted.
+  int GarbageCollectAllExpired(const base::Time& current);
+
+  // Does one step of global garbage collection: evicts the least recently
+  // accessed cookies, in a batch of kGlobalPurgeBatchCookies, until there are
+  // kMaxCookies - kPurgeCookies left or the next one is safe from global
+  // purge.  Clears |global_purge_pending_| once done.  Returns the number of
+  // cookies deleted.
+  int GarbageCollectGlobalBatch(const base::Time& current);
+
+  // Keeps |access_index_| in step with |cookies_|.
+  void AddToAccessIndex(CookieMap::iterator it);
+  void RemoveFromAccessIndex(CookieMap::iterator it);
+
   // Helper for GarbageCollect().  Deletes all cookies in the list
   // that were accessed before |keep_accessed_after|, using DeletionCause
   // |cause|.  If |keep_accessed_after| is null, deletes all cookies in the
@@ -480,13 +548,55 @@ class NET_EXPORT CookieMonster : public CookieStore {
   base::Histogram* histogram_cookie_deletion_cause_;
   base::Histogram* histogram_time_get_;
   base::Histogram* histogram_time_load_;
+  base::Histogram* histogram_time_load_for_key_;
+  base::Histogram* histogram_cookie_line_cache_hit_;
 
   CookieMap cookies_;
 
+  // The cookies in |cookies_| that expire, ordered by expiry date.
+  typedef std::multimap<base::Time, CookieMap::iterator> ExpiryIndex;
+  ExpiryIndex expiry_index_;
+
+  // All the cookies in |cookies_|, least recently accessed first; ties are
+  // broken by creation date, as in garbage collection.  Keyed by the
+  // internal values of (last access date, creation date).
+  typedef std::multimap<std::pair<int64, int64>, CookieMap::iterator>
+      AccessIndex;
+  AccessIndex access_index_;
+
+  // The generation of each key in |cookies_|, which changes whenever a cookie
+  // is added under the key or removed.  Generations are taken from
+  // |last_key_generation_|, so a key that is removed and added again does not
+  // repeat an old one.
+  std::map<std::string, uint64> key_generations_;
+  uint64 last_key_generation_;
+
+  // A cookie line built by GetCookiesWithOptions(), which can be reused
+  // while its key is at |generation| and until |expires|.
+  struct CachedCookieLine {
+    CachedCookieLine();
+    ~CachedCookieLine();
+
+    uint64 generation;
+    std::string cookie_line;
+    // The cookies in |cookie_line|, to update their access times.
+    std::vector<CanonicalCookie*> cookies;
+    // The earliest expiry date of |cookies|, or null if none expires.
+    base::Time expires;
+  };
+  // Keyed by the scheme, host and path of the URL and by whether httponly
+  // cookies were included.
+  typedef std::map<std::string, CachedCookieLine> CookieLineCache;
+  CookieLineCache cookie_line_cache_;
+
   // Indicates whether the cookie store has been initialized. This happens
   // lazily in InitStoreIfNecessary().
   bool initialized_;
 
+  // Keys whose cookies have been read from the store by
+  // InitForKeyIfNecessary() before the store was fully initialized.
+  std::set<std::string> keys_loaded_;
+
   // Indicates whether this cookie monster uses the new effective domain
   // key scheme or not.
   ExpiryAndKeyScheme expiry_and_key_scheme_;
@@ -499,17 +609,6 @@ class NET_EXPORT CookieMonster : public CookieStore {
   // update it again.
   const base::TimeDelta last_access_threshold_;
 
-  // Approximate date of access time of least recently accessed cookie
-  // in |cookies_|.  Note that this is not guaranteed to be accurate, only a)
-  // to be before or equal to the actual time, and b) to be accurate
-  // immediately after a garbage collection that scans through all the cookies.
-  // This value is used to determine whether global garbage collection might
-  // find cookies to purge.
-  // Note: The default Time() constructor will create a value that compares
-  // earlier than any other time value, which is is wanted.  Thus this
-  // value is not initialized.
-  base::Time earliest_access_time_;
-
   std::vector<std::string> cookieable_schemes_;
 
   scoped_refptr<Delegate> delegate_;
@@ -521,6 +620,10 @@ class NET_EXPORT CookieMonster : public CookieStore {
 
   bool keep_expired_cookies_;
 
+  // True while a global garbage collection has been started and has not got
+  // down to its goal yet.
+  bool global_purge_pending_;
+
   static bool enable_file_scheme_;
 
   DISALLOW_COPY_AND_ASSIGN(CookieMonster);
@@ -782,9 +885,19 @@ class CookieMonster::PersistentCookieStore
   virtual ~PersistentCookieStore() {}
 
   // Initializes the store and retrieves the existing cookies. This will be
-  // called only once at startup.
+  // called only once at startup.  Cookies already returned by
+  // LoadCookiesForKey() need not be returned again.
   virtual bool Load(std::vector<CookieMonster::CanonicalCookie*>* cookies) = 0;
 
+  // Retrieves the cookies whose domain has the key |key|, as returned by
+  // CookieMonster::GetEffectiveDomainKey(), so that the cookies for one site
+  // can be read before the rest of the store.  This may be called for several
+  // keys before Load(), but at most once per key.  Returns false if the store
+  // can't load cookies by key, in which case Load() is used instead.
+  virtual bool LoadCookiesForKey(
+      const std::string& key,
+      std::vector<CookieMonster::CanonicalCookie*>* cookies);
+
   virtual void AddCookie(const CanonicalCookie& cc) = 0;
   virtual void UpdateCookieAccessTime(const CanonicalCookie& cc) = 0;
   virtual void DeleteCookie(const CanonicalCookie& cc) = 0;
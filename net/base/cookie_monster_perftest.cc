@@ -3,10 +3,13 @@
 // found in the LICENSE file.
 
 #include <algorithm>
+#include <vector>
 
 #include "net/base/cookie_monster.h"
 
+#include "base/memory/scoped_ptr.h"
 #include "base/perftimer.h"
+#include "base/process_util.h"
 #include "base/string_util.h"
 #include "base/stringprintf.h"
 #include "googleurl/src/gurl.h"
@@ -22,6 +25,85 @@ namespace {
 static const int kNumCookies = 20000;
 static const char kCookieLine[] = "A  = \"b=;\\\"\"  ;secure;;;";
 
+// The sizes of the realistic workloads: a profile that has been used for a
+// while sees thousands of sites, and sets tens of thousands of cookies.
+static const int kNumDomains = 3000;
+static const int kCookiesPerDomain = 10;
+static const int kNumTrafficOps = 50000;
+
+namespace {
+
+// Records how long each of a series of operations took, and logs the
+// percentiles of the distribution, since the averages PerfTimeLogger reports
+// hide the occasional slow operation (e.g. one that triggers GC).
+class LatencyLogger {
+ public:
+  explicit LatencyLogger(const std::string& name) : name_(name) {}
+
+  void Start() { start_ = base::TimeTicks::HighResNow(); }
+
+  void Stop() {
+    samples_.push_back(
+        (base::TimeTicks::HighResNow() - start_).InMicroseconds());
+  }
+
+  void Done() {
+    if (samples_.empty())
+      return;
+    std::sort(samples_.begin(), samples_.end());
+    LogPercentile("p50", 50);
+    LogPercentile("p90", 90);
+    LogPercentile("p99", 99);
+    LogPerfResult((name_ + "_max").c_str(),
+                  static_cast<double>(samples_.back()), "us");
+    samples_.clear();
+  }
+
+ private:
+  void LogPercentile(const char* suffix, size_t percentile) {
+    size_t index = (samples_.size() - 1) * percentile / 100;
+    LogPerfResult((name_ + "_" + suffix).c_str(),
+                  static_cast<double>(samples_[index]), "us");
+  }
+
+  std::string name_;
+  base::TimeTicks start_;
+  std::vector<int64> samples_;
+};
+
+// Returns the resident size of this process, in bytes.
+size_t GetWorkingSetSize() {
+#if defined(OS_MACOSX)
+  scoped_ptr<base::ProcessMetrics> metrics(
+      base::ProcessMetrics::CreateProcessMetrics(
+          base::GetCurrentProcessHandle(), NULL));
+#else
+  scoped_ptr<base::ProcessMetrics> metrics(
+      base::ProcessMetrics::CreateProcessMetrics(
+          base::GetCurrentProcessHandle()));
+#endif
+  return metrics->GetWorkingSetSize();
+}
+
+void LogMemoryGrowth(const char* name, size_t before) {
+  size_t after = GetWorkingSetSize();
+  LogPerfResult(name, after > before ? (after - before) / 1024.0 : 0, "KB");
+}
+
+// Picks one of |num_domains| domains, skewed the way browsing is: a handful
+// of sites get most of the traffic.  |seed| makes the sequence repeatable.
+int PickDomain(int num_domains, unsigned int* seed) {
+  *seed = *seed * 1103515245 + 12345;
+  double r = ((*seed >> 16) & 0x7fff) / 32768.0;
+  return static_cast<int>(num_domains * r * r * r);
+}
+
+GURL DomainURL(int domain) {
+  return GURL(base::StringPrintf("http://www.domain%d.com/", domain));
+}
+
+}  // namespace
+
 namespace net {
 
 TEST(ParsedCookieTest, TestParseCookies) {
@@ -302,4 +384,109 @@ TEST(CookieMonsterTest, TestGCTimes) {
   }
 }
 
+// Sets tens of thousands of cookies across thousands of domains, then runs
+// mostly-Get traffic against them.  The cookies are all recent, so global GC
+// keeps them even though there are more than kMaxCookies.
+TEST(CookieMonsterTest, TestRealisticTraffic) {
+  size_t memory_before = GetWorkingSetSize();
+  scoped_refptr<CookieMonster> cm(new CookieMonster(NULL, NULL));
+
+  LatencyLogger set_latency("Cookie_monster_realistic_set");
+  for (int cookie_num = 0; cookie_num < kCookiesPerDomain; ++cookie_num) {
+    for (int domain = 0; domain < kNumDomains; ++domain) {
+      std::string cookie_line(base::StringPrintf(
+          "c%d=%d; path=/; max-age=86400", cookie_num, domain));
+      GURL url(DomainURL(domain));
+      set_latency.Start();
+      EXPECT_TRUE(cm->SetCookie(url, cookie_line));
+      set_latency.Stop();
+    }
+  }
+  set_latency.Done();
+  LogMemoryGrowth("Cookie_monster_realistic_memory", memory_before);
+
+  // Nine Gets for every Set, as page loads read cookies far more often than
+  // responses set them.
+  LatencyLogger get_latency("Cookie_monster_realistic_traffic_get");
+  LatencyLogger traffic_set_latency("Cookie_monster_realistic_traffic_set");
+  unsigned int seed = 1;
+  for (int i = 0; i < kNumTrafficOps; ++i) {
+    GURL url(DomainURL(PickDomain(kNumDomains, &seed)));
+    if (i % 10 == 0) {
+      std::string cookie_line(base::StringPrintf("t%d=1; path=/", i % 50));
+      traffic_set_latency.Start();
+      EXPECT_TRUE(cm->SetCookie(url, cookie_line));
+      traffic_set_latency.Stop();
+    } else {
+      get_latency.Start();
+      cm->GetCookies(url);
+      get_latency.Stop();
+    }
+  }
+  get_latency.Done();
+  traffic_set_latency.Done();
+}
+
+// Sets cookies on many domains into a monster that is full of old cookies,
+// so that most Sets have GC work to do.  The percentiles show how evenly
+// that work is spread.
+TEST(CookieMonsterTest, TestGCLatency) {
+  scoped_refptr<CookieMonster> cm(
+      CreateMonsterFromStoreForGC(
+          CookieMonster::kMaxCookies * 2, CookieMonster::kMaxCookies,
+          CookieMonster::kSafeFromGlobalPurgeDays * 2));
+
+  LatencyLogger latency("Cookie_monster_gc_set");
+  for (int i = 0; i < kNumCookies; ++i) {
+    GURL url(DomainURL(i % kNumDomains));
+    latency.Start();
+    EXPECT_TRUE(cm->SetCookie(url, base::StringPrintf("g%d=1", i)));
+    latency.Stop();
+  }
+  latency.Done();
+}
+
+// Measures startup: how long the first request waits for its cookies, and
+// how long loading everything takes, with and without loading by key.
+TEST(CookieMonsterTest, TestStartupLoad) {
+  const int kStoreDomains = 1000;
+  const int kStoreCookiesPerDomain = 3;
+  const char* const kNames[] = { "full", "by_key" };
+
+  for (int by_key = 0; by_key < 2; ++by_key) {
+    scoped_refptr<MockSimplePersistentCookieStore> store(
+        new MockSimplePersistentCookieStore);
+    store->set_load_by_key(by_key != 0);
+    base::Time now(base::Time::Now());
+    int64 time_tick(now.ToInternalValue());
+    for (int domain = 0; domain < kStoreDomains; ++domain) {
+      std::string host(base::StringPrintf("www.domain%d.com", domain));
+      for (int cookie_num = 0; cookie_num < kStoreCookiesPerDomain;
+           ++cookie_num) {
+        base::Time creation(base::Time::FromInternalValue(--time_tick));
+        store->AddCookie(CookieMonster::CanonicalCookie(
+            GURL(), base::StringPrintf("c%d", cookie_num), "1", host, "/",
+            creation, now + base::TimeDelta::FromDays(30), creation,
+            false, false, true));
+      }
+    }
+
+    size_t memory_before = GetWorkingSetSize();
+    scoped_refptr<CookieMonster> cm(new CookieMonster(store, NULL));
+    PerfTimeLogger first_timer(base::StringPrintf(
+        "Cookie_monster_startup_first_get_%s", kNames[by_key]).c_str());
+    EXPECT_FALSE(cm->GetCookies(DomainURL(kStoreDomains / 2)).empty());
+    first_timer.Done();
+
+    PerfTimeLogger all_timer(base::StringPrintf(
+        "Cookie_monster_startup_load_all_%s", kNames[by_key]).c_str());
+    EXPECT_EQ(static_cast<size_t>(kStoreDomains * kStoreCookiesPerDomain),
+              cm->GetAllCookies().size());
+    all_timer.Done();
+    LogMemoryGrowth(base::StringPrintf(
+        "Cookie_monster_startup_memory_%s", kNames[by_key]).c_str(),
+        memory_before);
+  }
+}
+
 } // namespace
@@ -4,6 +4,8 @@
 
 #include "net/base/cookie_monster_store_test.h"
 
+#include <algorithm>
+
 #include "base/message_loop.h"
 #include "base/stringprintf.h"
 #include "base/time.h"
@@ -102,16 +104,46 @@ void AddCookieToList(
   out_list->push_back(cookie.release());
 }
 
-MockSimplePersistentCookieStore::MockSimplePersistentCookieStore() {}
+MockSimplePersistentCookieStore::MockSimplePersistentCookieStore()
+    : load_by_key_(false),
+      load_called_(false) {
+}
 
 MockSimplePersistentCookieStore::~MockSimplePersistentCookieStore() {}
 
 bool MockSimplePersistentCookieStore::Load(
     std::vector<CookieMonster::CanonicalCookie*>* out_cookies) {
+  load_called_ = true;
   for (CanonicalCookieMap::const_iterator it = cookies_.begin();
-       it != cookies_.end(); it++)
+       it != cookies_.end(); it++) {
+    // Like a real store, skip what LoadCookiesForKey() handed out already.
+    const std::string key(
+        CookieMonster::GetEffectiveDomainKey(it->second.Domain()));
+    if (std::find(loaded_keys_.begin(), loaded_keys_.end(), key) !=
+        loaded_keys_.end())
+      continue;
     out_cookies->push_back(
         new CookieMonster::CanonicalCookie(it->second));
+  }
+  return true;
+}
+
+bool MockSimplePersistentCookieStore::LoadCookiesForKey(
+    const std::string& key,
+    std::vector<CookieMonster::CanonicalCookie*>* out_cookies) {
+  if (!load_by_key_)
+    return false;
+  EXPECT_FALSE(load_called_);
+  EXPECT_TRUE(std::find(loaded_keys_.begin(), loaded_keys_.end(), key) ==
+              loaded_keys_.end());
+  loaded_keys_.push_back(key);
+  for (CanonicalCookieMap::const_iterator it = cookies_.begin();
+       it != cookies_.end(); it++) {
+    if (CookieMonster::GetEffectiveDomainKey(it->second.Domain()) == key) {
+      out_cookies->push_back(
+          new CookieMonster::CanonicalCookie(it->second));
+    }
+  }
   return true;
 }
 
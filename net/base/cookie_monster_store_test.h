@@ -117,9 +117,22 @@ class MockSimplePersistentCookieStore
   MockSimplePersistentCookieStore();
   virtual ~MockSimplePersistentCookieStore();
 
+  // Makes LoadCookiesForKey() hand out the cookies under a key, rather than
+  // returning false.
+  void set_load_by_key(bool load_by_key) { load_by_key_ = load_by_key; }
+
+  // The keys passed to LoadCookiesForKey(), in order.
+  const std::vector<std::string>& loaded_keys() const { return loaded_keys_; }
+
+  bool load_called() const { return load_called_; }
+
   virtual bool Load(
       std::vector<CookieMonster::CanonicalCookie*>* out_cookies);
 
+  virtual bool LoadCookiesForKey(
+      const std::string& key,
+      std::vector<CookieMonster::CanonicalCookie*>* out_cookies);
+
   virtual void AddCookie(
       const CookieMonster::CanonicalCookie& cookie);
 
@@ -138,6 +151,10 @@ class MockSimplePersistentCookieStore
       CanonicalCookieMap;
 
   CanonicalCookieMap cookies_;
+
+  bool load_by_key_;
+  std::vector<std::string> loaded_keys_;
+  bool load_called_;
 };
 
 // Helper function for creating a CookieMonster backed by a
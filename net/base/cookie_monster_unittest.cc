@@ -1030,6 +1030,58 @@ TEST(CookieMonsterTest, TestLastAccess) {
   EXPECT_FALSE(last_access_date == GetFirstCookieAccessDate(cm));
 }
 
+// Test that repeated lookups see every change to the cookies for the site,
+// though the cookie line may be cached.
+TEST(CookieMonsterTest, CookieLineCache) {
+  GURL url_google(kUrlGoogle);
+  GURL url_google_foo("http://www.google.izzle/foo");
+  scoped_refptr<CookieMonster> cm(new CookieMonster(NULL, NULL));
+
+  EXPECT_EQ("", cm->GetCookies(url_google));
+  EXPECT_TRUE(cm->SetCookie(url_google, "A=B"));
+  EXPECT_EQ("A=B", cm->GetCookies(url_google));
+  EXPECT_EQ("A=B", cm->GetCookies(url_google));
+
+  // A domain cookie set from another host changes the line too.
+  EXPECT_TRUE(cm->SetCookie(GURL("http://mail.google.izzle"),
+                            "C=D; domain=.google.izzle"));
+  EXPECT_EQ("A=B; C=D", cm->GetCookies(url_google));
+
+  // Lines are cached per path.
+  EXPECT_TRUE(cm->SetCookie(url_google_foo, "E=F; path=/foo"));
+  EXPECT_EQ("E=F; A=B; C=D", cm->GetCookies(url_google_foo));
+  EXPECT_EQ("A=B; C=D", cm->GetCookies(url_google));
+
+  // And per httponly option.
+  CookieOptions options;
+  options.set_include_httponly();
+  EXPECT_TRUE(cm->SetCookieWithOptions(url_google, "G=H; httponly", options));
+  EXPECT_EQ("A=B; C=D", cm->GetCookies(url_google));
+  EXPECT_EQ("A=B; C=D; G=H", cm->GetCookiesWithOptions(url_google, options));
+
+  cm->DeleteCookie(url_google, "A");
+  EXPECT_EQ("C=D", cm->GetCookies(url_google));
+  EXPECT_EQ(3, cm->DeleteAll(false));
+  EXPECT_EQ("", cm->GetCookies(url_google));
+}
+
+// Test that a cached cookie line is not used past the expiry of a cookie in
+// it.
+TEST(CookieMonsterTest, CookieLineCacheExpiry) {
+  GURL url_google(kUrlGoogle);
+  scoped_refptr<CookieMonster> cm(new CookieMonster(NULL, NULL));
+
+  EXPECT_TRUE(cm->SetCookie(url_google, "A=B"));
+  EXPECT_TRUE(cm->SetCookieWithDetails(
+      url_google, "C", "D", std::string(), "/",
+      Time::Now() + TimeDelta::FromMilliseconds(100), false, false));
+  EXPECT_EQ("A=B; C=D", cm->GetCookies(url_google));
+
+  base::PlatformThread::Sleep(150);
+  EXPECT_EQ("A=B", cm->GetCookies(url_google));
+  EXPECT_EQ(1u, cm->GetAllCookies().size());
+}
+
 static int CountInString(const std::string& str, char c) {
   return std::count(str.begin(), str.end(), c);
 }
@@ -1902,6 +1954,62 @@ TEST(CookieMonsterTest, BackingStoreCommunication) {
   }
 }
 
+// Test that a lookup only reads the cookies for its own site from a store
+// that can load by key, and that the rest are read once they're all needed.
+TEST(CookieMonsterTest, LoadCookiesForKey) {
+  scoped_refptr<MockSimplePersistentCookieStore> store(
+      new MockSimplePersistentCookieStore);
+  base::Time now(base::Time::Now());
+  base::Time expires(now + base::TimeDelta::FromDays(30));
+  store->AddCookie(CookieMonster::CanonicalCookie(
+      GURL(), "A", "1", ".google.com", "/", now, expires, now,
+      false, false, true));
+  store->AddCookie(CookieMonster::CanonicalCookie(
+      GURL(), "B", "2", "www.mit.edu", "/",
+      now + base::TimeDelta::FromMicroseconds(1), expires, now,
+      false, false, true));
+  store->set_load_by_key(true);
+
+  scoped_refptr<CookieMonster> cm(new CookieMonster(store, NULL));
+  EXPECT_EQ("A=1", cm->GetCookies(GURL("http://www.google.com")));
+  ASSERT_EQ(1u, store->loaded_keys().size());
+  EXPECT_EQ("google.com", store->loaded_keys()[0]);
+  EXPECT_FALSE(store->load_called());
+
+  // Other hosts under the same key don't go back to the store.
+  EXPECT_EQ("A=1", cm->GetCookies(GURL("http://mail.google.com")));
+  EXPECT_TRUE(cm->SetCookie(GURL("http://www.google.com"),
+                            "C=3; max-age=1000"));
+  EXPECT_EQ(1u, store->loaded_keys().size());
+  EXPECT_FALSE(store->load_called());
+
+  // Listing every cookie loads the rest, without duplicating what was loaded
+  // already.
+  EXPECT_EQ(3u, cm->GetAllCookies().size());
+  EXPECT_TRUE(store->load_called());
+  EXPECT_EQ("B=2", cm->GetCookies(GURL("http://www.mit.edu")));
+  EXPECT_EQ(1u, store->loaded_keys().size());
+}
+
+// Test that the whole store is loaded when the keys don't match the ones the
+// store loads by.
+TEST(CookieMonsterTest, LoadCookiesForKeyNeedsETLDP1Keys) {
+  scoped_refptr<MockSimplePersistentCookieStore> store(
+      new MockSimplePersistentCookieStore);
+  base::Time now(base::Time::Now());
+  store->AddCookie(CookieMonster::CanonicalCookie(
+      GURL(), "A", "1", "www.google.com", "/", now,
+      now + base::TimeDelta::FromDays(30), now, false, false, true));
+  store->set_load_by_key(true);
+
+  scoped_refptr<CookieMonster> cm(new CookieMonster(store, NULL));
+  cm->SetExpiryAndKeyScheme(
+      CookieMonster::EKS_DISCARD_RECENT_AND_PURGE_DOMAIN);
+  EXPECT_EQ("A=1", cm->GetCookies(GURL("http://www.google.com")));
+  EXPECT_TRUE(store->loaded_keys().empty());
+  EXPECT_TRUE(store->load_called());
+}
+
 TEST(CookieMonsterTest, CookieOrdering) {
   // Put a random set of cookies into a monster and make sure
   // they're returned in the right order.
@@ -2034,8 +2142,13 @@ TEST(CookieMonsterTest, GarbageCollectionTriggers) {
       EXPECT_EQ(test_case->expected_initial_cookies,
                 static_cast<int>(cm->GetAllCookies().size()))
           << "For test case " << ci;
-      // Will trigger GC
-      cm->SetCookie(GURL("http://newdomain.com"), "b=2");
+      // Will trigger GC, which finishes over the next few sets.
+      for (size_t i = 0;
+           i <= CookieMonster::kPurgeCookies /
+               CookieMonster::kGlobalPurgeBatchCookies;
+           ++i) {
+        cm->SetCookie(GURL("http://newdomain.com"), "b=2");
+      }
       EXPECT_EQ(test_case->expected_cookies_after_set[recent_scheme],
                 static_cast<int>((cm->GetAllCookies().size())))
           << "For test case (" << ci << ", " << recent_scheme << ")";
@@ -2043,6 +2156,35 @@ TEST(CookieMonsterTest, GarbageCollectionTriggers) {
   }
 }
 
+// Test that global garbage collection evicts a bounded batch per call, and
+// never leaves more than kMaxCookies behind.
+TEST(CookieMonsterTest, GlobalGarbageCollectionIsIncremental) {
+  const size_t kNumCookies = CookieMonster::kMaxCookies + 1;
+  scoped_refptr<CookieMonster> cm(
+      CreateMonsterFromStoreForGC(
+          kNumCookies, kNumCookies,
+          CookieMonster::kSafeFromGlobalPurgeDays * 2));
+  EXPECT_EQ(kNumCookies, cm->GetAllCookies().size());
+
+  // The first set only evicts a batch.
+  EXPECT_TRUE(cm->SetCookie(GURL("http://newdomain.com"), "b=2"));
+  EXPECT_EQ(kNumCookies + 1 - CookieMonster::kGlobalPurgeBatchCookies,
+            cm->GetAllCookies().size());
+
+  // Later sets evict the rest, down to the purge goal and no further.
+  for (size_t i = 0; i < CookieMonster::kPurgeCookies; ++i)
+    EXPECT_TRUE(cm->SetCookie(GURL("http://newdomain.com"), "b=2"));
+  EXPECT_EQ(CookieMonster::kMaxCookies - CookieMonster::kPurgeCookies,
+            cm->GetAllCookies().size());
+
+  // A store far over the limit is brought back to kMaxCookies at once.
+  cm = CreateMonsterFromStoreForGC(
+      CookieMonster::kMaxCookies * 2, CookieMonster::kMaxCookies * 2,
+      CookieMonster::kSafeFromGlobalPurgeDays * 2);
+  EXPECT_TRUE(cm->SetCookie(GURL("http://newdomain.com"), "b=2"));
+  EXPECT_EQ(CookieMonster::kMaxCookies, cm->GetAllCookies().size());
+}
+
 // This test checks that setting a cookie forcing it to be a session only
 // cookie works as expected.
 TEST(CookieMonsterTest, ForceSessionOnly) {
@@ -82,9 +82,9 @@ bool DataURL::Parse(const GURL& url, std::string* mime_type,
         UnescapeRule::CONTROL_CHARS);
   }
 
-  // Strip whitespace.
-  if (base64_encoded || !(mime_type->compare(0, 5, "text/") == 0 ||
-                          mime_type->find("xml") != std::string::npos)) {
+  // Strip whitespace.  Base64 decoding skips it as it goes.
+  if (!base64_encoded && !(mime_type->compare(0, 5, "text/") == 0 ||
+                           mime_type->find("xml") != std::string::npos)) {
     temp_data.erase(std::remove_if(temp_data.begin(), temp_data.end(),
                                    IsAsciiWhitespace<wchar_t>),
                     temp_data.end());
@@ -97,7 +97,7 @@ bool DataURL::Parse(const GURL& url, std::string* mime_type,
   }
 
   if (base64_encoded)
-    return base::Base64Decode(temp_data, data);
+    return base::Base64DecodeIgnoringWhitespace(temp_data, data);
 
   temp_data.swap(*data);
   return true;
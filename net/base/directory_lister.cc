@@ -4,9 +4,18 @@
 
 #include "net/base/directory_lister.h"
 
+#if defined(OS_POSIX)
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#endif
+
 #include <algorithm>
 #include <vector>
 
+#if defined(OS_POSIX)
+#include "base/dir_reader_posix.h"
+#endif
 #include "base/file_util.h"
 #include "base/i18n/file_util_icu.h"
 #include "base/message_loop.h"
@@ -16,14 +25,16 @@
 
 namespace net {
 
-static const int kFilesPerEvent = 8;
+// Without sorting, entries are posted to the delegate in batches of this size
+// as they are read.
+static const size_t kFilesPerEvent = 64;
 
 // A task which is used to signal the delegate asynchronously.
 class DirectoryDataEvent : public Task {
 public:
   explicit DirectoryDataEvent(DirectoryLister* d) : lister(d), error(0) {
     // Allocations of the FindInfo aren't super cheap, so reserve space.
-    data.reserve(64);
+    data.reserve(kFilesPerEvent);
   }
 
   void Run() {
@@ -107,30 +118,29 @@ void DirectoryLister::ThreadMain() {
   if (!recursive_)
     types |= file_util::FileEnumerator::INCLUDE_DOT_DOT;
 
-  file_util::FileEnumerator file_enum(dir_, recursive_,
-      static_cast<file_util::FileEnumerator::FILE_TYPE>(types));
+  bool listed = false;
+#if defined(OS_POSIX)
+  if (sort_ == NO_SORT && !recursive_)
+    listed = ReadDirectoryEntries(&e);
+#endif
 
-  FilePath path;
-  while (!canceled_.IsSet() && !(path = file_enum.Next()).empty()) {
-    DirectoryListerData data;
-    file_enum.GetFindInfo(&data.info);
-    data.path = path;
-    e->data.push_back(data);
-
-    /* TODO(brettw) bug 24107: It would be nice to send incremental updates.
-       We gather them all so they can be sorted, but eventually the sorting
-       should be done from JS to give more flexibility in the page. When we do
-       that, we can uncomment this to send incremental updates to the page.
-    if (++e->count == kFilesPerEvent) {
-      message_loop_->PostTask(FROM_HERE, e);
-      e = new DirectoryDataEvent(this);
+  if (!listed) {
+    file_util::FileEnumerator file_enum(dir_, recursive_,
+        static_cast<file_util::FileEnumerator::FILE_TYPE>(types));
+
+    FilePath path;
+    while (!canceled_.IsSet() && !(path = file_enum.Next()).empty()) {
+      DirectoryListerData data;
+      file_enum.GetFindInfo(&data.info);
+      data.path = path;
+      AddEntry(&e, data);
     }
-    */
   }
 
   if (!e->data.empty()) {
-    // Sort the results. See the TODO above (this sort should be removed and we
-    // should do it from JS).
+    // Sort the results. TODO(brettw) bug 24107: The sorting should eventually
+    // be done from JS, with NO_SORT, so that the page gets incremental
+    // updates.
     if (sort_ == DATE)
       std::sort(e->data.begin(), e->data.end(), CompareDate);
     else if (sort_ == FULL_PATH)
@@ -149,6 +159,39 @@ void DirectoryLister::ThreadMain() {
   message_loop_->PostTask(FROM_HERE, e);
 }
 
+void DirectoryLister::AddEntry(DirectoryDataEvent** e,
+                               const DirectoryListerData& data) {
+  (*e)->data.push_back(data);
+  // Sorting needs the whole listing.
+  if (sort_ == NO_SORT && (*e)->data.size() == kFilesPerEvent) {
+    message_loop_->PostTask(FROM_HERE, *e);
+    *e = new DirectoryDataEvent(this);
+  }
+}
+
+#if defined(OS_POSIX)
+bool DirectoryLister::ReadDirectoryEntries(DirectoryDataEvent** e) {
+  base::DirReaderPosix reader(dir_.value().c_str());
+  if (!reader.IsValid())
+    return false;
+
+  while (!canceled_.IsSet() && reader.Next()) {
+    const char* name = reader.name();
+    // Like FileEnumerator with INCLUDE_DOT_DOT, list ".." but not ".".
+    if (!strcmp(name, "."))
+      continue;
+
+    DirectoryListerData data;
+    data.info.filename = name;
+    if (fstatat(reader.fd(), name, &data.info.stat, 0) < 0)
+      memset(&data.info.stat, 0, sizeof(data.info.stat));
+    data.path = dir_.Append(name);
+    AddEntry(e, data);
+  }
+  return true;
+}
+#endif
+
 DirectoryLister::~DirectoryLister() {
   if (thread_) {
     // This is a bug and we should stop joining this thread.
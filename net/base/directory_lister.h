@@ -19,6 +19,8 @@ class MessageLoop;
 
 namespace net {
 
+class DirectoryDataEvent;
+
 //
 // This class provides an API for listing the contents of a directory on the
 // filesystem asynchronously.  It spawns a background thread, and enumerates
@@ -53,6 +55,8 @@ class DirectoryLister : public base::RefCountedThreadSafe<DirectoryLister>,
   //   directories first in name order, then files by name order
   // FULL_PATH sorts by paths as strings, ignoring files v. directories
   // DATE sorts by last modified date
+  // NO_SORT leaves sorting to the delegate, and streams the entries to it in
+  //   batches as they are read, instead of after the whole listing
   enum SORT_TYPE {
     NO_SORT,
     DATE,
@@ -98,6 +102,18 @@ class DirectoryLister : public base::RefCountedThreadSafe<DirectoryLister>,
   static bool CompareFullPath(const DirectoryListerData& a,
                               const DirectoryListerData& b);
 
+  // Adds |data| to |*e|.  When streaming, posts |*e| once it holds a full
+  // batch, and replaces it with a new event.
+  void AddEntry(DirectoryDataEvent** e, const DirectoryListerData& data);
+
+#if defined(OS_POSIX)
+  // Adds the entries of |dir_| as they are read, a few kilobytes of them at a
+  // time, rather than reading the whole directory first like FileEnumerator
+  // does.  Non-recursive only.  Returns false if this isn't supported on this
+  // platform.
+  bool ReadDirectoryEntries(DirectoryDataEvent** e);
+#endif
+
   void OnReceivedData(const DirectoryListerData* data, int count);
   void OnDone(int error);
 
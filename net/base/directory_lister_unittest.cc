@@ -2,12 +2,16 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <set>
+
 #include "base/file_path.h"
 #include "base/file_util.h"
 #include "base/i18n/file_util_icu.h"
 #include "base/logging.h"
+#include "base/memory/scoped_temp_dir.h"
 #include "base/message_loop.h"
 #include "base/path_service.h"
+#include "base/stringprintf.h"
 #include "net/base/directory_lister.h"
 #include "net/base/net_errors.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -100,6 +104,55 @@ TEST(DirectoryListerTest, BigDirRecursiveTest) {
   EXPECT_EQ(delegate.error(), OK);
 }
 
+// Collects the entries, in whatever order they come.
+class UnsortedListerDelegate : public DirectoryLister::DirectoryListerDelegate {
+ public:
+  UnsortedListerDelegate() : error_(-1) {}
+  void OnListFile(const DirectoryLister::DirectoryListerData& data) {
+    EXPECT_TRUE(paths_.insert(data.path).second);
+    EXPECT_EQ(data.path.BaseName().value(), data.info.filename);
+  }
+  void OnListDone(int error) {
+    error_ = error;
+    MessageLoop::current()->Quit();
+  }
+  int error() const { return error_; }
+  const std::set<FilePath>& paths() const { return paths_; }
+ private:
+  int error_;
+  std::set<FilePath> paths_;
+};
+
+TEST(DirectoryListerTest, NoSortTest) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+
+  // Enough entries for several batches.
+  std::set<FilePath> expected;
+  expected.insert(temp_dir.path().Append(FilePath::kParentDirectory));
+  for (int i = 0; i < 200; i++) {
+    FilePath file =
+        temp_dir.path().AppendASCII(base::StringPrintf("file%d", i));
+    ASSERT_EQ(1, file_util::WriteFile(file, "a", 1));
+    expected.insert(file);
+  }
+  FilePath dir = temp_dir.path().AppendASCII("dir");
+  ASSERT_TRUE(file_util::CreateDirectory(dir));
+  expected.insert(dir);
+
+  UnsortedListerDelegate delegate;
+  scoped_refptr<DirectoryLister> lister(
+      new DirectoryLister(temp_dir.path(), false, DirectoryLister::NO_SORT,
+                          &delegate));
+
+  lister->Start();
+
+  MessageLoop::current()->Run();
+
+  EXPECT_EQ(delegate.error(), OK);
+  EXPECT_TRUE(delegate.paths() == expected);
+}
+
 TEST(DirectoryListerTest, CancelTest) {
   FilePath path;
   ASSERT_TRUE(PathService::Get(base::DIR_SOURCE_ROOT, &path));
@@ -0,0 +1,167 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/dns_config.h"
+
+#if defined(ANDROID)
+#include <cutils/properties.h>
+#endif
+
+#include <algorithm>
+
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/string_number_conversions.h"
+#include "base/string_split.h"
+#include "base/string_util.h"
+
+namespace net {
+
+namespace {
+
+const int kDnsPort = 53;
+
+// The resolv.conf defaults, see resolv.conf(5).
+const int kDefaultNdots = 1;
+const int kDefaultTimeoutSeconds = 5;
+const int kDefaultAttempts = 2;
+
+// The most name servers the system resolver will use.
+const size_t kMaxNameservers = 3;
+
+// The most attempts and the longest timeout resolv.conf may ask for.
+const int kMaxAttempts = 5;
+const int kMaxTimeoutSeconds = 30;
+
+// Splits |line| into whitespace separated words, dropping any comment.
+void SplitLine(const std::string& line, std::vector<std::string>* words) {
+  std::string::size_type comment = line.find_first_of("#;");
+  base::SplitStringAlongWhitespace(line.substr(0, comment), words);
+}
+
+// Parses the "name:value" option |option| if its name is |name|.  The value is
+// clamped to [|min|, |max|].
+bool ParseIntOption(const std::string& option, const char* name, int min,
+                    int max, int* value) {
+  std::string prefix = std::string(name) + ":";
+  if (!StartsWithASCII(option, prefix, true))
+    return false;
+  int parsed;
+  if (!base::StringToInt(option.substr(prefix.size()), &parsed))
+    return false;
+  *value = std::max(min, std::min(max, parsed));
+  return true;
+}
+
+#if defined(ANDROID)
+// Android has no resolv.conf; the name servers are system properties.
+void ReadAndroidNameservers(DnsConfig* config) {
+  static const char* const kProperties[] = { "net.dns1", "net.dns2" };
+  for (size_t i = 0; i < arraysize(kProperties); ++i) {
+    char value[PROPERTY_VALUE_MAX];
+    if (property_get(kProperties[i], value, NULL) <= 0)
+      continue;
+    IPAddressNumber address;
+    if (ParseIPLiteralToNumber(value, &address))
+      config->nameservers.push_back(IPEndPoint(address, kDnsPort));
+  }
+}
+#endif
+
+}  // namespace
+
+DnsConfig::DnsConfig()
+    : ndots(kDefaultNdots),
+      timeout(base::TimeDelta::FromSeconds(kDefaultTimeoutSeconds)),
+      attempts(kDefaultAttempts),
+      rotate(false) {
+}
+
+DnsConfig::~DnsConfig() {}
+
+bool ParseResolvConf(const std::string& contents, DnsConfig* config) {
+  std::vector<std::string> lines;
+  base::SplitString(contents, '\n', &lines);
+  for (size_t i = 0; i < lines.size(); ++i) {
+    std::vector<std::string> words;
+    SplitLine(lines[i], &words);
+    if (words.empty())
+      continue;
+
+    const std::string& keyword = words[0];
+    if (keyword == "nameserver" && words.size() >= 2) {
+      IPAddressNumber address;
+      if (config->nameservers.size() < kMaxNameservers &&
+          ParseIPLiteralToNumber(words[1], &address)) {
+        config->nameservers.push_back(IPEndPoint(address, kDnsPort));
+      }
+    } else if (keyword == "search" || keyword == "domain") {
+      // The last search or domain line wins.
+      config->search.assign(words.begin() + 1, words.end());
+      if (keyword == "domain" && config->search.size() > 1)
+        config->search.resize(1);
+    } else if (keyword == "options") {
+      for (size_t j = 1; j < words.size(); ++j) {
+        int timeout_seconds;
+        if (words[j] == "rotate") {
+          config->rotate = true;
+        } else if (ParseIntOption(words[j], "timeout", 1, kMaxTimeoutSeconds,
+                                  &timeout_seconds)) {
+          config->timeout = base::TimeDelta::FromSeconds(timeout_seconds);
+        } else if (!ParseIntOption(words[j], "ndots", 0, 15,
+                                   &config->ndots)) {
+          ParseIntOption(words[j], "attempts", 1, kMaxAttempts,
+                         &config->attempts);
+        }
+      }
+    }
+  }
+  return !config->nameservers.empty();
+}
+
+void ParseHosts(const std::string& contents, DnsHosts* hosts) {
+  std::vector<std::string> lines;
+  base::SplitString(contents, '\n', &lines);
+  for (size_t i = 0; i < lines.size(); ++i) {
+    std::vector<std::string> words;
+    SplitLine(lines[i], &words);
+    IPAddressNumber address;
+    if (words.size() < 2 || !ParseIPLiteralToNumber(words[0], &address))
+      continue;
+    AddressFamily family = address.size() == kIPv4AddressSize ?
+        ADDRESS_FAMILY_IPV4 : ADDRESS_FAMILY_IPV6;
+    for (size_t j = 1; j < words.size(); ++j) {
+      DnsHostsKey key(StringToLowerASCII(words[j]), family);
+      // Keep the first address, as the system resolver does.
+      hosts->insert(std::make_pair(key, address));
+    }
+  }
+}
+
+bool ReadSystemDnsConfig(DnsConfig* config, DnsHosts* hosts) {
+#if defined(ANDROID)
+  ReadAndroidNameservers(config);
+  std::string hosts_contents;
+  if (file_util::ReadFileToString(FilePath("/system/etc/hosts"),
+                                  &hosts_contents)) {
+    ParseHosts(hosts_contents, hosts);
+  }
+  return !config->nameservers.empty();
+#elif defined(OS_POSIX)
+  std::string contents;
+  if (!file_util::ReadFileToString(FilePath("/etc/resolv.conf"), &contents) ||
+      !ParseResolvConf(contents, config)) {
+    return false;
+  }
+  std::string hosts_contents;
+  if (file_util::ReadFileToString(FilePath("/etc/hosts"), &hosts_contents))
+    ParseHosts(hosts_contents, hosts);
+  return true;
+#else
+  // Windows keeps its name servers in the registry, which isn't read yet.
+  return false;
+#endif
+}
+
+}  // namespace net
@@ -0,0 +1,66 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_BASE_DNS_CONFIG_H_
+#define NET_BASE_DNS_CONFIG_H_
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/time.h"
+#include "net/base/address_family.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_util.h"
+
+namespace net {
+
+// The settings of the system's stub resolver, as found in resolv.conf.
+struct DnsConfig {
+  DnsConfig();
+  ~DnsConfig();
+
+  // The name servers to query, in order.
+  std::vector<IPEndPoint> nameservers;
+
+  // The suffixes to try for names that aren't fully qualified.
+  std::vector<std::string> search;
+
+  // Names with at least |ndots| dots are first tried as they are, before the
+  // suffixes in |search|.
+  int ndots;
+
+  // How long to wait for an answer from a name server, on the first round.
+  base::TimeDelta timeout;
+
+  // How many rounds of queries to make through all the name servers.
+  int attempts;
+
+  // True if queries should be spread over the name servers, instead of always
+  // starting with the first one.
+  bool rotate;
+};
+
+// The entries of a hosts file, keyed by lower-case name and address family.
+// Only the first address listed for each name and family is kept.
+typedef std::pair<std::string, AddressFamily> DnsHostsKey;
+typedef std::map<DnsHostsKey, IPAddressNumber> DnsHosts;
+
+// Parses the contents of a resolv.conf file into |config|.  Returns false if
+// no usable name server is listed.
+bool ParseResolvConf(const std::string& contents, DnsConfig* config);
+
+// Parses the contents of a hosts file into |hosts|.
+void ParseHosts(const std::string& contents, DnsHosts* hosts);
+
+// Reads the configuration of the system resolver and the hosts file.  This
+// does blocking file I/O, so must not be called on the IO thread.  Returns
+// false if there is no configuration to use on this platform.
+bool ReadSystemDnsConfig(DnsConfig* config, DnsHosts* hosts);
+
+}  // namespace net
+
+#endif  // NET_BASE_DNS_CONFIG_H_
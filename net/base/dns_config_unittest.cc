@@ -0,0 +1,117 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/dns_config.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+IPEndPoint MakeEndPoint(const std::string& ip, int port) {
+  IPAddressNumber address;
+  EXPECT_TRUE(ParseIPLiteralToNumber(ip, &address));
+  return IPEndPoint(address, port);
+}
+
+TEST(DnsConfigTest, Defaults) {
+  DnsConfig config;
+  EXPECT_TRUE(config.nameservers.empty());
+  EXPECT_TRUE(config.search.empty());
+  EXPECT_EQ(1, config.ndots);
+  EXPECT_EQ(5, config.timeout.InSeconds());
+  EXPECT_EQ(2, config.attempts);
+  EXPECT_FALSE(config.rotate);
+}
+
+TEST(DnsConfigTest, ParseResolvConf) {
+  const char kContents[] =
+      "# Generated by NetworkManager\n"
+      "nameserver 192.168.1.1\n"
+      "nameserver   2001:db8::1  # IPv6 works too\n"
+      "nameserver not.an.address\n"
+      "; another comment\n"
+      "search example.com corp.example.com\n"
+      "options ndots:2 timeout:3 attempts:4 rotate debug\n";
+  DnsConfig config;
+  ASSERT_TRUE(ParseResolvConf(kContents, &config));
+
+  ASSERT_EQ(2u, config.nameservers.size());
+  EXPECT_TRUE(config.nameservers[0] == MakeEndPoint("192.168.1.1", 53));
+  EXPECT_TRUE(config.nameservers[1] == MakeEndPoint("2001:db8::1", 53));
+  ASSERT_EQ(2u, config.search.size());
+  EXPECT_EQ("example.com", config.search[0]);
+  EXPECT_EQ("corp.example.com", config.search[1]);
+  EXPECT_EQ(2, config.ndots);
+  EXPECT_EQ(3, config.timeout.InSeconds());
+  EXPECT_EQ(4, config.attempts);
+  EXPECT_TRUE(config.rotate);
+}
+
+TEST(DnsConfigTest, ParseResolvConfLimits) {
+  const char kContents[] =
+      "nameserver 10.0.0.1\n"
+      "nameserver 10.0.0.2\n"
+      "nameserver 10.0.0.3\n"
+      "nameserver 10.0.0.4\n"
+      "search ignored.example.com\n"
+      "domain first.example.com second.example.com\n"
+      "options timeout:100 attempts:0 ndots:x\n";
+  DnsConfig config;
+  ASSERT_TRUE(ParseResolvConf(kContents, &config));
+
+  // Only the first three name servers are used.
+  ASSERT_EQ(3u, config.nameservers.size());
+  EXPECT_TRUE(config.nameservers[2] == MakeEndPoint("10.0.0.3", 53));
+  // The last of search and domain wins, and domain takes a single suffix.
+  ASSERT_EQ(1u, config.search.size());
+  EXPECT_EQ("first.example.com", config.search[0]);
+  // Options are clamped, and the bad one is ignored.
+  EXPECT_EQ(30, config.timeout.InSeconds());
+  EXPECT_EQ(1, config.attempts);
+  EXPECT_EQ(1, config.ndots);
+}
+
+TEST(DnsConfigTest, ParseResolvConfNoNameservers) {
+  DnsConfig config;
+  EXPECT_FALSE(ParseResolvConf("", &config));
+  EXPECT_FALSE(ParseResolvConf("search example.com\n", &config));
+  EXPECT_FALSE(ParseResolvConf("nameserver localhost\n", &config));
+}
+
+TEST(DnsConfigTest, ParseHosts) {
+  const char kContents[] =
+      "127.0.0.1 localhost  # loopback\n"
+      "::1 localhost ip6-localhost\n"
+      "\n"
+      "# 10.0.0.9 commented.example.com\n"
+      "10.0.0.1\tFoo.Example.COM foo\n"
+      "10.0.0.2 foo.example.com\n"
+      "bogus bogus.example.com\n"
+      "10.0.0.3\n";
+  DnsHosts hosts;
+  ParseHosts(kContents, &hosts);
+  EXPECT_EQ(5u, hosts.size());
+
+  IPAddressNumber address;
+  ASSERT_TRUE(ParseIPLiteralToNumber("127.0.0.1", &address));
+  EXPECT_TRUE(hosts[DnsHostsKey("localhost", ADDRESS_FAMILY_IPV4)] ==
+              address);
+  ASSERT_TRUE(ParseIPLiteralToNumber("::1", &address));
+  EXPECT_TRUE(hosts[DnsHostsKey("localhost", ADDRESS_FAMILY_IPV6)] ==
+              address);
+  EXPECT_TRUE(hosts[DnsHostsKey("ip6-localhost", ADDRESS_FAMILY_IPV6)] ==
+              address);
+
+  // Names are lower-cased, and the first address listed wins.
+  ASSERT_TRUE(ParseIPLiteralToNumber("10.0.0.1", &address));
+  EXPECT_TRUE(hosts[DnsHostsKey("foo.example.com", ADDRESS_FAMILY_IPV4)] ==
+              address);
+  EXPECT_TRUE(hosts[DnsHostsKey("foo", ADDRESS_FAMILY_IPV4)] == address);
+}
+
+}  // namespace
+
+}  // namespace net
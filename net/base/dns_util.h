@@ -9,6 +9,7 @@
 #include <string>
 
 #include "base/basictypes.h"
+#include "base/string_piece.h"
 
 namespace net {
 
@@ -34,8 +35,10 @@ std::string TrimEndingDot(const std::string& host);
 // WARNING: if you're adding any new values here you may need to add them to
 // dnsrr_resolver.cc:DnsRRIsParsedByWindows.
 
+static const uint16 kDNS_A = 1;
 static const uint16 kDNS_CNAME = 5;
 static const uint16 kDNS_TXT = 16;
+static const uint16 kDNS_AAAA = 28;
 static const uint16 kDNS_CERT = 37;
 static const uint16 kDNS_DS = 43;
 static const uint16 kDNS_RRSIG = 46;
@@ -44,6 +47,9 @@ static const uint16 kDNS_ANY = 0xff;
 static const uint16 kDNS_CAA = 13172;  // temporary, not IANA
 static const uint16 kDNS_TESTING = 0xfffe;  // in private use area.
 
+// The Internet class, the only one we ever query.
+static const uint16 kClassIN = 1;
+
 // http://www.iana.org/assignments/dns-sec-alg-numbers/dns-sec-alg-numbers.xhtml
 static const uint8 kDNSSEC_RSA_SHA1 = 5;
 static const uint8 kDNSSEC_RSA_SHA1_NSEC3 = 7;
@@ -53,6 +59,31 @@ static const uint8 kDNSSEC_RSA_SHA256 = 8;
 static const uint8 kDNSSEC_SHA1 = 1;
 static const uint8 kDNSSEC_SHA256 = 2;
 
+// A DnsResponseBuffer is used for walking over a DNS packet.  Each accessor
+// consumes what it reads, and returns false if the packet is too short.
+class DnsResponseBuffer {
+ public:
+  DnsResponseBuffer(const uint8* p, unsigned len);
+
+  bool U8(uint8* v);
+  bool U16(uint16* v);
+  bool U32(uint32* v);
+  bool Skip(unsigned n);
+  bool Block(base::StringPiece* out, unsigned len);
+
+  // DNSName parses a (possibly compressed) DNS name from the packet. If |name|
+  // is not NULL, then the name is written into it. See RFC 1035 section 4.1.4.
+  bool DNSName(std::string* name);
+
+ private:
+  const uint8* p_;
+  const uint8* const packet_;
+  unsigned len_;
+  const unsigned packet_len_;
+
+  DISALLOW_COPY_AND_ASSIGN(DnsResponseBuffer);
+};
+
 }  // namespace net
 
 #endif  // NET_BASE_DNS_UTIL_H_
@@ -12,6 +12,7 @@
 #include <windns.h>
 #endif
 
+#include "base/compiler_specific.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/singleton.h"
 #include "base/message_loop.h"
@@ -20,6 +21,7 @@
 #include "base/synchronization/lock.h"
 #include "base/task.h"
 #include "base/threading/worker_pool.h"
+#include "net/base/async_dns_resolver.h"
 #include "net/base/dns_reload_timer.h"
 #include "net/base/dns_util.h"
 #include "net/base/net_errors.h"
@@ -60,6 +62,11 @@
 //
 //
 //
+// The worker isn't created by Resolve() itself, but by StartPendingLookups(),
+// which Resolve() posts so that all the record types wanted for a name in the
+// same task are looked up by one worker.  With an AsyncDnsResolver set, an
+// RRResolverBatch sends them all at once instead.
+//
 // A cache hit:
 //
 // DnsRRResolver                       Handle
@@ -86,6 +93,8 @@ namespace net {
 static bool DnsRRIsParsedByWindows(uint16 rrtype) {
   // We only cover the types which are defined in dns_util.h
   switch (rrtype) {
+    case kDNS_A:
+    case kDNS_AAAA:
     case kDNS_CNAME:
     case kDNS_TXT:
     case kDNS_DS:
@@ -98,8 +107,16 @@ static bool DnsRRIsParsedByWindows(uint16 rrtype) {
 }
 #endif
 
-static const uint16 kClassIN = 1;
-// kMaxCacheEntries is the number of RRResponse objects that we'll cache.
+// IsTestQuery returns true if the query is one that unittests make, which only
+// the worker answers.  Any record type may be asked for the test names.
+static bool IsTestQuery(const std::string& name, uint16 rrtype) {
+  return rrtype == kDNS_TESTING ||
+         name == "www.testing.notatld" ||
+         name == "nx.testing.notatld";
+}
+
+// kMaxCacheEntries is the number of RRResponse objects that we'll cache by
+// default.
 static const unsigned kMaxCacheEntries = 32;
 // kNegativeTTLSecs is the number of seconds for which we'll cache a negative
 // cache entry.
@@ -142,18 +159,20 @@ class RRResolverHandle {
 
 
 // RRResolverWorker runs on a worker thread and takes care of the blocking
-// process of performing the DNS resolution.
+// process of performing the DNS resolution.  The record types for a name are
+// looked up one after the other on the same thread.
 class RRResolverWorker {
  public:
-  RRResolverWorker(const std::string& name, uint16 rrtype, uint16 flags,
+  RRResolverWorker(const std::string& name,
+                   const std::vector<uint16>& rrtypes,
                    DnsRRResolver* dnsrr_resolver)
       : name_(name),
-        rrtype_(rrtype),
-        flags_(flags),
+        rrtypes_(rrtypes),
         origin_loop_(MessageLoop::current()),
         dnsrr_resolver_(dnsrr_resolver),
         canceled_(false),
-        result_(ERR_UNEXPECTED) {
+        results_(rrtypes.size(), ERR_UNEXPECTED),
+        responses_(rrtypes.size()) {
   }
 
   bool Start() {
@@ -173,17 +192,18 @@ class RRResolverWorker {
   }
 
  private:
-
-#if defined(OS_POSIX) && !defined(ANDROID)
-
   void Run() {
     // Runs on a worker thread.
-
-    if (HandleTestCases()) {
-      Finish();
-      return;
+    for (size_t i = 0; i < rrtypes_.size(); ++i) {
+      if (!HandleTestCases(rrtypes_[i], &results_[i], &responses_[i]))
+        Lookup(rrtypes_[i], &results_[i], &responses_[i]);
     }
+    Finish();
+  }
+
+#if defined(OS_POSIX) && !defined(ANDROID)
 
+  void Lookup(uint16 rrtype, int* result, RRResponse* response) {
     bool r = true;
     if ((_res.options & RES_INIT) == 0) {
       if (res_ninit(&_res) != 0)
@@ -192,7 +212,7 @@ class RRResolverWorker {
 
     if (r) {
       unsigned long saved_options = _res.options;
-      r = Do();
+      r = Do(rrtype, response);
 
 #if defined(OS_POSIX) && !defined(OS_MACOSX) && !defined(OS_OPENBSD)
       if (!r && DnsReloadTimerHasExpired()) {
@@ -202,26 +222,24 @@ class RRResolverWorker {
         if (_res.nscount > 0)
           res_nclose(&_res);
         if (res_ninit(&_res) == 0)
-          r = Do();
+          r = Do(rrtype, response);
       }
 #endif
       _res.options = saved_options;
     }
 
-    response_.fetch_time = base::Time::Now();
+    response->fetch_time = base::Time::Now();
 
     if (r) {
-      result_ = OK;
+      *result = OK;
     } else {
-      result_ = ERR_NAME_NOT_RESOLVED;
-      response_.negative = true;
-      response_.ttl = kNegativeTTLSecs;
+      *result = ERR_NAME_NOT_RESOLVED;
+      response->negative = true;
+      response->ttl = kNegativeTTLSecs;
     }
-
-    Finish();
   }
 
-  bool Do() {
+  bool Do(uint16 rrtype, RRResponse* response) {
     // For DNSSEC, a 4K buffer is suggested
     static const unsigned kMaxDNSPayload = 4096;
 
@@ -241,58 +259,47 @@ class RRResolverWorker {
     // options: RES_DEFNAMES and RES_DNSRCH (see res_init(3)).
     _res.options = RES_INIT | RES_RECURSE | RES_USE_EDNS0 | RES_USE_DNSSEC;
     uint8 answer[kMaxDNSPayload];
-    int len = res_search(name_.c_str(), kClassIN, rrtype_, answer,
+    int len = res_search(name_.c_str(), kClassIN, rrtype, answer,
                          sizeof(answer));
     if (len == -1)
       return false;
 
-    return response_.ParseFromResponse(answer, len, rrtype_);
+    return response->ParseFromResponse(answer, len, rrtype);
   }
 
 #elif defined(ANDROID)
 
-  void Run() {
-    if (HandleTestCases()) {
-      Finish();
-      return;
-    }
-
-    response_.fetch_time = base::Time::Now();
-    response_.negative = true;
-    result_ = ERR_NAME_NOT_RESOLVED;
-    Finish();
+  void Lookup(uint16 rrtype, int* result, RRResponse* response) {
+    response->fetch_time = base::Time::Now();
+    response->negative = true;
+    *result = ERR_NAME_NOT_RESOLVED;
   }
 
 #else  // OS_WIN
 
-  void Run() {
-    if (HandleTestCases()) {
-      Finish();
-      return;
-    }
-
+  void Lookup(uint16 rrtype, int* result, RRResponse* response) {
     // See http://msdn.microsoft.com/en-us/library/ms682016(v=vs.85).aspx
     PDNS_RECORD record = NULL;
     DNS_STATUS status =
-        DnsQuery_A(name_.c_str(), rrtype_, DNS_QUERY_STANDARD,
+        DnsQuery_A(name_.c_str(), rrtype, DNS_QUERY_STANDARD,
                    NULL /* pExtra (reserved) */, &record, NULL /* pReserved */);
-    response_.fetch_time = base::Time::Now();
-    response_.name = name_;
-    response_.dnssec = false;
-    response_.ttl = 0;
+    response->fetch_time = base::Time::Now();
+    response->name = name_;
+    response->dnssec = false;
+    response->ttl = 0;
 
     if (status != 0) {
-      response_.negative = true;
-      result_ = ERR_NAME_NOT_RESOLVED;
+      response->negative = true;
+      *result = ERR_NAME_NOT_RESOLVED;
     } else {
-      response_.negative = false;
-      result_ = OK;
+      response->negative = false;
+      *result = OK;
       for (DNS_RECORD* cur = record; cur; cur = cur->pNext) {
-        if (cur->wType == rrtype_) {
-          response_.ttl = record->dwTtl;
+        if (cur->wType == rrtype) {
+          response->ttl = record->dwTtl;
           // Windows will parse some types of resource records. If we want one
           // of these types then we have to reserialise the record.
-          switch (rrtype_) {
+          switch (rrtype) {
             case kDNS_TXT: {
               // http://msdn.microsoft.com/en-us/library/ms682109(v=vs.85).aspx
               const DNS_TXT_DATA* txt = &cur->Data.TXT;
@@ -310,19 +317,19 @@ class RRResolverWorker {
                 rrdata.push_back(len8);
                 rrdata += s;
               }
-              response_.rrdatas.push_back(rrdata);
+              response->rrdatas.push_back(rrdata);
               break;
             }
             default:
-              if (DnsRRIsParsedByWindows(rrtype_)) {
+              if (DnsRRIsParsedByWindows(rrtype)) {
                 // Windows parses this type, but we don't have code to unparse
                 // it.
                 NOTREACHED() << "you need to add code for the RR type here";
-                response_.negative = true;
-                result_ = ERR_INVALID_ARGUMENT;
+                response->negative = true;
+                *result = ERR_INVALID_ARGUMENT;
               } else {
                 // This type is given to us raw.
-                response_.rrdatas.push_back(
+                response->rrdatas.push_back(
                     std::string(reinterpret_cast<char*>(&cur->Data),
                                 cur->wDataLength));
               }
@@ -332,26 +339,25 @@ class RRResolverWorker {
     }
 
     DnsRecordListFree(record, DnsFreeRecordList);
-    Finish();
   }
 
 #endif  // OS_WIN
 
   // HandleTestCases stuffs in magic test values in the event that the query is
   // from a unittest.
-  bool HandleTestCases() {
-    if (rrtype_ == kDNS_TESTING) {
-      response_.fetch_time = base::Time::Now();
+  bool HandleTestCases(uint16 rrtype, int* result, RRResponse* response) {
+    if (IsTestQuery(name_, rrtype)) {
+      response->fetch_time = base::Time::Now();
 
       if (name_ == "www.testing.notatld") {
-        response_.ttl = 86400;
-        response_.negative = false;
-        response_.rrdatas.push_back("goats!");
-        result_ = OK;
+        response->ttl = 86400;
+        response->negative = false;
+        response->rrdatas.push_back("goats!");
+        *result = OK;
         return true;
       } else if (name_ == "nx.testing.notatld") {
-        response_.negative = true;
-        result_ = ERR_NAME_NOT_RESOLVED;
+        response->negative = true;
+        *result = ERR_NAME_NOT_RESOLVED;
         return true;
       }
     }
@@ -362,14 +368,18 @@ class RRResolverWorker {
   // DoReply runs on the origin thread.
   void DoReply() {
     DCHECK_EQ(MessageLoop::current(), origin_loop_);
+    bool canceled;
     {
       // We lock here because the worker thread could still be in Finished,
       // after the PostTask, but before unlocking |lock_|. If we do not lock in
       // this case, we will end up deleting a locked Lock, which can lead to
       // memory leaks or worse errors.
       base::AutoLock locked(lock_);
-      if (!canceled_)
-        dnsrr_resolver_->HandleResult(name_, rrtype_, result_, response_);
+      canceled = canceled_;
+    }
+    if (!canceled) {
+      dnsrr_resolver_->workers_.erase(this);
+      dnsrr_resolver_->HandleResults(name_, rrtypes_, results_, responses_);
     }
     delete this;
   }
@@ -400,156 +410,21 @@ class RRResolverWorker {
   }
 
   const std::string name_;
-  const uint16 rrtype_;
-  const uint16 flags_;
+  const std::vector<uint16> rrtypes_;
   MessageLoop* const origin_loop_;
   DnsRRResolver* const dnsrr_resolver_;
 
   base::Lock lock_;
   bool canceled_;
 
-  int result_;
-  RRResponse response_;
+  // The result and response for each of |rrtypes_|.
+  std::vector<int> results_;
+  std::vector<RRResponse> responses_;
 
   DISALLOW_COPY_AND_ASSIGN(RRResolverWorker);
 };
 
 
-// A Buffer is used for walking over a DNS packet.
-class Buffer {
- public:
-  Buffer(const uint8* p, unsigned len)
-      : p_(p),
-        packet_(p),
-        len_(len),
-        packet_len_(len) {
-  }
-
-  bool U8(uint8* v) {
-    if (len_ < 1)
-      return false;
-    *v = *p_;
-    p_++;
-    len_--;
-    return true;
-  }
-
-  bool U16(uint16* v) {
-    if (len_ < 2)
-      return false;
-    *v = static_cast<uint16>(p_[0]) << 8 |
-         static_cast<uint16>(p_[1]);
-    p_ += 2;
-    len_ -= 2;
-    return true;
-  }
-
-  bool U32(uint32* v) {
-    if (len_ < 4)
-      return false;
-    *v = static_cast<uint32>(p_[0]) << 24 |
-         static_cast<uint32>(p_[1]) << 16 |
-         static_cast<uint32>(p_[2]) << 8 |
-         static_cast<uint32>(p_[3]);
-    p_ += 4;
-    len_ -= 4;
-    return true;
-  }
-
-  bool Skip(unsigned n) {
-    if (len_ < n)
-      return false;
-    p_ += n;
-    len_ -= n;
-    return true;
-  }
-
-  bool Block(base::StringPiece* out, unsigned len) {
-    if (len_ < len)
-      return false;
-    *out = base::StringPiece(reinterpret_cast<const char*>(p_), len);
-    p_ += len;
-    len_ -= len;
-    return true;
-  }
-
-  // DNSName parses a (possibly compressed) DNS name from the packet. If |name|
-  // is not NULL, then the name is written into it. See RFC 1035 section 4.1.4.
-  bool DNSName(std::string* name) {
-    unsigned jumps = 0;
-    const uint8* p = p_;
-    unsigned len = len_;
-
-    if (name)
-      name->clear();
-
-    for (;;) {
-      if (len < 1)
-        return false;
-      uint8 d = *p;
-      p++;
-      len--;
-
-      // The two couple of bits of the length give the type of the length. It's
-      // either a direct length or a pointer to the remainder of the name.
-      if ((d & 0xc0) == 0xc0) {
-        // This limit matches the depth limit in djbdns.
-        if (jumps > 100)
-          return false;
-        if (len < 1)
-          return false;
-        uint16 offset = static_cast<uint16>(d) << 8 |
-                        static_cast<uint16>(p[0]);
-        offset &= 0x3ff;
-        p++;
-        len--;
-
-        if (jumps == 0) {
-          p_ = p;
-          len_ = len;
-        }
-        jumps++;
-
-        if (offset >= packet_len_)
-          return false;
-        p = &packet_[offset];
-        len = packet_len_ - offset;
-      } else if ((d & 0xc0) == 0) {
-        uint8 label_len = d;
-        if (len < label_len)
-          return false;
-        if (name && label_len) {
-          if (!name->empty())
-            name->append(".");
-          name->append(reinterpret_cast<const char*>(p), label_len);
-        }
-        p += label_len;
-        len -= label_len;
-
-        if (jumps == 0) {
-          p_ = p;
-          len_ = len;
-        }
-
-        if (label_len == 0)
-          break;
-      } else {
-        return false;
-      }
-    }
-
-    return true;
-  }
-
- private:
-  const uint8* p_;
-  const uint8* const packet_;
-  unsigned len_;
-  const unsigned packet_len_;
-
-  DISALLOW_COPY_AND_ASSIGN(Buffer);
-};
-
 bool RRResponse::HasExpired(const base::Time current_time) const {
   const base::TimeDelta delta(base::TimeDelta::FromSeconds(ttl));
   const base::Time expiry = fetch_time + delta;
@@ -568,7 +443,7 @@ bool RRResponse::ParseFromResponse(const uint8* p, unsigned len,
 
   // RFC 1035 section 4.4.1
   uint8 flags2;
-  Buffer buf(p, len);
+  DnsResponseBuffer buf(p, len);
   if (!buf.Skip(2) ||  // skip id
       !buf.Skip(1) ||  // skip first flags byte
       !buf.U8(&flags2)) {
@@ -643,20 +518,15 @@ bool RRResponse::ParseFromResponse(const uint8* p, unsigned len,
 }
 
 
-// An RRResolverJob is a one-to-one counterpart of an RRResolverWorker. It
-// lives only on the DnsRRResolver's origin message loop.
+// An RRResolverJob holds the requests waiting for one name and record type.
+// It lives only on the DnsRRResolver's origin message loop.
 class RRResolverJob {
  public:
-  explicit RRResolverJob(RRResolverWorker* worker)
-      : worker_(worker) {
-  }
+  RRResolverJob() {}
 
+  // Requests still waiting are aborted.
   ~RRResolverJob() {
-    if (worker_) {
-      worker_->Cancel();
-      worker_ = NULL;
-      PostAll(ERR_ABORTED, NULL);
-    }
+    PostAll(ERR_ABORTED, NULL);
   }
 
   void AddHandle(RRResolverHandle* handle) {
@@ -664,7 +534,6 @@ class RRResolverJob {
   }
 
   void HandleResult(int result, const RRResponse& response) {
-    worker_ = NULL;
     PostAll(result, &response);
   }
 
@@ -681,21 +550,100 @@ class RRResolverJob {
   }
 
   std::vector<RRResolverHandle*> handles_;
-  RRResolverWorker* worker_;
+
+  DISALLOW_COPY_AND_ASSIGN(RRResolverJob);
+};
+
+
+// An RRResolverBatch looks up the record types wanted for one name on an
+// AsyncDnsResolver, with all the queries in flight at once.
+class RRResolverBatch {
+ public:
+  RRResolverBatch(const std::string& name,
+                  const std::vector<uint16>& rrtypes,
+                  AsyncDnsResolver* async_dns_resolver,
+                  DnsRRResolver* dnsrr_resolver)
+      : name_(name),
+        rrtypes_(rrtypes),
+        async_dns_resolver_(async_dns_resolver),
+        dnsrr_resolver_(dnsrr_resolver),
+        request_(NULL),
+        ALLOW_THIS_IN_INITIALIZER_LIST(
+            callback_(this, &RRResolverBatch::OnComplete)) {
+  }
+
+  ~RRResolverBatch() {
+    if (request_)
+      async_dns_resolver_->CancelRequest(request_);
+  }
+
+  // Returns true if the lookups are under way.
+  bool Start() {
+    int rv = async_dns_resolver_->ResolveRecords(
+        name_, rrtypes_, &results_, &responses_, &callback_, &request_);
+    return rv == ERR_IO_PENDING;
+  }
+
+  const std::string& name() const { return name_; }
+  const std::vector<uint16>& rrtypes() const { return rrtypes_; }
+  const std::vector<int>& results() const { return results_; }
+  std::vector<RRResponse>* responses() { return &responses_; }
+
+ private:
+  void OnComplete(int result) {
+    DCHECK_EQ(OK, result);
+    request_ = NULL;
+    dnsrr_resolver_->OnBatchComplete(this);
+  }
+
+  const std::string name_;
+  const std::vector<uint16> rrtypes_;
+  AsyncDnsResolver* const async_dns_resolver_;
+  DnsRRResolver* const dnsrr_resolver_;
+
+  AsyncDnsResolver::Request* request_;
+  CompletionCallbackImpl<RRResolverBatch> callback_;
+
+  // The result and response for each of |rrtypes_|.
+  std::vector<int> results_;
+  std::vector<RRResponse> responses_;
+
+  DISALLOW_COPY_AND_ASSIGN(RRResolverBatch);
 };
 
 
+DnsRRResolver::CacheEntry::CacheEntry(const Key& key,
+                                      const RRResponse& response)
+    : key(key),
+      response(response) {
+}
+
+DnsRRResolver::CacheEntry::~CacheEntry() {}
+
 DnsRRResolver::DnsRRResolver()
-    : requests_(0),
+    : max_cache_entries_(kMaxCacheEntries),
+      async_dns_resolver_(NULL),
+      requests_(0),
       cache_hits_(0),
       inflight_joins_(0),
-      in_destructor_(false) {
+      lookups_(0),
+      in_destructor_(false),
+      ALLOW_THIS_IN_INITIALIZER_LIST(method_factory_(this)) {
 }
 
 DnsRRResolver::~DnsRRResolver() {
   DCHECK(!in_destructor_);
   in_destructor_ = true;
+  CancelLookups();
   STLDeleteValues(&inflight_);
+  ClearCache();
+}
+
+void DnsRRResolver::set_max_cache_entries(size_t max_cache_entries) {
+  DCHECK_GE(max_cache_entries, 1u);
+  max_cache_entries_ = max_cache_entries;
+  while (cache_.size() > max_cache_entries_)
+    RemoveFromCache(cache_.find(lru_list_.head()->value()->key));
 }
 
 intptr_t DnsRRResolver::Resolve(const std::string& name, uint16 rrtype,
@@ -715,54 +663,49 @@ intptr_t DnsRRResolver::Resolve(const std::string& name, uint16 rrtype,
 
   requests_++;
 
-  const std::pair<std::string, uint16> key(make_pair(name, rrtype));
+  const Key key(make_pair(name, rrtype));
   // First check the cache.
-  std::map<std::pair<std::string, uint16>, RRResponse>::iterator i;
-  i = cache_.find(key);
-  if (i != cache_.end()) {
-    if (!i->second.HasExpired(base::Time::Now())) {
-      int error;
-      if (i->second.negative) {
-        error = ERR_NAME_NOT_RESOLVED;
-      } else {
-        error = OK;
-        *response = i->second;
-      }
-      RRResolverHandle* handle = new RRResolverHandle(
-          callback, NULL /* no response pointer because we've already filled */
-                         /* it in */);
-      cache_hits_++;
-      // We need a typed NULL pointer in order to make the templates work out.
-      static const RRResponse* kNoResponse = NULL;
-      MessageLoop::current()->PostTask(
-          FROM_HERE, NewRunnableMethod(handle, &RRResolverHandle::Post, error,
-                                       kNoResponse));
-      return reinterpret_cast<intptr_t>(handle);
+  const RRResponse* cached = LookupCache(key);
+  if (cached) {
+    int error;
+    if (cached->negative) {
+      error = ERR_NAME_NOT_RESOLVED;
     } else {
-      // entry has expired.
-      cache_.erase(i);
+      error = OK;
+      *response = *cached;
     }
+    RRResolverHandle* handle = new RRResolverHandle(
+        callback, NULL /* no response pointer because we've already filled */
+                       /* it in */);
+    cache_hits_++;
+    // We need a typed NULL pointer in order to make the templates work out.
+    static const RRResponse* kNoResponse = NULL;
+    MessageLoop::current()->PostTask(
+        FROM_HERE, NewRunnableMethod(handle, &RRResolverHandle::Post, error,
+                                     kNoResponse));
+    return reinterpret_cast<intptr_t>(handle);
   }
 
   // No cache hit. See if a request is currently in flight.
   RRResolverJob* job;
-  std::map<std::pair<std::string, uint16>, RRResolverJob*>::const_iterator j;
+  std::map<Key, RRResolverJob*>::const_iterator j;
   j = inflight_.find(key);
   if (j != inflight_.end()) {
     // The request is in flight already. We'll just attach our callback.
     inflight_joins_++;
     job = j->second;
   } else {
-    // Need to make a new request.
-    RRResolverWorker* worker = new RRResolverWorker(name, rrtype, flags, this);
-    job = new RRResolverJob(worker);
+    // Need to make a new request. It waits for the end of the current task,
+    // so that the other record types wanted for the name can go with it.
+    job = new RRResolverJob;
     inflight_.insert(make_pair(key, job));
-    if (!worker->Start()) {
-      inflight_.erase(key);
-      delete job;
-      delete worker;
-      return kInvalidHandle;
+    if (pending_.empty()) {
+      MessageLoop::current()->PostTask(
+          FROM_HERE,
+          method_factory_.NewRunnableMethod(
+              &DnsRRResolver::StartPendingLookups));
     }
+    pending_[name].push_back(rrtype);
   }
 
   RRResolverHandle* handle = new RRResolverHandle(callback, response);
@@ -780,51 +723,200 @@ void DnsRRResolver::OnIPAddressChanged() {
   DCHECK(CalledOnValidThread());
   DCHECK(!in_destructor_);
 
-  std::map<std::pair<std::string, uint16>, RRResolverJob*> inflight;
+  CancelLookups();
+  std::map<Key, RRResolverJob*> inflight;
   inflight.swap(inflight_);
-  cache_.clear();
+  ClearCache();
 
   STLDeleteValues(&inflight);
 }
 
-// HandleResult is called on the origin message loop.
-void DnsRRResolver::HandleResult(const std::string& name, uint16 rrtype,
-                                 int result, const RRResponse& response) {
+void DnsRRResolver::StartPendingLookups() {
   DCHECK(CalledOnValidThread());
 
-  const std::pair<std::string, uint16> key(std::make_pair(name, rrtype));
+  std::map<std::string, std::vector<uint16> > pending;
+  pending.swap(pending_);
+  for (std::map<std::string, std::vector<uint16> >::const_iterator
+       i = pending.begin(); i != pending.end(); ++i) {
+    const std::string& name = i->first;
+    const std::vector<uint16>& rrtypes = i->second;
+
+    std::vector<uint16> batched, unbatched;
+    bool use_async = async_dns_resolver_ && async_dns_resolver_->IsReady();
+    for (size_t j = 0; j < rrtypes.size(); ++j) {
+      if (use_async && !IsTestQuery(name, rrtypes[j]))
+        batched.push_back(rrtypes[j]);
+      else
+        unbatched.push_back(rrtypes[j]);
+    }
 
-  DCHECK_GE(kMaxCacheEntries, 1u);
-  DCHECK_LE(cache_.size(), kMaxCacheEntries);
-  if (cache_.size() == kMaxCacheEntries) {
-    // need to remove an element of the cache.
-    const base::Time current_time(base::Time::Now());
-    std::map<std::pair<std::string, uint16>, RRResponse>::iterator i, cur;
-    for (i = cache_.begin(); i != cache_.end(); ) {
-      cur = i++;
-      if (cur->second.HasExpired(current_time))
-        cache_.erase(cur);
+    if (!batched.empty()) {
+      RRResolverBatch* batch =
+          new RRResolverBatch(name, batched, async_dns_resolver_, this);
+      if (batch->Start()) {
+        lookups_++;
+        batches_.insert(batch);
+      } else {
+        delete batch;
+        unbatched.insert(unbatched.end(), batched.begin(), batched.end());
+      }
+    }
+
+    if (!unbatched.empty())
+      StartWorker(name, unbatched);
+  }
+}
+
+void DnsRRResolver::StartWorker(const std::string& name,
+                                const std::vector<uint16>& rrtypes) {
+  lookups_++;
+  RRResolverWorker* worker = new RRResolverWorker(name, rrtypes, this);
+  if (worker->Start()) {
+    workers_.insert(worker);
+    return;
+  }
+  delete worker;
+
+  // Without a thread to look them up on, the records get a negative answer,
+  // as they would if the lookup had failed.
+  std::vector<int> results(rrtypes.size(), ERR_NAME_NOT_RESOLVED);
+  std::vector<RRResponse> responses(rrtypes.size());
+  for (size_t i = 0; i < responses.size(); ++i) {
+    responses[i].fetch_time = base::Time::Now();
+    responses[i].negative = true;
+    responses[i].ttl = kNegativeTTLSecs;
+  }
+  HandleResults(name, rrtypes, results, responses);
+}
+
+void DnsRRResolver::OnBatchComplete(RRResolverBatch* batch) {
+  DCHECK(CalledOnValidThread());
+  size_t erased = batches_.erase(batch);
+  DCHECK_EQ(1u, erased);
+  scoped_ptr<RRResolverBatch> scoped_batch(batch);
+
+  // A name or record type that doesn't exist is a negative answer.  Other
+  // failures only mean that the name servers couldn't be asked, so those
+  // types are handed to the worker instead.
+  std::vector<uint16> rrtypes, retry_rrtypes;
+  std::vector<int> results;
+  std::vector<RRResponse> responses;
+  for (size_t i = 0; i < batch->rrtypes().size(); ++i) {
+    int result = batch->results()[i];
+    RRResponse* response = &(*batch->responses())[i];
+    if (result == ERR_NAME_NOT_RESOLVED) {
+      response->negative = true;
+      response->ttl = kNegativeTTLSecs;
+    } else if (result != OK) {
+      retry_rrtypes.push_back(batch->rrtypes()[i]);
+      continue;
+    }
+    rrtypes.push_back(batch->rrtypes()[i]);
+    results.push_back(result);
+    responses.push_back(*response);
+  }
+
+  if (!retry_rrtypes.empty())
+    StartWorker(batch->name(), retry_rrtypes);
+  if (!rrtypes.empty())
+    HandleResults(batch->name(), rrtypes, results, responses);
+}
+
+// HandleResults is called on the origin message loop.
+void DnsRRResolver::HandleResults(const std::string& name,
+                                  const std::vector<uint16>& rrtypes,
+                                  const std::vector<int>& results,
+                                  const std::vector<RRResponse>& responses) {
+  DCHECK(CalledOnValidThread());
+
+  // Everything is cached, and the jobs taken out of |inflight_|, before any
+  // callback is run, as a callback may delete |this|.
+  std::vector<RRResolverJob*> jobs;
+  for (size_t i = 0; i < rrtypes.size(); ++i) {
+    const Key key(std::make_pair(name, rrtypes[i]));
+    AddToCache(key, responses[i]);
+
+    std::map<Key, RRResolverJob*>::iterator j = inflight_.find(key);
+    if (j == inflight_.end()) {
+      NOTREACHED();
+      jobs.push_back(NULL);
+      continue;
     }
+    jobs.push_back(j->second);
+    inflight_.erase(j);
   }
-  if (cache_.size() == kMaxCacheEntries) {
-    // if we didn't clear out any expired entries, we just remove the first
-    // element. Crummy but simple.
-    cache_.erase(cache_.begin());
+
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    if (!jobs[i])
+      continue;
+    jobs[i]->HandleResult(results[i], responses[i]);
+    delete jobs[i];
   }
+}
 
-  cache_.insert(std::make_pair(key, response));
+const RRResponse* DnsRRResolver::LookupCache(const Key& key) {
+  CacheMap::iterator it = cache_.find(key);
+  if (it == cache_.end())
+    return NULL;
+  CacheEntry* entry = it->second;
+  if (entry->response.HasExpired(base::Time::Now())) {
+    RemoveFromCache(it);
+    return NULL;
+  }
+  entry->RemoveFromList();
+  lru_list_.Append(entry);
+  return &entry->response;
+}
 
-  std::map<std::pair<std::string, uint16>, RRResolverJob*>::iterator j;
-  j = inflight_.find(key);
-  if (j == inflight_.end()) {
-    NOTREACHED();
-    return;
+void DnsRRResolver::AddToCache(const Key& key, const RRResponse& response) {
+  CacheMap::iterator it = cache_.find(key);
+  if (it != cache_.end())
+    RemoveFromCache(it);
+
+  DCHECK_LE(cache_.size(), max_cache_entries_);
+  if (cache_.size() == max_cache_entries_) {
+    // Expired entries go first, then the least recently used one.
+    const base::Time current_time(base::Time::Now());
+    base::LinkNode<CacheEntry>* node = lru_list_.head();
+    while (node != lru_list_.end()) {
+      CacheEntry* entry = node->value();
+      node = node->next();
+      if (entry->response.HasExpired(current_time))
+        RemoveFromCache(cache_.find(entry->key));
+    }
   }
-  RRResolverJob* job = j->second;
-  inflight_.erase(j);
+  if (cache_.size() == max_cache_entries_)
+    RemoveFromCache(cache_.find(lru_list_.head()->value()->key));
 
-  job->HandleResult(result, response);
-  delete job;
+  CacheEntry* entry = new CacheEntry(key, response);
+  cache_.insert(std::make_pair(key, entry));
+  lru_list_.Append(entry);
+}
+
+void DnsRRResolver::RemoveFromCache(CacheMap::iterator it) {
+  DCHECK(it != cache_.end());
+  CacheEntry* entry = it->second;
+  cache_.erase(it);
+  entry->RemoveFromList();
+  delete entry;
+}
+
+void DnsRRResolver::ClearCache() {
+  while (!cache_.empty())
+    RemoveFromCache(cache_.begin());
+}
+
+void DnsRRResolver::CancelLookups() {
+  method_factory_.RevokeAll();
+  pending_.clear();
+
+  for (std::set<RRResolverWorker*>::iterator
+       i = workers_.begin(); i != workers_.end(); ++i) {
+    // The worker deletes itself once it's done.
+    (*i)->Cancel();
+  }
+  workers_.clear();
+  STLDeleteElements(&batches_);
 }
 
 }  // namespace net
@@ -7,12 +7,15 @@
 #pragma once
 
 #include <map>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "base/basictypes.h"
+#include "base/linked_list.h"
 #include "base/memory/ref_counted.h"
+#include "base/task.h"
 #include "base/threading/non_thread_safe.h"
 #include "base/time.h"
 #include "build/build_config.h"
@@ -52,7 +55,9 @@ struct RRResponse {
   bool negative;
 };
 
+class AsyncDnsResolver;
 class BoundNetLog;
+class RRResolverBatch;
 class RRResolverWorker;
 class RRResolverJob;
 
@@ -65,6 +70,12 @@ class RRResolverJob;
 // DnsRRResolver should only be used when the data is specifically DNS data and
 // the name is a fully qualified DNS domain.
 //
+// Lookups started in the same task for one name are gathered, so that all the
+// record types wanted go out together: in parallel over an AsyncDnsResolver if
+// one is set, or on a single worker thread otherwise.  The answers are kept in
+// a cache of limited size, which drops expired entries first and then the
+// least recently used ones.
+//
 // A DnsRRResolver must be used from the MessageLoop which created it.
 class DnsRRResolver : public base::NonThreadSafe,
                       public NetworkChangeNotifier::IPAddressObserver {
@@ -87,6 +98,21 @@ class DnsRRResolver : public base::NonThreadSafe,
   uint64 requests() const { return requests_; }
   uint64 cache_hits() const { return cache_hits_; }
   uint64 inflight_joins() const { return inflight_joins_; }
+  // The number of lookups started, each for all the record types wanted for
+  // one name.
+  uint64 lookups() const { return lookups_; }
+
+  // Sends lookups over |resolver|, rather than blocking a worker thread in the
+  // system resolver for each one.  Record types that |resolver| can't get an
+  // answer for, say because the answer doesn't fit a UDP datagram, are still
+  // looked up by the system resolver.  |resolver| isn't owned, and must
+  // outlive this object.
+  void set_async_dns_resolver(AsyncDnsResolver* resolver) {
+    async_dns_resolver_ = resolver;
+  }
+
+  // Sets the number of responses kept in the cache.  Must be at least 1.
+  void set_max_cache_entries(size_t max_cache_entries);
 
   // Resolve starts the resolution process. When complete, |callback| is called
   // with a result. If the result is |OK| then |response| is filled with the
@@ -109,25 +135,78 @@ class DnsRRResolver : public base::NonThreadSafe,
   virtual void OnIPAddressChanged();
 
  private:
+  friend class RRResolverBatch;
   friend class RRResolverWorker;
 
-  void HandleResult(const std::string& name, uint16 rrtype, int result,
-                    const RRResponse& response);
+  //               < name      , rrtype>
+  typedef std::pair<std::string, uint16> Key;
+
+  // A cached response, on |lru_list_|.
+  struct CacheEntry : public base::LinkNode<CacheEntry> {
+    CacheEntry(const Key& key, const RRResponse& response);
+    ~CacheEntry();
+
+    const Key key;
+    RRResponse response;
+  };
+  typedef std::map<Key, CacheEntry*> CacheMap;
+
+  // Starts the lookups gathered in |pending_|.
+  void StartPendingLookups();
+
+  // Looks up |rrtypes| for |name| on a worker thread.
+  void StartWorker(const std::string& name,
+                   const std::vector<uint16>& rrtypes);
+
+  // Called by |batch| once its lookups on |async_dns_resolver_| are done.
+  void OnBatchComplete(RRResolverBatch* batch);
+
+  // Caches the answers for |name|, and completes the jobs waiting for them.
+  void HandleResults(const std::string& name,
+                     const std::vector<uint16>& rrtypes,
+                     const std::vector<int>& results,
+                     const std::vector<RRResponse>& responses);
+
+  // Returns the unexpired response cached for |key|, or NULL.
+  const RRResponse* LookupCache(const Key& key);
+  void AddToCache(const Key& key, const RRResponse& response);
+  void RemoveFromCache(CacheMap::iterator it);
+  void ClearCache();
+
+  // Cancels the lookups in progress.  Their jobs, and the requests waiting for
+  // them, are left to the caller.
+  void CancelLookups();
 
   // cache_ maps from a request to a cached response. The cached answer may
-  // have expired and the size of |cache_| must be <= kMaxCacheEntries.
-  //                < name      , rrtype>
-  std::map<std::pair<std::string, uint16>, RRResponse> cache_;
+  // have expired and the size of |cache_| must be <= |max_cache_entries_|.
+  CacheMap cache_;
+  // The entries of |cache_|, from the least to the most recently used.
+  base::LinkedList<CacheEntry> lru_list_;
+  size_t max_cache_entries_;
+
   // inflight_ maps from a request to an active resolution which is taking
   // place.
-  std::map<std::pair<std::string, uint16>, RRResolverJob*> inflight_;
+  std::map<Key, RRResolverJob*> inflight_;
+
+  // The record types of the new jobs for each name, waiting to be looked up
+  // together.
+  std::map<std::string, std::vector<uint16> > pending_;
+
+  // The lookups in progress for the jobs in |inflight_|.
+  std::set<RRResolverWorker*> workers_;
+  std::set<RRResolverBatch*> batches_;
+
+  AsyncDnsResolver* async_dns_resolver_;
 
   uint64 requests_;
   uint64 cache_hits_;
   uint64 inflight_joins_;
+  uint64 lookups_;
 
   bool in_destructor_;
 
+  ScopedRunnableMethodFactory<DnsRRResolver> method_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(DnsRRResolver);
 };
 
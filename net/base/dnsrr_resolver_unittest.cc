@@ -123,6 +123,58 @@ TEST_F(DnsRRResolverTest, Resolve) {
   ASSERT_EQ(1u, resolver.inflight_joins());
 }
 
+TEST_F(DnsRRResolverTest, BatchesRecordTypes) {
+  DnsRRResolver resolver;
+  RRResponse response1, response2, response3;
+  TestCompletionCallback callback1, callback2, callback3;
+
+  DnsRRResolver::Handle handle;
+
+  // The two record types for www.testing.notatld go out together.
+  handle = resolver.Resolve("www.testing.notatld", kDNS_TESTING, 0,
+                            &callback1, &response1, 0, BoundNetLog());
+  ASSERT_TRUE(handle != DnsRRResolver::kInvalidHandle);
+  handle = resolver.Resolve("www.testing.notatld", kDNS_TXT, 0,
+                            &callback2, &response2, 0, BoundNetLog());
+  ASSERT_TRUE(handle != DnsRRResolver::kInvalidHandle);
+  handle = resolver.Resolve("nx.testing.notatld", kDNS_TESTING, 0,
+                            &callback3, &response3, 0, BoundNetLog());
+  ASSERT_TRUE(handle != DnsRRResolver::kInvalidHandle);
+  EXPECT_EQ(OK, callback1.WaitForResult());
+  EXPECT_EQ(OK, callback2.WaitForResult());
+  EXPECT_EQ(ERR_NAME_NOT_RESOLVED, callback3.WaitForResult());
+  ASSERT_EQ(1u, response2.rrdatas.size());
+  EXPECT_EQ("goats!", response2.rrdatas[0]);
+  EXPECT_EQ(3u, resolver.requests());
+  EXPECT_EQ(2u, resolver.lookups());
+}
+
+TEST_F(DnsRRResolverTest, CacheEvictsLeastRecentlyUsed) {
+  DnsRRResolver resolver;
+  resolver.set_max_cache_entries(2);
+  RRResponse response;
+  TestCompletionCallback callback;
+  DnsRRResolver::Handle handle;
+
+  // Using the kDNS_TESTING answer keeps it cached when the kDNS_CERT one comes
+  // in, and the kDNS_TXT one is dropped instead.
+  const uint16 kTypes[] = { kDNS_TESTING, kDNS_TXT, kDNS_TESTING, kDNS_CERT,
+                            kDNS_TESTING, kDNS_TXT };
+  const bool kHits[] = { false, false, true, false, true, false };
+  uint64 cache_hits = 0;
+  for (size_t i = 0; i < arraysize(kTypes); ++i) {
+    SCOPED_TRACE(i);
+    handle = resolver.Resolve("www.testing.notatld", kTypes[i], 0, &callback,
+                              &response, 0, BoundNetLog());
+    ASSERT_TRUE(handle != DnsRRResolver::kInvalidHandle);
+    EXPECT_EQ(OK, callback.WaitForResult());
+    if (kHits[i])
+      cache_hits++;
+    EXPECT_EQ(cache_hits, resolver.cache_hits());
+  }
+  EXPECT_EQ(4u, resolver.lookups());
+}
+
 #if defined(OS_POSIX)
 // This is a DNS packet resulting from querying a recursive resolver for a TXT
 // record for agl._pka.imperialviolet.org. You should be able to get a
@@ -7,9 +7,15 @@
 #include <cryptohi.h>
 #include <cryptoht.h>
 #include <keyhi.h>
+#include <pk11pub.h>
 
+#include <algorithm>
+#include <map>
+
+#include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/synchronization/lock.h"
 #include "base/time.h"
 #include "crypto/nss_util.h"
 #include "net/base/dns_util.h"
@@ -25,6 +31,69 @@ const unsigned char kRSAWithSHA256[] = {
   0x30, 0xd, 0x6, 0x9, 0x2a, 0x86, 0x48, 0x86, 0xf7, 0xd, 0x1, 0x1, 0xb, 5, 0
 };
 
+// The maximum number of signatures that are remembered.
+const size_t kMaxVerifiedSignatures = 256;
+
+// VerifiedSignatures remembers the signatures that have been checked, so that
+// the keys of the root and of the TLDs, which are part of nearly every chain,
+// don't cost a public key operation for each connection. Entries are keyed by
+// a hash of the key, signature and signed data, so a hit is only possible for
+// exactly the same check.
+class VerifiedSignatures {
+ public:
+  VerifiedSignatures() {}
+
+  bool Contains(const std::string& digest, base::Time now) {
+    base::AutoLock lock(lock_);
+    std::map<std::string, base::Time>::iterator i = expiries_.find(digest);
+    if (i == expiries_.end())
+      return false;
+    if (now >= i->second) {
+      expiries_.erase(i);
+      return false;
+    }
+    return true;
+  }
+
+  void Add(const std::string& digest, base::Time now, base::Time expiry) {
+    base::AutoLock lock(lock_);
+    if (expiries_.size() >= kMaxVerifiedSignatures) {
+      std::map<std::string, base::Time>::iterator i = expiries_.begin();
+      while (i != expiries_.end()) {
+        if (now >= i->second) {
+          expiries_.erase(i++);
+        } else {
+          ++i;
+        }
+      }
+      if (expiries_.size() >= kMaxVerifiedSignatures)
+        expiries_.clear();
+    }
+    expiries_[digest] = expiry;
+  }
+
+ private:
+  base::Lock lock_;
+  std::map<std::string, base::Time> expiries_;
+
+  DISALLOW_COPY_AND_ASSIGN(VerifiedSignatures);
+};
+
+base::LazyInstance<VerifiedSignatures> g_verified_signatures(
+    base::LINKER_INITIALIZED);
+
+// Returns the SHA-256 digest of |data|, or an empty string on failure.
+std::string DigestForCache(const std::string& data) {
+  crypto::EnsureNSSInit();
+  unsigned char digest[SHA256_LENGTH];
+  if (PK11_HashBuf(SEC_OID_SHA256, digest,
+                   reinterpret_cast<const unsigned char*>(data.data()),
+                   data.size()) != SECSuccess) {
+    return std::string();
+  }
+  return std::string(reinterpret_cast<char*>(digest), sizeof(digest));
+}
+
 }  // namespace
 
 namespace net {
@@ -68,6 +137,10 @@ bool DNSSECKeySet::CheckSignature(
       reinterpret_cast<const unsigned char*>(signature.data());
 
   uint8 algorithm = sigdata[0];
+  uint32 ttl = static_cast<uint32>(sigdata[2]) << 24 |
+               static_cast<uint32>(sigdata[3]) << 16 |
+               static_cast<uint32>(sigdata[4]) << 8 |
+               static_cast<uint32>(sigdata[5]);
   uint32 expires = static_cast<uint32>(sigdata[6]) << 24 |
                    static_cast<uint32>(sigdata[7]) << 16 |
                    static_cast<uint32>(sigdata[8]) << 8 |
@@ -79,10 +152,16 @@ bool DNSSECKeySet::CheckSignature(
   uint16 keyid = static_cast<uint16>(sigdata[14]) << 8 |
                  static_cast<uint16>(sigdata[15]);
 
+  base::Time now = base::Time::Now();
+  // A verified signature is trusted again until the records expire, or until
+  // the signature does, whichever happens first.
+  base::Time expiry = now + base::TimeDelta::FromSeconds(ttl);
   if (!ignore_timestamps_) {
-    uint32 now = static_cast<uint32>(base::Time::Now().ToTimeT());
-    if (now < begins || now >= expires)
+    uint32 now32 = static_cast<uint32>(now.ToTimeT());
+    if (now32 < begins || now32 >= expires)
       return false;
+    expiry = std::min(expiry, now + base::TimeDelta::FromSeconds(
+        expires - now32));
   }
 
   base::StringPiece sig(signature.data() + 16, signature.size() - 16);
@@ -149,15 +228,22 @@ bool DNSSECKeySet::CheckSignature(
   }
 
   // Check the signature with each trusted key which has a matching keyid.
+  base::StringPiece signed_data_piece(
+      reinterpret_cast<const char*>(signed_data.get()), signed_data_len);
   DCHECK_EQ(public_keys_.size(), keyids_.size());
   for (unsigned i = 0; i < public_keys_.size(); i++) {
     if (keyids_[i] != keyid)
       continue;
 
-    if (VerifySignature(
-            signature_algorithm, sig, public_keys_[i],
-            base::StringPiece(reinterpret_cast<const char*>(signed_data.get()),
-                              signed_data_len))) {
+    std::string digest = DigestForCache(
+        public_keys_[i] + sig.as_string() + signed_data_piece.as_string());
+    if (!digest.empty() && g_verified_signatures.Get().Contains(digest, now))
+      return true;
+
+    if (VerifySignature(signature_algorithm, sig, public_keys_[i],
+                        signed_data_piece)) {
+      if (!digest.empty())
+        g_verified_signatures.Get().Add(digest, now, expiry);
       return true;
     }
   }
@@ -29,6 +29,8 @@ class DNSSECKeySet {
   //   signature: the RRSIG signature, not include the signing zone.
   //   rrtype: the type of the resource records
   //   rrdatas: the RRDATA of the signed resource records, in canonical order.
+  // Signatures that pass are remembered by all the key sets, until the TTL of
+  // the records or the signature expires, so that they are not checked again.
   bool CheckSignature(const base::StringPiece& name,
                       const base::StringPiece& zone,
                       const base::StringPiece& signature,
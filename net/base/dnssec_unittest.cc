@@ -130,6 +130,49 @@ TEST(SignatureVerifierDNSSECTest, VerifySignature) {
   ASSERT_TRUE(keyset.CheckSignature(root, root, signature, kDNSKEY, rrdatas));
 }
 
+TEST(SignatureVerifierDNSSECTest, VerifySignatureAgain) {
+  DNSSECKeySet keyset;
+
+  ASSERT_TRUE(keyset.AddKey(
+     base::StringPiece(reinterpret_cast<const char*>(kExampleKey),
+                       sizeof(kExampleKey))));
+  keyset.IgnoreTimestamps();
+
+  static const uint16 kDNSKEY = 48;  // RRTYPE for DNSKEY
+  static const char kRootLabel[] = "";
+  base::StringPiece root(kRootLabel, 1);
+  base::StringPiece signature(reinterpret_cast<const char*>(kSignatureData),
+                              sizeof(kSignatureData));
+  std::vector<base::StringPiece> rrdatas;
+  rrdatas.push_back(base::StringPiece(reinterpret_cast<const char*>(kRRDATA1),
+                                      sizeof(kRRDATA1)));
+  rrdatas.push_back(base::StringPiece(reinterpret_cast<const char*>(kRRDATA2),
+                                      sizeof(kRRDATA2)));
+  ASSERT_TRUE(keyset.CheckSignature(root, root, signature, kDNSKEY, rrdatas));
+  // The remembered signature passes again, from any key set.
+  ASSERT_TRUE(keyset.CheckSignature(root, root, signature, kDNSKEY, rrdatas));
+
+  DNSSECKeySet keyset2;
+  ASSERT_TRUE(keyset2.AddKey(
+     base::StringPiece(reinterpret_cast<const char*>(kExampleKey),
+                       sizeof(kExampleKey))));
+  keyset2.IgnoreTimestamps();
+  ASSERT_TRUE(keyset2.CheckSignature(root, root, signature, kDNSKEY, rrdatas));
+
+  // But it doesn't cover different records.
+  rrdatas.pop_back();
+  ASSERT_FALSE(keyset2.CheckSignature(root, root, signature, kDNSKEY,
+                                      rrdatas));
+
+  // Or a key set that doesn't have the key.
+  DNSSECKeySet empty_keyset;
+  empty_keyset.IgnoreTimestamps();
+  rrdatas.push_back(base::StringPiece(reinterpret_cast<const char*>(kRRDATA2),
+                                      sizeof(kRRDATA2)));
+  ASSERT_FALSE(empty_keyset.CheckSignature(root, root, signature, kDNSKEY,
+                                           rrdatas));
+}
+
 static std::string FromDNSName(const char* name) {
   std::string result;
   bool ok = DNSDomainFromDot(name, &result);
@@ -48,19 +48,27 @@ class Charmap {
 std::string Escape(const std::string& text, const Charmap& charmap,
                    bool use_plus) {
   std::string escaped;
-  escaped.reserve(text.length() * 3);
-  for (unsigned int i = 0; i < text.length(); ++i) {
+  if (text.empty())
+    return escaped;
+
+  // Every character takes at most three in the output, so size it for that up
+  // front, write it through a pointer without checking for room, and trim it
+  // at the end.
+  char* const begin = WriteInto(&escaped, text.length() * 3 + 1);
+  char* out = begin;
+  for (size_t i = 0; i < text.length(); ++i) {
     unsigned char c = static_cast<unsigned char>(text[i]);
     if (use_plus && ' ' == c) {
-      escaped.push_back('+');
+      *out++ = '+';
     } else if (charmap.Contains(c)) {
-      escaped.push_back('%');
-      escaped.push_back(IntToHex(c >> 4));
-      escaped.push_back(IntToHex(c & 0xf));
+      *out++ = '%';
+      *out++ = IntToHex(c >> 4);
+      *out++ = IntToHex(c & 0xf);
     } else {
-      escaped.push_back(c);
+      *out++ = c;
     }
   }
+  escaped.resize(out - begin);
   return escaped;
 }
 
@@ -111,17 +119,22 @@ STR UnescapeURLWithOffsetsImpl(const STR& escaped_text,
   if (rules == UnescapeRule::NONE)
     return escaped_text;
 
-  // The output of the unescaping is always smaller than the input, so we can
-  // reserve the input size to make sure we have enough buffer and don't have
-  // to allocate in the loop below.
   STR result;
-  result.reserve(escaped_text.length());
+  if (escaped_text.empty())
+    return result;
+
+  // The output of the unescaping is never longer than the input, so we can
+  // size the result to the input, write it through a pointer without checking
+  // for room, and trim it at the end.
+  typename STR::value_type* const begin =
+      WriteInto(&result, escaped_text.length() + 1);
+  typename STR::value_type* out = begin;
 
   AdjustEncodingOffset::Adjustments adjustments;  // Locations of adjusted text.
   for (size_t i = 0, max = escaped_text.size(); i < max; ++i) {
     if (static_cast<unsigned char>(escaped_text[i]) >= 128) {
       // Non ASCII character, append as is.
-      result.push_back(escaped_text[i]);
+      *out++ = escaped_text[i];
       continue;
     }
 
@@ -146,26 +159,27 @@ STR UnescapeURLWithOffsetsImpl(const STR& escaped_text,
              (value < ' ' && (rules & UnescapeRule::CONTROL_CHARS)))) {
           // Use the unescaped version of the character.
           adjustments.push_back(i);
-          result.push_back(value);
+          *out++ = value;
           i += 2;
         } else {
           // Keep escaped. Append a percent and we'll get the following two
           // digits on the next loops through.
-          result.push_back('%');
+          *out++ = '%';
         }
       } else {
         // Invalid escape sequence, just pass the percent through and continue
         // right after it.
-        result.push_back('%');
+        *out++ = '%';
       }
     } else if ((rules & UnescapeRule::REPLACE_PLUS_WITH_SPACE) &&
                escaped_text[i] == '+') {
-      result.push_back(' ');
+      *out++ = ' ';
     } else {
       // Normal case for unescaped characters.
-      result.push_back(escaped_text[i]);
+      *out++ = escaped_text[i];
     }
   }
+  result.resize(out - begin);
 
   // Make offset adjustment.
   if (offsets_for_adjustment && !adjustments.empty()) {
@@ -155,6 +155,29 @@ TEST(EscapeTest, EscapeUrlEncodedData) {
     "%7B%7C%7D~%7F%80%FF");
 }
 
+// The output buffers are sized up front; make sure long inputs and inputs
+// where every character changes come out whole.
+TEST(EscapeTest, EscapeAndUnescapeLongText) {
+  std::string text;
+  std::string escaped;
+  for (int i = 0; i < 1000; ++i) {
+    text.append("name=John Smith&");
+    escaped.append("name%3DJohn+Smith%26");
+  }
+  EXPECT_EQ(escaped, EscapeQueryParamValue(text, true));
+  EXPECT_EQ(text, UnescapeURLComponent(escaped,
+      UnescapeRule::URL_SPECIAL_CHARS | UnescapeRule::REPLACE_PLUS_WITH_SPACE));
+
+  std::string all_escaped(4096, '\xff');
+  EXPECT_EQ(4096u * 3, EscapeNonASCII(all_escaped).size());
+  EXPECT_EQ(all_escaped,
+            UnescapeURLComponent(EscapeNonASCII(all_escaped),
+                                 UnescapeRule::NORMAL));
+
+  EXPECT_EQ("", EscapeQueryParamValue("", true));
+  EXPECT_EQ("", UnescapeURLComponent("", UnescapeRule::NORMAL));
+}
+
 TEST(EscapeTest, UnescapeURLComponentASCII) {
   const UnescapeURLCaseASCII unescape_cases[] = {
     {"", UnescapeRule::NORMAL, ""},
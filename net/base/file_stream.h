@@ -55,6 +55,10 @@ class FileStream {
   // Returns true if Open succeeded and Close has not been called.
   bool IsOpen() const;
 
+  // Returns the file used by the stream, or base::kInvalidPlatformFileValue if
+  // it is not open. The stream keeps ownership of the file.
+  base::PlatformFile platform_file() const { return file_; }
+
   // Adjust the position from where data is read.  Upon success, the stream
   // position relative to the start of the file is returned.  Otherwise, an
   // error code is returned.  It is not valid to call Seek while a Read call
@@ -121,6 +125,16 @@ class FileStream {
   //   platform with this call.
   int64 Truncate(int64 bytes);
 
+  // Lets an asynchronous stream keep up to |max_reads| reads of |read_size|
+  // bytes each in flight ahead of its consumer, once it has been read a few
+  // times in a row without a Seek().  Reads are then served from those
+  // buffers, and may complete synchronously.  The readahead stops at the next
+  // Seek() or Write(), and starts again if the reads resume in order.
+  // |direct_io| makes the reads ahead bypass the OS cache where that is
+  // supported, for large files that are streamed once.  Pass 0 |max_reads| to
+  // turn readahead off, which is the default.  Only implemented on POSIX.
+  void SetReadahead(int max_reads, int read_size, bool direct_io);
+
   // Forces out a filesystem sync on this file to make sure that the file was
   // written out to disk and is not currently sitting in the buffer. This does
   // not have to be called, it just forces one to happen at the time of
@@ -143,6 +157,11 @@ class FileStream {
   int open_flags_;
   bool auto_closed_;
 
+  // Set by SetReadahead().
+  int readahead_reads_;
+  int readahead_size_;
+  bool readahead_direct_io_;
+
   DISALLOW_COPY_AND_ASSIGN(FileStream);
 };
 
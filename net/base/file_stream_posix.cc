@@ -10,14 +10,20 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <string.h>
 #include <unistd.h>
 #include <errno.h>
 
+#include <algorithm>
+#include <deque>
+#include <vector>
+
 #include "base/basictypes.h"
 #include "base/callback.h"
 #include "base/eintr_wrapper.h"
 #include "base/file_path.h"
 #include "base/logging.h"
+#include "base/memory/ref_counted.h"
 #include "base/message_loop.h"
 #include "base/metrics/histogram.h"
 #include "base/string_util.h"
@@ -105,6 +111,306 @@ int FlushFile(base::PlatformFile file) {
   return res;
 }
 
+// The number of reads in a row, without a Seek() in between, after which the
+// stream starts reading ahead.
+const int kSequentialReadsForReadahead = 2;
+
+// Direct I/O needs the buffers, offsets and sizes of the reads to be aligned
+// to the logical block size of the device.  This covers the common ones.
+const int kDirectIOAlignment = 4096;
+
+// Turns direct I/O on or off for |file|.  Returns false if that failed, which
+// is the case for the file systems that don't support it.
+bool SetDirectIO(base::PlatformFile file, bool direct_io) {
+#if defined(OS_LINUX)
+  int flags = fcntl(file, F_GETFL);
+  if (flags == -1)
+    return false;
+  flags = direct_io ? flags | O_DIRECT : flags & ~O_DIRECT;
+  return fcntl(file, F_SETFL, flags) == 0;
+#else
+  return false;
+#endif
+}
+
+// A read issued ahead of the consumer, into a buffer of its own.  The
+// WorkerPool thread doing the read only touches |result| and |done|.
+class ReadaheadChunk : public base::RefCountedThreadSafe<ReadaheadChunk> {
+ public:
+  ReadaheadChunk(int64 offset, int size)
+      : offset(offset),
+        size(size),
+        result(0),
+        completed(false),
+        abandoned(false),
+        done(true, false),
+        buffer_(new char[size + kDirectIOAlignment]) {
+    // Aligned for direct I/O.
+    data = buffer_.get() + kDirectIOAlignment -
+           reinterpret_cast<uintptr_t>(buffer_.get()) % kDirectIOAlignment;
+  }
+
+  const int64 offset;
+  const int size;
+  char* data;
+  // The number of bytes read, or an error code.
+  int result;
+  // Set on the IO thread once the completion of the read has been seen.
+  bool completed;
+  // Set when the readahead has stopped, and the data is not wanted anymore.
+  bool abandoned;
+  // Signaled by the WorkerPool thread when the read is done.
+  base::WaitableEvent done;
+
+ private:
+  friend class base::RefCountedThreadSafe<ReadaheadChunk>;
+
+  ~ReadaheadChunk() {}
+
+  scoped_array<char> buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReadaheadChunk);
+};
+
+// Keeps reads of a file in flight ahead of an asynchronous consumer that
+// reads it in order, and serves the consumer from them.  The reads use
+// pread() at their own offsets, so several of them can run at the same time,
+// and the position of the file is not moved.  Lives on the IO thread, but the
+// chunks are read on WorkerPool threads, which hold references to it.
+class Readahead : public base::RefCountedThreadSafe<Readahead> {
+ public:
+  Readahead(MessageLoopForIO* message_loop, base::PlatformFile file,
+            int max_reads, int read_size, bool direct_io);
+
+  bool active() const { return active_; }
+
+  // The position of the consumer in the file.  Only valid while active.
+  int64 position() const { return position_; }
+
+  CompletionCallback* callback() const { return callback_; }
+
+  // Starts reading ahead from |position|.
+  void Start(int64 position);
+
+  // Drops the chunks.  The reads that are still in flight finish in the
+  // background.  There must not be a read of the consumer in progress.
+  void Stop();
+
+  // Waits for all the reads in flight, and drops any read of the consumer.
+  // Must be called before the file is closed.
+  void Detach();
+
+  // Behaves like FileStream::Read(), from the chunks.
+  int Read(char* buf, int buf_len, CompletionCallback* callback);
+
+ private:
+  friend class base::RefCountedThreadSafe<Readahead>;
+
+  ~Readahead();
+
+  // Issues reads until |max_reads_| chunks are kept.
+  void IssueReads();
+
+  // Copies data at |position_| out of the first chunk, or returns
+  // ERR_IO_PENDING if it hasn't been read yet.
+  int CopyData(char* buf, int buf_len);
+
+  // Runs on a WorkerPool thread.
+  void ReadChunk(ReadaheadChunk* chunk);
+
+  void OnChunkRead(ReadaheadChunk* chunk);
+
+  MessageLoopForIO* const message_loop_;
+  const base::PlatformFile file_;
+  const int max_reads_;
+  int read_size_;
+  // Whether direct I/O was asked for, and works for the file.
+  bool direct_io_;
+
+  bool active_;
+  bool detached_;
+  int64 position_;
+  // The offset of the next chunk to issue.
+  int64 next_offset_;
+  // Set once a chunk came back short, at the end of the file or with an
+  // error.  Nothing is issued after it.
+  bool reached_end_;
+
+  // The chunks from |position_| on, in the order of the file.
+  std::deque<scoped_refptr<ReadaheadChunk> > chunks_;
+  // The chunks whose reads haven't been seen to complete, dropped ones
+  // included.
+  std::vector<scoped_refptr<ReadaheadChunk> > in_flight_;
+
+  // The read of the consumer in progress, if any.
+  char* buf_;
+  int buf_len_;
+  CompletionCallback* callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(Readahead);
+};
+
+Readahead::Readahead(MessageLoopForIO* message_loop, base::PlatformFile file,
+                     int max_reads, int read_size, bool direct_io)
+    : message_loop_(message_loop),
+      file_(file),
+      max_reads_(max_reads),
+      read_size_(read_size),
+      direct_io_(direct_io),
+      active_(false),
+      detached_(false),
+      position_(0),
+      next_offset_(0),
+      reached_end_(false),
+      buf_(NULL),
+      buf_len_(0),
+      callback_(NULL) {
+  DCHECK_GT(max_reads_, 0);
+  DCHECK_GT(read_size_, 0);
+  if (direct_io_) {
+    read_size_ = (read_size_ + kDirectIOAlignment - 1) /
+                 kDirectIOAlignment * kDirectIOAlignment;
+  }
+}
+
+Readahead::~Readahead() {
+  DCHECK(in_flight_.empty() || detached_);
+}
+
+void Readahead::Start(int64 position) {
+  DCHECK(!active_);
+  DCHECK(!detached_);
+  active_ = true;
+  reached_end_ = false;
+  position_ = position;
+  next_offset_ = position;
+
+  if (direct_io_ && !SetDirectIO(file_, true))
+    direct_io_ = false;
+  if (direct_io_) {
+    next_offset_ -= position % kDirectIOAlignment;
+  } else {
+#if defined(OS_LINUX)
+    // This is only a hint, so failures are ignored.
+    posix_fadvise(file_, position, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+  }
+
+  IssueReads();
+}
+
+void Readahead::Stop() {
+  DCHECK(!callback_);
+  if (!active_)
+    return;
+  active_ = false;
+  for (size_t i = 0; i < chunks_.size(); i++)
+    chunks_[i]->abandoned = true;
+  chunks_.clear();
+
+  // The regular reads and writes may use unaligned buffers.
+  if (direct_io_)
+    SetDirectIO(file_, false);
+#if defined(OS_LINUX)
+  else
+    posix_fadvise(file_, 0, 0, POSIX_FADV_NORMAL);
+#endif
+}
+
+void Readahead::Detach() {
+  callback_ = NULL;
+  buf_ = NULL;
+  Stop();
+  detached_ = true;
+  for (size_t i = 0; i < in_flight_.size(); i++)
+    in_flight_[i]->done.Wait();
+  in_flight_.clear();
+}
+
+int Readahead::Read(char* buf, int buf_len, CompletionCallback* callback) {
+  DCHECK(active_);
+  DCHECK(!callback_);
+  int rv = CopyData(buf, buf_len);
+  if (rv == ERR_IO_PENDING) {
+    buf_ = buf;
+    buf_len_ = buf_len;
+    callback_ = callback;
+  }
+  return rv;
+}
+
+void Readahead::IssueReads() {
+  while (!reached_end_ && static_cast<int>(chunks_.size()) < max_reads_) {
+    scoped_refptr<ReadaheadChunk> chunk(
+        new ReadaheadChunk(next_offset_, read_size_));
+    next_offset_ += read_size_;
+    chunks_.push_back(chunk);
+    in_flight_.push_back(chunk);
+    base::WorkerPool::PostTask(FROM_HERE,
+                               NewRunnableMethod(this, &Readahead::ReadChunk,
+                                                 chunk),
+                               true /* task_is_slow */);
+  }
+}
+
+int Readahead::CopyData(char* buf, int buf_len) {
+  DCHECK(!chunks_.empty());
+  ReadaheadChunk* chunk = chunks_.front();
+  if (!chunk->completed)
+    return ERR_IO_PENDING;
+  if (chunk->result < 0)
+    return chunk->result;
+
+  // With direct I/O, the first chunk may start before the consumer.
+  int consumed = static_cast<int>(position_ - chunk->offset);
+  int bytes = std::min(buf_len, chunk->result - consumed);
+  if (bytes <= 0) {
+    // Only the last chunk isn't consumed to its end.
+    return 0;
+  }
+  memcpy(buf, chunk->data + consumed, bytes);
+  position_ += bytes;
+  if (consumed + bytes == chunk->size) {
+    chunks_.pop_front();
+    IssueReads();
+  }
+  return bytes;
+}
+
+void Readahead::ReadChunk(ReadaheadChunk* chunk) {
+  base::ThreadRestrictions::AssertIOAllowed();
+  ssize_t res = HANDLE_EINTR(pread(file_, chunk->data, chunk->size,
+                                   static_cast<off_t>(chunk->offset)));
+  chunk->result = res == -1 ? static_cast<int>(MapErrorCode(errno)) :
+                              static_cast<int>(res);
+  message_loop_->PostTask(FROM_HERE, NewRunnableMethod(
+      this, &Readahead::OnChunkRead, make_scoped_refptr(chunk)));
+  chunk->done.Signal();
+}
+
+void Readahead::OnChunkRead(ReadaheadChunk* chunk) {
+  std::vector<scoped_refptr<ReadaheadChunk> >::iterator it =
+      std::find(in_flight_.begin(), in_flight_.end(), chunk);
+  if (it != in_flight_.end())
+    in_flight_.erase(it);
+  if (detached_ || chunk->abandoned)
+    return;
+
+  chunk->completed = true;
+  if (chunk->result < chunk->size)
+    reached_end_ = true;
+  if (!callback_ || chunk != chunks_.front())
+    return;
+
+  int rv = CopyData(buf_, buf_len_);
+  if (rv == ERR_IO_PENDING)
+    return;
+  CompletionCallback* callback = callback_;
+  callback_ = NULL;
+  buf_ = NULL;
+  callback->Run(rv);
+}
+
 }  // namespace
 
 // CancelableCallbackTask takes ownership of the Callback.  This task gets
@@ -143,7 +449,27 @@ class FileStream::AsyncContext {
       base::PlatformFile file, const char* buf, int buf_len,
       CompletionCallback* callback);
 
-  CompletionCallback* callback() const { return callback_; }
+  // Reads |file|, from the readahead once the reads are in order, or else
+  // with InitiateAsyncRead().
+  int Read(base::PlatformFile file, char* buf, int buf_len,
+           CompletionCallback* callback);
+
+  // Replaces the readahead of |file|; see FileStream::SetReadahead().
+  void SetReadahead(base::PlatformFile file, int max_reads, int read_size,
+                    bool direct_io);
+
+  // Moves the position of |file| back to the consumer's, and stops reading
+  // ahead.  Called before anything that uses or changes the position.
+  void StopReadahead(base::PlatformFile file);
+
+  // Returns false if not reading ahead.
+  bool GetReadaheadPosition(int64* position) const;
+
+  CompletionCallback* callback() const {
+    if (!callback_ && readahead_)
+      return readahead_->callback();
+    return callback_;
+  }
 
   // Called by the WorkerPool thread executing the IO after the IO completes.
   // This method queues RunAsynchronousCallback() on the MessageLoop and signals
@@ -177,6 +503,10 @@ class FileStream::AsyncContext {
 
   bool is_closing_;
 
+  scoped_refptr<Readahead> readahead_;
+  // The number of reads since the last Seek().
+  int sequential_reads_;
+
   DISALLOW_COPY_AND_ASSIGN(AsyncContext);
 };
 
@@ -187,10 +517,13 @@ FileStream::AsyncContext::AsyncContext()
           this, &AsyncContext::OnBackgroundIOCompleted),
       background_io_completed_(true, false),
       message_loop_task_(NULL),
-      is_closing_(false) {}
+      is_closing_(false),
+      sequential_reads_(0) {}
 
 FileStream::AsyncContext::~AsyncContext() {
   is_closing_ = true;
+  if (readahead_)
+    readahead_->Detach();
   if (callback_) {
     // If |callback_| is non-NULL, that implies either the worker thread is
     // still running the IO task, or the completion callback is queued up on the
@@ -220,6 +553,52 @@ void FileStream::AsyncContext::InitiateAsyncRead(
                              true /* task_is_slow */);
 }
 
+int FileStream::AsyncContext::Read(
+    base::PlatformFile file, char* buf, int buf_len,
+    CompletionCallback* callback) {
+  if (readahead_) {
+    if (!readahead_->active() &&
+        ++sequential_reads_ >= kSequentialReadsForReadahead) {
+      off_t position = lseek(file, 0, SEEK_CUR);
+      if (position != static_cast<off_t>(-1))
+        readahead_->Start(position);
+    }
+    if (readahead_->active())
+      return readahead_->Read(buf, buf_len, callback);
+  }
+  InitiateAsyncRead(file, buf, buf_len, callback);
+  return ERR_IO_PENDING;
+}
+
+void FileStream::AsyncContext::SetReadahead(
+    base::PlatformFile file, int max_reads, int read_size, bool direct_io) {
+  DCHECK(!callback());
+  if (readahead_) {
+    StopReadahead(file);
+    readahead_->Detach();
+    readahead_ = NULL;
+  }
+  if (max_reads > 0) {
+    readahead_ = new Readahead(message_loop_, file, max_reads, read_size,
+                               direct_io);
+  }
+}
+
+void FileStream::AsyncContext::StopReadahead(base::PlatformFile file) {
+  sequential_reads_ = 0;
+  if (!readahead_ || !readahead_->active())
+    return;
+  lseek(file, static_cast<off_t>(readahead_->position()), SEEK_SET);
+  readahead_->Stop();
+}
+
+bool FileStream::AsyncContext::GetReadaheadPosition(int64* position) const {
+  if (!readahead_ || !readahead_->active())
+    return false;
+  *position = readahead_->position();
+  return true;
+}
+
 void FileStream::AsyncContext::InitiateAsyncWrite(
     base::PlatformFile file, const char* buf, int buf_len,
     CompletionCallback* callback) {
@@ -270,18 +649,26 @@ void FileStream::AsyncContext::RunAsynchronousCallback() {
 FileStream::FileStream()
     : file_(base::kInvalidPlatformFileValue),
       open_flags_(0),
-      auto_closed_(true) {
+      auto_closed_(true),
+      readahead_reads_(0),
+      readahead_size_(0),
+      readahead_direct_io_(false) {
   DCHECK(!IsOpen());
 }
 
 FileStream::FileStream(base::PlatformFile file, int flags)
     : file_(file),
       open_flags_(flags),
-      auto_closed_(false) {
+      auto_closed_(false),
+      readahead_reads_(0),
+      readahead_size_(0),
+      readahead_direct_io_(false) {
   // If the file handle is opened with base::PLATFORM_FILE_ASYNC, we need to
   // make sure we will perform asynchronous File IO to it.
   if (flags & base::PLATFORM_FILE_ASYNC) {
     async_context_.reset(new AsyncContext());
+    async_context_->SetReadahead(file_, readahead_reads_, readahead_size_,
+                                 readahead_direct_io_);
   }
 }
 
@@ -316,6 +703,8 @@ int FileStream::Open(const FilePath& path, int open_flags) {
 
   if (open_flags_ & base::PLATFORM_FILE_ASYNC) {
     async_context_.reset(new AsyncContext());
+    async_context_->SetReadahead(file_, readahead_reads_, readahead_size_,
+                                 readahead_direct_io_);
   }
 
   return OK;
@@ -334,6 +723,18 @@ int64 FileStream::Seek(Whence whence, int64 offset) {
   // If we're in async, make sure we don't have a request in flight.
   DCHECK(!async_context_.get() || !async_context_->callback());
 
+  if (async_context_.get()) {
+    if (whence == FROM_CURRENT && offset == 0) {
+      // This only asks for the position, which the file is past while
+      // reading ahead.
+      int64 position;
+      if (async_context_->GetReadaheadPosition(&position))
+        return position;
+    } else {
+      async_context_->StopReadahead(file_);
+    }
+  }
+
   off_t res = lseek(file_, static_cast<off_t>(offset),
                     static_cast<int>(whence));
   if (res == static_cast<off_t>(-1))
@@ -375,8 +776,7 @@ int FileStream::Read(
     DCHECK(open_flags_ & base::PLATFORM_FILE_ASYNC);
     // If we're in async, make sure we don't have a request in flight.
     DCHECK(!async_context_->callback());
-    async_context_->InitiateAsyncRead(file_, buf, buf_len, callback);
-    return ERR_IO_PENDING;
+    return async_context_->Read(file_, buf, buf_len, callback);
   } else {
     return ReadFile(file_, buf, buf_len);
   }
@@ -415,6 +815,7 @@ int FileStream::Write(
     DCHECK(open_flags_ & base::PLATFORM_FILE_ASYNC);
     // If we're in async, make sure we don't have a request in flight.
     DCHECK(!async_context_->callback());
+    async_context_->StopReadahead(file_);
     async_context_->InitiateAsyncWrite(file_, buf, buf_len, callback);
     return ERR_IO_PENDING;
   } else {
@@ -441,6 +842,16 @@ int64 FileStream::Truncate(int64 bytes) {
   return result == 0 ? seek_position : MapErrorCode(errno);
 }
 
+void FileStream::SetReadahead(int max_reads, int read_size, bool direct_io) {
+  readahead_reads_ = max_reads;
+  readahead_size_ = read_size;
+  readahead_direct_io_ = direct_io;
+  if (async_context_.get()) {
+    async_context_->SetReadahead(file_, readahead_reads_, readahead_size_,
+                                 readahead_direct_io_);
+  }
+}
+
 int FileStream::Flush() {
   if (!IsOpen())
     return ERR_UNEXPECTED;
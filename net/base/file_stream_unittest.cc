@@ -2,6 +2,9 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <string>
+#include <vector>
+
 #include "base/callback.h"
 #include "base/file_util.h"
 #include "base/message_loop.h"
@@ -195,6 +198,124 @@ TEST_F(FileStreamTest, AsyncRead_EarlyClose) {
   }
 }
 
+// Writes a file that spans several reads ahead, and returns its contents.
+std::string WriteLargeFile(const FilePath& path) {
+  std::string data;
+  for (int i = 0; data.size() < 100 * 1024; i++)
+    data.append(kTestData + i % kTestDataSize, 1);
+  EXPECT_EQ(static_cast<int>(data.size()),
+            file_util::WriteFile(path, data.data(), data.size()));
+  return data;
+}
+
+// Reads |stream| to the end in reads of |buf_len| bytes.
+std::string ReadToEnd(FileStream* stream, int buf_len) {
+  TestCompletionCallback callback;
+  std::vector<char> buf(buf_len);
+  std::string data_read;
+  for (;;) {
+    int rv = stream->Read(&buf[0], buf_len, &callback);
+    if (rv == ERR_IO_PENDING)
+      rv = callback.WaitForResult();
+    EXPECT_LE(0, rv);
+    if (rv <= 0)
+      break;
+    data_read.append(&buf[0], rv);
+  }
+  return data_read;
+}
+
+TEST_F(FileStreamTest, AsyncRead_Readahead) {
+  std::string data = WriteLargeFile(temp_file_path());
+
+  FileStream stream;
+  stream.SetReadahead(3, 8 * 1024, false);
+  int flags = base::PLATFORM_FILE_OPEN |
+              base::PLATFORM_FILE_READ |
+              base::PLATFORM_FILE_ASYNC;
+  EXPECT_EQ(OK, stream.Open(temp_file_path(), flags));
+
+  // Reads that don't line up with the reads ahead.
+  std::string data_read = ReadToEnd(&stream, 3000);
+  EXPECT_TRUE(data_read == data);
+}
+
+TEST_F(FileStreamTest, AsyncRead_ReadaheadDirectIO) {
+  std::string data = WriteLargeFile(temp_file_path());
+
+  FileStream stream;
+  // The size is rounded up for direct I/O, which falls back to regular reads
+  // on file systems that don't support it.
+  stream.SetReadahead(2, 5000, true);
+  int flags = base::PLATFORM_FILE_OPEN |
+              base::PLATFORM_FILE_READ |
+              base::PLATFORM_FILE_ASYNC;
+  EXPECT_EQ(OK, stream.Open(temp_file_path(), flags));
+
+  // Start at an offset that isn't aligned.
+  const int kOffset = 1234;
+  EXPECT_EQ(kOffset, stream.Seek(FROM_BEGIN, kOffset));
+  std::string data_read = ReadToEnd(&stream, 1000);
+  EXPECT_TRUE(data_read == data.substr(kOffset));
+}
+
+TEST_F(FileStreamTest, AsyncRead_ReadaheadSeek) {
+  std::string data = WriteLargeFile(temp_file_path());
+
+  FileStream stream;
+  stream.SetReadahead(4, 4096, false);
+  int flags = base::PLATFORM_FILE_OPEN |
+              base::PLATFORM_FILE_READ |
+              base::PLATFORM_FILE_ASYNC;
+  EXPECT_EQ(OK, stream.Open(temp_file_path(), flags));
+
+  TestCompletionCallback callback;
+  char buf[1000];
+  int total_bytes_read = 0;
+  while (total_bytes_read < 10000) {
+    int rv = stream.Read(buf, arraysize(buf), &callback);
+    if (rv == ERR_IO_PENDING)
+      rv = callback.WaitForResult();
+    ASSERT_LT(0, rv);
+    EXPECT_EQ(data.substr(total_bytes_read, rv), std::string(buf, rv));
+    total_bytes_read += rv;
+    EXPECT_EQ(total_bytes_read, stream.Seek(FROM_CURRENT, 0));
+  }
+
+  // A relative seek is from where the consumer is, not from the reads ahead.
+  const int kOffset = -5000;
+  EXPECT_EQ(total_bytes_read + kOffset, stream.Seek(FROM_CURRENT, kOffset));
+  EXPECT_EQ(static_cast<int64>(data.size()) - total_bytes_read - kOffset,
+            stream.Available());
+  std::string data_read = ReadToEnd(&stream, 1000);
+  EXPECT_TRUE(data_read == data.substr(total_bytes_read + kOffset));
+}
+
+TEST_F(FileStreamTest, AsyncRead_ReadaheadEarlyClose) {
+  WriteLargeFile(temp_file_path());
+
+  FileStream stream;
+  stream.SetReadahead(4, 4096, false);
+  int flags = base::PLATFORM_FILE_OPEN |
+              base::PLATFORM_FILE_READ |
+              base::PLATFORM_FILE_ASYNC;
+  EXPECT_EQ(OK, stream.Open(temp_file_path(), flags));
+
+  TestCompletionCallback callback;
+  char buf[4];
+  for (int i = 0; i < 3; i++) {
+    int rv = stream.Read(buf, arraysize(buf), &callback);
+    if (rv == ERR_IO_PENDING)
+      rv = callback.WaitForResult();
+    EXPECT_EQ(static_cast<int>(arraysize(buf)), rv);
+  }
+
+  // Closes with the reads ahead in flight.
+  stream.Close();
+  MessageLoop::current()->RunAllPending();
+  EXPECT_FALSE(callback.have_result());
+}
+
 TEST_F(FileStreamTest, BasicRead_FromOffset) {
   int64 file_size;
   bool ok = file_util::GetFileSize(temp_file_path(), &file_size);
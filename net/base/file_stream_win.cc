@@ -121,13 +121,19 @@ void FileStream::AsyncContext::OnIOCompleted(
 FileStream::FileStream()
     : file_(INVALID_HANDLE_VALUE),
       open_flags_(0),
-      auto_closed_(true) {
+      auto_closed_(true),
+      readahead_reads_(0),
+      readahead_size_(0),
+      readahead_direct_io_(false) {
 }
 
 FileStream::FileStream(base::PlatformFile file, int flags)
     : file_(file),
       open_flags_(flags),
-      auto_closed_(false) {
+      auto_closed_(false),
+      readahead_reads_(0),
+      readahead_size_(0),
+      readahead_direct_io_(false) {
   // If the file handle is opened with base::PLATFORM_FILE_ASYNC, we need to
   // make sure we will perform asynchronous File IO to it.
   if (flags & base::PLATFORM_FILE_ASYNC) {
@@ -314,6 +320,14 @@ int FileStream::Write(
   return rv;
 }
 
+void FileStream::SetReadahead(int max_reads, int read_size, bool direct_io) {
+  // Overlapped reads already go through the system cache, which does its own
+  // readahead for files that are read in order.
+  readahead_reads_ = max_reads;
+  readahead_size_ = read_size;
+  readahead_direct_io_ = direct_io;
+}
+
 int FileStream::Flush() {
   base::ThreadRestrictions::AssertIOAllowed();
 
@@ -4,6 +4,8 @@
 
 #include "net/base/filter.h"
 
+#include <algorithm>
+
 #include "base/file_path.h"
 #include "base/string_util.h"
 #include "net/base/gzip_filter.h"
@@ -37,6 +39,9 @@ const char kTextHtml[]             = "text/html";
 // Buffer size allocated when de-compressing data.
 const int kFilterBufSize = 32 * 1024;
 
+// The largest that the buffer between two chained filters is grown to.
+const int kMaxChainedFilterBufSize = 256 * 1024;
+
 }  // namespace
 
 namespace net {
@@ -322,6 +327,9 @@ Filter::Filter()
       next_stream_data_(NULL),
       stream_data_len_(0),
       next_filter_(NULL),
+      pushed_input_len_(0),
+      pushed_output_len_(0),
+      filled_next_filter_buffer_(false),
       last_status_(FILTER_NEED_MORE_DATA) {
 }
 
@@ -396,12 +404,50 @@ void Filter::InitBuffer(int buffer_size) {
   stream_buffer_size_ = buffer_size;
 }
 
+void Filter::GrowBuffer(int buffer_size) {
+  DCHECK_GT(buffer_size, stream_buffer_size_);
+  DCHECK_EQ(0, stream_data_len_);
+  stream_buffer_ = new IOBuffer(buffer_size);
+  stream_buffer_size_ = buffer_size;
+  next_stream_data_ = NULL;
+}
+
 void Filter::PushDataIntoNextFilter() {
+  MaybeGrowNextFilterBuffer();
   IOBuffer* next_buffer = next_filter_->stream_buffer();
   int next_size = next_filter_->stream_buffer_size();
+  int input_len = stream_data_len_;
   last_status_ = ReadFilteredData(next_buffer->data(), &next_size);
-  if (FILTER_ERROR != last_status_)
-    next_filter_->FlushStreamBuffer(next_size);
+  if (FILTER_ERROR == last_status_)
+    return;
+
+  pushed_input_len_ += input_len - stream_data_len_;
+  pushed_output_len_ += next_size;
+  filled_next_filter_buffer_ =
+      (next_size == next_filter_->stream_buffer_size());
+  next_filter_->FlushStreamBuffer(next_size);
+}
+
+void Filter::MaybeGrowNextFilterBuffer() {
+  int next_buffer_size = next_filter_->stream_buffer_size();
+  // The buffer can't be swapped while it holds data for the next filter to
+  // read.
+  if (!filled_next_filter_buffer_ || next_filter_->stream_data_len() ||
+      next_buffer_size >= kMaxChainedFilterBufSize) {
+    return;
+  }
+
+  // Aim for what a full stream_buffer_ of ours expands to.  Decoders like
+  // zlib consume their input well ahead of producing output, so the ratio
+  // seen so far runs low; always at least double the buffer.
+  int64 new_size = 2 * static_cast<int64>(next_buffer_size);
+  if (pushed_input_len_ > 0) {
+    new_size = std::max(new_size, stream_buffer_size_ * pushed_output_len_ /
+                                      pushed_input_len_);
+  }
+  new_size = std::min(new_size, static_cast<int64>(kMaxChainedFilterBufSize));
+  next_filter_->GrowBuffer(static_cast<int>(new_size));
+  filled_next_filter_buffer_ = false;
 }
 
 }  // namespace net
@@ -236,6 +236,10 @@ class Filter {
   // Allocates and initializes stream_buffer_ and stream_buffer_size_.
   void InitBuffer(int size);
 
+  // Replaces stream_buffer_ with a larger one of |size| chars.  Must only be
+  // called when stream_buffer_ is empty.
+  void GrowBuffer(int size);
+
   // A factory helper for creating filters for within a chain of potentially
   // multiple encodings.  If a chain of filters is created, then this may be
   // called multiple times during the filter creation process.  In most simple
@@ -256,6 +260,11 @@ class Filter {
   // Helper function to empty our output into the next filter's input.
   void PushDataIntoNextFilter();
 
+  // Grows next_filter_'s stream_buffer_ if our last push filled it, so that
+  // a highly compressed stream doesn't take a trip through the chain for
+  // every stream_buffer_size() chars of its output.
+  void MaybeGrowNextFilterBuffer();
+
   // Constructs a filter with an internal buffer of the given size.
   // Only meant to be called by unit tests that need to control the buffer size.
   static Filter* FactoryForTests(const std::vector<FilterType>& filter_types,
@@ -264,6 +273,12 @@ class Filter {
 
   // An optional filter to process output from this filter.
   scoped_ptr<Filter> next_filter_;
+  // Total chars we have consumed, and produced, while pushing data into
+  // next_filter_.  Their ratio is used to size next_filter_'s stream_buffer_.
+  int64 pushed_input_len_;
+  int64 pushed_output_len_;
+  // Whether our last push filled next_filter_'s stream_buffer_.
+  bool filled_next_filter_buffer_;
   // Remember what status or local filter last returned so we can better handle
   // chained filters.
   FilterStatus last_status_;
@@ -0,0 +1,119 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(USE_SYSTEM_ZLIB)
+#include <zlib.h>
+#else
+#include "third_party/zlib/zlib.h"
+#endif
+
+#include "base/memory/scoped_ptr.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "net/base/filter.h"
+#include "net/base/io_buffer.h"
+#include "net/base/mock_filter_context.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kBodySize = 4 * 1024 * 1024;
+const int kNumIterations = 10;
+
+// The size of the reads URLRequestJob does from the filter.
+const int kReadSize = 32 * 1024;
+
+// Returns |size| bytes of text that compress about as well as a typical page.
+std::string MakeBody(int size) {
+  static const char* const kWords[] = {
+    "<div class=\"", "content", "\">", "</div>\n", "the ", "request ",
+    "response ", "<a href=\"http://www.example.com/", "\">", "</a> ",
+    "function(", ") { return ", "; }\n", "var ", " = ", "0123456789",
+  };
+  std::string body;
+  body.reserve(size);
+  unsigned int seed = 1;
+  while (static_cast<int>(body.size()) < size) {
+    seed = seed * 1103515245 + 12345;
+    body.append(kWords[(seed >> 16) % arraysize(kWords)]);
+  }
+  body.resize(size);
+  return body;
+}
+
+// Returns |body| compressed with the wrapper for |type|, as servers send it.
+std::string Compress(const std::string& body, net::Filter::FilterType type) {
+  // Adding 16 to the window bits asks for the gzip wrapper.
+  int window_bits =
+      type == net::Filter::FILTER_TYPE_GZIP ? MAX_WBITS + 16 : MAX_WBITS;
+
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  EXPECT_EQ(Z_OK, deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                               window_bits, 8, Z_DEFAULT_STRATEGY));
+
+  std::vector<char> encoded(deflateBound(&stream, body.size()) + 32);
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(body.data()));
+  stream.avail_in = body.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&encoded[0]);
+  stream.avail_out = encoded.size();
+  EXPECT_EQ(Z_STREAM_END, deflate(&stream, Z_FINISH));
+  encoded.resize(encoded.size() - stream.avail_out);
+  deflateEnd(&stream);
+  return std::string(encoded.begin(), encoded.end());
+}
+
+void DecodeBody(const char* name, net::Filter::FilterType type) {
+  const std::string body = MakeBody(kBodySize);
+  const std::string encoded = Compress(body, type);
+  std::vector<net::Filter::FilterType> filter_types(1, type);
+  net::MockFilterContext filter_context;
+  scoped_refptr<net::IOBuffer> output(new net::IOBuffer(kReadSize));
+
+  PerfTimer timer;
+  for (int i = 0; i < kNumIterations; i++) {
+    scoped_ptr<net::Filter> filter(
+        net::Filter::Factory(filter_types, filter_context));
+    ASSERT_TRUE(filter.get());
+
+    size_t offset = 0;
+    int decoded = 0;
+    net::Filter::FilterStatus status = net::Filter::FILTER_NEED_MORE_DATA;
+    while (status != net::Filter::FILTER_DONE) {
+      if (status == net::Filter::FILTER_NEED_MORE_DATA) {
+        ASSERT_LT(offset, encoded.size());
+        int size = std::min(filter->stream_buffer_size(),
+                            static_cast<int>(encoded.size() - offset));
+        memcpy(filter->stream_buffer()->data(), encoded.data() + offset, size);
+        filter->FlushStreamBuffer(size);
+        offset += size;
+      }
+      int output_len = kReadSize;
+      status = filter->ReadData(output->data(), &output_len);
+      ASSERT_NE(net::Filter::FILTER_ERROR, status);
+      decoded += output_len;
+    }
+    EXPECT_EQ(kBodySize, decoded);
+  }
+  base::TimeDelta elapsed = timer.Elapsed();
+  LogPerfResult(name, elapsed.InMillisecondsF(), "ms");
+  double megabytes = static_cast<double>(kBodySize) * kNumIterations /
+      (1024 * 1024);
+  LogPerfResult(base::StringPrintf("%s_rate", name).c_str(),
+                megabytes / elapsed.InSecondsF(), "MB/s");
+}
+
+TEST(GZipFilterPerfTest, DecodeGZip) {
+  DecodeBody("GZip_filter_decode_gzip", net::Filter::FILTER_TYPE_GZIP);
+}
+
+TEST(GZipFilterPerfTest, DecodeDeflate) {
+  DecodeBody("GZip_filter_decode_deflate", net::Filter::FILTER_TYPE_DEFLATE);
+}
+
+}  // namespace
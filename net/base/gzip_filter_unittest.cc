@@ -394,4 +394,35 @@ TEST_F(GZipUnitTest, DecodeCorruptedHeader) {
   EXPECT_TRUE(code == Filter::FILTER_ERROR);
 }
 
+// Tests decoding gzip data whose header has every optional field, both when
+// the header arrives whole and when it arrives a byte at a time.
+TEST_F(GZipUnitTest, DecodeGZipWithOptionalHeaderFields) {
+  std::string header(kGZipHeader, sizeof(kGZipHeader));
+  header[3] = 0x1e;  // FHCRC | FEXTRA | FNAME | FCOMMENT
+  header.append("\003\000abc", 5);  // XLEN and the extra field.
+  header.append("google.txt", sizeof("google.txt"));
+  header.append("a comment", sizeof("a comment"));
+  header.append("\125\252", 2);  // The header CRC, which isn't checked.
+
+  std::string encoded(header);
+  encoded.append(gzip_encode_buffer_ + sizeof(kGZipHeader),
+                 gzip_encode_len_ - sizeof(kGZipHeader));
+  ASSERT_LE(static_cast<int>(encoded.size()), kDefaultBufferSize);
+
+  InitFilter(Filter::FILTER_TYPE_GZIP);
+  char decode_buffer[kDefaultBufferSize];
+  int decode_size = kDefaultBufferSize;
+  int code = DecodeAllWithFilter(filter_.get(), encoded.data(),
+                                 static_cast<int>(encoded.size()),
+                                 decode_buffer, &decode_size);
+  EXPECT_NE(Filter::FILTER_ERROR, code);
+  ASSERT_EQ(source_len(), decode_size);
+  EXPECT_EQ(0, memcmp(source_buffer(), decode_buffer, source_len()));
+
+  InitFilterWithBufferSize(Filter::FILTER_TYPE_GZIP, 1);
+  DecodeAndCompareWithFilter(filter_.get(), source_buffer(), source_len(),
+                             encoded.data(), static_cast<int>(encoded.size()),
+                             kDefaultBufferSize);
+}
+
 }  // namespace net
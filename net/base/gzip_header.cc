@@ -14,6 +14,13 @@
 
 namespace net {
 
+namespace {
+
+// The size of the fields every gzip header has, from ID1 to OS.
+const int kFixedHeaderSize = 10;
+
+}  // namespace
+
 const uint8 GZipHeader::magic[] = { 0x1f, 0x8b };
 
 GZipHeader::GZipHeader() {
@@ -35,6 +42,16 @@ GZipHeader::Status GZipHeader::ReadMore(const char* inbuf, int inbuf_len,
   const uint8* pos = reinterpret_cast<const uint8*>(inbuf);
   const uint8* const end = pos + inbuf_len;
 
+  // Nearly always the whole fixed-size part of the header is in the first
+  // read, so check it in one go rather than a byte at a time.
+  if ( state_ == IN_HEADER_ID1 && end - pos >= kFixedHeaderSize ) {
+    if ( pos[0] != magic[0] || pos[1] != magic[1] || pos[2] != Z_DEFLATED )
+      return INVALID_HEADER;
+    flags_ = pos[3] & (FLAG_FHCRC | FLAG_FEXTRA | FLAG_FNAME | FLAG_FCOMMENT);
+    pos += kFixedHeaderSize;
+    state_ = IN_XLEN_BYTE_0;
+  }
+
   while ( pos < end ) {
     switch ( state_ ) {
       case IN_HEADER_ID1:
@@ -93,6 +110,14 @@ GZipHeader::Status GZipHeader::ReadMore(const char* inbuf, int inbuf_len,
         }
         // We have a two-byte little-endian length, followed by a
         // field of that length.
+        if ( end - pos > 2 ) {
+          // Both length bytes are here, and at least one more to go on
+          // to IN_FEXTRA with.
+          extra_length_ = pos[0] + (pos[1] << 8);
+          pos += 2;
+          state_ = IN_FEXTRA;
+          break;
+        }
         extra_length_ = *pos;
         pos++;
         state_++;
@@ -160,6 +185,12 @@ GZipHeader::Status GZipHeader::ReadMore(const char* inbuf, int inbuf_len,
           state_ = IN_DONE;
           break;
         }
+        if ( end - pos >= 2 ) {
+          pos += 2;
+          flags_ &= ~FLAG_FHCRC;   // we're done with the FHCRC stuff
+          state_ = IN_DONE;
+          break;
+        }
         pos++;
         state_++;
         break;
@@ -1,20 +1,53 @@
-// Copyright (c) 2009 The Chromium Authors. All rights reserved.
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
 #include "net/base/host_cache.h"
 
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
 #include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/stl_util-inl.h"
+#include "base/values.h"
 #include "net/base/net_errors.h"
+#include "net/base/net_util.h"
+#include "net/base/sys_addrinfo.h"
 
 namespace net {
 
+namespace {
+
+// Returns roughly how much memory the entry for |key| holds.
+size_t EstimateEntrySize(const HostCache::Key& key,
+                         const HostCache::Entry* entry) {
+  size_t size = sizeof(*entry) + key.hostname.size();
+  for (const struct addrinfo* ai = entry->addrlist.head(); ai;
+       ai = ai->ai_next) {
+    size += sizeof(*ai) + ai->ai_addrlen;
+    if (ai->ai_canonname)
+      size += strlen(ai->ai_canonname) + 1;
+  }
+  return size;
+}
+
+}  // namespace
+
 //-----------------------------------------------------------------------------
 
-HostCache::Entry::Entry(int error,
+HostCache::Entry::Entry(const Key& key,
+                        int error,
                         const AddressList& addrlist,
                         base::TimeTicks expiration)
-    : error(error), addrlist(addrlist), expiration(expiration) {
+    : error(error),
+      addrlist(addrlist),
+      expiration(expiration),
+      network(-1),
+      key(key) {
 }
 
 HostCache::Entry::~Entry() {
@@ -27,10 +60,14 @@ HostCache::HostCache(size_t max_entries,
                      base::TimeDelta failure_entry_ttl)
     : max_entries_(max_entries),
       success_entry_ttl_(success_entry_ttl),
-      failure_entry_ttl_(failure_entry_ttl) {
+      failure_entry_ttl_(failure_entry_ttl),
+      network_(-1),
+      delegate_(NULL) {
 }
 
 HostCache::~HostCache() {
+  while (lru_list_.head() != lru_list_.end())
+    lru_list_.head()->RemoveFromList();
 }
 
 const HostCache::Entry* HostCache::Lookup(const Key& key,
@@ -44,8 +81,30 @@ const HostCache::Entry* HostCache::Lookup(const Key& key,
     return NULL;  // Not found.
 
   Entry* entry = it->second.get();
-  if (CanUseEntry(entry, now))
+  if (IsOnCurrentNetwork(entry) && CanUseEntry(entry, now)) {
+    TouchEntry(entry);
     return entry;
+  }
+
+  return NULL;
+}
+
+const HostCache::Entry* HostCache::LookupStale(const Key& key,
+                                               base::TimeTicks now) const {
+  DCHECK(CalledOnValidThread());
+  if (caching_is_disabled())
+    return NULL;
+
+  EntryMap::const_iterator it = entries_.find(key);
+  if (it == entries_.end())
+    return NULL;  // Not found.
+
+  Entry* entry = it->second.get();
+  if (IsOnCurrentNetwork(entry) && !CanUseEntry(entry, now) &&
+      CanUseStaleEntry(entry, now)) {
+    TouchEntry(entry);
+    return entry;
+  }
 
   return NULL;
 }
@@ -61,29 +120,195 @@ HostCache::Entry* HostCache::Set(const Key& key,
   base::TimeTicks expiration = now +
       (error == OK ? success_entry_ttl_ : failure_entry_ttl_);
 
-  scoped_refptr<Entry>& entry = entries_[key];
-  if (!entry) {
+  EntryMap::iterator it = entries_.find(key);
+  if (it == entries_.end()) {
     // Entry didn't exist, creating one now.
-    Entry* ptr = new Entry(error, addrlist, expiration);
-    entry = ptr;
+    Entry* ptr = new Entry(key, error, addrlist, expiration);
+    ptr->network = network_;
+    AddEntry(ptr, false);
 
     // Compact the cache if we grew it beyond limit -- exclude |entry| from
     // being pruned though!
     if (entries_.size() > max_entries_)
       Compact(now, ptr);
+    if (delegate_)
+      delegate_->EntriesAreDirty(this);
     return ptr;
   } else {
     // Update an existing cache entry.
+    Entry* entry = it->second.get();
+    expirations_.erase(std::make_pair(entry->expiration, entry));
     entry->error = error;
     entry->addrlist = addrlist;
     entry->expiration = expiration;
-    return entry.get();
+    entry->network = network_;
+    expirations_.insert(std::make_pair(entry->expiration, entry));
+    TouchEntry(entry);
+    if (delegate_)
+      delegate_->EntriesAreDirty(this);
+    return entry;
   }
 }
 
 void HostCache::clear() {
   DCHECK(CalledOnValidThread());
+  while (lru_list_.head() != lru_list_.end())
+    lru_list_.head()->RemoveFromList();
+  expirations_.clear();
   entries_.clear();
+  if (delegate_)
+    delegate_->EntriesAreDirty(this);
+}
+
+void HostCache::ClearNegativeEntries() {
+  DCHECK(CalledOnValidThread());
+  bool removed = false;
+  for (EntryMap::iterator it = entries_.begin(); it != entries_.end(); ) {
+    if (it->second->error != OK) {
+      RemoveEntry(it++);
+      removed = true;
+    } else {
+      ++it;
+    }
+  }
+  if (removed && delegate_)
+    delegate_->EntriesAreDirty(this);
+}
+
+size_t HostCache::PurgeMemory(MemoryPressureLevel level,
+                              base::TimeTicks now) {
+  DCHECK(CalledOnValidThread());
+  size_t freed = 0;
+  for (EntryMap::iterator it = entries_.begin(); it != entries_.end(); ) {
+    const Entry* entry = it->second;
+    if (level == MEMORY_PRESSURE_CRITICAL || !IsOnCurrentNetwork(entry) ||
+        (!CanUseEntry(entry, now) && !CanUseStaleEntry(entry, now))) {
+      freed += EstimateEntrySize(it->first, entry);
+      RemoveEntry(it++);
+    } else {
+      ++it;
+    }
+  }
+  if (freed && delegate_)
+    delegate_->EntriesAreDirty(this);
+  return freed;
+}
+
+void HostCache::set_network(int network) {
+  DCHECK(CalledOnValidThread());
+  network_ = network;
+}
+
+int HostCache::network() const {
+  DCHECK(CalledOnValidThread());
+  return network_;
+}
+
+void HostCache::Serialize(std::string* output) const {
+  DCHECK(CalledOnValidThread());
+  const base::TimeTicks now = base::TimeTicks::Now();
+  const base::Time wall_now = base::Time::Now();
+  ListValue entries;
+  for (EntryMap::const_iterator it = entries_.begin(); it != entries_.end();
+       ++it) {
+    const Key& key = it->first;
+    const Entry* entry = it->second.get();
+    if (!IsOnCurrentNetwork(entry) ||
+        (!CanUseEntry(entry, now) && !CanUseStaleEntry(entry, now))) {
+      continue;
+    }
+    // The canonical name isn't saved, so those entries can't be restored.
+    if (entry->error != OK ||
+        (key.host_resolver_flags & HOST_RESOLVER_CANONNAME)) {
+      continue;
+    }
+
+    ListValue* addresses = new ListValue;
+    for (const struct addrinfo* ai = entry->addrlist.head(); ai;
+         ai = ai->ai_next) {
+      addresses->Append(Value::CreateStringValue(NetAddressToString(ai)));
+    }
+
+    DictionaryValue* value = new DictionaryValue;
+    value->SetString("hostname", key.hostname);
+    value->SetInteger("address_family", key.address_family);
+    value->SetInteger("flags", key.host_resolver_flags);
+    value->SetDouble("expiration",
+                     (wall_now + (entry->expiration - now)).ToDoubleT());
+    value->Set("addresses", addresses);
+    entries.Append(value);
+  }
+
+  base::JSONWriter::Write(&entries, false /* no pretty print */, output);
+}
+
+bool HostCache::LoadEntries(const std::string& input) {
+  DCHECK(CalledOnValidThread());
+  scoped_ptr<Value> value(
+      base::JSONReader::Read(input, false /* do not allow trailing commas */));
+  if (!value.get() || !value->IsType(Value::TYPE_LIST))
+    return false;
+
+  ListValue* entries = static_cast<ListValue*>(value.get());
+  const base::TimeTicks now = base::TimeTicks::Now();
+  const base::Time wall_now = base::Time::Now();
+  for (size_t i = 0;
+       i < entries->GetSize() && entries_.size() < max_entries_; ++i) {
+    DictionaryValue* entry_value;
+    std::string hostname;
+    int address_family;
+    int flags;
+    double expiration;
+    ListValue* address_list;
+    if (!entries->GetDictionary(i, &entry_value) ||
+        !entry_value->GetString("hostname", &hostname) ||
+        !entry_value->GetInteger("address_family", &address_family) ||
+        !entry_value->GetInteger("flags", &flags) ||
+        !entry_value->GetDouble("expiration", &expiration) ||
+        !entry_value->GetList("addresses", &address_list)) {
+      continue;
+    }
+    if (address_family != ADDRESS_FAMILY_UNSPECIFIED &&
+        address_family != ADDRESS_FAMILY_IPV4 &&
+        address_family != ADDRESS_FAMILY_IPV6) {
+      continue;
+    }
+
+    Key key(hostname, static_cast<AddressFamily>(address_family), flags);
+    if (entries_.find(key) != entries_.end())
+      continue;
+
+    AddressList addrlist;
+    for (size_t j = 0; j < address_list->GetSize(); ++j) {
+      std::string address_string;
+      IPAddressNumber address;
+      if (!address_list->GetString(j, &address_string) ||
+          !ParseIPLiteralToNumber(address_string, &address)) {
+        continue;
+      }
+      AddressList single(address, 0, false);
+      if (addrlist.head())
+        addrlist.Append(single.head());
+      else
+        addrlist = single;
+    }
+    if (!addrlist.head())
+      continue;
+
+    // Whatever TTL was left, the entry is now expired, so it is refreshed the
+    // first time it is used.
+    base::TimeDelta remaining =
+        base::Time::FromDoubleT(expiration) - wall_now;
+    scoped_refptr<Entry> entry(new Entry(
+        key, OK, addrlist, now + std::min(remaining, base::TimeDelta())));
+    if (!CanUseStaleEntry(entry, now))
+      continue;
+    entry->network = network_;
+    // Restored entries haven't been used in this session, so they are the
+    // first to go if the cache fills up.
+    AddEntry(entry, true);
+  }
+  return true;
 }
 
 size_t HostCache::size() const {
@@ -106,6 +331,16 @@ base::TimeDelta HostCache::failure_entry_ttl() const {
   return failure_entry_ttl_;
 }
 
+void HostCache::set_stale_grace_period(base::TimeDelta stale_grace_period) {
+  DCHECK(CalledOnValidThread());
+  stale_grace_period_ = stale_grace_period;
+}
+
+base::TimeDelta HostCache::stale_grace_period() const {
+  DCHECK(CalledOnValidThread());
+  return stale_grace_period_;
+}
+
 // Note that this map may contain expired entries.
 const HostCache::EntryMap& HostCache::entries() const {
   DCHECK(CalledOnValidThread());
@@ -117,32 +352,62 @@ bool HostCache::CanUseEntry(const Entry* entry, const base::TimeTicks now) {
   return entry->expiration > now;
 }
 
+bool HostCache::IsOnCurrentNetwork(const Entry* entry) const {
+  return entry->network == network_;
+}
+
+bool HostCache::CanUseStaleEntry(const Entry* entry,
+                                 const base::TimeTicks now) const {
+  return entry->error == OK && entry->expiration + stale_grace_period_ > now;
+}
+
+void HostCache::AddEntry(Entry* entry, bool least_recently_used) {
+  DCHECK(!ContainsKey(entries_, entry->key));
+  entries_[entry->key] = entry;
+  expirations_.insert(std::make_pair(entry->expiration, entry));
+  if (least_recently_used)
+    entry->InsertBefore(lru_list_.head());
+  else
+    lru_list_.Append(entry);
+}
+
+void HostCache::RemoveEntry(EntryMap::iterator it) {
+  Entry* entry = it->second.get();
+  entry->RemoveFromList();
+  expirations_.erase(std::make_pair(entry->expiration, entry));
+  entries_.erase(it);
+}
+
+void HostCache::TouchEntry(Entry* entry) const {
+  entry->RemoveFromList();
+  lru_list_.Append(entry);
+}
+
 void HostCache::Compact(base::TimeTicks now, const Entry* pinned_entry) {
-  // Clear out expired entries.
-  for (EntryMap::iterator it = entries_.begin(); it != entries_.end(); ) {
-    Entry* entry = (it->second).get();
-    if (entry != pinned_entry && !CanUseEntry(entry, now)) {
-      entries_.erase(it++);
-    } else {
-      ++it;
+  while (entries_.size() > max_entries_) {
+    Entry* victim = NULL;
+
+    // Drop the entry that expired first if it can't be served anymore, not
+    // even stale.
+    ExpirationSet::const_iterator first = expirations_.begin();
+    if (first != expirations_.end() && first->second == pinned_entry)
+      ++first;
+    if (first != expirations_.end() && !CanUseEntry(first->second, now) &&
+        !CanUseStaleEntry(first->second, now)) {
+      victim = first->second;
     }
-  }
 
-  if (entries_.size() <= max_entries_)
-    return;
-
-  // If we still have too many entries, start removing unexpired entries
-  // at random.
-  // TODO(eroman): this eviction policy could be better (access count FIFO
-  // or whatever).
-  for (EntryMap::iterator it = entries_.begin();
-       it != entries_.end() && entries_.size() > max_entries_; ) {
-    Entry* entry = (it->second).get();
-    if (entry != pinned_entry) {
-      entries_.erase(it++);
-    } else {
-      ++it;
+    // Otherwise drop the least recently used entry.
+    if (!victim) {
+      base::LinkNode<Entry>* node = lru_list_.head();
+      if (node != lru_list_.end() && node->value() == pinned_entry)
+        node = node->next();
+      if (node == lru_list_.end())
+        break;
+      victim = node->value();
     }
+
+    RemoveEntry(entries_.find(victim->key));
   }
 
   if (entries_.size() > max_entries_)
@@ -6,24 +6,118 @@
 #define NET_BASE_HOST_CACHE_H_
 #pragma once
 
-#include <map>
+#include <set>
 #include <string>
+#include <utility>
 
 #include "base/gtest_prod_util.h"
+#include "base/hash_tables.h"
+#include "base/linked_list.h"
 #include "base/memory/ref_counted.h"
 #include "base/threading/non_thread_safe.h"
 #include "base/time.h"
 #include "net/base/address_family.h"
 #include "net/base/address_list.h"
+#include "net/base/memory_pressure_level.h"
+
+namespace net {
+
+// Identifies a HostCache entry. This is HostCache::Key; it is declared out
+// of the class so that it can be hashed.
+struct HostCacheKey {
+  HostCacheKey(const std::string& hostname, AddressFamily address_family,
+               HostResolverFlags host_resolver_flags)
+      : hostname(hostname),
+        address_family(address_family),
+        host_resolver_flags(host_resolver_flags) {}
+
+  bool operator==(const HostCacheKey& other) const {
+    // |address_family| and |host_resolver_flags| are compared before
+    // |hostname| under assumption that integer comparisons are faster than
+    // string comparisons.
+    return (other.address_family == address_family &&
+            other.host_resolver_flags == host_resolver_flags &&
+            other.hostname == hostname);
+  }
+
+  bool operator<(const HostCacheKey& other) const {
+    // |address_family| and |host_resolver_flags| are compared before
+    // |hostname| under assumption that integer comparisons are faster than
+    // string comparisons.
+    if (address_family != other.address_family)
+      return address_family < other.address_family;
+    if (host_resolver_flags != other.host_resolver_flags)
+      return host_resolver_flags < other.host_resolver_flags;
+    return hostname < other.hostname;
+  }
+
+  std::string hostname;
+  AddressFamily address_family;
+  HostResolverFlags host_resolver_flags;
+};
+
+}  // namespace net
+
+// Provide a hash function so that hash_maps can be keyed by HostCacheKey.
+#if defined(COMPILER_GCC)
+namespace __gnu_cxx {
+
+template<>
+struct hash<net::HostCacheKey> {
+  size_t operator()(const net::HostCacheKey& key) const {
+    return hash<std::string>()(key.hostname) * 31 +
+        key.address_family * 7 + key.host_resolver_flags;
+  }
+};
+
+}  // namespace __gnu_cxx
+#elif defined(COMPILER_MSVC)
+namespace stdext {
+
+inline size_t hash_value(const net::HostCacheKey& key) {
+  return hash_value(key.hostname) * 31 +
+      key.address_family * 7 + key.host_resolver_flags;
+}
+
+}  // namespace stdext
+#endif  // COMPILER
 
 namespace net {
 
 // Cache used by HostResolver to map hostnames to their resolved result.
+//
+// The successful entries can be saved across restarts: a Delegate is told
+// when the entries change, and can Serialize() them and LoadEntries() them
+// back later.
+//
+// Entries are kept in a hash map, and on an intrusive list in least recently
+// used order. When the cache is full, adding an entry evicts an entry that
+// can't be served anymore, even stale, if there is one, and otherwise the
+// least recently used entry.
+//
+// Entries are tagged with the network they were resolved on, and only the
+// entries of the current network are served. See set_network().
 class HostCache : public base::NonThreadSafe {
  public:
+  class Delegate {
+   public:
+    // Called when entries are added, updated or cleared. This must not
+    // reenter the HostCache.
+    virtual void EntriesAreDirty(HostCache* cache) = 0;
+
+   protected:
+    virtual ~Delegate() {}
+  };
+
+  typedef HostCacheKey Key;
+
   // Stores the latest address list that was looked up for a hostname.
-  struct Entry : public base::RefCounted<Entry> {
-    Entry(int error, const AddressList& addrlist, base::TimeTicks expiration);
+  struct Entry : public base::RefCounted<Entry>,
+                 public base::LinkNode<Entry> {
+    Entry(const Key& key,
+          int error,
+          const AddressList& addrlist,
+          base::TimeTicks expiration);
 
     // The resolve results for this entry.
     int error;
@@ -32,45 +126,20 @@ class HostCache : public base::NonThreadSafe {
     // The time when this entry expires.
     base::TimeTicks expiration;
 
+    // The network this entry was resolved on. See HostCache::set_network().
+    int network;
+
    private:
     friend class base::RefCounted<Entry>;
+    friend class HostCache;
 
     ~Entry();
-  };
 
-  struct Key {
-    Key(const std::string& hostname, AddressFamily address_family,
-        HostResolverFlags host_resolver_flags)
-        : hostname(hostname),
-          address_family(address_family),
-          host_resolver_flags(host_resolver_flags) {}
-
-    bool operator==(const Key& other) const {
-      // |address_family| and |host_resolver_flags| are compared before
-      // |hostname| under assumption that integer comparisons are faster than
-      // string comparisons.
-      return (other.address_family == address_family &&
-              other.host_resolver_flags == host_resolver_flags &&
-              other.hostname == hostname);
-    }
-
-    bool operator<(const Key& other) const {
-      // |address_family| and |host_resolver_flags| are compared before
-      // |hostname| under assumption that integer comparisons are faster than
-      // string comparisons.
-      if (address_family != other.address_family)
-        return address_family < other.address_family;
-      if (host_resolver_flags != other.host_resolver_flags)
-        return host_resolver_flags < other.host_resolver_flags;
-      return hostname < other.hostname;
-    }
-
-    std::string hostname;
-    AddressFamily address_family;
-    HostResolverFlags host_resolver_flags;
+    // The key of this entry, to remove it from the map when it is evicted.
+    const Key key;
   };
 
-  typedef std::map<Key, scoped_refptr<Entry> > EntryMap;
+  typedef base::hash_map<Key, scoped_refptr<Entry> > EntryMap;
 
   // Constructs a HostCache that caches successful host resolves for
   // |success_entry_ttl| time, and failed host resolves for
@@ -82,9 +151,15 @@ class HostCache : public base::NonThreadSafe {
   ~HostCache();
 
   // Returns a pointer to the entry for |key|, which is valid at time
-  // |now|. If there is no such entry, returns NULL.
+  // |now|. If there is no such entry, returns NULL. A hit makes the entry
+  // the most recently used one.
   const Entry* Lookup(const Key& key, base::TimeTicks now) const;
 
+  // Returns a pointer to the successful entry for |key| that has expired at
+  // time |now|, but by less than the stale grace period. If there is no such
+  // entry, returns NULL. A hit makes the entry the most recently used one.
+  const Entry* LookupStale(const Key& key, base::TimeTicks now) const;
+
   // Overwrites or creates an entry for |key|. Returns the pointer to the
   // entry, or NULL on failure (fails if caching is disabled).
   // (|error|, |addrlist|) is the value to set, and |now| is the current
@@ -97,6 +172,38 @@ class HostCache : public base::NonThreadSafe {
   // Empties the cache
   void clear();
 
+  // Removes the failed entries, which may have failed because of the network
+  // rather than of the name.
+  void ClearNegativeEntries();
+
+  // Removes the entries that can't be served at time |now|, even stale, and
+  // those of other networks, or all of them if |level| is critical.  Returns
+  // an estimate of the memory that held them.
+  size_t PurgeMemory(MemoryPressureLevel level, base::TimeTicks now);
+
+  // Sets the network that new entries are tagged with, typically the index of
+  // the interface that carries the default route, or -1 if it isn't known.
+  // Only the entries tagged with the current network are returned by
+  // lookups, but the others are kept until they are evicted, so that they
+  // can be served again if the previous network comes back.
+  void set_network(int network);
+  int network() const;
+
+  // Writes the successful entries that are still usable, at least as stale
+  // entries, to |output|. Their expiration is saved as wall clock time.
+  void Serialize(std::string* output) const;
+
+  // Adds the entries serialized in |input| for the keys that have no entry
+  // yet, as long as there is room. The entries are restored as expired, so
+  // that they are only served by LookupStale(), and get refreshed on first
+  // use; the ones that have been expired for longer than the stale grace
+  // period are skipped. Returns false if |input| can't be parsed.
+  bool LoadEntries(const std::string& input);
+
+  // Sets the delegate to tell about changes, or NULL. The delegate must
+  // outlive the cache, or be reset before the cache goes away.
+  void set_delegate(Delegate* delegate) { delegate_ = delegate; }
+
   // Returns the number of entries in the cache.
   size_t size() const;
 
@@ -107,18 +214,49 @@ class HostCache : public base::NonThreadSafe {
 
   base::TimeDelta failure_entry_ttl() const;
 
+  // How long past their expiration successful entries may still be served
+  // by LookupStale(). Zero, the default, disables serving stale entries.
+  void set_stale_grace_period(base::TimeDelta stale_grace_period);
+  base::TimeDelta stale_grace_period() const;
+
   // Note that this map may contain expired entries.
   const EntryMap& entries() const;
 
  private:
   FRIEND_TEST_ALL_PREFIXES(HostCacheTest, Compact);
+  FRIEND_TEST_ALL_PREFIXES(HostCacheTest, CompactKeepsStaleEntries);
+  FRIEND_TEST_ALL_PREFIXES(HostCacheTest, EvictLeastRecentlyUsed);
   FRIEND_TEST_ALL_PREFIXES(HostCacheTest, NoCache);
 
   // Returns true if this cache entry's result is valid at time |now|.
   static bool CanUseEntry(const Entry* entry, const base::TimeTicks now);
 
+  // Returns true if |entry| was resolved on the current network.
+  bool IsOnCurrentNetwork(const Entry* entry) const;
+
+  // Returns true if |entry| can be returned by LookupStale() at time |now|.
+  bool CanUseStaleEntry(const Entry* entry, const base::TimeTicks now) const;
+
+  // The entries ordered by expiration, so that the first one is the best
+  // candidate for eviction when it can't be served anymore.
+  typedef std::set<std::pair<base::TimeTicks, Entry*> > ExpirationSet;
+
+  // Adds |entry| to the map, to the expiration set, and to the LRU list,
+  // either as the most recently used entry or, if |least_recently_used|, as
+  // the least recently used one.
+  void AddEntry(Entry* entry, bool least_recently_used);
+
+  // Removes the entry at |it| from the map, the LRU list and the expiration
+  // set.
+  void RemoveEntry(EntryMap::iterator it);
+
+  // Makes |entry| the most recently used entry.
+  void TouchEntry(Entry* entry) const;
+
   // Prunes entries from the cache to bring it below max entry bound. Entries
-  // matching |pinned_entry| will NOT be pruned.
+  // matching |pinned_entry| will NOT be pruned. The entry that expired first
+  // goes first if it can't be served anymore, even stale; otherwise the least
+  // recently used entry goes.
   void Compact(base::TimeTicks now, const Entry* pinned_entry);
 
   // Returns true if this HostCache can contain no entries.
@@ -133,10 +271,24 @@ class HostCache : public base::NonThreadSafe {
   base::TimeDelta success_entry_ttl_;
   base::TimeDelta failure_entry_ttl_;
 
+  // How long expired successful entries are kept around to be served stale.
+  base::TimeDelta stale_grace_period_;
+
+  // The network that new entries are tagged with.
+  int network_;
+
   // Map from hostname (presumably in lowercase canonicalized format) to
   // a resolved result entry.
   EntryMap entries_;
 
+  // All the entries in |entries_|, least recently used first. Lookups move
+  // entries to the back, hence this is mutable.
+  mutable base::LinkedList<Entry> lru_list_;
+
+  ExpirationSet expirations_;
+
+  Delegate* delegate_;
+
   DISALLOW_COPY_AND_ASSIGN(HostCache);
 };
 
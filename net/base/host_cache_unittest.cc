@@ -9,6 +9,7 @@
 #include "base/string_util.h"
 #include "base/stringprintf.h"
 #include "net/base/net_errors.h"
+#include "net/base/net_util.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace net {
@@ -24,6 +25,25 @@ HostCache::Key Key(const std::string& hostname) {
   return HostCache::Key(hostname, ADDRESS_FAMILY_UNSPECIFIED, 0);
 }
 
+// Builds an address list holding the single address |ip|.
+AddressList AddressListFor(const std::string& ip) {
+  IPAddressNumber address;
+  EXPECT_TRUE(ParseIPLiteralToNumber(ip, &address));
+  return AddressList(address, 0, false);
+}
+
+class CountingDelegate : public HostCache::Delegate {
+ public:
+  CountingDelegate() : count_(0) {}
+
+  virtual void EntriesAreDirty(HostCache* cache) { count_++; }
+
+  int count() const { return count_; }
+
+ private:
+  int count_;
+};
+
 }  // namespace
 
 TEST(HostCacheTest, Basic) {
@@ -84,6 +104,136 @@ TEST(HostCacheTest, Basic) {
   EXPECT_TRUE(cache.Lookup(Key("foobar2.com"), now) == NULL);
 }
 
+// Expired successful entries are served by LookupStale() until the grace
+// period runs out.
+TEST(HostCacheTest, LookupStale) {
+  HostCache cache(kMaxCacheEntries, kSuccessEntryTTL, kFailureEntryTTL);
+
+  // Start at t=0.
+  base::TimeTicks now;
+
+  // Nothing is served stale without a grace period.
+  cache.Set(Key("foobar.com"), OK, AddressList(), now);
+  EXPECT_TRUE(cache.LookupStale(Key("foobar.com"),
+                                now + kSuccessEntryTTL) == NULL);
+
+  cache.set_stale_grace_period(base::TimeDelta::FromSeconds(30));
+  const HostCache::Entry* entry = cache.Lookup(Key("foobar.com"), now);
+  EXPECT_FALSE(entry == NULL);
+
+  // Unexpired entries are for Lookup() only.
+  EXPECT_TRUE(cache.LookupStale(Key("foobar.com"), now) == NULL);
+
+  // Advance to t=10; the entry is now expired, but still within the grace
+  // period.
+  now += kSuccessEntryTTL;
+  EXPECT_TRUE(cache.Lookup(Key("foobar.com"), now) == NULL);
+  EXPECT_EQ(entry, cache.LookupStale(Key("foobar.com"), now));
+
+  // Advance to t=40; the grace period is over.
+  now += base::TimeDelta::FromSeconds(30);
+  EXPECT_TRUE(cache.LookupStale(Key("foobar.com"), now) == NULL);
+
+  // Failures are never served stale.
+  cache.Set(Key("foobar2.com"), ERR_NAME_NOT_RESOLVED, AddressList(), now);
+  EXPECT_TRUE(cache.LookupStale(Key("foobar2.com"), now) == NULL);
+  EXPECT_TRUE(cache.LookupStale(Key("foobar2.com"),
+                                now + base::TimeDelta::FromSeconds(1)) == NULL);
+}
+
+// Compacting keeps the entries that may still be served stale.
+TEST(HostCacheTest, CompactKeepsStaleEntries) {
+  HostCache cache(kMaxCacheEntries, kSuccessEntryTTL, kFailureEntryTTL);
+  cache.set_stale_grace_period(base::TimeDelta::FromSeconds(30));
+
+  // Start at t=0.
+  base::TimeTicks now;
+  cache.Set(Key("stale.com"), OK, AddressList(), now);
+  cache.Set(Key("gone.com"), OK, AddressList(), now - kSuccessEntryTTL);
+  EXPECT_EQ(2U, cache.size());
+
+  // Advance to t=30; "stale.com" is in its grace period, "gone.com" isn't.
+  // "stale.com" is the least recently used entry, but "gone.com" goes first
+  // since it can't be served anymore.
+  now += base::TimeDelta::FromSeconds(30);
+  cache.max_entries_ = 1;
+  cache.Compact(now, NULL);
+  EXPECT_EQ(1U, cache.size());
+  EXPECT_FALSE(cache.LookupStale(Key("stale.com"), now) == NULL);
+}
+
+// Saved entries come back as stale entries.
+TEST(HostCacheTest, SerializeAndLoad) {
+  const base::TimeDelta kGracePeriod = base::TimeDelta::FromHours(1);
+  HostCache cache(kMaxCacheEntries, kSuccessEntryTTL, kFailureEntryTTL);
+  cache.set_stale_grace_period(kGracePeriod);
+
+  base::TimeTicks now = base::TimeTicks::Now();
+  cache.Set(Key("foobar.com"), OK, AddressListFor("192.168.1.42"), now);
+  cache.Set(Key("failed.com"), ERR_NAME_NOT_RESOLVED, AddressList(), now);
+  cache.Set(HostCache::Key("canon.com", ADDRESS_FAMILY_UNSPECIFIED,
+                           HOST_RESOLVER_CANONNAME),
+            OK, AddressListFor("192.168.1.43"), now);
+
+  std::string state;
+  cache.Serialize(&state);
+
+  HostCache restored(kMaxCacheEntries, kSuccessEntryTTL, kFailureEntryTTL);
+  restored.set_stale_grace_period(kGracePeriod);
+  ASSERT_TRUE(restored.LoadEntries(state));
+
+  // Failures and entries with canonical names aren't saved.
+  EXPECT_EQ(1U, restored.size());
+  now = base::TimeTicks::Now();
+  EXPECT_TRUE(restored.Lookup(Key("foobar.com"), now) == NULL);
+  const HostCache::Entry* entry = restored.LookupStale(Key("foobar.com"), now);
+  ASSERT_FALSE(entry == NULL);
+  EXPECT_EQ("192.168.1.42", NetAddressToString(entry->addrlist.head()));
+
+  // Loading again leaves the existing entries alone.
+  restored.Set(Key("foobar.com"), OK, AddressListFor("192.168.1.44"), now);
+  ASSERT_TRUE(restored.LoadEntries(state));
+  entry = restored.Lookup(Key("foobar.com"), now);
+  ASSERT_FALSE(entry == NULL);
+  EXPECT_EQ("192.168.1.44", NetAddressToString(entry->addrlist.head()));
+
+  // Without a grace period, there is nothing to restore.
+  HostCache no_stale(kMaxCacheEntries, kSuccessEntryTTL, kFailureEntryTTL);
+  ASSERT_TRUE(no_stale.LoadEntries(state));
+  EXPECT_EQ(0U, no_stale.size());
+
+  EXPECT_FALSE(restored.LoadEntries("not json"));
+  EXPECT_FALSE(restored.LoadEntries("{}"));
+}
+
+TEST(HostCacheTest, Delegate) {
+  HostCache cache(kMaxCacheEntries, kSuccessEntryTTL, kFailureEntryTTL);
+  CountingDelegate delegate;
+  cache.set_delegate(&delegate);
+
+  base::TimeTicks now;
+  cache.Set(Key("foobar.com"), OK, AddressList(), now);
+  EXPECT_EQ(1, delegate.count());
+  cache.Set(Key("foobar.com"), OK, AddressList(), now);
+  EXPECT_EQ(2, delegate.count());
+  EXPECT_TRUE(cache.Lookup(Key("foobar.com"), now) != NULL);
+  EXPECT_EQ(2, delegate.count());
+  cache.clear();
+  EXPECT_EQ(3, delegate.count());
+
+  // Loading saved entries doesn't count as a change.
+  cache.set_stale_grace_period(base::TimeDelta::FromHours(1));
+  cache.Set(Key("foobar.com"), OK, AddressListFor("192.168.1.42"),
+            base::TimeTicks::Now());
+  std::string state;
+  cache.Serialize(&state);
+  cache.clear();
+  EXPECT_EQ(5, delegate.count());
+  ASSERT_TRUE(cache.LoadEntries(state));
+  EXPECT_EQ(1U, cache.size());
+  EXPECT_EQ(5, delegate.count());
+}
+
 // Try caching entries for a failed resolve attempt -- since we set
 // the TTL of such entries to 0 it won't work.
 TEST(HostCacheTest, NoCacheNegative) {
@@ -269,6 +419,38 @@ TEST(HostCacheTest, SetWithCompact) {
   EXPECT_FALSE(cache.Lookup(Key("host5"), now) == NULL);
 }
 
+// When all the entries are valid, the least recently used one is evicted.
+TEST(HostCacheTest, EvictLeastRecentlyUsed) {
+  HostCache cache(3, kSuccessEntryTTL, kFailureEntryTTL);
+
+  // Start at t=0.
+  base::TimeTicks now;
+
+  cache.Set(Key("host1"), OK, AddressList(), now);
+  cache.Set(Key("host2"), OK, AddressList(), now);
+  cache.Set(Key("host3"), OK, AddressList(), now);
+
+  // Using "host1" makes "host2" the least recently used entry.
+  EXPECT_FALSE(cache.Lookup(Key("host1"), now) == NULL);
+  cache.Set(Key("host4"), OK, AddressList(), now);
+  EXPECT_EQ(3U, cache.size());
+  EXPECT_FALSE(ContainsKey(cache.entries_, Key("host2")));
+
+  // Updating "host3" makes "host1" the least recently used entry.
+  cache.Set(Key("host3"), OK, AddressList(), now);
+  cache.Set(Key("host5"), OK, AddressList(), now);
+  EXPECT_EQ(3U, cache.size());
+  EXPECT_FALSE(ContainsKey(cache.entries_, Key("host1")));
+  EXPECT_TRUE(ContainsKey(cache.entries_, Key("host3")));
+  EXPECT_TRUE(ContainsKey(cache.entries_, Key("host4")));
+  EXPECT_TRUE(ContainsKey(cache.entries_, Key("host5")));
+
+  // Failed lookups don't count as uses.
+  EXPECT_TRUE(cache.Lookup(Key("host4"), now + kSuccessEntryTTL) == NULL);
+  cache.Set(Key("host6"), OK, AddressList(), now);
+  EXPECT_FALSE(ContainsKey(cache.entries_, Key("host4")));
+}
+
 // Tests that the same hostname can be duplicated in the cache, so long as
 // the address family differs.
 TEST(HostCacheTest, AddressFamilyIsPartOfKey) {
@@ -388,6 +570,77 @@ TEST(HostCacheTest, Clear) {
   EXPECT_EQ(0u, cache.size());
 }
 
+TEST(HostCacheTest, ClearNegativeEntries) {
+  HostCache cache(kMaxCacheEntries, kSuccessEntryTTL,
+                  base::TimeDelta::FromSeconds(10));
+
+  // Set t=0.
+  base::TimeTicks now;
+
+  cache.Set(Key("good.com"), OK, AddressList(), now);
+  cache.Set(Key("bad.com"), ERR_NAME_NOT_RESOLVED, AddressList(), now);
+  EXPECT_EQ(2u, cache.size());
+
+  cache.ClearNegativeEntries();
+  EXPECT_EQ(1u, cache.size());
+  EXPECT_FALSE(cache.Lookup(Key("good.com"), now) == NULL);
+  EXPECT_TRUE(cache.Lookup(Key("bad.com"), now) == NULL);
+}
+
+// Under moderate pressure, only the entries that can't be served anymore go.
+TEST(HostCacheTest, PurgeMemory) {
+  HostCache cache(kMaxCacheEntries, kSuccessEntryTTL, kFailureEntryTTL);
+
+  // Set t=0.
+  base::TimeTicks now;
+
+  cache.Set(Key("foobar1.com"), OK, AddressList(), now);
+  cache.set_network(2);
+  cache.Set(Key("foobar2.com"), ERR_NAME_NOT_RESOLVED, AddressList(), now);
+  cache.Set(Key("foobar3.com"), OK, AddressList(), now);
+  EXPECT_EQ(3u, cache.size());
+
+  // Advance to t=5.  The failure has expired, and the first entry is of
+  // another network.
+  now += base::TimeDelta::FromSeconds(5);
+  EXPECT_GT(cache.PurgeMemory(MEMORY_PRESSURE_MODERATE, now), 0u);
+  EXPECT_EQ(1u, cache.size());
+  EXPECT_FALSE(cache.Lookup(Key("foobar3.com"), now) == NULL);
+  EXPECT_EQ(0u, cache.PurgeMemory(MEMORY_PRESSURE_MODERATE, now));
+
+  EXPECT_GT(cache.PurgeMemory(MEMORY_PRESSURE_CRITICAL, now), 0u);
+  EXPECT_EQ(0u, cache.size());
+}
+
+// Only the entries of the current network are served, but the others are
+// kept for when their network comes back.
+TEST(HostCacheTest, Network) {
+  HostCache cache(kMaxCacheEntries, kSuccessEntryTTL, kFailureEntryTTL);
+
+  // Set t=0.
+  base::TimeTicks now;
+
+  EXPECT_EQ(-1, cache.network());
+  cache.Set(Key("foobar1.com"), OK, AddressList(), now);
+  EXPECT_FALSE(cache.Lookup(Key("foobar1.com"), now) == NULL);
+
+  // Move to network 2.
+  cache.set_network(2);
+  EXPECT_TRUE(cache.Lookup(Key("foobar1.com"), now) == NULL);
+  cache.Set(Key("foobar2.com"), OK, AddressList(), now);
+  EXPECT_FALSE(cache.Lookup(Key("foobar2.com"), now) == NULL);
+  EXPECT_EQ(2u, cache.size());
+
+  // Come back to the first network.
+  cache.set_network(-1);
+  EXPECT_FALSE(cache.Lookup(Key("foobar1.com"), now) == NULL);
+  EXPECT_TRUE(cache.Lookup(Key("foobar2.com"), now) == NULL);
+
+  // Setting an entry again tags it with the current network.
+  cache.Set(Key("foobar2.com"), OK, AddressList(), now);
+  EXPECT_FALSE(cache.Lookup(Key("foobar2.com"), now) == NULL);
+}
+
 // Tests the less than and equal operators for HostCache::Key work.
 TEST(HostCacheTest, KeyComparators) {
   struct {
@@ -4,6 +4,8 @@
 
 #include "net/base/host_mapping_rules.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/string_split.h"
 #include "base/string_tokenizer.h"
@@ -31,38 +33,31 @@ HostMappingRules::~HostMappingRules() {}
 
 bool HostMappingRules::RewriteHost(HostPortPair* host_port) const {
   // Check if the hostname was excluded.
-  for (ExclusionRuleList::const_iterator it = exclusion_rules_.begin();
-       it != exclusion_rules_.end(); ++it) {
-    const ExclusionRule& rule = *it;
-    if (MatchPattern(host_port->host(), rule.hostname_pattern))
-      return false;
-  }
+  std::vector<int> matches;
+  exclusion_matcher_.GetMatches(host_port->host(), &matches);
+  if (!matches.empty())
+    return false;
 
   // Check if the hostname was remapped.
-  for (MapRuleList::const_iterator it = map_rules_.begin();
-       it != map_rules_.end(); ++it) {
-    const MapRule& rule = *it;
-
-    // The rule's hostname_pattern will be something like:
-    //     www.foo.com
-    //     *.foo.com
-    //     www.foo.com:1234
-    //     *.foo.com:1234
-    // First, we'll check for a match just on hostname.
-    // If that fails, we'll check for a match with both hostname and port.
-    if (!MatchPattern(host_port->host(), rule.hostname_pattern)) {
-      std::string host_port_string = host_port->ToString();
-      if (!MatchPattern(host_port_string, rule.hostname_pattern))
-        continue;  // This rule doesn't apply.
-    }
-
-    host_port->set_host(rule.replacement_hostname);
-    if (rule.replacement_port != -1)
-      host_port->set_port(rule.replacement_port);
-    return true;
-  }
-
-  return false;
+  //
+  // The rule's hostname_pattern will be something like:
+  //     www.foo.com
+  //     *.foo.com
+  //     www.foo.com:1234
+  //     *.foo.com:1234
+  // So a rule applies if it matches just the hostname, or both hostname and
+  // port. The first rule that applies wins.
+  map_matcher_.GetMatches(host_port->host(), &matches);
+  map_matcher_.GetMatches(host_port->ToString(), &matches);
+  if (matches.empty())
+    return false;
+
+  const MapRule& rule = map_rules_[*std::min_element(matches.begin(),
+                                                     matches.end())];
+  host_port->set_host(rule.replacement_hostname);
+  if (rule.replacement_port != -1)
+    host_port->set_port(rule.replacement_port);
+  return true;
 }
 
 bool HostMappingRules::AddRuleFromString(const std::string& rule_string) {
@@ -75,6 +70,8 @@ bool HostMappingRules::AddRuleFromString(const std::string& rule_string) {
   if (parts.size() == 2 && LowerCaseEqualsASCII(parts[0], "exclude")) {
     ExclusionRule rule;
     rule.hostname_pattern = StringToLowerASCII(parts[1]);
+    exclusion_matcher_.AddPattern(rule.hostname_pattern,
+                                  static_cast<int>(exclusion_rules_.size()));
     exclusion_rules_.push_back(rule);
     return true;
   }
@@ -89,6 +86,8 @@ bool HostMappingRules::AddRuleFromString(const std::string& rule_string) {
       return false;  // Failed parsing the hostname/port.
     }
 
+    map_matcher_.AddPattern(rule.hostname_pattern,
+                            static_cast<int>(map_rules_.size()));
     map_rules_.push_back(rule);
     return true;
   }
@@ -99,6 +98,8 @@ bool HostMappingRules::AddRuleFromString(const std::string& rule_string) {
 void HostMappingRules::SetRulesFromString(const std::string& rules_string) {
   exclusion_rules_.clear();
   map_rules_.clear();
+  exclusion_matcher_.Clear();
+  map_matcher_.Clear();
 
   StringTokenizer rules(rules_string, ",");
   while (rules.GetNext()) {
@@ -9,11 +9,14 @@
 #include <string>
 #include <vector>
 #include "base/basictypes.h"
+#include "net/base/host_pattern_matcher.h"
 
 namespace net {
 
 class HostPortPair;
 
+// The hostname patterns of the rules are compiled into HostPatternMatchers, so
+// the cost of RewriteHost() hardly grows with the number of rules.
 class HostMappingRules {
  public:
   HostMappingRules();
@@ -46,6 +49,10 @@ class HostMappingRules {
   MapRuleList map_rules_;
   ExclusionRuleList exclusion_rules_;
 
+  // The patterns of |map_rules_| and |exclusion_rules_|, by index.
+  HostPatternMatcher map_matcher_;
+  HostPatternMatcher exclusion_matcher_;
+
   DISALLOW_COPY_AND_ASSIGN(HostMappingRules);
 };
 
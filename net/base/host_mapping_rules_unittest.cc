@@ -67,6 +67,30 @@ TEST(HostMappingRulesTest, PortSpecificMatching) {
   EXPECT_EQ(443u, host_port.port());
 }
 
+// When several rules match, whatever their kind, the first one applies.
+TEST(HostMappingRulesTest, FirstMatchingRuleWins) {
+  HostMappingRules rules;
+  rules.SetRulesFromString(
+      "map www.*.com first, map *.foo.com second, map www.foo.com third, "
+      "map *:443 fourth");
+
+  HostPortPair host_port("www.foo.com", 80);
+  EXPECT_TRUE(rules.RewriteHost(&host_port));
+  EXPECT_EQ("first", host_port.host());
+
+  host_port = HostPortPair("www.foo.org", 80);
+  EXPECT_FALSE(rules.RewriteHost(&host_port));
+
+  host_port = HostPortPair("mail.foo.com", 443);
+  EXPECT_TRUE(rules.RewriteHost(&host_port));
+  EXPECT_EQ("second", host_port.host());
+
+  host_port = HostPortPair("www.foo.org", 443);
+  EXPECT_TRUE(rules.RewriteHost(&host_port));
+  EXPECT_EQ("fourth", host_port.host());
+  EXPECT_EQ(443u, host_port.port());
+}
+
 // Parsing bad rules should silently discard the rule (and never crash).
 TEST(HostMappingRulesTest, ParseInvalidRules) {
   HostMappingRules rules;
@@ -0,0 +1,165 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/host_pattern_matcher.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/string_util.h"
+
+namespace net {
+
+namespace {
+
+// Returns |ip_number| as an IPv6 address.
+IPAddressNumber ToIPv6Number(const IPAddressNumber& ip_number) {
+  if (ip_number.size() == kIPv4AddressSize)
+    return ConvertIPv4NumberToIPv6Number(ip_number);
+  return ip_number;
+}
+
+// Returns |ip_number| with the bits past |prefix_length_in_bits| cleared.
+IPAddressNumber MaskIPNumber(const IPAddressNumber& ip_number,
+                             size_t prefix_length_in_bits) {
+  IPAddressNumber masked(ip_number);
+  for (size_t i = 0; i < masked.size(); ++i) {
+    size_t bit = i * 8;
+    if (bit >= prefix_length_in_bits)
+      masked[i] = 0;
+    else if (prefix_length_in_bits - bit < 8)
+      masked[i] &= 0xFF << (8 - (prefix_length_in_bits - bit));
+  }
+  return masked;
+}
+
+bool PrefixLess(const std::pair<IPAddressNumber, int>& a,
+                const std::pair<IPAddressNumber, int>& b) {
+  return a.first < b.first;
+}
+
+}  // namespace
+
+HostPatternMatcher::SuffixNode::SuffixNode() {}
+
+HostPatternMatcher::SuffixNode::~SuffixNode() {}
+
+HostPatternMatcher::HostPatternMatcher()
+    : suffix_trie_(1) {
+}
+
+HostPatternMatcher::~HostPatternMatcher() {}
+
+void HostPatternMatcher::AddPattern(const std::string& pattern, int id) {
+  // Backslashes escape wildcards, so patterns with them are left to
+  // MatchPattern().
+  std::string::size_type wildcard = pattern.find_first_of("*?\\");
+  if (wildcard == std::string::npos) {
+    exact_patterns_[pattern].push_back(id);
+    return;
+  }
+
+  // Any run of leading '*'s counts as one.
+  std::string::size_type suffix_start = pattern.find_first_not_of('*');
+  if (wildcard != 0 || pattern[0] != '*' ||
+      (suffix_start != std::string::npos &&
+       pattern.find_first_of("*?\\", suffix_start) != std::string::npos)) {
+    other_patterns_.push_back(std::make_pair(pattern, id));
+    return;
+  }
+
+  size_t node = 0;
+  if (suffix_start != std::string::npos) {
+    for (std::string::size_type i = pattern.size(); i > suffix_start; --i) {
+      char c = pattern[i - 1];
+      std::map<char, size_t>::const_iterator it =
+          suffix_trie_[node].children.find(c);
+      if (it != suffix_trie_[node].children.end()) {
+        node = it->second;
+      } else {
+        // The push_back() may move the nodes, so they're only referred to by
+        // offset here.
+        suffix_trie_.push_back(SuffixNode());
+        suffix_trie_[node].children[c] = suffix_trie_.size() - 1;
+        node = suffix_trie_.size() - 1;
+      }
+    }
+  }
+  suffix_trie_[node].ids.push_back(id);
+}
+
+void HostPatternMatcher::AddIPBlock(const IPAddressNumber& ip_prefix,
+                                    size_t prefix_length_in_bits,
+                                    int id) {
+  DCHECK(ip_prefix.size() == kIPv4AddressSize ||
+         ip_prefix.size() == kIPv6AddressSize);
+  DCHECK_LE(prefix_length_in_bits, ip_prefix.size() * 8);
+  if (ip_prefix.size() == kIPv4AddressSize)
+    prefix_length_in_bits += 96;
+
+  std::pair<IPAddressNumber, int> block(
+      MaskIPNumber(ToIPv6Number(ip_prefix), prefix_length_in_bits), id);
+  IPBlockList& blocks = ip_blocks_[prefix_length_in_bits];
+  blocks.insert(std::upper_bound(blocks.begin(), blocks.end(), block,
+                                 PrefixLess),
+                block);
+}
+
+void HostPatternMatcher::GetMatches(const std::string& host,
+                                    std::vector<int>* ids) const {
+  ExactMap::const_iterator exact = exact_patterns_.find(host);
+  if (exact != exact_patterns_.end())
+    ids->insert(ids->end(), exact->second.begin(), exact->second.end());
+
+  // Every node on the way down is a suffix of |host|.
+  size_t node = 0;
+  std::string::size_type i = host.size();
+  while (true) {
+    const SuffixNode& suffix = suffix_trie_[node];
+    ids->insert(ids->end(), suffix.ids.begin(), suffix.ids.end());
+    if (i == 0)
+      break;
+    std::map<char, size_t>::const_iterator it =
+        suffix.children.find(host[--i]);
+    if (it == suffix.children.end())
+      break;
+    node = it->second;
+  }
+
+  for (size_t j = 0; j < other_patterns_.size(); ++j) {
+    if (MatchPattern(host, other_patterns_[j].first))
+      ids->push_back(other_patterns_[j].second);
+  }
+}
+
+void HostPatternMatcher::GetIPBlockMatches(const IPAddressNumber& ip_number,
+                                           std::vector<int>* ids) const {
+  DCHECK(ip_number.size() == kIPv4AddressSize ||
+         ip_number.size() == kIPv6AddressSize);
+  if (ip_blocks_.empty())
+    return;
+
+  IPAddressNumber ipv6_number = ToIPv6Number(ip_number);
+  for (IPBlockTable::const_iterator it = ip_blocks_.begin();
+       it != ip_blocks_.end(); ++it) {
+    std::pair<IPAddressNumber, int> key(MaskIPNumber(ipv6_number, it->first),
+                                        0);
+    std::pair<IPBlockList::const_iterator, IPBlockList::const_iterator> range =
+        std::equal_range(it->second.begin(), it->second.end(), key,
+                         PrefixLess);
+    for (IPBlockList::const_iterator block = range.first;
+         block != range.second; ++block) {
+      ids->push_back(block->second);
+    }
+  }
+}
+
+void HostPatternMatcher::Clear() {
+  exact_patterns_.clear();
+  suffix_trie_.assign(1, SuffixNode());
+  other_patterns_.clear();
+  ip_blocks_.clear();
+}
+
+}  // namespace net
@@ -0,0 +1,95 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_BASE_HOST_PATTERN_MATCHER_H_
+#define NET_BASE_HOST_PATTERN_MATCHER_H_
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/hash_tables.h"
+#include "net/base/net_util.h"
+
+namespace net {
+
+// HostPatternMatcher finds which of a set of hostname patterns, as understood
+// by MatchPattern(), a hostname matches, and which of a set of IP blocks an
+// address falls in.  It's for rule lists that are compiled once and checked
+// against every request, such as ProxyBypassRules and HostMappingRules.
+//
+// The cost of a lookup depends on the length of the hostname rather than on
+// the number of patterns, for the common kinds of pattern:
+//   - patterns without wildcards are kept in a hash table,
+//   - patterns of the form "*<suffix>" are kept in a trie of the reversed
+//     suffixes, which is walked from the end of the hostname,
+//   - IP blocks are kept in a table for each prefix length, sorted by prefix,
+//     so that each length costs one binary search.
+// Any other pattern, like "www.*.com", is tried in turn.
+//
+// Each pattern or block is added with an id, which is what lookups return.
+class HostPatternMatcher {
+ public:
+  HostPatternMatcher();
+  ~HostPatternMatcher();
+
+  // Adds |pattern|, which may contain the wildcards '*' and '?'.  Matching is
+  // case sensitive, as MatchPattern() is.
+  void AddPattern(const std::string& pattern, int id);
+
+  // Adds the addresses whose first |prefix_length_in_bits| bits are those of
+  // |ip_prefix|.  As with IPNumberMatchesPrefix(), an IPv4 block also holds
+  // the IPv4-mapped IPv6 addresses of its addresses, and the other way round.
+  void AddIPBlock(const IPAddressNumber& ip_prefix,
+                  size_t prefix_length_in_bits,
+                  int id);
+
+  // Appends the ids of the patterns that |host| matches to |ids|, in no
+  // particular order.
+  void GetMatches(const std::string& host, std::vector<int>* ids) const;
+
+  // Appends the ids of the IP blocks that |ip_number| is in to |ids|, in no
+  // particular order.
+  void GetIPBlockMatches(const IPAddressNumber& ip_number,
+                         std::vector<int>* ids) const;
+
+  // Removes all the patterns and IP blocks.
+  void Clear();
+
+ private:
+  // A node of the trie of reversed suffixes.  The root is the empty suffix,
+  // which "*" stands for.
+  struct SuffixNode {
+    SuffixNode();
+    ~SuffixNode();
+
+    // Offsets in |suffix_trie_| of the nodes for the suffixes one character
+    // longer.
+    std::map<char, size_t> children;
+    // The ids of the patterns for this suffix.
+    std::vector<int> ids;
+  };
+
+  typedef base::hash_map<std::string, std::vector<int> > ExactMap;
+
+  // (prefix, id) pairs, sorted by prefix.  The prefixes are IPv6, and have
+  // the bits past the prefix length cleared.
+  typedef std::vector<std::pair<IPAddressNumber, int> > IPBlockList;
+  // The blocks of each prefix length.
+  typedef std::map<size_t, IPBlockList> IPBlockTable;
+
+  ExactMap exact_patterns_;
+  std::vector<SuffixNode> suffix_trie_;
+  std::vector<std::pair<std::string, int> > other_patterns_;
+  IPBlockTable ip_blocks_;
+
+  DISALLOW_COPY_AND_ASSIGN(HostPatternMatcher);
+};
+
+}  // namespace net
+
+#endif  // NET_BASE_HOST_PATTERN_MATCHER_H_
@@ -0,0 +1,132 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/host_pattern_matcher.h"
+
+#include <algorithm>
+
+#include "base/string_number_conversions.h"
+#include "base/string_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// Returns |ids| sorted, as a comma separated string.
+std::string ToString(std::vector<int> ids) {
+  std::sort(ids.begin(), ids.end());
+  std::string result;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    if (i > 0)
+      result.push_back(',');
+    result.append(base::IntToString(ids[i]));
+  }
+  return result;
+}
+
+std::string GetMatches(const HostPatternMatcher& matcher,
+                       const std::string& host) {
+  std::vector<int> ids;
+  matcher.GetMatches(host, &ids);
+  return ToString(ids);
+}
+
+std::string GetIPBlockMatches(const HostPatternMatcher& matcher,
+                              const std::string& ip_literal) {
+  IPAddressNumber ip_number;
+  EXPECT_TRUE(ParseIPLiteralToNumber(ip_literal, &ip_number));
+  std::vector<int> ids;
+  matcher.GetIPBlockMatches(ip_number, &ids);
+  return ToString(ids);
+}
+
+TEST(HostPatternMatcherTest, Patterns) {
+  HostPatternMatcher matcher;
+  matcher.AddPattern("www.google.com", 0);
+  matcher.AddPattern("*.google.com", 1);
+  matcher.AddPattern("*google.com", 2);
+  matcher.AddPattern("www.*.org", 3);
+  matcher.AddPattern("**.org", 4);
+
+  EXPECT_EQ("0,1,2", GetMatches(matcher, "www.google.com"));
+  EXPECT_EQ("1,2", GetMatches(matcher, "mail.google.com"));
+  EXPECT_EQ("2", GetMatches(matcher, "google.com"));
+  EXPECT_EQ("2", GetMatches(matcher, "notgoogle.com"));
+  EXPECT_EQ("", GetMatches(matcher, "google.co"));
+  EXPECT_EQ("", GetMatches(matcher, "WWW.GOOGLE.COM"));
+  EXPECT_EQ("3,4", GetMatches(matcher, "www.chromium.org"));
+  EXPECT_EQ("4", GetMatches(matcher, "dev.chromium.org"));
+  EXPECT_EQ("", GetMatches(matcher, ""));
+
+  matcher.AddPattern("*", 5);
+  EXPECT_EQ("5", GetMatches(matcher, ""));
+  EXPECT_EQ("5", GetMatches(matcher, "localhost"));
+
+  matcher.Clear();
+  EXPECT_EQ("", GetMatches(matcher, "www.google.com"));
+}
+
+// The patterns held in the hash table and the trie must match exactly what
+// MatchPattern() would.
+TEST(HostPatternMatcherTest, AgreesWithMatchPattern) {
+  const char* kPatterns[] = {
+    "foo.com", "*foo.com", "*.foo.com", "*o.com", "*", "f?o.com", "*.com:80",
+    "?", "foo.*", "[::1]",
+  };
+  const char* kHosts[] = {
+    "foo.com", "www.foo.com", "afoo.com", "o.com", "fo.com", "", "foo.com:80",
+    "bar.foo.com:80", "f", "foo.org", "[::1]",
+  };
+
+  HostPatternMatcher matcher;
+  for (size_t i = 0; i < arraysize(kPatterns); ++i)
+    matcher.AddPattern(kPatterns[i], static_cast<int>(i));
+
+  for (size_t i = 0; i < arraysize(kHosts); ++i) {
+    SCOPED_TRACE(kHosts[i]);
+    std::vector<int> expected;
+    for (size_t j = 0; j < arraysize(kPatterns); ++j) {
+      if (MatchPattern(kHosts[i], kPatterns[j]))
+        expected.push_back(static_cast<int>(j));
+    }
+    EXPECT_EQ(ToString(expected), GetMatches(matcher, kHosts[i]));
+  }
+}
+
+TEST(HostPatternMatcherTest, IPBlocks) {
+  HostPatternMatcher matcher;
+  IPAddressNumber prefix;
+  size_t prefix_length_in_bits;
+
+  ASSERT_TRUE(ParseCIDRBlock("192.168.1.1/16", &prefix,
+                             &prefix_length_in_bits));
+  matcher.AddIPBlock(prefix, prefix_length_in_bits, 0);
+  ASSERT_TRUE(ParseCIDRBlock("192.168.100.0/22", &prefix,
+                             &prefix_length_in_bits));
+  matcher.AddIPBlock(prefix, prefix_length_in_bits, 1);
+  ASSERT_TRUE(ParseCIDRBlock("10.0.0.0/8", &prefix, &prefix_length_in_bits));
+  matcher.AddIPBlock(prefix, prefix_length_in_bits, 2);
+  ASSERT_TRUE(ParseCIDRBlock("fefe:13::abc/33", &prefix,
+                             &prefix_length_in_bits));
+  matcher.AddIPBlock(prefix, prefix_length_in_bits, 3);
+
+  EXPECT_EQ("0", GetIPBlockMatches(matcher, "192.168.1.1"));
+  EXPECT_EQ("0,1", GetIPBlockMatches(matcher, "192.168.103.255"));
+  EXPECT_EQ("0", GetIPBlockMatches(matcher, "192.168.104.0"));
+  EXPECT_EQ("2", GetIPBlockMatches(matcher, "10.20.30.40"));
+  EXPECT_EQ("", GetIPBlockMatches(matcher, "192.169.1.1"));
+  EXPECT_EQ("3", GetIPBlockMatches(matcher, "fefe:13:7fff::1"));
+  EXPECT_EQ("", GetIPBlockMatches(matcher, "fefe:13:8000::1"));
+
+  // IPv4 blocks hold the IPv4-mapped IPv6 addresses too.
+  EXPECT_EQ("2", GetIPBlockMatches(matcher, "::ffff:10.1.1.1"));
+
+  matcher.Clear();
+  EXPECT_EQ("", GetIPBlockMatches(matcher, "10.20.30.40"));
+}
+
+}  // namespace
+
+}  // namespace net
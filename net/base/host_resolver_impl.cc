@@ -30,6 +30,7 @@
 #include "base/values.h"
 #include "net/base/address_list.h"
 #include "net/base/address_list_net_log_param.h"
+#include "net/base/async_dns_resolver.h"
 #include "net/base/host_port_pair.h"
 #include "net/base/host_resolver_proc.h"
 #include "net/base/net_errors.h"
@@ -58,6 +59,10 @@ const char kOSErrorsForGetAddrinfoHistogramName[] =
     "Net.OSErrorsForGetAddrinfo";
 #endif
 
+// How long a pending request waits before it is scheduled as if its priority
+// were one level higher, so that low priority requests still get to run.
+const int kDefaultPendingRequestAgingSeconds = 1;
+
 HostCache* CreateDefaultCache() {
   static const size_t kMaxHostCacheEntries = 100;
 
@@ -312,6 +317,14 @@ class HostResolverImpl::Request {
     return info_;
   }
 
+  void set_queued_time(base::TimeTicks queued_time) {
+    queued_time_ = queued_time;
+  }
+
+  base::TimeTicks queued_time() const {
+    return queued_time_;
+  }
+
  private:
   BoundNetLog source_net_log_;
   BoundNetLog request_net_log_;
@@ -331,6 +344,9 @@ class HostResolverImpl::Request {
   // The address list to save result into.
   AddressList* addresses_;
 
+  // When the request was put in a JobPool queue, if it was.
+  base::TimeTicks queued_time_;
+
   DISALLOW_COPY_AND_ASSIGN(Request);
 };
 
@@ -356,6 +372,9 @@ class HostResolverImpl::Job
        resolver_(resolver),
        origin_loop_(MessageLoop::current()),
        resolver_proc_(resolver->effective_resolver_proc()),
+       async_request_(NULL),
+       ALLOW_THIS_IN_INITIALIZER_LIST(
+           async_callback_(this, &Job::OnAsyncLookupComplete)),
        error_(OK),
        os_error_(0),
        had_non_speculative_request_(false),
@@ -386,6 +405,25 @@ class HostResolverImpl::Job
   void Start() {
     start_time_ = base::TimeTicks::Now();
 
+    if (CanUseAsyncResolver()) {
+      int rv = resolver_->async_dns_resolver_->Resolve(
+          key_.hostname, key_.address_family, &results_, &async_callback_,
+          &async_request_);
+      if (rv == ERR_IO_PENDING)
+        return;
+      if (rv == OK || rv == ERR_NAME_NOT_RESOLVED) {
+        // As below, the result can't be delivered from within Resolve().
+        error_ = rv;
+        MessageLoop::current()->PostTask(
+            FROM_HERE, NewRunnableMethod(this, &Job::OnLookupComplete));
+        return;
+      }
+      // Otherwise leave it to the system resolver.
+    }
+    StartOnWorkerPool();
+  }
+
+  void StartOnWorkerPool() {
     // Dispatch the job to a worker thread.
     if (!base::WorkerPool::PostTask(FROM_HERE,
             NewRunnableMethod(this, &Job::DoLookup), true)) {
@@ -404,6 +442,11 @@ class HostResolverImpl::Job
   void Cancel() {
     net_log_.AddEvent(NetLog::TYPE_CANCELLED, NULL);
 
+    if (async_request_) {
+      resolver_->async_dns_resolver_->CancelRequest(async_request_);
+      async_request_ = NULL;
+    }
+
     HostResolver* resolver = resolver_;
     resolver_ = NULL;
 
@@ -471,6 +514,32 @@ class HostResolverImpl::Job
     STLDeleteElements(&requests_);
   }
 
+  // Returns true if the lookup can go to the asynchronous resolver, rather
+  // than to SystemHostResolverProc().  Custom procedures, and the flags only
+  // getaddrinfo() knows about, keep the lookup on the worker pool.
+  bool CanUseAsyncResolver() const {
+    static const HostResolverFlags kGetAddrInfoOnlyFlags =
+        HOST_RESOLVER_CANONNAME | HOST_RESOLVER_LOOPBACK_ONLY;
+    return resolver_->async_dns_resolver_.get() &&
+           resolver_->async_dns_resolver_->IsReady() &&
+           !resolver_proc_ &&
+           !(key_.host_resolver_flags & kGetAddrInfoOnlyFlags);
+  }
+
+  // Callback for when the asynchronous resolver completes.  Names that don't
+  // exist fail right away, but other failures are retried with the system
+  // resolver, which may know better (e.g. over TCP).
+  void OnAsyncLookupComplete(int result) {
+    async_request_ = NULL;
+    if (result == OK || result == ERR_NAME_NOT_RESOLVED) {
+      error_ = result;
+      OnLookupComplete();
+      return;
+    }
+    results_.Reset();
+    StartOnWorkerPool();
+  }
+
   // WARNING: This code runs inside a worker pool. The shutdown code cannot
   // wait for it to finish, so we must be very careful here about using other
   // objects (like MessageLoops, Singletons, etc). During shutdown these objects
@@ -617,6 +686,10 @@ class HostResolverImpl::Job
   // reference ensures that it remains valid until we are done.
   scoped_refptr<HostResolverProc> resolver_proc_;
 
+  // The lookup in progress on |resolver_|'s AsyncDnsResolver, if any.
+  AsyncDnsResolver::Request* async_request_;
+  CompletionCallbackImpl<Job> async_callback_;
+
   // Assigned on the worker thread, read on the origin thread.
   int error_;
   int os_error_;
@@ -749,7 +822,9 @@ COMPILE_ASSERT(HIGHEST == 0u &&
 class HostResolverImpl::JobPool {
  public:
   JobPool(size_t max_outstanding_jobs, size_t max_pending_requests)
-      : num_outstanding_jobs_(0u) {
+      : num_outstanding_jobs_(0u),
+        aging_interval_(base::TimeDelta::FromSeconds(
+            kDefaultPendingRequestAgingSeconds)) {
     SetConstraints(max_outstanding_jobs, max_pending_requests);
   }
 
@@ -768,6 +843,13 @@ class HostResolverImpl::JobPool {
     max_pending_requests_ = max_pending_requests;
   }
 
+  // Sets how long a pending request waits before it is scheduled as if its
+  // priority were one level higher.
+  void set_aging_interval(base::TimeDelta aging_interval) {
+    DCHECK_GT(aging_interval.InMicroseconds(), 0);
+    aging_interval_ = aging_interval;
+  }
+
   // Returns the number of pending requests enqueued to this pool.
   // A pending request is one waiting to be attached to a job.
   size_t GetNumPendingRequests() const {
@@ -786,9 +868,11 @@ class HostResolverImpl::JobPool {
   // evicted from the queue, and returned. Otherwise returns NULL. The caller
   // is responsible for freeing the evicted request.
   Request* InsertPendingRequest(Request* req) {
+    req->set_queued_time(base::TimeTicks::Now());
     req->request_net_log().BeginEvent(
         NetLog::TYPE_HOST_RESOLVER_IMPL_JOB_POOL_QUEUE,
-        NULL);
+        make_scoped_refptr(
+            new NetLogIntegerParameter("priority", req->info().priority())));
 
     PendingRequestsQueue& q = pending_requests_[req->info().priority()];
     q.push_back(req);
@@ -825,23 +909,32 @@ class HostResolverImpl::JobPool {
         NetLog::TYPE_HOST_RESOLVER_IMPL_JOB_POOL_QUEUE, NULL);
   }
 
-  // Removes and returns the highest priority pending request.
+  // Removes and returns the highest priority pending request, counting the
+  // levels each request gained by waiting. On a tie, the request with the
+  // higher priority of its own goes first.
   Request* RemoveTopPendingRequest() {
     DCHECK(HasPendingRequests());
 
+    base::TimeTicks now = base::TimeTicks::Now();
+    PendingRequestsQueue* top_queue = NULL;
+    int64 top_priority = 0;
     for (size_t i = 0u; i < arraysize(pending_requests_); ++i) {
       PendingRequestsQueue& q = pending_requests_[i];
-      if (!q.empty()) {
-        Request* req = q.front();
-        q.pop_front();
-        req->request_net_log().EndEvent(
-            NetLog::TYPE_HOST_RESOLVER_IMPL_JOB_POOL_QUEUE, NULL);
-        return req;
+      // Each queue is in arrival order, so its front has aged the most.
+      if (q.empty())
+        continue;
+      int64 priority = GetAgedPriority(q.front(), now);
+      if (!top_queue || priority < top_priority) {
+        top_queue = &q;
+        top_priority = priority;
       }
     }
 
-    NOTREACHED();
-    return NULL;
+    DCHECK(top_queue);
+    Request* req = top_queue->front();
+    top_queue->pop_front();
+    OnRequestDequeued(req, now);
+    return req;
   }
 
   // Keeps track of a job that was just added/removed, and belongs to this pool.
@@ -869,6 +962,7 @@ class HostResolverImpl::JobPool {
       while (req_it != q.end()) {
         Request* req = *req_it;
         if (job->CanServiceRequest(req->info())) {
+          OnRequestDequeued(req, base::TimeTicks::Now());
           // Job takes ownership of |req|.
           job->AddRequest(req);
           req_it = q.erase(req_it);
@@ -882,6 +976,29 @@ class HostResolverImpl::JobPool {
  private:
   typedef std::deque<Request*> PendingRequestsQueue;
 
+  // Returns the priority of |req|, raised by one level for every
+  // |aging_interval_| it has been waiting. This goes below HIGHEST for
+  // requests that have waited long enough.
+  int64 GetAgedPriority(const Request* req, base::TimeTicks now) const {
+    int64 levels = (now - req->queued_time()).InMicroseconds() /
+        aging_interval_.InMicroseconds();
+    return req->info().priority() - levels;
+  }
+
+  // Ends the queueing of |req|, which is about to be attached to a job, and
+  // records how long it waited.
+  void OnRequestDequeued(Request* req, base::TimeTicks now) {
+    base::TimeDelta queue_time = now - req->queued_time();
+    if (req->info().is_speculative())
+      DNS_HISTOGRAM("DNS.JobPoolQueueTimeSpeculative", queue_time);
+    else
+      DNS_HISTOGRAM("DNS.JobPoolQueueTime", queue_time);
+    req->request_net_log().EndEvent(
+        NetLog::TYPE_HOST_RESOLVER_IMPL_JOB_POOL_QUEUE,
+        make_scoped_refptr(new NetLogIntegerParameter(
+            "queue_ms", static_cast<int>(queue_time.InMilliseconds()))));
+  }
+
   // Maximum number of concurrent jobs allowed to be started for requests
   // belonging to this pool.
   size_t max_outstanding_jobs_;
@@ -894,6 +1011,9 @@ class HostResolverImpl::JobPool {
   // for this pool.
   size_t max_pending_requests_;
 
+  // How long a pending request waits to gain a priority level.
+  base::TimeDelta aging_interval_;
+
   // The requests which are waiting to be started for this pool.
   PendingRequestsQueue pending_requests_[NUM_PRIORITIES];
 };
@@ -906,6 +1026,8 @@ HostResolverImpl::HostResolverImpl(
     size_t max_jobs,
     NetLog* net_log)
     : cache_(cache),
+      ALLOW_THIS_IN_INITIALIZER_LIST(stale_refresh_callback_(
+          this, &HostResolverImpl::OnStaleEntryRefreshed)),
       max_jobs_(max_jobs),
       next_request_id_(0),
       next_job_id_(0),
@@ -967,6 +1089,14 @@ void HostResolverImpl::SetPoolConstraints(JobPoolIndex pool_index,
   pool->SetConstraints(max_outstanding_jobs, max_pending_requests);
 }
 
+void HostResolverImpl::SetPoolAgingInterval(JobPoolIndex pool_index,
+                                            base::TimeDelta aging_interval) {
+  DCHECK(CalledOnValidThread());
+  CHECK_GE(pool_index, 0);
+  CHECK_LT(pool_index, POOL_COUNT);
+  job_pools_[pool_index]->set_aging_interval(aging_interval);
+}
+
 int HostResolverImpl::Resolve(const RequestInfo& info,
                               AddressList* addresses,
                               CompletionCallback* callback,
@@ -1031,6 +1161,29 @@ int HostResolverImpl::Resolve(const RequestInfo& info,
 
       return net_error;
     }
+
+    // Otherwise an entry that expired a short while ago is likely still
+    // right.  Answer with it now, and look the name up again off the critical
+    // path.
+    base::TimeTicks now = base::TimeTicks::Now();
+    cache_entry = cache_->LookupStale(key, now);
+    if (cache_entry) {
+      request_net_log.AddEvent(
+          NetLog::TYPE_HOST_RESOLVER_IMPL_STALE_CACHE_HIT,
+          make_scoped_refptr(new NetLogIntegerParameter(
+              "stale_ms",
+              static_cast<int>(
+                  (now - cache_entry->expiration).InMilliseconds()))));
+      addresses->SetFrom(cache_entry->addrlist, info.port());
+
+      // Update the net log and notify registered observers.
+      OnFinishRequest(source_net_log, request_net_log, request_id, info, OK,
+                      0  /* os_error (unknown since from cache) */);
+
+      if (!info.only_use_cached_response())
+        RefreshStaleEntry(info, key, source_net_log);
+      return OK;
+    }
   }
 
   if (info.only_use_cached_response()) {  // Not allowed to do a real lookup.
@@ -1038,9 +1191,9 @@ int HostResolverImpl::Resolve(const RequestInfo& info,
                     request_net_log,
                     request_id,
                     info,
-                    ERR_NAME_NOT_RESOLVED,
+                    ERR_DNS_CACHE_MISS,
                     0);
-    return ERR_NAME_NOT_RESOLVED;
+    return ERR_DNS_CACHE_MISS;
   }
 
   // If no callback was specified, do a synchronous resolution.
@@ -1158,6 +1311,12 @@ AddressFamily HostResolverImpl::GetDefaultAddressFamily() const {
   return default_address_family_;
 }
 
+void HostResolverImpl::SetAsyncDnsResolver(AsyncDnsResolver* resolver) {
+  DCHECK(CalledOnValidThread());
+  DCHECK(jobs_.empty());
+  async_dns_resolver_.reset(resolver);
+}
+
 HostResolverImpl* HostResolverImpl::GetAsHostResolverImpl() {
   return this;
 }
@@ -1451,10 +1610,42 @@ void HostResolverImpl::AbortAllInProgressJobs() {
   }
 }
 
+void HostResolverImpl::RefreshStaleEntry(const RequestInfo& info,
+                                         const Key& key,
+                                         const BoundNetLog& source_net_log) {
+  // A job that is already running will refresh the entry when it completes.
+  if (FindOutstandingJob(key))
+    return;
+
+  RequestInfo refresh_info(info);
+  refresh_info.set_allow_cached_response(false);
+  refresh_info.set_is_speculative(true);
+  refresh_info.set_priority(IDLE);
+  Resolve(refresh_info, &stale_refresh_addresses_, &stale_refresh_callback_,
+          NULL, source_net_log);
+}
+
 void HostResolverImpl::OnIPAddressChanged() {
-  if (cache_.get())
-    cache_->clear();
-  if (ipv6_probe_monitoring_) {
+  OnIPAddressChangedWithDetails(NetworkChangeNotifier::IPAddressChange());
+}
+
+void HostResolverImpl::OnIPAddressChangedWithDetails(
+    const NetworkChangeNotifier::IPAddressChange& change) {
+  // The results depend on the network only through the name servers, and
+  // those are reached through the default route. So moving to another
+  // network only hides the entries of the previous one, and the entries only
+  // go away when the DNS configuration changes. A change confined to the
+  // addresses of an interface leaves the successful entries alone.
+  if (cache_.get()) {
+    if (change.default_route_changed)
+      cache_->set_network(change.default_route_interface_index);
+    if (change.dns_changed)
+      cache_->clear();
+    else
+      cache_->ClearNegativeEntries();
+  }
+  if ((change.addresses_changed || change.default_route_changed) &&
+      ipv6_probe_monitoring_) {
     DCHECK(!shutdown_);
     if (shutdown_)
       return;
@@ -1469,6 +1660,13 @@ void HostResolverImpl::OnIPAddressChanged() {
     additional_resolver_flags_ &= ~HOST_RESOLVER_LOOPBACK_ONLY;
   }
 #endif
+  // The jobs in progress would put results from the previous network or
+  // configuration in the cache.
+  if (!change.default_route_changed && !change.dns_changed)
+    return;
+  // The name servers may have changed along with the network.
+  if (async_dns_resolver_.get())
+    async_dns_resolver_->LoadSystemConfig();
   AbortAllInProgressJobs();
   // |this| may be deleted inside AbortAllInProgressJobs().
 }
@@ -19,6 +19,8 @@
 
 namespace net {
 
+class AsyncDnsResolver;
+
 // For each hostname that is requested, HostResolver creates a
 // HostResolverImpl::Job. This job gets dispatched to a thread in the global
 // WorkerPool, where it runs SystemHostResolverProc(). If requests for that same
@@ -41,6 +43,10 @@ namespace net {
 // When a HostResolverImpl::Job finishes its work in the threadpool, the
 // callbacks of each waiting request are run on the origin thread.
 //
+// With an AsyncDnsResolver set, jobs that would run SystemHostResolverProc()
+// query the name servers from the origin thread instead, and only go to the
+// threadpool when the name servers can't answer.
+//
 // Thread safety: This class is not threadsafe, and must only be called
 // from one thread!
 //
@@ -91,6 +97,14 @@ class HostResolverImpl : public HostResolver,
   // address family to IPv4 iff IPv6 is not supported.
   void ProbeIPv6Support();
 
+  // Sends the lookups that would use the system resolver to |resolver|
+  // instead, and takes ownership of it.  Must be called before any request
+  // has been made.
+  void SetAsyncDnsResolver(AsyncDnsResolver* resolver);
+
+  // Returns the resolver given to SetAsyncDnsResolver(), or NULL.
+  AsyncDnsResolver* async_dns_resolver() { return async_dns_resolver_.get(); }
+
   // Returns the cache this resolver uses, or NULL if caching is disabled.
   HostCache* cache() { return cache_.get(); }
 
@@ -109,6 +123,13 @@ class HostResolverImpl : public HostResolver,
                           size_t max_outstanding_jobs,
                           size_t max_pending_requests);
 
+  // Sets how long a request waits in the queue of pool |pool_index| before it
+  // is scheduled as if its priority were one level higher. This keeps a
+  // steady stream of higher priority requests from starving the others.
+  // Defaults to one second.
+  void SetPoolAgingInterval(JobPoolIndex pool_index,
+                            base::TimeDelta aging_interval);
+
   // HostResolver methods:
   virtual int Resolve(const RequestInfo& info,
                       AddressList* addresses,
@@ -223,12 +244,28 @@ class HostResolverImpl : public HostResolver,
   // Aborts all in progress jobs (but might start new ones).
   void AbortAllInProgressJobs();
 
+  // Starts a low priority resolve of |info| in the background, to refresh
+  // the stale cache entry for |key|.
+  void RefreshStaleEntry(const RequestInfo& info, const Key& key,
+                         const BoundNetLog& source_net_log);
+
+  // Callback for the background resolves started by RefreshStaleEntry().
+  // The result only matters to the cache, which OnJobComplete() updates.
+  void OnStaleEntryRefreshed(int result) {}
+
   // NetworkChangeNotifier::IPAddressObserver methods:
   virtual void OnIPAddressChanged();
+  virtual void OnIPAddressChangedWithDetails(
+      const NetworkChangeNotifier::IPAddressChange& change);
 
   // Cache of host resolution results.
   scoped_ptr<HostCache> cache_;
 
+  // Where the results of background refreshes are written, and the callback
+  // they complete to.  Nothing reads the addresses.
+  AddressList stale_refresh_addresses_;
+  CompletionCallbackImpl<HostResolverImpl> stale_refresh_callback_;
+
   // Map from hostname to outstanding job.
   JobMap jobs_;
 
@@ -258,6 +295,9 @@ class HostResolverImpl : public HostResolver,
   // in the case of unit-tests which inject custom host resolving behaviors.
   scoped_refptr<HostResolverProc> resolver_proc_;
 
+  // Answers the lookups that would go to the system resolver, when set.
+  scoped_ptr<AsyncDnsResolver> async_dns_resolver_;
+
   // Address family to use when the request doesn't specify one.
   AddressFamily default_address_family_;
 
@@ -11,6 +11,7 @@
 #include "base/message_loop.h"
 #include "base/string_util.h"
 #include "base/stringprintf.h"
+#include "base/threading/platform_thread.h"
 #include "net/base/address_list.h"
 #include "net/base/completion_callback.h"
 #include "net/base/mock_host_resolver.h"
@@ -1120,6 +1121,71 @@ TEST_F(HostResolverImplTest, FlushCacheOnIPAddressChange) {
   EXPECT_EQ(OK, callback.WaitForResult());
 }
 
+// Test that a change of the addresses of an interface that doesn't move the
+// default route keeps the cache.
+TEST_F(HostResolverImplTest, KeepCacheOnInterfaceAddressChange) {
+  scoped_ptr<HostResolver> host_resolver(
+      new HostResolverImpl(NULL, CreateDefaultCache(), kMaxJobs, NULL));
+
+  AddressList addrlist;
+
+  // Resolve "host1".
+  HostResolver::RequestInfo info1(HostPortPair("host1", 70));
+  TestCompletionCallback callback;
+  int rv = host_resolver->Resolve(info1, &addrlist, &callback, NULL,
+                                  BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, callback.WaitForResult());
+
+  NetworkChangeNotifier::IPAddressChange change;
+  change.interface_index = 3;
+  change.default_route_changed = false;
+  change.dns_changed = false;
+  NetworkChangeNotifier::NotifyObserversOfIPAddressChangeForTests(change);
+  MessageLoop::current()->RunAllPending();  // Notification happens async.
+
+  // Resolve "host1" again -- it is still served from cache.
+  rv = host_resolver->Resolve(info1, &addrlist, &callback, NULL, BoundNetLog());
+  EXPECT_EQ(OK, rv);
+}
+
+// Test that moving the default route hides the cache entries of the previous
+// network until it comes back.
+TEST_F(HostResolverImplTest, SwitchCacheOnDefaultRouteChange) {
+  scoped_ptr<HostResolver> host_resolver(
+      new HostResolverImpl(NULL, CreateDefaultCache(), kMaxJobs, NULL));
+
+  AddressList addrlist;
+
+  // Resolve "host1".
+  HostResolver::RequestInfo info1(HostPortPair("host1", 70));
+  TestCompletionCallback callback;
+  int rv = host_resolver->Resolve(info1, &addrlist, &callback, NULL,
+                                  BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, callback.WaitForResult());
+
+  // Move the default route to interface 3.
+  NetworkChangeNotifier::IPAddressChange change;
+  change.addresses_changed = false;
+  change.default_route_interface_index = 3;
+  change.dns_changed = false;
+  NetworkChangeNotifier::NotifyObserversOfIPAddressChangeForTests(change);
+  MessageLoop::current()->RunAllPending();  // Notification happens async.
+
+  rv = host_resolver->Resolve(info1, &addrlist, &callback, NULL, BoundNetLog());
+  ASSERT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, callback.WaitForResult());
+
+  // Move it back; the first entry is served again.
+  change.default_route_interface_index = -1;
+  NetworkChangeNotifier::NotifyObserversOfIPAddressChangeForTests(change);
+  MessageLoop::current()->RunAllPending();  // Notification happens async.
+
+  rv = host_resolver->Resolve(info1, &addrlist, &callback, NULL, BoundNetLog());
+  EXPECT_EQ(OK, rv);
+}
+
 // Test that IP address changes send ERR_ABORTED to pending requests.
 TEST_F(HostResolverImplTest, AbortOnIPAddressChanged) {
   scoped_refptr<WaitingHostResolverProc> resolver_proc(
@@ -1327,6 +1393,57 @@ TEST_F(HostResolverImplTest, HigherPriorityRequestsStartedFirst) {
   EXPECT_EQ("req6", observer.finish_log[7].info.hostname());
 }
 
+// Test that a request that has waited long enough goes before the higher
+// priority requests that came in after it.
+TEST_F(HostResolverImplTest, PendingRequestsAge) {
+  scoped_refptr<CapturingHostResolverProc> resolver_proc(
+      new CapturingHostResolverProc(NULL));
+
+  // This HostResolverImpl will only allow 1 outstanding resolve at a time.
+  size_t kMaxJobs = 1u;
+  scoped_ptr<HostResolverImpl> host_resolver(
+      new HostResolverImpl(resolver_proc, CreateDefaultCache(), kMaxJobs,
+                           NULL));
+  host_resolver->SetPoolAgingInterval(HostResolverImpl::POOL_NORMAL,
+                                      base::TimeDelta::FromMilliseconds(1));
+
+  HostResolver::RequestInfo req[] = {
+      CreateResolverRequest("req0", LOW),
+      CreateResolverRequest("req1", IDLE),
+      CreateResolverRequest("req2", HIGHEST),
+      CreateResolverRequest("req3", HIGHEST),
+  };
+
+  TestCompletionCallback callback[arraysize(req)];
+  AddressList addrlist[arraysize(req)];
+
+  // Start all of the requests, letting "req1" wait for long enough to beat
+  // the ones after it.
+  for (size_t i = 0; i < arraysize(req); ++i) {
+    int rv = host_resolver->Resolve(req[i], &addrlist[i],
+                                    &callback[i], NULL, BoundNetLog());
+    EXPECT_EQ(ERR_IO_PENDING, rv);
+    if (i == 1u)
+      base::PlatformThread::Sleep(20);
+  }
+
+  // Unblock the resolver thread so the requests can run.
+  resolver_proc->Signal();
+
+  for (size_t i = 0; i < arraysize(req); ++i) {
+    EXPECT_EQ(OK, callback[i].WaitForResult()) << "i=" << i;
+  }
+
+  CapturingHostResolverProc::CaptureList capture_list =
+      resolver_proc->GetCaptureList();
+  ASSERT_EQ(4u, capture_list.size());
+
+  EXPECT_EQ("req0", capture_list[0].hostname);
+  EXPECT_EQ("req1", capture_list[1].hostname);
+  EXPECT_EQ("req2", capture_list[2].hostname);
+  EXPECT_EQ("req3", capture_list[3].hostname);
+}
+
 // Try cancelling a request which has not been attached to a job yet.
 TEST_F(HostResolverImplTest, CancelPendingRequest) {
   scoped_refptr<CapturingHostResolverProc> resolver_proc(
@@ -1673,7 +1790,7 @@ TEST_F(HostResolverImplTest, DisallowNonCachedResponses) {
   info.set_only_use_cached_response(true);
   CapturingBoundNetLog log(CapturingNetLog::kUnbounded);
   int err = host_resolver->Resolve(info, &addrlist, NULL, NULL, log.bound());
-  EXPECT_EQ(ERR_NAME_NOT_RESOLVED, err);
+  EXPECT_EQ(ERR_DNS_CACHE_MISS, err);
 
   // This time, we fetch normally.
   info.set_only_use_cached_response(false);
@@ -1694,6 +1811,54 @@ TEST_F(HostResolverImplTest, DisallowNonCachedResponses) {
   EXPECT_TRUE(htons(kPortnum) == sa_in->sin_port);
   EXPECT_TRUE(htonl(0xc0a8012a) == sa_in->sin_addr.s_addr);
 }
+// Expired cache entries within the stale grace period are returned at once,
+// and refreshed in the background.
+TEST_F(HostResolverImplTest, ServeStaleEntries) {
+  scoped_refptr<CapturingHostResolverProc> resolver_proc(
+      new CapturingHostResolverProc(NULL));
+  resolver_proc->Signal();
+
+  // Entries expire as soon as they are written.
+  HostCache* cache = new HostCache(100, base::TimeDelta(), base::TimeDelta());
+  cache->set_stale_grace_period(base::TimeDelta::FromHours(1));
+  CapturingNetLog net_log(CapturingNetLog::kUnbounded);
+  scoped_ptr<HostResolver> host_resolver(
+      new HostResolverImpl(resolver_proc, cache, kMaxJobs, &net_log));
+
+  HostResolver::RequestInfo info(HostPortPair("host1", 70));
+  TestCompletionCallback callback;
+  AddressList addrlist;
+  int rv = host_resolver->Resolve(info, &addrlist, &callback, NULL,
+                                  BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, callback.WaitForResult());
+  EXPECT_EQ(1u, resolver_proc->GetCaptureList().size());
+
+  // The expired entry is used, and the name is looked up again.
+  AddressList stale_addrlist;
+  rv = host_resolver->Resolve(info, &stale_addrlist, &callback, NULL,
+                              BoundNetLog());
+  ASSERT_EQ(OK, rv);  // Should complete synchronously.
+  EXPECT_EQ(70, stale_addrlist.GetPort());
+
+  CapturingNetLog::EntryList entries;
+  net_log.GetEntries(&entries);
+  size_t stale_hits = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (entries[i].type == NetLog::TYPE_HOST_RESOLVER_IMPL_STALE_CACHE_HIT)
+      stale_hits++;
+  }
+  EXPECT_EQ(1u, stale_hits);
+
+  // A request that bypasses the cache joins the refresh, rather than starting
+  // another lookup.
+  info.set_allow_cached_response(false);
+  rv = host_resolver->Resolve(info, &addrlist, &callback, NULL, BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, callback.WaitForResult());
+  EXPECT_EQ(2u, resolver_proc->GetCaptureList().size());
+}
+
 // TODO(cbentzel): Test a mix of requests with different HostResolverFlags.
 
 }  // namespace
@@ -22,7 +22,6 @@
 #endif
 
 #include "base/eintr_wrapper.h"
-#include "base/threading/platform_thread.h"
 #include "net/base/net_util.h"
 #include "net/base/listen_socket.h"
 
@@ -34,6 +33,10 @@ namespace {
 
 const int kReadBufSize = 4096;
 
+// How many times a socket is read from before the other sockets watched by
+// the message loop get their turn.
+const int kMaxReadsPerEvent = 16;
+
 }  // namespace
 
 #if defined(OS_WIN)
@@ -68,6 +71,41 @@ void ListenSocket::Send(const std::string& str, bool append_linefeed) {
   Send(str.data(), static_cast<int>(str.length()), append_linefeed);
 }
 
+void ListenSocket::Send(net::IOBuffer* buffer, int len) {
+  if (close_after_sending_)
+    return;
+  scoped_refptr<net::DrainableIOBuffer> drainable(
+      new net::DrainableIOBuffer(buffer, len));
+  if (send_queue_.empty()) {
+    int sent = SendNow(drainable->data(), len);
+    if (sent < 0 || sent == len)
+      return;
+    drainable->DidConsume(sent);
+  }
+  QueueSend(drainable);
+}
+
+void ListenSocket::CloseAfterSending() {
+  DCHECK(!close_after_sending_);
+  socket_delegate_ = NULL;
+  if (send_queue_.empty()) {
+    CloseSocket(socket_);
+    socket_ = kInvalidSocket;
+    return;
+  }
+  close_after_sending_ = true;
+  // Released once the queue is sent.
+  AddRef();
+  RewatchSocket();
+}
+
+void ListenSocket::SetSendQueueWatermarks(int high, int low) {
+  DCHECK_GE(low, 0);
+  DCHECK_GT(high, low);
+  send_queue_high_watermark_ = high;
+  send_queue_low_watermark_ = low;
+}
+
 void ListenSocket::PauseReads() {
   DCHECK(!reads_paused_);
   reads_paused_ = true;
@@ -86,7 +124,12 @@ ListenSocket::ListenSocket(SOCKET s, ListenSocketDelegate *del)
     : socket_(s),
       socket_delegate_(del),
       reads_paused_(false),
-      has_pending_reads_(false) {
+      has_pending_reads_(false),
+      pending_send_size_(0),
+      send_queue_high_watermark_(kMaxPendingSendSize),
+      send_queue_low_watermark_(kMaxPendingSendSize / 2),
+      send_queue_full_(false),
+      close_after_sending_(false) {
 #if defined(OS_WIN)
   socket_event_ = WSACreateEvent();
   // TODO(ibrar): error handling in case of socket_event_ == WSA_INVALID_EVENT
@@ -141,13 +184,25 @@ SOCKET ListenSocket::Accept(SOCKET s) {
 }
 
 void ListenSocket::SendInternal(const char* bytes, int len) {
-  char* send_buf = const_cast<char *>(bytes);
-  int len_left = len;
-  while (true) {
-    int sent = HANDLE_EINTR(send(socket_, send_buf, len_left, 0));
-    if (sent == len_left) {  // A shortcut to avoid extraneous checks.
-      break;
-    }
+  if (close_after_sending_)
+    return;
+  if (send_queue_.empty()) {
+    int sent = SendNow(bytes, len);
+    if (sent < 0 || sent == len)
+      return;
+    bytes += sent;
+    len -= sent;
+  }
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(len));
+  memcpy(buffer->data(), bytes, len);
+  QueueSend(new net::DrainableIOBuffer(buffer, len));
+}
+
+int ListenSocket::SendNow(const char* bytes, int len) {
+  int len_sent = 0;
+  while (len_sent < len) {
+    int sent = HANDLE_EINTR(send(socket_, bytes + len_sent, len - len_sent,
+                                 0));
     if (sent == kSocketError) {
 #if defined(OS_WIN)
       if (WSAGetLastError() != WSAEWOULDBLOCK) {
@@ -156,17 +211,72 @@ void ListenSocket::SendInternal(const char* bytes, int len) {
       if (errno != EWOULDBLOCK && errno != EAGAIN) {
         LOG(ERROR) << "send failed: errno==" << errno;
 #endif
-        break;
+        return -1;
       }
-      // Otherwise we would block, and now we have to wait for a retry.
-      // Fall through to PlatformThread::YieldCurrentThread()
-    } else {
-      // sent != len_left according to the shortcut above.
-      // Shift the buffer start and send the remainder after a short while.
-      send_buf += sent;
-      len_left -= sent;
+      // The rest waits until the socket is writable.
+      break;
     }
-    base::PlatformThread::YieldCurrentThread();
+    len_sent += sent;
+  }
+  return len_sent;
+}
+
+void ListenSocket::QueueSend(net::DrainableIOBuffer* buffer) {
+  bool was_empty = send_queue_.empty();
+  send_queue_.push_back(buffer);
+  pending_send_size_ += buffer->BytesRemaining();
+  bool became_full =
+      !send_queue_full_ && pending_send_size_ > send_queue_high_watermark_;
+  if (became_full)
+    send_queue_full_ = true;
+  if (was_empty || became_full)
+    RewatchSocket();
+  if (became_full && socket_delegate_)
+    socket_delegate_->DidFillSendQueue(this);
+}
+
+void ListenSocket::SendQueued() {
+  // Both closing and the delegate may release the last reference to |this|.
+  scoped_refptr<ListenSocket> protect(this);
+  while (!send_queue_.empty()) {
+    net::DrainableIOBuffer* buffer = send_queue_.front();
+    int sent = SendNow(buffer->data(), buffer->BytesRemaining());
+    if (sent < 0) {
+      // The rest can't be sent either.
+      send_queue_.clear();
+      pending_send_size_ = 0;
+      break;
+    }
+    buffer->DidConsume(sent);
+    pending_send_size_ -= sent;
+    if (buffer->BytesRemaining())
+      break;
+    send_queue_.pop_front();
+  }
+
+  if (close_after_sending_) {
+    if (!send_queue_.empty())
+      return;
+    CloseSocket(socket_);
+    socket_ = kInvalidSocket;
+    close_after_sending_ = false;
+    Release();  // Balanced in CloseAfterSending().
+    return;
+  }
+
+  bool drained =
+      send_queue_full_ && pending_send_size_ <= send_queue_low_watermark_;
+  if (drained)
+    send_queue_full_ = false;
+  if (send_queue_.empty() || drained)
+    RewatchSocket();
+  if (!drained)
+    return;
+  if (socket_delegate_)
+    socket_delegate_->DidDrainSendQueue(this);
+  if (has_pending_reads_ && !reads_paused_ && !send_queue_full_) {
+    has_pending_reads_ = false;
+    Read();
   }
 }
 
@@ -195,9 +305,18 @@ void ListenSocket::Accept() {
 }
 
 void ListenSocket::Read() {
+  // The delegate may drop its reference to |this| in DidRead().
+  scoped_refptr<ListenSocket> protect(this);
   char buf[kReadBufSize + 1];  // +1 for null termination
   int len;
+  int reads = 0;
   do {
+    if (!socket_delegate_)
+      break;
+    if (send_queue_full_) {
+      has_pending_reads_ = true;
+      break;
+    }
     len = HANDLE_EINTR(recv(socket_, buf, kReadBufSize, 0));
     if (len == kSocketError) {
 #if defined(OS_WIN)
@@ -223,7 +342,7 @@ void ListenSocket::Read() {
       buf[len] = 0;  // already create a buffer with +1 length
       socket_delegate_->DidRead(this, buf, len);
     }
-  } while (len == kReadBufSize);
+  } while (len == kReadBufSize && ++reads < kMaxReadsPerEvent);
 }
 
 void ListenSocket::Close() {
@@ -232,7 +351,8 @@ void ListenSocket::Close() {
     return;
   wait_state_ = WAITING_CLOSE;
 #endif
-  socket_delegate_->DidClose(this);
+  if (socket_delegate_)
+    socket_delegate_->DidClose(this);
 }
 
 void ListenSocket::CloseSocket(SOCKET s) {
@@ -248,7 +368,8 @@ void ListenSocket::CloseSocket(SOCKET s) {
 
 void ListenSocket::WatchSocket(WaitState state) {
 #if defined(OS_WIN)
-  WSAEventSelect(socket_, socket_event_, FD_ACCEPT | FD_CLOSE | FD_READ);
+  WSAEventSelect(socket_, socket_event_,
+                 FD_ACCEPT | FD_CLOSE | FD_READ | FD_WRITE);
   watcher_.StartWatching(socket_event_, this);
 #elif defined(OS_POSIX)
   // Implicitly calls StartWatchingFileDescriptor().
@@ -266,6 +387,26 @@ void ListenSocket::UnwatchSocket() {
 #endif
 }
 
+void ListenSocket::RewatchSocket() {
+#if defined(OS_POSIX)
+  // Readiness is level triggered, so a socket that isn't read from mustn't
+  // be watched for reads.
+  bool read = !send_queue_full_ && !close_after_sending_;
+  bool write = !send_queue_.empty();
+  watcher_.StopWatchingFileDescriptor();
+  if (read || write) {
+    MessageLoopForIO::current()->WatchFileDescriptor(
+        socket_, true,
+        read && write ? MessageLoopForIO::WATCH_READ_WRITE :
+            (read ? MessageLoopForIO::WATCH_READ :
+                    MessageLoopForIO::WATCH_WRITE),
+        &watcher_, this);
+  }
+#endif
+  // On Windows, FD_WRITE is always selected, and FD_READ isn't signaled
+  // again until the socket is read.
+}
+
 // TODO(ibrar): We can add these functions into OS dependent files
 #if defined(OS_WIN)
 // MessageLoop watcher callback
@@ -284,11 +425,20 @@ void ListenSocket::OnObjectSignaled(HANDLE object) {
     // The net seems to think that this is ignorable.
     return;
   }
+  // SendQueued() may release the last reference to |this|.
+  scoped_refptr<ListenSocket> protect(this);
+  if (ev.lNetworkEvents & FD_WRITE) {
+    SendQueued();
+  }
+  if (close_after_sending_ || socket_ == kInvalidSocket) {
+    // Closing: nothing else matters.
+    return;
+  }
   if (ev.lNetworkEvents & FD_ACCEPT) {
     Accept();
   }
   if (ev.lNetworkEvents & FD_READ) {
-    if (reads_paused_) {
+    if (reads_paused_ || send_queue_full_) {
       has_pending_reads_ = true;
     } else {
       Read();
@@ -304,7 +454,7 @@ void ListenSocket::OnFileCanReadWithoutBlocking(int fd) {
     Accept();
   }
   if (wait_state_ == WAITING_READ) {
-    if (reads_paused_) {
+    if (reads_paused_ || send_queue_full_) {
       has_pending_reads_ = true;
     } else {
       Read();
@@ -317,9 +467,8 @@ void ListenSocket::OnFileCanReadWithoutBlocking(int fd) {
 }
 
 void ListenSocket::OnFileCanWriteWithoutBlocking(int fd) {
-  // MessagePumpLibevent callback, we don't listen for write events
-  // so we shouldn't ever reach here.
-  NOTREACHED();
+  // Only watched while there is something queued to send.
+  SendQueued();
 }
 
 #endif
@@ -17,6 +17,7 @@
 #if defined(OS_WIN)
 #include <winsock2.h>
 #endif
+#include <deque>
 #include <string>
 #if defined(OS_WIN)
 #include "base/win/object_watcher.h"
@@ -26,6 +27,7 @@
 
 #include "base/basictypes.h"
 #include "base/memory/ref_counted.h"
+#include "net/base/io_buffer.h"
 
 #if defined(OS_POSIX)
 struct event;  // From libevent
@@ -56,6 +58,12 @@ class ListenSocket : public base::RefCountedThreadSafe<ListenSocket>,
                          const char* data,
                          int len) = 0;
     virtual void DidClose(ListenSocket *sock) = 0;
+
+    // Called when more than the high watermark is queued to be sent on
+    // |sock|, from the Send() call that queued it, and when the queue drains
+    // back to the low watermark.  |sock| doesn't read in between.
+    virtual void DidFillSendQueue(ListenSocket *sock) {}
+    virtual void DidDrainSendQueue(ListenSocket *sock) {}
   };
 
   // Listen on port for the specified IP address.  Use 127.0.0.1 to only
@@ -63,9 +71,29 @@ class ListenSocket : public base::RefCountedThreadSafe<ListenSocket>,
   static ListenSocket* Listen(std::string ip, int port,
                               ListenSocketDelegate* del);
 
-  // Send data to the socket.
+  // Send data to the socket.  What can't be sent right away is queued, and
+  // sent in order as the socket becomes writable.  Once more than the high
+  // watermark is queued, the socket stops reading until the queue drains to
+  // the low watermark, so that a peer that doesn't read what it is sent
+  // stops being served.
   void Send(const char* bytes, int len, bool append_linefeed = false);
   void Send(const std::string& str, bool append_linefeed = false);
+  // Sends the first |len| bytes of |buffer| without copying them.  |buffer|
+  // is kept until they are sent.
+  void Send(net::IOBuffer* buffer, int len);
+
+  // Returns the number of bytes queued to be sent.
+  int pending_send_size() const { return pending_send_size_; }
+
+  // Closes the socket once the data queued so far is sent.  The delegate is
+  // not called any more.
+  void CloseAfterSending();
+
+  // Sets the watermarks, in bytes, which default to kMaxPendingSendSize and
+  // half of it.
+  void SetSendQueueWatermarks(int high, int low);
+
+  static const int kMaxPendingSendSize = 256 * 1024;
 
   // NOTE: This is for unit test use only!
   // Pause/Resume calling Read().  Note that ResumeReads() will also call
@@ -94,6 +122,14 @@ class ListenSocket : public base::RefCountedThreadSafe<ListenSocket>,
 
   virtual void SendInternal(const char* bytes, int len);
 
+  // Sends as much of [bytes, bytes + len) as the socket takes without
+  // blocking.  Returns the number of bytes sent, or -1 on error.
+  int SendNow(const char* bytes, int len);
+  // Queues the rest of |buffer| to be sent when the socket is writable.
+  void QueueSend(net::DrainableIOBuffer* buffer);
+  // Sends what is queued, until the socket would block.
+  void SendQueued();
+
   virtual void Listen();
   virtual void Accept();
   virtual void Read();
@@ -104,6 +140,9 @@ class ListenSocket : public base::RefCountedThreadSafe<ListenSocket>,
   // we are not using state.
   void WatchSocket(WaitState state);
   void UnwatchSocket();
+  // Watches a connected socket for reads, unless too much is queued to be
+  // sent, and for writes while anything is.
+  void RewatchSocket();
 
 #if defined(OS_WIN)
   // ObjectWatcher delegate
@@ -126,6 +165,16 @@ class ListenSocket : public base::RefCountedThreadSafe<ListenSocket>,
   bool reads_paused_;
   bool has_pending_reads_;
 
+  std::deque<scoped_refptr<net::DrainableIOBuffer> > send_queue_;
+  int pending_send_size_;
+  int send_queue_high_watermark_;
+  int send_queue_low_watermark_;
+  // True while reads stop because too much is queued to be sent.
+  bool send_queue_full_;
+  // True after CloseAfterSending(), while the socket keeps a reference to
+  // itself until the queue is sent.
+  bool close_after_sending_;
+
   DISALLOW_COPY_AND_ASSIGN(ListenSocket);
 };
 
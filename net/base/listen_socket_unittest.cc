@@ -18,6 +18,11 @@ static const char kHelloWorld[] = "HELLO, WORLD";
 static const int kMaxQueueSize = 20;
 static const char kLoopback[] = "127.0.0.1";
 static const int kDefaultTimeoutMs = 5000;
+static const int kLongSendSize = 4 * 1024 * 1024;
+
+static char LongSendByte(int i) {
+  return 'a' + i % 26;
+}
 
 ListenSocketTester::ListenSocketTester()
     : thread_(NULL),
@@ -125,6 +130,27 @@ void ListenSocketTester::SendFromTester() {
   ReportAction(ListenSocketTestAction(ACTION_SEND));
 }
 
+void ListenSocketTester::SendLongFromTester() {
+  // Keep the socket reading, and the delegate from being told.
+  connection_->SetSendQueueWatermarks(2 * kLongSendSize, kLongSendSize);
+  SendLong();
+}
+
+void ListenSocketTester::SendLong() {
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(kLongSendSize));
+  for (int i = 0; i < kLongSendSize; ++i)
+    buffer->data()[i] = LongSendByte(i);
+  connection_->Send(buffer, kLongSendSize);
+  // More than the socket takes is left queued, and sent as it is read.
+  ReportAction(ListenSocketTestAction(
+      connection_->pending_send_size() ? ACTION_SEND : ACTION_NONE));
+}
+
+void ListenSocketTester::SendLongWithWatermarksFromTester() {
+  connection_->SetSendQueueWatermarks(1, 0);
+  SendLong();
+}
+
 void ListenSocketTester::TestClientSend() {
   ASSERT_TRUE(Send(test_socket_, kHelloWorld));
   NextAction();
@@ -174,6 +200,41 @@ void ListenSocketTester::TestServerSend() {
   ASSERT_STREQ(buf, kHelloWorld);
 }
 
+void ListenSocketTester::TestServerSendLong() {
+  loop_->PostTask(FROM_HERE, NewRunnableMethod(
+      this, &ListenSocketTester::SendLongFromTester));
+  NextAction();
+  ASSERT_EQ(ACTION_SEND, last_action_.type());
+  char buf[kReadBufSize];
+  int recv_len = 0;
+  while (recv_len < kLongSendSize) {
+    int r = HANDLE_EINTR(recv(test_socket_, buf, kReadBufSize, 0));
+    ASSERT_GT(r, 0);
+    for (int i = 0; i < r; ++i)
+      ASSERT_EQ(LongSendByte(recv_len + i), buf[i]);
+    recv_len += r;
+  }
+  ASSERT_EQ(kLongSendSize, recv_len);
+}
+
+void ListenSocketTester::TestSendQueueWatermarks() {
+  loop_->PostTask(FROM_HERE, NewRunnableMethod(
+      this, &ListenSocketTester::SendLongWithWatermarksFromTester));
+  NextAction();
+  ASSERT_EQ(ACTION_SEND_QUEUE_FULL, last_action_.type());
+  NextAction();
+  ASSERT_EQ(ACTION_SEND, last_action_.type());
+  char buf[kReadBufSize];
+  int recv_len = 0;
+  while (recv_len < kLongSendSize) {
+    int r = HANDLE_EINTR(recv(test_socket_, buf, kReadBufSize, 0));
+    ASSERT_GT(r, 0);
+    recv_len += r;
+  }
+  NextAction();
+  ASSERT_EQ(ACTION_SEND_QUEUE_DRAINED, last_action_.type());
+}
+
 bool ListenSocketTester::Send(SOCKET sock, const std::string& str) {
   int len = static_cast<int>(str.length());
   int send_len = HANDLE_EINTR(send(sock, str.data(), len, 0));
@@ -204,6 +265,14 @@ void ListenSocketTester::DidClose(ListenSocket *sock) {
   ReportAction(ListenSocketTestAction(ACTION_CLOSE));
 }
 
+void ListenSocketTester::DidFillSendQueue(ListenSocket *sock) {
+  ReportAction(ListenSocketTestAction(ACTION_SEND_QUEUE_FULL));
+}
+
+void ListenSocketTester::DidDrainSendQueue(ListenSocket *sock) {
+  ReportAction(ListenSocketTestAction(ACTION_SEND_QUEUE_DRAINED));
+}
+
 ListenSocketTester::~ListenSocketTester() {}
 
 ListenSocket* ListenSocketTester::DoListen() {
@@ -243,3 +312,11 @@ TEST_F(ListenSocketTest, ClientSendLong) {
 TEST_F(ListenSocketTest, ServerSend) {
   tester_->TestServerSend();
 }
+
+TEST_F(ListenSocketTest, ServerSendLong) {
+  tester_->TestServerSendLong();
+}
+
+TEST_F(ListenSocketTest, SendQueueWatermarks) {
+  tester_->TestSendQueueWatermarks();
+}
@@ -42,7 +42,9 @@ enum ActionType {
   ACTION_READ = 3,
   ACTION_SEND = 4,
   ACTION_CLOSE = 5,
-  ACTION_SHUTDOWN = 6
+  ACTION_SHUTDOWN = 6,
+  ACTION_SEND_QUEUE_FULL = 7,
+  ACTION_SEND_QUEUE_DRAINED = 8
 };
 
 class ListenSocketTestAction {
@@ -83,12 +85,21 @@ class ListenSocketTester :
   void Shutdown();
   void Listen();
   void SendFromTester();
+  void SendLongFromTester();
+  void SendLongWithWatermarksFromTester();
+  // send a long buffer and report whether any of it is left queued
+  void SendLong();
   // verify the send/read from client to server
   void TestClientSend();
   // verify send/read of a longer string
   void TestClientSendLong();
   // verify a send/read from server to client
   void TestServerSend();
+  // verify a send from server to client that doesn't fit in the socket
+  // buffers
+  void TestServerSendLong();
+  // verify the delegate is told when the send queue fills and drains
+  void TestSendQueueWatermarks();
 
   virtual bool Send(SOCKET sock, const std::string& str);
 
@@ -96,6 +107,8 @@ class ListenSocketTester :
   virtual void DidAccept(ListenSocket *server, ListenSocket *connection);
   virtual void DidRead(ListenSocket *connection, const char* data, int len);
   virtual void DidClose(ListenSocket *sock);
+  virtual void DidFillSendQueue(ListenSocket *sock);
+  virtual void DidDrainSendQueue(ListenSocket *sock);
 
   scoped_ptr<base::Thread> thread_;
   MessageLoopForIO* loop_;
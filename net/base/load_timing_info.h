@@ -0,0 +1,81 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_BASE_LOAD_TIMING_INFO_H_
+#define NET_BASE_LOAD_TIMING_INFO_H_
+#pragma once
+
+#include "base/time.h"
+
+namespace net {
+
+// LoadTimingInfo holds the times at which a request passed through each step
+// of being loaded.  Every layer records its times with TimeTicks as it moves
+// from one step to the next, so that the whole record is available from
+// URLRequest::GetLoadTimingInfo() without capturing a NetLog.
+//
+// A time is null if the request did not go through that step, e.g. the
+// connect times for a reused socket, or the send times for a response served
+// from the cache.
+struct LoadTimingInfo {
+  // The steps of connecting a socket.  When connecting through a proxy, these
+  // are the times for the connection to the proxy, and the SSL times are for
+  // the handshake with the origin server, if any.
+  struct ConnectTiming {
+    ConnectTiming();
+    ~ConnectTiming();
+
+    base::TimeTicks dns_start;
+    base::TimeTicks dns_end;
+    base::TimeTicks connect_start;
+    base::TimeTicks connect_end;
+    base::TimeTicks ssl_start;
+    base::TimeTicks ssl_end;
+  };
+
+  LoadTimingInfo();
+  ~LoadTimingInfo();
+
+  // True if the request was sent on a socket that had been used before, in
+  // which case |connect_timing| is empty.
+  bool socket_reused;
+
+  // When URLRequest::Start() was called, as a wall clock time and as the base
+  // of all the TimeTicks below.
+  base::Time request_start_time;
+  base::TimeTicks request_start;
+
+  // Looking up the response in the cache.
+  base::TimeTicks cache_start;
+  base::TimeTicks cache_end;
+
+  // Resolving the proxy to use.  Happens after |stream_start|.
+  base::TimeTicks proxy_resolve_start;
+  base::TimeTicks proxy_resolve_end;
+
+  // Asking for a stream to send the request on.  This spans resolving the
+  // proxy and connecting; the time from |proxy_resolve_end| to the first
+  // connect time is spent queued in the socket pools, waiting for a socket
+  // slot.
+  base::TimeTicks stream_start;
+  base::TimeTicks stream_end;
+
+  ConnectTiming connect_timing;
+
+  // Sending the request headers and body.
+  base::TimeTicks send_start;
+  base::TimeTicks send_end;
+
+  // When the first byte of the response headers arrived, and when the last
+  // did.
+  base::TimeTicks receive_headers_start;
+  base::TimeTicks receive_headers_end;
+
+  // Total time spent in the content decoding filters.
+  base::TimeDelta filter_time;
+};
+
+}  // namespace net
+
+#endif  // NET_BASE_LOAD_TIMING_INFO_H_
@@ -0,0 +1,25 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_BASE_MEMORY_PRESSURE_LEVEL_H_
+#define NET_BASE_MEMORY_PRESSURE_LEVEL_H_
+#pragma once
+
+namespace net {
+
+// How much memory the network stack should give back when the embedder is
+// told that the system runs low, as by Android's onTrimMemory().  See
+// URLRequestContext::PurgeMemory().
+enum MemoryPressureLevel {
+  // Drops what is cheap to get back: idle connections, and cached data that
+  // can't be served anymore or hasn't been used for a while.
+  MEMORY_PRESSURE_MODERATE,
+  // Drops everything that isn't in use, at the cost of slower loads until
+  // the caches are warm again.
+  MEMORY_PRESSURE_CRITICAL,
+};
+
+}  // namespace net
+
+#endif  // NET_BASE_MEMORY_PRESSURE_LEVEL_H_
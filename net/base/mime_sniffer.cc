@@ -230,7 +230,10 @@ static bool MagicCmp(const char* magic_entry, const char* content, size_t len) {
   return true;
 }
 
+// |content_strlen| is the length of |content| up to the first '\0', or |size|
+// if there is none.
 static bool MatchMagicNumber(const char* content, size_t size,
+                             size_t content_strlen,
                              const MagicNumber* magic_entry,
                              std::string* result) {
   const size_t len = magic_entry->magic_len;
@@ -238,13 +241,17 @@ static bool MatchMagicNumber(const char* content, size_t size,
   // Keep kBytesRequiredForMagic honest.
   DCHECK_LE(len, kBytesRequiredForMagic);
 
-  // To compare with magic strings, we need to compute strlen(content), but
-  // content might not actually have a null terminator.  In that case, we
-  // pretend the length is content_size.
-  const char* end =
-      static_cast<const char*>(memchr(content, '\0', size));
-  const size_t content_strlen =
-      (end != NULL) ? static_cast<size_t>(end - content) : size;
+  // Most entries differ from the content in the first byte, so check that
+  // before comparing the rest.
+  const char first = magic_entry->magic[0];
+  if (size == 0)
+    return false;
+  if (magic_entry->is_string) {
+    if (base::ToLowerASCII(first) != base::ToLowerASCII(content[0]))
+      return false;
+  } else if (first != '.' && first != content[0]) {
+    return false;
+  }
 
   bool match = false;
   if (magic_entry->is_string) {
@@ -268,8 +275,18 @@ static bool CheckForMagicNumbers(const char* content, size_t size,
                                  const MagicNumber* magic, size_t magic_len,
                                  base::Histogram* counter,
                                  std::string* result) {
+  // To compare with magic strings, we need to compute strlen(content), but
+  // content might not actually have a null terminator.  In that case, we
+  // pretend the length is content_size.  This is done once for the whole
+  // table rather than for each entry.
+  const char* end =
+      static_cast<const char*>(memchr(content, '\0', size));
+  const size_t content_strlen =
+      (end != NULL) ? static_cast<size_t>(end - content) : size;
+
   for (size_t i = 0; i < magic_len; ++i) {
-    if (MatchMagicNumber(content, size, &(magic[i]), result)) {
+    if (MatchMagicNumber(content, size, content_strlen, &(magic[i]),
+                         result)) {
       if (counter) counter->Add(static_cast<int>(i));
       return true;
     }
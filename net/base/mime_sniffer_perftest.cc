@@ -0,0 +1,67 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/perftimer.h"
+#include "googleurl/src/gurl.h"
+#include "net/base/mime_sniffer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kNumIterations = 100000;
+
+// Sniffs |content| as though it had been served with |type_hint|, and checks
+// that |expected| is the result.
+void SniffRepeatedly(const char* name, const std::string& content,
+                     const std::string& type_hint,
+                     const std::string& expected) {
+  GURL url("http://www.example.com/");
+  std::string mime_type;
+
+  PerfTimeLogger timer(name);
+  for (int i = 0; i < kNumIterations; ++i) {
+    net::SniffMimeType(content.data(), content.size(), url, type_hint,
+                       &mime_type);
+  }
+  timer.Done();
+  EXPECT_EQ(expected, mime_type);
+}
+
+// Text that matches none of the signatures, so that every table is searched.
+std::string MakeText() {
+  std::string text;
+  while (text.size() < static_cast<size_t>(net::kMaxBytesToSniff))
+    text.append("The quick brown fox jumps over the lazy dog.\n");
+  text.resize(net::kMaxBytesToSniff);
+  return text;
+}
+
+TEST(MimeSnifferPerfTest, SniffHTML) {
+  std::string content("  \n<html><head><title>Example</title></head>");
+  content.append(MakeText());
+  SniffRepeatedly("Sniff_html", content, "", "text/html");
+}
+
+TEST(MimeSnifferPerfTest, SniffLateHTMLTag) {
+  // <p> is the last of the sniffable tags.
+  std::string content("<p>");
+  content.append(MakeText());
+  SniffRepeatedly("Sniff_late_html_tag", content, "", "text/html");
+}
+
+TEST(MimeSnifferPerfTest, SniffPlainText) {
+  SniffRepeatedly("Sniff_plain_text", MakeText(), "", "text/plain");
+}
+
+TEST(MimeSnifferPerfTest, SniffMagicNumber) {
+  std::string content("PK\x03\x04");
+  content.append(MakeText());
+  SniffRepeatedly("Sniff_magic_number", content, "text/plain",
+                  "application/zip");
+}
+
+}  // namespace
@@ -17,6 +17,7 @@
 //   500-599 ?
 //   600-699 FTP errors
 //   700-799 Certificate manager errors
+//   800-899 DNS resolver errors
 //
 
 // An asynchronous IO operation is not yet complete.  This usually does not
@@ -447,6 +448,10 @@ NET_ERROR(INCOMPLETE_SPDY_HEADERS, -347)
 // SPDY server didn't respond to the PING message.
 NET_ERROR(SPDY_PING_FAILED, -352)
 
+// The request was sent on a pipelined connection that could not deliver its
+// response, because an earlier request on the same connection failed.
+NET_ERROR(PIPELINE_EVICTION, -353)
+
 // The cache does not have the requested entry.
 NET_ERROR(CACHE_MISS, -400)
 
@@ -533,3 +538,22 @@ NET_ERROR(IMPORT_CA_CERT_FAILED, -705)
 
 // Server certificate import failed due to some internal error.
 NET_ERROR(IMPORT_SERVER_CERT_FAILED, -706)
+
+// DNS error codes.
+
+// The DNS server sent a response that couldn't be parsed.
+NET_ERROR(DNS_MALFORMED_RESPONSE, -800)
+
+// The DNS server's answer didn't fit in a UDP datagram, and has to be asked
+// for again over TCP.
+NET_ERROR(DNS_SERVER_REQUIRES_TCP, -801)
+
+// The DNS server failed, or refused to answer the query.
+NET_ERROR(DNS_SERVER_FAILED, -802)
+
+// No DNS server answered in time.
+NET_ERROR(DNS_TIMED_OUT, -803)
+
+// The host resolver was asked to answer from its cache only, and the cache
+// had no entry for the host.
+NET_ERROR(DNS_CACHE_MISS, -804)
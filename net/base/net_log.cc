@@ -5,14 +5,21 @@
 #include "net/base/net_log.h"
 
 #include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/string_number_conversions.h"
 #include "base/time.h"
 #include "base/utf_string_conversions.h"
 #include "base/values.h"
 #include "net/base/net_errors.h"
+#include "net/base/net_log_binary.h"
 
 namespace net {
 
+void NetLog::EventParameters::AppendToBinaryLog(std::string* output) const {
+  scoped_ptr<Value> value(ToValue());
+  NetLogBinaryWriter::AppendValueParameters(value.get(), output);
+}
+
 Value* NetLog::Source::ToValue() const {
   DictionaryValue* dict = new DictionaryValue();
   dict->SetInteger("type", static_cast<int>(type));
@@ -195,12 +202,20 @@ Value* NetLogIntegerParameter::ToValue() const {
   return dict;
 }
 
+void NetLogIntegerParameter::AppendToBinaryLog(std::string* output) const {
+  NetLogBinaryWriter::AppendIntegerParameter(name_, value_, output);
+}
+
 Value* NetLogStringParameter::ToValue() const {
   DictionaryValue* dict = new DictionaryValue();
   dict->SetString(name_, value_);
   return dict;
 }
 
+void NetLogStringParameter::AppendToBinaryLog(std::string* output) const {
+  NetLogBinaryWriter::AppendStringParameter(name_, value_, output);
+}
+
 Value* NetLogSourceParameter::ToValue() const {
   DictionaryValue* dict = new DictionaryValue();
 
@@ -208,6 +223,10 @@ Value* NetLogSourceParameter::ToValue() const {
   return dict;
 }
 
+void NetLogSourceParameter::AppendToBinaryLog(std::string* output) const {
+  NetLogBinaryWriter::AppendSourceParameter(name_, value_, output);
+}
+
 ScopedNetLogEvent::ScopedNetLogEvent(
     const BoundNetLog& net_log,
     NetLog::EventType event_type,
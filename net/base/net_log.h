@@ -88,6 +88,12 @@ class NetLog {
     // The caller takes ownership of the returned Value*.
     virtual Value* ToValue() const = 0;
 
+    // Appends the parameters to |output| in the format of
+    // NetLogBinaryWriter.  Writes the JSON of ToValue() by default.
+    // Parameters which are logged often should override it, so that no
+    // Values are built for them.
+    virtual void AppendToBinaryLog(std::string* output) const;
+
    private:
     DISALLOW_COPY_AND_ASSIGN(EventParameters);
   };
@@ -233,6 +239,7 @@ class NetLogStringParameter : public NetLog::EventParameters {
   }
 
   virtual Value* ToValue() const;
+  virtual void AppendToBinaryLog(std::string* output) const;
 
  private:
   const char* const name_;
@@ -252,6 +259,7 @@ class NetLogIntegerParameter : public NetLog::EventParameters {
   }
 
   virtual Value* ToValue() const;
+  virtual void AppendToBinaryLog(std::string* output) const;
 
  private:
   const char* name_;
@@ -271,6 +279,7 @@ class NetLogSourceParameter : public NetLog::EventParameters {
   }
 
   virtual Value* ToValue() const;
+  virtual void AppendToBinaryLog(std::string* output) const;
 
  private:
   const char* name_;
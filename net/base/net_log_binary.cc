@@ -0,0 +1,344 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/net_log_binary.h"
+
+#include <string.h>
+
+#include <map>
+
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/string_number_conversions.h"
+#include "base/values.h"
+
+namespace net {
+
+namespace {
+
+void AppendVarint(uint64 value, std::string* output) {
+  while (value >= 0x80) {
+    output->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  output->push_back(static_cast<char>(value));
+}
+
+// Zigzag encoding keeps small negative numbers small.
+void AppendSignedVarint(int64 value, std::string* output) {
+  AppendVarint((static_cast<uint64>(value) << 1) ^
+               static_cast<uint64>(value >> 63), output);
+}
+
+void AppendString(const std::string& value, std::string* output) {
+  AppendVarint(value.size(), output);
+  output->append(value);
+}
+
+// Reads the records written by NetLogBinaryWriter.  Each method returns
+// false if the data ends before what it reads.
+class BinaryReader {
+ public:
+  // Reads |data| from |position|.
+  BinaryReader(const std::string& data, size_t position)
+      : data_(data),
+        position_(position) {
+  }
+
+  bool AtEnd() const { return position_ == data_.size(); }
+
+  bool ReadByte(uint8* value) {
+    if (AtEnd())
+      return false;
+    *value = static_cast<uint8>(data_[position_++]);
+    return true;
+  }
+
+  bool ReadVarint(uint64* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8 byte;
+      if (!ReadByte(&byte))
+        return false;
+      *value |= static_cast<uint64>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  bool ReadSignedVarint(int64* value) {
+    uint64 encoded;
+    if (!ReadVarint(&encoded))
+      return false;
+    *value = static_cast<int64>(encoded >> 1) ^
+             -static_cast<int64>(encoded & 1);
+    return true;
+  }
+
+  bool ReadString(std::string* value) {
+    uint64 length;
+    if (!ReadVarint(&length) || length > data_.size() - position_)
+      return false;
+    value->assign(data_, position_, static_cast<size_t>(length));
+    position_ += static_cast<size_t>(length);
+    return true;
+  }
+
+ private:
+  const std::string& data_;
+  size_t position_;
+
+  DISALLOW_COPY_AND_ASSIGN(BinaryReader);
+};
+
+Value* SourceToValue(uint64 type, uint64 id) {
+  DictionaryValue* dict = new DictionaryValue();
+  dict->SetInteger("type", static_cast<int>(type));
+  dict->SetInteger("id", static_cast<int>(id));
+  return dict;
+}
+
+// Reads the parameters of an entry.  Sets |params| to NULL if it has none.
+bool ReadParameters(BinaryReader* reader, scoped_ptr<Value>* params) {
+  uint8 tag;
+  if (!reader->ReadByte(&tag))
+    return false;
+
+  params->reset();
+  switch (tag) {
+    case NetLogBinaryWriter::PARAMS_NONE:
+      return true;
+    case NetLogBinaryWriter::PARAMS_INTEGER: {
+      std::string name;
+      int64 value;
+      if (!reader->ReadString(&name) || !reader->ReadSignedVarint(&value))
+        return false;
+      DictionaryValue* dict = new DictionaryValue();
+      dict->SetInteger(name, static_cast<int>(value));
+      params->reset(dict);
+      return true;
+    }
+    case NetLogBinaryWriter::PARAMS_STRING: {
+      std::string name;
+      std::string value;
+      if (!reader->ReadString(&name) || !reader->ReadString(&value))
+        return false;
+      DictionaryValue* dict = new DictionaryValue();
+      dict->SetString(name, value);
+      params->reset(dict);
+      return true;
+    }
+    case NetLogBinaryWriter::PARAMS_SOURCE: {
+      std::string name;
+      uint64 type;
+      uint64 id;
+      if (!reader->ReadString(&name) || !reader->ReadVarint(&type) ||
+          !reader->ReadVarint(&id)) {
+        return false;
+      }
+      DictionaryValue* dict = new DictionaryValue();
+      dict->Set(name, SourceToValue(type, id));
+      params->reset(dict);
+      return true;
+    }
+    case NetLogBinaryWriter::PARAMS_JSON: {
+      std::string json;
+      if (!reader->ReadString(&json))
+        return false;
+      params->reset(base::JSONReader::Read(json, false));
+      return params->get() != NULL;
+    }
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+// static
+const char NetLogBinaryWriter::kMagic[] = "NetLog\x01";
+
+NetLogBinaryWriter::NetLogBinaryWriter()
+    : wrote_magic_(false),
+      last_source_id_(0) {
+}
+
+NetLogBinaryWriter::~NetLogBinaryWriter() {}
+
+void NetLogBinaryWriter::AppendEntry(NetLog::EventType type,
+                                     const base::TimeTicks& time,
+                                     const NetLog::Source& source,
+                                     NetLog::EventPhase phase,
+                                     NetLog::EventParameters* params,
+                                     std::string* output) {
+  if (!wrote_magic_) {
+    output->append(kMagic);
+    wrote_magic_ = true;
+  }
+
+  size_t type_index = static_cast<size_t>(type);
+  if (type_index >= wrote_event_type_.size())
+    wrote_event_type_.resize(type_index + 1);
+  if (!wrote_event_type_[type_index]) {
+    output->push_back(TAG_EVENT_TYPE);
+    AppendVarint(type_index, output);
+    AppendString(NetLog::EventTypeToString(type), output);
+    wrote_event_type_[type_index] = true;
+  }
+
+  size_t source_type_index = static_cast<size_t>(source.type);
+  if (source_type_index >= wrote_source_type_.size())
+    wrote_source_type_.resize(source_type_index + 1);
+  if (!wrote_source_type_[source_type_index]) {
+    output->push_back(TAG_SOURCE_TYPE);
+    AppendVarint(source_type_index, output);
+    AppendString(NetLog::SourceTypeToString(source.type), output);
+    wrote_source_type_[source_type_index] = true;
+  }
+
+  output->push_back(TAG_ENTRY);
+  AppendVarint(type_index, output);
+  AppendVarint(source_type_index, output);
+  AppendSignedVarint(static_cast<int32>(source.id - last_source_id_), output);
+  AppendSignedVarint((time - last_time_).InMicroseconds(), output);
+  output->push_back(static_cast<char>(phase));
+  if (params) {
+    params->AppendToBinaryLog(output);
+  } else {
+    output->push_back(PARAMS_NONE);
+  }
+
+  last_source_id_ = source.id;
+  last_time_ = time;
+}
+
+// static
+void NetLogBinaryWriter::AppendIntegerParameter(const char* name, int value,
+                                                std::string* output) {
+  output->push_back(PARAMS_INTEGER);
+  AppendString(name, output);
+  AppendSignedVarint(value, output);
+}
+
+// static
+void NetLogBinaryWriter::AppendStringParameter(const char* name,
+                                               const std::string& value,
+                                               std::string* output) {
+  output->push_back(PARAMS_STRING);
+  AppendString(name, output);
+  AppendString(value, output);
+}
+
+// static
+void NetLogBinaryWriter::AppendSourceParameter(const char* name,
+                                               const NetLog::Source& value,
+                                               std::string* output) {
+  output->push_back(PARAMS_SOURCE);
+  AppendString(name, output);
+  AppendVarint(static_cast<uint64>(value.type), output);
+  AppendVarint(value.id, output);
+}
+
+// static
+void NetLogBinaryWriter::AppendValueParameters(const Value* value,
+                                               std::string* output) {
+  if (!value) {
+    output->push_back(PARAMS_NONE);
+    return;
+  }
+  std::string json;
+  base::JSONWriter::Write(value, false, &json);
+  output->push_back(PARAMS_JSON);
+  AppendString(json, output);
+}
+
+bool ConvertNetLogBinaryToJSON(const std::string& data, std::string* json) {
+  json->clear();
+
+  size_t magic_length = strlen(NetLogBinaryWriter::kMagic);
+  if (data.compare(0, magic_length, NetLogBinaryWriter::kMagic) != 0)
+    return false;
+  BinaryReader reader(data, magic_length);
+
+  std::map<uint64, std::string> event_types;
+  std::map<uint64, std::string> source_types;
+  uint32 source_id = 0;
+  int64 time = 0;
+
+  while (!reader.AtEnd()) {
+    uint8 tag;
+    if (!reader.ReadByte(&tag))
+      return false;
+
+    switch (tag) {
+      case NetLogBinaryWriter::TAG_EVENT_TYPE:
+      case NetLogBinaryWriter::TAG_SOURCE_TYPE: {
+        uint64 type;
+        std::string name;
+        if (!reader.ReadVarint(&type) || !reader.ReadString(&name))
+          return false;
+        if (tag == NetLogBinaryWriter::TAG_EVENT_TYPE) {
+          event_types[type] = name;
+        } else {
+          source_types[type] = name;
+        }
+        break;
+      }
+      case NetLogBinaryWriter::TAG_ENTRY: {
+        uint64 type;
+        uint64 source_type;
+        int64 source_id_delta;
+        int64 time_delta;
+        uint8 phase;
+        scoped_ptr<Value> params;
+        if (!reader.ReadVarint(&type) || !reader.ReadVarint(&source_type) ||
+            !reader.ReadSignedVarint(&source_id_delta) ||
+            !reader.ReadSignedVarint(&time_delta) ||
+            !reader.ReadByte(&phase) ||
+            !ReadParameters(&reader, &params)) {
+          return false;
+        }
+        if (!event_types.count(type) || !source_types.count(source_type))
+          return false;
+        if (phase != NetLog::PHASE_NONE && phase != NetLog::PHASE_BEGIN &&
+            phase != NetLog::PHASE_END) {
+          return false;
+        }
+        source_id += static_cast<uint32>(source_id_delta);
+        time += time_delta;
+
+        // Build the same dictionary as NetLog::EntryToDictionaryValue().
+        DictionaryValue entry_dict;
+        entry_dict.SetString(
+            "time",
+            base::Int64ToString(
+                base::TimeDelta::FromMicroseconds(time).InMilliseconds()));
+        DictionaryValue* source_dict = new DictionaryValue();
+        source_dict->SetInteger("id", source_id);
+        source_dict->SetString("type", source_types[source_type]);
+        entry_dict.Set("source", source_dict);
+        entry_dict.SetString("type", event_types[type]);
+        entry_dict.SetString(
+            "phase", NetLog::EventPhaseToString(
+                static_cast<NetLog::EventPhase>(phase)));
+        if (params.get())
+          entry_dict.Set("params", params.release());
+
+        std::string line;
+        base::JSONWriter::Write(&entry_dict, false, &line);
+        json->append(line);
+        json->push_back('\n');
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace net
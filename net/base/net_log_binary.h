@@ -0,0 +1,109 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_BASE_NET_LOG_BINARY_H_
+#define NET_BASE_NET_LOG_BINARY_H_
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/time.h"
+#include "net/base/net_log.h"
+
+class Value;
+
+namespace net {
+
+// NetLogBinaryWriter encodes NetLog entries in a compact binary format, for
+// capturing long traces.  Converting every entry to JSON text, as
+// NetLogLogger does, is too slow and too large for that.
+//
+// A log starts with kMagic, followed by records, each starting with a tag:
+//
+//   TAG_EVENT_TYPE   varint type, string name
+//   TAG_SOURCE_TYPE  varint type, string name
+//   TAG_ENTRY        varint event type, varint source type,
+//                    signed varint source id delta,
+//                    signed varint time delta in microseconds,
+//                    byte phase, parameters
+//
+// The names of event and source types are written once, before the first
+// entry which uses them, so that logs stay readable by other versions.
+// Source ids and times are written as the difference from the entry
+// before.  Parameters start with a PARAMS_* byte:
+//
+//   PARAMS_NONE
+//   PARAMS_INTEGER   string name, signed varint value
+//   PARAMS_STRING    string name, string value
+//   PARAMS_SOURCE    string name, varint source type, varint source id
+//   PARAMS_JSON      string JSON
+//
+// Varints are little endian base 128, signed ones zigzag encoded first.
+// Strings are a varint length followed by the bytes.
+//
+// The format of the common parameters is written without building Values;
+// other parameters are written as the JSON of their ToValue().
+class NetLogBinaryWriter {
+ public:
+  static const char kMagic[];
+
+  enum Tag {
+    TAG_EVENT_TYPE = 1,
+    TAG_SOURCE_TYPE = 2,
+    TAG_ENTRY = 3,
+  };
+
+  enum ParamsTag {
+    PARAMS_NONE = 0,
+    PARAMS_INTEGER = 1,
+    PARAMS_STRING = 2,
+    PARAMS_SOURCE = 3,
+    PARAMS_JSON = 4,
+  };
+
+  NetLogBinaryWriter();
+  ~NetLogBinaryWriter();
+
+  // Appends the encoding of an entry to |output|, after kMagic if it is the
+  // first one.  Not thread safe.
+  void AppendEntry(NetLog::EventType type,
+                   const base::TimeTicks& time,
+                   const NetLog::Source& source,
+                   NetLog::EventPhase phase,
+                   NetLog::EventParameters* params,
+                   std::string* output);
+
+  // Used by EventParameters::AppendToBinaryLog() to write parameters.
+  static void AppendIntegerParameter(const char* name, int value,
+                                     std::string* output);
+  static void AppendStringParameter(const char* name,
+                                    const std::string& value,
+                                    std::string* output);
+  static void AppendSourceParameter(const char* name,
+                                    const NetLog::Source& value,
+                                    std::string* output);
+  static void AppendValueParameters(const Value* value, std::string* output);
+
+ private:
+  bool wrote_magic_;
+  std::vector<bool> wrote_event_type_;
+  std::vector<bool> wrote_source_type_;
+
+  uint32 last_source_id_;
+  base::TimeTicks last_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(NetLogBinaryWriter);
+};
+
+// Converts a log written by NetLogBinaryWriter to the format written by
+// NetLogLogger: the JSON of NetLog::EntryToDictionaryValue(), with strings,
+// for each entry, one per line.  Returns false if |data| isn't a valid log,
+// in which case |json| holds the entries before the error.
+bool ConvertNetLogBinaryToJSON(const std::string& data, std::string* json);
+
+}  // namespace net
+
+#endif  // NET_BASE_NET_LOG_BINARY_H_
@@ -0,0 +1,146 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/net_log_binary.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/json/json_writer.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// Parameters without a binary encoding of their own.
+class DictionaryParameters : public NetLog::EventParameters {
+ public:
+  virtual Value* ToValue() const {
+    DictionaryValue* dict = new DictionaryValue();
+    dict->SetString("host", "www.google.com");
+    ListValue* list = new ListValue();
+    list->Append(Value::CreateIntegerValue(1));
+    list->Append(Value::CreateBooleanValue(false));
+    dict->Set("list", list);
+    return dict;
+  }
+};
+
+struct TestEntry {
+  NetLog::EventType type;
+  int64 time_us;
+  NetLog::Source source;
+  NetLog::EventPhase phase;
+  scoped_refptr<NetLog::EventParameters> params;
+};
+
+// The line NetLogLogger writes for |entry|.
+std::string GetExpectedJSON(const TestEntry& entry) {
+  scoped_ptr<Value> value(NetLog::EntryToDictionaryValue(
+      entry.type,
+      base::TimeTicks() + base::TimeDelta::FromMicroseconds(entry.time_us),
+      entry.source, entry.phase, entry.params, true));
+  std::string json;
+  base::JSONWriter::Write(value.get(), false, &json);
+  return json + "\n";
+}
+
+TEST(NetLogBinaryTest, ConvertToJSON) {
+  const TestEntry kEntries[] = {
+    { NetLog::TYPE_REQUEST_ALIVE, 1000000,
+      NetLog::Source(NetLog::SOURCE_URL_REQUEST, 5), NetLog::PHASE_BEGIN,
+      NULL },
+    { NetLog::TYPE_SOCKET_ALIVE, 1000999,
+      NetLog::Source(NetLog::SOURCE_SOCKET, 2), NetLog::PHASE_BEGIN,
+      new NetLogSourceParameter(
+          "source_dependency",
+          NetLog::Source(NetLog::SOURCE_CONNECT_JOB, 12345)) },
+    // Times may go back when events come from several threads.
+    { NetLog::TYPE_CANCELLED, 999000,
+      NetLog::Source(NetLog::SOURCE_URL_REQUEST, 5), NetLog::PHASE_NONE,
+      new NetLogStringParameter("url", "http://www.google.com/\xe2\x82\xac") },
+    { NetLog::TYPE_REQUEST_ALIVE, 3000000000LL,
+      NetLog::Source(NetLog::SOURCE_URL_REQUEST, 5), NetLog::PHASE_END,
+      new NetLogIntegerParameter("net_error", -3) },
+    { NetLog::TYPE_SOCKET_ALIVE, 3000000001LL,
+      NetLog::Source(NetLog::SOURCE_SOCKET, 2), NetLog::PHASE_END,
+      new DictionaryParameters() },
+  };
+
+  NetLogBinaryWriter writer;
+  std::string binary;
+  std::string expected_json;
+  for (size_t i = 0; i < arraysize(kEntries); ++i) {
+    const TestEntry& entry = kEntries[i];
+    writer.AppendEntry(
+        entry.type,
+        base::TimeTicks() + base::TimeDelta::FromMicroseconds(entry.time_us),
+        entry.source, entry.phase, entry.params, &binary);
+    expected_json += GetExpectedJSON(entry);
+  }
+
+  std::string json;
+  EXPECT_TRUE(ConvertNetLogBinaryToJSON(binary, &json));
+  EXPECT_EQ(expected_json, json);
+
+  // Even with the names of all the types, the log is smaller than its JSON.
+  EXPECT_LT(binary.size() * 2, json.size());
+}
+
+TEST(NetLogBinaryTest, TypesWrittenOnce) {
+  NetLogBinaryWriter writer;
+  NetLog::Source source(NetLog::SOURCE_URL_REQUEST, 1);
+  std::string first;
+  writer.AppendEntry(NetLog::TYPE_REQUEST_ALIVE, base::TimeTicks(), source,
+                     NetLog::PHASE_BEGIN, NULL, &first);
+  std::string second;
+  writer.AppendEntry(NetLog::TYPE_REQUEST_ALIVE, base::TimeTicks(), source,
+                     NetLog::PHASE_END, NULL, &second);
+
+  // Tag, event type, source type, source id, time, phase and parameters.
+  EXPECT_EQ(7u, second.size());
+  EXPECT_LT(second.size() + strlen(NetLogBinaryWriter::kMagic), first.size());
+
+  std::string json;
+  EXPECT_TRUE(ConvertNetLogBinaryToJSON(first + second, &json));
+  EXPECT_EQ(2, std::count(json.begin(), json.end(), '\n'));
+}
+
+TEST(NetLogBinaryTest, InvalidData) {
+  std::string json;
+  EXPECT_FALSE(ConvertNetLogBinaryToJSON("", &json));
+  EXPECT_FALSE(ConvertNetLogBinaryToJSON("not a log", &json));
+  EXPECT_TRUE(ConvertNetLogBinaryToJSON(NetLogBinaryWriter::kMagic, &json));
+  EXPECT_EQ("", json);
+
+  NetLogBinaryWriter writer;
+  std::string binary;
+  NetLog::Source source(NetLog::SOURCE_URL_REQUEST, 1);
+  writer.AppendEntry(NetLog::TYPE_REQUEST_ALIVE, base::TimeTicks(), source,
+                     NetLog::PHASE_BEGIN,
+                     new NetLogStringParameter("url", "http://www.google.com/"),
+                     &binary);
+  writer.AppendEntry(NetLog::TYPE_REQUEST_ALIVE, base::TimeTicks(), source,
+                     NetLog::PHASE_END, NULL, &binary);
+  std::string full_json;
+  EXPECT_TRUE(ConvertNetLogBinaryToJSON(binary, &full_json));
+
+  // A log cut short keeps the entries before the cut.
+  EXPECT_FALSE(ConvertNetLogBinaryToJSON(binary.substr(0, binary.size() - 1),
+                                         &json));
+  EXPECT_EQ(full_json.substr(0, full_json.find('\n') + 1), json);
+
+  // An entry whose event type wasn't written before is invalid.
+  std::string entry_only(NetLogBinaryWriter::kMagic);
+  entry_only.append(binary, binary.size() - 7, 7);
+  EXPECT_FALSE(ConvertNetLogBinaryToJSON(entry_only, &json));
+}
+
+}  // namespace
+
+}  // namespace net
@@ -51,6 +51,16 @@ EVENT_TYPE(HOST_RESOLVER_IMPL_REQUEST)
 // This event is logged when a request is handled by a cache entry.
 EVENT_TYPE(HOST_RESOLVER_IMPL_CACHE_HIT)
 
+// This event is logged when a request is handled by a cache entry that has
+// expired, but is still within the cache's stale grace period.  A background
+// request is started to refresh the entry.
+//
+// The following parameters are attached:
+//   {
+//     "stale_ms": <How long ago the entry expired, in milliseconds>,
+//   }
+EVENT_TYPE(HOST_RESOLVER_IMPL_STALE_CACHE_HIT)
+
 // This event means a request was queued/dequeued for subsequent job creation,
 // because there are already too many active HostResolverImpl::Jobs.
 //
@@ -59,6 +69,13 @@ EVENT_TYPE(HOST_RESOLVER_IMPL_CACHE_HIT)
 //   {
 //     "priority": <Priority of the queued request>,
 //   }
+//
+// The END phase contains the following parameters, unless the request was
+// cancelled or evicted:
+//
+//   {
+//     "queue_ms": <How long the request waited, in milliseconds>,
+//   }
 EVENT_TYPE(HOST_RESOLVER_IMPL_JOB_POOL_QUEUE)
 
 // This event is created when a new HostResolverImpl::Request is evicted from
@@ -262,6 +279,19 @@ EVENT_TYPE(TCP_CONNECT)
 //   }
 EVENT_TYPE(TCP_CONNECT_ATTEMPT)
 
+// A sample of the kernel's TCP_INFO for a connected socket, taken when the
+// connect completes, when the first byte is read, when the end of the stream
+// is read and when the socket is closed.  Only logged when all events are
+// being captured.
+//   {
+//     "point": <"connect", "first_byte", "end_of_stream" or "close">,
+//     "rtt_us": <Smoothed round trip time, in microseconds>,
+//     "rtt_variance_us": <Mean deviation of the round trip time>,
+//     "congestion_window": <Send congestion window, in segments>,
+//     "total_retransmits": <Segments retransmitted on this connection>,
+//   }
+EVENT_TYPE(TCP_INFO)
+
 // The start/end of a TCP connect(). This corresponds with a call to
 // TCPServerSocket::Accept().
 //
@@ -417,6 +447,27 @@ EVENT_TYPE(CONNECT_JOB_SET_SOCKET)
 // Whether the connect job timed out.
 EVENT_TYPE(SOCKET_POOL_CONNECT_JOB_TIMED_OUT)
 
+// ------------------------------------------------------------------------
+// TransportConnectJob
+// ------------------------------------------------------------------------
+
+// The connect to the first address was slow, so a connect to the first address
+// of the other family was started to race against it.  The parameters are:
+//
+//   {
+//     "address_family": <"ipv4" or "ipv6", the family of the new connect>,
+//   }
+EVENT_TYPE(TRANSPORT_CONNECT_JOB_FALLBACK_STARTED)
+
+// One of the raced connects of a TransportConnectJob has finished.  The
+// parameters are:
+//
+//   {
+//     "address_family": <"ipv4" or "ipv6">,
+//     "net_error": <The net error code of the connect>,
+//   }
+EVENT_TYPE(TRANSPORT_CONNECT_JOB_ATTEMPT_DONE)
+
 // ------------------------------------------------------------------------
 // ClientSocketPoolBaseHelper
 // ------------------------------------------------------------------------
@@ -430,6 +481,10 @@ EVENT_TYPE(SOCKET_POOL_STALLED_MAX_SOCKETS)
 // The request stalled because there are too many sockets in the group.
 EVENT_TYPE(SOCKET_POOL_STALLED_MAX_SOCKETS_PER_GROUP)
 
+// The IDLE priority request stalled because requests of higher priorities are
+// waiting for sockets.
+EVENT_TYPE(SOCKET_POOL_STALLED_IDLE_PRIORITY)
+
 // Indicates that we reused an existing socket. Attached to the event are
 // the parameters:
 //   {
@@ -437,6 +492,13 @@ EVENT_TYPE(SOCKET_POOL_STALLED_MAX_SOCKETS_PER_GROUP)
 //   }
 EVENT_TYPE(SOCKET_POOL_REUSED_AN_EXISTING_SOCKET)
 
+// Logged on a socket put on an idle list by a socket pool, when the socket
+// freed buffers it doesn't need while idle. The event parameters are:
+//   {
+//     "bytes": <The number of bytes of buffers freed>,
+//   }
+EVENT_TYPE(SOCKET_POOL_RELEASED_IDLE_BUFFERS)
+
 // This event simply describes the host:port that were requested from the
 // socket pool. Its parameters are:
 //   {
@@ -543,6 +605,31 @@ EVENT_TYPE(HTTP_CACHE_WRITE_INFO)
 EVENT_TYPE(HTTP_CACHE_READ_DATA)
 EVENT_TYPE(HTTP_CACHE_WRITE_DATA)
 
+// Emitted when a stale response is used while it is validated in the
+// background. The event parameters are:
+//   {
+//      "source_dependency": <Source identifier for the validation>,
+//   }
+EVENT_TYPE(HTTP_CACHE_STALE_WHILE_REVALIDATE)
+
+// Emitted on a SPDY session when the cache claims a pushed stream to store
+// it. The event parameters are:
+//   {
+//      "source_dependency": <Source identifier for the background request>,
+//   }
+EVENT_TYPE(HTTP_CACHE_ADOPT_PUSHED_STREAM)
+
+// Measures the time taken by the background validation of a response. The
+// BEGIN phase contains the following parameters:
+//   {
+//      "url": <The URL being validated>,
+//   }
+EVENT_TYPE(HTTP_CACHE_ASYNC_VALIDATION)
+
+// This event is sent when a transaction starts reading a response that another
+// transaction is still writing to the cache.
+EVENT_TYPE(HTTP_CACHE_JOIN_WRITER)
+
 // ------------------------------------------------------------------------
 // Disk Cache / Memory Cache
 // ------------------------------------------------------------------------
@@ -645,6 +732,14 @@ EVENT_TYPE(HTTP_STREAM_JOB)
 //   }
 EVENT_TYPE(HTTP_STREAM_REQUEST_BOUND_TO_JOB)
 
+// Logged by a Job whose connection to the first proxy in its list was slow,
+// when it starts another Job to race the rest of the list. The event
+// parameters are:
+//   {
+//      "source_dependency": <Source identifier for the racing job>,
+//   }
+EVENT_TYPE(HTTP_STREAM_JOB_RACE_PROXY_FALLBACK)
+
 // ------------------------------------------------------------------------
 // HttpNetworkTransaction
 // ------------------------------------------------------------------------
@@ -708,6 +803,11 @@ EVENT_TYPE(HTTP_TRANSACTION_DRAIN_BODY_FOR_AUTH_RESTART)
 //     "host": <The host-port string>,
 //     "proxy": <The Proxy PAC string>,
 //   }
+//
+// The END phase has these parameters:
+//   {
+//     "compression_memory": <Estimated bytes used by the zlib streams>,
+//   }
 EVENT_TYPE(SPDY_SESSION)
 
 // This event is sent for a SPDY SYN_STREAM.
@@ -839,6 +939,21 @@ EVENT_TYPE(SPDY_SESSION_CLOSE)
 // the maximum number of concurrent streams.
 EVENT_TYPE(SPDY_SESSION_STALLED_MAX_STREAMS)
 
+// Statistics of the write queue, logged when the session goes away. Only the
+// priorities that wrote frames are listed.
+//   {
+//     "priorities": [
+//       {
+//         "priority": <The priority level>,
+//         "frames": <Number of frames written>,
+//         "average_delay_ms": <Average time spent in the queue>,
+//         "max_delay_ms": <Longest time spent in the queue>,
+//       },
+//       ...
+//     ]
+//   }
+EVENT_TYPE(SPDY_SESSION_WRITE_QUEUE_STATS)
+
 // ------------------------------------------------------------------------
 // SpdySessionPool
 // ------------------------------------------------------------------------
@@ -874,6 +989,14 @@ EVENT_TYPE(SPDY_SESSION_POOL_IMPORTED_SESSION_FROM_SOCKET)
 //   }
 EVENT_TYPE(SPDY_SESSION_POOL_REMOVE_SESSION)
 
+// This event is logged on a session when the pool hands it to a different
+// origin that shares its IP address and certificate.
+//   {
+//     "host": <The host:port that uses this session>,
+//     "source_dependency": <The source of the request>,
+//   }
+EVENT_TYPE(SPDY_SESSION_POOLED_ORIGIN)
+
 // ------------------------------------------------------------------------
 // SpdyStream
 // ------------------------------------------------------------------------
@@ -900,6 +1023,12 @@ EVENT_TYPE(SPDY_STREAM_SEND_WINDOW_UPDATE)
 //   }
 EVENT_TYPE(SPDY_STREAM_RECV_WINDOW_UPDATE)
 
+// Auto-tuning grew the receive window of a stream.
+//   {
+//     "window_size": <The new receive window size>,
+//   }
+EVENT_TYPE(SPDY_STREAM_RECV_WINDOW_TUNED)
+
 // ------------------------------------------------------------------------
 // HttpStreamParser
 // ------------------------------------------------------------------------
@@ -950,6 +1079,13 @@ EVENT_TYPE(WEB_SOCKET_SEND_REQUEST_HEADERS)
 //   }
 EVENT_TYPE(WEB_SOCKET_READ_RESPONSE_HEADERS)
 
+// This event is sent when several messages are sent in one write.
+// The following parameters are attached:
+//   {
+//     "messages": <number of messages in the write>,
+//   }
+EVENT_TYPE(WEB_SOCKET_SEND_COALESCED)
+
 // ------------------------------------------------------------------------
 // SOCKS5ClientSocket
 // ------------------------------------------------------------------------
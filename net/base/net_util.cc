@@ -13,6 +13,7 @@
 #include <unicode/uset.h>
 #include <algorithm>
 #include <iterator>
+#include <list>
 #include <map>
 
 #include "build/build_config.h"
@@ -691,6 +692,118 @@ bool IsIDNComponentSafe(const char16* str,
   return false;
 }
 
+// Converts |comp|, an IDN component starting with "xn--", to Unicode in |out|.
+// Returns false, leaving |out| empty, if the conversion fails or the result is
+// unsafe to display.
+bool IDNToUnicodeOneComponentUncached(const char16* comp,
+                                      size_t comp_len,
+                                      const std::wstring& languages,
+                                      string16* out) {
+  DCHECK(out->empty());
+  // Repeatedly expand the output string until it's big enough.  It looks like
+  // ICU will return the required size of the buffer, but that's not
+  // documented, so we'll just grow by 2x. This should be rare and is not on a
+  // critical path.
+  for (int extra_space = 64; ; extra_space *= 2) {
+    UErrorCode status = U_ZERO_ERROR;
+    out->resize(extra_space);
+    int output_chars = uidna_IDNToUnicode(comp,
+        static_cast<int32_t>(comp_len), &(*out)[0], extra_space,
+        UIDNA_DEFAULT, NULL, &status);
+    if (status == U_ZERO_ERROR) {
+      // Converted successfully.
+      out->resize(output_chars);
+      if (IsIDNComponentSafe(out->data(), output_chars, languages))
+        return true;
+    }
+
+    if (status != U_BUFFER_OVERFLOW_ERROR)
+      break;
+  }
+  // Failed, revert back to original string.
+  out->clear();
+  return false;
+}
+
+// Remembers the display form of the most recently converted IDN components,
+// since the omnibox, history and downloads format the same hosts over and
+// over, and the ICU decoding and the script checks dominate the cost of
+// formatting them.  Entries are keyed by the languages too, so a change of the
+// accept languages simply stops hitting the old ones, which then age out.
+class IDNComponentCache {
+ public:
+  static IDNComponentCache* GetInstance() {
+    return Singleton<IDNComponentCache>::get();
+  }
+
+  // Returns true and fills |converted| and |unicode| if |comp| has been looked
+  // up for |languages| before.  |unicode| is only set when |converted| is.
+  bool Lookup(const string16& comp,
+              const std::wstring& languages,
+              bool* converted,
+              string16* unicode) {
+    base::AutoLock lock(lock_);
+    EntryMap::iterator it = index_.find(Key(languages, comp));
+    if (it == index_.end())
+      return false;
+
+    // Move the entry to the back, as the most recently used.
+    entries_.splice(entries_.end(), entries_, it->second);
+    *converted = it->second->converted;
+    if (*converted)
+      *unicode = it->second->unicode;
+    return true;
+  }
+
+  void Insert(const string16& comp,
+              const std::wstring& languages,
+              bool converted,
+              const string16& unicode) {
+    base::AutoLock lock(lock_);
+    Key key(languages, comp);
+    if (index_.find(key) != index_.end())
+      return;
+
+    if (entries_.size() >= kMaxEntries) {
+      index_.erase(entries_.front().key);
+      entries_.pop_front();
+    }
+    Entry entry;
+    entry.key = key;
+    entry.converted = converted;
+    if (converted)
+      entry.unicode = unicode;
+    entries_.push_back(entry);
+    index_[key] = --entries_.end();
+  }
+
+ private:
+  typedef std::pair<std::wstring, string16> Key;
+  struct Entry {
+    Key key;
+    bool converted;
+    string16 unicode;
+  };
+  typedef std::list<Entry> EntryList;
+  typedef std::map<Key, EntryList::iterator> EntryMap;
+
+  static const size_t kMaxEntries = 512;
+
+  IDNComponentCache() {}
+
+  friend class Singleton<IDNComponentCache>;
+  friend struct DefaultSingletonTraits<IDNComponentCache>;
+
+  // We're called from both the UI thread and the history thread.
+  base::Lock lock_;
+
+  // Least recently used first.
+  EntryList entries_;
+  EntryMap index_;
+
+  DISALLOW_COPY_AND_ASSIGN(IDNComponentCache);
+};
+
 // Converts one component of a host (between dots) to IDN if safe. The result
 // will be APPENDED to the given output string and will be the same as the input
 // if it is not IDN or the IDN is unsafe to display.  Returns whether any
@@ -707,34 +820,23 @@ bool IDNToUnicodeOneComponent(const char16* comp,
   static const char16 kIdnPrefix[] = {'x', 'n', '-', '-'};
   if ((comp_len > arraysize(kIdnPrefix)) &&
       !memcmp(comp, kIdnPrefix, arraysize(kIdnPrefix) * sizeof(char16))) {
-    // Repeatedly expand the output string until it's big enough.  It looks like
-    // ICU will return the required size of the buffer, but that's not
-    // documented, so we'll just grow by 2x. This should be rare and is not on a
-    // critical path.
-    size_t original_length = out->length();
-    for (int extra_space = 64; ; extra_space *= 2) {
-      UErrorCode status = U_ZERO_ERROR;
-      out->resize(out->length() + extra_space);
-      int output_chars = uidna_IDNToUnicode(comp,
-          static_cast<int32_t>(comp_len), &(*out)[original_length], extra_space,
-          UIDNA_DEFAULT, NULL, &status);
-      if (status == U_ZERO_ERROR) {
-        // Converted successfully.
-        out->resize(original_length + output_chars);
-        if (IsIDNComponentSafe(out->data() + original_length, output_chars,
-                               languages))
-          return true;
-      }
-
-      if (status != U_BUFFER_OVERFLOW_ERROR)
-        break;
+    IDNComponentCache* cache = IDNComponentCache::GetInstance();
+    const string16 comp_string(comp, comp_len);
+    bool converted;
+    string16 unicode;
+    if (cache->Lookup(comp_string, languages, &converted, &unicode)) {
+      out->append(converted ? unicode : comp_string);
+      return converted;
     }
-    // Failed, revert back to original string.
-    out->resize(original_length);
+
+    converted = IDNToUnicodeOneComponentUncached(comp, comp_len, languages,
+                                                 &unicode);
+    cache->Insert(comp_string, languages, converted, unicode);
+    out->append(converted ? unicode : comp_string);
+    return converted;
   }
 
-  // We get here with no IDN or on error, in which case we just append the
-  // literal input.
+  // We get here with no IDN, in which case we just append the literal input.
   out->append(comp, comp_len);
   return false;
 }
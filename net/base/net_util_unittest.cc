@@ -967,6 +967,22 @@ TEST(NetUtilTest, IDNToUnicodeSlow) {
   }
 }
 
+// Converted components are cached per languages; repeating the conversions, with
+// the languages changing in between, must give the same results.
+TEST(NetUtilTest, IDNToUnicodeRepeated) {
+  for (int pass = 0; pass < 2; ++pass) {
+    for (size_t j = 0; j < arraysize(kLanguages); j++) {
+      for (size_t i = 0; i < ARRAYSIZE_UNSAFE(idn_cases); i++) {
+        std::wstring output(IDNToUnicode(idn_cases[i].input,
+            strlen(idn_cases[i].input), kLanguages[j], NULL));
+        std::wstring expected(idn_cases[i].unicode_allowed[j] ?
+            idn_cases[i].unicode_output : ASCIIToWide(idn_cases[i].input));
+        EXPECT_EQ(expected, output) << kLanguages[j];
+      }
+    }
+  }
+}
+
 TEST(NetUtilTest, IDNToUnicodeAdjustOffset) {
   const AdjustOffsetCase adjust_cases[] = {
     {0, 0},
@@ -29,6 +29,20 @@ class MockNetworkChangeNotifier : public NetworkChangeNotifier {
 
 }  // namespace
 
+NetworkChangeNotifier::IPAddressChange::IPAddressChange()
+    : addresses_changed(true),
+      interface_index(-1),
+      default_route_changed(true),
+      default_route_interface_index(-1),
+      dns_changed(true) {
+}
+
+void NetworkChangeNotifier::IPAddressObserver::OnIPAddressChangedWithDetails(
+    const IPAddressChange& change) {
+  if (change.addresses_changed || change.default_route_changed)
+    OnIPAddressChanged();
+}
+
 NetworkChangeNotifier::~NetworkChangeNotifier() {
   DCHECK_EQ(this, g_network_change_notifier);
   g_network_change_notifier = NULL;
@@ -99,9 +113,14 @@ NetworkChangeNotifier::NetworkChangeNotifier()
 }
 
 void NetworkChangeNotifier::NotifyObserversOfIPAddressChange() {
+  NotifyObserversOfIPAddressChange(IPAddressChange());
+}
+
+void NetworkChangeNotifier::NotifyObserversOfIPAddressChange(
+    const IPAddressChange& change) {
   if (g_network_change_notifier) {
     g_network_change_notifier->ip_address_observer_list_->Notify(
-        &IPAddressObserver::OnIPAddressChanged);
+        &IPAddressObserver::OnIPAddressChangedWithDetails, change);
   }
 }
 
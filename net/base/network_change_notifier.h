@@ -17,6 +17,33 @@ namespace net {
 // and will be called back on the thread from which they registered.
 class NET_EXPORT NetworkChangeNotifier {
  public:
+  // Describes an IP address change, as far as the platform implementation
+  // can tell. The default describes a change nothing is known about, which
+  // may have affected the addresses, the default route and the DNS
+  // configuration alike.
+  struct NET_EXPORT IPAddressChange {
+    IPAddressChange();
+
+    // True if the addresses of some interface may have changed.
+    bool addresses_changed;
+
+    // The interface whose addresses changed, or -1 if it isn't known or
+    // several interfaces changed.
+    int interface_index;
+
+    // True if the IPv4 default route may have been added, removed or moved
+    // to another interface.
+    bool default_route_changed;
+
+    // The interface the default route goes through after the change, or -1
+    // if there is none or it isn't known. Only meaningful when
+    // |default_route_changed| is true.
+    int default_route_interface_index;
+
+    // True if the DNS configuration of the system may have changed.
+    bool dns_changed;
+  };
+
   class NET_EXPORT IPAddressObserver {
    public:
     virtual ~IPAddressObserver() {}
@@ -25,6 +52,13 @@ class NET_EXPORT NetworkChangeNotifier {
     // This includes when the primary interface itself changes.
     virtual void OnIPAddressChanged() = 0;
 
+    // Called instead of OnIPAddressChanged() by the notifiers, with what is
+    // known about the change. Observers that can scope their reaction to the
+    // change override this; by default, changes of the addresses or of the
+    // default route call OnIPAddressChanged(), and changes of only the DNS
+    // configuration are ignored.
+    virtual void OnIPAddressChangedWithDetails(const IPAddressChange& change);
+
    protected:
     IPAddressObserver() {}
 
@@ -99,6 +133,10 @@ class NET_EXPORT NetworkChangeNotifier {
   static void NotifyObserversOfIPAddressChangeForTests() {
     NotifyObserversOfIPAddressChange();
   }
+  static void NotifyObserversOfIPAddressChangeForTests(
+      const IPAddressChange& change) {
+    NotifyObserversOfIPAddressChange(change);
+  }
 #endif
 
  protected:
@@ -108,6 +146,7 @@ class NET_EXPORT NetworkChangeNotifier {
   // happens asynchronously, even for observers on the current thread, even in
   // tests.
   static void NotifyObserversOfIPAddressChange();
+  static void NotifyObserversOfIPAddressChange(const IPAddressChange& change);
   void NotifyObserversOfOnlineStateChange();
 
  private:
@@ -9,6 +9,8 @@
 
 #include "base/compiler_specific.h"
 #include "base/eintr_wrapper.h"
+#include "base/file_path.h"
+#include "base/files/file_path_watcher.h"
 #include "base/task.h"
 #include "base/threading/thread.h"
 #include "net/base/net_errors.h"
@@ -20,6 +22,9 @@ namespace {
 
 const int kInvalidSocket = -1;
 
+const FilePath::CharType kResolvConfPath[] =
+    FILE_PATH_LITERAL("/etc/resolv.conf");
+
 }  // namespace
 
 class NetworkChangeNotifierLinux::Thread
@@ -38,10 +43,22 @@ class NetworkChangeNotifierLinux::Thread
   virtual void CleanUp();
 
  private:
-  void NotifyObserversOfIPAddressChange() {
-    NetworkChangeNotifier::NotifyObserversOfIPAddressChange();
+  // Tells the observers when resolv.conf changes.
+  class DNSWatchDelegate : public base::files::FilePathWatcher::Delegate {
+   public:
+    virtual void OnFilePathChanged(const FilePath& path);
+  };
+
+  void NotifyObserversOfIPAddressChange(
+      const NetworkChangeNotifier::IPAddressChange& change) {
+    NetworkChangeNotifier::NotifyObserversOfIPAddressChange(change);
   }
 
+  // Turns what the netlink messages said into the change to tell the
+  // observers about.  Returns false if there is nothing to tell.
+  bool GetIPAddressChange(const NetlinkChange& netlink_change,
+                          NetworkChangeNotifier::IPAddressChange* change);
+
   // Starts listening for netlink messages.  Also handles the messages if there
   // are any available on the netlink socket.
   void ListenForNotifications();
@@ -55,6 +72,12 @@ class NetworkChangeNotifierLinux::Thread
   int netlink_fd_;
   MessageLoopForIO::FileDescriptorWatcher netlink_watcher_;
 
+  // The interface of the IPv4 default route, as of the last netlink message
+  // about it, or -1 if there is none or no message was received yet.
+  int default_route_interface_index_;
+
+  scoped_ptr<base::files::FilePathWatcher> resolv_conf_watcher_;
+
   // Technically only needed for ChromeOS, but it's ugly to #ifdef out.
   ScopedRunnableMethodFactory<Thread> method_factory_;
 
@@ -64,11 +87,19 @@ class NetworkChangeNotifierLinux::Thread
 NetworkChangeNotifierLinux::Thread::Thread()
     : base::Thread("NetworkChangeNotifier"),
       netlink_fd_(kInvalidSocket),
+      default_route_interface_index_(-1),
       ALLOW_THIS_IN_INITIALIZER_LIST(method_factory_(this)) {}
 
 NetworkChangeNotifierLinux::Thread::~Thread() {}
 
 void NetworkChangeNotifierLinux::Thread::Init() {
+  resolv_conf_watcher_.reset(new base::files::FilePathWatcher);
+  if (!resolv_conf_watcher_->Watch(FilePath(kResolvConfPath),
+                                   new DNSWatchDelegate)) {
+    LOG(ERROR) << "Failed to watch " << kResolvConfPath;
+    resolv_conf_watcher_.reset();
+  }
+
   netlink_fd_ = InitializeNetlinkSocket();
   if (netlink_fd_ < 0) {
     netlink_fd_ = kInvalidSocket;
@@ -78,6 +109,7 @@ void NetworkChangeNotifierLinux::Thread::Init() {
 }
 
 void NetworkChangeNotifierLinux::Thread::CleanUp() {
+  resolv_conf_watcher_.reset();
   if (netlink_fd_ != kInvalidSocket) {
     if (HANDLE_EINTR(close(netlink_fd_)) != 0)
       PLOG(ERROR) << "Failed to close socket";
@@ -100,7 +132,10 @@ void NetworkChangeNotifierLinux::Thread::ListenForNotifications() {
   char buf[4096];
   int rv = ReadNotificationMessage(buf, arraysize(buf));
   while (rv > 0) {
-    if (HandleNetlinkMessage(buf, rv)) {
+    NetlinkChange netlink_change;
+    NetworkChangeNotifier::IPAddressChange change;
+    if (HandleNetlinkMessage(buf, rv, &netlink_change) &&
+        GetIPAddressChange(netlink_change, &change)) {
       VLOG(1) << "Detected IP address changes.";
 #if defined(OS_CHROMEOS)
       // TODO(oshima): chromium-os:8285 - introduced artificial delay to
@@ -111,10 +146,10 @@ void NetworkChangeNotifierLinux::Thread::ListenForNotifications() {
       message_loop()->PostDelayedTask(
           FROM_HERE,
           method_factory_.NewRunnableMethod(
-              &Thread::NotifyObserversOfIPAddressChange),
+              &Thread::NotifyObserversOfIPAddressChange, change),
           kObserverNotificationDelayMS);
 #else
-      NotifyObserversOfIPAddressChange();
+      NotifyObserversOfIPAddressChange(change);
 #endif
     }
     rv = ReadNotificationMessage(buf, arraysize(buf));
@@ -127,6 +162,27 @@ void NetworkChangeNotifierLinux::Thread::ListenForNotifications() {
   }
 }
 
+bool NetworkChangeNotifierLinux::Thread::GetIPAddressChange(
+    const NetlinkChange& netlink_change,
+    NetworkChangeNotifier::IPAddressChange* change) {
+  change->addresses_changed = netlink_change.addresses_changed;
+  change->interface_index = netlink_change.interface_index;
+  // The default route is reported again when it is refreshed, which only
+  // counts as a change if it moved.
+  change->default_route_changed =
+      netlink_change.saw_default_route &&
+      netlink_change.default_route_interface_index !=
+          default_route_interface_index_;
+  if (change->default_route_changed) {
+    default_route_interface_index_ =
+        netlink_change.default_route_interface_index;
+  }
+  change->default_route_interface_index = default_route_interface_index_;
+  // resolv.conf is watched separately.
+  change->dns_changed = false;
+  return change->addresses_changed || change->default_route_changed;
+}
+
 int NetworkChangeNotifierLinux::Thread::ReadNotificationMessage(
     char* buf,
     size_t len) {
@@ -146,6 +202,15 @@ int NetworkChangeNotifierLinux::Thread::ReadNotificationMessage(
   return ERR_IO_PENDING;
 }
 
+void NetworkChangeNotifierLinux::Thread::DNSWatchDelegate::OnFilePathChanged(
+    const FilePath& path) {
+  VLOG(1) << "Detected DNS configuration changes.";
+  NetworkChangeNotifier::IPAddressChange change;
+  change.addresses_changed = false;
+  change.default_route_changed = false;
+  NetworkChangeNotifier::NotifyObserversOfIPAddressChange(change);
+}
+
 NetworkChangeNotifierLinux::NetworkChangeNotifierLinux()
     : notifier_thread_(new Thread) {
   // We create this notifier thread because the notification implementation
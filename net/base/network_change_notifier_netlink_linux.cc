@@ -55,8 +55,51 @@ bool IsDuplicateIPv6AddressUpdate(
   return false;
 }
 
+// Returns the output interface of the route in |netlink_message_header|, or -1
+// if it has none.
+int GetRouteInterfaceIndex(const struct nlmsghdr* netlink_message_header) {
+  const struct rtmsg* route_message =
+      reinterpret_cast<struct rtmsg*>(NLMSG_DATA(netlink_message_header));
+  int route_message_length = RTM_PAYLOAD(netlink_message_header);
+  const struct rtattr* route_attribute =
+      reinterpret_cast<struct rtattr*>(RTM_RTA(route_message));
+  while (RTA_OK(route_attribute, route_message_length)) {
+    if (route_attribute->rta_type == RTA_OIF)
+      return *reinterpret_cast<int*>(RTA_DATA(route_attribute));
+    route_attribute = RTA_NEXT(route_attribute, route_message_length);
+  }
+  return -1;
+}
+
+bool IsIPv4DefaultRoute(const struct nlmsghdr* netlink_message_header) {
+  const struct rtmsg* route_message =
+      reinterpret_cast<struct rtmsg*>(NLMSG_DATA(netlink_message_header));
+  return route_message->rtm_family == AF_INET &&
+         route_message->rtm_dst_len == 0 &&
+         route_message->rtm_table == RT_TABLE_MAIN;
+}
+
+void AddAddressChange(const struct nlmsghdr* netlink_message_header,
+                      NetlinkChange* change) {
+  const struct ifaddrmsg* address_message =
+      reinterpret_cast<struct ifaddrmsg*>(NLMSG_DATA(netlink_message_header));
+  int interface_index = static_cast<int>(address_message->ifa_index);
+  if (!change->addresses_changed)
+    change->interface_index = interface_index;
+  else if (change->interface_index != interface_index)
+    change->interface_index = -1;
+  change->addresses_changed = true;
+}
+
 }  // namespace
 
+NetlinkChange::NetlinkChange()
+    : addresses_changed(false),
+      interface_index(-1),
+      saw_default_route(false),
+      default_route_interface_index(-1) {
+}
+
 int InitializeNetlinkSocket() {
   int sock = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
   if (sock < 0) {
@@ -76,7 +119,7 @@ int InitializeNetlinkSocket() {
   local_addr.nl_family = AF_NETLINK;
   local_addr.nl_pid = getpid();
   local_addr.nl_groups = RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR |
-                         RTMGRP_NOTIFY;
+                         RTMGRP_IPV4_ROUTE | RTMGRP_NOTIFY;
   int ret = bind(sock, reinterpret_cast<struct sockaddr*>(&local_addr),
                  sizeof(local_addr));
   if (ret < 0) {
@@ -89,10 +132,12 @@ int InitializeNetlinkSocket() {
   return sock;
 }
 
-bool HandleNetlinkMessage(char* buf, size_t len) {
+bool HandleNetlinkMessage(char* buf, size_t len, NetlinkChange* change) {
   const struct nlmsghdr* netlink_message_header =
       reinterpret_cast<struct nlmsghdr*>(buf);
   DCHECK(netlink_message_header);
+  DCHECK(change);
+  bool detected = false;
   for (; NLMSG_OK(netlink_message_header, len);
        netlink_message_header = NLMSG_NEXT(netlink_message_header, len)) {
     int netlink_message_type = netlink_message_header->nlmsg_type;
@@ -100,10 +145,10 @@ bool HandleNetlinkMessage(char* buf, size_t len) {
       case NLMSG_DONE:
         NOTREACHED()
             << "This is a monitoring netlink socket.  It should never be done.";
-        return false;
+        return detected;
       case NLMSG_ERROR:
         LOG(ERROR) << "Unexpected netlink error.";
-        return false;
+        return detected;
       // During IP address changes, we will see all these messages.  Only fire
       // the notification when we get a new address or remove an address.  We
       // may still end up notifying observers more than strictly necessary, but
@@ -111,19 +156,35 @@ bool HandleNetlinkMessage(char* buf, size_t len) {
       case RTM_NEWADDR:
         if (IsIPv6Update(netlink_message_header) &&
             IsDuplicateIPv6AddressUpdate(netlink_message_header))
-          return false;
-        return true;
+          break;
+        AddAddressChange(netlink_message_header, change);
+        detected = true;
+        break;
       case RTM_DELADDR:
-        return true;
+        AddAddressChange(netlink_message_header, change);
+        detected = true;
+        break;
+      // Only the IPv4 default route is followed; the other routes come and go
+      // without saying much about which network is in use.
+      case RTM_NEWROUTE:
+      case RTM_DELROUTE:
+        if (!IsIPv4DefaultRoute(netlink_message_header))
+          break;
+        change->saw_default_route = true;
+        change->default_route_interface_index =
+            netlink_message_type == RTM_NEWROUTE ?
+                GetRouteInterfaceIndex(netlink_message_header) : -1;
+        detected = true;
+        break;
       case RTM_NEWLINK:
       case RTM_DELLINK:
-        return false;
+        break;
       default:
         LOG(DFATAL) << "Received unexpected netlink message type: "
                     << netlink_message_type;
-        return false;
+        break;
     }
   }
 
-  return false;
+  return detected;
 }
@@ -12,10 +12,28 @@
 
 #include <cstddef>
 
+// What a buffer of netlink messages says about the network.
+struct NetlinkChange {
+  NetlinkChange();
+
+  // True if addresses were added to or removed from an interface.
+  bool addresses_changed;
+
+  // The interface whose addresses changed, or -1 if several did.
+  int interface_index;
+
+  // True if a message was about the IPv4 default route of the main table.
+  bool saw_default_route;
+
+  // The interface of that route after the message, or -1 if it was removed.
+  int default_route_interface_index;
+};
+
 // Returns the file descriptor if successful.  Otherwise, returns -1.
 int InitializeNetlinkSocket();
 
 // Returns true if a network change has been detected, otherwise returns false.
-bool HandleNetlinkMessage(char* buf, size_t len);
+// The detected changes are added to |change|.
+bool HandleNetlinkMessage(char* buf, size_t len, NetlinkChange* change);
 
 #endif  // NET_BASE_NETWORK_CHANGE_NOTIFIER_NETLINK_LINUX_H_
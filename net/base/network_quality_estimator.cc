@@ -0,0 +1,166 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/network_quality_estimator.h"
+
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+
+namespace net {
+
+namespace {
+
+base::LazyInstance<NetworkQualityEstimator,
+                   base::LeakyLazyInstanceTraits<NetworkQualityEstimator> >
+    g_network_quality_estimator(base::LINKER_INITIALIZED);
+
+double AddToAverage(double average, int samples, double sample,
+                    double weight) {
+  if (samples == 0)
+    return sample;
+  return average + weight * (sample - average);
+}
+
+base::TimeDelta AddToAverage(const base::TimeDelta& average, int samples,
+                             const base::TimeDelta& sample, double weight) {
+  return base::TimeDelta::FromMicroseconds(static_cast<int64>(AddToAverage(
+      static_cast<double>(average.InMicroseconds()), samples,
+      static_cast<double>(sample.InMicroseconds()), weight)));
+}
+
+}  // namespace
+
+NetworkQualityEstimator::Quality::Quality()
+    : throughput_kbps(0.0),
+      throughput_samples(0),
+      rtt_samples(0),
+      connect_time_samples(0) {
+}
+
+// static
+const int NetworkQualityEstimator::kUnknownNetwork = -1;
+
+// static
+const size_t NetworkQualityEstimator::kMaxNetworks = 10;
+
+// static
+const double NetworkQualityEstimator::kThroughputWeight = 0.25;
+
+// static
+const double NetworkQualityEstimator::kRTTWeight = 0.125;
+
+// static
+const double NetworkQualityEstimator::kConnectTimeWeight = 0.125;
+
+NetworkQualityEstimator::NetworkQualityEstimator()
+    : current_network_(kUnknownNetwork) {
+  NetworkChangeNotifier::AddIPAddressObserver(this);
+}
+
+NetworkQualityEstimator::~NetworkQualityEstimator() {
+  NetworkChangeNotifier::RemoveIPAddressObserver(this);
+}
+
+// static
+NetworkQualityEstimator* NetworkQualityEstimator::GetInstance() {
+  return g_network_quality_estimator.Pointer();
+}
+
+void NetworkQualityEstimator::AddThroughputSample(double kbps) {
+  DCHECK_GE(kbps, 0.0);
+  base::AutoLock lock(lock_);
+  Quality* quality = GetCurrentQualityLocked();
+  quality->throughput_kbps = AddToAverage(
+      quality->throughput_kbps, quality->throughput_samples, kbps,
+      kThroughputWeight);
+  ++quality->throughput_samples;
+  quality->last_sample_time = base::TimeTicks::Now();
+}
+
+void NetworkQualityEstimator::AddRTTSample(const base::TimeDelta& rtt) {
+  base::AutoLock lock(lock_);
+  Quality* quality = GetCurrentQualityLocked();
+  quality->rtt = AddToAverage(quality->rtt, quality->rtt_samples, rtt,
+                              kRTTWeight);
+  ++quality->rtt_samples;
+  quality->last_sample_time = base::TimeTicks::Now();
+}
+
+void NetworkQualityEstimator::AddConnectTimeSample(
+    const base::TimeDelta& connect_time) {
+  base::AutoLock lock(lock_);
+  Quality* quality = GetCurrentQualityLocked();
+  quality->connect_time = AddToAverage(
+      quality->connect_time, quality->connect_time_samples, connect_time,
+      kConnectTimeWeight);
+  ++quality->connect_time_samples;
+  quality->last_sample_time = base::TimeTicks::Now();
+}
+
+bool NetworkQualityEstimator::GetCurrentQuality(Quality* quality) const {
+  base::AutoLock lock(lock_);
+  QualityMap::const_iterator it = qualities_.find(current_network_);
+  if (it == qualities_.end())
+    return false;
+  *quality = it->second;
+  return true;
+}
+
+int NetworkQualityEstimator::current_network() const {
+  base::AutoLock lock(lock_);
+  return current_network_;
+}
+
+void NetworkQualityEstimator::OnIPAddressChanged() {
+  OnIPAddressChangedWithDetails(NetworkChangeNotifier::IPAddressChange());
+}
+
+void NetworkQualityEstimator::OnIPAddressChangedWithDetails(
+    const NetworkChangeNotifier::IPAddressChange& change) {
+  base::AutoLock lock(lock_);
+  if (change.default_route_changed) {
+    current_network_ = change.default_route_interface_index >= 0 ?
+        change.default_route_interface_index : kUnknownNetwork;
+    // There is no telling which network an unknown one is.
+    if (current_network_ == kUnknownNetwork) {
+      ResetCurrentNetworkLocked();
+      return;
+    }
+  }
+
+  // New addresses on the interface mean it may have joined another network,
+  // say another wireless one.
+  if (change.addresses_changed &&
+      (change.interface_index < 0 ||
+       change.interface_index == current_network_)) {
+    ResetCurrentNetworkLocked();
+  }
+}
+
+NetworkQualityEstimator::Quality*
+NetworkQualityEstimator::GetCurrentQualityLocked() {
+  lock_.AssertAcquired();
+  QualityMap::iterator it = qualities_.find(current_network_);
+  if (it != qualities_.end())
+    return &it->second;
+
+  // Make room by forgetting the network measured least recently.
+  if (qualities_.size() >= kMaxNetworks) {
+    QualityMap::iterator oldest = qualities_.begin();
+    for (QualityMap::iterator it = qualities_.begin();
+         it != qualities_.end(); ++it) {
+      if (it->second.last_sample_time < oldest->second.last_sample_time)
+        oldest = it;
+    }
+    qualities_.erase(oldest);
+  }
+  return &qualities_[current_network_];
+}
+
+void NetworkQualityEstimator::ResetCurrentNetworkLocked() {
+  lock_.AssertAcquired();
+  qualities_.erase(current_network_);
+}
+
+}  // namespace net
@@ -0,0 +1,112 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_BASE_NETWORK_QUALITY_ESTIMATOR_H_
+#define NET_BASE_NETWORK_QUALITY_ESTIMATOR_H_
+#pragma once
+
+#include <map>
+
+#include "base/basictypes.h"
+#include "base/synchronization/lock.h"
+#include "base/time.h"
+#include "net/base/net_export.h"
+#include "net/base/network_change_notifier.h"
+
+namespace net {
+
+// NetworkQualityEstimator keeps running estimates of the throughput, round
+// trip time and TCP connect time of the network the machine is on, from
+// samples reported by the network stack: the throughput of completed
+// transfers (BandwidthMetrics), the duration of TCP connects
+// (TransportConnectJob) and the TCP_INFO round trip time of sockets given
+// back to their pool (ClientSocketHandle).
+//
+// The estimates are exponentially weighted moving averages, so that they
+// follow the link as it changes.  They are kept for each network, keyed by
+// the interface the default route goes through, so that moving back to a
+// network brings back what was measured there.  A change of the addresses of
+// the current network forgets its estimates.
+//
+// All methods may be called on any thread.
+class NET_EXPORT NetworkQualityEstimator
+    : public NetworkChangeNotifier::IPAddressObserver {
+ public:
+  struct NET_EXPORT Quality {
+    Quality();
+
+    // Throughput of transfers, in kilobits per second.
+    double throughput_kbps;
+    int throughput_samples;
+
+    // Round trip time reported by TCP.
+    base::TimeDelta rtt;
+    int rtt_samples;
+
+    // Time from starting a TCP connect to it completing.
+    base::TimeDelta connect_time;
+    int connect_time_samples;
+
+    // When the last sample of any kind was added.
+    base::TimeTicks last_sample_time;
+  };
+
+  // The key of the network when the interface of the default route isn't
+  // known.
+  static const int kUnknownNetwork;
+
+  // The most networks whose estimates are kept.
+  static const size_t kMaxNetworks;
+
+  // The weights of a new sample in the moving averages.
+  static const double kThroughputWeight;
+  static const double kRTTWeight;
+  static const double kConnectTimeWeight;
+
+  // Registers with the NetworkChangeNotifier, if there is one.
+  NetworkQualityEstimator();
+  virtual ~NetworkQualityEstimator();
+
+  // The estimator the network stack reports samples to.  It is never
+  // deleted.
+  static NetworkQualityEstimator* GetInstance();
+
+  void AddThroughputSample(double kbps);
+  void AddRTTSample(const base::TimeDelta& rtt);
+  void AddConnectTimeSample(const base::TimeDelta& connect_time);
+
+  // Fills |quality| with the estimates for the current network.  Returns
+  // false if nothing was measured on it yet.  Check the sample counts before
+  // using each estimate.
+  bool GetCurrentQuality(Quality* quality) const;
+
+  // The key of the current network: the index of the interface the default
+  // route goes through, or kUnknownNetwork.
+  int current_network() const;
+
+  // NetworkChangeNotifier::IPAddressObserver methods:
+  virtual void OnIPAddressChanged();
+  virtual void OnIPAddressChangedWithDetails(
+      const NetworkChangeNotifier::IPAddressChange& change);
+
+ private:
+  typedef std::map<int, Quality> QualityMap;
+
+  // Returns the estimates of the current network, adding them if needed.
+  // |lock_| must be held.
+  Quality* GetCurrentQualityLocked();
+
+  // Forgets the estimates of the current network.  |lock_| must be held.
+  void ResetCurrentNetworkLocked();
+
+  mutable base::Lock lock_;
+  int current_network_;
+  QualityMap qualities_;
+
+  DISALLOW_COPY_AND_ASSIGN(NetworkQualityEstimator);
+};
+
+}  // namespace net
+
+#endif  // NET_BASE_NETWORK_QUALITY_ESTIMATOR_H_
@@ -0,0 +1,125 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/network_quality_estimator.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+NetworkChangeNotifier::IPAddressChange DefaultRouteChange(int index) {
+  NetworkChangeNotifier::IPAddressChange change;
+  change.addresses_changed = false;
+  change.default_route_changed = true;
+  change.default_route_interface_index = index;
+  change.dns_changed = false;
+  return change;
+}
+
+NetworkChangeNotifier::IPAddressChange AddressChange(int index) {
+  NetworkChangeNotifier::IPAddressChange change;
+  change.addresses_changed = true;
+  change.interface_index = index;
+  change.default_route_changed = false;
+  change.dns_changed = false;
+  return change;
+}
+
+TEST(NetworkQualityEstimatorTest, MovingAverages) {
+  NetworkQualityEstimator estimator;
+  NetworkQualityEstimator::Quality quality;
+  EXPECT_FALSE(estimator.GetCurrentQuality(&quality));
+
+  // The first sample is taken as it is.
+  estimator.AddThroughputSample(1000.0);
+  ASSERT_TRUE(estimator.GetCurrentQuality(&quality));
+  EXPECT_EQ(1, quality.throughput_samples);
+  EXPECT_DOUBLE_EQ(1000.0, quality.throughput_kbps);
+  EXPECT_EQ(0, quality.rtt_samples);
+  EXPECT_EQ(0, quality.connect_time_samples);
+
+  estimator.AddThroughputSample(2000.0);
+  ASSERT_TRUE(estimator.GetCurrentQuality(&quality));
+  EXPECT_EQ(2, quality.throughput_samples);
+  EXPECT_DOUBLE_EQ(1250.0, quality.throughput_kbps);
+
+  estimator.AddRTTSample(base::TimeDelta::FromMilliseconds(100));
+  estimator.AddRTTSample(base::TimeDelta::FromMilliseconds(180));
+  estimator.AddConnectTimeSample(base::TimeDelta::FromMilliseconds(80));
+  ASSERT_TRUE(estimator.GetCurrentQuality(&quality));
+  EXPECT_EQ(2, quality.rtt_samples);
+  EXPECT_EQ(110, quality.rtt.InMilliseconds());
+  EXPECT_EQ(1, quality.connect_time_samples);
+  EXPECT_EQ(80, quality.connect_time.InMilliseconds());
+}
+
+TEST(NetworkQualityEstimatorTest, AddressChangeResets) {
+  NetworkQualityEstimator estimator;
+  estimator.OnIPAddressChangedWithDetails(DefaultRouteChange(2));
+  EXPECT_EQ(2, estimator.current_network());
+  estimator.AddThroughputSample(1000.0);
+
+  // Another interface changing doesn't affect the estimates.
+  NetworkQualityEstimator::Quality quality;
+  estimator.OnIPAddressChangedWithDetails(AddressChange(3));
+  EXPECT_TRUE(estimator.GetCurrentQuality(&quality));
+
+  estimator.OnIPAddressChangedWithDetails(AddressChange(2));
+  EXPECT_FALSE(estimator.GetCurrentQuality(&quality));
+
+  // Nor does a change of only the DNS configuration.
+  estimator.AddThroughputSample(1000.0);
+  NetworkChangeNotifier::IPAddressChange dns_change;
+  dns_change.addresses_changed = false;
+  dns_change.default_route_changed = false;
+  estimator.OnIPAddressChangedWithDetails(dns_change);
+  EXPECT_TRUE(estimator.GetCurrentQuality(&quality));
+
+  // A change nothing is known about does.
+  estimator.OnIPAddressChanged();
+  EXPECT_EQ(NetworkQualityEstimator::kUnknownNetwork,
+            estimator.current_network());
+  EXPECT_FALSE(estimator.GetCurrentQuality(&quality));
+}
+
+TEST(NetworkQualityEstimatorTest, KeptPerNetwork) {
+  NetworkQualityEstimator estimator;
+  estimator.OnIPAddressChangedWithDetails(DefaultRouteChange(2));
+  estimator.AddThroughputSample(1000.0);
+
+  estimator.OnIPAddressChangedWithDetails(DefaultRouteChange(3));
+  NetworkQualityEstimator::Quality quality;
+  EXPECT_FALSE(estimator.GetCurrentQuality(&quality));
+  estimator.AddThroughputSample(50.0);
+
+  estimator.OnIPAddressChangedWithDetails(DefaultRouteChange(2));
+  ASSERT_TRUE(estimator.GetCurrentQuality(&quality));
+  EXPECT_DOUBLE_EQ(1000.0, quality.throughput_kbps);
+
+  estimator.OnIPAddressChangedWithDetails(DefaultRouteChange(3));
+  ASSERT_TRUE(estimator.GetCurrentQuality(&quality));
+  EXPECT_DOUBLE_EQ(50.0, quality.throughput_kbps);
+}
+
+TEST(NetworkQualityEstimatorTest, NetworksAreBounded) {
+  NetworkQualityEstimator estimator;
+  for (size_t i = 0; i <= NetworkQualityEstimator::kMaxNetworks; ++i) {
+    estimator.OnIPAddressChangedWithDetails(
+        DefaultRouteChange(static_cast<int>(i)));
+    estimator.AddRTTSample(base::TimeDelta::FromMilliseconds(10));
+  }
+
+  // The network measured first was forgotten to make room for the last.
+  NetworkQualityEstimator::Quality quality;
+  estimator.OnIPAddressChangedWithDetails(DefaultRouteChange(1));
+  EXPECT_TRUE(estimator.GetCurrentQuality(&quality));
+  estimator.OnIPAddressChangedWithDetails(DefaultRouteChange(0));
+  EXPECT_FALSE(estimator.GetCurrentQuality(&quality));
+}
+
+}  // namespace
+
+}  // namespace net
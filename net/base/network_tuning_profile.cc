@@ -0,0 +1,94 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/network_tuning_profile.h"
+
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "base/synchronization/lock.h"
+
+namespace net {
+
+namespace {
+
+class CurrentProfile {
+ public:
+  NetworkTuningProfile Get() {
+    base::AutoLock lock(lock_);
+    return profile_;
+  }
+
+  void Set(const NetworkTuningProfile& profile) {
+    base::AutoLock lock(lock_);
+    profile_ = profile;
+  }
+
+ private:
+  base::Lock lock_;
+  NetworkTuningProfile profile_;
+};
+
+base::LazyInstance<CurrentProfile,
+                   base::LeakyLazyInstanceTraits<CurrentProfile> >
+    g_current_profile(base::LINKER_INITIALIZED);
+
+}  // namespace
+
+NetworkTuningProfile::NetworkTuningProfile()
+    : connection_type(CONNECTION_UNKNOWN),
+      max_sockets_per_group(6),
+      max_sockets_per_proxy_server(32),
+      connect_timeout(base::TimeDelta::FromMinutes(4)),
+      max_preconnects_per_host(6),
+      spdy_connection_at_risk_of_loss(base::TimeDelta::FromSeconds(10)),
+      spdy_hung_interval(base::TimeDelta::FromSeconds(10)) {
+}
+
+// static
+NetworkTuningProfile NetworkTuningProfile::ForConnectionType(
+    ConnectionType type) {
+  NetworkTuningProfile profile;
+  profile.connection_type = type;
+  switch (type) {
+    case CONNECTION_UNKNOWN:
+    case CONNECTION_NONE:
+      break;
+    case CONNECTION_ETHERNET:
+    case CONNECTION_WIFI:
+    case CONNECTION_4G:
+      profile.connect_timeout = base::TimeDelta::FromMinutes(1);
+      break;
+    case CONNECTION_3G:
+      profile.connect_timeout = base::TimeDelta::FromMinutes(2);
+      profile.max_preconnects_per_host = 2;
+      profile.spdy_connection_at_risk_of_loss =
+          base::TimeDelta::FromSeconds(30);
+      profile.spdy_hung_interval = base::TimeDelta::FromSeconds(20);
+      break;
+    case CONNECTION_2G:
+      profile.max_sockets_per_group = 4;
+      profile.max_sockets_per_proxy_server = 16;
+      profile.max_preconnects_per_host = 1;
+      profile.spdy_connection_at_risk_of_loss =
+          base::TimeDelta::FromSeconds(60);
+      profile.spdy_hung_interval = base::TimeDelta::FromSeconds(30);
+      break;
+    default:
+      NOTREACHED();
+      break;
+  }
+  return profile;
+}
+
+// static
+NetworkTuningProfile NetworkTuningProfile::GetCurrent() {
+  return g_current_profile.Get().Get();
+}
+
+// static
+void NetworkTuningProfile::SetCurrent(const NetworkTuningProfile& profile) {
+  g_current_profile.Get().Set(profile);
+}
+
+}  // namespace net
@@ -0,0 +1,63 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_BASE_NETWORK_TUNING_PROFILE_H_
+#define NET_BASE_NETWORK_TUNING_PROFILE_H_
+#pragma once
+
+#include "base/time.h"
+#include "net/base/net_export.h"
+
+namespace net {
+
+// The limits and timeouts the network stack uses on one kind of connection.
+// Slow radios get fewer parallel connections and speculative connections,
+// which only compete for the little bandwidth there is, and fewer SPDY
+// pings, each of which wakes the radio up.  Fast links fail connects sooner,
+// so that another address or a retry gets its turn.
+//
+// NetworkTuner applies a profile to the stack.  The profile for
+// CONNECTION_UNKNOWN is the stack's defaults.
+struct NET_EXPORT NetworkTuningProfile {
+  enum ConnectionType {
+    CONNECTION_UNKNOWN,
+    CONNECTION_ETHERNET,
+    CONNECTION_WIFI,
+    CONNECTION_2G,
+    CONNECTION_3G,
+    CONNECTION_4G,
+    CONNECTION_NONE,
+  };
+
+  // The profile for CONNECTION_UNKNOWN.
+  NetworkTuningProfile();
+
+  static NetworkTuningProfile ForConnectionType(ConnectionType type);
+
+  // The profile last given to SetCurrent(), or the default one.  May be
+  // called on any thread.
+  static NetworkTuningProfile GetCurrent();
+  static void SetCurrent(const NetworkTuningProfile& profile);
+
+  ConnectionType connection_type;
+
+  // See ClientSocketPoolManager.
+  int max_sockets_per_group;
+  int max_sockets_per_proxy_server;
+
+  // The time allowed to resolve and connect a TransportConnectJob.
+  base::TimeDelta connect_timeout;
+
+  // The most connections the Predictor opens to a host ahead of use.
+  int max_preconnects_per_host;
+
+  // How long a SPDY session may be idle before a PING checks it is alive,
+  // and how long the PING may go unanswered.  See SpdySession.
+  base::TimeDelta spdy_connection_at_risk_of_loss;
+  base::TimeDelta spdy_hung_interval;
+};
+
+}  // namespace net
+
+#endif  // NET_BASE_NETWORK_TUNING_PROFILE_H_
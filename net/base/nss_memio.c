@@ -67,6 +67,14 @@ static void memio_buffer_new(struct memio_buffer *mb, int size);
 /* Deallocate a memio_buffer allocated by memio_buffer_new. */
 static void memio_buffer_destroy(struct memio_buffer *mb);
 
+/* Free the storage of an empty buffer; see memio_ReleaseBuffers.
+ * Returns the number of bytes freed. */
+static int memio_buffer_release(struct memio_buffer *mb);
+
+/* Allocate the storage of a released buffer again, before putting
+ * bytes into it. */
+static void memio_buffer_ensure(struct memio_buffer *mb);
+
 /* How many bytes can be read out of the buffer without wrapping */
 static int memio_buffer_used_contiguous(const struct memio_buffer *mb);
 
@@ -100,6 +108,23 @@ static void memio_buffer_destroy(struct memio_buffer *mb)
     mb->tail = 0;
 }
 
+static int memio_buffer_release(struct memio_buffer *mb)
+{
+    if (!mb->buf || mb->head != mb->tail)
+        return 0;
+    free(mb->buf);
+    mb->buf = NULL;
+    mb->head = 0;
+    mb->tail = 0;
+    return mb->bufsize;
+}
+
+static void memio_buffer_ensure(struct memio_buffer *mb)
+{
+    if (!mb->buf)
+        mb->buf = malloc(mb->bufsize);
+}
+
 /* How many bytes can be read out of the buffer without wrapping */
 static int memio_buffer_used_contiguous(const struct memio_buffer *mb)
 {
@@ -254,6 +279,7 @@ static int PR_CALLBACK memio_Send(PRFileDesc *fd, const void *buf, PRInt32 len,
         PR_SetError(mb->last_err, 0);
         return -1;
     }
+    memio_buffer_ensure(mb);
     rv = memio_buffer_put(mb, buf, len);
     if (rv == 0) {
         PR_SetError(PR_WOULD_BLOCK_ERROR, 0);
@@ -387,6 +413,7 @@ int memio_GetReadParams(memio_Private *secret, char **buf)
     struct memio_buffer* mb = &((PRFilePrivate *)secret)->readbuf;
     PR_ASSERT(mb->bufsize);
 
+    memio_buffer_ensure(mb);
     *buf = &mb->buf[mb->tail];
     return memio_buffer_unused_contiguous(mb);
 }
@@ -435,6 +462,13 @@ void memio_PutWriteResult(memio_Private *secret, int bytes_written)
     }
 }
 
+int memio_ReleaseBuffers(memio_Private *secret)
+{
+    struct PRFilePrivate *priv = (PRFilePrivate *)secret;
+    return memio_buffer_release(&priv->readbuf) +
+           memio_buffer_release(&priv->writebuf);
+}
+
 /*--------------- private memio_buffer self-test -----------------*/
 
 /* Even a trivial unit test is very helpful when doing circular buffers. */
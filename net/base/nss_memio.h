@@ -83,6 +83,13 @@ void memio_GetWriteParams(memio_Private *secret,
  */
 void memio_PutWriteResult(memio_Private *secret, int bytes_written);
 
+/* Free the storage of the buffers that are empty, for instance while the
+ * connection is idle.  They are allocated again when bytes have to be put
+ * into them.
+ * Returns the number of bytes freed.
+ */
+int memio_ReleaseBuffers(memio_Private *secret);
+
 
 #ifdef __cplusplus
 }
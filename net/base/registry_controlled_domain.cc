@@ -47,17 +47,81 @@
 #include "net/base/net_module.h"
 #include "net/base/net_util.h"
 
-#include "effective_tld_names.cc"
-
 namespace net {
 
 namespace {
 
+#include "effective_tld_names.cc"
+
 const int kExceptionRule = 1;
 const int kWildcardRule = 2;
 
 RegistryControlledDomainService* test_instance_;
 
+// Reads an offset in |graph|, which is stored in three bytes.
+size_t ReadOffset(const unsigned char* graph, size_t pos) {
+  return (graph[pos] << 16) | (graph[pos + 1] << 8) | graph[pos + 2];
+}
+
+// Returns the offset of the edge of |node| that starts with |c|, or
+// std::string::npos if there is none.  The edge index of a node is sorted by
+// first character, so this is a binary search.
+size_t FindEdge(const unsigned char* graph, size_t node, unsigned char c) {
+  const size_t index = node + 2;
+  size_t low = 0;
+  size_t high = graph[node + 1];
+  while (low < high) {
+    const size_t mid = (low + high) / 2;
+    const unsigned char mid_char = graph[index + 4 * mid];
+    if (mid_char == c)
+      return ReadOffset(graph, index + 4 * mid + 1);
+    if (mid_char < c)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return std::string::npos;
+}
+
+// Walks |graph| (see make_dafsa.py) from the end of host[begin, end), and
+// returns where the longest suffix that starts at a label boundary and has a
+// rule begins, setting |*rule_type| to that rule's type.  Returns
+// std::string::npos if no suffix has a rule.
+size_t FindLongestRule(const unsigned char* graph,
+                       const std::string& host,
+                       size_t begin,
+                       size_t end,
+                       int* rule_type) {
+  size_t match = std::string::npos;
+  size_t node = 0;
+  size_t pos = end;  // host[pos, end) has been matched.
+  while (true) {
+    if (graph[node] && (pos == begin || host[pos - 1] == '.')) {
+      match = pos;
+      *rule_type = graph[node] - 1;
+    }
+    if (pos == begin)
+      return match;
+
+    // No two edges start with the same character, so at most one can match.
+    const size_t edge = FindEdge(graph, node,
+                                 base::ToLowerASCII(host[pos - 1]));
+    if (edge == std::string::npos)
+      return match;
+
+    const size_t label_length = graph[edge];
+    if (label_length > pos - begin)
+      return match;
+    for (size_t j = 1; j < label_length; ++j) {
+      if (graph[edge + 1 + j] !=
+          static_cast<unsigned char>(base::ToLowerASCII(host[pos - 1 - j])))
+        return match;
+    }
+    pos -= label_length;
+    node = ReadOffset(graph, edge + 1 + label_length);
+  }
+}
+
 }  // namespace
 
 // static
@@ -166,7 +230,7 @@ RegistryControlledDomainService* RegistryControlledDomainService::GetInstance()
 }
 
 RegistryControlledDomainService::RegistryControlledDomainService()
-    : find_domain_function_(Perfect_Hash::FindDomain) {
+    : graph_(kDafsa) {
 }
 
 // static
@@ -178,10 +242,10 @@ RegistryControlledDomainService* RegistryControlledDomainService::SetInstance(
 }
 
 // static
-void RegistryControlledDomainService::UseFindDomainFunction(
-    FindDomainPtr function) {
+void RegistryControlledDomainService::UseDomainGraph(
+    const unsigned char* graph) {
   RegistryControlledDomainService* instance = GetInstance();
-  instance->find_domain_function_ = function;
+  instance->graph_ = graph;
 }
 
 // static
@@ -233,62 +297,52 @@ size_t RegistryControlledDomainService::GetRegistryLengthImpl(
       return 0;  // Multiple trailing dots.
   }
 
-  // Walk up the domain tree, most specific to least specific,
-  // looking for matches at each level.
-  size_t prev_start = std::string::npos;
-  size_t curr_start = host_check_begin;
-  size_t next_dot = host.find('.', curr_start);
-  if (next_dot >= host_check_len)  // Catches std::string::npos as well.
+  if (host.find('.', host_check_begin) >= host_check_len)
     return 0;  // This can't have a registry + domain.
-  while (1) {
-    const char* domain_str = host.data() + curr_start;
-    int domain_length = host_check_len - curr_start;
-    const DomainRule* rule = find_domain_function_(domain_str, domain_length);
-
-    // We need to compare the string after finding a match because the
-    // no-collisions of perfect hashing only refers to items in the set.  Since
-    // we're searching for arbitrary domains, there could be collisions.
-    if (rule &&
-        base::strncasecmp(domain_str, rule->name, domain_length) == 0) {
-      // Exception rules override wildcard rules when the domain is an exact
-      // match, but wildcards take precedence when there's a subdomain.
-      if (rule->type == kWildcardRule && (prev_start != std::string::npos)) {
-        // If prev_start == host_check_begin, then the host is the registry
-        // itself, so return 0.
-        return (prev_start == host_check_begin) ?
-            0 : (host.length() - prev_start);
-      }
-
-      if (rule->type == kExceptionRule) {
-        if (next_dot == std::string::npos) {
-          // If we get here, we had an exception rule with no dots (e.g.
-          // "!foo").  This would only be valid if we had a corresponding
-          // wildcard rule, which would have to be "*".  But we explicitly
-          // disallow that case, so this kind of rule is invalid.
-          NOTREACHED() << "Invalid exception rule";
-          return 0;
-        }
-        return host.length() - next_dot - 1;
-      }
-
-      // If curr_start == host_check_begin, then the host is the registry
-      // itself, so return 0.
-      return (curr_start == host_check_begin) ?
-          0 : (host.length() - curr_start);
-    }
 
-    if (next_dot >= host_check_len)  // Catches std::string::npos as well.
-      break;
+  // Find the most specific rule, i.e. the one for the longest suffix, with one
+  // walk of the rule graph from the end of the host.
+  int rule_type = 0;
+  const size_t curr_start = FindLongestRule(graph_, host, host_check_begin,
+                                            host_check_len, &rule_type);
+  if (curr_start == std::string::npos) {
+    // No rule found in the registry.  If we allow unknown registries, return
+    // the length of the last subcomponent of the host.
+    return allow_unknown_registries ?
+        (host.length() - host.rfind('.', host_check_len - 1) - 1) : 0;
+  }
+
+  // Exception rules override wildcard rules when the domain is an exact
+  // match, but wildcards take precedence when there's a subdomain.
+  if (rule_type == kWildcardRule && curr_start != host_check_begin) {
+    // The registry is the rule plus the subcomponent before it.  If that
+    // subcomponent starts the host, the host is the registry itself, so
+    // return 0.
+    const size_t prev_dot = host.rfind('.', curr_start - 2);
+    const size_t prev_start = (prev_dot == std::string::npos ||
+                               prev_dot < host_check_begin) ?
+        host_check_begin : prev_dot + 1;
+    return (prev_start == host_check_begin) ?
+        0 : (host.length() - prev_start);
+  }
 
-    prev_start = curr_start;
-    curr_start = next_dot + 1;
-    next_dot = host.find('.', curr_start);
+  if (rule_type == kExceptionRule) {
+    const size_t next_dot = host.find('.', curr_start);
+    if (next_dot == std::string::npos) {
+      // If we get here, we had an exception rule with no dots (e.g.
+      // "!foo").  This would only be valid if we had a corresponding
+      // wildcard rule, which would have to be "*".  But we explicitly
+      // disallow that case, so this kind of rule is invalid.
+      NOTREACHED() << "Invalid exception rule";
+      return 0;
+    }
+    return host.length() - next_dot - 1;
   }
 
-  // No rule found in the registry.  curr_start now points to the first
-  // character of the last subcomponent of the host, so if we allow unknown
-  // registries, return the length of this subcomponent.
-  return allow_unknown_registries ? (host.length() - curr_start) : 0;
+  // If curr_start == host_check_begin, then the host is the registry
+  // itself, so return 0.
+  return (curr_start == host_check_begin) ?
+      0 : (host.length() - curr_start);
 }
 
 }  // namespace net
@@ -119,7 +119,6 @@ class GURL;
 
 template <typename T>
 struct DefaultSingletonTraits;
-struct DomainRule;
 
 namespace net {
 
@@ -204,8 +203,6 @@ class RegistryControlledDomainService {
   static RegistryControlledDomainService* GetInstance();
 
  protected:
-  typedef const struct DomainRule* (*FindDomainPtr)(const char *, unsigned int);
-
   // The entire protected API is only for unit testing.  I mean it.  Don't make
   // me come over there!
   RegistryControlledDomainService();
@@ -218,9 +215,10 @@ class RegistryControlledDomainService {
   static RegistryControlledDomainService* SetInstance(
       RegistryControlledDomainService* instance);
 
-  // Used for unit tests, so that a different perfect hash map from the full
-  // list is used.
-  static void UseFindDomainFunction(FindDomainPtr function);
+  // Used for unit tests, so that a different rule graph from the full list is
+  // used.  |graph| is in the format written by
+  // net/tools/tld_cleanup/make_dafsa.py.
+  static void UseDomainGraph(const unsigned char* graph);
 
  private:
   // To allow construction of the internal singleton instance.
@@ -231,8 +229,8 @@ class RegistryControlledDomainService {
   size_t GetRegistryLengthImpl(const std::string& host,
                                bool allow_unknown_registries);
 
-  // Function that returns a DomainRule given a domain.
-  FindDomainPtr find_domain_function_;
+  // The rules, as a graph of their reversed names.
+  const unsigned char* graph_;
 
   DISALLOW_COPY_AND_ASSIGN(RegistryControlledDomainService);
 };
@@ -6,23 +6,23 @@
 #include "net/base/registry_controlled_domain.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
-#include "effective_tld_names_unittest1.cc"
-#undef TOTAL_KEYWORDS
-#undef MIN_WORD_LENGTH
-#undef MAX_WORD_LENGTH
-#undef MIN_HASH_VALUE
-#undef MAX_HASH_VALUE
-#include "effective_tld_names_unittest2.cc"
-
 namespace net {
 namespace {
 
+namespace test1 {
+#include "effective_tld_names_unittest1.cc"
+}  // namespace test1
+
+namespace test2 {
+#include "effective_tld_names_unittest2.cc"
+}  // namespace test2
+
 class TestRegistryControlledDomainService :
     public RegistryControlledDomainService {
  public:
   // Sets the given data.
-  static void UseDomainData(FindDomainPtr function) {
-    RegistryControlledDomainService::UseFindDomainFunction(function);
+  static void UseDomainData(const unsigned char* graph) {
+    RegistryControlledDomainService::UseDomainGraph(graph);
   }
 
   // Creates a new dedicated instance to be used for testing, deleting any
@@ -78,8 +78,7 @@ bool CompareDomains(const std::string& url1, const std::string& url2) {
 }
 
 TEST_F(RegistryControlledDomainTest, TestGetDomainAndRegistry) {
-  TestRegistryControlledDomainService::UseDomainData(
-      Perfect_Hash_Test1::FindDomain);
+  TestRegistryControlledDomainService::UseDomainData(test1::kDafsa);
 
   // Test GURL version of GetDomainAndRegistry().
   EXPECT_EQ("baz.jp", GetDomainFromURL("http://a.baz.jp/file.html"));   // 1
@@ -138,8 +137,7 @@ TEST_F(RegistryControlledDomainTest, TestGetDomainAndRegistry) {
 }
 
 TEST_F(RegistryControlledDomainTest, TestGetRegistryLength) {
-  TestRegistryControlledDomainService::UseDomainData(
-      Perfect_Hash_Test1::FindDomain);
+  TestRegistryControlledDomainService::UseDomainData(test1::kDafsa);
 
   // Test GURL version of GetRegistryLength().
   EXPECT_EQ(2U, GetRegistryLengthFromURL("http://a.baz.jp/file.html", false));
@@ -211,8 +209,7 @@ TEST_F(RegistryControlledDomainTest, TestGetRegistryLength) {
 }
 
 TEST_F(RegistryControlledDomainTest, TestSameDomainOrHost) {
-  TestRegistryControlledDomainService::UseDomainData(
-      Perfect_Hash_Test2::FindDomain);
+  TestRegistryControlledDomainService::UseDomainData(test2::kDafsa);
 
   EXPECT_TRUE(CompareDomains("http://a.b.bar.jp/file.html",
                              "http://a.b.bar.jp/file.html")); // b.bar.jp
@@ -13,10 +13,69 @@
 #include "base/metrics/histogram.h"
 #include "net/base/sdch_manager.h"
 
+#include "sdch/open-vcdiff/src/google/output_string.h"
 #include "sdch/open-vcdiff/src/google/vcdecoder.h"
 
 namespace net {
 
+namespace {
+
+// Receives the output of the decoder, writing it straight into the buffer
+// given to ReadFilteredData(), and keeping whatever doesn't fit in |excess|.
+// The usual output is a std::string, which would have to be copied out again.
+class DestBufferOutput : public open_vcdiff::OutputStringInterface {
+ public:
+  DestBufferOutput(char* dest_buffer, size_t available_space,
+                   std::string* excess)
+      : dest_buffer_(dest_buffer),
+        available_space_(available_space),
+        written_(0),
+        excess_(excess) {
+  }
+
+  virtual OutputStringInterface& append(const char* s, size_t n) {
+    size_t amount = std::min(n, available_space_ - written_);
+    memcpy(dest_buffer_ + written_, s, amount);
+    written_ += amount;
+    if (amount < n)
+      excess_->append(s + amount, n - amount);
+    return *this;
+  }
+
+  virtual void clear() {
+    written_ = 0;
+    excess_->clear();
+  }
+
+  virtual void push_back(char c) {
+    append(&c, 1);
+  }
+
+  virtual void ReserveAdditionalBytes(size_t res_arg) {
+    // Only the part that won't fit in |dest_buffer_| needs room.
+    size_t room = available_space_ - written_;
+    if (res_arg > room)
+      excess_->reserve(excess_->size() + res_arg - room);
+  }
+
+  virtual size_t size() const {
+    return written_ + excess_->size();
+  }
+
+  // The number of bytes written to |dest_buffer_|.
+  size_t written() const { return written_; }
+
+ private:
+  char* const dest_buffer_;
+  const size_t available_space_;
+  size_t written_;
+  std::string* const excess_;
+
+  DISALLOW_COPY_AND_ASSIGN(DestBufferOutput);
+};
+
+}  // namespace
+
 SdchFilter::SdchFilter(const FilterContext& filter_context)
     : filter_context_(filter_context),
       decoding_status_(DECODING_UNINITIALIZED),
@@ -288,13 +347,14 @@ Filter::FilterStatus SdchFilter::ReadFilteredData(char* dest_buffer,
   if (!next_stream_data_ || stream_data_len_ <= 0)
     return FILTER_NEED_MORE_DATA;
 
-  bool ret = vcdiff_streaming_decoder_->DecodeChunk(
-    next_stream_data_, stream_data_len_, &dest_buffer_excess_);
+  DestBufferOutput output(dest_buffer, available_space, &dest_buffer_excess_);
+  bool ret = vcdiff_streaming_decoder_->DecodeChunkToInterface(
+    next_stream_data_, stream_data_len_, &output);
   // Assume all data was used in decoding.
   next_stream_data_ = NULL;
   source_bytes_ += stream_data_len_;
   stream_data_len_ = 0;
-  output_bytes_ += dest_buffer_excess_.size();
+  output_bytes_ += output.size();
   if (!ret) {
     vcdiff_streaming_decoder_.reset(NULL);  // Don't call it again.
     decoding_status_ = DECODING_ERROR;
@@ -302,7 +362,7 @@ Filter::FilterStatus SdchFilter::ReadFilteredData(char* dest_buffer,
     return FILTER_ERROR;
   }
 
-  amount = OutputBufferExcess(dest_buffer, available_space);
+  amount = output.written();
   *dest_len += amount;
   dest_buffer += amount;
   available_space -= amount;
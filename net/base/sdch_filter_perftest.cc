@@ -0,0 +1,174 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(USE_SYSTEM_ZLIB)
+#include <zlib.h>
+#else
+#include "third_party/zlib/zlib.h"
+#endif
+
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/path_service.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "net/base/filter.h"
+#include "net/base/io_buffer.h"
+#include "net/base/mock_filter_context.h"
+#include "net/base/sdch_manager.h"
+#include "sdch/open-vcdiff/src/google/vcencoder.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kNumIterations = 200;
+
+// The number of variations of the page in each body.
+const int kPagesPerBody = 32;
+
+// The size of the reads URLRequestJob does from the filter.
+const int kReadSize = 32 * 1024;
+
+const char kDomain[] = "www.example.com";
+
+class SdchFilterPerfTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    FilePath file_path;
+    PathService::Get(base::DIR_SOURCE_ROOT, &file_path);
+    file_path = file_path.AppendASCII("net");
+    file_path = file_path.AppendASCII("data");
+    file_path = file_path.AppendASCII("filter_unittests");
+    file_path = file_path.AppendASCII("google.txt");
+    std::string page;
+    ASSERT_TRUE(file_util::ReadFileToString(file_path, &page));
+
+    // The page itself is the dictionary, as a site would use its template,
+    // and the body is made of pages that differ slightly from it.
+    std::string dictionary(base::StringPrintf("Domain: %s\n\n", kDomain));
+    dictionary.append(page);
+    for (int i = 0; i < kPagesPerBody; i++) {
+      std::string variation(page);
+      variation.insert(variation.size() / 2,
+                       base::StringPrintf("<p>Result %d</p>", i));
+      body_.append(variation);
+    }
+
+    sdch_manager_.reset(new net::SdchManager);
+    sdch_manager_->EnableSdchSupport("");
+    ASSERT_TRUE(sdch_manager_->AddSdchDictionary(
+        dictionary, GURL(std::string("http://") + kDomain)));
+
+    std::string client_hash;
+    std::string server_hash;
+    net::SdchManager::GenerateHash(dictionary, &client_hash, &server_hash);
+    sdch_encoded_ = server_hash;
+    sdch_encoded_.push_back('\0');
+    open_vcdiff::HashedDictionary hashed_dictionary(page.data(), page.size());
+    ASSERT_TRUE(hashed_dictionary.Init());
+    open_vcdiff::VCDiffStreamingEncoder encoder(
+        &hashed_dictionary, open_vcdiff::VCD_STANDARD_FORMAT, true);
+    ASSERT_TRUE(encoder.StartEncoding(&sdch_encoded_));
+    ASSERT_TRUE(encoder.EncodeChunk(body_.data(), body_.size(),
+                                    &sdch_encoded_));
+    ASSERT_TRUE(encoder.FinishEncoding(&sdch_encoded_));
+  }
+
+  // Decodes |encoded| through the filters for |filter_types|, and logs how
+  // long it took, and the rate of decoded output.
+  void DecodeBody(const char* name, const std::string& encoded,
+                  const std::vector<net::Filter::FilterType>& filter_types) {
+    net::MockFilterContext filter_context;
+    filter_context.SetURL(GURL(std::string("http://") + kDomain + "/"));
+    filter_context.SetMimeType("text/html");
+    scoped_refptr<net::IOBuffer> output(new net::IOBuffer(kReadSize));
+
+    PerfTimer timer;
+    for (int i = 0; i < kNumIterations; i++) {
+      scoped_ptr<net::Filter> filter(
+          net::Filter::Factory(filter_types, filter_context));
+      ASSERT_TRUE(filter.get());
+
+      size_t offset = 0;
+      size_t decoded = 0;
+      net::Filter::FilterStatus status = net::Filter::FILTER_NEED_MORE_DATA;
+      while (status != net::Filter::FILTER_DONE) {
+        if (status == net::Filter::FILTER_NEED_MORE_DATA) {
+          if (offset == encoded.size())
+            break;
+          int size = std::min(filter->stream_buffer_size(),
+                              static_cast<int>(encoded.size() - offset));
+          memcpy(filter->stream_buffer()->data(), encoded.data() + offset,
+                 size);
+          filter->FlushStreamBuffer(size);
+          offset += size;
+        }
+        int output_len = kReadSize;
+        status = filter->ReadData(output->data(), &output_len);
+        ASSERT_NE(net::Filter::FILTER_ERROR, status);
+        decoded += output_len;
+      }
+      EXPECT_EQ(body_.size(), decoded);
+    }
+    base::TimeDelta elapsed = timer.Elapsed();
+    LogPerfResult(name, elapsed.InMillisecondsF(), "ms");
+    double megabytes =
+        static_cast<double>(body_.size()) * kNumIterations / (1024 * 1024);
+    LogPerfResult(base::StringPrintf("%s_rate", name).c_str(),
+                  megabytes / elapsed.InSecondsF(), "MB/s");
+  }
+
+  // The decoded body, and the body encoded against the dictionary.
+  std::string body_;
+  std::string sdch_encoded_;
+
+  scoped_ptr<net::SdchManager> sdch_manager_;
+};
+
+// Returns |input| compressed with gzip.
+std::string GZip(const std::string& input) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // Adding 16 to the window bits asks for the gzip wrapper.
+  EXPECT_EQ(Z_OK, deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                               MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY));
+
+  std::vector<char> encoded(deflateBound(&stream, input.size()) + 32);
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+  stream.avail_in = input.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&encoded[0]);
+  stream.avail_out = encoded.size();
+  EXPECT_EQ(Z_STREAM_END, deflate(&stream, Z_FINISH));
+  encoded.resize(encoded.size() - stream.avail_out);
+  deflateEnd(&stream);
+  return std::string(encoded.begin(), encoded.end());
+}
+
+TEST_F(SdchFilterPerfTest, DecodeSdch) {
+  std::vector<net::Filter::FilterType> filter_types;
+  filter_types.push_back(net::Filter::FILTER_TYPE_SDCH);
+  DecodeBody("SDCH_filter_decode_sdch", sdch_encoded_, filter_types);
+}
+
+TEST_F(SdchFilterPerfTest, DecodeSdchGZip) {
+  std::vector<net::Filter::FilterType> filter_types;
+  filter_types.push_back(net::Filter::FILTER_TYPE_SDCH);
+  filter_types.push_back(net::Filter::FILTER_TYPE_GZIP);
+  DecodeBody("SDCH_filter_decode_sdch_gzip", GZip(sdch_encoded_),
+             filter_types);
+}
+
+TEST_F(SdchFilterPerfTest, DecodeGZip) {
+  // The same body without SDCH, for comparison.
+  std::vector<net::Filter::FilterType> filter_types;
+  filter_types.push_back(net::Filter::FILTER_TYPE_GZIP);
+  DecodeBody("SDCH_filter_decode_gzip_only", GZip(body_), filter_types);
+}
+
+}  // namespace
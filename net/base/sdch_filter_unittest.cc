@@ -16,6 +16,7 @@
 
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/pickle.h"
 #include "net/base/filter.h"
 #include "net/base/io_buffer.h"
 #include "net/base/mock_filter_context.h"
@@ -820,6 +821,11 @@ class SdchFilterChainingTest {
                            const FilterContext& context, int size) {
     return Filter::FactoryForTests(types, context, size);
   }
+
+  // Returns the size of the buffer between |filter| and the next one.
+  static int NextFilterBufferSize(const Filter& filter) {
+    return filter.next_filter_->stream_buffer_size();
+  }
 };
 
 // Test that filters can be cascaded (chained) so that the output of one filter
@@ -895,6 +901,11 @@ TEST_F(SdchFilterTest, FilterChaining) {
                              output_block_size, filter.get(), &output));
   EXPECT_EQ(output, expanded_);
 
+  // The gunzipped content filled the buffer between the filters, so it was
+  // grown for the rest.
+  EXPECT_LT(static_cast<int>(kMidSizedInputBufferSize),
+            SdchFilterChainingTest::NextFilterBufferSize(*filter));
+
   // Next try with a tiny input and output buffer to cover edge effects.
   filter.reset(SdchFilterChainingTest::Factory(filter_types, filter_context,
                                                kLargeInputBufferSize));
@@ -1297,16 +1308,137 @@ TEST_F(SdchFilterTest, TooManyDictionaries) {
   std::string dictionary_domain(".google.com");
   std::string dictionary_text(NewSdchDictionary(dictionary_domain));
 
-  size_t count = 0;
-  while (count <= SdchManager::kMaxDictionaryCount + 1) {
-    if (!sdch_manager_->AddSdchDictionary(dictionary_text,
-                                          GURL("http://www.google.com")))
-      break;
+  // Adding more than the maximum evicts the least recently used, rather than
+  // refusing the new one.
+  std::vector<std::string> server_hashes;
+  for (size_t i = 0; i <= SdchManager::kMaxDictionaryCount; ++i) {
+    EXPECT_TRUE(sdch_manager_->AddSdchDictionary(
+        dictionary_text, GURL("http://www.google.com")));
+    std::string client_hash;
+    std::string server_hash;
+    SdchManager::GenerateHash(dictionary_text, &client_hash, &server_hash);
+    server_hashes.push_back(server_hash);
 
     dictionary_text += " ";  // Create dictionary with different SHA signature.
-    ++count;
   }
-  EXPECT_EQ(SdchManager::kMaxDictionaryCount, count);
+
+  GURL url("http://www.google.com");
+  SdchManager::Dictionary* dictionary = NULL;
+  sdch_manager_->GetVcdiffDictionary(server_hashes[0], url, &dictionary);
+  EXPECT_TRUE(dictionary == NULL);
+  for (size_t i = 1; i < server_hashes.size(); ++i) {
+    sdch_manager_->GetVcdiffDictionary(server_hashes[i], url, &dictionary);
+    EXPECT_TRUE(dictionary != NULL);
+  }
+}
+
+TEST_F(SdchFilterTest, UsedDictionaryNotEvicted) {
+  std::string dictionary_domain(".google.com");
+  std::string dictionary_text(NewSdchDictionary(dictionary_domain));
+  GURL url("http://www.google.com");
+
+  std::vector<std::string> server_hashes;
+  for (size_t i = 0; i < SdchManager::kMaxDictionaryCount; ++i) {
+    EXPECT_TRUE(sdch_manager_->AddSdchDictionary(dictionary_text, url));
+    std::string client_hash;
+    std::string server_hash;
+    SdchManager::GenerateHash(dictionary_text, &client_hash, &server_hash);
+    server_hashes.push_back(server_hash);
+    dictionary_text += " ";
+  }
+
+  // Using the oldest dictionary makes the second oldest the one to go.
+  SdchManager::Dictionary* dictionary = NULL;
+  sdch_manager_->GetVcdiffDictionary(server_hashes[0], url, &dictionary);
+  EXPECT_TRUE(dictionary != NULL);
+  EXPECT_TRUE(sdch_manager_->AddSdchDictionary(dictionary_text, url));
+
+  dictionary = NULL;
+  sdch_manager_->GetVcdiffDictionary(server_hashes[0], url, &dictionary);
+  EXPECT_TRUE(dictionary != NULL);
+  dictionary = NULL;
+  sdch_manager_->GetVcdiffDictionary(server_hashes[1], url, &dictionary);
+  EXPECT_TRUE(dictionary == NULL);
+}
+
+TEST_F(SdchFilterTest, TotalDictionarySizeLimited) {
+  std::string dictionary_domain(".google.com");
+  std::string dictionary_text(NewSdchDictionary(dictionary_domain));
+  GURL url("http://www.google.com");
+
+  // Add the largest dictionaries allowed, one more than fit in the budget.
+  dictionary_text.append(
+      SdchManager::kMaxDictionarySize - dictionary_text.size(), ' ');
+  size_t count = SdchManager::kMaxTotalDictionarySize /
+      SdchManager::kMaxDictionarySize + 1;
+  ASSERT_LT(count, SdchManager::kMaxDictionaryCount);
+
+  std::vector<std::string> server_hashes;
+  for (size_t i = 0; i < count; ++i) {
+    EXPECT_TRUE(sdch_manager_->AddSdchDictionary(dictionary_text, url));
+    std::string client_hash;
+    std::string server_hash;
+    SdchManager::GenerateHash(dictionary_text, &client_hash, &server_hash);
+    server_hashes.push_back(server_hash);
+    dictionary_text[dictionary_text.size() - 1] = 'a' + i;
+  }
+
+  SdchManager::Dictionary* dictionary = NULL;
+  sdch_manager_->GetVcdiffDictionary(server_hashes[0], url, &dictionary);
+  EXPECT_TRUE(dictionary == NULL);
+  for (size_t i = 1; i < server_hashes.size(); ++i) {
+    sdch_manager_->GetVcdiffDictionary(server_hashes[i], url, &dictionary);
+    EXPECT_TRUE(dictionary != NULL);
+  }
+}
+
+TEST_F(SdchFilterTest, SerializeDictionaries) {
+  std::string dictionary_domain(".google.com");
+  std::string dictionary_text(NewSdchDictionary(dictionary_domain));
+  GURL url("http://www.google.com");
+  std::string client_hash;
+  std::string server_hash;
+  SdchManager::GenerateHash(dictionary_text, &client_hash, &server_hash);
+  EXPECT_TRUE(sdch_manager_->AddSdchDictionary(dictionary_text, url));
+
+  Pickle pickle;
+  sdch_manager_->SerializeDictionaries(&pickle);
+
+  // Only one SdchManager can exist at a time.
+  sdch_manager_.reset();
+  sdch_manager_.reset(new SdchManager);
+  sdch_manager_->EnableSdchSupport("");
+
+  SdchManager::Dictionary* dictionary = NULL;
+  sdch_manager_->GetVcdiffDictionary(server_hash, url, &dictionary);
+  EXPECT_TRUE(dictionary == NULL);
+
+  EXPECT_TRUE(sdch_manager_->DeserializeDictionaries(pickle));
+  sdch_manager_->GetVcdiffDictionary(server_hash, url, &dictionary);
+  ASSERT_TRUE(dictionary != NULL);
+  EXPECT_EQ(test_vcdiff_dictionary_, dictionary->text());
+  std::string list;
+  sdch_manager_->GetAvailDictionaryList(url, &list);
+  EXPECT_EQ(client_hash, list);
+
+  // Reading the same dictionaries again doesn't load them twice.
+  EXPECT_TRUE(sdch_manager_->DeserializeDictionaries(pickle));
+  list.clear();
+  sdch_manager_->GetAvailDictionaryList(url, &list);
+  EXPECT_EQ(client_hash, list);
+}
+
+TEST_F(SdchFilterTest, DeserializeTruncatedDictionaries) {
+  // Claims two dictionaries, but holds only the server hash of the first.
+  Pickle pickle;
+  pickle.WriteInt(1);
+  pickle.WriteInt(2);
+  pickle.WriteString("MyciMVll");
+  EXPECT_FALSE(sdch_manager_->DeserializeDictionaries(pickle));
+
+  std::string list;
+  sdch_manager_->GetAvailDictionaryList(GURL("http://www.google.com"), &list);
+  EXPECT_TRUE(list.empty());
 }
 
 TEST_F(SdchFilterTest, DictionaryNotTooLarge) {
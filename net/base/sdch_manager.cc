@@ -4,9 +4,12 @@
 
 #include "net/base/sdch_manager.h"
 
+#include <vector>
+
 #include "base/base64.h"
 #include "base/logging.h"
 #include "base/metrics/histogram.h"
+#include "base/pickle.h"
 #include "base/string_number_conversions.h"
 #include "base/string_util.h"
 #include "crypto/sha2.h"
@@ -22,6 +25,16 @@ const size_t SdchManager::kMaxDictionarySize = 1000000;
 // static
 const size_t SdchManager::kMaxDictionaryCount = 20;
 
+// static
+const size_t SdchManager::kMaxTotalDictionarySize = 5000000;
+
+namespace {
+
+// Bump this whenever the format written by SerializeDictionaries() changes.
+const int kDictionaryFormatVersion = 1;
+
+}  // namespace
+
 // static
 SdchManager* SdchManager::global_;
 
@@ -35,6 +48,7 @@ SdchManager::Dictionary::Dictionary(const std::string& dictionary_text,
                                     const base::Time& expiration,
                                     const std::set<int>& ports)
     : text_(dictionary_text, offset),
+      last_use_(0),
       client_hash_(client_hash),
       url_(gurl),
       domain_(domain),
@@ -202,7 +216,10 @@ bool SdchManager::Dictionary::DomainMatch(const GURL& gurl,
 }
 
 //------------------------------------------------------------------------------
-SdchManager::SdchManager() : sdch_enabled_(false) {
+SdchManager::SdchManager()
+    : total_dictionary_size_(0),
+      dictionary_use_count_(0),
+      sdch_enabled_(false) {
   DCHECK(!global_);
   global_ = this;
 }
@@ -435,27 +452,18 @@ bool SdchManager::AddSdchDictionary(const std::string& dictionary_text,
   if (!Dictionary::CanSet(domain, path, ports, dictionary_url))
     return false;
 
-  // TODO(jar): Remove these hacks to preclude a DOS attack involving piles of
-  // useless dictionaries.  We should probably have a cache eviction plan,
-  // instead of just blocking additions.  For now, with the spec in flux, it
-  // is probably not worth doing eviction handling.
   if (kMaxDictionarySize < dictionary_text.size()) {
     SdchErrorRecovery(DICTIONARY_IS_TOO_LARGE);
     return false;
   }
-  if (kMaxDictionaryCount <= dictionaries_.size()) {
-    SdchErrorRecovery(DICTIONARY_COUNT_EXCEEDED);
-    return false;
-  }
 
   UMA_HISTOGRAM_COUNTS("Sdch3.Dictionary size loaded", dictionary_text.size());
   DVLOG(1) << "Loaded dictionary with client hash " << client_hash
            << " and server hash " << server_hash;
-  Dictionary* dictionary =
-      new Dictionary(dictionary_text, header_end + 2, client_hash,
-                     dictionary_url, domain, path, expiration, ports);
-  dictionary->AddRef();
-  dictionaries_[server_hash] = dictionary;
+  AddDictionary(server_hash,
+                new Dictionary(dictionary_text, header_end + 2, client_hash,
+                               dictionary_url, domain, path, expiration,
+                               ports));
   return true;
 }
 
@@ -469,12 +477,100 @@ void SdchManager::GetVcdiffDictionary(const std::string& server_hash,
   Dictionary* matching_dictionary = it->second;
   if (!matching_dictionary->CanUse(referring_url))
     return;
+  matching_dictionary->last_use_ = ++dictionary_use_count_;
   *dictionary = matching_dictionary;
 }
 
-// TODO(jar): If we have evictions from the dictionaries_, then we need to
-// change this interface to return a list of reference counted Dictionary
-// instances that can be used if/when a server specifies one.
+void SdchManager::SerializeDictionaries(Pickle* pickle) const {
+  // Write the least recently used first, so that they're read back in the
+  // same order of use.  Every dictionary has a distinct |last_use_|.
+  std::map<uint64, DictionaryMap::const_iterator> by_use;
+  for (DictionaryMap::const_iterator it = dictionaries_.begin();
+       it != dictionaries_.end(); ++it) {
+    by_use[it->second->last_use_] = it;
+  }
+
+  pickle->WriteInt(kDictionaryFormatVersion);
+  pickle->WriteInt(static_cast<int>(by_use.size()));
+  for (std::map<uint64, DictionaryMap::const_iterator>::const_iterator it =
+           by_use.begin(); it != by_use.end(); ++it) {
+    const Dictionary* dictionary = it->second->second;
+    pickle->WriteString(it->second->first);
+    pickle->WriteString(dictionary->client_hash_);
+    pickle->WriteString(dictionary->url_.spec());
+    pickle->WriteString(dictionary->domain_);
+    pickle->WriteString(dictionary->path_);
+    pickle->WriteInt64(dictionary->expiration_.ToInternalValue());
+    pickle->WriteInt(static_cast<int>(dictionary->ports_.size()));
+    for (std::set<int>::const_iterator port = dictionary->ports_.begin();
+         port != dictionary->ports_.end(); ++port) {
+      pickle->WriteInt(*port);
+    }
+    pickle->WriteString(dictionary->text_);
+  }
+}
+
+bool SdchManager::DeserializeDictionaries(const Pickle& pickle) {
+  void* iter = NULL;
+  int version;
+  int count;
+  if (!pickle.ReadInt(&iter, &version) ||
+      version != kDictionaryFormatVersion ||
+      !pickle.ReadLength(&iter, &count)) {
+    return false;
+  }
+
+  // Read everything before adding any, so that a truncated pickle adds
+  // nothing.
+  std::vector<std::pair<std::string, Dictionary*> > read;
+  bool ok = true;
+  for (int i = 0; ok && i < count; ++i) {
+    std::string server_hash, client_hash, url_spec, domain, path, text;
+    int64 expiration;
+    int port_count;
+    std::set<int> ports;
+    ok = pickle.ReadString(&iter, &server_hash) &&
+         pickle.ReadString(&iter, &client_hash) &&
+         pickle.ReadString(&iter, &url_spec) &&
+         pickle.ReadString(&iter, &domain) &&
+         pickle.ReadString(&iter, &path) &&
+         pickle.ReadInt64(&iter, &expiration) &&
+         pickle.ReadLength(&iter, &port_count);
+    for (int j = 0; ok && j < port_count; ++j) {
+      int port;
+      ok = pickle.ReadInt(&iter, &port);
+      ports.insert(port);
+    }
+    ok = ok && pickle.ReadString(&iter, &text);
+    if (ok) {
+      Dictionary* dictionary =
+          new Dictionary(text, 0, client_hash, GURL(url_spec), domain, path,
+                         base::Time::FromInternalValue(expiration), ports);
+      dictionary->AddRef();
+      read.push_back(std::make_pair(server_hash, dictionary));
+    }
+  }
+
+  for (size_t i = 0; i < read.size(); ++i) {
+    Dictionary* dictionary = read[i].second;
+    // The dictionaries are checked again, as the rules for setting them may
+    // have changed since they were written.
+    if (ok && dictionaries_.find(read[i].first) == dictionaries_.end() &&
+        dictionary->text_.size() <= kMaxDictionarySize &&
+        base::Time::Now() <= dictionary->expiration_ &&
+        Dictionary::CanSet(dictionary->domain_, dictionary->path_,
+                           dictionary->ports_, dictionary->url_)) {
+      AddDictionary(read[i].first, dictionary);
+    }
+    dictionary->Release();
+  }
+  return ok;
+}
+
+// TODO(jar): Now that dictionaries are evicted, one advertised here may be
+// gone by the time a response needs it.  This should return a list of
+// reference counted Dictionary instances that can be used if/when a server
+// specifies one.
 void SdchManager::GetAvailDictionaryList(const GURL& target_url,
                                          std::string* list) {
   int count = 0;
@@ -527,6 +623,32 @@ void SdchManager::SetAllowLatencyExperiment(const GURL& url, bool enable) {
   allow_latency_experiment_.erase(it);
 }
 
+void SdchManager::AddDictionary(const std::string& server_hash,
+                                Dictionary* dictionary) {
+  DCHECK(dictionaries_.find(server_hash) == dictionaries_.end());
+  size_t size = dictionary->text_.size();
+  while (!dictionaries_.empty() &&
+         (dictionaries_.size() >= kMaxDictionaryCount ||
+          total_dictionary_size_ + size > kMaxTotalDictionarySize)) {
+    DictionaryMap::iterator least_recently_used = dictionaries_.begin();
+    for (DictionaryMap::iterator it = dictionaries_.begin();
+         it != dictionaries_.end(); ++it) {
+      if (it->second->last_use_ < least_recently_used->second->last_use_)
+        least_recently_used = it;
+    }
+    SdchErrorRecovery(DICTIONARY_EVICTED);
+    total_dictionary_size_ -= least_recently_used->second->text_.size();
+    // Filters that are using the dictionary keep their own references.
+    least_recently_used->second->Release();
+    dictionaries_.erase(least_recently_used);
+  }
+
+  dictionary->AddRef();
+  dictionary->last_use_ = ++dictionary_use_count_;
+  dictionaries_[server_hash] = dictionary;
+  total_dictionary_size_ += size;
+}
+
 // static
 void SdchManager::UrlSafeBase64Encode(const std::string& input,
                                       std::string* output) {
@@ -31,6 +31,8 @@
 #include "base/time.h"
 #include "googleurl/src/gurl.h"
 
+class Pickle;
+
 namespace net {
 
 //------------------------------------------------------------------------------
@@ -105,6 +107,7 @@ class SdchManager {
     DICTIONARY_COUNT_EXCEEDED = 35,
     DICTIONARY_ALREADY_SCHEDULED_TO_DOWNLOAD = 36,
     DICTIONARY_ALREADY_TRIED_TO_DOWNLOAD = 37,
+    DICTIONARY_EVICTED = 38,
 
     // Failsafe hack.
     ATTEMPT_TO_DECODE_NON_HTTP_DATA = 40,
@@ -154,10 +157,13 @@ class SdchManager {
     MAX_PROBLEM_CODE  // Used to bound histogram.
   };
 
-  // Use the following static limits to block DOS attacks until we implement
-  // a cached dictionary evicition strategy.
+  // Dictionaries larger than kMaxDictionarySize are refused.  Once
+  // kMaxDictionaryCount dictionaries are loaded, or adding one would take
+  // their text past kMaxTotalDictionarySize, the least recently used ones are
+  // dropped to make room.
   static const size_t kMaxDictionarySize;
   static const size_t kMaxDictionaryCount;
+  static const size_t kMaxTotalDictionarySize;
 
   // There is one instance of |Dictionary| for each memory-cached SDCH
   // dictionary.
@@ -211,6 +217,10 @@ class SdchManager {
     // The actual text of the dictionary.
     std::string text_;
 
+    // When the dictionary was last added or used, as a count of uses of all
+    // the dictionaries; the smallest is the least recently used.
+    uint64 last_use_;
+
     // Part of the hash of text_ that the client uses to advertise the fact that
     // it has a specific dictionary pre-cached.
     std::string client_hash_;
@@ -313,14 +323,23 @@ class SdchManager {
                            const GURL& referring_url,
                            Dictionary** dictionary);
 
+  // Writes the dictionaries to |pickle|, so that an embedder can keep them
+  // across runs rather than fetch them again.
+  void SerializeDictionaries(Pickle* pickle) const;
+
+  // Adds the dictionaries written by SerializeDictionaries(), other than ones
+  // that have expired or are no longer allowed.  Returns false, without
+  // adding any, if |pickle| is malformed.
+  bool DeserializeDictionaries(const Pickle& pickle);
+
   // Get list of available (pre-cached) dictionaries that we have already loaded
   // into memory.  The list is a comma separated list of (client) hashes per
   // the SDCH spec.
   void GetAvailDictionaryList(const GURL& target_url, std::string* list);
 
   // Construct the pair of hashes for client and server to identify an SDCH
-  // dictionary.  This is only made public to facilitate unit testing, but is
-  // otherwise private
+  // dictionary.  This is public for unit testing, and for servers (such as
+  // flip_server) that encode responses against a dictionary.
   static void GenerateHash(const std::string& dictionary_text,
                            std::string* client_hash, std::string* server_hash);
 
@@ -345,8 +364,20 @@ class SdchManager {
   // A simple implementation of a RFC 3548 "URL safe" base64 encoder.
   static void UrlSafeBase64Encode(const std::string& input,
                                   std::string* output);
+
+  // Takes a reference to |dictionary| and makes it available under
+  // |server_hash|, first dropping the least recently used dictionaries if
+  // there isn't room for it.
+  void AddDictionary(const std::string& server_hash, Dictionary* dictionary);
+
   DictionaryMap dictionaries_;
 
+  // The size of the text of all of |dictionaries_|.
+  size_t total_dictionary_size_;
+
+  // Counts uses of the dictionaries, to order them by when they were used.
+  uint64 dictionary_use_count_;
+
   // An instance that can fetch a dictionary given a URL.
   scoped_ptr<SdchFetcher> fetcher_;
 
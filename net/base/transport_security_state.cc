@@ -6,8 +6,10 @@
 
 #include "base/base64.h"
 #include "base/command_line.h"
+#include "base/hash_tables.h"
 #include "base/json/json_reader.h"
 #include "base/json/json_writer.h"
+#include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/sha1.h"
@@ -26,6 +28,71 @@ namespace net {
 
 const long int TransportSecurityState::kMaxHSTSAgeSecs = 86400 * 365;  // 1 year
 
+namespace {
+
+// In the medium term this list is likely to just be hardcoded here. This,
+// slightly odd, form removes the need for additional relocations records.
+struct PreloadedHost {
+  uint8 length;
+  bool include_subdomains;
+  char dns_name[30];
+};
+
+const PreloadedHost kPreloadedSTS[] = {
+  {16, false, "\003www\006paypal\003com"},
+  {16, false, "\003www\006elanex\003biz"},
+  {12, true,  "\006jottit\003com"},
+  {19, true,  "\015sunshinepress\003org"},
+  {21, false, "\003www\013noisebridge\003net"},
+  {10, false, "\004neg9\003org"},
+  {12, true, "\006riseup\003net"},
+  {11, false, "\006factor\002cc"},
+  {22, false, "\007members\010mayfirst\003org"},
+  {22, false, "\007support\010mayfirst\003org"},
+  {17, false, "\002id\010mayfirst\003org"},
+  {20, false, "\005lists\010mayfirst\003org"},
+  {19, true, "\015splendidbacon\003com"},
+  {19, true, "\006health\006google\003com"},
+  {21, true, "\010checkout\006google\003com"},
+  {19, true, "\006chrome\006google\003com"},
+  {26, false, "\006latest\006chrome\006google\003com"},
+  {28, false, "\016aladdinschools\007appspot\003com"},
+  {14, true, "\011ottospora\002nl"},
+  {17, true, "\004docs\006google\003com"},
+  {18, true, "\005sites\006google\003com"},
+  {25, true, "\014spreadsheets\006google\003com"},
+  {22, false, "\011appengine\006google\003com"},
+  {25, false, "\003www\017paycheckrecords\003com"},
+  {20, true, "\006market\007android\003com"},
+  {14, false, "\010lastpass\003com"},
+  {18, false, "\003www\010lastpass\003com"},
+  {14, true, "\010keyerror\003com"},
+  {22, true, "\011encrypted\006google\003com"},
+  {13, false, "\010entropia\002de"},
+  {17, false, "\003www\010entropia\002de"},
+  {21, true, "\010accounts\006google\003com"},
+#if defined(OS_CHROMEOS)
+  {17, true, "\004mail\006google\003com"},
+  {13, false, "\007twitter\003com"},
+  {17, false, "\003www\007twitter\003com"},
+  {17, false, "\003api\007twitter\003com"},
+  {17, false, "\003dev\007twitter\003com"},
+  {22, false, "\010business\007twitter\003com"},
+#endif
+};
+const size_t kNumPreloadedSTS = ARRAYSIZE_UNSAFE(kPreloadedSTS);
+
+// These are only enabled when SNI is available.
+const PreloadedHost kPreloadedSNISTS[] = {
+  {11, false, "\005gmail\003com"},
+  {16, false, "\012googlemail\003com"},
+  {15, false, "\003www\005gmail\003com"},
+  {20, false, "\003www\012googlemail\003com"},
+};
+const size_t kNumPreloadedSNISTS = ARRAYSIZE_UNSAFE(kPreloadedSNISTS);
+
+}  // namespace
+
 TransportSecurityState::TransportSecurityState()
     : delegate_(NULL) {
 }
@@ -96,6 +163,10 @@ bool TransportSecurityState::IsEnabledForHost(DomainState* result,
 
   *result = DomainState();
 
+  // Most profiles have no dynamic entries; don't hash every label for nothing.
+  if (enabled_hosts_.empty())
+    return false;
+
   base::Time current_time(base::Time::Now());
 
   for (size_t i = 0; canonicalized_host[i]; i += canonicalized_host[i] + 1) {
@@ -482,6 +553,71 @@ std::string TransportSecurityState::CanonicalizeHost(const std::string& host) {
   return new_host;
 }
 
+// PreloadedHosts indexes the built-in entries by their DNS form, and parses
+// the entries given on the command line, once per process, so that checking a
+// host costs a hash lookup per label instead of parsing JSON and scanning the
+// lists each time.
+class TransportSecurityState::PreloadedHosts {
+ public:
+  struct Entry {
+    bool include_subdomains;
+    bool requires_sni;
+  };
+
+  PreloadedHosts() {
+    for (size_t i = 0; i < kNumPreloadedSTS; ++i)
+      Add(kPreloadedSTS[i], false);
+    for (size_t i = 0; i < kNumPreloadedSNISTS; ++i)
+      Add(kPreloadedSNISTS[i], true);
+
+#if !defined(ANDROID)
+    std::string cmd_line_hsts =
+        CommandLine::ForCurrentProcess()->GetSwitchValueASCII(
+            switches::kHstsHosts);
+    if (!cmd_line_hsts.empty()) {
+      bool dirty;
+      Deserialise(cmd_line_hsts, &dirty, &command_line_hosts_);
+    }
+#endif
+  }
+
+  // Returns the built-in entry for exactly |dns_name|, or NULL.
+  const Entry* Find(const std::string& dns_name) const {
+    EntryMap::const_iterator i = entries_.find(dns_name);
+    return i == entries_.end() ? NULL : &i->second;
+  }
+
+  // Returns the command line entry for exactly |dns_name|, or NULL.
+  const DomainState* FindCommandLine(const std::string& dns_name) const {
+    if (command_line_hosts_.empty())
+      return NULL;
+    std::map<std::string, DomainState>::const_iterator i =
+        command_line_hosts_.find(HashHost(dns_name));
+    return i == command_line_hosts_.end() ? NULL : &i->second;
+  }
+
+ private:
+  typedef base::hash_map<std::string, Entry> EntryMap;
+
+  void Add(const PreloadedHost& host, bool requires_sni) {
+    Entry entry;
+    entry.include_subdomains = host.include_subdomains;
+    entry.requires_sni = requires_sni;
+    entries_[std::string(host.dns_name, host.length)] = entry;
+  }
+
+  EntryMap entries_;
+
+  // Keyed, like |enabled_hosts_|, by the hash of the DNS form.
+  std::map<std::string, DomainState> command_line_hosts_;
+
+  DISALLOW_COPY_AND_ASSIGN(PreloadedHosts);
+};
+
+// static
+base::LazyInstance<TransportSecurityState::PreloadedHosts>
+    TransportSecurityState::preloaded_hosts_(base::LINKER_INITIALIZED);
+
 // IsPreloadedSTS returns true if the canonicalized hostname should always be
 // considered to have STS enabled.
 // static
@@ -495,113 +631,26 @@ bool TransportSecurityState::IsPreloadedSTS(
   out->expiry = out->created;
   out->include_subdomains = false;
 
-  std::map<std::string, DomainState> hosts;
-  std::string cmd_line_hsts
-#ifdef ANDROID
-      ;
-#else
-      = CommandLine::ForCurrentProcess()->GetSwitchValueASCII(
-          switches::kHstsHosts);
-#endif
-  if (!cmd_line_hsts.empty()) {
-    bool dirty;
-    Deserialise(cmd_line_hsts, &dirty, &hosts);
-  }
-
-  // In the medium term this list is likely to just be hardcoded here. This,
-  // slightly odd, form removes the need for additional relocations records.
-  static const struct {
-    uint8 length;
-    bool include_subdomains;
-    char dns_name[30];
-  } kPreloadedSTS[] = {
-    {16, false, "\003www\006paypal\003com"},
-    {16, false, "\003www\006elanex\003biz"},
-    {12, true,  "\006jottit\003com"},
-    {19, true,  "\015sunshinepress\003org"},
-    {21, false, "\003www\013noisebridge\003net"},
-    {10, false, "\004neg9\003org"},
-    {12, true, "\006riseup\003net"},
-    {11, false, "\006factor\002cc"},
-    {22, false, "\007members\010mayfirst\003org"},
-    {22, false, "\007support\010mayfirst\003org"},
-    {17, false, "\002id\010mayfirst\003org"},
-    {20, false, "\005lists\010mayfirst\003org"},
-    {19, true, "\015splendidbacon\003com"},
-    {19, true, "\006health\006google\003com"},
-    {21, true, "\010checkout\006google\003com"},
-    {19, true, "\006chrome\006google\003com"},
-    {26, false, "\006latest\006chrome\006google\003com"},
-    {28, false, "\016aladdinschools\007appspot\003com"},
-    {14, true, "\011ottospora\002nl"},
-    {17, true, "\004docs\006google\003com"},
-    {18, true, "\005sites\006google\003com"},
-    {25, true, "\014spreadsheets\006google\003com"},
-    {22, false, "\011appengine\006google\003com"},
-    {25, false, "\003www\017paycheckrecords\003com"},
-    {20, true, "\006market\007android\003com"},
-    {14, false, "\010lastpass\003com"},
-    {18, false, "\003www\010lastpass\003com"},
-    {14, true, "\010keyerror\003com"},
-    {22, true, "\011encrypted\006google\003com"},
-    {13, false, "\010entropia\002de"},
-    {17, false, "\003www\010entropia\002de"},
-    {21, true, "\010accounts\006google\003com"},
-#if defined(OS_CHROMEOS)
-    {17, true, "\004mail\006google\003com"},
-    {13, false, "\007twitter\003com"},
-    {17, false, "\003www\007twitter\003com"},
-    {17, false, "\003api\007twitter\003com"},
-    {17, false, "\003dev\007twitter\003com"},
-    {22, false, "\010business\007twitter\003com"},
-#endif
-  };
-  static const size_t kNumPreloadedSTS = ARRAYSIZE_UNSAFE(kPreloadedSTS);
-
-  static const struct {
-    uint8 length;
-    bool include_subdomains;
-    char dns_name[30];
-  } kPreloadedSNISTS[] = {
-    {11, false, "\005gmail\003com"},
-    {16, false, "\012googlemail\003com"},
-    {15, false, "\003www\005gmail\003com"},
-    {20, false, "\003www\012googlemail\003com"},
-  };
-  static const size_t kNumPreloadedSNISTS = ARRAYSIZE_UNSAFE(kPreloadedSNISTS);
+  const PreloadedHosts& preloaded = preloaded_hosts_.Get();
 
   for (size_t i = 0; canonicalized_host[i]; i += canonicalized_host[i] + 1) {
     std::string host_sub_chunk(&canonicalized_host[i],
                                canonicalized_host.size() - i);
-    out->domain = DNSDomainToString(host_sub_chunk);
-    std::string hashed_host(HashHost(host_sub_chunk));
-    if (hosts.find(hashed_host) != hosts.end()) {
-      *out = hosts[hashed_host];
+    const DomainState* command_line_state =
+        preloaded.FindCommandLine(host_sub_chunk);
+    if (command_line_state) {
+      *out = *command_line_state;
       out->domain = DNSDomainToString(host_sub_chunk);
       out->preloaded = true;
       return true;
     }
-    for (size_t j = 0; j < kNumPreloadedSTS; j++) {
-      if (kPreloadedSTS[j].length == canonicalized_host.size() - i &&
-          memcmp(kPreloadedSTS[j].dns_name, &canonicalized_host[i],
-                 kPreloadedSTS[j].length) == 0) {
-        if (!kPreloadedSTS[j].include_subdomains && i != 0)
-          return false;
-        out->include_subdomains = kPreloadedSTS[j].include_subdomains;
-        return true;
-      }
-    }
-    if (sni_available) {
-      for (size_t j = 0; j < kNumPreloadedSNISTS; j++) {
-        if (kPreloadedSNISTS[j].length == canonicalized_host.size() - i &&
-            memcmp(kPreloadedSNISTS[j].dns_name, &canonicalized_host[i],
-                   kPreloadedSNISTS[j].length) == 0) {
-          if (!kPreloadedSNISTS[j].include_subdomains && i != 0)
-            return false;
-          out->include_subdomains = kPreloadedSNISTS[j].include_subdomains;
-          return true;
-        }
-      }
+    const PreloadedHosts::Entry* entry = preloaded.Find(host_sub_chunk);
+    if (entry && (sni_available || !entry->requires_sni)) {
+      out->domain = DNSDomainToString(host_sub_chunk);
+      if (!entry->include_subdomains && i != 0)
+        return false;
+      out->include_subdomains = entry->include_subdomains;
+      return true;
     }
   }
 
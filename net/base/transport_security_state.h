@@ -12,6 +12,7 @@
 
 #include "base/basictypes.h"
 #include "base/gtest_prod_util.h"
+#include "base/lazy_instance.h"
 #include "base/memory/ref_counted.h"
 #include "base/time.h"
 #include "net/base/x509_cert_types.h"
@@ -117,6 +118,9 @@ class TransportSecurityState :
   friend class base::RefCountedThreadSafe<TransportSecurityState>;
   FRIEND_TEST_ALL_PREFIXES(TransportSecurityStateTest, IsPreloaded);
 
+  // The built-in and command line entries, indexed once per process.
+  class PreloadedHosts;
+
   ~TransportSecurityState();
 
   // If we have a callback configured, call it to let our serialiser know that
@@ -136,6 +140,8 @@ class TransportSecurityState :
   // ('www.google.com') to the form used in DNS: "\x03www\x06google\x03com"
   std::map<std::string, DomainState> enabled_hosts_;
 
+  static base::LazyInstance<PreloadedHosts> preloaded_hosts_;
+
   // Our delegate who gets notified when we are dirtied, or NULL.
   Delegate* delegate_;
 
@@ -123,7 +123,8 @@ FileStream* UploadData::Element::NewFileStreamForReading() {
 UploadData::UploadData()
     : identifier_(0),
       chunk_callback_(NULL),
-      is_chunked_(false) {
+      is_chunked_(false),
+      send_gzipped_(false) {
 }
 
 void UploadData::AppendBytes(const char* bytes, int bytes_len) {
@@ -164,6 +164,13 @@ class UploadData : public base::RefCounted<UploadData> {
   void set_is_chunked(bool set) { is_chunked_ = set; }
   bool is_chunked() const { return is_chunked_; }
 
+  // Compresses the data with gzip as it is uploaded, and sends it with
+  // "Content-Encoding: gzip".  Only use this with servers known to accept
+  // compressed request bodies.  As the compressed size isn't known up front,
+  // the data is always sent with chunked transfer encoding.
+  void set_send_gzipped(bool send_gzipped) { send_gzipped_ = send_gzipped; }
+  bool send_gzipped() const { return send_gzipped_; }
+
   // Returns the total size in bytes of the data to upload.
   uint64 GetContentLength();
 
@@ -192,6 +199,7 @@ class UploadData : public base::RefCounted<UploadData> {
   int64 identifier_;
   ChunkCallback* chunk_callback_;
   bool is_chunked_;
+  bool send_gzipped_;
 
   DISALLOW_COPY_AND_ASSIGN(UploadData);
 };
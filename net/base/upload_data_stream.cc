@@ -4,6 +4,12 @@
 
 #include "net/base/upload_data_stream.h"
 
+#if defined(USE_SYSTEM_ZLIB)
+#include <zlib.h>
+#else
+#include "third_party/zlib/zlib.h"
+#endif
+
 #include "base/file_util.h"
 #include "base/logging.h"
 #include "net/base/file_stream.h"
@@ -15,6 +21,8 @@ namespace net {
 bool UploadDataStream::merge_chunks_ = true;
 
 UploadDataStream::~UploadDataStream() {
+  if (zlib_stream_.get())
+    deflateEnd(zlib_stream_.get());
 }
 
 UploadDataStream* UploadDataStream::Create(UploadData* data, int* error_code) {
@@ -29,10 +37,21 @@ UploadDataStream* UploadDataStream::Create(UploadData* data, int* error_code) {
 }
 
 void UploadDataStream::MarkConsumedAndFillBuffer(size_t num_bytes) {
-  DCHECK_LE(num_bytes, buf_len_);
   DCHECK(!eof_);
 
-  if (num_bytes) {
+  if (num_bytes && !buf_len_ && send_files_directly_) {
+    // The data was sent from the file of the current element.
+    DCHECK(next_element_stream_.get());
+    DCHECK_LE(num_bytes, next_element_remaining_);
+    next_element_stream_->Seek(FROM_CURRENT, num_bytes);
+    next_element_remaining_ -= num_bytes;
+    if (!next_element_remaining_) {
+      ++next_element_;
+      next_element_offset_ = 0;
+      next_element_stream_.reset();
+    }
+  } else if (num_bytes) {
+    DCHECK_LE(num_bytes, buf_len_);
     buf_len_ -= num_bytes;
     if (buf_len_)
       memmove(buf_->data(), buf_->data() + num_bytes, buf_len_);
@@ -52,18 +71,119 @@ UploadDataStream::UploadDataStream(UploadData* data)
       next_element_remaining_(0),
       total_size_(data->is_chunked() ? 0 : data->GetContentLength()),
       current_position_(0),
-      eof_(false) {
+      eof_(false),
+      send_files_directly_(false),
+      raw_buf_len_(0),
+      zlib_stream_done_(false) {
+  if (data->send_gzipped()) {
+    // Adding 16 to the window bits asks zlib for the gzip wrapper.
+    zlib_stream_.reset(new z_stream);
+    memset(zlib_stream_.get(), 0, sizeof(z_stream));
+    if (deflateInit2(zlib_stream_.get(), Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                     MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK) {
+      raw_buf_ = new IOBuffer(kBufSize);
+      total_size_ = 0;
+    } else {
+      // Send the data as it is.
+      zlib_stream_.reset();
+    }
+  }
+}
+
+void UploadDataStream::set_send_files_directly(bool send_files_directly) {
+  DCHECK(!is_chunked());
+  send_files_directly_ = send_files_directly;
+  // The file data has to be read into the buffer now.
+  if (!send_files_directly_ && !buf_len_)
+    FillBuf();
+}
+
+bool UploadDataStream::GetFileData(base::PlatformFile* file,
+                                   int64* offset,
+                                   int* length) {
+  if (!send_files_directly_ || buf_len_ || !next_element_stream_.get() ||
+      !next_element_remaining_) {
+    return false;
+  }
+
+  int64 position = next_element_stream_->Seek(FROM_CURRENT, 0);
+  if (position < 0)
+    return false;
+
+  *file = next_element_stream_->platform_file();
+  *offset = position;
+  *length = static_cast<int>(
+      std::min(next_element_remaining_, static_cast<uint64>(kMaxFileDataSize)));
+  return true;
 }
 
 int UploadDataStream::FillBuf() {
+  if (is_gzipped())
+    return FillBufGZipped();
+
+  int rv = ReadElements(buf_->data(), &buf_len_);
+  if (rv != OK)
+    return rv;
+
+  if (!buf_len_ && AllElementsRead())
+    eof_ = true;
+
+  return OK;
+}
+
+int UploadDataStream::FillBufGZipped() {
+  while (buf_len_ < kBufSize && !zlib_stream_done_) {
+    int rv = ReadElements(raw_buf_->data(), &raw_buf_len_);
+    if (rv != OK)
+      return rv;
+
+    // Once everything is read, finish the gzip stream.  A chunked upload that
+    // has to wait for its next chunk flushes what it has, so that the server
+    // isn't kept waiting for the chunks sent so far.
+    int flush = Z_NO_FLUSH;
+    if (AllElementsRead())
+      flush = Z_FINISH;
+    else if (next_element_ == data_->elements()->size())
+      flush = Z_SYNC_FLUSH;
+
+    zlib_stream_->next_in = bit_cast<Bytef*>(raw_buf_->data());
+    zlib_stream_->avail_in = raw_buf_len_;
+    zlib_stream_->next_out = bit_cast<Bytef*>(buf_->data() + buf_len_);
+    zlib_stream_->avail_out = kBufSize - buf_len_;
+    int code = deflate(zlib_stream_.get(), flush);
+    buf_len_ = kBufSize - zlib_stream_->avail_out;
+
+    size_t consumed = raw_buf_len_ - zlib_stream_->avail_in;
+    raw_buf_len_ -= consumed;
+    if (raw_buf_len_)
+      memmove(raw_buf_->data(), raw_buf_->data() + consumed, raw_buf_len_);
+
+    if (code == Z_STREAM_END) {
+      zlib_stream_done_ = true;
+    } else if (code == Z_BUF_ERROR ||
+               (flush == Z_SYNC_FLUSH && zlib_stream_->avail_out)) {
+      // Everything there is so far has been compressed and flushed.
+      break;
+    } else {
+      DCHECK_EQ(Z_OK, code);
+    }
+  }
+
+  if (zlib_stream_done_ && !buf_len_)
+    eof_ = true;
+
+  return OK;
+}
+
+int UploadDataStream::ReadElements(char* buf, size_t* buf_len) {
   std::vector<UploadData::Element>& elements = *data_->elements();
 
-  while (buf_len_ < kBufSize && next_element_ < elements.size()) {
+  while (*buf_len < kBufSize && next_element_ < elements.size()) {
     bool advance_to_next_element = false;
 
     UploadData::Element& element = elements[next_element_];
 
-    size_t size_remaining = kBufSize - buf_len_;
+    size_t size_remaining = kBufSize - *buf_len;
     if (element.type() == UploadData::TYPE_BYTES ||
         element.type() == UploadData::TYPE_CHUNK) {
       const std::vector<char>& d = element.bytes();
@@ -75,8 +195,8 @@ int UploadDataStream::FillBuf() {
       // address of an element in |d| and that will throw an exception if |d|
       // is an empty vector.
       if (bytes_copied) {
-        memcpy(buf_->data() + buf_len_, &d[next_element_offset_], bytes_copied);
-        buf_len_ += bytes_copied;
+        memcpy(buf + *buf_len, &d[next_element_offset_], bytes_copied);
+        *buf_len += bytes_copied;
       }
 
       if (bytes_copied == count) {
@@ -109,6 +229,11 @@ int UploadDataStream::FillBuf() {
         next_element_stream_.reset(element.NewFileStreamForReading());
       }
 
+      // The consumer sends the file itself, once the buffer is empty.
+      if (send_files_directly_ && next_element_stream_.get() &&
+          next_element_remaining_)
+        break;
+
       int rv = 0;
       int count =
           static_cast<int>(std::min(next_element_remaining_,
@@ -116,11 +241,11 @@ int UploadDataStream::FillBuf() {
       if (count > 0) {
 #ifdef ANDROID
         if (next_element_java_stream_.get())
-            rv = next_element_java_stream_->Read(buf_->data() + buf_len_, count);
+            rv = next_element_java_stream_->Read(buf + *buf_len, count);
         else {
 #endif
         if (next_element_stream_.get())
-          rv = next_element_stream_->Read(buf_->data() + buf_len_, count, NULL);
+          rv = next_element_stream_->Read(buf + *buf_len, count, NULL);
 #ifdef ANDROID
         }
 #endif
@@ -128,10 +253,10 @@ int UploadDataStream::FillBuf() {
           // If there's less data to read than we initially observed, then
           // pad with zero.  Otherwise the server will hang waiting for the
           // rest of the data.
-          memset(buf_->data() + buf_len_, 0, count);
+          memset(buf + *buf_len, 0, count);
           rv = count;
         }
-        buf_len_ += rv;
+        *buf_len += rv;
       }
 
       if (static_cast<int>(next_element_remaining_) == rv) {
@@ -148,23 +273,26 @@ int UploadDataStream::FillBuf() {
       next_element_stream_.reset();
     }
 
-    if (is_chunked() && !merge_chunks_)
+    if (data_->is_chunked() && !merge_chunks_)
       break;
   }
 
-  if (next_element_ == elements.size() && !buf_len_) {
-    if (!data_->is_chunked() ||
-        (!elements.empty() && elements.back().is_last_chunk())) {
-      eof_ = true;
-    }
-  }
-
   return OK;
 }
 
+bool UploadDataStream::AllElementsRead() const {
+  const std::vector<UploadData::Element>& elements = *data_->elements();
+  return next_element_ == elements.size() &&
+         (!data_->is_chunked() ||
+          (!elements.empty() && elements.back().is_last_chunk()));
+}
+
 bool UploadDataStream::IsOnLastChunk() const {
+  DCHECK(is_chunked());
+  if (is_gzipped())
+    return zlib_stream_done_;
+
   const std::vector<UploadData::Element>& elements = *data_->elements();
-  DCHECK(data_->is_chunked());
   return (eof_ ||
           (!elements.empty() &&
            next_element_ == elements.size() &&
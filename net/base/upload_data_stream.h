@@ -7,12 +7,15 @@
 #pragma once
 
 #include "base/memory/scoped_ptr.h"
+#include "base/platform_file.h"
 #include "net/base/upload_data.h"
 
 #ifdef ANDROID
 #include "android/jni/platform_file_jni.h"
 #endif
 
+typedef struct z_stream_s z_stream;
+
 namespace net {
 
 class FileStream;
@@ -39,9 +42,21 @@ class UploadDataStream {
 
   // Call to indicate that a portion of the stream's buffer was consumed.  This
   // call modifies the stream's buffer so that it contains the next segment of
-  // the upload data to be consumed.
+  // the upload data to be consumed. If the data was sent from the file given
+  // by GetFileData(), |num_bytes| is the number of bytes sent from it.
   void MarkConsumedAndFillBuffer(size_t num_bytes);
 
+  // Lets the consumer send the contents of file elements straight from their
+  // files (see GetFileData()) instead of having them copied into the buffer.
+  // Data that is already in the buffer is not affected. Must not be used with
+  // chunked uploads.
+  void set_send_files_directly(bool send_files_directly);
+
+  // Returns true if the buffer is empty and the next |*length| bytes of the
+  // stream have to be read from |*file|, starting at |*offset|. This only
+  // happens after set_send_files_directly(true).
+  bool GetFileData(base::PlatformFile* file, int64* offset, int* length);
+
   // Sets the callback to be invoked when new chunks are available to upload.
   void set_chunk_callback(ChunkCallback* callback) {
     data_->set_chunk_callback(callback);
@@ -54,7 +69,15 @@ class UploadDataStream {
   uint64 size() const { return total_size_; }
   uint64 position() const { return current_position_; }
 
-  bool is_chunked() const { return data_->is_chunked(); }
+  // Returns whether the stream has to be sent with chunked transfer encoding,
+  // either because the data is chunked, or because it is gzipped and so its
+  // final size isn't known.
+  bool is_chunked() const { return data_->is_chunked() || is_gzipped(); }
+
+  // Returns whether the stream is the data compressed with gzip (see
+  // UploadData::set_send_gzipped()), to be sent with
+  // "Content-Encoding: gzip".
+  bool is_gzipped() const { return zlib_stream_.get() != NULL; }
 
   // Returns whether there is no more data to read, regardless of whether
   // position < size.
@@ -73,6 +96,10 @@ class UploadDataStream {
  private:
   enum { kBufSize = 16384 };
 
+  // The maximum number of bytes returned by GetFileData(), so that the upload
+  // progress is still updated regularly.
+  enum { kMaxFileDataSize = 1024 * 1024 };
+
   // Protects from public access since now we have a static creator function
   // which will do both creation and initialization and might return an error.
   explicit UploadDataStream(UploadData* data);
@@ -82,6 +109,18 @@ class UploadDataStream {
   // Returns OK if the operation succeeds. Otherwise error code is returned.
   int FillBuf();
 
+  // Same as FillBuf(), for gzipped streams: the data is read into |raw_buf_|
+  // and compressed from there into the buffer.
+  int FillBufGZipped();
+
+  // Appends the data of the next elements to |buf|, which holds |*buf_len|
+  // bytes already, until it holds kBufSize bytes or the elements run out.
+  int ReadElements(char* buf, size_t* buf_len);
+
+  // Returns true if all of the data has been read from the elements, and no
+  // chunks are to follow.
+  bool AllElementsRead() const;
+
   scoped_refptr<UploadData> data_;
 
   // This buffer is filled with data to be uploaded.  The data to be sent is
@@ -117,6 +156,18 @@ class UploadDataStream {
   // Whether there is no data left to read.
   bool eof_;
 
+  // Whether file elements are sent straight from their files.
+  bool send_files_directly_;
+
+  // For gzipped streams, the compressor, and the data read from the elements
+  // that it is yet to take.
+  scoped_ptr<z_stream> zlib_stream_;
+  scoped_refptr<IOBuffer> raw_buf_;
+  size_t raw_buf_len_;
+
+  // Whether the compressor has written the end of the gzip stream.
+  bool zlib_stream_done_;
+
   // TODO(satish): Remove this once we have a better way to unit test POST
   // requests with chunked uploads.
   static bool merge_chunks_;
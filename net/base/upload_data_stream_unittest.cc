@@ -4,13 +4,21 @@
 
 #include "net/base/upload_data_stream.h"
 
+#include <string>
 #include <vector>
 
+#if defined(USE_SYSTEM_ZLIB)
+#include <zlib.h>
+#else
+#include "third_party/zlib/zlib.h"
+#endif
+
 #include "base/basictypes.h"
 #include "base/file_path.h"
 #include "base/file_util.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/time.h"
+#include "net/base/io_buffer.h"
 #include "net/base/net_errors.h"
 #include "net/base/upload_data.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -23,6 +31,29 @@ namespace {
 const char kTestData[] = "0123456789";
 const int kTestDataSize = arraysize(kTestData) - 1;
 
+// Returns |gzipped| uncompressed, or an empty string if it isn't a whole
+// gzip stream.
+std::string GUnzip(const std::string& gzipped) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (inflateInit2(&stream, MAX_WBITS + 16) != Z_OK)
+    return std::string();
+
+  std::string output;
+  char buf[4096];
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(gzipped.data()));
+  stream.avail_in = gzipped.size();
+  int code = Z_OK;
+  while (code == Z_OK) {
+    stream.next_out = reinterpret_cast<Bytef*>(buf);
+    stream.avail_out = sizeof(buf);
+    code = inflate(&stream, Z_NO_FLUSH);
+    output.append(buf, sizeof(buf) - stream.avail_out);
+  }
+  inflateEnd(&stream);
+  return code == Z_STREAM_END ? output : std::string();
+}
+
 }  // namespace
 
 class UploadDataStreamTest : public PlatformTest {
@@ -85,6 +116,59 @@ TEST_F(UploadDataStreamTest, FileSmallerThanLength) {
   file_util::Delete(temp_file_path, false);
 }
 
+TEST_F(UploadDataStreamTest, SendFilesDirectly) {
+  FilePath temp_file_path;
+  ASSERT_TRUE(file_util::CreateTemporaryFile(&temp_file_path));
+  ASSERT_EQ(kTestDataSize, file_util::WriteFile(temp_file_path,
+                                                kTestData, kTestDataSize));
+
+  // The bytes fill the whole buffer, so the file is not read by Create().
+  scoped_ptr<UploadDataStream> empty_stream(
+      UploadDataStream::Create(new UploadData, NULL));
+  std::vector<char> bytes(empty_stream->GetMaxBufferSize(), 'a');
+  std::vector<UploadData::Element> elements;
+  UploadData::Element element;
+  element.SetToBytes(&bytes[0], bytes.size());
+  elements.push_back(element);
+  element.SetToFilePathRange(temp_file_path, 2, 5, base::Time());
+  elements.push_back(element);
+  upload_data_->SetElements(elements);
+
+  scoped_ptr<UploadDataStream> stream(
+      UploadDataStream::Create(upload_data_, NULL));
+  ASSERT_TRUE(stream.get());
+  stream->set_send_files_directly(true);
+
+  base::PlatformFile file;
+  int64 offset;
+  int length;
+  EXPECT_FALSE(stream->GetFileData(&file, &offset, &length));
+  EXPECT_EQ(bytes.size(), stream->buf_len());
+  stream->MarkConsumedAndFillBuffer(stream->buf_len());
+
+  // The file is not copied to the buffer.
+  EXPECT_EQ(0U, stream->buf_len());
+  ASSERT_TRUE(stream->GetFileData(&file, &offset, &length));
+  EXPECT_NE(base::kInvalidPlatformFileValue, file);
+  EXPECT_EQ(2, offset);
+  EXPECT_EQ(5, length);
+  stream->MarkConsumedAndFillBuffer(3);
+  ASSERT_TRUE(stream->GetFileData(&file, &offset, &length));
+  EXPECT_EQ(5, offset);
+  EXPECT_EQ(2, length);
+
+  // The rest of the file can still go through the buffer.
+  stream->set_send_files_directly(false);
+  EXPECT_FALSE(stream->GetFileData(&file, &offset, &length));
+  ASSERT_EQ(2U, stream->buf_len());
+  EXPECT_EQ("56", std::string(stream->buf()->data(), 2));
+  stream->MarkConsumedAndFillBuffer(2);
+  EXPECT_TRUE(stream->eof());
+  EXPECT_EQ(stream->size(), stream->position());
+
+  file_util::Delete(temp_file_path, false);
+}
+
 void UploadDataStreamTest::FileChangedHelper(const FilePath& file_path,
                                              const base::Time& time,
                                              bool error_expected) {
@@ -123,4 +207,58 @@ TEST_F(UploadDataStreamTest, FileChanged) {
   file_util::Delete(temp_file_path, false);
 }
 
+TEST_F(UploadDataStreamTest, SendGZipped) {
+  // More than fits in the stream's buffer, uncompressed.
+  std::string data;
+  for (int i = 0; i < 10000; ++i)
+    data.append(kTestData);
+  upload_data_->AppendBytes(data.data(), static_cast<int>(data.size()));
+  upload_data_->AppendBytes(kTestData, kTestDataSize);
+  upload_data_->set_send_gzipped(true);
+
+  scoped_ptr<UploadDataStream> stream(
+      UploadDataStream::Create(upload_data_, NULL));
+  ASSERT_TRUE(stream.get());
+  EXPECT_TRUE(stream->is_gzipped());
+  EXPECT_TRUE(stream->is_chunked());
+
+  std::string gzipped;
+  while (!stream->eof()) {
+    ASSERT_GT(stream->buf_len(), 0u);
+    gzipped.append(stream->buf()->data(), stream->buf_len());
+    stream->MarkConsumedAndFillBuffer(stream->buf_len());
+  }
+  EXPECT_LT(gzipped.size(), data.size());
+  EXPECT_EQ(data + kTestData, GUnzip(gzipped));
+}
+
+TEST_F(UploadDataStreamTest, SendGZippedChunks) {
+  upload_data_->set_is_chunked(true);
+  upload_data_->set_send_gzipped(true);
+  upload_data_->AppendChunk(kTestData, kTestDataSize, false);
+
+  scoped_ptr<UploadDataStream> stream(
+      UploadDataStream::Create(upload_data_, NULL));
+  ASSERT_TRUE(stream.get());
+  EXPECT_TRUE(stream->is_gzipped());
+
+  // The first chunk is flushed without waiting for the others.
+  std::string gzipped;
+  ASSERT_GT(stream->buf_len(), 0u);
+  EXPECT_FALSE(stream->IsOnLastChunk());
+  gzipped.append(stream->buf()->data(), stream->buf_len());
+  stream->MarkConsumedAndFillBuffer(stream->buf_len());
+  EXPECT_EQ(0u, stream->buf_len());
+  EXPECT_FALSE(stream->eof());
+
+  upload_data_->AppendChunk(kTestData, kTestDataSize, true);
+  stream->MarkConsumedAndFillBuffer(0);
+  EXPECT_TRUE(stream->IsOnLastChunk());
+  while (!stream->eof()) {
+    gzipped.append(stream->buf()->data(), stream->buf_len());
+    stream->MarkConsumedAndFillBuffer(stream->buf_len());
+  }
+  EXPECT_EQ(std::string(kTestData) + kTestData, GUnzip(gzipped));
+}
+
 }  // namespace net
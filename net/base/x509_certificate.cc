@@ -151,6 +151,7 @@ X509Certificate::X509Certificate(const std::string& subject,
       cert_handle_(NULL),
       source_(SOURCE_UNUSED) {
   memset(fingerprint_.data, 0, sizeof(fingerprint_.data));
+  memset(chain_fingerprint_.data, 0, sizeof(chain_fingerprint_.data));
 }
 
 // static
@@ -541,6 +542,24 @@ X509Certificate::X509Certificate(OSCertHandle cert_handle,
     intermediate_ca_certs_.push_back(DupOSCertHandle(intermediates[i]));
   // Platform-specific initialization.
   Initialize();
+
+  // The chain fingerprint is the hash of the fingerprints of the chain, in
+  // order.
+  if (intermediate_ca_certs_.empty()) {
+    chain_fingerprint_ = fingerprint_;
+  } else {
+    std::string fingerprints(reinterpret_cast<const char*>(fingerprint_.data),
+                             sizeof(fingerprint_.data));
+    for (size_t i = 0; i < intermediate_ca_certs_.size(); ++i) {
+      SHA1Fingerprint fingerprint =
+          CalculateFingerprint(intermediate_ca_certs_[i]);
+      fingerprints.append(reinterpret_cast<const char*>(fingerprint.data),
+                          sizeof(fingerprint.data));
+    }
+    base::SHA1HashBytes(
+        reinterpret_cast<const unsigned char*>(fingerprints.data()),
+        fingerprints.size(), chain_fingerprint_.data);
+  }
 }
 
 X509Certificate::~X509Certificate() {
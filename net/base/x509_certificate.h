@@ -219,6 +219,13 @@ class NET_EXPORT X509Certificate : public base::RefCountedThreadSafe<X509Certifi
   // The fingerprint of this certificate.
   const SHA1Fingerprint& fingerprint() const { return fingerprint_; }
 
+  // A fingerprint of this certificate together with its intermediates, which
+  // identifies the chain given for verification.  It is fingerprint() if
+  // there are no intermediates.
+  const SHA1Fingerprint& chain_fingerprint() const {
+    return chain_fingerprint_;
+  }
+
   // Gets the DNS names in the certificate.  Pursuant to RFC 2818, Section 3.1
   // Server Identity, if the certificate has a subjectAltName extension of
   // type dNSName, this method gets the DNS names in that extension.
@@ -451,6 +458,9 @@ class NET_EXPORT X509Certificate : public base::RefCountedThreadSafe<X509Certifi
   // The fingerprint of this certificate.
   SHA1Fingerprint fingerprint_;
 
+  // The fingerprint of this certificate and |intermediate_ca_certs_|.
+  SHA1Fingerprint chain_fingerprint_;
+
   // The serial number of this certificate, DER encoded.
   std::string serial_number_;
 
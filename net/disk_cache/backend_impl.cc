@@ -344,6 +344,7 @@ BackendImpl::BackendImpl(const FilePath& path,
       mask_(0),
       max_size_(0),
       io_delay_(0),
+      doomed_children_(0),
       cache_type_(net::DISK_CACHE),
       uma_report_(0),
       user_flags_(0),
@@ -370,6 +371,7 @@ BackendImpl::BackendImpl(const FilePath& path,
       mask_(mask),
       max_size_(0),
       io_delay_(0),
+      doomed_children_(0),
       cache_type_(net::DISK_CACHE),
       uma_report_(0),
       user_flags_(kMask),
@@ -481,7 +483,8 @@ int BackendImpl::SyncInit() {
   if (!data_->header.this_id)
     data_->header.this_id++;
 
-  if (data_->header.crash) {
+  bool previous_crash = data_->header.crash != 0;
+  if (previous_crash) {
     ReportError(ERR_PREVIOUS_CRASH);
   } else {
     ReportError(0);
@@ -509,6 +512,14 @@ int BackendImpl::SyncInit() {
     return net::ERR_FAILED;
 
   disabled_ = !rankings_.Init(this, new_eviction_);
+  if (!disabled_ && !(user_flags_ & kUpgradeMode))
+    hot_set_.Init(this);
+  if (!disabled_ && !read_only_) {
+    // The unit tests decide when to check the cache.
+    verifier_.Init(this, previous_crash, !(user_flags_ & kNoRandom));
+  }
+  if (!disabled_)
+    filter_.Init(data_->table, mask_);
 
   return disabled_ ? net::ERR_FAILED : net::OK;
 }
@@ -516,10 +527,13 @@ int BackendImpl::SyncInit() {
 void BackendImpl::CleanupCache() {
   Trace("Backend Cleanup");
   eviction_.Stop();
+  verifier_.Stop();
   timer_.Stop();
 
   if (init_) {
     stats_.Store();
+    if (!read_only_)
+      hot_set_.Store();
     if (data_)
       data_->header.crash = 0;
 
@@ -529,6 +543,7 @@ void BackendImpl::CleanupCache() {
       DCHECK(!num_refs_);
     }
   }
+  hot_set_.Stop();
   block_files_.CloseFiles();
   factory_.RevokeAll();
   ptr_factory_.InvalidateWeakPtrs();
@@ -670,6 +685,7 @@ EntryImpl* BackendImpl::OpenEntryImpl(const std::string& key) {
   TimeTicks start = TimeTicks::Now();
   uint32 hash = Hash(key);
   Trace("Open hash 0x%x", hash);
+  eviction_.OnEntryRequested(hash);
 
   bool error;
   EntryImpl* cache_entry = MatchEntry(key, hash, false, Addr(), &error);
@@ -686,9 +702,12 @@ EntryImpl* BackendImpl::OpenEntryImpl(const std::string& key) {
   }
 
   eviction_.OnOpenEntry(cache_entry);
+  hot_set_.OnEntryUsed(cache_entry);
   entry_count_++;
 
   CACHE_UMA(AGE_MS, "OpenTime", GetSizeGroup(), start);
+  if (hot_set_.IsWarmingUp())
+    CACHE_UMA(AGE_MS, "StartupOpenTime", GetSizeGroup(), start);
   stats_.OnEvent(Stats::OPEN_HIT);
   SIMPLE_STATS_COUNTER("disk_cache.hit");
   return cache_entry;
@@ -701,6 +720,7 @@ EntryImpl* BackendImpl::CreateEntryImpl(const std::string& key) {
   TimeTicks start = TimeTicks::Now();
   uint32 hash = Hash(key);
   Trace("Create hash 0x%x", hash);
+  eviction_.OnEntryRequested(hash);
 
   scoped_refptr<EntryImpl> parent;
   Addr entry_address(data_->table[hash & mask_]);
@@ -736,6 +756,11 @@ EntryImpl* BackendImpl::CreateEntryImpl(const std::string& key) {
   // the current operation (as we do while manipulating the lists) so that we
   // can detect and cleanup (a) and (b).
 
+  if (!eviction_.ShouldAdmit(hash)) {
+    stats_.OnEvent(Stats::CREATE_REJECTED);
+    return NULL;
+  }
+
   int num_blocks = EntryImpl::NumBlocksForEntry(key.size());
   if (!block_files_.CreateBlock(BLOCK_256, num_blocks, &entry_address)) {
     LOG(ERROR) << "Create entry failed " << key.c_str();
@@ -779,6 +804,7 @@ EntryImpl* BackendImpl::CreateEntryImpl(const std::string& key) {
     parent->SetNextAddress(entry_address);
   } else {
     data_->table[hash & mask_] = entry_address.value();
+    filter_.OnBucketChanged(data_->table, hash);
   }
 
   // Link this entry through the lists.
@@ -907,6 +933,7 @@ void BackendImpl::RecoveredEntry(CacheRankingsBlock* rankings) {
     return;
 
   data_->table[hash & mask_] = address.value();
+  filter_.OnBucketChanged(data_->table, hash);
 }
 
 void BackendImpl::InternalDoomEntry(EntryImpl* entry) {
@@ -934,6 +961,7 @@ void BackendImpl::InternalDoomEntry(EntryImpl* entry) {
     parent_entry->Release();
   } else if (!error) {
     data_->table[hash & mask_] = child;
+    filter_.OnBucketChanged(data_->table, hash);
   }
 }
 
@@ -978,6 +1006,10 @@ int32 BackendImpl::GetCurrentEntryId() const {
   return data_->header.this_id;
 }
 
+void BackendImpl::OnChildEntryDoomed() {
+  doomed_children_++;
+}
+
 int BackendImpl::MaxFileSize() const {
   return max_size_ / 8;
 }
@@ -1176,8 +1208,11 @@ void BackendImpl::OnStatsTimer() {
   }
 
   // Save stats to disk at 5 min intervals.
-  if (time % 10 == 0)
+  if (time % 10 == 0) {
     stats_.Store();
+    if (!read_only_)
+      hot_set_.Store();
+  }
 }
 
 void BackendImpl::IncrementIoCount() {
@@ -1231,6 +1266,10 @@ void BackendImpl::TrimDeletedListForTest(bool empty) {
   eviction_.TrimDeletedList(empty);
 }
 
+int BackendImpl::VerifyForTest() {
+  return verifier_.RunForTest();
+}
+
 int BackendImpl::SelfCheck() {
   if (!init_) {
     LOG(ERROR) << "Init failed";
@@ -1271,6 +1310,12 @@ int32 BackendImpl::GetEntryCount() const {
 int BackendImpl::OpenEntry(const std::string& key, Entry** entry,
                            CompletionCallback* callback) {
   DCHECK(callback);
+  // Most misses are for keys that were never stored, and there is no need to
+  // go to the cache thread to find out. An entry that is being created may not
+  // be on the filter yet.
+  if (!background_queue_.HasPendingCreates() && !filter_.MayContain(Hash(key)))
+    return net::ERR_FAILED;
+
   background_queue_.OpenEntry(key, entry, callback);
   return net::ERR_IO_PENDING;
 }
@@ -1344,6 +1389,11 @@ void BackendImpl::GetStats(StatsItems* stats) {
   item.second = base::StringPrintf("%d", data_->header.num_bytes);
   stats->push_back(item);
 
+  item.first = "Hit ratio per MB";
+  item.second = base::StringPrintf(
+      "%d", stats_.GetHitRatioPerMegabyte(data_->header.num_bytes));
+  stats->push_back(item);
+
   stats_.GetItems(stats);
 }
 
@@ -1491,8 +1541,11 @@ void BackendImpl::PrepareForRestart() {
 #ifdef ANDROID
   }
 #endif
+  filter_.Disable();
   index_ = NULL;
   data_ = NULL;
+  hot_set_.Stop();
+  verifier_.Stop();
   block_files_.CloseFiles();
   rankings_.Reset();
   init_ = false;
@@ -1612,10 +1665,12 @@ EntryImpl* BackendImpl::MatchEntry(const std::string& key, uint32 hash,
         parent_entry = NULL;
       } else {
         data_->table[hash & mask_] = child.value();
+        filter_.OnBucketChanged(data_->table, hash);
       }
 
       Trace("MatchEntry dirty %d 0x%x 0x%x", find_parent, entry_addr.value(),
             address.value());
+      verifier_.OnInconsistency();
 
       if (!error) {
         // It is important to call DestroyInvalidEntry after removing this
@@ -1778,6 +1833,7 @@ EntryImpl* BackendImpl::GetEnumeratedEntry(CacheRankingsBlock* next,
   EntryImpl* entry;
   int rv = NewEntry(Addr(next->Data()->contents), &entry);
   if (rv) {
+    verifier_.OnInconsistency();
     rankings_.Remove(next, list, false);
     if (rv == ERR_INVALID_ADDRESS) {
       // There is nothing linked from the index. Delete the rankings node.
@@ -1845,6 +1901,83 @@ void BackendImpl::DestroyInvalidEntry(EntryImpl* entry) {
   stats_.OnEvent(Stats::INVALID_ENTRY);
 }
 
+int BackendImpl::VerifyBucket(int bucket) {
+  int num_fixed = 0;
+  Addr address(data_->table[bucket]);
+  scoped_refptr<EntryImpl> cache_entry, parent_entry;
+  std::set<CacheAddr> visited;
+
+  while (address.is_initialized() && !disabled_) {
+    if (visited.find(address.value()) != visited.end()) {
+      // A loop on the collision list. Just break it.
+      Trace("VerifyBucket loop 0x%x", address.value());
+      if (parent_entry) {
+        parent_entry->SetNextAddress(Addr(0));
+      } else {
+        // Every node that was visited was dropped.
+        data_->table[bucket] = 0;
+        filter_.OnBucketChanged(data_->table, bucket);
+      }
+      num_fixed++;
+      break;
+    }
+    visited.insert(address.value());
+
+    EntriesMap::iterator it = open_entries_.find(address.value());
+    if (it != open_entries_.end()) {
+      // An entry in use is fine.
+      parent_entry = it->second;
+      address.set_value(parent_entry->GetNextAddress());
+      continue;
+    }
+
+    EntryImpl* tmp = NULL;
+    int error = NewEntry(address, &tmp);
+    cache_entry.swap(&tmp);
+
+    bool linked = true;
+    if (!error && !cache_entry->dirty() &&
+        (cache_entry->entry()->Data()->hash & mask_) == static_cast<uint32>(
+            bucket)) {
+      linked = rankings_.IsLinked(cache_entry->rankings());
+      if (linked) {
+        parent_entry.swap(cache_entry);
+        address.set_value(parent_entry->GetNextAddress());
+        continue;
+      }
+    }
+
+    // Take this entry out of the collision list.
+    Addr child(0);
+    if (!error)
+      child.set_value(cache_entry->GetNextAddress());
+
+    if (parent_entry) {
+      parent_entry->SetNextAddress(child);
+    } else {
+      data_->table[bucket] = child.value();
+      filter_.OnBucketChanged(data_->table, bucket);
+    }
+
+    Trace("VerifyBucket drop %d 0x%x", error, address.value());
+    num_fixed++;
+    if (!error) {
+      if (!linked) {
+        // The rankings list doesn't know about this node anymore.
+        CacheRankingsBlock* node = cache_entry->rankings();
+        node->Data()->next = 0;
+        node->Data()->prev = 0;
+        node->Store();
+      }
+      DestroyInvalidEntry(cache_entry);
+      cache_entry = NULL;
+    }
+    address = child;
+  }
+
+  return num_fixed;
+}
+
 void BackendImpl::AddStorageSize(int32 bytes) {
   data_->header.num_bytes += bytes;
   DCHECK_GE(data_->header.num_bytes, 0);
@@ -1947,6 +2080,8 @@ void BackendImpl::ReportStats() {
   CACHE_UMA(HOURS, "UseTime", 0, static_cast<int>(use_hours));
   CACHE_UMA(PERCENTAGE, "HitRatio", data_->header.experiment,
             stats_.GetHitRatio());
+  CACHE_UMA(COUNTS_10000, "HitRatioPerMB", 0,
+            stats_.GetHitRatioPerMegabyte(data_->header.num_bytes));
 
   int64 trim_rate = stats_.GetCounter(Stats::TRIM_ENTRY) / use_hours;
   CACHE_UMA(COUNTS, "TrimRate", 0, static_cast<int>(trim_rate));
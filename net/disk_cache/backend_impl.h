@@ -13,11 +13,14 @@
 #include "base/timer.h"
 #include "net/disk_cache/block_files.h"
 #include "net/disk_cache/disk_cache.h"
+#include "net/disk_cache/entry_filter.h"
 #include "net/disk_cache/eviction.h"
+#include "net/disk_cache/hot_set.h"
 #include "net/disk_cache/in_flight_backend_io.h"
 #include "net/disk_cache/rankings.h"
 #include "net/disk_cache/stats.h"
 #include "net/disk_cache/trace.h"
+#include "net/disk_cache/verifier.h"
 
 namespace net {
 class NetLog;
@@ -34,13 +37,17 @@ enum BackendFlags {
   kNewEviction = 1 << 4,        // Use of new eviction was specified.
   kNoRandom = 1 << 5,           // Don't add randomness to the behavior.
   kNoLoadProtection = 1 << 6,   // Don't act conservatively under load.
-  kNoBuffering = 1 << 7         // Disable extended IO buffering.
+  kNoBuffering = 1 << 7,        // Disable extended IO buffering.
+  kAdmissionFilter = 1 << 8,    // Filter new entries by access frequency.
+  kSegmentedLru = 1 << 9        // Use segmented LRU with the new eviction.
 };
 
 // This class implements the Backend interface. An object of this
 // class handles the operations of the cache for a particular profile.
 class BackendImpl : public Backend {
   friend class Eviction;
+  friend class HotSet;
+  friend class Verifier;
  public:
   BackendImpl(const FilePath& path, base::MessageLoopProxy* cache_thread,
               net::NetLog* net_log);
@@ -98,6 +105,11 @@ class BackendImpl : public Backend {
   // Returns the actual file used to store a given (non-external) address.
   MappedFile* File(Addr address);
 
+  // Returns the journal used for the rankings blocks.
+  Journal* journal() {
+    return block_files_.journal();
+  }
+
   InFlightBackendIO* background_queue() {
     return &background_queue_;
   }
@@ -146,6 +158,15 @@ class BackendImpl : public Backend {
   // Returns the id being used on this run of the cache.
   int32 GetCurrentEntryId() const;
 
+  // A child entry of a sparse entry is being doomed.
+  void OnChildEntryDoomed();
+
+  // Returns the number of child entries doomed since the cache started, so
+  // that SparseControl can tell when what it knows about children is stale.
+  int32 doomed_children() const {
+    return doomed_children_;
+  }
+
   // Returns the maximum size for a file to reside on the cache.
   int MaxFileSize() const;
 
@@ -242,6 +263,11 @@ class BackendImpl : public Backend {
   // entries. This method should be called directly on the cache thread.
   void TrimDeletedListForTest(bool empty);
 
+  // Checks the whole cache, fixing whatever is wrong, and returns the number
+  // of problems found. This method should be called directly on the cache
+  // thread.
+  int VerifyForTest();
+
   // Peforms a simple self-check, and returns the number of dirty items
   // or an error code (negative value).
   int SelfCheck();
@@ -308,6 +334,11 @@ class BackendImpl : public Backend {
 
   void DestroyInvalidEntry(EntryImpl* entry);
 
+  // Walks the collision list of |bucket| on the index, dropping the entries
+  // that are dirty, belong to another bucket or are not on a rankings list.
+  // Returns the number of problems fixed.
+  int VerifyBucket(int bucket);
+
   // Handles the used storage count.
   void AddStorageSize(int32 bytes);
   void SubstractStorageSize(int32 bytes);
@@ -348,6 +379,9 @@ class BackendImpl : public Backend {
   uint32 mask_;  // Binary mask to map a hash to the hash table.
   int32 max_size_;  // Maximum data size for this instance.
   Eviction eviction_;  // Handler of the eviction algorithm.
+  HotSet hot_set_;  // Recently used blocks, to be prefetched on startup.
+  Verifier verifier_;  // Background check of the cache structures.
+  EntryFilter filter_;  // Buckets of the index in use, read by OpenEntry().
   EntriesMap open_entries_;  // Map of open entries.
   int num_refs_;  // Number of referenced cache entries.
   int max_refs_;  // Max number of referenced cache entries.
@@ -356,6 +390,7 @@ class BackendImpl : public Backend {
   int byte_count_;  // Number of bytes read/written lately.
   int buffer_bytes_;  // Total size of the temporary entries' buffers.
   int io_delay_;  // Average time (ms) required to complete some IO operations.
+  int32 doomed_children_;  // Number of child entries doomed on this run.
   net::CacheType cache_type_;
   int uma_report_;  // Controls transmision of UMA data.
   uint32 user_flags_;  // Flags set by the user.
@@ -15,9 +15,11 @@
 #include "net/disk_cache/cache_util.h"
 #include "net/disk_cache/disk_cache_test_base.h"
 #include "net/disk_cache/disk_cache_test_util.h"
+#include "net/disk_cache/entry_impl.h"
 #include "net/disk_cache/histogram_macros.h"
 #include "net/disk_cache/mapped_file.h"
 #include "net/disk_cache/mem_backend_impl.h"
+#include "net/disk_cache/sharded_backend.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 #if defined(OS_WIN)
@@ -60,6 +62,8 @@ class DiskCacheBackendTest : public DiskCacheTestWithCache {
   void BackendDisable2();
   void BackendDisable3();
   void BackendDisable4();
+  void BackendVerifyBrokenList();
+  void BackendVerifySelfLoop();
 };
 
 void DiskCacheBackendTest::BackendBasics() {
@@ -230,6 +234,77 @@ TEST_F(DiskCacheTest, CreateBackend) {
   MessageLoop::current()->RunAllPending();
 }
 
+// Tests the basic operations of a sharded backend.
+TEST_F(DiskCacheTest, ShardedBackend) {
+  TestCompletionCallback cb;
+  FilePath path = GetCacheFilePath();
+  ASSERT_TRUE(DeleteCache(path));
+
+  const int kNumShards = 4;
+  disk_cache::Backend* cache = NULL;
+  int rv = disk_cache::ShardedBackend::CreateBackend(
+               path, false, 20 * 1024 * 1024, net::DISK_CACHE,
+               disk_cache::kNoRandom, kNumShards, NULL, &cache, &cb);
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+  ASSERT_TRUE(cache);
+  disk_cache::ShardedBackend* sharded =
+      static_cast<disk_cache::ShardedBackend*>(cache);
+  EXPECT_EQ(kNumShards, sharded->num_shards());
+
+  // Keys should be spread among the shards.
+  const int kNumEntries = 40;
+  std::vector<int> entries_per_shard(kNumShards, 0);
+  for (int i = 0; i < kNumEntries; i++) {
+    std::string key = base::StringPrintf("the key %d", i);
+    entries_per_shard[sharded->GetShardForKey(key)]++;
+
+    disk_cache::Entry* entry;
+    rv = cache->CreateEntry(key, &entry, &cb);
+    ASSERT_EQ(net::OK, cb.GetResult(rv));
+    entry->Close();
+  }
+  for (int i = 0; i < kNumShards; i++)
+    EXPECT_LT(0, entries_per_shard[i]);
+  EXPECT_EQ(kNumEntries, cache->GetEntryCount());
+
+  disk_cache::Entry* entry;
+  rv = cache->OpenEntry("the key 7", &entry, &cb);
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+  EXPECT_EQ("the key 7", entry->GetKey());
+  entry->Close();
+
+  rv = cache->DoomEntry("the key 7", &cb);
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+  rv = cache->OpenEntry("the key 7", &entry, &cb);
+  EXPECT_NE(net::OK, cb.GetResult(rv));
+
+  // The enumeration goes through all the shards.
+  void* iter = NULL;
+  int count = 0;
+  for (;;) {
+    rv = cache->OpenNextEntry(&iter, &entry, &cb);
+    if (cb.GetResult(rv) != net::OK)
+      break;
+    entry->Close();
+    count++;
+  }
+  EXPECT_EQ(kNumEntries - 1, count);
+  EXPECT_TRUE(NULL == iter);
+
+  // An enumeration can be ended early.
+  rv = cache->OpenNextEntry(&iter, &entry, &cb);
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+  entry->Close();
+  cache->EndEnumeration(&iter);
+
+  rv = cache->DoomAllEntries(&cb);
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+  EXPECT_EQ(0, cache->GetEntryCount());
+
+  delete cache;
+  MessageLoop::current()->RunAllPending();
+}
+
 TEST_F(DiskCacheBackendTest, ExternalFiles) {
   InitCache();
   // First, let's create a file on the folder.
@@ -432,6 +507,41 @@ TEST_F(DiskCacheBackendTest, MemoryOnlySetSize) {
   BackendSetSize();
 }
 
+// Under pressure, the memory only cache drops the least recently used entries
+// that are not in use.
+TEST_F(DiskCacheBackendTest, MemoryOnlyPurgeMemory) {
+  SetMemoryOnlyMode();
+  InitCache();
+
+  const int kSize = 20000;
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(kSize));
+  CacheTestFillBuffer(buffer->data(), kSize, false);
+  disk_cache::Entry* first;
+  for (int i = 0; i < 4; i++) {
+    disk_cache::Entry* entry;
+    ASSERT_EQ(net::OK, CreateEntry(base::StringPrintf("key%d", i), &entry));
+    EXPECT_EQ(kSize, WriteData(entry, 0, 0, buffer, kSize, false));
+    if (i)
+      entry->Close();
+    else
+      first = entry;
+  }
+
+  // Half the data goes, but not the first entry, which is in use.
+  EXPECT_LT(0u, cache_->PurgeMemory(net::MEMORY_PRESSURE_MODERATE));
+  EXPECT_EQ(2, cache_->GetEntryCount());
+  disk_cache::Entry* entry;
+  ASSERT_EQ(net::OK, OpenEntry("key3", &entry));
+  entry->Close();
+
+  EXPECT_LT(0u, cache_->PurgeMemory(net::MEMORY_PRESSURE_CRITICAL));
+  EXPECT_EQ(1, cache_->GetEntryCount());
+  EXPECT_EQ(0u, cache_->PurgeMemory(net::MEMORY_PRESSURE_CRITICAL));
+  first->Close();
+  ASSERT_EQ(net::OK, OpenEntry("key0", &entry));
+  entry->Close();
+}
+
 void DiskCacheBackendTest::BackendLoad() {
   InitCache();
   int seed = static_cast<int>(Time::Now().ToInternalValue());
@@ -525,6 +635,111 @@ TEST_F(DiskCacheBackendTest, NewEvictionTrim) {
   entry->Close();
 }
 
+// Tests that the admission filter rejects new entries when the cache is full,
+// unless the entry is requested more often than the evicted entries.
+TEST_F(DiskCacheBackendTest, AdmissionFilter) {
+  SetBackendFlags(disk_cache::kAdmissionFilter);
+  SetMaxSize(0x3000);  // 12 kB, so the cache is always full.
+  InitCache();
+
+  disk_cache::Entry* entry;
+  ASSERT_EQ(net::OK, CreateEntry("Key 0", &entry));
+  entry->Close();
+
+  // Evict one entry, requested only once.
+  TrimForTest(false);
+  EXPECT_NE(net::OK, OpenEntry("Key 0", &entry));
+
+  // A new key is not more popular than the evicted entry.
+  EXPECT_NE(net::OK, CreateEntry("Key 1", &entry));
+
+  // But it is after being requested again.
+  ASSERT_EQ(net::OK, CreateEntry("Key 1", &entry));
+  entry->Close();
+  EXPECT_EQ(1, cache_->GetEntryCount());
+}
+
+// Tests that opening a key that is not stored fails without going to the cache
+// thread.
+TEST_F(DiskCacheBackendTest, OpenMissIsSynchronous) {
+  InitCache();
+
+  disk_cache::Entry* entry;
+  TestCompletionCallback cb;
+  EXPECT_EQ(net::ERR_FAILED, cache_->OpenEntry("the first key", &entry, &cb));
+
+  // The entry that is being created is found.
+  int rv = cache_->CreateEntry("the first key", &entry, &cb);
+  disk_cache::Entry* entry2;
+  TestCompletionCallback cb2;
+  int rv2 = cache_->OpenEntry("the first key", &entry2, &cb2);
+  EXPECT_EQ(net::ERR_IO_PENDING, rv2);
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+  ASSERT_EQ(net::OK, cb2.GetResult(rv2));
+  entry->Close();
+  entry2->Close();
+
+  ASSERT_EQ(net::OK, CreateEntry("the second key", &entry));
+  entry->Close();
+
+  // And so are the entries of a previous run.
+  delete cache_;
+  cache_ = NULL;
+  cache_impl_ = NULL;
+  DisableFirstCleanup();
+  InitCache();
+  rv = cache_->OpenEntry("the first key", &entry, &cb);
+  EXPECT_EQ(net::ERR_IO_PENDING, rv);
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+  entry->Close();
+  EXPECT_EQ(net::ERR_FAILED, cache_->OpenEntry("some other key", &entry, &cb));
+
+  ASSERT_EQ(net::OK, DoomEntry("the first key"));
+  EXPECT_EQ(net::ERR_FAILED, cache_->OpenEntry("the first key", &entry, &cb));
+  ASSERT_EQ(net::OK, OpenEntry("the second key", &entry));
+  entry->Close();
+}
+
+// Tests that the recently used entries are saved on the hot set manifest, and
+// that the cache works as usual when the manifest is used on startup.
+TEST_F(DiskCacheBackendTest, HotSetManifest) {
+  SetDirectMode();
+  InitCache();
+
+  const int kSize = 200;
+  scoped_refptr<net::IOBuffer> buffer1(new net::IOBuffer(kSize));
+  CacheTestFillBuffer(buffer1->data(), kSize, false);
+
+  disk_cache::Entry* entry;
+  for (int i = 0; i < 10; i++) {
+    std::string key(StringPrintf("Key %d", i));
+    ASSERT_EQ(net::OK, CreateEntry(key, &entry));
+    EXPECT_EQ(kSize, WriteData(entry, 0, 0, buffer1, kSize, false));
+    entry->Close();
+  }
+  for (int i = 0; i < 5; i++) {
+    ASSERT_EQ(net::OK, OpenEntry(StringPrintf("Key %d", i), &entry));
+    entry->Close();
+  }
+
+  delete cache_;
+  cache_ = NULL;
+  cache_impl_ = NULL;
+  FilePath manifest = GetCacheFilePath().AppendASCII("hot_set");
+  EXPECT_TRUE(file_util::PathExists(manifest));
+
+  DisableFirstCleanup();
+  InitCache();
+  scoped_refptr<net::IOBuffer> buffer2(new net::IOBuffer(kSize));
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(net::OK, OpenEntry(StringPrintf("Key %d", i), &entry));
+    EXPECT_EQ(kSize, ReadData(entry, 0, 0, buffer2, kSize));
+    EXPECT_EQ(0, memcmp(buffer1->data(), buffer2->data(), kSize));
+    entry->Close();
+  }
+  EXPECT_EQ(10, cache_->GetEntryCount());
+}
+
 // Before looking for invalid entries, let's check a valid entry.
 void DiskCacheBackendTest::BackendValidEntry() {
   SetDirectMode();
@@ -1496,6 +1711,92 @@ TEST_F(DiskCacheBackendTest, NewEvictionInvalidEntry6) {
   entry->Close();
 }
 
+// Tests that a broken rankings list is repaired in place, and that only the
+// entry that cannot be trusted is dropped.
+void DiskCacheBackendTest::BackendVerifyBrokenList() {
+  SetDirectMode();
+  UseCurrentThread();
+  InitCache();
+
+  const int kNumEntries = 5;
+  disk_cache::Entry* entries[kNumEntries];
+  for (int i = 0; i < kNumEntries; i++) {
+    ASSERT_EQ(net::OK,
+              CreateEntry(base::StringPrintf("key%d", i), &entries[i]));
+  }
+  EXPECT_EQ(0, cache_impl_->VerifyForTest());
+
+  // Make the node of the middle entry look like another head of the list.
+  disk_cache::CacheRankingsBlock* node =
+      static_cast<disk_cache::EntryImpl*>(entries[2])->rankings();
+  node->Data()->prev = node->address().value();
+  node->Store();
+  for (int i = 0; i < kNumEntries; i++)
+    entries[i]->Close();
+  FlushQueueForTest();
+
+  // One broken link, and one entry out of the list.
+  EXPECT_EQ(2, cache_impl_->VerifyForTest());
+  EXPECT_EQ(0, cache_impl_->VerifyForTest());
+  EXPECT_EQ(kNumEntries - 1, cache_->GetEntryCount());
+
+  disk_cache::Entry* entry;
+  EXPECT_NE(net::OK, OpenEntry("key2", &entry));
+
+  // The rest of the entries can be enumerated, and opened.
+  void* iter = NULL;
+  int count = 0;
+  while (OpenNextEntry(&iter, &entry) == net::OK) {
+    entry->Close();
+    count++;
+  }
+  EXPECT_EQ(kNumEntries - 1, count);
+
+  for (int i = 0; i < kNumEntries; i++) {
+    if (i == 2)
+      continue;
+    ASSERT_EQ(net::OK, OpenEntry(base::StringPrintf("key%d", i), &entry));
+    entry->Close();
+  }
+}
+
+TEST_F(DiskCacheBackendTest, VerifyBrokenList) {
+  BackendVerifyBrokenList();
+}
+
+TEST_F(DiskCacheBackendTest, NewEvictionVerifyBrokenList) {
+  SetNewEviction();
+  BackendVerifyBrokenList();
+}
+
+// Tests that a bad head of a collision list that points back to itself is
+// taken out of the index.
+void DiskCacheBackendTest::BackendVerifySelfLoop() {
+  SetDirectMode();
+  UseCurrentThread();
+  InitCache();
+
+  disk_cache::Entry* entry;
+  ASSERT_EQ(net::OK, CreateEntry("the first key", &entry));
+  disk_cache::EntryImpl* entry_impl =
+      static_cast<disk_cache::EntryImpl*>(entry);
+
+  // Move the entry to another bucket, and make it its own next entry.
+  entry_impl->entry()->Data()->hash ^= 1;
+  entry_impl->SetNextAddress(entry_impl->entry()->address());
+  entry->Close();
+  FlushQueueForTest();
+
+  // The entry is dropped, and the loop is noticed.
+  EXPECT_EQ(2, cache_impl_->VerifyForTest());
+  EXPECT_EQ(0, cache_impl_->VerifyForTest());
+  EXPECT_NE(net::OK, OpenEntry("the first key", &entry));
+}
+
+TEST_F(DiskCacheBackendTest, VerifySelfLoop) {
+  BackendVerifySelfLoop();
+}
+
 // We want to be able to deal with abnormal dirty entries.
 void DiskCacheBackendTest::BackendNotMarkedButDirty(const std::string& name) {
   ASSERT_TRUE(CopyTestCache(name));
@@ -19,6 +19,7 @@ using base::TimeTicks;
 namespace {
 
 const char* kBlockName = "data_";
+const char* kJournalName = "journal";
 
 // This array is used to perform a fast lookup of the nibble bit pattern to the
 // type of entry that can be stored there (number of consecutive blocks).
@@ -31,6 +32,47 @@ inline int GetMapBlockType(uint8 value) {
   return s_types[value];
 }
 
+// Returns a mask with the lowest bit of each nibble of |map_block| set when that
+// nibble has exactly |target| empty blocks at the end (in other words, when the
+// type of the nibble is |target|), so that a whole 32-block chunk of the map is
+// processed at once. Blocks are allocated from the lowest bit of each nibble.
+inline uint32 GetMapBlocksOfType(uint32 map_block, int target) {
+  // The top |target| bits of a nibble must be empty...
+  const uint32 kTopMasks[] = {0x88888888, 0xCCCCCCCC, 0xEEEEEEEE, 0xFFFFFFFF};
+  uint32 used = map_block & kTopMasks[target - 1];
+  used = (used | (used >> 1) | (used >> 2) | (used >> 3)) & 0x11111111;
+  uint32 matches = ~used & 0x11111111;
+
+  // ... and the next bit must be used.
+  if (target < disk_cache::kMaxNumBlocks)
+    matches &= map_block >> (3 - target);
+  return matches;
+}
+
+// Returns the number of bits set on |value|.
+inline int CountBits(uint32 value) {
+  value = value - ((value >> 1) & 0x55555555);
+  value = (value & 0x33333333) + ((value >> 2) & 0x33333333);
+  return (((value + (value >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
+// Returns the position of the lowest nibble selected by |matches|, a non-zero
+// value returned by GetMapBlocksOfType().
+inline int LowestMapBlock(uint32 matches) {
+  int nibble = 0;
+  if (!(matches & 0xFFFF)) {
+    matches >>= 16;
+    nibble += 4;
+  }
+  if (!(matches & 0xFF)) {
+    matches >>= 8;
+    nibble += 2;
+  }
+  if (!(matches & 0xF))
+    nibble++;
+  return nibble;
+}
+
 void FixAllocationCounters(disk_cache::BlockFileHeader* header);
 
 // Creates a new entry on the allocation map, updating the apropriate counters.
@@ -46,34 +88,38 @@ bool CreateMapBlock(int target, int size, disk_cache::BlockFileHeader* header,
 
   TimeTicks start = TimeTicks::Now();
   // We are going to process the map on 32-block chunks (32 bits), and on every
-  // chunk, iterate through the 8 nibbles where the new block can be located.
+  // chunk, look at the 8 nibbles where the new block can be located at once.
   int current = header->hints[target - 1];
   for (int i = 0; i < header->max_entries / 32; i++, current++) {
     if (current == header->max_entries / 32)
       current = 0;
     uint32 map_block = header->allocation_map[current];
+    if (map_block == 0xFFFFFFFF)
+      continue;
+
+    uint32 matches = GetMapBlocksOfType(map_block, target);
+    if (!matches)
+      continue;
 
-    for (int j = 0; j < 8; j++, map_block >>= 4) {
-      if (GetMapBlockType(map_block) != target)
-        continue;
-
-      disk_cache::FileLock lock(header);
-      int index_offset = j * 4 + 4 - target;
-      *index = current * 32 + index_offset;
-      DCHECK_EQ(*index / 4, (*index + size - 1) / 4);
-      uint32 to_add = ((1 << size) - 1) << index_offset;
-      header->allocation_map[current] |= to_add;
-
-      header->hints[target - 1] = current;
-      header->empty[target - 1]--;
-      DCHECK(header->empty[target - 1] >= 0);
-      header->num_entries++;
-      if (target != size) {
-        header->empty[target - size - 1]++;
-      }
-      HISTOGRAM_TIMES("DiskCache.CreateBlock", TimeTicks::Now() - start);
-      return true;
+    int j = LowestMapBlock(matches);
+    DCHECK_EQ(target, GetMapBlockType(map_block >> (j * 4)));
+
+    disk_cache::FileLock lock(header);
+    int index_offset = j * 4 + 4 - target;
+    *index = current * 32 + index_offset;
+    DCHECK_EQ(*index / 4, (*index + size - 1) / 4);
+    uint32 to_add = ((1 << size) - 1) << index_offset;
+    header->allocation_map[current] |= to_add;
+
+    header->hints[target - 1] = current;
+    header->empty[target - 1]--;
+    DCHECK(header->empty[target - 1] >= 0);
+    header->num_entries++;
+    if (target != size) {
+      header->empty[target - size - 1]++;
     }
+    HISTOGRAM_TIMES("DiskCache.CreateBlock", TimeTicks::Now() - start);
+    return true;
   }
 
   // It is possible to have an undetected corruption (for example when the OS
@@ -143,24 +189,28 @@ bool UsedMapBlock(int index, int size, disk_cache::BlockFileHeader* header) {
 }
 #endif  // NDEBUG
 
-// Restores the "empty counters" and allocation hints.
-void FixAllocationCounters(disk_cache::BlockFileHeader* header) {
-  for (int i = 0; i < disk_cache::kMaxNumBlocks; i++) {
-    header->hints[i] = 0;
-    header->empty[i] = 0;
-  }
+// Computes the "empty counters" from the allocation map of |header|.
+void CountEmptyBlocks(const disk_cache::BlockFileHeader* header,
+                      int32* empty) {
+  for (int i = 0; i < disk_cache::kMaxNumBlocks; i++)
+    empty[i] = 0;
 
   for (int i = 0; i < header->max_entries / 32; i++) {
     uint32 map_block = header->allocation_map[i];
 
-    for (int j = 0; j < 8; j++, map_block >>= 4) {
-      int type = GetMapBlockType(map_block);
-      if (type)
-        header->empty[type -1]++;
-    }
+    for (int type = 1; type <= disk_cache::kMaxNumBlocks; type++)
+      empty[type - 1] += CountBits(GetMapBlocksOfType(map_block, type));
   }
 }
 
+// Restores the "empty counters" and allocation hints.
+void FixAllocationCounters(disk_cache::BlockFileHeader* header) {
+  for (int i = 0; i < disk_cache::kMaxNumBlocks; i++)
+    header->hints[i] = 0;
+
+  CountEmptyBlocks(header, header->empty);
+}
+
 // Returns true if the current block file should not be used as-is to store more
 // records. |block_count| is the number of blocks to allocate.
 bool NeedToGrowBlockFile(const disk_cache::BlockFileHeader* header,
@@ -203,6 +253,9 @@ bool BlockFiles::Init(bool create_files) {
 
   thread_checker_.reset(new base::ThreadChecker);
 
+  // Without a journal the rankings blocks are written directly.
+  journal_.Init(path_.AppendASCII(kJournalName), this, create_files);
+
   block_files_.resize(kFirstAdditionalBlockFile);
   for (int i = 0; i < kFirstAdditionalBlockFile; i++) {
     if (create_files)
@@ -216,6 +269,9 @@ bool BlockFiles::Init(bool create_files) {
     RemoveEmptyFile(static_cast<FileType>(i + 1));
   }
 
+  // Write the blocks left by the previous instance.
+  journal_.Flush();
+
   init_ = true;
   return true;
 }
@@ -290,8 +346,12 @@ void BlockFiles::DeleteBlock(Addr address, bool deep) {
   size_t size = address.BlockSize() * address.num_blocks();
   size_t offset = address.start_block() * address.BlockSize() +
                   kBlockHeaderSize;
-  if (deep)
-    file->Write(zero_buffer_, size, offset);
+  if (deep) {
+    if (RANKINGS == address.file_type() && journal_.IsValid())
+      journal_.Store(address.FileNumber(), offset, zero_buffer_, size);
+    else
+      file->Write(zero_buffer_, size, offset);
+  }
 
   BlockFileHeader* header = reinterpret_cast<BlockFileHeader*>(file->buffer());
   DeleteMapBlock(address.start_block(), address.num_blocks(), header);
@@ -309,6 +369,8 @@ void BlockFiles::CloseFiles() {
   if (init_) {
     DCHECK(thread_checker_->CalledOnValidThread());
   }
+  journal_.Close();
+
   init_ = false;
   for (unsigned int i = 0; i < block_files_.size(); i++) {
     if (block_files_[i]) {
@@ -367,6 +429,34 @@ bool BlockFiles::IsValid(Addr address) {
 #endif
 }
 
+bool BlockFiles::VerifyFile(int index, bool* fixed) {
+  DCHECK(thread_checker_->CalledOnValidThread());
+  *fixed = false;
+  if (!init_ || static_cast<unsigned int>(index) >= block_files_.size())
+    return false;
+
+  MappedFile* file = block_files_[index];
+  if (!file)
+    return true;
+
+  BlockFileHeader* header = reinterpret_cast<BlockFileHeader*>(file->buffer());
+  int32 empty[kMaxNumBlocks];
+  CountEmptyBlocks(header, empty);
+  bool valid = !header->updating;
+  for (int i = 0; i < kMaxNumBlocks; i++)
+    valid = valid && header->empty[i] == empty[i];
+  if (valid)
+    return true;
+
+  LOG(WARNING) << "Fixing the header of block file " << index;
+  *fixed = true;
+  if (!FixBlockFileHeader(file)) {
+    // Make sure that this file is replaced on the next start.
+    header->updating = 100;
+  }
+  return true;
+}
+
 bool BlockFiles::CreateBlockFile(int index, FileType file_type, bool force) {
   FilePath name = Name(index);
   int flags =
@@ -432,6 +522,11 @@ bool BlockFiles::OpenBlockFile(int index) {
       return false;
   }
 
+  if (Addr::BlockSizeForFileType(RANKINGS) == header->entry_size &&
+      journal_.IsValid()) {
+    file->set_journal(&journal_, index);
+  }
+
   DCHECK(!block_files_[index]);
   file.swap(&block_files_[index]);
   return true;
@@ -526,6 +621,10 @@ void BlockFiles::RemoveEmptyFile(FileType block_type) {
   MappedFile* file = block_files_[block_type - 1];
   BlockFileHeader* header = reinterpret_cast<BlockFileHeader*>(file->buffer());
 
+  // Don't leave pending blocks for a file that may go away.
+  if (RANKINGS == block_type && header->next_file)
+    journal_.Flush();
+
   while (header->next_file) {
     // Only the block_file argument is relevant for what we want.
     Addr address(BLOCK_256, 1, header->next_file, 0);
@@ -14,6 +14,7 @@
 #include "base/gtest_prod_util.h"
 #include "base/memory/scoped_ptr.h"
 #include "net/disk_cache/addr.h"
+#include "net/disk_cache/journal.h"
 #include "net/disk_cache/mapped_file.h"
 
 namespace base {
@@ -56,6 +57,17 @@ class BlockFiles {
   // This method is only intended for debugging.
   bool IsValid(Addr address);
 
+  // Checks the header of the block file number |index|, if it is open, against
+  // its allocation map, and fixes the empty counters if they don't match.
+  // Returns false if |index| is past the last file. |fixed| is set to true if
+  // the header was modified.
+  bool VerifyFile(int index, bool* fixed);
+
+  // Returns the journal used for the rankings blocks.
+  Journal* journal() {
+    return &journal_;
+  }
+
  private:
   // Set force to true to overwrite the file if it exists.
   bool CreateBlockFile(int index, FileType file_type, bool force);
@@ -89,6 +101,7 @@ class BlockFiles {
   char* zero_buffer_;  // Buffer to speed-up cleaning deleted entries.
   FilePath path_;  // Path to the backing folder.
   std::vector<MappedFile*> block_files_;  // The actual files.
+  Journal journal_;  // Pending writes of rankings blocks.
   scoped_ptr<base::ThreadChecker> thread_checker_;
 
   FRIEND_TEST_ALL_PREFIXES(DiskCacheTest, BlockFiles_ZeroSizeFile);
@@ -7,6 +7,7 @@
 #include "net/disk_cache/disk_cache.h"
 #include "net/disk_cache/disk_cache_test_base.h"
 #include "net/disk_cache/disk_cache_test_util.h"
+#include "net/disk_cache/storage_block-inl.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 using base::Time;
@@ -38,11 +39,11 @@ TEST_F(DiskCacheTest, BlockFiles_Grow) {
   const int kMaxSize = 35000;
   Addr address[kMaxSize];
 
-  // Fill up the 32-byte block file (use three files).
+  // Fill up the 32-byte block file (use three files). There is also a journal.
   for (int i = 0; i < kMaxSize; i++) {
     EXPECT_TRUE(files.CreateBlock(RANKINGS, 4, &address[i]));
   }
-  EXPECT_EQ(6, NumberOfFiles(path));
+  EXPECT_EQ(7, NumberOfFiles(path));
 
   // Make sure we don't keep adding files.
   for (int i = 0; i < kMaxSize * 4; i += 2) {
@@ -50,7 +51,7 @@ TEST_F(DiskCacheTest, BlockFiles_Grow) {
     files.DeleteBlock(address[target], false);
     EXPECT_TRUE(files.CreateBlock(RANKINGS, 4, &address[target]));
   }
-  EXPECT_EQ(6, NumberOfFiles(path));
+  EXPECT_EQ(7, NumberOfFiles(path));
 }
 
 // We should be able to delete empty block files.
@@ -74,7 +75,41 @@ TEST_F(DiskCacheTest, BlockFiles_Shrink) {
   for (int i = 0; i < kMaxSize; i++) {
     files.DeleteBlock(address[i], false);
   }
-  EXPECT_EQ(4, NumberOfFiles(path));
+  EXPECT_EQ(5, NumberOfFiles(path));
+}
+
+// Allocations of different sizes on a fragmented file should never overlap.
+TEST_F(DiskCacheTest, BlockFiles_FragmentedAllocation) {
+  FilePath path = GetCacheFilePath();
+  ASSERT_TRUE(DeleteCache(path));
+  ASSERT_TRUE(file_util::CreateDirectory(path));
+
+  BlockFiles files(path);
+  ASSERT_TRUE(files.Init(true));
+
+  const int kNumEntries = 2000;
+  Addr address[kNumEntries];
+  for (int i = 0; i < kNumEntries; i++)
+    EXPECT_TRUE(files.CreateBlock(RANKINGS, (i % 4) + 1, &address[i]));
+
+  // Free every third entry, and allocate the space again with other sizes.
+  for (int i = 0; i < kNumEntries; i += 3)
+    files.DeleteBlock(address[i], false);
+  for (int i = 0; i < kNumEntries; i += 3)
+    EXPECT_TRUE(files.CreateBlock(RANKINGS, 4 - (i % 4), &address[i]));
+
+  // Verify that no block is used twice.
+  std::vector<bool> used(kMaxBlocks * 4);
+  for (int i = 0; i < kNumEntries; i++) {
+    ASSERT_EQ(0, address[i].FileNumber());
+    for (int j = 0; j < address[i].num_blocks(); j++) {
+      int block = address[i].start_block() + j;
+      EXPECT_FALSE(used[block]);
+      used[block] = true;
+    }
+    EXPECT_EQ(address[i].start_block() / 4,
+              (address[i].start_block() + address[i].num_blocks() - 1) / 4);
+  }
 }
 
 // Handling of block files not properly closed.
@@ -155,6 +190,93 @@ TEST_F(DiskCacheTest, BlockFiles_Recover) {
   EXPECT_EQ(empty_4, header->empty[3]);
 }
 
+// Tests that the counters of a file can be fixed while the file is in use.
+TEST_F(DiskCacheTest, BlockFiles_Verify) {
+  FilePath path = GetCacheFilePath();
+  ASSERT_TRUE(DeleteCache(path));
+  ASSERT_TRUE(file_util::CreateDirectory(path));
+
+  BlockFiles files(path);
+  ASSERT_TRUE(files.Init(true));
+
+  Addr address(0);
+  for (int i = 0; i < 20; i++)
+    EXPECT_TRUE(files.CreateBlock(BLOCK_256, (i % 4) + 1, &address));
+
+  bool fixed;
+  EXPECT_TRUE(files.VerifyFile(address.FileNumber(), &fixed));
+  EXPECT_FALSE(fixed);
+
+  MappedFile* file = files.GetFile(address);
+  ASSERT_TRUE(NULL != file);
+  BlockFileHeader* header =
+      reinterpret_cast<BlockFileHeader*>(file->buffer());
+  int empty_1 = header->empty[0];
+  int empty_4 = header->empty[3];
+
+  // Corrupt the counters.
+  header->empty[0] = 500;
+  header->empty[3] = 0;
+
+  EXPECT_TRUE(files.VerifyFile(address.FileNumber(), &fixed));
+  EXPECT_TRUE(fixed);
+  EXPECT_EQ(0, header->updating);
+  EXPECT_EQ(empty_1, header->empty[0]);
+  EXPECT_EQ(empty_4, header->empty[3]);
+
+  // There is nothing past the last file.
+  EXPECT_FALSE(files.VerifyFile(kMaxBlockFile + 1, &fixed));
+}
+
+// Rankings blocks are stored on the journal, and recovered after a crash.
+TEST_F(DiskCacheTest, BlockFiles_Journal) {
+  FilePath path = GetCacheFilePath();
+  ASSERT_TRUE(DeleteCache(path));
+  ASSERT_TRUE(file_util::CreateDirectory(path));
+
+  BlockFiles files(path);
+  ASSERT_TRUE(files.Init(true));
+
+  Addr address(0);
+  ASSERT_TRUE(files.CreateBlock(RANKINGS, 1, &address));
+  MappedFile* file = files.GetFile(address);
+  ASSERT_TRUE(NULL != file);
+
+  CacheRankingsBlock node(file, address);
+  memset(node.Data(), 0, sizeof(RankingsNode));
+  node.Data()->contents = 0x1234;
+  ASSERT_TRUE(node.Store());
+
+  // The block file has not been updated, but the node can be loaded.
+  size_t offset = address.start_block() * address.BlockSize() +
+                  kBlockHeaderSize;
+  RankingsNode data;
+  ASSERT_TRUE(file->Read(&data, sizeof(data), offset));
+  EXPECT_EQ(0U, data.contents);
+
+  CacheRankingsBlock node2(file, address);
+  ASSERT_TRUE(node2.Load());
+  EXPECT_EQ(0x1234U, node2.Data()->contents);
+
+  // Save the current state of the files, and restore it after they are closed,
+  // as if the process had crashed.
+  FilePath name = path.AppendASCII("data_0");
+  FilePath copy = path.AppendASCII("data_0_copy");
+  FilePath journal = path.AppendASCII("journal");
+  FilePath journal_copy = path.AppendASCII("journal_copy");
+  ASSERT_TRUE(file_util::CopyFile(name, copy));
+  ASSERT_TRUE(file_util::CopyFile(journal, journal_copy));
+  files.CloseFiles();
+  ASSERT_TRUE(file_util::Move(copy, name));
+  ASSERT_TRUE(file_util::Move(journal_copy, journal));
+
+  ASSERT_TRUE(files.Init(false));
+  file = files.GetFile(address);
+  ASSERT_TRUE(NULL != file);
+  ASSERT_TRUE(file->Read(&data, sizeof(data), offset));
+  EXPECT_EQ(0x1234U, data.contents);
+}
+
 // Handling of truncated files.
 TEST_F(DiskCacheTest, BlockFiles_ZeroSizeFile) {
   FilePath path = GetCacheFilePath();
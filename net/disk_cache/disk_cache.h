@@ -16,6 +16,7 @@
 #include "base/time.h"
 #include "net/base/cache_type.h"
 #include "net/base/completion_callback.h"
+#include "net/base/memory_pressure_level.h"
 
 class FilePath;
 
@@ -135,6 +136,11 @@ class Backend {
   // Return a list of cache statistics.
   virtual void GetStats(
       std::vector<std::pair<std::string, std::string> >* stats) = 0;
+
+  // Drops the data kept in memory that isn't in use, as much as |level|
+  // asks for, and returns an estimate of the bytes freed. Backends that keep
+  // their data on disk have nothing to do.
+  virtual size_t PurgeMemory(net::MemoryPressureLevel level) { return 0; }
 };
 
 // This interface represents an entry in the disk cache.
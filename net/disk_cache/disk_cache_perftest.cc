@@ -255,3 +255,41 @@ TEST_F(DiskCacheTest, BlockFilesPerformance) {
   MessageLoop::current()->RunAllPending();
   delete[] address;
 }
+
+// Finding room for a new entry requires a search of the allocation bitmap of
+// the block-file for a run of free blocks of the right size. This test measures
+// that search when most of the bitmap is full and the free runs are scattered.
+TEST_F(DiskCacheTest, BlockFilesSearchPerformance) {
+  MessageLoopForIO message_loop;
+
+  ScopedTestCache test_cache;
+
+  disk_cache::BlockFiles files(test_cache.path());
+  ASSERT_TRUE(files.Init(true));
+
+  const int kNumEntries = 16000;
+  disk_cache::Addr* address = new disk_cache::Addr[kNumEntries];
+
+  // Fill one block-file with single blocks, and allocate runs of different
+  // sizes on the holes left by deleting some of them.
+  for (int i = 0; i < kNumEntries; i++) {
+    EXPECT_TRUE(files.CreateBlock(disk_cache::BLOCK_1K, 1, &address[i]));
+  }
+  for (int i = 0; i < kNumEntries; i += 16) {
+    for (int j = 0; j < 4; j++)
+      files.DeleteBlock(address[i + j], false);
+  }
+
+  PerfTimeLogger timer("Search fragmented block-file");
+
+  for (int i = 0; i < 100000; i++) {
+    int size = (i % 4) + 1;
+    disk_cache::Addr new_address;
+    EXPECT_TRUE(files.CreateBlock(disk_cache::BLOCK_1K, size, &new_address));
+    files.DeleteBlock(new_address, false);
+  }
+
+  timer.Done();
+  MessageLoop::current()->RunAllPending();
+  delete[] address;
+}
@@ -20,6 +20,7 @@ DiskCacheTestWithCache::DiskCacheTestWithCache()
       cache_impl_(NULL),
       mem_cache_(NULL),
       mask_(0),
+      flags_(0),
       size_(0),
       type_(net::DISK_CACHE),
       memory_only_(false),
@@ -35,7 +36,7 @@ DiskCacheTestWithCache::DiskCacheTestWithCache()
 DiskCacheTestWithCache::~DiskCacheTestWithCache() {}
 
 void DiskCacheTestWithCache::InitCache() {
-  if (mask_ || new_eviction_)
+  if (mask_ || new_eviction_ || flags_)
     implementation_ = true;
 
   if (memory_only_)
@@ -279,7 +280,7 @@ void DiskCacheTestWithCache::InitDiskCacheImpl(const FilePath& path) {
     cache_impl_->SetNewEviction();
 
   cache_impl_->SetType(type_);
-  cache_impl_->SetFlags(disk_cache::kNoRandom);
+  cache_impl_->SetFlags(disk_cache::kNoRandom | flags_);
   TestCompletionCallback cb;
   int rv = cache_impl_->Init(&cb);
   ASSERT_EQ(net::OK, cb.GetResult(rv));
@@ -71,6 +71,12 @@ class DiskCacheTestWithCache : public DiskCacheTest {
     new_eviction_ = true;
   }
 
+  // Adds |flags| to the flags used to initialize the backend. Enables direct
+  // mode.
+  void SetBackendFlags(uint32 flags) {
+    flags_ = flags;
+  }
+
   void DisableFirstCleanup() {
     first_cleanup_ = false;
   }
@@ -125,6 +131,7 @@ class DiskCacheTestWithCache : public DiskCacheTest {
   disk_cache::MemBackendImpl* mem_cache_;
 
   uint32 mask_;
+  uint32 flags_;
   int size_;
   net::CacheType type_;
   bool memory_only_;
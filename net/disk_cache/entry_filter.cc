@@ -0,0 +1,87 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/entry_filter.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+using base::subtle::Atomic32;
+
+namespace disk_cache {
+
+const int EntryFilter::kMaxBits;
+
+EntryFilter::EntryFilter() : mask_(0), enabled_(0), table_mask_(0) {
+  memset(bits_, 0, sizeof(bits_));
+}
+
+EntryFilter::~EntryFilter() {
+}
+
+void EntryFilter::Init(const CacheAddr* table, uint32 table_mask) {
+  // The table length is a power of two.
+  DCHECK(!(table_mask & (table_mask + 1)));
+  Disable();
+
+  uint32 mask = std::min(table_mask, static_cast<uint32>(kMaxBits - 1));
+  for (size_t i = 0; i < arraysize(bits_); i++)
+    base::subtle::NoBarrier_Store(&bits_[i], 0);
+  for (uint32 i = 0; i <= table_mask; i++) {
+    if (table[i])
+      SetBit(i & mask, true);
+  }
+
+  table_mask_ = table_mask;
+  base::subtle::NoBarrier_Store(&mask_, static_cast<Atomic32>(mask));
+  base::subtle::Release_Store(&enabled_, 1);
+}
+
+void EntryFilter::Disable() {
+  base::subtle::NoBarrier_Store(&enabled_, 0);
+}
+
+void EntryFilter::OnBucketChanged(const CacheAddr* table, uint32 hash) {
+  if (!base::subtle::NoBarrier_Load(&enabled_))
+    return;
+
+  uint32 bit = hash & static_cast<uint32>(base::subtle::NoBarrier_Load(&mask_));
+  SetBit(bit, IsInUse(table, bit));
+}
+
+bool EntryFilter::MayContain(uint32 hash) const {
+  if (!base::subtle::Acquire_Load(&enabled_))
+    return true;
+
+  uint32 bit = hash & static_cast<uint32>(base::subtle::NoBarrier_Load(&mask_));
+  uint32 word = static_cast<uint32>(base::subtle::NoBarrier_Load(
+      &bits_[bit / 32]));
+  return (word & (1u << (bit % 32))) != 0;
+}
+
+bool EntryFilter::IsInUse(const CacheAddr* table, uint32 bit) const {
+  uint32 step = static_cast<uint32>(base::subtle::NoBarrier_Load(&mask_)) + 1;
+  for (uint32 i = bit; i <= table_mask_; i += step) {
+    if (table[i])
+      return true;
+  }
+  return false;
+}
+
+void EntryFilter::SetBit(uint32 bit, bool value) {
+  // Only the cache thread writes to the filter.
+  uint32 word = static_cast<uint32>(base::subtle::NoBarrier_Load(
+      &bits_[bit / 32]));
+  if (value) {
+    word |= 1u << (bit % 32);
+  } else {
+    word &= ~(1u << (bit % 32));
+  }
+  base::subtle::NoBarrier_Store(&bits_[bit / 32], static_cast<Atomic32>(word));
+}
+
+}  // namespace disk_cache
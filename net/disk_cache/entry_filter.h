@@ -0,0 +1,59 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DISK_CACHE_ENTRY_FILTER_H_
+#define NET_DISK_CACHE_ENTRY_FILTER_H_
+#pragma once
+
+#include "base/atomicops.h"
+#include "base/basictypes.h"
+#include "net/disk_cache/disk_format.h"
+
+namespace disk_cache {
+
+// This class keeps one bit per bucket (or group of buckets) of the index
+// table, set when the bucket is in use. A key whose bit is clear is definitely
+// not stored, so an open of that key can fail without going to the cache
+// thread. The filter is built and updated on the cache thread, and can be
+// queried from any thread.
+class EntryFilter {
+ public:
+  // The maximum size of the filter. Larger index tables share each bit among
+  // several buckets.
+  static const int kMaxBits = 64 * 1024;
+
+  EntryFilter();
+  ~EntryFilter();
+
+  // Builds the filter from the index |table|, of |table_mask| + 1 buckets,
+  // and starts answering MayContain().
+  void Init(const CacheAddr* table, uint32 table_mask);
+
+  // Makes MayContain() return true until the next Init().
+  void Disable();
+
+  // Updates the filter after the bucket of |hash| on |table| changed.
+  void OnBucketChanged(const CacheAddr* table, uint32 hash);
+
+  // Returns false if there is no entry for |hash| on the index. This is the
+  // only method that may be called from other threads.
+  bool MayContain(uint32 hash) const;
+
+ private:
+  // Returns true if any of the buckets of |table| that map to |bit| is in use.
+  bool IsInUse(const CacheAddr* table, uint32 bit) const;
+
+  void SetBit(uint32 bit, bool value);
+
+  base::subtle::Atomic32 bits_[kMaxBits / 32];
+  base::subtle::Atomic32 mask_;  // Maps a hash to its bit.
+  base::subtle::Atomic32 enabled_;
+  uint32 table_mask_;
+
+  DISALLOW_COPY_AND_ASSIGN(EntryFilter);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_ENTRY_FILTER_H_
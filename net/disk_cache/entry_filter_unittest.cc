@@ -0,0 +1,64 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include "net/disk_cache/entry_filter.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+TEST(EntryFilterTest, Disabled) {
+  disk_cache::EntryFilter filter;
+  EXPECT_TRUE(filter.MayContain(0x1234));
+
+  std::vector<disk_cache::CacheAddr> table(16);
+  filter.Init(&table[0], 15);
+  EXPECT_FALSE(filter.MayContain(0x1234));
+  filter.Disable();
+  EXPECT_TRUE(filter.MayContain(0x1234));
+}
+
+TEST(EntryFilterTest, Basics) {
+  std::vector<disk_cache::CacheAddr> table(16);
+  table[3] = 0x90000001;
+
+  disk_cache::EntryFilter filter;
+  filter.Init(&table[0], 15);
+  EXPECT_TRUE(filter.MayContain(0x13));
+  EXPECT_TRUE(filter.MayContain(0x3));
+  EXPECT_FALSE(filter.MayContain(0x14));
+
+  table[4] = 0x90000002;
+  filter.OnBucketChanged(&table[0], 0x24);
+  EXPECT_TRUE(filter.MayContain(0x14));
+
+  table[3] = 0;
+  filter.OnBucketChanged(&table[0], 0x3);
+  EXPECT_FALSE(filter.MayContain(0x13));
+  EXPECT_TRUE(filter.MayContain(0x14));
+}
+
+// Tests that a bit is shared by several buckets of a large table.
+TEST(EntryFilterTest, LargeTable) {
+  const uint32 kTableMask = disk_cache::EntryFilter::kMaxBits * 4 - 1;
+  std::vector<disk_cache::CacheAddr> table(kTableMask + 1);
+  const uint32 kHash1 = 5;
+  const uint32 kHash2 = 5 + disk_cache::EntryFilter::kMaxBits * 2;
+  table[kHash1] = 0x90000001;
+  table[kHash2] = 0x90000002;
+
+  disk_cache::EntryFilter filter;
+  filter.Init(&table[0], kTableMask);
+  EXPECT_TRUE(filter.MayContain(kHash1));
+  EXPECT_TRUE(filter.MayContain(kHash2));
+  EXPECT_FALSE(filter.MayContain(kHash1 + 1));
+
+  table[kHash1] = 0;
+  filter.OnBucketChanged(&table[0], kHash1);
+  EXPECT_TRUE(filter.MayContain(kHash1));
+
+  table[kHash2] = 0;
+  filter.OnBucketChanged(&table[0], kHash2);
+  EXPECT_FALSE(filter.MayContain(kHash1));
+  EXPECT_FALSE(filter.MayContain(kHash2));
+}
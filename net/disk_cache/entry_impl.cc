@@ -14,6 +14,7 @@
 #include "net/disk_cache/cache_util.h"
 #include "net/disk_cache/hash.h"
 #include "net/disk_cache/histogram_macros.h"
+#include "net/disk_cache/mapped_file.h"
 #include "net/disk_cache/net_log_parameters.h"
 #include "net/disk_cache/sparse_control.h"
 
@@ -396,6 +397,51 @@ int EntryImpl::ReadyForSparseIOImpl(CompletionCallback* callback) {
   return sparse_->ReadyToUse(callback);
 }
 
+int EntryImpl::ReadMappedDataImpl(int index, int offset, int buf_len,
+                                  scoped_refptr<net::IOBuffer>* buf) {
+  DCHECK(node_.Data()->dirty || read_only_);
+  if (index < 0 || index >= kNumStreams)
+    return net::ERR_INVALID_ARGUMENT;
+
+  int entry_size = entry_.Data()->data_size[index];
+  if (offset >= entry_size || offset < 0 || !buf_len)
+    return 0;
+
+  if (buf_len < 0)
+    return net::ERR_INVALID_ARGUMENT;
+
+  Addr address(entry_.Data()->data_addr[index]);
+  if (!address.is_initialized() || !address.is_separate_file())
+    return net::ERR_FAILED;
+
+  if (offset + buf_len > entry_size)
+    buf_len = entry_size - offset;
+
+  // Part of the data may still be waiting on memory to be written.
+  if (user_buffers_[index].get() &&
+      user_buffers_[index]->PreRead(entry_size, offset, &buf_len)) {
+    return net::ERR_FAILED;
+  }
+
+  File* file = GetBackingFile(address, index);
+  if (!file)
+    return net::ERR_FAILED;
+
+  TimeTicks start = TimeTicks::Now();
+  scoped_refptr<MappedIOBuffer> mapped(
+      MappedIOBuffer::Create(file, offset, buf_len));
+  if (!mapped)
+    return net::ERR_FAILED;
+
+  UpdateRank(false);
+  backend_->OnEvent(Stats::READ_DATA);
+  backend_->OnRead(buf_len);
+
+  *buf = mapped;
+  ReportIOTime(kRead, start);
+  return buf_len;
+}
+
 uint32 EntryImpl::GetHash() {
   return entry_.Data()->hash;
 }
@@ -463,6 +509,8 @@ void EntryImpl::InternalDoom() {
     node_.Data()->dirty = backend_->GetCurrentEntryId();
     node_.Store();
   }
+  if (GetEntryFlags() & CHILD_ENTRY)
+    backend_->OnChildEntryDoomed();
   doomed_ = true;
 }
 
@@ -47,6 +47,13 @@ class EntryImpl : public Entry, public base::RefCounted<EntryImpl> {
   void CancelSparseIOImpl();
   int ReadyForSparseIOImpl(CompletionCallback* callback);
 
+  // Returns on |buf| a buffer that maps up to |buf_len| bytes of the stream
+  // |index|, starting at |offset|, without copying the data. This is only
+  // possible for data stored on an external file, so when this method returns
+  // net::ERR_FAILED the caller should use ReadDataImpl instead.
+  int ReadMappedDataImpl(int index, int offset, int buf_len,
+                         scoped_refptr<net::IOBuffer>* buf);
+
   inline CacheEntryBlock* entry() {
     return &entry_;
   }
@@ -51,6 +51,7 @@ class DiskCacheEntryTest : public DiskCacheTestWithCache {
   void UpdateSparseEntry();
   void DoomSparseEntry();
   void PartialSparseEntry();
+  void MultipleChildrenSparseIO();
 };
 
 // Simple task to run part of a test from the cache thread.
@@ -1842,6 +1843,57 @@ TEST_F(DiskCacheEntryTest, MemoryPartialSparseEntry) {
   PartialSparseEntry();
 }
 
+// Tests reads and range queries that cover multiple children with a hole.
+void DiskCacheEntryTest::MultipleChildrenSparseIO() {
+  std::string key("the first key");
+  disk_cache::Entry* entry;
+  ASSERT_EQ(net::OK, CreateEntry(key, &entry));
+
+  const int k1Meg = 1024 * 1024;
+  const int kSize = 4 * k1Meg;
+  scoped_refptr<net::IOBuffer> buf1(new net::IOBuffer(kSize));
+  scoped_refptr<net::IOBuffer> buf2(new net::IOBuffer(kSize));
+  CacheTestFillBuffer(buf1->data(), kSize, false);
+
+  // Leave a hole between 2.5 MB and 3 MB.
+  EXPECT_EQ(5 * k1Meg / 2, WriteSparseData(entry, 0, buf1, 5 * k1Meg / 2));
+  scoped_refptr<net::IOBuffer> tail(
+      new net::WrappedIOBuffer(buf1->data() + 3 * k1Meg));
+  EXPECT_EQ(k1Meg / 2, WriteSparseData(entry, 3 * k1Meg, tail, k1Meg / 2));
+  entry->Close();
+
+  ASSERT_EQ(net::OK, OpenEntry(key, &entry));
+  memset(buf2->data(), 0, kSize);
+  EXPECT_EQ(5 * k1Meg / 2, ReadSparseData(entry, 0, buf2, kSize));
+  EXPECT_EQ(0, memcmp(buf2->data(), buf1->data(), 5 * k1Meg / 2));
+
+  // The children are known now, so these don't have to open them again.
+  int64 start;
+  TestCompletionCallback cb;
+  int rv = entry->GetAvailableRange(2 * k1Meg, k1Meg, &start, &cb);
+  EXPECT_EQ(k1Meg / 2, cb.GetResult(rv));
+  EXPECT_EQ(2 * k1Meg, start);
+  rv = entry->GetAvailableRange(5 * k1Meg / 2, k1Meg, &start, &cb);
+  EXPECT_EQ(k1Meg / 2, cb.GetResult(rv));
+  EXPECT_EQ(3 * k1Meg, start);
+
+  memset(buf2->data(), 0, kSize);
+  EXPECT_EQ(k1Meg / 2, ReadSparseData(entry, 3 * k1Meg, buf2, k1Meg));
+  EXPECT_EQ(0, memcmp(buf2->data(), buf1->data() + 3 * k1Meg, k1Meg / 2));
+  entry->Close();
+}
+
+TEST_F(DiskCacheEntryTest, MultipleChildrenSparseIO) {
+  InitCache();
+  MultipleChildrenSparseIO();
+}
+
+TEST_F(DiskCacheEntryTest, MemoryOnlyMultipleChildrenSparseIO) {
+  SetMemoryOnlyMode();
+  InitCache();
+  MultipleChildrenSparseIO();
+}
+
 // Tests that corrupt sparse children are removed automatically.
 TEST_F(DiskCacheEntryTest, CleanupSparseEntry) {
   InitCache();
@@ -1893,6 +1945,56 @@ TEST_F(DiskCacheEntryTest, CleanupSparseEntry) {
   EXPECT_EQ(3, cache_->GetEntryCount());
 }
 
+// Tests that range queries notice that a child went away while the parent is
+// open.
+TEST_F(DiskCacheEntryTest, DoomedChildSparseRange) {
+  InitCache();
+  std::string key("the first key");
+  disk_cache::Entry* entry;
+  ASSERT_EQ(net::OK, CreateEntry(key, &entry));
+
+  const int kSize = 4 * 1024;
+  scoped_refptr<net::IOBuffer> buf(new net::IOBuffer(kSize));
+  CacheTestFillBuffer(buf->data(), kSize, false);
+
+  const int k1Meg = 1024 * 1024;
+  EXPECT_EQ(kSize, WriteSparseData(entry, 8192, buf, kSize));
+  EXPECT_EQ(kSize, WriteSparseData(entry, k1Meg + 8192, buf, kSize));
+
+  // Neither child is open after these.
+  int64 start;
+  TestCompletionCallback cb;
+  int rv = entry->GetAvailableRange(0, k1Meg, &start, &cb);
+  EXPECT_EQ(kSize, cb.GetResult(rv));
+  EXPECT_EQ(8192, start);
+  rv = entry->GetAvailableRange(k1Meg, k1Meg, &start, &cb);
+  EXPECT_EQ(kSize, cb.GetResult(rv));
+  EXPECT_EQ(k1Meg + 8192, start);
+
+  // Doom the second child, the way eviction would.
+  void* iter = NULL;
+  disk_cache::Entry* child;
+  std::string child_key;
+  while (OpenNextEntry(&iter, &child) == net::OK) {
+    std::string child_name = child->GetKey();
+    if (child_name != key &&
+        child_name.compare(child_name.size() - 2, 2, ":1") == 0) {
+      child_key = child_name;
+    }
+    child->Close();
+  }
+  cache_->EndEnumeration(&iter);
+  ASSERT_FALSE(child_key.empty());
+  EXPECT_EQ(net::OK, DoomEntry(child_key));
+
+  rv = entry->GetAvailableRange(k1Meg, k1Meg, &start, &cb);
+  EXPECT_EQ(0, cb.GetResult(rv));
+  rv = entry->GetAvailableRange(0, k1Meg, &start, &cb);
+  EXPECT_EQ(kSize, cb.GetResult(rv));
+  EXPECT_EQ(8192, start);
+  entry->Close();
+}
+
 TEST_F(DiskCacheEntryTest, CancelSparseIO) {
   UseCurrentThread();
   InitCache();
@@ -1945,6 +2047,42 @@ TEST_F(DiskCacheEntryTest, CancelSparseIO) {
   entry->Close();
 }
 
+// Tests that data stored on an external file can be read through a mapping.
+TEST_F(DiskCacheEntryTest, MappedExternalRead) {
+  UseCurrentThread();
+  InitCache();
+  std::string key("the first key");
+  disk_cache::Entry* entry;
+  ASSERT_EQ(net::OK, CreateEntry(key, &entry));
+
+  const int kSize = 50000;
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(kSize));
+  CacheTestFillBuffer(buffer->data(), kSize, false);
+  EXPECT_EQ(kSize, WriteData(entry, 1, 0, buffer, kSize, false));
+  EXPECT_EQ(100, WriteData(entry, 0, 0, buffer, 100, false));
+  entry->Close();
+
+  ASSERT_EQ(net::OK, OpenEntry(key, &entry));
+  disk_cache::EntryImpl* entry_impl =
+      static_cast<disk_cache::EntryImpl*>(entry);
+
+  // Data stored on a block file cannot be mapped.
+  scoped_refptr<net::IOBuffer> mapped;
+  EXPECT_EQ(net::ERR_FAILED,
+            entry_impl->ReadMappedDataImpl(0, 0, 100, &mapped));
+  EXPECT_FALSE(mapped.get());
+
+  // Use an offset that is not aligned to a page, and read past the end.
+  EXPECT_EQ(kSize - 5000,
+            entry_impl->ReadMappedDataImpl(1, 5000, kSize, &mapped));
+  ASSERT_TRUE(mapped.get());
+  EXPECT_EQ(0, memcmp(mapped->data(), buffer->data() + 5000, kSize - 5000));
+
+  // The mapping outlives the entry.
+  entry->Close();
+  EXPECT_EQ(0, memcmp(mapped->data(), buffer->data() + 5000, kSize - 5000));
+}
+
 // Tests that we perform sanity checks on an entry's key. Note that there are
 // other tests that exercise sanity checks by using saved corrupt files.
 TEST_F(DiskCacheEntryTest, KeySanityCheck) {
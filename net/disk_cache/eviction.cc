@@ -26,6 +26,16 @@
 // size so that we have a chance to see an element again and move it to another
 // list.
 
+// Two variations can be enabled through BackendImpl::SetFlags(). With
+// kSegmentedLru, the NO_USE list is treated as a probationary segment and the
+// LOW_USE and HIGH_USE lists as a protected segment, so we always evict from
+// NO_USE unless the protected segment grows beyond kProtectedPercent of the
+// entries. With kAdmissionFilter, we keep an approximate count of how often
+// each key is requested (see FrequencySketch), and when the cache is full a
+// new entry is only stored if it is requested more often than the last entry
+// that we had to evict; this keeps a burst of one-time entries from flushing
+// the working set of the cache.
+
 #include "net/disk_cache/eviction.h"
 
 #include "base/compiler_specific.h"
@@ -48,6 +58,7 @@ const int kCleanUpMargin = 1024 * 1024;
 const int kHighUse = 10;  // Reuse count to be on the HIGH_USE list.
 const int kTargetTime = 24 * 7;  // Time to be evicted (hours since last use).
 const int kMaxDelayedTrims = 60;
+const int kProtectedPercent = 80;  // Max size of the protected segment.
 
 int LowWaterAdjust(int high_water) {
   if (high_water < kCleanUpMargin)
@@ -63,6 +74,9 @@ namespace disk_cache {
 Eviction::Eviction()
     : backend_(NULL),
       init_(false),
+      admission_filter_(false),
+      segmented_lru_(false),
+      last_evicted_frequency_(0),
       ALLOW_THIS_IN_INITIALIZER_LIST(factory_(this)) {
 }
 
@@ -84,6 +98,11 @@ void Eviction::Init(BackendImpl* backend) {
   init_ = true;
   test_mode_ = false;
   in_experiment_ = (header_->experiment == EXPERIMENT_DELETED_LIST_IN);
+  admission_filter_ = (backend->user_flags_ & kAdmissionFilter) != 0;
+  segmented_lru_ = new_eviction_ && (backend->user_flags_ & kSegmentedLru);
+  last_evicted_frequency_ = 0;
+  if (admission_filter_)
+    sketch_.Init(header_->table_len);
 }
 
 void Eviction::Stop() {
@@ -161,6 +180,18 @@ void Eviction::UpdateRank(EntryImpl* entry, bool modified) {
   rankings_->UpdateRank(entry->rankings(), modified, GetListForEntry(entry));
 }
 
+void Eviction::OnEntryRequested(uint32 hash) {
+  if (admission_filter_)
+    sketch_.Increment(hash);
+}
+
+bool Eviction::ShouldAdmit(uint32 hash) {
+  if (!admission_filter_ || header_->num_bytes < max_size_)
+    return true;
+
+  return sketch_.Frequency(hash) > last_evicted_frequency_;
+}
+
 void Eviction::OnOpenEntry(EntryImpl* entry) {
   if (new_eviction_)
     return OnOpenEntryV2(entry);
@@ -265,6 +296,9 @@ bool Eviction::EvictEntry(CacheRankingsBlock* node, bool empty,
   }
 
   ReportTrimTimes(entry);
+  if (admission_filter_ && !empty)
+    last_evicted_frequency_ = sketch_.Frequency(entry->GetHash());
+
   if (empty || !new_eviction_) {
     entry->DoomImpl();
   } else {
@@ -311,6 +345,10 @@ void Eviction::TrimCacheV2(bool empty) {
   if (!empty && Rankings::LAST_ELEMENT == list)
     list = SelectListByLength(next);
 
+  // With a segmented LRU, the time targets don't matter.
+  if (!empty && segmented_lru_)
+    list = SelectListForSegmentedLru();
+
   if (empty)
     list = 0;
 
@@ -543,6 +581,23 @@ int Eviction::SelectListByLength(Rankings::ScopedRankingsBlock* next) {
   return list;
 }
 
+int Eviction::SelectListForSegmentedLru() {
+  int data_entries = header_->num_entries -
+                     header_->lru.sizes[Rankings::DELETED];
+  int protected_entries = header_->lru.sizes[Rankings::LOW_USE] +
+                          header_->lru.sizes[Rankings::HIGH_USE];
+
+  // Evict from the probationary segment unless it is empty or the protected
+  // segment is too big.
+  if (header_->lru.sizes[Rankings::NO_USE] &&
+      protected_entries <= data_entries * kProtectedPercent / 100)
+    return Rankings::NO_USE;
+
+  // Within the protected segment, entries with less reuse go first.
+  return header_->lru.sizes[Rankings::LOW_USE] ? Rankings::LOW_USE :
+                                                 Rankings::HIGH_USE;
+}
+
 void Eviction::ReportListStats() {
   if (!new_eviction_)
     return;
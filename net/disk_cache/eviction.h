@@ -9,6 +9,7 @@
 #include "base/basictypes.h"
 #include "base/task.h"
 #include "net/disk_cache/disk_format.h"
+#include "net/disk_cache/frequency_sketch.h"
 #include "net/disk_cache/rankings.h"
 
 namespace disk_cache {
@@ -34,6 +35,15 @@ class Eviction {
   // Updates the ranking information for an entry.
   void UpdateRank(EntryImpl* entry, bool modified);
 
+  // Records a request for the entry identified by |hash| (regardless of the
+  // entry being on the cache or not).
+  void OnEntryRequested(uint32 hash);
+
+  // Returns true if a new entry identified by |hash| should be stored. When the
+  // admission filter is enabled, a new entry is rejected if the cache is full
+  // and the entry is not requested more often than the entries being evicted.
+  bool ShouldAdmit(uint32 hash);
+
   // Notifications of interesting events for a given entry.
   void OnOpenEntry(EntryImpl* entry);
   void OnCreateEntry(EntryImpl* entry);
@@ -67,6 +77,7 @@ class Eviction {
 
   bool NodeIsOldEnough(CacheRankingsBlock* node, int list);
   int SelectListByLength(Rankings::ScopedRankingsBlock* next);
+  int SelectListForSegmentedLru();
   void ReportListStats();
 
   BackendImpl* backend_;
@@ -81,6 +92,10 @@ class Eviction {
   bool init_;
   bool test_mode_;
   bool in_experiment_;
+  bool admission_filter_;
+  bool segmented_lru_;
+  int last_evicted_frequency_;  // Of the last entry evicted by TrimCache.
+  FrequencySketch sketch_;
   ScopedRunnableMethodFactory<Eviction> factory_;
 
   DISALLOW_COPY_AND_ASSIGN(Eviction);
@@ -5,8 +5,16 @@
 #include "net/disk_cache/file.h"
 
 #include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
 
+#include <vector>
+
+#include "base/eintr_wrapper.h"
+#include "base/lazy_instance.h"
 #include "base/logging.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread_local.h"
 #include "base/threading/worker_pool.h"
 #include "net/base/net_errors.h"
 #include "net/disk_cache/disk_cache.h"
@@ -14,6 +22,20 @@
 
 namespace {
 
+// Linux has vectored positional IO, so contiguous operations on the same file
+// can be completed with a single syscall. Bionic doesn't provide it.
+#if defined(OS_LINUX) && !defined(ANDROID)
+#define USE_VECTORED_IO 1
+#endif
+
+// The maximum number of operations that can be merged into a single vectored
+// syscall (well below IOV_MAX).
+const size_t kMaxOperationsPerSyscall = 64;
+
+// The maximum number of worker threads draining the queue of pending
+// operations at the same time.
+const int kMaxBatchWorkers = 2;
+
 // This class represents a single asynchronous IO operation while it is being
 // bounced between threads.
 class FileBackgroundIO : public disk_cache::BackgroundIO {
@@ -24,10 +46,11 @@ class FileBackgroundIO : public disk_cache::BackgroundIO {
   // (we do NOT invoke the callback), in the worker thead that completed the
   // operation.
   FileBackgroundIO(disk_cache::File* file, const void* buf, size_t buf_len,
-                   size_t offset, disk_cache::FileIOCallback* callback,
+                   size_t offset, bool is_read,
+                   disk_cache::FileIOCallback* callback,
                    disk_cache::InFlightIO* controller)
       : disk_cache::BackgroundIO(controller), callback_(callback), file_(file),
-        buf_(buf), buf_len_(buf_len), offset_(offset) {
+        buf_(buf), buf_len_(buf_len), offset_(offset), is_read_(is_read) {
   }
 
   disk_cache::FileIOCallback* callback() {
@@ -38,14 +61,29 @@ class FileBackgroundIO : public disk_cache::BackgroundIO {
     return file_;
   }
 
+  const void* buf() const { return buf_; }
+  size_t buf_len() const { return buf_len_; }
+  size_t offset() const { return offset_; }
+  bool is_read() const { return is_read_; }
+
+  // Returns true if |other| can be completed with the same syscall, right
+  // after this operation.
+  bool IsFollowedBy(const FileBackgroundIO* other) const;
+
   // Read and Write are the operations that can be performed asynchronously.
   // The actual parameters for the operation are setup in the constructor of
-  // the object. Both methods should be called from a worker thread, by posting
-  // a task to the WorkerPool (they are RunnableMethods). When finished,
-  // controller->OnIOComplete() is called.
+  // the object. Both methods should be called from a worker thread. When
+  // finished, controller->OnIOComplete() is called.
   void Read();
   void Write();
 
+  // Performs the operation described by is_read().
+  void Execute();
+
+  // Completes an operation that was performed as part of a batch, without
+  // touching the file again.
+  void Complete(bool success);
+
  private:
   ~FileBackgroundIO() {}
 
@@ -55,15 +93,55 @@ class FileBackgroundIO : public disk_cache::BackgroundIO {
   const void* buf_;
   size_t buf_len_;
   size_t offset_;
+  bool is_read_;
 
   DISALLOW_COPY_AND_ASSIGN(FileBackgroundIO);
 };
 
+// Operations waiting for a worker thread. Instead of posting a task per
+// operation, the operations are queued here and the worker threads drain the
+// queue, so all the operations issued while a worker is busy are performed
+// together, merging contiguous operations on the same file into a single
+// preadv / pwritev call. This object is reference counted because the workers
+// may still be running after the controller is gone (the controller only waits
+// for the completion of the last operation, not for the worker to return).
+class FileOperationQueue
+    : public base::RefCountedThreadSafe<FileOperationQueue> {
+ public:
+  FileOperationQueue() : active_workers_(0) {}
+
+  // Adds |operation| to the queue, and makes sure that a worker will get to it.
+  void Enqueue(FileBackgroundIO* operation);
+
+ private:
+  friend class base::RefCountedThreadSafe<FileOperationQueue>;
+  typedef std::vector<scoped_refptr<FileBackgroundIO> > Operations;
+
+  ~FileOperationQueue() {}
+
+  // Runs on a worker thread until there is nothing left on the queue.
+  void DrainQueue();
+
+  // Performs all the operations from |batch|, in order.
+  void ExecuteBatch(const Operations& batch);
+
+  // Performs |count| contiguous operations, starting at |first|, with a single
+  // syscall. Returns false if the vectored operation didn't fully succeed, and
+  // the operations have to be performed one by one.
+  bool ExecuteVectored(const Operations& batch, size_t first, size_t count);
+
+  base::Lock lock_;
+  Operations pending_;  // Protected by |lock_|.
+  int active_workers_;  // Protected by |lock_|.
+
+  DISALLOW_COPY_AND_ASSIGN(FileOperationQueue);
+};
+
 
 // The specialized controller that keeps track of current operations.
 class FileInFlightIO : public disk_cache::InFlightIO {
  public:
-  FileInFlightIO() {}
+  FileInFlightIO() : queue_(new FileOperationQueue) {}
   ~FileInFlightIO() {}
 
   // These methods start an asynchronous operation. The arguments have the same
@@ -83,6 +161,8 @@ class FileInFlightIO : public disk_cache::InFlightIO {
                                    bool cancel);
 
  private:
+  scoped_refptr<FileOperationQueue> queue_;
+
   DISALLOW_COPY_AND_ASSIGN(FileInFlightIO);
 };
 
@@ -106,29 +186,142 @@ void FileBackgroundIO::Write() {
   controller_->OnIOComplete(this);
 }
 
+// Runs on a worker thread.
+void FileBackgroundIO::Execute() {
+  if (is_read_)
+    Read();
+  else
+    Write();
+}
+
+// Runs on a worker thread.
+void FileBackgroundIO::Complete(bool success) {
+  if (success) {
+    result_ = static_cast<int>(buf_len_);
+  } else {
+    result_ = is_read_ ? net::ERR_CACHE_READ_FAILURE :
+                         net::ERR_CACHE_WRITE_FAILURE;
+  }
+  controller_->OnIOComplete(this);
+}
+
+bool FileBackgroundIO::IsFollowedBy(const FileBackgroundIO* other) const {
+  return other->file_ == file_ && other->is_read_ == is_read_ &&
+         other->offset_ == offset_ + buf_len_;
+}
+
+// ---------------------------------------------------------------------------
+
+void FileOperationQueue::Enqueue(FileBackgroundIO* operation) {
+  {
+    base::AutoLock lock(lock_);
+    pending_.push_back(operation);
+
+    // A busy worker will pick up this operation as part of its next batch.
+    if (active_workers_ && (pending_.size() > 1 ||
+                            active_workers_ == kMaxBatchWorkers)) {
+      return;
+    }
+    active_workers_++;
+  }
+
+  base::WorkerPool::PostTask(FROM_HERE,
+      NewRunnableMethod(this, &FileOperationQueue::DrainQueue), true);
+}
+
+// Runs on a worker thread.
+void FileOperationQueue::DrainQueue() {
+  for (;;) {
+    Operations batch;
+    {
+      base::AutoLock lock(lock_);
+      if (pending_.empty()) {
+        active_workers_--;
+        return;
+      }
+      batch.swap(pending_);
+    }
+    ExecuteBatch(batch);
+  }
+}
+
+// Runs on a worker thread.
+void FileOperationQueue::ExecuteBatch(const Operations& batch) {
+  for (size_t first = 0; first < batch.size();) {
+    size_t count = 1;
+#if defined(USE_VECTORED_IO)
+    while (first + count < batch.size() && count < kMaxOperationsPerSyscall &&
+           batch[first + count - 1]->IsFollowedBy(batch[first + count])) {
+      count++;
+    }
+#endif
+    if (count == 1 || !ExecuteVectored(batch, first, count)) {
+      for (size_t i = first; i < first + count; i++)
+        batch[i]->Execute();
+    }
+    first += count;
+  }
+}
+
+// Runs on a worker thread.
+bool FileOperationQueue::ExecuteVectored(const Operations& batch, size_t first,
+                                         size_t count) {
+#if defined(USE_VECTORED_IO)
+  FileBackgroundIO* head = batch[first];
+  if (head->offset() > LONG_MAX)
+    return false;
+
+  struct iovec vectors[kMaxOperationsPerSyscall];
+  size_t total_len = 0;
+  for (size_t i = 0; i < count; i++) {
+    vectors[i].iov_base = const_cast<void*>(batch[first + i]->buf());
+    vectors[i].iov_len = batch[first + i]->buf_len();
+    total_len += vectors[i].iov_len;
+  }
+
+  int fd = head->file()->platform_file();
+  ssize_t ret;
+  if (head->is_read()) {
+    ret = HANDLE_EINTR(preadv(fd, vectors, count, head->offset()));
+  } else {
+    ret = HANDLE_EINTR(pwritev(fd, vectors, count, head->offset()));
+  }
+
+  // A short transfer (for instance, reading past the end of the file) has to
+  // be reported per operation, so let the caller retry them one at a time.
+  if (ret < 0 || static_cast<size_t>(ret) != total_len)
+    return false;
+
+  for (size_t i = 0; i < count; i++)
+    batch[first + i]->Complete(true);
+  return true;
+#else
+  return false;
+#endif
+}
+
 // ---------------------------------------------------------------------------
 
 void FileInFlightIO::PostRead(disk_cache::File *file, void* buf, size_t buf_len,
                           size_t offset, disk_cache::FileIOCallback *callback) {
   scoped_refptr<FileBackgroundIO> operation(
-      new FileBackgroundIO(file, buf, buf_len, offset, callback, this));
+      new FileBackgroundIO(file, buf, buf_len, offset, true, callback, this));
   file->AddRef();  // Balanced on OnOperationComplete()
 
-  base::WorkerPool::PostTask(FROM_HERE,
-      NewRunnableMethod(operation.get(), &FileBackgroundIO::Read), true);
+  // The operation must be tracked before a worker has a chance to complete it.
   OnOperationPosted(operation);
+  queue_->Enqueue(operation);
 }
 
 void FileInFlightIO::PostWrite(disk_cache::File* file, const void* buf,
                            size_t buf_len, size_t offset,
                            disk_cache::FileIOCallback* callback) {
   scoped_refptr<FileBackgroundIO> operation(
-      new FileBackgroundIO(file, buf, buf_len, offset, callback, this));
+      new FileBackgroundIO(file, buf, buf_len, offset, false, callback, this));
   file->AddRef();  // Balanced on OnOperationComplete()
 
-  base::WorkerPool::PostTask(FROM_HERE,
-      NewRunnableMethod(operation.get(), &FileBackgroundIO::Write), true);
   OnOperationPosted(operation);
+  queue_->Enqueue(operation);
 }
 
 // Runs on the IO thread.
@@ -144,22 +337,28 @@ void FileInFlightIO::OnOperationComplete(disk_cache::BackgroundIO* operation,
   callback->OnFileIOComplete(bytes);
 }
 
-// A static object tha will broker all async operations.
-FileInFlightIO* s_file_operations = NULL;
+// A per-thread object that will broker all async operations. Each cache thread
+// (there is more than one with a sharded backend) gets its own controller, so
+// that callbacks are delivered to the thread that issued the operation.
+base::LazyInstance<base::ThreadLocalPointer<FileInFlightIO> >
+    g_file_operations(base::LINKER_INITIALIZED);
 
 // Returns the current FileInFlightIO.
 FileInFlightIO* GetFileInFlightIO() {
-  if (!s_file_operations) {
-    s_file_operations = new FileInFlightIO;
+  FileInFlightIO* file_operations = g_file_operations.Pointer()->Get();
+  if (!file_operations) {
+    file_operations = new FileInFlightIO;
+    g_file_operations.Pointer()->Set(file_operations);
   }
-  return s_file_operations;
+  return file_operations;
 }
 
 // Deletes the current FileInFlightIO.
 void DeleteFileInFlightIO() {
-  DCHECK(s_file_operations);
-  delete s_file_operations;
-  s_file_operations = NULL;
+  FileInFlightIO* file_operations = g_file_operations.Pointer()->Get();
+  DCHECK(file_operations);
+  delete file_operations;
+  g_file_operations.Pointer()->Set(NULL);
 }
 
 }  // namespace
@@ -0,0 +1,99 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/frequency_sketch.h"
+
+#include <algorithm>
+
+
+namespace {
+
+const int kNumRows = 4;
+const int kCountersPerElement = 16;  // 4-bit counters on an uint64.
+const int kMinIndexBits = 10;
+const int kMaxIndexBits = 20;
+
+// Multipliers used to derive the counter of each row from the key hash.
+const uint32 kSeeds[kNumRows] = {
+  0x9E3779B1, 0x85EBCA77, 0xC2B2AE3D, 0x27D4EB2F
+};
+
+}  // namespace
+
+namespace disk_cache {
+
+const int FrequencySketch::kMaxFrequency;
+
+FrequencySketch::FrequencySketch()
+    : index_bits_(0), num_increments_(0), sample_size_(0) {
+}
+
+FrequencySketch::~FrequencySketch() {
+}
+
+void FrequencySketch::Init(int num_keys) {
+  index_bits_ = kMinIndexBits;
+  while (index_bits_ < kMaxIndexBits && (1 << index_bits_) < num_keys)
+    index_bits_++;
+
+  int counters_per_row = 1 << index_bits_;
+  table_.assign(kNumRows * counters_per_row / kCountersPerElement, 0);
+  sample_size_ = counters_per_row * 10;
+  num_increments_ = 0;
+}
+
+void FrequencySketch::Increment(uint32 hash) {
+  if (!is_initialized())
+    return;
+
+  bool added = false;
+  for (int row = 0; row < kNumRows; row++) {
+    uint32 index = GetIndex(hash, row);
+    uint64* element = &table_[index / kCountersPerElement];
+    int shift = (index % kCountersPerElement) * 4;
+    if (((*element >> shift) & 0xF) < kMaxFrequency) {
+      *element += GG_UINT64_C(1) << shift;
+      added = true;
+    }
+  }
+
+  if (added && ++num_increments_ >= sample_size_)
+    Age();
+}
+
+int FrequencySketch::Frequency(uint32 hash) const {
+  if (!is_initialized())
+    return 0;
+
+  int frequency = kMaxFrequency;
+  for (int row = 0; row < kNumRows; row++) {
+    uint32 index = GetIndex(hash, row);
+    uint64 element = table_[index / kCountersPerElement];
+    int shift = (index % kCountersPerElement) * 4;
+    frequency = std::min(frequency, static_cast<int>((element >> shift) & 0xF));
+  }
+  return frequency;
+}
+
+void FrequencySketch::Clear() {
+  std::fill(table_.begin(), table_.end(), 0);
+  num_increments_ = 0;
+}
+
+uint32 FrequencySketch::GetIndex(uint32 hash, int row) const {
+  // Each row has its own region of the table.
+  uint32 index = (hash * kSeeds[row]) >> (32 - index_bits_);
+  return (row << index_bits_) + index;
+}
+
+void FrequencySketch::Age() {
+  // Shift every counter right by one bit, dropping the bit that moves from one
+  // counter to its neighbor.
+  const uint64 kMask = GG_UINT64_C(0x7777777777777777);
+  for (size_t i = 0; i < table_.size(); i++)
+    table_[i] = (table_[i] >> 1) & kMask;
+  num_increments_ /= 2;
+}
+
+}  // namespace disk_cache
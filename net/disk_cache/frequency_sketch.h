@@ -0,0 +1,60 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DISK_CACHE_FREQUENCY_SKETCH_H_
+#define NET_DISK_CACHE_FREQUENCY_SKETCH_H_
+#pragma once
+
+#include <vector>
+
+#include "base/basictypes.h"
+
+namespace disk_cache {
+
+// This class provides an approximate count of how often a given key hash is
+// seen (a count-min sketch of 4-bit counters). The counts are periodically
+// halved so that the sketch reflects the recent popularity of each key. This
+// is the frequency filter used to decide if a new entry should be admitted
+// into a full cache (see Eviction::ShouldAdmit).
+class FrequencySketch {
+ public:
+  // The largest value returned by Frequency().
+  static const int kMaxFrequency = 15;
+
+  FrequencySketch();
+  ~FrequencySketch();
+
+  // Sizes the sketch to keep track of roughly |num_keys| distinct keys. All the
+  // current counts are discarded.
+  void Init(int num_keys);
+
+  // Records one more use of |hash|.
+  void Increment(uint32 hash);
+
+  // Returns the estimated number of recent uses of |hash|.
+  int Frequency(uint32 hash) const;
+
+  // Discards all counts.
+  void Clear();
+
+  bool is_initialized() const { return !table_.empty(); }
+
+ private:
+  // Returns the index of the counter of |hash| on a given |row|.
+  uint32 GetIndex(uint32 hash, int row) const;
+
+  // Halves all counters.
+  void Age();
+
+  std::vector<uint64> table_;  // 16 counters per element.
+  int index_bits_;  // log2 of the number of counters per row.
+  int num_increments_;
+  int sample_size_;  // Number of increments between Age() calls.
+
+  DISALLOW_COPY_AND_ASSIGN(FrequencySketch);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_FREQUENCY_SKETCH_H_
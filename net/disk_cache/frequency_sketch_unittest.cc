@@ -0,0 +1,54 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/frequency_sketch.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+TEST(FrequencySketchTest, Uninitialized) {
+  disk_cache::FrequencySketch sketch;
+  EXPECT_FALSE(sketch.is_initialized());
+  sketch.Increment(0x1234);
+  EXPECT_EQ(0, sketch.Frequency(0x1234));
+}
+
+TEST(FrequencySketchTest, Basics) {
+  disk_cache::FrequencySketch sketch;
+  sketch.Init(1000);
+  EXPECT_TRUE(sketch.is_initialized());
+  EXPECT_EQ(0, sketch.Frequency(0x1234));
+
+  for (int i = 0; i < 5; i++)
+    sketch.Increment(0x1234);
+  sketch.Increment(0x5678);
+
+  EXPECT_EQ(5, sketch.Frequency(0x1234));
+  EXPECT_EQ(1, sketch.Frequency(0x5678));
+
+  // The counters saturate.
+  for (int i = 0; i < 100; i++)
+    sketch.Increment(0x1234);
+  EXPECT_EQ(disk_cache::FrequencySketch::kMaxFrequency,
+            sketch.Frequency(0x1234));
+
+  sketch.Clear();
+  EXPECT_EQ(0, sketch.Frequency(0x1234));
+  EXPECT_EQ(0, sketch.Frequency(0x5678));
+}
+
+TEST(FrequencySketchTest, Aging) {
+  disk_cache::FrequencySketch sketch;
+  sketch.Init(1024);
+
+  for (int i = 0; i < 15; i++)
+    sketch.Increment(0xabcdef);
+  EXPECT_EQ(disk_cache::FrequencySketch::kMaxFrequency,
+            sketch.Frequency(0xabcdef));
+
+  // Enough activity makes the sketch halve all counts.
+  for (uint32 i = 0; i < 10 * 1024; i++)
+    sketch.Increment(i * 0x10001);
+
+  EXPECT_GT(disk_cache::FrequencySketch::kMaxFrequency,
+            sketch.Frequency(0xabcdef));
+}
@@ -0,0 +1,287 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/hot_set.h"
+
+#include <algorithm>
+
+#include "base/file_path.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/platform_file.h"
+#include "net/disk_cache/backend_impl.h"
+#include "net/disk_cache/entry_impl.h"
+#include "net/disk_cache/file.h"
+#include "net/disk_cache/histogram_macros.h"
+#include "net/disk_cache/mapped_file.h"
+
+namespace {
+
+const char kHotSetName[] = "hot_set";
+const uint32 kHotSetMagic = 0xC1A5E7;
+const uint32 kHotSetVersion = 1;
+
+// Number of block addresses tracked (about 400 entries).
+const int kMaxAddresses = 2048;
+
+// Blocks that are this close are read with a single operation.
+const int kMaxReadGap = 4096;
+const int kMaxReadSize = 64 * 1024;
+
+// Upper bound of the data read in the background at startup.
+const int kMaxPrefetchSize = 4 * 1024 * 1024;
+
+// Number of requests considered part of the cache startup.
+const int kWarmupUses = 100;
+
+struct HotSetHeader {
+  uint32 magic;
+  uint32 version;
+  int32 num_addresses;
+  int32 pad;
+};
+
+// A contiguous piece of a block file.
+struct FileRange {
+  disk_cache::Addr address;  // The first block of the range.
+  int file_type;
+  int file_number;
+  int offset;
+  int length;
+};
+
+bool RangeLess(const FileRange& a, const FileRange& b) {
+  if (a.file_type != b.file_type)
+    return a.file_type < b.file_type;
+  if (a.file_number != b.file_number)
+    return a.file_number < b.file_number;
+  return a.offset < b.offset;
+}
+
+}  // namespace
+
+namespace disk_cache {
+
+// A read from a block file that only wants the data on the page cache. The
+// object deletes itself when the read completes.
+class HotSet::PrefetchRead : public FileIOCallback {
+ public:
+  PrefetchRead(BackendImpl* backend, int length)
+      : backend_(backend), buffer_(new char[length]) {
+    backend_->IncrementIoCount();
+  }
+
+  virtual ~PrefetchRead() {
+    backend_->DecrementIoCount();
+  }
+
+  char* buffer() { return buffer_.get(); }
+
+  virtual void OnFileIOComplete(int bytes_copied) {
+    delete this;
+  }
+
+ private:
+  BackendImpl* backend_;
+  scoped_array<char> buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(PrefetchRead);
+};
+
+HotSet::HotSet()
+    : backend_(NULL), next_(0), num_uses_(0), prefetched_bytes_(0),
+      dirty_(false) {
+}
+
+HotSet::~HotSet() {
+}
+
+void HotSet::Init(BackendImpl* backend) {
+  backend_ = backend;
+  addresses_.clear();
+  next_ = 0;
+  recorded_.clear();
+  num_uses_ = 0;
+  prefetched_bytes_ = 0;
+  dirty_ = false;
+
+  FilePath name = backend_->path_.AppendASCII(kHotSetName);
+  int flags = base::PLATFORM_FILE_OPEN | base::PLATFORM_FILE_READ;
+  scoped_refptr<disk_cache::File> file(new disk_cache::File(
+      base::CreatePlatformFile(name, flags, NULL, NULL)));
+  if (!file->IsValid())
+    return;
+
+  HotSetHeader header;
+  if (!file->Read(&header, sizeof(header), 0) ||
+      header.magic != kHotSetMagic || header.version != kHotSetVersion ||
+      header.num_addresses <= 0 || header.num_addresses > kMaxAddresses) {
+    return;
+  }
+
+  std::vector<CacheAddr> values(header.num_addresses);
+  if (!file->Read(&values[0], values.size() * sizeof(values[0]),
+                  sizeof(header))) {
+    return;
+  }
+
+  std::vector<Addr> addresses;
+  for (size_t i = 0; i < values.size(); i++) {
+    Addr address(values[i]);
+    if (!address.is_initialized() || !address.is_block_file() ||
+        !address.SanityCheck()) {
+      continue;
+    }
+    addresses.push_back(address);
+    addresses_.push_back(values[i]);
+  }
+  next_ = addresses_.size() % kMaxAddresses;
+
+  Prefetch(addresses);
+}
+
+void HotSet::Stop() {
+  backend_ = NULL;
+  addresses_.clear();
+  next_ = 0;
+  recorded_.clear();
+  dirty_ = false;
+}
+
+void HotSet::OnEntryUsed(EntryImpl* entry) {
+  if (!backend_)
+    return;
+
+  num_uses_++;
+
+  // Popular entries are recorded only once between saves of the manifest.
+  if (recorded_.size() >= static_cast<size_t>(kMaxAddresses))
+    recorded_.clear();
+  if (!recorded_.insert(entry->entry()->address().value()).second)
+    return;
+
+  AddAddress(entry->rankings()->address());
+  AddAddress(entry->entry()->address());
+
+  EntryStore* store = entry->entry()->Data();
+  if (store->long_key)
+    AddAddress(Addr(store->long_key));
+
+  // The first two streams hold the HTTP headers and the start of the body.
+  for (int i = 0; i < 2; i++) {
+    if (store->data_addr[i])
+      AddAddress(Addr(store->data_addr[i]));
+  }
+}
+
+bool HotSet::IsWarmingUp() const {
+  return backend_ && num_uses_ <= kWarmupUses;
+}
+
+void HotSet::Store() {
+  if (!backend_ || !dirty_ || addresses_.empty())
+    return;
+
+  std::vector<CacheAddr> values(addresses_);
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+
+  FilePath name = backend_->path_.AppendASCII(kHotSetName);
+  int flags = base::PLATFORM_FILE_CREATE_ALWAYS | base::PLATFORM_FILE_WRITE;
+  scoped_refptr<disk_cache::File> file(new disk_cache::File(
+      base::CreatePlatformFile(name, flags, NULL, NULL)));
+  if (!file->IsValid())
+    return;
+
+  HotSetHeader header;
+  header.magic = kHotSetMagic;
+  header.version = kHotSetVersion;
+  header.num_addresses = static_cast<int32>(values.size());
+  header.pad = 0;
+
+  if (!file->Write(&header, sizeof(header), 0) ||
+      !file->Write(&values[0], values.size() * sizeof(values[0]),
+                   sizeof(header)) ||
+      !file->SetLength(sizeof(header) + values.size() * sizeof(values[0]))) {
+    return;
+  }
+  recorded_.clear();
+  dirty_ = false;
+}
+
+void HotSet::Prefetch(const std::vector<Addr>& addresses) {
+  std::vector<FileRange> ranges;
+  ranges.reserve(addresses.size());
+  for (size_t i = 0; i < addresses.size(); i++) {
+    FileRange range;
+    range.address = addresses[i];
+    range.file_type = addresses[i].file_type();
+    range.file_number = addresses[i].FileNumber();
+    range.offset = kBlockHeaderSize +
+                   addresses[i].start_block() * addresses[i].BlockSize();
+    range.length = addresses[i].num_blocks() * addresses[i].BlockSize();
+    ranges.push_back(range);
+  }
+  std::sort(ranges.begin(), ranges.end(), RangeLess);
+
+  // Merge the blocks that are close to each other, on the same file.
+  std::vector<FileRange> reads;
+  for (size_t i = 0; i < ranges.size(); i++) {
+    if (!reads.empty()) {
+      FileRange& last = reads.back();
+      int end = std::max(last.offset + last.length,
+                         ranges[i].offset + ranges[i].length);
+      if (last.file_type == ranges[i].file_type &&
+          last.file_number == ranges[i].file_number &&
+          ranges[i].offset <= last.offset + last.length + kMaxReadGap &&
+          end - last.offset <= kMaxReadSize) {
+        last.length = end - last.offset;
+        continue;
+      }
+    }
+    reads.push_back(ranges[i]);
+  }
+
+  for (size_t i = 0; i < reads.size(); i++) {
+    if (prefetched_bytes_ + reads[i].length > kMaxPrefetchSize)
+      break;
+
+    MappedFile* file = backend_->File(reads[i].address);
+    if (!file || file->GetLength() <
+                 static_cast<size_t>(reads[i].offset + reads[i].length)) {
+      continue;
+    }
+
+    PrefetchRead* read = new PrefetchRead(backend_, reads[i].length);
+    bool completed;
+    if (!file->Read(read->buffer(), reads[i].length, reads[i].offset, read,
+                    &completed)) {
+      delete read;
+      continue;
+    }
+    if (completed)
+      delete read;
+    prefetched_bytes_ += reads[i].length;
+  }
+
+  CACHE_UMA(COUNTS_10000, "PrefetchSize", 0, prefetched_bytes_ / 1024);
+  CACHE_UMA(COUNTS_10000, "PrefetchReads", 0, static_cast<int>(reads.size()));
+}
+
+void HotSet::AddAddress(Addr address) {
+  if (!address.is_initialized() || !address.is_block_file())
+    return;
+
+  dirty_ = true;
+  if (addresses_.size() < static_cast<size_t>(kMaxAddresses)) {
+    addresses_.push_back(address.value());
+    next_ = addresses_.size() % kMaxAddresses;
+    return;
+  }
+
+  addresses_[next_] = address.value();
+  next_ = (next_ + 1) % kMaxAddresses;
+}
+
+}  // namespace disk_cache
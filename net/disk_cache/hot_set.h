@@ -0,0 +1,74 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// See net/disk_cache/disk_cache.h for the public interface of the cache.
+
+#ifndef NET_DISK_CACHE_HOT_SET_H_
+#define NET_DISK_CACHE_HOT_SET_H_
+#pragma once
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/hash_tables.h"
+#include "net/disk_cache/addr.h"
+
+namespace disk_cache {
+
+class BackendImpl;
+class EntryImpl;
+
+// This class keeps track of the storage blocks used by the most recently used
+// entries of the cache, and saves that list (the hot set manifest) to disk
+// from time to time. When the cache starts, the blocks listed on the manifest
+// are read in the background, with sorted and coalesced reads, so that the
+// first requests after a restart don't have to go to cold storage for the
+// rankings nodes, entries and small data streams of popular entries.
+class HotSet {
+ public:
+  HotSet();
+  ~HotSet();
+
+  // Loads the manifest of |backend| and starts prefetching the listed blocks.
+  // The backend must keep track of the IO started by this object.
+  void Init(BackendImpl* backend);
+
+  // Drops all the state (the cache is going away).
+  void Stop();
+
+  // Records that |entry| was just used.
+  void OnEntryUsed(EntryImpl* entry);
+
+  // Returns true while the cache is serving the first requests after a start.
+  bool IsWarmingUp() const;
+
+  // Saves the manifest to disk.
+  void Store();
+
+  // Returns the number of bytes read by the last prefetch.
+  int prefetched_bytes() const { return prefetched_bytes_; }
+
+ private:
+  class PrefetchRead;
+
+  // Reads the blocks stored at |addresses|.
+  void Prefetch(const std::vector<Addr>& addresses);
+
+  // Adds |address| to the list of hot blocks, if it makes sense.
+  void AddAddress(Addr address);
+
+  BackendImpl* backend_;
+  std::vector<CacheAddr> addresses_;  // Circular list of recent blocks.
+  size_t next_;  // Position for the next address on addresses_.
+  base::hash_set<CacheAddr> recorded_;  // Entries recorded since the last save.
+  int num_uses_;
+  int prefetched_bytes_;
+  bool dirty_;
+
+  DISALLOW_COPY_AND_ASSIGN(HotSet);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_HOT_SET_H_
@@ -284,7 +284,8 @@ void BackendIO::ExecuteEntryOperation() {
 InFlightBackendIO::InFlightBackendIO(BackendImpl* backend,
                     base::MessageLoopProxy* background_thread)
     : backend_(backend),
-      background_thread_(background_thread) {
+      background_thread_(background_thread),
+      pending_creates_(0) {
 }
 
 InFlightBackendIO::~InFlightBackendIO() {
@@ -308,6 +309,7 @@ void InFlightBackendIO::CreateEntry(const std::string& key, Entry** entry,
   scoped_refptr<BackendIO> operation(new BackendIO(this, backend_, callback));
   operation->CreateEntry(key, entry);
   PostOperation(operation);
+  pending_creates_++;
 }
 
 void InFlightBackendIO::DoomEntry(const std::string& key,
@@ -448,6 +450,11 @@ void InFlightBackendIO::OnOperationComplete(BackgroundIO* operation,
     CACHE_UMA(TIMES, "TotalIOTime", 0, op->ElapsedTime());
   }
 
+  if (op->IsCreateOperation()) {
+    DCHECK_GT(pending_creates_, 0);
+    pending_creates_--;
+  }
+
   if (op->callback() && (!cancel || op->IsEntryOperation()))
     op->callback()->Run(op->result());
 }
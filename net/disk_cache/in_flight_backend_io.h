@@ -37,6 +37,9 @@ class BackendIO : public BackgroundIO {
   // Returns true if this operation is directed to an entry (vs. the backend).
   bool IsEntryOperation();
 
+  // Returns true if this operation creates an entry.
+  bool IsCreateOperation() const { return operation_ == OP_CREATE; }
+
   net::CompletionCallback* callback() { return callback_; }
 
   // Grabs an extra reference of entry_.
@@ -190,6 +193,9 @@ class InFlightBackendIO : public InFlightIO {
     return background_thread_->BelongsToCurrentThread();
   }
 
+  // Returns true if an entry creation has not completed yet.
+  bool HasPendingCreates() const { return pending_creates_ > 0; }
+
  protected:
   virtual void OnOperationComplete(BackgroundIO* operation, bool cancel);
 
@@ -198,6 +204,7 @@ class InFlightBackendIO : public InFlightIO {
 
   BackendImpl* backend_;
   scoped_refptr<base::MessageLoopProxy> background_thread_;
+  int pending_creates_;
 
   DISALLOW_COPY_AND_ASSIGN(InFlightBackendIO);
 };
@@ -0,0 +1,292 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/journal.h"
+
+#include "base/file_path.h"
+#include "base/logging.h"
+#include "base/platform_file.h"
+#include "net/disk_cache/addr.h"
+#include "net/disk_cache/block_files.h"
+#include "net/disk_cache/disk_format.h"
+#include "net/disk_cache/file.h"
+#include "net/disk_cache/hash.h"
+#include "net/disk_cache/mapped_file.h"
+#include "net/disk_cache/trace.h"
+
+namespace {
+
+const uint32 kJournalMagic = 0xC1A5E8;
+const uint32 kJournalVersion = 1;
+const uint32 kGroupMagic = 0x6A6E6C;
+
+// The pending blocks are written to the block files when the journal grows
+// beyond this size.
+const size_t kMaxJournalSize = 256 * 1024;
+
+struct JournalHeader {
+  uint32 magic;
+  uint32 version;
+};
+
+// A group of records, written with a single operation. The hash covers all the
+// records of the group.
+struct GroupHeader {
+  uint32 magic;
+  int32 num_records;
+  int32 size;
+  uint32 hash;
+};
+
+// A record is followed by the |size| bytes of the block.
+struct RecordHeader {
+  int32 file_index;
+  int32 offset;
+  int32 size;
+};
+
+}  // namespace
+
+namespace disk_cache {
+
+Journal::Journal()
+    : files_(NULL), group_records_(0), group_depth_(0), journal_size_(0) {
+}
+
+Journal::~Journal() {
+  DCHECK(!file_);
+}
+
+bool Journal::Init(const FilePath& name, BlockFiles* files, bool create) {
+  DCHECK(!file_);
+  files_ = files;
+  pending_.clear();
+  group_.clear();
+  group_records_ = 0;
+  group_depth_ = 0;
+  journal_size_ = 0;
+
+  int flags = base::PLATFORM_FILE_READ | base::PLATFORM_FILE_WRITE;
+  flags |= create ? base::PLATFORM_FILE_CREATE_ALWAYS :
+                    base::PLATFORM_FILE_OPEN_ALWAYS;
+  file_ = new File(base::CreatePlatformFile(name, flags, NULL, NULL));
+  if (!file_->IsValid()) {
+    file_ = NULL;
+    return false;
+  }
+
+  if (!create)
+    Replay();
+
+  if (!journal_size_) {
+    JournalHeader header;
+    header.magic = kJournalMagic;
+    header.version = kJournalVersion;
+    if (!file_->Write(&header, sizeof(header), 0) ||
+        !file_->SetLength(sizeof(header))) {
+      file_ = NULL;
+      pending_.clear();
+      return false;
+    }
+    journal_size_ = sizeof(header);
+  }
+  return true;
+}
+
+void Journal::Close() {
+  if (!file_)
+    return;
+
+  DCHECK(!group_depth_);
+  Commit();
+  Flush();
+  file_ = NULL;
+  group_depth_ = 0;
+}
+
+bool Journal::IsValid() const {
+  return file_ != NULL;
+}
+
+void Journal::Flush() {
+  if (!file_)
+    return;
+
+  // The blocks are sorted by file and offset, so consecutive blocks can be
+  // written together.
+  PendingBlocks::const_iterator it = pending_.begin();
+  while (it != pending_.end()) {
+    int file_index = it->first.first;
+    size_t offset = it->first.second;
+    std::string data(it->second);
+    for (++it; it != pending_.end() && it->first.first == file_index &&
+               it->first.second == offset + data.size(); ++it) {
+      data.append(it->second);
+    }
+
+    MappedFile* file = files_->GetFile(Addr(RANKINGS, 1, file_index, 0));
+    if (!file)
+      continue;
+
+    // Make sure that the blocks still belong to a rankings file.
+    BlockFileHeader* header =
+        reinterpret_cast<BlockFileHeader*>(file->buffer());
+    if (header->entry_size != Addr::BlockSizeForFileType(RANKINGS) ||
+        offset + data.size() > file->GetLength()) {
+      continue;
+    }
+
+    if (!file->Write(data.data(), data.size(), offset))
+      Trace("Failed journal flush 0x%x", file_index);
+  }
+  pending_.clear();
+
+  if (journal_size_ > sizeof(JournalHeader)) {
+    file_->SetLength(sizeof(JournalHeader));
+    journal_size_ = sizeof(JournalHeader);
+  }
+}
+
+void Journal::BeginGroup() {
+  group_depth_++;
+}
+
+void Journal::EndGroup() {
+  DCHECK_GT(group_depth_, 0);
+  if (--group_depth_ > 0)
+    return;
+
+  Commit();
+}
+
+void Journal::Commit() {
+  if (!file_ || !group_records_)
+    return;
+
+  GroupHeader group;
+  group.magic = kGroupMagic;
+  group.num_records = group_records_;
+  group.size = static_cast<int32>(group_.size());
+  group.hash = Hash(group_);
+
+  std::string buffer(reinterpret_cast<const char*>(&group), sizeof(group));
+  buffer.append(group_);
+  group_.clear();
+  group_records_ = 0;
+
+  if (!file_->Write(buffer.data(), buffer.size(), journal_size_)) {
+    // Write everything to the block files instead.
+    Flush();
+    return;
+  }
+
+  journal_size_ += buffer.size();
+  if (journal_size_ > kMaxJournalSize)
+    Flush();
+}
+
+bool Journal::Load(int file_index, size_t offset, void* buffer, size_t size) {
+  PendingBlocks::const_iterator it =
+      pending_.find(std::make_pair(file_index, offset));
+  if (it == pending_.end())
+    return false;
+
+  DCHECK_EQ(size, it->second.size());
+  if (size != it->second.size())
+    return false;
+
+  memcpy(buffer, it->second.data(), size);
+  return true;
+}
+
+bool Journal::Store(int file_index, size_t offset, const void* buffer,
+                    size_t size) {
+  if (!file_)
+    return false;
+
+  RecordHeader record;
+  record.file_index = file_index;
+  record.offset = static_cast<int32>(offset);
+  record.size = static_cast<int32>(size);
+
+  const char* data = static_cast<const char*>(buffer);
+  group_.append(reinterpret_cast<const char*>(&record), sizeof(record));
+  group_.append(data, size);
+  group_records_++;
+  pending_[std::make_pair(file_index, offset)].assign(data, size);
+
+  if (!group_depth_)
+    Commit();
+  return true;
+}
+
+void Journal::Replay() {
+  size_t length = file_->GetLength();
+  JournalHeader header;
+  if (length < sizeof(header) || !file_->Read(&header, sizeof(header), 0) ||
+      header.magic != kJournalMagic || header.version != kJournalVersion) {
+    return;
+  }
+
+  // Stop at the first group that is not complete.
+  size_t position = sizeof(header);
+  std::string body;
+  while (position + sizeof(GroupHeader) <= length) {
+    GroupHeader group;
+    if (!file_->Read(&group, sizeof(group), position))
+      break;
+
+    if (group.magic != kGroupMagic || group.num_records <= 0 ||
+        group.size <= 0 ||
+        position + sizeof(group) + group.size > length) {
+      break;
+    }
+
+    body.resize(group.size);
+    if (!file_->Read(&body[0], group.size, position + sizeof(group)) ||
+        Hash(body) != group.hash ||
+        !ParseGroup(body, group.num_records, &pending_)) {
+      break;
+    }
+    position += sizeof(group) + group.size;
+  }
+
+  if (position < length)
+    file_->SetLength(position);
+  journal_size_ = position;
+}
+
+bool Journal::ParseGroup(const std::string& group, int num_records,
+                         PendingBlocks* blocks) {
+  PendingBlocks records;
+  size_t position = 0;
+  for (int i = 0; i < num_records; i++) {
+    RecordHeader record;
+    if (position + sizeof(record) > group.size())
+      return false;
+    memcpy(&record, group.data() + position, sizeof(record));
+    position += sizeof(record);
+
+    if (record.file_index < 0 || record.file_index > kMaxBlockFile ||
+        record.offset < kBlockHeaderSize ||
+        record.size <= 0 || position + record.size > group.size()) {
+      return false;
+    }
+    records[std::make_pair(record.file_index,
+                           static_cast<size_t>(record.offset))] =
+        group.substr(position, record.size);
+    position += record.size;
+  }
+
+  if (position != group.size())
+    return false;
+
+  for (PendingBlocks::iterator it = records.begin(); it != records.end();
+       ++it) {
+    (*blocks)[it->first].swap(it->second);
+  }
+  return true;
+}
+
+}  // namespace disk_cache
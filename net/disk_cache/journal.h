@@ -0,0 +1,95 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// See net/disk_cache/disk_cache.h for the public interface of the cache.
+
+#ifndef NET_DISK_CACHE_JOURNAL_H_
+#define NET_DISK_CACHE_JOURNAL_H_
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+
+class FilePath;
+
+namespace disk_cache {
+
+class BlockFiles;
+class File;
+
+// This class implements a write-back journal for the blocks of the rankings
+// files. Instead of writing every modified rankings node to its block file
+// right away (and all over the file), the new contents of the node are
+// appended to the journal and kept in memory until the journal grows too big.
+// At that point all the pending blocks are written to the block files, sorted
+// by position, and the journal is emptied.
+//
+// Blocks stored together (for instance, the three nodes modified by a removal
+// from a list) are written to the journal as a single group, and after a crash
+// only the groups that were completely written are applied to the block files.
+// Note that the rankings code still relies on the header of the rankings file
+// to finish an interrupted operation, so a group has to be committed before
+// the header starts pointing to any block of the group.
+class Journal {
+ public:
+  Journal();
+  ~Journal();
+
+  // Opens the journal stored on |name|, for the blocks of |files|. If |create|
+  // is false, the blocks from a previous instance of the cache that were not
+  // written yet are loaded; the caller should call Flush() when all the files
+  // are ready.
+  bool Init(const FilePath& name, BlockFiles* files, bool create);
+
+  // Writes the current group and all the pending blocks to their files, and
+  // closes the journal.
+  void Close();
+
+  // Returns true if the journal is in use.
+  bool IsValid() const;
+
+  // Writes all the pending blocks to their files, and empties the journal.
+  void Flush();
+
+  // Groups the blocks stored between these calls. Blocks stored outside of a
+  // group are immediately committed by themselves. Groups can be nested.
+  void BeginGroup();
+  void EndGroup();
+
+  // Writes the blocks stored so far by the current group to the journal.
+  void Commit();
+
+  // Journaled versions of MappedFile::Load and Store for the block file number
+  // |file_index|. Load returns false if the block is not pending.
+  bool Load(int file_index, size_t offset, void* buffer, size_t size);
+  bool Store(int file_index, size_t offset, const void* buffer, size_t size);
+
+ private:
+  typedef std::map<std::pair<int, size_t>, std::string> PendingBlocks;
+
+  // Loads the groups stored on the journal file.
+  void Replay();
+
+  // Parses the |num_records| records of a group, and adds them to |blocks|.
+  bool ParseGroup(const std::string& group, int num_records,
+                  PendingBlocks* blocks);
+
+  BlockFiles* files_;
+  scoped_refptr<File> file_;
+  PendingBlocks pending_;  // Blocks not written to the block files yet.
+  std::string group_;  // Records of the current group.
+  int group_records_;
+  int group_depth_;
+  size_t journal_size_;  // Current length of the journal file.
+
+  DISALLOW_COPY_AND_ASSIGN(Journal);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_JOURNAL_H_
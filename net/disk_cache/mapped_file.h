@@ -8,6 +8,8 @@
 #define NET_DISK_CACHE_MAPPED_FILE_H_
 #pragma once
 
+#include "base/memory/ref_counted.h"
+#include "net/base/io_buffer.h"
 #include "net/disk_cache/disk_format.h"
 #include "net/disk_cache/file.h"
 #include "net/disk_cache/file_block.h"
@@ -16,13 +18,15 @@ class FilePath;
 
 namespace disk_cache {
 
+class Journal;
+
 // This class implements a memory mapped file used to access block-files. The
 // idea is that the header and bitmap will be memory mapped all the time, and
 // the actual data for the blocks will be access asynchronously (most of the
 // time).
 class MappedFile : public File {
  public:
-  MappedFile() : File(true), init_(false) {}
+  MappedFile() : File(true), init_(false), journal_(NULL), file_index_(0) {}
 
   // Performs object initialization. name is the file to use, and size is the
   // ammount of data to memory map from th efile. If size is 0, the whole file
@@ -37,10 +41,19 @@ class MappedFile : public File {
   bool Load(const FileBlock* block);
   bool Store(const FileBlock* block);
 
+  // Sends the blocks stored on this file (the block file number |file_index|)
+  // through |journal|.
+  void set_journal(Journal* journal, int file_index) {
+    journal_ = journal;
+    file_index_ = file_index;
+  }
+
  private:
   virtual ~MappedFile();
 
   bool init_;
+  Journal* journal_;
+  int file_index_;
 #if defined(OS_WIN)
   HANDLE section_;
 #endif
@@ -50,6 +63,35 @@ class MappedFile : public File {
   DISALLOW_COPY_AND_ASSIGN(MappedFile);
 };
 
+// This class implements an IOBuffer that points to a read-only memory mapped
+// view of a section of a file, so that the data stored on the file can be
+// handed out without being copied. The file is kept alive by the buffer.
+class MappedIOBuffer : public net::IOBuffer {
+ public:
+  // Maps |size| bytes of |file|, starting at |offset|. Returns NULL if the
+  // section cannot be mapped.
+  static MappedIOBuffer* Create(File* file, size_t offset, size_t size);
+
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  MappedIOBuffer(File* file, void* view, size_t view_size, char* data,
+                 size_t size);
+  virtual ~MappedIOBuffer();
+
+  scoped_refptr<File> file_;
+#if defined(OS_WIN)
+  HANDLE section_;
+#endif
+  void* view_;  // Address of the mapped view (aligned to a page boundary).
+  size_t view_size_;  // Size of the memory pointed by view_.
+  size_t size_;  // Size of the requested data.
+
+  DISALLOW_COPY_AND_ASSIGN(MappedIOBuffer);
+};
+
 }  // namespace disk_cache
 
 #endif  // NET_DISK_CACHE_MAPPED_FILE_H_
@@ -9,7 +9,9 @@
 
 #include "base/file_path.h"
 #include "base/logging.h"
+#include "base/sys_info.h"
 #include "net/disk_cache/disk_cache.h"
+#include "net/disk_cache/journal.h"
 
 namespace disk_cache {
 
@@ -34,11 +36,17 @@ void* MappedFile::Init(const FilePath& name, size_t size) {
 
 bool MappedFile::Load(const FileBlock* block) {
   size_t offset = block->offset() + view_size_;
+  if (journal_ &&
+      journal_->Load(file_index_, offset, block->buffer(), block->size())) {
+    return true;
+  }
   return Read(block->buffer(), block->size(), offset);
 }
 
 bool MappedFile::Store(const FileBlock* block) {
   size_t offset = block->offset() + view_size_;
+  if (journal_)
+    return journal_->Store(file_index_, offset, block->buffer(), block->size());
   return Write(block->buffer(), block->size(), offset);
 }
 
@@ -52,4 +60,37 @@ MappedFile::~MappedFile() {
   }
 }
 
+// static
+MappedIOBuffer* MappedIOBuffer::Create(File* file, size_t offset,
+                                       size_t size) {
+  DCHECK(size);
+  if (!size || offset + size > file->GetLength())
+    return NULL;
+
+  // The view has to start at a page boundary.
+  size_t granularity = base::SysInfo::VMAllocationGranularity();
+  size_t view_offset = offset - offset % granularity;
+  size_t view_size = size + offset - view_offset;
+
+  void* view = mmap(NULL, view_size, PROT_READ, MAP_SHARED,
+                    file->platform_file(), view_offset);
+  if (view == MAP_FAILED)
+    return NULL;
+
+  char* data = static_cast<char*>(view) + (offset - view_offset);
+  return new MappedIOBuffer(file, view, view_size, data, size);
+}
+
+MappedIOBuffer::MappedIOBuffer(File* file, void* view, size_t view_size,
+                               char* data, size_t size)
+    : net::IOBuffer(data), file_(file), view_(view), view_size_(view_size),
+      size_(size) {
+}
+
+MappedIOBuffer::~MappedIOBuffer() {
+  int ret = munmap(view_, view_size_);
+  DCHECK(0 == ret);
+  data_ = NULL;  // We don't own the data.
+}
+
 }  // namespace disk_cache
@@ -89,3 +89,48 @@ TEST_F(DiskCacheTest, MappedFile_AsyncIO) {
   EXPECT_FALSE(g_cache_tests_error);
   EXPECT_STREQ(buffer1, buffer2);
 }
+
+// Tests that a burst of contiguous asynchronous operations (that may be merged
+// into a single vectored operation) completes each individual request.
+TEST_F(DiskCacheTest, MappedFile_ContiguousAsyncIO) {
+  FilePath filename = GetCacheFilePath().AppendASCII("a_test");
+  scoped_refptr<disk_cache::MappedFile> file(new disk_cache::MappedFile);
+  ASSERT_TRUE(CreateCacheTestFile(filename));
+  ASSERT_TRUE(file->Init(filename, 8192));
+
+  FileCallbackTest callback(1);
+  g_cache_tests_error = false;
+  g_cache_tests_max_id = 1;
+  g_cache_tests_received = 0;
+
+  MessageLoopHelper helper;
+
+  const int kNumOperations = 10;
+  const int kSize = 1024;
+  char buffer1[kNumOperations * kSize];
+  char buffer2[kNumOperations * kSize];
+  CacheTestFillBuffer(buffer1, sizeof(buffer1), false);
+  memset(buffer2, 0, sizeof(buffer2));
+
+  int expected = 0;
+  bool completed;
+  for (int i = 0; i < kNumOperations; i++) {
+    EXPECT_TRUE(file->Write(buffer1 + i * kSize, kSize, 8192 + i * kSize,
+                            &callback, &completed));
+    if (!completed)
+      expected++;
+  }
+  helper.WaitUntilCacheIoFinished(expected);
+
+  for (int i = 0; i < kNumOperations; i++) {
+    EXPECT_TRUE(file->Read(buffer2 + i * kSize, kSize, 8192 + i * kSize,
+                           &callback, &completed));
+    if (!completed)
+      expected++;
+  }
+  helper.WaitUntilCacheIoFinished(expected);
+
+  EXPECT_EQ(expected, g_cache_tests_received);
+  EXPECT_FALSE(g_cache_tests_error);
+  EXPECT_EQ(0, memcmp(buffer1, buffer2, sizeof(buffer1)));
+}
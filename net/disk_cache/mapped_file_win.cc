@@ -6,7 +6,9 @@
 
 #include "base/file_path.h"
 #include "base/logging.h"
+#include "base/sys_info.h"
 #include "net/disk_cache/disk_cache.h"
+#include "net/disk_cache/journal.h"
 
 namespace disk_cache {
 
@@ -44,12 +46,63 @@ MappedFile::~MappedFile() {
 
 bool MappedFile::Load(const FileBlock* block) {
   size_t offset = block->offset() + view_size_;
+  if (journal_ &&
+      journal_->Load(file_index_, offset, block->buffer(), block->size())) {
+    return true;
+  }
   return Read(block->buffer(), block->size(), offset);
 }
 
 bool MappedFile::Store(const FileBlock* block) {
   size_t offset = block->offset() + view_size_;
+  if (journal_)
+    return journal_->Store(file_index_, offset, block->buffer(), block->size());
   return Write(block->buffer(), block->size(), offset);
 }
 
+// static
+MappedIOBuffer* MappedIOBuffer::Create(File* file, size_t offset,
+                                       size_t size) {
+  DCHECK(size);
+  if (!size || offset + size > file->GetLength())
+    return NULL;
+
+  // The view has to start at an allocation boundary.
+  size_t granularity = base::SysInfo::VMAllocationGranularity();
+  size_t view_offset = offset - offset % granularity;
+  size_t view_size = size + offset - view_offset;
+
+  HANDLE section = CreateFileMapping(file->platform_file(), NULL, PAGE_READONLY,
+                                     0, 0, NULL);
+  if (!section)
+    return NULL;
+
+  void* view = MapViewOfFile(section, FILE_MAP_READ, 0,
+                             static_cast<DWORD>(view_offset), view_size);
+  if (!view) {
+    CloseHandle(section);
+    return NULL;
+  }
+
+  char* data = static_cast<char*>(view) + (offset - view_offset);
+  MappedIOBuffer* buffer = new MappedIOBuffer(file, view, view_size, data,
+                                              size);
+  buffer->section_ = section;
+  return buffer;
+}
+
+MappedIOBuffer::MappedIOBuffer(File* file, void* view, size_t view_size,
+                               char* data, size_t size)
+    : net::IOBuffer(data), file_(file), section_(NULL), view_(view),
+      view_size_(view_size), size_(size) {
+}
+
+MappedIOBuffer::~MappedIOBuffer() {
+  BOOL ret = UnmapViewOfFile(view_);
+  DCHECK(ret);
+  if (section_)
+    CloseHandle(section_);
+  data_ = NULL;  // We don't own the data.
+}
+
 }  // namespace disk_cache
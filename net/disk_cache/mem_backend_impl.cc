@@ -291,20 +291,32 @@ bool MemBackendImpl::OpenNextEntry(void** iter, Entry** next_entry) {
 }
 
 void MemBackendImpl::TrimCache(bool empty) {
-  MemEntryImpl* next = rankings_.GetPrev(NULL);
-
-  DCHECK(next);
+  DCHECK(rankings_.GetPrev(NULL));
+  EvictEntries(empty ? 0 : LowWaterAdjust(max_size_), empty);
+}
 
-  int target_size = empty ? 0 : LowWaterAdjust(max_size_);
+void MemBackendImpl::EvictEntries(int32 target_size, bool in_use_too) {
+  MemEntryImpl* next = rankings_.GetPrev(NULL);
   while (current_size_ > target_size && next) {
     MemEntryImpl* node = next;
     next = rankings_.GetPrev(next);
-    if (!node->InUse() || empty) {
+    if (!node->InUse() || in_use_too) {
+      // Dooming a parent dooms its children too, and |next| may be one of
+      // them.
+      bool restart = node->type() == MemEntryImpl::kParentEntry;
       node->Doom();
+      if (restart)
+        next = rankings_.GetPrev(NULL);
     }
   }
+}
 
-  return;
+size_t MemBackendImpl::PurgeMemory(net::MemoryPressureLevel level) {
+  int64 heap_bytes = allocator_.heap_bytes();
+  EvictEntries(level == net::MEMORY_PRESSURE_CRITICAL ? 0 : current_size_ / 2,
+               false);
+  allocator_.ReleaseFreeSlabs();
+  return static_cast<size_t>(heap_bytes - allocator_.heap_bytes());
 }
 
 void MemBackendImpl::AddStorageSize(int32 bytes) {
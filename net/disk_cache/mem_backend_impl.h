@@ -12,6 +12,7 @@
 
 #include "net/disk_cache/disk_cache.h"
 #include "net/disk_cache/mem_rankings.h"
+#include "net/disk_cache/mem_slab_allocator.h"
 
 namespace net {
 class NetLog;
@@ -53,6 +54,9 @@ class MemBackendImpl : public Backend {
   // Returns the maximum size for a file to reside on the cache.
   int MaxFileSize() const;
 
+  // Returns the allocator for the user data of the entries.
+  MemSlabAllocator* allocator() { return &allocator_; }
+
   // Insert an MemEntryImpl into the ranking list. This method is only called
   // from MemEntryImpl to insert child entries. The reference can be removed
   // by calling RemoveFromRankingList(|entry|).
@@ -80,6 +84,7 @@ class MemBackendImpl : public Backend {
   virtual void EndEnumeration(void** iter);
   virtual void GetStats(
       std::vector<std::pair<std::string, std::string> >* stats) {}
+  virtual size_t PurgeMemory(net::MemoryPressureLevel level);
 
  private:
   typedef base::hash_map<std::string, MemEntryImpl*> EntryMap;
@@ -99,10 +104,15 @@ class MemBackendImpl : public Backend {
   // use.
   void TrimCache(bool empty);
 
+  // Deletes the least recently used entries until the current size is down to
+  // |target_size|. Entries in use are only deleted if |in_use_too| is true.
+  void EvictEntries(int32 target_size, bool in_use_too);
+
   // Handles the used storage count.
   void AddStorageSize(int32 bytes);
   void SubstractStorageSize(int32 bytes);
 
+  MemSlabAllocator allocator_;  // Must outlive the entries.
   EntryMap entries_;
   MemRankings rankings_;  // Rankings to be able to trim the cache.
   int32 max_size_;        // Maximum data size for this instance.
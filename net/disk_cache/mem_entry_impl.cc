@@ -4,11 +4,14 @@
 
 #include "net/disk_cache/mem_entry_impl.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/stringprintf.h"
 #include "net/base/io_buffer.h"
 #include "net/base/net_errors.h"
 #include "net/disk_cache/mem_backend_impl.h"
+#include "net/disk_cache/mem_slab_allocator.h"
 #include "net/disk_cache/net_log_parameters.h"
 
 using base::Time;
@@ -54,8 +57,10 @@ MemEntryImpl::MemEntryImpl(MemBackendImpl* backend) {
   child_first_pos_ = 0;
   next_ = NULL;
   prev_ = NULL;
-  for (int i = 0; i < NUM_STREAMS; i++)
+  for (int i = 0; i < NUM_STREAMS; i++) {
+    data_[i] = NULL;
     data_size_[i] = 0;
+  }
 }
 
 // ------------------------------------------------------------------------
@@ -263,7 +268,7 @@ int MemEntryImpl::ReadyForSparseIO(
 
 MemEntryImpl::~MemEntryImpl() {
   for (int i = 0; i < NUM_STREAMS; i++)
-    backend_->ModifyStorageSize(data_size_[i], 0);
+    ResizeStream(i, 0);
   backend_->ModifyStorageSize(static_cast<int32>(key_.size()), 0);
   net_log_.EndEvent(net::NetLog::TYPE_DISK_CACHE_MEM_ENTRY_IMPL, NULL);
 }
@@ -287,7 +292,7 @@ int MemEntryImpl::InternalReadData(int index, int offset, net::IOBuffer* buf,
 
   UpdateRank(false);
 
-  memcpy(buf->data(), &(data_[index])[offset], buf_len);
+  memcpy(buf->data(), data_[index] + offset, buf_len);
   return buf_len;
 }
 
@@ -314,22 +319,15 @@ int MemEntryImpl::InternalWriteData(int index, int offset, net::IOBuffer* buf,
 
   PrepareTarget(index, offset, buf_len);
 
-  if (entry_size < offset + buf_len) {
-    backend_->ModifyStorageSize(entry_size, offset + buf_len);
-    data_size_[index] = offset + buf_len;
-  } else if (truncate) {
-    if (entry_size > offset + buf_len) {
-      backend_->ModifyStorageSize(entry_size, offset + buf_len);
-      data_size_[index] = offset + buf_len;
-    }
-  }
+  if (truncate && entry_size > offset + buf_len)
+    ResizeStream(index, offset + buf_len);
 
   UpdateRank(true);
 
   if (!buf_len)
     return 0;
 
-  memcpy(&(data_[index])[offset], buf->data(), buf_len);
+  memcpy(data_[index] + offset, buf->data(), buf_len);
   return buf_len;
 }
 
@@ -508,15 +506,34 @@ void MemEntryImpl::PrepareTarget(int index, int offset, int buf_len) {
   if (entry_size >= offset + buf_len)
     return;  // Not growing the stored data.
 
-  if (static_cast<int>(data_[index].size()) < offset + buf_len)
-    data_[index].resize(offset + buf_len);
+  ResizeStream(index, offset + buf_len);
 
   if (offset <= entry_size)
     return;  // There is no "hole" on the stored data.
 
   // Cleanup the hole not written by the user. The point is to avoid returning
   // random stuff later on.
-  memset(&(data_[index])[entry_size], 0, offset - entry_size);
+  memset(data_[index] + entry_size, 0, offset - entry_size);
+}
+
+void MemEntryImpl::ResizeStream(int index, int new_size) {
+  int old_size = data_size_[index];
+  int old_capacity = MemSlabAllocator::GetCapacity(old_size);
+  int new_capacity = MemSlabAllocator::GetCapacity(new_size);
+  data_size_[index] = new_size;
+  if (old_capacity == new_capacity)
+    return;
+
+  // The cache is charged for the memory actually used, not for the size of the
+  // stream. Note that growing the storage may trim the cache, so the data is
+  // moved before that.
+  MemSlabAllocator* allocator = backend_->allocator();
+  char* new_data = allocator->Allocate(new_size);
+  if (old_size && new_size)
+    memcpy(new_data, data_[index], std::min(old_size, new_size));
+  allocator->Free(data_[index], old_size);
+  data_[index] = new_data;
+  backend_->ModifyStorageSize(old_capacity, new_capacity);
 }
 
 void MemEntryImpl::UpdateRank(bool modified) {
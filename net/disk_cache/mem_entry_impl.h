@@ -136,6 +136,10 @@ class MemEntryImpl : public Entry {
   // Grows and cleans up the data buffer.
   void PrepareTarget(int index, int offset, int buf_len);
 
+  // Moves the data of stream |index| to a buffer for |new_size| bytes, if
+  // needed, and updates the size of the stream.
+  void ResizeStream(int index, int new_size);
+
   // Updates ranking information.
   void UpdateRank(bool modified);
 
@@ -163,7 +167,7 @@ class MemEntryImpl : public Entry {
   void DetachChild(int child_id);
 
   std::string key_;
-  std::vector<char> data_[NUM_STREAMS];  // User data.
+  char* data_[NUM_STREAMS];    // User data, from the backend's allocator.
   int32 data_size_[NUM_STREAMS];
   int ref_count_;
 
@@ -0,0 +1,184 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/mem_slab_allocator.h"
+
+#include <set>
+
+#include "base/logging.h"
+
+namespace {
+
+// The smallest buffer is 2 to the power of this number.
+const int kMinCapacityBits = 6;
+const int kMinCapacity = 1 << kMinCapacityBits;
+
+// Buffers up to 2 to the power of this number come from slabs.
+const int kMaxSlabBufferBits = 14;
+const int kMaxSlabBuffer = 1 << kMaxSlabBufferBits;
+
+// Each power of two is split in this many size classes, so no more than 25% of
+// a buffer is wasted.
+const int kClassesPerPowerBits = 2;
+const int kClassesPerPower = 1 << kClassesPerPowerBits;
+
+const int kNumSizeClasses =
+    1 + (kMaxSlabBufferBits - kMinCapacityBits) * kClassesPerPower;
+
+const int kSlabSize = 64 * 1024;
+
+// Returns the position of the most significant bit of |value|.
+int Log2Floor(int value) {
+  DCHECK_GT(value, 0);
+  int log = 0;
+  while (value >>= 1)
+    log++;
+  return log;
+}
+
+}  // namespace
+
+namespace disk_cache {
+
+MemSlabAllocator::MemSlabAllocator()
+    : free_lists_(kNumSizeClasses),
+      allocated_bytes_(0),
+      slab_bytes_(0),
+      heap_bytes_(0) {
+  COMPILE_ASSERT(kSlabSize >= kMaxSlabBuffer, slab_too_small);
+}
+
+MemSlabAllocator::~MemSlabAllocator() {
+  for (SlabMap::iterator it = slabs_.begin(); it != slabs_.end(); ++it)
+    delete[] it->first;
+}
+
+// Static.
+int MemSlabAllocator::GetCapacity(int size) {
+  DCHECK_GE(size, 0);
+  if (!size)
+    return 0;
+  if (size <= kMinCapacity)
+    return kMinCapacity;
+
+  // Round up to the next multiple of a quarter of the power of two below size.
+  int step = 1 << (Log2Floor(size - 1) - kClassesPerPowerBits);
+  return (size + step - 1) & ~(step - 1);
+}
+
+char* MemSlabAllocator::Allocate(int size) {
+  int capacity = GetCapacity(size);
+  if (!capacity)
+    return NULL;
+
+  allocated_bytes_ += capacity;
+  int size_class = GetSizeClass(capacity);
+  if (size_class < 0) {
+    heap_bytes_ += capacity;
+    return new char[capacity];
+  }
+
+  if (!free_lists_[size_class])
+    AddSlab(size_class, capacity);
+
+  FreeBuffer* buffer = free_lists_[size_class];
+  free_lists_[size_class] = buffer->next;
+  return reinterpret_cast<char*>(buffer);
+}
+
+void MemSlabAllocator::Free(char* buffer, int size) {
+  int capacity = GetCapacity(size);
+  if (!buffer) {
+    DCHECK(!capacity);
+    return;
+  }
+
+  allocated_bytes_ -= capacity;
+  DCHECK_GE(allocated_bytes_, 0);
+  int size_class = GetSizeClass(capacity);
+  if (size_class < 0) {
+    heap_bytes_ -= capacity;
+    delete[] buffer;
+    return;
+  }
+
+  FreeBuffer* free_buffer = reinterpret_cast<FreeBuffer*>(buffer);
+  free_buffer->next = free_lists_[size_class];
+  free_lists_[size_class] = free_buffer;
+}
+
+int64 MemSlabAllocator::ReleaseFreeSlabs() {
+  std::map<char*, int> free_buffers;
+  for (size_t i = 0; i < free_lists_.size(); i++) {
+    for (FreeBuffer* buffer = free_lists_[i]; buffer; buffer = buffer->next)
+      free_buffers[FindSlab(buffer)->first]++;
+  }
+
+  std::set<char*> released;
+  for (SlabMap::iterator it = slabs_.begin(); it != slabs_.end(); ++it) {
+    if (free_buffers[it->first] == kSlabSize / it->second)
+      released.insert(it->first);
+  }
+  if (released.empty())
+    return 0;
+
+  // Unlink the buffers of the released slabs, keeping the order of the rest.
+  for (size_t i = 0; i < free_lists_.size(); i++) {
+    FreeBuffer** link = &free_lists_[i];
+    while (*link) {
+      if (released.count(FindSlab(*link)->first))
+        *link = (*link)->next;
+      else
+        link = &(*link)->next;
+    }
+  }
+
+  for (std::set<char*>::iterator it = released.begin(); it != released.end();
+       ++it) {
+    slabs_.erase(*it);
+    delete[] *it;
+  }
+  int64 bytes = static_cast<int64>(released.size()) * kSlabSize;
+  slab_bytes_ -= bytes;
+  heap_bytes_ -= bytes;
+  return bytes;
+}
+
+// Static.
+int MemSlabAllocator::GetSizeClass(int capacity) {
+  if (capacity > kMaxSlabBuffer)
+    return -1;
+  if (capacity == kMinCapacity)
+    return 0;
+
+  int power = Log2Floor(capacity - 1);
+  int step = 1 << (power - kClassesPerPowerBits);
+  int sub_class = ((capacity - (1 << power)) / step) - 1;
+  return 1 + (power - kMinCapacityBits) * kClassesPerPower + sub_class;
+}
+
+void MemSlabAllocator::AddSlab(int size_class, int capacity) {
+  char* slab = new char[kSlabSize];
+  slabs_[slab] = capacity;
+  slab_bytes_ += kSlabSize;
+  heap_bytes_ += kSlabSize;
+
+  // Thread all the buffers of the slab on the free list, keeping them in
+  // address order.
+  int num_buffers = kSlabSize / capacity;
+  for (int i = num_buffers - 1; i >= 0; i--) {
+    FreeBuffer* buffer = reinterpret_cast<FreeBuffer*>(slab + i * capacity);
+    buffer->next = free_lists_[size_class];
+    free_lists_[size_class] = buffer;
+  }
+}
+
+MemSlabAllocator::SlabMap::iterator MemSlabAllocator::FindSlab(
+    FreeBuffer* buffer) {
+  SlabMap::iterator it = slabs_.upper_bound(reinterpret_cast<char*>(buffer));
+  DCHECK(it != slabs_.begin());
+  return --it;
+}
+
+}  // namespace disk_cache
@@ -0,0 +1,87 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// See net/disk_cache/disk_cache.h for the public interface.
+
+#ifndef NET_DISK_CACHE_MEM_SLAB_ALLOCATOR_H_
+#define NET_DISK_CACHE_MEM_SLAB_ALLOCATOR_H_
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "base/basictypes.h"
+
+namespace disk_cache {
+
+// This class provides the storage for the user data of the memory only cache.
+// Small buffers are carved from large slabs, grouped by size class, and freed
+// buffers go back to a per-class free list instead of the heap, so a long
+// lived cache doesn't fragment the heap and the amount of memory held by the
+// cache is known exactly. Buffers bigger than the largest class come straight
+// from the heap.
+//
+// The capacity of a buffer is always GetCapacity() of the requested size, and
+// that is the value that should be charged against the size of the cache. The
+// class is not thread safe.
+class MemSlabAllocator {
+ public:
+  MemSlabAllocator();
+  ~MemSlabAllocator();
+
+  // Returns the actual amount of memory used to store |size| bytes.
+  static int GetCapacity(int size);
+
+  // Returns a buffer of GetCapacity(|size|) bytes, or NULL if |size| is zero.
+  char* Allocate(int size);
+
+  // Releases a buffer previously returned by Allocate(|size|). |size| can be
+  // any value with the same GetCapacity() as the one used for the allocation.
+  void Free(char* buffer, int size);
+
+  // Returns the memory currently handed out to the users of this object.
+  int64 allocated_bytes() const { return allocated_bytes_; }
+
+  // Returns the memory obtained from the heap for slabs.
+  int64 slab_bytes() const { return slab_bytes_; }
+
+  // Returns all the memory obtained from the heap, for slabs and for the
+  // buffers that are too big for them.
+  int64 heap_bytes() const { return heap_bytes_; }
+
+  // Gives the slabs that have no buffer in use back to the heap. Returns the
+  // number of bytes released.
+  int64 ReleaseFreeSlabs();
+
+ private:
+  // A freed buffer stores the pointer to the next free buffer of its class.
+  struct FreeBuffer {
+    FreeBuffer* next;
+  };
+
+  // Returns the size class of a buffer with |capacity| bytes, or -1 if the
+  // buffer doesn't come from a slab.
+  static int GetSizeClass(int capacity);
+
+  // The slabs, with the capacity of their buffers.
+  typedef std::map<char*, int> SlabMap;
+
+  // Adds a new slab to |size_class|.
+  void AddSlab(int size_class, int capacity);
+
+  // Returns the slab that holds |buffer|.
+  SlabMap::iterator FindSlab(FreeBuffer* buffer);
+
+  std::vector<FreeBuffer*> free_lists_;  // One per size class.
+  SlabMap slabs_;
+  int64 allocated_bytes_;
+  int64 slab_bytes_;
+  int64 heap_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemSlabAllocator);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_MEM_SLAB_ALLOCATOR_H_
@@ -0,0 +1,102 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <vector>
+
+#include "net/disk_cache/mem_slab_allocator.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+TEST(MemSlabAllocatorTest, Capacity) {
+  EXPECT_EQ(0, disk_cache::MemSlabAllocator::GetCapacity(0));
+  EXPECT_EQ(64, disk_cache::MemSlabAllocator::GetCapacity(1));
+  EXPECT_EQ(64, disk_cache::MemSlabAllocator::GetCapacity(64));
+  EXPECT_EQ(80, disk_cache::MemSlabAllocator::GetCapacity(65));
+  EXPECT_EQ(128, disk_cache::MemSlabAllocator::GetCapacity(128));
+  EXPECT_EQ(160, disk_cache::MemSlabAllocator::GetCapacity(129));
+  EXPECT_EQ(4096, disk_cache::MemSlabAllocator::GetCapacity(4096));
+  EXPECT_EQ(5120, disk_cache::MemSlabAllocator::GetCapacity(4097));
+  EXPECT_EQ(1310720, disk_cache::MemSlabAllocator::GetCapacity(1048577));
+
+  // Never waste more than 25% of the buffer.
+  for (int size = 65; size < 100000; size++) {
+    int capacity = disk_cache::MemSlabAllocator::GetCapacity(size);
+    ASSERT_GE(capacity, size);
+    ASSERT_LE(capacity - size, capacity / 4);
+  }
+}
+
+TEST(MemSlabAllocatorTest, ReuseBuffers) {
+  disk_cache::MemSlabAllocator allocator;
+  EXPECT_TRUE(NULL == allocator.Allocate(0));
+
+  char* buffer1 = allocator.Allocate(1000);
+  char* buffer2 = allocator.Allocate(1000);
+  ASSERT_TRUE(NULL != buffer1);
+  ASSERT_TRUE(NULL != buffer2);
+  EXPECT_NE(buffer1, buffer2);
+  memset(buffer1, 1, 1000);
+  memset(buffer2, 2, 1000);
+  EXPECT_EQ(2 * 1024, allocator.allocated_bytes());
+  int64 slab_bytes = allocator.slab_bytes();
+  EXPECT_LT(0, slab_bytes);
+
+  // A freed buffer is reused for the same size class, without new slabs.
+  allocator.Free(buffer1, 1000);
+  EXPECT_EQ(1024, allocator.allocated_bytes());
+  EXPECT_EQ(buffer1, allocator.Allocate(1020));
+  EXPECT_EQ(slab_bytes, allocator.slab_bytes());
+
+  allocator.Free(buffer1, 1020);
+  allocator.Free(buffer2, 1000);
+  EXPECT_EQ(0, allocator.allocated_bytes());
+}
+
+TEST(MemSlabAllocatorTest, LargeBuffers) {
+  disk_cache::MemSlabAllocator allocator;
+  const int kSize = 200 * 1024;
+  char* buffer = allocator.Allocate(kSize);
+  ASSERT_TRUE(NULL != buffer);
+  memset(buffer, 0, kSize);
+  EXPECT_EQ(disk_cache::MemSlabAllocator::GetCapacity(kSize),
+            allocator.allocated_bytes());
+  EXPECT_EQ(0, allocator.slab_bytes());
+
+  allocator.Free(buffer, kSize);
+  EXPECT_EQ(0, allocator.allocated_bytes());
+}
+
+TEST(MemSlabAllocatorTest, ReleaseFreeSlabs) {
+  disk_cache::MemSlabAllocator allocator;
+  EXPECT_EQ(0, allocator.ReleaseFreeSlabs());
+
+  // Fill more than one slab.
+  const int kSize = 4096;
+  std::vector<char*> buffers;
+  while (allocator.slab_bytes() < 2 * 64 * 1024) {
+    buffers.push_back(allocator.Allocate(kSize));
+    ASSERT_TRUE(NULL != buffers.back());
+    memset(buffers.back(), 0, kSize);
+  }
+  char* large = allocator.Allocate(200 * 1024);
+  int64 heap_bytes = allocator.heap_bytes();
+  EXPECT_EQ(allocator.slab_bytes() +
+                disk_cache::MemSlabAllocator::GetCapacity(200 * 1024),
+            heap_bytes);
+
+  // Only the slab that is left without buffers in use goes.
+  allocator.Free(buffers.back(), kSize);
+  buffers.pop_back();
+  EXPECT_EQ(64 * 1024, allocator.ReleaseFreeSlabs());
+  EXPECT_EQ(heap_bytes - 64 * 1024, allocator.heap_bytes());
+  for (size_t i = 1; i < buffers.size(); i++)
+    allocator.Free(buffers[i], kSize);
+  EXPECT_EQ(0, allocator.ReleaseFreeSlabs());
+
+  // The free buffers of the remaining slab are still handed out.
+  EXPECT_TRUE(NULL != allocator.Allocate(kSize));
+  allocator.Free(large, 200 * 1024);
+  EXPECT_EQ(64 * 1024, allocator.heap_bytes());
+}
@@ -23,6 +23,9 @@ enum Operation {
   REMOVE
 };
 
+// Number of nodes walked back from the tail when repairing a list.
+const int kMaxRepairNodes = 1000;
+
 // This class provides a simple lock for the LRU list of rankings. Whenever an
 // entry is to be inserted or removed from the list, a transaction object should
 // be created to keep track of the operation. If the process crashes before
@@ -35,25 +38,31 @@ class Transaction {
   // from user_data because it is the basis of the crash detection. Maybe
   // volatile is not enough for that, but it should be a good hint.
   Transaction(volatile disk_cache::LruData* data, disk_cache::Addr addr,
-              Operation op, int list);
+              Operation op, int list, disk_cache::Journal* journal);
   ~Transaction();
  private:
   volatile disk_cache::LruData* data_;
+  disk_cache::Journal* journal_;
   DISALLOW_COPY_AND_ASSIGN(Transaction);
 };
 
 Transaction::Transaction(volatile disk_cache::LruData* data,
-                         disk_cache::Addr addr, Operation op, int list)
-    : data_(data) {
+                         disk_cache::Addr addr, Operation op, int list,
+                         disk_cache::Journal* journal)
+    : data_(data), journal_(journal) {
   DCHECK(!data_->transaction);
   DCHECK(addr.is_initialized());
   data_->operation = op;
   data_->operation_list = list;
   data_->transaction = addr.value();
+  journal_->BeginGroup();
 }
 
 Transaction::~Transaction() {
   DCHECK(data_->transaction);
+
+  // The modified nodes must be on the journal before the transaction is gone.
+  journal_->EndGroup();
   data_->transaction = 0;
   data_->operation = 0;
   data_->operation_list = 0;
@@ -229,6 +238,7 @@ void Rankings::Reset() {
     heads_[i].set_value(0);
     tails_[i].set_value(0);
   }
+  check_node_.set_value(0);
   control_data_ = NULL;
 }
 
@@ -237,7 +247,8 @@ void Rankings::Insert(CacheRankingsBlock* node, bool modified, List list) {
   DCHECK(node->HasData());
   Addr& my_head = heads_[list];
   Addr& my_tail = tails_[list];
-  Transaction lock(control_data_, node->address(), INSERT, list);
+  Transaction lock(control_data_, node->address(), INSERT, list,
+                   backend_->journal());
   CacheRankingsBlock head(backend_->File(my_head), my_head);
   if (my_head.is_initialized()) {
     if (!GetRanking(&head))
@@ -309,6 +320,12 @@ void Rankings::Remove(CacheRankingsBlock* node, List list, bool strict) {
   if (strict)
   InvalidateIterators(node);
 
+  // Keep the position of the background check on the list.
+  if (node->address().value() == check_node_.value()) {
+    CacheAddr prev = node->Data()->prev;
+    check_node_.set_value(prev == check_node_.value() ? 0 : prev);
+  }
+
   Addr next_addr(node->Data()->next);
   Addr prev_addr(node->Data()->prev);
   if (!next_addr.is_initialized() || next_addr.is_separate_file() ||
@@ -327,7 +344,8 @@ void Rankings::Remove(CacheRankingsBlock* node, List list, bool strict) {
   if (!CheckLinks(node, &prev, &next, &list))
     return;
 
-  Transaction lock(control_data_, node->address(), REMOVE, list);
+  Transaction lock(control_data_, node->address(), REMOVE, list,
+                   backend_->journal());
   prev.Data()->next = next.address().value();
   next.Data()->prev = prev.address().value();
   GenerateCrash(ON_REMOVE_1);
@@ -537,6 +555,75 @@ void Rankings::SetContents(CacheRankingsBlock* node, CacheAddr address) {
   node->Store();
 }
 
+bool Rankings::CheckNextLink(List list, int* num_fixed) {
+  if (!check_node_.is_initialized()) {
+    Addr& my_head = heads_[list];
+    if (!my_head.is_initialized())
+      return false;
+
+    scoped_ptr<CacheRankingsBlock> head(LoadNodeForCheck(my_head));
+    if (!head.get() || head->Data()->prev != my_head.value()) {
+      Trace("CheckNextLink bad head 0x%x l %d", my_head.value(), list);
+      RepairList(list, NULL);
+      (*num_fixed)++;
+      return true;
+    }
+    check_node_ = my_head;
+    return true;
+  }
+
+  scoped_ptr<CacheRankingsBlock> node(LoadNodeForCheck(check_node_));
+  if (!node.get()) {
+    // This node was valid when we got here, so the list changed behind our
+    // back. Start again.
+    check_node_.set_value(0);
+    return true;
+  }
+
+  // SanityCheck() already verified that a node that points to itself is a
+  // tail.
+  Addr next_addr(node->Data()->next);
+  if (next_addr.value() == check_node_.value())
+    return false;
+
+  scoped_ptr<CacheRankingsBlock> next(LoadNodeForCheck(next_addr));
+  if (next.get() && next->Data()->prev == check_node_.value()) {
+    check_node_ = next_addr;
+    return true;
+  }
+
+  Trace("CheckNextLink broken 0x%x 0x%x l %d", check_node_.value(),
+        next_addr.value(), list);
+  RepairList(list, node.get());
+  (*num_fixed)++;
+  return true;
+}
+
+void Rankings::ResetLinkCheck() {
+  check_node_.set_value(0);
+}
+
+bool Rankings::IsLinked(CacheRankingsBlock* node) {
+  CacheAddr address = node->address().value();
+  const RankingsNode* data = node->Data();
+  List list = NO_USE;  // Initialize it to something.
+
+  if (data->prev == address) {
+    if (!IsHead(address, &list))
+      return false;
+  } else {
+    scoped_ptr<CacheRankingsBlock> prev(LoadNodeForCheck(Addr(data->prev)));
+    if (!prev.get() || prev->Data()->next != address)
+      return false;
+  }
+
+  if (data->next == address)
+    return IsTail(address, &list);
+
+  scoped_ptr<CacheRankingsBlock> next(LoadNodeForCheck(Addr(data->next)));
+  return next.get() && next->Data()->prev == address;
+}
+
 void Rankings::ReadHeads() {
   for (int i = 0; i < LAST_ELEMENT; i++)
     heads_[i] = Addr(control_data_->heads[i]);
@@ -547,11 +634,15 @@ void Rankings::ReadTails() {
     tails_[i] = Addr(control_data_->tails[i]);
 }
 
+// The header of the file is updated directly, so the nodes stored before have
+// to be on the journal first.
 void Rankings::WriteHead(List list) {
+  backend_->journal()->Commit();
   control_data_->heads[list] = heads_[list].value();
 }
 
 void Rankings::WriteTail(List list) {
+  backend_->journal()->Commit();
   control_data_->tails[list] = tails_[list].value();
 }
 
@@ -818,6 +909,89 @@ int Rankings::CheckList(List list) {
   return num_items;
 }
 
+CacheRankingsBlock* Rankings::LoadNodeForCheck(Addr address) {
+  if (!address.is_initialized() || !address.SanityCheck() ||
+      address.is_separate_file() || address.file_type() != RANKINGS ||
+      address.num_blocks() != 1) {
+    return NULL;
+  }
+
+  MappedFile* file = backend_->File(address);
+  if (!file)
+    return NULL;
+
+  scoped_ptr<CacheRankingsBlock> node(new CacheRankingsBlock(file, address));
+  if (!node->Load() || !SanityCheck(node.get(), true))
+    return NULL;
+
+  return node.release();
+}
+
+// We look for the part of the list that is still linked by walking back from
+// the tail, because that is where the eviction code works. If |node| is the
+// last good node from the head, the two parts are joined and whatever was
+// between them is dropped from the list; with no usable tail, |node| becomes
+// the new tail.
+void Rankings::RepairList(List list, CacheRankingsBlock* node) {
+  Addr& my_head = heads_[list];
+  Addr& my_tail = tails_[list];
+
+  scoped_ptr<CacheRankingsBlock> current(LoadNodeForCheck(my_tail));
+  if (current.get() && current->Data()->next != my_tail.value())
+    current.reset();
+
+  for (int i = 0; current.get() && i < kMaxRepairNodes; i++) {
+    Addr prev_addr(current->Data()->prev);
+    if (node && prev_addr.value() == node->address().value())
+      break;  // Only the link from |node| was wrong.
+
+    if (prev_addr.value() == current->address().value())
+      break;  // This is a head.
+
+    scoped_ptr<CacheRankingsBlock> prev(LoadNodeForCheck(prev_addr));
+    if (!prev.get() || prev->Data()->next != current->address().value())
+      break;
+    current.swap(prev);
+  }
+
+  backend_->journal()->BeginGroup();
+  if (current.get()) {
+    CacheAddr first = current->address().value();
+    CacheAddr last = node ? node->address().value() : first;
+    SetLink(current->address(), false, last);
+    if (node) {
+      SetLink(node->address(), true, first);
+    } else {
+      my_head.set_value(first);
+      WriteHead(list);
+    }
+  } else if (node) {
+    // Nothing after |node| can be trusted.
+    SetLink(node->address(), true, node->address().value());
+    my_tail = node->address();
+    WriteTail(list);
+  } else {
+    my_head.set_value(0);
+    my_tail.set_value(0);
+    WriteHead(list);
+    WriteTail(list);
+  }
+  backend_->journal()->EndGroup();
+}
+
+void Rankings::SetLink(Addr address, bool next, CacheAddr value) {
+  CacheRankingsBlock block(backend_->File(address), address);
+  if (!GetRanking(&block))
+    return;
+
+  if (next)
+    block.Data()->next = value;
+  else
+    block.Data()->prev = value;
+  block.Store();
+  UpdateIterators(&block);
+}
+
 bool Rankings::IsHead(CacheAddr addr, List* list) const {
   for (int i = 0; i < LAST_ELEMENT; i++) {
     if (addr == heads_[i].value()) {
@@ -142,6 +142,20 @@ class Rankings {
   // Sets the |contents| field of |node| to |address|.
   void SetContents(CacheRankingsBlock* node, CacheAddr address);
 
+  // Checks the next link of |list|, for the background verification of the
+  // cache. Returns false when the whole list has been walked. A broken link is
+  // repaired by splicing the last good node with the part of the list that can
+  // still be walked back from the tail, and |num_fixed| is incremented; the
+  // entries of the nodes left out are found through the index (IsLinked()).
+  bool CheckNextLink(List list, int* num_fixed);
+
+  // Makes the next call to CheckNextLink() start at the head of a list.
+  void ResetLinkCheck();
+
+  // Returns false if |node| is supposed to be on a list, but its neighbors
+  // don't point back to it.
+  bool IsLinked(CacheRankingsBlock* node);
+
  private:
   typedef std::pair<CacheAddr, CacheRankingsBlock*> IteratorPair;
   typedef std::list<IteratorPair> IteratorList;
@@ -180,6 +194,18 @@ class Rankings {
   // error code (negative value).
   int CheckList(List list);
 
+  // Returns a new node with the contents of |address|, or NULL if |address|
+  // doesn't point to a sane node. Unlike GetRanking(), a bad node is not
+  // considered a critical error.
+  CacheRankingsBlock* LoadNodeForCheck(Addr address);
+
+  // Fixes |list| when the link that follows |node| is broken, or the head of
+  // the list when |node| is NULL.
+  void RepairList(List list, CacheRankingsBlock* node);
+
+  // Sets the |next| (or prev) link of the node stored at |address|.
+  void SetLink(Addr address, bool next, CacheAddr value);
+
   // Returns true if addr is the head or tail of any list. When there is a
   // match |list| will contain the list number for |addr|.
   bool IsHead(CacheAddr addr, List* list) const;
@@ -202,6 +228,7 @@ class Rankings {
   BackendImpl* backend_;
   LruData* control_data_;  // Data related to the LRU lists.
   IteratorList iterators_;
+  Addr check_node_;  // Last node checked by CheckNextLink().
 
   DISALLOW_COPY_AND_ASSIGN(Rankings);
 };
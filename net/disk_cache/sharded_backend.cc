@@ -0,0 +1,487 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/sharded_backend.h"
+
+#include "base/logging.h"
+#include "base/message_loop.h"
+#include "base/stl_util-inl.h"
+#include "base/stringprintf.h"
+#include "base/threading/thread.h"
+#include "net/base/net_errors.h"
+#include "net/disk_cache/backend_impl.h"
+#include "net/disk_cache/hash.h"
+
+namespace {
+
+// Maximum number of shards for a single cache.
+const int kMaxShards = 16;
+
+// The size used for the whole cache when no size is provided (the same value
+// that BackendImpl uses by default).
+const int kDefaultCacheSize = 80 * 1024 * 1024;
+
+}  // namespace
+
+namespace disk_cache {
+
+// This class takes care of building all the shards of the backend. It deletes
+// itself when done.
+class ShardedBackend::Creator {
+ public:
+  Creator(ShardedBackend* backend, Backend** result,
+          CompletionCallback* callback)
+      : backend_(backend), result_(result), callback_(callback), pending_(0),
+        rv_(net::OK),
+        ALLOW_THIS_IN_INITIALIZER_LIST(
+            my_callback_(this, &Creator::OnIOComplete)) {
+  }
+  ~Creator() {}
+
+  // Creates the shards. Returns ERR_IO_PENDING if |callback_| will be invoked.
+  int Run(bool force, int max_bytes, net::CacheType type, uint32 flags,
+          net::NetLog* net_log);
+
+  // Callback implementation.
+  void OnIOComplete(int result);
+
+ private:
+  // Records the result of creating one shard, whether it completed right away
+  // or through OnIOComplete().
+  void OnShardCreated(int result);
+
+  // Returns the final result of the operation.
+  int Finish();
+
+  ShardedBackend* backend_;
+  Backend** result_;
+  CompletionCallback* callback_;
+  int pending_;
+  int rv_;
+  net::CompletionCallbackImpl<Creator> my_callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(Creator);
+};
+
+int ShardedBackend::Creator::Run(bool force, int max_bytes,
+                                 net::CacheType type, uint32 flags,
+                                 net::NetLog* net_log) {
+  int num_shards = backend_->num_shards();
+  int shard_size = max_bytes / num_shards;
+
+  // Keep an extra reference for this method, so that we don't finish until all
+  // the shards are requested.
+  pending_ = num_shards + 1;
+  for (int i = 0; i < num_shards; i++) {
+    int rv = BackendImpl::CreateBackend(
+        backend_->shard_paths_[i], force, shard_size, type, flags,
+        backend_->threads_[i]->message_loop_proxy(), net_log,
+        &backend_->shards_[i], &my_callback_);
+    if (rv != net::ERR_IO_PENDING)
+      OnShardCreated(rv);
+  }
+
+  if (--pending_)
+    return net::ERR_IO_PENDING;
+
+  int rv = Finish();
+  delete this;
+  return rv;
+}
+
+void ShardedBackend::Creator::OnIOComplete(int result) {
+  OnShardCreated(result);
+  if (pending_)
+    return;
+
+  CompletionCallback* callback = callback_;
+  int rv = Finish();
+  delete this;
+  callback->Run(rv);
+}
+
+void ShardedBackend::Creator::OnShardCreated(int result) {
+  DCHECK_NE(net::ERR_IO_PENDING, result);
+  DCHECK_GT(pending_, 0);
+  pending_--;
+  if (result != net::OK && rv_ == net::OK)
+    rv_ = result;
+}
+
+int ShardedBackend::Creator::Finish() {
+  if (rv_ == net::OK) {
+    *result_ = backend_;
+  } else {
+    LOG(ERROR) << "Unable to create sharded cache";
+    *result_ = NULL;
+    delete backend_;
+  }
+  return rv_;
+}
+
+// ------------------------------------------------------------------------
+
+// This class keeps track of an enumeration of the whole cache, that goes
+// through the shards in order.
+class ShardedBackend::Enumerator {
+ public:
+  explicit Enumerator(ShardedBackend* backend)
+      : backend_(backend), shard_(0), shard_iter_(NULL), iter_(NULL),
+        next_entry_(NULL), callback_(NULL),
+        ALLOW_THIS_IN_INITIALIZER_LIST(
+            my_callback_(this, &Enumerator::OnIOComplete)) {
+  }
+  ~Enumerator() {}
+
+  // Same semantics as Backend::OpenNextEntry(). |iter| is the user's iterator
+  // that points to this object.
+  int OpenNextEntry(void** iter, Entry** next_entry,
+                    CompletionCallback* callback);
+
+  // Releases the iterator of the current shard.
+  void End();
+
+  // Callback implementation.
+  void OnIOComplete(int result);
+
+ private:
+  // Opens the next entry, moving to the next shard when needed.
+  int OpenNextEntryFromShards();
+
+  ShardedBackend* backend_;
+  int shard_;
+  void* shard_iter_;
+  void** iter_;
+  Entry** next_entry_;
+  CompletionCallback* callback_;
+  net::CompletionCallbackImpl<Enumerator> my_callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(Enumerator);
+};
+
+int ShardedBackend::Enumerator::OpenNextEntry(void** iter, Entry** next_entry,
+                                              CompletionCallback* callback) {
+  iter_ = iter;
+  next_entry_ = next_entry;
+  callback_ = callback;
+  return OpenNextEntryFromShards();
+}
+
+void ShardedBackend::Enumerator::End() {
+  if (shard_iter_ && shard_ < backend_->num_shards())
+    backend_->shards_[shard_]->EndEnumeration(&shard_iter_);
+  shard_iter_ = NULL;
+}
+
+void ShardedBackend::Enumerator::OnIOComplete(int result) {
+  if (result == net::ERR_FAILED) {
+    // This shard is done.
+    shard_iter_ = NULL;
+    shard_++;
+    result = OpenNextEntryFromShards();
+    if (result == net::ERR_IO_PENDING)
+      return;
+  }
+
+  // Note that the user may end the enumeration from within the callback, so we
+  // cannot touch this object after that.
+  CompletionCallback* callback = callback_;
+  if (result == net::ERR_FAILED) {
+    // There are no more entries, so the enumeration is over.
+    *iter_ = NULL;
+    backend_->OnEnumeratorDone(this);  // Deletes this object.
+  }
+  callback->Run(result);
+}
+
+int ShardedBackend::Enumerator::OpenNextEntryFromShards() {
+  while (shard_ < backend_->num_shards()) {
+    int rv = backend_->shards_[shard_]->OpenNextEntry(&shard_iter_, next_entry_,
+                                                      &my_callback_);
+    if (rv != net::ERR_FAILED)
+      return rv;
+
+    // The shard already released its iterator.
+    shard_iter_ = NULL;
+    shard_++;
+  }
+  return net::ERR_FAILED;
+}
+
+// ------------------------------------------------------------------------
+
+// This class performs an operation that involves every shard, and completes
+// when all the shards are done.
+class ShardedBackend::MultiShardOperation {
+ public:
+  enum Type {
+    DOOM_ALL,
+    DOOM_BETWEEN,
+    DOOM_SINCE
+  };
+
+  MultiShardOperation(ShardedBackend* backend, Type type,
+                      const base::Time initial_time,
+                      const base::Time end_time)
+      : backend_(backend), type_(type), initial_time_(initial_time),
+        end_time_(end_time), callback_(NULL), pending_(0), rv_(net::OK),
+        ALLOW_THIS_IN_INITIALIZER_LIST(
+            my_callback_(this, &MultiShardOperation::OnIOComplete)) {
+  }
+  ~MultiShardOperation() {}
+
+  // Starts the operation on all shards. Returns ERR_IO_PENDING if |callback|
+  // will be invoked.
+  int Run(CompletionCallback* callback);
+
+  // Callback implementation.
+  void OnIOComplete(int result);
+
+ private:
+  void OnShardDone(int result);
+
+  ShardedBackend* backend_;
+  Type type_;
+  base::Time initial_time_;
+  base::Time end_time_;
+  CompletionCallback* callback_;
+  int pending_;
+  int rv_;
+  net::CompletionCallbackImpl<MultiShardOperation> my_callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(MultiShardOperation);
+};
+
+int ShardedBackend::MultiShardOperation::Run(CompletionCallback* callback) {
+  callback_ = callback;
+  pending_ = 1;
+  for (int i = 0; i < backend_->num_shards(); i++) {
+    Backend* shard = backend_->shards_[i];
+    int rv;
+    switch (type_) {
+      case DOOM_ALL:
+        rv = shard->DoomAllEntries(&my_callback_);
+        break;
+      case DOOM_BETWEEN:
+        rv = shard->DoomEntriesBetween(initial_time_, end_time_,
+                                       &my_callback_);
+        break;
+      case DOOM_SINCE:
+        rv = shard->DoomEntriesSince(initial_time_, &my_callback_);
+        break;
+      default:
+        NOTREACHED();
+        rv = net::ERR_FAILED;
+    }
+    if (rv == net::ERR_IO_PENDING)
+      pending_++;
+    else
+      OnShardDone(rv);
+  }
+
+  if (--pending_)
+    return net::ERR_IO_PENDING;
+  return rv_;
+}
+
+void ShardedBackend::MultiShardOperation::OnIOComplete(int result) {
+  OnShardDone(result);
+  if (--pending_)
+    return;
+
+  CompletionCallback* callback = callback_;
+  int rv = rv_;
+  backend_->OnOperationDone(this);  // Deletes this object.
+  callback->Run(rv);
+}
+
+void ShardedBackend::MultiShardOperation::OnShardDone(int result) {
+  if (result != net::OK && rv_ == net::OK)
+    rv_ = result;
+}
+
+// ------------------------------------------------------------------------
+
+ShardedBackend::ShardedBackend(const FilePath& path) : path_(path) {
+}
+
+ShardedBackend::~ShardedBackend() {
+  for (std::set<Enumerator*>::iterator it = enumerators_.begin();
+       it != enumerators_.end(); ++it) {
+    (*it)->End();
+  }
+  STLDeleteElements(&enumerators_);
+
+  // The shards will not invoke any pending callback.
+  STLDeleteElements(&shards_);
+  STLDeleteElements(&operations_);
+
+  // Stopping the threads after deleting the shards, as each shard requires its
+  // thread to perform the final cleanup.
+  STLDeleteElements(&threads_);
+}
+
+// Static.
+int ShardedBackend::CreateBackend(const FilePath& full_path, bool force,
+                                  int max_bytes, net::CacheType type,
+                                  uint32 flags, int num_shards,
+                                  net::NetLog* net_log, Backend** backend,
+                                  CompletionCallback* callback) {
+  DCHECK(callback);
+  DCHECK_GT(num_shards, 0);
+  if (num_shards <= 0 || num_shards > kMaxShards || max_bytes < 0)
+    return net::ERR_INVALID_ARGUMENT;
+
+  // The automatic size of each shard would be the size of the whole cache.
+  if (!max_bytes)
+    max_bytes = kDefaultCacheSize;
+
+  ShardedBackend* cache = new ShardedBackend(full_path);
+  if (!cache->StartThreads(num_shards)) {
+    delete cache;
+    return net::ERR_FAILED;
+  }
+
+  // This object will self-destroy when finished.
+  Creator* creator = new Creator(cache, backend, callback);
+  return creator->Run(force, max_bytes, type, flags, net_log);
+}
+
+bool ShardedBackend::StartThreads(int num_shards) {
+  shards_.resize(num_shards, NULL);
+  for (int i = 0; i < num_shards; i++) {
+    shard_paths_.push_back(
+        path_.AppendASCII(base::StringPrintf("shard_%d", i)));
+
+    base::Thread* thread =
+        new base::Thread(base::StringPrintf("CacheShard%d", i).c_str());
+    threads_.push_back(thread);
+    if (!thread->StartWithOptions(
+            base::Thread::Options(MessageLoop::TYPE_IO, 0))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int ShardedBackend::GetShardForKey(const std::string& key) const {
+  // The low bits of the hash select the bucket of the index table on each
+  // shard, so scramble the value before reducing it to the number of shards.
+  uint32 hash = Hash(key) * 2654435761U;
+  return static_cast<int>((static_cast<uint64>(hash) * shards_.size()) >> 32);
+}
+
+int32 ShardedBackend::GetEntryCount() const {
+  int32 count = 0;
+  for (size_t i = 0; i < shards_.size(); i++)
+    count += shards_[i]->GetEntryCount();
+  return count;
+}
+
+int ShardedBackend::OpenEntry(const std::string& key, Entry** entry,
+                              CompletionCallback* callback) {
+  return shards_[GetShardForKey(key)]->OpenEntry(key, entry, callback);
+}
+
+int ShardedBackend::CreateEntry(const std::string& key, Entry** entry,
+                                CompletionCallback* callback) {
+  return shards_[GetShardForKey(key)]->CreateEntry(key, entry, callback);
+}
+
+int ShardedBackend::DoomEntry(const std::string& key,
+                              CompletionCallback* callback) {
+  return shards_[GetShardForKey(key)]->DoomEntry(key, callback);
+}
+
+int ShardedBackend::DoomAllEntries(CompletionCallback* callback) {
+  MultiShardOperation* operation = new MultiShardOperation(
+      this, MultiShardOperation::DOOM_ALL, base::Time(), base::Time());
+  int rv = operation->Run(callback);
+  if (rv == net::ERR_IO_PENDING)
+    operations_.insert(operation);
+  else
+    delete operation;
+  return rv;
+}
+
+int ShardedBackend::DoomEntriesBetween(const base::Time initial_time,
+                                       const base::Time end_time,
+                                       CompletionCallback* callback) {
+  MultiShardOperation* operation = new MultiShardOperation(
+      this, MultiShardOperation::DOOM_BETWEEN, initial_time, end_time);
+  int rv = operation->Run(callback);
+  if (rv == net::ERR_IO_PENDING)
+    operations_.insert(operation);
+  else
+    delete operation;
+  return rv;
+}
+
+int ShardedBackend::DoomEntriesSince(const base::Time initial_time,
+                                     CompletionCallback* callback) {
+  MultiShardOperation* operation = new MultiShardOperation(
+      this, MultiShardOperation::DOOM_SINCE, initial_time, base::Time());
+  int rv = operation->Run(callback);
+  if (rv == net::ERR_IO_PENDING)
+    operations_.insert(operation);
+  else
+    delete operation;
+  return rv;
+}
+
+int ShardedBackend::OpenNextEntry(void** iter, Entry** next_entry,
+                                  CompletionCallback* callback) {
+  DCHECK(iter);
+  Enumerator* enumerator = reinterpret_cast<Enumerator*>(*iter);
+  if (!enumerator) {
+    enumerator = new Enumerator(this);
+    enumerators_.insert(enumerator);
+    *iter = enumerator;
+  }
+
+  int rv = enumerator->OpenNextEntry(iter, next_entry, callback);
+  if (rv == net::ERR_FAILED) {
+    // The enumeration is over, so there is nothing to end later.
+    OnEnumeratorDone(enumerator);
+    *iter = NULL;
+  }
+  return rv;
+}
+
+void ShardedBackend::EndEnumeration(void** iter) {
+  Enumerator* enumerator = reinterpret_cast<Enumerator*>(*iter);
+  *iter = NULL;
+  if (!enumerator)
+    return;
+
+  enumerator->End();
+  OnEnumeratorDone(enumerator);
+}
+
+void ShardedBackend::GetStats(StatsItems* stats) {
+  for (size_t i = 0; i < shards_.size(); i++) {
+    StatsItems shard_stats;
+    shards_[i]->GetStats(&shard_stats);
+    for (size_t j = 0; j < shard_stats.size(); j++) {
+      stats->push_back(std::make_pair(
+          base::StringPrintf("Shard %d: %s", static_cast<int>(i),
+                             shard_stats[j].first.c_str()),
+          shard_stats[j].second));
+    }
+  }
+}
+
+void ShardedBackend::OnEnumeratorDone(Enumerator* enumerator) {
+  DCHECK(enumerators_.find(enumerator) != enumerators_.end());
+  enumerators_.erase(enumerator);
+  delete enumerator;
+}
+
+void ShardedBackend::OnOperationDone(MultiShardOperation* operation) {
+  DCHECK(operations_.find(operation) != operations_.end());
+  operations_.erase(operation);
+  delete operation;
+}
+
+}  // namespace disk_cache
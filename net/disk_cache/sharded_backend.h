@@ -0,0 +1,100 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// See net/disk_cache/disk_cache.h for the public interface of the cache.
+
+#ifndef NET_DISK_CACHE_SHARDED_BACKEND_H_
+#define NET_DISK_CACHE_SHARDED_BACKEND_H_
+#pragma once
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/file_path.h"
+#include "net/disk_cache/disk_cache.h"
+#include "net/disk_cache/stats.h"
+
+namespace base {
+class Thread;
+}
+
+namespace disk_cache {
+
+class BackendImpl;
+
+// This class implements the Backend interface on top of a set of independent
+// BackendImpl instances (shards). Keys are distributed among the shards by
+// hash, and each shard has its own files (on a sub-folder of the cache path),
+// index table, rankings lists, block files and cache thread, so that the
+// work of the cache is not limited by the throughput of a single thread.
+class ShardedBackend : public Backend {
+ public:
+  virtual ~ShardedBackend();
+
+  // Returns a new sharded backend with |num_shards| shards, stored under
+  // |full_path|. The rest of the arguments have the same semantics as the ones
+  // of BackendImpl::CreateBackend(), except that |max_bytes| is the maximum
+  // size of the whole cache, not of each shard. The cache threads are owned by
+  // the returned object.
+  static int CreateBackend(const FilePath& full_path, bool force,
+                           int max_bytes, net::CacheType type,
+                           uint32 flags, int num_shards, net::NetLog* net_log,
+                           Backend** backend, CompletionCallback* callback);
+
+  // Returns the shard that stores |key|.
+  int GetShardForKey(const std::string& key) const;
+
+  int num_shards() const { return static_cast<int>(shards_.size()); }
+
+  // Backend interface.
+  virtual int32 GetEntryCount() const;
+  virtual int OpenEntry(const std::string& key, Entry** entry,
+                        CompletionCallback* callback);
+  virtual int CreateEntry(const std::string& key, Entry** entry,
+                          CompletionCallback* callback);
+  virtual int DoomEntry(const std::string& key, CompletionCallback* callback);
+  virtual int DoomAllEntries(CompletionCallback* callback);
+  virtual int DoomEntriesBetween(const base::Time initial_time,
+                                 const base::Time end_time,
+                                 CompletionCallback* callback);
+  virtual int DoomEntriesSince(const base::Time initial_time,
+                               CompletionCallback* callback);
+  virtual int OpenNextEntry(void** iter, Entry** next_entry,
+                            CompletionCallback* callback);
+  virtual void EndEnumeration(void** iter);
+  virtual void GetStats(StatsItems* stats);
+
+ private:
+  class Creator;
+  class Enumerator;
+  class MultiShardOperation;
+  friend class Creator;
+  friend class Enumerator;
+  friend class MultiShardOperation;
+
+  explicit ShardedBackend(const FilePath& path);
+
+  // Starts the cache threads. Returns false in case of failure.
+  bool StartThreads(int num_shards);
+
+  // Notifications from the helpers that are done.
+  void OnEnumeratorDone(Enumerator* enumerator);
+  void OnOperationDone(MultiShardOperation* operation);
+
+  FilePath path_;
+  std::vector<FilePath> shard_paths_;  // Must outlive the shard creation.
+  std::vector<base::Thread*> threads_;
+  std::vector<Backend*> shards_;
+
+  // Helpers with pending callbacks from the shards.
+  std::set<Enumerator*> enumerators_;
+  std::set<MultiShardOperation*> operations_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShardedBackend);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_SHARDED_BACKEND_H_
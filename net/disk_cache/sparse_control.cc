@@ -36,6 +36,10 @@ const int kMaxEntrySize = 0x100000;
 // The size of each data block (tracked by the child allocation bitmap).
 const int kBlockSize = 1024;
 
+// The number of children with allocation data kept in memory (about 40 KB, for
+// 256 MB of sparse data).
+const int kMaxChildrenInfo = 256;
+
 // Returns the name of a child entry given the base_name and signature of the
 // parent and the child_id.
 // If the entry is called entry_name, child entries will be named something
@@ -183,12 +187,50 @@ void LogChildOperationEnd(const net::BoundNetLog& net_log,
 
 namespace disk_cache {
 
+// The callback of a read from a child entry that runs in parallel with the
+// reads from other children. It keeps a reference to the child until the read
+// completes, and deletes itself after that.
+class SparseControl::ChildReadCallback : public net::CompletionCallback {
+ public:
+  ChildReadCallback(SparseControl* control, EntryImpl* child, int index)
+      : control_(control), child_(child), index_(index) {
+    child_->AddRef();
+  }
+
+  // The read will not invoke this callback.
+  void Discard() {
+    child_->Release();
+    delete this;
+  }
+
+  virtual void RunWithParams(const Tuple1<int>& params) {
+    SparseControl* control = control_;
+    int index = index_;
+    Discard();
+    control->OnParallelReadCompleted(index, params.a);
+  }
+
+ private:
+  virtual ~ChildReadCallback() {}
+
+  SparseControl* control_;
+  EntryImpl* child_;
+  int index_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChildReadCallback);
+};
+
 SparseControl::SparseControl(EntryImpl* entry)
     : entry_(entry),
       child_(NULL),
       operation_(kNoOperation),
       init_(false),
       child_map_(child_data_.bitmap, kNumSparseBits, kNumSparseBits / 32),
+      child_id_(0),
+      cached_child_(false),
+      cached_child_len_(0),
+      doomed_children_(0),
+      pending_reads_(0),
       ALLOW_THIS_IN_INITIALIZER_LIST(
           child_callback_(this, &SparseControl::OnChildIOCompleted)),
       user_callback_(NULL) {
@@ -436,10 +478,17 @@ bool SparseControl::OpenChild() {
     CloseChild();
   }
 
+  cached_child_ = false;
+  child_id_ = static_cast<int>(offset_ >> 20);
+
   // See if we are tracking this child.
   if (!ChildPresent())
     return ContinueWithoutChild(key);
 
+  // There is no need to open the child just to look at the allocation map.
+  if (kGetRangeOperation == operation_ && LoadChildInfo())
+    return true;
+
   child_ = entry_->backend_->OpenEntryImpl(key);
   if (!child_)
     return ContinueWithoutChild(key);
@@ -469,6 +518,7 @@ bool SparseControl::OpenChild() {
     child_data_.header.last_block = -1;
   }
 
+  SaveChildInfo();
   return true;
 }
 
@@ -481,6 +531,7 @@ void SparseControl::CloseChild() {
                              NULL, false);
   if (rv != sizeof(child_data_))
     DLOG(ERROR) << "Failed to save child data";
+  SaveChildInfo();
   child_->Release();
   child_ = NULL;
 }
@@ -493,6 +544,7 @@ std::string SparseControl::GenerateChildKey() {
 // We are deleting the child because something went wrong.
 bool SparseControl::KillChildAndContinue(const std::string& key, bool fatal) {
   SetChildBit(false);
+  children_info_.erase(child_id_);
   child_->DoomImpl();
   child_->Release();
   child_ = NULL;
@@ -539,6 +591,42 @@ void SparseControl::SetChildBit(bool value) {
   children_map_.Set(child_bit, value);
 }
 
+void SparseControl::SaveChildInfo() {
+  CheckChildrenInfo();
+  if (children_info_.size() >= static_cast<size_t>(kMaxChildrenInfo) &&
+      children_info_.find(child_id_) == children_info_.end()) {
+    children_info_.erase(children_info_.begin());
+  }
+
+  ChildInfo& info = children_info_[child_id_];
+  info.data = child_data_;
+  info.data_len = child_->GetDataSize(kSparseData);
+}
+
+bool SparseControl::LoadChildInfo() {
+  CheckChildrenInfo();
+  ChildrenInfo::const_iterator it = children_info_.find(child_id_);
+  if (it == children_info_.end())
+    return false;
+
+  // Note that child_map_ works directly with child_data_.
+  child_data_ = it->second.data;
+  cached_child_len_ = it->second.data_len;
+  cached_child_ = true;
+  return true;
+}
+
+void SparseControl::CheckChildrenInfo() {
+  // Children can be evicted or found to be corrupt at any time, and we don't
+  // know which one it was, so we just start over.
+  int32 doomed_children = entry_->backend_->doomed_children();
+  if (doomed_children == doomed_children_)
+    return;
+
+  children_info_.clear();
+  doomed_children_ = doomed_children;
+}
+
 void SparseControl::WriteSparseData() {
   scoped_refptr<net::IOBuffer> buf(new net::WrappedIOBuffer(
       reinterpret_cast<const char*>(children_map_.GetMap())));
@@ -629,7 +717,8 @@ int SparseControl::PartialBlockLength(int block_index) const {
     return child_data_.header.last_block_len;
 
   // This may be the last stored index.
-  int entry_len = child_->GetDataSize(kSparseData);
+  int entry_len = child_ ? child_->GetDataSize(kSparseData) :
+                           cached_child_len_;
   if (block_index == entry_len >> 10)
     return entry_len & (kBlockSize - 1);
 
@@ -658,6 +747,11 @@ void SparseControl::InitChildData() {
 void SparseControl::DoChildrenIO() {
   while (DoChildIO()) continue;
 
+  // Wait until all the children are done reading.
+  if (pending_reads_)
+    return;
+  FinishParallelReads();
+
   // Range operations are finished synchronously, often without setting
   // |finished_| to true.
   if (kGetRangeOperation == operation_ &&
@@ -702,6 +796,8 @@ bool SparseControl::DoChildIO() {
                 child_->net_log().source(),
                 child_len_)));
       }
+      if (user_callback_)
+        return DoParallelChildRead();
       rv = child_->ReadDataImpl(kSparseData, child_offset_, user_buf_,
                                 child_len_, callback);
       break;
@@ -741,8 +837,84 @@ bool SparseControl::DoChildIO() {
   return true;
 }
 
+bool SparseControl::DoParallelChildRead() {
+  int index = static_cast<int>(read_lengths_.size());
+  read_lengths_.push_back(child_len_);
+  read_results_.push_back(net::ERR_IO_PENDING);
+
+  // The data for this child goes directly to its place on the user's buffer,
+  // which is kept alive by user_buf_.
+  scoped_refptr<net::IOBuffer> buf(new net::WrappedIOBuffer(user_buf_->data()));
+  ChildReadCallback* callback = new ChildReadCallback(this, child_, index);
+  int rv = child_->ReadDataImpl(kSparseData, child_offset_, buf, child_len_,
+                                callback);
+  if (rv == net::ERR_IO_PENDING) {
+    pending_reads_++;
+    if (!pending_) {
+      pending_ = true;
+      entry_->AddRef();  // Balanced in DoUserCallback.
+    }
+  } else {
+    callback->Discard();
+    LogChildOperationEnd(entry_->net_log(), operation_, rv);
+    read_results_[index] = rv;
+    if (rv != child_len_) {
+      // There is no point in reading past this child.
+      buf_len_ = 0;
+      return true;
+    }
+  }
+
+  offset_ += child_len_;
+  buf_len_ -= child_len_;
+  if (buf_len_)
+    user_buf_->DidConsume(child_len_);
+  return true;
+}
+
+void SparseControl::OnParallelReadCompleted(int index, int result) {
+  DCHECK_NE(net::ERR_IO_PENDING, result);
+  DCHECK_GT(pending_reads_, 0);
+  LogChildOperationEnd(entry_->net_log(), operation_, result);
+  read_results_[index] = result;
+  if (--pending_reads_)
+    return;
+
+  // All the reads were issued before returning to the message loop, so this
+  // is the end of the operation.
+  FinishParallelReads();
+  if (abort_) {
+    abort_ = false;
+    if (entry_->net_log().IsLoggingAllEvents()) {
+      entry_->net_log().AddEvent(net::NetLog::TYPE_CANCELLED, NULL);
+      entry_->net_log().EndEvent(GetSparseEventType(operation_), NULL);
+    }
+    DoUserCallback();
+    return DoAbortCallbacks();
+  }
+
+  if (entry_->net_log().IsLoggingAllEvents())
+    entry_->net_log().EndEvent(GetSparseEventType(operation_), NULL);
+  DoUserCallback();
+}
+
+void SparseControl::FinishParallelReads() {
+  // The data is only valid up to the first read that was not complete.
+  for (size_t i = 0; i < read_results_.size(); i++) {
+    if (read_results_[i] < 0) {
+      result_ = read_results_[i];
+      break;
+    }
+    result_ += read_results_[i];
+    if (read_results_[i] != read_lengths_[i])
+      break;
+  }
+  read_lengths_.clear();
+  read_results_.clear();
+}
+
 int SparseControl::DoGetAvailableRange() {
-  if (!child_)
+  if (!child_ && !cached_child_)
     return child_len_;  // Move on to the next child.
 
   // Check that there are no holes in this range.
@@ -6,6 +6,7 @@
 #define NET_DISK_CACHE_SPARSE_CONTROL_H_
 #pragma once
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -30,6 +31,11 @@ class EntryImpl;
 // the operation into multiple small pieces, sending each one to the
 // appropriate entry. An instance of this class is asociated with each entry
 // used directly for sparse operations (the entry passed in to the constructor).
+//
+// Asynchronous reads that span multiple children are sent to all the children
+// at the same time, and the allocation maps of the children that were already
+// used are kept in memory so that GetAvailableRange() doesn't have to open
+// each child again.
 class SparseControl {
  public:
   // The operation to perform.
@@ -76,6 +82,16 @@ class SparseControl {
   static void DeleteChildren(EntryImpl* entry);
 
  private:
+  class ChildReadCallback;
+  friend class ChildReadCallback;
+
+  // Allocation data of a child entry that was already used.
+  struct ChildInfo {
+    SparseData data;
+    int data_len;  // Bytes stored by the child.
+  };
+  typedef std::map<int, ChildInfo> ChildrenInfo;
+
   // Creates a new sparse entry or opens an aready created entry from disk.
   // These methods just read / write the required info from disk for the current
   // entry, and verify that everything is correct. The return value is a net
@@ -104,6 +120,14 @@ class SparseControl {
   // starts or stops tracking this child.
   void SetChildBit(bool value);
 
+  // Saves the allocation data of the current child on children_info_, or loads
+  // it from there (returning false if not found).
+  void SaveChildInfo();
+  bool LoadChildInfo();
+
+  // Forgets children_info_ if a child entry was doomed since it was saved.
+  void CheckChildrenInfo();
+
   // Writes to disk the tracking information for this entry.
   void WriteSparseData();
 
@@ -132,6 +156,16 @@ class SparseControl {
   // work.
   bool DoChildIO();
 
+  // Starts an asynchronous read from the current child, without waiting for
+  // it to complete. Returns true when we should move on to the next child.
+  bool DoParallelChildRead();
+
+  // Invoked when one of the parallel reads completes.
+  void OnParallelReadCompleted(int index, int result);
+
+  // Adds the result of the parallel reads to result_.
+  void FinishParallelReads();
+
   // Performs the required work for GetAvailableRange for one child.
   int DoGetAvailableRange();
 
@@ -158,6 +192,16 @@ class SparseControl {
   Bitmap children_map_;  // The actual bitmap of children.
   SparseData child_data_;  // Parent and allocation map of child_.
   Bitmap child_map_;  // The allocation map as a bitmap.
+  int child_id_;  // The id (bit on children_map_) of child_.
+  bool cached_child_;  // True if child_data_ comes from children_info_.
+  int cached_child_len_;  // Bytes stored by the cached child.
+  ChildrenInfo children_info_;
+  int32 doomed_children_;  // The backend's count when children_info_ was used.
+
+  // Expected length and result of each parallel read.
+  std::vector<int> read_lengths_;
+  std::vector<int> read_results_;
+  int pending_reads_;
 
   net::CompletionCallbackImpl<SparseControl> child_callback_;
   net::CompletionCallback* user_callback_;
@@ -60,7 +60,8 @@ static const char* kCounterNames[] = {
   "Fatal error",
   "Last report",
   "Last report timer",
-  "Doom recent entries"
+  "Doom recent entries",
+  "Create rejected"
 };
 COMPILE_ASSERT(arraysize(kCounterNames) == disk_cache::Stats::MAX_COUNTER,
                update_the_names);
@@ -212,6 +213,13 @@ int Stats::GetResurrectRatio() const {
   return GetRatio(RESURRECT_HIT, CREATE_HIT);
 }
 
+int Stats::GetHitRatioPerMegabyte(int32 used_bytes) const {
+  int used_mb = used_bytes / (1024 * 1024);
+  if (!used_mb)
+    used_mb++;
+  return GetHitRatio() * 100 / used_mb;
+}
+
 void Stats::ResetRatios() {
   SetCounter(OPEN_HIT, 0);
   SetCounter(OPEN_MISS, 0);
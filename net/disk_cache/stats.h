@@ -46,6 +46,7 @@ class Stats {
     LAST_REPORT,  // Time of the last time we sent a report.
     LAST_REPORT_TIMER,  // Timer count of the last time we sent a report.
     DOOM_RECENT,  // The cache was partially cleared.
+    CREATE_REJECTED,  // The admission filter prevented the creation of an entry.
     MAX_COUNTER
   };
 
@@ -65,6 +66,10 @@ class Stats {
   void GetItems(StatsItems* items);
   int GetHitRatio() const;
   int GetResurrectRatio() const;
+
+  // Returns the hit ratio (as a percentage) for each MB of storage in use, in
+  // hundredths.
+  int GetHitRatioPerMegabyte(int32 used_bytes) const;
   void ResetRatios();
 
   // Returns the lower bound of the space used by entries bigger than 512 KB.
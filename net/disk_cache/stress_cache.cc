@@ -8,7 +8,21 @@
 // the main application quits.
 
 // The child application has two threads: one to exercise the cache in an
-// infinite loop, and another one to asynchronously kill the process.
+// infinite loop, and another one to asynchronously kill the process. The cache
+// is exercised by a number of workers, each one with its own operation in
+// flight, so that the cache thread sees concurrent requests.
+
+// Before dying, the child records the operations it performed and the time it
+// took to open the cache (which includes recovering from the previous crash).
+// The main application uses that to report the throughput of every run, how
+// long the recovery took and how many entries were lost by the crash.
+
+// These switches change the workload, and are passed along to the child:
+//   --workers=N          The number of concurrent workers (1).
+//   --read-percent=N     Operations that read an entry instead of writing (0).
+//   --doom-percent=N     Operations followed by dooming a random entry (19).
+//   --crash-interval=N   Seconds between crash attempts (10).
+//   --iterations=N       Child processes to run (100000).
 
 // A regular build should never crash.
 // To test that the disk cache doesn't generate critical errors with regular
@@ -22,21 +36,29 @@
 //         NOTREACHED();
 //       }
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
 #include "base/at_exit.h"
+#include "base/atomicops.h"
 #include "base/command_line.h"
+#include "base/compiler_specific.h"
 #include "base/debug/debugger.h"
 #include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/format_macros.h"
 #include "base/logging.h"
+#include "base/memory/scoped_vector.h"
 #include "base/message_loop.h"
 #include "base/path_service.h"
 #include "base/process_util.h"
 #include "base/string_number_conversions.h"
 #include "base/string_util.h"
+#include "base/stringprintf.h"
 #include "base/threading/platform_thread.h"
 #include "base/threading/thread.h"
+#include "base/time.h"
 #include "base/utf_string_conversions.h"
 #include "net/base/net_errors.h"
 #include "net/base/test_completion_callback.h"
@@ -50,12 +72,68 @@ using base::Time;
 const int kError = -1;
 const int kExpectedCrash = 100;
 
+const char kWorkers[] = "workers";
+const char kReadPercent[] = "read-percent";
+const char kDoomPercent[] = "doom-percent";
+const char kCrashInterval[] = "crash-interval";
+const char kIterations[] = "iterations";
+
+// What the child process does to the cache.
+struct Workload {
+  Workload() : num_workers(1), read_percent(0), doom_percent(19) {}
+
+  int num_workers;
+  int read_percent;
+  int doom_percent;
+};
+
+// What the child process recorded before dying.
+struct RunStats {
+  RunStats()
+      : num_ops(0), elapsed_ms(0), num_entries(0), recovery_ms(0),
+        initial_entries(0) {}
+
+  int num_ops;
+  int64 elapsed_ms;
+  // Entries on the cache when the process died.
+  int num_entries;
+  // The time it took to open the cache.
+  int recovery_ms;
+  // Entries on the cache once it was open.
+  int initial_entries;
+};
+
+int GetIntSwitch(const CommandLine& command_line, const char* name,
+                 int default_value) {
+  int value;
+  if (!command_line.HasSwitch(name) ||
+      !base::StringToInt(command_line.GetSwitchValueASCII(name), &value)) {
+    return default_value;
+  }
+  return value;
+}
+
+// The child writes its RunStats to this file.
+FilePath GetStatsFilePath() {
+  return GetCacheFilePath().InsertBeforeExtensionASCII("_stress_stats");
+}
+
+bool ReadRunStats(RunStats* stats) {
+  std::string data;
+  if (!file_util::ReadFileToString(GetStatsFilePath(), &data))
+    return false;
+  return sscanf(data.c_str(), "%d %" PRId64 " %d %d %d", &stats->num_ops,
+                &stats->elapsed_ms, &stats->num_entries, &stats->recovery_ms,
+                &stats->initial_entries) == 5;
+}
+
 // Starts a new process.
 int RunSlave(int iteration) {
   FilePath exe;
   PathService::Get(base::FILE_EXE, &exe);
 
   CommandLine cmdline(exe);
+  cmdline.AppendSwitches(*CommandLine::ForCurrentProcess());
   cmdline.AppendArg(base::IntToString(iteration));
 
   base::ProcessHandle handle;
@@ -72,25 +150,279 @@ int RunSlave(int iteration) {
   return exit_code;
 }
 
+// Totals of the runs of the child process.
+class Summary {
+ public:
+  Summary()
+      : num_runs_(0), num_ops_(0), elapsed_ms_(0), recovery_ms_(0),
+        max_recovery_ms_(0), num_crashes_(0), entries_lost_(0),
+        max_entries_lost_(0), have_previous_(false) {}
+
+  // Adds the run number |iteration|, that ended with a crash.
+  void AddRun(int iteration) {
+    RunStats stats;
+    if (!ReadRunStats(&stats)) {
+      // The cache was not ready yet.
+      printf("Iteration %d: no stats\n", iteration);
+      have_previous_ = false;
+      return;
+    }
+
+    num_runs_++;
+    num_ops_ += stats.num_ops;
+    elapsed_ms_ += stats.elapsed_ms;
+    recovery_ms_ += stats.recovery_ms;
+    max_recovery_ms_ = std::max(max_recovery_ms_, stats.recovery_ms);
+
+    // The entries lost by the previous crash are only known when that run
+    // recorded how many there were.
+    int lost = -1;
+    if (have_previous_) {
+      lost = std::max(previous_entries_ - stats.initial_entries, 0);
+      num_crashes_++;
+      entries_lost_ += lost;
+      max_entries_lost_ = std::max(max_entries_lost_, lost);
+    }
+    have_previous_ = true;
+    previous_entries_ = stats.num_entries;
+
+    printf("Iteration %d: %d ops, %.1f ops/s, recovery %d ms, "
+           "entries %d -> %d, lost %d\n", iteration, stats.num_ops,
+           OpsPerSecond(stats.num_ops, stats.elapsed_ms), stats.recovery_ms,
+           stats.initial_entries, stats.num_entries, lost);
+  }
+
+  void Print() const {
+    if (!num_runs_)
+      return;
+    printf("Runs: %d, %" PRId64 " ops, %.1f ops/s\n", num_runs_, num_ops_,
+           OpsPerSecond(num_ops_, elapsed_ms_));
+    printf("Recovery: %" PRId64 " ms average, %d ms max\n",
+           recovery_ms_ / num_runs_, max_recovery_ms_);
+    if (num_crashes_) {
+      printf("Entries lost per crash: %.1f average, %d max\n",
+             static_cast<double>(entries_lost_) / num_crashes_,
+             max_entries_lost_);
+    }
+  }
+
+ private:
+  static double OpsPerSecond(int64 num_ops, int64 elapsed_ms) {
+    return elapsed_ms ? num_ops * 1000.0 / elapsed_ms : 0.0;
+  }
+
+  int num_runs_;
+  int64 num_ops_;
+  int64 elapsed_ms_;
+  int64 recovery_ms_;
+  int max_recovery_ms_;
+  int num_crashes_;
+  int64 entries_lost_;
+  int max_entries_lost_;
+  bool have_previous_;
+  int previous_entries_;
+};
+
 // Main loop for the master process.
-int MasterCode() {
-  for (int i = 0; i < 100000; i++) {
+int MasterCode(int iterations) {
+  Summary summary;
+  for (int i = 0; i < iterations; i++) {
+    file_util::Delete(GetStatsFilePath(), false);
     int ret = RunSlave(i);
-    if (kExpectedCrash != ret)
+    if (kExpectedCrash != ret) {
+      summary.Print();
       return ret;
+    }
+    summary.AddRun(i);
   }
 
   printf("More than enough...\n");
+  summary.Print();
 
   return 0;
 }
 
 // -----------------------------------------------------------------------
 
-// This thread will loop forever, adding and removing entries from the cache.
-// iteration is the current crash cycle, so the entries on the cache are marked
-// to know which instance of the application wrote them.
-void StressTheCache(int iteration) {
+// What the child process has done so far, read by the crash thread.
+base::subtle::Atomic32 g_ready = 0;
+base::subtle::Atomic32 g_num_ops = 0;
+base::subtle::Atomic32 g_num_entries = 0;
+// Set before |g_ready|.
+base::TimeTicks g_start_time;
+int g_recovery_ms = 0;
+int g_initial_entries = 0;
+
+// Saves the RunStats of this process.
+void WriteRunStats() {
+  if (!base::subtle::Acquire_Load(&g_ready))
+    return;
+  int64 elapsed_ms = (base::TimeTicks::Now() - g_start_time).InMilliseconds();
+  std::string data = base::StringPrintf(
+      "%d %" PRId64 " %d %d %d", base::subtle::NoBarrier_Load(&g_num_ops),
+      elapsed_ms, base::subtle::NoBarrier_Load(&g_num_entries), g_recovery_ms,
+      g_initial_entries);
+  file_util::WriteFile(GetStatsFilePath(), data.data(), data.size());
+}
+
+const int kSize = 4000;
+
+// Loops forever adding, reading and removing entries from the cache, with one
+// operation in flight at a time. |iteration| is the current crash cycle, so
+// the entries on the cache are marked to know which instance of the
+// application wrote them.
+class Worker {
+ public:
+  Worker(disk_cache::Backend* cache, const std::vector<std::string>* keys,
+         int num_slots, int iteration, const Workload& workload)
+      : cache_(cache),
+        keys_(keys),
+        entries_(num_slots),
+        iteration_(iteration),
+        workload_(workload),
+        state_(STATE_NONE),
+        slot_(0),
+        size_(0),
+        truncate_(false),
+        buffer_(new net::IOBuffer(kSize)),
+        ALLOW_THIS_IN_INITIALIZER_LIST(
+            callback_(this, &Worker::OnIOComplete)) {
+    memset(buffer_->data(), 'k', kSize);
+  }
+
+  void Start() {
+    state_ = STATE_OPEN;
+    DoLoop(net::OK);
+  }
+
+ private:
+  enum State {
+    STATE_NONE,
+    STATE_OPEN,
+    STATE_OPEN_COMPLETE,
+    STATE_CREATE_COMPLETE,
+    STATE_READ_COMPLETE,
+    STATE_WRITE_COMPLETE,
+    STATE_DOOM_COMPLETE,
+  };
+
+  void OnIOComplete(int result) {
+    DoLoop(result);
+  }
+
+  void DoLoop(int result) {
+    int rv = result;
+    do {
+      State state = state_;
+      state_ = STATE_NONE;
+      switch (state) {
+        case STATE_OPEN:
+          rv = DoOpen();
+          break;
+        case STATE_OPEN_COMPLETE:
+          rv = DoOpenComplete(rv);
+          break;
+        case STATE_CREATE_COMPLETE:
+          rv = DoCreateComplete(rv);
+          break;
+        case STATE_READ_COMPLETE:
+          CHECK_GE(rv, 0);
+          rv = DoOperationComplete();
+          break;
+        case STATE_WRITE_COMPLETE:
+          CHECK_EQ(size_, rv);
+          rv = DoOperationComplete();
+          break;
+        case STATE_DOOM_COMPLETE:
+          rv = DoDoomComplete();
+          break;
+        default:
+          NOTREACHED() << "bad state";
+          break;
+      }
+    } while (rv != net::ERR_IO_PENDING);
+  }
+
+  int DoOpen() {
+    slot_ = rand() % entries_.size();
+    key_ = (*keys_)[rand() % keys_->size()];
+    if (entries_[slot_]) {
+      entries_[slot_]->Close();
+      entries_[slot_] = NULL;
+    }
+    state_ = STATE_OPEN_COMPLETE;
+    return cache_->OpenEntry(key_, &entries_[slot_], &callback_);
+  }
+
+  int DoOpenComplete(int result) {
+    if (result != net::OK) {
+      state_ = STATE_CREATE_COMPLETE;
+      return cache_->CreateEntry(key_, &entries_[slot_], &callback_);
+    }
+    if (rand() % 100 < workload_.read_percent) {
+      state_ = STATE_READ_COMPLETE;
+      return entries_[slot_]->ReadData(0, 0, buffer_, kSize, &callback_);
+    }
+    return DoWrite();
+  }
+
+  int DoCreateComplete(int result) {
+    if (result != net::OK) {
+      // Another worker created the entry first.
+      CHECK_GT(workload_.num_workers, 1);
+      state_ = STATE_OPEN;
+      return net::OK;
+    }
+    return DoWrite();
+  }
+
+  int DoWrite() {
+    truncate_ = rand() % 2 ? false : true;
+    size_ = kSize - (rand() % 4) * kSize / 4;
+    base::snprintf(buffer_->data(), kSize,
+                   "i: %d iter: %d, size: %d, truncate: %d",
+                   base::subtle::NoBarrier_Load(&g_num_ops), iteration_, size_,
+                   truncate_ ? 1 : 0);
+    state_ = STATE_WRITE_COMPLETE;
+    return entries_[slot_]->WriteData(0, 0, buffer_, size_, &callback_,
+                                      truncate_);
+  }
+
+  int DoOperationComplete() {
+    if (rand() % 100 < workload_.doom_percent) {
+      state_ = STATE_DOOM_COMPLETE;
+      return cache_->DoomEntry((*keys_)[rand() % keys_->size()], &callback_);
+    }
+    return DoDoomComplete();
+  }
+
+  int DoDoomComplete() {
+    int num_ops = base::subtle::NoBarrier_AtomicIncrement(&g_num_ops, 1);
+    base::subtle::NoBarrier_Store(&g_num_entries, cache_->GetEntryCount());
+    if (!(num_ops % 100))
+      printf("Operations: %d    \r", num_ops);
+    state_ = STATE_OPEN;
+    return net::OK;
+  }
+
+  disk_cache::Backend* cache_;
+  const std::vector<std::string>* keys_;
+  std::vector<disk_cache::Entry*> entries_;
+  const int iteration_;
+  const Workload workload_;
+  State state_;
+  int slot_;
+  std::string key_;
+  int size_;
+  bool truncate_;
+  scoped_refptr<net::IOBuffer> buffer_;
+  net::CompletionCallbackImpl<Worker> callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(Worker);
+};
+
+// Runs the workers until the process is killed.
+void StressTheCache(int iteration, const Workload& workload) {
   int cache_size = 0x800000;  // 8MB
   FilePath path = GetCacheFilePath().InsertBeforeExtensionASCII("_stress");
 
@@ -99,6 +431,7 @@ void StressTheCache(int iteration) {
           base::Thread::Options(MessageLoop::TYPE_IO, 0)))
     return;
 
+  base::TimeTicks open_start = base::TimeTicks::Now();
   TestCompletionCallback cb;
   disk_cache::Backend* cache;
   int rv = disk_cache::BackendImpl::CreateBackend(
@@ -110,8 +443,14 @@ void StressTheCache(int iteration) {
     printf("Unable to initialize cache.\n");
     return;
   }
-  printf("Iteration %d, initial entries: %d\n", iteration,
-         cache->GetEntryCount());
+  g_start_time = base::TimeTicks::Now();
+  g_recovery_ms =
+      static_cast<int>((g_start_time - open_start).InMilliseconds());
+  g_initial_entries = cache->GetEntryCount();
+  base::subtle::NoBarrier_Store(&g_num_entries, g_initial_entries);
+  base::subtle::Release_Store(&g_ready, 1);
+  printf("Iteration %d, initial entries: %d, recovery: %d ms\n", iteration,
+         g_initial_entries, g_recovery_ms);
 
   int seed = static_cast<int>(Time::Now().ToInternalValue());
   srand(seed);
@@ -122,53 +461,28 @@ void StressTheCache(int iteration) {
   const int kNumKeys = 1700;
 #endif
   const int kNumEntries = 30;
-  std::string keys[kNumKeys];
-  disk_cache::Entry* entries[kNumEntries] = {0};
-
+  std::vector<std::string> keys(kNumKeys);
   for (int i = 0; i < kNumKeys; i++) {
     keys[i] = GenerateKey(true);
   }
 
-  const int kSize = 4000;
-  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(kSize));
-  memset(buffer->data(), 'k', kSize);
-
-  for (int i = 0;; i++) {
-    int slot = rand() % kNumEntries;
-    int key = rand() % kNumKeys;
-    bool truncate = rand() % 2 ? false : true;
-    int size = kSize - (rand() % 4) * kSize / 4;
-
-    if (entries[slot])
-      entries[slot]->Close();
-
-    rv = cache->OpenEntry(keys[key], &entries[slot], &cb);
-    if (cb.GetResult(rv) != net::OK) {
-      rv = cache->CreateEntry(keys[key], &entries[slot], &cb);
-      CHECK_EQ(net::OK, cb.GetResult(rv));
-    }
-
-    base::snprintf(buffer->data(), kSize,
-                   "i: %d iter: %d, size: %d, truncate: %d", i, iteration, size,
-                   truncate ? 1 : 0);
-    rv = entries[slot]->WriteData(0, 0, buffer, size, &cb, truncate);
-    CHECK_EQ(size, cb.GetResult(rv));
-
-    if (rand() % 100 > 80) {
-      key = rand() % kNumKeys;
-      rv = cache->DoomEntry(keys[key], &cb);
-      cb.GetResult(rv);
-    }
-
-    if (!(i % 100))
-      printf("Entries: %d    \r", i);
+  // The open entries are split among the workers.
+  int num_slots = std::max(kNumEntries / workload.num_workers, 1);
+  ScopedVector<Worker> workers;
+  for (int i = 0; i < workload.num_workers; i++) {
+    Worker* worker = new Worker(cache, &keys, num_slots, iteration, workload);
+    workers.push_back(worker);
+    worker->Start();
   }
+  MessageLoop::current()->Run();
 }
 
 // We want to prevent the timer thread from killing the process while we are
 // waiting for the debugger to attach.
 bool g_crashing = false;
 
+int g_crash_interval_ms = 10000;  // 10 seconds
+
 class CrashTask : public Task {
  public:
   CrashTask() {}
@@ -183,6 +497,7 @@ class CrashTask : public Task {
 
     if (rand() % 100 > 1) {
       printf("sweet death...\n");
+      WriteRunStats();
 #if defined(OS_WIN)
       // Windows does more work on _exit() that we would like, so we use Kill.
       base::KillProcessById(base::GetCurrentProcId(), kExpectedCrash, false);
@@ -195,9 +510,8 @@ class CrashTask : public Task {
   }
 
   static void RunSoon(MessageLoop* target_loop) {
-    int task_delay = 10000;  // 10 seconds
     CrashTask* task = new CrashTask();
-    target_loop->PostDelayedTask(FROM_HERE, task, task_delay);
+    target_loop->PostDelayedTask(FROM_HERE, task, g_crash_interval_ms);
   }
 };
 
@@ -221,9 +535,22 @@ void CrashHandler(const std::string& str) {
 int main(int argc, const char* argv[]) {
   // Setup an AtExitManager so Singleton objects will be destructed.
   base::AtExitManager at_exit_manager;
-
-  if (argc < 2)
-    return MasterCode();
+  CommandLine::Init(argc, argv);
+  const CommandLine& command_line = *CommandLine::ForCurrentProcess();
+
+  if (command_line.args().empty())
+    return MasterCode(GetIntSwitch(command_line, kIterations, 100000));
+
+  Workload workload;
+  workload.num_workers =
+      std::max(GetIntSwitch(command_line, kWorkers, workload.num_workers), 1);
+  workload.read_percent =
+      GetIntSwitch(command_line, kReadPercent, workload.read_percent);
+  workload.doom_percent =
+      GetIntSwitch(command_line, kDoomPercent, workload.doom_percent);
+  g_crash_interval_ms =
+      GetIntSwitch(command_line, kCrashInterval, g_crash_interval_ms / 1000) *
+      1000;
 
   logging::SetLogAssertHandler(CrashHandler);
 
@@ -231,14 +558,14 @@ int main(int argc, const char* argv[]) {
   base::PlatformThread::Sleep(3000);
   MessageLoop message_loop(MessageLoop::TYPE_IO);
 
-  char* end;
-  long int iteration = strtol(argv[1], &end, 0);
+  int iteration = 0;
+  base::StringToInt(command_line.args()[0], &iteration);
 
   if (!StartCrashThread()) {
     printf("failed to start thread\n");
     return kError;
   }
 
-  StressTheCache(iteration);
+  StressTheCache(iteration, workload);
   return 0;
 }
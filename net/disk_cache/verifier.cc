@@ -0,0 +1,168 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/verifier.h"
+
+#include "base/logging.h"
+#include "base/message_loop.h"
+#include "net/disk_cache/backend_impl.h"
+#include "net/disk_cache/histogram_macros.h"
+#include "net/disk_cache/trace.h"
+
+using base::TimeDelta;
+using base::TimeTicks;
+
+namespace {
+
+// Time to wait after a restart before checking the cache, so that we don't
+// compete with the first requests.
+const int kStartDelayMs = 60 * 1000;
+
+// Time to wait before checking the cache when a problem is found.
+const int kInconsistencyDelayMs = 5 * 1000;
+
+// Length of a slice of work, and time between slices.
+const int kSliceLengthMs = 10;
+const int kSliceDelayMs = 100;
+
+// Fixing a broken list may leave some entries out of it. They are found by the
+// index check, or by the next pass. This is the max number of passes in a row.
+const int kMaxPasses = 3;
+
+}  // namespace
+
+namespace disk_cache {
+
+Verifier::Verifier()
+    : backend_(NULL),
+      phase_(PHASE_NONE),
+      position_(0),
+      num_fixed_(0),
+      num_passes_(0),
+      automatic_(false),
+      ALLOW_THIS_IN_INITIALIZER_LIST(factory_(this)) {
+}
+
+Verifier::~Verifier() {
+}
+
+void Verifier::Init(BackendImpl* backend, bool previous_crash,
+                    bool automatic) {
+  backend_ = backend;
+  automatic_ = automatic;
+  if (automatic_ && previous_crash)
+    Schedule(kStartDelayMs);
+}
+
+void Verifier::Stop() {
+  factory_.RevokeAll();
+  phase_ = PHASE_NONE;
+  num_passes_ = 0;
+}
+
+void Verifier::OnInconsistency() {
+  // A check that is already scheduled will take care of this.
+  if (!automatic_ || !factory_.empty())
+    return;
+
+  Schedule(kInconsistencyDelayMs);
+}
+
+int Verifier::RunForTest() {
+  factory_.RevokeAll();
+  StartPass();
+  while (DoStep()) {}
+  phase_ = PHASE_NONE;
+  return num_fixed_;
+}
+
+void Verifier::Schedule(int delay_ms) {
+  MessageLoop::current()->PostDelayedTask(FROM_HERE,
+      factory_.NewRunnableMethod(&Verifier::RunSlice), delay_ms);
+}
+
+void Verifier::RunSlice() {
+  if (backend_->disabled_) {
+    Stop();
+    return;
+  }
+
+  if (PHASE_NONE == phase_)
+    StartPass();
+
+  TimeTicks end = TimeTicks::Now() + TimeDelta::FromMilliseconds(
+      kSliceLengthMs);
+  while (DoStep()) {
+    if (TimeTicks::Now() >= end) {
+      Schedule(kSliceDelayMs);
+      return;
+    }
+  }
+
+  Trace("Verifier done %d", num_fixed_);
+  CACHE_UMA(AGE_MS, "VerifierTime", 0, start_);
+  CACHE_UMA(COUNTS_10000, "VerifierFixes", 0, num_fixed_);
+  phase_ = PHASE_NONE;
+
+  if (num_fixed_ && !backend_->disabled_ && ++num_passes_ < kMaxPasses) {
+    Schedule(kSliceDelayMs);
+    return;
+  }
+  num_passes_ = 0;
+}
+
+void Verifier::StartPass() {
+  Trace("Verifier start");
+  phase_ = PHASE_LISTS;
+  position_ = 0;
+  num_fixed_ = 0;
+  start_ = TimeTicks::Now();
+  backend_->rankings_.ResetLinkCheck();
+}
+
+bool Verifier::DoStep() {
+  if (backend_->disabled_)
+    return false;
+
+  switch (phase_) {
+    case PHASE_LISTS:
+      if (position_ < Rankings::LAST_ELEMENT) {
+        Rankings::List list = static_cast<Rankings::List>(position_);
+        if (!backend_->rankings_.CheckNextLink(list, &num_fixed_)) {
+          backend_->rankings_.ResetLinkCheck();
+          position_++;
+        }
+        return true;
+      }
+      phase_ = PHASE_INDEX;
+      position_ = 0;
+      return true;
+
+    case PHASE_INDEX:
+      if (position_ <= static_cast<int>(backend_->mask_)) {
+        num_fixed_ += backend_->VerifyBucket(position_);
+        position_++;
+        return true;
+      }
+      phase_ = PHASE_BLOCK_FILES;
+      position_ = 0;
+      return true;
+
+    case PHASE_BLOCK_FILES: {
+      bool fixed;
+      if (!backend_->block_files_.VerifyFile(position_, &fixed))
+        return false;
+      if (fixed)
+        num_fixed_++;
+      position_++;
+      return true;
+    }
+
+    default:
+      NOTREACHED();
+      return false;
+  }
+}
+
+}  // namespace disk_cache
@@ -0,0 +1,78 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// See net/disk_cache/disk_cache.h for the public interface of the cache.
+
+#ifndef NET_DISK_CACHE_VERIFIER_H_
+#define NET_DISK_CACHE_VERIFIER_H_
+#pragma once
+
+#include "base/basictypes.h"
+#include "base/task.h"
+#include "base/time.h"
+
+namespace disk_cache {
+
+class BackendImpl;
+
+// This class checks the structures of the cache in the background, a little at
+// a time, when the last instance of the cache was not shut down cleanly, or
+// when a problem is found while serving a request. The rankings lists, the
+// collision lists of the index and the headers of the block files are walked
+// on short slices of the cache thread, and whatever is broken is repaired, or
+// the affected entries are dropped, one at a time. That way a bad block only
+// costs the entries that use it, instead of the whole cache.
+class Verifier {
+ public:
+  Verifier();
+  ~Verifier();
+
+  // Starts checking |backend| if |previous_crash| is true. When |automatic| is
+  // false, the checks only happen when requested through RunForTest().
+  void Init(BackendImpl* backend, bool previous_crash, bool automatic);
+
+  // Drops all the state (the cache is going away).
+  void Stop();
+
+  // Schedules a check because something was wrong with the cache.
+  void OnInconsistency();
+
+  // Checks the whole cache right away, and returns the number of problems
+  // that were fixed.
+  int RunForTest();
+
+ private:
+  enum Phase {
+    PHASE_NONE,
+    PHASE_LISTS,  // The rankings lists.
+    PHASE_INDEX,  // The collision lists of the index.
+    PHASE_BLOCK_FILES  // The headers of the block files.
+  };
+
+  // Runs the next slice of the check after |delay_ms|.
+  void Schedule(int delay_ms);
+
+  void RunSlice();
+
+  // Sets up a new check of the whole cache.
+  void StartPass();
+
+  // Does a small unit of work. Returns false when the check is done.
+  bool DoStep();
+
+  BackendImpl* backend_;
+  Phase phase_;
+  int position_;  // The list, bucket or block file that is being checked.
+  int num_fixed_;  // Problems fixed by the current check.
+  int num_passes_;  // Consecutive checks that found something to fix.
+  bool automatic_;
+  base::TimeTicks start_;
+  ScopedRunnableMethodFactory<Verifier> factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(Verifier);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_VERIFIER_H_
@@ -37,6 +37,12 @@ class FtpCtrlResponseBuffer {
     return !responses_.empty();
   }
 
+  // Returns true if some of the data consumed is not a part of a complete
+  // response yet.
+  bool HasPartialResponse() const {
+    return !buffer_.empty() || multiline_;
+  }
+
   // Returns the next response. It is an error to call this function
   // unless ResponseAvailable returns true.
   FtpCtrlResponse PopResponse();
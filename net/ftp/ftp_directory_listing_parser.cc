@@ -6,6 +6,7 @@
 
 #include "base/i18n/icu_encoding_detection.h"
 #include "base/i18n/icu_string_conversions.h"
+#include "base/logging.h"
 #include "base/stl_util-inl.h"
 #include "base/string_split.h"
 #include "base/string_util.h"
@@ -35,6 +36,34 @@ int FillInRawName(const std::string& encoding,
   return OK;
 }
 
+// The listing formats we recognize, in the order we try them.
+const FtpServerType kServerTypes[] = {
+  SERVER_LS,
+  SERVER_WINDOWS,
+  SERVER_VMS,
+  SERVER_NETWARE,
+};
+
+// Parses |lines| as a listing of |server_type|. Returns true on success.
+bool ParseLines(FtpServerType server_type,
+                const std::vector<string16>& lines,
+                const base::Time& current_time,
+                std::vector<FtpDirectoryListingEntry>* entries) {
+  switch (server_type) {
+    case SERVER_LS:
+      return ParseFtpDirectoryListingLs(lines, current_time, entries);
+    case SERVER_WINDOWS:
+      return ParseFtpDirectoryListingWindows(lines, entries);
+    case SERVER_VMS:
+      return ParseFtpDirectoryListingVms(lines, entries);
+    case SERVER_NETWARE:
+      return ParseFtpDirectoryListingNetware(lines, current_time, entries);
+    default:
+      NOTREACHED();
+      return false;
+  }
+}
+
 // Parses |text| as an FTP directory listing. Fills in |entries|
 // and |server_type| and returns network error code.
 int ParseListing(const string16& text,
@@ -45,30 +74,12 @@ int ParseListing(const string16& text,
   std::vector<string16> lines;
   base::SplitString(text, '\n', &lines);
 
-  // TODO(phajdan.jr): Use a table of callbacks instead of repeating code.
-
-  entries->clear();
-  if (ParseFtpDirectoryListingLs(lines, current_time, entries)) {
-    *server_type = SERVER_LS;
-    return FillInRawName(encoding, entries);
-  }
-
-  entries->clear();
-  if (ParseFtpDirectoryListingWindows(lines, entries)) {
-    *server_type = SERVER_WINDOWS;
-    return FillInRawName(encoding, entries);
-  }
-
-  entries->clear();
-  if (ParseFtpDirectoryListingVms(lines, entries)) {
-    *server_type = SERVER_VMS;
-    return FillInRawName(encoding, entries);
-  }
-
-  entries->clear();
-  if (ParseFtpDirectoryListingNetware(lines, current_time, entries)) {
-    *server_type = SERVER_NETWARE;
-    return FillInRawName(encoding, entries);
+  for (size_t i = 0; i < arraysize(kServerTypes); i++) {
+    entries->clear();
+    if (ParseLines(kServerTypes[i], lines, current_time, entries)) {
+      *server_type = kServerTypes[i];
+      return FillInRawName(encoding, entries);
+    }
   }
 
   entries->clear();
@@ -76,11 +87,13 @@ int ParseListing(const string16& text,
 }
 
 // Detects encoding of |text| and parses it as an FTP directory listing.
-// Fills in |entries| and |server_type| and returns network error code.
+// Fills in |entries|, |server_type| and |encoding| and returns network error
+// code.
 int DecodeAndParse(const std::string& text,
                    const base::Time& current_time,
                    std::vector<FtpDirectoryListingEntry>* entries,
-                   FtpServerType* server_type) {
+                   FtpServerType* server_type,
+                   std::string* encoding) {
   std::vector<std::string> encodings;
   if (!base::DetectAllEncodings(text, &encodings))
     return ERR_ENCODING_DETECTION_FAILED;
@@ -97,8 +110,10 @@ int DecodeAndParse(const std::string& text,
                             current_time,
                             entries,
                             server_type);
-      if (rv == OK)
+      if (rv == OK) {
+        *encoding = encodings[i];
         return rv;
+      }
     }
   }
 
@@ -116,9 +131,143 @@ int ParseFtpDirectoryListing(const std::string& text,
                              const base::Time& current_time,
                              std::vector<FtpDirectoryListingEntry>* entries) {
   FtpServerType server_type = SERVER_UNKNOWN;
-  int rv = DecodeAndParse(text, current_time, entries, &server_type);
+  std::string encoding;
+  int rv = DecodeAndParse(text, current_time, entries, &server_type,
+                          &encoding);
   UpdateFtpServerTypeHistograms(server_type);
   return rv;
 }
 
+// static
+const size_t FtpDirectoryListingStreamParser::kDetectionLineCount = 32;
+
+FtpDirectoryListingStreamParser::FtpDirectoryListingStreamParser(
+    const base::Time& current_time)
+    : current_time_(current_time),
+      state_(STATE_DETECTING),
+      server_type_(SERVER_UNKNOWN),
+      header_entry_count_(0),
+      error_(OK) {
+}
+
+FtpDirectoryListingStreamParser::~FtpDirectoryListingStreamParser() {}
+
+int FtpDirectoryListingStreamParser::ConsumeData(
+    const char* data,
+    int data_length,
+    std::vector<FtpDirectoryListingEntry>* entries) {
+  if (error_ != OK)
+    return error_;
+
+  buffer_.append(data, data_length);
+
+  if (state_ == STATE_DETECTING) {
+    std::string::size_type header_length = 0;
+    for (size_t i = 0; i < kDetectionLineCount; i++) {
+      std::string::size_type end = buffer_.find('\n', header_length);
+      if (end == std::string::npos)
+        return OK;
+      header_length = end + 1;
+    }
+    error_ = DetectFormat(header_length, entries);
+    if (error_ != OK)
+      return error_;
+  }
+
+  if (state_ == STATE_PARSING) {
+    // Leave the last line in the buffer until it is complete.
+    std::string::size_type end = buffer_.rfind('\n');
+    if (end != std::string::npos) {
+      error_ = ParseText(buffer_.substr(0, end + 1), entries);
+      buffer_.erase(0, end + 1);
+    }
+  }
+  return error_;
+}
+
+int FtpDirectoryListingStreamParser::ProcessEndOfInput(
+    std::vector<FtpDirectoryListingEntry>* entries) {
+  if (error_ != OK)
+    return error_;
+
+  if (state_ == STATE_PARSING) {
+    error_ = ParseText(buffer_, entries);
+  } else {
+    // Parse the whole listing at once, like ParseFtpDirectoryListing.
+    std::vector<FtpDirectoryListingEntry> parsed_entries;
+    error_ = DecodeAndParse(buffer_, current_time_, &parsed_entries,
+                            &server_type_, &encoding_);
+    UpdateFtpServerTypeHistograms(server_type_);
+    entries->insert(entries->end(), parsed_entries.begin(),
+                    parsed_entries.end());
+  }
+  buffer_.clear();
+  return error_;
+}
+
+int FtpDirectoryListingStreamParser::DetectFormat(
+    size_t header_length,
+    std::vector<FtpDirectoryListingEntry>* entries) {
+  DCHECK_EQ(STATE_DETECTING, state_);
+
+  std::string header(buffer_, 0, header_length);
+  std::vector<FtpDirectoryListingEntry> header_entries;
+  string16 converted_header;
+  if (DecodeAndParse(header, current_time_, &header_entries, &server_type_,
+                     &encoding_) != OK ||
+      !base::CodepageToUTF16(header,
+                             encoding_.c_str(),
+                             base::OnStringConversionError::FAIL,
+                             &converted_header)) {
+    // A VMS listing, for one, is only complete with the line ending it, so
+    // the first lines are not enough to tell.  Keep the whole listing.
+    server_type_ = SERVER_UNKNOWN;
+    state_ = STATE_BUFFERING;
+    return OK;
+  }
+  UpdateFtpServerTypeHistograms(server_type_);
+
+  base::SplitString(converted_header, '\n', &header_lines_);
+  header_entry_count_ = header_entries.size();
+  entries->insert(entries->end(), header_entries.begin(),
+                  header_entries.end());
+  buffer_.erase(0, header_length);
+  state_ = STATE_PARSING;
+  return OK;
+}
+
+int FtpDirectoryListingStreamParser::ParseText(
+    const std::string& text,
+    std::vector<FtpDirectoryListingEntry>* entries) {
+  DCHECK_EQ(STATE_PARSING, state_);
+
+  string16 converted_text;
+  if (!base::CodepageToUTF16(text,
+                             encoding_.c_str(),
+                             base::OnStringConversionError::FAIL,
+                             &converted_text)) {
+    return ERR_ENCODING_CONVERSION_FAILED;
+  }
+  std::vector<string16> new_lines;
+  base::SplitString(converted_text, '\n', &new_lines);
+
+  // The parsers need the lines the listing starts with to make sense of the
+  // later ones.  Those are few, so it's cheap to parse them again.
+  std::vector<string16> lines(header_lines_);
+  lines.insert(lines.end(), new_lines.begin(), new_lines.end());
+  std::vector<FtpDirectoryListingEntry> parsed_entries;
+  if (!ParseLines(server_type_, lines, current_time_, &parsed_entries))
+    return ERR_UNRECOGNIZED_FTP_DIRECTORY_LISTING_FORMAT;
+  DCHECK_GE(parsed_entries.size(), header_entry_count_);
+  parsed_entries.erase(parsed_entries.begin(),
+                       parsed_entries.begin() + header_entry_count_);
+
+  int rv = FillInRawName(encoding_, &parsed_entries);
+  if (rv != OK)
+    return rv;
+  entries->insert(entries->end(), parsed_entries.begin(),
+                  parsed_entries.end());
+  return OK;
+}
+
 }  // namespace net
@@ -12,6 +12,7 @@
 #include "base/basictypes.h"
 #include "base/string16.h"
 #include "base/time.h"
+#include "net/ftp/ftp_server_type_histograms.h"
 
 namespace net {
 
@@ -39,6 +40,72 @@ int ParseFtpDirectoryListing(const std::string& text,
                              const base::Time& current_time,
                              std::vector<FtpDirectoryListingEntry>* entries);
 
+// Parses an FTP directory listing as it is received, so that its entries can
+// be shown before the end of a large listing.  The encoding and the server
+// type are detected from the first kDetectionLineCount lines, and the later
+// lines are parsed as they are completed.
+class FtpDirectoryListingStreamParser {
+ public:
+  static const size_t kDetectionLineCount;
+
+  explicit FtpDirectoryListingStreamParser(const base::Time& current_time);
+  ~FtpDirectoryListingStreamParser();
+
+  // Called when data of the listing is received.  Appends the entries it
+  // completes to |entries|.  Returns network error code; once it returns an
+  // error, the rest of the listing is ignored.
+  int ConsumeData(const char* data,
+                  int data_length,
+                  std::vector<FtpDirectoryListingEntry>* entries);
+
+  // Called at the end of the listing.  Appends the remaining entries to
+  // |entries| and returns network error code.
+  int ProcessEndOfInput(std::vector<FtpDirectoryListingEntry>* entries);
+
+ private:
+  enum State {
+    // Waiting for the lines to detect the format from.
+    STATE_DETECTING,
+
+    // Parsing each line as it is completed.
+    STATE_PARSING,
+
+    // The format wasn't detected from the first lines, so the whole listing
+    // is parsed at the end.
+    STATE_BUFFERING,
+  };
+
+  // Detects the format from the first |header_length| bytes of |buffer_|,
+  // which hold complete lines, and appends their entries to |entries| if it
+  // is detected.  Returns network error code.
+  int DetectFormat(size_t header_length,
+                   std::vector<FtpDirectoryListingEntry>* entries);
+
+  // Parses the listing lines in |text|, appending their entries to
+  // |entries|.  Returns network error code.
+  int ParseText(const std::string& text,
+                std::vector<FtpDirectoryListingEntry>* entries);
+
+  const base::Time current_time_;
+
+  State state_;
+
+  // Data received and not parsed yet.
+  std::string buffer_;
+
+  FtpServerType server_type_;
+  std::string encoding_;
+
+  // The lines the format was detected from, and the number of entries in
+  // them.
+  std::vector<string16> header_lines_;
+  size_t header_entry_count_;
+
+  int error_;
+
+  DISALLOW_COPY_AND_ASSIGN(FtpDirectoryListingStreamParser);
+};
+
 }  // namespace net
 
 #endif  // NET_FTP_FTP_DIRECTORY_LISTING_PARSER_H_
@@ -4,6 +4,8 @@
 
 #include "net/ftp/ftp_directory_listing_parser.h"
 
+#include <algorithm>
+
 #include "base/file_util.h"
 #include "base/format_macros.h"
 #include "base/path_service.h"
@@ -19,71 +21,79 @@ namespace net {
 
 namespace {
 
-TEST(FtpDirectoryListingBufferTest, Parse) {
-  const char* test_files[] = {
-    "dir-listing-ls-1",
-    "dir-listing-ls-1-utf8",
-    "dir-listing-ls-2",
-    "dir-listing-ls-3",
-    "dir-listing-ls-4",
-    "dir-listing-ls-5",
-    "dir-listing-ls-6",
-    "dir-listing-ls-7",
-    "dir-listing-ls-8",
-    "dir-listing-ls-9",
-    "dir-listing-ls-10",
-    "dir-listing-ls-11",
-    "dir-listing-ls-12",
-    "dir-listing-ls-13",
-    "dir-listing-ls-14",
-    "dir-listing-ls-15",
-    "dir-listing-ls-16",
-    "dir-listing-ls-17",
-    "dir-listing-ls-18",
-    "dir-listing-ls-19",
-    "dir-listing-ls-20",  // TODO(phajdan.jr): should use windows-1251 encoding.
-    "dir-listing-ls-21",  // TODO(phajdan.jr): should use windows-1251 encoding.
-    "dir-listing-ls-22",  // TODO(phajdan.jr): should use windows-1251 encoding.
-    "dir-listing-ls-23",
-    "dir-listing-ls-24",
-
-    // Tests for Russian listings. The only difference between those
-    // files is character encoding:
-    "dir-listing-ls-25",  // UTF-8
-    "dir-listing-ls-26",  // KOI8-R
-    "dir-listing-ls-27",  // windows-1251
-
-    "dir-listing-netware-1",
-    "dir-listing-netware-2",
-    "dir-listing-vms-1",
-    "dir-listing-vms-2",
-    "dir-listing-vms-3",
-    "dir-listing-vms-4",
-    "dir-listing-vms-5",
-    "dir-listing-windows-1",
-    "dir-listing-windows-2",
-  };
+const char* const kTestFiles[] = {
+  "dir-listing-ls-1",
+  "dir-listing-ls-1-utf8",
+  "dir-listing-ls-2",
+  "dir-listing-ls-3",
+  "dir-listing-ls-4",
+  "dir-listing-ls-5",
+  "dir-listing-ls-6",
+  "dir-listing-ls-7",
+  "dir-listing-ls-8",
+  "dir-listing-ls-9",
+  "dir-listing-ls-10",
+  "dir-listing-ls-11",
+  "dir-listing-ls-12",
+  "dir-listing-ls-13",
+  "dir-listing-ls-14",
+  "dir-listing-ls-15",
+  "dir-listing-ls-16",
+  "dir-listing-ls-17",
+  "dir-listing-ls-18",
+  "dir-listing-ls-19",
+  "dir-listing-ls-20",  // TODO(phajdan.jr): should use windows-1251 encoding.
+  "dir-listing-ls-21",  // TODO(phajdan.jr): should use windows-1251 encoding.
+  "dir-listing-ls-22",  // TODO(phajdan.jr): should use windows-1251 encoding.
+  "dir-listing-ls-23",
+  "dir-listing-ls-24",
+
+  // Tests for Russian listings. The only difference between those
+  // files is character encoding:
+  "dir-listing-ls-25",  // UTF-8
+  "dir-listing-ls-26",  // KOI8-R
+  "dir-listing-ls-27",  // windows-1251
 
+  "dir-listing-netware-1",
+  "dir-listing-netware-2",
+  "dir-listing-vms-1",
+  "dir-listing-vms-2",
+  "dir-listing-vms-3",
+  "dir-listing-vms-4",
+  "dir-listing-vms-5",
+  "dir-listing-windows-1",
+  "dir-listing-windows-2",
+};
+
+FilePath GetTestDataDir() {
   FilePath test_dir;
   PathService::Get(base::DIR_SOURCE_ROOT, &test_dir);
   test_dir = test_dir.AppendASCII("net");
   test_dir = test_dir.AppendASCII("data");
   test_dir = test_dir.AppendASCII("ftp");
+  return test_dir;
+}
 
+base::Time GetMockCurrentTime() {
   base::Time::Exploded mock_current_time_exploded = { 0 };
   mock_current_time_exploded.year = 1994;
   mock_current_time_exploded.month = 11;
   mock_current_time_exploded.day_of_month = 15;
   mock_current_time_exploded.hour = 12;
   mock_current_time_exploded.minute = 45;
-  base::Time mock_current_time(
-      base::Time::FromLocalExploded(mock_current_time_exploded));
+  return base::Time::FromLocalExploded(mock_current_time_exploded);
+}
+
+TEST(FtpDirectoryListingBufferTest, Parse) {
+
+  FilePath test_dir(GetTestDataDir());
+  base::Time mock_current_time(GetMockCurrentTime());
 
-  for (size_t i = 0; i < arraysize(test_files); i++) {
-    SCOPED_TRACE(base::StringPrintf("Test[%" PRIuS "]: %s", i, test_files[i]));
+  for (size_t i = 0; i < arraysize(kTestFiles); i++) {
+    SCOPED_TRACE(base::StringPrintf("Test[%" PRIuS "]: %s", i, kTestFiles[i]));
 
     std::string test_listing;
-    EXPECT_TRUE(file_util::ReadFileToString(test_dir.AppendASCII(test_files[i]),
+    EXPECT_TRUE(file_util::ReadFileToString(test_dir.AppendASCII(kTestFiles[i]),
                                             &test_listing));
 
     std::vector<FtpDirectoryListingEntry> entries;
@@ -93,7 +103,7 @@ TEST(FtpDirectoryListingBufferTest, Parse) {
 
     std::string expected_listing;
     ASSERT_TRUE(file_util::ReadFileToString(
-        test_dir.AppendASCII(std::string(test_files[i]) + ".expected"),
+        test_dir.AppendASCII(std::string(kTestFiles[i]) + ".expected"),
         &expected_listing));
 
     std::vector<std::string> lines;
@@ -144,6 +154,122 @@ TEST(FtpDirectoryListingBufferTest, Parse) {
   }
 }
 
+// The stream parser should find the same entries however the listing is
+// split.
+TEST(FtpDirectoryListingBufferTest, StreamParse) {
+  const size_t kChunkSizes[] = { 1, 7, 100, 4096 };
+
+  FilePath test_dir(GetTestDataDir());
+  base::Time mock_current_time(GetMockCurrentTime());
+
+  for (size_t i = 0; i < arraysize(kTestFiles); i++) {
+    std::string test_listing;
+    EXPECT_TRUE(file_util::ReadFileToString(test_dir.AppendASCII(kTestFiles[i]),
+                                            &test_listing));
+
+    std::vector<FtpDirectoryListingEntry> expected_entries;
+    EXPECT_EQ(OK, ParseFtpDirectoryListing(test_listing,
+                                           mock_current_time,
+                                           &expected_entries));
+
+    for (size_t j = 0; j < arraysize(kChunkSizes); j++) {
+      SCOPED_TRACE(base::StringPrintf("Test[%" PRIuS "]: %s, chunk size %"
+                                      PRIuS, i, kTestFiles[i],
+                                      kChunkSizes[j]));
+
+      FtpDirectoryListingStreamParser parser(mock_current_time);
+      std::vector<FtpDirectoryListingEntry> entries;
+      for (size_t offset = 0; offset < test_listing.length();
+           offset += kChunkSizes[j]) {
+        size_t length = std::min(kChunkSizes[j],
+                                 test_listing.length() - offset);
+        ASSERT_EQ(OK, parser.ConsumeData(test_listing.data() + offset,
+                                         static_cast<int>(length),
+                                         &entries));
+      }
+      ASSERT_EQ(OK, parser.ProcessEndOfInput(&entries));
+
+      ASSERT_EQ(expected_entries.size(), entries.size());
+      for (size_t k = 0; k < entries.size(); k++) {
+        EXPECT_EQ(expected_entries[k].type, entries[k].type);
+        EXPECT_EQ(expected_entries[k].name, entries[k].name);
+        EXPECT_EQ(expected_entries[k].raw_name, entries[k].raw_name);
+        EXPECT_EQ(expected_entries[k].size, entries[k].size);
+        EXPECT_EQ(expected_entries[k].last_modified,
+                  entries[k].last_modified);
+      }
+    }
+  }
+}
+
+TEST(FtpDirectoryListingBufferTest, StreamParseEntriesBeforeEnd) {
+  const size_t kLineCount =
+      2 * FtpDirectoryListingStreamParser::kDetectionLineCount;
+  std::string listing("total 1\r\n");
+  for (size_t i = 0; i < kLineCount; i++) {
+    listing.append(base::StringPrintf(
+        "-rw-r--r--   1 ftp  ftp  %" PRIuS " May 11  2009 file%" PRIuS "\r\n",
+        i, i));
+  }
+
+  FtpDirectoryListingStreamParser parser(GetMockCurrentTime());
+  std::vector<FtpDirectoryListingEntry> entries;
+  EXPECT_EQ(OK, parser.ConsumeData(listing.data(),
+                                   static_cast<int>(listing.length()),
+                                   &entries));
+  ASSERT_EQ(kLineCount, entries.size());
+  EXPECT_EQ(ASCIIToUTF16("file0"), entries[0].name);
+  EXPECT_EQ(5, entries[5].size);
+
+  // Only a complete line is parsed.
+  std::string line("-rw-r--r--   1 ftp  ftp  1 May 11  2009 last\r\n");
+  entries.clear();
+  EXPECT_EQ(OK, parser.ConsumeData(line.data(),
+                                   static_cast<int>(line.length()) - 2,
+                                   &entries));
+  EXPECT_TRUE(entries.empty());
+  EXPECT_EQ(OK, parser.ConsumeData(line.data() + line.length() - 2, 2,
+                                   &entries));
+  ASSERT_EQ(1u, entries.size());
+  EXPECT_EQ(ASCIIToUTF16("last"), entries[0].name);
+
+  entries.clear();
+  EXPECT_EQ(OK, parser.ProcessEndOfInput(&entries));
+  EXPECT_TRUE(entries.empty());
+}
+
+TEST(FtpDirectoryListingBufferTest, StreamParseError) {
+  std::string listing;
+  for (size_t i = 0; i < FtpDirectoryListingStreamParser::kDetectionLineCount;
+       i++) {
+    listing.append("-rw-r--r--   1 ftp  ftp  1 May 11  2009 file\r\n");
+  }
+
+  FtpDirectoryListingStreamParser parser(GetMockCurrentTime());
+  std::vector<FtpDirectoryListingEntry> entries;
+  EXPECT_EQ(OK, parser.ConsumeData(listing.data(),
+                                   static_cast<int>(listing.length()),
+                                   &entries));
+  EXPECT_EQ(FtpDirectoryListingStreamParser::kDetectionLineCount,
+            entries.size());
+
+  // Once the format is known, a line which doesn't fit it is an error, and
+  // so is the rest of the listing.
+  std::string bad_line("garbage\r\n");
+  entries.clear();
+  EXPECT_EQ(ERR_UNRECOGNIZED_FTP_DIRECTORY_LISTING_FORMAT,
+            parser.ConsumeData(bad_line.data(),
+                               static_cast<int>(bad_line.length()),
+                               &entries));
+  EXPECT_EQ(ERR_UNRECOGNIZED_FTP_DIRECTORY_LISTING_FORMAT,
+            parser.ConsumeData(listing.data(),
+                               static_cast<int>(listing.length()),
+                               &entries));
+  EXPECT_EQ(ERR_UNRECOGNIZED_FTP_DIRECTORY_LISTING_FORMAT,
+            parser.ProcessEndOfInput(&entries));
+  EXPECT_TRUE(entries.empty());
+}
+
 }  // namespace
 
 }  // namespace net
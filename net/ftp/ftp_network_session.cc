@@ -1,15 +1,97 @@
-// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
 #include "net/ftp/ftp_network_session.h"
 
+#include "base/logging.h"
+#include "net/socket/client_socket.h"
+
 namespace net {
 
+// static
+const size_t FtpNetworkSession::kMaxIdleCtrlConnections = 6;
+
+// static
+const int FtpNetworkSession::kIdleCtrlConnectionTimeoutSeconds = 60;
+
+FtpNetworkSession::IdleCtrlConnection::IdleCtrlConnection()
+    : socket(NULL),
+      system_type(0),
+      data_type(0),
+      use_epsv(true) {
+}
+
+FtpNetworkSession::IdleCtrlConnection::~IdleCtrlConnection() {}
+
+FtpNetworkSession::IdleCtrlConnectionEntry::IdleCtrlConnectionEntry(
+    const HostPortPair& host_port_pair,
+    const string16& username,
+    const string16& password,
+    const IdleCtrlConnection& connection)
+    : host_port_pair(host_port_pair),
+      username(username),
+      password(password),
+      connection(connection),
+      idle_since(base::TimeTicks::Now()) {
+}
+
+FtpNetworkSession::IdleCtrlConnectionEntry::~IdleCtrlConnectionEntry() {}
+
 FtpNetworkSession::FtpNetworkSession(HostResolver* host_resolver)
     : host_resolver_(host_resolver) {}
 
-FtpNetworkSession::~FtpNetworkSession() {}
+FtpNetworkSession::~FtpNetworkSession() {
+  CloseIdleCtrlConnections();
+}
 
-}  // namespace net
+bool FtpNetworkSession::TakeIdleCtrlConnection(
+    const HostPortPair& host_port_pair,
+    const string16& username,
+    const string16& password,
+    IdleCtrlConnection* connection) {
+  base::TimeTicks expired = base::TimeTicks::Now() -
+      base::TimeDelta::FromSeconds(kIdleCtrlConnectionTimeoutSeconds);
+  IdleCtrlConnectionList::iterator it = idle_ctrl_connections_.begin();
+  while (it != idle_ctrl_connections_.end()) {
+    IdleCtrlConnectionList::iterator entry = it++;
+    if (entry->idle_since < expired ||
+        !entry->connection.socket->IsConnectedAndIdle()) {
+      delete entry->connection.socket;
+      idle_ctrl_connections_.erase(entry);
+      continue;
+    }
+    if (entry->host_port_pair.Equals(host_port_pair) &&
+        entry->username == username && entry->password == password) {
+      *connection = entry->connection;
+      idle_ctrl_connections_.erase(entry);
+      return true;
+    }
+  }
+  return false;
+}
+
+void FtpNetworkSession::AddIdleCtrlConnection(
+    const HostPortPair& host_port_pair,
+    const string16& username,
+    const string16& password,
+    const IdleCtrlConnection& connection) {
+  DCHECK(connection.socket);
+  idle_ctrl_connections_.push_front(IdleCtrlConnectionEntry(
+      host_port_pair, username, password, connection));
 
+  if (idle_ctrl_connections_.size() > kMaxIdleCtrlConnections) {
+    delete idle_ctrl_connections_.back().connection.socket;
+    idle_ctrl_connections_.pop_back();
+  }
+}
+
+void FtpNetworkSession::CloseIdleCtrlConnections() {
+  for (IdleCtrlConnectionList::iterator it = idle_ctrl_connections_.begin();
+       it != idle_ctrl_connections_.end(); ++it) {
+    delete it->connection.socket;
+  }
+  idle_ctrl_connections_.clear();
+}
+
+}  // namespace net
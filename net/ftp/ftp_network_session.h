@@ -6,28 +6,103 @@
 #define NET_FTP_FTP_NETWORK_SESSION_H_
 #pragma once
 
+#include <list>
+#include <string>
+
 #include "base/memory/ref_counted.h"
+#include "base/string16.h"
+#include "base/time.h"
+#include "net/base/host_port_pair.h"
 #include "net/ftp/ftp_auth_cache.h"
 
 namespace net {
 
+class ClientSocket;
 class HostResolver;
 
 // This class holds session objects used by FtpNetworkTransaction objects.
 class FtpNetworkSession : public base::RefCounted<FtpNetworkSession> {
  public:
+  // Maximum number of idle control connections we keep.
+  static const size_t kMaxIdleCtrlConnections;
+
+  // An idle control connection is dropped after this many seconds, as the
+  // server is likely to have closed it by then.
+  static const int kIdleCtrlConnectionTimeoutSeconds;
+
+  // A control connection logged in to a server, with what the transaction
+  // which used it last learned about the server.
+  struct IdleCtrlConnection {
+    IdleCtrlConnection();
+    ~IdleCtrlConnection();
+
+    ClientSocket* socket;
+
+    // FtpNetworkTransaction's SystemType of the server, and DataType set by
+    // the last TYPE command sent on the connection.
+    int system_type;
+    int data_type;
+
+    bool use_epsv;
+
+    // As returned by PWD after the login, with any trailing slash removed.
+    std::string remote_directory;
+  };
+
   explicit FtpNetworkSession(HostResolver* host_resolver);
 
   HostResolver* host_resolver() { return host_resolver_; }
   FtpAuthCache* auth_cache() { return &auth_cache_; }
 
+  // Takes the most recently used idle control connection to |host_port_pair|
+  // logged in with |username| and |password| into |connection|, dropping the
+  // ones that have been idle for too long or were closed by the server.
+  // Returns false if there is none.  The caller owns |connection->socket|
+  // after this.
+  bool TakeIdleCtrlConnection(const HostPortPair& host_port_pair,
+                              const string16& username,
+                              const string16& password,
+                              IdleCtrlConnection* connection);
+
+  // Keeps |connection| for later transactions.  The session owns
+  // |connection.socket| after this.
+  void AddIdleCtrlConnection(const HostPortPair& host_port_pair,
+                             const string16& username,
+                             const string16& password,
+                             const IdleCtrlConnection& connection);
+
+  void CloseIdleCtrlConnections();
+
+  size_t idle_ctrl_connection_count() const {
+    return idle_ctrl_connections_.size();
+  }
+
  private:
   friend class base::RefCounted<FtpNetworkSession>;
 
+  struct IdleCtrlConnectionEntry {
+    IdleCtrlConnectionEntry(const HostPortPair& host_port_pair,
+                            const string16& username,
+                            const string16& password,
+                            const IdleCtrlConnection& connection);
+    ~IdleCtrlConnectionEntry();
+
+    HostPortPair host_port_pair;
+    string16 username;
+    string16 password;
+    IdleCtrlConnection connection;
+    base::TimeTicks idle_since;
+  };
+  typedef std::list<IdleCtrlConnectionEntry> IdleCtrlConnectionList;
+
   virtual ~FtpNetworkSession();
 
   HostResolver* const host_resolver_;
   FtpAuthCache auth_cache_;
+
+  // Most recently used first.  Like the auth cache, we expect very few
+  // entries here.
+  IdleCtrlConnectionList idle_ctrl_connections_;
 };
 
 }  // namespace net
@@ -181,6 +181,7 @@ FtpNetworkTransaction::FtpNetworkTransaction(
     FtpNetworkSession* session,
     ClientSocketFactory* socket_factory)
     : command_sent_(COMMAND_NONE),
+      pipelined_command_(COMMAND_NONE),
       ALLOW_THIS_IN_INITIALIZER_LIST(
           io_callback_(this, &FtpNetworkTransaction::OnIOComplete)),
       user_callback_(NULL),
@@ -199,6 +200,9 @@ FtpNetworkTransaction::FtpNetworkTransaction(
       use_epsv_(true),
       data_connection_port_(0),
       socket_factory_(socket_factory),
+      ctrl_reused_(false),
+      ctrl_response_received_(false),
+      allow_ctrl_reuse_(true),
       next_state_(STATE_NONE) {
 }
 
@@ -305,6 +309,7 @@ uint64 FtpNetworkTransaction::GetUploadProgress() const {
 
 void FtpNetworkTransaction::ResetStateForRestart() {
   command_sent_ = COMMAND_NONE;
+  pipelined_command_ = COMMAND_NONE;
   user_callback_ = NULL;
   response_ = FtpResponseInfo();
   read_ctrl_buf_ = new IOBuffer(kCtrlBufLen);
@@ -316,6 +321,9 @@ void FtpNetworkTransaction::ResetStateForRestart() {
   last_error_ = OK;
   data_connection_port_ = 0;
   ctrl_socket_.reset();
+  ctrl_reused_ = false;
+  ctrl_response_received_ = false;
+  allow_ctrl_reuse_ = true;
   data_socket_.reset();
   next_state_ = STATE_NONE;
 }
@@ -339,6 +347,11 @@ void FtpNetworkTransaction::OnIOComplete(int result) {
 int FtpNetworkTransaction::ProcessCtrlResponse() {
   FtpCtrlResponse response = ctrl_response_buffer_->PopResponse();
 
+  // A server may tell us why it is closing a connection we kept idle.
+  if (response.status_code == 421 && CanRetryWithNewCtrlConnection())
+    return RetryWithNewCtrlConnection();
+  ctrl_response_received_ = true;
+
   int rv = OK;
   switch (command_sent_) {
     case COMMAND_NONE:
@@ -387,8 +400,10 @@ int FtpNetworkTransaction::ProcessCtrlResponse() {
   }
 
   // We may get multiple responses for some commands,
-  // see http://crbug.com/18036.
-  while (ctrl_response_buffer_->ResponseAvailable() && rv == OK) {
+  // see http://crbug.com/18036.  The next response is for the pipelined
+  // command if there is one.
+  while (pipelined_command_ == COMMAND_NONE &&
+         ctrl_response_buffer_->ResponseAvailable() && rv == OK) {
     response = ctrl_response_buffer_->PopResponse();
 
     switch (command_sent_) {
@@ -410,6 +425,31 @@ int FtpNetworkTransaction::ProcessCtrlResponse() {
 // Used to prepare and send FTP command.
 int FtpNetworkTransaction::SendFtpCommand(const std::string& command,
                                           Command cmd) {
+  if (pipelined_command_ != COMMAND_NONE) {
+    Command pipelined_command = pipelined_command_;
+    pipelined_command_ = COMMAND_NONE;
+    if (cmd == pipelined_command) {
+      // It has been sent already, so go on with its response.
+      command_sent_ = cmd;
+      if (ctrl_response_buffer_->ResponseAvailable()) {
+        next_state_ = STATE_NONE;
+        return ProcessCtrlResponse();
+      }
+      next_state_ = STATE_CTRL_READ;
+      return OK;
+    }
+
+    // The response to the pipelined command would be taken for the response
+    // to |cmd|, so this connection can't be used any more.
+    if (cmd == COMMAND_QUIT) {
+      command_sent_ = COMMAND_QUIT;
+      ctrl_socket_->Disconnect();
+      next_state_ = STATE_NONE;
+      return last_error_;
+    }
+    return RetryWithNewCtrlConnection();
+  }
+
   // If we send a new command when we still have unprocessed responses
   // for previous commands, the response receiving code will have no way to know
   // which responses are for which command.
@@ -437,6 +477,95 @@ int FtpNetworkTransaction::SendFtpCommand(const std::string& command,
   return OK;
 }
 
+void FtpNetworkTransaction::PipelineFtpCommand(const std::string& command,
+                                               Command cmd) {
+  DCHECK_EQ(STATE_CTRL_WRITE, next_state_);
+  DCHECK_EQ(COMMAND_NONE, pipelined_command_);
+  DCHECK(IsValidFTPCommandString(command));
+
+  std::string line(write_command_buf_->data(), write_command_buf_->size());
+  line.append(command).append(kCRLF);
+  write_command_buf_ = new IOBufferWithSize(line.length());
+  write_buf_ = new DrainableIOBuffer(write_command_buf_,
+                                     write_command_buf_->size());
+  memcpy(write_command_buf_->data(), line.data(), line.length());
+  pipelined_command_ = cmd;
+}
+
+bool FtpNetworkTransaction::TakeCtrlSocket() {
+  FtpNetworkSession::IdleCtrlConnection connection;
+  if (!allow_ctrl_reuse_ ||
+      !session_->TakeIdleCtrlConnection(HostPortPair::FromURL(request_->url),
+                                        username_, password_, &connection)) {
+    return false;
+  }
+  ctrl_socket_.reset(connection.socket);
+
+  // Put the peer's IP address and port into the response.
+  AddressList address;
+  if (ctrl_socket_->GetPeerAddress(&address) != OK) {
+    ctrl_socket_.reset();
+    return false;
+  }
+  response_.socket_address = HostPortPair::FromAddrInfo(address.head());
+
+  ctrl_reused_ = true;
+  system_type_ = static_cast<SystemType>(connection.system_type);
+  use_epsv_ = connection.use_epsv;
+  current_remote_directory_ = connection.remote_directory;
+
+  // The data type set on the connection stays in effect.
+  if (static_cast<DataType>(connection.data_type) == data_type_)
+    next_state_ = use_epsv_ ? STATE_CTRL_WRITE_EPSV : STATE_CTRL_WRITE_PASV;
+  else
+    next_state_ = STATE_CTRL_WRITE_TYPE;
+  return true;
+}
+
+bool FtpNetworkTransaction::ReleaseCtrlSocket() {
+  if (ctrl_response_buffer_->ResponseAvailable() ||
+      ctrl_response_buffer_->HasPartialResponse() ||
+      !ctrl_socket_->IsConnectedAndIdle()) {
+    return false;
+  }
+
+  FtpNetworkSession::IdleCtrlConnection connection;
+  connection.system_type = system_type_;
+  connection.data_type = data_type_;
+  connection.use_epsv = use_epsv_;
+  connection.remote_directory = current_remote_directory_;
+  connection.socket = ctrl_socket_.release();
+  session_->AddIdleCtrlConnection(HostPortPair::FromURL(request_->url),
+                                  username_, password_, connection);
+  return true;
+}
+
+bool FtpNetworkTransaction::CanRetryWithNewCtrlConnection() const {
+  return ctrl_reused_ && !ctrl_response_received_;
+}
+
+int FtpNetworkTransaction::RetryWithNewCtrlConnection() {
+  DCHECK(ctrl_reused_);
+  ctrl_socket_.reset();
+  data_socket_.reset();
+  ctrl_reused_ = false;
+  ctrl_response_received_ = false;
+  allow_ctrl_reuse_ = false;
+  command_sent_ = COMMAND_NONE;
+  pipelined_command_ = COMMAND_NONE;
+  ctrl_response_buffer_.reset(new FtpCtrlResponseBuffer());
+  write_buf_ = NULL;
+  write_command_buf_ = NULL;
+
+  // Learn about the server again, as if the session didn't know it.
+  system_type_ = SYSTEM_TYPE_UNKNOWN;
+  use_epsv_ = true;
+  current_remote_directory_.clear();
+
+  next_state_ = STATE_CTRL_RESOLVE_HOST;
+  return OK;
+}
+
 std::string FtpNetworkTransaction::GetRequestPathForFtpCommand(
     bool is_directory) const {
   std::string path(current_remote_directory_);
@@ -600,6 +729,11 @@ int FtpNetworkTransaction::DoLoop(int result) {
 }
 
 int FtpNetworkTransaction::DoCtrlResolveHost() {
+  // There is no need to connect and log in if the session kept a connection
+  // to the server.
+  if (TakeCtrlSocket())
+    return OK;
+
   next_state_ = STATE_CTRL_RESOLVE_HOST_COMPLETE;
 
   HostResolver::RequestInfo info(HostPortPair::FromURL(request_->url));
@@ -642,6 +776,8 @@ int FtpNetworkTransaction::DoCtrlRead() {
 }
 
 int FtpNetworkTransaction::DoCtrlReadComplete(int result) {
+  if (result <= 0 && CanRetryWithNewCtrlConnection())
+    return RetryWithNewCtrlConnection();
   if (result == 0) {
     // Some servers (for example Pure-FTPd) apparently close the control
     // connection when anonymous login is not permitted. For more details
@@ -673,8 +809,11 @@ int FtpNetworkTransaction::DoCtrlWrite() {
 }
 
 int FtpNetworkTransaction::DoCtrlWriteComplete(int result) {
-  if (result < 0)
+  if (result < 0) {
+    if (CanRetryWithNewCtrlConnection())
+      return RetryWithNewCtrlConnection();
     return result;
+  }
 
   write_buf_->DidConsume(result);
   if (write_buf_->BytesRemaining() == 0) {
@@ -864,7 +1003,16 @@ int FtpNetworkTransaction::DoCtrlWriteTYPE() {
     return Stop(ERR_UNEXPECTED);
   }
   next_state_ = STATE_CTRL_READ;
-  return SendFtpCommand(command, COMMAND_TYPE);
+  int rv = SendFtpCommand(command, COMMAND_TYPE);
+  // On a connection which has been used before, TYPE is all but certain to
+  // succeed, so ask for the data connection right away.
+  if (rv == OK && next_state_ == STATE_CTRL_WRITE && ctrl_reused_) {
+    if (use_epsv_)
+      PipelineFtpCommand("EPSV", COMMAND_EPSV);
+    else
+      PipelineFtpCommand("PASV", COMMAND_PASV);
+  }
+  return rv;
 }
 
 int FtpNetworkTransaction::ProcessResponseTYPE(
@@ -892,7 +1040,14 @@ int FtpNetworkTransaction::ProcessResponseTYPE(
 int FtpNetworkTransaction::DoCtrlWriteEPSV() {
   const std::string command = "EPSV";
   next_state_ = STATE_CTRL_READ;
-  return SendFtpCommand(command, COMMAND_EPSV);
+  int rv = SendFtpCommand(command, COMMAND_EPSV);
+  // SIZE always follows the data connection, and its response doesn't
+  // depend on it.
+  if (rv == OK && next_state_ == STATE_CTRL_WRITE && ctrl_reused_) {
+    PipelineFtpCommand("SIZE " + GetRequestPathForFtpCommand(false),
+                       COMMAND_SIZE);
+  }
+  return rv;
 }
 
 int FtpNetworkTransaction::ProcessResponseEPSV(
@@ -926,7 +1081,12 @@ int FtpNetworkTransaction::ProcessResponseEPSV(
 int FtpNetworkTransaction::DoCtrlWritePASV() {
   std::string command = "PASV";
   next_state_ = STATE_CTRL_READ;
-  return SendFtpCommand(command, COMMAND_PASV);
+  int rv = SendFtpCommand(command, COMMAND_PASV);
+  if (rv == OK && next_state_ == STATE_CTRL_WRITE && ctrl_reused_) {
+    PipelineFtpCommand("SIZE " + GetRequestPathForFtpCommand(false),
+                       COMMAND_SIZE);
+  }
+  return rv;
 }
 
 int FtpNetworkTransaction::ProcessResponsePASV(
@@ -1138,6 +1298,15 @@ int FtpNetworkTransaction::ProcessResponseLIST(
 
 // QUIT command
 int FtpNetworkTransaction::DoCtrlWriteQUIT() {
+  // Rather than log out after a transfer, keep the connection for the next
+  // transaction to the server.
+  if (last_error_ == OK &&
+      (command_sent_ == COMMAND_RETR || command_sent_ == COMMAND_LIST) &&
+      ReleaseCtrlSocket()) {
+    command_sent_ = COMMAND_NONE;
+    return OK;
+  }
+
   std::string command = "QUIT";
   next_state_ = STATE_CTRL_READ;
   return SendFtpCommand(command, COMMAND_QUIT);
@@ -1197,6 +1366,11 @@ int FtpNetworkTransaction::DoDataRead() {
     // to be closed on our side too.
     data_socket_.reset();
 
+    // The control connection has been kept for later transactions after the
+    // server said the transfer was complete.
+    if (!ctrl_socket_.get())
+      return OK;
+
     if (ctrl_socket_->IsConnected()) {
       // Wait for the server's response, we should get it before sending QUIT.
       next_state_ = STATE_CTRL_READ;
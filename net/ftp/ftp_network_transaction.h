@@ -130,6 +130,28 @@ class FtpNetworkTransaction : public FtpTransaction {
 
   int SendFtpCommand(const std::string& command, Command cmd);
 
+  // Sends |command| right after the command being sent, without waiting for
+  // its response.  Once that response leads to sending |cmd|, the response
+  // to |command| is processed instead.
+  void PipelineFtpCommand(const std::string& command, Command cmd);
+
+  // Takes an idle control connection to the server from the session.
+  // Returns false if there is none.
+  bool TakeCtrlSocket();
+
+  // Gives the control connection to the session for the next transaction to
+  // the server instead of closing it.  Returns false if it can't be reused.
+  bool ReleaseCtrlSocket();
+
+  // Returns true if the control connection was taken from the session and
+  // we have not heard from the server on it yet, so an error probably means
+  // the server closed it while it was idle.
+  bool CanRetryWithNewCtrlConnection() const;
+
+  // Drops the control connection taken from the session and starts over
+  // with a new one.
+  int RetryWithNewCtrlConnection();
+
   // Returns request path suitable to be included in an FTP command. If the path
   // will be used as a directory, |is_directory| should be true.
   std::string GetRequestPathForFtpCommand(bool is_directory) const;
@@ -186,6 +208,10 @@ class FtpNetworkTransaction : public FtpTransaction {
 
   Command command_sent_;
 
+  // Command sent right after |command_sent_|, whose response follows, or
+  // COMMAND_NONE.
+  Command pipelined_command_;
+
   CompletionCallbackImpl<FtpNetworkTransaction> io_callback_;
   CompletionCallback* user_callback_;
 
@@ -240,6 +266,16 @@ class FtpNetworkTransaction : public FtpTransaction {
   ClientSocketFactory* socket_factory_;
 
   scoped_ptr<ClientSocket> ctrl_socket_;
+
+  // True if |ctrl_socket_| was taken from the session, already logged in.
+  bool ctrl_reused_;
+
+  // True once a response is read from |ctrl_socket_|.
+  bool ctrl_response_received_;
+
+  // False after a control connection taken from the session failed, so that
+  // we log in on a new one.
+  bool allow_ctrl_reuse_;
   scoped_ptr<ClientSocket> data_socket_;
 
   State next_state_;
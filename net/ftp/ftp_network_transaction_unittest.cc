@@ -347,6 +347,39 @@ class FtpSocketDataProviderFileDownloadWithFileTypecode
   DISALLOW_COPY_AND_ASSIGN(FtpSocketDataProviderFileDownloadWithFileTypecode);
 };
 
+// Serves another download on the control connection kept after the first
+// one, which the client doesn't log in on again.
+class FtpSocketDataProviderFileDownloadReused
+    : public FtpSocketDataProviderFileDownloadWithFileTypecode {
+ public:
+  // The client is expected to send |commands| at once on the connection it
+  // reuses.  The server replies with |response| and goes to |next_state|.
+  FtpSocketDataProviderFileDownloadReused(const char* commands,
+                                          State next_state,
+                                          const char* response)
+      : commands_(commands),
+        next_state_(next_state),
+        response_(response),
+        reused_(false) {
+  }
+
+  virtual MockWriteResult OnWrite(const std::string& data) {
+    if (state() == PRE_QUIT && !reused_) {
+      reused_ = true;
+      return Verify(commands_, data, next_state_, response_);
+    }
+    return FtpSocketDataProviderFileDownloadWithFileTypecode::OnWrite(data);
+  }
+
+ private:
+  const char* commands_;
+  State next_state_;
+  const char* response_;
+  bool reused_;
+
+  DISALLOW_COPY_AND_ASSIGN(FtpSocketDataProviderFileDownloadReused);
+};
+
 class FtpSocketDataProviderFileDownload : public FtpSocketDataProvider {
  public:
   FtpSocketDataProviderFileDownload() {
@@ -746,6 +779,17 @@ class FtpNetworkTransactionTest : public PlatformTest {
   void ExecuteTransaction(FtpSocketDataProvider* ctrl_socket,
                           const char* request,
                           int expected_result) {
+    mock_socket_factory_.AddSocketDataProvider(ctrl_socket);
+    RunTransaction(&transaction_, ctrl_socket, request, expected_result);
+  }
+
+  // Runs |transaction|, which either connects to the socket provided next
+  // by |mock_socket_factory_| or reuses a control connection kept by
+  // |session_|, as |ctrl_socket|.
+  void RunTransaction(FtpNetworkTransaction* transaction,
+                      FtpSocketDataProvider* ctrl_socket,
+                      const char* request,
+                      int expected_result) {
     std::string mock_data("mock-data");
     MockRead data_reads[] = {
       // Usually FTP servers close the data connection after the entire data has
@@ -755,33 +799,40 @@ class FtpNetworkTransactionTest : public PlatformTest {
     };
     StaticSocketDataProvider data_socket(data_reads, arraysize(data_reads),
                                          NULL, 0);
-    mock_socket_factory_.AddSocketDataProvider(ctrl_socket);
     mock_socket_factory_.AddSocketDataProvider(&data_socket);
     FtpRequestInfo request_info = GetRequestInfo(request);
-    EXPECT_EQ(LOAD_STATE_IDLE, transaction_.GetLoadState());
+    EXPECT_EQ(LOAD_STATE_IDLE, transaction->GetLoadState());
     ASSERT_EQ(ERR_IO_PENDING,
-              transaction_.Start(&request_info, &callback_, BoundNetLog()));
-    EXPECT_NE(LOAD_STATE_IDLE, transaction_.GetLoadState());
+              transaction->Start(&request_info, &callback_, BoundNetLog()));
+    EXPECT_NE(LOAD_STATE_IDLE, transaction->GetLoadState());
     ASSERT_EQ(expected_result, callback_.WaitForResult());
     if (expected_result == OK) {
       scoped_refptr<IOBuffer> io_buffer(new IOBuffer(kBufferSize));
       memset(io_buffer->data(), 0, kBufferSize);
       ASSERT_EQ(ERR_IO_PENDING,
-                transaction_.Read(io_buffer.get(), kBufferSize, &callback_));
+                transaction->Read(io_buffer.get(), kBufferSize, &callback_));
       ASSERT_EQ(static_cast<int>(mock_data.length()),
                 callback_.WaitForResult());
       EXPECT_EQ(mock_data, std::string(io_buffer->data(), mock_data.length()));
 
       // Do another Read to detect that the data socket is now closed.
-      int rv = transaction_.Read(io_buffer.get(), kBufferSize, &callback_);
+      int rv = transaction->Read(io_buffer.get(), kBufferSize, &callback_);
       if (rv == ERR_IO_PENDING) {
         EXPECT_EQ(0, callback_.WaitForResult());
       } else {
         EXPECT_EQ(0, rv);
       }
     }
-    EXPECT_EQ(FtpSocketDataProvider::QUIT, ctrl_socket->state());
-    EXPECT_EQ(LOAD_STATE_IDLE, transaction_.GetLoadState());
+    // A control connection is kept for later transactions rather than
+    // closed if the transfer succeeded.
+    if (expected_result == OK) {
+      EXPECT_EQ(FtpSocketDataProvider::PRE_QUIT, ctrl_socket->state());
+      EXPECT_EQ(1u, session_->idle_ctrl_connection_count());
+    } else {
+      EXPECT_EQ(FtpSocketDataProvider::QUIT, ctrl_socket->state());
+      EXPECT_EQ(0u, session_->idle_ctrl_connection_count());
+    }
+    EXPECT_EQ(LOAD_STATE_IDLE, transaction->GetLoadState());
   }
 
   void TransactionFailHelper(FtpSocketDataProvider* ctrl_socket,
@@ -1437,4 +1488,77 @@ TEST_F(FtpNetworkTransactionTest, ZeroLengthDirInPWD) {
                         OK);
 }
 
+TEST_F(FtpNetworkTransactionTest, DownloadTransactionReusesCtrlConnection) {
+  // The client sends SIZE along with EPSV on the reused connection, and
+  // doesn't need to set the data type again.
+  FtpSocketDataProviderFileDownloadReused ctrl_socket(
+      "EPSV\r\nSIZE /file\r\n",
+      FtpSocketDataProvider::PRE_RETR,
+      "227 Entering Extended Passive Mode (|||31744|)\r\n213 18\r\n");
+  ExecuteTransaction(&ctrl_socket, "ftp://host/file;type=i", OK);
+
+  FtpNetworkTransaction transaction(session_.get(), &mock_socket_factory_);
+  RunTransaction(&transaction, &ctrl_socket, "ftp://host/file;type=i", OK);
+  EXPECT_EQ(18, transaction.GetResponseInfo()->expected_content_size);
+  EXPECT_EQ("192.0.2.33",
+            transaction.GetResponseInfo()->socket_address.host());
+}
+
+TEST_F(FtpNetworkTransactionTest, DownloadTransactionReusedCtrlConnectionType) {
+  FtpSocketDataProviderFileDownloadReused ctrl_socket(
+      "TYPE A\r\nEPSV\r\n",
+      FtpSocketDataProvider::PRE_SIZE,
+      "200 TYPE set successfully\r\n"
+      "227 Entering Extended Passive Mode (|||31744|)\r\n");
+  ExecuteTransaction(&ctrl_socket, "ftp://host/file;type=i", OK);
+
+  FtpNetworkTransaction transaction(session_.get(), &mock_socket_factory_);
+  RunTransaction(&transaction, &ctrl_socket, "ftp://host/file;type=a", OK);
+}
+
+TEST_F(FtpNetworkTransactionTest, DownloadTransactionReusedCtrlConnection421) {
+  FtpSocketDataProviderFileDownloadReused ctrl_socket(
+      "EPSV\r\nSIZE /file\r\n",
+      FtpSocketDataProvider::QUIT,
+      "421 Timeout\r\n");
+  ExecuteTransaction(&ctrl_socket, "ftp://host/file;type=i", OK);
+
+  // The client logs in again on a new connection.
+  FtpSocketDataProviderFileDownloadWithFileTypecode new_ctrl_socket;
+  mock_socket_factory_.AddSocketDataProvider(&new_ctrl_socket);
+  FtpNetworkTransaction transaction(session_.get(), &mock_socket_factory_);
+  RunTransaction(&transaction, &new_ctrl_socket, "ftp://host/file;type=i", OK);
+  EXPECT_EQ(FtpSocketDataProvider::QUIT, ctrl_socket.state());
+}
+
+TEST_F(FtpNetworkTransactionTest,
+       DownloadTransactionReusedCtrlConnectionClosed) {
+  FtpSocketDataProviderFileDownloadReused ctrl_socket(
+      "EPSV\r\nSIZE /file\r\n", FtpSocketDataProvider::QUIT, "");
+  ExecuteTransaction(&ctrl_socket, "ftp://host/file;type=i", OK);
+
+  FtpSocketDataProviderFileDownloadWithFileTypecode new_ctrl_socket;
+  mock_socket_factory_.AddSocketDataProvider(&new_ctrl_socket);
+  FtpNetworkTransaction transaction(session_.get(), &mock_socket_factory_);
+  RunTransaction(&transaction, &new_ctrl_socket, "ftp://host/file;type=i", OK);
+  EXPECT_EQ(FtpSocketDataProvider::QUIT, ctrl_socket.state());
+}
+
+TEST_F(FtpNetworkTransactionTest, DownloadTransactionCtrlConnectionNotReused) {
+  // A failed transaction doesn't keep its connection.
+  FtpSocketDataProviderFileNotFound ctrl_socket;
+  ExecuteTransaction(&ctrl_socket, "ftp://host/file", ERR_FTP_FAILED);
+
+  // Neither does one that is told to go away.  As the connection is new,
+  // the error is not retried.
+  FtpSocketDataProviderFileDownload new_ctrl_socket;
+  new_ctrl_socket.InjectFailure(FtpSocketDataProvider::PRE_TYPE,
+                                FtpSocketDataProvider::PRE_QUIT,
+                                "421 Timeout\r\n");
+  mock_socket_factory_.AddSocketDataProvider(&new_ctrl_socket);
+  FtpNetworkTransaction transaction(session_.get(), &mock_socket_factory_);
+  RunTransaction(&transaction, &new_ctrl_socket, "ftp://host/file",
+                 ERR_FTP_SERVICE_UNAVAILABLE);
+}
+
 }  // namespace net
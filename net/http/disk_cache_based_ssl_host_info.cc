@@ -87,7 +87,6 @@ void DiskCacheBasedSSLHostInfo::Persist() {
 }
 
 DiskCacheBasedSSLHostInfo::~DiskCacheBasedSSLHostInfo() {
-  DCHECK(!user_callback_);
   if (entry_)
     entry_->Close();
   if (!IsCallbackPending())
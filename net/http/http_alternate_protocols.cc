@@ -1,12 +1,16 @@
-// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
 #include "net/http/http_alternate_protocols.h"
 
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
 #include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/stringprintf.h"
 #include "base/stl_util-inl.h"
+#include "base/values.h"
 
 namespace net {
 
@@ -38,17 +42,25 @@ std::string HttpAlternateProtocols::PortProtocolPair::ToString() const {
                             HttpAlternateProtocols::ProtocolToString(protocol));
 }
 
+// static
+const size_t HttpAlternateProtocols::kMaxEntries = 500;
+
+// static
+const int HttpAlternateProtocols::kMaxAgeDays = 30;
+
+// static
+const int HttpAlternateProtocols::kMaxBrokenAgeDays = 1;
+
 // static
 HttpAlternateProtocols::PortProtocolPair*
     HttpAlternateProtocols::forced_alternate_protocol_ = NULL;
 
-HttpAlternateProtocols::HttpAlternateProtocols() {}
+HttpAlternateProtocols::HttpAlternateProtocols() : delegate_(NULL) {}
 HttpAlternateProtocols::~HttpAlternateProtocols() {}
 
 bool HttpAlternateProtocols::HasAlternateProtocolFor(
     const HostPortPair& http_host_port_pair) const {
-  return ContainsKey(protocol_map_, http_host_port_pair) ||
-      forced_alternate_protocol_;
+  return FindEntry(http_host_port_pair) || forced_alternate_protocol_;
 }
 
 bool HttpAlternateProtocols::HasAlternateProtocolFor(
@@ -63,9 +75,9 @@ HttpAlternateProtocols::GetAlternateProtocolFor(
   DCHECK(HasAlternateProtocolFor(http_host_port_pair));
 
   // First check the map.
-  ProtocolMap::const_iterator it = protocol_map_.find(http_host_port_pair);
-  if (it != protocol_map_.end())
-    return it->second;
+  const PortProtocolPair* alternate = FindEntry(http_host_port_pair);
+  if (alternate)
+    return *alternate;
 
   // We must be forcing an alternate.
   DCHECK(forced_alternate_protocol_);
@@ -112,11 +124,136 @@ void HttpAlternateProtocols::SetAlternateProtocolFor(
   }
 
   protocol_map_[http_host_port_pair] = alternate;
+  last_updates_[http_host_port_pair] = base::Time::Now();
+  EvictEntries();
+  DirtyNotify();
 }
 
 void HttpAlternateProtocols::MarkBrokenAlternateProtocolFor(
     const HostPortPair& http_host_port_pair) {
   protocol_map_[http_host_port_pair].protocol = BROKEN;
+  last_updates_[http_host_port_pair] = base::Time::Now();
+  EvictEntries();
+  DirtyNotify();
+}
+
+void HttpAlternateProtocols::Serialize(std::string* output) const {
+  const base::Time now = base::Time::Now();
+  ListValue entries;
+  for (ProtocolMap::const_iterator it = protocol_map_.begin();
+       it != protocol_map_.end(); ++it) {
+    UpdateTimeMap::const_iterator last_update = last_updates_.find(it->first);
+    DCHECK(last_update != last_updates_.end());
+    if (IsExpired(it->second, last_update->second, now))
+      continue;
+
+    DictionaryValue* entry = new DictionaryValue;
+    entry->SetString("host", it->first.host());
+    entry->SetInteger("port", it->first.port());
+    entry->SetInteger("alternate_port", it->second.port);
+    entry->SetString("protocol", ProtocolToString(it->second.protocol));
+    entry->SetDouble("last_update", last_update->second.ToDoubleT());
+    entries.Append(entry);
+  }
+
+  base::JSONWriter::Write(&entries, false /* no pretty print */, output);
+}
+
+bool HttpAlternateProtocols::LoadEntries(const std::string& input) {
+  scoped_ptr<Value> value(
+      base::JSONReader::Read(input, false /* do not allow trailing commas */));
+  if (!value.get() || !value->IsType(Value::TYPE_LIST))
+    return false;
+
+  ListValue* entries = static_cast<ListValue*>(value.get());
+  const base::Time now = base::Time::Now();
+  for (size_t i = 0; i < entries->GetSize(); ++i) {
+    DictionaryValue* entry;
+    std::string host;
+    int port;
+    int alternate_port;
+    std::string protocol_string;
+    double last_update;
+    if (!entries->GetDictionary(i, &entry) ||
+        !entry->GetString("host", &host) ||
+        !entry->GetInteger("port", &port) ||
+        !entry->GetInteger("alternate_port", &alternate_port) ||
+        !entry->GetString("protocol", &protocol_string) ||
+        !entry->GetDouble("last_update", &last_update) ||
+        port < 0 || port > kuint16max ||
+        alternate_port < 0 || alternate_port > kuint16max) {
+      continue;
+    }
+
+    // The protocols are saved by name, so that their values can change.
+    PortProtocolPair alternate;
+    alternate.port = static_cast<uint16>(alternate_port);
+    alternate.protocol = UNINITIALIZED;
+    if (protocol_string == ProtocolToString(BROKEN))
+      alternate.protocol = BROKEN;
+    for (int j = 0; j < NUM_ALTERNATE_PROTOCOLS; ++j) {
+      if (protocol_string == kProtocolStrings[j])
+        alternate.protocol = static_cast<Protocol>(j);
+    }
+    if (alternate.protocol == UNINITIALIZED)
+      continue;
+
+    base::Time last_update_time = base::Time::FromDoubleT(last_update);
+    if (IsExpired(alternate, last_update_time, now))
+      continue;
+
+    // What was learned in this session is newer.
+    HostPortPair http_host_port_pair(host, static_cast<uint16>(port));
+    if (FindEntry(http_host_port_pair))
+      continue;
+
+    protocol_map_[http_host_port_pair] = alternate;
+    last_updates_[http_host_port_pair] = last_update_time;
+  }
+
+  EvictEntries();
+  return true;
+}
+
+const HttpAlternateProtocols::PortProtocolPair*
+HttpAlternateProtocols::FindEntry(
+    const HostPortPair& http_host_port_pair) const {
+  ProtocolMap::const_iterator it = protocol_map_.find(http_host_port_pair);
+  if (it == protocol_map_.end())
+    return NULL;
+  UpdateTimeMap::const_iterator last_update =
+      last_updates_.find(http_host_port_pair);
+  DCHECK(last_update != last_updates_.end());
+  if (IsExpired(it->second, last_update->second, base::Time::Now()))
+    return NULL;
+  return &it->second;
+}
+
+// static
+bool HttpAlternateProtocols::IsExpired(const PortProtocolPair& alternate,
+                                       base::Time last_update,
+                                       base::Time now) {
+  int max_age_days =
+      alternate.protocol == BROKEN ? kMaxBrokenAgeDays : kMaxAgeDays;
+  return now - last_update > base::TimeDelta::FromDays(max_age_days);
+}
+
+void HttpAlternateProtocols::EvictEntries() {
+  while (protocol_map_.size() > kMaxEntries) {
+    UpdateTimeMap::iterator oldest = last_updates_.begin();
+    for (UpdateTimeMap::iterator it = last_updates_.begin();
+         it != last_updates_.end(); ++it) {
+      if (it->second < oldest->second)
+        oldest = it;
+    }
+    protocol_map_.erase(oldest->first);
+    last_updates_.erase(oldest);
+  }
+}
+
+void HttpAlternateProtocols::DirtyNotify() {
+  if (delegate_)
+    delegate_->ProtocolsAreDirty(this);
 }
 
 // static
@@ -1,10 +1,17 @@
-// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 //
 // HttpAlternateProtocols is an in-memory data structure used for keeping track
 // of which HTTP HostPortPairs have an alternate protocol that can be used
 // instead of HTTP on a different port.
+//
+// The map can be saved across restarts, so that the first request to a known
+// server can use the alternate protocol right away: a Delegate is told when
+// it changes, and can Serialize() it and LoadEntries() it back later. Only the
+// |kMaxEntries| most recently updated servers are kept. An alternate protocol
+// is forgotten |kMaxAgeDays| after it was last announced, and a broken one is
+// tried again |kMaxBrokenAgeDays| after it was marked broken.
 
 #ifndef NET_HTTP_HTTP_ALTERNATE_PROTOCOLS_H_
 #define NET_HTTP_HTTP_ALTERNATE_PROTOCOLS_H_
@@ -15,12 +22,23 @@
 #include <utility>
 
 #include "base/basictypes.h"
+#include "base/time.h"
 #include "net/base/host_port_pair.h"
 
 namespace net {
 
 class HttpAlternateProtocols {
  public:
+  class Delegate {
+   public:
+    // Called when the map changes.  This must not reenter the
+    // HttpAlternateProtocols.
+    virtual void ProtocolsAreDirty(HttpAlternateProtocols* protocols) = 0;
+
+   protected:
+    virtual ~Delegate() {}
+  };
+
   enum Protocol {
     NPN_SPDY_1,
     NPN_SPDY_2,
@@ -45,9 +63,21 @@ class HttpAlternateProtocols {
   static const char kHeader[];
   static const char* const kProtocolStrings[NUM_ALTERNATE_PROTOCOLS];
 
+  // The maximum number of servers for which an alternate protocol is stored.
+  static const size_t kMaxEntries;
+
+  // The number of days for which an alternate protocol is kept after it was
+  // last announced.
+  static const int kMaxAgeDays;
+
+  // The number of days for which an alternate protocol is known to be broken.
+  static const int kMaxBrokenAgeDays;
+
   HttpAlternateProtocols();
   ~HttpAlternateProtocols();
 
+  void set_delegate(Delegate* delegate) { delegate_ = delegate; }
+
   // Reports whether or not we have received Alternate-Protocol for
   // |http_host_port_pair|.
   bool HasAlternateProtocolFor(const HostPortPair& http_host_port_pair) const;
@@ -65,11 +95,21 @@ class HttpAlternateProtocols {
                                Protocol alternate_protocol);
 
   // Marks the alternate protocol as broken.  Once marked broken, any further
-  // attempts to set the alternate protocol for |http_host_port_pair| will fail.
+  // attempts to set the alternate protocol for |http_host_port_pair| will fail,
+  // until the marking expires.
   void MarkBrokenAlternateProtocolFor(const HostPortPair& http_host_port_pair);
 
+  // Expired entries may still be in the map.
   const ProtocolMap& protocol_map() const { return protocol_map_; }
 
+  // Writes the map to |output|, as JSON.
+  void Serialize(std::string* output) const;
+
+  // Adds the entries serialized in |input| for the servers that have no entry
+  // yet.  Entries that have expired are skipped.  Returns false if |input|
+  // can't be parsed.
+  bool LoadEntries(const std::string& input);
+
   // Debugging to simulate presence of an AlternateProtocol.
   // If we don't have an alternate protocol in the map for any given host/port
   // pair, force this ProtocolPortPair.
@@ -77,8 +117,31 @@ class HttpAlternateProtocols {
   static void DisableForcedAlternateProtocol();
 
  private:
+  typedef std::map<HostPortPair, base::Time> UpdateTimeMap;
+
+  // Returns the entry for |http_host_port_pair|, or NULL if there is none or
+  // it has expired.
+  const PortProtocolPair* FindEntry(
+      const HostPortPair& http_host_port_pair) const;
+
+  // Returns true if |alternate|, last updated at |last_update|, has expired at
+  // |now|.
+  static bool IsExpired(const PortProtocolPair& alternate,
+                        base::Time last_update,
+                        base::Time now);
+
+  // Drops the least recently updated entries beyond |kMaxEntries|.
+  void EvictEntries();
+
+  void DirtyNotify();
+
   ProtocolMap protocol_map_;
 
+  // When each entry of |protocol_map_| was last updated.
+  UpdateTimeMap last_updates_;
+
+  Delegate* delegate_;
+
   static const char* ProtocolToString(Protocol protocol);
 
   // The forced alternate protocol.  If not-null, there is a protocol being
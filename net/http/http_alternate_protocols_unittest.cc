@@ -1,4 +1,4 @@
-// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 //
@@ -7,11 +7,38 @@
 // instead of HTTP on a different port.
 
 #include "net/http/http_alternate_protocols.h"
+
+#include "base/string_number_conversions.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace net {
 namespace {
 
+class CountingDelegate : public HttpAlternateProtocols::Delegate {
+ public:
+  CountingDelegate() : dirty_count_(0) {}
+
+  virtual void ProtocolsAreDirty(HttpAlternateProtocols* protocols) {
+    dirty_count_++;
+  }
+
+  int dirty_count() const { return dirty_count_; }
+
+ private:
+  int dirty_count_;
+};
+
+// Returns a serialized entry for foo:80 with |protocol|, updated |age| ago.
+std::string SerializedEntry(const char* protocol, base::TimeDelta age) {
+  return base::StringPrintf(
+      "[{\"host\":\"foo\",\"port\":80,\"alternate_port\":443,"
+      "\"protocol\":\"%s\",\"last_update\":%s}]",
+      protocol,
+      base::DoubleToString((base::Time::Now() - age).ToDoubleT()).c_str());
+}
+
 TEST(HttpAlternateProtocols, Basic) {
   HttpAlternateProtocols alternate_protocols;
   HostPortPair test_host_port_pair("foo", 80);
@@ -81,5 +108,120 @@ TEST(HttpAlternateProtocols, Forced) {
       alternate_protocols.HasAlternateProtocolFor(test_host_port_pair2));
 }
 
+TEST(HttpAlternateProtocols, NotifiesDelegate) {
+  HttpAlternateProtocols alternate_protocols;
+  CountingDelegate delegate;
+  alternate_protocols.set_delegate(&delegate);
+  HostPortPair test_host_port_pair("foo", 80);
+
+  alternate_protocols.SetAlternateProtocolFor(
+      test_host_port_pair, 443, HttpAlternateProtocols::NPN_SPDY_2);
+  EXPECT_EQ(1, delegate.dirty_count());
+  alternate_protocols.MarkBrokenAlternateProtocolFor(test_host_port_pair);
+  EXPECT_EQ(2, delegate.dirty_count());
+
+  // Loading is not a change worth saving.
+  EXPECT_TRUE(alternate_protocols.LoadEntries(
+      SerializedEntry("npn-spdy/2", base::TimeDelta())));
+  EXPECT_EQ(2, delegate.dirty_count());
+}
+
+TEST(HttpAlternateProtocols, SerializeAndLoad) {
+  HttpAlternateProtocols alternate_protocols;
+  HostPortPair test_host_port_pair("foo", 80);
+  HostPortPair broken_host_port_pair("bar", 80);
+  alternate_protocols.SetAlternateProtocolFor(
+      test_host_port_pair, 443, HttpAlternateProtocols::NPN_SPDY_2);
+  alternate_protocols.MarkBrokenAlternateProtocolFor(broken_host_port_pair);
+  std::string serialized;
+  alternate_protocols.Serialize(&serialized);
+
+  HttpAlternateProtocols loaded;
+  EXPECT_TRUE(loaded.LoadEntries(serialized));
+  ASSERT_TRUE(loaded.HasAlternateProtocolFor(test_host_port_pair));
+  HttpAlternateProtocols::PortProtocolPair alternate =
+      loaded.GetAlternateProtocolFor(test_host_port_pair);
+  EXPECT_EQ(443, alternate.port);
+  EXPECT_EQ(HttpAlternateProtocols::NPN_SPDY_2, alternate.protocol);
+  ASSERT_TRUE(loaded.HasAlternateProtocolFor(broken_host_port_pair));
+  alternate = loaded.GetAlternateProtocolFor(broken_host_port_pair);
+  EXPECT_EQ(HttpAlternateProtocols::BROKEN, alternate.protocol);
+
+  EXPECT_FALSE(loaded.LoadEntries("not json"));
+}
+
+TEST(HttpAlternateProtocols, LoadSkipsExpiredEntries) {
+  HostPortPair test_host_port_pair("foo", 80);
+  base::TimeDelta max_age =
+      base::TimeDelta::FromDays(HttpAlternateProtocols::kMaxAgeDays);
+  base::TimeDelta max_broken_age =
+      base::TimeDelta::FromDays(HttpAlternateProtocols::kMaxBrokenAgeDays);
+  base::TimeDelta one_hour = base::TimeDelta::FromHours(1);
+
+  HttpAlternateProtocols fresh;
+  EXPECT_TRUE(fresh.LoadEntries(
+      SerializedEntry("npn-spdy/2", max_age - one_hour)));
+  EXPECT_TRUE(fresh.HasAlternateProtocolFor(test_host_port_pair));
+
+  HttpAlternateProtocols expired;
+  EXPECT_TRUE(expired.LoadEntries(
+      SerializedEntry("npn-spdy/2", max_age + one_hour)));
+  EXPECT_FALSE(expired.HasAlternateProtocolFor(test_host_port_pair));
+
+  HttpAlternateProtocols broken;
+  EXPECT_TRUE(broken.LoadEntries(
+      SerializedEntry("Broken", max_broken_age - one_hour)));
+  ASSERT_TRUE(broken.HasAlternateProtocolFor(test_host_port_pair));
+  EXPECT_EQ(HttpAlternateProtocols::BROKEN,
+            broken.GetAlternateProtocolFor(test_host_port_pair).protocol);
+
+  // Once the broken marking expires, the alternate protocol can be set again.
+  HttpAlternateProtocols retry;
+  EXPECT_TRUE(retry.LoadEntries(
+      SerializedEntry("Broken", max_broken_age + one_hour)));
+  EXPECT_FALSE(retry.HasAlternateProtocolFor(test_host_port_pair));
+  retry.SetAlternateProtocolFor(
+      test_host_port_pair, 443, HttpAlternateProtocols::NPN_SPDY_2);
+  ASSERT_TRUE(retry.HasAlternateProtocolFor(test_host_port_pair));
+  EXPECT_EQ(HttpAlternateProtocols::NPN_SPDY_2,
+            retry.GetAlternateProtocolFor(test_host_port_pair).protocol);
+
+  HttpAlternateProtocols unknown;
+  EXPECT_TRUE(unknown.LoadEntries(
+      SerializedEntry("npn-spdy/99", base::TimeDelta())));
+  EXPECT_FALSE(unknown.HasAlternateProtocolFor(test_host_port_pair));
+}
+
+TEST(HttpAlternateProtocols, LoadKeepsNewerEntries) {
+  HttpAlternateProtocols alternate_protocols;
+  HostPortPair test_host_port_pair("foo", 80);
+  alternate_protocols.MarkBrokenAlternateProtocolFor(test_host_port_pair);
+
+  EXPECT_TRUE(alternate_protocols.LoadEntries(
+      SerializedEntry("npn-spdy/2", base::TimeDelta())));
+  EXPECT_EQ(HttpAlternateProtocols::BROKEN,
+            alternate_protocols.GetAlternateProtocolFor(
+                test_host_port_pair).protocol);
+}
+
+TEST(HttpAlternateProtocols, EvictsLeastRecentlyUpdated) {
+  HttpAlternateProtocols alternate_protocols;
+  // Load an old entry first, so that it's the least recently updated one.
+  EXPECT_TRUE(alternate_protocols.LoadEntries(
+      SerializedEntry("npn-spdy/2", base::TimeDelta::FromDays(1))));
+  for (size_t i = 0; i < HttpAlternateProtocols::kMaxEntries; ++i) {
+    alternate_protocols.SetAlternateProtocolFor(
+        HostPortPair(base::StringPrintf("host%d", static_cast<int>(i)), 80),
+        443, HttpAlternateProtocols::NPN_SPDY_2);
+  }
+
+  EXPECT_EQ(HttpAlternateProtocols::kMaxEntries,
+            alternate_protocols.protocol_map().size());
+  EXPECT_FALSE(alternate_protocols.HasAlternateProtocolFor(
+      HostPortPair("foo", 80)));
+  EXPECT_TRUE(alternate_protocols.HasAlternateProtocolFor(
+      HostPortPair("host0", 80)));
+}
+
 }  // namespace
 }  // namespace net
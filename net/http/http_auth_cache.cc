@@ -4,7 +4,11 @@
 
 #include "net/http/http_auth_cache.h"
 
+#include <algorithm>
+#include <map>
+
 #include "base/logging.h"
+#include "base/stl_util-inl.h"
 #include "base/string_util.h"
 
 namespace {
@@ -46,6 +50,21 @@ void CheckOriginIsValid(const GURL& origin) {
   DCHECK(origin.GetOrigin() == origin);
 }
 
+// Splits |dir|, an absolute path that ends with a slash, into the names of
+// its directories.
+// Examples:
+//   "/" --> {}
+//   "/foo/bar/" --> {"foo", "bar"}
+void SplitDirectories(const std::string& dir, std::vector<std::string>* names) {
+  DCHECK(!dir.empty() && dir[0] == '/' && *(dir.end() - 1) == '/');
+  std::string::size_type start = 1;
+  while (start < dir.size()) {
+    std::string::size_type end = dir.find('/', start);
+    names->push_back(dir.substr(start, end - start));
+    start = end + 1;
+  }
+}
+
 // Functor used by remove_if.
 struct IsEnclosedBy {
   explicit IsEnclosedBy(const std::string& path) : path(path) { }
@@ -59,51 +78,98 @@ struct IsEnclosedBy {
 
 namespace net {
 
-HttpAuthCache::HttpAuthCache() {
+// A directory of the protection spaces of an origin. |entries| holds the
+// entries whose protection space starts at this directory.
+struct HttpAuthCache::PathNode {
+  typedef std::map<std::string, PathNode*> ChildMap;
+
+  PathNode() {}
+  ~PathNode() {
+    STLDeleteValues(&children);
+  }
+
+  // Returns the most recently created entry of this node, or NULL.
+  Entry* BestEntry() const {
+    Entry* best = NULL;
+    for (std::vector<Entry*>::const_iterator it = entries.begin();
+         it != entries.end(); ++it) {
+      if (!best || (*it)->id_ > best->id_)
+        best = *it;
+    }
+    return best;
+  }
+
+  std::vector<Entry*> entries;
+  ChildMap children;
+};
+
+struct HttpAuthCache::OriginIndex {
+  // All the entries of the origin.
+  std::vector<Entry*> entries;
+
+  // The entries with an empty path (proxy auth).
+  PathNode no_path;
+
+  // The directory "/".
+  PathNode root;
+};
+
+HttpAuthCache::HttpAuthCache() : next_entry_id_(0) {
 }
 
 HttpAuthCache::~HttpAuthCache() {
+  STLDeleteValues(&origins_);
 }
 
-// Performance: O(n), where n is the number of realm entries.
+// Performance: O(m), where m is the number of realm entries of |origin|.
 HttpAuthCache::Entry* HttpAuthCache::Lookup(const GURL& origin,
                                             const std::string& realm,
                                             HttpAuth::Scheme scheme) {
   CheckOriginIsValid(origin);
 
-  // Linear scan through the realm entries.
-  for (EntryList::iterator it = entries_.begin(); it != entries_.end(); ++it) {
-    if (it->origin() == origin && it->realm() == realm &&
-        it->scheme() == scheme)
-      return &(*it);
+  OriginIndex* index = FindOriginIndex(origin);
+  if (!index)
+    return NULL;
+
+  for (std::vector<Entry*>::iterator it = index->entries.begin();
+       it != index->entries.end(); ++it) {
+    if ((*it)->realm() == realm && (*it)->scheme() == scheme)
+      return *it;
   }
   return NULL;  // No realm entry found.
 }
 
-// Performance: O(n*m), where n is the number of realm entries, m is the number
-// of path entries per realm. Both n amd m are expected to be small; m is
-// kept small because AddPath() only keeps the shallowest entry.
+// Performance: O(d), where d is the number of directories of |path|.
 HttpAuthCache::Entry* HttpAuthCache::LookupByPath(const GURL& origin,
                                                   const std::string& path) {
-  HttpAuthCache::Entry* best_match = NULL;
-  size_t best_match_length = 0;
   CheckOriginIsValid(origin);
   CheckPathIsValid(path);
 
+  OriginIndex* index = FindOriginIndex(origin);
+  if (!index)
+    return NULL;
+
   // RFC 2617 section 2:
   // A client SHOULD assume that all paths at or deeper than the depth of
   // the last symbolic element in the path field of the Request-URI also are
   // within the protection space ...
   std::string parent_dir = GetParentDirectory(path);
-
-  // Linear scan through the realm entries.
-  for (EntryList::iterator it = entries_.begin(); it != entries_.end(); ++it) {
-    size_t len = 0;
-    if (it->origin() == origin && it->HasEnclosingPath(parent_dir, &len) &&
-        (!best_match || len > best_match_length)) {
-      best_match_length = len;
-      best_match = &(*it);
-    }
+  if (parent_dir.empty())
+    return index->no_path.BestEntry();
+
+  // The deepest directory with an entry is the closest enclosing path.
+  std::vector<std::string> names;
+  SplitDirectories(parent_dir, &names);
+  PathNode* node = &index->root;
+  HttpAuthCache::Entry* best_match = node->BestEntry();
+  for (std::vector<std::string>::const_iterator it = names.begin();
+       it != names.end(); ++it) {
+    PathNode::ChildMap::const_iterator child = node->children.find(*it);
+    if (child == node->children.end())
+      break;
+    node = child->second;
+    if (!node->entries.empty())
+      best_match = node->BestEntry();
   }
   return best_match;
 }
@@ -124,7 +190,7 @@ HttpAuthCache::Entry* HttpAuthCache::Add(const GURL& origin,
     // Failsafe to prevent unbounded memory growth of the cache.
     if (entries_.size() >= kMaxNumRealmEntries) {
       LOG(WARNING) << "Num auth cache entries reached limit -- evicting";
-      entries_.pop_back();
+      RemoveEntry(--entries_.end());
     }
 
     entries_.push_front(Entry());
@@ -132,6 +198,12 @@ HttpAuthCache::Entry* HttpAuthCache::Add(const GURL& origin,
     entry->origin_ = origin;
     entry->realm_ = realm;
     entry->scheme_ = scheme;
+    entry->id_ = next_entry_id_++;
+
+    OriginIndex*& index = origins_[origin.spec()];
+    if (!index)
+      index = new OriginIndex;
+    index->entries.push_back(entry);
   }
   DCHECK_EQ(origin, entry->origin_);
   DCHECK_EQ(realm, entry->realm_);
@@ -141,7 +213,13 @@ HttpAuthCache::Entry* HttpAuthCache::Add(const GURL& origin,
   entry->username_ = username;
   entry->password_ = password;
   entry->nonce_count_ = 1;
+
+  // AddPath() may drop other paths of the entry, so the entry is indexed
+  // again from scratch.
+  OriginIndex* index = FindOriginIndex(origin);
+  UnindexPaths(index, entry);
   entry->AddPath(path);
+  IndexPaths(index, entry);
 
   return entry;
 }
@@ -157,7 +235,8 @@ void HttpAuthCache::Entry::UpdateStaleChallenge(
 
 HttpAuthCache::Entry::Entry()
     : scheme_(HttpAuth::AUTH_SCHEME_MAX),
-      nonce_count_(0) {
+      nonce_count_(0),
+      id_(0) {
 }
 
 void HttpAuthCache::Entry::AddPath(const std::string& path) {
@@ -201,16 +280,19 @@ bool HttpAuthCache::Remove(const GURL& origin,
                            HttpAuth::Scheme scheme,
                            const string16& username,
                            const string16& password) {
+  Entry* entry = Lookup(origin, realm, scheme);
+  if (!entry || username != entry->username() ||
+      password != entry->password()) {
+    return false;
+  }
+
   for (EntryList::iterator it = entries_.begin(); it != entries_.end(); ++it) {
-    if (it->origin() == origin && it->realm() == realm &&
-        it->scheme() == scheme) {
-      if (username == it->username() && password == it->password()) {
-        entries_.erase(it);
-        return true;
-      }
-      return false;
+    if (&(*it) == entry) {
+      RemoveEntry(it);
+      return true;
     }
   }
+  NOTREACHED();
   return false;
 }
 
@@ -225,4 +307,78 @@ bool HttpAuthCache::UpdateStaleChallenge(const GURL& origin,
   return true;
 }
 
+HttpAuthCache::OriginIndex* HttpAuthCache::FindOriginIndex(
+    const GURL& origin) const {
+  OriginMap::const_iterator it = origins_.find(origin.spec());
+  return it == origins_.end() ? NULL : it->second;
+}
+
+void HttpAuthCache::IndexPaths(OriginIndex* index, Entry* entry) {
+  for (Entry::PathList::const_iterator it = entry->paths_.begin();
+       it != entry->paths_.end(); ++it) {
+    PathNode* node = &index->no_path;
+    if (!it->empty()) {
+      std::vector<std::string> names;
+      SplitDirectories(*it, &names);
+      node = &index->root;
+      for (size_t i = 0; i < names.size(); ++i) {
+        PathNode*& child = node->children[names[i]];
+        if (!child)
+          child = new PathNode;
+        node = child;
+      }
+    }
+    node->entries.push_back(entry);
+  }
+}
+
+void HttpAuthCache::UnindexPaths(OriginIndex* index, Entry* entry) {
+  for (Entry::PathList::const_iterator it = entry->paths_.begin();
+       it != entry->paths_.end(); ++it) {
+    // Keep track of the directories that lead to the path, so that the ones
+    // left empty can be deleted.
+    std::vector<PathNode*> parents;
+    std::vector<std::string> names;
+    PathNode* node = &index->no_path;
+    if (!it->empty()) {
+      SplitDirectories(*it, &names);
+      node = &index->root;
+      for (size_t i = 0; i < names.size(); ++i) {
+        parents.push_back(node);
+        node = node->children[names[i]];
+        DCHECK(node);
+      }
+    }
+
+    std::vector<Entry*>::iterator entry_it =
+        std::find(node->entries.begin(), node->entries.end(), entry);
+    DCHECK(entry_it != node->entries.end());
+    node->entries.erase(entry_it);
+
+    while (!parents.empty() && node->entries.empty() &&
+           node->children.empty()) {
+      parents.back()->children.erase(names[parents.size() - 1]);
+      delete node;
+      node = parents.back();
+      parents.pop_back();
+    }
+  }
+}
+
+void HttpAuthCache::RemoveEntry(EntryList::iterator it) {
+  Entry* entry = &(*it);
+  OriginMap::iterator origin_it = origins_.find(entry->origin().spec());
+  DCHECK(origin_it != origins_.end());
+  OriginIndex* index = origin_it->second;
+
+  UnindexPaths(index, entry);
+  index->entries.erase(
+      std::find(index->entries.begin(), index->entries.end(), entry));
+  if (index->entries.empty()) {
+    delete index;
+    origins_.erase(origin_it);
+  }
+  entries_.erase(it);
+}
+
 }  // namespace net
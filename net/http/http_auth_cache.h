@@ -8,8 +8,10 @@
 
 #include <list>
 #include <string>
+#include <vector>
 
 #include "base/gtest_prod_util.h"
+#include "base/hash_tables.h"
 #include "base/memory/ref_counted.h"
 #include "base/string16.h"
 #include "googleurl/src/gurl.h"
@@ -25,14 +27,16 @@ namespace net {
 //   - the last auth handler used (contains realm and authentication scheme)
 //   - the list of paths which used this realm
 // Entries can be looked up by either (origin, realm, scheme) or (origin, path).
+// Both lookups go through a per-origin index; the paths of an origin are kept
+// in a trie of directory names, so that the closest enclosing path is found by
+// walking down the directories of the requested path.
 class HttpAuthCache {
  public:
   class Entry;
 
   // Prevent unbounded memory growth. These are safeguards for abuse; it is
   // not expected that the limits will be reached in ordinary usage.
-  // This also defines the worst-case lookup times (which grow linearly
-  // with number of elements in the cache).
+  // This also bounds the work done to keep the lookup indices up to date.
   enum { kMaxNumPathsPerRealmEntry = 10 };
   enum { kMaxNumRealmEntries = 10 };
 
@@ -103,8 +107,33 @@ class HttpAuthCache {
                             const std::string& auth_challenge);
 
  private:
+  struct PathNode;
+  struct OriginIndex;
+
   typedef std::list<Entry> EntryList;
+  typedef base::hash_map<std::string, OriginIndex*> OriginMap;
+
+  // Returns the index of the entries for |origin|, or NULL if there is none.
+  OriginIndex* FindOriginIndex(const GURL& origin) const;
+
+  // Adds (or removes) the protection space of |entry| to the path trie of
+  // |index|.
+  void IndexPaths(OriginIndex* index, Entry* entry);
+  void UnindexPaths(OriginIndex* index, Entry* entry);
+
+  // Removes the entry at |it| from the cache.
+  void RemoveEntry(EntryList::iterator it);
+
+  // Entries, from the most recently created.
   EntryList entries_;
+
+  // Index of |entries_| by the spec of their origin.
+  OriginMap origins_;
+
+  // Identifies the next entry that is created.
+  int next_entry_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(HttpAuthCache);
 };
 
 // An authentication realm entry.
@@ -182,6 +211,10 @@ class HttpAuthCache::Entry {
 
   int nonce_count_;
 
+  // Increases with every entry added to the cache. When several entries have
+  // the same enclosing path, the most recently created one is used.
+  int id_;
+
   // List of paths that define the realm's protection space.
   PathList paths_;
 };
@@ -368,6 +368,45 @@ TEST(HttpAuthCacheTest, Remove) {
   EXPECT_FALSE(NULL == entry);
 }
 
+// Test that LookupByPath() finds the closest enclosing path among several
+// realms, and that removed entries are no longer found.
+TEST(HttpAuthCacheTest, LookupByPathNestedRealms) {
+  GURL origin("http://foobar3.com");
+  HttpAuthCache cache;
+  cache.Add(origin, kRealm1, HttpAuth::AUTH_SCHEME_BASIC, "basic realm=Realm1",
+            kAlice, k123, "/a/index.html");
+  cache.Add(origin, kRealm2, HttpAuth::AUTH_SCHEME_BASIC, "basic realm=Realm2",
+            kAdmin, kPassword, "/a/b/c/index.html");
+  cache.Add(origin, kRealm3, HttpAuth::AUTH_SCHEME_BASIC, "basic realm=Realm3",
+            kRoot, kWileCoyote, "/a/bc/index.html");
+
+  HttpAuthCache::Entry* realm1_entry =
+      cache.Lookup(origin, kRealm1, HttpAuth::AUTH_SCHEME_BASIC);
+  HttpAuthCache::Entry* realm2_entry =
+      cache.Lookup(origin, kRealm2, HttpAuth::AUTH_SCHEME_BASIC);
+  HttpAuthCache::Entry* realm3_entry =
+      cache.Lookup(origin, kRealm3, HttpAuth::AUTH_SCHEME_BASIC);
+  ASSERT_TRUE(realm1_entry && realm2_entry && realm3_entry);
+
+  EXPECT_TRUE(NULL == cache.LookupByPath(origin, "/index.html"));
+  EXPECT_TRUE(realm1_entry == cache.LookupByPath(origin, "/a/"));
+  EXPECT_TRUE(realm1_entry == cache.LookupByPath(origin, "/a/b/index.html"));
+  EXPECT_TRUE(realm2_entry == cache.LookupByPath(origin, "/a/b/c/d/e.html"));
+  EXPECT_TRUE(realm3_entry == cache.LookupByPath(origin, "/a/bc/"));
+  EXPECT_TRUE(realm1_entry == cache.LookupByPath(origin, "/a/bcd/"));
+  EXPECT_TRUE(NULL ==
+              cache.LookupByPath(GURL("http://foobar4.com"), "/a/b/c/"));
+
+  EXPECT_TRUE(cache.Remove(
+      origin, kRealm2, HttpAuth::AUTH_SCHEME_BASIC, kAdmin, kPassword));
+  EXPECT_TRUE(realm1_entry == cache.LookupByPath(origin, "/a/b/c/d/e.html"));
+
+  EXPECT_TRUE(cache.Remove(
+      origin, kRealm1, HttpAuth::AUTH_SCHEME_BASIC, kAlice, k123));
+  EXPECT_TRUE(NULL == cache.LookupByPath(origin, "/a/b/c/d/e.html"));
+  EXPECT_TRUE(realm3_entry == cache.LookupByPath(origin, "/a/bc/"));
+}
+
 TEST(HttpAuthCacheTest, UpdateStaleChallenge) {
   HttpAuthCache cache;
   GURL origin("http://foobar2.com");
@@ -6,6 +6,7 @@
 
 #include "base/stringprintf.h"
 #include "net/base/io_buffer.h"
+#include "net/base/load_timing_info.h"
 #include "net/base/net_errors.h"
 #include "net/http/http_request_headers.h"
 #include "net/http/http_request_info.h"
@@ -102,6 +103,17 @@ void HttpBasicStream::SetConnectionReused() {
   parser_->SetConnectionReused();
 }
 
+void HttpBasicStream::GetLoadTimingInfo(
+    LoadTimingInfo* load_timing_info) const {
+  load_timing_info->socket_reused = connection_->is_reused();
+  load_timing_info->connect_timing = load_timing_info->socket_reused ?
+      LoadTimingInfo::ConnectTiming() : connection_->connect_timing();
+  if (parser_.get()) {
+    load_timing_info->receive_headers_start =
+        parser_->first_response_byte_time();
+  }
+}
+
 bool HttpBasicStream::IsConnectionReusable() const {
   return parser_->IsConnectionReusable();
 }
@@ -115,6 +127,10 @@ void HttpBasicStream::GetSSLCertRequestInfo(
   parser_->GetSSLCertRequestInfo(cert_request_info);
 }
 
+void HttpBasicStream::SetPriority(RequestPriority priority) {
+  // Nothing to do: the connection is not shared with other streams.
+}
+
 bool HttpBasicStream::IsSpdyHttpStream() const {
   return false;
 }
@@ -74,10 +74,14 @@ class HttpBasicStream : public HttpStream {
 
   virtual bool IsConnectionReusable() const OVERRIDE;
 
+  virtual void GetLoadTimingInfo(
+      LoadTimingInfo* load_timing_info) const OVERRIDE;
+
   virtual void GetSSLInfo(SSLInfo* ssl_info) OVERRIDE;
 
   virtual void GetSSLCertRequestInfo(
       SSLCertRequestInfo* cert_request_info) OVERRIDE;
+  virtual void SetPriority(RequestPriority priority) OVERRIDE;
 
   virtual bool IsSpdyHttpStream() const OVERRIDE;
 
@@ -24,6 +24,7 @@
 #include "net/base/io_buffer.h"
 #include "net/base/load_flags.h"
 #include "net/base/net_errors.h"
+#include "net/base/net_log.h"
 #include "net/disk_cache/disk_cache.h"
 #include "net/http/disk_cache_based_ssl_host_info.h"
 #include "net/http/http_cache_transaction.h"
@@ -34,6 +35,7 @@
 #include "net/http/http_response_info.h"
 #include "net/http/http_util.h"
 #include "net/socket/ssl_host_info.h"
+#include "net/spdy/spdy_session_pool.h"
 
 namespace net {
 
@@ -97,7 +99,8 @@ HttpCache::ActiveEntry::ActiveEntry(disk_cache::Entry* entry)
     : disk_entry(entry),
       writer(NULL),
       will_process_pending_queue(false),
-      doomed(false) {
+      doomed(false),
+      streaming(false) {
 }
 
 HttpCache::ActiveEntry::~ActiveEntry() {
@@ -290,6 +293,124 @@ void HttpCache::MetadataWriter::OnIOComplete(int result) {
 
 //-----------------------------------------------------------------------------
 
+// This class runs |request| in the background to update the cache: it
+// validates a stored response after it was used stale, or stores a response
+// pushed by a SPDY server. The body (if any) is read and dropped, so that the
+// transaction updates or replaces the cache entry.
+class HttpCache::AsyncValidation {
+ public:
+  AsyncValidation(HttpCache* cache, const std::string& key,
+                  const HttpRequestInfo& request, const BoundNetLog& net_log)
+      : cache_(cache),
+        key_(key),
+        request_info_(request),
+        read_buf_(new IOBuffer(kBufferSize)),
+        started_(false),
+        net_log_(BoundNetLog::Make(net_log.net_log(),
+                                   NetLog::SOURCE_HTTP_CACHE_ASYNC_VALIDATION)),
+        ALLOW_THIS_IN_INITIALIZER_LIST(
+            callback_(this, &AsyncValidation::OnIOComplete)) {
+    request_info_.priority = LOWEST;
+  }
+
+  ~AsyncValidation() {
+    if (transaction_.get())
+      net_log_.EndEventWithNetErrorCode(
+          NetLog::TYPE_HTTP_CACHE_ASYNC_VALIDATION, ERR_ABORTED);
+  }
+
+  const std::string& key() const { return key_; }
+  const BoundNetLog& net_log() const { return net_log_; }
+
+  void Start();
+
+ private:
+  enum { kBufferSize = 32 * 1024 };
+
+  // Reads the response body until it is done.
+  void ReadBody();
+  void Done(int result);
+  void OnIOComplete(int result);
+
+  HttpCache* cache_;
+  std::string key_;
+  HttpRequestInfo request_info_;
+  scoped_ptr<HttpCache::Transaction> transaction_;
+  scoped_refptr<IOBuffer> read_buf_;
+  bool started_;
+  BoundNetLog net_log_;
+  CompletionCallbackImpl<AsyncValidation> callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncValidation);
+};
+
+void HttpCache::AsyncValidation::Start() {
+  net_log_.BeginEvent(
+      NetLog::TYPE_HTTP_CACHE_ASYNC_VALIDATION,
+      make_scoped_refptr(new NetLogStringParameter(
+          "url", request_info_.url.possibly_invalid_spec())));
+
+  transaction_.reset(new HttpCache::Transaction(cache_));
+  int rv = transaction_->Start(&request_info_, &callback_, net_log_);
+  if (rv != ERR_IO_PENDING)
+    OnIOComplete(rv);
+}
+
+void HttpCache::AsyncValidation::ReadBody() {
+  for (;;) {
+    int rv = transaction_->Read(read_buf_, kBufferSize, &callback_);
+    if (rv == ERR_IO_PENDING)
+      return;
+    if (rv <= 0)
+      return Done(rv);
+  }
+}
+
+void HttpCache::AsyncValidation::Done(int result) {
+  net_log_.EndEventWithNetErrorCode(NetLog::TYPE_HTTP_CACHE_ASYNC_VALIDATION,
+                                    result);
+  transaction_.reset();
+  cache_->OnAsyncValidationComplete(this);
+}
+
+void HttpCache::AsyncValidation::OnIOComplete(int result) {
+  if (result < 0 || (started_ && !result))
+    return Done(result);
+
+  started_ = true;
+  ReadBody();
+}
+
+//-----------------------------------------------------------------------------
+
+class HttpCache::PushedStreamAdopter : public SpdySessionPool::PushObserver {
+ public:
+  PushedStreamAdopter(HttpCache* http_cache, SpdySessionPool* spdy_session_pool)
+      : http_cache_(http_cache),
+        spdy_session_pool_(spdy_session_pool) {
+    spdy_session_pool_->AddPushObserver(this);
+  }
+
+  virtual ~PushedStreamAdopter() {
+    spdy_session_pool_->RemovePushObserver(this);
+  }
+
+  // SpdySessionPool::PushObserver methods:
+  virtual bool OnPushedStream(const GURL& url,
+                              const HttpResponseInfo& response,
+                              const BoundNetLog& session_net_log) {
+    return http_cache_->OnPushedStream(url, response, session_net_log);
+  }
+
+ private:
+  HttpCache* const http_cache_;
+  SpdySessionPool* const spdy_session_pool_;
+
+  DISALLOW_COPY_AND_ASSIGN(PushedStreamAdopter);
+};
+
+//-----------------------------------------------------------------------------
+
 class HttpCache::SSLHostInfoFactoryAdaptor : public SSLHostInfoFactory {
  public:
   SSLHostInfoFactoryAdaptor(CertVerifier* cert_verifier, HttpCache* http_cache)
@@ -323,6 +444,7 @@ HttpCache::HttpCache(HostResolver* host_resolver,
       backend_factory_(backend_factory),
       building_backend_(false),
       mode_(NORMAL),
+      compress_bodies_(false),
       ssl_host_info_factory_(new SSLHostInfoFactoryAdaptor(
           cert_verifier,
           ALLOW_THIS_IN_INITIALIZER_LIST(this))),
@@ -340,6 +462,8 @@ HttpCache::HttpCache(HostResolver* host_resolver,
                   network_delegate,
                   net_log))),
       ALLOW_THIS_IN_INITIALIZER_LIST(task_factory_(this)) {
+  pushed_stream_adopter_.reset(
+      new PushedStreamAdopter(this, GetSession()->spdy_session_pool()));
 }
 
 
@@ -349,11 +473,14 @@ HttpCache::HttpCache(HttpNetworkSession* session,
       backend_factory_(backend_factory),
       building_backend_(false),
       mode_(NORMAL),
+      compress_bodies_(false),
       ssl_host_info_factory_(new SSLHostInfoFactoryAdaptor(
           session->cert_verifier(),
           ALLOW_THIS_IN_INITIALIZER_LIST(this))),
       network_layer_(new HttpNetworkLayer(session)),
       ALLOW_THIS_IN_INITIALIZER_LIST(task_factory_(this)) {
+  pushed_stream_adopter_.reset(
+      new PushedStreamAdopter(this, session->spdy_session_pool()));
 }
 
 HttpCache::HttpCache(HttpTransactionFactory* network_layer,
@@ -363,11 +490,17 @@ HttpCache::HttpCache(HttpTransactionFactory* network_layer,
       backend_factory_(backend_factory),
       building_backend_(false),
       mode_(NORMAL),
+      compress_bodies_(false),
       network_layer_(network_layer),
       ALLOW_THIS_IN_INITIALIZER_LIST(task_factory_(this)) {
 }
 
 HttpCache::~HttpCache() {
+  pushed_stream_adopter_.reset();
+
+  // The background validations use the network layer and the active entries.
+  STLDeleteValues(&async_validations_);
+
   // If we have any active entries remaining, then we need to deactivate them.
   // We may have some pending calls to OnProcessPendingQueue, but since those
   // won't run (due to our destruction), we can simply ignore the corresponding
@@ -793,12 +926,19 @@ int HttpCache::AddTransactionToEntry(ActiveEntry* entry, Transaction* trans) {
   // We implement a basic reader/writer lock for the disk cache entry.  If
   // there is already a writer, then everyone has to wait for the writer to
   // finish before they can access the cache entry.  There can be multiple
-  // readers.
+  // readers.  The exception is a writer that is storing the body of a new
+  // response: transactions that can use that response read the body while it
+  // is being written.
   //
   // NOTE: If the transaction can only write, then the entry should not be in
   // use (since any existing entry should have already been doomed).
 
   if (entry->writer || entry->will_process_pending_queue) {
+    if (entry->streaming &&
+        trans->JoinWriter(*entry->writer->GetResponseInfo(), false)) {
+      entry->readers.push_back(trans);
+      return OK;
+    }
     entry->pending_queue.push_back(trans);
     return ERR_IO_PENDING;
   }
@@ -832,8 +972,10 @@ void HttpCache::DoneWithEntry(ActiveEntry* entry, Transaction* trans,
   if (entry->will_process_pending_queue && entry->readers.empty())
     return;
 
-  if (entry->writer) {
-    DCHECK(trans == entry->writer);
+  if (entry->writer == trans) {
+    // The readers sharing the response will not get the rest of it.
+    if (entry->streaming)
+      StopStreaming(entry, ERR_CACHE_READ_FAILURE);
 
     // Assume there was a failure.
     bool success = false;
@@ -850,7 +992,8 @@ void HttpCache::DoneWithEntry(ActiveEntry* entry, Transaction* trans,
 }
 
 void HttpCache::DoneWritingToEntry(ActiveEntry* entry, bool success) {
-  DCHECK(entry->readers.empty());
+  if (entry->streaming)
+    StopStreaming(entry, success ? OK : ERR_CACHE_READ_FAILURE);
 
   entry->writer = NULL;
 
@@ -863,8 +1006,15 @@ void HttpCache::DoneWritingToEntry(ActiveEntry* entry, bool success) {
     TransactionList pending_queue;
     pending_queue.swap(entry->pending_queue);
 
-    entry->disk_entry->Doom();
-    DestroyEntry(entry);
+    if (entry->readers.empty()) {
+      entry->disk_entry->Doom();
+      DestroyEntry(entry);
+    } else if (!entry->doomed) {
+      // The readers that were sharing the response are still using the entry,
+      // so it will be destroyed when they are done.
+      int rv = DoomEntry(entry->disk_entry->GetKey(), NULL);
+      DCHECK_EQ(OK, rv);
+    }
 
     // We need to do something about these pending entries, which now need to
     // be added to a new entry.
@@ -877,7 +1027,7 @@ void HttpCache::DoneWritingToEntry(ActiveEntry* entry, bool success) {
 }
 
 void HttpCache::DoneReadingFromEntry(ActiveEntry* entry, Transaction* trans) {
-  DCHECK(!entry->writer);
+  DCHECK(!entry->writer || entry->streaming);
 
   TransactionList::iterator it =
       std::find(entry->readers.begin(), entry->readers.end(), trans);
@@ -885,7 +1035,9 @@ void HttpCache::DoneReadingFromEntry(ActiveEntry* entry, Transaction* trans) {
 
   entry->readers.erase(it);
 
-  ProcessPendingQueue(entry);
+  // The pending transactions are still waiting for the writer.
+  if (!entry->writer)
+    ProcessPendingQueue(entry);
 }
 
 void HttpCache::ConvertWriterToReader(ActiveEntry* entry) {
@@ -901,6 +1053,47 @@ void HttpCache::ConvertWriterToReader(ActiveEntry* entry) {
   ProcessPendingQueue(entry);
 }
 
+void HttpCache::StartStreaming(ActiveEntry* entry) {
+  DCHECK(entry->writer);
+  DCHECK(!entry->streaming);
+  entry->streaming = true;
+
+  // Let the pending transactions that can use the new response go ahead.
+  const HttpResponseInfo* response = entry->writer->GetResponseInfo();
+  TransactionList::iterator it = entry->pending_queue.begin();
+  while (it != entry->pending_queue.end()) {
+    Transaction* trans = *it;
+    if (!trans->JoinWriter(*response, true)) {
+      ++it;
+      continue;
+    }
+    it = entry->pending_queue.erase(it);
+    entry->readers.push_back(trans);
+    trans->OnWriterProgress(ERR_IO_PENDING);
+  }
+}
+
+void HttpCache::DataWrittenToEntry(ActiveEntry* entry) {
+  DCHECK(entry->writer);
+  if (!entry->streaming)
+    return;
+
+  for (TransactionList::iterator it = entry->readers.begin();
+       it != entry->readers.end(); ++it) {
+    (*it)->OnWriterProgress(ERR_IO_PENDING);
+  }
+}
+
+void HttpCache::StopStreaming(ActiveEntry* entry, int result) {
+  DCHECK(entry->streaming);
+  entry->streaming = false;
+
+  for (TransactionList::iterator it = entry->readers.begin();
+       it != entry->readers.end(); ++it) {
+    (*it)->OnWriterProgress(result);
+  }
+}
+
 LoadState HttpCache::GetLoadStateForPendingTransaction(
       const Transaction* trans) {
   ActiveEntriesMap::const_iterator i = active_entries_.find(trans->key());
@@ -952,8 +1145,16 @@ bool HttpCache::RemovePendingTransactionFromEntry(ActiveEntry* entry,
 
   TransactionList::iterator j =
       find(pending_queue.begin(), pending_queue.end(), trans);
-  if (j == pending_queue.end())
-    return false;
+  if (j == pending_queue.end()) {
+    // The transaction may have joined the writer of the entry without running
+    // yet.
+    if (find(entry->readers.begin(), entry->readers.end(), trans) ==
+        entry->readers.end()) {
+      return false;
+    }
+    DoneReadingFromEntry(entry, trans);
+    return true;
+  }
 
   pending_queue.erase(j);
   return true;
@@ -993,6 +1194,85 @@ void HttpCache::ProcessPendingQueue(ActiveEntry* entry) {
                                       entry));
 }
 
+void HttpCache::StartAsyncValidation(const HttpRequestInfo& request,
+                                     const BoundNetLog& net_log) {
+  std::string key = GenerateCacheKey(&request);
+  AsyncValidation*& validation = async_validations_[key];
+  bool start = !validation;
+  if (start) {
+    HttpRequestInfo validation_request(request);
+    validation_request.load_flags &= ~LOAD_PREFERRING_CACHE;
+    validation_request.load_flags |= LOAD_VALIDATE_CACHE;
+    validation = new AsyncValidation(this, key, validation_request, net_log);
+  }
+
+  net_log.AddEvent(
+      NetLog::TYPE_HTTP_CACHE_STALE_WHILE_REVALIDATE,
+      make_scoped_refptr(new NetLogSourceParameter(
+          "source_dependency", validation->net_log().source())));
+
+  // The validation may be done (and gone) as soon as it starts.
+  if (start)
+    validation->Start();
+}
+
+void HttpCache::OnAsyncValidationComplete(AsyncValidation* validation) {
+  async_validations_.erase(validation->key());
+  delete validation;
+}
+
+bool HttpCache::OnPushedStream(const GURL& url,
+                               const HttpResponseInfo& response,
+                               const BoundNetLog& session_net_log) {
+  if (mode_ != NORMAL || !response.headers)
+    return false;
+
+  // The stored response would be used for any later GET of |url|, so leave
+  // the stream alone unless it is a plain cacheable response.
+  if (response.headers->response_code() != 200 ||
+      response.headers->HasHeaderValue("cache-control", "no-store")) {
+    return false;
+  }
+
+  // The SPDY session is in the middle of processing the push.
+  MessageLoop::current()->PostTask(
+      FROM_HERE,
+      task_factory_.NewRunnableMethod(&HttpCache::AdoptPushedStream, url,
+                                      session_net_log));
+  return true;
+}
+
+void HttpCache::AdoptPushedStream(const GURL& url,
+                                  const BoundNetLog& session_net_log) {
+  // A stored response, fresh or not, is left in place: going to the network
+  // for it would send a real request if the push was claimed meanwhile.
+  // Otherwise the request finds the pushed stream on the SPDY session.
+  HttpRequestInfo request;
+  request.url = url;
+  request.method = "GET";
+  request.load_flags = LOAD_PREFERRING_CACHE;
+
+  std::string key = GenerateCacheKey(&request);
+  if (ContainsKey(async_validations_, key))
+    return;
+
+  // Do lazy initialization of disk cache if needed.
+  if (!disk_cache_.get())
+    CreateBackend(NULL, NULL);  // We don't care about the result.
+
+  AsyncValidation* validation =
+      new AsyncValidation(this, key, request, session_net_log);
+  async_validations_[key] = validation;
+
+  session_net_log.AddEvent(
+      NetLog::TYPE_HTTP_CACHE_ADOPT_PUSHED_STREAM,
+      make_scoped_refptr(new NetLogSourceParameter(
+          "source_dependency", validation->net_log().source())));
+
+  // The adoption may be done (and gone) as soon as it starts.
+  validation->Start();
+}
+
 void HttpCache::OnProcessPendingQueue(ActiveEntry* entry) {
   entry->will_process_pending_queue = false;
   DCHECK(!entry->writer);
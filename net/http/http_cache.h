@@ -42,6 +42,7 @@ class Entry;
 
 namespace net {
 
+class BoundNetLog;
 class CertVerifier;
 class DnsCertProvenanceChecker;
 class DnsRRResolver;
@@ -174,6 +175,12 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
   void set_mode(Mode value) { mode_ = value; }
   Mode mode() { return mode_; }
 
+  // Enables storing the body of compressible responses (text that was not
+  // compressed by the server) compressed on the disk cache. Existing entries
+  // remain readable regardless of this setting.
+  void set_compress_bodies(bool value) { compress_bodies_ = value; }
+  bool compress_bodies() const { return compress_bodies_; }
+
   // Close currently active sockets so that fresh page loads will not use any
   // recycled connections.  For sockets currently in use, they may not close
   // immediately, but they will not be reusable. This is for debugging.
@@ -203,11 +210,15 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
  private:
   // Types --------------------------------------------------------------------
 
+  class AsyncValidation;
   class BackendCallback;
   class MetadataWriter;
+  class PushedStreamAdopter;
   class SSLHostInfoFactoryAdaptor;
   class Transaction;
   class WorkItem;
+  friend class AsyncValidation;
+  friend class PushedStreamAdopter;
   friend class Transaction;
   struct PendingOp;  // Info for an entry under construction.
 
@@ -224,12 +235,16 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
     TransactionList    pending_queue;
     bool               will_process_pending_queue;
     bool               doomed;
+    // True while |writer| is storing the body of a response that |readers| are
+    // reading at the same time.
+    bool               streaming;
   };
 
   typedef base::hash_map<std::string, ActiveEntry*> ActiveEntriesMap;
   typedef base::hash_map<std::string, PendingOp*> PendingOpsMap;
   typedef std::set<ActiveEntry*> ActiveEntriesSet;
   typedef base::hash_map<std::string, int> PlaybackCacheMap;
+  typedef base::hash_map<std::string, AsyncValidation*> AsyncValidationMap;
 
   // Methods ------------------------------------------------------------------
 
@@ -319,6 +334,17 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
   // transactions can start reading from this entry.
   void ConvertWriterToReader(ActiveEntry* entry);
 
+  // Called by the writer of |entry| once the response headers are stored, to
+  // let other transactions read the response body while it is being written.
+  void StartStreaming(ActiveEntry* entry);
+
+  // Called by the writer of |entry| after storing more data.
+  void DataWrittenToEntry(ActiveEntry* entry);
+
+  // Tells the readers of |entry| that the writer is done with the entry.
+  // |result| is OK if the whole response was stored, or an error code.
+  void StopStreaming(ActiveEntry* entry, int result);
+
   // Returns the LoadState of the provided pending transaction.
   LoadState GetLoadStateForPendingTransaction(const Transaction* trans);
 
@@ -337,10 +363,28 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
   // Resumes processing the pending list of |entry|.
   void ProcessPendingQueue(ActiveEntry* entry);
 
+  // Starts validating the stored response for |request| in the background,
+  // unless that is already in progress. The validation is logged as a
+  // dependency of |net_log|.
+  void StartAsyncValidation(const HttpRequestInfo& request,
+                            const BoundNetLog& net_log);
+
+  // Called when |validation| is done.
+  void OnAsyncValidationComplete(AsyncValidation* validation);
+
+  // Called when a SPDY server pushes |response| for |url|. Returns true if the
+  // response is going to be stored.
+  bool OnPushedStream(const GURL& url, const HttpResponseInfo& response,
+                      const BoundNetLog& session_net_log);
+
   // Events (called via PostTask) ---------------------------------------------
 
   void OnProcessPendingQueue(ActiveEntry* entry);
 
+  // Claims the pushed stream for |url| with a background request, which
+  // stores the response.
+  void AdoptPushedStream(const GURL& url, const BoundNetLog& session_net_log);
+
   // Callbacks ----------------------------------------------------------------
 
   // Processes BackendCallback notifications.
@@ -359,12 +403,16 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
   bool building_backend_;
 
   Mode mode_;
+  bool compress_bodies_;
 
   const scoped_ptr<SSLHostInfoFactoryAdaptor> ssl_host_info_factory_;
 
   const scoped_ptr<HttpTransactionFactory> network_layer_;
   scoped_ptr<disk_cache::Backend> disk_cache_;
 
+  // Receives the streams pushed on the SPDY sessions of |network_layer_|.
+  scoped_ptr<PushedStreamAdopter> pushed_stream_adopter_;
+
   // The set of active entries indexed by cache key.
   ActiveEntriesMap active_entries_;
 
@@ -378,6 +426,10 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
 
   scoped_ptr<PlaybackCacheMap> playback_cache_map_;
 
+  // The background validations (and pushed stream adoptions) in progress,
+  // indexed by cache key.
+  AsyncValidationMap async_validations_;
+
   DISALLOW_COPY_AND_ASSIGN(HttpCache);
 };
 
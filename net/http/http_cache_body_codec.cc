@@ -0,0 +1,129 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_cache_body_codec.h"
+
+#if defined(USE_SYSTEM_ZLIB)
+#include <zlib.h>
+#else
+#include "third_party/zlib/zlib.h"
+#endif
+
+#include "base/logging.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+
+namespace {
+
+// The stored data is a raw deflate stream; there is no need for a header.
+const int kWindowBits = -MAX_WBITS;
+
+// Room for the marker that ends each flushed block.
+const int kFlushMarkerSize = 16;
+
+}  // namespace
+
+namespace net {
+
+HttpCacheBodyEncoder::HttpCacheBodyEncoder() {
+}
+
+HttpCacheBodyEncoder::~HttpCacheBodyEncoder() {
+  if (zlib_stream_.get())
+    deflateEnd(zlib_stream_.get());
+}
+
+bool HttpCacheBodyEncoder::Init() {
+  DCHECK(!zlib_stream_.get());
+  zlib_stream_.reset(new z_stream);
+  memset(zlib_stream_.get(), 0, sizeof(z_stream));
+
+  // The fastest compression level: this runs for every byte that we store.
+  if (deflateInit2(zlib_stream_.get(), Z_BEST_SPEED, Z_DEFLATED, kWindowBits,
+                   8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    zlib_stream_.reset();
+    return false;
+  }
+  return true;
+}
+
+bool HttpCacheBodyEncoder::Compress(const char* data, int data_len,
+                                    scoped_refptr<IOBuffer>* output,
+                                    int* output_len) {
+  DCHECK(zlib_stream_.get());
+  DCHECK_GT(data_len, 0);
+
+  int buf_len = static_cast<int>(deflateBound(zlib_stream_.get(), data_len)) +
+                kFlushMarkerSize;
+  scoped_refptr<IOBuffer> buf(new IOBuffer(buf_len));
+
+  z_stream* stream = zlib_stream_.get();
+  stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  stream->avail_in = data_len;
+  stream->next_out = reinterpret_cast<Bytef*>(buf->data());
+  stream->avail_out = buf_len;
+
+  int rv = deflate(stream, Z_SYNC_FLUSH);
+  if (rv != Z_OK || stream->avail_in || !stream->avail_out) {
+    // We don't know if all the output was generated.
+    DLOG(ERROR) << "Unable to compress the response body: " << rv;
+    return false;
+  }
+
+  *output = buf;
+  *output_len = buf_len - static_cast<int>(stream->avail_out);
+  return true;
+}
+
+HttpCacheBodyDecoder::HttpCacheBodyDecoder() : output_full_(false) {
+}
+
+HttpCacheBodyDecoder::~HttpCacheBodyDecoder() {
+  if (zlib_stream_.get())
+    inflateEnd(zlib_stream_.get());
+}
+
+bool HttpCacheBodyDecoder::Init() {
+  DCHECK(!zlib_stream_.get());
+  zlib_stream_.reset(new z_stream);
+  memset(zlib_stream_.get(), 0, sizeof(z_stream));
+
+  if (inflateInit2(zlib_stream_.get(), kWindowBits) != Z_OK) {
+    zlib_stream_.reset();
+    return false;
+  }
+  return true;
+}
+
+bool HttpCacheBodyDecoder::HasPendingData() const {
+  return zlib_stream_->avail_in || output_full_;
+}
+
+void HttpCacheBodyDecoder::SetInput(IOBuffer* data, int data_len) {
+  DCHECK(!HasPendingData());
+  input_ = data;
+  zlib_stream_->next_in = reinterpret_cast<Bytef*>(data->data());
+  zlib_stream_->avail_in = data_len;
+}
+
+int HttpCacheBodyDecoder::Decompress(IOBuffer* buf, int buf_len) {
+  DCHECK_GT(buf_len, 0);
+  z_stream* stream = zlib_stream_.get();
+  stream->next_out = reinterpret_cast<Bytef*>(buf->data());
+  stream->avail_out = buf_len;
+
+  int rv = inflate(stream, Z_SYNC_FLUSH);
+  // Z_BUF_ERROR only means that there was nothing to do.
+  if (rv != Z_OK && rv != Z_STREAM_END && rv != Z_BUF_ERROR) {
+    DLOG(ERROR) << "Unable to decompress the stored body: " << rv;
+    return ERR_CACHE_READ_FAILURE;
+  }
+
+  output_full_ = !stream->avail_out;
+  if (!stream->avail_in)
+    input_ = NULL;
+  return buf_len - static_cast<int>(stream->avail_out);
+}
+
+}  // namespace net
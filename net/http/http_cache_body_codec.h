@@ -0,0 +1,74 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_HTTP_HTTP_CACHE_BODY_CODEC_H_
+#define NET_HTTP_HTTP_CACHE_BODY_CODEC_H_
+#pragma once
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+
+typedef struct z_stream_s z_stream;
+
+namespace net {
+
+class IOBuffer;
+
+// Compresses the body of a response as it is written to the cache. The output
+// of every Compress() call is flushed, so a reader can decompress everything
+// stored so far while the entry is still being written.
+class HttpCacheBodyEncoder {
+ public:
+  HttpCacheBodyEncoder();
+  ~HttpCacheBodyEncoder();
+
+  // Returns false if the compressor cannot be initialized.
+  bool Init();
+
+  // Compresses |data_len| bytes of |data|. On success, |output| receives a new
+  // buffer and |output_len| the number of bytes stored on it.
+  bool Compress(const char* data, int data_len,
+                scoped_refptr<IOBuffer>* output, int* output_len);
+
+ private:
+  scoped_ptr<z_stream> zlib_stream_;
+
+  DISALLOW_COPY_AND_ASSIGN(HttpCacheBodyEncoder);
+};
+
+// Decompresses a body stored by HttpCacheBodyEncoder, in pieces of any size.
+class HttpCacheBodyDecoder {
+ public:
+  HttpCacheBodyDecoder();
+  ~HttpCacheBodyDecoder();
+
+  // Returns false if the decompressor cannot be initialized.
+  bool Init();
+
+  // Returns true if there is still data to decompress from the last input.
+  bool HasPendingData() const;
+
+  // Sets the next |data_len| bytes of compressed data. The previous input must
+  // be fully decompressed.
+  void SetInput(IOBuffer* data, int data_len);
+
+  // Decompresses up to |buf_len| bytes into |buf|. Returns the number of bytes
+  // decompressed (zero if more input is needed), or ERR_CACHE_READ_FAILURE.
+  int Decompress(IOBuffer* buf, int buf_len);
+
+ private:
+  scoped_ptr<z_stream> zlib_stream_;
+  scoped_refptr<IOBuffer> input_;
+
+  // True if the last call to Decompress() filled the output buffer, so there
+  // may be more output available without new input.
+  bool output_full_;
+
+  DISALLOW_COPY_AND_ASSIGN(HttpCacheBodyDecoder);
+};
+
+}  // namespace net
+
+#endif  // NET_HTTP_HTTP_CACHE_BODY_CODEC_H_
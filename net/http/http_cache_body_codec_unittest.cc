@@ -0,0 +1,101 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_cache_body_codec.h"
+
+#include <string>
+
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// Decompresses all of |stored| using an output buffer of |buf_len| bytes.
+std::string Decompress(const std::string& stored, int buf_len) {
+  HttpCacheBodyDecoder decoder;
+  EXPECT_TRUE(decoder.Init());
+
+  scoped_refptr<IOBuffer> input(new IOBuffer(stored.size()));
+  memcpy(input->data(), stored.data(), stored.size());
+  decoder.SetInput(input, stored.size());
+
+  std::string result;
+  scoped_refptr<IOBuffer> buf(new IOBuffer(buf_len));
+  while (decoder.HasPendingData()) {
+    int rv = decoder.Decompress(buf, buf_len);
+    EXPECT_GE(rv, 0);
+    if (rv <= 0)
+      break;
+    result.append(buf->data(), rv);
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(HttpCacheBodyCodecTest, RoundTrip) {
+  std::string body;
+  for (int i = 0; i < 100; i++)
+    body.append("{\"key\": \"value\", \"number\": 12345}\n");
+
+  HttpCacheBodyEncoder encoder;
+  ASSERT_TRUE(encoder.Init());
+
+  // Compress the body in a few pieces.
+  std::string stored;
+  const int kPieceSize = 1000;
+  for (size_t i = 0; i < body.size(); i += kPieceSize) {
+    std::string piece = body.substr(i, kPieceSize);
+    scoped_refptr<IOBuffer> output;
+    int output_len = 0;
+    ASSERT_TRUE(encoder.Compress(piece.data(), piece.size(), &output,
+                                 &output_len));
+    stored.append(output->data(), output_len);
+  }
+  EXPECT_LT(stored.size(), body.size() / 4);
+
+  EXPECT_EQ(body, Decompress(stored, 4096));
+  EXPECT_EQ(body, Decompress(stored, 7));
+}
+
+// Each piece can be decompressed as soon as it is written.
+TEST(HttpCacheBodyCodecTest, Incremental) {
+  HttpCacheBodyEncoder encoder;
+  ASSERT_TRUE(encoder.Init());
+  HttpCacheBodyDecoder decoder;
+  ASSERT_TRUE(decoder.Init());
+
+  const char* pieces[] = { "Hello, ", "world", "!" };
+  scoped_refptr<IOBuffer> buf(new IOBuffer(100));
+  for (size_t i = 0; i < arraysize(pieces); i++) {
+    scoped_refptr<IOBuffer> output;
+    int output_len = 0;
+    ASSERT_TRUE(encoder.Compress(pieces[i], strlen(pieces[i]), &output,
+                                 &output_len));
+
+    EXPECT_FALSE(decoder.HasPendingData());
+    decoder.SetInput(output, output_len);
+    int rv = decoder.Decompress(buf, 100);
+    ASSERT_EQ(static_cast<int>(strlen(pieces[i])), rv);
+    EXPECT_EQ(pieces[i], std::string(buf->data(), rv));
+  }
+}
+
+TEST(HttpCacheBodyCodecTest, CorruptData) {
+  HttpCacheBodyDecoder decoder;
+  ASSERT_TRUE(decoder.Init());
+
+  const char kData[] = "\xff\xff\xff\xff not a deflate stream";
+  scoped_refptr<IOBuffer> input(new IOBuffer(arraysize(kData)));
+  memcpy(input->data(), kData, arraysize(kData));
+  decoder.SetInput(input, arraysize(kData));
+
+  scoped_refptr<IOBuffer> buf(new IOBuffer(100));
+  EXPECT_EQ(ERR_CACHE_READ_FAILURE, decoder.Decompress(buf, 100));
+}
+
+}  // namespace net
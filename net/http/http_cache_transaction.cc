@@ -28,6 +28,7 @@
 #include "net/base/ssl_config_service.h"
 #include "net/disk_cache/disk_cache.h"
 #include "net/http/disk_cache_based_ssl_host_info.h"
+#include "net/http/http_cache_body_codec.h"
 #include "net/http/http_network_session.h"
 #include "net/http/http_request_info.h"
 #include "net/http/http_response_headers.h"
@@ -78,6 +79,31 @@ static const HeaderNameAndValue kForceValidateHeaders[] = {
   { NULL, NULL }
 };
 
+// Responses of these types are stored compressed (when enabled), in addition
+// to all text/ types.
+static const char* const kCompressibleMimeTypes[] = {
+  "application/javascript",
+  "application/json",
+  "application/x-javascript",
+  "application/xhtml+xml",
+  "application/xml",
+  "image/svg+xml",
+};
+
+// Smaller bodies are not worth compressing.
+static const int64 kMinCompressedBodySize = 256;
+
+static bool IsCompressibleMimeType(const std::string& mime_type) {
+  if (StartsWithASCII(mime_type, "text/", true))
+    return true;
+
+  for (size_t i = 0; i < arraysize(kCompressibleMimeTypes); i++) {
+    if (mime_type == kCompressibleMimeTypes[i])
+      return true;
+  }
+  return false;
+}
+
 static bool HeaderMatches(const HttpRequestHeaders& headers,
                           const HeaderNameAndValue* search) {
   for (; search->name; ++search) {
@@ -116,9 +142,13 @@ HttpCache::Transaction::Transaction(HttpCache* cache)
       is_sparse_(false),
       server_responded_206_(false),
       cache_pending_(false),
+      joined_writer_(false),
+      waiting_for_writer_(false),
+      writer_error_(OK),
       read_offset_(0),
       effective_load_flags_(0),
       write_len_(0),
+      compressed_len_(0),
       final_upload_progress_(0),
       ALLOW_THIS_IN_INITIALIZER_LIST(
           io_callback_(this, &Transaction::OnIOComplete)),
@@ -127,7 +157,8 @@ HttpCache::Transaction::Transaction(HttpCache* cache)
               this, &Transaction::OnIOComplete))),
       ALLOW_THIS_IN_INITIALIZER_LIST(
           write_headers_callback_(new CancelableCompletionCallback<Transaction>(
-              this, &Transaction::OnIOComplete))) {
+              this, &Transaction::OnIOComplete))),
+      ALLOW_THIS_IN_INITIALIZER_LIST(task_factory_(this)) {
   COMPILE_ASSERT(HttpCache::Transaction::kNumValidationHeaders ==
                  arraysize(kValidationHeaders),
                  Invalid_number_of_validation_headers);
@@ -198,6 +229,43 @@ bool HttpCache::Transaction::AddTruncatedFlag() {
   return true;
 }
 
+bool HttpCache::Transaction::JoinWriter(const HttpResponseInfo& response,
+                                        bool pending) {
+  if ((mode_ != READ && mode_ != READ_WRITE) || partial_.get() ||
+      !response.headers || response.headers->response_code() != 200) {
+    return false;
+  }
+
+  if (mode_ == READ_WRITE && !(effective_load_flags_ & LOAD_PREFERRING_CACHE) &&
+      RequiresValidation(response)) {
+    return false;
+  }
+
+  mode_ = READ;
+  joined_writer_ = true;
+  waiting_for_writer_ = pending;
+  net_log_.AddEvent(NetLog::TYPE_HTTP_CACHE_JOIN_WRITER, NULL);
+  return true;
+}
+
+void HttpCache::Transaction::OnWriterProgress(int result) {
+  DCHECK(joined_writer_);
+  if (result != ERR_IO_PENDING) {
+    joined_writer_ = false;
+    writer_error_ = result;
+  }
+
+  if (!waiting_for_writer_)
+    return;
+
+  // The writer may be in the middle of its own IO, so resume from a new task.
+  waiting_for_writer_ = false;
+  MessageLoop::current()->PostTask(
+      FROM_HERE,
+      task_factory_.NewRunnableMethod(
+          &Transaction::OnWriterProgressComplete));
+}
+
 LoadState HttpCache::Transaction::GetWriterLoadState() const {
   if (network_trans_.get())
     return network_trans_->GetLoadState();
@@ -385,6 +453,18 @@ uint64 HttpCache::Transaction::GetUploadProgress() const {
   return final_upload_progress_;
 }
 
+void HttpCache::Transaction::GetLoadTimingInfo(
+    LoadTimingInfo* load_timing_info) const {
+  *load_timing_info = load_timing_info_;
+  if (network_trans_.get())
+    network_trans_->GetLoadTimingInfo(load_timing_info);
+}
+
+void HttpCache::Transaction::SetPriority(RequestPriority priority) {
+  if (network_trans_.get())
+    network_trans_->SetPriority(priority);
+}
+
 //-----------------------------------------------------------------------------
 
 void HttpCache::Transaction::DoCallback(int rv) {
@@ -626,6 +706,7 @@ int HttpCache::Transaction::DoGetBackendComplete(int result) {
 int HttpCache::Transaction::DoSendRequest() {
   DCHECK(mode_ & WRITE || mode_ == NONE);
   DCHECK(!network_trans_.get());
+  RecordCacheLookupEnd();
 
   // Create a network transaction.
   int rv = cache_->network_layer_->CreateTransaction(&network_trans_);
@@ -678,7 +759,7 @@ int HttpCache::Transaction::DoSuccessfulSendRequest() {
     // hapenning if the user cancels the authentication before we receive
     // the new response.
     response_ = HttpResponseInfo();
-    network_trans_.reset();
+    ResetNetworkTransaction();
     new_response_ = NULL;
     next_state_ = STATE_SEND_REQUEST;
     return OK;
@@ -736,6 +817,9 @@ int HttpCache::Transaction::DoInitEntry() {
   if (!cache_)
     return ERR_UNEXPECTED;
 
+  if (load_timing_info_.cache_start.is_null())
+    load_timing_info_.cache_start = base::TimeTicks::Now();
+
   if (mode_ == WRITE) {
     next_state_ = STATE_DOOM_ENTRY;
     return OK;
@@ -895,6 +979,15 @@ int HttpCache::Transaction::DoAddToEntryComplete(int result) {
     // We have to read the headers from the cached entry.
     DCHECK(mode_ & READ_META);
     next_state_ = STATE_CACHE_READ_RESPONSE;
+
+    // If we are sharing a response that is still being written, wait for the
+    // first part of the body. Until we return the headers we can still go to
+    // the network if the writer fails.
+    if (joined_writer_ &&
+        !entry_->disk_entry->GetDataSize(kResponseContentIndex)) {
+      waiting_for_writer_ = true;
+      return ERR_IO_PENDING;
+    }
   }
   return OK;
 }
@@ -1027,13 +1120,13 @@ int HttpCache::Transaction::DoUpdateCachedResponseComplete(int result) {
     }
     // We no longer need the network transaction, so destroy it.
     final_upload_progress_ = network_trans_->GetUploadProgress();
-    network_trans_.reset();
+    ResetNetworkTransaction();
   } else if (entry_ && server_responded_206_ && truncated_ &&
              partial_->initial_validation()) {
     // We just finished the validation of a truncated entry, and the server
     // is willing to resume the operation. Now we go back and start serving
     // the first part to the user.
-    network_trans_.reset();
+    ResetNetworkTransaction();
     new_response_ = NULL;
     next_state_ = STATE_START_PARTIAL_CACHE_VALIDATION;
     partial_->SetRangeToStartDownload();
@@ -1064,6 +1157,14 @@ int HttpCache::Transaction::DoOverwriteCachedResponse() {
     return OK;
   }
 
+  if (ShouldCompressBody()) {
+    body_encoder_.reset(new HttpCacheBodyEncoder());
+    if (body_encoder_->Init())
+      response_.body_stored_compressed = true;
+    else
+      body_encoder_.reset();
+  }
+
   target_state_ = STATE_TRUNCATE_CACHED_DATA;
   next_state_ = truncated_ ? STATE_CACHE_WRITE_TRUNCATED_RESPONSE :
                              STATE_CACHE_WRITE_RESPONSE;
@@ -1116,8 +1217,13 @@ int HttpCache::Transaction::DoTruncateCachedMetadataComplete(int result) {
 
   // If this response is a redirect, then we can stop writing now.  (We don't
   // need to cache the response body of a redirect.)
-  if (response_.headers->IsRedirect(NULL))
+  if (response_.headers->IsRedirect(NULL)) {
     DoneWritingToEntry(true);
+  } else if (entry_ && mode_ == WRITE && !partial_.get() && !truncated_ &&
+             response_.headers->response_code() == 200) {
+    // Other requests for this resource can read the body while we write it.
+    cache_->StartStreaming(entry_);
+  }
   next_state_ = STATE_PARTIAL_HEADERS_RECEIVED;
   return OK;
 }
@@ -1169,6 +1275,7 @@ int HttpCache::Transaction::DoCacheReadResponseComplete(int result) {
     return ERR_CACHE_READ_FAILURE;
   }
 
+  RecordCacheLookupEnd();
   next_state_ = STATE_NOTIFY_BEFORE_SEND_HEADERS;
   return OK;
 }
@@ -1260,6 +1367,26 @@ int HttpCache::Transaction::DoCacheReadData() {
                                cache_callback_);
   }
 
+  if (response_.body_stored_compressed) {
+    if (!body_decoder_.get()) {
+      body_decoder_.reset(new HttpCacheBodyDecoder());
+      if (!body_decoder_->Init())
+        return ERR_CACHE_READ_FAILURE;
+    }
+
+    // There may be enough data left from the last read.
+    if (body_decoder_->HasPendingData()) {
+      int rv = body_decoder_->Decompress(read_buf_, io_buf_len_);
+      if (rv)
+        return rv;
+    }
+
+    compressed_buf_ = new IOBuffer(io_buf_len_);
+    return entry_->disk_entry->ReadData(kResponseContentIndex, read_offset_,
+                                        compressed_buf_, io_buf_len_,
+                                        cache_callback_);
+  }
+
   return entry_->disk_entry->ReadData(kResponseContentIndex, read_offset_,
                                       read_buf_, io_buf_len_, cache_callback_);
 }
@@ -1277,8 +1404,34 @@ int HttpCache::Transaction::DoCacheReadDataComplete(int result) {
   if (partial_.get())
     return DoPartialCacheReadCompleted(result);
 
+  if (compressed_buf_) {
+    scoped_refptr<IOBuffer> buf;
+    buf.swap(compressed_buf_);
+    if (result > 0) {
+      read_offset_ += result;
+      body_decoder_->SetInput(buf, result);
+      result = body_decoder_->Decompress(read_buf_, io_buf_len_);
+      if (!result) {
+        // Keep reading until there is something to return.
+        next_state_ = STATE_CACHE_READ_DATA;
+        return OK;
+      }
+      return result;
+    }
+  }
+
   if (result > 0) {
-    read_offset_ += result;
+    // |read_offset_| is the offset of the stored data, not of the body.
+    if (!body_decoder_.get())
+      read_offset_ += result;
+  } else if (result == 0 && joined_writer_) {
+    // The writer has not stored the rest of the response yet.
+    waiting_for_writer_ = true;
+    next_state_ = STATE_CACHE_READ_DATA;
+    return ERR_IO_PENDING;
+  } else if (result == 0 && writer_error_ != OK) {
+    // We have all the data that we are going to get.
+    result = writer_error_;
   } else if (result == 0) {  // End of file.
     cache_->DoneReadingFromEntry(entry_, this);
     entry_ = NULL;
@@ -1289,10 +1442,21 @@ int HttpCache::Transaction::DoCacheReadDataComplete(int result) {
 int HttpCache::Transaction::DoCacheWriteData(int num_bytes) {
   next_state_ = STATE_CACHE_WRITE_DATA_COMPLETE;
   write_len_ = num_bytes;
+  compressed_len_ = num_bytes;
   if (net_log_.IsLoggingAllEvents() && entry_)
     net_log_.BeginEvent(NetLog::TYPE_HTTP_CACHE_WRITE_DATA, NULL);
   cache_callback_->AddRef();  // Balanced in DoCacheWriteDataComplete.
 
+  if (body_encoder_.get() && entry_ && num_bytes > 0) {
+    scoped_refptr<IOBuffer> compressed;
+    if (!body_encoder_->Compress(read_buf_->data(), num_bytes, &compressed,
+                                 &compressed_len_)) {
+      return ERR_CACHE_WRITE_FAILURE;
+    }
+    return AppendResponseDataToEntry(compressed, compressed_len_,
+                                     cache_callback_);
+  }
+
   return AppendResponseDataToEntry(read_buf_, num_bytes, cache_callback_);
 }
 
@@ -1306,15 +1470,15 @@ int HttpCache::Transaction::DoCacheWriteDataComplete(int result) {
   if (!cache_)
     return ERR_UNEXPECTED;
 
-  if (result != write_len_) {
+  if (result != compressed_len_) {
     DLOG(ERROR) << "failed to write response data to cache";
     DoneWritingToEntry(false);
-
-    // We want to ignore errors writing to disk and just keep reading from
-    // the network.
-    result = write_len_;
   }
 
+  // We want to ignore errors writing to disk and just keep reading from
+  // the network.
+  result = write_len_;
+
   if (partial_.get()) {
     // This may be the last request.
     if (!(result == 0 && !truncated_ &&
@@ -1322,8 +1486,11 @@ int HttpCache::Transaction::DoCacheWriteDataComplete(int result) {
       return DoPartialNetworkReadCompleted(result);
   }
 
-  if (result == 0)  // End of file.
+  if (result == 0) {  // End of file.
     DoneWritingToEntry(true);
+  } else if (entry_) {
+    cache_->DataWrittenToEntry(entry_);
+  }
 
   return result;
 }
@@ -1480,7 +1647,7 @@ int HttpCache::Transaction::BeginCacheValidation() {
   DCHECK(mode_ == READ_WRITE);
 
   bool skip_validation = effective_load_flags_ & LOAD_PREFERRING_CACHE ||
-                         !RequiresValidation();
+                         !RequiresValidation(response_);
 
   if (truncated_)
     skip_validation = !partial_->initial_validation();
@@ -1488,6 +1655,12 @@ int HttpCache::Transaction::BeginCacheValidation() {
   if ((partial_.get() && !partial_->IsCurrentRangeCached()) || invalid_range_)
     skip_validation = false;
 
+  if (!skip_validation && CanUseWhileRevalidating()) {
+    // Return the stored response now, and refresh it in the background.
+    cache_->StartAsyncValidation(*request_, net_log_);
+    skip_validation = true;
+  }
+
   if (skip_validation) {
     if (partial_.get()) {
       // We are going to return the saved response headers to the caller, so
@@ -1543,7 +1716,9 @@ int HttpCache::Transaction::ValidateEntryHeadersAndContinue(
     bool byte_range_requested) {
   DCHECK(mode_ == READ_WRITE);
 
-  if (!partial_->UpdateFromStoredHeaders(response_.headers, entry_->disk_entry,
+  // Ranges cannot be read from a compressed body.
+  if (response_.body_stored_compressed ||
+      !partial_->UpdateFromStoredHeaders(response_.headers, entry_->disk_entry,
                                          truncated_)) {
     // The stored data cannot be used. Get rid of it and restart this request.
     // We need to also reset the |truncated_| flag as a new entry is created.
@@ -1631,7 +1806,8 @@ int HttpCache::Transaction::RestartNetworkRequestWithAuth(
   return rv;
 }
 
-bool HttpCache::Transaction::RequiresValidation() {
+bool HttpCache::Transaction::RequiresValidation(
+    const HttpResponseInfo& response) {
   // TODO(darin): need to do more work here:
   //  - make sure we have a matching request method
   //  - watch out for cached responses that depend on authentication
@@ -1642,18 +1818,35 @@ bool HttpCache::Transaction::RequiresValidation() {
   if (effective_load_flags_ & LOAD_VALIDATE_CACHE)
     return true;
 
-  if (response_.headers->RequiresValidation(
-          response_.request_time, response_.response_time, Time::Now()))
+  if (response.headers->RequiresValidation(
+          response.request_time, response.response_time, Time::Now()))
     return true;
 
   // Since Vary header computation is fairly expensive, we save it for last.
-  if (response_.vary_data.is_valid() &&
-      !response_.vary_data.MatchesRequest(*request_, *response_.headers))
+  if (response.vary_data.is_valid() &&
+      !response.vary_data.MatchesRequest(*request_, *response.headers))
     return true;
 
   return false;
 }
 
+bool HttpCache::Transaction::CanUseWhileRevalidating() {
+  if (partial_.get() || truncated_ || invalid_range_)
+    return false;
+
+  if (cache_->mode() != NORMAL || request_->method != "GET" ||
+      effective_load_flags_ & LOAD_VALIDATE_CACHE) {
+    return false;
+  }
+
+  if (response_.vary_data.is_valid() &&
+      !response_.vary_data.MatchesRequest(*request_, *response_.headers))
+    return false;
+
+  return response_.headers->IsUsableWhileRevalidating(
+      response_.request_time, response_.response_time, Time::Now());
+}
+
 bool HttpCache::Transaction::ConditionalizeRequest() {
   DCHECK(response_.headers);
 
@@ -1952,7 +2145,7 @@ int HttpCache::Transaction::DoPartialNetworkReadCompleted(int result) {
 
   if (result == 0) {
     // We need to move on to the next range.
-    network_trans_.reset();
+    ResetNetworkTransaction();
     next_state_ = STATE_START_PARTIAL_CACHE_VALIDATION;
   }
   return result;
@@ -1986,6 +2179,10 @@ bool HttpCache::Transaction::CanResume(bool has_data) {
   if (has_data && !entry_->disk_entry->GetDataSize(kResponseContentIndex))
     return false;
 
+  // The stored size doesn't tell how much of a compressed body we have.
+  if (response_.body_stored_compressed)
+    return false;
+
   if (request_->method != "GET")
     return false;
 
@@ -1997,8 +2194,64 @@ bool HttpCache::Transaction::CanResume(bool has_data) {
   return true;
 }
 
+bool HttpCache::Transaction::ShouldCompressBody() const {
+  if (!cache_ || !cache_->compress_bodies() || !entry_ || partial_.get() ||
+      truncated_ || response_.headers->response_code() != 200) {
+    return false;
+  }
+
+  // Don't compress what the server already encoded.
+  if (response_.headers->HasHeader("Content-Encoding"))
+    return false;
+
+  int64 content_length = response_.headers->GetContentLength();
+  if (content_length >= 0 && content_length < kMinCompressedBodySize)
+    return false;
+
+  std::string mime_type;
+  return response_.headers->GetMimeType(&mime_type) &&
+         IsCompressibleMimeType(mime_type);
+}
+
 void HttpCache::Transaction::OnIOComplete(int result) {
   DoLoop(result);
 }
 
+void HttpCache::Transaction::RecordCacheLookupEnd() {
+  if (!load_timing_info_.cache_start.is_null() &&
+      load_timing_info_.cache_end.is_null()) {
+    load_timing_info_.cache_end = base::TimeTicks::Now();
+  }
+}
+
+void HttpCache::Transaction::ResetNetworkTransaction() {
+  network_trans_->GetLoadTimingInfo(&load_timing_info_);
+  network_trans_.reset();
+}
+
+void HttpCache::Transaction::OnWriterProgressComplete() {
+  int result = OK;
+  if (writer_error_ != OK) {
+    // If the writer failed before we returned anything to the caller, we can
+    // start over with a new entry.
+    ActiveEntry* entry = NULL;
+    if (next_state_ == STATE_ADD_TO_ENTRY_COMPLETE) {
+      entry = new_entry_;
+      result = ERR_CACHE_RACE;
+    } else if (next_state_ == STATE_CACHE_READ_RESPONSE) {
+      entry = entry_;
+      entry_ = NULL;
+      next_state_ = STATE_INIT_ENTRY;
+    }
+
+    if (entry) {
+      cache_->DoneReadingFromEntry(entry, this);
+      writer_error_ = OK;
+      mode_ = (effective_load_flags_ & LOAD_ONLY_FROM_CACHE) ? READ :
+                                                                READ_WRITE;
+    }
+  }
+  DoLoop(result);
+}
+
 }  // namespace net
@@ -12,7 +12,9 @@
 #include <string>
 
 #include "base/string16.h"
+#include "base/task.h"
 #include "base/time.h"
+#include "net/base/load_timing_info.h"
 #include "net/base/net_log.h"
 #include "net/http/http_cache.h"
 #include "net/http/http_response_info.h"
@@ -20,6 +22,8 @@
 
 namespace net {
 
+class HttpCacheBodyDecoder;
+class HttpCacheBodyEncoder;
 class HttpResponseHeaders;
 class PartialData;
 struct HttpRequestInfo;
@@ -92,6 +96,18 @@ class HttpCache::Transaction : public HttpTransaction {
   // to the cache entry.
   LoadState GetWriterLoadState() const;
 
+  // Returns true if this transaction can use |response|, the response that the
+  // writer of the entry is still storing, without validating it. In that case
+  // the transaction switches to READ mode and reads the body as it is written.
+  // |pending| is true if the transaction is waiting in the pending queue of the
+  // entry, so it has to be resumed by the next call to OnWriterProgress().
+  bool JoinWriter(const HttpResponseInfo& response, bool pending);
+
+  // Called when the writer of the entry that this transaction joined stores
+  // more data (|result| is ERR_IO_PENDING), or stops writing (|result| is OK
+  // if the whole response was stored, or an error code otherwise).
+  void OnWriterProgress(int result);
+
   CompletionCallback* io_callback() { return &io_callback_; }
 
   const BoundNetLog& net_log() const;
@@ -111,6 +127,8 @@ class HttpCache::Transaction : public HttpTransaction {
   virtual const HttpResponseInfo* GetResponseInfo() const;
   virtual LoadState GetLoadState() const;
   virtual uint64 GetUploadProgress(void) const;
+  virtual void GetLoadTimingInfo(LoadTimingInfo* load_timing_info) const;
+  virtual void SetPriority(RequestPriority priority);
 
  private:
   static const size_t kNumValidationHeaders = 2;
@@ -263,8 +281,13 @@ class HttpCache::Transaction : public HttpTransaction {
   int RestartNetworkRequestWithAuth(const string16& username,
                                     const string16& password);
 
-  // Called to determine if we need to validate the cache entry before using it.
-  bool RequiresValidation();
+  // Called to determine if we need to validate the cache entry before using it,
+  // when the stored response is |response|.
+  bool RequiresValidation(const HttpResponseInfo& response);
+
+  // Called to determine if a cache entry that requires validation can be used
+  // while it is validated in the background.
+  bool CanUseWhileRevalidating();
 
   // Called to make the request conditional (to ask the server if the cached
   // copy is valid).  Returns true if able to make the request conditional.
@@ -323,9 +346,22 @@ class HttpCache::Transaction : public HttpTransaction {
   // data is considered for the result.
   bool CanResume(bool has_data);
 
+  // Returns true if the body of the response that we are about to store should
+  // be compressed.
+  bool ShouldCompressBody() const;
+
   // Called to signal completion of asynchronous IO.
   void OnIOComplete(int result);
 
+  // Sets the end of the cache lookup, if it started and hasn't ended yet.
+  void RecordCacheLookupEnd();
+
+  // Keeps the times of |network_trans_| before it is destroyed.
+  void ResetNetworkTransaction();
+
+  // Resumes the transaction after the writer of the entry made progress.
+  void OnWriterProgressComplete();
+
   State next_state_;
   const HttpRequestInfo* request_;
   BoundNetLog net_log_;
@@ -336,6 +372,9 @@ class HttpCache::Transaction : public HttpTransaction {
   base::WeakPtr<HttpCache> cache_;
   HttpCache::ActiveEntry* entry_;
   base::TimeTicks entry_lock_waiting_since_;
+  // The cache lookup times, and the times of the last network transaction
+  // that was destroyed.
+  LoadTimingInfo load_timing_info_;
   HttpCache::ActiveEntry* new_entry_;
   scoped_ptr<HttpTransaction> network_trans_;
   CompletionCallback* callback_;  // Consumer's callback.
@@ -351,17 +390,25 @@ class HttpCache::Transaction : public HttpTransaction {
   bool is_sparse_;  // The data is stored in sparse byte ranges.
   bool server_responded_206_;
   bool cache_pending_;  // We are waiting for the HttpCache.
+  bool joined_writer_;  // We are reading an entry that is being written.
+  bool waiting_for_writer_;  // We are waiting for more data from the writer.
+  int writer_error_;  // The writer stopped before storing the whole body.
   scoped_refptr<IOBuffer> read_buf_;
   int io_buf_len_;
   int read_offset_;
   int effective_load_flags_;
   int write_len_;
+  int compressed_len_;  // What we are writing to the cache for |write_len_|.
   scoped_ptr<PartialData> partial_;  // We are dealing with range requests.
+  scoped_ptr<HttpCacheBodyEncoder> body_encoder_;
+  scoped_ptr<HttpCacheBodyDecoder> body_decoder_;
+  scoped_refptr<IOBuffer> compressed_buf_;  // We are reading compressed data.
   uint64 final_upload_progress_;
   CompletionCallbackImpl<Transaction> io_callback_;
   scoped_refptr<CancelableCompletionCallback<Transaction> > cache_callback_;
   scoped_refptr<CancelableCompletionCallback<Transaction> >
       write_headers_callback_;
+  ScopedRunnableMethodFactory<Transaction> task_factory_;
 };
 
 }  // namespace net
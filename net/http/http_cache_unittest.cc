@@ -1596,11 +1596,11 @@ TEST(HttpCache, SimpleGET_RacingReaders) {
   c->result = c->callback.WaitForResult();
   ReadAndVerifyTransaction(c->trans.get(), kSimpleGET_Transaction);
 
-  // Now we have 2 active readers and two queued transactions.
+  // Now we have 4 active readers: all of them joined the writer.
 
   EXPECT_EQ(net::LOAD_STATE_IDLE,
             context_list[2]->trans->GetLoadState());
-  EXPECT_EQ(net::LOAD_STATE_WAITING_FOR_CACHE,
+  EXPECT_EQ(net::LOAD_STATE_IDLE,
             context_list[3]->trans->GetLoadState());
 
   c = context_list[1];
@@ -1609,10 +1609,8 @@ TEST(HttpCache, SimpleGET_RacingReaders) {
   if (c->result == net::OK)
     ReadAndVerifyTransaction(c->trans.get(), kSimpleGET_Transaction);
 
-  // At this point we have one reader, two pending transactions and a task on
-  // the queue to move to the next transaction. Now we cancel the request that
-  // is the current reader, and expect the queued task to be able to start the
-  // next request.
+  // At this point we have three readers. Now we cancel one of them, and
+  // expect the other requests to be able to finish.
 
   c = context_list[2];
   c->trans.reset();
@@ -1637,6 +1635,155 @@ TEST(HttpCache, SimpleGET_RacingReaders) {
   }
 }
 
+// Tests that a request can read the body of a response while another request
+// writes it to the cache.
+TEST(HttpCache, SimpleGET_ReaderJoinsWriter) {
+  MockHttpCache cache;
+
+  MockHttpRequest request(kSimpleGET_Transaction);
+  Context writer;
+  Context reader;
+
+  ASSERT_EQ(net::OK, cache.http_cache()->CreateTransaction(&writer.trans));
+  ASSERT_EQ(net::OK, cache.http_cache()->CreateTransaction(&reader.trans));
+  writer.result = writer.trans->Start(&request, &writer.callback,
+                                      net::BoundNetLog());
+  reader.result = reader.trans->Start(&request, &reader.callback,
+                                      net::BoundNetLog());
+  EXPECT_EQ(net::OK, writer.callback.GetResult(writer.result));
+
+  // The reader gets the headers once the writer starts storing the body.
+  const int kChunkSize = 10;
+  std::string expected(kSimpleGET_Transaction.data);
+  scoped_refptr<net::IOBuffer> buf(new net::IOBuffer(kChunkSize));
+  int rv = writer.trans->Read(buf, kChunkSize, &writer.callback);
+  EXPECT_EQ(kChunkSize, writer.callback.GetResult(rv));
+  EXPECT_EQ(net::OK, reader.callback.GetResult(reader.result));
+
+  // Read everything that the writer has stored so far.
+  rv = reader.trans->Read(buf, kChunkSize, &reader.callback);
+  EXPECT_EQ(kChunkSize, reader.callback.GetResult(rv));
+  EXPECT_EQ(expected.substr(0, kChunkSize), std::string(buf->data(), rv));
+
+  // Now the reader has to wait for the writer.
+  rv = reader.trans->Read(buf, kChunkSize, &reader.callback);
+  EXPECT_EQ(net::ERR_IO_PENDING, rv);
+  MessageLoop::current()->RunAllPending();
+  EXPECT_FALSE(reader.callback.have_result());
+
+  std::string content;
+  EXPECT_EQ(net::OK, ReadTransaction(writer.trans.get(), &content));
+  EXPECT_EQ(expected.substr(kChunkSize), content);
+
+  rv = reader.callback.WaitForResult();
+  ASSERT_EQ(kChunkSize, rv);
+  content.assign(buf->data(), rv);
+  std::string rest;
+  EXPECT_EQ(net::OK, ReadTransaction(reader.trans.get(), &rest));
+  EXPECT_EQ(expected.substr(kChunkSize), content + rest);
+
+  EXPECT_EQ(1, cache.network_layer()->transaction_count());
+  EXPECT_EQ(0, cache.disk_cache()->open_count());
+  EXPECT_EQ(1, cache.disk_cache()->create_count());
+}
+
+// Tests that a request that is reading the body of a response fails if the
+// writer is cancelled before storing the whole body.
+TEST(HttpCache, SimpleGET_ReaderJoinsWriter_CancelWriter) {
+  MockHttpCache cache;
+
+  MockHttpRequest request(kSimpleGET_Transaction);
+  Context writer;
+  Context reader;
+
+  ASSERT_EQ(net::OK, cache.http_cache()->CreateTransaction(&writer.trans));
+  ASSERT_EQ(net::OK, cache.http_cache()->CreateTransaction(&reader.trans));
+  writer.result = writer.trans->Start(&request, &writer.callback,
+                                      net::BoundNetLog());
+  reader.result = reader.trans->Start(&request, &reader.callback,
+                                      net::BoundNetLog());
+  EXPECT_EQ(net::OK, writer.callback.GetResult(writer.result));
+
+  const int kChunkSize = 10;
+  scoped_refptr<net::IOBuffer> buf(new net::IOBuffer(kChunkSize));
+  int rv = writer.trans->Read(buf, kChunkSize, &writer.callback);
+  EXPECT_EQ(kChunkSize, writer.callback.GetResult(rv));
+  EXPECT_EQ(net::OK, reader.callback.GetResult(reader.result));
+
+  rv = reader.trans->Read(buf, kChunkSize, &reader.callback);
+  EXPECT_EQ(kChunkSize, reader.callback.GetResult(rv));
+  rv = reader.trans->Read(buf, kChunkSize, &reader.callback);
+  EXPECT_EQ(net::ERR_IO_PENDING, rv);
+
+  writer.trans.reset();
+  EXPECT_EQ(net::ERR_CACHE_READ_FAILURE, reader.callback.WaitForResult());
+  reader.trans.reset();
+
+  // The entry was not kept.
+  RunTransactionTest(cache.http_cache(), kSimpleGET_Transaction);
+  EXPECT_EQ(2, cache.network_layer()->transaction_count());
+  EXPECT_EQ(2, cache.disk_cache()->create_count());
+}
+
+// Tests that compressible bodies are stored compressed, and decompressed when
+// read from the cache.
+TEST(HttpCache, SimpleGET_CompressedBody) {
+  MockHttpCache cache;
+  cache.http_cache()->set_compress_bodies(true);
+
+  std::string body;
+  for (int i = 0; i < 200; i++)
+    body.append("<p>Google Blah Blah</p>\n");
+
+  ScopedMockTransaction transaction(kSimpleGET_Transaction);
+  transaction.response_headers = "Content-Type: text/html\n"
+                                 "Cache-Control: max-age=10000\n";
+  transaction.data = body.c_str();
+
+  net::HttpResponseInfo response;
+  RunTransactionTestWithResponseInfo(cache.http_cache(), transaction,
+                                     &response);
+  EXPECT_TRUE(response.body_stored_compressed);
+
+  disk_cache::Entry* entry;
+  ASSERT_TRUE(cache.OpenBackendEntry(transaction.url, &entry));
+  EXPECT_GT(static_cast<int>(body.size()) / 4, entry->GetDataSize(1));
+  entry->Close();
+
+  // Now read it back from the cache.
+  RunTransactionTestWithResponseInfo(cache.http_cache(), transaction,
+                                     &response);
+  EXPECT_TRUE(response.was_cached);
+  EXPECT_TRUE(response.body_stored_compressed);
+
+  EXPECT_EQ(1, cache.network_layer()->transaction_count());
+  EXPECT_EQ(1, cache.disk_cache()->open_count());
+  EXPECT_EQ(1, cache.disk_cache()->create_count());
+}
+
+// Tests that bodies encoded by the server are stored as received.
+TEST(HttpCache, SimpleGET_CompressedBody_ContentEncoding) {
+  MockHttpCache cache;
+  cache.http_cache()->set_compress_bodies(true);
+
+  std::string body(1024, 'a');
+  ScopedMockTransaction transaction(kSimpleGET_Transaction);
+  transaction.response_headers = "Content-Type: text/html\n"
+                                 "Content-Encoding: gzip\n"
+                                 "Cache-Control: max-age=10000\n";
+  transaction.data = body.c_str();
+
+  net::HttpResponseInfo response;
+  RunTransactionTestWithResponseInfo(cache.http_cache(), transaction,
+                                     &response);
+  EXPECT_FALSE(response.body_stored_compressed);
+
+  disk_cache::Entry* entry;
+  ASSERT_TRUE(cache.OpenBackendEntry(transaction.url, &entry));
+  EXPECT_EQ(static_cast<int>(body.size()), entry->GetDataSize(1));
+  entry->Close();
+}
+
 // Tests that we can doom an entry with pending transactions and delete one of
 // the pending transactions before the first one completes.
 // See http://code.google.com/p/chromium/issues/detail?id=25588
@@ -2210,6 +2357,40 @@ TEST(HttpCache, ETagGET_ConditionalRequest_304) {
   EXPECT_EQ(1, cache.disk_cache()->create_count());
 }
 
+// Tests that a stale response that allows stale-while-revalidate is returned
+// right away, and validated in the background.
+TEST(HttpCache, ETagGET_StaleWhileRevalidate) {
+  MockHttpCache cache;
+
+  ScopedMockTransaction transaction(kETagGET_Transaction);
+  transaction.response_headers =
+      "Cache-Control: max-age=0, stale-while-revalidate=3600\n"
+      "Etag: foopy\n";
+
+  // Write to the cache.
+  RunTransactionTest(cache.http_cache(), transaction);
+
+  EXPECT_EQ(1, cache.network_layer()->transaction_count());
+  EXPECT_EQ(0, cache.disk_cache()->open_count());
+  EXPECT_EQ(1, cache.disk_cache()->create_count());
+
+  // Get the same URL again. The cached response is used, and a conditional
+  // request is sent once this transaction is done with the entry.
+  transaction.handler = ETagGet_ConditionalRequest_Handler;
+  net::HttpResponseInfo response;
+  RunTransactionTestWithResponseInfo(cache.http_cache(), transaction,
+                                     &response);
+  EXPECT_TRUE(response.was_cached);
+
+  for (int i = 0; i < 10 && cache.network_layer()->transaction_count() < 2;
+       i++) {
+    MessageLoop::current()->RunAllPending();
+  }
+  EXPECT_EQ(2, cache.network_layer()->transaction_count());
+  EXPECT_EQ(2, cache.disk_cache()->open_count());
+  EXPECT_EQ(1, cache.disk_cache()->create_count());
+}
+
 static void ETagGet_ConditionalRequest_NoStore_Handler(
     const net::HttpRequestInfo* request,
     std::string* response_status,
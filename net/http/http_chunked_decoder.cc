@@ -44,6 +44,10 @@
 
 #include "net/http/http_chunked_decoder.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/string_number_conversions.h"
 #include "base/string_piece.h"
@@ -61,34 +65,42 @@ HttpChunkedDecoder::HttpChunkedDecoder()
 }
 
 int HttpChunkedDecoder::FilterBuf(char* buf, int buf_len) {
+  // The decoded data is copied down to |buf| + |result| as it is found, so
+  // every byte is moved at most once (and not at all until the first chunk
+  // marker is seen).
+  const char* input = buf;
   int result = 0;
 
   while (buf_len) {
     if (chunk_remaining_) {
       int num = std::min(chunk_remaining_, buf_len);
+      if (input != buf + result)
+        memmove(buf + result, input, num);
 
       buf_len -= num;
       chunk_remaining_ -= num;
 
       result += num;
-      buf += num;
+      input += num;
 
       // After each chunk's data there should be a CRLF
       if (!chunk_remaining_)
         chunk_terminator_remaining_ = true;
       continue;
     } else if (reached_eof_) {
+      // Keep the extra bytes right after the decoded data.
+      if (input != buf + result)
+        memmove(buf + result, input, buf_len);
       bytes_after_eof_ += buf_len;
       break;  // Done!
     }
 
-    int bytes_consumed = ScanForChunkRemaining(buf, buf_len);
+    int bytes_consumed = ScanForChunkRemaining(input, buf_len);
     if (bytes_consumed < 0)
       return bytes_consumed; // Error
 
     buf_len -= bytes_consumed;
-    if (buf_len)
-      memmove(buf, buf + bytes_consumed, buf_len);
+    input += bytes_consumed;
   }
 
   return result;
@@ -100,12 +112,13 @@ int HttpChunkedDecoder::ScanForChunkRemaining(const char* buf, int buf_len) {
 
   int bytes_consumed = 0;
 
-  size_t index_of_lf = base::StringPiece(buf, buf_len).find('\n');
-  if (index_of_lf != base::StringPiece::npos) {
-    buf_len = static_cast<int>(index_of_lf);
+  const char* lf = static_cast<const char*>(memchr(buf, '\n', buf_len));
+  if (lf) {
+    int index_of_lf = static_cast<int>(lf - buf);
+    buf_len = index_of_lf;
     if (buf_len && buf[buf_len - 1] == '\r')  // Eliminate a preceding CR.
       buf_len--;
-    bytes_consumed = static_cast<int>(index_of_lf) + 1;
+    bytes_consumed = index_of_lf + 1;
 
     // Make buf point to the full line buffer to parse.
     if (!line_buf_.empty()) {
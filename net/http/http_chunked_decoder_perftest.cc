@@ -0,0 +1,72 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "net/http/http_chunked_decoder.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kBodySize = 1024 * 1024;
+const int kNumIterations = 50;
+
+// The size of the reads done by HttpStreamParser.
+const int kReadSize = 32 * 1024;
+
+// Returns a chunked encoding of |body_size| bytes, using chunks of
+// |chunk_size| bytes.
+std::string ChunkedBody(int body_size, int chunk_size) {
+  std::string encoded;
+  for (int i = 0; i < body_size; i += chunk_size) {
+    int size = std::min(chunk_size, body_size - i);
+    encoded.append(base::StringPrintf("%X\r\n", size));
+    encoded.append(size, 'a');
+    encoded.append("\r\n");
+  }
+  encoded.append("0\r\n\r\n");
+  return encoded;
+}
+
+void DecodeBody(const char* name, int chunk_size) {
+  const std::string encoded = ChunkedBody(kBodySize, chunk_size);
+  std::string buffer;
+
+  PerfTimer timer;
+  for (int i = 0; i < kNumIterations; i++) {
+    net::HttpChunkedDecoder decoder;
+    int decoded = 0;
+    for (size_t offset = 0; offset < encoded.size(); offset += kReadSize) {
+      buffer.assign(encoded, offset, kReadSize);
+      int rv = decoder.FilterBuf(&buffer[0], static_cast<int>(buffer.size()));
+      ASSERT_GE(rv, 0);
+      decoded += rv;
+    }
+    EXPECT_TRUE(decoder.reached_eof());
+    EXPECT_EQ(kBodySize, decoded);
+  }
+  base::TimeDelta elapsed = timer.Elapsed();
+  LogPerfResult(name, elapsed.InMillisecondsF(), "ms");
+  double megabytes = static_cast<double>(kBodySize) * kNumIterations /
+      (1024 * 1024);
+  LogPerfResult(base::StringPrintf("%s_rate", name).c_str(),
+                megabytes / elapsed.InSecondsF(), "MB/s");
+}
+
+TEST(HttpChunkedDecoderPerfTest, SmallChunks) {
+  DecodeBody("Chunked_decoder_small_chunks", 64);
+}
+
+TEST(HttpChunkedDecoderPerfTest, TypicalChunks) {
+  DecodeBody("Chunked_decoder_typical_chunks", 4 * 1024);
+}
+
+TEST(HttpChunkedDecoderPerfTest, LargeChunks) {
+  DecodeBody("Chunked_decoder_large_chunks", 256 * 1024);
+}
+
+}  // namespace
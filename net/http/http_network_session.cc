@@ -17,6 +17,7 @@
 #include "net/http/url_security_manager.h"
 #include "net/proxy/proxy_service.h"
 #include "net/socket/client_socket_factory.h"
+#include "net/socket/ssl_host_info_prefetcher.h"
 #include "net/spdy/spdy_session_pool.h"
 
 namespace net {
@@ -26,6 +27,7 @@ HttpNetworkSession::HttpNetworkSession(const Params& params)
     : net_log_(params.net_log),
       network_delegate_(params.network_delegate),
       cert_verifier_(params.cert_verifier),
+      host_resolver_(params.host_resolver),
       http_auth_handler_factory_(params.http_auth_handler_factory),
       proxy_service_(params.proxy_service),
       ssl_config_service_(params.ssl_config_service),
@@ -45,6 +47,10 @@ HttpNetworkSession::HttpNetworkSession(const Params& params)
           new HttpStreamFactoryImpl(this))) {
   DCHECK(params.proxy_service);
   DCHECK(params.ssl_config_service);
+  if (params.ssl_host_info_factory) {
+    ssl_host_info_prefetcher_.reset(
+        new SSLHostInfoPrefetcher(params.ssl_host_info_factory));
+  }
 }
 
 HttpNetworkSession::~HttpNetworkSession() {
@@ -67,4 +73,19 @@ Value* HttpNetworkSession::SpdySessionPoolInfoToValue() const {
   return spdy_session_pool_.SpdySessionPoolInfoToValue();
 }
 
+size_t HttpNetworkSession::PurgeMemory(MemoryPressureLevel level) {
+  socket_pool_manager_.CloseIdleSockets();
+  size_t freed = spdy_session_pool_.CloseIdleSessions();
+  // Losing the sessions only costs full handshakes on the next connections.
+  if (level == MEMORY_PRESSURE_CRITICAL)
+    socket_pool_manager_.ClearSSLSessionCache();
+  return freed;
+}
+
+void HttpNetworkSession::PrefetchSSLHostInfo(const std::string& hostname,
+                                             const SSLConfig& ssl_config) {
+  if (ssl_host_info_prefetcher_.get())
+    ssl_host_info_prefetcher_->Prefetch(hostname, ssl_config);
+}
+
 }  //  namespace net
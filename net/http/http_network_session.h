@@ -7,10 +7,13 @@
 #pragma once
 
 #include <set>
+#include <string>
+
 #include "base/memory/ref_counted.h"
 #include "base/threading/non_thread_safe.h"
 #include "net/base/host_port_pair.h"
 #include "net/base/host_resolver.h"
+#include "net/base/memory_pressure_level.h"
 #include "net/base/ssl_client_auth_cache.h"
 #include "net/http/http_alternate_protocols.h"
 #include "net/http/http_auth_cache.h"
@@ -37,6 +40,8 @@ class NetworkDelegate;
 class ProxyService;
 class SSLConfigService;
 class SSLHostInfoFactory;
+class SSLHostInfoPrefetcher;
+struct SSLConfig;
 
 // This class holds session objects used by HttpNetworkTransaction objects.
 class HttpNetworkSession : public base::RefCounted<HttpNetworkSession>,
@@ -111,6 +116,7 @@ class HttpNetworkSession : public base::RefCounted<HttpNetworkSession>,
   }
 
   CertVerifier* cert_verifier() { return cert_verifier_; }
+  HostResolver* host_resolver() { return host_resolver_; }
   ProxyService* proxy_service() { return proxy_service_; }
   SSLConfigService* ssl_config_service() { return ssl_config_service_; }
   SpdySessionPool* spdy_session_pool() { return &spdy_session_pool_; }
@@ -149,6 +155,23 @@ class HttpNetworkSession : public base::RefCounted<HttpNetworkSession>,
     spdy_session_pool_.CloseIdleSessions();
   }
 
+  // Closes the idle connections, and under critical pressure drops the SSL
+  // sessions too. Returns an estimate of the memory freed, which only counts
+  // the compressors of the SPDY sessions; the memory of sockets and SSL
+  // sessions is not known.
+  size_t PurgeMemory(MemoryPressureLevel level);
+
+  // See ClientSocketPoolManager::TakePeakSocketCount().
+  int TakePeakSocketCount(const HostPortPair& origin, bool using_ssl) {
+    return socket_pool_manager_.TakePeakSocketCount(origin, using_ssl);
+  }
+
+  // Loads the saved SSL state for |hostname| and verifies its certificates
+  // ahead of a likely connection.  Does nothing if the session has no
+  // SSLHostInfoFactory.  See SSLHostInfoPrefetcher.
+  void PrefetchSSLHostInfo(const std::string& hostname,
+                           const SSLConfig& ssl_config);
+
 
  private:
   friend class base::RefCounted<HttpNetworkSession>;
@@ -159,6 +182,7 @@ class HttpNetworkSession : public base::RefCounted<HttpNetworkSession>,
   NetLog* const net_log_;
   NetworkDelegate* const network_delegate_;
   CertVerifier* const cert_verifier_;
+  HostResolver* const host_resolver_;
   HttpAuthHandlerFactory* const http_auth_handler_factory_;
 
   // Not const since it's modified by HttpNetworkSessionPeer for testing.
@@ -171,6 +195,7 @@ class HttpNetworkSession : public base::RefCounted<HttpNetworkSession>,
   ClientSocketPoolManager socket_pool_manager_;
   SpdySessionPool spdy_session_pool_;
   scoped_ptr<HttpStreamFactory> http_stream_factory_;
+  scoped_ptr<SSLHostInfoPrefetcher> ssl_host_info_prefetcher_;
   std::set<HttpResponseBodyDrainer*> response_drainers_;
 };
 
@@ -371,6 +371,29 @@ uint64 HttpNetworkTransaction::GetUploadProgress() const {
   return stream_->GetUploadProgress();
 }
 
+void HttpNetworkTransaction::GetLoadTimingInfo(
+    LoadTimingInfo* load_timing_info) const {
+  load_timing_info->socket_reused = load_timing_info_.socket_reused;
+  load_timing_info->proxy_resolve_start =
+      proxy_info_.proxy_resolve_start_time();
+  load_timing_info->proxy_resolve_end = proxy_info_.proxy_resolve_end_time();
+  load_timing_info->stream_start = load_timing_info_.stream_start;
+  load_timing_info->stream_end = load_timing_info_.stream_end;
+  load_timing_info->connect_timing = load_timing_info_.connect_timing;
+  load_timing_info->send_start = load_timing_info_.send_start;
+  load_timing_info->send_end = load_timing_info_.send_end;
+  load_timing_info->receive_headers_start =
+      load_timing_info_.receive_headers_start;
+  load_timing_info->receive_headers_end = load_timing_info_.receive_headers_end;
+}
+
+void HttpNetworkTransaction::SetPriority(RequestPriority priority) {
+  if (stream_request_.get())
+    stream_request_->SetPriority(priority);
+  if (stream_.get())
+    stream_->SetPriority(priority);
+}
+
 void HttpNetworkTransaction::OnStreamReady(const SSLConfig& used_ssl_config,
                                            const ProxyInfo& used_proxy_info,
                                            HttpStream* stream) {
@@ -582,6 +605,7 @@ int HttpNetworkTransaction::DoLoop(int result) {
 
 int HttpNetworkTransaction::DoCreateStream() {
   next_state_ = STATE_CREATE_STREAM_COMPLETE;
+  load_timing_info_.stream_start = base::TimeTicks::Now();
 
   stream_request_.reset(
       session_->http_stream_factory()->RequestStream(
@@ -594,9 +618,11 @@ int HttpNetworkTransaction::DoCreateStream() {
 }
 
 int HttpNetworkTransaction::DoCreateStreamComplete(int result) {
+  load_timing_info_.stream_end = base::TimeTicks::Now();
   if (result == OK) {
     next_state_ = STATE_INIT_STREAM;
     DCHECK(stream_.get());
+    stream_->GetLoadTimingInfo(&load_timing_info_);
   } else if (result == ERR_SSL_CLIENT_AUTH_CERT_NEEDED) {
     result = HandleCertificateRequest(result);
   } else if (result == ERR_HTTPS_PROXY_TUNNEL_RESPONSE) {
@@ -701,6 +727,8 @@ void HttpNetworkTransaction::BuildRequestHeaders(bool using_proxy) {
 
   // Add a content length header?
   if (request_body_.get()) {
+    if (request_body_->is_gzipped())
+      request_headers_.SetHeader(HttpRequestHeaders::kContentEncoding, "gzip");
     if (request_body_->is_chunked()) {
       request_headers_.SetHeader(
           HttpRequestHeaders::kTransferEncoding, "chunked");
@@ -790,12 +818,14 @@ int HttpNetworkTransaction::DoBuildRequestComplete(int result) {
 
 int HttpNetworkTransaction::DoSendRequest() {
   next_state_ = STATE_SEND_REQUEST_COMPLETE;
+  load_timing_info_.send_start = base::TimeTicks::Now();
 
   return stream_->SendRequest(
       request_headers_, request_body_.release(), &response_, &io_callback_);
 }
 
 int HttpNetworkTransaction::DoSendRequestComplete(int result) {
+  load_timing_info_.send_end = base::TimeTicks::Now();
   if (result < 0)
     return HandleIOError(result);
   next_state_ = STATE_READ_HEADERS;
@@ -852,6 +882,9 @@ int HttpNetworkTransaction::DoReadHeadersComplete(int result) {
   if (result == OK)
     LogTransactionConnectedMetrics();
 
+  load_timing_info_.receive_headers_end = base::TimeTicks::Now();
+  stream_->GetLoadTimingInfo(&load_timing_info_);
+
   if (result == ERR_CONNECTION_CLOSED) {
     // For now, if we get at least some data, we do the best we can to make
     // sense of it and send it back up the stack.
@@ -1206,6 +1239,7 @@ int HttpNetworkTransaction::HandleIOError(int error) {
        }
        break;
     case ERR_SPDY_PING_FAILED:
+    case ERR_PIPELINE_EVICTION:
       ResetConnectionAndRequestForResend();
       error = OK;
       break;
@@ -13,6 +13,7 @@
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/time.h"
+#include "net/base/load_timing_info.h"
 #include "net/base/net_log.h"
 #include "net/base/request_priority.h"
 #include "net/base/ssl_config_service.h"
@@ -56,6 +57,8 @@ class HttpNetworkTransaction : public HttpTransaction,
   virtual const HttpResponseInfo* GetResponseInfo() const;
   virtual LoadState GetLoadState() const;
   virtual uint64 GetUploadProgress() const;
+  virtual void GetLoadTimingInfo(LoadTimingInfo* load_timing_info) const;
+  virtual void SetPriority(RequestPriority priority);
 
   // HttpStreamRequest::Delegate methods:
   virtual void OnStreamReady(const SSLConfig& used_ssl_config,
@@ -264,6 +267,11 @@ class HttpNetworkTransaction : public HttpTransaction,
   // The time the Start method was called.
   base::Time start_time_;
 
+  // The stream, send and receive times of the latest attempt, and the
+  // socket times |stream_| reported, kept since |stream_| may be gone by the
+  // time they're asked for.
+  LoadTimingInfo load_timing_info_;
+
   // The next state in the state machine.
   State next_state_;
 
@@ -16,6 +16,7 @@
 #include "net/base/auth.h"
 #include "net/base/capturing_net_log.h"
 #include "net/base/completion_callback.h"
+#include "net/base/load_timing_info.h"
 #include "net/base/mock_host_resolver.h"
 #include "net/base/net_log.h"
 #include "net/base/net_log_unittest.h"
@@ -352,6 +353,65 @@ TEST_F(HttpNetworkTransactionTest, SimpleGET) {
   EXPECT_EQ("hello world", out.response_data);
 }
 
+// Checks that the times of each step of a load on a new socket are recorded,
+// in order.
+TEST_F(HttpNetworkTransactionTest, LoadTimingInfo) {
+  HttpRequestInfo request;
+  request.method = "GET";
+  request.url = GURL("http://www.google.com/");
+  request.load_flags = 0;
+
+  SessionDependencies session_deps;
+  scoped_ptr<HttpTransaction> trans(
+      new HttpNetworkTransaction(CreateSession(&session_deps)));
+
+  MockRead data_reads[] = {
+    MockRead("HTTP/1.0 200 OK\r\n\r\n"),
+    MockRead("hello world"),
+    MockRead(false, OK),
+  };
+  StaticSocketDataProvider data(data_reads, arraysize(data_reads), NULL, 0);
+  session_deps.socket_factory.AddSocketDataProvider(&data);
+
+  LoadTimingInfo load_timing_info;
+  trans->GetLoadTimingInfo(&load_timing_info);
+  EXPECT_TRUE(load_timing_info.stream_start.is_null());
+
+  TestCompletionCallback callback;
+  int rv = trans->Start(&request, &callback, BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, callback.WaitForResult());
+
+  trans->GetLoadTimingInfo(&load_timing_info);
+  EXPECT_FALSE(load_timing_info.socket_reused);
+  EXPECT_FALSE(load_timing_info.stream_start.is_null());
+  EXPECT_LE(load_timing_info.stream_start,
+            load_timing_info.proxy_resolve_start);
+  EXPECT_LE(load_timing_info.proxy_resolve_start,
+            load_timing_info.proxy_resolve_end);
+
+  const LoadTimingInfo::ConnectTiming& connect_timing =
+      load_timing_info.connect_timing;
+  EXPECT_LE(load_timing_info.proxy_resolve_end, connect_timing.dns_start);
+  EXPECT_LE(connect_timing.dns_start, connect_timing.dns_end);
+  EXPECT_LE(connect_timing.dns_end, connect_timing.connect_start);
+  EXPECT_LE(connect_timing.connect_start, connect_timing.connect_end);
+  EXPECT_LE(connect_timing.connect_end, load_timing_info.stream_end);
+  EXPECT_TRUE(connect_timing.ssl_start.is_null());
+  EXPECT_TRUE(connect_timing.ssl_end.is_null());
+
+  EXPECT_LE(load_timing_info.stream_end, load_timing_info.send_start);
+  EXPECT_LE(load_timing_info.send_start, load_timing_info.send_end);
+  EXPECT_LE(load_timing_info.send_end, load_timing_info.receive_headers_start);
+  EXPECT_LE(load_timing_info.receive_headers_start,
+            load_timing_info.receive_headers_end);
+  EXPECT_FALSE(load_timing_info.receive_headers_end.is_null());
+
+  // The network transaction knows nothing of the cache or the filters.
+  EXPECT_TRUE(load_timing_info.cache_start.is_null());
+  EXPECT_TRUE(load_timing_info.request_start.is_null());
+}
+
 // Response with no status line.
 TEST_F(HttpNetworkTransactionTest, SimpleGETNoHeaders) {
   MockRead data_reads[] = {
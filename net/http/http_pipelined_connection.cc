@@ -0,0 +1,467 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_pipelined_connection.h"
+
+#include "base/logging.h"
+#include "base/message_loop.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/upload_data_stream.h"
+#include "net/http/http_pipelined_stream.h"
+#include "net/http/http_response_headers.h"
+#include "net/http/http_response_info.h"
+#include "net/http/http_stream_parser.h"
+#include "net/http/http_version.h"
+#include "net/socket/client_socket_handle.h"
+
+namespace net {
+
+HttpPipelinedConnection::StreamInfo::StreamInfo()
+    : pending_user_callback(NULL),
+      state(STREAM_CREATED) {
+}
+
+HttpPipelinedConnection::StreamInfo::~StreamInfo() {
+}
+
+HttpPipelinedConnection::PendingSendRequest::PendingSendRequest()
+    : pipeline_id(0),
+      response(NULL),
+      callback(NULL) {
+}
+
+HttpPipelinedConnection::PendingSendRequest::~PendingSendRequest() {
+}
+
+HttpPipelinedConnection::HttpPipelinedConnection(
+    ClientSocketHandle* connection,
+    Delegate* delegate,
+    const HostPortPair& origin,
+    const BoundNetLog& net_log)
+    : delegate_(delegate),
+      connection_(connection),
+      read_buf_(new GrowableIOBuffer()),
+      origin_(origin),
+      net_log_(net_log),
+      next_pipeline_id_(1),
+      send_active_(false),
+      read_active_(false),
+      capability_known_(false),
+      capable_(false),
+      evicted_(false),
+      ALLOW_THIS_IN_INITIALIZER_LIST(
+          send_io_callback_(this, &HttpPipelinedConnection::OnSendIOCallback)),
+      ALLOW_THIS_IN_INITIALIZER_LIST(
+          read_headers_io_callback_(
+              this, &HttpPipelinedConnection::OnReadHeadersIOCallback)),
+      ALLOW_THIS_IN_INITIALIZER_LIST(method_factory_(this)) {
+}
+
+HttpPipelinedConnection::~HttpPipelinedConnection() {
+  DCHECK(stream_info_map_.empty());
+  while (!pending_send_request_queue_.empty()) {
+    delete pending_send_request_queue_.front();
+    pending_send_request_queue_.pop_front();
+  }
+
+  // The connection can go back to the pool only if every response was read.
+  if (connection_->socket() &&
+      (evicted_ || read_buf_->offset() ||
+       !connection_->socket()->IsConnectedAndIdle())) {
+    connection_->socket()->Disconnect();
+  }
+  connection_->Reset();
+}
+
+HttpPipelinedStream* HttpPipelinedConnection::CreateNewStream() {
+  DCHECK(stream_info_map_.empty() || usable());
+  int pipeline_id = next_pipeline_id_++;
+  stream_info_map_[pipeline_id].state = STREAM_CREATED;
+  return new HttpPipelinedStream(this, pipeline_id);
+}
+
+bool HttpPipelinedConnection::usable() const {
+  return capable_ && !evicted_ && depth() < kMaxDepth &&
+         connection_->socket() && connection_->socket()->IsConnected();
+}
+
+void HttpPipelinedConnection::InitializeParser(int pipeline_id,
+                                               const HttpRequestInfo* request,
+                                               const BoundNetLog& net_log) {
+  StreamInfo& info = stream_info_map_[pipeline_id];
+  DCHECK_EQ(STREAM_CREATED, info.state);
+  info.parser.reset(new HttpStreamParser(connection_.get(), request,
+                                         read_buf_, net_log));
+  info.state = STREAM_BOUND;
+}
+
+int HttpPipelinedConnection::SendRequest(int pipeline_id,
+                                         const std::string& request_line,
+                                         const HttpRequestHeaders& headers,
+                                         UploadDataStream* request_body,
+                                         HttpResponseInfo* response,
+                                         CompletionCallback* callback) {
+  StreamInfo& info = stream_info_map_[pipeline_id];
+  DCHECK_EQ(STREAM_BOUND, info.state);
+  if (evicted_) {
+    delete request_body;
+    info.state = STREAM_EVICTED;
+    return ERR_PIPELINE_EVICTION;
+  }
+
+  PendingSendRequest* send_request = new PendingSendRequest;
+  send_request->pipeline_id = pipeline_id;
+  send_request->request_line = request_line;
+  send_request->headers.CopyFrom(headers);
+  send_request->request_body.reset(request_body);
+  send_request->response = response;
+  send_request->callback = callback;
+  pending_send_request_queue_.push_back(send_request);
+  info.state = STREAM_SENDING;
+
+  // Wait for the requests that were sent before this one.
+  if (send_active_)
+    return ERR_IO_PENDING;
+
+  int rv = DoSendRequest();
+  if (rv != ERR_IO_PENDING)
+    rv = FinishSendRequest(rv);
+  return rv;
+}
+
+int HttpPipelinedConnection::DoSendRequest() {
+  DCHECK(!send_active_);
+  DCHECK(!pending_send_request_queue_.empty());
+  PendingSendRequest* send_request = pending_send_request_queue_.front();
+  send_active_ = true;
+  request_order_.push_back(send_request->pipeline_id);
+
+  StreamInfo& info = stream_info_map_[send_request->pipeline_id];
+  return info.parser->SendRequest(send_request->request_line,
+                                  send_request->headers,
+                                  send_request->request_body.release(),
+                                  send_request->response,
+                                  &send_io_callback_);
+}
+
+int HttpPipelinedConnection::FinishSendRequest(int result) {
+  DCHECK(send_active_);
+  PendingSendRequest* send_request = pending_send_request_queue_.front();
+  pending_send_request_queue_.pop_front();
+  send_active_ = false;
+
+  int pipeline_id = send_request->pipeline_id;
+  delete send_request;
+  StreamInfo& info = stream_info_map_[pipeline_id];
+
+  if (info.state == STREAM_EVICTED) {
+    // Another stream broke the pipeline while this request was being sent.
+    return ERR_PIPELINE_EVICTION;
+  }
+
+  if (result < 0) {
+    // We don't know how much of the request made it to the server.
+    info.state = STREAM_CLOSED;
+    RemoveFromRequestOrder(pipeline_id);
+    Evict();
+    return result;
+  }
+
+  info.state = STREAM_SENT;
+  if (!pending_send_request_queue_.empty()) {
+    MessageLoop::current()->PostTask(
+        FROM_HERE,
+        method_factory_.NewRunnableMethod(
+            &HttpPipelinedConnection::SendQueuedRequests));
+  }
+  return result;
+}
+
+void HttpPipelinedConnection::OnSendIOCallback(int result) {
+  CompletionCallback* callback = pending_send_request_queue_.front()->callback;
+  result = FinishSendRequest(result);
+  callback->Run(result);
+}
+
+void HttpPipelinedConnection::SendQueuedRequests() {
+  while (!send_active_ && !pending_send_request_queue_.empty()) {
+    PendingSendRequest* send_request = pending_send_request_queue_.front();
+    int pipeline_id = send_request->pipeline_id;
+    CompletionCallback* callback = send_request->callback;
+
+    int rv = DoSendRequest();
+    if (rv == ERR_IO_PENDING)
+      return;
+    rv = FinishSendRequest(rv);
+    QueueUserCallback(pipeline_id, rv, callback);
+  }
+}
+
+int HttpPipelinedConnection::ReadResponseHeaders(int pipeline_id,
+                                                 CompletionCallback* callback) {
+  StreamInfo& info = stream_info_map_[pipeline_id];
+  if (info.state == STREAM_EVICTED)
+    return ERR_PIPELINE_EVICTION;
+  DCHECK_EQ(STREAM_SENT, info.state);
+
+  if (!read_active_ && request_order_.front() == pipeline_id) {
+    int rv = DoReadHeaders();
+    if (rv == ERR_IO_PENDING) {
+      info.pending_user_callback = callback;
+      return rv;
+    }
+    return FinishReadHeaders(rv);
+  }
+
+  // The responses for the previous requests have to be read first.
+  info.state = STREAM_READ_PENDING;
+  info.pending_user_callback = callback;
+  return ERR_IO_PENDING;
+}
+
+int HttpPipelinedConnection::DoReadHeaders() {
+  DCHECK(!read_active_);
+  StreamInfo& info = stream_info_map_[request_order_.front()];
+  read_active_ = true;
+  info.state = STREAM_ACTIVE;
+  return info.parser->ReadResponseHeaders(&read_headers_io_callback_);
+}
+
+int HttpPipelinedConnection::FinishReadHeaders(int result) {
+  DCHECK(read_active_);
+  StreamInfo& info = stream_info_map_[request_order_.front()];
+  bool pipelining = request_order_.size() > 1 ||
+                    !pending_send_request_queue_.empty();
+
+  if (result == OK && !capability_known_) {
+    const HttpResponseInfo* response = info.parser->GetResponseInfo();
+    capability_known_ = true;
+    capable_ = response->headers &&
+               response->headers->GetHttpVersion() >= HttpVersion(1, 1) &&
+               response->headers->IsKeepAlive() &&
+               info.parser->CanFindEndOfResponse();
+    delegate_->OnPipelineFeedback(this, capable_);
+  } else if (result < 0 && pipelining) {
+    // The server was not able to deal with the pipelined requests.
+    capable_ = false;
+    capability_known_ = true;
+    delegate_->OnPipelineFeedback(this, false);
+  }
+  return result;
+}
+
+void HttpPipelinedConnection::OnReadHeadersIOCallback(int result) {
+  int pipeline_id = request_order_.front();
+  result = FinishReadHeaders(result);
+  FireUserCallback(pipeline_id, result);
+}
+
+void HttpPipelinedConnection::ReadNextResponse() {
+  if (read_active_ || request_order_.empty())
+    return;
+
+  int pipeline_id = request_order_.front();
+  if (stream_info_map_[pipeline_id].state != STREAM_READ_PENDING)
+    return;
+
+  int rv = DoReadHeaders();
+  if (rv == ERR_IO_PENDING)
+    return;
+  rv = FinishReadHeaders(rv);
+  FireUserCallback(pipeline_id, rv);
+}
+
+int HttpPipelinedConnection::ReadResponseBody(int pipeline_id,
+                                              IOBuffer* buf,
+                                              int buf_len,
+                                              CompletionCallback* callback) {
+  StreamInfo& info = stream_info_map_[pipeline_id];
+  DCHECK_EQ(STREAM_ACTIVE, info.state);
+  DCHECK_EQ(pipeline_id, request_order_.front());
+  return info.parser->ReadResponseBody(buf, buf_len, callback);
+}
+
+void HttpPipelinedConnection::Close(int pipeline_id, bool not_reusable) {
+  StreamInfo& info = stream_info_map_[pipeline_id];
+  StreamState state = info.state;
+  info.state = STREAM_CLOSED;
+  info.pending_user_callback = NULL;
+
+  switch (state) {
+    case STREAM_CREATED:
+    case STREAM_BOUND:
+    case STREAM_CLOSED:
+    case STREAM_EVICTED:
+      // Nothing was sent for this stream, or it is already gone.
+      break;
+
+    case STREAM_ACTIVE:
+      DCHECK_EQ(pipeline_id, request_order_.front());
+      request_order_.pop_front();
+      read_active_ = false;
+      if (not_reusable || !info.parser->IsResponseBodyComplete()) {
+        // We can't find the start of the next response.
+        if (connection_->socket())
+          connection_->socket()->Disconnect();
+        Evict();
+      } else if (!request_order_.empty()) {
+        MessageLoop::current()->PostTask(
+            FROM_HERE,
+            method_factory_.NewRunnableMethod(
+                &HttpPipelinedConnection::ReadNextResponse));
+      }
+      break;
+
+    default:
+      // The response for this request will never be read, so none of the ones
+      // after it can be read either.
+      if (state == STREAM_SENDING && send_active_ &&
+          pending_send_request_queue_.front()->pipeline_id == pipeline_id) {
+        // The parser is still writing the request. Disconnecting makes sure
+        // that the write never completes.
+        if (connection_->socket())
+          connection_->socket()->Disconnect();
+        delete pending_send_request_queue_.front();
+        pending_send_request_queue_.pop_front();
+        send_active_ = false;
+        RemoveFromRequestOrder(pipeline_id);
+      }
+      Evict();
+      break;
+  }
+}
+
+void HttpPipelinedConnection::Evict() {
+  evicted_ = true;
+
+  // The active response (if any) can still be read.
+  std::deque<int>::iterator it = request_order_.begin();
+  if (read_active_)
+    ++it;
+  for (; it != request_order_.end(); ++it) {
+    StreamInfo& info = stream_info_map_[*it];
+    if (info.state == STREAM_CLOSED)
+      continue;
+    info.state = STREAM_EVICTED;
+    if (info.pending_user_callback)
+      QueueUserCallback(*it, ERR_PIPELINE_EVICTION, info.pending_user_callback);
+  }
+  request_order_.erase(read_active_ ? request_order_.begin() + 1 :
+                                      request_order_.begin(),
+                       request_order_.end());
+
+  // None of the queued requests will be sent. The one being sent (if any)
+  // fails when the write completes.
+  std::deque<PendingSendRequest*> active_send;
+  if (send_active_) {
+    active_send.push_back(pending_send_request_queue_.front());
+    pending_send_request_queue_.pop_front();
+  }
+  while (!pending_send_request_queue_.empty()) {
+    PendingSendRequest* send_request = pending_send_request_queue_.front();
+    StreamInfo& info = stream_info_map_[send_request->pipeline_id];
+    if (info.state != STREAM_CLOSED) {
+      info.state = STREAM_EVICTED;
+      QueueUserCallback(send_request->pipeline_id, ERR_PIPELINE_EVICTION,
+                        send_request->callback);
+    }
+    delete send_request;
+    pending_send_request_queue_.pop_front();
+  }
+  pending_send_request_queue_.swap(active_send);
+}
+
+void HttpPipelinedConnection::QueueUserCallback(int pipeline_id,
+                                                int result,
+                                                CompletionCallback* callback) {
+  stream_info_map_[pipeline_id].pending_user_callback = callback;
+  MessageLoop::current()->PostTask(
+      FROM_HERE,
+      method_factory_.NewRunnableMethod(
+          &HttpPipelinedConnection::FireUserCallback, pipeline_id, result));
+}
+
+void HttpPipelinedConnection::FireUserCallback(int pipeline_id, int result) {
+  StreamInfoMap::iterator it = stream_info_map_.find(pipeline_id);
+  if (it == stream_info_map_.end() || !it->second.pending_user_callback)
+    return;
+
+  CompletionCallback* callback = it->second.pending_user_callback;
+  it->second.pending_user_callback = NULL;
+  callback->Run(result);
+}
+
+void HttpPipelinedConnection::RemoveFromRequestOrder(int pipeline_id) {
+  for (std::deque<int>::iterator it = request_order_.begin();
+       it != request_order_.end(); ++it) {
+    if (*it == pipeline_id) {
+      request_order_.erase(it);
+      return;
+    }
+  }
+}
+
+uint64 HttpPipelinedConnection::GetUploadProgress(int pipeline_id) const {
+  StreamInfoMap::const_iterator it = stream_info_map_.find(pipeline_id);
+  DCHECK(it != stream_info_map_.end());
+  return it->second.parser->GetUploadProgress();
+}
+
+HttpResponseInfo* HttpPipelinedConnection::GetResponseInfo(int pipeline_id) {
+  return stream_info_map_[pipeline_id].parser->GetResponseInfo();
+}
+
+bool HttpPipelinedConnection::IsResponseBodyComplete(int pipeline_id) const {
+  StreamInfoMap::const_iterator it = stream_info_map_.find(pipeline_id);
+  DCHECK(it != stream_info_map_.end());
+  return it->second.parser->IsResponseBodyComplete();
+}
+
+bool HttpPipelinedConnection::CanFindEndOfResponse(int pipeline_id) const {
+  StreamInfoMap::const_iterator it = stream_info_map_.find(pipeline_id);
+  DCHECK(it != stream_info_map_.end());
+  return it->second.parser->CanFindEndOfResponse();
+}
+
+bool HttpPipelinedConnection::IsMoreDataBuffered(int pipeline_id) const {
+  return read_buf_->offset() != 0;
+}
+
+bool HttpPipelinedConnection::IsConnectionReused(int pipeline_id) const {
+  // Only the first stream can be on a connection that was never used before.
+  if (pipeline_id > 1)
+    return true;
+  StreamInfoMap::const_iterator it = stream_info_map_.find(pipeline_id);
+  DCHECK(it != stream_info_map_.end());
+  return it->second.parser->IsConnectionReused();
+}
+
+void HttpPipelinedConnection::SetConnectionReused(int pipeline_id) {
+  connection_->set_is_reused(true);
+}
+
+void HttpPipelinedConnection::GetSSLInfo(int pipeline_id, SSLInfo* ssl_info) {
+  stream_info_map_[pipeline_id].parser->GetSSLInfo(ssl_info);
+}
+
+void HttpPipelinedConnection::GetSSLCertRequestInfo(
+    int pipeline_id,
+    SSLCertRequestInfo* cert_request_info) {
+  stream_info_map_[pipeline_id].parser->GetSSLCertRequestInfo(
+      cert_request_info);
+}
+
+void HttpPipelinedConnection::OnStreamDeleted(int pipeline_id) {
+  DCHECK(stream_info_map_.count(pipeline_id));
+  if (stream_info_map_[pipeline_id].state != STREAM_CLOSED)
+    Close(pipeline_id, true);
+
+  stream_info_map_.erase(pipeline_id);
+  if (stream_info_map_.empty())
+    delegate_->OnPipelineEmpty(this);
+  // |this| may be deleted.
+}
+
+}  // namespace net
@@ -0,0 +1,245 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_HTTP_HTTP_PIPELINED_CONNECTION_H_
+#define NET_HTTP_HTTP_PIPELINED_CONNECTION_H_
+#pragma once
+
+#include <deque>
+#include <map>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/memory/linked_ptr.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/task.h"
+#include "net/base/completion_callback.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/net_log.h"
+#include "net/http/http_request_headers.h"
+
+namespace net {
+
+class ClientSocketHandle;
+class GrowableIOBuffer;
+class HttpPipelinedStream;
+struct HttpRequestInfo;
+class HttpResponseInfo;
+class HttpStreamParser;
+class IOBuffer;
+class SSLCertRequestInfo;
+class SSLInfo;
+class UploadDataStream;
+
+// This class manages all of the state for a single pipelined connection. It
+// tracks the order that HTTP requests are sent and enforces that the
+// subsequent reads occur in the appropriate order.
+//
+// Each HttpPipelinedStream has its own HttpStreamParser, and all of them share
+// the connection and its read buffer. Requests are written one at a time, in
+// the order in which SendRequest() is called. A response can only be read
+// after the previous response has been completely read and its stream closed.
+//
+// If a stream is closed while its response cannot be consumed (for instance,
+// before the body is complete), the rest of the responses on the connection
+// are lost; the streams that are still waiting fail with ERR_PIPELINE_EVICTION
+// so that the requests can be retried elsewhere.
+class HttpPipelinedConnection {
+ public:
+  class Delegate {
+   public:
+    // Called once, when the first response on |pipeline| tells if its origin
+    // can handle pipelined requests. It is also called with |capable| set to
+    // false if a pipelined response is lost because of the server.
+    virtual void OnPipelineFeedback(HttpPipelinedConnection* pipeline,
+                                    bool capable) = 0;
+
+    // Called when the last stream of |pipeline| goes away. The delegate is
+    // expected to delete |pipeline|.
+    virtual void OnPipelineEmpty(HttpPipelinedConnection* pipeline) = 0;
+
+   protected:
+    virtual ~Delegate() {}
+  };
+
+  // The maximum number of streams that are sent on a connection at a time.
+  enum { kMaxDepth = 3 };
+
+  // Takes ownership of |connection|.
+  HttpPipelinedConnection(ClientSocketHandle* connection,
+                          Delegate* delegate,
+                          const HostPortPair& origin,
+                          const BoundNetLog& net_log);
+  ~HttpPipelinedConnection();
+
+  // Returns a new stream that uses this connection. The caller owns it.
+  HttpPipelinedStream* CreateNewStream();
+
+  // Returns true if another stream can be added to this connection. This
+  // requires the first response to confirm that the server should be able to
+  // handle pipelined requests.
+  bool usable() const;
+
+  // The number of streams that use this connection.
+  int depth() const { return static_cast<int>(stream_info_map_.size()); }
+
+  const HostPortPair& origin() const { return origin_; }
+
+  // The following methods implement the interface of HttpStream for the stream
+  // with the given |pipeline_id|. See HttpStream for details.
+  void InitializeParser(int pipeline_id,
+                        const HttpRequestInfo* request,
+                        const BoundNetLog& net_log);
+
+  int SendRequest(int pipeline_id,
+                  const std::string& request_line,
+                  const HttpRequestHeaders& headers,
+                  UploadDataStream* request_body,
+                  HttpResponseInfo* response,
+                  CompletionCallback* callback);
+
+  int ReadResponseHeaders(int pipeline_id, CompletionCallback* callback);
+
+  int ReadResponseBody(int pipeline_id,
+                       IOBuffer* buf,
+                       int buf_len,
+                       CompletionCallback* callback);
+
+  void Close(int pipeline_id, bool not_reusable);
+
+  uint64 GetUploadProgress(int pipeline_id) const;
+
+  HttpResponseInfo* GetResponseInfo(int pipeline_id);
+
+  bool IsResponseBodyComplete(int pipeline_id) const;
+
+  bool CanFindEndOfResponse(int pipeline_id) const;
+
+  bool IsMoreDataBuffered(int pipeline_id) const;
+
+  bool IsConnectionReused(int pipeline_id) const;
+
+  void SetConnectionReused(int pipeline_id);
+
+  void GetSSLInfo(int pipeline_id, SSLInfo* ssl_info);
+
+  void GetSSLCertRequestInfo(int pipeline_id,
+                             SSLCertRequestInfo* cert_request_info);
+
+  // Called when the stream with |pipeline_id| is destroyed.
+  void OnStreamDeleted(int pipeline_id);
+
+ private:
+  enum StreamState {
+    STREAM_CREATED,
+    STREAM_BOUND,
+    STREAM_SENDING,
+    STREAM_SENT,
+    STREAM_READ_PENDING,
+    STREAM_ACTIVE,
+    STREAM_CLOSED,
+    STREAM_EVICTED,
+  };
+
+  struct StreamInfo {
+    StreamInfo();
+    ~StreamInfo();
+
+    linked_ptr<HttpStreamParser> parser;
+    CompletionCallback* pending_user_callback;
+    StreamState state;
+  };
+
+  struct PendingSendRequest {
+    PendingSendRequest();
+    ~PendingSendRequest();
+
+    int pipeline_id;
+    std::string request_line;
+    HttpRequestHeaders headers;
+    scoped_ptr<UploadDataStream> request_body;
+    HttpResponseInfo* response;
+    CompletionCallback* callback;
+  };
+
+  typedef std::map<int, StreamInfo> StreamInfoMap;
+
+  // Starts sending the request at the front of |pending_send_request_queue_|.
+  int DoSendRequest();
+
+  // Called when the request being sent is done, with the |result| of the send.
+  // Returns the result for the caller of SendRequest().
+  int FinishSendRequest(int result);
+
+  // Completion of an asynchronous send.
+  void OnSendIOCallback(int result);
+
+  // Sends as many of the queued requests as possible.
+  void SendQueuedRequests();
+
+  // Starts reading the headers of the response at the front of
+  // |request_order_|.
+  int DoReadHeaders();
+
+  // Called when the headers of the active response are read.
+  int FinishReadHeaders(int result);
+
+  // Completion of an asynchronous header read.
+  void OnReadHeadersIOCallback(int result);
+
+  // Starts reading the next response, if the caller is waiting for it.
+  void ReadNextResponse();
+
+  // Stops using this connection for new requests, and fails every stream that
+  // is still waiting to be sent or to read its response.
+  void Evict();
+
+  // Posts |result| to the callback stored for the stream with |pipeline_id|.
+  void QueueUserCallback(int pipeline_id, int result,
+                         CompletionCallback* callback);
+
+  // Invokes the callback stored for the stream with |pipeline_id|, if the
+  // stream still exists.
+  void FireUserCallback(int pipeline_id, int result);
+
+  // Removes |pipeline_id| from |request_order_|.
+  void RemoveFromRequestOrder(int pipeline_id);
+
+  Delegate* delegate_;
+  scoped_ptr<ClientSocketHandle> connection_;
+  scoped_refptr<GrowableIOBuffer> read_buf_;
+  const HostPortPair origin_;
+  BoundNetLog net_log_;
+
+  int next_pipeline_id_;
+  StreamInfoMap stream_info_map_;
+
+  // The requests that are waiting to be sent. The front one is being sent if
+  // |send_active_| is true.
+  std::deque<PendingSendRequest*> pending_send_request_queue_;
+  bool send_active_;
+
+  // The streams that sent their requests, in sending order. The front one owns
+  // the response that is currently on the connection.
+  std::deque<int> request_order_;
+  bool read_active_;
+
+  // True once the first response tells whether the server can be pipelined.
+  bool capability_known_;
+  bool capable_;
+
+  // True if the connection cannot be used for more requests.
+  bool evicted_;
+
+  CompletionCallbackImpl<HttpPipelinedConnection> send_io_callback_;
+  CompletionCallbackImpl<HttpPipelinedConnection> read_headers_io_callback_;
+  ScopedRunnableMethodFactory<HttpPipelinedConnection> method_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(HttpPipelinedConnection);
+};
+
+}  // namespace net
+
+#endif  // NET_HTTP_HTTP_PIPELINED_CONNECTION_H_
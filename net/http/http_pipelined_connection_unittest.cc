@@ -0,0 +1,205 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_pipelined_connection.h"
+
+#include <string>
+
+#include "base/memory/scoped_ptr.h"
+#include "net/base/address_list.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_log.h"
+#include "net/base/test_completion_callback.h"
+#include "net/http/http_pipelined_stream.h"
+#include "net/http/http_request_headers.h"
+#include "net/http/http_request_info.h"
+#include "net/http/http_response_info.h"
+#include "net/socket/client_socket_handle.h"
+#include "net/socket/socket_test_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+class HttpPipelinedConnectionTest : public testing::Test,
+                                    public HttpPipelinedConnection::Delegate {
+ public:
+  HttpPipelinedConnectionTest()
+      : pipeline_(NULL),
+        feedback_count_(0),
+        capable_(false) {
+  }
+
+  // HttpPipelinedConnection::Delegate methods:
+  virtual void OnPipelineFeedback(HttpPipelinedConnection* pipeline,
+                                  bool capable) {
+    EXPECT_EQ(pipeline_, pipeline);
+    feedback_count_++;
+    capable_ = capable;
+  }
+
+  virtual void OnPipelineEmpty(HttpPipelinedConnection* pipeline) {
+    EXPECT_EQ(pipeline_, pipeline);
+    delete pipeline_;
+    pipeline_ = NULL;
+  }
+
+ protected:
+  void Initialize(MockRead* reads, size_t reads_count,
+                  MockWrite* writes, size_t writes_count) {
+    data_.reset(new StaticSocketDataProvider(reads, reads_count,
+                                             writes, writes_count));
+    data_->set_connect_data(MockConnect(false, OK));
+    MockTCPClientSocket* socket =
+        new MockTCPClientSocket(AddressList(), NULL, data_.get());
+    TestCompletionCallback callback;
+    ASSERT_EQ(OK, socket->Connect(&callback));
+    ClientSocketHandle* connection = new ClientSocketHandle;
+    connection->set_socket(socket);
+    pipeline_ = new HttpPipelinedConnection(
+        connection, this, HostPortPair("localhost", 80), BoundNetLog());
+  }
+
+  HttpPipelinedStream* NewStream(const HttpRequestInfo& request) {
+    HttpPipelinedStream* stream = pipeline_->CreateNewStream();
+    EXPECT_EQ(OK, stream->InitializeStream(&request, BoundNetLog(), NULL));
+    return stream;
+  }
+
+  void ExpectBody(HttpPipelinedStream* stream, const std::string& expected) {
+    scoped_refptr<IOBuffer> buf(new IOBuffer(expected.size()));
+    TestCompletionCallback callback;
+    int rv = stream->ReadResponseBody(buf, expected.size(), &callback);
+    EXPECT_EQ(static_cast<int>(expected.size()), callback.GetResult(rv));
+    EXPECT_EQ(expected, std::string(buf->data(), expected.size()));
+    EXPECT_TRUE(stream->IsResponseBodyComplete());
+  }
+
+  scoped_ptr<StaticSocketDataProvider> data_;
+  HttpPipelinedConnection* pipeline_;
+  int feedback_count_;
+  bool capable_;
+};
+
+HttpRequestInfo MakeRequest(const std::string& path) {
+  HttpRequestInfo request;
+  request.method = "GET";
+  request.url = GURL("http://localhost" + path);
+  return request;
+}
+
+TEST_F(HttpPipelinedConnectionTest, TwoResponsesInOneRead) {
+  MockWrite writes[] = {
+    MockWrite(false, "GET /ok1.html HTTP/1.1\r\n\r\n"),
+    MockWrite(false, "GET /ok2.html HTTP/1.1\r\n\r\n"),
+  };
+  MockRead reads[] = {
+    MockRead(false, "HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\nok1"
+                    "HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\nok2"),
+  };
+  Initialize(reads, arraysize(reads), writes, arraysize(writes));
+
+  HttpRequestInfo request1 = MakeRequest("/ok1.html");
+  HttpRequestInfo request2 = MakeRequest("/ok2.html");
+  HttpRequestHeaders headers;
+  HttpResponseInfo response1;
+  HttpResponseInfo response2;
+  TestCompletionCallback callback1;
+  TestCompletionCallback callback2;
+
+  scoped_ptr<HttpPipelinedStream> stream1(NewStream(request1));
+  EXPECT_EQ(OK, stream1->SendRequest(headers, NULL, &response1, &callback1));
+  EXPECT_FALSE(pipeline_->usable());
+  EXPECT_EQ(OK, stream1->ReadResponseHeaders(&callback1));
+  EXPECT_EQ(1, feedback_count_);
+  EXPECT_TRUE(capable_);
+  EXPECT_TRUE(pipeline_->usable());
+
+  scoped_ptr<HttpPipelinedStream> stream2(NewStream(request2));
+  EXPECT_EQ(2, pipeline_->depth());
+  EXPECT_TRUE(stream2->IsConnectionReused());
+  EXPECT_EQ(OK, stream2->SendRequest(headers, NULL, &response2, &callback2));
+
+  // The second response has to wait for the first one to be consumed.
+  EXPECT_EQ(ERR_IO_PENDING, stream2->ReadResponseHeaders(&callback2));
+  ExpectBody(stream1.get(), "ok1");
+  stream1->Close(false);
+  EXPECT_EQ(OK, callback2.WaitForResult());
+  ExpectBody(stream2.get(), "ok2");
+  stream2->Close(false);
+
+  stream1.reset();
+  stream2.reset();
+  EXPECT_TRUE(pipeline_ == NULL);
+  EXPECT_EQ(1, feedback_count_);
+}
+
+TEST_F(HttpPipelinedConnectionTest, EvictedByEarlyClose) {
+  MockWrite writes[] = {
+    MockWrite(false, "GET /ok1.html HTTP/1.1\r\n\r\n"),
+    MockWrite(false, "GET /ok2.html HTTP/1.1\r\n\r\n"),
+  };
+  MockRead reads[] = {
+    MockRead(false, "HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\n"),
+  };
+  Initialize(reads, arraysize(reads), writes, arraysize(writes));
+
+  HttpRequestInfo request1 = MakeRequest("/ok1.html");
+  HttpRequestInfo request2 = MakeRequest("/ok2.html");
+  HttpRequestHeaders headers;
+  HttpResponseInfo response1;
+  HttpResponseInfo response2;
+  TestCompletionCallback callback1;
+  TestCompletionCallback callback2;
+
+  scoped_ptr<HttpPipelinedStream> stream1(NewStream(request1));
+  EXPECT_EQ(OK, stream1->SendRequest(headers, NULL, &response1, &callback1));
+  EXPECT_EQ(OK, stream1->ReadResponseHeaders(&callback1));
+
+  scoped_ptr<HttpPipelinedStream> stream2(NewStream(request2));
+  EXPECT_EQ(OK, stream2->SendRequest(headers, NULL, &response2, &callback2));
+
+  // The end of the first response can't be found anymore.
+  stream1->Close(false);
+  EXPECT_FALSE(pipeline_->usable());
+  EXPECT_EQ(ERR_PIPELINE_EVICTION, stream2->ReadResponseHeaders(&callback2));
+  stream2->Close(true);
+
+  stream1.reset();
+  stream2.reset();
+  EXPECT_TRUE(pipeline_ == NULL);
+}
+
+TEST_F(HttpPipelinedConnectionTest, Http10ResponseIsNotCapable) {
+  MockWrite writes[] = {
+    MockWrite(false, "GET /ok1.html HTTP/1.1\r\n\r\n"),
+  };
+  MockRead reads[] = {
+    MockRead(false, "HTTP/1.0 200 OK\r\nContent-Length: 3\r\n\r\nok1"),
+  };
+  Initialize(reads, arraysize(reads), writes, arraysize(writes));
+
+  HttpRequestInfo request1 = MakeRequest("/ok1.html");
+  HttpRequestHeaders headers;
+  HttpResponseInfo response1;
+  TestCompletionCallback callback1;
+
+  scoped_ptr<HttpPipelinedStream> stream1(NewStream(request1));
+  EXPECT_EQ(OK, stream1->SendRequest(headers, NULL, &response1, &callback1));
+  EXPECT_EQ(OK, stream1->ReadResponseHeaders(&callback1));
+  EXPECT_EQ(1, feedback_count_);
+  EXPECT_FALSE(capable_);
+  EXPECT_FALSE(pipeline_->usable());
+  ExpectBody(stream1.get(), "ok1");
+  stream1->Close(false);
+
+  stream1.reset();
+  EXPECT_TRUE(pipeline_ == NULL);
+}
+
+}  // namespace
+
+}  // namespace net
@@ -0,0 +1,68 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_pipelined_host_pool.h"
+
+#include "base/logging.h"
+#include "net/http/http_pipelined_stream.h"
+
+namespace net {
+
+HttpPipelinedHostPool::HttpPipelinedHostPool() {
+}
+
+HttpPipelinedHostPool::~HttpPipelinedHostPool() {
+  DCHECK(pipelines_.empty());
+}
+
+bool HttpPipelinedHostPool::IsHostEligibleForPipelining(
+    const HostPortPair& origin) const {
+  return incapable_hosts_.find(origin) == incapable_hosts_.end();
+}
+
+HttpPipelinedStream* HttpPipelinedHostPool::CreateStreamOnExistingPipeline(
+    const HostPortPair& origin) {
+  PipelineMap::iterator map_it = pipelines_.find(origin);
+  if (map_it == pipelines_.end() || !IsHostEligibleForPipelining(origin))
+    return NULL;
+
+  HttpPipelinedConnection* best = NULL;
+  for (PipelineSet::iterator it = map_it->second.begin();
+       it != map_it->second.end(); ++it) {
+    if ((*it)->usable() && (!best || (*it)->depth() < best->depth()))
+      best = *it;
+  }
+  if (!best)
+    return NULL;
+  return best->CreateNewStream();
+}
+
+HttpPipelinedStream* HttpPipelinedHostPool::CreateStreamOnNewPipeline(
+    const HostPortPair& origin,
+    ClientSocketHandle* connection,
+    const BoundNetLog& net_log) {
+  HttpPipelinedConnection* pipeline =
+      new HttpPipelinedConnection(connection, this, origin, net_log);
+  pipelines_[origin].insert(pipeline);
+  return pipeline->CreateNewStream();
+}
+
+void HttpPipelinedHostPool::OnPipelineFeedback(
+    HttpPipelinedConnection* pipeline,
+    bool capable) {
+  if (!capable)
+    incapable_hosts_.insert(pipeline->origin());
+}
+
+void HttpPipelinedHostPool::OnPipelineEmpty(
+    HttpPipelinedConnection* pipeline) {
+  PipelineMap::iterator map_it = pipelines_.find(pipeline->origin());
+  DCHECK(map_it != pipelines_.end());
+  map_it->second.erase(pipeline);
+  if (map_it->second.empty())
+    pipelines_.erase(map_it);
+  delete pipeline;
+}
+
+}  // namespace net
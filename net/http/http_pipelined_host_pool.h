@@ -0,0 +1,64 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_HTTP_HTTP_PIPELINED_HOST_POOL_H_
+#define NET_HTTP_HTTP_PIPELINED_HOST_POOL_H_
+#pragma once
+
+#include <map>
+#include <set>
+
+#include "base/basictypes.h"
+#include "net/base/host_port_pair.h"
+#include "net/http/http_pipelined_connection.h"
+
+namespace net {
+
+class BoundNetLog;
+class ClientSocketHandle;
+class HttpPipelinedStream;
+
+// Manages the pipelined connections to every origin, and remembers the origins
+// that are not able to handle pipelined requests.
+class HttpPipelinedHostPool : public HttpPipelinedConnection::Delegate {
+ public:
+  HttpPipelinedHostPool();
+  virtual ~HttpPipelinedHostPool();
+
+  // Returns true if new requests to |origin| may be pipelined.
+  bool IsHostEligibleForPipelining(const HostPortPair& origin) const;
+
+  // Returns a new stream on the least busy pipeline to |origin| that can take
+  // more requests, or NULL if there is not any.
+  HttpPipelinedStream* CreateStreamOnExistingPipeline(
+      const HostPortPair& origin);
+
+  // Starts a new pipeline to |origin| over |connection|, which must be a new
+  // connection, and returns its first stream. Takes ownership of
+  // |connection|.
+  HttpPipelinedStream* CreateStreamOnNewPipeline(
+      const HostPortPair& origin,
+      ClientSocketHandle* connection,
+      const BoundNetLog& net_log);
+
+  // HttpPipelinedConnection::Delegate methods:
+  virtual void OnPipelineFeedback(HttpPipelinedConnection* pipeline,
+                                  bool capable);
+  virtual void OnPipelineEmpty(HttpPipelinedConnection* pipeline);
+
+ private:
+  typedef std::set<HttpPipelinedConnection*> PipelineSet;
+  typedef std::map<HostPortPair, PipelineSet> PipelineMap;
+
+  PipelineMap pipelines_;
+
+  // The origins that failed to handle pipelined requests.
+  std::set<HostPortPair> incapable_hosts_;
+
+  DISALLOW_COPY_AND_ASSIGN(HttpPipelinedHostPool);
+};
+
+}  // namespace net
+
+#endif  // NET_HTTP_HTTP_PIPELINED_HOST_POOL_H_
@@ -174,6 +174,12 @@ bool HttpProxyClientSocket::UsingTCPFastOpen() const {
   return false;
 }
 
+bool HttpProxyClientSocket::GetTCPInfo(TCPInfo* info) const {
+  if (transport_.get() && transport_->socket())
+    return transport_->socket()->GetTCPInfo(info);
+  return false;
+}
+
 int HttpProxyClientSocket::Read(IOBuffer* buf, int buf_len,
                                 CompletionCallback* callback) {
   DCHECK(!user_callback_);
@@ -202,6 +208,26 @@ int HttpProxyClientSocket::Write(IOBuffer* buf, int buf_len,
   return transport_->socket()->Write(buf, buf_len, callback);
 }
 
+int HttpProxyClientSocket::Writev(IOBuffer* const* bufs, const int* buf_lens,
+                                  int num_bufs, CompletionCallback* callback) {
+  DCHECK_EQ(STATE_DONE, next_state_);
+  DCHECK(!user_callback_);
+
+  return transport_->socket()->Writev(bufs, buf_lens, num_bufs, callback);
+}
+
+bool HttpProxyClientSocket::SupportsSendFile() const {
+  return transport_->socket()->SupportsSendFile();
+}
+
+int HttpProxyClientSocket::SendFile(base::PlatformFile file, int64 offset,
+                                    int len, CompletionCallback* callback) {
+  DCHECK_EQ(STATE_DONE, next_state_);
+  DCHECK(!user_callback_);
+
+  return transport_->socket()->SendFile(file, offset, len, callback);
+}
+
 bool HttpProxyClientSocket::SetReceiveBufferSize(int32 size) {
   return transport_->socket()->SetReceiveBufferSize(size);
 }
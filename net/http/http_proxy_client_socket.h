@@ -84,10 +84,16 @@ class HttpProxyClientSocket : public ProxyClientSocket {
   virtual void SetOmniboxSpeculation();
   virtual bool WasEverUsed() const;
   virtual bool UsingTCPFastOpen() const;
+  virtual bool GetTCPInfo(TCPInfo* info) const;
 
   // Socket methods:
   virtual int Read(IOBuffer* buf, int buf_len, CompletionCallback* callback);
   virtual int Write(IOBuffer* buf, int buf_len, CompletionCallback* callback);
+  virtual int Writev(IOBuffer* const* bufs, const int* buf_lens, int num_bufs,
+                     CompletionCallback* callback);
+  virtual bool SupportsSendFile() const;
+  virtual int SendFile(base::PlatformFile file, int64 offset, int len,
+                       CompletionCallback* callback);
   virtual bool SetReceiveBufferSize(int32 size);
   virtual bool SetSendBufferSize(int32 size);
   virtual int GetPeerAddress(AddressList* address) const;
@@ -6,6 +6,8 @@
 
 #include <algorithm>
 
+#include "base/message_loop.h"
+#include "base/stl_util-inl.h"
 #include "base/time.h"
 #include "base/values.h"
 #include "googleurl/src/gurl.h"
@@ -79,6 +81,67 @@ void HttpProxySocketParams::setUID(uid_t uid) {
 }
 #endif
 
+SpdyProxySessionTracker::PendingConnect::PendingConnect() : job(NULL) {}
+
+SpdyProxySessionTracker::PendingConnect::~PendingConnect() {}
+
+SpdyProxySessionTracker::SpdyProxySessionTracker() {}
+
+SpdyProxySessionTracker::~SpdyProxySessionTracker() {
+  DCHECK(pending_connects_.empty());
+}
+
+bool SpdyProxySessionTracker::ShouldWait(const HostPortPair& proxy,
+                                         bool want_spdy,
+                                         HttpProxyConnectJob* job) {
+  if (ContainsKey(non_spdy_proxies_, proxy))
+    return false;
+  if (!want_spdy && !ContainsKey(spdy_proxies_, proxy))
+    return false;
+
+  PendingConnect& pending_connect = pending_connects_[proxy];
+  if (!pending_connect.job || pending_connect.job == job) {
+    pending_connect.job = job;
+    return false;
+  }
+  pending_connect.waiting_jobs.push_back(job);
+  return true;
+}
+
+void SpdyProxySessionTracker::SetProxyUsesSpdy(const HostPortPair& proxy,
+                                               bool uses_spdy) {
+  if (uses_spdy) {
+    spdy_proxies_.insert(proxy);
+    non_spdy_proxies_.erase(proxy);
+  } else {
+    non_spdy_proxies_.insert(proxy);
+    spdy_proxies_.erase(proxy);
+  }
+}
+
+void SpdyProxySessionTracker::RemoveJob(HttpProxyConnectJob* job) {
+  for (PendingConnectMap::iterator it = pending_connects_.begin();
+       it != pending_connects_.end(); ++it) {
+    PendingConnect& pending_connect = it->second;
+    if (pending_connect.job == job) {
+      std::vector<HttpProxyConnectJob*> waiting_jobs;
+      waiting_jobs.swap(pending_connect.waiting_jobs);
+      pending_connects_.erase(it);
+      for (size_t i = 0; i < waiting_jobs.size(); ++i)
+        waiting_jobs[i]->OnSpdyProxyConnectDone();
+      return;
+    }
+
+    std::vector<HttpProxyConnectJob*>::iterator waiting_job = std::find(
+        pending_connect.waiting_jobs.begin(),
+        pending_connect.waiting_jobs.end(), job);
+    if (waiting_job != pending_connect.waiting_jobs.end()) {
+      pending_connect.waiting_jobs.erase(waiting_job);
+      return;
+    }
+  }
+}
+
 // HttpProxyConnectJobs will time out after this many seconds.  Note this is on
 // top of the timeout for the transport socket.
 static const int kHttpProxyConnectJobTimeoutInSeconds = 30;
@@ -89,6 +152,7 @@ HttpProxyConnectJob::HttpProxyConnectJob(
     const base::TimeDelta& timeout_duration,
     TransportClientSocketPool* transport_pool,
     SSLClientSocketPool* ssl_pool,
+    SpdyProxySessionTracker* spdy_proxy_tracker,
     HostResolver* host_resolver,
     Delegate* delegate,
     NetLog* net_log)
@@ -97,13 +161,17 @@ HttpProxyConnectJob::HttpProxyConnectJob(
       params_(params),
       transport_pool_(transport_pool),
       ssl_pool_(ssl_pool),
+      spdy_proxy_tracker_(spdy_proxy_tracker),
       resolver_(host_resolver),
       ALLOW_THIS_IN_INITIALIZER_LIST(
           callback_(this, &HttpProxyConnectJob::OnIOComplete)),
-      using_spdy_(false) {
+      using_spdy_(false),
+      ALLOW_THIS_IN_INITIALIZER_LIST(method_factory_(this)) {
 }
 
-HttpProxyConnectJob::~HttpProxyConnectJob() {}
+HttpProxyConnectJob::~HttpProxyConnectJob() {
+  spdy_proxy_tracker_->RemoveJob(this);
+}
 
 LoadState HttpProxyConnectJob::GetLoadState() const {
   switch (next_state_) {
@@ -112,6 +180,7 @@ LoadState HttpProxyConnectJob::GetLoadState() const {
     case STATE_SSL_CONNECT:
     case STATE_SSL_CONNECT_COMPLETE:
       return transport_socket_handle_->GetLoadState();
+    case STATE_SPDY_PROXY_WAIT_FOR_SESSION_COMPLETE:
     case STATE_HTTP_PROXY_CONNECT:
     case STATE_HTTP_PROXY_CONNECT_COMPLETE:
     case STATE_SPDY_PROXY_CREATE_STREAM:
@@ -158,6 +227,9 @@ int HttpProxyConnectJob::DoLoop(int result) {
       case STATE_SSL_CONNECT_COMPLETE:
         rv = DoSSLConnectComplete(rv);
         break;
+      case STATE_SPDY_PROXY_WAIT_FOR_SESSION_COMPLETE:
+        rv = DoSpdyProxyWaitForSessionComplete(rv);
+        break;
       case STATE_HTTP_PROXY_CONNECT:
         DCHECK_EQ(OK, rv);
         rv = DoHttpProxyConnect();
@@ -217,6 +289,13 @@ int HttpProxyConnectJob::DoSSLConnect() {
       next_state_ = STATE_SPDY_PROXY_CREATE_STREAM;
       return OK;
     }
+    // If another job is connecting to a proxy that may speak SPDY, its session
+    // can carry our tunnel too.
+    if (spdy_proxy_tracker_->ShouldWait(
+            pair.first, params_->ssl_params()->want_spdy_over_npn(), this)) {
+      next_state_ = STATE_SPDY_PROXY_WAIT_FOR_SESSION_COMPLETE;
+      return ERR_IO_PENDING;
+    }
   }
   next_state_ = STATE_SSL_CONNECT_COMPLETE;
   transport_socket_handle_.reset(new ClientSocketHandle());
@@ -249,6 +328,13 @@ int HttpProxyConnectJob::DoSSLConnectComplete(int result) {
   SSLClientSocket* ssl =
       static_cast<SSLClientSocket*>(transport_socket_handle_->socket());
   using_spdy_ = ssl->was_spdy_negotiated();
+  if (params_->tunnel()) {
+    spdy_proxy_tracker_->SetProxyUsesSpdy(
+        params_->destination().host_port_pair(), using_spdy_);
+    // Without a session to share, the jobs that wait for us can go ahead.
+    if (!using_spdy_)
+      spdy_proxy_tracker_->RemoveJob(this);
+  }
 
   // Reset the timer to just the length of time allowed for HttpProxy handshake
   // so that a fast SSL connection plus a slow HttpProxy failure doesn't take
@@ -268,6 +354,13 @@ int HttpProxyConnectJob::DoSSLConnectComplete(int result) {
   return result;
 }
 
+int HttpProxyConnectJob::DoSpdyProxyWaitForSessionComplete(int result) {
+  DCHECK_EQ(OK, result);
+  // The session may be there now. If not, we connect on our own.
+  next_state_ = STATE_SSL_CONNECT;
+  return result;
+}
+
 #ifdef ANDROID
 // TODO(kristianm): Find out if Connect should block
 #endif
@@ -275,6 +368,7 @@ int HttpProxyConnectJob::DoHttpProxyConnect() {
   next_state_ = STATE_HTTP_PROXY_CONNECT_COMPLETE;
   const HostResolver::RequestInfo& tcp_destination = params_->destination();
   const HostPortPair& proxy_server = tcp_destination.host_port_pair();
+  connect_timing_ = transport_socket_handle_->connect_timing();
 
   // Add a HttpProxy connection on top of the tcp socket.
   transport_socket_.reset(
@@ -336,6 +430,8 @@ int HttpProxyConnectJob::DoSpdyProxyCreateStream() {
     if (rv < 0)
       return rv;
   }
+  // The jobs that wait for us can use the session too.
+  spdy_proxy_tracker_->RemoveJob(this);
 
   next_state_ = STATE_SPDY_PROXY_CREATE_STREAM_COMPLETE;
   return spdy_session->CreateStream(params_->request_url(),
@@ -382,14 +478,23 @@ int HttpProxyConnectJob::ConnectInternal() {
   return DoLoop(OK);
 }
 
+void HttpProxyConnectJob::OnSpdyProxyConnectDone() {
+  DCHECK_EQ(STATE_SPDY_PROXY_WAIT_FOR_SESSION_COMPLETE, next_state_);
+  // Don't resume from inside the other job.
+  MessageLoop::current()->PostTask(FROM_HERE, method_factory_.NewRunnableMethod(
+      &HttpProxyConnectJob::OnIOComplete, static_cast<int>(OK)));
+}
+
 HttpProxyClientSocketPool::
 HttpProxyConnectJobFactory::HttpProxyConnectJobFactory(
     TransportClientSocketPool* transport_pool,
     SSLClientSocketPool* ssl_pool,
+    SpdyProxySessionTracker* spdy_proxy_tracker,
     HostResolver* host_resolver,
     NetLog* net_log)
     : transport_pool_(transport_pool),
       ssl_pool_(ssl_pool),
+      spdy_proxy_tracker_(spdy_proxy_tracker),
       host_resolver_(host_resolver),
       net_log_(net_log) {
   base::TimeDelta max_pool_timeout = base::TimeDelta();
@@ -413,6 +518,7 @@ HttpProxyClientSocketPool::HttpProxyConnectJobFactory::NewConnectJob(
                                  ConnectionTimeout(),
                                  transport_pool_,
                                  ssl_pool_,
+                                 spdy_proxy_tracker_,
                                  host_resolver_,
                                  delegate,
                                  net_log_);
@@ -434,6 +540,7 @@ HttpProxyClientSocketPool::HttpProxyClientSocketPool(
             base::TimeDelta::FromSeconds(kUsedIdleSocketTimeout),
             new HttpProxyConnectJobFactory(transport_pool,
                                            ssl_pool,
+                                           &spdy_proxy_tracker_,
                                            host_resolver,
                                            net_log)) {}
 
@@ -469,6 +576,12 @@ void HttpProxyClientSocketPool::CancelRequest(
   base_.CancelRequest(group_name, handle);
 }
 
+void HttpProxyClientSocketPool::SetPriority(const std::string& group_name,
+                                            ClientSocketHandle* handle,
+                                            RequestPriority priority) {
+  base_.SetPriority(group_name, handle, priority);
+}
+
 void HttpProxyClientSocketPool::ReleaseSocket(const std::string& group_name,
                                               ClientSocket* socket, int id) {
   base_.ReleaseSocket(group_name, socket, id);
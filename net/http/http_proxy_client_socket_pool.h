@@ -6,11 +6,15 @@
 #define NET_HTTP_HTTP_PROXY_CLIENT_SOCKET_POOL_H_
 #pragma once
 
+#include <map>
+#include <set>
 #include <string>
+#include <vector>
 
 #include "base/basictypes.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/task.h"
 #include "base/time.h"
 #include "net/base/host_port_pair.h"
 #include "net/http/http_auth.h"
@@ -25,6 +29,7 @@ namespace net {
 class HostResolver;
 class HttpAuthCache;
 class HttpAuthHandlerFactory;
+class HttpProxyConnectJob;
 class SSLClientSocketPool;
 class SSLSocketParams;
 class SpdySessionPool;
@@ -92,6 +97,47 @@ class HttpProxySocketParams : public base::RefCounted<HttpProxySocketParams> {
   DISALLOW_COPY_AND_ASSIGN(HttpProxySocketParams);
 };
 
+// SpdyProxySessionTracker lets the tunnel connect jobs to an HTTPS proxy that
+// speaks SPDY wait for the job that is already connecting to it, so that the
+// tunnels to all the origins share its SPDY session instead of each one doing
+// a TLS handshake with the proxy. Proxies that may speak SPDY are only
+// connected to by one job at a time, until we know whether they do.
+class SpdyProxySessionTracker {
+ public:
+  SpdyProxySessionTracker();
+  ~SpdyProxySessionTracker();
+
+  // Returns true if |job| has to wait until the job that is connecting to
+  // |proxy| is done. Otherwise |job| may go ahead, and it becomes the job
+  // that is connecting to |proxy| when the proxy is known to speak SPDY, or
+  // when |want_spdy| is true and nothing is known about it yet.
+  bool ShouldWait(const HostPortPair& proxy, bool want_spdy,
+                  HttpProxyConnectJob* job);
+
+  // Records whether |proxy| negotiated SPDY.
+  void SetProxyUsesSpdy(const HostPortPair& proxy, bool uses_spdy);
+
+  // Called when |job| is done with connecting, or is going away. The jobs that
+  // were waiting for it are resumed.
+  void RemoveJob(HttpProxyConnectJob* job);
+
+ private:
+  struct PendingConnect {
+    PendingConnect();
+    ~PendingConnect();
+
+    HttpProxyConnectJob* job;
+    std::vector<HttpProxyConnectJob*> waiting_jobs;
+  };
+  typedef std::map<HostPortPair, PendingConnect> PendingConnectMap;
+
+  PendingConnectMap pending_connects_;
+  std::set<HostPortPair> spdy_proxies_;
+  std::set<HostPortPair> non_spdy_proxies_;
+
+  DISALLOW_COPY_AND_ASSIGN(SpdyProxySessionTracker);
+};
+
 // HttpProxyConnectJob optionally establishes a tunnel through the proxy
 // server after connecting the underlying transport socket.
 class HttpProxyConnectJob : public ConnectJob {
@@ -101,6 +147,7 @@ class HttpProxyConnectJob : public ConnectJob {
                       const base::TimeDelta& timeout_duration,
                       TransportClientSocketPool* transport_pool,
                       SSLClientSocketPool* ssl_pool,
+                      SpdyProxySessionTracker* spdy_proxy_tracker,
                       HostResolver* host_resolver,
                       Delegate* delegate,
                       NetLog* net_log);
@@ -112,11 +159,14 @@ class HttpProxyConnectJob : public ConnectJob {
   virtual void GetAdditionalErrorState(ClientSocketHandle* handle);
 
  private:
+  friend class SpdyProxySessionTracker;
+
   enum State {
     STATE_TCP_CONNECT,
     STATE_TCP_CONNECT_COMPLETE,
     STATE_SSL_CONNECT,
     STATE_SSL_CONNECT_COMPLETE,
+    STATE_SPDY_PROXY_WAIT_FOR_SESSION_COMPLETE,
     STATE_HTTP_PROXY_CONNECT,
     STATE_HTTP_PROXY_CONNECT_COMPLETE,
     STATE_SPDY_PROXY_CREATE_STREAM,
@@ -136,6 +186,7 @@ class HttpProxyConnectJob : public ConnectJob {
   // Connecting to HTTPS Proxy
   int DoSSLConnect();
   int DoSSLConnectComplete(int result);
+  int DoSpdyProxyWaitForSessionComplete(int result);
 
   int DoHttpProxyConnect();
   int DoHttpProxyConnectComplete(int result);
@@ -152,9 +203,13 @@ class HttpProxyConnectJob : public ConnectJob {
   // a standard net error code will be returned.
   virtual int ConnectInternal();
 
+  // Called by |spdy_proxy_tracker_| when the job we were waiting for is done.
+  void OnSpdyProxyConnectDone();
+
   scoped_refptr<HttpProxySocketParams> params_;
   TransportClientSocketPool* const transport_pool_;
   SSLClientSocketPool* const ssl_pool_;
+  SpdyProxySessionTracker* const spdy_proxy_tracker_;
   HostResolver* const resolver_;
 
   State next_state_;
@@ -166,6 +221,7 @@ class HttpProxyConnectJob : public ConnectJob {
   HttpResponseInfo error_response_info_;
 
   scoped_refptr<SpdyStream> spdy_stream_;
+  ScopedRunnableMethodFactory<HttpProxyConnectJob> method_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(HttpProxyConnectJob);
 };
@@ -199,6 +255,10 @@ class HttpProxyClientSocketPool : public ClientSocketPool {
   virtual void CancelRequest(const std::string& group_name,
                              ClientSocketHandle* handle);
 
+  virtual void SetPriority(const std::string& group_name,
+                           ClientSocketHandle* handle,
+                           RequestPriority priority);
+
   virtual void ReleaseSocket(const std::string& group_name,
                              ClientSocket* socket,
                              int id);
@@ -230,6 +290,7 @@ class HttpProxyClientSocketPool : public ClientSocketPool {
     HttpProxyConnectJobFactory(
         TransportClientSocketPool* transport_pool,
         SSLClientSocketPool* ssl_pool,
+        SpdyProxySessionTracker* spdy_proxy_tracker,
         HostResolver* host_resolver,
         NetLog* net_log);
 
@@ -243,6 +304,7 @@ class HttpProxyClientSocketPool : public ClientSocketPool {
    private:
     TransportClientSocketPool* const transport_pool_;
     SSLClientSocketPool* const ssl_pool_;
+    SpdyProxySessionTracker* const spdy_proxy_tracker_;
     HostResolver* const host_resolver_;
     NetLog* net_log_;
     base::TimeDelta timeout_;
@@ -252,6 +314,8 @@ class HttpProxyClientSocketPool : public ClientSocketPool {
 
   TransportClientSocketPool* const transport_pool_;
   SSLClientSocketPool* const ssl_pool_;
+  // Must outlive the connect jobs of |base_|.
+  SpdyProxySessionTracker spdy_proxy_tracker_;
   PoolBase base_;
 
   DISALLOW_COPY_AND_ASSIGN(HttpProxyClientSocketPool);
@@ -140,6 +140,25 @@ class HttpProxyClientSocketPoolTest : public TestWithHttpParam {
     return GetParams(false);
   }
 
+  // Returns tunnel params for a proxy that we would like to speak SPDY with.
+  scoped_refptr<HttpProxySocketParams> GetWantSpdyTunnelParams() {
+    scoped_refptr<SSLSocketParams> ssl_params(new SSLSocketParams(
+        ignored_transport_socket_params_, NULL, NULL,
+        ProxyServer::SCHEME_DIRECT, HostPortPair("www.google.com", 443),
+        ssl_config_, 0, false, true));
+    return scoped_refptr<HttpProxySocketParams>(
+        new HttpProxySocketParams(
+            NULL,
+            ssl_params,
+            GURL("https://www.google.com/"),
+            "",
+            HostPortPair("www.google.com", 443),
+            session_->http_auth_cache(),
+            session_->http_auth_handler_factory(),
+            session_->spdy_session_pool(),
+            true));
+  }
+
   DeterministicMockClientSocketFactory& socket_factory() {
     return socket_factory_;
   }
@@ -362,6 +381,48 @@ TEST_P(HttpProxyClientSocketPoolTest, AsyncHaveAuth) {
   EXPECT_TRUE(tunnel_socket->IsConnected());
 }
 
+// A tunnel that is requested while the first connection to a proxy that may
+// speak SPDY is being set up is opened on the same SPDY session.
+TEST_P(HttpProxyClientSocketPoolTest, SpdyTunnelsShareSession) {
+  if (GetParam() != SPDY) return;
+
+  scoped_ptr<spdy::SpdyFrame> req1(ConstructSpdyConnect(NULL, 0, 1));
+  scoped_ptr<spdy::SpdyFrame> req2(ConstructSpdyConnect(NULL, 0, 3));
+  MockWrite spdy_writes[] = {
+    CreateMockWrite(*req1, 0, true),
+    CreateMockWrite(*req2, 1, true),
+  };
+  scoped_ptr<spdy::SpdyFrame> resp1(ConstructSpdyGetSynReply(NULL, 0, 1));
+  scoped_ptr<spdy::SpdyFrame> resp2(ConstructSpdyGetSynReply(NULL, 0, 3));
+  MockRead spdy_reads[] = {
+    CreateMockRead(*resp1, 2, true),
+    CreateMockRead(*resp2, 3, true),
+    MockRead(true, 0, 4)
+  };
+
+  // Only one connection to the proxy is available.
+  Initialize(true, NULL, 0, NULL, 0, spdy_reads, arraysize(spdy_reads),
+             spdy_writes, arraysize(spdy_writes));
+
+  int rv = handle_.Init("a", GetWantSpdyTunnelParams(), LOW, &callback_,
+                        &pool_, BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+
+  ClientSocketHandle handle2;
+  TestCompletionCallback callback2;
+  rv = handle2.Init("b", GetWantSpdyTunnelParams(), LOW, &callback2, &pool_,
+                    BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+
+  data_->RunFor(4);
+  EXPECT_EQ(OK, callback_.WaitForResult());
+  EXPECT_EQ(OK, callback2.WaitForResult());
+  ASSERT_TRUE(handle_.socket());
+  ASSERT_TRUE(handle2.socket());
+  EXPECT_TRUE(handle_.socket()->IsConnected());
+  EXPECT_TRUE(handle2.socket()->IsConnected());
+}
+
 TEST_P(HttpProxyClientSocketPoolTest, TCPError) {
   if (GetParam() == SPDY) return;
   data_ = new DeterministicSocketData(NULL, 0, NULL, 0);
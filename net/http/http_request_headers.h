@@ -61,6 +61,7 @@ class NET_EXPORT HttpRequestHeaders {
   static const char kAcceptLanguage[];
   static const char kCacheControl[];
   static const char kConnection[];
+  static const char kContentEncoding[];
   static const char kContentType[];
   static const char kCookie[];
   static const char kContentLength[];
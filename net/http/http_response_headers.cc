@@ -114,6 +114,17 @@ int MapHttpResponseCode(int code) {
   return 0;
 }
 
+// The header index has at least this number of slots, and it is kept at most
+// half full.
+const size_t kMinHeaderIndexSize = 16;
+
+size_t HashHeaderName(const base::StringPiece& name) {
+  size_t hash = 0;
+  for (size_t i = 0; i < name.size(); ++i)
+    hash = hash * 31 + base::ToLowerASCII(name[i]);
+  return hash;
+}
+
 }  // namespace
 
 struct HttpResponseHeaders::ParsedHeader {
@@ -121,10 +132,18 @@ struct HttpResponseHeaders::ParsedHeader {
   // preceding header.  (Header values are comma separated.)
   bool is_continuation() const { return name_begin == name_end; }
 
+  base::StringPiece name() const {
+    return base::StringPiece(&*name_begin, name_end - name_begin);
+  }
+
   std::string::const_iterator name_begin;
   std::string::const_iterator name_end;
   std::string::const_iterator value_begin;
   std::string::const_iterator value_end;
+
+  // The index in parsed_ of the next header with the same name, or
+  // string::npos.
+  size_t next;
 };
 
 //-----------------------------------------------------------------------------
@@ -325,6 +344,7 @@ void HttpResponseHeaders::ReplaceStatusLine(const std::string& new_status) {
 
 void HttpResponseHeaders::Parse(const std::string& raw_input) {
   raw_headers_.reserve(raw_input.size());
+  header_index_.clear();
 
   // ParseStatusLine adds a normalized status line to raw_headers_
   std::string::const_iterator line_begin = raw_input.begin();
@@ -360,6 +380,8 @@ void HttpResponseHeaders::Parse(const std::string& raw_input) {
               headers.values_begin(),
               headers.values_end());
   }
+
+  BuildHeaderIndex();
 }
 
 // Append all of our headers to the final output string.
@@ -485,6 +507,15 @@ bool HttpResponseHeaders::EnumerateHeaderLines(void** iter,
 
 bool HttpResponseHeaders::EnumerateHeader(void** iter, const std::string& name,
                                           std::string* value) const {
+  base::StringPiece value_piece;
+  bool found = EnumerateHeader(iter, base::StringPiece(name), &value_piece);
+  value_piece.CopyToString(value);
+  return found;
+}
+
+bool HttpResponseHeaders::EnumerateHeader(void** iter,
+                                          const base::StringPiece& name,
+                                          base::StringPiece* value) const {
   size_t i;
   if (!iter || !*iter) {
     i = FindHeader(0, name);
@@ -504,7 +535,9 @@ bool HttpResponseHeaders::EnumerateHeader(void** iter, const std::string& name,
 
   if (iter)
     *iter = reinterpret_cast<void*>(i + 1);
-  value->assign(parsed_[i].value_begin, parsed_[i].value_end);
+  const std::string::const_iterator& value_begin = parsed_[i].value_begin;
+  value->set(value_begin == parsed_[i].value_end ? NULL : &*value_begin,
+             parsed_[i].value_end - value_begin);
   return true;
 }
 
@@ -513,8 +546,8 @@ bool HttpResponseHeaders::HasHeaderValue(const std::string& name,
   // The value has to be an exact match.  This is important since
   // 'cache-control: no-cache' != 'cache-control: no-cache="foo"'
   void* iter = NULL;
-  std::string temp;
-  while (EnumerateHeader(&iter, name, &temp)) {
+  base::StringPiece temp;
+  while (EnumerateHeader(&iter, base::StringPiece(name), &temp)) {
     if (value.size() == temp.size() &&
         std::equal(temp.begin(), temp.end(), value.begin(),
                    base::CaseInsensitiveCompare<char>()))
@@ -654,19 +687,55 @@ void HttpResponseHeaders::ParseStatusLine(
 }
 
 size_t HttpResponseHeaders::FindHeader(size_t from,
-                                       const std::string& search) const {
-  for (size_t i = from; i < parsed_.size(); ++i) {
+                                       const base::StringPiece& search) const {
+  if (header_index_.empty())
+    return std::string::npos;
+
+  size_t i = header_index_[FindIndexSlot(search)];
+  while (i != std::string::npos && i < from)
+    i = parsed_[i].next;
+  return i;
+}
+
+void HttpResponseHeaders::BuildHeaderIndex() {
+  size_t size = kMinHeaderIndexSize;
+  while (size < parsed_.size() * 2)
+    size *= 2;
+  header_index_.assign(size, std::string::npos);
+
+  // The last header seen for each slot.
+  std::vector<size_t> last_header(size, std::string::npos);
+  for (size_t i = 0; i < parsed_.size(); ++i) {
     if (parsed_[i].is_continuation())
       continue;
-    const std::string::const_iterator& name_begin = parsed_[i].name_begin;
-    const std::string::const_iterator& name_end = parsed_[i].name_end;
-    if (static_cast<size_t>(name_end - name_begin) == search.size() &&
-        std::equal(name_begin, name_end, search.begin(),
-                   base::CaseInsensitiveCompare<char>()))
-      return i;
+
+    size_t slot = FindIndexSlot(parsed_[i].name());
+    if (header_index_[slot] == std::string::npos) {
+      header_index_[slot] = i;
+    } else {
+      parsed_[last_header[slot]].next = i;
+    }
+    last_header[slot] = i;
   }
+}
+
+size_t HttpResponseHeaders::FindIndexSlot(
+    const base::StringPiece& name) const {
+  DCHECK(!header_index_.empty());
+  size_t mask = header_index_.size() - 1;
+  size_t slot = HashHeaderName(name) & mask;
+  for (;;) {
+    size_t i = header_index_[slot];
+    if (i == std::string::npos)
+      return slot;
 
-  return std::string::npos;
+    base::StringPiece header_name = parsed_[i].name();
+    if (header_name.size() == name.size() &&
+        std::equal(header_name.begin(), header_name.end(), name.begin(),
+                   base::CaseInsensitiveCompare<char>()))
+      return slot;
+    slot = (slot + 1) & mask;
+  }
 }
 
 void HttpResponseHeaders::AddHeader(std::string::const_iterator name_begin,
@@ -696,6 +765,7 @@ void HttpResponseHeaders::AddToParsed(std::string::const_iterator name_begin,
   header.name_end = name_end;
   header.value_begin = value_begin;
   header.value_end = value_end;
+  header.next = std::string::npos;
   parsed_.push_back(header);
 }
 
@@ -847,6 +917,28 @@ bool HttpResponseHeaders::RequiresValidation(const Time& request_time,
   return lifetime <= GetCurrentAge(request_time, response_time, current_time);
 }
 
+bool HttpResponseHeaders::IsUsableWhileRevalidating(
+    const Time& request_time,
+    const Time& response_time,
+    const Time& current_time) const {
+  TimeDelta stale_while_revalidate;
+  if (!GetStaleWhileRevalidateValue(&stale_while_revalidate))
+    return false;
+
+  // A response that is never fresh, or that has to be revalidated once it
+  // becomes stale, cannot be used.
+  if (HasHeaderValue("cache-control", "no-cache") ||
+      HasHeaderValue("cache-control", "no-store") ||
+      HasHeaderValue("cache-control", "must-revalidate") ||
+      HasHeaderValue("pragma", "no-cache") ||
+      HasHeaderValue("vary", "*"))
+    return false;
+
+  TimeDelta lifetime = GetFreshnessLifetime(response_time);
+  return lifetime + stale_while_revalidate >
+         GetCurrentAge(request_time, response_time, current_time);
+}
+
 // From RFC 2616 section 13.2.4:
 //
 // The max-age directive takes priority over Expires, so if max-age is present
@@ -993,8 +1085,8 @@ TimeDelta HttpResponseHeaders::GetCurrentAge(const Time& request_time,
 }
 
 bool HttpResponseHeaders::GetMaxAgeValue(TimeDelta* result) const {
-  std::string name = "cache-control";
-  std::string value;
+  base::StringPiece name("cache-control");
+  base::StringPiece value;
 
   const char kMaxAgePrefix[] = "max-age=";
   const size_t kMaxAgePrefixLen = arraysize(kMaxAgePrefix) - 1;
@@ -1018,13 +1110,43 @@ bool HttpResponseHeaders::GetMaxAgeValue(TimeDelta* result) const {
   return false;
 }
 
+bool HttpResponseHeaders::GetStaleWhileRevalidateValue(
+    TimeDelta* result) const {
+  base::StringPiece name("cache-control");
+  base::StringPiece value;
+
+  const char kPrefix[] = "stale-while-revalidate=";
+  const size_t kPrefixLen = arraysize(kPrefix) - 1;
+
+  void* iter = NULL;
+  while (EnumerateHeader(&iter, name, &value)) {
+    if (value.size() > kPrefixLen) {
+      if (LowerCaseEqualsASCII(value.begin(),
+                               value.begin() + kPrefixLen,
+                               kPrefix)) {
+        int64 seconds;
+        if (!base::StringToInt64(value.begin() + kPrefixLen,
+                                 value.end(),
+                                 &seconds) ||
+            seconds < 0) {
+          return false;
+        }
+        *result = TimeDelta::FromSeconds(seconds);
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
 bool HttpResponseHeaders::GetAgeValue(TimeDelta* result) const {
-  std::string value;
-  if (!EnumerateHeader(NULL, "Age", &value))
+  base::StringPiece value;
+  if (!EnumerateHeader(NULL, base::StringPiece("Age"), &value))
     return false;
 
   int64 seconds;
-  base::StringToInt64(value, &seconds);
+  base::StringToInt64(value.begin(), value.end(), &seconds);
   *result = TimeDelta::FromSeconds(seconds);
   return true;
 }
@@ -1058,18 +1180,21 @@ bool HttpResponseHeaders::IsKeepAlive() const {
   // NOTE: It is perhaps risky to assume that a Proxy-Connection header is
   // meaningful when we don't know that this response was from a proxy, but
   // Mozilla also does this, so we'll do the same.
-  std::string connection_val;
-  if (!EnumerateHeader(NULL, "connection", &connection_val))
-    EnumerateHeader(NULL, "proxy-connection", &connection_val);
+  base::StringPiece connection_val;
+  if (!EnumerateHeader(NULL, base::StringPiece("connection"), &connection_val))
+    EnumerateHeader(NULL, base::StringPiece("proxy-connection"),
+                    &connection_val);
 
   bool keep_alive;
 
   if (http_version_ == HttpVersion(1, 0)) {
     // HTTP/1.0 responses default to NOT keep-alive
-    keep_alive = LowerCaseEqualsASCII(connection_val, "keep-alive");
+    keep_alive = LowerCaseEqualsASCII(connection_val.begin(),
+                                      connection_val.end(), "keep-alive");
   } else {
     // HTTP/1.1 responses default to keep-alive
-    keep_alive = !LowerCaseEqualsASCII(connection_val, "close");
+    keep_alive = !LowerCaseEqualsASCII(connection_val.begin(),
+                                       connection_val.end(), "close");
   }
 
   return keep_alive;
@@ -1105,9 +1230,11 @@ bool HttpResponseHeaders::HasStrongValidators() const {
 // Content-Length = "Content-Length" ":" 1*DIGIT
 int64 HttpResponseHeaders::GetContentLength() const {
   void* iter = NULL;
-  std::string content_length_val;
-  if (!EnumerateHeader(&iter, "content-length", &content_length_val))
+  base::StringPiece content_length_val;
+  if (!EnumerateHeader(&iter, base::StringPiece("content-length"),
+                       &content_length_val)) {
     return -1;
+  }
 
   if (content_length_val.empty())
     return -1;
@@ -1116,7 +1243,8 @@ int64 HttpResponseHeaders::GetContentLength() const {
     return -1;
 
   int64 result;
-  bool ok = base::StringToInt64(content_length_val, &result);
+  bool ok = base::StringToInt64(content_length_val.begin(),
+                                content_length_val.end(), &result);
   if (!ok || result < 0)
     return -1;
 
@@ -12,6 +12,7 @@
 #include "base/basictypes.h"
 #include "base/hash_tables.h"
 #include "base/memory/ref_counted.h"
+#include "base/string_piece.h"
 #include "net/base/net_export.h"
 #include "net/http/http_version.h"
 
@@ -154,6 +155,13 @@ class NET_EXPORT HttpResponseHeaders
                        const std::string& name,
                        std::string* value) const;
 
+  // Same as above, but |value| points into the stored headers instead of
+  // receiving a copy of the value, so it is only valid until this object is
+  // modified or destroyed.
+  bool EnumerateHeader(void** iter,
+                       const base::StringPiece& name,
+                       base::StringPiece* value) const;
+
   // Returns true if the response contains the specified header-value pair.
   // Both name and value are compared case insensitively.
   bool HasHeaderValue(const std::string& name, const std::string& value) const;
@@ -192,6 +200,14 @@ class NET_EXPORT HttpResponseHeaders
                           const base::Time& response_time,
                           const base::Time& current_time) const;
 
+  // Returns true if a response that requires validation can still be used
+  // while it is validated in the background, as allowed by the
+  // stale-while-revalidate Cache-Control extension (RFC 5861). See
+  // RequiresValidation for a description of this method's parameters.
+  bool IsUsableWhileRevalidating(const base::Time& request_time,
+                                 const base::Time& response_time,
+                                 const base::Time& current_time) const;
+
   // Returns the amount of time the server claims the response is fresh from
   // the time the response was generated.  See section 13.2.4 of RFC 2616.  See
   // RequiresValidation for a description of the response_time parameter.
@@ -207,6 +223,7 @@ class NET_EXPORT HttpResponseHeaders
   // value is not present, then false is returned.  Otherwise, true is returned
   // and the out param is assigned to the corresponding value.
   bool GetMaxAgeValue(base::TimeDelta* value) const;
+  bool GetStaleWhileRevalidateValue(base::TimeDelta* value) const;
   bool GetAgeValue(base::TimeDelta* value) const;
   bool GetDateValue(base::Time* value) const;
   bool GetLastModifiedValue(base::Time* value) const;
@@ -281,7 +298,14 @@ class NET_EXPORT HttpResponseHeaders
 
   // Find the header in our list (case-insensitive) starting with parsed_ at
   // index |from|.  Returns string::npos if not found.
-  size_t FindHeader(size_t from, const std::string& name) const;
+  size_t FindHeader(size_t from, const base::StringPiece& name) const;
+
+  // Builds header_index_ for the current contents of parsed_.
+  void BuildHeaderIndex();
+
+  // Returns the slot of header_index_ for |name|: either the slot that holds
+  // that header, or the empty slot where it should go.
+  size_t FindIndexSlot(const base::StringPiece& name) const;
 
   // Add a header->value pair to our list.  If we already have header in our
   // list, append the value to it.
@@ -325,6 +349,11 @@ class NET_EXPORT HttpResponseHeaders
   // header-value pairs within raw_headers_.
   HeaderList parsed_;
 
+  // Open-addressed hash table from a (case-insensitive) header name to the
+  // index in parsed_ of the first header with that name, or string::npos for
+  // empty slots. The other headers with the same name are linked from there.
+  std::vector<size_t> header_index_;
+
   // The raw_headers_ consists of the normalized status line (terminated with a
   // null byte) and then followed by the raw null-terminated headers from the
   // input that was passed to our constructor.  We preserve the input [*] to
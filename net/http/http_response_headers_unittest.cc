@@ -6,6 +6,7 @@
 
 #include "base/basictypes.h"
 #include "base/pickle.h"
+#include "base/stringprintf.h"
 #include "base/time.h"
 #include "net/http/http_response_headers.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -520,6 +521,40 @@ TEST(HttpResponseHeadersTest, EnumerateHeader_DateValued) {
   EXPECT_EQ("Wed, 01 Aug 2007 23:23:45 GMT", value);
 }
 
+TEST(HttpResponseHeadersTest, EnumerateHeader_ManyHeaders) {
+  // Enough headers to make the header index grow, with repeated names that
+  // are not next to each other.
+  std::string headers = "HTTP/1.1 200 OK\n";
+  for (int i = 0; i < 20; ++i) {
+    headers.append(StringPrintf("X-Header-%d: value%d\n", i, i));
+    if (i % 5 == 0)
+      headers.append(StringPrintf("x-repeated: r%d\n", i));
+  }
+  HeadersToRaw(&headers);
+  scoped_refptr<net::HttpResponseHeaders> parsed(
+      new net::HttpResponseHeaders(headers));
+
+  for (int i = 0; i < 20; ++i) {
+    base::StringPiece value;
+    EXPECT_TRUE(parsed->EnumerateHeader(
+        NULL, base::StringPiece(StringPrintf("x-HEADER-%d", i)), &value));
+    EXPECT_EQ(StringPrintf("value%d", i), value.as_string());
+  }
+
+  void* iter = NULL;
+  base::StringPiece value;
+  base::StringPiece name("X-Repeated");
+  for (int i = 0; i < 20; i += 5) {
+    EXPECT_TRUE(parsed->EnumerateHeader(&iter, name, &value));
+    EXPECT_EQ(StringPrintf("r%d", i), value.as_string());
+  }
+  EXPECT_FALSE(parsed->EnumerateHeader(&iter, name, &value));
+  EXPECT_TRUE(value.empty());
+
+  EXPECT_FALSE(parsed->HasHeader("x-header-20"));
+  EXPECT_TRUE(parsed->HasHeaderValue("x-repeated", "R15"));
+}
+
 TEST(HttpResponseHeadersTest, GetMimeType) {
   const ContentTypeTestData tests[] = {
     { "HTTP/1.1 200 OK\n"
@@ -815,6 +850,85 @@ TEST(HttpResponseHeadersTest, RequiresValidation) {
   }
 }
 
+TEST(HttpResponseHeadersTest, IsUsableWhileRevalidating) {
+  const struct {
+    const char* headers;
+    bool usable;
+  } tests[] = {
+    // no stale-while-revalidate
+    { "HTTP/1.1 200 OK\n"
+      "cache-control: max-age=0\n"
+      "\n",
+      false
+    },
+    // within the stale-while-revalidate window
+    { "HTTP/1.1 200 OK\n"
+      "cache-control: max-age=60, stale-while-revalidate=3600\n"
+      "\n",
+      true
+    },
+    // expired already, but within the window
+    { "HTTP/1.1 200 OK\n"
+      "date: Wed, 28 Nov 2007 00:40:11 GMT\n"
+      "expires: Wed, 28 Nov 2007 00:00:00 GMT\n"
+      "cache-control: stale-while-revalidate=3600\n"
+      "\n",
+      true
+    },
+    // past the window
+    { "HTTP/1.1 200 OK\n"
+      "cache-control: max-age=60, stale-while-revalidate=60\n"
+      "\n",
+      false
+    },
+    // must-revalidate wins
+    { "HTTP/1.1 200 OK\n"
+      "cache-control: max-age=0, stale-while-revalidate=3600\n"
+      "cache-control: must-revalidate\n"
+      "\n",
+      false
+    },
+    // no-cache wins
+    { "HTTP/1.1 200 OK\n"
+      "cache-control: no-cache, stale-while-revalidate=3600\n"
+      "\n",
+      false
+    },
+    // malformed windows are ignored
+    { "HTTP/1.1 200 OK\n"
+      "cache-control: max-age=60, stale-while-revalidate=3600x\n"
+      "\n",
+      false
+    },
+    { "HTTP/1.1 200 OK\n"
+      "cache-control: max-age=60, stale-while-revalidate=abc\n"
+      "\n",
+      false
+    },
+    { "HTTP/1.1 200 OK\n"
+      "cache-control: max-age=60, stale-while-revalidate=-3600\n"
+      "\n",
+      false
+    },
+  };
+  base::Time request_time, response_time, current_time;
+  base::Time::FromString(L"Wed, 28 Nov 2007 00:40:09 GMT", &request_time);
+  base::Time::FromString(L"Wed, 28 Nov 2007 00:40:12 GMT", &response_time);
+  base::Time::FromString(L"Wed, 28 Nov 2007 00:45:20 GMT", &current_time);
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(tests); ++i) {
+    std::string headers(tests[i].headers);
+    HeadersToRaw(&headers);
+    scoped_refptr<net::HttpResponseHeaders> parsed(
+        new net::HttpResponseHeaders(headers));
+
+    bool usable = parsed->IsUsableWhileRevalidating(request_time,
+                                                    response_time,
+                                                    current_time);
+    EXPECT_EQ(tests[i].usable, usable);
+  }
+}
+
 TEST(HttpResponseHeadersTest, Update) {
   const struct {
     const char* orig_headers;
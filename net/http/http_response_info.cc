@@ -55,6 +55,9 @@ enum {
   // This bit is set if the request was fetched via an explicit proxy.
   RESPONSE_INFO_WAS_PROXY = 1 << 15,
 
+  // This bit is set if the cache stored the response body compressed.
+  RESPONSE_INFO_BODY_COMPRESSED = 1 << 16,
+
   // TODO(darin): Add other bits to indicate alternate request methods.
   // For now, we don't support storing those.
 };
@@ -63,7 +66,8 @@ HttpResponseInfo::HttpResponseInfo()
     : was_cached(false),
       was_fetched_via_spdy(false),
       was_npn_negotiated(false),
-      was_fetched_via_proxy(false) {
+      was_fetched_via_proxy(false),
+      body_stored_compressed(false) {
 }
 
 HttpResponseInfo::HttpResponseInfo(const HttpResponseInfo& rhs)
@@ -71,6 +75,7 @@ HttpResponseInfo::HttpResponseInfo(const HttpResponseInfo& rhs)
       was_fetched_via_spdy(rhs.was_fetched_via_spdy),
       was_npn_negotiated(rhs.was_npn_negotiated),
       was_fetched_via_proxy(rhs.was_fetched_via_proxy),
+      body_stored_compressed(rhs.body_stored_compressed),
       socket_address(rhs.socket_address),
       request_time(rhs.request_time),
       response_time(rhs.response_time),
@@ -90,6 +95,7 @@ HttpResponseInfo& HttpResponseInfo::operator=(const HttpResponseInfo& rhs) {
   was_fetched_via_spdy = rhs.was_fetched_via_spdy;
   was_npn_negotiated = rhs.was_npn_negotiated;
   was_fetched_via_proxy = rhs.was_fetched_via_proxy;
+  body_stored_compressed = rhs.body_stored_compressed;
   socket_address = rhs.socket_address;
   request_time = rhs.request_time;
   response_time = rhs.response_time;
@@ -179,6 +185,8 @@ bool HttpResponseInfo::InitFromPickle(const Pickle& pickle,
 
   was_fetched_via_proxy = (flags & RESPONSE_INFO_WAS_PROXY) != 0;
 
+  body_stored_compressed = (flags & RESPONSE_INFO_BODY_COMPRESSED) != 0;
+
   *response_truncated = (flags & RESPONSE_INFO_TRUNCATED) ? true : false;
 
   return true;
@@ -205,6 +213,8 @@ void HttpResponseInfo::Persist(Pickle* pickle,
     flags |= RESPONSE_INFO_WAS_NPN;
   if (was_fetched_via_proxy)
     flags |= RESPONSE_INFO_WAS_PROXY;
+  if (body_stored_compressed)
+    flags |= RESPONSE_INFO_BODY_COMPRESSED;
 
   pickle->WriteInt(flags);
   pickle->WriteInt64(request_time.ToInternalValue());
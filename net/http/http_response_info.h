@@ -58,6 +58,11 @@ class NET_EXPORT HttpResponseInfo {
   // transparent proxy may have been involved.
   bool was_fetched_via_proxy;
 
+  // True if the body of this response is stored compressed by the cache. This
+  // describes only how the cache stores the body; the data returned to the
+  // caller is never affected.
+  bool body_stored_compressed;
+
   // Remote address of the socket which fetched this resource.
   //
   // NOTE: If the response was served from the cache (was_cached is true),
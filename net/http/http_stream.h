@@ -18,6 +18,7 @@
 
 #include "base/basictypes.h"
 #include "net/base/completion_callback.h"
+#include "net/base/request_priority.h"
 
 namespace net {
 
@@ -26,6 +27,7 @@ class HttpRequestHeaders;
 struct HttpRequestInfo;
 class HttpResponseInfo;
 class IOBuffer;
+struct LoadTimingInfo;
 class SSLCertRequestInfo;
 class SSLInfo;
 class UploadDataStream;
@@ -120,6 +122,11 @@ class HttpStream {
   // allows it to be reused.
   virtual bool IsConnectionReusable() const = 0;
 
+  // Fills in the parts of |load_timing_info| that belong to the connection
+  // (whether it was reused, and how it was connected) and, if known, when the
+  // response headers started arriving.  Leaves the other fields alone.
+  virtual void GetLoadTimingInfo(LoadTimingInfo* load_timing_info) const = 0;
+
   // Get the SSLInfo associated with this stream's connection.  This should
   // only be called for streams over SSL sockets, otherwise the behavior is
   // undefined.
@@ -130,6 +137,10 @@ class HttpStream {
   // behavior is undefined.
   virtual void GetSSLCertRequestInfo(SSLCertRequestInfo* cert_request_info) = 0;
 
+  // Changes the priority of the frames that are still to be sent for this
+  // stream. Streams that do not share their connection ignore it.
+  virtual void SetPriority(RequestPriority priority) = 0;
+
   // HACK(willchan): Really, we should move the HttpResponseDrainer logic into
   // the HttpStream implementation. This is just a quick hack.
   virtual bool IsSpdyHttpStream() const = 0;
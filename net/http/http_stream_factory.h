@@ -12,6 +12,7 @@
 #include "base/string16.h"
 #include "net/base/completion_callback.h"
 #include "net/base/load_states.h"
+#include "net/base/request_priority.h"
 
 class GURL;
 
@@ -135,6 +136,10 @@ class HttpStreamRequest {
   // Returns the LoadState for the request.
   virtual LoadState GetLoadState() const = 0;
 
+  // Changes the priority of the request. This affects the socket request if
+  // it is still waiting in a socket pool.
+  virtual void SetPriority(RequestPriority priority) = 0;
+
   // Returns true if TLS/NPN was negotiated for this stream.
   virtual bool was_npn_negotiated() const = 0;
 
@@ -223,6 +228,22 @@ class HttpStreamFactory {
     return ignore_certificate_errors_;
   }
 
+  // Controls whether or not we pipeline HTTP/1.1 requests to origins that
+  // support it.
+  static void set_http_pipelining_enabled(bool value) {
+    http_pipelining_enabled_ = value;
+  }
+  static bool http_pipelining_enabled() { return http_pipelining_enabled_; }
+
+  // When a connection to the first proxy in a list hasn't completed within
+  // |value| milliseconds, a connection to the rest of the list is started
+  // in parallel, and whichever completes first is used. 0, the default,
+  // turns this off.
+  static void set_proxy_race_delay_ms(int value) {
+    proxy_race_delay_ms_ = value;
+  }
+  static int proxy_race_delay_ms() { return proxy_race_delay_ms_; }
+
   static void SetHostMappingRules(const std::string& rules);
 
  protected:
@@ -239,6 +260,8 @@ class HttpStreamFactory {
   static bool force_spdy_always_;
   static std::list<HostPortPair>* forced_spdy_exclusions_;
   static bool ignore_certificate_errors_;
+  static bool http_pipelining_enabled_;
+  static int proxy_race_delay_ms_;
 
   DISALLOW_COPY_AND_ASSIGN(HttpStreamFactory);
 };
@@ -10,6 +10,7 @@
 
 #include "base/memory/ref_counted.h"
 #include "net/base/host_port_pair.h"
+#include "net/http/http_pipelined_host_pool.h"
 #include "net/http/http_stream_factory.h"
 #include "net/base/net_log.h"
 #include "net/proxy/proxy_server.h"
@@ -99,6 +100,9 @@ class HttpStreamFactoryImpl : public HttpStreamFactory {
   // deleted when the factory is destroyed.
   std::set<const Job*> preconnect_job_set_;
 
+  // The pipelined connections, for origins that support HTTP pipelining.
+  HttpPipelinedHostPool http_pipelined_host_pool_;
+
   DISALLOW_COPY_AND_ASSIGN(HttpStreamFactoryImpl);
 };
 
@@ -10,11 +10,14 @@
 #include "base/stringprintf.h"
 #include "base/values.h"
 #include "net/base/connection_type_histograms.h"
+#include "net/base/load_flags.h"
 #include "net/base/net_log.h"
 #include "net/base/net_util.h"
 #include "net/base/ssl_cert_request_info.h"
 #include "net/http/http_basic_stream.h"
 #include "net/http/http_network_session.h"
+#include "net/http/http_pipelined_host_pool.h"
+#include "net/http/http_pipelined_stream.h"
 #include "net/http/http_proxy_client_socket.h"
 #include "net/http/http_proxy_client_socket_pool.h"
 #include "net/http/http_request_info.h"
@@ -60,7 +63,10 @@ HttpStreamFactoryImpl::Job::Job(HttpStreamFactoryImpl* stream_factory,
       establishing_tunnel_(false),
       was_npn_negotiated_(false),
       num_streams_(0),
+      spdy_alias_checked_(false),
       spdy_session_direct_(false),
+      has_proxy_info_(false),
+      started_proxy_race_(false),
       ALLOW_THIS_IN_INITIALIZER_LIST(method_factory_(this)) {
   DCHECK(stream_factory);
   DCHECK(session);
@@ -91,6 +97,15 @@ void HttpStreamFactoryImpl::Job::Start(Request* request) {
   StartInternal();
 }
 
+void HttpStreamFactoryImpl::Job::StartWithProxyInfo(
+    Request* request, const ProxyInfo& proxy_info) {
+  DCHECK(request);
+  request_ = request;
+  proxy_info_ = proxy_info;
+  has_proxy_info_ = true;
+  StartInternal();
+}
+
 int HttpStreamFactoryImpl::Job::Preconnect(int num_streams) {
   DCHECK_GT(num_streams, 0);
   num_streams_ = num_streams;
@@ -109,6 +124,8 @@ LoadState HttpStreamFactoryImpl::Job::GetLoadState() const {
   switch (next_state_) {
     case STATE_RESOLVE_PROXY_COMPLETE:
       return LOAD_STATE_RESOLVING_PROXY_FOR_URL;
+    case STATE_RESOLVE_HOST_COMPLETE:
+      return LOAD_STATE_RESOLVING_HOST;
     case STATE_CREATE_STREAM_COMPLETE:
       return connection_->GetLoadState();
     case STATE_INIT_CONNECTION_COMPLETE:
@@ -118,6 +135,12 @@ LoadState HttpStreamFactoryImpl::Job::GetLoadState() const {
   }
 }
 
+void HttpStreamFactoryImpl::Job::SetPriority(RequestPriority priority) {
+  request_info_.priority = priority;
+  if (next_state_ == STATE_INIT_CONNECTION_COMPLETE)
+    connection_->SetPriority(priority);
+}
+
 void HttpStreamFactoryImpl::Job::MarkAsAlternate(const GURL& original_url) {
   DCHECK(!original_url_.get());
   original_url_.reset(new GURL(original_url));
@@ -405,6 +428,13 @@ int HttpStreamFactoryImpl::Job::DoLoop(int result) {
       case STATE_WAIT_FOR_JOB_COMPLETE:
         rv = DoWaitForJobComplete(rv);
         break;
+      case STATE_RESOLVE_HOST:
+        DCHECK_EQ(OK, rv);
+        rv = DoResolveHost();
+        break;
+      case STATE_RESOLVE_HOST_COMPLETE:
+        rv = DoResolveHostComplete(rv);
+        break;
       case STATE_INIT_CONNECTION:
         DCHECK_EQ(OK, rv);
         rv = DoInitConnection();
@@ -457,6 +487,9 @@ int HttpStreamFactoryImpl::Job::DoResolveProxy() {
   origin_ = HostPortPair(request_info_.url.HostNoBrackets(),
                          request_info_.url.EffectiveIntPort());
 
+  if (has_proxy_info_)
+    return OK;
+
   if (request_info_.load_flags & LOAD_BYPASS_PROXY) {
     proxy_info_.UseDirect();
     return OK;
@@ -507,6 +540,23 @@ bool HttpStreamFactoryImpl::Job::ShouldForceSpdyWithoutSSL() const {
   return rv && !HttpStreamFactory::HasSpdyExclusion(origin_);
 }
 
+bool HttpStreamFactoryImpl::Job::ShouldResolveForSpdyAlias() const {
+  if (spdy_alias_checked_ || !session_->host_resolver())
+    return false;
+  // Through a proxy, the origin is resolved by the proxy.
+  if (!proxy_info_.is_direct())
+    return false;
+  if (!using_ssl_ && !ShouldForceSpdyWithoutSSL())
+    return false;
+  // These loads make the socket pool skip the host cache, so resolving here
+  // would only add a lookup.
+  if (request_info_.load_flags &
+      (LOAD_BYPASS_CACHE | LOAD_VALIDATE_CACHE | LOAD_DISABLE_CACHE)) {
+    return false;
+  }
+  return session_->spdy_session_pool()->CanPoolByIP();
+}
+
 int HttpStreamFactoryImpl::Job::DoWaitForJob() {
   DCHECK(blocking_job_);
   next_state_ = STATE_WAIT_FOR_JOB_COMPLETE;
@@ -520,6 +570,27 @@ int HttpStreamFactoryImpl::Job::DoWaitForJobComplete(int result) {
   return OK;
 }
 
+int HttpStreamFactoryImpl::Job::DoResolveHost() {
+  DCHECK(!spdy_alias_checked_);
+  next_state_ = STATE_RESOLVE_HOST_COMPLETE;
+  spdy_alias_checked_ = true;
+
+  if (!host_resolver_.get())
+    host_resolver_.reset(
+        new SingleRequestHostResolver(session_->host_resolver()));
+  HostResolver::RequestInfo info(origin_);
+  info.set_priority(request_info_.priority);
+  info.set_referrer(request_info_.referrer);
+  return host_resolver_->Resolve(info, &addresses_, &io_callback_, net_log_);
+}
+
+int HttpStreamFactoryImpl::Job::DoResolveHostComplete(int result) {
+  // Resolution errors are reported by the socket pool, which resolves the
+  // host again if no SpdySession turns up.
+  next_state_ = STATE_INIT_CONNECTION;
+  return OK;
+}
+
 int HttpStreamFactoryImpl::Job::DoInitConnection() {
   DCHECK(!blocking_job_);
   DCHECK(!connection_->is_initialized());
@@ -547,6 +618,9 @@ int HttpStreamFactoryImpl::Job::DoInitConnection() {
     using_spdy_ = true;
     next_state_ = STATE_CREATE_STREAM;
     return OK;
+  } else if (ShouldResolveForSpdyAlias()) {
+    next_state_ = STATE_RESOLVE_HOST;
+    return OK;
   } else if (request_ && (using_ssl_ || ShouldForceSpdyWithoutSSL())) {
     // Update the spdy session key for the request that launched this job.
     request_->SetSpdySessionKey(spdy_session_key);
@@ -555,6 +629,16 @@ int HttpStreamFactoryImpl::Job::DoInitConnection() {
   // OK, there's no available SPDY session. Let |dependent_job_| resume if it's
   // paused.
 
+  if (ShouldUsePipelining()) {
+    HttpPipelinedStream* stream = stream_factory_->http_pipelined_host_pool_.
+        CreateStreamOnExistingPipeline(origin_);
+    if (stream) {
+      stream_.reset(stream);
+      next_state_ = STATE_CREATE_STREAM_COMPLETE;
+      return OK;
+    }
+  }
+
   if (dependent_job_) {
     dependent_job_->Resume(this);
     dependent_job_ = NULL;
@@ -586,6 +670,12 @@ int HttpStreamFactoryImpl::Job::DoInitConnection() {
         net_log_,
         num_streams_);
   } else {
+    if (ShouldRaceProxyFallback()) {
+      proxy_race_timer_.Start(
+          base::TimeDelta::FromMilliseconds(
+              HttpStreamFactory::proxy_race_delay_ms()),
+          this, &HttpStreamFactoryImpl::Job::OnProxyRaceTimerFired);
+    }
     return ClientSocketPoolManager::InitSocketHandleForHttpRequest(
         request_info_,
         session_,
@@ -606,6 +696,8 @@ int HttpStreamFactoryImpl::Job::DoInitConnectionComplete(int result) {
     return OK;
   }
 
+  proxy_race_timer_.Stop();
+
   // TODO(willchan): Make this a bit more exact. Maybe there are recoverable
   // errors, such as ignoring certificate errors for Alternate-Protocol.
   if (result < 0 && dependent_job_) {
@@ -728,6 +820,12 @@ int HttpStreamFactoryImpl::Job::DoCreateStream() {
   const ProxyServer& proxy_server = proxy_info_.proxy_server();
 
   if (!using_spdy_) {
+    if (ShouldUsePipelining()) {
+      stream_.reset(stream_factory_->http_pipelined_host_pool_.
+                    CreateStreamOnNewPipeline(origin_, connection_.release(),
+                                              net_log_));
+      return OK;
+    }
     bool using_proxy = (proxy_info_.is_http() || proxy_info_.is_https()) &&
         request_info_.url.SchemeIs("http");
     stream_.reset(new HttpBasicStream(connection_.release(), NULL,
@@ -856,6 +954,20 @@ bool HttpStreamFactoryImpl::Job::IsHttpsProxyAndHttpUrl() {
   return request_info_.url.SchemeIs("http");
 }
 
+bool HttpStreamFactoryImpl::Job::ShouldUsePipelining() const {
+  // Only idempotent requests without a body, sent directly to an http origin,
+  // are pipelined, so that they can be safely retried if the pipeline fails.
+  if (!HttpStreamFactory::http_pipelining_enabled() || IsPreconnecting() ||
+      using_ssl_ || using_spdy_ || original_url_.get() ||
+      !proxy_info_.is_direct() || request_info_.upload_data) {
+    return false;
+  }
+  if (request_info_.method != "GET" && request_info_.method != "HEAD")
+    return false;
+  return stream_factory_->http_pipelined_host_pool_.
+      IsHostEligibleForPipelining(origin_);
+}
+
 // Sets several fields of ssl_config for the given origin_server based on the
 // proxy info and other factors.
 void HttpStreamFactoryImpl::Job::InitSSLConfig(
@@ -938,6 +1050,11 @@ int HttpStreamFactoryImpl::Job::ReconsiderProxyAfterError(int error) {
   int rv = session_->proxy_service()->ReconsiderProxyAfterError(
       request_info_.url, &proxy_info_, &io_callback_, &pac_request_,
       net_log_);
+  if (rv == OK && started_proxy_race_) {
+    // The proxy has been marked as bad, and the rest of the list is what the
+    // racing Job is trying already.
+    return error;
+  }
   if (rv == OK || rv == ERR_IO_PENDING) {
     // If the error was during connection setup, there is no socket to
     // disconnect.
@@ -958,6 +1075,41 @@ int HttpStreamFactoryImpl::Job::ReconsiderProxyAfterError(int error) {
   return rv;
 }
 
+bool HttpStreamFactoryImpl::Job::ShouldRaceProxyFallback() {
+  if (HttpStreamFactory::proxy_race_delay_ms() <= 0 || started_proxy_race_)
+    return false;
+  // Alternate-Protocol Jobs, and the Jobs they block, race each other
+  // already.
+  if (!request_ || original_url_.get() || blocking_job_ || dependent_job_)
+    return false;
+  if (proxy_info_.is_direct())
+    return false;
+
+  // The first proxy is only skipped in the copy, so it isn't marked as bad
+  // unless it really fails.
+  proxy_race_info_ = proxy_info_;
+  ProxyRetryInfoMap unused_retry_info;
+  return proxy_race_info_.Fallback(&unused_retry_info);
+}
+
+void HttpStreamFactoryImpl::Job::OnProxyRaceTimerFired() {
+  DCHECK_EQ(STATE_INIT_CONNECTION_COMPLETE, next_state_);
+  DCHECK(!started_proxy_race_);
+  // There is nothing left to race for once the Job is orphaned.
+  if (!request_)
+    return;
+
+  started_proxy_race_ = true;
+  Job* job = new Job(stream_factory_, session_, request_info_, ssl_config_,
+                     net_log_);
+  request_->AttachJob(job);
+  net_log_.AddEvent(
+      NetLog::TYPE_HTTP_STREAM_JOB_RACE_PROXY_FALLBACK,
+      make_scoped_refptr(new NetLogSourceParameter(
+          "source_dependency", job->net_log().source())));
+  job->StartWithProxyInfo(request_, proxy_race_info_);
+}
+
 int HttpStreamFactoryImpl::Job::HandleCertificateError(int error) {
   DCHECK(using_ssl_);
   DCHECK(IsCertificateError(error));
@@ -8,7 +8,10 @@
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/task.h"
+#include "base/timer.h"
+#include "net/base/address_list.h"
 #include "net/base/completion_callback.h"
+#include "net/base/host_resolver.h"
 #include "net/base/net_log.h"
 #include "net/base/ssl_config_service.h"
 #include "net/http/http_alternate_protocols.h"
@@ -45,6 +48,10 @@ class HttpStreamFactoryImpl::Job {
   // notified upon completion if the Job has not been Orphan()'d.
   void Start(Request* request);
 
+  // Like Start(), but connects using |proxy_info| rather than resolving the
+  // proxy. Used for a Job that races the rest of another Job's proxy list.
+  void StartWithProxyInfo(Request* request, const ProxyInfo& proxy_info);
+
   // Preconnect will attempt to request |num_streams| sockets from the
   // appropriate ClientSocketPool.
   int Preconnect(int num_streams);
@@ -53,6 +60,9 @@ class HttpStreamFactoryImpl::Job {
                                  const string16& password);
   LoadState GetLoadState() const;
 
+  // Changes the priority used for the socket request of this Job.
+  void SetPriority(RequestPriority priority);
+
   // Marks this Job as the "alternate" job, from Alternate-Protocol. Tracks the
   // original url so we can mark the Alternate-Protocol as broken if
   // we fail to connect.
@@ -105,6 +115,14 @@ class HttpStreamFactoryImpl::Job {
     STATE_WAIT_FOR_JOB,
     STATE_WAIT_FOR_JOB_COMPLETE,
 
+    // Before connecting to a host that might be served by an existing
+    // SpdySession of another host (same IP address, and a certificate valid
+    // for both), we resolve it so that the SpdySessionPool can find the
+    // session through its IP aliases. The socket pool then gets the addresses
+    // from the host cache if a connection is still needed.
+    STATE_RESOLVE_HOST,
+    STATE_RESOLVE_HOST_COMPLETE,
+
     STATE_INIT_CONNECTION,
     STATE_INIT_CONNECTION_COMPLETE,
     STATE_WAITING_USER_ACTION,
@@ -142,6 +160,8 @@ class HttpStreamFactoryImpl::Job {
   int DoResolveProxyComplete(int result);
   int DoWaitForJob();
   int DoWaitForJobComplete(int result);
+  int DoResolveHost();
+  int DoResolveHostComplete(int result);
   int DoInitConnection();
   int DoInitConnectionComplete(int result);
   int DoWaitingUserAction(int result);
@@ -158,6 +178,16 @@ class HttpStreamFactoryImpl::Job {
 
   bool IsHttpsProxyAndHttpUrl();
 
+  // Returns true if the request may be sent on a pipelined connection.
+  bool ShouldUsePipelining() const;
+
+  // Returns true, and sets |proxy_race_info_| to the proxies after the first,
+  // if a Job should be started to try them when the first is slow to connect.
+  bool ShouldRaceProxyFallback();
+
+  // Starts the Job that tries |proxy_race_info_|.
+  void OnProxyRaceTimerFired();
+
 // Sets several fields of ssl_config for the given origin_server based on the
 // proxy info and other factors.
   void InitSSLConfig(const HostPortPair& origin_server,
@@ -196,12 +226,16 @@ class HttpStreamFactoryImpl::Job {
   // Should we force SPDY to run without SSL for this stream request.
   bool ShouldForceSpdyWithoutSSL() const;
 
+  // Returns true if the origin should be resolved before connecting, because
+  // it might be able to use an existing SpdySession of another host.
+  bool ShouldResolveForSpdyAlias() const;
+
   // Record histograms of latency until Connect() completes.
   static void LogHttpConnectedMetrics(const ClientSocketHandle& handle);
 
   Request* request_;
 
-  const HttpRequestInfo request_info_;
+  HttpRequestInfo request_info_;
   ProxyInfo proxy_info_;
   SSLConfig ssl_config_;
   const BoundNetLog net_log_;
@@ -259,12 +293,29 @@ class HttpStreamFactoryImpl::Job {
   // preconnect.
   int num_streams_;
 
+  // Used to resolve the origin when looking for a SpdySession through an IP
+  // alias. |spdy_alias_checked_| is set once that was done.
+  scoped_ptr<SingleRequestHostResolver> host_resolver_;
+  AddressList addresses_;
+  bool spdy_alias_checked_;
+
   // Initialized when we create a new SpdySession.
   scoped_refptr<SpdySession> new_spdy_session_;
 
   // Only used if |new_spdy_session_| is non-NULL.
   bool spdy_session_direct_;
 
+  // True if |proxy_info_| was given to StartWithProxyInfo().
+  bool has_proxy_info_;
+
+  // Set up in DoInitConnection() if the rest of the proxy list is to be raced
+  // against the first proxy. Once the other Job is started,
+  // |started_proxy_race_| is set, and this Job no longer falls back to the
+  // proxies that Job tries.
+  ProxyInfo proxy_race_info_;
+  base::OneShotTimer<Job> proxy_race_timer_;
+  bool started_proxy_race_;
+
   ScopedRunnableMethodFactory<Job> method_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(Job);
@@ -199,6 +199,17 @@ LoadState HttpStreamFactoryImpl::Request::GetLoadState() const {
   return (*jobs_.begin())->GetLoadState();
 }
 
+void HttpStreamFactoryImpl::Request::SetPriority(RequestPriority priority) {
+  if (bound_job_.get()) {
+    bound_job_->SetPriority(priority);
+    return;
+  }
+  for (std::set<HttpStreamFactoryImpl::Job*>::iterator it = jobs_.begin();
+       it != jobs_.end(); ++it) {
+    (*it)->SetPriority(priority);
+  }
+}
+
 bool HttpStreamFactoryImpl::Request::was_npn_negotiated() const {
   DCHECK(completed_);
   return was_npn_negotiated_;
@@ -82,6 +82,7 @@ class HttpStreamFactoryImpl::Request : public HttpStreamRequest {
   virtual int RestartTunnelWithProxyAuth(const string16& username,
                                          const string16& password);
   virtual LoadState GetLoadState() const;
+  virtual void SetPriority(RequestPriority priority);
   virtual bool was_npn_negotiated() const;
   virtual bool using_spdy() const;
 
@@ -7,6 +7,7 @@
 #include <string>
 
 #include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
 #include "net/base/cert_verifier.h"
 #include "net/base/mock_host_resolver.h"
 #include "net/base/net_log.h"
@@ -16,6 +17,7 @@
 #include "net/http/http_network_session.h"
 #include "net/http/http_network_session_peer.h"
 #include "net/http/http_request_info.h"
+#include "net/http/http_stream.h"
 #include "net/proxy/proxy_info.h"
 #include "net/proxy/proxy_service.h"
 #include "net/socket/socket_test_util.h"
@@ -123,6 +125,69 @@ void PreconnectHelper(const TestCase& test,
   mock_factory->WaitForPreconnects();
 };
 
+// Waits for a stream request's OnStreamReady(), which is the only outcome
+// expected of it.
+class StreamRequestWaiter : public HttpStreamRequest::Delegate {
+ public:
+  StreamRequestWaiter()
+      : stream_done_(false),
+        waiting_for_stream_(false) {}
+
+  void WaitForStream() {
+    while (!stream_done_) {
+      waiting_for_stream_ = true;
+      MessageLoop::current()->Run();
+      waiting_for_stream_ = false;
+    }
+  }
+
+  const ProxyInfo& used_proxy_info() const { return used_proxy_info_; }
+
+  // HttpStreamRequest::Delegate methods.
+  virtual void OnStreamReady(const SSLConfig& used_ssl_config,
+                             const ProxyInfo& used_proxy_info,
+                             HttpStream* stream) {
+    stream_done_ = true;
+    used_proxy_info_ = used_proxy_info;
+    stream_.reset(stream);
+    if (waiting_for_stream_)
+      MessageLoop::current()->Quit();
+  }
+  virtual void OnStreamFailed(int status, const SSLConfig& used_ssl_config) {
+    ADD_FAILURE();
+  }
+  virtual void OnCertificateError(int status,
+                                  const SSLConfig& used_ssl_config,
+                                  const SSLInfo& ssl_info) {
+    ADD_FAILURE();
+  }
+  virtual void OnNeedsProxyAuth(const HttpResponseInfo& proxy_response,
+                                const SSLConfig& used_ssl_config,
+                                const ProxyInfo& used_proxy_info,
+                                HttpAuthController* auth_controller) {
+    ADD_FAILURE();
+  }
+  virtual void OnNeedsClientAuth(const SSLConfig& used_ssl_config,
+                                 SSLCertRequestInfo* cert_info) {
+    ADD_FAILURE();
+  }
+  virtual void OnHttpsProxyTunnelResponse(
+      const HttpResponseInfo& response_info,
+      const SSLConfig& used_ssl_config,
+      const ProxyInfo& used_proxy_info,
+      HttpStream* stream) {
+    ADD_FAILURE();
+  }
+
+ private:
+  bool stream_done_;
+  bool waiting_for_stream_;
+  ProxyInfo used_proxy_info_;
+  scoped_ptr<HttpStream> stream_;
+
+  DISALLOW_COPY_AND_ASSIGN(StreamRequestWaiter);
+};
+
 template<typename ParentPool>
 class CapturePreconnectsSocketPool : public ParentPool {
  public:
@@ -315,6 +380,39 @@ TEST(HttpStreamFactoryTest, PreconnectDirectWithExistingSpdySession) {
   }
 }
 
+// A slow first proxy is raced by the rest of the list, and isn't marked as
+// bad just for being slow.
+TEST(HttpStreamFactoryTest, RaceProxyFallback) {
+  HttpStreamFactory::set_proxy_race_delay_ms(1);
+  SessionDependencies session_deps(ProxyService::CreateFixedFromPacResult(
+      "PROXY bad:8080; PROXY good:8080"));
+
+  // The connection to the first proxy never completes.
+  StaticSocketDataProvider hung_data;
+  hung_data.set_connect_data(MockConnect(false, ERR_IO_PENDING));
+  session_deps.socket_factory.AddSocketDataProvider(&hung_data);
+  StaticSocketDataProvider good_data;
+  session_deps.socket_factory.AddSocketDataProvider(&good_data);
+
+  scoped_refptr<HttpNetworkSession> session(CreateSession(&session_deps));
+
+  HttpRequestInfo request_info;
+  request_info.method = "GET";
+  request_info.url = GURL("http://www.google.com");
+  request_info.load_flags = 0;
+  SSLConfig ssl_config;
+  StreamRequestWaiter waiter;
+  scoped_ptr<HttpStreamRequest> request(
+      session->http_stream_factory()->RequestStream(
+          request_info, ssl_config, &waiter, BoundNetLog()));
+  waiter.WaitForStream();
+
+  EXPECT_EQ("PROXY good:8080", waiter.used_proxy_info().ToPacString());
+  EXPECT_TRUE(session->proxy_service()->proxy_retry_info().empty());
+
+  HttpStreamFactory::set_proxy_race_delay_ms(0);
+}
+
 }  // namespace
 
 }  // namespace net
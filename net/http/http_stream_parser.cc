@@ -45,7 +45,6 @@ HttpStreamParser::HttpStreamParser(ClientSocketHandle* connection,
       chunk_length_(0),
       chunk_length_without_encoding_(0),
       sent_last_chunk_(false) {
-  DCHECK_EQ(0, read_buffer->offset());
 }
 
 HttpStreamParser::~HttpStreamParser() {
@@ -88,6 +87,10 @@ int HttpStreamParser::SendRequest(const std::string& request_line,
     const int kChunkHeaderFooterSize = 12;  // 2 CRLFs + max of 8 hex chars.
     chunk_buf_ = new IOBuffer(request_body_->GetMaxBufferSize() +
                               kChunkHeaderFooterSize);
+  } else if (request_body_ != NULL &&
+             connection_->socket()->SupportsSendFile()) {
+    // Upload the files without copying them through the stream's buffer.
+    request_body_->set_send_files_directly(true);
   }
 
   io_state_ = STATE_SENDING_HEADERS;
@@ -230,6 +233,13 @@ int HttpStreamParser::DoLoop(int result) {
 }
 
 int HttpStreamParser::DoSendHeaders(int result) {
+  // If the body was written along with the headers, the bytes beyond the
+  // headers belong to the body.
+  int body_bytes = 0;
+  if (result > request_headers_->BytesRemaining()) {
+    body_bytes = result - request_headers_->BytesRemaining();
+    result = request_headers_->BytesRemaining();
+  }
   request_headers_->DidConsume(result);
   int bytes_remaining = request_headers_->BytesRemaining();
   if (bytes_remaining > 0) {
@@ -270,13 +280,24 @@ int HttpStreamParser::DoSendHeaders(int result) {
       UMA_HISTOGRAM_ENUMERATION("Net.CoalescePotential", coalesce,
                                 COALESCE_POTENTIAL_MAX);
     }
-    result = connection_->socket()->Write(request_headers_,
-                                          bytes_remaining,
-                                          &io_callback_);
+    if (request_body_ != NULL && !request_body_->is_chunked() &&
+        request_body_->buf_len() > 0) {
+      // Send the headers and the first part of the body together, to avoid
+      // putting them on separate packets.
+      IOBuffer* bufs[] = { request_headers_, request_body_->buf() };
+      int buf_lens[] = { bytes_remaining,
+                         static_cast<int>(request_body_->buf_len()) };
+      result = connection_->socket()->Writev(bufs, buf_lens, arraysize(bufs),
+                                             &io_callback_);
+    } else {
+      result = connection_->socket()->Write(request_headers_,
+                                            bytes_remaining,
+                                            &io_callback_);
+    }
   } else if (request_body_ != NULL &&
              (request_body_->is_chunked() || request_body_->size())) {
     io_state_ = STATE_SENDING_BODY;
-    result = OK;
+    result = body_bytes;
   } else {
     io_state_ = STATE_REQUEST_SENT;
   }
@@ -331,6 +352,21 @@ int HttpStreamParser::DoSendBody(int result) {
   request_body_->MarkConsumedAndFillBuffer(result);
 
   if (!request_body_->eof()) {
+    base::PlatformFile file;
+    int64 offset;
+    int file_len;
+    if (request_body_->GetFileData(&file, &offset, &file_len)) {
+      result = connection_->socket()->SendFile(file, offset, file_len,
+                                               &io_callback_);
+      if (result != 0 && result != ERR_NOT_IMPLEMENTED)
+        return result;
+    }
+    if (!request_body_->buf_len()) {
+      // The file can't be sent directly, or it is shorter than it was: copy
+      // (and pad) it through the buffer instead.
+      request_body_->set_send_files_directly(false);
+    }
+
     int buf_len = static_cast<int>(request_body_->buf_len());
     result = connection_->socket()->Write(request_body_->buf(), buf_len,
                                           &io_callback_);
@@ -374,8 +410,10 @@ int HttpStreamParser::DoReadHeadersComplete(int result) {
 
   // Record our best estimate of the 'response time' as the time when we read
   // the first bytes of the response headers.
-  if (read_buf_->offset() == 0 && result != ERR_CONNECTION_CLOSED)
+  if (read_buf_->offset() == 0 && result != ERR_CONNECTION_CLOSED) {
     response_->response_time = base::Time::Now();
+    first_response_byte_time_ = base::TimeTicks::Now();
+  }
 
   if (result == ERR_CONNECTION_CLOSED) {
     // The connection closed before we detected the end of the headers.
@@ -449,6 +487,7 @@ int HttpStreamParser::DoReadHeadersComplete(int result) {
         read_buf_unused_offset_ = 0;
         return OK;
       }
+      body_metrics_.StartStream();
     }
   }
   return result;
@@ -506,11 +545,14 @@ int HttpStreamParser::DoReadBodyComplete(int result) {
     }
   }
 
-  if (result > 0)
+  if (result > 0) {
     response_body_read_ += result;
+    body_metrics_.RecordBytes(result);
+  }
 
   if (result <= 0 || IsResponseBodyComplete()) {
     io_state_ = STATE_DONE;
+    body_metrics_.StopStream();
 
     // Save the overflow data, which can be in two places.  There may be
     // some left over in |user_read_buf_|, plus there may be more
@@ -9,6 +9,8 @@
 #include <string>
 
 #include "base/basictypes.h"
+#include "base/time.h"
+#include "net/base/bandwidth_metrics.h"
 #include "net/base/completion_callback.h"
 #include "net/base/net_log.h"
 #include "net/base/upload_data_stream.h"
@@ -73,6 +75,11 @@ class HttpStreamParser  : public ChunkCallback {
 
   void GetSSLCertRequestInfo(SSLCertRequestInfo* cert_request_info);
 
+  // When the first bytes of the response headers were read.
+  base::TimeTicks first_response_byte_time() const {
+    return first_response_byte_time_;
+  }
+
   // ChunkCallback methods.
   virtual void OnChunkAvailable();
 
@@ -158,6 +165,8 @@ class HttpStreamParser  : public ChunkCallback {
   // The parsed response headers.  Owned by the caller.
   HttpResponseInfo* response_;
 
+  base::TimeTicks first_response_byte_time_;
+
   // Indicates the content length.  If this value is less than zero
   // (and chunked_decoder_ is null), then we must read until the server
   // closes the connection.
@@ -191,6 +200,9 @@ class HttpStreamParser  : public ChunkCallback {
   // Callback to be used when doing IO.
   CompletionCallbackImpl<HttpStreamParser> io_callback_;
 
+  // Measures the throughput of reading the response body.
+  ScopedBandwidthMetrics body_metrics_;
+
   // Stores an encoded chunk for chunked uploads.
   // Note: This should perhaps be improved to not create copies of the data.
   scoped_refptr<IOBuffer> chunk_buf_;
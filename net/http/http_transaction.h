@@ -9,11 +9,13 @@
 #include "base/string16.h"
 #include "net/base/completion_callback.h"
 #include "net/base/load_states.h"
+#include "net/base/request_priority.h"
 
 namespace net {
 
 class BoundNetLog;
 struct HttpRequestInfo;
+struct LoadTimingInfo;
 class HttpResponseInfo;
 class IOBuffer;
 class X509Certificate;
@@ -106,6 +108,15 @@ class HttpTransaction {
   // zero will be returned.  This does not include the request headers.
   virtual uint64 GetUploadProgress() const = 0;
 
+  // Fills in the times in |load_timing_info| for the steps this transaction
+  // has been through so far.
+  virtual void GetLoadTimingInfo(LoadTimingInfo* load_timing_info) const = 0;
+
+  // Changes the priority of the transaction. The HttpRequestInfo passed to
+  // Start() should be updated by the caller too, so that any further requests
+  // made by the transaction (for instance, after an auth restart) use it.
+  virtual void SetPriority(RequestPriority priority) = 0;
+
   // SetSSLHostInfo sets a object which reads and writes public information
   // about an SSL server. It's used to implement Snap Start.
   // TODO(agl): remove this.
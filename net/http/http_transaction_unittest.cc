@@ -309,6 +309,13 @@ uint64 MockNetworkTransaction::GetUploadProgress() const {
   return 0;
 }
 
+void MockNetworkTransaction::GetLoadTimingInfo(
+    net::LoadTimingInfo* load_timing_info) const {
+}
+
+void MockNetworkTransaction::SetPriority(net::RequestPriority priority) {
+}
+
 void MockNetworkTransaction::CallbackLater(net::CompletionCallback* callback,
                                            int result) {
   MessageLoop::current()->PostTask(FROM_HERE, task_factory_.NewRunnableMethod(
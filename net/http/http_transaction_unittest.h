@@ -182,6 +182,10 @@ class MockNetworkTransaction : public net::HttpTransaction {
 
   virtual uint64 GetUploadProgress() const;
 
+  virtual void GetLoadTimingInfo(net::LoadTimingInfo* load_timing_info) const;
+
+  virtual void SetPriority(net::RequestPriority priority);
+
  private:
   void CallbackLater(net::CompletionCallback* callback, int result);
   void RunCallback(net::CompletionCallback* callback, int result);
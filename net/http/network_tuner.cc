@@ -0,0 +1,61 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/network_tuner.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "net/socket/client_socket_pool_manager.h"
+#include "net/socket/transport_client_socket_pool.h"
+#include "net/spdy/spdy_session.h"
+
+namespace net {
+
+NetworkTuner::NetworkTuner() {
+#if defined(ANDROID)
+  AndroidNetworkLibrary::AddConnectionTypeObserver(this);
+  AndroidNetworkLibrary* lib = AndroidNetworkLibrary::GetSharedInstance();
+  if (lib)
+    OnConnectionTypeChanged(lib->GetConnectionType());
+#endif
+}
+
+NetworkTuner::~NetworkTuner() {
+#if defined(ANDROID)
+  AndroidNetworkLibrary::RemoveConnectionTypeObserver(this);
+#endif
+}
+
+// static
+void NetworkTuner::ApplyProfile(const NetworkTuningProfile& profile) {
+  NetworkTuningProfile::SetCurrent(profile);
+
+  // The per group limit may never exceed the per proxy server one, so lower
+  // it before changing the latter.
+  ClientSocketPoolManager::set_max_sockets_per_group(
+      std::min(ClientSocketPoolManager::max_sockets_per_group(),
+               profile.max_sockets_per_group));
+  ClientSocketPoolManager::set_max_sockets_per_proxy_server(
+      profile.max_sockets_per_proxy_server);
+  ClientSocketPoolManager::set_max_sockets_per_group(
+      profile.max_sockets_per_group);
+
+  TransportClientSocketPool::set_connect_timeout(profile.connect_timeout);
+
+  SpdySession::set_connection_at_risk_of_loss_ms(static_cast<int>(
+      profile.spdy_connection_at_risk_of_loss.InMilliseconds()));
+  SpdySession::set_hung_interval_ms(static_cast<int>(
+      profile.spdy_hung_interval.InMilliseconds()));
+}
+
+void NetworkTuner::OnConnectionTypeChanged(
+    NetworkTuningProfile::ConnectionType type) {
+  if (type == NetworkTuningProfile::GetCurrent().connection_type)
+    return;
+  VLOG(1) << "Tuning the network stack for connection type " << type;
+  ApplyProfile(NetworkTuningProfile::ForConnectionType(type));
+}
+
+}  // namespace net
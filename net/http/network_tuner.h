@@ -0,0 +1,45 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_HTTP_NETWORK_TUNER_H_
+#define NET_HTTP_NETWORK_TUNER_H_
+#pragma once
+
+#include "base/basictypes.h"
+#include "net/base/android_network_library.h"
+#include "net/base/net_export.h"
+#include "net/base/network_tuning_profile.h"
+
+namespace net {
+
+// Switches the network stack to the NetworkTuningProfile of the connection
+// type the platform reports.  On Android, it follows the connection type
+// AndroidNetworkLibrary reports; elsewhere, the stack keeps its defaults
+// unless ApplyProfile() is called.
+//
+// The per group and per proxy server limits apply to the socket pools
+// created after the change; SPDY ping intervals and connect timeouts apply
+// from then on everywhere.  The Predictor reads its preconnect budget from
+// NetworkTuningProfile::GetCurrent().
+//
+// Create it, and call ApplyProfile(), on the IO thread.
+class NET_EXPORT NetworkTuner
+    : public AndroidNetworkLibrary::ConnectionTypeObserver {
+ public:
+  NetworkTuner();
+  virtual ~NetworkTuner();
+
+  static void ApplyProfile(const NetworkTuningProfile& profile);
+
+  // AndroidNetworkLibrary::ConnectionTypeObserver methods:
+  virtual void OnConnectionTypeChanged(
+      NetworkTuningProfile::ConnectionType type);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(NetworkTuner);
+};
+
+}  // namespace net
+
+#endif  // NET_HTTP_NETWORK_TUNER_H_
@@ -0,0 +1,90 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/network_tuner.h"
+
+#include "net/socket/client_socket_pool_manager.h"
+#include "net/socket/transport_client_socket_pool.h"
+#include "net/spdy/spdy_session.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+class NetworkTunerTest : public testing::Test {
+ protected:
+  virtual void TearDown() {
+    NetworkTuner::ApplyProfile(NetworkTuningProfile());
+  }
+};
+
+TEST_F(NetworkTunerTest, DefaultProfileKeepsDefaults) {
+  int max_sockets_per_group = ClientSocketPoolManager::max_sockets_per_group();
+  base::TimeDelta connect_timeout =
+      TransportClientSocketPool::connect_timeout();
+  int at_risk_ms = SpdySession::connection_at_risk_of_loss_ms();
+  int hung_interval_ms = SpdySession::hung_interval_ms();
+
+  NetworkTuner::ApplyProfile(NetworkTuningProfile());
+  EXPECT_EQ(max_sockets_per_group,
+            ClientSocketPoolManager::max_sockets_per_group());
+  EXPECT_EQ(connect_timeout, TransportClientSocketPool::connect_timeout());
+  EXPECT_EQ(at_risk_ms, SpdySession::connection_at_risk_of_loss_ms());
+  EXPECT_EQ(hung_interval_ms, SpdySession::hung_interval_ms());
+}
+
+TEST_F(NetworkTunerTest, ConnectionTypeChanges) {
+  NetworkTuner tuner;
+  tuner.OnConnectionTypeChanged(NetworkTuningProfile::CONNECTION_2G);
+  NetworkTuningProfile slow = NetworkTuningProfile::ForConnectionType(
+      NetworkTuningProfile::CONNECTION_2G);
+  EXPECT_EQ(NetworkTuningProfile::CONNECTION_2G,
+            NetworkTuningProfile::GetCurrent().connection_type);
+  EXPECT_EQ(slow.max_sockets_per_group,
+            ClientSocketPoolManager::max_sockets_per_group());
+  EXPECT_EQ(slow.connect_timeout, TransportClientSocketPool::connect_timeout());
+  EXPECT_EQ(slow.spdy_connection_at_risk_of_loss.InMilliseconds(),
+            SpdySession::connection_at_risk_of_loss_ms());
+  EXPECT_EQ(slow.spdy_hung_interval.InMilliseconds(),
+            SpdySession::hung_interval_ms());
+
+  tuner.OnConnectionTypeChanged(NetworkTuningProfile::CONNECTION_WIFI);
+  NetworkTuningProfile fast = NetworkTuningProfile::ForConnectionType(
+      NetworkTuningProfile::CONNECTION_WIFI);
+  EXPECT_EQ(NetworkTuningProfile::CONNECTION_WIFI,
+            NetworkTuningProfile::GetCurrent().connection_type);
+  EXPECT_EQ(fast.max_sockets_per_group,
+            ClientSocketPoolManager::max_sockets_per_group());
+  EXPECT_EQ(fast.connect_timeout, TransportClientSocketPool::connect_timeout());
+  EXPECT_LT(fast.connect_timeout, slow.connect_timeout);
+  EXPECT_LT(fast.spdy_hung_interval, slow.spdy_hung_interval);
+}
+
+TEST_F(NetworkTunerTest, SlowerIsNeverMoreAggressive) {
+  const NetworkTuningProfile::ConnectionType kFastestFirst[] = {
+    NetworkTuningProfile::CONNECTION_WIFI,
+    NetworkTuningProfile::CONNECTION_4G,
+    NetworkTuningProfile::CONNECTION_3G,
+    NetworkTuningProfile::CONNECTION_2G,
+  };
+  for (size_t i = 1; i < arraysize(kFastestFirst); ++i) {
+    NetworkTuningProfile faster =
+        NetworkTuningProfile::ForConnectionType(kFastestFirst[i - 1]);
+    NetworkTuningProfile slower =
+        NetworkTuningProfile::ForConnectionType(kFastestFirst[i]);
+    EXPECT_LE(slower.max_sockets_per_group, faster.max_sockets_per_group);
+    EXPECT_LE(slower.max_preconnects_per_host,
+              faster.max_preconnects_per_host);
+    EXPECT_GE(slower.connect_timeout, faster.connect_timeout);
+    EXPECT_GE(slower.spdy_connection_at_risk_of_loss,
+              faster.spdy_connection_at_risk_of_loss);
+    EXPECT_LE(slower.max_sockets_per_group,
+              slower.max_sockets_per_proxy_server);
+  }
+}
+
+}  // namespace
+
+}  // namespace net
@@ -30,6 +30,8 @@
         'base/address_list_net_log_param.cc',
         'base/address_list_net_log_param.h',
         'base/asn1_util.cc',
+        'base/async_dns_resolver.cc',
+        'base/async_dns_resolver.h',
         'base/auth.cc',
         'base/auth.h',
         'base/backoff_entry.cc',
@@ -67,6 +69,8 @@
         'base/data_url.h',
         'base/directory_lister.cc',
         'base/directory_lister.h',
+        'base/dns_config.cc',
+        'base/dns_config.h',
         'base/dns_reload_timer.cc',
         'base/dns_reload_timer.h',
         'base/dnssec_chain_verifier.cc',
@@ -95,6 +99,8 @@
         'base/host_cache.h',
         'base/host_mapping_rules.cc',
         'base/host_mapping_rules.h',
+        'base/host_pattern_matcher.cc',
+        'base/host_pattern_matcher.h',
         'base/host_port_pair.cc',
         'base/host_port_pair.h',
         'base/host_resolver.cc',
@@ -118,8 +124,11 @@
         'base/load_flags.h',
         'base/load_flags_list.h',
         'base/load_states.h',
+        'base/load_timing_info.cc',
+        'base/load_timing_info.h',
         'base/mapped_host_resolver.cc',
         'base/mapped_host_resolver.h',
+        'base/memory_pressure_level.h',
         'base/mime_sniffer.cc',
         'base/mime_sniffer.h',
         'base/mime_util.cc',
@@ -134,6 +143,8 @@
         'base/net_errors_win.cc',
         'base/net_log.cc',
         'base/net_log.h',
+        'base/net_log_binary.cc',
+        'base/net_log_binary.h',
         'base/net_log_event_type_list.h',
         'base/net_log_source_type_list.h',
         'base/net_module.cc',
@@ -158,6 +169,10 @@
         'base/network_config_watcher_mac.h',
         'base/network_delegate.cc',
         'base/network_delegate.h',
+        'base/network_quality_estimator.cc',
+        'base/network_quality_estimator.h',
+        'base/network_tuning_profile.cc',
+        'base/network_tuning_profile.h',
         'base/nss_memio.c',
         'base/nss_memio.h',
         'base/openssl_memory_private_key_store.cc',
@@ -384,6 +399,8 @@
         'disk_cache/disk_cache.h',
         'disk_cache/disk_format.cc',
         'disk_cache/disk_format.h',
+        'disk_cache/entry_filter.cc',
+        'disk_cache/entry_filter.h',
         'disk_cache/entry_impl.cc',
         'disk_cache/entry_impl.h',
         'disk_cache/errors.h',
@@ -399,13 +416,19 @@
         'disk_cache/file_lock.h',
         'disk_cache/file_posix.cc',
         'disk_cache/file_win.cc',
+        'disk_cache/frequency_sketch.cc',
+        'disk_cache/frequency_sketch.h',
         'disk_cache/hash.cc',
         'disk_cache/hash.h',
         'disk_cache/histogram_macros.h',
+        'disk_cache/hot_set.cc',
+        'disk_cache/hot_set.h',
         'disk_cache/in_flight_backend_io.cc',
         'disk_cache/in_flight_backend_io.h',
         'disk_cache/in_flight_io.cc',
         'disk_cache/in_flight_io.h',
+        'disk_cache/journal.cc',
+        'disk_cache/journal.h',
         'disk_cache/mapped_file.h',
         'disk_cache/mapped_file_posix.cc',
         'disk_cache/mapped_file_win.cc',
@@ -415,8 +438,12 @@
         'disk_cache/mem_entry_impl.h',
         'disk_cache/mem_rankings.cc',
         'disk_cache/mem_rankings.h',
+        'disk_cache/mem_slab_allocator.cc',
+        'disk_cache/mem_slab_allocator.h',
         'disk_cache/rankings.cc',
         'disk_cache/rankings.h',
+        'disk_cache/sharded_backend.cc',
+        'disk_cache/sharded_backend.h',
         'disk_cache/sparse_control.cc',
         'disk_cache/sparse_control.h',
         'disk_cache/stats.cc',
@@ -427,6 +454,8 @@
         'disk_cache/storage_block.h',
         'disk_cache/trace.cc',
         'disk_cache/trace.h',
+        'disk_cache/verifier.cc',
+        'disk_cache/verifier.h',
         'ftp/ftp_auth_cache.cc',
         'ftp/ftp_auth_cache.h',
         'ftp/ftp_ctrl_response_buffer.cc',
@@ -496,6 +525,8 @@
         'http/http_byte_range.h',
         'http/http_cache.cc',
         'http/http_cache.h',
+        'http/http_cache_body_codec.cc',
+        'http/http_cache_body_codec.h',
         'http/http_cache_transaction.cc',
         'http/http_cache_transaction.h',
         'http/http_chunked_decoder.cc',
@@ -510,6 +541,12 @@
         'http/http_network_session_peer.h',
         'http/http_network_transaction.cc',
         'http/http_network_transaction.h',
+        'http/http_pipelined_connection.cc',
+        'http/http_pipelined_connection.h',
+        'http/http_pipelined_host_pool.cc',
+        'http/http_pipelined_host_pool.h',
+        'http/http_pipelined_stream.cc',
+        'http/http_pipelined_stream.h',
         'http/http_request_headers.cc',
         'http/http_request_headers.h',
         'http/http_request_info.cc',
@@ -551,6 +588,8 @@
         'http/http_version.h',
         'http/md4.cc',
         'http/md4.h',
+        'http/network_tuner.cc',
+        'http/network_tuner.h',
         'http/partial_data.cc',
         'http/partial_data.h',
         'http/proxy_client_socket.h',
@@ -586,6 +625,8 @@
         'proxy/proxy_resolver_mac.h',
         'proxy/proxy_resolver_request_context.h',
         'proxy/proxy_resolver_script.h',
+        'proxy/proxy_resolver_script_cache.cc',
+        'proxy/proxy_resolver_script_cache.h',
         'proxy/proxy_resolver_script_data.cc',
         'proxy/proxy_resolver_script_data.h',
         'proxy/proxy_resolver_v8.cc',
@@ -649,13 +690,19 @@
         'socket/ssl_server_socket_openssl.cc',
         'socket/ssl_host_info.cc',
         'socket/ssl_host_info.h',
+        'socket/ssl_host_info_prefetcher.cc',
+        'socket/ssl_host_info_prefetcher.h',
         'socket/tcp_client_socket.cc',
         'socket/tcp_client_socket.h',
         'socket/tcp_client_socket_libevent.cc',
         'socket/tcp_client_socket_libevent.h',
         'socket/tcp_client_socket_win.cc',
         'socket/tcp_client_socket_win.h',
+        'socket/tcp_info.cc',
+        'socket/tcp_info.h',
         'socket/tcp_server_socket.h',
+        'socket/tcp_server_socket_group.cc',
+        'socket/tcp_server_socket_group.h',
         'socket/tcp_server_socket_libevent.cc',
         'socket/tcp_server_socket_libevent.h',
         'socket/tcp_server_socket_win.cc',
@@ -692,6 +739,8 @@
         'spdy/spdy_settings_storage.h',
         'spdy/spdy_stream.cc',
         'spdy/spdy_stream.h',
+        'spdy/spdy_write_queue.cc',
+        'spdy/spdy_write_queue.h',
         'udp/datagram_client_socket.h',
         'udp/datagram_server_socket.h',
         'udp/datagram_socket.h',
@@ -757,6 +806,8 @@
         'url_request/view_cache_helper.h',
         'websockets/websocket.cc',
         'websockets/websocket.h',
+        'websockets/websocket_deflater.cc',
+        'websockets/websocket_deflater.h',
         'websockets/websocket_frame_handler.cc',
         'websockets/websocket_frame_handler.h',
         'websockets/websocket_handshake.cc',
@@ -838,6 +889,7 @@
             'sources!': [
               'http/http_auth_handler_ntlm_portable.cc',
               'socket/tcp_client_socket_libevent.cc',
+              'socket/tcp_server_socket_group.cc',
               'socket/tcp_server_socket_libevent.cc',
               'udp/udp_socket_libevent.cc',
             ],
@@ -887,12 +939,14 @@
       'msvs_guid': 'E99DA267-BE90-4F45-88A1-6919DB2C7567',
       'sources': [
         'base/address_list_unittest.cc',
+        'base/async_dns_resolver_unittest.cc',
         'base/backoff_entry_unittest.cc',
         'base/cert_database_nss_unittest.cc',
         'base/cert_verifier_unittest.cc',
         'base/cookie_monster_unittest.cc',
         'base/data_url_unittest.cc',
         'base/directory_lister_unittest.cc',
+        'base/dns_config_unittest.cc',
         'base/dnssec_unittest.cc',
         'base/dns_util_unittest.cc',
         'base/dnsrr_resolver_unittest.cc',
@@ -902,6 +956,7 @@
         'base/gzip_filter_unittest.cc',
         'base/host_cache_unittest.cc',
         'base/host_mapping_rules_unittest.cc',
+        'base/host_pattern_matcher_unittest.cc',
         'base/host_resolver_impl_unittest.cc',
         'base/ip_endpoint_unittest.cc',
         'base/keygen_handler_unittest.cc',
@@ -912,9 +967,11 @@
         'base/mime_util_unittest.cc',
         'base/mock_filter_context.cc',
         'base/mock_filter_context.h',
+        'base/net_log_binary_unittest.cc',
         'base/net_log_unittest.cc',
         'base/net_log_unittest.h',
         'base/net_util_unittest.cc',
+        'base/network_quality_estimator_unittest.cc',
         'base/pem_tokenizer_unittest.cc',
         'base/registry_controlled_domain_unittest.cc',
         'base/run_all_unittests.cc',
@@ -937,8 +994,11 @@
         'disk_cache/cache_util_unittest.cc',
         'disk_cache/disk_cache_test_base.cc',
         'disk_cache/disk_cache_test_base.h',
+        'disk_cache/entry_filter_unittest.cc',
         'disk_cache/entry_unittest.cc',
+        'disk_cache/frequency_sketch_unittest.cc',
         'disk_cache/mapped_file_unittest.cc',
+        'disk_cache/mem_slab_allocator_unittest.cc',
         'disk_cache/storage_block_unittest.cc',
         'ftp/ftp_auth_cache_unittest.cc',
         'ftp/ftp_ctrl_response_buffer_unittest.cc',
@@ -965,10 +1025,12 @@
         'http/http_auth_sspi_win_unittest.cc',
         'http/http_auth_unittest.cc',
         'http/http_byte_range_unittest.cc',
+        'http/http_cache_body_codec_unittest.cc',
         'http/http_cache_unittest.cc',
         'http/http_chunked_decoder_unittest.cc',
         'http/http_network_layer_unittest.cc',
         'http/http_network_transaction_unittest.cc',
+        'http/http_pipelined_connection_unittest.cc',
         'http/http_proxy_client_socket_pool_unittest.cc',
         'http/http_request_headers_unittest.cc',
         'http/http_response_body_drainer_unittest.cc',
@@ -984,6 +1046,7 @@
         'http/mock_gssapi_library_posix.h',
         'http/mock_sspi_library_win.h',
         'http/mock_sspi_library_win.cc',
+        'http/network_tuner_unittest.cc',
         'http/url_security_manager_unittest.cc',
         'proxy/init_proxy_resolver_unittest.cc',
         'proxy/multi_threaded_proxy_resolver_unittest.cc',
@@ -993,6 +1056,7 @@
         'proxy/proxy_config_unittest.cc',
         'proxy/proxy_list_unittest.cc',
         'proxy/proxy_resolver_js_bindings_unittest.cc',
+        'proxy/proxy_resolver_script_cache_unittest.cc',
         'proxy/proxy_resolver_v8_unittest.cc',
         'proxy/proxy_script_fetcher_impl_unittest.cc',
         'proxy/proxy_server_unittest.cc',
@@ -1005,7 +1069,9 @@
         'socket/socks_client_socket_unittest.cc',
         'socket/ssl_client_socket_unittest.cc',
         'socket/ssl_client_socket_pool_unittest.cc',
+        'socket/ssl_host_info_prefetcher_unittest.cc',
         'socket/ssl_server_socket_unittest.cc',
+        'socket/tcp_server_socket_group_unittest.cc',
         'socket/tcp_server_socket_unittest.cc',
         'socket/transport_client_socket_pool_unittest.cc',
         'socket/transport_client_socket_unittest.cc',
@@ -1017,9 +1083,11 @@
         'spdy/spdy_protocol_test.cc',
         'spdy/spdy_proxy_client_socket_unittest.cc',
         'spdy/spdy_session_unittest.cc',
+        'spdy/spdy_settings_storage_unittest.cc',
         'spdy/spdy_stream_unittest.cc',
         'spdy/spdy_test_util.cc',
         'spdy/spdy_test_util.h',
+        'spdy/spdy_write_queue_unittest.cc',
         'test/python_utils_unittest.cc',
         'tools/dump_cache/url_to_filename_encoder.cc',
         'tools/dump_cache/url_to_filename_encoder.h',
@@ -1032,6 +1100,7 @@
         'url_request/url_request_throttler_unittest.cc',
         'url_request/url_request_unittest.cc',
         'url_request/view_cache_helper_unittest.cc',
+        'websockets/websocket_deflater_unittest.cc',
         'websockets/websocket_frame_handler_unittest.cc',
         'websockets/websocket_handshake_draft75_unittest.cc',
         'websockets/websocket_handshake_handler_unittest.cc',
@@ -1086,6 +1155,7 @@
         [ 'OS == "win"', {
             'sources!': [
               'http/http_auth_gssapi_posix_unittest.cc',
+              'socket/tcp_server_socket_group_unittest.cc',
             ],
             # This is needed to trigger the dll copy step on windows.
             # TODO(mark): Specifying this here shouldn't be necessary.
@@ -1105,13 +1175,27 @@
         '../base/base.gyp:base',
         '../base/base.gyp:base_i18n',
         '../base/base.gyp:test_support_perf',
+        '../crypto/crypto.gyp:crypto',
+        '../sdch/sdch.gyp:sdch_encoder',
         '../testing/gtest.gyp:gtest',
+        '../third_party/zlib/zlib.gyp:zlib',
       ],
       'msvs_guid': 'AAC78796-B9A2-4CD9-BF89-09B03E92BF73',
       'sources': [
         'base/cookie_monster_perftest.cc',
+        'base/gzip_filter_perftest.cc',
+        'base/mime_sniffer_perftest.cc',
+        'base/mock_filter_context.cc',
+        'base/mock_filter_context.h',
+        'base/sdch_filter_perftest.cc',
         'disk_cache/disk_cache_perftest.cc',
+        'http/http_chunked_decoder_perftest.cc',
         'proxy/proxy_resolver_perftest.cc',
+        'spdy/spdy_framer_perftest.cc',
+        'spdy/spdy_session_perftest.cc',
+        'spdy/spdy_test_util.cc',
+        'spdy/spdy_test_util.h',
+        'url_request/url_request_perftest.cc',
       ],
       'conditions': [
         # This is needed to trigger the dll copy step on windows.
@@ -1124,6 +1208,40 @@
         ],
       ],
     },
+    {
+      'target_name': 'cache_benchmark',
+      'type': 'executable',
+      'dependencies': [
+        'net',
+        'net_test_support',
+        '../base/base.gyp:base',
+      ],
+      'sources': [
+        'tools/cache_benchmark/cache_benchmark.cc',
+      ],
+    },
+    {
+      'target_name': 'host_resolver_benchmark',
+      'type': 'executable',
+      'dependencies': [
+        'net',
+        '../base/base.gyp:base',
+      ],
+      'sources': [
+        'tools/host_resolver_benchmark/host_resolver_benchmark.cc',
+      ],
+    },
+    {
+      'target_name': 'net_log_to_json',
+      'type': 'executable',
+      'dependencies': [
+        'net',
+        '../base/base.gyp:base',
+      ],
+      'sources': [
+        'tools/net_log_to_json/net_log_to_json.cc',
+      ],
+    },
     {
       'target_name': 'stress_cache',
       'type': 'executable',
@@ -1347,6 +1465,7 @@
            'dependencies': [
              '../base/base.gyp:base',
              'net.gyp:net',
+             '../sdch/sdch.gyp:sdch_encoder',
              '../third_party/openssl/openssl.gyp:openssl',
            ],
            'sources': [
@@ -1421,6 +1540,10 @@
             '../base/base.gyp:base',
           ],
           'sources': [
+            'tools/dump_cache/cache_analyzer.cc',
+            'tools/dump_cache/cache_analyzer.h',
+            'tools/dump_cache/cache_converter.cc',
+            'tools/dump_cache/cache_converter.h',
             'tools/dump_cache/cache_dumper.cc',
             'tools/dump_cache/cache_dumper.h',
             'tools/dump_cache/dump_cache.cc',
@@ -12,6 +12,7 @@
 #include <pthread.h>
 #include <secerr.h>
 
+#include <map>
 #include <string>
 
 #include "base/basictypes.h"
@@ -90,6 +91,13 @@ base::LazyInstance<OCSPIOLoop, base::LeakyLazyInstanceTraits<OCSPIOLoop> >
 
 const int kRecvBufferSize = 4096;
 
+// Responses are kept no longer than this, whatever their headers say.
+const int kMaxCachedResponseHours = 24;
+
+// Bounds on the responses that are kept, so that large CRLs aren't.
+const size_t kMaxCachedResponses = 64;
+const size_t kMaxCachedResponseSize = 16 * 1024;
+
 // All OCSP handlers should be called in the context of
 // CertVerifier's thread (i.e. worker pool, not on the I/O thread).
 // It supports blocking mode only.
@@ -198,24 +206,48 @@ class OCSPRequestSession
   }
 
   bool Wait() {
-    base::TimeDelta timeout = timeout_;
     base::AutoLock autolock(lock_);
-    while (!finished_) {
-      base::TimeTicks last_time = base::TimeTicks::Now();
-      cv_.TimedWait(timeout);
-      // Check elapsed time
-      base::TimeDelta elapsed_time = base::TimeTicks::Now() - last_time;
-      timeout -= elapsed_time;
-      if (timeout < base::TimeDelta()) {
-        VLOG(1) << "OCSP Timed out";
-        if (!finished_)
-          CancelLocked();
-        break;
-      }
+    if (!WaitLocked(timeout_)) {
+      VLOG(1) << "OCSP Timed out";
+      CancelLocked();
     }
     return finished_;
   }
 
+  // Waits up to |timeout| for a request that another thread started, without
+  // cancelling it on timeout.  Returns whether it finished.
+  bool WaitForOtherThread(base::TimeDelta timeout) {
+    base::AutoLock autolock(lock_);
+    return WaitLocked(timeout);
+  }
+
+  // Identifies what is fetched, so that identical requests can share one
+  // fetch and its response.
+  std::string FetchKey() const {
+    return http_request_method_ + " " + url_.spec() + "\n" +
+        extra_request_headers_.ToString() + upload_content_type_ + "\n" +
+        upload_content_;
+  }
+
+  // Finishes this request with the response of |other|, which has finished.
+  void TakeResponseFrom(const OCSPRequestSession& other) {
+    DCHECK(other.Finished());
+    DCHECK(!Started());
+    response_code_ = other.response_code_;
+    response_content_type_ = other.response_content_type_;
+    response_headers_ = other.response_headers_;
+    data_ = other.data_;
+    base::AutoLock autolock(lock_);
+    finished_ = true;
+  }
+
+  // When the response stops being fresh, going by its headers.  For an OCSP
+  // responder following RFC 5019 this is the nextUpdate of the response.
+  base::Time fresh_until() const {
+    DCHECK(Finished());
+    return fresh_until_;
+  }
+
   const GURL& url() const {
     return url_;
   }
@@ -270,6 +302,9 @@ class OCSPRequestSession
       response_code_ = request_->GetResponseCode();
       response_headers_ = request_->response_headers();
       response_headers_->GetMimeType(&response_content_type_);
+      const base::Time response_time = base::Time::Now();
+      fresh_until_ = response_time +
+          response_headers_->GetFreshnessLifetime(response_time);
       request_->Read(buffer_, kRecvBufferSize, &bytes_read);
     }
     OnReadCompleted(request_, bytes_read);
@@ -294,7 +329,7 @@ class OCSPRequestSession
         finished_ = true;
         io_loop_ = NULL;
       }
-      cv_.Signal();
+      cv_.Broadcast();
       Release();  // Balanced with StartURLRequest().
     }
   }
@@ -318,7 +353,7 @@ class OCSPRequestSession
         finished_ = true;
         io_loop_ = NULL;
       }
-      cv_.Signal();
+      cv_.Broadcast();
       Release();  // Balanced with StartURLRequest().
     }
   }
@@ -334,6 +369,21 @@ class OCSPRequestSession
     DCHECK(!io_loop_);
   }
 
+  // Must call this method while holding |lock_|.
+  bool WaitLocked(base::TimeDelta timeout) {
+    lock_.AssertAcquired();
+    while (!finished_) {
+      base::TimeTicks last_time = base::TimeTicks::Now();
+      cv_.TimedWait(timeout);
+      // Check elapsed time
+      base::TimeDelta elapsed_time = base::TimeTicks::Now() - last_time;
+      timeout -= elapsed_time;
+      if (timeout < base::TimeDelta())
+        break;
+    }
+    return finished_;
+  }
+
   // Must call this method while holding |lock_|.
   void CancelLocked() {
     lock_.AssertAcquired();
@@ -399,10 +449,12 @@ class OCSPRequestSession
   std::string response_content_type_;
   scoped_refptr<net::HttpResponseHeaders> response_headers_;
   std::string data_;              // Results of the requst
+  base::Time fresh_until_;
 
-  // |lock_| protects |finished_| and |io_loop_|.
+  // |lock_| protects |finished_| and |io_loop_|.  The response is only
+  // written before |finished_| is set.
   mutable base::Lock lock_;
-  base::ConditionVariable cv_;
+  base::ConditionVariable cv_;  // Broadcast when |finished_| is set.
 
   MessageLoop* io_loop_;          // Message loop of the IO thread
   bool finished_;
@@ -451,6 +503,99 @@ class OCSPServerSession {
   DISALLOW_COPY_AND_ASSIGN(OCSPServerSession);
 };
 
+// Lets identical requests from different verifications share one fetch, and
+// keeps fresh responses so that they can be given again without a fetch.
+// Used from the worker threads.
+class OCSPFetchTable {
+ public:
+  // Returns the request whose response |request| should get: a finished one
+  // for the same fetch that is still fresh, one still in flight, or |request|
+  // itself, which the caller must then start and pass to Finish().
+  scoped_refptr<OCSPRequestSession> Lookup(OCSPRequestSession* request) {
+    const std::string key = request->FetchKey();
+    base::AutoLock autolock(lock_);
+    RequestMap::iterator it = responses_.find(key);
+    if (it != responses_.end()) {
+      if (it->second->fresh_until() > base::Time::Now())
+        return it->second;
+      responses_.erase(it);
+    }
+    std::pair<RequestMap::iterator, bool> inserted =
+        in_flight_.insert(std::make_pair(key, request));
+    return inserted.first->second;
+  }
+
+  // Called once |request|, which Lookup() returned for itself, has finished
+  // or given up.  Later requests for the same fetch start one of their own,
+  // or get its response if it is fresh.
+  void Finish(OCSPRequestSession* request) {
+    const std::string key = request->FetchKey();
+    base::AutoLock autolock(lock_);
+    RequestMap::iterator it = in_flight_.find(key);
+    if (it != in_flight_.end() && it->second == request)
+      in_flight_.erase(it);
+
+    if (!request->Finished() || request->http_response_code() != 200 ||
+        request->http_response_data().size() > kMaxCachedResponseSize) {
+      return;
+    }
+    const base::Time now = base::Time::Now();
+    if (request->fresh_until() <= now ||
+        request->fresh_until() - now >
+            base::TimeDelta::FromHours(kMaxCachedResponseHours)) {
+      return;
+    }
+    if (responses_.size() >= kMaxCachedResponses)
+      EvictLocked(now);
+    responses_[key] = request;
+  }
+
+  void Clear() {
+    base::AutoLock autolock(lock_);
+    responses_.clear();
+    in_flight_.clear();
+  }
+
+ private:
+  friend struct base::DefaultLazyInstanceTraits<OCSPFetchTable>;
+
+  typedef std::map<std::string, scoped_refptr<OCSPRequestSession> >
+      RequestMap;
+
+  OCSPFetchTable() {}
+  ~OCSPFetchTable() {}
+
+  // Drops the stale responses, or if there are none, the one that would go
+  // stale first.
+  void EvictLocked(base::Time now) {
+    lock_.AssertAcquired();
+    RequestMap::iterator soonest = responses_.end();
+    for (RequestMap::iterator it = responses_.begin();
+         it != responses_.end(); ) {
+      RequestMap::iterator current = it++;
+      if (current->second->fresh_until() <= now) {
+        responses_.erase(current);
+      } else if (soonest == responses_.end() ||
+                 current->second->fresh_until() <
+                     soonest->second->fresh_until()) {
+        soonest = current;
+      }
+    }
+    if (responses_.size() >= kMaxCachedResponses)
+      responses_.erase(soonest);
+  }
+
+  base::Lock lock_;
+  RequestMap in_flight_;  // Protected by |lock_|.
+  RequestMap responses_;  // Protected by |lock_|.
+
+  DISALLOW_COPY_AND_ASSIGN(OCSPFetchTable);
+};
+
+base::LazyInstance<OCSPFetchTable,
+                   base::LeakyLazyInstanceTraits<OCSPFetchTable> >
+    g_ocsp_fetch_table(base::LINKER_INITIALIZED);
+
 OCSPIOLoop::OCSPIOLoop()
     : shutdown_(false),
       used_(false),
@@ -486,6 +631,7 @@ void OCSPIOLoop::Shutdown() {
   }
 
   CancelAllRequests();
+  g_ocsp_fetch_table.Get().Clear();
 
   pthread_mutex_lock(&g_request_context_lock);
   g_request_context = NULL;
@@ -718,14 +864,38 @@ SECStatus OCSPTrySendAndReceive(SEC_HTTP_REQUEST_SESSION request,
   }
 
   const base::Time start_time = base::Time::Now();
-  req->Start();
-  if (!req->Wait() || req->http_response_code() == static_cast<PRUint16>(-1)) {
+  scoped_refptr<OCSPRequestSession> fetch =
+      g_ocsp_fetch_table.Get().Lookup(req);
+  bool finished;
+  if (fetch == req) {
+    req->Start();
+    finished = req->Wait();
+    g_ocsp_fetch_table.Get().Finish(req);
+  } else {
+    // Another verification asked for the same thing, just now or recently
+    // enough that its response is still fresh.
+    finished = fetch->WaitForOtherThread(req->timeout());
+    if (finished)
+      req->TakeResponseFrom(*fetch);
+  }
+  if (!finished ||
+      req->http_response_code() == static_cast<PRUint16>(-1)) {
     // If the response code is -1, the request failed and there is no response.
     PORT_SetError(SEC_ERROR_BAD_HTTP_RESPONSE);  // Simple approximation.
     return SECFailure;
   }
   const base::TimeDelta duration = base::Time::Now() - start_time;
 
+  // Only time the fetches that were made.
+  if (fetch != req) {
+    return OCSPSetResponse(
+        req, http_response_code,
+        http_response_content_type,
+        http_response_headers,
+        http_response_data,
+        http_response_data_len);
+  }
+
   // We want to know if this was:
   //   1) An OCSP request
   //   2) A CRL request
@@ -9,9 +9,12 @@
 #include "base/stringprintf.h"
 #include "base/threading/thread.h"
 #include "base/threading/thread_restrictions.h"
+#include "base/utf_string_conversions.h"
+#include "googleurl/src/gurl.h"
 #include "net/base/net_errors.h"
 #include "net/base/net_log.h"
 #include "net/proxy/proxy_info.h"
+#include "net/proxy/proxy_resolver_script_data.h"
 
 // TODO(eroman): Have the MultiThreadedProxyResolver clear its PAC script
 //               data when SetPacScript fails. That will reclaim memory when
@@ -21,6 +24,98 @@ namespace net {
 
 namespace {
 
+// The number of hosts whose results are cached, by default.
+const size_t kDefaultMaxCachedResults = 256;
+
+// How many times a request is put back in the queue to wait for DNS. After
+// that its script is left to block on DNS, so that a script that keeps
+// needing new lookups still gets an answer.
+const int kMaxDnsRestarts = 4;
+
+// How long a cached result is used for. The script may look at DNS, so
+// this is the same as the lifetime of HostResolverImpl's cache entries.
+const int kCachedResultLifetimeSeconds = 60;
+
+// Words which, if they appear anywhere in a PAC script, mean that its
+// results may vary from run to run, or that it may read the |url| argument of
+// FindProxyForURL() without naming it.
+const char* const kUncacheableWords[] = {
+  "arguments", "eval", "Function", "Date", "dateRange", "timeRange",
+  "weekdayRange", "random",
+};
+
+bool IsWordChar(char16 c) {
+  return IsAsciiAlpha(c) || IsAsciiDigit(c) || c == '_' || c == '$';
+}
+
+// Splits |script| into its words, the runs of characters that can make up an
+// identifier, and appends them to |words| along with their offsets.
+void GetWords(const string16& script,
+              std::vector<std::pair<size_t, std::string> >* words) {
+  size_t i = 0;
+  while (i < script.size()) {
+    if (!IsWordChar(script[i])) {
+      ++i;
+      continue;
+    }
+    size_t start = i;
+    while (i < script.size() && IsWordChar(script[i]))
+      ++i;
+    words->push_back(
+        std::make_pair(start, UTF16ToASCII(script.substr(start, i - start))));
+  }
+}
+
+// Returns true if the FindProxyForURL() defined by |script| can be assumed to
+// return the same for all URLs with the same host.
+//
+// This looks at the words of the script rather than parsing it, so it errs
+// on the side of "no": the script has to declare FindProxyForURL() once, as
+// "function FindProxyForURL(url, host)", and the name of the first argument
+// must not appear anywhere else, even in a comment or a string.
+bool ScriptDependsOnlyOnHost(const string16& script) {
+  // An escape in an identifier could name the argument without its name
+  // appearing as a word.
+  if (script.find(ASCIIToUTF16("\\u")) != string16::npos)
+    return false;
+
+  std::vector<std::pair<size_t, std::string> > words;
+  GetWords(script, &words);
+
+  std::string url_argument;
+  for (size_t i = 0; i < words.size(); ++i) {
+    const std::string& word = words[i].second;
+    for (size_t j = 0; j < arraysize(kUncacheableWords); ++j) {
+      if (word == kUncacheableWords[j])
+        return false;
+    }
+
+    if (word != "FindProxyForURL")
+      continue;
+    if (!url_argument.empty() || i == 0 || i + 1 == words.size() ||
+        words[i - 1].second != "function") {
+      return false;
+    }
+    // Only a '(' may come between the name and the first argument.
+    size_t name_end = words[i].first + word.size();
+    string16 between;
+    TrimWhitespace(script.substr(name_end, words[i + 1].first - name_end),
+                   TRIM_ALL, &between);
+    if (between != ASCIIToUTF16("("))
+      return false;
+    url_argument = words[i + 1].second;
+  }
+  if (url_argument.empty())
+    return false;
+
+  int num_url_argument_uses = 0;
+  for (size_t i = 0; i < words.size(); ++i) {
+    if (words[i].second == url_argument)
+      ++num_url_argument_uses;
+  }
+  return num_url_argument_uses == 1;
+}
+
 class PurgeMemoryTask : public base::RefCountedThreadSafe<PurgeMemoryTask> {
  public:
   explicit PurgeMemoryTask(ProxyResolver* resolver) : resolver_(resolver) {}
@@ -65,6 +160,9 @@ class MultiThreadedProxyResolver::Executor
 
   ProxyResolver* resolver() { return resolver_.get(); }
 
+  // Returns NULL once Destroy() has been called.
+  MultiThreadedProxyResolver* coordinator() { return coordinator_; }
+
   int thread_number() const { return thread_number_; }
 
  private:
@@ -218,15 +316,25 @@ class MultiThreadedProxyResolver::GetProxyForURLJob
  public:
   // |url|         -- the URL of the query.
   // |results|     -- the structure to fill with proxy resolve results.
-  GetProxyForURLJob(const GURL& url,
+  // |non_blocking_dns| -- whether the resolver may defer DNS lookups.
+  GetProxyForURLJob(MultiThreadedProxyResolver* coordinator,
+                    const GURL& url,
                     ProxyInfo* results,
                     CompletionCallback* callback,
+                    bool non_blocking_dns,
                     const BoundNetLog& net_log)
       : Job(TYPE_GET_PROXY_FOR_URL, callback),
+        coordinator_(coordinator),
         results_(results),
         net_log_(net_log),
         url_(url),
-        was_waiting_for_thread_(false) {
+        was_waiting_for_thread_(false),
+        non_blocking_dns_(non_blocking_dns),
+        num_dns_restarts_(0),
+        waiting_for_dns_(false),
+        dns_ready_(false),
+        ALLOW_THIS_IN_INITIALIZER_LIST(
+            dns_callback_(this, &GetProxyForURLJob::OnDnsReady)) {
     DCHECK(callback);
   }
 
@@ -255,8 +363,11 @@ class MultiThreadedProxyResolver::GetProxyForURLJob
   // Runs on the worker thread.
   virtual void Run(MessageLoop* origin_loop) {
     ProxyResolver* resolver = executor()->resolver();
+    CompletionCallback* dns_callback =
+        non_blocking_dns_ && num_dns_restarts_ < kMaxDnsRestarts ?
+            &dns_callback_ : NULL;
     int rv = resolver->GetProxyForURL(
-        url_, &results_buf_, NULL, NULL, net_log_);
+        url_, &results_buf_, dns_callback, NULL, net_log_);
     DCHECK_NE(rv, ERR_IO_PENDING);
 
     origin_loop->PostTask(
@@ -267,6 +378,27 @@ class MultiThreadedProxyResolver::GetProxyForURLJob
  private:
   // Runs the completion callback on the origin thread.
   void QueryComplete(int result_code) {
+    if (result_code == ERR_DNS_CACHE_MISS && executor()) {
+      // The resolver is looking up the hosts the script needs in the
+      // background, and will run |dns_callback_| when they are cached. Give
+      // the executor back in the meantime. Even a cancelled job has to wait,
+      // to keep |dns_callback_| alive.
+      ++num_dns_restarts_;
+      was_waiting_for_thread_ = false;
+      waiting_for_dns_ = true;
+      coordinator_->AddJobWaitingForDns(this);
+      OnJobCompleted();
+      set_executor(NULL);
+      if (dns_ready_)
+        OnDnsReady(OK);
+      return;
+    }
+
+    // Even a cancelled job's result is good for the cache, as long as the
+    // executor, and so the script that produced it, is still around.
+    if (result_code == OK && executor() && executor()->coordinator())
+      executor()->coordinator()->CacheResult(url_, results_buf_);
+
     // The Job may have been cancelled after it was started.
     if (!was_cancelled()) {
       if (result_code >= OK) {  // Note: unit-tests use values > 0.
@@ -277,7 +409,21 @@ class MultiThreadedProxyResolver::GetProxyForURLJob
     OnJobCompleted();
   }
 
-  // Must only be used on the "origin" thread.
+  // Runs on the origin thread, which must be the host resolver's, once the
+  // lookups that the last run missed are cached.
+  void OnDnsReady(int result) {
+    DCHECK(coordinator_->CalledOnValidThread());
+    dns_ready_ = true;
+    if (!waiting_for_dns_)
+      return;  // QueryComplete() hasn't run yet.
+    waiting_for_dns_ = false;
+    dns_ready_ = false;
+    coordinator_->RestartJob(this);
+  }
+
+  // Must only be used on the "origin" thread. |coordinator_| is only used
+  // while the job waits for DNS, when it is known to be alive.
+  MultiThreadedProxyResolver* const coordinator_;
   ProxyInfo* results_;
 
   // Can be used on either "origin" or worker thread.
@@ -288,6 +434,14 @@ class MultiThreadedProxyResolver::GetProxyForURLJob
   ProxyInfo results_buf_;
 
   bool was_waiting_for_thread_;
+
+  const bool non_blocking_dns_;
+  // Only changed on the origin thread, while the job isn't running.
+  int num_dns_restarts_;
+  // Used on the origin thread.
+  bool waiting_for_dns_;
+  bool dns_ready_;
+  CompletionCallbackImpl<GetProxyForURLJob> dns_callback_;
 };
 
 // MultiThreadedProxyResolver::Executor ----------------------------------------
@@ -384,11 +538,16 @@ MultiThreadedProxyResolver::MultiThreadedProxyResolver(
     size_t max_num_threads)
     : ProxyResolver(resolver_factory->resolvers_expect_pac_bytes()),
       resolver_factory_(resolver_factory),
-      max_num_threads_(max_num_threads) {
+      max_num_threads_(max_num_threads),
+      non_blocking_dns_(false),
+      cache_results_(false),
+      max_cached_results_(kDefaultMaxCachedResults) {
   DCHECK_GE(max_num_threads, 1u);
+  NetworkChangeNotifier::AddIPAddressObserver(this);
 }
 
 MultiThreadedProxyResolver::~MultiThreadedProxyResolver() {
+  NetworkChangeNotifier::RemoveIPAddressObserver(this);
   // We will cancel all outstanding requests.
   pending_jobs_.clear();
   ReleaseAllExecutors();
@@ -404,8 +563,12 @@ int MultiThreadedProxyResolver::GetProxyForURL(const GURL& url,
   DCHECK(current_script_data_.get())
       << "Resolver is un-initialized. Must call SetPacScript() first!";
 
+  if (GetCachedResult(url, results))
+    return OK;
+
   scoped_refptr<GetProxyForURLJob> job(
-      new GetProxyForURLJob(url, results, callback, net_log));
+      new GetProxyForURLJob(this, url, results, callback, non_blocking_dns_,
+                            net_log));
 
   // Completion will be notified through |callback|, unless the caller cancels
   // the request using |request|.
@@ -448,11 +611,18 @@ void MultiThreadedProxyResolver::CancelRequest(RequestHandle req) {
     // as cancelled so the user callback isn't run on completion.
     job->Cancel();
   } else {
-    // Otherwise the job is just sitting in a queue.
+    // Otherwise the job is just sitting in a queue, or waiting for DNS.
     PendingJobsQueue::iterator it =
         std::find(pending_jobs_.begin(), pending_jobs_.end(), job);
-    DCHECK(it != pending_jobs_.end());
-    pending_jobs_.erase(it);
+    if (it != pending_jobs_.end()) {
+      pending_jobs_.erase(it);
+    } else {
+      // It is dropped once its lookups are done.
+      DCHECK(std::find(jobs_waiting_for_dns_.begin(),
+                       jobs_waiting_for_dns_.end(), job) !=
+             jobs_waiting_for_dns_.end());
+      job->Cancel();
+    }
   }
 }
 
@@ -466,6 +636,8 @@ void MultiThreadedProxyResolver::CancelSetPacScript() {
   // Defensively clear some data which shouldn't be getting used
   // anymore.
   current_script_data_ = NULL;
+  ClearResultCache();
+  cache_results_ = false;
 
   ReleaseAllExecutors();
 }
@@ -488,6 +660,11 @@ int MultiThreadedProxyResolver::SetPacScript(
   // Save the script details, so we can provision new executors later.
   current_script_data_ = script_data;
 
+  ClearResultCache();
+  cache_results_ = max_cached_results_ > 0 &&
+      script_data->type() == ProxyResolverScriptData::TYPE_SCRIPT_CONTENTS &&
+      ScriptDependsOnlyOnHost(script_data->utf16());
+
   // The user should not have any outstanding requests when they call
   // SetPacScript().
   CheckNoOutstandingUserRequests();
@@ -502,6 +679,12 @@ int MultiThreadedProxyResolver::SetPacScript(
   return ERR_IO_PENDING;
 }
 
+void MultiThreadedProxyResolver::OnIPAddressChanged() {
+  DCHECK(CalledOnValidThread());
+  // The script may look at DNS or at myIpAddress().
+  ClearResultCache();
+}
+
 void MultiThreadedProxyResolver::CheckNoOutstandingUserRequests() const {
   DCHECK(CalledOnValidThread());
   CHECK_EQ(0u, pending_jobs_.size());
@@ -518,6 +701,11 @@ void MultiThreadedProxyResolver::CheckNoOutstandingUserRequests() const {
     // for a new request to be started from within the callback).
     CHECK(!job || job->was_cancelled() || !job->has_user_callback());
   }
+
+  for (JobList::const_iterator it = jobs_waiting_for_dns_.begin();
+       it != jobs_waiting_for_dns_.end(); ++it) {
+    CHECK((*it)->was_cancelled());
+  }
 }
 
 void MultiThreadedProxyResolver::ReleaseAllExecutors() {
@@ -528,6 +716,14 @@ void MultiThreadedProxyResolver::ReleaseAllExecutors() {
     executor->Destroy();
   }
   executors_.clear();
+
+  // Destroying the executors shut down their resolvers, so the lookups these
+  // jobs were waiting for won't complete.
+  for (JobList::iterator it = jobs_waiting_for_dns_.begin();
+       it != jobs_waiting_for_dns_.end(); ++it) {
+    (*it)->Cancel();
+  }
+  jobs_waiting_for_dns_.clear();
 }
 
 MultiThreadedProxyResolver::Executor*
@@ -567,4 +763,77 @@ void MultiThreadedProxyResolver::OnExecutorReady(Executor* executor) {
   executor->StartJob(job);
 }
 
+void MultiThreadedProxyResolver::AddJobWaitingForDns(GetProxyForURLJob* job) {
+  DCHECK(CalledOnValidThread());
+  jobs_waiting_for_dns_.push_back(make_scoped_refptr(job));
+}
+
+void MultiThreadedProxyResolver::RestartJob(GetProxyForURLJob* job) {
+  DCHECK(CalledOnValidThread());
+  JobList::iterator it = std::find(jobs_waiting_for_dns_.begin(),
+                                   jobs_waiting_for_dns_.end(), job);
+  DCHECK(it != jobs_waiting_for_dns_.end());
+  scoped_refptr<GetProxyForURLJob> restarted_job = *it;
+  jobs_waiting_for_dns_.erase(it);
+
+  if (job->was_cancelled())
+    return;
+
+  // It has waited its turn already.
+  pending_jobs_.push_front(restarted_job);
+  Executor* executor = FindIdleExecutor();
+  if (executor)
+    OnExecutorReady(executor);
+}
+
+bool MultiThreadedProxyResolver::GetCachedResult(const GURL& url,
+                                                 ProxyInfo* results) {
+  DCHECK(CalledOnValidThread());
+  CachedResultMap::iterator it = cached_result_index_.find(url.host());
+  if (it == cached_result_index_.end())
+    return false;
+
+  if (base::TimeTicks::Now() >= it->second->second.expiration) {
+    cached_results_.erase(it->second);
+    cached_result_index_.erase(it);
+    return false;
+  }
+
+  // Move the entry to the back, as the most recently used.
+  cached_results_.splice(cached_results_.end(), cached_results_, it->second);
+  results->Use(it->second->second.proxy_info);
+  return true;
+}
+
+void MultiThreadedProxyResolver::CacheResult(const GURL& url,
+                                             const ProxyInfo& results) {
+  DCHECK(CalledOnValidThread());
+  if (!cache_results_ || max_cached_results_ == 0)
+    return;
+
+  const std::string& host = url.host();
+  CachedResultMap::iterator it = cached_result_index_.find(host);
+  if (it != cached_result_index_.end()) {
+    cached_results_.erase(it->second);
+    cached_result_index_.erase(it);
+  }
+
+  while (cached_results_.size() >= max_cached_results_) {
+    cached_result_index_.erase(cached_results_.front().first);
+    cached_results_.pop_front();
+  }
+
+  CachedResult result;
+  result.proxy_info.Use(results);
+  result.expiration = base::TimeTicks::Now() +
+      base::TimeDelta::FromSeconds(kCachedResultLifetimeSeconds);
+  cached_results_.push_back(std::make_pair(host, result));
+  cached_result_index_[host] = --cached_results_.end();
+}
+
+void MultiThreadedProxyResolver::ClearResultCache() {
+  cached_results_.clear();
+  cached_result_index_.clear();
+}
+
 }  // namespace net
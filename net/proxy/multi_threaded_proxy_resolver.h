@@ -7,12 +7,18 @@
 #pragma once
 
 #include <deque>
+#include <list>
+#include <map>
+#include <string>
 #include <vector>
 
 #include "base/basictypes.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/threading/non_thread_safe.h"
+#include "base/time.h"
+#include "net/base/network_change_notifier.h"
+#include "net/proxy/proxy_info.h"
 #include "net/proxy/proxy_resolver.h"
 
 namespace base {
@@ -71,8 +77,24 @@ class ProxyResolverFactory {
 //     a global counter and using that to make a decision. In the
 //     multi-threaded model, each thread may have a different value for this
 //     counter, so it won't globally be seen as monotonically increasing!
-class MultiThreadedProxyResolver : public ProxyResolver,
-                                   public base::NonThreadSafe {
+//
+// Most PAC scripts only look at the host of the URL. When a scan of the
+// script shows that its FindProxyForURL() never reads the |url| argument, nor
+// anything that changes with time, the results are cached by host. Repeat
+// requests for a host are then answered synchronously, without a trip to a
+// worker thread. The cache is bounded and LRU. It is cleared when the script
+// or the IP address changes, and its entries expire after a minute in case
+// the script looks at DNS.
+//
+// With set_non_blocking_dns(true), a request whose script needs a DNS lookup
+// that isn't cached gives its thread back while the lookup runs, and is put
+// back in the queue once the result is cached (see
+// ProxyResolverV8::GetProxyForURL()). A slow lookup then delays only the
+// requests that need it.
+class MultiThreadedProxyResolver
+    : public ProxyResolver,
+      public NetworkChangeNotifier::IPAddressObserver,
+      public base::NonThreadSafe {
  public:
   // Creates an asynchronous ProxyResolver that runs requests on up to
   // |max_num_threads|.
@@ -102,6 +124,21 @@ class MultiThreadedProxyResolver : public ProxyResolver,
       const scoped_refptr<ProxyResolverScriptData>& script_data,
       CompletionCallback* callback);
 
+  // Sets the number of hosts whose results are cached. 0 turns the cache
+  // off. Takes effect from the next SetPacScript().
+  void set_max_cached_results(size_t max_cached_results) {
+    max_cached_results_ = max_cached_results;
+  }
+
+  // Sets whether the synchronous resolvers are given a callback, so that
+  // they can defer DNS lookups rather than block on them. Off by default.
+  void set_non_blocking_dns(bool non_blocking_dns) {
+    non_blocking_dns_ = non_blocking_dns;
+  }
+
+  // NetworkChangeNotifier::IPAddressObserver implementation:
+  virtual void OnIPAddressChanged();
+
  private:
   class Executor;
   class Job;
@@ -111,6 +148,15 @@ class MultiThreadedProxyResolver : public ProxyResolver,
   // TODO(eroman): Make this priority queue.
   typedef std::deque<scoped_refptr<Job> > PendingJobsQueue;
   typedef std::vector<scoped_refptr<Executor> > ExecutorList;
+  typedef std::vector<scoped_refptr<GetProxyForURLJob> > JobList;
+
+  struct CachedResult {
+    ProxyInfo proxy_info;
+    base::TimeTicks expiration;
+  };
+  // (host, result) pairs, least recently used first.
+  typedef std::list<std::pair<std::string, CachedResult> > CachedResultList;
+  typedef std::map<std::string, CachedResultList::iterator> CachedResultMap;
 
   // Asserts that there are no outstanding user-initiated jobs on any of the
   // worker threads.
@@ -129,11 +175,36 @@ class MultiThreadedProxyResolver : public ProxyResolver,
   // Starts the next job from |pending_jobs_| if possible.
   void OnExecutorReady(Executor* executor);
 
+  // Holds on to |job| while the DNS lookups it needs are running.
+  void AddJobWaitingForDns(GetProxyForURLJob* job);
+
+  // Puts |job|, whose DNS lookups are now cached, at the front of the queue.
+  void RestartJob(GetProxyForURLJob* job);
+
+  // Copies the cached result for the host of |url| to |results|. Returns
+  // false if there is none.
+  bool GetCachedResult(const GURL& url, ProxyInfo* results);
+
+  // Caches |results| as the result for the host of |url|, if caching is on.
+  void CacheResult(const GURL& url, const ProxyInfo& results);
+
+  void ClearResultCache();
+
   const scoped_ptr<ProxyResolverFactory> resolver_factory_;
   const size_t max_num_threads_;
   PendingJobsQueue pending_jobs_;
   ExecutorList executors_;
   scoped_refptr<ProxyResolverScriptData> current_script_data_;
+
+  bool non_blocking_dns_;
+  // The jobs whose DNS lookups are running. They belong to no executor.
+  JobList jobs_waiting_for_dns_;
+
+  // Whether the results of |current_script_data_| are cached by host.
+  bool cache_results_;
+  size_t max_cached_results_;
+  CachedResultList cached_results_;
+  CachedResultMap cached_result_index_;
 };
 
 }  // namespace net
@@ -33,7 +33,8 @@ class MockProxyResolver : public ProxyResolver {
         wrong_loop_(MessageLoop::current()),
         request_count_(0),
         purge_count_(0),
-        resolve_latency_ms_(0) {}
+        resolve_latency_ms_(0),
+        always_return_ok_(false) {}
 
   // ProxyResolver implementation:
   virtual int GetProxyForURL(const GURL& query_url,
@@ -55,7 +56,8 @@ class MockProxyResolver : public ProxyResolver {
     results->UseNamedProxy(query_url.host());
 
     // Return a success code which represents the request's order.
-    return request_count_++;
+    int rv = request_count_++;
+    return always_return_ok_ ? OK : rv;
   }
 
   virtual void CancelRequest(RequestHandle request) {
@@ -90,6 +92,11 @@ class MockProxyResolver : public ProxyResolver {
     resolve_latency_ms_ = latency_ms;
   }
 
+  // Makes every request return OK, rather than its number.
+  void set_always_return_ok(bool always_return_ok) {
+    always_return_ok_ = always_return_ok;
+  }
+
  private:
   void CheckIsOnWorkerThread() {
     // We should be running on the worker thread -- while we don't know the
@@ -104,6 +111,7 @@ class MockProxyResolver : public ProxyResolver {
   int purge_count_;
   scoped_refptr<ProxyResolverScriptData> last_script_data_;
   int resolve_latency_ms_;
+  bool always_return_ok_;
 };
 
 
@@ -772,6 +780,207 @@ TEST(MultiThreadedProxyResolverTest, OneThreadBlocked) {
   EXPECT_EQ(3, factory->resolvers()[1]->request_count());
 }
 
+// Loads |script| into |resolver|, then resolves two URLs with the same host.
+// Returns true if the second was answered from the cache.
+bool SecondRequestForHostIsCached(MultiThreadedProxyResolver* resolver,
+                                  const char* script) {
+  TestCompletionCallback set_script_callback;
+  EXPECT_EQ(ERR_IO_PENDING,
+            resolver->SetPacScript(ProxyResolverScriptData::FromUTF8(script),
+                                   &set_script_callback));
+  EXPECT_EQ(OK, set_script_callback.WaitForResult());
+
+  TestCompletionCallback callback;
+  ProxyInfo results;
+  int rv = resolver->GetProxyForURL(GURL("http://host/path1"), &results,
+                                    &callback, NULL, BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, callback.WaitForResult());
+
+  rv = resolver->GetProxyForURL(GURL("https://host/path2"), &results,
+                                &callback, NULL, BoundNetLog());
+  bool cached = rv != ERR_IO_PENDING;
+  EXPECT_EQ(OK, callback.GetResult(rv));
+  EXPECT_EQ("PROXY host:80", results.ToPacString());
+  return cached;
+}
+
+TEST(MultiThreadedProxyResolverTest, CachesResultsOfHostOnlyScripts) {
+  scoped_ptr<MockProxyResolver> mock(new MockProxyResolver);
+  mock->set_always_return_ok(true);
+  MultiThreadedProxyResolver resolver(
+      new ForwardingProxyResolverFactory(mock.get()), 1u);
+
+  EXPECT_TRUE(SecondRequestForHostIsCached(&resolver,
+      "function FindProxyForURL(url, host) {\n"
+      "  // Send the intranet direct.\n"
+      "  if (isPlainHostName(host) || dnsDomainIs(host, '.corp'))\n"
+      "    return 'DIRECT';\n"
+      "  return 'PROXY proxy:80';\n"
+      "}\n"));
+  EXPECT_EQ(1, mock->request_count());
+
+  // Scripts that read |url|, change with time, or can't be understood by a
+  // scan of their words aren't cached.
+  const char* kUncacheableScripts[] = {
+    "function FindProxyForURL(url, host) {\n"
+    "  if (shExpMatch(url, 'http://*/private/*')) return 'DIRECT';\n"
+    "  return 'PROXY proxy:80';\n"
+    "}\n",
+    "function FindProxyForURL(u, host) { return arguments[0]; }",
+    "function FindProxyForURL(url, host) {\n"
+    "  if (weekdayRange('SAT', 'SUN')) return 'DIRECT';\n"
+    "  return 'PROXY proxy:80';\n"
+    "}\n",
+    "function FindProxyForURL(url, host) {\n"
+    "  return Math.random() < 0.5 ? 'PROXY a:80' : 'PROXY b:80';\n"
+    "}\n",
+    "var FindProxyForURL = function(url, host) { return 'DIRECT'; }",
+    "function FindProxyForURL(url, host) { return 'DIRECT'; }\n"
+    "function FindProxyForURL(url, host) { return url; }\n",
+    "function FindProxyForURL(\\u0075rl, host) { return url; }",
+    "pac script bytes",
+  };
+  for (size_t i = 0; i < arraysize(kUncacheableScripts); ++i) {
+    SCOPED_TRACE(kUncacheableScripts[i]);
+    EXPECT_FALSE(SecondRequestForHostIsCached(&resolver,
+                                              kUncacheableScripts[i]));
+  }
+
+  // Turning the cache off works too.
+  resolver.set_max_cached_results(0);
+  EXPECT_FALSE(SecondRequestForHostIsCached(&resolver,
+      "function FindProxyForURL(url, host) { return 'DIRECT'; }"));
+}
+
+TEST(MultiThreadedProxyResolverTest, ClearsResultCache) {
+  scoped_ptr<MockProxyResolver> mock(new MockProxyResolver);
+  mock->set_always_return_ok(true);
+  MultiThreadedProxyResolver resolver(
+      new ForwardingProxyResolverFactory(mock.get()), 1u);
+  const char kScript[] =
+      "function FindProxyForURL(url, host) { return 'DIRECT'; }";
+
+  ASSERT_TRUE(SecondRequestForHostIsCached(&resolver, kScript));
+  EXPECT_EQ(1, mock->request_count());
+
+  // Setting the script again starts from an empty cache.
+  ASSERT_TRUE(SecondRequestForHostIsCached(&resolver, kScript));
+  EXPECT_EQ(2, mock->request_count());
+
+  // So does a change of IP address.
+  resolver.OnIPAddressChanged();
+  TestCompletionCallback callback;
+  ProxyInfo results;
+  EXPECT_EQ(ERR_IO_PENDING,
+            resolver.GetProxyForURL(GURL("http://host/"), &results, &callback,
+                                    NULL, BoundNetLog()));
+  EXPECT_EQ(OK, callback.WaitForResult());
+  EXPECT_EQ(3, mock->request_count());
+}
+
+// A mock synchronous ProxyResolver that, whenever it is allowed to, reports
+// that its script needs a host that isn't cached yet. The host is "cached" as
+// soon as the origin loop runs.
+class DnsMissingProxyResolver : public MockProxyResolver {
+ public:
+  DnsMissingProxyResolver()
+      : origin_loop_(MessageLoop::current()),
+        miss_count_(0) {
+  }
+
+  virtual int GetProxyForURL(const GURL& query_url,
+                             ProxyInfo* results,
+                             CompletionCallback* callback,
+                             RequestHandle* request,
+                             const BoundNetLog& net_log) {
+    if (callback) {
+      ++miss_count_;
+      origin_loop_->PostTask(FROM_HERE,
+                             NewRunnableFunction(&RunCallback, callback));
+      return ERR_DNS_CACHE_MISS;
+    }
+    return MockProxyResolver::GetProxyForURL(query_url, results, NULL,
+                                             request, net_log);
+  }
+
+  int miss_count() const { return miss_count_; }
+
+ private:
+  static void RunCallback(CompletionCallback* callback) {
+    callback->Run(OK);
+  }
+
+  MessageLoop* origin_loop_;
+  int miss_count_;
+};
+
+TEST(MultiThreadedProxyResolverTest, NonBlockingDns) {
+  scoped_ptr<DnsMissingProxyResolver> mock(new DnsMissingProxyResolver);
+  MultiThreadedProxyResolver resolver(
+      new ForwardingProxyResolverFactory(mock.get()), 1u);
+
+  TestCompletionCallback set_script_callback;
+  int rv = resolver.SetPacScript(
+      ProxyResolverScriptData::FromUTF8("pac script bytes"),
+      &set_script_callback);
+  EXPECT_EQ(OK, set_script_callback.GetResult(rv));
+
+  // Without non-blocking DNS, the resolver is never asked to defer lookups.
+  TestCompletionCallback callback0;
+  ProxyInfo results0;
+  rv = resolver.GetProxyForURL(GURL("http://request0"), &results0,
+                               &callback0, NULL, BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(0, callback0.WaitForResult());
+  EXPECT_EQ(0, mock->miss_count());
+
+  // With it, the request is restarted each time the lookups it missed are
+  // done, until it is left to block.
+  resolver.set_non_blocking_dns(true);
+  TestCompletionCallback callback1;
+  ProxyInfo results1;
+  rv = resolver.GetProxyForURL(GURL("http://request1"), &results1,
+                               &callback1, NULL, BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(1, callback1.WaitForResult());
+  EXPECT_EQ("PROXY request1:80", results1.ToPacString());
+  EXPECT_EQ(4, mock->miss_count());
+}
+
+// A request that is cancelled while it waits for DNS never completes.
+TEST(MultiThreadedProxyResolverTest, NonBlockingDns_CancelRequest) {
+  scoped_ptr<DnsMissingProxyResolver> mock(new DnsMissingProxyResolver);
+  mock->set_always_return_ok(true);
+  MultiThreadedProxyResolver resolver(
+      new ForwardingProxyResolverFactory(mock.get()), 1u);
+  resolver.set_non_blocking_dns(true);
+
+  TestCompletionCallback set_script_callback;
+  int rv = resolver.SetPacScript(
+      ProxyResolverScriptData::FromUTF8("pac script bytes"),
+      &set_script_callback);
+  EXPECT_EQ(OK, set_script_callback.GetResult(rv));
+
+  TestCompletionCallback callback0;
+  ProxyInfo results0;
+  ProxyResolver::RequestHandle request0;
+  rv = resolver.GetProxyForURL(GURL("http://request0"), &results0,
+                               &callback0, &request0, BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  resolver.CancelRequest(request0);
+
+  // A later request still gets its answer.
+  TestCompletionCallback callback1;
+  ProxyInfo results1;
+  rv = resolver.GetProxyForURL(GURL("http://request1"), &results1,
+                               &callback1, NULL, BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, callback1.WaitForResult());
+  EXPECT_EQ("PROXY request1:80", results1.ToPacString());
+  EXPECT_FALSE(callback0.have_result());
+}
+
 }  // namespace
 
 }  // namespace net
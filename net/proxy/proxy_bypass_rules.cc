@@ -52,6 +52,11 @@ class HostnamePatternRule : public ProxyBypassRules::Rule {
                                    optional_port_);
   }
 
+  virtual bool AddToMatcher(int id, HostPatternMatcher* matcher) const {
+    matcher->AddPattern(hostname_pattern_, id);
+    return true;
+  }
+
  private:
   const std::string optional_scheme_;
   const std::string hostname_pattern_;
@@ -120,6 +125,11 @@ class BypassIPBlockRule : public ProxyBypassRules::Rule {
                                  prefix_length_in_bits_);
   }
 
+  virtual bool AddToMatcher(int id, HostPatternMatcher* matcher) const {
+    matcher->AddIPBlock(ip_prefix_, prefix_length_in_bits_, id);
+    return true;
+  }
+
  private:
   const std::string description_;
   const std::string optional_scheme_;
@@ -150,6 +160,11 @@ bool ProxyBypassRules::Rule::Equals(const Rule& rule) const {
   return ToString() == rule.ToString();
 }
 
+bool ProxyBypassRules::Rule::AddToMatcher(int id,
+                                          HostPatternMatcher* matcher) const {
+  return false;
+}
+
 ProxyBypassRules::ProxyBypassRules() {
 }
 
@@ -167,8 +182,19 @@ ProxyBypassRules& ProxyBypassRules::operator=(const ProxyBypassRules& rhs) {
 }
 
 bool ProxyBypassRules::Matches(const GURL& url) const {
-  for (RuleList::const_iterator it = rules_.begin(); it != rules_.end(); ++it) {
-    if ((*it)->Matches(url))
+  // Only the rules |matcher_| picks out for the URL's host, and the ones it
+  // knows nothing about, have to be tested. Note it is necessary to lower-case
+  // the host, since GURL uses capital letters for percent-escaped characters.
+  std::vector<int> candidates(unindexed_rules_);
+  matcher_.GetMatches(StringToLowerASCII(url.host()), &candidates);
+  if (url.HostIsIPAddress()) {
+    IPAddressNumber ip_number;
+    if (ParseIPLiteralToNumber(url.HostNoBrackets(), &ip_number))
+      matcher_.GetIPBlockMatches(ip_number, &candidates);
+  }
+
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (rules_[candidates[i]]->Matches(url))
       return true;
   }
   return false;
@@ -200,14 +226,14 @@ bool ProxyBypassRules::AddRuleForHostname(const std::string& optional_scheme,
   if (hostname_pattern.empty())
     return false;
 
-  rules_.push_back(new HostnamePatternRule(optional_scheme,
-                                           hostname_pattern,
-                                           optional_port));
+  AddRule(new HostnamePatternRule(optional_scheme,
+                                  hostname_pattern,
+                                  optional_port));
   return true;
 }
 
 void ProxyBypassRules::AddRuleToBypassLocal() {
-  rules_.push_back(new BypassLocalRule);
+  AddRule(new BypassLocalRule);
 }
 
 bool ProxyBypassRules::AddRuleFromString(const std::string& raw) {
@@ -232,6 +258,8 @@ std::string ProxyBypassRules::ToString() const {
 
 void ProxyBypassRules::Clear() {
   STLDeleteElements(&rules_);
+  matcher_.Clear();
+  unindexed_rules_.clear();
 }
 
 void ProxyBypassRules::AssignFrom(const ProxyBypassRules& other) {
@@ -240,7 +268,7 @@ void ProxyBypassRules::AssignFrom(const ProxyBypassRules& other) {
   // Make a copy of the rules list.
   for (RuleList::const_iterator it = other.rules_.begin();
        it != other.rules_.end(); ++it) {
-    rules_.push_back((*it)->Clone());
+    AddRule((*it)->Clone());
   }
 }
 
@@ -291,7 +319,7 @@ bool ProxyBypassRules::AddRuleFromStringInternal(
     if (!ParseCIDRBlock(raw, &ip_prefix, &prefix_length_in_bits))
       return false;
 
-    rules_.push_back(
+    AddRule(
         new BypassIPBlockRule(raw, scheme, ip_prefix, prefix_length_in_bits));
 
     return true;
@@ -340,4 +368,11 @@ bool ProxyBypassRules::AddRuleFromStringInternalWithLogging(
   return AddRuleFromStringInternal(raw, use_hostname_suffix_matching);
 }
 
+void ProxyBypassRules::AddRule(Rule* rule) {
+  int id = static_cast<int>(rules_.size());
+  rules_.push_back(rule);
+  if (!rule->AddToMatcher(id, &matcher_))
+    unindexed_rules_.push_back(id);
+}
+
 }  // namespace net
@@ -10,12 +10,17 @@
 #include <vector>
 
 #include "googleurl/src/gurl.h"
+#include "net/base/host_pattern_matcher.h"
 
 namespace net {
 
 // ProxyBypassRules describes the set of URLs that should bypass the proxy
 // settings, as a list of rules. A URL is said to match the bypass rules
 // if it matches any one of these rules.
+//
+// The hostname patterns and IP blocks of the rules are also compiled into a
+// HostPatternMatcher, so that a URL is only tested against the few rules that
+// could match it, however long the list is.
 class ProxyBypassRules {
  public:
   // Interface for an individual proxy bypass rule.
@@ -34,6 +39,12 @@ class ProxyBypassRules {
     // Creates a copy of this rule. (Caller is responsible for deleting it)
     virtual Rule* Clone() const = 0;
 
+    // Adds the hostnames or addresses this rule can match to |matcher|, with
+    // |id|, and returns true. Matches() is then only called for the URLs which
+    // |matcher| finds |id| for. Rules that can't be described this way return
+    // false, and are tested against every URL.
+    virtual bool AddToMatcher(int id, HostPatternMatcher* matcher) const;
+
     bool Equals(const Rule& rule) const;
 
    private:
@@ -174,7 +185,15 @@ class ProxyBypassRules {
   bool AddRuleFromStringInternalWithLogging(const std::string& raw,
                                             bool use_hostname_suffix_matching);
 
+  // Appends |rule| to |rules_|, and takes ownership of it.
+  void AddRule(Rule* rule);
+
   RuleList rules_;
+
+  // Finds the candidate rules for a URL, by their index in |rules_|.
+  HostPatternMatcher matcher_;
+  // The indices of the rules which aren't in |matcher_|.
+  std::vector<int> unindexed_rules_;
 };
 
 }  // namespace net
@@ -310,6 +310,40 @@ TEST(ProxyBypassRulesTest, ParseAndMatchCIDR_IPv6) {
   EXPECT_FALSE(rules.Matches(GURL("http://192.169.1.1")));
 }
 
+// A long list mixing every kind of rule, which a copy of the rules must match
+// the same way.
+TEST(ProxyBypassRulesTest, ManyRules) {
+  std::string raw;
+  for (int i = 0; i < 500; ++i)
+    base::StringAppendF(&raw, "host%d.example.com, .domain%d.com:%d, ", i, i,
+                        1000 + i);
+  raw += "http://*.scheme.com, www.*.org, 10.1.0.0/16, <local>";
+
+  ProxyBypassRules original;
+  original.ParseFromString(raw);
+  ASSERT_EQ(1004u, original.rules().size());
+  ProxyBypassRules rules(original);
+  original.Clear();
+
+  EXPECT_TRUE(rules.Matches(GURL("http://host0.example.com")));
+  EXPECT_TRUE(rules.Matches(GURL("http://HOST499.example.com")));
+  EXPECT_FALSE(rules.Matches(GURL("http://host500.example.com")));
+  EXPECT_FALSE(rules.Matches(GURL("http://xhost1.example.com")));
+
+  EXPECT_TRUE(rules.Matches(GURL("http://a.domain7.com:1007")));
+  EXPECT_FALSE(rules.Matches(GURL("http://a.domain7.com:1008")));
+  EXPECT_FALSE(rules.Matches(GURL("http://a.domain7.com")));
+
+  EXPECT_TRUE(rules.Matches(GURL("http://a.scheme.com")));
+  EXPECT_FALSE(rules.Matches(GURL("https://a.scheme.com")));
+  EXPECT_TRUE(rules.Matches(GURL("http://www.chromium.org")));
+  EXPECT_FALSE(rules.Matches(GURL("http://dev.chromium.org")));
+
+  EXPECT_TRUE(rules.Matches(GURL("http://10.1.2.3")));
+  EXPECT_FALSE(rules.Matches(GURL("http://10.2.2.3")));
+  EXPECT_TRUE(rules.Matches(GURL("http://localhost")));
+}
+
 }  // namespace
 
 }  // namespace net
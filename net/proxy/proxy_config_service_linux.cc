@@ -1122,6 +1122,7 @@ void ProxyConfigServiceLinux::Delegate::SetupAndFetchInitialConfig(
   // mislead us.
 
   bool got_config = false;
+  bool watching_empty_settings = false;
   if (gconf_getter_.get()) {
     if (gconf_getter_->Init(glib_default_loop, file_loop) &&
         (!io_loop || !file_loop || gconf_getter_->SetupNotification(this))) {
@@ -1139,8 +1140,14 @@ void ProxyConfigServiceLinux::Delegate::SetupAndFetchInitialConfig(
         // comparison with updated settings when we get notifications.
         reference_config_ = cached_config_;
         reference_config_.set_id(1);  // mark it as valid
+      } else if (!io_loop || !file_loop) {
+        gconf_getter_->Shutdown();
       } else {
-        gconf_getter_->Shutdown();  // Stop notifications
+        // Keep the notifications going: the settings may be filled in
+        // later (e.g. kioslaverc is only written once the user changes
+        // something), and they should take over from the environment
+        // variables when they are.
+        watching_empty_settings = true;
       }
     }
   }
@@ -1155,6 +1162,8 @@ void ProxyConfigServiceLinux::Delegate::SetupAndFetchInitialConfig(
       cached_config_.set_id(1);  // mark it as valid
       VLOG(1) << "Obtained proxy settings from environment variables";
     }
+    if (watching_empty_settings)
+      reference_config_ = cached_config_;
   }
 }
 
@@ -1192,6 +1201,12 @@ void ProxyConfigServiceLinux::Delegate::OnCheckProxyConfigSettings() {
   DCHECK(!required_loop || MessageLoop::current() == required_loop);
   ProxyConfig new_config;
   bool valid = GetConfigFromGConf(&new_config);
+  if (!valid) {
+    // The settings are gone, or still aren't there, so the environment
+    // variables apply, as they would have at startup.
+    new_config = ProxyConfig();
+    valid = GetConfigFromEnv(&new_config);
+  }
   if (valid)
     new_config.set_id(1);  // mark it as valid
 
@@ -135,9 +135,11 @@ class ProxyConfigServiceLinux : public ProxyConfigService {
                                     MessageLoopForIO* file_loop);
 
     // Handler for gconf change notifications: fetches a new proxy
-    // configuration from gconf settings, and if this config is
-    // different than what we had before, posts a task to have it
-    // stored in cached_config_.
+    // configuration from gconf settings (or from the environment, if
+    // gconf has none), and if this config is different than what we had
+    // before, posts a task to have it stored in cached_config_.
+    // Notifications stay enabled when gconf has no settings at startup,
+    // so that settings added later are picked up.
     // Left public for simplicity.
     void OnCheckProxyConfigSettings();
 
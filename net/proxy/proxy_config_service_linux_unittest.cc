@@ -974,6 +974,39 @@ TEST_F(ProxyConfigServiceLinuxTest, GconfNotification) {
   EXPECT_TRUE(config.auto_detect());
 }
 
+// Settings that only show up after startup still take over from the
+// environment variables, and the environment applies again once they go.
+TEST_F(ProxyConfigServiceLinuxTest, GconfNotificationWithoutInitialSettings) {
+  MockEnvironment* env = new MockEnvironment;
+  MockGConfSettingGetter* gconf_getter = new MockGConfSettingGetter;
+  ProxyConfigServiceLinux* service =
+      new ProxyConfigServiceLinux(env, gconf_getter);
+  SynchConfigGetter sync_config_getter(service);
+  ProxyConfig config;
+
+  env->values.http_proxy = "www.google.com:80";
+  sync_config_getter.SetupAndInitialFetch();
+  EXPECT_EQ(ProxyConfigService::CONFIG_VALID,
+            sync_config_getter.SyncGetLatestProxyConfig(&config));
+  EXPECT_FALSE(config.auto_detect());
+  EXPECT_EQ(ProxyConfig::ProxyRules::TYPE_SINGLE_PROXY,
+            config.proxy_rules().type);
+
+  gconf_getter->values.mode = "auto";
+  service->OnCheckProxyConfigSettings();
+  EXPECT_EQ(ProxyConfigService::CONFIG_VALID,
+            sync_config_getter.SyncGetLatestProxyConfig(&config));
+  EXPECT_TRUE(config.auto_detect());
+
+  gconf_getter->Reset();
+  service->OnCheckProxyConfigSettings();
+  EXPECT_EQ(ProxyConfigService::CONFIG_VALID,
+            sync_config_getter.SyncGetLatestProxyConfig(&config));
+  EXPECT_FALSE(config.auto_detect());
+  EXPECT_EQ(ProxyConfig::ProxyRules::TYPE_SINGLE_PROXY,
+            config.proxy_rules().type);
+}
+
 TEST_F(ProxyConfigServiceLinuxTest, KDEConfigParser) {
   // One of the tests below needs a worst-case long line prefix. We build it
   // programmatically so that it will always be the right size.
@@ -8,6 +8,7 @@
 
 #include <string>
 
+#include "base/time.h"
 #include "net/proxy/proxy_config.h"
 #include "net/proxy/proxy_list.h"
 #include "net/proxy/proxy_retry_info.h"
@@ -94,6 +95,14 @@ class ProxyInfo {
   // Deletes any entry which doesn't have one of the specified proxy schemes.
   void RemoveProxiesWithoutScheme(int scheme_bit_field);
 
+  // When ProxyService started and finished resolving this proxy info.
+  base::TimeTicks proxy_resolve_start_time() const {
+    return proxy_resolve_start_time_;
+  }
+  base::TimeTicks proxy_resolve_end_time() const {
+    return proxy_resolve_end_time_;
+  }
+
  private:
   friend class ProxyService;
 
@@ -103,6 +112,9 @@ class ProxyInfo {
 
   // This value identifies the proxy config used to initialize this object.
   ProxyConfig::ID config_id_;
+
+  base::TimeTicks proxy_resolve_start_time_;
+  base::TimeTicks proxy_resolve_end_time_;
 };
 
 }  // namespace net
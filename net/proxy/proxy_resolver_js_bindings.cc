@@ -15,6 +15,7 @@
 #include "net/base/net_util.h"
 #include "net/base/sys_addrinfo.h"
 #include "net/proxy/proxy_resolver_request_context.h"
+#include "net/proxy/sync_host_resolver_bridge.h"
 
 namespace net {
 
@@ -64,8 +65,12 @@ class AlertNetlogParams : public NetLog::EventParameters {
 // ProxyResolverJSBindings implementation.
 class DefaultJSBindings : public ProxyResolverJSBindings {
  public:
-  DefaultJSBindings(HostResolver* host_resolver, NetLog* net_log)
+  // |bridge| may be NULL. Otherwise it is the same object as |host_resolver|.
+  DefaultJSBindings(HostResolver* host_resolver,
+                    SyncHostResolverBridge* bridge,
+                    NetLog* net_log)
       : host_resolver_(host_resolver),
+        bridge_(bridge),
         net_log_(net_log) {
   }
 
@@ -156,6 +161,15 @@ class DefaultJSBindings : public ProxyResolverJSBindings {
     host_resolver_->Shutdown();
   }
 
+  virtual bool ResolveInBackground(
+      const std::vector<HostResolver::RequestInfo>& infos,
+      CompletionCallback* callback) {
+    if (!bridge_)
+      return false;
+    bridge_->ResolveInBackground(infos, callback);
+    return true;
+  }
+
  private:
   bool MyIpAddressImpl(std::string* first_ip_address) {
     std::string my_hostname = GetHostName();
@@ -248,9 +262,25 @@ class DefaultJSBindings : public ProxyResolverJSBindings {
       }
     }
 
-    // Otherwise ask the resolver.
-    int result = host_resolver_->Resolve(info, address_list, NULL, NULL,
-                                         BoundNetLog());
+    // Otherwise ask the resolver. If the request mustn't block, only its
+    // cache is looked at.
+    std::vector<HostResolver::RequestInfo>* missed_lookups =
+        current_request_context() ?
+            current_request_context()->missed_lookups : NULL;
+    int result;
+    if (missed_lookups) {
+      HostResolver::RequestInfo cached_info(info);
+      cached_info.set_only_use_cached_response(true);
+      result = host_resolver_->Resolve(cached_info, address_list, NULL, NULL,
+                                       BoundNetLog());
+      // The miss goes in the per-request cache too, so that it is only
+      // reported once.
+      if (result == ERR_DNS_CACHE_MISS)
+        missed_lookups->push_back(info);
+    } else {
+      result = host_resolver_->Resolve(info, address_list, NULL, NULL,
+                                       BoundNetLog());
+    }
 
     // Save the result back to the per-request DNS cache.
     if (host_cache) {
@@ -286,15 +316,28 @@ class DefaultJSBindings : public ProxyResolverJSBindings {
   }
 
   HostResolver* const host_resolver_;
+  SyncHostResolverBridge* const bridge_;
   NetLog* net_log_;
 };
 
 }  // namespace
 
+bool ProxyResolverJSBindings::ResolveInBackground(
+    const std::vector<HostResolver::RequestInfo>& infos,
+    CompletionCallback* callback) {
+  return false;
+}
+
 // static
 ProxyResolverJSBindings* ProxyResolverJSBindings::CreateDefault(
     HostResolver* host_resolver, NetLog* net_log) {
-  return new DefaultJSBindings(host_resolver, net_log);
+  return new DefaultJSBindings(host_resolver, NULL, net_log);
+}
+
+// static
+ProxyResolverJSBindings* ProxyResolverJSBindings::CreateDefaultWithBridge(
+    SyncHostResolverBridge* host_resolver, NetLog* net_log) {
+  return new DefaultJSBindings(host_resolver, host_resolver, net_log);
 }
 
 }  // namespace net
@@ -7,14 +7,17 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "base/string16.h"
+#include "net/base/completion_callback.h"
+#include "net/base/host_resolver.h"
 
 namespace net {
 
-class HostResolver;
 class NetLog;
 struct ProxyResolverRequestContext;
+class SyncHostResolverBridge;
 
 // Interface for the javascript bindings.
 class ProxyResolverJSBindings {
@@ -58,6 +61,15 @@ class ProxyResolverJSBindings {
   // Called before the thread running the proxy resolver is stopped.
   virtual void Shutdown() = 0;
 
+  // Starts |infos|, lookups that missed the host cache while the current
+  // request context had |missed_lookups| set, without waiting for them.
+  // |callback| runs once they are all cached, on the host resolver's thread.
+  // Returns false if these bindings can't resolve in the background, in
+  // which case the request has to be run again with blocking lookups.
+  virtual bool ResolveInBackground(
+      const std::vector<HostResolver::RequestInfo>& infos,
+      CompletionCallback* callback);
+
   // Creates a default javascript bindings implementation that will:
   //   - Send script error messages to both VLOG(1) and the NetLog.
   //   - Send script alert()s to both VLOG(1) and the NetLog.
@@ -67,6 +79,12 @@ class ProxyResolverJSBindings {
   static ProxyResolverJSBindings* CreateDefault(HostResolver* host_resolver,
                                                 NetLog* net_log);
 
+  // Same as CreateDefault(), but ResolveInBackground() is supported too, by
+  // way of |host_resolver|.
+  static ProxyResolverJSBindings* CreateDefaultWithBridge(
+      SyncHostResolverBridge* host_resolver,
+      NetLog* net_log);
+
   // Sets details about the currently executing FindProxyForURL() request.
   void set_current_request_context(
       ProxyResolverRequestContext* current_request_context) {
@@ -286,6 +286,54 @@ TEST(ProxyResolverJSBindingsTest, PerRequestDNSCache) {
   bindings->set_current_request_context(NULL);
 }
 
+// Test that a request that mustn't block on DNS only gets cached results,
+// and is told which hosts it missed.
+TEST(ProxyResolverJSBindingsTest, MissedLookups) {
+  scoped_ptr<MockCachingHostResolver> host_resolver(
+      new MockCachingHostResolver);
+  host_resolver->rules()->AddRule("foo", "192.168.1.1");
+
+  scoped_ptr<ProxyResolverJSBindings> bindings(
+      ProxyResolverJSBindings::CreateDefault(host_resolver.get(), NULL));
+
+  std::string ip_address;
+  std::vector<HostResolver::RequestInfo> missed_lookups;
+
+  HostCache cache(50,
+                  base::TimeDelta::FromMinutes(10),
+                  base::TimeDelta::FromMinutes(10));
+  ProxyResolverRequestContext context(NULL, &cache);
+  context.missed_lookups = &missed_lookups;
+  bindings->set_current_request_context(&context);
+
+  // "foo" isn't cached yet. The miss is only reported once.
+  EXPECT_FALSE(bindings->DnsResolve("foo", &ip_address));
+  EXPECT_FALSE(bindings->DnsResolve("foo", &ip_address));
+  ASSERT_EQ(1u, missed_lookups.size());
+  EXPECT_EQ("foo", missed_lookups[0].hostname());
+
+  // Once the host resolver has it cached, a new request gets it.
+  bindings->set_current_request_context(NULL);
+  EXPECT_TRUE(bindings->DnsResolve("foo", &ip_address));
+
+  HostCache cache2(50,
+                   base::TimeDelta::FromMinutes(10),
+                   base::TimeDelta::FromMinutes(10));
+  ProxyResolverRequestContext context2(NULL, &cache2);
+  missed_lookups.clear();
+  context2.missed_lookups = &missed_lookups;
+  bindings->set_current_request_context(&context2);
+
+  EXPECT_TRUE(bindings->DnsResolve("foo", &ip_address));
+  EXPECT_EQ("192.168.1.1", ip_address);
+  EXPECT_TRUE(missed_lookups.empty());
+
+  // Without a bridge, the lookups can't be done in the background.
+  EXPECT_FALSE(bindings->ResolveInBackground(missed_lookups, NULL));
+
+  bindings->set_current_request_context(NULL);
+}
+
 // Test that when a binding is called, it logs to the per-request NetLog.
 TEST(ProxyResolverJSBindingsTest, NetLog) {
   scoped_ptr<MockFailingHostResolver> host_resolver(
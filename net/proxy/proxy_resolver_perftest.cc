@@ -1,18 +1,35 @@
-// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "base/base_paths.h"
 #include "base/file_util.h"
+#include "base/message_loop.h"
 #include "base/path_service.h"
 #include "base/perftimer.h"
+#include "base/stl_util-inl.h"
 #include "base/string_util.h"
+#include "base/stringprintf.h"
+#include "base/threading/platform_thread.h"
+#include "net/base/host_cache.h"
+#include "net/base/host_resolver_impl.h"
 #include "net/base/mock_host_resolver.h"
 #include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/proxy/multi_threaded_proxy_resolver.h"
+#include "net/proxy/proxy_config_service_fixed.h"
 #include "net/proxy/proxy_info.h"
 #include "net/proxy/proxy_resolver_js_bindings.h"
 #include "net/proxy/proxy_resolver_v8.h"
+#include "net/proxy/proxy_script_fetcher_impl.h"
+#include "net/proxy/proxy_service.h"
 #include "net/test/test_server.h"
+#include "net/url_request/url_request_test_util.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 #if defined(OS_WIN)
@@ -76,6 +93,38 @@ int PacPerfTest::NumQueries() const {
 // The number of URLs to resolve when testing a PAC script.
 const int kNumIterations = 500;
 
+// Logs the throughput of |latencies|, which took |elapsed| in all, and their
+// median and 99th percentile. Sorts |latencies|.
+void LogLatencies(const std::string& test_name,
+                  std::vector<base::TimeDelta>* latencies,
+                  base::TimeDelta elapsed) {
+  ASSERT_FALSE(latencies->empty());
+  std::sort(latencies->begin(), latencies->end());
+  size_t p99_index = (latencies->size() * 99 + 99) / 100 - 1;
+  LogPerfResult((test_name + "_throughput").c_str(),
+                latencies->size() / std::max(elapsed.InSecondsF(), 1e-6),
+                "queries/s");
+  LogPerfResult((test_name + "_p50").c_str(),
+                (*latencies)[latencies->size() / 2].InMillisecondsF(), "ms");
+  LogPerfResult((test_name + "_p99").c_str(),
+                (*latencies)[p99_index].InMillisecondsF(), "ms");
+}
+
+// Reads the PAC script |script_name| from net/data/proxy_resolver_perftest.
+bool ReadPacScript(const std::string& script_name, std::string* contents) {
+  FilePath path;
+  PathService::Get(base::DIR_SOURCE_ROOT, &path);
+  path = path.AppendASCII("net");
+  path = path.AppendASCII("data");
+  path = path.AppendASCII("proxy_resolver_perftest");
+  path = path.AppendASCII(script_name);
+
+  // If we can't load the file from disk, something is misconfigured.
+  bool ok = file_util::ReadFileToString(path, contents);
+  LOG_IF(ERROR, !ok) << "Failed to read file: " << path.value();
+  return ok;
+}
+
 // Helper class to run through all the performance tests using the specified
 // proxy resolver implementation.
 class PacPerfSuiteRunner {
@@ -127,6 +176,8 @@ class PacPerfSuiteRunner {
     // Start the perf timer.
     std::string perf_test_name = resolver_name_ + "_" + script_name;
     PerfTimeLogger timer(perf_test_name.c_str());
+    PerfTimer elapsed_timer;
+    std::vector<base::TimeDelta> latencies;
 
     for (int i = 0; i < kNumIterations; ++i) {
       // Round-robin between URLs to resolve.
@@ -134,9 +185,11 @@ class PacPerfSuiteRunner {
 
       // Resolve.
       net::ProxyInfo proxy_info;
+      base::TimeTicks start_time = base::TimeTicks::Now();
       int result = resolver_->GetProxyForURL(GURL(query.query_url),
                                              &proxy_info, NULL, NULL,
                                              net::BoundNetLog());
+      latencies.push_back(base::TimeTicks::Now() - start_time);
 
       // Check that the result was correct. Note that ToPacString() and
       // ASSERT_EQ() are fast, so they won't skew the results.
@@ -146,24 +199,13 @@ class PacPerfSuiteRunner {
 
     // Print how long the test ran for.
     timer.Done();
+    LogLatencies(perf_test_name, &latencies, elapsed_timer.Elapsed());
   }
 
   // Read the PAC script from disk and initialize the proxy resolver with it.
   void LoadPacScriptIntoResolver(const std::string& script_name) {
-    FilePath path;
-    PathService::Get(base::DIR_SOURCE_ROOT, &path);
-    path = path.AppendASCII("net");
-    path = path.AppendASCII("data");
-    path = path.AppendASCII("proxy_resolver_perftest");
-    path = path.AppendASCII(script_name);
-
-    // Try to read the file from disk.
     std::string file_contents;
-    bool ok = file_util::ReadFileToString(path, &file_contents);
-
-    // If we can't load the file from disk, something is misconfigured.
-    LOG_IF(ERROR, !ok) << "Failed to read file: " << path.value();
-    ASSERT_TRUE(ok);
+    ASSERT_TRUE(ReadPacScript(script_name, &file_contents));
 
     // Load the PAC script into the ProxyResolver.
     int rv = resolver_->SetPacScript(
@@ -176,6 +218,213 @@ class PacPerfSuiteRunner {
   net::TestServer test_server_;
 };
 
+
+// (URL, expected result) pairs.
+typedef std::vector<std::pair<std::string, std::string> > QueryList;
+
+// Returns |num_queries| of kPerfTests[|test_index|]'s queries, round-robin.
+QueryList GetPerfTestQueries(size_t test_index, int num_queries) {
+  const PacPerfTest& test_data = kPerfTests[test_index];
+  QueryList queries;
+  for (int i = 0; i < num_queries; ++i) {
+    const PacQuery& query = test_data.queries[i % test_data.NumQueries()];
+    queries.push_back(std::make_pair(query.query_url, query.expected_result));
+  }
+  return queries;
+}
+
+// Starts a set of proxy resolves all at once, through an asynchronous
+// ProxyResolver or a ProxyService, and logs how long each took to complete.
+// As they are queued together, the latencies include the time spent waiting
+// for a PAC thread.
+class ConcurrentQueryRunner {
+ public:
+  ConcurrentQueryRunner() : num_pending_(0), waiting_(false) {}
+
+  ~ConcurrentQueryRunner() {
+    STLDeleteElements(&queries_);
+  }
+
+  // Exactly one of |resolver| and |service| is non-NULL.
+  void Run(const std::string& test_name,
+           const QueryList& queries,
+           net::ProxyResolver* resolver,
+           net::ProxyService* service) {
+    DCHECK_NE(!resolver, !service);
+    STLDeleteElements(&queries_);
+    latencies_.clear();
+
+    PerfTimer timer;
+    for (size_t i = 0; i < queries.size(); ++i) {
+      PendingQuery* query = new PendingQuery(this, queries[i].second);
+      queries_.push_back(query);
+      ++num_pending_;
+      GURL url(queries[i].first);
+      int rv = resolver ?
+          resolver->GetProxyForURL(url, &query->proxy_info, query, NULL,
+                                   net::BoundNetLog()) :
+          service->ResolveProxy(url, &query->proxy_info, query, NULL,
+                                net::BoundNetLog());
+      if (rv != net::ERR_IO_PENDING)
+        OnQueryComplete(query, rv);
+    }
+    while (num_pending_ > 0) {
+      waiting_ = true;
+      MessageLoop::current()->Run();
+      waiting_ = false;
+    }
+
+    LogLatencies(test_name, &latencies_, timer.Elapsed());
+  }
+
+ private:
+  class PendingQuery : public net::CompletionCallback {
+   public:
+    PendingQuery(ConcurrentQueryRunner* runner,
+                 const std::string& expected_result)
+        : runner(runner),
+          expected_result(expected_result),
+          start_time(base::TimeTicks::Now()) {
+    }
+
+    virtual void RunWithParams(const Tuple1<int>& params) {
+      runner->OnQueryComplete(this, params.a);
+    }
+
+    ConcurrentQueryRunner* const runner;
+    const std::string expected_result;
+    const base::TimeTicks start_time;
+    net::ProxyInfo proxy_info;
+  };
+
+  void OnQueryComplete(PendingQuery* query, int result) {
+    latencies_.push_back(base::TimeTicks::Now() - query->start_time);
+    EXPECT_EQ(net::OK, result);
+    EXPECT_EQ(query->expected_result, query->proxy_info.ToPacString());
+    if (--num_pending_ == 0 && waiting_)
+      MessageLoop::current()->Quit();
+  }
+
+  std::vector<PendingQuery*> queries_;
+  std::vector<base::TimeDelta> latencies_;
+  int num_pending_;
+  bool waiting_;
+};
+
+// Creates ProxyResolverV8s for a MultiThreadedProxyResolver. Their bindings
+// share |host_resolver|, which must be thread-safe if the script uses DNS.
+class ProxyResolverFactoryForV8 : public net::ProxyResolverFactory {
+ public:
+  explicit ProxyResolverFactoryForV8(net::HostResolver* host_resolver)
+      : net::ProxyResolverFactory(true /*expects_pac_bytes*/),
+        host_resolver_(host_resolver) {
+  }
+
+  virtual net::ProxyResolver* CreateProxyResolver() {
+    return new net::ProxyResolverV8(
+        net::ProxyResolverJSBindings::CreateDefault(host_resolver_, NULL));
+  }
+
+ private:
+  net::HostResolver* const host_resolver_;
+};
+
+// Resolves every host after sleeping for |delay_ms|, to stand in for a DNS
+// server of a given latency. Hosts in ".intranet" resolve to 10.1.2.3, and
+// others to 192.0.2.1.
+class DelayedHostResolverProc : public net::HostResolverProc {
+ public:
+  explicit DelayedHostResolverProc(int delay_ms)
+      : net::HostResolverProc(CreateRules()),
+        delay_ms_(delay_ms) {
+  }
+
+  virtual int Resolve(const std::string& host,
+                      net::AddressFamily address_family,
+                      net::HostResolverFlags host_resolver_flags,
+                      net::AddressList* addrlist,
+                      int* os_error) {
+    if (delay_ms_)
+      base::PlatformThread::Sleep(delay_ms_);
+    return ResolveUsingPrevious(host, address_family, host_resolver_flags,
+                                addrlist, os_error);
+  }
+
+ private:
+  static net::HostResolverProc* CreateRules() {
+    net::RuleBasedHostResolverProc* rules =
+        new net::RuleBasedHostResolverProc(NULL);
+    rules->AddRule("*.intranet", "10.1.2.3");
+    rules->AddRule("*", "192.0.2.1");
+    return rules;
+  }
+
+  const int delay_ms_;
+};
+
+// Returns a HostResolver that takes |delay_ms| for each host it hasn't
+// cached.
+net::HostResolver* CreateDelayedHostResolver(int delay_ms) {
+  return new net::HostResolverImpl(
+      new DelayedHostResolverProc(delay_ms),
+      new net::HostCache(1000, base::TimeDelta::FromMinutes(1),
+                         base::TimeDelta()),
+      8, NULL);
+}
+
+// Returns |num_queries| queries for dns-intranet.pac, with a new host for
+// each, so that each one needs a lookup.
+QueryList GetDnsQueries(int num_queries) {
+  QueryList queries;
+  for (int i = 0; i < num_queries; ++i) {
+    if (i % 2) {
+      queries.push_back(std::make_pair(
+          base::StringPrintf("http://host%d.intranet/", i), "DIRECT"));
+    } else {
+      queries.push_back(std::make_pair(
+          base::StringPrintf("http://www%d.example.com/", i),
+          "PROXY proxy.example.com:8080"));
+    }
+  }
+  return queries;
+}
+
+// Runs |queries| through a ProxyService that fetches |script_name| from
+// |test_server| and runs it on |num_threads| threads with V8. Logs the time
+// taken by the first query, which waits for the script, separately.
+void RunProxyServiceTest(const std::string& test_name,
+                         net::TestServer* test_server,
+                         const std::string& script_name,
+                         size_t num_threads,
+                         net::HostResolver* host_resolver,
+                         const QueryList& queries) {
+  scoped_refptr<TestURLRequestContext> context(new TestURLRequestContext);
+  net::ProxyConfig config;
+  config.set_pac_url(test_server->GetURL("files/" + script_name));
+  scoped_refptr<net::ProxyService> service(
+      net::ProxyService::CreateUsingV8ProxyResolver(
+          new net::ProxyConfigServiceFixed(config), num_threads,
+          new net::ProxyScriptFetcherImpl(context), host_resolver, NULL,
+          NULL));
+
+  {
+    PerfTimeLogger timer((test_name + "_init").c_str());
+    TestCompletionCallback callback;
+    net::ProxyInfo proxy_info;
+    int rv = service->ResolveProxy(GURL("http://www.warmup.com"),
+                                   &proxy_info, &callback, NULL,
+                                   net::BoundNetLog());
+    ASSERT_EQ(net::OK, callback.GetResult(rv));
+    timer.Done();
+  }
+
+  ConcurrentQueryRunner runner;
+  runner.Run(test_name, queries, NULL, service);
+}
+
+// The numbers of PAC threads to compare.
+const size_t kNumThreads[] = { 1, 2, 4, 8 };
+
 #if defined(OS_WIN)
 TEST(ProxyResolverPerfTest, ProxyResolverWinHttp) {
   net::ProxyResolverWinHttp resolver;
@@ -200,3 +449,73 @@ TEST(ProxyResolverPerfTest, ProxyResolverV8) {
   runner.RunAllTests();
 }
 
+
+TEST(ProxyResolverPerfTest, MultiThreadedProxyResolverV8) {
+  MessageLoop message_loop;
+  std::string script;
+  ASSERT_TRUE(ReadPacScript(kPerfTests[0].pac_name, &script));
+  QueryList queries = GetPerfTestQueries(0, kNumIterations);
+  // no-ads.pac doesn't use DNS.
+  net::MockHostResolver host_resolver;
+
+  for (size_t i = 0; i < arraysize(kNumThreads); ++i) {
+    net::MultiThreadedProxyResolver resolver(
+        new ProxyResolverFactoryForV8(&host_resolver), kNumThreads[i]);
+    // Measure running the script, not the result cache.
+    resolver.set_max_cached_results(0);
+    TestCompletionCallback callback;
+    int rv = resolver.SetPacScript(
+        net::ProxyResolverScriptData::FromUTF8(script), &callback);
+    ASSERT_EQ(net::OK, callback.GetResult(rv));
+
+    ConcurrentQueryRunner runner;
+    runner.Run(base::StringPrintf("MultiThreadedProxyResolverV8_%uthreads_%s",
+                                  static_cast<unsigned>(kNumThreads[i]),
+                                  kPerfTests[0].pac_name),
+               queries, &resolver, NULL);
+  }
+}
+
+// Includes fetching the script, as for a WPAD or PAC URL.
+TEST(ProxyResolverPerfTest, ProxyServiceV8) {
+  MessageLoopForIO message_loop;
+  net::TestServer test_server(net::TestServer::TYPE_HTTP,
+      FilePath(FILE_PATH_LITERAL("net/data/proxy_resolver_perftest")));
+  ASSERT_TRUE(test_server.Start());
+  scoped_ptr<net::HostResolver> host_resolver(CreateDelayedHostResolver(0));
+
+  for (size_t i = 0; i < arraysize(kNumThreads); ++i) {
+    RunProxyServiceTest(
+        base::StringPrintf("ProxyServiceV8_%uthreads_%s",
+                           static_cast<unsigned>(kNumThreads[i]),
+                           kPerfTests[0].pac_name),
+        &test_server, kPerfTests[0].pac_name, kNumThreads[i],
+        host_resolver.get(), GetPerfTestQueries(0, kNumIterations));
+  }
+}
+
+// A script that calls dnsResolve() for every host, with DNS of increasing
+// latency.
+TEST(ProxyResolverPerfTest, ProxyServiceV8WithDns) {
+  const int kNumDnsQueries = 200;
+  const int kDnsDelaysMs[] = { 0, 10, 50 };
+
+  MessageLoopForIO message_loop;
+  net::TestServer test_server(net::TestServer::TYPE_HTTP,
+      FilePath(FILE_PATH_LITERAL("net/data/proxy_resolver_perftest")));
+  ASSERT_TRUE(test_server.Start());
+
+  for (size_t i = 0; i < arraysize(kDnsDelaysMs); ++i) {
+    for (size_t j = 0; j < arraysize(kNumThreads); ++j) {
+      scoped_ptr<net::HostResolver> host_resolver(
+          CreateDelayedHostResolver(kDnsDelaysMs[i]));
+      RunProxyServiceTest(
+          base::StringPrintf("ProxyServiceV8_%uthreads_%dmsdns_"
+                             "dns-intranet.pac",
+                             static_cast<unsigned>(kNumThreads[j]),
+                             kDnsDelaysMs[i]),
+          &test_server, "dns-intranet.pac", kNumThreads[j],
+          host_resolver.get(), GetDnsQueries(kNumDnsQueries));
+    }
+  }
+}
@@ -6,6 +6,10 @@
 #define NET_PROXY_PROXY_RESOLVER_REQUEST_CONTEXT_H_
 #pragma once
 
+#include <vector>
+
+#include "net/base/host_resolver.h"
+
 namespace net {
 
 class HostCache;
@@ -20,11 +24,16 @@ struct ProxyResolverRequestContext {
   ProxyResolverRequestContext(const BoundNetLog* net_log,
                               HostCache* host_cache)
     : net_log(net_log),
-      host_cache(host_cache) {
+      host_cache(host_cache),
+      missed_lookups(NULL) {
   }
 
   const BoundNetLog* net_log;
   HostCache* host_cache;
+
+  // If not NULL, the bindings must not block on DNS: they only look in the
+  // host resolver's cache, and append the lookups that missed it here.
+  std::vector<HostResolver::RequestInfo>* missed_lookups;
 };
 
 }  // namespace net
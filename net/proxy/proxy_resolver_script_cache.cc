@@ -0,0 +1,124 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/proxy/proxy_resolver_script_cache.h"
+
+#include <vector>
+
+#include "base/logging.h"
+#include "base/pickle.h"
+#include "base/sha1.h"
+
+namespace net {
+
+namespace {
+
+// Bump this whenever the format written by Serialize() changes.
+const int kFormatVersion = 1;
+
+}  // namespace
+
+ProxyResolverScriptCache::ProxyResolverScriptCache(size_t max_entries)
+    : max_entries_(max_entries) {
+  DCHECK_GT(max_entries_, 0u);
+}
+
+// static
+std::string ProxyResolverScriptCache::GetKey(const std::string& salt,
+                                             const string16& script) {
+  std::string input(salt);
+  input.push_back('\0');
+  input.append(reinterpret_cast<const char*>(script.data()),
+               script.size() * sizeof(char16));
+  return base::SHA1HashString(input);
+}
+
+bool ProxyResolverScriptCache::Lookup(const std::string& key,
+                                      std::string* data) {
+  base::AutoLock auto_lock(lock_);
+  EntryMap::iterator it = index_.find(key);
+  if (it == index_.end())
+    return false;
+
+  // Move the entry to the back, as the most recently used.
+  entries_.splice(entries_.end(), entries_, it->second);
+  *data = it->second->second;
+  return true;
+}
+
+void ProxyResolverScriptCache::Insert(const std::string& key,
+                                      const std::string& data) {
+  base::AutoLock auto_lock(lock_);
+  InsertLocked(key, data);
+}
+
+void ProxyResolverScriptCache::Clear() {
+  base::AutoLock auto_lock(lock_);
+  entries_.clear();
+  index_.clear();
+}
+
+size_t ProxyResolverScriptCache::size() const {
+  base::AutoLock auto_lock(lock_);
+  return entries_.size();
+}
+
+void ProxyResolverScriptCache::Serialize(Pickle* pickle) const {
+  base::AutoLock auto_lock(lock_);
+  pickle->WriteInt(kFormatVersion);
+  pickle->WriteInt(static_cast<int>(entries_.size()));
+  for (EntryList::const_iterator it = entries_.begin(); it != entries_.end();
+       ++it) {
+    pickle->WriteString(it->first);
+    pickle->WriteString(it->second);
+  }
+}
+
+bool ProxyResolverScriptCache::Deserialize(const Pickle& pickle) {
+  void* iter = NULL;
+  int version;
+  int count;
+  if (!pickle.ReadInt(&iter, &version) || version != kFormatVersion ||
+      !pickle.ReadLength(&iter, &count)) {
+    return false;
+  }
+
+  // Read everything before touching the cache, so that a truncated pickle
+  // leaves it as it was.
+  std::vector<std::pair<std::string, std::string> > entries;
+  for (int i = 0; i < count; ++i) {
+    std::string key;
+    std::string data;
+    if (!pickle.ReadString(&iter, &key) || !pickle.ReadString(&iter, &data))
+      return false;
+    entries.push_back(std::make_pair(key, data));
+  }
+
+  base::AutoLock auto_lock(lock_);
+  for (size_t i = 0; i < entries.size(); ++i)
+    InsertLocked(entries[i].first, entries[i].second);
+  return true;
+}
+
+ProxyResolverScriptCache::~ProxyResolverScriptCache() {}
+
+void ProxyResolverScriptCache::InsertLocked(const std::string& key,
+                                            const std::string& data) {
+  lock_.AssertAcquired();
+  EntryMap::iterator it = index_.find(key);
+  if (it != index_.end()) {
+    entries_.erase(it->second);
+    index_.erase(it);
+  }
+
+  while (entries_.size() >= max_entries_) {
+    index_.erase(entries_.front().first);
+    entries_.pop_front();
+  }
+
+  entries_.push_back(std::make_pair(key, data));
+  index_[key] = --entries_.end();
+}
+
+}  // namespace net
@@ -0,0 +1,85 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_PROXY_PROXY_RESOLVER_SCRIPT_CACHE_H_
+#define NET_PROXY_PROXY_RESOLVER_SCRIPT_CACHE_H_
+#pragma once
+
+#include <list>
+#include <map>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "base/string16.h"
+#include "base/synchronization/lock.h"
+
+class Pickle;
+
+namespace net {
+
+// ProxyResolverScriptCache holds the data that compiling a PAC script
+// produces (for V8, the pre-parse data), keyed by a hash of the script.  The
+// first resolver to load a script stores the data, and every other resolver
+// that loads the same script skips that work.
+//
+// This is thread-safe, so that the worker threads of a
+// MultiThreadedProxyResolver can share one cache.  It can also be written to
+// and read back from a Pickle, so that an embedder can keep it across runs.
+class ProxyResolverScriptCache
+    : public base::RefCountedThreadSafe<ProxyResolverScriptCache> {
+ public:
+  // Once |max_entries| scripts are cached, adding another drops the one that
+  // was used least recently.
+  explicit ProxyResolverScriptCache(size_t max_entries);
+
+  // Returns the key to cache the compiled form of |script| under.  |salt|
+  // should identify the compiler (e.g. its version), so that data from a
+  // different compiler is never looked up.
+  static std::string GetKey(const std::string& salt, const string16& script);
+
+  // Copies the data cached under |key| to |data|.  Returns false if there is
+  // none.
+  bool Lookup(const std::string& key, std::string* data);
+
+  // Caches |data| under |key|, replacing anything cached there already.
+  void Insert(const std::string& key, const std::string& data);
+
+  // Removes every entry.
+  void Clear();
+
+  size_t size() const;
+
+  // Writes every entry to |pickle|, least recently used first.
+  void Serialize(Pickle* pickle) const;
+
+  // Adds the entries written by Serialize() to the cache.  Returns false,
+  // without changing the cache, if |pickle| is malformed.
+  bool Deserialize(const Pickle& pickle);
+
+ private:
+  friend class base::RefCountedThreadSafe<ProxyResolverScriptCache>;
+
+  typedef std::list<std::pair<std::string, std::string> > EntryList;
+  typedef std::map<std::string, EntryList::iterator> EntryMap;
+
+  ~ProxyResolverScriptCache();
+
+  // Same as Insert(), but |lock_| must be held already.
+  void InsertLocked(const std::string& key, const std::string& data);
+
+  const size_t max_entries_;
+
+  mutable base::Lock lock_;
+
+  // (key, data) pairs, least recently used first.
+  EntryList entries_;
+  EntryMap index_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProxyResolverScriptCache);
+};
+
+}  // namespace net
+
+#endif  // NET_PROXY_PROXY_RESOLVER_SCRIPT_CACHE_H_
@@ -0,0 +1,114 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/proxy/proxy_resolver_script_cache.h"
+
+#include "base/pickle.h"
+#include "base/utf_string_conversions.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+namespace {
+
+TEST(ProxyResolverScriptCacheTest, GetKey) {
+  std::string key = ProxyResolverScriptCache::GetKey("v1", ASCIIToUTF16("a"));
+  EXPECT_EQ(key, ProxyResolverScriptCache::GetKey("v1", ASCIIToUTF16("a")));
+  EXPECT_NE(key, ProxyResolverScriptCache::GetKey("v1", ASCIIToUTF16("b")));
+  EXPECT_NE(key, ProxyResolverScriptCache::GetKey("v2", ASCIIToUTF16("a")));
+}
+
+TEST(ProxyResolverScriptCacheTest, EvictsLeastRecentlyUsed) {
+  scoped_refptr<ProxyResolverScriptCache> cache(
+      new ProxyResolverScriptCache(2));
+  std::string data;
+
+  cache->Insert("a", "1");
+  cache->Insert("b", "2");
+  EXPECT_TRUE(cache->Lookup("a", &data));
+  EXPECT_EQ("1", data);
+
+  // "b" is the least recently used now.
+  cache->Insert("c", "3");
+  EXPECT_EQ(2u, cache->size());
+  EXPECT_FALSE(cache->Lookup("b", &data));
+  EXPECT_TRUE(cache->Lookup("a", &data));
+  EXPECT_TRUE(cache->Lookup("c", &data));
+  EXPECT_EQ("3", data);
+
+  // Inserting an existing key replaces its data.
+  cache->Insert("a", "4");
+  EXPECT_EQ(2u, cache->size());
+  EXPECT_TRUE(cache->Lookup("a", &data));
+  EXPECT_EQ("4", data);
+
+  cache->Clear();
+  EXPECT_EQ(0u, cache->size());
+  EXPECT_FALSE(cache->Lookup("a", &data));
+}
+
+TEST(ProxyResolverScriptCacheTest, Serialize) {
+  scoped_refptr<ProxyResolverScriptCache> cache(
+      new ProxyResolverScriptCache(2));
+  cache->Insert("a", "1");
+  cache->Insert("b", std::string("\0\1\2", 3));
+
+  Pickle pickle;
+  cache->Serialize(&pickle);
+
+  scoped_refptr<ProxyResolverScriptCache> copy(
+      new ProxyResolverScriptCache(2));
+  ASSERT_TRUE(copy->Deserialize(pickle));
+  EXPECT_EQ(2u, copy->size());
+
+  std::string data;
+  EXPECT_TRUE(copy->Lookup("a", &data));
+  EXPECT_EQ("1", data);
+  EXPECT_TRUE(copy->Lookup("b", &data));
+  EXPECT_EQ(std::string("\0\1\2", 3), data);
+
+  // The order of use carries over: "b" was used last in |cache|, so "a" is
+  // the one dropped from a smaller cache.
+  scoped_refptr<ProxyResolverScriptCache> small(
+      new ProxyResolverScriptCache(1));
+  ASSERT_TRUE(small->Deserialize(pickle));
+  EXPECT_FALSE(small->Lookup("a", &data));
+  EXPECT_TRUE(small->Lookup("b", &data));
+}
+
+TEST(ProxyResolverScriptCacheTest, DeserializeMalformed) {
+  scoped_refptr<ProxyResolverScriptCache> cache(
+      new ProxyResolverScriptCache(2));
+  cache->Insert("a", "1");
+
+  // Empty.
+  EXPECT_FALSE(cache->Deserialize(Pickle()));
+
+  // Unknown version.
+  Pickle bad_version;
+  bad_version.WriteInt(-1);
+  bad_version.WriteInt(0);
+  EXPECT_FALSE(cache->Deserialize(bad_version));
+
+  // Truncated: claims two entries but holds one.
+  Pickle pickle;
+  cache->Serialize(&pickle);
+  Pickle truncated;
+  void* iter = NULL;
+  int version;
+  ASSERT_TRUE(pickle.ReadInt(&iter, &version));
+  truncated.WriteInt(version);
+  truncated.WriteInt(2);
+  truncated.WriteString("b");
+  truncated.WriteString("2");
+  EXPECT_FALSE(cache->Deserialize(truncated));
+
+  // None of these touched the cache.
+  std::string data;
+  EXPECT_EQ(1u, cache->size());
+  EXPECT_FALSE(cache->Lookup("b", &data));
+  EXPECT_TRUE(cache->Lookup("a", &data));
+}
+
+}  // namespace
+}  // namespace net
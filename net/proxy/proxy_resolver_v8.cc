@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <vector>
 
 #include "net/proxy/proxy_resolver_v8.h"
 
@@ -22,6 +23,7 @@
 #include "net/proxy/proxy_resolver_js_bindings.h"
 #include "net/proxy/proxy_resolver_request_context.h"
 #include "net/proxy/proxy_resolver_script.h"
+#include "net/proxy/proxy_resolver_script_cache.h"
 #include "v8/include/v8.h"
 
 // Notes on the javascript environment:
@@ -399,7 +401,9 @@ class ProxyResolverV8::Context {
     return OK;
   }
 
-  int InitV8(const scoped_refptr<ProxyResolverScriptData>& pac_script) {
+  // |script_cache| may be NULL.
+  int InitV8(const scoped_refptr<ProxyResolverScriptData>& pac_script,
+             ProxyResolverScriptCache* script_cache) {
     v8::Locker locked;
     v8::HandleScope scope;
 
@@ -454,14 +458,18 @@ class ProxyResolverV8::Context {
         ASCIILiteralToV8String(
             PROXY_RESOLVER_SCRIPT
             PROXY_RESOLVER_SCRIPT_EX),
-        kPacUtilityResourceName);
+        kPacUtilityResourceName, NULL);
     if (rv != OK) {
       NOTREACHED();
       return rv;
     }
 
     // Add the user's PAC code to the environment.
-    rv = RunScript(ScriptDataToV8String(pac_script), kPacResourceName);
+    v8::Local<v8::String> pac_source = ScriptDataToV8String(pac_script);
+    scoped_ptr<v8::ScriptData> pre_data;
+    if (script_cache)
+      pre_data.reset(GetPreParseData(pac_script, pac_source, script_cache));
+    rv = RunScript(pac_source, kPacResourceName, pre_data.get());
     if (rv != OK)
       return rv;
 
@@ -507,15 +515,42 @@ class ProxyResolverV8::Context {
     js_bindings_->OnError(line_number, error_message);
   }
 
-  // Compiles and runs |script| in the current V8 context.
+  // Returns the pre-parse data for |source|, the contents of |pac_script|,
+  // from |script_cache|, or pre-parses it and caches the result.  Returns
+  // NULL if the script doesn't pre-parse; compiling it will report the error.
+  static v8::ScriptData* GetPreParseData(
+      const scoped_refptr<ProxyResolverScriptData>& pac_script,
+      v8::Handle<v8::String> source,
+      ProxyResolverScriptCache* script_cache) {
+    std::string key = ProxyResolverV8::GetScriptCacheKey(pac_script->utf16());
+    std::string data;
+    if (script_cache->Lookup(key, &data)) {
+      // V8 checks the data before using it, so data that was persisted and
+      // has since been damaged only costs the pre-parse it would have saved.
+      return v8::ScriptData::New(data.data(), static_cast<int>(data.size()));
+    }
+
+    scoped_ptr<v8::ScriptData> pre_data(v8::ScriptData::PreCompile(source));
+    if (!pre_data.get() || pre_data->HasError())
+      return NULL;
+    script_cache->Insert(key, std::string(pre_data->Data(),
+                                          pre_data->Length()));
+    return pre_data.release();
+  }
+
+  // Compiles and runs |script| in the current V8 context, using the
+  // pre-parse data |pre_data| if it isn't NULL.
   // Returns OK on success, otherwise an error code.
-  int RunScript(v8::Handle<v8::String> script, const char* script_name) {
+  int RunScript(v8::Handle<v8::String> script,
+                const char* script_name,
+                v8::ScriptData* pre_data) {
     v8::TryCatch try_catch;
 
     // Compile the script.
     v8::ScriptOrigin origin =
         v8::ScriptOrigin(ASCIILiteralToV8String(script_name));
-    v8::Local<v8::Script> code = v8::Script::Compile(script, &origin);
+    v8::Local<v8::Script> code =
+        v8::Script::Compile(script, &origin, pre_data);
 
     // Execute.
     if (!code.IsEmpty())
@@ -683,11 +718,25 @@ ProxyResolverV8::ProxyResolverV8(
       js_bindings_(custom_js_bindings) {
 }
 
+ProxyResolverV8::ProxyResolverV8(
+    ProxyResolverJSBindings* custom_js_bindings,
+    ProxyResolverScriptCache* script_cache)
+    : ProxyResolver(true /*expects_pac_bytes*/),
+      js_bindings_(custom_js_bindings),
+      script_cache_(script_cache) {
+}
+
 ProxyResolverV8::~ProxyResolverV8() {}
 
+// static
+std::string ProxyResolverV8::GetScriptCacheKey(const string16& script) {
+  return ProxyResolverScriptCache::GetKey(
+      std::string("v8-") + v8::V8::GetVersion(), script);
+}
+
 int ProxyResolverV8::GetProxyForURL(const GURL& query_url,
                                     ProxyInfo* results,
-                                    CompletionCallback* /*callback*/,
+                                    CompletionCallback* callback,
                                     RequestHandle* /*request*/,
                                     const BoundNetLog& net_log) {
   // If the V8 instance has not been initialized (either because
@@ -708,12 +757,26 @@ int ProxyResolverV8::GetProxyForURL(const GURL& query_url,
 
   ProxyResolverRequestContext request_context(&net_log, &host_cache);
 
+  // With a |callback|, DNS lookups that the host resolver can't answer from
+  // its cache fail rather than block, and are collected here.
+  std::vector<HostResolver::RequestInfo> missed_lookups;
+  if (callback)
+    request_context.missed_lookups = &missed_lookups;
+
   // Otherwise call into V8.
   context_->SetCurrentRequestContext(&request_context);
   int rv = context_->ResolveProxy(query_url, results);
   context_->SetCurrentRequestContext(NULL);
 
-  return rv;
+  if (missed_lookups.empty())
+    return rv;
+
+  // The script saw failed lookups, so its answer doesn't count. Have the
+  // lookups done in the background, and let the caller run the script again
+  // once they are cached. If that isn't possible, run it again now, blocking.
+  if (js_bindings_->ResolveInBackground(missed_lookups, callback))
+    return ERR_DNS_CACHE_MISS;
+  return GetProxyForURL(query_url, results, NULL, NULL, net_log);
 }
 
 void ProxyResolverV8::CancelRequest(RequestHandle request) {
@@ -743,7 +806,7 @@ int ProxyResolverV8::SetPacScript(
 
   // Try parsing the PAC script.
   scoped_ptr<Context> context(new Context(js_bindings_.get()));
-  int rv = context->InitV8(script_data);
+  int rv = context->InitV8(script_data, script_cache_.get());
   if (rv == OK)
     context_.reset(context.release());
   return rv;
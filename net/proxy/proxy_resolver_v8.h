@@ -6,12 +6,17 @@
 #define NET_PROXY_PROXY_RESOLVER_V8_H_
 #pragma once
 
+#include <string>
+
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/string16.h"
 #include "net/proxy/proxy_resolver.h"
 
 namespace net {
 
 class ProxyResolverJSBindings;
+class ProxyResolverScriptCache;
 
 // Implementation of ProxyResolver that uses V8 to evaluate PAC scripts.
 //
@@ -31,6 +36,11 @@ class ProxyResolverJSBindings;
 // This is the case with the V8 instance used by chromium's renderer -- it runs
 // on a different thread from ProxyResolver (renderer thread vs PAC thread),
 // and does not use locking since it expects to be alone.
+//
+// SetPacScript() can take the V8 pre-parse data for the script from a
+// ProxyResolverScriptCache, and store it there for the next resolver that
+// loads the same script.  This way only the first of the worker threads of a
+// MultiThreadedProxyResolver pays for the full parse of a large PAC script.
 class ProxyResolverV8 : public ProxyResolver {
  public:
   // Constructs a ProxyResolverV8 with custom bindings. ProxyResolverV8 takes
@@ -38,11 +48,28 @@ class ProxyResolverV8 : public ProxyResolver {
   // is destroyed.
   explicit ProxyResolverV8(ProxyResolverJSBindings* custom_js_bindings);
 
+  // Same as above, but shares compiled script data through |script_cache|,
+  // which may be NULL.
+  ProxyResolverV8(ProxyResolverJSBindings* custom_js_bindings,
+                  ProxyResolverScriptCache* script_cache);
+
   virtual ~ProxyResolverV8();
 
+  // Returns the key that the pre-parse data for |script| is cached under.
+  // The key covers the V8 version, so that data persisted by one version is
+  // never handed to another.
+  static std::string GetScriptCacheKey(const string16& script);
+
   ProxyResolverJSBindings* js_bindings() const { return js_bindings_.get(); }
 
   // ProxyResolver implementation:
+  //
+  // This is a synchronous resolver, but if |callback| is not NULL the
+  // script doesn't block on DNS. When it needs a lookup that the host
+  // resolver doesn't have cached, GetProxyForURL() fails with
+  // ERR_DNS_CACHE_MISS and the lookups are started in the background.
+  // |callback| runs, on the host resolver's thread, once they are cached;
+  // the caller should call GetProxyForURL() again then.
   virtual int GetProxyForURL(const GURL& url,
                              ProxyInfo* results,
                              CompletionCallback* /*callback*/,
@@ -65,6 +92,8 @@ class ProxyResolverV8 : public ProxyResolver {
 
   scoped_ptr<ProxyResolverJSBindings> js_bindings_;
 
+  scoped_refptr<ProxyResolverScriptCache> script_cache_;
+
   DISALLOW_COPY_AND_ASSIGN(ProxyResolverV8);
 };
 
@@ -12,6 +12,7 @@
 #include "net/base/net_log_unittest.h"
 #include "net/proxy/proxy_info.h"
 #include "net/proxy/proxy_resolver_js_bindings.h"
+#include "net/proxy/proxy_resolver_script_cache.h"
 #include "net/proxy/proxy_resolver_v8.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -88,6 +89,10 @@ class ProxyResolverV8WithMockBindings : public ProxyResolverV8 {
  public:
   ProxyResolverV8WithMockBindings() : ProxyResolverV8(new MockJSBindings()) {}
 
+  explicit ProxyResolverV8WithMockBindings(
+      ProxyResolverScriptCache* script_cache)
+      : ProxyResolverV8(new MockJSBindings(), script_cache) {}
+
   MockJSBindings* mock_js_bindings() const {
     return reinterpret_cast<MockJSBindings*>(js_bindings());
   }
@@ -544,5 +549,55 @@ TEST(ProxyResolverV8Test, DNSResolutionOfInternationDomainName) {
   EXPECT_EQ("xn--bcher-kva.ch", bindings->dns_resolves_ex[0]);
 }
 
+// Resolvers that share a script cache pre-parse a script only once.
+TEST(ProxyResolverV8Test, SharesPreParseData) {
+  scoped_refptr<ProxyResolverScriptCache> cache(
+      new ProxyResolverScriptCache(2));
+
+  ProxyResolverV8WithMockBindings resolver1(cache);
+  EXPECT_EQ(OK, resolver1.SetPacScriptFromDisk("passthrough.js"));
+  EXPECT_EQ(1u, cache->size());
+
+  // The second resolver finds the data the first stored, and still runs the
+  // script correctly.
+  ProxyResolverV8WithMockBindings resolver2(cache);
+  EXPECT_EQ(OK, resolver2.SetPacScriptFromDisk("passthrough.js"));
+  EXPECT_EQ(1u, cache->size());
+
+  ProxyInfo proxy_info;
+  EXPECT_EQ(OK, resolver2.GetProxyForURL(GURL("http://query.com/path"),
+                                         &proxy_info, NULL, NULL,
+                                         BoundNetLog()));
+  EXPECT_EQ("http.query.com.path.query.com:80",
+            proxy_info.proxy_server().ToURI());
+
+  // A script that doesn't parse isn't cached.
+  EXPECT_EQ(ERR_PAC_SCRIPT_FAILED,
+            resolver1.SetPacScriptFromDisk("missing_close_brace.js"));
+  EXPECT_EQ(1u, cache->size());
+}
+
+// Damaged pre-parse data, such as could be read back from disk, is ignored.
+TEST(ProxyResolverV8Test, IgnoresBadPreParseData) {
+  scoped_refptr<ProxyResolverScriptCache> cache(
+      new ProxyResolverScriptCache(2));
+  const char kScript[] =
+      "function FindProxyForURL(url, host) {\n"
+      "  return 'PROXY ' + host + ':80';\n"
+      "}\n";
+  scoped_refptr<ProxyResolverScriptData> script_data =
+      ProxyResolverScriptData::FromUTF8(kScript);
+  cache->Insert(ProxyResolverV8::GetScriptCacheKey(script_data->utf16()),
+                "not pre-parse data");
+
+  ProxyResolverV8WithMockBindings resolver(cache);
+  EXPECT_EQ(OK, resolver.SetPacScript(script_data, NULL));
+
+  ProxyInfo proxy_info;
+  EXPECT_EQ(OK, resolver.GetProxyForURL(kQueryUrl, &proxy_info, NULL, NULL,
+                                        BoundNetLog()));
+  EXPECT_EQ("www.google.com:80", proxy_info.proxy_server().ToURI());
+}
+
 }  // namespace
 }  // namespace net
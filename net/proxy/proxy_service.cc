@@ -20,6 +20,7 @@
 #include "net/proxy/proxy_config_service_fixed.h"
 #include "net/proxy/proxy_resolver.h"
 #include "net/proxy/proxy_resolver_js_bindings.h"
+#include "net/proxy/proxy_resolver_script_cache.h"
 #ifndef ANDROID
 #include "net/proxy/proxy_resolver_v8.h"
 #endif
@@ -47,6 +48,10 @@ namespace {
 const size_t kMaxNumNetLogEntries = 100;
 const size_t kDefaultNumPacThreads = 4;
 
+// The number of PAC scripts whose pre-parse data is kept when the caller of
+// CreateUsingV8ProxyResolver() doesn't pass in a cache.
+const size_t kDefaultMaxCachedPacScripts = 4;
+
 // When the IP address changes we don't immediately re-run proxy auto-config.
 // Instead, we  wait for |kNumMillisToStallAfterNetworkChanges| before
 // attempting to re-valuate proxy auto-config.
@@ -169,12 +174,15 @@ class ProxyResolverFactoryForV8 : public ProxyResolverFactory {
   // |async_host_resolver|, |io_loop| and |net_log| must remain
   // valid for the duration of our lifetime.
   // |async_host_resolver| will only be operated on |io_loop|.
+  // Every resolver created shares |script_cache|.
   ProxyResolverFactoryForV8(HostResolver* async_host_resolver,
                             MessageLoop* io_loop,
+                            ProxyResolverScriptCache* script_cache,
                             NetLog* net_log)
       : ProxyResolverFactory(true /*expects_pac_bytes*/),
         async_host_resolver_(async_host_resolver),
         io_loop_(io_loop),
+        script_cache_(script_cache),
         net_log_(net_log) {
   }
 
@@ -185,15 +193,17 @@ class ProxyResolverFactoryForV8 : public ProxyResolverFactory {
         new SyncHostResolverBridge(async_host_resolver_, io_loop_);
 
     ProxyResolverJSBindings* js_bindings =
-        ProxyResolverJSBindings::CreateDefault(sync_host_resolver, net_log_);
+        ProxyResolverJSBindings::CreateDefaultWithBridge(sync_host_resolver,
+                                                         net_log_);
 
     // ProxyResolverV8 takes ownership of |js_bindings|.
-    return new ProxyResolverV8(js_bindings);
+    return new ProxyResolverV8(js_bindings, script_cache_);
   }
 
  private:
   HostResolver* const async_host_resolver_;
   MessageLoop* io_loop_;
+  scoped_refptr<ProxyResolverScriptCache> script_cache_;
   NetLog* net_log_;
 };
 #endif
@@ -400,6 +410,7 @@ ProxyService* ProxyService::CreateUsingV8ProxyResolver(
     size_t num_pac_threads,
     ProxyScriptFetcher* proxy_script_fetcher,
     HostResolver* host_resolver,
+    ProxyResolverScriptCache* script_cache,
     NetLog* net_log) {
   DCHECK(proxy_config_service);
   DCHECK(proxy_script_fetcher);
@@ -408,14 +419,20 @@ ProxyService* ProxyService::CreateUsingV8ProxyResolver(
   if (num_pac_threads == 0)
     num_pac_threads = kDefaultNumPacThreads;
 
+  if (!script_cache)
+    script_cache = new ProxyResolverScriptCache(kDefaultMaxCachedPacScripts);
+
   ProxyResolverFactory* sync_resolver_factory =
       new ProxyResolverFactoryForV8(
           host_resolver,
           MessageLoop::current(),
+          script_cache,
           net_log);
 
-  ProxyResolver* proxy_resolver =
+  MultiThreadedProxyResolver* proxy_resolver =
       new MultiThreadedProxyResolver(sync_resolver_factory, num_pac_threads);
+  // Don't let a slow DNS lookup tie up a PAC thread.
+  proxy_resolver->set_non_blocking_dns(true);
 
   ProxyService* proxy_service =
       new ProxyService(proxy_config_service, proxy_resolver, net_log);
@@ -510,6 +527,7 @@ int ProxyService::ResolveProxy(const GURL& raw_url,
   DCHECK(callback);
 
   net_log.BeginEvent(NetLog::TYPE_PROXY_SERVICE, NULL);
+  result->proxy_resolve_start_time_ = base::TimeTicks::Now();
 
   config_service_->OnLazyPoll();
   if (current_state_ == STATE_NONE)
@@ -740,6 +758,7 @@ int ProxyService::DidFinishResolvingProxy(ProxyInfo* result,
     result_code = OK;
   }
 
+  result->proxy_resolve_end_time_ = base::TimeTicks::Now();
   net_log.EndEvent(NetLog::TYPE_PROXY_SERVICE, NULL);
   return result_code;
 }
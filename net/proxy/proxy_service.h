@@ -29,6 +29,7 @@ namespace net {
 class HostResolver;
 class InitProxyResolver;
 class ProxyResolver;
+class ProxyResolverScriptCache;
 class ProxyScriptFetcher;
 class URLRequestContext;
 
@@ -164,6 +165,11 @@ class NET_EXPORT ProxyService : public base::RefCounted<ProxyService>,
   // should use for any DNS queries. It must remain valid throughout the
   // lifetime of the ProxyService.
   //
+  // |script_cache| holds the pre-parse data of PAC scripts, so that only the
+  // first PAC thread to load a script parses all of it. It may be NULL, in
+  // which case the PAC threads share a cache of their own. Passing one in
+  // lets the caller keep the data across runs; see ProxyResolverScriptCache.
+  //
   // ##########################################################################
   // # See the warnings in net/proxy/proxy_resolver_v8.h describing the
   // # multi-threading model. In order for this to be safe to use, *ALL* the
@@ -174,6 +180,7 @@ class NET_EXPORT ProxyService : public base::RefCounted<ProxyService>,
       size_t num_pac_threads,
       ProxyScriptFetcher* proxy_script_fetcher,
       HostResolver* host_resolver,
+      ProxyResolverScriptCache* script_cache,
       NetLog* net_log);
 
   // Same as CreateUsingV8ProxyResolver, except it uses system libraries
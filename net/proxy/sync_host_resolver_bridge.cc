@@ -4,11 +4,14 @@
 
 #include "net/proxy/sync_host_resolver_bridge.h"
 
+#include <deque>
+
 #include "base/compiler_specific.h"
 #include "base/logging.h"
 #include "base/message_loop.h"
 #include "base/synchronization/lock.h"
 #include "base/synchronization/waitable_event.h"
+#include "net/base/address_list.h"
 #include "net/base/net_errors.h"
 #include "net/base/net_log.h"
 
@@ -24,6 +27,10 @@ class SyncHostResolverBridge::Core
   int ResolveSynchronously(const HostResolver::RequestInfo& info,
                            AddressList* addresses);
 
+  // Not called on |host_resolver_loop_|.
+  void ResolveInBackground(const std::vector<HostResolver::RequestInfo>& infos,
+                           CompletionCallback* callback);
+
   // Returns true if Shutdown() has been called.
   bool HasShutdown() const {
     base::AutoLock l(lock_);
@@ -50,6 +57,28 @@ class SyncHostResolverBridge::Core
   // Not called on |host_resolver_loop_|.
   int WaitForResolveCompletion();
 
+  // A set of lookups from one ResolveInBackground() call.
+  struct BackgroundBatch {
+    BackgroundBatch(const std::vector<HostResolver::RequestInfo>& infos,
+                    CompletionCallback* callback);
+    ~BackgroundBatch();
+
+    std::vector<HostResolver::RequestInfo> infos;
+    CompletionCallback* callback;
+  };
+
+  // Called on |host_resolver_loop_|.
+  void AddBackgroundBatch(
+      const std::vector<HostResolver::RequestInfo>& infos,
+      CompletionCallback* callback);
+
+  // Starts the next background lookup, running the callbacks of the batches
+  // that are done along the way. Called on |host_resolver_loop_|.
+  void StartNextBackgroundResolve();
+
+  // Called on |host_resolver_loop_|.
+  void OnBackgroundResolveCompletion(int result);
+
   HostResolver* const host_resolver_;
   MessageLoop* const host_resolver_loop_;
   net::CompletionCallbackImpl<Core> callback_;
@@ -68,6 +97,15 @@ class SyncHostResolverBridge::Core
   // Mutex to guard accesses to |has_shutdown_|.
       mutable base::Lock lock_;
 
+  // The background batches, in the order they were added, and the position
+  // in the front one of the next lookup to start. The rest are only used on
+  // |host_resolver_loop_|.
+  std::deque<BackgroundBatch> background_batches_;
+  size_t next_background_info_;
+  net::CompletionCallbackImpl<Core> background_callback_;
+  AddressList background_addresses_;
+  HostResolver::RequestHandle outstanding_background_request_;
+
   DISALLOW_COPY_AND_ASSIGN(Core);
 };
 
@@ -80,7 +118,11 @@ SyncHostResolverBridge::Core::Core(HostResolver* host_resolver,
       err_(0),
       outstanding_request_(NULL),
       event_(true, false),
-      has_shutdown_(false) {}
+      has_shutdown_(false),
+      next_background_info_(0),
+      ALLOW_THIS_IN_INITIALIZER_LIST(
+          background_callback_(this, &Core::OnBackgroundResolveCompletion)),
+      outstanding_background_request_(NULL) {}
 
 int SyncHostResolverBridge::Core::ResolveSynchronously(
     const HostResolver::RequestInfo& info,
@@ -94,6 +136,14 @@ int SyncHostResolverBridge::Core::ResolveSynchronously(
   return WaitForResolveCompletion();
 }
 
+void SyncHostResolverBridge::Core::ResolveInBackground(
+    const std::vector<HostResolver::RequestInfo>& infos,
+    CompletionCallback* callback) {
+  host_resolver_loop_->PostTask(
+      FROM_HERE,
+      NewRunnableMethod(this, &Core::AddBackgroundBatch, infos, callback));
+}
+
 void SyncHostResolverBridge::Core::StartResolve(
     const HostResolver::RequestInfo& info,
     net::AddressList* addresses) {
@@ -130,6 +180,62 @@ int SyncHostResolverBridge::Core::WaitForResolveCompletion() {
   return err_;
 }
 
+SyncHostResolverBridge::Core::BackgroundBatch::BackgroundBatch(
+    const std::vector<HostResolver::RequestInfo>& infos,
+    CompletionCallback* callback)
+    : infos(infos),
+      callback(callback) {
+}
+
+SyncHostResolverBridge::Core::BackgroundBatch::~BackgroundBatch() {}
+
+void SyncHostResolverBridge::Core::AddBackgroundBatch(
+    const std::vector<HostResolver::RequestInfo>& infos,
+    CompletionCallback* callback) {
+  DCHECK_EQ(MessageLoop::current(), host_resolver_loop_);
+
+  if (HasShutdown())
+    return;
+
+  background_batches_.push_back(BackgroundBatch(infos, callback));
+  if (!outstanding_background_request_)
+    StartNextBackgroundResolve();
+}
+
+void SyncHostResolverBridge::Core::StartNextBackgroundResolve() {
+  DCHECK_EQ(MessageLoop::current(), host_resolver_loop_);
+  DCHECK(!outstanding_background_request_);
+
+  while (!background_batches_.empty()) {
+    BackgroundBatch& batch = background_batches_.front();
+    if (next_background_info_ == batch.infos.size()) {
+      CompletionCallback* callback = batch.callback;
+      background_batches_.pop_front();
+      next_background_info_ = 0;
+      // The callback may call Shutdown().
+      callback->Run(OK);
+      if (HasShutdown())
+        return;
+      continue;
+    }
+
+    int error = host_resolver_->Resolve(
+        batch.infos[next_background_info_++], &background_addresses_,
+        &background_callback_, &outstanding_background_request_,
+        BoundNetLog());
+    if (error == ERR_IO_PENDING)
+      return;
+    outstanding_background_request_ = NULL;
+  }
+}
+
+void SyncHostResolverBridge::Core::OnBackgroundResolveCompletion(int result) {
+  DCHECK_EQ(MessageLoop::current(), host_resolver_loop_);
+  // Whatever the result, it is in the host resolver's cache now.
+  outstanding_background_request_ = NULL;
+  StartNextBackgroundResolve();
+}
+
 void SyncHostResolverBridge::Core::Shutdown() {
   DCHECK_EQ(MessageLoop::current(), host_resolver_loop_);
 
@@ -138,6 +244,13 @@ void SyncHostResolverBridge::Core::Shutdown() {
     outstanding_request_ = NULL;
   }
 
+  if (outstanding_background_request_) {
+    host_resolver_->CancelRequest(outstanding_background_request_);
+    outstanding_background_request_ = NULL;
+  }
+  background_batches_.clear();
+  next_background_info_ = 0;
+
   {
     base::AutoLock l(lock_);
     has_shutdown_ = true;
@@ -183,6 +296,13 @@ void SyncHostResolverBridge::RemoveObserver(Observer* observer) {
   NOTREACHED();
 }
 
+void SyncHostResolverBridge::ResolveInBackground(
+    const std::vector<RequestInfo>& infos,
+    CompletionCallback* callback) {
+  DCHECK(callback);
+  core_->ResolveInBackground(infos, callback);
+}
+
 void SyncHostResolverBridge::Shutdown() {
   DCHECK_EQ(MessageLoop::current(), host_resolver_loop_);
   core_->Shutdown();
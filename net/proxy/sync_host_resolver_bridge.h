@@ -6,6 +6,8 @@
 #define NET_PROXY_SYNC_HOST_RESOLVER_BRIDGE_H_
 #pragma once
 
+#include <vector>
+
 #include "base/memory/scoped_ptr.h"
 #include "net/base/host_resolver.h"
 
@@ -32,6 +34,13 @@ class SyncHostResolverBridge : public HostResolver {
   virtual void AddObserver(Observer* observer);
   virtual void RemoveObserver(Observer* observer);
 
+  // Starts resolving |infos| on |host_resolver_loop|, one after the other,
+  // without waiting for them. The point is to fill the host resolver's cache.
+  // |callback| runs on |host_resolver_loop| once every lookup has finished,
+  // unless Shutdown() is called first.
+  void ResolveInBackground(const std::vector<RequestInfo>& infos,
+                           CompletionCallback* callback);
+
   // The Shutdown() method should be called prior to destruction, from
   // |host_resolver_loop_|. It aborts any in progress synchronous resolves, to
   // prevent deadlocks from happening.
@@ -11,7 +11,7 @@
 #include "base/string_util.h"
 #include "base/stringprintf.h"
 #include "build/build_config.h"
-#include "net/server/http_server_request_info.h"
+#include "net/base/io_buffer.h"
 
 #if defined(OS_WIN)
 #include <winsock2.h>
@@ -134,6 +134,14 @@ void HttpServer::Send(int connection_id, const char* bytes, int len) {
   connection->socket_->Send(bytes, len);
 }
 
+void HttpServer::Send(int connection_id, IOBuffer* buffer, int len) {
+  Connection* connection = FindConnection(connection_id);
+  if (connection == NULL)
+    return;
+
+  connection->socket_->Send(buffer, len);
+}
+
 void HttpServer::Send200(int connection_id,
                          const std::string& data,
                          const std::string& content_type) {
@@ -149,6 +157,26 @@ void HttpServer::Send200(int connection_id,
       content_type.c_str(),
       static_cast<int>(data.length())));
   connection->socket_->Send(data);
+  DidSendResponse(connection);
+}
+
+void HttpServer::Send200Buffer(int connection_id,
+                               IOBuffer* body,
+                               int body_len,
+                               const std::string& content_type) {
+  Connection* connection = FindConnection(connection_id);
+  if (connection == NULL)
+    return;
+
+  connection->socket_->Send(base::StringPrintf(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type:%s\r\n"
+      "Content-Length:%d\r\n"
+      "\r\n",
+      content_type.c_str(),
+      body_len));
+  connection->socket_->Send(body, body_len);
+  DidSendResponse(connection);
 }
 
 void HttpServer::Send404(int connection_id) {
@@ -160,6 +188,7 @@ void HttpServer::Send404(int connection_id) {
       "HTTP/1.1 404 Not Found\r\n"
       "Content-Length: 0\r\n"
       "\r\n");
+  DidSendResponse(connection);
 }
 
 void HttpServer::Send500(int connection_id, const std::string& message) {
@@ -175,6 +204,7 @@ void HttpServer::Send500(int connection_id, const std::string& message) {
       "%s",
       static_cast<int>(message.length()),
       message.c_str()));
+  DidSendResponse(connection);
 }
 
 void HttpServer::Close(int connection_id)
@@ -183,27 +213,17 @@ void HttpServer::Close(int connection_id)
   if (connection == NULL)
     return;
 
-  connection->DetachSocket();
-}
-
-HttpServer::Connection::Connection(HttpServer* server, ListenSocket* sock)
-    : server_(server),
-      socket_(sock),
-      is_web_socket_(false) {
-  id_ = lastId_++;
-}
-
-HttpServer::Connection::~Connection() {
-  DetachSocket();
-  server_->delegate_->OnClose(id_);
-}
-
-void HttpServer::Connection::DetachSocket() {
-  socket_ = NULL;
+  id_to_connection_.erase(connection->id_);
+  socket_to_connection_.erase(connection->socket_);
+  connection->socket_->CloseAfterSending();
+  delete connection;
 }
 
-void HttpServer::Connection::Shift(int num_bytes) {
-  recv_data_ = recv_data_.substr(num_bytes);
+void HttpServer::DidSendResponse(Connection* connection) {
+  if (connection->pending_requests_ > 0)
+    --connection->pending_requests_;
+  if (connection->close_after_response_ && !connection->pending_requests_)
+    Close(connection->id_);
 }
 
 //
@@ -280,15 +300,51 @@ int charToInput(char ch) {
   return INPUT_DEFAULT;
 }
 
-bool HttpServer::ParseHeaders(Connection* connection,
-                              HttpServerRequestInfo* info,
-                              int* ppos) {
-  int& pos = *ppos;
+HttpServer::Connection::Connection(HttpServer* server, ListenSocket* sock)
+    : server_(server),
+      socket_(sock),
+      is_web_socket_(false),
+      read_pos_(0),
+      parse_state_(ST_METHOD),
+      headers_done_(false),
+      http_1_1_(false),
+      pending_requests_(0),
+      close_after_response_(false) {
+  id_ = lastId_++;
+}
+
+HttpServer::Connection::~Connection() {
+  DetachSocket();
+  server_->delegate_->OnClose(id_);
+}
+
+void HttpServer::Connection::DetachSocket() {
+  socket_ = NULL;
+}
+
+void HttpServer::Connection::TakeRequest(HttpServerRequestInfo* request) {
+  request->method.swap(request_.method);
+  request->path.swap(request_.path);
+  request->data.swap(request_.data);
+  request->headers.swap(request_.headers);
+  request_ = HttpServerRequestInfo();
+  parse_state_ = is_web_socket_ ? ST_WS_READY : ST_METHOD;
+  parse_buffer_.clear();
+  header_name_.clear();
+  headers_done_ = false;
+}
+
+bool HttpServer::ParseHeaders(Connection* connection) {
+  HttpServerRequestInfo* info = &connection->request_;
+  int& pos = connection->read_pos_;
   int data_len = connection->recv_data_.length();
-  int state = connection->is_web_socket_ ? ST_WS_READY : ST_METHOD;
-  std::string buffer;
-  std::string header_name;
+  int& state = connection->parse_state_;
+  std::string& buffer = connection->parse_buffer_;
+  std::string& header_name = connection->header_name_;
   std::string header_value;
+  // The connection may have been upgraded since the parser was reset.
+  if (connection->is_web_socket_ && state == ST_METHOD && buffer.empty())
+    state = ST_WS_READY;
   while (pos < data_len) {
     char ch = connection->recv_data_[pos++];
     int input = charToInput(ch);
@@ -307,8 +363,7 @@ bool HttpServer::ParseHeaders(Connection* connection,
           buffer.clear();
           break;
         case ST_PROTO:
-          // TODO(mbelshe): Deal better with parsing protocol.
-          DCHECK(buffer == "HTTP/1.1");
+          connection->http_1_1_ = (buffer == "HTTP/1.1");
           buffer.clear();
           break;
         case ST_NAME:
@@ -326,10 +381,10 @@ bool HttpServer::ParseHeaders(Connection* connection,
           buffer.append(&ch, 1);
           break;
         case ST_WS_FRAME:
-          info->data = buffer;
+          info->data.swap(buffer);
           buffer.clear();
+          state = next_state;
           return true;
-          break;
       }
       state = next_state;
     } else {
@@ -345,6 +400,7 @@ bool HttpServer::ParseHeaders(Connection* connection,
           break;
         case ST_DONE:
           DCHECK(input == INPUT_LF);
+          connection->headers_done_ = true;
           return true;
         case ST_WS_CLOSE:
           connection->is_web_socket_ = false;
@@ -373,51 +429,91 @@ void HttpServer::DidRead(ListenSocket* socket,
   if (connection == NULL)
     return;
 
+  // Once the connection is to be closed, what else comes in is dropped.
+  if (connection->close_after_response_)
+    return;
+
   connection->recv_data_.append(data, len);
-  while (connection->recv_data_.length()) {
-    int pos = 0;
-    HttpServerRequestInfo request;
-    if (!ParseHeaders(connection, &request, &pos))
+  int id = connection->id_;
+  while (connection->read_pos_ <
+             static_cast<int>(connection->recv_data_.length())) {
+    if (!connection->headers_done_ && !ParseHeaders(connection)) {
+      if (connection->parse_state_ == ST_ERR) {
+        Close(id);
+        return;
+      }
       break;
+    }
 
     if (connection->is_web_socket_) {
-      delegate_->OnWebSocketMessage(connection->id_, request.data);
-      connection->Shift(pos);
+      HttpServerRequestInfo request;
+      connection->TakeRequest(&request);
+      delegate_->OnWebSocketMessage(id, request.data);
+      // The delegate may have closed the connection.
+      connection = FindConnection(id);
+      if (connection == NULL)
+        return;
       continue;
     }
 
-    std::string connection_header = GetHeaderValue(request, "Connection");
-    if (connection_header == "Upgrade") {
-      // Is this WebSocket and if yes, upgrade the connection.
-      std::string key1 = GetHeaderValue(request, "Sec-WebSocket-Key1");
-      std::string key2 = GetHeaderValue(request, "Sec-WebSocket-Key2");
-
-      const int websocket_handshake_body_len = 8;
-      if (pos + websocket_handshake_body_len >
-              static_cast<int>(connection->recv_data_.length())) {
-        // We haven't received websocket handshake body yet. Wait.
-        break;
+    const HttpServerRequestInfo& headers = connection->request_;
+    std::string connection_header = GetHeaderValue(headers, "Connection");
+    bool web_socket = false;
+    int body_len = 0;
+    if (connection_header == "Upgrade" &&
+        !GetHeaderValue(headers, "Sec-WebSocket-Key1").empty() &&
+        !GetHeaderValue(headers, "Sec-WebSocket-Key2").empty()) {
+      // The WebSocket handshake is followed by an 8 byte key.
+      web_socket = true;
+      body_len = 8;
+    } else {
+      std::string content_length = GetHeaderValue(headers, "Content-Length");
+      if (!content_length.empty() &&
+          (!base::StringToInt(content_length, &body_len) || body_len < 0)) {
+        Close(id);
+        return;
       }
+    }
+    if (connection->read_pos_ + body_len >
+            static_cast<int>(connection->recv_data_.length())) {
+      // We haven't received the body yet. Wait.
+      break;
+    }
 
-      if (!key1.empty() && !key2.empty()) {
-        request.data = connection->recv_data_.substr(
-            pos,
-            pos + websocket_handshake_body_len);
-        pos += websocket_handshake_body_len;
-        delegate_->OnWebSocketRequest(connection->id_, request);
-        connection->Shift(pos);
-        continue;
-      }
+    HttpServerRequestInfo request;
+    connection->TakeRequest(&request);
+    request.data.assign(connection->recv_data_, connection->read_pos_,
+                        body_len);
+    connection->read_pos_ += body_len;
+    if (web_socket) {
+      delegate_->OnWebSocketRequest(id, request);
+    } else {
+      std::string value = StringToLowerASCII(connection_header);
+      if (connection->http_1_1_ ? value == "close" : value != "keep-alive")
+        connection->close_after_response_ = true;
+      ++connection->pending_requests_;
+      delegate_->OnHttpRequest(id, request);
     }
-    // Request body is not supported. It is always empty.
-    delegate_->OnHttpRequest(connection->id_, request);
-    connection->Shift(pos);
+    // The delegate may have closed the connection.
+    connection = FindConnection(id);
+    if (connection == NULL || connection->close_after_response_)
+      return;
+  }
+
+  // Drop what has been parsed, once that is at least half of the buffer, so
+  // that pipelined requests don't make the rest be copied every time.
+  if (connection->read_pos_ * 2 >=
+          static_cast<int>(connection->recv_data_.length())) {
+    connection->recv_data_.erase(0, connection->read_pos_);
+    connection->read_pos_ = 0;
   }
 }
 
 void HttpServer::DidClose(ListenSocket* socket) {
   Connection* connection = FindConnection(socket);
   DCHECK(connection != NULL);
+  if (connection == NULL)
+    return;
   id_to_connection_.erase(connection->id_);
   socket_to_connection_.erase(connection->socket_);
   delete connection;
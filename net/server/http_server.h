@@ -12,10 +12,16 @@
 #include "base/basictypes.h"
 #include "base/memory/ref_counted.h"
 #include "net/base/listen_socket.h"
+#include "net/server/http_server_request_info.h"
 
 namespace net {
 
-class HttpServerRequestInfo;
+class IOBuffer;
+
+// Connections are persistent: HTTP/1.1 ones unless the client sends
+// "Connection: close", HTTP/1.0 ones if it sends "Connection: keep-alive".
+// Requests may be pipelined; the responses must be sent in the order the
+// requests came in.
 
 class HttpServer : public ListenSocket::ListenSocketDelegate,
                    public base::RefCountedThreadSafe<HttpServer> {
@@ -44,11 +50,19 @@ class HttpServer : public ListenSocket::ListenSocketDelegate,
   void SendOverWebSocket(int connection_id, const std::string& data);
   void Send(int connection_id, const std::string& data);
   void Send(int connection_id, const char* bytes, int len);
+  // Sends the first |len| bytes of |buffer| without copying them.
+  void Send(int connection_id, IOBuffer* buffer, int len);
   void Send200(int connection_id,
                const std::string& data,
                const std::string& mime_type);
+  // Like Send200(), but sends the body from |body| without copying it.
+  void Send200Buffer(int connection_id,
+                     IOBuffer* body,
+                     int body_len,
+                     const std::string& mime_type);
   void Send404(int connection_id);
   void Send500(int connection_id, const std::string& message);
+  // Closes the connection once what was sent on it is.
   void Close(int connection_id);
 
 private:
@@ -63,7 +77,9 @@ private:
 
     void DetachSocket();
 
-    void Shift(int num_bytes);
+    // Moves the request parsed so far to |request|, and gets ready to parse
+    // the next one.
+    void TakeRequest(HttpServerRequestInfo* request);
 
     HttpServer* server_;
     scoped_refptr<ListenSocket> socket_;
@@ -71,6 +87,22 @@ private:
     std::string recv_data_;
     int id_;
 
+    // The parser state is kept between reads, so that the data received
+    // is only scanned once.  recv_data_ before |read_pos_| is parsed.
+    int read_pos_;
+    int parse_state_;
+    std::string parse_buffer_;
+    std::string header_name_;
+    HttpServerRequestInfo request_;
+    bool headers_done_;
+    bool http_1_1_;
+
+    // Requests passed to the delegate that haven't been responded to.
+    int pending_requests_;
+    // Set when no more requests are read, and the connection is closed once
+    // the pending ones are responded to.
+    bool close_after_response_;
+
     DISALLOW_COPY_AND_ASSIGN(Connection);
   };
   friend class Connection;
@@ -81,12 +113,13 @@ private:
   virtual void DidRead(ListenSocket* socket, const char* data, int len);
   virtual void DidClose(ListenSocket* socket);
 
-  // Expects the raw data to be stored in recv_data_. If parsing is successful,
-  // will remove the data parsed from recv_data_, leaving only the unused
-  // recv data.
-  bool ParseHeaders(Connection* connection,
-                    HttpServerRequestInfo* info,
-                    int* ppos);
+  // Parses recv_data_ from where the last call stopped, into request_.
+  // Returns true once the headers of a request, or a whole WebSocket
+  // message, are parsed.
+  bool ParseHeaders(Connection* connection);
+
+  // Called when a response is sent on |connection|.
+  void DidSendResponse(Connection* connection);
 
   Connection* FindConnection(int connection_id);
   Connection* FindConnection(ListenSocket* socket);
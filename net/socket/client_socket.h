@@ -13,6 +13,7 @@ namespace net {
 
 class AddressList;
 class IPEndPoint;
+struct TCPInfo;
 
 class ClientSocket : public Socket {
  public:
@@ -85,6 +86,18 @@ class ClientSocket : public Socket {
   // TCP FastOpen is an experiment with sending data in the TCP SYN packet.
   virtual bool UsingTCPFastOpen() const = 0;
 
+  // Called by the socket pools when the socket is put on an idle list.
+  // Sockets that keep buffers around, like the SSL sockets, may free them
+  // here and allocate them again when the socket is used. Returns the number
+  // of bytes freed.
+  virtual int ReleaseIdleBuffers() { return 0; }
+
+  // Fills in |info| with what the kernel knows about the underlying TCP
+  // connection.  Returns false if that isn't available on this platform or
+  // for this kind of socket.  Layered sockets should forward this call to the
+  // transport socket.
+  virtual bool GetTCPInfo(TCPInfo* info) const { return false; }
+
  protected:
   // The following class is only used to gather statistics about the history of
   // a socket.  It is only instantiated and used in basic sockets, such as
@@ -77,7 +77,8 @@ class DefaultClientSocketFactory : public ClientSocketFactory,
                                   dns_cert_checker);
 #elif defined(USE_OPENSSL)
     return new SSLClientSocketOpenSSL(transport_socket, host_and_port,
-                                      ssl_config, cert_verifier);
+                                      ssl_config, shi.release(),
+                                      cert_verifier);
 #elif defined(USE_NSS)
     return new SSLClientSocketNSS(transport_socket, host_and_port, ssl_config,
                                   shi.release(), cert_verifier,
@@ -96,14 +97,14 @@ class DefaultClientSocketFactory : public ClientSocketFactory,
 #endif
   }
 
-  // TODO(rch): This is only implemented for the NSS SSL library, which is the
-  /// default for Windows, Mac and Linux, but we should implement it everywhere.
+  // TODO(rch): This is only implemented for the NSS and OpenSSL libraries, but
+  // we should implement it everywhere.
   void ClearSSLSessionCache() {
 #if defined(OS_WIN)
     if (!g_use_system_ssl)
       SSLClientSocketNSS::ClearSessionCache();
 #elif defined(USE_OPENSSL)
-    // no-op
+    SSLClientSocketOpenSSL::ClearSessionCache();
 #elif defined(USE_NSS)
     SSLClientSocketNSS::ClearSessionCache();
 #elif defined(OS_MACOSX)
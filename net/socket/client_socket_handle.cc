@@ -8,8 +8,10 @@
 #include "base/metrics/histogram.h"
 #include "base/logging.h"
 #include "net/base/net_errors.h"
+#include "net/base/network_quality_estimator.h"
 #include "net/socket/client_socket_pool.h"
 #include "net/socket/client_socket_pool_histograms.h"
+#include "net/socket/tcp_info.h"
 
 namespace net {
 
@@ -36,10 +38,17 @@ void ClientSocketHandle::ResetInternal(bool cancel) {
     // Because of http://crbug.com/37810 we may not have a pool, but have
     // just a raw socket.
     socket_->NetLog().EndEvent(NetLog::TYPE_SOCKET_IN_USE, NULL);
-    if (pool_)
+    if (pool_) {
+      // Sample how the connection behaved over the transfer that just ended.
+      TCPInfo tcp_info;
+      if (socket_->WasEverUsed() && socket_->GetTCPInfo(&tcp_info)) {
+        pool_->histograms()->AddTCPInfo(tcp_info);
+        NetworkQualityEstimator::GetInstance()->AddRTTSample(tcp_info.rtt);
+      }
       // If we've still got a socket, release it back to the ClientSocketPool so
       // it can be deleted or reused.
       pool_->ReleaseSocket(group_name_, release_socket(), pool_id_);
+    }
   } else if (cancel) {
     // If we did not get initialized yet, we've got a socket request pending.
     // Cancel it.
@@ -48,6 +57,7 @@ void ClientSocketHandle::ResetInternal(bool cancel) {
   is_initialized_ = false;
   group_name_.clear();
   is_reused_ = false;
+  connect_timing_ = LoadTimingInfo::ConnectTiming();
   user_callback_ = NULL;
   pool_ = NULL;
   idle_time_ = base::TimeDelta();
@@ -72,6 +82,12 @@ LoadState ClientSocketHandle::GetLoadState() const {
   return pool_->GetLoadState(group_name_, this);
 }
 
+void ClientSocketHandle::SetPriority(RequestPriority priority) {
+  if (is_initialized() || group_name_.empty() || !pool_)
+    return;
+  pool_->SetPriority(group_name_, this, priority);
+}
+
 void ClientSocketHandle::OnIOComplete(int result) {
   CompletionCallback* callback = user_callback_;
   user_callback_ = NULL;
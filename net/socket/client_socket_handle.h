@@ -14,6 +14,7 @@
 #include "base/time.h"
 #include "net/base/completion_callback.h"
 #include "net/base/load_states.h"
+#include "net/base/load_timing_info.h"
 #include "net/base/net_errors.h"
 #include "net/base/net_log.h"
 #include "net/base/request_priority.h"
@@ -91,6 +92,10 @@ class ClientSocketHandle {
   // initialized the ClientSocketHandle.
   LoadState GetLoadState() const;
 
+  // Changes the priority of the socket request started by Init(). Does
+  // nothing if the request has already completed.
+  void SetPriority(RequestPriority priority);
+
   // Returns true when Init() has completed successfully.
   bool is_initialized() const { return is_initialized_; }
 
@@ -112,6 +117,10 @@ class ClientSocketHandle {
   void set_pending_http_proxy_connection(ClientSocketHandle* connection) {
     pending_http_proxy_connection_.reset(connection);
   }
+  void set_connect_timing(
+      const LoadTimingInfo::ConnectTiming& connect_timing) {
+    connect_timing_ = connect_timing;
+  }
 
   // Only valid if there is no |socket_|.
   bool is_ssl_error() const {
@@ -135,6 +144,10 @@ class ClientSocketHandle {
   ClientSocket* release_socket() { return socket_.release(); }
   bool is_reused() const { return is_reused_; }
   base::TimeDelta idle_time() const { return idle_time_; }
+  // How the socket was connected.  Empty if it was reused.
+  const LoadTimingInfo::ConnectTiming& connect_timing() const {
+    return connect_timing_;
+  }
   SocketReuseType reuse_type() const {
     if (is_reused()) {
       return REUSED_IDLE;
@@ -175,6 +188,7 @@ class ClientSocketHandle {
   scoped_ptr<ClientSocketHandle> pending_http_proxy_connection_;
   base::TimeTicks init_time_;
   base::TimeDelta setup_time_;
+  LoadTimingInfo::ConnectTiming connect_timing_;
 
   NetLog::Source requesting_source_;
 
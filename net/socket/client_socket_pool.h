@@ -39,6 +39,8 @@ class ClientSocketPool {
   // 3) RequestSocket returns ERR_IO_PENDING.  The handle will be added to a
   // wait list until a socket is available to reuse or a new socket finishes
   // connecting.  |priority| will determine the placement into the wait list.
+  // An IDLE request also waits while requests of any other priority are
+  // waiting, and may have its connect job taken by them.
   // 4) An error occurred early on, so RequestSocket returns an error code.
   // 5) A recoverable error occurred while setting up the socket.  An error
   // code is returned, but the |handle| is initialized with the new socket.
@@ -90,6 +92,15 @@ class ClientSocketPool {
   virtual void CancelRequest(const std::string& group_name,
                              ClientSocketHandle* handle) = 0;
 
+  // Called to change the priority of a RequestSocket call that returned
+  // ERR_IO_PENDING and has not completed yet.  The same handle parameter must
+  // be passed to this method as was passed to the RequestSocket call.  The
+  // request is moved within the group's pending queue; requests that already
+  // have a socket are not affected.
+  virtual void SetPriority(const std::string& group_name,
+                           ClientSocketHandle* handle,
+                           RequestPriority priority) = 0;
+
   // Called to release a socket once the socket is no longer needed.  If the
   // socket still has an established connection, then it will be added to the
   // set of idle sockets to be used to satisfy future RequestSocket calls.
@@ -4,9 +4,12 @@
 
 #include "net/socket/client_socket_pool_base.h"
 
+#include <vector>
+
 #include "base/compiler_specific.h"
 #include "base/format_macros.h"
 #include "base/message_loop.h"
+#include "base/metrics/histogram.h"
 #include "base/metrics/stats_counters.h"
 #include "base/stl_util-inl.h"
 #include "base/string_util.h"
@@ -167,7 +170,8 @@ ClientSocketPoolBaseHelper::ClientSocketPoolBaseHelper(
     base::TimeDelta unused_idle_socket_timeout,
     base::TimeDelta used_idle_socket_timeout,
     ConnectJobFactory* connect_job_factory)
-    : idle_socket_count_(0),
+    : next_pending_order_(0),
+      idle_socket_count_(0),
       connecting_socket_count_(0),
       handed_out_socket_count_(0),
       max_sockets_(max_sockets),
@@ -178,7 +182,8 @@ ClientSocketPoolBaseHelper::ClientSocketPoolBaseHelper(
       connect_job_factory_(connect_job_factory),
       connect_backup_jobs_enabled_(false),
       pool_generation_number_(0),
-      method_factory_(ALLOW_THIS_IN_INITIALIZER_LIST(this)) {
+      method_factory_(ALLOW_THIS_IN_INITIALIZER_LIST(this)),
+      resume_idle_priority_factory_(ALLOW_THIS_IN_INITIALIZER_LIST(this)) {
   DCHECK_LE(0, max_sockets_per_group);
   DCHECK_LE(max_sockets_per_group, max_sockets);
 
@@ -191,6 +196,7 @@ ClientSocketPoolBaseHelper::~ClientSocketPoolBaseHelper() {
   // cleaned up prior to |this| being destroyed.
   Flush();
   DCHECK(group_map_.empty());
+  DCHECK(pending_groups_.empty());
   DCHECK(pending_callback_map_.empty());
   DCHECK_EQ(0, connecting_socket_count_);
 
@@ -210,18 +216,45 @@ void ClientSocketPoolBaseHelper::InsertRequestIntoQueue(
   pending_requests->insert(it, r);
 }
 
-// static
+void ClientSocketPoolBaseHelper::AddPendingRequest(const Request* r,
+                                                   Group* group) {
+  RemoveFromPendingGroups(group);
+  if (group->pending_requests().empty())
+    group->set_pending_order(next_pending_order_++);
+  InsertRequestIntoQueue(r, group->mutable_pending_requests());
+  AddToPendingGroups(group);
+}
+
 const ClientSocketPoolBaseHelper::Request*
 ClientSocketPoolBaseHelper::RemoveRequestFromQueue(
     const RequestQueue::iterator& it, Group* group) {
+  RemoveFromPendingGroups(group);
   const Request* req = *it;
   group->mutable_pending_requests()->erase(it);
+  AddToPendingGroups(group);
+  if (req->priority() != IDLE)
+    MaybeResumeIdlePriorityRequests();
   // If there are no more requests, we kill the backup timer.
   if (group->pending_requests().empty())
     group->CleanupBackupJob();
   return req;
 }
 
+void ClientSocketPoolBaseHelper::RemoveFromPendingGroups(Group* group) {
+  if (group->pending_requests().empty())
+    return;
+  size_t erased = pending_groups_.erase(
+      std::make_pair(group->TopPendingPriority(), group->pending_order()));
+  DCHECK_EQ(1u, erased);
+}
+
+void ClientSocketPoolBaseHelper::AddToPendingGroups(Group* group) {
+  if (group->pending_requests().empty())
+    return;
+  pending_groups_[std::make_pair(group->TopPendingPriority(),
+                                 group->pending_order())] = group;
+}
+
 int ClientSocketPoolBaseHelper::RequestSocket(
     const std::string& group_name,
     const Request* request) {
@@ -241,7 +274,7 @@ int ClientSocketPoolBaseHelper::RequestSocket(
     CHECK(!request->handle()->is_initialized());
     delete request;
   } else {
-    InsertRequestIntoQueue(request, group->mutable_pending_requests());
+    AddPendingRequest(request, group);
   }
   return rv;
 }
@@ -308,6 +341,15 @@ int ClientSocketPoolBaseHelper::RequestSocketInternal(
   const bool preconnecting = !handle;
   Group* group = GetOrCreateGroup(group_name);
 
+  // IDLE requests are for work that can wait, like prefetches: they don't
+  // get a socket while any other request is waiting for one.
+  if (request->priority() == IDLE && !request->ignore_limits() &&
+      HasPendingNonIdleRequest()) {
+    request->net_log().AddEvent(
+        NetLog::TYPE_SOCKET_POOL_STALLED_IDLE_PRIORITY, NULL);
+    return ERR_IO_PENDING;
+  }
+
   if (!(request->flags() & NO_IDLE_SOCKETS)) {
     // Try to reuse a socket.
     if (AssignIdleSocketToGroup(request, group))
@@ -330,7 +372,8 @@ int ClientSocketPoolBaseHelper::RequestSocketInternal(
       bool closed = CloseOneIdleSocketExceptInGroup(group);
       if (preconnecting && !closed)
         return ERR_PRECONNECT_MAX_SOCKET_LIMIT;
-    } else {
+    } else if (request->priority() == IDLE ||
+               !CancelOneIdlePriorityConnectJob(group)) {
       // We could check if we really have a stalled group here, but it requires
       // a scan of all groups, so just flip a flag here, and do the check later.
       request->net_log().AddEvent(
@@ -350,6 +393,7 @@ int ClientSocketPoolBaseHelper::RequestSocketInternal(
     if (!preconnecting) {
       HandOutSocket(connect_job->ReleaseSocket(), false /* not reused */,
                     handle, base::TimeDelta(), group, request->net_log());
+      handle->set_connect_timing(connect_job->connect_timing());
     } else {
       AddIdleSocket(connect_job->ReleaseSocket(), group);
     }
@@ -377,6 +421,7 @@ int ClientSocketPoolBaseHelper::RequestSocketInternal(
     if (error_socket) {
       HandOutSocket(error_socket, false /* not reused */, handle,
                     base::TimeDelta(), group, request->net_log());
+      handle->set_connect_timing(connect_job->connect_timing());
     } else if (group->IsEmpty()) {
       RemoveGroup(group_name);
     }
@@ -387,45 +432,41 @@ int ClientSocketPoolBaseHelper::RequestSocketInternal(
 
 bool ClientSocketPoolBaseHelper::AssignIdleSocketToGroup(
     const Request* request, Group* group) {
-  std::list<IdleSocket>* idle_sockets = group->mutable_idle_sockets();
-  std::list<IdleSocket>::iterator idle_socket_it = idle_sockets->end();
+  IdleSocketList* idle_sockets = group->mutable_idle_sockets();
+  IdleSocket* idle_socket = NULL;
 
   // Iterate through the idle sockets forwards (oldest to newest)
   //   * Delete any disconnected ones.
   //   * If we find a used idle socket, assign to |idle_socket|.  At the end,
-  //   the |idle_socket_it| will be set to the newest used idle socket.
-  for (std::list<IdleSocket>::iterator it = idle_sockets->begin();
+  //   the |idle_socket| will be set to the newest used idle socket.
+  for (IdleSocketList::iterator it = idle_sockets->begin();
        it != idle_sockets->end();) {
-    if (!it->socket->IsConnectedAndIdle()) {
-      DecrementIdleCount();
-      delete it->socket;
-      it = idle_sockets->erase(it);
+    IdleSocket* current = *it;
+    ++it;
+    if (!current->socket->IsConnectedAndIdle()) {
+      delete RemoveIdleSocket(current);
       continue;
     }
 
-    if (it->socket->WasEverUsed()) {
+    if (current->socket->WasEverUsed()) {
       // We found one we can reuse!
-      idle_socket_it = it;
+      idle_socket = current;
     }
-
-    ++it;
   }
 
   // If we haven't found an idle socket, that means there are no used idle
   // sockets.  Pick the oldest (first) idle socket (FIFO).
 
-  if (idle_socket_it == idle_sockets->end() && !idle_sockets->empty())
-    idle_socket_it = idle_sockets->begin();
+  if (!idle_socket && !idle_sockets->empty())
+    idle_socket = idle_sockets->front();
 
-  if (idle_socket_it != idle_sockets->end()) {
-    DecrementIdleCount();
+  if (idle_socket) {
     base::TimeDelta idle_time =
-        base::TimeTicks::Now() - idle_socket_it->start_time;
-    IdleSocket idle_socket = *idle_socket_it;
-    idle_sockets->erase(idle_socket_it);
+        base::TimeTicks::Now() - idle_socket->start_time;
+    ClientSocket* socket = RemoveIdleSocket(idle_socket);
     HandOutSocket(
-        idle_socket.socket,
-        idle_socket.socket->WasEverUsed(),
+        socket,
+        socket->WasEverUsed(),
         request->handle(),
         idle_time,
         group,
@@ -482,6 +523,40 @@ void ClientSocketPoolBaseHelper::CancelRequest(
   }
 }
 
+void ClientSocketPoolBaseHelper::SetPriority(const std::string& group_name,
+                                             ClientSocketHandle* handle,
+                                             RequestPriority priority) {
+  GroupMap::iterator group_it = group_map_.find(group_name);
+  if (group_it == group_map_.end())
+    return;
+
+  // The request is taken out of the queue directly, without going through
+  // RemoveRequestFromQueue(), so that the group keeps its backup job timer.
+  Group* group = group_it->second;
+  RequestQueue* pending_requests = group->mutable_pending_requests();
+  for (RequestQueue::iterator it = pending_requests->begin();
+       it != pending_requests->end(); ++it) {
+    if ((*it)->handle() == handle) {
+      // The queue only hands out const pointers, but the helper owns the
+      // requests.
+      Request* req = const_cast<Request*>(*it);
+      if (req->priority() == priority)
+        return;
+      RemoveFromPendingGroups(group);
+      pending_requests->erase(it);
+      RequestPriority old_priority = req->priority();
+      req->set_priority(priority);
+      InsertRequestIntoQueue(req, pending_requests);
+      AddToPendingGroups(group);
+      if (old_priority == IDLE && group->IsStalled(max_sockets_per_group_))
+        OnAvailableSocketSlot(group_name, group);
+      else if (priority == IDLE)
+        MaybeResumeIdlePriorityRequests();
+      return;
+    }
+  }
+}
+
 bool ClientSocketPoolBaseHelper::HasGroup(const std::string& group_name) const {
   return ContainsKey(group_map_, group_name);
 }
@@ -499,6 +574,14 @@ int ClientSocketPoolBaseHelper::IdleSocketCountInGroup(
   return i->second->idle_sockets().size();
 }
 
+int ClientSocketPoolBaseHelper::TakePeakActiveSocketCount(
+    const std::string& group_name) {
+  GroupMap::iterator i = group_map_.find(group_name);
+  if (i == group_map_.end())
+    return 0;
+  return i->second->TakePeakActiveSocketCount();
+}
+
 LoadState ClientSocketPoolBaseHelper::GetLoadState(
     const std::string& group_name,
     const ClientSocketHandle* handle) const {
@@ -568,11 +651,11 @@ DictionaryValue* ClientSocketPoolBaseHelper::GetInfoAsValue(
     group_dict->SetInteger("active_socket_count", group->active_socket_count());
 
     ListValue* idle_socket_list = new ListValue();
-    std::list<IdleSocket>::const_iterator idle_socket;
+    IdleSocketList::const_iterator idle_socket;
     for (idle_socket = group->idle_sockets().begin();
          idle_socket != group->idle_sockets().end();
          idle_socket++) {
-      int source_id = idle_socket->socket->NetLog().source().id;
+      int source_id = (*idle_socket)->socket->NetLog().source().id;
       idle_socket_list->Append(Value::CreateIntegerValue(source_id));
     }
     group_dict->Set("idle_sockets", idle_socket_list);
@@ -614,29 +697,22 @@ void ClientSocketPoolBaseHelper::CleanupIdleSockets(bool force) {
   // inside the inner loop, since it shouldn't change by any meaningful amount.
   base::TimeTicks now = base::TimeTicks::Now();
 
-  GroupMap::iterator i = group_map_.begin();
-  while (i != group_map_.end()) {
-    Group* group = i->second;
+  // Only the groups with idle sockets are visited, through the LRU.
+  base::LinkNode<IdleSocket>* node = idle_socket_lru_.head();
+  while (node != idle_socket_lru_.end()) {
+    IdleSocket* idle_socket = node->value();
+    node = node->next();
 
-    std::list<IdleSocket>::iterator j = group->mutable_idle_sockets()->begin();
-    while (j != group->idle_sockets().end()) {
-      base::TimeDelta timeout =
-          j->socket->WasEverUsed() ?
-          used_idle_socket_timeout_ : unused_idle_socket_timeout_;
-      if (force || j->ShouldCleanup(now, timeout)) {
-        delete j->socket;
-        j = group->mutable_idle_sockets()->erase(j);
-        DecrementIdleCount();
-      } else {
-        ++j;
-      }
-    }
+    base::TimeDelta timeout =
+        idle_socket->socket->WasEverUsed() ?
+        used_idle_socket_timeout_ : unused_idle_socket_timeout_;
+    if (force || idle_socket->ShouldCleanup(now, timeout)) {
+      Group* group = idle_socket->group;
+      delete RemoveIdleSocket(idle_socket);
 
-    // Delete group if no longer needed.
-    if (group->IsEmpty()) {
-      RemoveGroup(i++);
-    } else {
-      ++i;
+      // Delete group if no longer needed.
+      if (group->IsEmpty())
+        RemoveGroup(group->group_name());
     }
   }
 }
@@ -646,7 +722,7 @@ ClientSocketPoolBaseHelper::Group* ClientSocketPoolBaseHelper::GetOrCreateGroup(
   GroupMap::iterator it = group_map_.find(group_name);
   if (it != group_map_.end())
     return it->second;
-  Group* group = new Group;
+  Group* group = new Group(group_name);
   group_map_[group_name] = group;
   return group;
 }
@@ -659,6 +735,7 @@ void ClientSocketPoolBaseHelper::RemoveGroup(const std::string& group_name) {
 }
 
 void ClientSocketPoolBaseHelper::RemoveGroup(GroupMap::iterator it) {
+  RemoveFromPendingGroups(it->second);
   delete it->second;
   group_map_.erase(it);
 }
@@ -759,35 +836,25 @@ void ClientSocketPoolBaseHelper::CheckForStalledSocketGroups() {
 
 // Search for the highest priority pending request, amongst the groups that
 // are not at the |max_sockets_per_group_| limit. Note: for requests with
-// the same priority, the winner is based on group hash ordering (and not
-// insertion order).
+// the same priority, the winner is the group which has been waiting the
+// longest.  Only groups with pending requests are visited, in priority order,
+// so this usually stops at the first one.
 bool ClientSocketPoolBaseHelper::FindTopStalledGroup(Group** group,
                                                      std::string* group_name) {
-  Group* top_group = NULL;
-  const std::string* top_group_name = NULL;
-  bool has_stalled_group = false;
-  for (GroupMap::iterator i = group_map_.begin();
-       i != group_map_.end(); ++i) {
+  for (PendingGroupQueue::const_iterator i = pending_groups_.begin();
+       i != pending_groups_.end(); ++i) {
+    // The rest of the groups only have IDLE requests, which would stay
+    // stalled.
+    if (i->first.first == IDLE && HasPendingNonIdleRequest())
+      return false;
     Group* curr_group = i->second;
-    const RequestQueue& queue = curr_group->pending_requests();
-    if (queue.empty())
-      continue;
     if (curr_group->IsStalled(max_sockets_per_group_)) {
-      has_stalled_group = true;
-      bool has_higher_priority = !top_group ||
-          curr_group->TopPendingPriority() < top_group->TopPendingPriority();
-      if (has_higher_priority) {
-        top_group = curr_group;
-        top_group_name = &i->first;
-      }
+      *group = curr_group;
+      *group_name = curr_group->group_name();
+      return true;
     }
   }
-
-  if (top_group) {
-    *group = top_group;
-    *group_name = *top_group_name;
-  }
-  return has_stalled_group;
+  return false;
 }
 
 void ClientSocketPoolBaseHelper::OnConnectJobComplete(
@@ -801,6 +868,7 @@ void ClientSocketPoolBaseHelper::OnConnectJobComplete(
   scoped_ptr<ClientSocket> socket(job->ReleaseSocket());
 
   BoundNetLog job_log = job->net_log();
+  LoadTimingInfo::ConnectTiming connect_timing = job->connect_timing();
 
   if (result == OK) {
     DCHECK(socket.get());
@@ -812,6 +880,7 @@ void ClientSocketPoolBaseHelper::OnConnectJobComplete(
       HandOutSocket(
           socket.release(), false /* unused socket */, r->handle(),
           base::TimeDelta(), group, r->net_log());
+      r->handle()->set_connect_timing(connect_timing);
       r->net_log().EndEvent(NetLog::TYPE_SOCKET_POOL, NULL);
       InvokeUserCallbackLater(r->handle(), r->callback(), result);
     } else {
@@ -931,14 +1000,38 @@ void ClientSocketPoolBaseHelper::HandOutSocket(
 void ClientSocketPoolBaseHelper::AddIdleSocket(
     ClientSocket* socket, Group* group) {
   DCHECK(socket);
-  IdleSocket idle_socket;
-  idle_socket.socket = socket;
-  idle_socket.start_time = base::TimeTicks::Now();
+  int released = socket->ReleaseIdleBuffers();
+  if (released > 0) {
+    UMA_HISTOGRAM_CUSTOM_COUNTS("Net.SocketIdleBuffersReleased", released,
+                                1, 256 * 1024, 50);
+    socket->NetLog().AddEvent(
+        NetLog::TYPE_SOCKET_POOL_RELEASED_IDLE_BUFFERS,
+        make_scoped_refptr(new NetLogIntegerParameter("bytes", released)));
+  }
 
-  group->mutable_idle_sockets()->push_back(idle_socket);
+  IdleSocket* idle_socket = new IdleSocket;
+  idle_socket->socket = socket;
+  idle_socket->start_time = base::TimeTicks::Now();
+  idle_socket->group = group;
+
+  IdleSocketList* idle_sockets = group->mutable_idle_sockets();
+  idle_socket->position_in_group =
+      idle_sockets->insert(idle_sockets->end(), idle_socket);
+  idle_socket_lru_.Append(idle_socket);
   IncrementIdleCount();
 }
 
+ClientSocket* ClientSocketPoolBaseHelper::RemoveIdleSocket(
+    IdleSocket* idle_socket) {
+  ClientSocket* socket = idle_socket->socket;
+  idle_socket->RemoveFromList();
+  idle_socket->group->mutable_idle_sockets()->erase(
+      idle_socket->position_in_group);
+  delete idle_socket;
+  DecrementIdleCount();
+  return socket;
+}
+
 void ClientSocketPoolBaseHelper::CancelAllConnectJobs() {
   for (GroupMap::iterator i = group_map_.begin(); i != group_map_.end();) {
     Group* group = i->second;
@@ -962,6 +1055,7 @@ void ClientSocketPoolBaseHelper::AbortAllRequests() {
   for (GroupMap::iterator i = group_map_.begin(); i != group_map_.end();) {
     Group* group = i->second;
 
+    RemoveFromPendingGroups(group);
     RequestQueue pending_requests;
     pending_requests.swap(*group->mutable_pending_requests());
     for (RequestQueue::iterator it2 = pending_requests.begin();
@@ -983,6 +1077,68 @@ void ClientSocketPoolBaseHelper::AbortAllRequests() {
   }
 }
 
+bool ClientSocketPoolBaseHelper::HasPendingNonIdleRequest() const {
+  return !pending_groups_.empty() &&
+      pending_groups_.begin()->first.first != IDLE;
+}
+
+bool ClientSocketPoolBaseHelper::CancelOneIdlePriorityConnectJob(
+    const Group* exception_group) {
+  // The groups whose requests are all IDLE are at the end of the queue.
+  for (PendingGroupQueue::reverse_iterator i = pending_groups_.rbegin();
+       i != pending_groups_.rend() && i->first.first == IDLE; ++i) {
+    Group* group = i->second;
+    if (group != exception_group && !group->jobs().empty()) {
+      RemoveConnectJob(*group->jobs().begin(), group);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ClientSocketPoolBaseHelper::MaybeResumeIdlePriorityRequests() {
+  if (pending_groups_.empty() || HasPendingNonIdleRequest() ||
+      !resume_idle_priority_factory_.empty()) {
+    return;
+  }
+  MessageLoop::current()->PostTask(
+      FROM_HERE,
+      resume_idle_priority_factory_.NewRunnableMethod(
+          &ClientSocketPoolBaseHelper::ResumeIdlePriorityRequests));
+}
+
+void ClientSocketPoolBaseHelper::ResumeIdlePriorityRequests() {
+  // Starting a request can remove its group, or the group queue entry, so
+  // work from a copy of the names.
+  std::vector<std::string> group_names;
+  for (PendingGroupQueue::const_iterator i = pending_groups_.begin();
+       i != pending_groups_.end(); ++i) {
+    group_names.push_back(i->second->group_name());
+  }
+
+  for (size_t i = 0; i < group_names.size(); i++) {
+    if (HasPendingNonIdleRequest())
+      return;
+    // Start as many of the requests of the group as it has slots for.
+    while (true) {
+      GroupMap::iterator it = group_map_.find(group_names[i]);
+      if (it == group_map_.end())
+        break;
+      Group* group = it->second;
+      if (!group->IsStalled(max_sockets_per_group_))
+        break;
+      size_t num_pending = group->pending_requests().size();
+      size_t num_jobs = group->jobs().size();
+      OnAvailableSocketSlot(group_names[i], group);
+      if (!ContainsKey(group_map_, group_names[i]) ||
+          (group->pending_requests().size() == num_pending &&
+           group->jobs().size() == num_jobs)) {
+        break;
+      }
+    }
+  }
+}
+
 bool ClientSocketPoolBaseHelper::ReachedMaxSocketsLimit() const {
   // Each connecting socket will eventually connect and be handed out.
   int total = handed_out_socket_count_ + connecting_socket_count_ +
@@ -1002,21 +1158,19 @@ bool ClientSocketPoolBaseHelper::CloseOneIdleSocketExceptInGroup(
     const Group* exception_group) {
   CHECK_GT(idle_socket_count(), 0);
 
-  for (GroupMap::iterator i = group_map_.begin(); i != group_map_.end(); ++i) {
-    Group* group = i->second;
+  // At most the idle sockets of |exception_group| are skipped.
+  for (base::LinkNode<IdleSocket>* node = idle_socket_lru_.head();
+       node != idle_socket_lru_.end(); node = node->next()) {
+    IdleSocket* idle_socket = node->value();
+    Group* group = idle_socket->group;
     if (exception_group == group)
       continue;
-    std::list<IdleSocket>* idle_sockets = group->mutable_idle_sockets();
 
-    if (!idle_sockets->empty()) {
-      delete idle_sockets->front().socket;
-      idle_sockets->pop_front();
-      DecrementIdleCount();
-      if (group->IsEmpty())
-        RemoveGroup(i);
+    delete RemoveIdleSocket(idle_socket);
+    if (group->IsEmpty())
+      RemoveGroup(group->group_name());
 
-      return true;
-    }
+    return true;
   }
 
   if (!exception_group)
@@ -1051,8 +1205,11 @@ void ClientSocketPoolBaseHelper::InvokeUserCallback(
   callback->Run(result);
 }
 
-ClientSocketPoolBaseHelper::Group::Group()
-    : active_socket_count_(0),
+ClientSocketPoolBaseHelper::Group::Group(const std::string& group_name)
+    : group_name_(group_name),
+      active_socket_count_(0),
+      peak_active_socket_count_(0),
+      pending_order_(0),
       ALLOW_THIS_IN_INITIALIZER_LIST(method_factory_(this)) {}
 
 ClientSocketPoolBaseHelper::Group::~Group() {
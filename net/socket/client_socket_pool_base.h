@@ -28,8 +28,11 @@
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
 
 #include "base/basictypes.h"
+#include "base/hash_tables.h"
+#include "base/linked_list.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/task.h"
@@ -38,6 +41,7 @@
 #include "net/base/address_list.h"
 #include "net/base/completion_callback.h"
 #include "net/base/load_states.h"
+#include "net/base/load_timing_info.h"
 #include "net/base/net_errors.h"
 #include "net/base/net_log.h"
 #include "net/base/network_change_notifier.h"
@@ -112,12 +116,20 @@ class ConnectJob {
 
   const BoundNetLog& net_log() const { return net_log_; }
 
+  // The times of the steps taken to connect the socket.
+  const LoadTimingInfo::ConnectTiming& connect_timing() const {
+    return connect_timing_;
+  }
+
  protected:
   void set_socket(ClientSocket* socket);
   ClientSocket* socket() { return socket_.get(); }
   void NotifyDelegateOfCompletion(int rv);
   void ResetTimer(base::TimeDelta remainingTime);
 
+  // Filled in by subclasses as they go through each step.
+  LoadTimingInfo::ConnectTiming connect_timing_;
+
  private:
   enum PreconnectState {
     NOT_PRECONNECT,
@@ -184,6 +196,7 @@ class ClientSocketPoolBaseHelper
     ClientSocketHandle* handle() const { return handle_; }
     CompletionCallback* callback() const { return callback_; }
     RequestPriority priority() const { return priority_; }
+    void set_priority(RequestPriority priority) { priority_ = priority; }
     bool ignore_limits() const { return ignore_limits_; }
     Flags flags() const { return flags_; }
     const BoundNetLog& net_log() const { return net_log_; }
@@ -191,7 +204,7 @@ class ClientSocketPoolBaseHelper
    private:
     ClientSocketHandle* const handle_;
     CompletionCallback* const callback_;
-    const RequestPriority priority_;
+    RequestPriority priority_;
     bool ignore_limits_;
     const Flags flags_;
     BoundNetLog net_log_;
@@ -242,6 +255,11 @@ class ClientSocketPoolBaseHelper
   void CancelRequest(const std::string& group_name,
                      ClientSocketHandle* handle);
 
+  // See ClientSocketPool::SetPriority for documentation on this function.
+  void SetPriority(const std::string& group_name,
+                   ClientSocketHandle* handle,
+                   RequestPriority priority);
+
   // See ClientSocketPool::ReleaseSocket for documentation on this function.
   void ReleaseSocket(const std::string& group_name,
                      ClientSocket* socket,
@@ -280,6 +298,11 @@ class ClientSocketPoolBaseHelper
     return group_map_.find(group_name)->second->active_socket_count();
   }
 
+  // Returns the largest number of sockets that clients of |group_name| held
+  // at the same time since the last call, and starts a new measurement from
+  // the current number. Returns 0 if there is no such group.
+  int TakePeakActiveSocketCount(const std::string& group_name);
+
   bool HasGroup(const std::string& group_name) const;
 
   // Called to enable/disable cleaning up idle sockets. When enabled,
@@ -316,9 +339,13 @@ class ClientSocketPoolBaseHelper
  private:
   friend class base::RefCounted<ClientSocketPoolBaseHelper>;
 
+  class Group;
+
   // Entry for a persistent socket which became idle at time |start_time|.
-  struct IdleSocket {
-    IdleSocket() : socket(NULL) {}
+  // Each entry is owned by the idle socket list of its |group|, and is also
+  // linked into the pool-wide list of idle sockets, oldest first.
+  struct IdleSocket : public base::LinkNode<IdleSocket> {
+    IdleSocket() : socket(NULL), group(NULL) {}
 
     // An idle socket should be removed if it can't be reused, or has been idle
     // for too long. |now| is the current time value (TimeTicks::Now()).
@@ -332,8 +359,12 @@ class ClientSocketPoolBaseHelper
 
     ClientSocket* socket;
     base::TimeTicks start_time;
+    Group* group;
+    // The position of this entry in the idle socket list of |group|.
+    std::list<IdleSocket*>::iterator position_in_group;
   };
 
+  typedef std::list<IdleSocket*> IdleSocketList;
   typedef std::deque<const Request* > RequestQueue;
   typedef std::map<const ClientSocketHandle*, const Request*> RequestMap;
 
@@ -342,9 +373,11 @@ class ClientSocketPoolBaseHelper
   // |active_socket_count| tracks the number of sockets held by clients.
   class Group {
    public:
-    Group();
+    explicit Group(const std::string& group_name);
     ~Group();
 
+    const std::string& group_name() const { return group_name_; }
+
     bool IsEmpty() const {
       return active_socket_count_ == 0 && idle_sockets_.empty() &&
           jobs_.empty() && pending_requests_.empty();
@@ -386,15 +419,33 @@ class ClientSocketPoolBaseHelper
     void RemoveJob(ConnectJob* job) { jobs_.erase(job); }
     void RemoveAllJobs();
 
-    void IncrementActiveSocketCount() { active_socket_count_++; }
+    void IncrementActiveSocketCount() {
+      active_socket_count_++;
+      if (active_socket_count_ > peak_active_socket_count_)
+        peak_active_socket_count_ = active_socket_count_;
+    }
     void DecrementActiveSocketCount() { active_socket_count_--; }
 
+    // Returns the peak of |active_socket_count_| since the last call.
+    int TakePeakActiveSocketCount() {
+      int peak = peak_active_socket_count_;
+      peak_active_socket_count_ = active_socket_count_;
+      return peak;
+    }
+
     const std::set<ConnectJob*>& jobs() const { return jobs_; }
-    const std::list<IdleSocket>& idle_sockets() const { return idle_sockets_; }
+    const IdleSocketList& idle_sockets() const { return idle_sockets_; }
     const RequestQueue& pending_requests() const { return pending_requests_; }
     int active_socket_count() const { return active_socket_count_; }
     RequestQueue* mutable_pending_requests() { return &pending_requests_; }
-    std::list<IdleSocket>* mutable_idle_sockets() { return &idle_sockets_; }
+    IdleSocketList* mutable_idle_sockets() { return &idle_sockets_; }
+
+    // The order in which the group started waiting for a socket, used to
+    // break ties between stalled groups of equal priority.
+    uint64 pending_order() const { return pending_order_; }
+    void set_pending_order(uint64 pending_order) {
+      pending_order_ = pending_order;
+    }
 
    private:
     // Called when the backup socket timer fires.
@@ -402,15 +453,23 @@ class ClientSocketPoolBaseHelper
         std::string group_name,
         ClientSocketPoolBaseHelper* pool);
 
-    std::list<IdleSocket> idle_sockets_;
+    const std::string group_name_;
+    IdleSocketList idle_sockets_;
     std::set<ConnectJob*> jobs_;
     RequestQueue pending_requests_;
     int active_socket_count_;  // number of active sockets used by clients
+    int peak_active_socket_count_;
+    uint64 pending_order_;
     // A factory to pin the backup_job tasks.
     ScopedRunnableMethodFactory<Group> method_factory_;
   };
 
-  typedef std::map<std::string, Group*> GroupMap;
+  typedef base::hash_map<std::string, Group*> GroupMap;
+
+  // The groups with pending requests, keyed by the priority of their top
+  // pending request and then by the order in which they started waiting.
+  typedef std::map<std::pair<RequestPriority, uint64>, Group*>
+      PendingGroupQueue;
 
   typedef std::set<ConnectJob*> ConnectJobSet;
 
@@ -428,8 +487,17 @@ class ClientSocketPoolBaseHelper
 
   static void InsertRequestIntoQueue(const Request* r,
                                      RequestQueue* pending_requests);
-  static const Request* RemoveRequestFromQueue(const RequestQueue::iterator& it,
-                                               Group* group);
+
+  // Adds |r| to the pending requests of |group|, and keeps |pending_groups_|
+  // up to date.
+  void AddPendingRequest(const Request* r, Group* group);
+  const Request* RemoveRequestFromQueue(const RequestQueue::iterator& it,
+                                        Group* group);
+
+  // Remove |group| from, and add it back to, |pending_groups_|.  Must bracket
+  // any change to the pending requests of |group|.
+  void RemoveFromPendingGroups(Group* group);
+  void AddToPendingGroups(Group* group);
 
   Group* GetOrCreateGroup(const std::string& group_name);
   void RemoveGroup(const std::string& group_name);
@@ -442,10 +510,11 @@ class ClientSocketPoolBaseHelper
   // Start cleanup timer for idle sockets.
   void StartIdleSocketTimer();
 
-  // Scans the group map for groups which have an available socket slot and
-  // at least one pending request. Returns true if any groups are stalled, and
-  // if so, fills |group| and |group_name| with data of the stalled group
-  // having highest priority.
+  // Looks for a group which has an available socket slot and more pending
+  // requests than connect jobs, starting from the groups with the highest
+  // priority requests. Returns true if a group is stalled, and if so, fills
+  // |group| and |group_name| with data of the stalled group having highest
+  // priority.
   bool FindTopStalledGroup(Group** group, std::string* group_name);
 
   // Called when timer_ fires.  This method scans the idle sockets removing
@@ -471,9 +540,14 @@ class ClientSocketPoolBaseHelper
                      Group* group,
                      const BoundNetLog& net_log);
 
-  // Adds |socket| to the list of idle sockets for |group|.
+  // Adds |socket| to the list of idle sockets for |group|, after letting it
+  // free the buffers it doesn't need while idle.
   void AddIdleSocket(ClientSocket* socket, Group* group);
 
+  // Removes |idle_socket| from its group and from |idle_socket_lru_|, deletes
+  // it, and returns its socket, which the caller now owns.
+  ClientSocket* RemoveIdleSocket(IdleSocket* idle_socket);
+
   // Iterates through |group_map_|, canceling all ConnectJobs and deleting
   // groups if they are no longer needed.
   void CancelAllConnectJobs();
@@ -485,6 +559,23 @@ class ClientSocketPoolBaseHelper
   // Returns true if we can't create any more sockets due to the total limit.
   bool ReachedMaxSocketsLimit() const;
 
+  // Returns true if a request that is not IDLE is waiting for a socket.
+  // IDLE requests wait behind those.
+  bool HasPendingNonIdleRequest() const;
+
+  // Cancels a connect job of a group, other than |exception_group|, that only
+  // has IDLE requests waiting, so that a request of a higher priority can
+  // take its slot.  The IDLE requests stay queued.  Returns true if it
+  // cancelled a job.
+  bool CancelOneIdlePriorityConnectJob(const Group* exception_group);
+
+  // Posts a task to call ResumeIdlePriorityRequests() if IDLE requests are
+  // all that is left waiting.
+  void MaybeResumeIdlePriorityRequests();
+
+  // Starts the IDLE requests that were held back, as slots allow.
+  void ResumeIdlePriorityRequests();
+
   // This is the internal implementation of RequestSocket().  It differs in that
   // it does not handle logging into NetLog of the queueing status of
   // |request|.
@@ -498,11 +589,7 @@ class ClientSocketPoolBaseHelper
   static void LogBoundConnectJobToRequest(
       const NetLog::Source& connect_job_source, const Request* request);
 
-  // Closes one idle socket.  Picks the first one encountered.
-  // TODO(willchan): Consider a better algorithm for doing this.  Perhaps we
-  // should keep an ordered list of idle sockets, and close them in order.
-  // Requires maintaining more state.  It's not clear if it's worth it since
-  // I'm not sure if we hit this situation often.
+  // Closes the oldest idle socket.
   void CloseOneIdleSocket();
 
   // Same as CloseOneIdleSocket() except it won't close an idle socket in
@@ -528,6 +615,15 @@ class ClientSocketPoolBaseHelper
 
   GroupMap group_map_;
 
+  // See PendingGroupQueue.
+  PendingGroupQueue pending_groups_;
+
+  // The value of Group::pending_order() for the next group to wait.
+  uint64 next_pending_order_;
+
+  // All the idle sockets, oldest first.
+  base::LinkedList<IdleSocket> idle_socket_lru_;
+
   // Map of the ClientSocketHandles for which we have a pending Task to invoke a
   // callback.  This is necessary since, before we invoke said callback, it's
   // possible that the request is cancelled.
@@ -571,6 +667,10 @@ class ClientSocketPoolBaseHelper
 
   ScopedRunnableMethodFactory<ClientSocketPoolBaseHelper> method_factory_;
 
+  // Has a task pending while ResumeIdlePriorityRequests() is posted.
+  ScopedRunnableMethodFactory<ClientSocketPoolBaseHelper>
+      resume_idle_priority_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(ClientSocketPoolBaseHelper);
 };
 
@@ -702,6 +802,12 @@ class ClientSocketPoolBase {
     return helper_.CancelRequest(group_name, handle);
   }
 
+  void SetPriority(const std::string& group_name,
+                   ClientSocketHandle* handle,
+                   RequestPriority priority) {
+    return helper_.SetPriority(group_name, handle, priority);
+  }
+
   void ReleaseSocket(const std::string& group_name, ClientSocket* socket,
                      int id) {
     return helper_.ReleaseSocket(group_name, socket, id);
@@ -732,6 +838,10 @@ class ClientSocketPoolBase {
     return helper_.NumActiveSocketsInGroup(group_name);
   }
 
+  int TakePeakActiveSocketCount(const std::string& group_name) {
+    return helper_.TakePeakActiveSocketCount(group_name);
+  }
+
   bool HasGroup(const std::string& group_name) const {
     return helper_.HasGroup(group_name);
   }
@@ -45,7 +45,10 @@ typedef ClientSocketPoolBase<TestSocketParams> TestClientSocketPoolBase;
 
 class MockClientSocket : public ClientSocket {
  public:
-  MockClientSocket() : connected_(false), was_used_to_convey_data_(false) {}
+  MockClientSocket()
+      : connected_(false),
+        was_used_to_convey_data_(false),
+        release_idle_buffers_count_(0) {}
 
   // Socket methods:
   virtual int Read(
@@ -88,11 +91,20 @@ class MockClientSocket : public ClientSocket {
   virtual void SetOmniboxSpeculation() {}
   virtual bool WasEverUsed() const { return was_used_to_convey_data_; }
   virtual bool UsingTCPFastOpen() const { return false; }
+  virtual int ReleaseIdleBuffers() {
+    release_idle_buffers_count_++;
+    return 1024;
+  }
+
+  int release_idle_buffers_count() const {
+    return release_idle_buffers_count_;
+  }
 
  private:
   bool connected_;
   BoundNetLog net_log_;
   bool was_used_to_convey_data_;
+  int release_idle_buffers_count_;
 
   DISALLOW_COPY_AND_ASSIGN(MockClientSocket);
 };
@@ -414,6 +426,13 @@ class TestClientSocketPool : public ClientSocketPool {
     base_.CancelRequest(group_name, handle);
   }
 
+  virtual void SetPriority(
+      const std::string& group_name,
+      ClientSocketHandle* handle,
+      RequestPriority priority) {
+    base_.SetPriority(group_name, handle, priority);
+  }
+
   virtual void ReleaseSocket(
       const std::string& group_name,
       ClientSocket* socket,
@@ -698,6 +717,26 @@ TEST_F(ClientSocketPoolBaseTest, BasicSynchronous) {
       entries, 3, NetLog::TYPE_SOCKET_POOL));
 }
 
+// Sockets are told to release their buffers when they go idle.
+TEST_F(ClientSocketPoolBaseTest, ReleaseIdleBuffers) {
+  CreatePool(kDefaultMaxSockets, kDefaultMaxSocketsPerGroup);
+
+  TestCompletionCallback callback;
+  ClientSocketHandle handle;
+  EXPECT_EQ(OK, handle.Init("a", params_, kDefaultPriority, &callback,
+                            pool_.get(), BoundNetLog()));
+  MockClientSocket* socket = static_cast<MockClientSocket*>(handle.socket());
+  EXPECT_EQ(0, socket->release_idle_buffers_count());
+  handle.Reset();
+  EXPECT_EQ(1, pool_->IdleSocketCount());
+
+  EXPECT_EQ(OK, handle.Init("a", params_, kDefaultPriority, &callback,
+                            pool_.get(), BoundNetLog()));
+  EXPECT_EQ(socket, handle.socket());
+  EXPECT_EQ(1, socket->release_idle_buffers_count());
+  handle.Reset();
+}
+
 TEST_F(ClientSocketPoolBaseTest, InitConnectionFailure) {
   CreatePool(kDefaultMaxSockets, kDefaultMaxSocketsPerGroup);
 
@@ -879,6 +918,32 @@ TEST_F(ClientSocketPoolBaseTest, TotalLimitRespectsGroupLimit) {
   EXPECT_EQ(ClientSocketPoolTest::kIndexOutOfBounds, GetOrderOfRequest(8));
 }
 
+// Stalled groups with requests of equal priority are served in the order in
+// which they started waiting, not in group name order.
+TEST_F(ClientSocketPoolBaseTest, TotalLimitServesStalledGroupsInOrder) {
+  CreatePool(kDefaultMaxSockets, kDefaultMaxSocketsPerGroup);
+
+  EXPECT_EQ(OK, StartRequest("a", kDefaultPriority));
+  EXPECT_EQ(OK, StartRequest("a", kDefaultPriority));
+  EXPECT_EQ(OK, StartRequest("b", kDefaultPriority));
+  EXPECT_EQ(OK, StartRequest("b", kDefaultPriority));
+
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("z", kDefaultPriority));
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("y", kDefaultPriority));
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("x", kDefaultPriority));
+
+  ReleaseAllConnections(ClientSocketPoolTest::NO_KEEP_ALIVE);
+
+  EXPECT_EQ(requests_size() - kDefaultMaxSockets, completion_count());
+
+  EXPECT_EQ(5, GetOrderOfRequest(5));
+  EXPECT_EQ(6, GetOrderOfRequest(6));
+  EXPECT_EQ(7, GetOrderOfRequest(7));
+
+  // Make sure we test order of all requests made.
+  EXPECT_EQ(ClientSocketPoolTest::kIndexOutOfBounds, GetOrderOfRequest(8));
+}
+
 // Make sure that we count connecting sockets against the total limit.
 TEST_F(ClientSocketPoolBaseTest, TotalLimitCountsConnectingSockets) {
   CreatePool(kDefaultMaxSockets, kDefaultMaxSocketsPerGroup);
@@ -1132,9 +1197,9 @@ TEST_F(ClientSocketPoolBaseTest, CloseIdleSocketAtSocketLimitDeleteGroup) {
   ClientSocketHandle handle;
   TestCompletionCallback callback;
 
-  // "0" is special here, since it should be the first entry in the sorted map,
-  // which is the one which we would close an idle socket for.  We shouldn't
-  // close an idle socket though, since we should reuse the idle socket.
+  // "0" is special here, since its idle socket is the oldest one, which is the
+  // one which we would close.  We shouldn't close an idle socket though, since
+  // we should reuse the idle socket.
   EXPECT_EQ(OK, handle.Init("0",
                             params_,
                             kDefaultPriority,
@@ -1146,6 +1211,41 @@ TEST_F(ClientSocketPoolBaseTest, CloseIdleSocketAtSocketLimitDeleteGroup) {
   EXPECT_EQ(kDefaultMaxSockets - 1, pool_->IdleSocketCount());
 }
 
+TEST_F(ClientSocketPoolBaseTest, CloseOldestIdleSocketAtSocketLimit) {
+  CreatePool(kDefaultMaxSockets, kDefaultMaxSocketsPerGroup);
+  connect_job_factory_->set_job_type(TestConnectJob::kMockJob);
+
+  // The idle socket of "d" is the oldest one, then the one of "c", and so on.
+  const char* const kGroups[] = { "d", "c", "b", "a" };
+  for (size_t i = 0; i < arraysize(kGroups); ++i) {
+    ClientSocketHandle handle;
+    TestCompletionCallback callback;
+    EXPECT_EQ(OK, handle.Init(kGroups[i],
+                              params_,
+                              kDefaultPriority,
+                              &callback,
+                              pool_.get(),
+                              BoundNetLog()));
+  }
+
+  // Flush all the DoReleaseSocket tasks.
+  MessageLoop::current()->RunAllPending();
+  EXPECT_EQ(kDefaultMaxSockets, pool_->IdleSocketCount());
+
+  ClientSocketHandle handle;
+  TestCompletionCallback callback;
+  EXPECT_EQ(OK, handle.Init("e",
+                            params_,
+                            kDefaultPriority,
+                            &callback,
+                            pool_.get(),
+                            BoundNetLog()));
+
+  EXPECT_EQ(kDefaultMaxSockets - 1, pool_->IdleSocketCount());
+  EXPECT_FALSE(pool_->HasGroup("d"));
+  EXPECT_EQ(1, pool_->IdleSocketCountInGroup("a"));
+}
+
 TEST_F(ClientSocketPoolBaseTest, PendingRequests) {
   CreatePool(kDefaultMaxSockets, kDefaultMaxSocketsPerGroup);
 
@@ -1285,6 +1385,100 @@ TEST_F(ClientSocketPoolBaseTest, CancelRequest) {
   EXPECT_EQ(ClientSocketPoolTest::kIndexOutOfBounds, GetOrderOfRequest(8));
 }
 
+TEST_F(ClientSocketPoolBaseTest, SetPriority) {
+  CreatePool(kDefaultMaxSockets, kDefaultMaxSocketsPerGroup);
+
+  EXPECT_EQ(OK, StartRequest("a", kDefaultPriority));
+  EXPECT_EQ(OK, StartRequest("a", kDefaultPriority));
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("a", LOWEST));
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("a", MEDIUM));
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("a", LOW));
+
+  // Move the LOWEST request ahead of the others.
+  size_t index_to_raise = kDefaultMaxSocketsPerGroup;
+  EXPECT_FALSE((*requests())[index_to_raise]->handle()->is_initialized());
+  (*requests())[index_to_raise]->handle()->SetPriority(HIGHEST);
+
+  ReleaseAllConnections(ClientSocketPoolTest::KEEP_ALIVE);
+
+  EXPECT_EQ(kDefaultMaxSocketsPerGroup,
+            client_socket_factory_.allocation_count());
+  EXPECT_EQ(requests_size() - kDefaultMaxSocketsPerGroup, completion_count());
+
+  EXPECT_EQ(1, GetOrderOfRequest(1));
+  EXPECT_EQ(2, GetOrderOfRequest(2));
+  EXPECT_EQ(3, GetOrderOfRequest(3));
+  EXPECT_EQ(4, GetOrderOfRequest(4));
+  EXPECT_EQ(5, GetOrderOfRequest(5));
+
+  // Make sure we test order of all requests made.
+  EXPECT_EQ(ClientSocketPoolTest::kIndexOutOfBounds, GetOrderOfRequest(6));
+}
+
+// An IDLE request doesn't start while a request of another group waits.
+TEST_F(ClientSocketPoolBaseTest, IdlePriorityWaitsForOtherRequests) {
+  CreatePool(kDefaultMaxSockets, kDefaultMaxSocketsPerGroup);
+  connect_job_factory_->set_job_type(TestConnectJob::kMockWaitingJob);
+
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("a", LOWEST));
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("b", IDLE));
+  EXPECT_EQ(1, pool_->NumConnectJobsInGroup("a"));
+  EXPECT_EQ(0, pool_->NumConnectJobsInGroup("b"));
+
+  // Once nothing else waits, the IDLE request starts.
+  client_socket_factory_.SignalJobs();
+  EXPECT_EQ(OK, request(0)->WaitForResult());
+  MessageLoop::current()->RunAllPending();
+  EXPECT_EQ(1, pool_->NumConnectJobsInGroup("b"));
+
+  client_socket_factory_.SignalJobs();
+  EXPECT_EQ(OK, request(1)->WaitForResult());
+  EXPECT_EQ(1, GetOrderOfRequest(1));
+  EXPECT_EQ(2, GetOrderOfRequest(2));
+}
+
+// Raising the priority of a held back IDLE request starts it.
+TEST_F(ClientSocketPoolBaseTest, IdlePrioritySetPriority) {
+  CreatePool(kDefaultMaxSockets, kDefaultMaxSocketsPerGroup);
+  connect_job_factory_->set_job_type(TestConnectJob::kMockWaitingJob);
+
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("a", LOWEST));
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("b", IDLE));
+  EXPECT_EQ(0, pool_->NumConnectJobsInGroup("b"));
+
+  request(1)->handle()->SetPriority(LOWEST);
+  EXPECT_EQ(1, pool_->NumConnectJobsInGroup("b"));
+
+  client_socket_factory_.SignalJobs();
+  EXPECT_EQ(OK, request(0)->WaitForResult());
+  EXPECT_EQ(OK, request(1)->WaitForResult());
+}
+
+// At the socket limit, a request of a higher priority takes the slot of a
+// connect job that only IDLE requests wait for.
+TEST_F(ClientSocketPoolBaseTest, IdlePriorityYieldsConnectJobAtSocketLimit) {
+  CreatePool(kDefaultMaxSockets, kDefaultMaxSocketsPerGroup);
+  connect_job_factory_->set_job_type(TestConnectJob::kMockPendingJob);
+
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("a", IDLE));
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("a", IDLE));
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("b", IDLE));
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("b", IDLE));
+  EXPECT_EQ(2, pool_->NumConnectJobsInGroup("a"));
+  EXPECT_EQ(2, pool_->NumConnectJobsInGroup("b"));
+
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("c", LOWEST));
+  EXPECT_EQ(1, pool_->NumConnectJobsInGroup("c"));
+  EXPECT_EQ(2, pool_->NumConnectJobsInGroup("a"));
+  EXPECT_EQ(1, pool_->NumConnectJobsInGroup("b"));
+  EXPECT_EQ(OK, request(4)->WaitForResult());
+
+  // The IDLE request that lost its job gets a slot back once a socket is
+  // released.
+  EXPECT_TRUE(ReleaseOneConnection(ClientSocketPoolTest::NO_KEEP_ALIVE));
+  EXPECT_EQ(OK, request(3)->WaitForResult());
+}
+
 class RequestSocketCallback : public CallbackRunner< Tuple1<int> > {
  public:
   RequestSocketCallback(ClientSocketHandle* handle,
@@ -3143,8 +3337,8 @@ TEST_F(ClientSocketPoolBaseTest, PreconnectClosesIdleSocketRemovesGroup) {
   CreatePool(kMaxTotalSockets, kMaxSocketsPerGroup);
   connect_job_factory_->set_job_type(TestConnectJob::kMockPendingJob);
 
-  // Note that group name ordering matters here.  "a" comes before "b", so
-  // CloseOneIdleSocket() will try to close "a"'s idle socket.
+  // Note that idle socket age matters here.  "a"'s idle socket is the oldest
+  // one, so CloseOneIdleSocket() will try to close it.
 
   // Set up one idle socket in "a".
   ClientSocketHandle handle1;
@@ -9,6 +9,7 @@
 #include "base/metrics/field_trial.h"
 #include "base/metrics/histogram.h"
 #include "net/socket/client_socket_handle.h"
+#include "net/socket/tcp_info.h"
 
 namespace net {
 
@@ -41,6 +42,26 @@ ClientSocketPoolHistograms::ClientSocketPoolHistograms(
       base::TimeDelta::FromMilliseconds(1),
       base::TimeDelta::FromMinutes(6),
       100, Histogram::kUmaTargetedHistogramFlag);
+  // UMA_HISTOGRAM_CUSTOM_TIMES
+  tcp_rtt_ = Histogram::FactoryTimeGet(
+      "Net.TcpRtt_" + pool_name,
+      base::TimeDelta::FromMilliseconds(1),
+      base::TimeDelta::FromMinutes(1),
+      100, Histogram::kUmaTargetedHistogramFlag);
+  // UMA_HISTOGRAM_CUSTOM_TIMES
+  tcp_rtt_variance_ = Histogram::FactoryTimeGet(
+      "Net.TcpRttVariance_" + pool_name,
+      base::TimeDelta::FromMilliseconds(1),
+      base::TimeDelta::FromMinutes(1),
+      100, Histogram::kUmaTargetedHistogramFlag);
+  // UMA_HISTOGRAM_CUSTOM_COUNTS
+  tcp_congestion_window_ = Histogram::FactoryGet(
+      "Net.TcpCongestionWindow_" + pool_name, 1, 1000, 50,
+      Histogram::kUmaTargetedHistogramFlag);
+  // UMA_HISTOGRAM_CUSTOM_COUNTS
+  tcp_retransmits_ = Histogram::FactoryGet(
+      "Net.TcpRetransmits_" + pool_name, 1, 1000, 50,
+      Histogram::kUmaTargetedHistogramFlag);
 
   if (pool_name == "HTTPProxy")
     is_http_proxy_connection_ = true;
@@ -88,4 +109,11 @@ void ClientSocketPoolHistograms::AddReusedIdleTime(base::TimeDelta time) const {
   reused_idle_time_->AddTime(time);
 }
 
+void ClientSocketPoolHistograms::AddTCPInfo(const TCPInfo& info) const {
+  tcp_rtt_->AddTime(info.rtt);
+  tcp_rtt_variance_->AddTime(info.rtt_variance);
+  tcp_congestion_window_->Add(info.congestion_window);
+  tcp_retransmits_->Add(info.total_retransmits);
+}
+
 }  // namespace net
@@ -17,6 +17,8 @@ class Histogram;
 
 namespace net {
 
+struct TCPInfo;
+
 class ClientSocketPoolHistograms {
  public:
   ClientSocketPoolHistograms(const std::string& pool_name);
@@ -26,12 +28,17 @@ class ClientSocketPoolHistograms {
   void AddRequestTime(base::TimeDelta time) const;
   void AddUnusedIdleTime(base::TimeDelta time) const;
   void AddReusedIdleTime(base::TimeDelta time) const;
+  void AddTCPInfo(const TCPInfo& info) const;
 
  private:
   base::Histogram* socket_type_;
   base::Histogram* request_time_;
   base::Histogram* unused_idle_time_;
   base::Histogram* reused_idle_time_;
+  base::Histogram* tcp_rtt_;
+  base::Histogram* tcp_rtt_variance_;
+  base::Histogram* tcp_congestion_window_;
+  base::Histogram* tcp_retransmits_;
 
   bool is_http_proxy_connection_;
   bool is_socks_connection_;
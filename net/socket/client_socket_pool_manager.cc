@@ -56,6 +56,16 @@ static void AddSocketPoolsToList(ListValue* list,
   }
 }
 
+// Returns the name of the group that holds the connections to |origin|.
+std::string GetConnectionGroupName(const HostPortPair& origin,
+                                   bool using_ssl) {
+  std::string connection_group = origin.ToString();
+  DCHECK(!connection_group.empty());
+  if (using_ssl)
+    connection_group = base::StringPrintf("ssl/%s", connection_group.c_str());
+  return connection_group;
+}
+
 // The meat of the implementation for the InitSocketHandleForHttpRequest,
 // InitSocketHandleForRawConnect and PreconnectSocketsForHttpRequest methods.
 int InitSocketPoolHelper(const HttpRequestInfo& request_info,
@@ -92,10 +102,8 @@ int InitSocketPoolHelper(const HttpRequestInfo& request_info,
 
   // Build the string used to uniquely identify connections of this type.
   // Determine the host and port to connect to.
-  std::string connection_group = origin_host_port.ToString();
-  DCHECK(!connection_group.empty());
-  if (using_ssl)
-    connection_group = base::StringPrintf("ssl/%s", connection_group.c_str());
+  std::string connection_group =
+      GetConnectionGroupName(origin_host_port, using_ssl);
 
   bool ignore_limits = (request_info.load_flags & LOAD_IGNORE_LIMITS) != 0;
   if (proxy_info.is_direct()) {
@@ -398,6 +406,18 @@ void ClientSocketPoolManager::CloseIdleSockets() {
   transport_socket_pool_->CloseIdleSockets();
 }
 
+void ClientSocketPoolManager::ClearSSLSessionCache() {
+  socket_factory_->ClearSSLSessionCache();
+}
+
+int ClientSocketPoolManager::TakePeakSocketCount(const HostPortPair& origin,
+                                                 bool using_ssl) {
+  std::string group_name = GetConnectionGroupName(origin, using_ssl);
+  if (using_ssl)
+    return ssl_socket_pool_->TakePeakActiveSocketCount(group_name);
+  return transport_socket_pool_->TakePeakActiveSocketCount(group_name);
+}
+
 SOCKSClientSocketPool* ClientSocketPoolManager::GetSocketPoolForSOCKSProxy(
     const HostPortPair& socks_proxy) {
   SOCKSSocketPoolMap::const_iterator it = socks_socket_pools_.find(socks_proxy);
@@ -83,6 +83,15 @@ class ClientSocketPoolManager : public base::NonThreadSafe,
   void FlushSocketPools();
   void CloseIdleSockets();
 
+  // Drops the SSL sessions that new connections could resume. The session
+  // cache is shared by the whole process.
+  void ClearSSLSessionCache();
+
+  // Returns the largest number of sockets that were in use at the same time
+  // for direct connections to |origin| since the last call, and starts a new
+  // measurement.  Returns 0 if there is no such group.
+  int TakePeakSocketCount(const HostPortPair& origin, bool using_ssl);
+
   TransportClientSocketPool* transport_socket_pool() {
     return transport_socket_pool_.get();
   }
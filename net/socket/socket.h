@@ -6,7 +6,10 @@
 #define NET_SOCKET_SOCKET_H_
 #pragma once
 
+#include "base/basictypes.h"
+#include "base/platform_file.h"
 #include "net/base/completion_callback.h"
+#include "net/base/net_errors.h"
 
 namespace net {
 
@@ -46,6 +49,31 @@ class Socket {
   virtual int Write(IOBuffer* buf, int buf_len,
                     CompletionCallback* callback) = 0;
 
+  // Writes data from the |num_bufs| buffers of |bufs|, in order, with a single
+  // operation if the socket supports it. |buf_lens| holds the number of bytes
+  // to write from each buffer. As with Write(), only part of the data may be
+  // written, and the return value is the number of bytes written (starting
+  // with the first buffer) or an error code. The default implementation only
+  // writes from the first buffer.
+  virtual int Writev(IOBuffer* const* bufs, const int* buf_lens, int num_bufs,
+                     CompletionCallback* callback) {
+    return Write(bufs[0], buf_lens[0], callback);
+  }
+
+  // Returns true if SendFile() can be used on this socket.
+  virtual bool SupportsSendFile() const { return false; }
+
+  // Writes up to |len| bytes of |file|, starting at |offset|, straight from
+  // the file to the socket, without going through a buffer. The file position
+  // is not changed. As with Write(), only part of the data may be written,
+  // and the return value is the number of bytes written or an error code.
+  // Zero is returned at the end of the file. ERR_NOT_IMPLEMENTED is returned
+  // if the data can't be sent this way; the caller should then use Write().
+  virtual int SendFile(base::PlatformFile file, int64 offset, int len,
+                       CompletionCallback* callback) {
+    return ERR_NOT_IMPLEMENTED;
+  }
+
   // Set the receive buffer size (in bytes) for the socket.
   // Note: changing this value can effect the TCP window size on some platforms.
   // Returns true on success, or false on failure.
@@ -24,6 +24,9 @@ const uint8 SOCKS5ClientSocket::kSOCKS5Version = 0x05;
 const uint8 SOCKS5ClientSocket::kTunnelCommand = 0x01;
 const uint8 SOCKS5ClientSocket::kNullByte = 0x00;
 
+// static
+bool SOCKS5ClientSocket::use_pipelined_handshake_ = false;
+
 COMPILE_ASSERT(sizeof(struct in_addr) == 4, incorrect_system_size_of_IPv4);
 COMPILE_ASSERT(sizeof(struct in6_addr) == 16, incorrect_system_size_of_IPv6);
 
@@ -35,6 +38,10 @@ SOCKS5ClientSocket::SOCKS5ClientSocket(
       transport_(transport_socket),
       next_state_(STATE_NONE),
       user_callback_(NULL),
+      pipelined_(false),
+      replies_pending_(false),
+      user_read_buf_len_(0),
+      user_read_callback_(NULL),
       completed_handshake_(false),
       bytes_sent_(0),
       bytes_received_(0),
@@ -51,6 +58,10 @@ SOCKS5ClientSocket::SOCKS5ClientSocket(
       transport_(new ClientSocketHandle()),
       next_state_(STATE_NONE),
       user_callback_(NULL),
+      pipelined_(false),
+      replies_pending_(false),
+      user_read_buf_len_(0),
+      user_read_callback_(NULL),
       completed_handshake_(false),
       bytes_sent_(0),
       bytes_received_(0),
@@ -87,6 +98,8 @@ int SOCKS5ClientSocket::Connect(CompletionCallback* callback
 
   next_state_ = STATE_GREET_WRITE;
   buffer_.clear();
+  pipelined_ = use_pipelined_handshake_;
+  replies_pending_ = false;
 
   int rv = DoLoop(OK);
   if (rv == ERR_IO_PENDING) {
@@ -105,6 +118,10 @@ void SOCKS5ClientSocket::Disconnect() {
   // These are the states initialized by Connect().
   next_state_ = STATE_NONE;
   user_callback_ = NULL;
+  replies_pending_ = false;
+  user_read_buf_ = NULL;
+  user_read_buf_len_ = 0;
+  user_read_callback_ = NULL;
 }
 
 bool SOCKS5ClientSocket::IsConnected() const {
@@ -151,6 +168,12 @@ bool SOCKS5ClientSocket::UsingTCPFastOpen() const {
   return false;
 }
 
+bool SOCKS5ClientSocket::GetTCPInfo(TCPInfo* info) const {
+  if (transport_.get() && transport_->socket())
+    return transport_->socket()->GetTCPInfo(info);
+  return false;
+}
+
 // Read is called by the transport layer above to read. This can only be done
 // if the SOCKS handshake is complete.
 int SOCKS5ClientSocket::Read(IOBuffer* buf, int buf_len,
@@ -158,6 +181,22 @@ int SOCKS5ClientSocket::Read(IOBuffer* buf, int buf_len,
   DCHECK(completed_handshake_);
   DCHECK_EQ(STATE_NONE, next_state_);
   DCHECK(!user_callback_);
+  DCHECK(!user_read_callback_);
+
+  if (replies_pending_) {
+    // Read the replies to the pipelined greeting and CONNECT request first.
+    user_read_buf_ = buf;
+    user_read_buf_len_ = buf_len;
+    buffer_.clear();
+    bytes_received_ = 0;
+    next_state_ = STATE_GREET_READ;
+    int rv = DoLoop(OK);
+    if (rv == ERR_IO_PENDING) {
+      user_read_callback_ = callback;
+      return rv;
+    }
+    return DidReadReplies(rv, callback);
+  }
 
   return transport_->socket()->Read(buf, buf_len, callback);
 }
@@ -173,6 +212,28 @@ int SOCKS5ClientSocket::Write(IOBuffer* buf, int buf_len,
   return transport_->socket()->Write(buf, buf_len, callback);
 }
 
+int SOCKS5ClientSocket::Writev(IOBuffer* const* bufs, const int* buf_lens,
+                               int num_bufs, CompletionCallback* callback) {
+  DCHECK(completed_handshake_);
+  DCHECK_EQ(STATE_NONE, next_state_);
+  DCHECK(!user_callback_);
+
+  return transport_->socket()->Writev(bufs, buf_lens, num_bufs, callback);
+}
+
+bool SOCKS5ClientSocket::SupportsSendFile() const {
+  return transport_->socket()->SupportsSendFile();
+}
+
+int SOCKS5ClientSocket::SendFile(base::PlatformFile file, int64 offset,
+                                 int len, CompletionCallback* callback) {
+  DCHECK(completed_handshake_);
+  DCHECK_EQ(STATE_NONE, next_state_);
+  DCHECK(!user_callback_);
+
+  return transport_->socket()->SendFile(file, offset, len, callback);
+}
+
 bool SOCKS5ClientSocket::SetReceiveBufferSize(int32 size) {
   return transport_->socket()->SetReceiveBufferSize(size);
 }
@@ -192,9 +253,30 @@ void SOCKS5ClientSocket::DoCallback(int result) {
   c->Run(result);
 }
 
+int SOCKS5ClientSocket::DidReadReplies(int result,
+                                       CompletionCallback* callback) {
+  DCHECK(replies_pending_);
+  replies_pending_ = false;
+  scoped_refptr<IOBuffer> buf;
+  buf.swap(user_read_buf_);
+  if (result != OK) {
+    completed_handshake_ = false;
+    return result;
+  }
+  return transport_->socket()->Read(buf, user_read_buf_len_, callback);
+}
+
 void SOCKS5ClientSocket::OnIOComplete(int result) {
   DCHECK_NE(STATE_NONE, next_state_);
   int rv = DoLoop(result);
+  if (rv != ERR_IO_PENDING && replies_pending_) {
+    CompletionCallback* c = user_read_callback_;
+    user_read_callback_ = NULL;
+    rv = DidReadReplies(rv, c);
+    if (rv != ERR_IO_PENDING)
+      c->Run(rv);
+    return;
+  }
   if (rv != ERR_IO_PENDING) {
     net_log_.EndEvent(NetLog::TYPE_SOCKS5_CONNECT, NULL);
     DoCallback(rv);
@@ -269,6 +351,13 @@ int SOCKS5ClientSocket::DoGreetWrite() {
   if (buffer_.empty()) {
     buffer_ = std::string(kSOCKS5GreetWriteData,
                           arraysize(kSOCKS5GreetWriteData));
+    if (pipelined_) {
+      std::string handshake;
+      int rv = BuildHandshakeWriteBuffer(&handshake);
+      if (rv != OK)
+        return rv;
+      buffer_.append(handshake);
+    }
     bytes_sent_ = 0;
   }
 
@@ -286,7 +375,12 @@ int SOCKS5ClientSocket::DoGreetWriteComplete(int result) {
     return result;
 
   bytes_sent_ += result;
-  if (bytes_sent_ == buffer_.size()) {
+  if (bytes_sent_ == buffer_.size() && pipelined_) {
+    // The replies are read by the first Read().
+    buffer_.clear();
+    completed_handshake_ = true;
+    replies_pending_ = true;
+  } else if (bytes_sent_ == buffer_.size()) {
     buffer_.clear();
     bytes_received_ = 0;
     next_state_ = STATE_GREET_READ;
@@ -336,7 +430,8 @@ int SOCKS5ClientSocket::DoGreetReadComplete(int result) {
   }
 
   buffer_.clear();
-  next_state_ = STATE_HANDSHAKE_WRITE;
+  // A pipelined CONNECT request has already been sent.
+  next_state_ = pipelined_ ? STATE_HANDSHAKE_READ : STATE_HANDSHAKE_WRITE;
   return OK;
 }
 
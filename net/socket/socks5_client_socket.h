@@ -48,6 +48,18 @@ class SOCKS5ClientSocket : public ClientSocket {
   // On destruction Disconnect() is called.
   virtual ~SOCKS5ClientSocket();
 
+  // Enables or disables the pipelined handshake.  Since no authentication is
+  // used, the greeting and the CONNECT request are then sent together, and
+  // Connect() completes as soon as they are written.  The replies of the
+  // proxy are read and checked, in order, by the first Read(), so the first
+  // Write() (typically a TLS ClientHello) leaves without waiting for them.
+  // A proxy that refuses the connection makes that Read() fail with
+  // ERR_SOCKS_CONNECTION_FAILED.
+  static void set_pipelined_handshake(bool enable) {
+    use_pipelined_handshake_ = enable;
+  }
+  static bool pipelined_handshake() { return use_pipelined_handshake_; }
+
   // ClientSocket methods:
 
   // Does the SOCKS handshake and completes the protocol.
@@ -66,10 +78,16 @@ class SOCKS5ClientSocket : public ClientSocket {
   virtual void SetOmniboxSpeculation();
   virtual bool WasEverUsed() const;
   virtual bool UsingTCPFastOpen() const;
+  virtual bool GetTCPInfo(TCPInfo* info) const;
 
   // Socket methods:
   virtual int Read(IOBuffer* buf, int buf_len, CompletionCallback* callback);
   virtual int Write(IOBuffer* buf, int buf_len, CompletionCallback* callback);
+  virtual int Writev(IOBuffer* const* bufs, const int* buf_lens, int num_bufs,
+                     CompletionCallback* callback);
+  virtual bool SupportsSendFile() const;
+  virtual int SendFile(base::PlatformFile file, int64 offset, int len,
+                       CompletionCallback* callback);
 
   virtual bool SetReceiveBufferSize(int32 size);
   virtual bool SetSendBufferSize(int32 size);
@@ -107,6 +125,10 @@ class SOCKS5ClientSocket : public ClientSocket {
   void DoCallback(int result);
   void OnIOComplete(int result);
 
+  // Completes the read that was held back by the replies of a pipelined
+  // handshake.  |result| is the result of reading the replies.
+  int DidReadReplies(int result, CompletionCallback* callback);
+
   int DoLoop(int last_io_result);
   int DoHandshakeRead();
   int DoHandshakeReadComplete(int result);
@@ -131,6 +153,19 @@ class SOCKS5ClientSocket : public ClientSocket {
   // Stores the callback to the layer above, called on completing Connect().
   CompletionCallback* user_callback_;
 
+  // True when the current handshake is pipelined; see
+  // set_pipelined_handshake().
+  bool pipelined_;
+
+  // Set while the replies of a pipelined handshake haven't been read yet.
+  bool replies_pending_;
+
+  // The first Read() of a pipelined handshake, held while the replies are
+  // being read.
+  scoped_refptr<IOBuffer> user_read_buf_;
+  int user_read_buf_len_;
+  CompletionCallback* user_read_callback_;
+
   // This IOBuffer is used by the class to read and write
   // SOCKS handshake data. The length contains the expected size to
   // read or write.
@@ -154,6 +189,8 @@ class SOCKS5ClientSocket : public ClientSocket {
 
   BoundNetLog net_log_;
 
+  static bool use_pipelined_handshake_;
+
   DISALLOW_COPY_AND_ASSIGN(SOCKS5ClientSocket);
 };
 
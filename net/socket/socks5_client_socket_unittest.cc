@@ -165,6 +165,101 @@ TEST_F(SOCKS5ClientSocketTest, CompleteHandshake) {
   EXPECT_FALSE(user_sock_->IsConnected());
 }
 
+// Tests a pipelined handshake: the greeting, the CONNECT request and the
+// first write go out together, and the first read checks the replies.
+TEST_F(SOCKS5ClientSocketTest, PipelinedHandshake) {
+  const std::string payload_write = "random data";
+  const std::string payload_read = "moar random data";
+
+  const char kOkRequest[] = {
+    0x05,  // Version
+    0x01,  // Command (CONNECT)
+    0x00,  // Reserved.
+    0x03,  // Address type (DOMAINNAME).
+    0x09,  // Length of domain (9)
+    // Domain string:
+    'l', 'o', 'c', 'a', 'l', 'h', 'o', 's', 't',
+    0x00, 0x50,  // 16-bit port (80)
+  };
+  std::string request(kSOCKS5GreetRequest, kSOCKS5GreetRequestLength);
+  request.append(kOkRequest, arraysize(kOkRequest));
+
+  MockWrite data_writes[] = {
+      MockWrite(true, request.data(), request.size()),
+      MockWrite(true, payload_write.data(), payload_write.size()) };
+  MockRead data_reads[] = {
+      MockRead(true, kSOCKS5GreetResponse, kSOCKS5GreetResponseLength),
+      MockRead(true, kSOCKS5OkResponse, kSOCKS5OkResponseLength),
+      MockRead(true, payload_read.data(), payload_read.size()) };
+
+  SOCKS5ClientSocket::set_pipelined_handshake(true);
+  user_sock_.reset(BuildMockSocket(data_reads, arraysize(data_reads),
+                                   data_writes, arraysize(data_writes),
+                                   "localhost", 80, &net_log_));
+
+  int rv = user_sock_->Connect(&callback_);
+  SOCKS5ClientSocket::set_pipelined_handshake(false);
+  EXPECT_EQ(OK, callback_.GetResult(rv));
+  EXPECT_TRUE(user_sock_->IsConnected());
+
+  scoped_refptr<IOBuffer> buffer(new IOBuffer(payload_write.size()));
+  memcpy(buffer->data(), payload_write.data(), payload_write.size());
+  rv = user_sock_->Write(buffer, payload_write.size(), &callback_);
+  EXPECT_EQ(static_cast<int>(payload_write.size()), callback_.GetResult(rv));
+
+  buffer = new IOBuffer(payload_read.size());
+  rv = user_sock_->Read(buffer, payload_read.size(), &callback_);
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  rv = callback_.WaitForResult();
+  EXPECT_EQ(static_cast<int>(payload_read.size()), rv);
+  EXPECT_EQ(payload_read, std::string(buffer->data(), payload_read.size()));
+  EXPECT_TRUE(user_sock_->IsConnected());
+}
+
+// Tests that the first read fails when the proxy rejects a pipelined CONNECT
+// request.
+TEST_F(SOCKS5ClientSocketTest, PipelinedHandshakeFailure) {
+  const char kOkRequest[] = {
+    0x05,  // Version
+    0x01,  // Command (CONNECT)
+    0x00,  // Reserved.
+    0x03,  // Address type (DOMAINNAME).
+    0x09,  // Length of domain (9)
+    // Domain string:
+    'l', 'o', 'c', 'a', 'l', 'h', 'o', 's', 't',
+    0x00, 0x50,  // 16-bit port (80)
+  };
+  const char kFailedResponse[] = {
+    0x05,  // Version
+    0x05,  // Reply (connection refused)
+    0x00,  // Reserved.
+    0x01,  // Address type (IPv4).
+    127, 0, 0, 1,
+    0x00, 0x50,  // 16-bit port (80)
+  };
+  std::string request(kSOCKS5GreetRequest, kSOCKS5GreetRequestLength);
+  request.append(kOkRequest, arraysize(kOkRequest));
+
+  MockWrite data_writes[] = {
+      MockWrite(false, request.data(), request.size()) };
+  MockRead data_reads[] = {
+      MockRead(false, kSOCKS5GreetResponse, kSOCKS5GreetResponseLength),
+      MockRead(false, kFailedResponse, arraysize(kFailedResponse)) };
+
+  SOCKS5ClientSocket::set_pipelined_handshake(true);
+  user_sock_.reset(BuildMockSocket(data_reads, arraysize(data_reads),
+                                   data_writes, arraysize(data_writes),
+                                   "localhost", 80, NULL));
+  int rv = user_sock_->Connect(&callback_);
+  SOCKS5ClientSocket::set_pipelined_handshake(false);
+  EXPECT_EQ(OK, rv);
+
+  scoped_refptr<IOBuffer> buffer(new IOBuffer(10));
+  rv = user_sock_->Read(buffer, 10, &callback_);
+  EXPECT_EQ(ERR_SOCKS_CONNECTION_FAILED, rv);
+  EXPECT_FALSE(user_sock_->IsConnected());
+}
+
 // Test that you can call Connect() again after having called Disconnect().
 TEST_F(SOCKS5ClientSocketTest, ConnectAndDisconnectTwice) {
   const std::string hostname = "my-host-name";
@@ -178,6 +178,12 @@ bool SOCKSClientSocket::UsingTCPFastOpen() const {
   return false;
 }
 
+bool SOCKSClientSocket::GetTCPInfo(TCPInfo* info) const {
+  if (transport_.get() && transport_->socket())
+    return transport_->socket()->GetTCPInfo(info);
+  return false;
+}
+
 
 // Read is called by the transport layer above to read. This can only be done
 // if the SOCKS handshake is complete.
@@ -201,6 +207,28 @@ int SOCKSClientSocket::Write(IOBuffer* buf, int buf_len,
   return transport_->socket()->Write(buf, buf_len, callback);
 }
 
+int SOCKSClientSocket::Writev(IOBuffer* const* bufs, const int* buf_lens,
+                              int num_bufs, CompletionCallback* callback) {
+  DCHECK(completed_handshake_);
+  DCHECK_EQ(STATE_NONE, next_state_);
+  DCHECK(!user_callback_);
+
+  return transport_->socket()->Writev(bufs, buf_lens, num_bufs, callback);
+}
+
+bool SOCKSClientSocket::SupportsSendFile() const {
+  return transport_->socket()->SupportsSendFile();
+}
+
+int SOCKSClientSocket::SendFile(base::PlatformFile file, int64 offset,
+                                int len, CompletionCallback* callback) {
+  DCHECK(completed_handshake_);
+  DCHECK_EQ(STATE_NONE, next_state_);
+  DCHECK(!user_callback_);
+
+  return transport_->socket()->SendFile(file, offset, len, callback);
+}
+
 bool SOCKSClientSocket::SetReceiveBufferSize(int32 size) {
   return transport_->socket()->SetReceiveBufferSize(size);
 }
@@ -157,6 +157,7 @@ int SOCKSConnectJob::DoTransportConnectComplete(int result) {
 
 int SOCKSConnectJob::DoSOCKSConnect() {
   next_state_ = STATE_SOCKS_CONNECT_COMPLETE;
+  connect_timing_ = transport_socket_handle_->connect_timing();
 
   // Add a SOCKS connection on top of the tcp socket.
   if (socks_params_->is_socks_v5()) {
@@ -264,6 +265,12 @@ void SOCKSClientSocketPool::CancelRequest(const std::string& group_name,
   base_.CancelRequest(group_name, handle);
 }
 
+void SOCKSClientSocketPool::SetPriority(const std::string& group_name,
+                                        ClientSocketHandle* handle,
+                                        RequestPriority priority) {
+  base_.SetPriority(group_name, handle, priority);
+}
+
 void SOCKSClientSocketPool::ReleaseSocket(const std::string& group_name,
                                           ClientSocket* socket, int id) {
   base_.ReleaseSocket(group_name, socket, id);
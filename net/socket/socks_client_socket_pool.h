@@ -137,6 +137,10 @@ class SOCKSClientSocketPool : public ClientSocketPool {
   virtual void CancelRequest(const std::string& group_name,
                              ClientSocketHandle* handle);
 
+  virtual void SetPriority(const std::string& group_name,
+                           ClientSocketHandle* handle,
+                           RequestPriority priority);
+
   virtual void ReleaseSocket(const std::string& group_name,
                              ClientSocket* socket,
                              int id);
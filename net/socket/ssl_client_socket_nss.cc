@@ -763,6 +763,24 @@ bool SSLClientSocketNSS::UsingTCPFastOpen() const {
   return false;
 }
 
+bool SSLClientSocketNSS::GetTCPInfo(TCPInfo* info) const {
+  if (transport_.get() && transport_->socket())
+    return transport_->socket()->GetTCPInfo(info);
+  return false;
+}
+
+int SSLClientSocketNSS::ReleaseIdleBuffers() {
+  // The memio buffers can only go while no data is on its way through them.
+  if (!nss_bufs_ || !completed_handshake_ || transport_send_busy_ ||
+      transport_recv_busy_ || user_read_callback_ || user_write_callback_) {
+    return 0;
+  }
+  int released = memio_ReleaseBuffers(nss_bufs_);
+  if (transport_.get() && transport_->socket())
+    released += transport_->socket()->ReleaseIdleBuffers();
+  return released;
+}
+
 int SSLClientSocketNSS::Read(IOBuffer* buf, int buf_len,
                              CompletionCallback* callback) {
   EnterFunction(buf_len);
@@ -80,6 +80,8 @@ class SSLClientSocketNSS : public SSLClientSocket {
   virtual void SetOmniboxSpeculation();
   virtual bool WasEverUsed() const;
   virtual bool UsingTCPFastOpen() const;
+  virtual bool GetTCPInfo(TCPInfo* info) const;
+  virtual int ReleaseIdleBuffers();
 
   // Socket methods:
   virtual int Read(IOBuffer* buf, int buf_len, CompletionCallback* callback);
@@ -7,6 +7,7 @@
 
 #include "net/socket/ssl_client_socket_openssl.h"
 
+#include <limits.h>
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 #ifdef ANDROID
@@ -15,6 +16,8 @@
 
 #include "base/memory/singleton.h"
 #include "base/metrics/histogram.h"
+#include "base/stl_util-inl.h"
+#include "base/string_number_conversions.h"
 #include "base/synchronization/lock.h"
 #include "crypto/openssl_util.h"
 #include "net/base/cert_verifier.h"
@@ -24,6 +27,7 @@
 #include "net/base/ssl_connection_status_flags.h"
 #include "net/base/ssl_info.h"
 #include "net/socket/ssl_error_params.h"
+#include "net/socket/ssl_host_info.h"
 
 namespace net {
 
@@ -41,6 +45,8 @@ namespace {
 const size_t kMaxRecvBufferSize = 4096;
 const int kSessionCacheTimeoutSeconds = 60 * 60;
 const size_t kSessionCacheMaxEntires = 1024;
+// Larger sessions (e.g. with big tickets) are not saved in the SSLHostInfo.
+const int kMaxPersistedSessionSize = 4 * 1024;
 
 #if OPENSSL_VERSION_NUMBER < 0x1000100fL
 // This method was first included in OpenSSL 1.0.1.
@@ -203,31 +209,31 @@ int NoOpVerifyCallback(X509_STORE_CTX*, void *) {
 
 // OpenSSL manages a cache of SSL_SESSION, this class provides the application
 // side policy for that cache about session re-use: we retain one session per
-// unique HostPortPair.
+// unique session cache key, see SSLClientSocketOpenSSL::GetSessionCacheKey().
 class SSLSessionCache {
  public:
   SSLSessionCache() {}
 
-  void OnSessionAdded(const HostPortPair& host_and_port, SSL_SESSION* session) {
+  void OnSessionAdded(const std::string& cache_key, SSL_SESSION* session) {
     // Declare the session cleaner-upper before the lock, so any call into
     // OpenSSL to free the session will happen after the lock is released.
     crypto::ScopedOpenSSL<SSL_SESSION, SSL_SESSION_free> session_to_free;
     base::AutoLock lock(lock_);
 
     DCHECK_EQ(0U, session_map_.count(session));
-    std::pair<HostPortMap::iterator, bool> res =
-        host_port_map_.insert(std::make_pair(host_and_port, session));
+    std::pair<KeyMap::iterator, bool> res =
+        key_map_.insert(std::make_pair(cache_key, session));
     if (!res.second) {  // Already exists: replace old entry.
       session_to_free.reset(res.first->second);
       session_map_.erase(session_to_free.get());
       res.first->second = session;
     }
     DVLOG(2) << "Adding session " << session << " => "
-             << host_and_port.ToString() << ", new entry = " << res.second;
-    DCHECK(host_port_map_[host_and_port] == session);
+             << cache_key << ", new entry = " << res.second;
+    DCHECK(key_map_[cache_key] == session);
     session_map_[session] = res.first;
-    DCHECK_EQ(host_port_map_.size(), session_map_.size());
-    DCHECK_LE(host_port_map_.size(), kSessionCacheMaxEntires);
+    DCHECK_EQ(key_map_.size(), session_map_.size());
+    DCHECK_LE(key_map_.size(), kSessionCacheMaxEntires);
   }
 
   void OnSessionRemoved(SSL_SESSION* session) {
@@ -239,24 +245,22 @@ class SSLSessionCache {
     SessionMap::iterator it = session_map_.find(session);
     if (it == session_map_.end())
       return;
-    DVLOG(2) << "Remove session " << session << " => "
-             << it->second->first.ToString();
+    DVLOG(2) << "Remove session " << session << " => " << it->second->first;
     DCHECK(it->second->second == session);
-    host_port_map_.erase(it->second);
+    key_map_.erase(it->second);
     session_map_.erase(it);
     session_to_free.reset(session);
-    DCHECK_EQ(host_port_map_.size(), session_map_.size());
+    DCHECK_EQ(key_map_.size(), session_map_.size());
   }
 
-  // Looks up the host:port in the cache, and if a session is found it is added
+  // Looks up |cache_key| in the cache, and if a session is found it is added
   // to |ssl|, returning true on success.
-  bool SetSSLSession(SSL* ssl, const HostPortPair& host_and_port) {
+  bool SetSSLSession(SSL* ssl, const std::string& cache_key) {
     base::AutoLock lock(lock_);
-    HostPortMap::iterator it = host_port_map_.find(host_and_port);
-    if (it == host_port_map_.end())
+    KeyMap::iterator it = key_map_.find(cache_key);
+    if (it == key_map_.end())
       return false;
-    DVLOG(2) << "Lookup session: " << it->second << " => "
-             << host_and_port.ToString();
+    DVLOG(2) << "Lookup session: " << it->second << " => " << cache_key;
     SSL_SESSION* session = it->second;
     DCHECK(session);
     DCHECK(session_map_[session] == it);
@@ -269,13 +273,11 @@ class SSLSessionCache {
   }
 
  private:
-  // A pair of maps to allow bi-directional lookups between host:port and an
-  // associated session.
-  // TODO(joth): When client certificates are implemented we should key the
-  // cache on the client certificate used in addition to the host-port pair.
-  typedef std::map<HostPortPair, SSL_SESSION*> HostPortMap;
-  typedef std::map<SSL_SESSION*, HostPortMap::iterator> SessionMap;
-  HostPortMap host_port_map_;
+  // A pair of maps to allow bi-directional lookups between a session cache key
+  // and an associated session.
+  typedef std::map<std::string, SSL_SESSION*> KeyMap;
+  typedef std::map<SSL_SESSION*, KeyMap::iterator> SessionMap;
+  KeyMap key_map_;
   SessionMap session_map_;
 
   // Protects access to both the above maps.
@@ -302,6 +304,12 @@ class SSLContext {
     return SSL_set_ex_data(ssl, ssl_socket_data_index_, socket) != 0;
   }
 
+  // Removes every session from the cache of OpenSSL, as if they had all
+  // expired; |session_cache_| lets go of them in RemoveSessionCallback().
+  void FlushSessions() {
+    SSL_CTX_flush_sessions(ssl_ctx_.get(), LONG_MAX);
+  }
+
  private:
   friend struct DefaultSingletonTraits<SSLContext>;
 
@@ -332,7 +340,7 @@ class SSLContext {
 
   int NewSessionCallback(SSL* ssl, SSL_SESSION* session) {
     SSLClientSocketOpenSSL* socket = GetClientSocketFromSSL(ssl);
-    session_cache_.OnSessionAdded(socket->host_and_port(), session);
+    session_cache_.OnSessionAdded(socket->GetSessionCacheKey(), session);
     return 1;  // 1 => We took ownership of |session|.
   }
 
@@ -386,6 +394,7 @@ SSLClientSocketOpenSSL::SSLClientSocketOpenSSL(
     ClientSocketHandle* transport_socket,
     const HostPortPair& host_and_port,
     const SSLConfig& ssl_config,
+    SSLHostInfo* ssl_host_info,
     CertVerifier* cert_verifier)
     : ALLOW_THIS_IN_INITIALIZER_LIST(buffer_send_callback_(
           this, &SSLClientSocketOpenSSL::BufferSendComplete)),
@@ -406,6 +415,7 @@ SSLClientSocketOpenSSL::SSLClientSocketOpenSSL(
       transport_(transport_socket),
       host_and_port_(host_and_port),
       ssl_config_(ssl_config),
+      ssl_host_info_(ssl_host_info),
       trying_cached_session_(false),
       npn_status_(kNextProtoUnsupported),
       net_log_(transport_socket->socket()->NetLog()) {
@@ -415,6 +425,27 @@ SSLClientSocketOpenSSL::~SSLClientSocketOpenSSL() {
   Disconnect();
 }
 
+// static
+void SSLClientSocketOpenSSL::ClearSessionCache() {
+  SSLContext::GetInstance()->FlushSessions();
+}
+
+bool SSLClientSocketOpenSSL::EnsureTransportBIO() {
+  DCHECK(ssl_);
+  if (transport_bio_)
+    return true;
+
+  BIO* ssl_bio = NULL;
+  // 0 => use default buffer sizes.
+  if (!BIO_new_bio_pair(&ssl_bio, 0, &transport_bio_, 0))
+    return false;
+  DCHECK(ssl_bio);
+  DCHECK(transport_bio_);
+
+  SSL_set_bio(ssl_, ssl_bio, ssl_bio);
+  return true;
+}
+
 bool SSLClientSocketOpenSSL::Init() {
   DCHECK(!ssl_);
   DCHECK(!transport_bio_);
@@ -430,16 +461,12 @@ bool SSLClientSocketOpenSSL::Init() {
     return false;
 
   trying_cached_session_ =
-      context->session_cache()->SetSSLSession(ssl_, host_and_port_);
+      context->session_cache()->SetSSLSession(ssl_, GetSessionCacheKey());
+  if (!trying_cached_session_)
+    trying_cached_session_ = SetSSLHostInfoSession();
 
-  BIO* ssl_bio = NULL;
-  // 0 => use default buffer sizes.
-  if (!BIO_new_bio_pair(&ssl_bio, 0, &transport_bio_, 0))
+  if (!EnsureTransportBIO())
     return false;
-  DCHECK(ssl_bio);
-  DCHECK(transport_bio_);
-
-  SSL_set_bio(ssl_, ssl_bio, ssl_bio);
 
   // OpenSSL defaults some options to on, others to off. To avoid ambiguity,
   // set everything we care about to an absolute value.
@@ -852,6 +879,81 @@ int SSLClientSocketOpenSSL::DoVerifyCert(int result) {
                            &handshake_io_callback_);
 }
 
+std::string SSLClientSocketOpenSSL::GetSessionCacheKey() const {
+  std::string key = host_and_port_.ToString();
+  key.append(ssl_config_.ssl3_enabled ? "/ssl3" : "/no-ssl3");
+  key.append(ssl_config_.tls1_enabled ? "/tls1" : "/no-tls1");
+  if (ssl_config_.send_client_cert) {
+    if (ssl_config_.client_cert) {
+      const SHA1Fingerprint& fingerprint =
+          ssl_config_.client_cert->fingerprint();
+      key.append("/cert:");
+      key.append(base::HexEncode(fingerprint.data, sizeof(fingerprint.data)));
+    } else {
+      key.append("/no-cert");
+    }
+  }
+  return key;
+}
+
+bool SSLClientSocketOpenSSL::SetSSLHostInfoSession() {
+  // Don't wait for the disk: SSLConnectJob has been loading it while the
+  // transport connected.
+  if (!ssl_host_info_.get() || ssl_host_info_->WaitForDataReady(NULL) != OK)
+    return false;
+
+  const SSLHostInfo::State& state = ssl_host_info_->state();
+  if (state.ssl_session.empty() ||
+      state.ssl_session_key != GetSessionCacheKey()) {
+    return false;
+  }
+
+  const unsigned char* data =
+      reinterpret_cast<const unsigned char*>(state.ssl_session.data());
+  crypto::ScopedOpenSSL<SSL_SESSION, SSL_SESSION_free> session(
+      d2i_SSL_SESSION(NULL, &data, state.ssl_session.size()));
+  if (!session.get())
+    return false;
+
+  // OpenSSL doesn't check the lifetime of the sessions it offers.
+  long expiry = SSL_SESSION_get_time(session.get()) +
+      SSL_SESSION_get_timeout(session.get());
+  if (expiry < static_cast<long>(base::Time::Now().ToTimeT()))
+    return false;
+
+  DVLOG(2) << "Offering saved session for " << GetSessionCacheKey();
+  return SSL_set_session(ssl_, session.get()) == 1;
+}
+
+void SSLClientSocketOpenSSL::SaveSSLHostInfo() {
+  // A resumed session is already saved.
+  if (!ssl_host_info_.get() || SSL_session_reused(ssl_))
+    return;
+
+  // If the SSLHostInfo hasn't managed to load from disk yet then we can't save
+  // anything.
+  if (ssl_host_info_->WaitForDataReady(NULL) != OK)
+    return;
+
+  SSL_SESSION* session = SSL_get_session(ssl_);
+  if (!session)
+    return;
+  int size = i2d_SSL_SESSION(session, NULL);
+  if (size <= 0 || size > kMaxPersistedSessionSize)
+    return;
+
+  std::string der_session(size, '\0');
+  unsigned char* data =
+      reinterpret_cast<unsigned char*>(string_as_array(&der_session));
+  if (i2d_SSL_SESSION(session, &data) != size)
+    return;
+
+  SSLHostInfo::State* state = ssl_host_info_->mutable_state();
+  state->ssl_session_key = GetSessionCacheKey();
+  state->ssl_session.swap(der_session);
+  ssl_host_info_->Persist();
+}
+
 int SSLClientSocketOpenSSL::DoVerifyCertComplete(int result) {
   verifier_.reset();
 
@@ -875,6 +977,9 @@ int SSLClientSocketOpenSSL::DoVerifyCertComplete(int result) {
     result = OK;
   }
 
+  if (result == OK)
+    SaveSSLHostInfo();
+
   completed_handshake_ = true;
   // Exit DoHandshakeLoop and return the result to the caller to Connect.
   DCHECK_EQ(STATE_NONE, next_handshake_state_);
@@ -1124,11 +1229,41 @@ bool SSLClientSocketOpenSSL::UsingTCPFastOpen() const {
   return false;
 }
 
+bool SSLClientSocketOpenSSL::GetTCPInfo(TCPInfo* info) const {
+  if (transport_.get() && transport_->socket())
+    return transport_->socket()->GetTCPInfo(info);
+  return false;
+}
+
 // Socket methods
 
+int SSLClientSocketOpenSSL::ReleaseIdleBuffers() {
+  // SSL_MODE_RELEASE_BUFFERS already frees the record buffers of |ssl_|, but
+  // the BIO pair keeps its two buffers for as long as it lives. It can only
+  // go while no data is on its way through it.
+  if (!transport_bio_ || !completed_handshake_ || transport_send_busy_ ||
+      transport_recv_busy_ || user_read_callback_ || user_write_callback_ ||
+      BIO_ctrl_pending(transport_bio_) || BIO_ctrl_wpending(transport_bio_)) {
+    return 0;
+  }
+  int released = 2 * BIO_get_write_buf_size(transport_bio_, 0);
+
+  // This frees our end of the pair too.
+  SSL_set_bio(ssl_, NULL, NULL);
+  BIO_free_all(transport_bio_);
+  transport_bio_ = NULL;
+
+  if (transport_.get() && transport_->socket())
+    released += transport_->socket()->ReleaseIdleBuffers();
+  return released;
+}
+
 int SSLClientSocketOpenSSL::Read(IOBuffer* buf,
                                  int buf_len,
                                  CompletionCallback* callback) {
+  if (!EnsureTransportBIO())
+    return ERR_OUT_OF_MEMORY;
+
   user_read_buf_ = buf;
   user_read_buf_len_ = buf_len;
 
@@ -1161,6 +1296,9 @@ int SSLClientSocketOpenSSL::DoReadLoop(int result) {
 int SSLClientSocketOpenSSL::Write(IOBuffer* buf,
                                   int buf_len,
                                   CompletionCallback* callback) {
+  if (!EnsureTransportBIO())
+    return ERR_OUT_OF_MEMORY;
+
   user_write_buf_ = buf;
   user_write_buf_len_ = buf_len;
 
@@ -27,6 +27,7 @@ class CertVerifier;
 class SingleRequestCertVerifier;
 class SSLCertRequestInfo;
 class SSLConfig;
+class SSLHostInfo;
 class SSLInfo;
 
 // An SSL client socket implemented with OpenSSL.
@@ -35,15 +36,24 @@ class SSLClientSocketOpenSSL : public SSLClientSocket {
   // Takes ownership of the transport_socket, which may already be connected.
   // The given hostname will be compared with the name(s) in the server's
   // certificate during the SSL handshake.  ssl_config specifies the SSL
-  // settings.
+  // settings. The socket takes ownership of |ssl_host_info|, which may be
+  // NULL, and uses it to resume sessions across restarts.
   SSLClientSocketOpenSSL(ClientSocketHandle* transport_socket,
                          const HostPortPair& host_and_port,
                          const SSLConfig& ssl_config,
+                         SSLHostInfo* ssl_host_info,
                          CertVerifier* cert_verifier);
   ~SSLClientSocketOpenSSL();
 
+  // Drops the sessions that new sockets could resume.
+  static void ClearSessionCache();
+
   const HostPortPair& host_and_port() const { return host_and_port_; }
 
+  // Returns the key of the sessions of this socket: a session can only be
+  // resumed by a socket to the same host:port, with the same SSL settings.
+  std::string GetSessionCacheKey() const;
+
   // Callback from the SSL layer that indicates the remote server is requesting
   // a certificate for this client.
   int ClientCertRequestCallback(SSL* ssl, X509** x509, EVP_PKEY** pkey);
@@ -75,6 +85,8 @@ class SSLClientSocketOpenSSL : public SSLClientSocket {
   virtual void SetOmniboxSpeculation();
   virtual bool WasEverUsed() const;
   virtual bool UsingTCPFastOpen() const;
+  virtual bool GetTCPInfo(TCPInfo* info) const;
+  virtual int ReleaseIdleBuffers();
 
   // Socket methods:
   virtual int Read(IOBuffer* buf, int buf_len, CompletionCallback* callback);
@@ -84,6 +96,10 @@ class SSLClientSocketOpenSSL : public SSLClientSocket {
 
  private:
   bool Init();
+
+  // Creates the BIO pair between |ssl_| and the transport, unless it already
+  // exists. ReleaseIdleBuffers() frees it. Returns false on failure.
+  bool EnsureTransportBIO();
   void DoReadCallback(int result);
   void DoWriteCallback(int result);
 
@@ -94,6 +110,14 @@ class SSLClientSocketOpenSSL : public SSLClientSocket {
   void DoConnectCallback(int result);
   X509Certificate* UpdateServerCert();
 
+  // Offers the session saved in |ssl_host_info_|, if it belongs to this
+  // socket's session cache key and hasn't expired. Returns true if a session
+  // was set on |ssl_|.
+  bool SetSSLHostInfoSession();
+
+  // Saves the newly negotiated session in |ssl_host_info_|.
+  void SaveSSLHostInfo();
+
   void OnHandshakeIOComplete(int result);
   void OnSendComplete(int result);
   void OnRecvComplete(int result);
@@ -151,6 +175,7 @@ class SSLClientSocketOpenSSL : public SSLClientSocket {
   scoped_ptr<ClientSocketHandle> transport_;
   const HostPortPair host_and_port_;
   SSLConfig ssl_config_;
+  scoped_ptr<SSLHostInfo> ssl_host_info_;
 
   // Used for session cache diagnostics.
   bool trying_cached_session_;
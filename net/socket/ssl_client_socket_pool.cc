@@ -328,6 +328,8 @@ int SSLConnectJob::DoSSLConnect() {
   // Reset the timeout to just the time allowed for the SSL handshake.
   ResetTimer(base::TimeDelta::FromSeconds(kSSLHandshakeTimeoutInSeconds));
   ssl_connect_start_time_ = base::TimeTicks::Now();
+  connect_timing_ = transport_socket_handle_->connect_timing();
+  connect_timing_.ssl_start = ssl_connect_start_time_;
 
   ssl_socket_.reset(client_socket_factory_->CreateSSLClientSocket(
       transport_socket_handle_.release(), params_->host_and_port(),
@@ -349,6 +351,8 @@ int SSLConnectJob::DoSSLConnect() {
 }
 
 int SSLConnectJob::DoSSLConnectComplete(int result) {
+  connect_timing_.ssl_end = base::TimeTicks::Now();
+
   SSLClientSocket::NextProtoStatus status =
       SSLClientSocket::kNextProtoUnsupported;
   std::string proto;
@@ -533,6 +537,11 @@ SSLClientSocketPool::~SSLClientSocketPool() {
     ssl_config_service_->RemoveObserver(this);
 }
 
+int SSLClientSocketPool::TakePeakActiveSocketCount(
+    const std::string& group_name) {
+  return base_.TakePeakActiveSocketCount(group_name);
+}
+
 ConnectJob* SSLClientSocketPool::SSLConnectJobFactory::NewConnectJob(
     const std::string& group_name,
     const PoolBase::Request& request,
@@ -573,6 +582,12 @@ void SSLClientSocketPool::CancelRequest(const std::string& group_name,
   base_.CancelRequest(group_name, handle);
 }
 
+void SSLClientSocketPool::SetPriority(const std::string& group_name,
+                                      ClientSocketHandle* handle,
+                                      RequestPriority priority) {
+  base_.SetPriority(group_name, handle, priority);
+}
+
 void SSLClientSocketPool::ReleaseSocket(const std::string& group_name,
                                         ClientSocket* socket, int id) {
   base_.ReleaseSocket(group_name, socket, id);
@@ -198,6 +198,9 @@ class SSLClientSocketPool : public ClientSocketPool,
 
   virtual ~SSLClientSocketPool();
 
+  // See ClientSocketPoolBaseHelper::TakePeakActiveSocketCount().
+  int TakePeakActiveSocketCount(const std::string& group_name);
+
   // ClientSocketPool methods:
   virtual int RequestSocket(const std::string& group_name,
                             const void* connect_params,
@@ -214,6 +217,10 @@ class SSLClientSocketPool : public ClientSocketPool,
   virtual void CancelRequest(const std::string& group_name,
                              ClientSocketHandle* handle);
 
+  virtual void SetPriority(const std::string& group_name,
+                           ClientSocketHandle* handle,
+                           RequestPriority priority);
+
   virtual void ReleaseSocket(const std::string& group_name,
                              ClientSocket* socket,
                              int id);
@@ -21,6 +21,8 @@ SSLHostInfo::State::~State() {}
 
 void SSLHostInfo::State::Clear() {
   certs.clear();
+  ssl_session_key.clear();
+  ssl_session.clear();
 }
 
 SSLHostInfo::SSLHostInfo(
@@ -110,6 +112,13 @@ bool SSLHostInfo::ParseInner(const std::string& data) {
     }
   }
 
+  // The session was added to the format later, so older entries end here.
+  if (!p.ReadString(&iter, &state->ssl_session_key) ||
+      !p.ReadString(&iter, &state->ssl_session)) {
+    state->ssl_session_key.clear();
+    state->ssl_session.clear();
+  }
+
   if (!state->certs.empty()) {
     std::vector<base::StringPiece> der_certs(state->certs.size());
     for (size_t i = 0; i < state->certs.size(); i++)
@@ -162,7 +171,9 @@ std::string SSLHostInfo::Serialize() const {
   }
 
   if (!p.WriteString("") ||
-      !p.WriteBool(false)) {
+      !p.WriteBool(false) ||
+      !p.WriteString(state_.ssl_session_key) ||
+      !p.WriteString(state_.ssl_session)) {
     return "";
   }
 
@@ -174,9 +185,8 @@ const CertVerifyResult& SSLHostInfo::cert_verify_result() const {
 }
 
 int SSLHostInfo::WaitForCertVerification(CompletionCallback* callback) {
-  if (cert_verification_complete_)
+  if (cert_verification_complete_ || cert_parsing_failed_)
     return cert_verification_error_;
-  DCHECK(!cert_parsing_failed_);
   DCHECK(!cert_verification_callback_);
   DCHECK(!state_.certs.empty());
   cert_verification_callback_ = callback;
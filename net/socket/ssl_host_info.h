@@ -23,9 +23,9 @@ class X509Certificate;
 struct SSLConfig;
 
 // SSLHostInfo is an interface for fetching information about an SSL server.
-// This information may be stored on disk so does not include keys or session
-// information etc. Primarily it's intended for caching the server's
-// certificates.
+// This information may be stored on disk. Primarily it's intended for caching
+// the server's certificates, but it can also carry a resumable session so that
+// the handshake can be abbreviated across restarts.
 class SSLHostInfo {
  public:
   SSLHostInfo(const std::string& hostname,
@@ -47,7 +47,8 @@ class SSLHostInfo {
   // to delete |callback|.
   //
   // |callback| may be NULL, in which case ERR_IO_PENDING may still be returned
-  // but, obviously, a callback will never be made.
+  // but, obviously, a callback will never be made.  If this object is deleted
+  // first, |callback| isn't called.
   virtual int WaitForDataReady(CompletionCallback* callback) = 0;
 
   // Persist allows for the host information to be updated for future users.
@@ -70,6 +71,14 @@ class SSLHostInfo {
     // returned them and in the same order.
     std::vector<std::string> certs;
 
+    // ssl_session is a DER encoded session that can be offered to resume
+    // with the server, or empty. The hostname alone doesn't say which port
+    // and SSL settings the session was made with, so it's stored along with
+    // the session cache key of its socket, see
+    // SSLClientSocketOpenSSL::GetSessionCacheKey().
+    std::string ssl_session_key;
+    std::string ssl_session;
+
    private:
     DISALLOW_COPY_AND_ASSIGN(State);
   };
@@ -87,7 +96,8 @@ class SSLHostInfo {
   // |state().certs| is still being validated and arranges for the given
   // callback to be called when the verification completes. If the verification
   // has already finished then WaitForCertVerification returns the result of
-  // that verification.
+  // that verification.  If the certificates couldn't be parsed, it returns
+  // ERR_CERT_INVALID.
   int WaitForCertVerification(CompletionCallback* callback);
 
   base::TimeTicks verification_start_time() const {
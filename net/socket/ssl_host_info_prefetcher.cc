@@ -0,0 +1,130 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/socket/ssl_host_info_prefetcher.h"
+
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/stl_util-inl.h"
+#include "net/base/completion_callback.h"
+#include "net/base/net_errors.h"
+#include "net/socket/ssl_host_info.h"
+
+namespace net {
+
+namespace {
+
+// Bounds the hosts remembered as prefetched.
+const size_t kMaxRecentHosts = 256;
+
+}  // namespace
+
+// Loads one SSLHostInfo and waits for the verification of its certificates.
+class SSLHostInfoPrefetcher::Job {
+ public:
+  Job(SSLHostInfoPrefetcher* prefetcher, SSLHostInfo* ssl_host_info)
+      : prefetcher_(prefetcher),
+        ssl_host_info_(ssl_host_info),
+        waiting_for_verification_(false),
+        ALLOW_THIS_IN_INITIALIZER_LIST(
+            callback_(this, &Job::OnIOComplete)) {
+  }
+
+  void Start() {
+    ssl_host_info_->Start();
+    int rv = ssl_host_info_->WaitForDataReady(&callback_);
+    if (rv != ERR_IO_PENDING)
+      OnIOComplete(rv);
+  }
+
+ private:
+  void OnIOComplete(int result) {
+    if (!waiting_for_verification_ &&
+        !ssl_host_info_->state().certs.empty()) {
+      waiting_for_verification_ = true;
+      int rv = ssl_host_info_->WaitForCertVerification(&callback_);
+      if (rv == ERR_IO_PENDING)
+        return;
+    }
+    // |ssl_host_info_| may still be on the stack, so it can't be deleted
+    // here.
+    MessageLoop::current()->PostTask(
+        FROM_HERE,
+        prefetcher_->method_factory_.NewRunnableMethod(
+            &SSLHostInfoPrefetcher::OnJobComplete, this));
+  }
+
+  SSLHostInfoPrefetcher* const prefetcher_;
+  scoped_ptr<SSLHostInfo> ssl_host_info_;
+  bool waiting_for_verification_;
+  CompletionCallbackImpl<Job> callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(Job);
+};
+
+SSLHostInfoPrefetcher::SSLHostInfoPrefetcher(SSLHostInfoFactory* factory)
+    : factory_(factory),
+      ALLOW_THIS_IN_INITIALIZER_LIST(method_factory_(this)) {
+  DCHECK(factory_);
+}
+
+SSLHostInfoPrefetcher::~SSLHostInfoPrefetcher() {
+  STLDeleteElements(&running_);
+}
+
+void SSLHostInfoPrefetcher::Prefetch(const std::string& hostname,
+                                     const SSLConfig& ssl_config) {
+  DCHECK(CalledOnValidThread());
+  const base::TimeTicks now = base::TimeTicks::Now();
+  std::map<std::string, base::TimeTicks>::iterator it = recent_.find(hostname);
+  if (it != recent_.end() &&
+      now - it->second < base::TimeDelta::FromSeconds(kRefetchIntervalSecs)) {
+    return;
+  }
+  if (recent_.size() >= kMaxRecentHosts)
+    PruneRecent(now);
+  recent_[hostname] = now;
+
+  queue_.push_back(std::make_pair(hostname, ssl_config));
+  StartPrefetches();
+}
+
+void SSLHostInfoPrefetcher::StartPrefetches() {
+  // Jobs always complete from a posted task, so this isn't re-entered.
+  while (running_.size() < kMaxRunningPrefetches && !queue_.empty()) {
+    SSLHostInfo* ssl_host_info =
+        factory_->GetForHost(queue_.front().first, queue_.front().second);
+    queue_.pop_front();
+    if (!ssl_host_info)
+      continue;
+    Job* job = new Job(this, ssl_host_info);
+    running_.insert(job);
+    job->Start();
+  }
+}
+
+void SSLHostInfoPrefetcher::OnJobComplete(Job* job) {
+  DCHECK(ContainsKey(running_, job));
+  running_.erase(job);
+  delete job;
+  StartPrefetches();
+}
+
+void SSLHostInfoPrefetcher::PruneRecent(base::TimeTicks now) {
+  const base::TimeDelta interval =
+      base::TimeDelta::FromSeconds(kRefetchIntervalSecs);
+  for (std::map<std::string, base::TimeTicks>::iterator it = recent_.begin();
+       it != recent_.end(); ) {
+    if (now - it->second >= interval)
+      recent_.erase(it++);
+    else
+      ++it;
+  }
+  // Only if they were all prefetched just now.
+  if (recent_.size() >= kMaxRecentHosts)
+    recent_.clear();
+}
+
+}  // namespace net
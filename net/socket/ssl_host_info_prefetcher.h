@@ -0,0 +1,81 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_SOCKET_SSL_HOST_INFO_PREFETCHER_H_
+#define NET_SOCKET_SSL_HOST_INFO_PREFETCHER_H_
+#pragma once
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+#include "base/basictypes.h"
+#include "base/task.h"
+#include "base/threading/non_thread_safe.h"
+#include "base/time.h"
+#include "net/base/net_export.h"
+#include "net/base/ssl_config_service.h"
+
+namespace net {
+
+class SSLHostInfoFactory;
+
+// SSLHostInfoPrefetcher loads the SSLHostInfo of hosts that are likely to be
+// connected to soon, such as the ones that were used at startup last time or
+// that a loading page is predicted to need.  Loading an SSLHostInfo starts the
+// verification of its certificates, and the result stays in the
+// CertVerifier's cache.  So when the connection is made and reads the
+// SSLHostInfo again, its verification is answered at once from the cache
+// instead of being on the critical path of the handshake.
+class NET_EXPORT SSLHostInfoPrefetcher : public base::NonThreadSafe {
+ public:
+  // A host isn't prefetched again within this long, which is well inside the
+  // lifetime of the CertVerifier's cached results.
+  static const int kRefetchIntervalSecs = 600;
+
+  // How many prefetches run at once.  The rest wait their turn.
+  static const size_t kMaxRunningPrefetches = 4;
+
+  // |factory| must outlive this object.
+  explicit SSLHostInfoPrefetcher(SSLHostInfoFactory* factory);
+  ~SSLHostInfoPrefetcher();
+
+  // Loads the SSLHostInfo of |hostname|.  |ssl_config| should be the one the
+  // connection will use, since the verification flags come from it.
+  void Prefetch(const std::string& hostname, const SSLConfig& ssl_config);
+
+  // The number of prefetches running or waiting to run.
+  size_t pending_count() const { return running_.size() + queue_.size(); }
+
+ private:
+  class Job;
+
+  // Starts waiting prefetches while there are fewer than
+  // kMaxRunningPrefetches running.
+  void StartPrefetches();
+
+  // Called, from a posted task, when |job| is done with.
+  void OnJobComplete(Job* job);
+
+  // Forgets the hosts that were prefetched long enough ago.
+  void PruneRecent(base::TimeTicks now);
+
+  SSLHostInfoFactory* const factory_;
+
+  std::set<Job*> running_;
+  std::deque<std::pair<std::string, SSLConfig> > queue_;
+
+  // When each host was last prefetched.
+  std::map<std::string, base::TimeTicks> recent_;
+
+  ScopedRunnableMethodFactory<SSLHostInfoPrefetcher> method_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(SSLHostInfoPrefetcher);
+};
+
+}  // namespace net
+
+#endif  // NET_SOCKET_SSL_HOST_INFO_PREFETCHER_H_
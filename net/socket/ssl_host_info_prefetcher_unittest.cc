@@ -0,0 +1,150 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/socket/ssl_host_info_prefetcher.h"
+
+#include <string>
+#include <vector>
+
+#include "base/message_loop.h"
+#include "net/base/cert_verifier.h"
+#include "net/base/completion_callback.h"
+#include "net/base/net_errors.h"
+#include "net/base/ssl_config_service.h"
+#include "net/socket/ssl_host_info.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// An SSLHostInfo whose load finishes, with nothing found, when told to.
+class FakeSSLHostInfo : public SSLHostInfo {
+ public:
+  FakeSSLHostInfo(const std::string& hostname,
+                  const SSLConfig& ssl_config,
+                  CertVerifier* cert_verifier,
+                  std::vector<FakeSSLHostInfo*>* live)
+      : SSLHostInfo(hostname, ssl_config, cert_verifier),
+        live_(live),
+        callback_(NULL) {
+    live_->push_back(this);
+  }
+
+  virtual ~FakeSSLHostInfo() {
+    for (std::vector<FakeSSLHostInfo*>::iterator it = live_->begin();
+         it != live_->end(); ++it) {
+      if (*it == this) {
+        live_->erase(it);
+        break;
+      }
+    }
+  }
+
+  virtual void Start() {}
+
+  virtual int WaitForDataReady(CompletionCallback* callback) {
+    callback_ = callback;
+    return ERR_IO_PENDING;
+  }
+
+  virtual void Persist() {}
+
+  void FinishLoading() {
+    ASSERT_TRUE(callback_);
+    CompletionCallback* callback = callback_;
+    callback_ = NULL;
+    callback->Run(OK);
+  }
+
+ private:
+  std::vector<FakeSSLHostInfo*>* const live_;
+  CompletionCallback* callback_;
+};
+
+class FakeSSLHostInfoFactory : public SSLHostInfoFactory {
+ public:
+  virtual SSLHostInfo* GetForHost(const std::string& hostname,
+                                  const SSLConfig& ssl_config) {
+    hostnames_.push_back(hostname);
+    return new FakeSSLHostInfo(hostname, ssl_config, &cert_verifier_, &live_);
+  }
+
+  const std::vector<std::string>& hostnames() const { return hostnames_; }
+  const std::vector<FakeSSLHostInfo*>& live() const { return live_; }
+
+ private:
+  CertVerifier cert_verifier_;
+  std::vector<std::string> hostnames_;
+  std::vector<FakeSSLHostInfo*> live_;
+};
+
+TEST(SSLHostInfoPrefetcherTest, LimitsRunningPrefetches) {
+  MessageLoop message_loop;
+  FakeSSLHostInfoFactory factory;
+  SSLHostInfoPrefetcher prefetcher(&factory);
+  SSLConfig ssl_config;
+
+  const char* const kHosts[] = {
+    "a.example.com", "b.example.com", "c.example.com", "d.example.com",
+    "e.example.com", "f.example.com",
+  };
+  for (size_t i = 0; i < arraysize(kHosts); ++i)
+    prefetcher.Prefetch(kHosts[i], ssl_config);
+  EXPECT_EQ(arraysize(kHosts), prefetcher.pending_count());
+  ASSERT_EQ(4u, factory.hostnames().size());
+  EXPECT_EQ("d.example.com", factory.hostnames()[3]);
+
+  // Finishing one lets the next one start, once the message loop has run.
+  factory.live()[0]->FinishLoading();
+  EXPECT_EQ(4u, factory.hostnames().size());
+  MessageLoop::current()->RunAllPending();
+  EXPECT_EQ(5u, factory.hostnames().size());
+  EXPECT_EQ("e.example.com", factory.hostnames()[4]);
+  EXPECT_EQ(arraysize(kHosts) - 1, prefetcher.pending_count());
+  EXPECT_EQ(4u, factory.live().size());
+
+  while (!factory.live().empty()) {
+    factory.live()[0]->FinishLoading();
+    MessageLoop::current()->RunAllPending();
+  }
+  EXPECT_EQ(arraysize(kHosts), factory.hostnames().size());
+  EXPECT_EQ(0u, prefetcher.pending_count());
+}
+
+TEST(SSLHostInfoPrefetcherTest, SkipsRecentHosts) {
+  MessageLoop message_loop;
+  FakeSSLHostInfoFactory factory;
+  SSLHostInfoPrefetcher prefetcher(&factory);
+  SSLConfig ssl_config;
+
+  prefetcher.Prefetch("www.example.com", ssl_config);
+  prefetcher.Prefetch("www.example.com", ssl_config);
+  EXPECT_EQ(1u, prefetcher.pending_count());
+
+  factory.live()[0]->FinishLoading();
+  MessageLoop::current()->RunAllPending();
+  EXPECT_EQ(0u, prefetcher.pending_count());
+
+  // Still too soon to load it again.
+  prefetcher.Prefetch("www.example.com", ssl_config);
+  EXPECT_EQ(0u, prefetcher.pending_count());
+  EXPECT_EQ(1u, factory.hostnames().size());
+}
+
+// Loads still running when the prefetcher goes away are just dropped.
+TEST(SSLHostInfoPrefetcherTest, DeletedWhileRunning) {
+  MessageLoop message_loop;
+  FakeSSLHostInfoFactory factory;
+  {
+    SSLHostInfoPrefetcher prefetcher(&factory);
+    prefetcher.Prefetch("www.example.com", SSLConfig());
+    EXPECT_EQ(1u, factory.live().size());
+  }
+  EXPECT_TRUE(factory.live().empty());
+}
+
+}  // namespace
+
+}  // namespace net
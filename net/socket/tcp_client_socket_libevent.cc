@@ -11,6 +11,10 @@
 #include <netinet/tcp.h>
 #if defined(OS_POSIX)
 #include <netinet/in.h>
+#include <sys/uio.h>
+#endif
+#if defined(OS_LINUX)
+#include <sys/sendfile.h>
 #endif
 
 #include "base/eintr_wrapper.h"
@@ -26,6 +30,7 @@
 #include "net/base/net_log.h"
 #include "net/base/net_util.h"
 #include "net/base/network_change_notifier.h"
+#include "net/socket/tcp_info.h"
 #if defined(USE_SYSTEM_LIBEVENT)
 #include <event.h>
 #else
@@ -41,6 +46,29 @@ namespace {
 
 const int kInvalidSocket = -1;
 
+#if !defined(MSG_FASTOPEN)
+// Older C libraries lack the flag which asks sendto() to open the connection
+// and put the data on the SYN packet.
+#define MSG_FASTOPEN 0x20000000
+#endif
+
+// The most data that can go on a fast open SYN packet.
+const int kMaxFastOpenSendLength = 1420;
+
+// Returns true if |os_error|, from a fast open sendto(), means that fast open
+// can't be used for this connection, as opposed to the connection failing.
+bool IsFastOpenUnsupportedError(int os_error) {
+  switch (os_error) {
+    case EOPNOTSUPP:   // Fast open is disabled in the kernel.
+    case ENOPROTOOPT:
+    case EPIPE:        // The kernel ignored MSG_FASTOPEN, and the socket
+    case ENOTCONN:     // isn't connected.
+      return true;
+    default:
+      return false;
+  }
+}
+
 // DisableNagle turns off buffering in the kernel. By default, TCP sockets will
 // wait up to 200ms for more data to complete a packet before transmitting.
 // After calling this function, the kernel will not wait. See TCP_NODELAY in
@@ -111,6 +139,8 @@ TCPClientSocketLibevent::TCPClientSocketLibevent(
       current_ai_(NULL),
       read_watcher_(this),
       write_watcher_(this),
+      write_file_(base::kInvalidPlatformFileValue),
+      write_file_offset_(0),
       read_callback_(NULL),
       write_callback_(NULL),
       next_connect_state_(CONNECT_STATE_NONE),
@@ -118,7 +148,8 @@ TCPClientSocketLibevent::TCPClientSocketLibevent(
       net_log_(BoundNetLog::Make(net_log, NetLog::SOURCE_SOCKET)),
       previously_disconnected_(false),
       use_tcp_fastopen_(false),
-      tcp_fastopen_connected_(false)
+      tcp_fastopen_connected_(false),
+      received_first_byte_(false)
 #ifdef ANDROID
       , wait_for_connect_(false)
       , valid_uid_(false)
@@ -262,7 +293,8 @@ int TCPClientSocketLibevent::DoConnect() {
 #endif
     }
   } else {
-    // With TCP FastOpen, we pretend that the socket is connected.
+    // With TCP FastOpen, we pretend that the socket is connected. The
+    // connection is opened by the first write, see InternalWrite().
     DCHECK(!tcp_fastopen_connected_);
     return OK;
   }
@@ -336,10 +368,13 @@ void TCPClientSocketLibevent::DoDisconnect() {
     qtaguid_untagSocket(socket_);
 #endif
 
+  LogTCPInfo("close");
   if (HANDLE_EINTR(close(socket_)) < 0)
     PLOG(ERROR) << "close";
   socket_ = kInvalidSocket;
   previously_disconnected_ = true;
+  tcp_fastopen_connected_ = false;
+  received_first_byte_ = false;
 }
 
 bool TCPClientSocketLibevent::IsConnected() const {
@@ -348,6 +383,10 @@ bool TCPClientSocketLibevent::IsConnected() const {
   if (socket_ == kInvalidSocket || waiting_connect())
     return false;
 
+  // A fast open socket has nothing to check until its first write.
+  if (waiting_fastopen_write())
+    return true;
+
   // Check if connection is alive.
   char c;
   int rv = HANDLE_EINTR(recv(socket_, &c, 1, MSG_PEEK));
@@ -365,6 +404,9 @@ bool TCPClientSocketLibevent::IsConnectedAndIdle() const {
   if (socket_ == kInvalidSocket || waiting_connect())
     return false;
 
+  if (waiting_fastopen_write())
+    return true;
+
   // Check if connection is alive and we haven't received any data
   // unexpectedly.
   char c;
@@ -396,6 +438,7 @@ int TCPClientSocketLibevent::Read(IOBuffer* buf,
       use_history_.set_was_used_to_convey_data();
     LogByteTransfer(
         net_log_, NetLog::TYPE_SOCKET_BYTES_RECEIVED, nread, buf->data());
+    LogTCPInfoForRead(nread);
     return nread;
   }
   if (errno != EAGAIN && errno != EWOULDBLOCK) {
@@ -453,36 +496,162 @@ int TCPClientSocketLibevent::Write(IOBuffer* buf,
   return ERR_IO_PENDING;
 }
 
-int TCPClientSocketLibevent::InternalWrite(IOBuffer* buf, int buf_len) {
-  int nwrite;
-  if (use_tcp_fastopen_ && !tcp_fastopen_connected_) {
-    // We have a limited amount of data to send in the SYN packet.
-    int kMaxFastOpenSendLength = 1420;
-
-    buf_len = std::min(kMaxFastOpenSendLength, buf_len);
-
-    int flags = 0x20000000;  // Magic flag to enable TCP_FASTOPEN
-    nwrite = HANDLE_EINTR(sendto(socket_,
-                                 buf->data(),
-                                 buf_len,
-                                 flags,
-                                 current_ai_->ai_addr,
-                                 static_cast<int>(current_ai_->ai_addrlen)));
-    tcp_fastopen_connected_ = true;
-
-    if (nwrite < 0) {
-      // Non-blocking mode is returning EINPROGRESS rather than EAGAIN.
-      if (errno == EINPROGRESS)
-         errno = EAGAIN;
-
-      // Unlike "normal" nonblocking sockets, the data is already queued,
-      // so tell the app that we've consumed it.
-      return buf_len;
+int TCPClientSocketLibevent::Writev(IOBuffer* const* bufs,
+                                    const int* buf_lens,
+                                    int num_bufs,
+                                    CompletionCallback* callback) {
+  DCHECK(CalledOnValidThread());
+  DCHECK_NE(kInvalidSocket, socket_);
+  DCHECK(!waiting_connect());
+  DCHECK(!write_callback_);
+  DCHECK(callback);
+  DCHECK_GT(num_bufs, 0);
+
+  // The first write of a fast open socket goes on the SYN packet, and that
+  // requires sendto().
+  if (num_bufs == 1 || waiting_fastopen_write())
+    return Write(bufs[0], buf_lens[0], callback);
+
+  const int kMaxWritevBuffers = 16;
+  struct iovec iov[kMaxWritevBuffers];
+  num_bufs = std::min(num_bufs, kMaxWritevBuffers);
+  for (int i = 0; i < num_bufs; i++) {
+    DCHECK_GT(buf_lens[i], 0);
+    iov[i].iov_base = bufs[i]->data();
+    iov[i].iov_len = buf_lens[i];
+  }
+
+  int nwrite = HANDLE_EINTR(writev(socket_, iov, num_bufs));
+  if (nwrite >= 0) {
+    base::StatsCounter write_bytes("tcp.write_bytes");
+    write_bytes.Add(nwrite);
+    if (nwrite > 0)
+      use_history_.set_was_used_to_convey_data();
+    int remaining = nwrite;
+    for (int i = 0; i < num_bufs && remaining > 0; i++) {
+      int bytes = std::min(remaining, buf_lens[i]);
+      LogByteTransfer(
+          net_log_, NetLog::TYPE_SOCKET_BYTES_SENT, bytes, bufs[i]->data());
+      remaining -= bytes;
     }
-  } else {
-    nwrite = HANDLE_EINTR(write(socket_, buf->data(), buf_len));
+    return nwrite;
+  }
+  if (errno != EAGAIN && errno != EWOULDBLOCK)
+    return MapSystemError(errno);
+
+  // The socket is not writable; wait for it with a regular write of the first
+  // buffer.
+  return Write(bufs[0], buf_lens[0], callback);
+}
+
+bool TCPClientSocketLibevent::SupportsSendFile() const {
+#if defined(OS_LINUX)
+  return true;
+#else
+  return false;
+#endif
+}
+
+int TCPClientSocketLibevent::SendFile(base::PlatformFile file,
+                                      int64 offset,
+                                      int len,
+                                      CompletionCallback* callback) {
+  DCHECK(CalledOnValidThread());
+  DCHECK_NE(kInvalidSocket, socket_);
+  DCHECK(!waiting_connect());
+  DCHECK(!write_callback_);
+  DCHECK(callback);
+  DCHECK_GT(len, 0);
+
+  // The first write of a fast open socket has to carry data from a buffer.
+  if (waiting_fastopen_write())
+    return ERR_NOT_IMPLEMENTED;
+
+  int nwrite = InternalSendFile(file, offset, len);
+  if (nwrite >= 0) {
+    base::StatsCounter write_bytes("tcp.write_bytes");
+    write_bytes.Add(nwrite);
+    if (nwrite > 0)
+      use_history_.set_was_used_to_convey_data();
+    LogByteTransfer(net_log_, NetLog::TYPE_SOCKET_BYTES_SENT, nwrite, NULL);
+    return nwrite;
   }
-  return nwrite;
+  if (errno == EINVAL || errno == ENOSYS)
+    return ERR_NOT_IMPLEMENTED;
+  if (errno != EAGAIN && errno != EWOULDBLOCK)
+    return MapSystemError(errno);
+
+  if (!MessageLoopForIO::current()->WatchFileDescriptor(
+          socket_, true, MessageLoopForIO::WATCH_WRITE,
+          &write_socket_watcher_, &write_watcher_)) {
+    DVLOG(1) << "WatchFileDescriptor failed on write, errno " << errno;
+    return MapSystemError(errno);
+  }
+
+  write_file_ = file;
+  write_file_offset_ = offset;
+  write_buf_len_ = len;
+  write_callback_ = callback;
+  return ERR_IO_PENDING;
+}
+
+int TCPClientSocketLibevent::InternalSendFile(base::PlatformFile file,
+                                              int64 offset,
+                                              int len) {
+#if defined(OS_LINUX)
+  off_t file_offset = static_cast<off_t>(offset);
+  return HANDLE_EINTR(sendfile(socket_, file, &file_offset, len));
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+int TCPClientSocketLibevent::InternalWrite(IOBuffer* buf, int buf_len) {
+  if (waiting_fastopen_write())
+    return FastOpenWrite(buf, buf_len);
+  return HANDLE_EINTR(write(socket_, buf->data(), buf_len));
+}
+
+int TCPClientSocketLibevent::FastOpenWrite(IOBuffer* buf, int buf_len) {
+  // Whatever happens, the connection is opened by this call.
+  tcp_fastopen_connected_ = true;
+
+  // We have a limited amount of data to send in the SYN packet.
+  buf_len = std::min(kMaxFastOpenSendLength, buf_len);
+
+  int nwrite = HANDLE_EINTR(sendto(socket_,
+                                   buf->data(),
+                                   buf_len,
+                                   MSG_FASTOPEN,
+                                   current_ai_->ai_addr,
+                                   static_cast<int>(current_ai_->ai_addrlen)));
+  if (nwrite >= 0)
+    return nwrite;
+
+  if (errno == EINPROGRESS) {
+    // There is no fast open cookie for the server yet, so the SYN went out
+    // without the data. Wait for the handshake to finish like any other
+    // blocked write; DidCompleteWrite() sends the data with write().
+    errno = EAGAIN;
+    return -1;
+  }
+
+  if (!IsFastOpenUnsupportedError(errno))
+    return -1;
+
+  // Fast open can't be used here, so fall back to a regular connect().
+  DVLOG(1) << "TCP FastOpen failed, errno " << errno;
+  use_tcp_fastopen_ = false;
+  if (HANDLE_EINTR(connect(socket_, current_ai_->ai_addr,
+                           static_cast<int>(current_ai_->ai_addrlen)))) {
+    // An asynchronous connect() looks like a blocked write to the caller. If
+    // it fails, the error comes out of the next write().
+    if (errno == EINPROGRESS)
+      errno = EAGAIN;
+    return -1;
+  }
+  return HANDLE_EINTR(write(socket_, buf->data(), buf_len));
 }
 
 bool TCPClientSocketLibevent::SetReceiveBufferSize(int32 size) {
@@ -571,6 +740,27 @@ void TCPClientSocketLibevent::LogConnectCompletion(int net_error) {
                     make_scoped_refptr(new NetLogStringParameter(
                         "source address",
                         source_address_str)));
+  LogTCPInfo("connect");
+}
+
+void TCPClientSocketLibevent::LogTCPInfo(const char* point) {
+  // Only pay for the getsockopt() when someone is looking.
+  if (!net_log_.IsLoggingAllEvents())
+    return;
+  TCPInfo info;
+  if (!GetTCPInfo(&info))
+    return;
+  net_log_.AddEvent(NetLog::TYPE_TCP_INFO,
+                    make_scoped_refptr(new TCPInfoParameters(point, info)));
+}
+
+void TCPClientSocketLibevent::LogTCPInfoForRead(int bytes_read) {
+  if (bytes_read == 0) {
+    LogTCPInfo("end_of_stream");
+  } else if (!received_first_byte_) {
+    received_first_byte_ = true;
+    LogTCPInfo("first_byte");
+  }
 }
 
 void TCPClientSocketLibevent::DoReadCallback(int rv) {
@@ -630,6 +820,7 @@ void TCPClientSocketLibevent::DidCompleteRead() {
       use_history_.set_was_used_to_convey_data();
     LogByteTransfer(net_log_, NetLog::TYPE_SOCKET_BYTES_RECEIVED, result,
                     read_buf_->data());
+    LogTCPInfoForRead(result);
   } else {
     result = MapSystemError(errno);
   }
@@ -645,8 +836,13 @@ void TCPClientSocketLibevent::DidCompleteRead() {
 
 void TCPClientSocketLibevent::DidCompleteWrite() {
   int bytes_transferred;
-  bytes_transferred = HANDLE_EINTR(write(socket_, write_buf_->data(),
-                                         write_buf_len_));
+  if (write_file_ != base::kInvalidPlatformFileValue) {
+    bytes_transferred = InternalSendFile(write_file_, write_file_offset_,
+                                         write_buf_len_);
+  } else {
+    bytes_transferred = HANDLE_EINTR(write(socket_, write_buf_->data(),
+                                           write_buf_len_));
+  }
 
   int result;
   if (bytes_transferred >= 0) {
@@ -656,7 +852,7 @@ void TCPClientSocketLibevent::DidCompleteWrite() {
     if (bytes_transferred > 0)
       use_history_.set_was_used_to_convey_data();
     LogByteTransfer(net_log_, NetLog::TYPE_SOCKET_BYTES_SENT, result,
-                    write_buf_->data());
+                    write_buf_ ? write_buf_->data() : NULL);
   } else {
     result = MapSystemError(errno);
   }
@@ -664,6 +860,8 @@ void TCPClientSocketLibevent::DidCompleteWrite() {
   if (result != ERR_IO_PENDING) {
     write_buf_ = NULL;
     write_buf_len_ = 0;
+    write_file_ = base::kInvalidPlatformFileValue;
+    write_file_offset_ = 0;
     write_socket_watcher_.StopWatchingFileDescriptor();
     DoWriteCallback(result);
   }
@@ -711,6 +909,28 @@ bool TCPClientSocketLibevent::WasEverUsed() const {
   return use_history_.was_used_to_convey_data();
 }
 
+bool TCPClientSocketLibevent::GetTCPInfo(TCPInfo* info) const {
+  DCHECK(CalledOnValidThread());
+
+#if defined(OS_LINUX)
+  if (socket_ == kInvalidSocket || waiting_connect())
+    return false;
+
+  struct tcp_info tcpi;
+  socklen_t tcpi_len = sizeof(tcpi);
+  if (getsockopt(socket_, IPPROTO_TCP, TCP_INFO, &tcpi, &tcpi_len) != 0)
+    return false;
+
+  info->rtt = base::TimeDelta::FromMicroseconds(tcpi.tcpi_rtt);
+  info->rtt_variance = base::TimeDelta::FromMicroseconds(tcpi.tcpi_rttvar);
+  info->congestion_window = tcpi.tcpi_snd_cwnd;
+  info->total_retransmits = tcpi.tcpi_total_retrans;
+  return true;
+#else
+  return false;
+#endif
+}
+
 bool TCPClientSocketLibevent::UsingTCPFastOpen() const {
   return use_tcp_fastopen_;
 }
@@ -58,12 +58,18 @@ class TCPClientSocketLibevent : public ClientSocket, base::NonThreadSafe {
   virtual void SetOmniboxSpeculation();
   virtual bool WasEverUsed() const;
   virtual bool UsingTCPFastOpen() const;
+  virtual bool GetTCPInfo(TCPInfo* info) const;
 
   // Socket methods:
   // Multiple outstanding requests are not supported.
   // Full duplex mode (reading and writing at the same time) is supported
   virtual int Read(IOBuffer* buf, int buf_len, CompletionCallback* callback);
   virtual int Write(IOBuffer* buf, int buf_len, CompletionCallback* callback);
+  virtual int Writev(IOBuffer* const* bufs, const int* buf_lens, int num_bufs,
+                     CompletionCallback* callback);
+  virtual bool SupportsSendFile() const;
+  virtual int SendFile(base::PlatformFile file, int64 offset, int len,
+                       CompletionCallback* callback);
   virtual bool SetReceiveBufferSize(int32 size);
   virtual bool SetSendBufferSize(int32 size);
 
@@ -136,6 +142,12 @@ class TCPClientSocketLibevent : public ClientSocket, base::NonThreadSafe {
     return next_connect_state_ != CONNECT_STATE_NONE;
   }
 
+  // Returns true if the socket is connected with TCP FastOpen, which doesn't
+  // open the connection until the first write.
+  bool waiting_fastopen_write() const {
+    return use_tcp_fastopen_ && !tcp_fastopen_connected_;
+  }
+
   // Returns the OS error code (or 0 on success).
   int CreateSocket(const struct addrinfo* ai);
 
@@ -145,9 +157,28 @@ class TCPClientSocketLibevent : public ClientSocket, base::NonThreadSafe {
   // Helper to add a TCP_CONNECT (end) event to the NetLog.
   void LogConnectCompletion(int net_error);
 
-  // Internal function to write to a socket.
+  // Adds a TCP_INFO event for |point| to the NetLog, when all events are
+  // being logged.  |point| must be a string literal.
+  void LogTCPInfo(const char* point);
+
+  // Samples TCP_INFO for the first byte received and for the end of the
+  // stream, given the result of a read.
+  void LogTCPInfoForRead(int bytes_read);
+
+  // Internal function to write to a socket. Returns -1 and sets errno on
+  // failure.
   int InternalWrite(IOBuffer* buf, int buf_len);
 
+  // Opens the connection of a TCP FastOpen socket, with up to |buf_len| bytes
+  // of |buf| on the SYN packet. Falls back to a regular connect() if the
+  // kernel or the path doesn't support fast open. Returns like
+  // InternalWrite().
+  int FastOpenWrite(IOBuffer* buf, int buf_len);
+
+  // Internal function to write from a file to a socket. Returns -1 and sets
+  // errno on failure, like InternalWrite().
+  int InternalSendFile(base::PlatformFile file, int64 offset, int len);
+
   int socket_;
 
   // The list of addresses we should try in order to establish a connection.
@@ -172,6 +203,11 @@ class TCPClientSocketLibevent : public ClientSocket, base::NonThreadSafe {
   scoped_refptr<IOBuffer> write_buf_;
   int write_buf_len_;
 
+  // The file used by OnSocketReady to retry SendFile requests, instead of
+  // |write_buf_|.
+  base::PlatformFile write_file_;
+  int64 write_file_offset_;
+
   // External callback; called when read is complete.
   CompletionCallback* read_callback_;
 
@@ -193,12 +229,16 @@ class TCPClientSocketLibevent : public ClientSocket, base::NonThreadSafe {
   // histograms.
   UseHistory use_history_;
 
-  // Enables experimental TCP FastOpen option.
+  // Enables experimental TCP FastOpen option. Cleared if the first write finds
+  // out that fast open can't be used, and falls back to a regular connect().
   bool use_tcp_fastopen_;
 
   // True when TCP FastOpen is in use and we have done the connect.
   bool tcp_fastopen_connected_;
 
+  // True once data has been read from the current connection.
+  bool received_first_byte_;
+
 #ifdef ANDROID
   // True if connect should block and not return before the socket is connected
   bool wait_for_connect_;
@@ -308,6 +308,12 @@ void TCPClientSocketPool::CancelRequest(
   base_.CancelRequest(group_name, handle);
 }
 
+void TCPClientSocketPool::SetPriority(const std::string& group_name,
+                                      ClientSocketHandle* handle,
+                                      RequestPriority priority) {
+  base_.SetPriority(group_name, handle, priority);
+}
+
 void TCPClientSocketPool::ReleaseSocket(
     const std::string& group_name,
     ClientSocket* socket,
@@ -147,6 +147,10 @@ class TCPClientSocketPool : public ClientSocketPool {
   virtual void CancelRequest(const std::string& group_name,
                              ClientSocketHandle* handle);
 
+  virtual void SetPriority(const std::string& group_name,
+                           ClientSocketHandle* handle,
+                           RequestPriority priority);
+
   virtual void ReleaseSocket(const std::string& group_name,
                              ClientSocket* socket,
                              int id);
@@ -0,0 +1,34 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/socket/tcp_info.h"
+
+#include "base/values.h"
+
+namespace net {
+
+TCPInfo::TCPInfo()
+    : congestion_window(0),
+      total_retransmits(0) {
+}
+
+TCPInfoParameters::TCPInfoParameters(const char* point, const TCPInfo& info)
+    : point_(point),
+      info_(info) {
+}
+
+TCPInfoParameters::~TCPInfoParameters() {}
+
+Value* TCPInfoParameters::ToValue() const {
+  DictionaryValue* dict = new DictionaryValue();
+  dict->SetString("point", point_);
+  dict->SetInteger("rtt_us", static_cast<int>(info_.rtt.InMicroseconds()));
+  dict->SetInteger("rtt_variance_us",
+                   static_cast<int>(info_.rtt_variance.InMicroseconds()));
+  dict->SetInteger("congestion_window", info_.congestion_window);
+  dict->SetInteger("total_retransmits", info_.total_retransmits);
+  return dict;
+}
+
+}  // namespace net
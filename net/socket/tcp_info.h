@@ -0,0 +1,45 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_SOCKET_TCP_INFO_H_
+#define NET_SOCKET_TCP_INFO_H_
+#pragma once
+
+#include "base/time.h"
+#include "net/base/net_log.h"
+
+namespace net {
+
+// The kernel's view of a TCP connection, as reported by TCP_INFO.
+struct TCPInfo {
+  TCPInfo();
+
+  // Smoothed round trip time, and its mean deviation.
+  base::TimeDelta rtt;
+  base::TimeDelta rtt_variance;
+
+  // Send congestion window, in segments.
+  int congestion_window;
+
+  // Segments retransmitted since the connection was opened.
+  int total_retransmits;
+};
+
+// NetLog parameters for TYPE_TCP_INFO.  |point| says when the sample was
+// taken, and must be a string literal.
+class TCPInfoParameters : public NetLog::EventParameters {
+ public:
+  TCPInfoParameters(const char* point, const TCPInfo& info);
+  virtual ~TCPInfoParameters();
+
+  virtual Value* ToValue() const;
+
+ private:
+  const char* const point_;
+  const TCPInfo info_;
+};
+
+}  // namespace net
+
+#endif  // NET_SOCKET_TCP_INFO_H_
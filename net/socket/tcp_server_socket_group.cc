@@ -0,0 +1,191 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/socket/tcp_server_socket_group.h"
+
+#include "base/compiler_specific.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/task.h"
+#include "base/threading/thread.h"
+#include "net/base/completion_callback.h"
+#include "net/base/net_errors.h"
+#include "net/socket/client_socket.h"
+#include "net/socket/tcp_server_socket.h"
+
+namespace net {
+
+// Owns one listening socket and the IO thread that accepts on it.  All the
+// socket work happens on that thread.
+class TCPServerSocketGroup::Acceptor
+    : public base::RefCountedThreadSafe<Acceptor> {
+ public:
+  Acceptor(int index, Delegate* delegate, NetLog* net_log)
+      : thread_(base::StringPrintf("TCPServerSocketGroup/%d", index).c_str()),
+        delegate_(delegate),
+        net_log_(net_log),
+        ALLOW_THIS_IN_INITIALIZER_LIST(
+            accept_callback_(this, &Acceptor::OnAcceptComplete)) {
+  }
+
+  // Starts the thread and listens on |address|.  Blocks until the socket is
+  // listening, and stores the address it is bound to in |local_address|.
+  int Listen(const IPEndPoint& address, int backlog, bool reuse_port,
+             IPEndPoint* local_address) {
+    base::Thread::Options options(MessageLoop::TYPE_IO, 0);
+    if (!thread_.StartWithOptions(options))
+      return ERR_FAILED;
+
+    int result = ERR_FAILED;
+    base::WaitableEvent done(false, false);
+    thread_.message_loop()->PostTask(
+        FROM_HERE,
+        NewRunnableMethod(this, &Acceptor::ListenOnThread, address, backlog,
+                          reuse_port, local_address, &result, &done));
+    done.Wait();
+    if (result != OK)
+      thread_.Stop();
+    return result;
+  }
+
+  // Closes the socket and stops the thread.
+  void Stop() {
+    if (!thread_.message_loop())
+      return;
+    thread_.message_loop()->PostTask(
+        FROM_HERE, NewRunnableMethod(this, &Acceptor::CloseOnThread));
+    thread_.Stop();
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<Acceptor>;
+
+  ~Acceptor() {
+    DCHECK(!socket_.get());
+  }
+
+  void ListenOnThread(const IPEndPoint& address, int backlog, bool reuse_port,
+                      IPEndPoint* local_address, int* result,
+                      base::WaitableEvent* done) {
+    socket_.reset(new TCPServerSocket(net_log_, NetLog::Source()));
+    socket_->set_reuse_port(reuse_port);
+    *result = socket_->Listen(address, backlog);
+    if (*result == OK)
+      *result = socket_->GetLocalAddress(local_address);
+    if (*result != OK)
+      socket_.reset();
+    done->Signal();
+    if (socket_.get())
+      DoAccept();
+  }
+
+  void CloseOnThread() {
+    socket_.reset();
+    accepted_socket_.reset();
+  }
+
+  // Accepts connections until one is pending.
+  void DoAccept() {
+    while (true) {
+      int result = socket_->Accept(&accepted_socket_, &accept_callback_);
+      if (result == ERR_IO_PENDING)
+        return;
+      if (!HandleAcceptResult(result))
+        return;
+    }
+  }
+
+  void OnAcceptComplete(int result) {
+    if (HandleAcceptResult(result))
+      DoAccept();
+  }
+
+  // Hands an accepted socket to the delegate.  Returns false if this acceptor
+  // should stop accepting connections.
+  bool HandleAcceptResult(int result) {
+    if (result != OK) {
+      LOG(ERROR) << "Accept failed: " << ErrorToString(result);
+      return false;
+    }
+    delegate_->OnAccept(accepted_socket_.release());
+    return true;
+  }
+
+  base::Thread thread_;
+  Delegate* const delegate_;
+  NetLog* const net_log_;
+
+  scoped_ptr<TCPServerSocket> socket_;
+  scoped_ptr<ClientSocket> accepted_socket_;
+  CompletionCallbackImpl<Acceptor> accept_callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(Acceptor);
+};
+
+TCPServerSocketGroup::TCPServerSocketGroup(int num_acceptors,
+                                           Delegate* delegate,
+                                           NetLog* net_log)
+    : max_acceptors_(num_acceptors),
+      delegate_(delegate),
+      net_log_(net_log) {
+  DCHECK_GT(num_acceptors, 0);
+  DCHECK(delegate);
+}
+
+TCPServerSocketGroup::~TCPServerSocketGroup() {
+  Stop();
+}
+
+int TCPServerSocketGroup::Listen(const IPEndPoint& address, int backlog) {
+  DCHECK(acceptors_.empty());
+
+  // The first acceptor picks the port for the others.
+  bool reuse_port = max_acceptors_ > 1;
+  scoped_refptr<Acceptor> acceptor(new Acceptor(0, delegate_, net_log_));
+  int result = acceptor->Listen(address, backlog, reuse_port, &local_address_);
+  if (result == ERR_NOT_IMPLEMENTED && reuse_port) {
+    // The port can't be shared, so one thread has to do all the work.
+    VLOG(1) << "SO_REUSEPORT is not supported, using a single acceptor";
+    reuse_port = false;
+    acceptor = new Acceptor(0, delegate_, net_log_);
+    result = acceptor->Listen(address, backlog, false, &local_address_);
+  }
+  if (result != OK)
+    return result;
+  acceptors_.push_back(acceptor);
+
+  if (!reuse_port)
+    return OK;
+
+  for (int i = 1; i < max_acceptors_; ++i) {
+    IPEndPoint bound_address;
+    acceptor = new Acceptor(i, delegate_, net_log_);
+    result = acceptor->Listen(local_address_, backlog, true, &bound_address);
+    if (result != OK) {
+      Stop();
+      return result;
+    }
+    acceptors_.push_back(acceptor);
+  }
+  return OK;
+}
+
+int TCPServerSocketGroup::GetLocalAddress(IPEndPoint* address) const {
+  DCHECK(address);
+  if (acceptors_.empty())
+    return ERR_SOCKET_NOT_CONNECTED;
+  *address = local_address_;
+  return OK;
+}
+
+void TCPServerSocketGroup::Stop() {
+  for (size_t i = 0; i < acceptors_.size(); ++i)
+    acceptors_[i]->Stop();
+  acceptors_.clear();
+}
+
+}  // namespace net
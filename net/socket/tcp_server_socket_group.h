@@ -0,0 +1,74 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_SOCKET_TCP_SERVER_SOCKET_GROUP_H_
+#define NET_SOCKET_TCP_SERVER_SOCKET_GROUP_H_
+#pragma once
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "net/base/ip_endpoint.h"
+
+namespace net {
+
+class ClientSocket;
+class NetLog;
+
+// Listens on one address from several IO threads.  Each thread has its own
+// TCPServerSocket, opened with SO_REUSEPORT, so the kernel spreads incoming
+// connections between the threads instead of funneling them through one
+// accept loop.  Where the port can't be shared, a single thread accepts
+// everything.
+//
+// The group itself must be used from a single thread.
+class TCPServerSocketGroup {
+ public:
+  class Delegate {
+   public:
+    // Called on the IO thread that accepted |socket|, which takes ownership
+    // of it.  |socket| must only be used and deleted on that thread, and may
+    // not outlive the group.
+    virtual void OnAccept(ClientSocket* socket) = 0;
+
+   protected:
+    virtual ~Delegate() {}
+  };
+
+  // |delegate| must outlive the group.
+  TCPServerSocketGroup(int num_acceptors, Delegate* delegate, NetLog* net_log);
+  ~TCPServerSocketGroup();
+
+  // Starts the acceptor threads and listens on |address| from each of them.
+  // When the port of |address| is 0, all acceptors share the port picked for
+  // the first one.  Returns a net error code.
+  int Listen(const IPEndPoint& address, int backlog);
+
+  // Gets the address the group is listening on.
+  int GetLocalAddress(IPEndPoint* address) const;
+
+  // Returns the number of threads accepting connections.
+  int num_acceptors() const { return static_cast<int>(acceptors_.size()); }
+
+  // Closes the listening sockets and stops the acceptor threads.  Called by
+  // the destructor.
+  void Stop();
+
+ private:
+  class Acceptor;
+
+  const int max_acceptors_;
+  Delegate* const delegate_;
+  NetLog* const net_log_;
+
+  std::vector<scoped_refptr<Acceptor> > acceptors_;
+  IPEndPoint local_address_;
+
+  DISALLOW_COPY_AND_ASSIGN(TCPServerSocketGroup);
+};
+
+}  // namespace net
+
+#endif  // NET_SOCKET_TCP_SERVER_SOCKET_GROUP_H_
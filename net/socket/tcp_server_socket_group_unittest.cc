@@ -0,0 +1,97 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/socket/tcp_server_socket_group.h"
+
+#include "base/memory/scoped_ptr.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/time.h"
+#include "net/base/address_list.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_util.h"
+#include "net/base/test_completion_callback.h"
+#include "net/socket/client_socket.h"
+#include "net/socket/tcp_client_socket.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/platform_test.h"
+
+namespace net {
+
+namespace {
+
+const int kListenBacklog = 5;
+
+// Counts the accepted connections, and signals once |expected| have come in.
+class CountingDelegate : public TCPServerSocketGroup::Delegate {
+ public:
+  explicit CountingDelegate(int expected)
+      : expected_(expected),
+        accepted_(0),
+        done_(false, false) {
+  }
+
+  virtual void OnAccept(ClientSocket* socket) {
+    delete socket;
+    base::AutoLock lock(lock_);
+    if (++accepted_ == expected_)
+      done_.Signal();
+  }
+
+  bool WaitForConnections() {
+    return done_.TimedWait(base::TimeDelta::FromSeconds(10));
+  }
+
+ private:
+  const int expected_;
+  base::Lock lock_;
+  int accepted_;
+  base::WaitableEvent done_;
+};
+
+class TCPServerSocketGroupTest : public PlatformTest {
+ protected:
+  void ParseAddress(std::string ip_str, int port, IPEndPoint* address) {
+    IPAddressNumber ip_number;
+    bool rv = ParseIPLiteralToNumber(ip_str, &ip_number);
+    if (!rv)
+      return;
+    *address = IPEndPoint(ip_number, port);
+  }
+};
+
+TEST_F(TCPServerSocketGroupTest, AcceptOnAllThreads) {
+  const int kNumAcceptors = 4;
+  const int kNumConnections = 16;
+  CountingDelegate delegate(kNumConnections);
+  TCPServerSocketGroup group(kNumAcceptors, &delegate, NULL);
+
+  IPEndPoint address;
+  ParseAddress("127.0.0.1", 0, &address);
+  ASSERT_EQ(OK, group.Listen(address, kListenBacklog));
+  EXPECT_GE(group.num_acceptors(), 1);
+  EXPECT_LE(group.num_acceptors(), kNumAcceptors);
+
+  IPEndPoint local_address;
+  ASSERT_EQ(OK, group.GetLocalAddress(&local_address));
+  EXPECT_GT(local_address.port(), 0);
+
+  for (int i = 0; i < kNumConnections; ++i) {
+    TestCompletionCallback connect_callback;
+    TCPClientSocket connecting_socket(AddressList(local_address.address(),
+                                                  local_address.port(), false),
+                                      NULL, NetLog::Source());
+    EXPECT_EQ(OK, connect_callback.GetResult(
+        connecting_socket.Connect(&connect_callback)));
+  }
+  EXPECT_TRUE(delegate.WaitForConnections());
+
+  group.Stop();
+  EXPECT_EQ(ERR_SOCKET_NOT_CONNECTED, group.GetLocalAddress(&local_address));
+}
+
+}  // namespace
+
+}  // namespace net
@@ -34,10 +34,15 @@ const int kInvalidSocket = -1;
 
 }  // namespace
 
+#if defined(OS_LINUX) && !defined(SO_REUSEPORT)
+#define SO_REUSEPORT 15
+#endif
+
 TCPServerSocketLibevent::TCPServerSocketLibevent(
     net::NetLog* net_log,
     const net::NetLog::Source& source)
     : socket_(kInvalidSocket),
+      reuse_port_(false),
       accept_socket_(NULL),
       accept_callback_(NULL),
       net_log_(BoundNetLog::Make(net_log, NetLog::SOURCE_SOCKET)) {
@@ -70,6 +75,20 @@ int TCPServerSocketLibevent::Listen(const IPEndPoint& address, int backlog) {
     return result;
   }
 
+  if (reuse_port_) {
+#if defined(SO_REUSEPORT)
+    const int kOn = 1;
+    if (setsockopt(socket_, SOL_SOCKET, SO_REUSEPORT, &kOn, sizeof(kOn)) < 0) {
+      PLOG(ERROR) << "setsockopt(SO_REUSEPORT) returned an error";
+      Close();
+      return ERR_NOT_IMPLEMENTED;
+    }
+#else
+    Close();
+    return ERR_NOT_IMPLEMENTED;
+#endif
+  }
+
   struct sockaddr_storage addr_storage;
   size_t addr_len = sizeof(addr_storage);
   struct sockaddr* addr = reinterpret_cast<struct sockaddr*>(&addr_storage);
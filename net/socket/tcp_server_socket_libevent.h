@@ -24,6 +24,12 @@ class TCPServerSocketLibevent : public ServerSocket,
                           const net::NetLog::Source& source);
   ~TCPServerSocketLibevent();
 
+  // When set before Listen(), the socket is opened with SO_REUSEPORT, so that
+  // several sockets can listen on the same address and the kernel spreads
+  // the incoming connections between them.  Listen() then returns
+  // ERR_NOT_IMPLEMENTED if the system doesn't support this.
+  void set_reuse_port(bool reuse_port) { reuse_port_ = reuse_port; }
+
   // net::ServerSocket implementation.
   virtual int Listen(const net::IPEndPoint& address, int backlog);
   virtual int GetLocalAddress(IPEndPoint* address) const;
@@ -39,6 +45,7 @@ class TCPServerSocketLibevent : public ServerSocket,
   void Close();
 
   int socket_;
+  bool reuse_port_;
 
   MessageLoopForIO::FileDescriptorWatcher accept_socket_watcher_;
 
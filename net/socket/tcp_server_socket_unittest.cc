@@ -12,6 +12,7 @@
 #include "net/base/sys_addrinfo.h"
 #include "net/base/test_completion_callback.h"
 #include "net/socket/tcp_client_socket.h"
+#include "net/socket/tcp_info.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/platform_test.h"
 
@@ -141,6 +142,35 @@ TEST_F(TCPServerSocketTest, Accept2Connections) {
             local_address_.address());
 }
 
+#if defined(OS_LINUX)
+// Both ends of a connection should report TCP_INFO while it is open.
+TEST_F(TCPServerSocketTest, GetTCPInfo) {
+  TestCompletionCallback connect_callback;
+  TCPClientSocket connecting_socket(AddressList(local_address_.address(),
+                                                local_address_.port(), false),
+                                    NULL, NetLog::Source());
+  TCPInfo info;
+  EXPECT_FALSE(connecting_socket.GetTCPInfo(&info));
+  int connect_result = connecting_socket.Connect(&connect_callback);
+
+  TestCompletionCallback accept_callback;
+  scoped_ptr<ClientSocket> accepted_socket;
+  int result = socket_.Accept(&accepted_socket, &accept_callback);
+  if (result == ERR_IO_PENDING)
+    result = accept_callback.WaitForResult();
+  ASSERT_EQ(OK, result);
+  EXPECT_EQ(OK, connect_callback.GetResult(connect_result));
+
+  EXPECT_TRUE(connecting_socket.GetTCPInfo(&info));
+  EXPECT_GT(info.congestion_window, 0);
+  EXPECT_EQ(0, info.total_retransmits);
+  EXPECT_TRUE(accepted_socket->GetTCPInfo(&info));
+
+  connecting_socket.Disconnect();
+  EXPECT_FALSE(connecting_socket.GetTCPInfo(&info));
+}
+#endif
+
 }  // namespace
 
 }  // namespace net
@@ -10,9 +10,11 @@
 #include "base/metrics/histogram.h"
 #include "base/string_util.h"
 #include "base/time.h"
+#include "base/values.h"
 #include "net/base/ip_endpoint.h"
 #include "net/base/net_log.h"
 #include "net/base/net_errors.h"
+#include "net/base/network_quality_estimator.h"
 #include "net/base/sys_addrinfo.h"
 #include "net/socket/client_socket_factory.h"
 #include "net/socket/client_socket_handle.h"
@@ -30,16 +32,27 @@ const int TransportConnectJob::kIPv6FallbackTimerInMs = 300;
 
 namespace {
 
-bool AddressListStartsWithIPv6AndHasAnIPv4Addr(const AddressList& addrlist) {
-  const struct addrinfo* ai = addrlist.head();
-  if (ai->ai_family != AF_INET6)
-    return false;
+// The outcome of a raced connect, for the histograms.
+enum RaceResult {
+  RACE_MAIN_CONNECT_WON,
+  RACE_FALLBACK_CONNECT_WON,
+  RACE_BOTH_CONNECTS_FAILED,
+  RACE_RESULT_MAX,
+};
 
-  ai = ai->ai_next;
-  while (ai) {
-    if (ai->ai_family != AF_INET6)
+bool IsIPv6(const struct addrinfo* ai) {
+  return ai->ai_family == AF_INET6;
+}
+
+const char* AddressFamilyName(const struct addrinfo* ai) {
+  return IsIPv6(ai) ? "ipv6" : "ipv4";
+}
+
+bool AddressListHasAnAddrOfOtherFamily(const AddressList& addrlist) {
+  const struct addrinfo* head = addrlist.head();
+  for (const struct addrinfo* ai = head->ai_next; ai; ai = ai->ai_next) {
+    if (IsIPv6(ai) != IsIPv6(head))
       return true;
-    ai = ai->ai_next;
   }
 
   return false;
@@ -55,6 +68,32 @@ bool AddressListOnlyContainsIPv6Addresses(const AddressList& addrlist) {
   return true;
 }
 
+class NetLogConnectAttemptParameter : public NetLog::EventParameters {
+ public:
+  NetLogConnectAttemptParameter(const char* address_family, int net_error)
+      : address_family_(address_family),
+        net_error_(net_error) {
+  }
+
+  virtual Value* ToValue() const {
+    DictionaryValue* dict = new DictionaryValue();
+    dict->SetString("address_family", address_family_);
+    dict->SetInteger("net_error", net_error_);
+    return dict;
+  }
+
+ private:
+  const char* const address_family_;
+  const int net_error_;
+
+  DISALLOW_COPY_AND_ASSIGN(NetLogConnectAttemptParameter);
+};
+
+void RecordRaceResult(RaceResult result) {
+  UMA_HISTOGRAM_ENUMERATION("Net.TCP_Connection_Race_Result", result,
+                            RACE_RESULT_MAX);
+}
+
 }  // namespace
 
 TransportSocketParams::TransportSocketParams(
@@ -111,6 +150,11 @@ void TransportSocketParams::setUID(uid_t uid) {
 // See comment #12 at http://crbug.com/23364 for specifics.
 static const int kTransportConnectJobTimeoutInSeconds = 240;  // 4 minutes.
 
+// The timeout of TransportConnectJobs started from now on.  See
+// TransportClientSocketPool::set_connect_timeout().
+static int64 g_connect_timeout_ms =
+    kTransportConnectJobTimeoutInSeconds * 1000;
+
 TransportConnectJob::TransportConnectJob(
     const std::string& group_name,
     const scoped_refptr<TransportSocketParams>& params,
@@ -130,7 +174,8 @@ TransportConnectJob::TransportConnectJob(
       ALLOW_THIS_IN_INITIALIZER_LIST(
           fallback_callback_(
               this,
-              &TransportConnectJob::DoIPv6FallbackTransportConnectComplete)) {}
+              &TransportConnectJob::DoIPv6FallbackTransportConnectComplete)),
+      main_connect_result_(OK) {}
 
 TransportConnectJob::~TransportConnectJob() {
   // We don't worry about cancelling the host resolution and TCP connect, since
@@ -153,25 +198,24 @@ LoadState TransportConnectJob::GetLoadState() const {
 
 // static
 void TransportConnectJob::MakeAddrListStartWithIPv4(AddressList* addrlist) {
-  if (addrlist->head()->ai_family != AF_INET6)
-    return;
-  bool has_ipv4 = false;
-  for (const struct addrinfo* ai = addrlist->head(); ai; ai = ai->ai_next) {
-    if (ai->ai_family != AF_INET6) {
-      has_ipv4 = true;
-      break;
-    }
-  }
-  if (!has_ipv4)
+  if (IsIPv6(addrlist->head()))
+    MakeAddrListStartWithOtherFamily(addrlist);
+}
+
+// static
+void TransportConnectJob::MakeAddrListStartWithOtherFamily(
+    AddressList* addrlist) {
+  if (!AddressListHasAnAddrOfOtherFamily(*addrlist))
     return;
 
+  const bool head_is_ipv6 = IsIPv6(addrlist->head());
   struct addrinfo* head = CreateCopyOfAddrinfo(addrlist->head(), true);
   struct addrinfo* tail = head;
   while (tail->ai_next)
     tail = tail->ai_next;
   char* canonname = head->ai_canonname;
   head->ai_canonname = NULL;
-  while (head->ai_family == AF_INET6) {
+  while (IsIPv6(head) == head_is_ipv6) {
     tail->ai_next = head;
     tail = head;
     head = head->ai_next;
@@ -223,11 +267,13 @@ int TransportConnectJob::DoLoop(int result) {
 
 int TransportConnectJob::DoResolveHost() {
   next_state_ = STATE_RESOLVE_HOST_COMPLETE;
+  connect_timing_.dns_start = base::TimeTicks::Now();
   return resolver_.Resolve(params_->destination(), &addresses_, &callback_,
                            net_log());
 }
 
 int TransportConnectJob::DoResolveHostComplete(int result) {
+  connect_timing_.dns_end = base::TimeTicks::Now();
   if (result == OK)
     next_state_ = STATE_TRANSPORT_CONNECT;
   return result;
@@ -238,6 +284,7 @@ int TransportConnectJob::DoTransportConnect() {
   transport_socket_.reset(client_socket_factory_->CreateTransportClientSocket(
         addresses_, net_log().net_log(), net_log().source()));
   connect_start_time_ = base::TimeTicks::Now();
+  connect_timing_.connect_start = connect_start_time_;
 
 #ifdef ANDROID
   uid_t calling_uid = 0;
@@ -251,8 +298,7 @@ int TransportConnectJob::DoTransportConnect() {
                                       , calling_uid
 #endif
                                       );
-  if (rv == ERR_IO_PENDING &&
-      AddressListStartsWithIPv6AndHasAnIPv4Addr(addresses_)) {
+  if (rv == ERR_IO_PENDING && AddressListHasAnAddrOfOtherFamily(addresses_)) {
     fallback_timer_.Start(
         base::TimeDelta::FromMilliseconds(kIPv6FallbackTimerInMs),
         this, &TransportConnectJob::DoIPv6FallbackTransportConnect);
@@ -261,11 +307,16 @@ int TransportConnectJob::DoTransportConnect() {
 }
 
 int TransportConnectJob::DoTransportConnectComplete(int result) {
+  const bool racing = fallback_addresses_.get() != NULL;
+  if (racing)
+    LogAttemptDone(addresses_, result);
+
   if (result == OK) {
-    bool is_ipv4 = addresses_.head()->ai_family != AF_INET6;
+    bool is_ipv4 = !IsIPv6(addresses_.head());
     DCHECK(connect_start_time_ != base::TimeTicks());
     DCHECK(start_time_ != base::TimeTicks());
     base::TimeTicks now = base::TimeTicks::Now();
+    connect_timing_.connect_end = now;
     base::TimeDelta total_duration = now - start_time_;
     UMA_HISTOGRAM_CUSTOM_TIMES(
         "Net.DNS_Resolution_And_TCP_Connection_Latency2",
@@ -280,6 +331,8 @@ int TransportConnectJob::DoTransportConnectComplete(int result) {
         base::TimeDelta::FromMilliseconds(1),
         base::TimeDelta::FromMinutes(10),
         100);
+    NetworkQualityEstimator::GetInstance()->AddConnectTimeSample(
+        connect_duration);
 
     if (is_ipv4) {
       UMA_HISTOGRAM_CUSTOM_TIMES("Net.TCP_Connection_Latency_IPv4_No_Race",
@@ -304,9 +357,22 @@ int TransportConnectJob::DoTransportConnectComplete(int result) {
     }
     set_socket(transport_socket_.release());
     fallback_timer_.Stop();
+    if (racing)
+      RecordRaceResult(RACE_MAIN_CONNECT_WON);
+    // Cancel the losing connect, if it is still running.
+    fallback_transport_socket_.reset();
   } else {
+    transport_socket_.reset();
+    fallback_timer_.Stop();
+    if (fallback_transport_socket_.get()) {
+      // The other family may still make it, so wait for it.
+      main_connect_result_ = result;
+      next_state_ = STATE_TRANSPORT_CONNECT_COMPLETE;
+      return ERR_IO_PENDING;
+    }
+    if (racing)
+      RecordRaceResult(RACE_BOTH_CONNECTS_FAILED);
     // Be a bit paranoid and kill off the fallback members to prevent reuse.
-    fallback_transport_socket_.reset();
     fallback_addresses_.reset();
   }
 
@@ -325,7 +391,12 @@ void TransportConnectJob::DoIPv6FallbackTransportConnect() {
   DCHECK(!fallback_addresses_.get());
 
   fallback_addresses_.reset(new AddressList(addresses_));
-  MakeAddrListStartWithIPv4(fallback_addresses_.get());
+  MakeAddrListStartWithOtherFamily(fallback_addresses_.get());
+  net_log().AddEvent(
+      NetLog::TYPE_TRANSPORT_CONNECT_JOB_FALLBACK_STARTED,
+      make_scoped_refptr(new NetLogStringParameter(
+          "address_family",
+          AddressFamilyName(fallback_addresses_->head()))));
   fallback_transport_socket_.reset(
       client_socket_factory_->CreateTransportClientSocket(
           *fallback_addresses_, net_log().net_log(), net_log().source()));
@@ -358,10 +429,19 @@ void TransportConnectJob::DoIPv6FallbackTransportConnectComplete(int result) {
   DCHECK(fallback_transport_socket_.get());
   DCHECK(fallback_addresses_.get());
 
+  LogAttemptDone(*fallback_addresses_, result);
+
+  if (result != OK && transport_socket_.get()) {
+    // The main connect is still running, so let it finish.
+    fallback_transport_socket_.reset();
+    return;
+  }
+
   if (result == OK) {
     DCHECK(fallback_connect_start_time_ != base::TimeTicks());
     DCHECK(start_time_ != base::TimeTicks());
     base::TimeTicks now = base::TimeTicks::Now();
+    connect_timing_.connect_end = now;
     base::TimeDelta total_duration = now - start_time_;
     UMA_HISTOGRAM_CUSTOM_TIMES(
         "Net.DNS_Resolution_And_TCP_Connection_Latency2",
@@ -377,15 +457,29 @@ void TransportConnectJob::DoIPv6FallbackTransportConnectComplete(int result) {
         base::TimeDelta::FromMinutes(10),
         100);
 
-    UMA_HISTOGRAM_CUSTOM_TIMES("Net.TCP_Connection_Latency_IPv4_Wins_Race",
-        connect_duration,
-        base::TimeDelta::FromMilliseconds(1),
-        base::TimeDelta::FromMinutes(10),
-        100);
+    if (IsIPv6(fallback_addresses_->head())) {
+      UMA_HISTOGRAM_CUSTOM_TIMES("Net.TCP_Connection_Latency_IPv6_Wins_Race",
+          connect_duration,
+          base::TimeDelta::FromMilliseconds(1),
+          base::TimeDelta::FromMinutes(10),
+          100);
+    } else {
+      UMA_HISTOGRAM_CUSTOM_TIMES("Net.TCP_Connection_Latency_IPv4_Wins_Race",
+          connect_duration,
+          base::TimeDelta::FromMilliseconds(1),
+          base::TimeDelta::FromMinutes(10),
+          100);
+    }
+    RecordRaceResult(RACE_FALLBACK_CONNECT_WON);
     set_socket(fallback_transport_socket_.release());
     next_state_ = STATE_NONE;
     transport_socket_.reset();
   } else {
+    // Both connects failed.  Report the error of the main one, which tried
+    // all the addresses.
+    RecordRaceResult(RACE_BOTH_CONNECTS_FAILED);
+    result = main_connect_result_;
+    next_state_ = STATE_NONE;
     // Be a bit paranoid and kill off the fallback members to prevent reuse.
     fallback_transport_socket_.reset();
     fallback_addresses_.reset();
@@ -393,6 +487,14 @@ void TransportConnectJob::DoIPv6FallbackTransportConnectComplete(int result) {
   NotifyDelegateOfCompletion(result);  // Deletes |this|
 }
 
+void TransportConnectJob::LogAttemptDone(const AddressList& addresses,
+                                         int result) {
+  net_log().AddEvent(
+      NetLog::TYPE_TRANSPORT_CONNECT_JOB_ATTEMPT_DONE,
+      make_scoped_refptr(new NetLogConnectAttemptParameter(
+          AddressFamilyName(addresses.head()), result)));
+}
+
 int TransportConnectJob::ConnectInternal() {
   next_state_ = STATE_RESOLVE_HOST;
   start_time_ = base::TimeTicks::Now();
@@ -416,7 +518,7 @@ ConnectJob*
 base::TimeDelta
     TransportClientSocketPool::TransportConnectJobFactory::ConnectionTimeout()
     const {
-  return base::TimeDelta::FromSeconds(kTransportConnectJobTimeoutInSeconds);
+  return TransportClientSocketPool::connect_timeout();
 }
 
 TransportClientSocketPool::TransportClientSocketPool(
@@ -437,6 +539,11 @@ TransportClientSocketPool::TransportClientSocketPool(
 
 TransportClientSocketPool::~TransportClientSocketPool() {}
 
+int TransportClientSocketPool::TakePeakActiveSocketCount(
+    const std::string& group_name) {
+  return base_.TakePeakActiveSocketCount(group_name);
+}
+
 int TransportClientSocketPool::RequestSocket(
     const std::string& group_name,
     const void* params,
@@ -486,6 +593,12 @@ void TransportClientSocketPool::CancelRequest(
   base_.CancelRequest(group_name, handle);
 }
 
+void TransportClientSocketPool::SetPriority(const std::string& group_name,
+                                            ClientSocketHandle* handle,
+                                            RequestPriority priority) {
+  base_.SetPriority(group_name, handle, priority);
+}
+
 void TransportClientSocketPool::ReleaseSocket(
     const std::string& group_name,
     ClientSocket* socket,
@@ -522,6 +635,18 @@ DictionaryValue* TransportClientSocketPool::GetInfoAsValue(
   return base_.GetInfoAsValue(name, type);
 }
 
+// static
+base::TimeDelta TransportClientSocketPool::connect_timeout() {
+  return base::TimeDelta::FromMilliseconds(g_connect_timeout_ms);
+}
+
+// static
+void TransportClientSocketPool::set_connect_timeout(
+    const base::TimeDelta& timeout) {
+  DCHECK_LT(0, timeout.InMilliseconds());
+  g_connect_timeout_ms = timeout.InMilliseconds();
+}
+
 base::TimeDelta TransportClientSocketPool::ConnectionTimeout() const {
   return base_.ConnectionTimeout();
 }
@@ -58,12 +58,13 @@ class TransportSocketParams : public base::RefCounted<TransportSocketParams> {
 
 // TransportConnectJob handles the host resolution necessary for socket creation
 // and the transport (likely TCP) connect. TransportConnectJob also has fallback
-// logic for IPv6 connect() timeouts (which may happen due to networks / routers
-// with broken IPv6 support). Those timeouts take 20s, so rather than make the
-// user wait 20s for the timeout to fire, we use a fallback timer
-// (kIPv6FallbackTimerInMs) and start a connect() to a IPv4 address if the timer
-// fires. Then we race the IPv4 connect() against the IPv6 connect() (which has
-// a headstart) and return the one that completes first to the socket pool.
+// logic for connect() timeouts on one address family (which may happen due to
+// networks / routers with broken IPv6 support). Those timeouts take 20s, so
+// rather than make the user wait 20s for the timeout to fire, we use a fallback
+// timer (kIPv6FallbackTimerInMs) and start a connect() to the first address of
+// the other family if the timer fires. Then we race the two connect()s (the
+// first one has a headstart) and return the one that completes first to the
+// socket pool.  If one of them fails, we keep waiting for the other one.
 class TransportConnectJob : public ConnectJob {
  public:
   TransportConnectJob(const std::string& group_name,
@@ -85,6 +86,12 @@ class TransportConnectJob : public ConnectJob {
   // hack.  It is a public method for the unit tests.
   static void MakeAddrListStartWithIPv4(AddressList* addrlist);
 
+  // Makes |addrlist| start with the first address whose family differs from
+  // the family of its head, by moving the addresses before it to the end.
+  // Does nothing if all the addresses have the same family.  It is a public
+  // method for the unit tests.
+  static void MakeAddrListStartWithOtherFamily(AddressList* addrlist);
+
   static const int kIPv6FallbackTimerInMs;
 
  private:
@@ -110,6 +117,9 @@ class TransportConnectJob : public ConnectJob {
   void DoIPv6FallbackTransportConnect();
   void DoIPv6FallbackTransportConnectComplete(int result);
 
+  // Logs the result of one of the raced connects to |addresses|.
+  void LogAttemptDone(const AddressList& addresses, int result);
+
   // Begins the host resolution and the TCP connect.  Returns OK on success
   // and ERR_IO_PENDING if it cannot immediately service the request.
   // Otherwise, it returns a net error code.
@@ -136,6 +146,10 @@ class TransportConnectJob : public ConnectJob {
   base::TimeTicks fallback_connect_start_time_;
   base::OneShotTimer<TransportConnectJob> fallback_timer_;
 
+  // The result of the first connect if it failed while the fallback connect
+  // was still pending.
+  int main_connect_result_;
+
   DISALLOW_COPY_AND_ASSIGN(TransportConnectJob);
 };
 
@@ -151,6 +165,9 @@ class TransportClientSocketPool : public ClientSocketPool {
 
   virtual ~TransportClientSocketPool();
 
+  // See ClientSocketPoolBaseHelper::TakePeakActiveSocketCount().
+  int TakePeakActiveSocketCount(const std::string& group_name);
+
   // ClientSocketPool methods:
 
   virtual int RequestSocket(const std::string& group_name,
@@ -168,6 +185,10 @@ class TransportClientSocketPool : public ClientSocketPool {
   virtual void CancelRequest(const std::string& group_name,
                              ClientSocketHandle* handle);
 
+  virtual void SetPriority(const std::string& group_name,
+                           ClientSocketHandle* handle,
+                           RequestPriority priority);
+
   virtual void ReleaseSocket(const std::string& group_name,
                              ClientSocket* socket,
                              int id);
@@ -191,6 +212,12 @@ class TransportClientSocketPool : public ClientSocketPool {
 
   virtual ClientSocketPoolHistograms* histograms() const;
 
+  // The time allowed to TransportConnectJobs, including host resolution.
+  // A new timeout applies to the jobs started after it is set.  Must be
+  // called on the IO thread.
+  static base::TimeDelta connect_timeout();
+  static void set_connect_timeout(const base::TimeDelta& timeout);
+
  private:
   typedef ClientSocketPoolBase<TransportSocketParams> PoolBase;
 
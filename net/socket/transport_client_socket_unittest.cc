@@ -281,6 +281,54 @@ TEST_P(TransportClientSocketTest, Read) {
   EXPECT_EQ(0, callback.WaitForResult());
 }
 
+// Writes the request from two buffers with a single Writev().
+TEST_P(TransportClientSocketTest, Writev) {
+  TestCompletionCallback callback;
+  int rv = sock_->Connect(&callback);
+  if (rv != OK) {
+    ASSERT_EQ(rv, ERR_IO_PENDING);
+
+    rv = callback.WaitForResult();
+    EXPECT_EQ(rv, OK);
+  }
+
+  const char request_line[] = "GET / HTTP/1.0\r\n";
+  const char request_end[] = "\r\n";
+  scoped_refptr<IOBuffer> bufs[2];
+  bufs[0] = new IOBuffer(arraysize(request_line) - 1);
+  memcpy(bufs[0]->data(), request_line, arraysize(request_line) - 1);
+  bufs[1] = new IOBuffer(arraysize(request_end) - 1);
+  memcpy(bufs[1]->data(), request_end, arraysize(request_end) - 1);
+
+  IOBuffer* buf_ptrs[] = { bufs[0], bufs[1] };
+  int buf_lens[] = { arraysize(request_line) - 1, arraysize(request_end) - 1 };
+  rv = sock_->Writev(buf_ptrs, buf_lens, arraysize(buf_ptrs), &callback);
+  if (rv == ERR_IO_PENDING)
+    rv = callback.WaitForResult();
+  ASSERT_GT(rv, 0);
+
+  // Send whatever was not written by Writev().
+  int total = buf_lens[0] + buf_lens[1];
+  while (rv < total) {
+    int buf_index = rv < buf_lens[0] ? 0 : 1;
+    int offset = buf_index ? rv - buf_lens[0] : rv;
+    scoped_refptr<IOBuffer> remaining(
+        new WrappedIOBuffer(bufs[buf_index]->data() + offset));
+    int written = sock_->Write(remaining, buf_lens[buf_index] - offset,
+                               &callback);
+    if (written == ERR_IO_PENDING)
+      written = callback.WaitForResult();
+    ASSERT_GT(written, 0);
+    rv += written;
+  }
+  EXPECT_EQ(total, rv);
+
+  scoped_refptr<IOBuffer> buf(new IOBuffer(4096));
+  uint32 bytes_read = DrainClientSocket(buf, 4096, arraysize(kServerReply) - 1,
+                                        &callback);
+  EXPECT_EQ(bytes_read, arraysize(kServerReply) - 1);
+}
+
 TEST_P(TransportClientSocketTest, Read_SmallChunks) {
   TestCompletionCallback callback;
   int rv = sock_->Connect(&callback);
@@ -7,6 +7,7 @@
 
 #include "net/socket_stream/socket_stream.h"
 
+#include <algorithm>
 #include <set>
 #include <string>
 
@@ -34,7 +35,11 @@
 #include "net/url_request/url_request.h"
 
 static const int kMaxPendingSendAllowed = 32768;  // 32 kilobytes.
-static const int kReadBufferSize = 4096;
+// The read buffer starts at the minimum size and is doubled after each read
+// that fills it, up to the maximum.  It is halved after each read that uses
+// less than a quarter of it.
+static const int kMinReadBufferSize = 4096;
+static const int kMaxReadBufferSize = 65536;
 
 namespace net {
 
@@ -65,8 +70,11 @@ SocketStream::SocketStream(const GURL& url, Delegate* delegate)
       ALLOW_THIS_IN_INITIALIZER_LIST(
           write_callback_(this, &SocketStream::OnWriteCompleted)),
       read_buf_(NULL),
+      read_buf_size_(kMinReadBufferSize),
+      read_pending_(false),
       write_buf_(NULL),
       current_write_buf_(NULL),
+      write_buf_capacity_(0),
       write_buf_offset_(0),
       write_buf_size_(0),
       closing_(false),
@@ -154,32 +162,38 @@ bool SocketStream::SendData(const char* data, int len) {
       "The current MessageLoop must be TYPE_IO";
   if (!socket_.get() || !socket_->IsConnected() || next_state_ == STATE_NONE)
     return false;
-  if (write_buf_) {
-    int current_amount_send = write_buf_size_ - write_buf_offset_;
-    for (PendingDataQueue::const_iterator iter = pending_write_bufs_.begin();
-         iter != pending_write_bufs_.end();
-         ++iter)
-      current_amount_send += (*iter)->size();
-
-    current_amount_send += len;
-    if (current_amount_send > max_pending_send_allowed_)
+  if (write_buf_size_ > 0) {
+    if (write_buf_size_ + len > max_pending_send_allowed_)
       return false;
+  } else {
+    // Nothing is queued, so data of any size is taken, as it always has
+    // been.  The buffer is allocated once and reused.
+    DCHECK(!current_write_buf_);
+    write_buf_offset_ = 0;
+    int capacity = std::max(len, max_pending_send_allowed_);
+    if (capacity > write_buf_capacity_) {
+      write_buf_ = new IOBuffer(capacity);
+      write_buf_capacity_ = capacity;
+    }
+  }
 
-    pending_write_bufs_.push_back(make_scoped_refptr(
-        new IOBufferWithSize(len)));
-    memcpy(pending_write_bufs_.back()->data(), data, len);
-    return true;
+  // Copy |data| after the queued data, wrapping around the end of the
+  // buffer.
+  int end = (write_buf_offset_ + write_buf_size_) % write_buf_capacity_;
+  int first_len = std::min(len, write_buf_capacity_ - end);
+  memcpy(write_buf_->data() + end, data, first_len);
+  memcpy(write_buf_->data(), data + first_len, len - first_len);
+  bool was_empty = (write_buf_size_ == 0);
+  write_buf_size_ += len;
+
+  // If a write is in flight, |data| is sent after it.
+  if (was_empty) {
+    // Send pending data asynchronously, so that delegate won't be called
+    // back before returning SendData().
+    MessageLoop::current()->PostTask(
+        FROM_HERE,
+        NewRunnableMethod(this, &SocketStream::DoLoop, OK));
   }
-  DCHECK(!current_write_buf_);
-  write_buf_ = new IOBuffer(len);
-  memcpy(write_buf_->data(), data, len);
-  write_buf_size_ = len;
-  write_buf_offset_ = 0;
-  // Send pending data asynchronously, so that delegate won't be called
-  // back before returning SendData().
-  MessageLoop::current()->PostTask(
-      FROM_HERE,
-      NewRunnableMethod(this, &SocketStream::DoLoop, OK));
   return true;
 }
 
@@ -230,7 +244,12 @@ void SocketStream::DetachDelegate() {
   delegate_ = NULL;
   net_log_.AddEvent(NetLog::TYPE_CANCELLED, NULL);
   // We don't need to send pending data when client detach the delegate.
-  pending_write_bufs_.clear();
+  // Only the write in flight is finished.
+  if (current_write_buf_) {
+    write_buf_size_ = current_write_buf_->BytesRemaining();
+  } else {
+    write_buf_size_ = 0;
+  }
   Close();
 }
 
@@ -313,16 +332,20 @@ int SocketStream::DidEstablishConnection() {
 }
 
 int SocketStream::DidReceiveData(int result) {
-  DCHECK(read_buf_);
+  DCHECK(read_pending_);
   DCHECK_GT(result, 0);
   net_log_.AddEvent(NetLog::TYPE_SOCKET_STREAM_RECEIVED, NULL);
   int len = result;
   metrics_->OnRead(len);
+  read_pending_ = false;
+  if (len == read_buf_size_ && read_buf_size_ < kMaxReadBufferSize)
+    read_buf_size_ *= 2;
+  else if (len < read_buf_size_ / 4 && read_buf_size_ > kMinReadBufferSize)
+    read_buf_size_ /= 2;
   if (delegate_) {
     // Notify recevied data to delegate.
     delegate_->OnReceivedData(this, read_buf_->data(), len);
   }
-  read_buf_ = NULL;
   return OK;
 }
 
@@ -335,20 +358,9 @@ int SocketStream::DidSendData(int result) {
   if (delegate_)
     delegate_->OnSentData(this, len);
 
-  int remaining_size = write_buf_size_ - write_buf_offset_ - len;
-  if (remaining_size == 0) {
-    if (!pending_write_bufs_.empty()) {
-      write_buf_size_ = pending_write_bufs_.front()->size();
-      write_buf_ = pending_write_bufs_.front();
-      pending_write_bufs_.pop_front();
-    } else {
-      write_buf_size_ = 0;
-      write_buf_ = NULL;
-    }
-    write_buf_offset_ = 0;
-  } else {
-    write_buf_offset_ += len;
-  }
+  DCHECK_LE(len, write_buf_size_);
+  write_buf_offset_ = (write_buf_offset_ + len) % write_buf_capacity_;
+  write_buf_size_ -= len;
   return OK;
 }
 
@@ -361,14 +373,14 @@ void SocketStream::OnReadCompleted(int result) {
     // 0 indicates end-of-file, so socket was closed.
     // Don't close the socket if it's still writing.
     server_closed_ = true;
-  } else if (result > 0 && read_buf_) {
+  } else if (result > 0 && read_pending_) {
     result = DidReceiveData(result);
   }
   DoLoop(result);
 }
 
 void SocketStream::OnWriteCompleted(int result) {
-  if (result >= 0 && write_buf_) {
+  if (result >= 0 && current_write_buf_) {
     result = DidSendData(result);
   }
   DoLoop(result);
@@ -873,7 +885,7 @@ int SocketStream::DoReadWrite(int result) {
   // If client has requested close(), and there's nothing to write, then
   // let's close the socket.
   // We don't care about receiving data after the socket is closed.
-  if (closing_ && !write_buf_ && pending_write_bufs_.empty()) {
+  if (closing_ && write_buf_size_ == 0) {
     socket_->Disconnect();
     next_state_ = STATE_CLOSE;
     return OK;
@@ -883,10 +895,12 @@ int SocketStream::DoReadWrite(int result) {
 
   // If server already closed the socket, we don't try to read.
   if (!server_closed_) {
-    if (!read_buf_) {
+    if (!read_pending_) {
       // No read pending and server didn't close the socket.
-      read_buf_ = new IOBuffer(kReadBufferSize);
-      result = socket_->Read(read_buf_, kReadBufferSize, &read_callback_);
+      if (!read_buf_ || read_buf_->size() != read_buf_size_)
+        read_buf_ = new IOBufferWithSize(read_buf_size_);
+      read_pending_ = true;
+      result = socket_->Read(read_buf_, read_buf_size_, &read_callback_);
       if (result > 0) {
         return DidReceiveData(result);
       } else if (result == 0) {
@@ -905,12 +919,16 @@ int SocketStream::DoReadWrite(int result) {
       }
     }
     // Read is pending.
-    DCHECK(read_buf_);
+    DCHECK(read_pending_);
   }
 
-  if (write_buf_ && !current_write_buf_) {
-    // No write pending.
-    current_write_buf_ = new DrainableIOBuffer(write_buf_, write_buf_size_);
+  if (write_buf_size_ > 0 && !current_write_buf_) {
+    // No write pending.  Write all the queued data, up to the end of the
+    // buffer.
+    int len = std::min(write_buf_size_,
+                       write_buf_capacity_ - write_buf_offset_);
+    current_write_buf_ = new DrainableIOBuffer(write_buf_,
+                                               write_buf_offset_ + len);
     current_write_buf_->SetOffset(write_buf_offset_);
     result = socket_->Write(current_write_buf_,
                             current_write_buf_->BytesRemaining(),
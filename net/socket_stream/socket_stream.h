@@ -6,7 +6,6 @@
 #define NET_SOCKET_STREAM_SOCKET_STREAM_H_
 #pragma once
 
-#include <deque>
 #include <map>
 #include <string>
 
@@ -159,7 +158,6 @@ class SocketStream : public base::RefCountedThreadSafe<SocketStream> {
   friend class WebSocketThrottleTest;
 
   typedef std::map<const void*, linked_ptr<UserData> > UserDataMap;
-  typedef std::deque< scoped_refptr<IOBufferWithSize> > PendingDataQueue;
 
   class RequestHeaders : public IOBuffer {
    public:
@@ -308,20 +306,24 @@ class SocketStream : public base::RefCountedThreadSafe<SocketStream> {
   CompletionCallbackImpl<SocketStream> read_callback_;
   CompletionCallbackImpl<SocketStream> write_callback_;
 
-  scoped_refptr<IOBuffer> read_buf_;
+  // |read_buf_| is kept from one read to the next.  Its size,
+  // |read_buf_size_|, grows while reads fill it and shrinks while they use
+  // little of it, so that busy streams read more per call.
+  scoped_refptr<IOBufferWithSize> read_buf_;
   int read_buf_size_;
-
-  // Total amount of buffer (|write_buf_size_| - |write_buf_offset_| +
-  // sum of size of |pending_write_bufs_|) should not exceed
-  // |max_pending_send_allowed_|.
-  // |write_buf_| holds requested data and |current_write_buf_| is used
-  // for Write operation, that is, |current_write_buf_| is
-  // |write_buf_| + |write_buf_offset_|.
+  bool read_pending_;
+
+  // |write_buf_| is a ring buffer of |write_buf_capacity_| bytes holding the
+  // data to send: |write_buf_size_| bytes from |write_buf_offset_|, wrapping
+  // around.  Data given to SendData() while a write is in flight is copied
+  // after it, and sent with the rest of the queued data in one write.
+  // |write_buf_size_| should not exceed |max_pending_send_allowed_|.
+  // |current_write_buf_| is the part of |write_buf_| being written.
   scoped_refptr<IOBuffer> write_buf_;
   scoped_refptr<DrainableIOBuffer> current_write_buf_;
+  int write_buf_capacity_;
   int write_buf_offset_;
   int write_buf_size_;
-  PendingDataQueue pending_write_bufs_;
 
   bool closing_;
   bool server_closed_;
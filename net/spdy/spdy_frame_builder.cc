@@ -20,6 +20,14 @@ SpdyFrameBuilder::SpdyFrameBuilder()
   Resize(kInitialPayload);
 }
 
+SpdyFrameBuilder::SpdyFrameBuilder(size_t size)
+    : buffer_(NULL),
+      capacity_(0),
+      length_(0),
+      variable_buffer_offset_(0) {
+  Resize(size);
+}
+
 SpdyFrameBuilder::SpdyFrameBuilder(const char* data, int data_len)
     : buffer_(const_cast<char*>(data)),
       capacity_(kCapacityReadOnly),
@@ -113,7 +121,7 @@ bool SpdyFrameBuilder::WriteString(const std::string& value) {
   return WriteBytes(value.data(), static_cast<uint16>(value.size()));
 }
 
-bool SpdyFrameBuilder::WriteBytes(const void* data, uint16 data_len) {
+bool SpdyFrameBuilder::WriteBytes(const void* data, uint32 data_len) {
   DCHECK(capacity_ != kCapacityReadOnly);
 
   char* dest = BeginWrite(data_len);
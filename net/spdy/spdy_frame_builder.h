@@ -29,6 +29,11 @@ class SpdyFrameBuilder {
  public:
   SpdyFrameBuilder();
 
+  // Initializes a SpdyFrameBuilder with a buffer of exactly |size| bytes. Use
+  // this when the size of the frame is known up front, so that the buffer is
+  // allocated once and never has to grow.
+  explicit SpdyFrameBuilder(size_t size);
+
   // Initializes a SpdyFrameBuilder from a const block of data.  The data is
   // not copied; instead the data is merely referenced by this
   // SpdyFrameBuilder.  Only const methods should be used when initialized
@@ -72,7 +77,7 @@ class SpdyFrameBuilder {
     return WriteBytes(&value, sizeof(value));
   }
   bool WriteString(const std::string& value);
-  bool WriteBytes(const void* data, uint16 data_len);
+  bool WriteBytes(const void* data, uint32 data_len);
 
   // Write an integer to a particular offset in the data buffer.
   bool WriteUInt32ToOffset(int offset, uint32 value) {
@@ -35,6 +35,22 @@ const int kCompressorLevel = 9;
 const int kCompressorWindowSizeInBits = 11;
 const int kCompressorMemLevel = 1;
 
+// The smallest window that still holds the whole SPDY dictionary.
+const int kLowMemoryCompressorWindowSizeInBits = 10;
+
+// Approximate size of the internal state of a zlib stream, on top of the
+// window and hash buffers. See the memory usage notes in zconf.h.
+const size_t kDeflateStateSize = 6 * 1024;
+const size_t kInflateStateSize = 7 * 1024;
+
+size_t DeflateMemoryUsage(int window_bits, int mem_level) {
+  return kDeflateStateSize + (1 << (window_bits + 2)) + (1 << (mem_level + 9));
+}
+
+size_t InflateMemoryUsage(int window_bits) {
+  return kInflateStateSize + (1 << window_bits);
+}
+
 // Adler ID for the SPDY header compressor dictionary.
 uLong dictionary_id = 0;
 
@@ -62,6 +78,8 @@ const int SpdyFramer::kDictionarySize = arraysize(kDictionary);
 
 // By default is compression on or off.
 bool SpdyFramer::compression_default_ = true;
+SpdyFramer::CompressionMemoryMode
+    SpdyFramer::compression_memory_mode_default_ = COMPRESSION_MEMORY_DEFAULT;
 int SpdyFramer::spdy_version_ = kSpdyProtocolVersion;
 
 // The initial size of the control frame buffer; this is used internally
@@ -153,6 +171,7 @@ SpdyFramer::SpdyFramer()
       current_frame_capacity_(0),
       validate_control_frame_sizes_(true),
       enable_compression_(compression_default_),
+      compression_memory_mode_(compression_memory_mode_default_),
       visitor_(NULL) {
 }
 
@@ -538,7 +557,9 @@ bool SpdyFramer::ParseHeaderBlockInBuffer(const char* header_data,
 SpdySynStreamControlFrame* SpdyFramer::CreateSynStream(
     SpdyStreamId stream_id, SpdyStreamId associated_stream_id, int priority,
     SpdyControlFlags flags, bool compressed, const SpdyHeaderBlock* headers) {
-  SpdyFrameBuilder frame;
+  const size_t frame_size =
+      SpdySynStreamControlFrame::size() + GetSerializedLength(headers);
+  SpdyFrameBuilder frame(frame_size);
 
   DCHECK_GT(stream_id, static_cast<SpdyStreamId>(0));
   DCHECK_EQ(0u, stream_id & ~kStreamIdMask);
@@ -551,14 +572,8 @@ SpdySynStreamControlFrame* SpdyFramer::CreateSynStream(
   frame.WriteUInt32(associated_stream_id);
   frame.WriteUInt16(ntohs(priority) << 6);  // Priority.
 
-  frame.WriteUInt16(headers->size());  // Number of headers.
-  SpdyHeaderBlock::const_iterator it;
-  for (it = headers->begin(); it != headers->end(); ++it) {
-    bool wrote_header;
-    wrote_header = frame.WriteString(it->first);
-    wrote_header &= frame.WriteString(it->second);
-    DCHECK(wrote_header);
-  }
+  WriteHeaderBlock(&frame, headers);
+  DCHECK_EQ(frame_size, static_cast<size_t>(frame.length()));
 
   // Write the length and flags.
   size_t length = frame.length() - SpdyFrame::size();
@@ -583,7 +598,9 @@ SpdySynReplyControlFrame* SpdyFramer::CreateSynReply(SpdyStreamId stream_id,
   DCHECK_GT(stream_id, 0u);
   DCHECK_EQ(0u, stream_id & ~kStreamIdMask);
 
-  SpdyFrameBuilder frame;
+  const size_t frame_size =
+      SpdySynReplyControlFrame::size() + GetSerializedLength(headers);
+  SpdyFrameBuilder frame(frame_size);
 
   frame.WriteUInt16(kControlFlagMask | spdy_version_);
   frame.WriteUInt16(SYN_REPLY);
@@ -591,14 +608,8 @@ SpdySynReplyControlFrame* SpdyFramer::CreateSynReply(SpdyStreamId stream_id,
   frame.WriteUInt32(stream_id);
   frame.WriteUInt16(0);  // Unused
 
-  frame.WriteUInt16(headers->size());  // Number of headers.
-  SpdyHeaderBlock::const_iterator it;
-  for (it = headers->begin(); it != headers->end(); ++it) {
-    bool wrote_header;
-    wrote_header = frame.WriteString(it->first);
-    wrote_header &= frame.WriteString(it->second);
-    DCHECK(wrote_header);
-  }
+  WriteHeaderBlock(&frame, headers);
+  DCHECK_EQ(frame_size, static_cast<size_t>(frame.length()));
 
   // Write the length and flags.
   size_t length = frame.length() - SpdyFrame::size();
@@ -626,7 +637,7 @@ SpdyRstStreamControlFrame* SpdyFramer::CreateRstStream(SpdyStreamId stream_id,
   DCHECK_NE(status, INVALID);
   DCHECK_LT(status, NUM_STATUS_CODES);
 
-  SpdyFrameBuilder frame;
+  SpdyFrameBuilder frame(SpdyRstStreamControlFrame::size());
   frame.WriteUInt16(kControlFlagMask | spdy_version_);
   frame.WriteUInt16(RST_STREAM);
   frame.WriteUInt32(8);
@@ -638,11 +649,11 @@ SpdyRstStreamControlFrame* SpdyFramer::CreateRstStream(SpdyStreamId stream_id,
 /* static */
 SpdySettingsControlFrame* SpdyFramer::CreateSettings(
     const SpdySettings& values) {
-  SpdyFrameBuilder frame;
-  frame.WriteUInt16(kControlFlagMask | spdy_version_);
-  frame.WriteUInt16(SETTINGS);
   size_t settings_size = SpdySettingsControlFrame::size() - SpdyFrame::size() +
       8 * values.size();
+  SpdyFrameBuilder frame(SpdyFrame::size() + settings_size);
+  frame.WriteUInt16(kControlFlagMask | spdy_version_);
+  frame.WriteUInt16(SETTINGS);
   frame.WriteUInt32(settings_size);
   frame.WriteUInt32(values.size());
   SpdySettings::const_iterator it = values.begin();
@@ -656,7 +667,7 @@ SpdySettingsControlFrame* SpdyFramer::CreateSettings(
 
 /* static */
 SpdyNoOpControlFrame* SpdyFramer::CreateNopFrame() {
-  SpdyFrameBuilder frame;
+  SpdyFrameBuilder frame(SpdyNoOpControlFrame::size());
   frame.WriteUInt16(kControlFlagMask | spdy_version_);
   frame.WriteUInt16(NOOP);
   frame.WriteUInt32(0);
@@ -665,7 +676,7 @@ SpdyNoOpControlFrame* SpdyFramer::CreateNopFrame() {
 
 /* static */
 SpdyPingControlFrame* SpdyFramer::CreatePingFrame(uint32 unique_id) {
-  SpdyFrameBuilder frame;
+  SpdyFrameBuilder frame(SpdyPingControlFrame::size());
   frame.WriteUInt16(kControlFlagMask | kSpdyProtocolVersion);
   frame.WriteUInt16(PING);
   size_t ping_size = SpdyPingControlFrame::size() - SpdyFrame::size();
@@ -679,7 +690,7 @@ SpdyGoAwayControlFrame* SpdyFramer::CreateGoAway(
     SpdyStreamId last_accepted_stream_id) {
   DCHECK_EQ(0u, last_accepted_stream_id & ~kStreamIdMask);
 
-  SpdyFrameBuilder frame;
+  SpdyFrameBuilder frame(SpdyGoAwayControlFrame::size());
   frame.WriteUInt16(kControlFlagMask | spdy_version_);
   frame.WriteUInt16(GOAWAY);
   size_t go_away_size = SpdyGoAwayControlFrame::size() - SpdyFrame::size();
@@ -694,21 +705,17 @@ SpdyHeadersControlFrame* SpdyFramer::CreateHeaders(SpdyStreamId stream_id,
   DCHECK_GT(stream_id, 0u);
   DCHECK_EQ(0u, stream_id & ~kStreamIdMask);
 
-  SpdyFrameBuilder frame;
+  const size_t frame_size =
+      SpdyHeadersControlFrame::size() + GetSerializedLength(headers);
+  SpdyFrameBuilder frame(frame_size);
   frame.WriteUInt16(kControlFlagMask | kSpdyProtocolVersion);
   frame.WriteUInt16(HEADERS);
   frame.WriteUInt32(0);  // Placeholder for the length and flags.
   frame.WriteUInt32(stream_id);
   frame.WriteUInt16(0);  // Unused
 
-  frame.WriteUInt16(headers->size());  // Number of headers.
-  SpdyHeaderBlock::const_iterator it;
-  for (it = headers->begin(); it != headers->end(); ++it) {
-    bool wrote_header;
-    wrote_header = frame.WriteString(it->first);
-    wrote_header &= frame.WriteString(it->second);
-    DCHECK(wrote_header);
-  }
+  WriteHeaderBlock(&frame, headers);
+  DCHECK_EQ(frame_size, static_cast<size_t>(frame.length()));
 
   // Write the length and flags.
   size_t length = frame.length() - SpdyFrame::size();
@@ -737,7 +744,7 @@ SpdyWindowUpdateControlFrame* SpdyFramer::CreateWindowUpdate(
   DCHECK_GT(delta_window_size, 0u);
   DCHECK_LE(delta_window_size, spdy::kSpdyStreamMaximumWindowSize);
 
-  SpdyFrameBuilder frame;
+  SpdyFrameBuilder frame(SpdyWindowUpdateControlFrame::size());
   frame.WriteUInt16(kControlFlagMask | spdy_version_);
   frame.WriteUInt16(WINDOW_UPDATE);
   size_t window_update_size = SpdyWindowUpdateControlFrame::size() -
@@ -771,7 +778,7 @@ bool SpdyFramer::ParseSettings(const SpdySettingsControlFrame* frame,
 SpdyDataFrame* SpdyFramer::CreateDataFrame(SpdyStreamId stream_id,
                                            const char* data,
                                            uint32 len, SpdyDataFlags flags) {
-  SpdyFrameBuilder frame;
+  SpdyFrameBuilder frame(SpdyDataFrame::size() + len);
 
   DCHECK_GT(stream_id, 0u);
   DCHECK_EQ(0u, stream_id & ~kStreamIdMask);
@@ -897,6 +904,42 @@ void SpdyFramer::set_enable_compression_default(bool value) {
   compression_default_ = value;
 }
 
+void SpdyFramer::set_compression_memory_mode(CompressionMemoryMode mode) {
+  DCHECK(!header_compressor_.get());
+  DCHECK(stream_compressors_.empty());
+  compression_memory_mode_ = mode;
+}
+
+void SpdyFramer::set_compression_memory_mode_default(
+    CompressionMemoryMode mode) {
+  compression_memory_mode_default_ = mode;
+}
+
+size_t SpdyFramer::GetCompressionMemoryUsage() const {
+  const size_t compressor_size =
+      DeflateMemoryUsage(CompressorWindowSizeInBits(), kCompressorMemLevel);
+  const size_t decompressor_size = InflateMemoryUsage(MAX_WBITS);
+
+  size_t total = stream_compressors_.size() * compressor_size +
+                 stream_decompressors_.size() * decompressor_size;
+  if (header_compressor_.get())
+    total += compressor_size;
+  if (header_decompressor_.get())
+    total += decompressor_size;
+  return total;
+}
+
+void SpdyFramer::ReleaseStreamCompressors(SpdyStreamId stream_id) {
+  CleanupCompressorForStream(stream_id);
+  CleanupDecompressorForStream(stream_id);
+}
+
+int SpdyFramer::CompressorWindowSizeInBits() const {
+  if (compression_memory_mode_ == COMPRESSION_MEMORY_LOW)
+    return kLowMemoryCompressorWindowSizeInBits;
+  return kCompressorWindowSizeInBits;
+}
+
 size_t SpdyFramer::ProcessCommonHeader(const char* data, size_t len) {
   // This should only be called when we're in the SPDY_READING_COMMON_HEADER
   // state.
@@ -1125,7 +1168,7 @@ z_stream* SpdyFramer::GetHeaderCompressor() {
   int success = deflateInit2(header_compressor_.get(),
                              kCompressorLevel,
                              Z_DEFLATED,
-                             kCompressorWindowSizeInBits,
+                             CompressorWindowSizeInBits(),
                              kCompressorMemLevel,
                              Z_DEFAULT_STRATEGY);
   if (success == Z_OK)
@@ -1176,7 +1219,7 @@ z_stream* SpdyFramer::GetStreamCompressor(SpdyStreamId stream_id) {
   int success = deflateInit2(compressor.get(),
                              kCompressorLevel,
                              Z_DEFLATED,
-                             kCompressorWindowSizeInBits,
+                             CompressorWindowSizeInBits(),
                              kCompressorMemLevel,
                              Z_DEFAULT_STRATEGY);
   if (success != Z_OK) {
@@ -1444,7 +1487,8 @@ SpdyFrame* SpdyFramer::CompressFrameWithZStream(const SpdyFrame& frame,
   int compressed_max_size = deflateBound(compressor, payload_length);
   int new_frame_size = header_length + compressed_max_size;
   scoped_ptr<SpdyFrame> new_frame(new SpdyFrame(new_frame_size));
-  memcpy(new_frame->data(), frame.data(), frame.length() + SpdyFrame::size());
+  // Only the header is copied; deflate writes the payload in place.
+  memcpy(new_frame->data(), frame.data(), header_length);
 
   compressor->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(payload));
   compressor->avail_in = payload_length;
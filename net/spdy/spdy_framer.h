@@ -126,6 +126,16 @@ class SpdyFramer {
   // Constant for invalid (or unknown) stream IDs.
   static const SpdyStreamId kInvalidStream;
 
+  // Controls how much memory the zlib compressors of a framer use. The
+  // decompressors always accept the largest window, since it is chosen by the
+  // peer.
+  enum CompressionMemoryMode {
+    COMPRESSION_MEMORY_DEFAULT,
+    // Uses the smallest window that still covers kDictionary. Meant for
+    // servers that keep a large number of mostly idle sessions.
+    COMPRESSION_MEMORY_LOW,
+  };
+
   // The maximum size of header data chunks delivered to the framer visitor
   // through OnControlFrameHeaderData. (It is exposed here for unit test
   // purposes.)
@@ -296,6 +306,19 @@ class SpdyFramer {
   // For ease of testing and experimentation we can tweak compression on/off.
   void set_enable_compression(bool value);
 
+  // Selects the memory used by the compressors of this framer. This must be
+  // called before anything is compressed.
+  void set_compression_memory_mode(CompressionMemoryMode mode);
+  static void set_compression_memory_mode_default(CompressionMemoryMode mode);
+
+  // Returns an estimate of the memory held by the zlib streams of this framer.
+  size_t GetCompressionMemoryUsage() const;
+
+  // Releases the data compressor and decompressor of |stream_id|, if any.
+  // Streams that end with a FIN data frame release them automatically, but
+  // the framer doesn't know about streams that are reset or abandoned.
+  void ReleaseStreamCompressors(SpdyStreamId stream_id);
+
   // SPDY will by default validate the length of incoming control
   // frames. Set validation to false if you do not want this behavior.
   void set_validate_control_frame_sizes(bool value);
@@ -317,6 +340,7 @@ class SpdyFramer {
   FRIEND_TEST_ALL_PREFIXES(SpdyFramerTest, DataCompression);
   FRIEND_TEST_ALL_PREFIXES(SpdyFramerTest, ExpandBuffer_HeapSmash);
   FRIEND_TEST_ALL_PREFIXES(SpdyFramerTest, HugeHeaderBlock);
+  FRIEND_TEST_ALL_PREFIXES(SpdyFramerTest, ReleaseStreamCompressors);
   FRIEND_TEST_ALL_PREFIXES(SpdyFramerTest, UnclosedStreamDataCompressors);
   FRIEND_TEST_ALL_PREFIXES(SpdyFramerTest,
                            UncompressLargerThanFrameBufferInitialSize);
@@ -421,6 +445,9 @@ class SpdyFramer {
   bool GetFrameBoundaries(const SpdyFrame& frame, int* payload_length,
                           int* header_length, const char** payload) const;
 
+  // Returns the window size used by new compressors.
+  int CompressorWindowSizeInBits() const;
+
   int num_stream_compressors() const { return stream_compressors_.size(); }
   int num_stream_decompressors() const { return stream_decompressors_.size(); }
 
@@ -457,6 +484,7 @@ class SpdyFramer {
 
   bool validate_control_frame_sizes_;
   bool enable_compression_;  // Controls all compression
+  CompressionMemoryMode compression_memory_mode_;
   // SPDY header compressors.
   scoped_ptr<z_stream> header_compressor_;
   scoped_ptr<z_stream> header_decompressor_;
@@ -468,6 +496,7 @@ class SpdyFramer {
   SpdyFramerVisitorInterface* visitor_;
 
   static bool compression_default_;
+  static CompressionMemoryMode compression_memory_mode_default_;
   static int spdy_version_;
 };
 
@@ -0,0 +1,288 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "net/spdy/spdy_framer.h"
+#include "net/spdy/spdy_protocol.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace spdy {
+
+namespace {
+
+const int kNumHeaderFrames = 2000;
+const int kDataBytes = 4 * 1024 * 1024;
+const int kNumIterations = 10;
+
+// The size of the reads done by SpdySession.
+const size_t kReadSize = 8 * 1024;
+
+// Headers of a typical browser request.
+const char* const kRequestHeaders[] = {
+  "method", "GET",
+  "url", "/search?q=spdy&ie=utf-8&oe=utf-8&aq=t&rls=org.mozilla:en-US",
+  "version", "HTTP/1.1",
+  "host", "www.google.com",
+  "scheme", "https",
+  "accept", "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8",
+  "accept-charset", "ISO-8859-1,utf-8;q=0.7,*;q=0.3",
+  "accept-encoding", "gzip,deflate,sdch",
+  "accept-language", "en-US,en;q=0.8",
+  "cookie", "PREF=ID=0123456789abcdef:U=fedcba9876543210:FF=0:TM=1300000000:"
+            "LM=1300000001:S=AbCdEfGhIjKlMnOp; NID=45=aBcDeFgHiJkLmNoPqRsTuV"
+            "wXyZ0123456789aBcDeFgHiJkLmNoPqRsTuVwXyZ",
+  "referer", "https://www.google.com/",
+  "user-agent", "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/535.1 (KHTML, "
+                "like Gecko) Chrome/14.0.835.0 Safari/535.1",
+};
+
+// Headers of a typical response.
+const char* const kResponseHeaders[] = {
+  "status", "200 OK",
+  "version", "HTTP/1.1",
+  "cache-control", "private, max-age=0",
+  "content-encoding", "gzip",
+  "content-type", "text/html; charset=UTF-8",
+  "date", "Tue, 12 Jul 2011 18:49:35 GMT",
+  "expires", "-1",
+  "server", "gws",
+  "set-cookie", "NID=48=aBcDeFgHiJkLmNoPqRsTuVwXyZ; expires=Wed, 11-Jan-2012 "
+                "18:49:35 GMT; path=/; domain=.google.com; HttpOnly",
+  "x-xss-protection", "1; mode=block",
+};
+
+void MakeHeaderBlock(const char* const headers[], size_t count,
+                     SpdyHeaderBlock* block) {
+  for (size_t i = 0; i + 1 < count; i += 2)
+    (*block)[headers[i]] = headers[i + 1];
+}
+
+// Returns the size of the headers in |block|, as they'd be sent over HTTP.
+int HeaderBlockSize(const SpdyHeaderBlock& block) {
+  int size = 0;
+  for (SpdyHeaderBlock::const_iterator it = block.begin();
+       it != block.end(); ++it) {
+    size += it->first.size() + it->second.size() + 4;
+  }
+  return size;
+}
+
+// Logs the frame and byte rates of |name| for the time measured by |timer|.
+void LogRates(const std::string& name, const PerfTimer& timer,
+              int64 frames, int64 bytes) {
+  double seconds = std::max(timer.Elapsed().InSecondsF(), 1e-6);
+  LogPerfResult((name + "_frames").c_str(), frames / seconds, "frames/s");
+  LogPerfResult((name + "_bytes").c_str(), bytes / seconds, "bytes/s");
+}
+
+// A visitor that parses the frames as SpdySession does.
+class CountingVisitor : public SpdyFramerVisitorInterface {
+ public:
+  explicit CountingVisitor(SpdyFramer* framer)
+      : framer_(framer),
+        error_count_(0),
+        control_frame_count_(0),
+        header_count_(0),
+        data_bytes_(0) {
+  }
+
+  virtual void OnError(SpdyFramer* framer) {
+    error_count_++;
+  }
+
+  virtual void OnControl(const SpdyControlFrame* frame) {
+    control_frame_count_++;
+    SpdyHeaderBlock headers;
+    if (framer_->ParseHeaderBlock(frame, &headers))
+      header_count_ += headers.size();
+    else
+      error_count_++;
+  }
+
+  virtual bool OnControlFrameHeaderData(SpdyStreamId stream_id,
+                                        const char* header_data,
+                                        size_t len) {
+    return true;
+  }
+
+  virtual void OnDataFrameHeader(const SpdyDataFrame* frame) {}
+
+  virtual void OnStreamFrameData(SpdyStreamId stream_id,
+                                 const char* data,
+                                 size_t len) {
+    data_bytes_ += len;
+  }
+
+  int error_count() const { return error_count_; }
+  int control_frame_count() const { return control_frame_count_; }
+  int header_count() const { return header_count_; }
+  int64 data_bytes() const { return data_bytes_; }
+
+ private:
+  SpdyFramer* framer_;
+  int error_count_;
+  int control_frame_count_;
+  int header_count_;
+  int64 data_bytes_;
+};
+
+// Feeds |input| to |framer| in reads of |kReadSize| bytes.
+void ProcessInChunks(SpdyFramer* framer, const std::string& input) {
+  for (size_t offset = 0; offset < input.size(); offset += kReadSize) {
+    size_t len = std::min(kReadSize, input.size() - offset);
+    size_t processed = 0;
+    while (processed < len && !framer->HasError()) {
+      processed += framer->ProcessInput(input.data() + offset + processed,
+                                        len - processed);
+    }
+    ASSERT_FALSE(framer->HasError());
+  }
+}
+
+// Measures building |kNumHeaderFrames| SYN_STREAM frames with |headers|.
+void CreateSynStreams(const char* name, const char* const headers[],
+                      size_t count, bool compressed) {
+  SpdyHeaderBlock block;
+  MakeHeaderBlock(headers, count, &block);
+
+  for (int iteration = 0; iteration < kNumIterations; ++iteration) {
+    SpdyFramer framer;
+    int64 bytes = 0;
+    PerfTimer timer;
+    for (int i = 0; i < kNumHeaderFrames; ++i) {
+      scoped_ptr<SpdyFrame> frame(framer.CreateSynStream(
+          2 * i + 1, 0, 0, CONTROL_FLAG_FIN, compressed, &block));
+      ASSERT_TRUE(frame.get() != NULL);
+      bytes += frame->length() + SpdyFrame::size();
+    }
+    if (iteration == kNumIterations - 1) {
+      LogRates(name, timer, kNumHeaderFrames, bytes);
+      LogPerfResult(base::StringPrintf("%s_ratio", name).c_str(),
+                    100.0 * bytes / (kNumHeaderFrames * HeaderBlockSize(block)),
+                    "%");
+    }
+  }
+}
+
+// Measures parsing |kNumHeaderFrames| SYN_STREAM frames with |headers|,
+// including the decompression of their header blocks.
+void ProcessSynStreams(const char* name, const char* const headers[],
+                       size_t count, bool compressed) {
+  SpdyHeaderBlock block;
+  MakeHeaderBlock(headers, count, &block);
+
+  // The frames share one compression context, so they must be parsed in
+  // order by a single framer.
+  std::string input;
+  {
+    SpdyFramer framer;
+    for (int i = 0; i < kNumHeaderFrames; ++i) {
+      scoped_ptr<SpdyFrame> frame(framer.CreateSynStream(
+          2 * i + 1, 0, 0, CONTROL_FLAG_FIN, compressed, &block));
+      input.append(frame->data(), frame->length() + SpdyFrame::size());
+    }
+  }
+
+  for (int iteration = 0; iteration < kNumIterations; ++iteration) {
+    SpdyFramer framer;
+    CountingVisitor visitor(&framer);
+    framer.set_visitor(&visitor);
+    PerfTimer timer;
+    ProcessInChunks(&framer, input);
+    if (iteration == kNumIterations - 1)
+      LogRates(name, timer, kNumHeaderFrames, input.size());
+    EXPECT_EQ(0, visitor.error_count());
+    EXPECT_EQ(kNumHeaderFrames, visitor.control_frame_count());
+    EXPECT_EQ(static_cast<int>(kNumHeaderFrames * block.size()),
+              visitor.header_count());
+  }
+}
+
+// Measures building and parsing |kDataBytes| of DATA frames of |frame_size|.
+void CreateAndProcessData(const char* name, int frame_size) {
+  const std::string payload(frame_size, 'a');
+  const int num_frames = kDataBytes / frame_size;
+
+  std::string input;
+  for (int iteration = 0; iteration < kNumIterations; ++iteration) {
+    SpdyFramer framer;
+    input.clear();
+    PerfTimer timer;
+    for (int i = 0; i < num_frames; ++i) {
+      scoped_ptr<SpdyFrame> frame(framer.CreateDataFrame(
+          1, payload.data(), frame_size, DATA_FLAG_NONE));
+      input.append(frame->data(), frame->length() + SpdyFrame::size());
+    }
+    if (iteration == kNumIterations - 1) {
+      LogRates(base::StringPrintf("%s_create", name), timer, num_frames,
+               input.size());
+    }
+  }
+
+  for (int iteration = 0; iteration < kNumIterations; ++iteration) {
+    SpdyFramer framer;
+    CountingVisitor visitor(&framer);
+    framer.set_visitor(&visitor);
+    PerfTimer timer;
+    ProcessInChunks(&framer, input);
+    if (iteration == kNumIterations - 1) {
+      LogRates(base::StringPrintf("%s_process", name), timer, num_frames,
+               input.size());
+    }
+    EXPECT_EQ(0, visitor.error_count());
+    EXPECT_EQ(static_cast<int64>(num_frames) * frame_size,
+              visitor.data_bytes());
+  }
+}
+
+}  // namespace
+
+TEST(SpdyFramerPerfTest, CreateRequestHeaders) {
+  CreateSynStreams("Spdy_create_request_headers", kRequestHeaders,
+                   arraysize(kRequestHeaders), true);
+}
+
+TEST(SpdyFramerPerfTest, CreateRequestHeadersUncompressed) {
+  CreateSynStreams("Spdy_create_request_headers_uncompressed",
+                   kRequestHeaders, arraysize(kRequestHeaders), false);
+}
+
+TEST(SpdyFramerPerfTest, CreateResponseHeaders) {
+  CreateSynStreams("Spdy_create_response_headers", kResponseHeaders,
+                   arraysize(kResponseHeaders), true);
+}
+
+TEST(SpdyFramerPerfTest, ProcessRequestHeaders) {
+  ProcessSynStreams("Spdy_process_request_headers", kRequestHeaders,
+                    arraysize(kRequestHeaders), true);
+}
+
+TEST(SpdyFramerPerfTest, ProcessRequestHeadersUncompressed) {
+  ProcessSynStreams("Spdy_process_request_headers_uncompressed",
+                    kRequestHeaders, arraysize(kRequestHeaders), false);
+}
+
+TEST(SpdyFramerPerfTest, ProcessResponseHeaders) {
+  ProcessSynStreams("Spdy_process_response_headers", kResponseHeaders,
+                    arraysize(kResponseHeaders), true);
+}
+
+TEST(SpdyFramerPerfTest, SmallDataFrames) {
+  CreateAndProcessData("Spdy_small_data_frames", 256);
+}
+
+TEST(SpdyFramerPerfTest, TypicalDataFrames) {
+  CreateAndProcessData("Spdy_typical_data_frames", 4 * 1024);
+}
+
+TEST(SpdyFramerPerfTest, LargeDataFrames) {
+  CreateAndProcessData("Spdy_large_data_frames", 64 * 1024);
+}
+
+}  // namespace spdy
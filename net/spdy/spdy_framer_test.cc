@@ -741,6 +741,59 @@ TEST_F(SpdyFramerTest, UnclosedStreamDataCompressors) {
   EXPECT_EQ(0, send_framer.num_stream_decompressors());
 }
 
+TEST_F(SpdyFramerTest, ReleaseStreamCompressors) {
+  SpdyFramer send_framer;
+  FramerSetEnableCompressionHelper(&send_framer, true);
+
+  const char bytes[] = "this is a test test test test test!";
+  scoped_ptr<SpdyFrame> data_frame(
+      send_framer.CreateDataFrame(1, bytes, arraysize(bytes),
+                                  DATA_FLAG_COMPRESSED));
+  EXPECT_TRUE(data_frame.get() != NULL);
+  EXPECT_EQ(1, send_framer.num_stream_compressors());
+  size_t memory = send_framer.GetCompressionMemoryUsage();
+  EXPECT_LT(0u, memory);
+
+  // The stream never sent a FIN, so its compressor is still around.
+  send_framer.ReleaseStreamCompressors(1);
+  EXPECT_EQ(0, send_framer.num_stream_compressors());
+  EXPECT_GT(memory, send_framer.GetCompressionMemoryUsage());
+}
+
+TEST_F(SpdyFramerTest, LowMemoryCompression) {
+  SpdyHeaderBlock headers;
+  headers["method"] = "GET";
+  headers["url"] = "http://www.google.com/";
+  headers["version"] = "HTTP/1.1";
+  headers["accept-encoding"] = "gzip,deflate";
+
+  SpdyFramer default_framer;
+  SpdyFramer low_memory_framer;
+  SpdyFramer recv_framer;
+  FramerSetEnableCompressionHelper(&default_framer, true);
+  FramerSetEnableCompressionHelper(&low_memory_framer, true);
+  FramerSetEnableCompressionHelper(&recv_framer, true);
+  low_memory_framer.set_compression_memory_mode(
+      SpdyFramer::COMPRESSION_MEMORY_LOW);
+
+  scoped_ptr<SpdySynStreamControlFrame> default_frame(
+      default_framer.CreateSynStream(1, 0, 1, CONTROL_FLAG_NONE, true,
+                                     &headers));
+  scoped_ptr<SpdySynStreamControlFrame> low_memory_frame(
+      low_memory_framer.CreateSynStream(1, 0, 1, CONTROL_FLAG_NONE, true,
+                                        &headers));
+  ASSERT_TRUE(default_frame.get() != NULL);
+  ASSERT_TRUE(low_memory_frame.get() != NULL);
+  EXPECT_GT(default_framer.GetCompressionMemoryUsage(),
+            low_memory_framer.GetCompressionMemoryUsage());
+
+  // A regular framer can read the headers.
+  SpdyHeaderBlock parsed_headers;
+  EXPECT_TRUE(recv_framer.ParseHeaderBlock(low_memory_frame.get(),
+                                           &parsed_headers));
+  EXPECT_EQ(headers, parsed_headers);
+}
+
 TEST_F(SpdyFramerTest, CreateDataFrame) {
   SpdyFramer framer;
 
@@ -807,6 +860,18 @@ TEST_F(SpdyFramerTest, CreateDataFrame) {
   }
 }
 
+TEST_F(SpdyFramerTest, CreateLargeDataFrame) {
+  SpdyFramer framer;
+
+  // The payload does not fit in 16 bits.
+  const std::string payload(0x12345, 'a');
+  scoped_ptr<SpdyDataFrame> frame(framer.CreateDataFrame(
+      1, payload.data(), payload.size(), DATA_FLAG_NONE));
+  ASSERT_TRUE(frame.get() != NULL);
+  EXPECT_EQ(payload.size(), frame->length());
+  EXPECT_EQ(payload, std::string(frame->payload(), frame->length()));
+}
+
 TEST_F(SpdyFramerTest, CreateSynStreamUncompressed) {
   SpdyFramer framer;
   FramerSetEnableCompressionHelper(&framer, false);
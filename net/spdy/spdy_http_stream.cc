@@ -13,6 +13,7 @@
 #include "net/base/address_list.h"
 #include "net/base/host_port_pair.h"
 #include "net/base/load_flags.h"
+#include "net/base/load_timing_info.h"
 #include "net/base/net_util.h"
 #include "net/http/http_request_headers.h"
 #include "net/http/http_request_info.h"
@@ -112,20 +113,13 @@ int SpdyHttpStream::ReadResponseBody(
   if (!response_body_.empty()) {
     int bytes_read = 0;
     while (!response_body_.empty() && buf_len > 0) {
-      scoped_refptr<IOBufferWithSize> data = response_body_.front();
-      const int bytes_to_copy = std::min(buf_len, data->size());
+      DrainableIOBuffer* data = response_body_.front();
+      const int bytes_to_copy = std::min(buf_len, data->BytesRemaining());
       memcpy(&(buf->data()[bytes_read]), data->data(), bytes_to_copy);
       buf_len -= bytes_to_copy;
-      if (bytes_to_copy == data->size()) {
+      data->DidConsume(bytes_to_copy);
+      if (!data->BytesRemaining())
         response_body_.pop_front();
-      } else {
-        const int bytes_remaining = data->size() - bytes_to_copy;
-        IOBufferWithSize* new_buffer = new IOBufferWithSize(bytes_remaining);
-        memcpy(new_buffer->data(), &(data->data()[bytes_to_copy]),
-               bytes_remaining);
-        response_body_.pop_front();
-        response_body_.push_front(make_scoped_refptr(new_buffer));
-      }
       bytes_read += bytes_to_copy;
     }
     if (SpdySession::flow_control())
@@ -177,6 +171,13 @@ void SpdyHttpStream::SetConnectionReused() {
   // SPDY doesn't need an indicator here.
 }
 
+void SpdyHttpStream::GetLoadTimingInfo(
+    LoadTimingInfo* load_timing_info) const {
+  load_timing_info->socket_reused = spdy_session_->IsReused();
+  load_timing_info->connect_timing = load_timing_info->socket_reused ?
+      LoadTimingInfo::ConnectTiming() : spdy_session_->connect_timing();
+}
+
 bool SpdyHttpStream::IsConnectionReusable() const {
   // SPDY streams aren't considered reusable.
   return false;
@@ -344,7 +345,7 @@ int SpdyHttpStream::OnResponseReceived(const spdy::SpdyHeaderBlock& response,
   return status;
 }
 
-void SpdyHttpStream::OnDataReceived(const char* data, int length) {
+void SpdyHttpStream::OnDataReceived(DrainableIOBuffer* buffer) {
   // SpdyStream won't call us with data if the header block didn't contain a
   // valid set of headers.  So we don't expect to not have headers received
   // here.
@@ -354,11 +355,10 @@ void SpdyHttpStream::OnDataReceived(const char* data, int length) {
   // ReadResponseBody(), therefore user_buffer_ may be NULL.  This may often
   // happen for server initiated streams.
   DCHECK(!stream_->closed() || stream_->pushed());
-  if (length > 0) {
-    // Save the received data.
-    IOBufferWithSize* io_buffer = new IOBufferWithSize(length);
-    memcpy(io_buffer->data(), data, length);
-    response_body_.push_back(make_scoped_refptr(io_buffer));
+  if (buffer) {
+    // Save the received data. The buffer may be a slice of the session's read
+    // buffer, so it is kept as is rather than copied.
+    response_body_.push_back(make_scoped_refptr(buffer));
 
     if (user_buffer_) {
       // Handing small chunks of data to the caller creates measurable overhead.
@@ -408,11 +408,11 @@ bool SpdyHttpStream::ShouldWaitForMoreBufferedData() const {
     return false;
 
   int bytes_buffered = 0;
-  std::list<scoped_refptr<IOBufferWithSize> >::const_iterator it;
+  std::list<scoped_refptr<DrainableIOBuffer> >::const_iterator it;
   for (it = response_body_.begin();
        it != response_body_.end() && bytes_buffered < user_buffer_len_;
        ++it)
-    bytes_buffered += (*it)->size();
+    bytes_buffered += (*it)->BytesRemaining();
 
   return bytes_buffered < user_buffer_len_;
 }
@@ -468,6 +468,13 @@ void SpdyHttpStream::GetSSLCertRequestInfo(
   stream_->GetSSLCertRequestInfo(cert_request_info);
 }
 
+void SpdyHttpStream::SetPriority(RequestPriority priority) {
+  // A stream that is still queued in the session keeps the priority it was
+  // requested with.
+  if (stream_.get())
+    stream_->set_priority(priority);
+}
+
 bool SpdyHttpStream::IsSpdyHttpStream() const {
   return true;
 }
@@ -64,9 +64,12 @@ class SpdyHttpStream : public SpdyStream::Delegate, public HttpStream {
   virtual bool IsConnectionReused() const OVERRIDE;
   virtual void SetConnectionReused() OVERRIDE;
   virtual bool IsConnectionReusable() const OVERRIDE;
+  virtual void GetLoadTimingInfo(
+      LoadTimingInfo* load_timing_info) const OVERRIDE;
   virtual void GetSSLInfo(SSLInfo* ssl_info) OVERRIDE;
   virtual void GetSSLCertRequestInfo(
       SSLCertRequestInfo* cert_request_info) OVERRIDE;
+  virtual void SetPriority(RequestPriority priority) OVERRIDE;
   virtual bool IsSpdyHttpStream() const OVERRIDE;
 
   // SpdyStream::Delegate methods:
@@ -76,7 +79,7 @@ class SpdyHttpStream : public SpdyStream::Delegate, public HttpStream {
   virtual int OnResponseReceived(const spdy::SpdyHeaderBlock& response,
                                  base::Time response_time,
                                  int status) OVERRIDE;
-  virtual void OnDataReceived(const char* buffer, int bytes) OVERRIDE;
+  virtual void OnDataReceived(DrainableIOBuffer* buffer) OVERRIDE;
   virtual void OnDataSent(int length) OVERRIDE;
   virtual void OnClose(int status) OVERRIDE;
   virtual void set_chunk_callback(ChunkCallback* callback) OVERRIDE;
@@ -114,7 +117,7 @@ class SpdyHttpStream : public SpdyStream::Delegate, public HttpStream {
 
   // We buffer the response body as it arrives asynchronously from the stream.
   // TODO(mbelshe):  is this infinite buffering?
-  std::list<scoped_refptr<IOBufferWithSize> > response_body_;
+  std::list<scoped_refptr<DrainableIOBuffer> > response_body_;
 
   CompletionCallback* user_callback_;
 
@@ -447,14 +447,10 @@ int SpdyProxyClientSocket::OnResponseReceived(
 }
 
 // Called when data is received.
-void SpdyProxyClientSocket::OnDataReceived(const char* data, int length) {
-  if (length > 0) {
-    // Save the received data.
-    scoped_refptr<IOBuffer> io_buffer(new IOBuffer(length));
-    memcpy(io_buffer->data(), data, length);
-    read_buffer_.push_back(
-        make_scoped_refptr(new DrainableIOBuffer(io_buffer, length)));
-  }
+void SpdyProxyClientSocket::OnDataReceived(DrainableIOBuffer* buffer) {
+  // Save the received data.
+  if (buffer)
+    read_buffer_.push_back(make_scoped_refptr(buffer));
 
   if (read_callback_) {
     int rv = PopulateUserReadBuffer();
@@ -508,7 +504,7 @@ void SpdyProxyClientSocket::OnClose(int status)  {
     read_callback->Run(status);
   } else if (read_callback_) {
     // If we have a read_callback, the we need to make sure we call it back
-    OnDataReceived(NULL, 0);
+    OnDataReceived(NULL);
   }
   if (write_callback)
     write_callback->Run(ERR_CONNECTION_CLOSED);
@@ -98,7 +98,7 @@ class SpdyProxyClientSocket : public ProxyClientSocket,
   virtual int OnResponseReceived(const spdy::SpdyHeaderBlock& response,
                                  base::Time response_time,
                                  int status);
-  virtual void OnDataReceived(const char* data, int length);
+  virtual void OnDataReceived(DrainableIOBuffer* buffer);
   virtual void OnDataSent(int length);
   virtual void OnClose(int status);
   virtual void set_chunk_callback(ChunkCallback* /*callback*/);
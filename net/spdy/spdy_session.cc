@@ -4,6 +4,8 @@
 
 #include "net/spdy/spdy_session.h"
 
+#include <algorithm>
+
 #include "base/basictypes.h"
 #include "base/logging.h"
 #include "base/memory/linked_ptr.h"
@@ -21,6 +23,7 @@
 #include "net/base/net_log.h"
 #include "net/base/net_util.h"
 #include "net/http/http_network_session.h"
+#include "net/http/http_response_info.h"
 #include "net/socket/ssl_client_socket.h"
 #include "net/spdy/spdy_frame_builder.h"
 #include "net/spdy/spdy_http_utils.h"
@@ -65,6 +68,23 @@ namespace {
 
 const int kReadBufferSize = 8 * 1024;
 
+// An IOBuffer that owns the SpdyFrame it points to, so that frames can be
+// queued and written without being copied.
+class SpdyFrameIOBuffer : public WrappedIOBuffer {
+ public:
+  explicit SpdyFrameIOBuffer(spdy::SpdyFrame* frame)
+      : WrappedIOBuffer(frame->data()),
+        frame_(frame) {
+  }
+
+ private:
+  virtual ~SpdyFrameIOBuffer() {}
+
+  scoped_ptr<spdy::SpdyFrame> frame_;
+
+  DISALLOW_COPY_AND_ASSIGN(SpdyFrameIOBuffer);
+};
+
 class NetLogSpdySessionParameter : public NetLog::EventParameters {
  public:
   NetLogSpdySessionParameter(const HostPortProxyPair& host_pair)
@@ -216,6 +236,41 @@ class NetLogSpdyGoAwayParameter : public NetLog::EventParameters {
   DISALLOW_COPY_AND_ASSIGN(NetLogSpdyGoAwayParameter);
 };
 
+class NetLogSpdyWriteQueueStatsParameter : public NetLog::EventParameters {
+ public:
+  explicit NetLogSpdyWriteQueueStatsParameter(const SpdyWriteQueue& queue) {
+    for (int i = 0; i < NUM_PRIORITIES; ++i)
+      stats_[i] = queue.stats(i);
+  }
+
+  virtual Value* ToValue() const {
+    ListValue* levels = new ListValue();
+    for (int i = 0; i < NUM_PRIORITIES; ++i) {
+      const SpdyWriteQueue::Stats& stats = stats_[i];
+      if (!stats.frames)
+        continue;
+      DictionaryValue* level = new DictionaryValue();
+      level->SetInteger("priority", i);
+      level->SetInteger("frames", stats.frames);
+      level->SetInteger(
+          "average_delay_ms",
+          static_cast<int>(stats.total_delay.InMilliseconds() / stats.frames));
+      level->SetInteger("max_delay_ms",
+                        static_cast<int>(stats.max_delay.InMilliseconds()));
+      levels->Append(level);
+    }
+    DictionaryValue* dict = new DictionaryValue();
+    dict->Set("priorities", levels);
+    return dict;
+  }
+
+ private:
+  ~NetLogSpdyWriteQueueStatsParameter() {}
+  SpdyWriteQueue::Stats stats_[NUM_PRIORITIES];
+
+  DISALLOW_COPY_AND_ASSIGN(NetLogSpdyWriteQueueStatsParameter);
+};
+
 }  // namespace
 
 // static
@@ -231,14 +286,29 @@ size_t SpdySession::max_concurrent_stream_limit_ = 256;
 bool SpdySession::enable_ping_based_connection_checking_ = true;
 
 // static
-int SpdySession::connection_at_risk_of_loss_ms_ = 0;
+int SpdySession::connection_at_risk_of_loss_ms_ = 10000;
 
 // static
 int SpdySession::trailing_ping_delay_time_ms_ = 1000;
 
+// static
+int SpdySession::max_data_frame_size_ = kMaxSpdyFrameChunkSize;
+
+// static
+bool SpdySession::use_recv_window_autotuning_ = false;
+
+// static
+int SpdySession::max_recv_window_size_ = 16 * 1024 * 1024;
+
+// static
+int SpdySession::max_session_recv_window_memory_ = 32 * 1024 * 1024;
+
 // static
 int SpdySession::hung_interval_ms_ = 10000;
 
+// static
+int SpdySession::min_hung_interval_ms_ = 2000;
+
 SpdySession::SpdySession(const HostPortProxyPair& host_port_proxy_pair,
                          SpdySessionPool* spdy_session_pool,
                          SpdySettingsStorage* spdy_settings,
@@ -279,6 +349,7 @@ SpdySession::SpdySession(const HostPortProxyPair& host_port_proxy_pair,
       need_to_send_ping_(false),
       initial_send_window_size_(spdy::kSpdyStreamInitialWindowSize),
       initial_recv_window_size_(spdy::kSpdyStreamInitialWindowSize),
+      recv_window_growth_(0),
       net_log_(BoundNetLog::Make(net_log, NetLog::SOURCE_SPDY_SESSION)) {
   DCHECK(HttpStreamFactory::spdy_enabled());
   net_log_.BeginEvent(
@@ -314,7 +385,15 @@ SpdySession::~SpdySession() {
 
   RecordHistograms();
 
-  net_log_.EndEvent(NetLog::TYPE_SPDY_SESSION, NULL);
+  net_log_.AddEvent(
+      NetLog::TYPE_SPDY_SESSION_WRITE_QUEUE_STATS,
+      make_scoped_refptr(new NetLogSpdyWriteQueueStatsParameter(queue_)));
+  net_log_.EndEvent(
+      NetLog::TYPE_SPDY_SESSION,
+      make_scoped_refptr(
+          new NetLogIntegerParameter(
+              "compression_memory",
+              static_cast<int>(spdy_framer_.GetCompressionMemoryUsage()))));
 }
 
 net::Error SpdySession::InitializeWithSocket(
@@ -341,6 +420,10 @@ bool SpdySession::VerifyDomainAuthentication(const std::string& domain) {
   if (state_ != CONNECTED)
     return false;
 
+  // A certificate error was accepted for this session's own host only.
+  if (is_secure_ && certificate_error_code_ != OK)
+    return false;
+
   SSLInfo ssl_info;
   bool was_npn_negotiated;
   if (!GetSSLInfo(&ssl_info, &was_npn_negotiated))
@@ -382,10 +465,8 @@ int SpdySession::CreateStream(
     scoped_refptr<SpdyStream>* spdy_stream,
     const BoundNetLog& stream_net_log,
     CompletionCallback* callback) {
-  if (!max_concurrent_streams_ ||
-      active_streams_.size() < max_concurrent_streams_) {
+  if (HasStreamSlot(priority))
     return CreateStreamImpl(url, priority, spdy_stream, stream_net_log);
-  }
 
   stalled_streams_++;
   net_log().AddEvent(NetLog::TYPE_SPDY_SESSION_STALLED_MAX_STREAMS, NULL);
@@ -396,11 +477,13 @@ int SpdySession::CreateStream(
 }
 
 void SpdySession::ProcessPendingCreateStreams() {
-  while (!max_concurrent_streams_ ||
-         active_streams_.size() < max_concurrent_streams_) {
+  while (HasStreamSlot(HIGHEST)) {
     bool no_pending_create_streams = true;
     for (int i = 0;i < NUM_PRIORITIES;++i) {
       if (!create_stream_queues_[i].empty()) {
+        // The queues of lower priorities wait too.
+        if (!HasStreamSlot(static_cast<RequestPriority>(i)))
+          return;
         PendingCreateStream pending_create = create_stream_queues_[i].front();
         create_stream_queues_[i].pop();
         no_pending_create_streams = false;
@@ -449,6 +532,17 @@ void SpdySession::CancelPendingCreateStreams(
   }
 }
 
+bool SpdySession::HasStreamSlot(RequestPriority priority) const {
+  if (!max_concurrent_streams_)
+    return true;
+  size_t max_streams = max_concurrent_streams_;
+  // IDLE streams leave a slot free, so that a stream of any other priority
+  // can start right away.
+  if (priority == net::IDLE && max_streams > 1)
+    max_streams--;
+  return active_streams_.size() < max_streams;
+}
+
 int SpdySession::CreateStreamImpl(
     const GURL& url,
     RequestPriority priority,
@@ -508,7 +602,7 @@ int SpdySession::WriteSynStream(
           stream_id, 0,
           ConvertRequestPriorityToSpdyPriority(priority),
           flags, false, headers.get()));
-  QueueFrame(syn_frame.get(), priority, stream);
+  QueueFrame(syn_frame.release(), priority, stream);
 
   base::StatsCounter spdy_requests("spdy.requests");
   spdy_requests.Increment();
@@ -542,8 +636,8 @@ int SpdySession::WriteStreamData(spdy::SpdyStreamId stream_id,
 
   SendPrefacePingIfNoneInFlight();
 
-  if (len > kMaxSpdyFrameChunkSize) {
-    len = kMaxSpdyFrameChunkSize;
+  if (len > max_data_frame_size_) {
+    len = max_data_frame_size_;
     flags = static_cast<spdy::SpdyDataFlags>(flags & ~spdy::DATA_FLAG_FIN);
   }
 
@@ -577,10 +671,9 @@ int SpdySession::WriteStreamData(spdy::SpdyStreamId stream_id,
         make_scoped_refptr(new NetLogSpdyDataParameter(stream_id, len, flags)));
   }
 
-  // TODO(mbelshe): reduce memory copies here.
   scoped_ptr<spdy::SpdyDataFrame> frame(
       spdy_framer_.CreateDataFrame(stream_id, data->data(), len, flags));
-  QueueFrame(frame.get(), stream->priority(), stream);
+  QueueFrame(frame.release(), stream->priority(), stream);
   return ERR_IO_PENDING;
 }
 
@@ -606,8 +699,10 @@ void SpdySession::ResetStream(
   if(IsStreamActive(stream_id)) {
     scoped_refptr<SpdyStream> stream = active_streams_[stream_id];
     priority = stream->priority();
+    // The peer would discard the stream's queued DATA frames anyway.
+    queue_.RemovePendingDataForStream(stream);
   }
-  QueueFrame(rst_frame.get(), priority, NULL);
+  QueueFrame(rst_frame.release(), priority, NULL);
   DeleteStream(stream_id, ERR_SPDY_PROTOCOL_ERROR);
 }
 
@@ -731,6 +826,11 @@ net::Error SpdySession::ReadSocket() {
 
   CHECK(connection_.get());
   CHECK(connection_->socket());
+
+  // Streams may still hold slices of the data received last time.
+  if (!read_buffer_->HasOneRef())
+    read_buffer_ = new IOBuffer(kReadBufferSize);
+
   int bytes_read = connection_->socket()->Read(read_buffer_.get(),
                                                kReadBufferSize,
                                                &read_callback_);
@@ -789,8 +889,7 @@ void SpdySession::WriteSocket() {
   while (in_flight_write_.buffer() || !queue_.empty()) {
     if (!in_flight_write_.buffer()) {
       // Grab the next SpdyFrame to send.
-      SpdyIOBuffer next_buffer = queue_.top();
-      queue_.pop();
+      SpdyIOBuffer next_buffer = queue_.Pop();
 
       // We've deferred compression until just before we write it to the socket,
       // which is now.  At this time, we don't compress our data frames.
@@ -809,12 +908,10 @@ void SpdySession::WriteSocket() {
 
         DCHECK_GT(size, 0u);
 
-        // TODO(mbelshe): We have too much copying of data here.
-        IOBufferWithSize* buffer = new IOBufferWithSize(size);
-        memcpy(buffer->data(), compressed_frame->data(), size);
-
         // Attempt to send the frame.
-        in_flight_write_ = SpdyIOBuffer(buffer, size, 0, next_buffer.stream());
+        in_flight_write_ = SpdyIOBuffer(
+            new SpdyFrameIOBuffer(compressed_frame.release()), size, 0,
+            next_buffer.stream());
       } else {
         size = uncompressed_frame.length() + spdy::SpdyFrame::size();
         in_flight_write_ = next_buffer;
@@ -870,8 +967,7 @@ void SpdySession::CloseAllStreams(net::Error status) {
   }
 
   // We also need to drain the queue.
-  while (queue_.size())
-    queue_.pop();
+  queue_.Clear();
 }
 
 int SpdySession::GetNewStreamId() {
@@ -886,9 +982,10 @@ void SpdySession::QueueFrame(spdy::SpdyFrame* frame,
                              spdy::SpdyPriority priority,
                              SpdyStream* stream) {
   int length = spdy::SpdyFrame::size() + frame->length();
-  IOBuffer* buffer = new IOBuffer(length);
-  memcpy(buffer->data(), frame->data(), length);
-  queue_.push(SpdyIOBuffer(buffer, length, priority, stream));
+  bool is_data = !frame->is_control_frame();
+  queue_.Push(SpdyIOBuffer(new SpdyFrameIOBuffer(frame), length, priority,
+                           stream),
+              is_data);
 
   WriteSocketLater();
 }
@@ -939,6 +1036,11 @@ Value* SpdySession::GetInfoAsValue() const {
       streams_pushed_and_claimed_count_);
   dict->SetInteger("streams_abandoned_count", streams_abandoned_count_);
   dict->SetInteger("frames_received", frames_received_);
+  dict->SetInteger("compression_memory",
+      static_cast<int>(spdy_framer_.GetCompressionMemoryUsage()));
+  dict->SetInteger("recv_window_growth", recv_window_growth_);
+  dict->SetInteger("rtt_ms",
+      static_cast<int>(smoothed_rtt_.InMilliseconds()));
 
   dict->SetBoolean("sent_settings", sent_settings_);
   dict->SetBoolean("received_settings", received_settings_);
@@ -982,6 +1084,10 @@ void SpdySession::DeleteStream(spdy::SpdyStreamId id, int status) {
     }
   }
 
+  // Data compressors are only released by a FIN, so drop them here in case
+  // the stream ended some other way.
+  spdy_framer_.ReleaseStreamCompressors(id);
+
   // The stream might have been deleted.
   ActiveStreamMap::iterator it2 = active_streams_.find(id);
   if (it2 == active_streams_.end())
@@ -990,6 +1096,10 @@ void SpdySession::DeleteStream(spdy::SpdyStreamId id, int status) {
   // If this is an active stream, call the callback.
   const scoped_refptr<SpdyStream> stream(it2->second);
   active_streams_.erase(it2);
+  if (stream) {
+    recv_window_growth_ -= stream->recv_window_growth();
+    DCHECK_GE(recv_window_growth_, 0);
+  }
   if (stream)
     stream->OnClose(status);
   ProcessPendingCreateStreams();
@@ -1059,8 +1169,24 @@ void SpdySession::OnStreamFrameData(spdy::SpdyStreamId stream_id,
     return;
   }
 
+  scoped_refptr<DrainableIOBuffer> buffer;
+  if (len > 0) {
+    const char* read_data = read_buffer_->data();
+    if (data >= read_data && data + len <= read_data + kReadBufferSize) {
+      // Uncompressed payloads point into |read_buffer_|; hand the stream a
+      // slice of it instead of a copy.
+      const int offset = data - read_data;
+      buffer = new DrainableIOBuffer(read_buffer_, offset + len);
+      buffer->SetOffset(offset);
+    } else {
+      IOBuffer* copy = new IOBuffer(len);
+      memcpy(copy->data(), data, len);
+      buffer = new DrainableIOBuffer(copy, len);
+    }
+  }
+
   scoped_refptr<SpdyStream> stream = active_streams_[stream_id];
-  stream->OnDataReceived(data, len);
+  stream->OnDataReceived(buffer);
 }
 
 bool SpdySession::Respond(const spdy::SpdyHeaderBlock& headers,
@@ -1170,6 +1296,15 @@ void SpdySession::OnSyn(const spdy::SpdySynStreamControlFrame& frame,
 
   base::StatsCounter push_requests("spdy.pushed_streams");
   push_requests.Increment();
+
+  if (spdy_session_pool_) {
+    HttpResponseInfo response;
+    if (SpdyHeadersToHttpResponse(*headers, &response)) {
+      response.request_time = stream->GetRequestTime();
+      response.response_time = base::Time::Now();
+      spdy_session_pool_->OnPushedStream(gurl, response, net_log_);
+    }
+  }
 }
 
 void SpdySession::OnSynReply(const spdy::SpdySynReplyControlFrame& frame,
@@ -1329,7 +1464,7 @@ void SpdySession::OnRst(const spdy::SpdyRstStreamControlFrame& frame) {
   CHECK(!stream->cancelled());
 
   if (frame.status() == 0) {
-    stream->OnDataReceived(NULL, 0);
+    stream->OnDataReceived(NULL);
   } else {
     LOG(ERROR) << "Spdy stream closed: " << frame.status();
     // TODO(mbelshe): Map from Spdy-protocol errors to something sensical.
@@ -1373,6 +1508,12 @@ void SpdySession::OnPing(const spdy::SpdyPingControlFrame& frame) {
     return;
   }
 
+  base::TimeDelta rtt = base::TimeTicks::Now() - last_ping_sent_time_;
+  if (smoothed_rtt_ == base::TimeDelta())
+    smoothed_rtt_ = rtt;
+  else
+    smoothed_rtt_ = (smoothed_rtt_ * 7 + rtt) / 8;
+
   if (pings_in_flight_ > 0)
     return;
 
@@ -1438,7 +1579,21 @@ void SpdySession::SendWindowUpdate(spdy::SpdyStreamId stream_id,
 
   scoped_ptr<spdy::SpdyWindowUpdateControlFrame> window_update_frame(
       spdy_framer_.CreateWindowUpdate(stream_id, delta_window_size));
-  QueueFrame(window_update_frame.get(), stream->priority(), stream);
+  QueueFrame(window_update_frame.release(), stream->priority(), stream);
+}
+
+int SpdySession::ReserveRecvWindowGrowth(int delta) {
+  DCHECK_GE(delta, 0);
+  int available = max_session_recv_window_memory_ - recv_window_growth_;
+  int granted = std::max(0, std::min(delta, available));
+  recv_window_growth_ += granted;
+  return granted;
+}
+
+void SpdySession::MeasureRtt() {
+  if (smoothed_rtt_ != base::TimeDelta() || pings_in_flight_ > 0)
+    return;
+  WritePingFrame(next_ping_id_);
 }
 
 // Given a cwnd that we would have sent to the server, modify it based on the
@@ -1502,7 +1657,7 @@ void SpdySession::SendSettings() {
   scoped_ptr<spdy::SpdySettingsControlFrame> settings_frame(
       spdy_framer_.CreateSettings(settings));
   sent_settings_ = true;
-  QueueFrame(settings_frame.get(), 0, NULL);
+  QueueFrame(settings_frame.release(), 0, NULL);
 }
 
 void SpdySession::HandleSettings(const spdy::SpdySettings& settings) {
@@ -1537,9 +1692,7 @@ void SpdySession::SendPrefacePingIfNoneInFlight() {
 }
 
 void SpdySession::SendPrefacePing() {
-  // TODO(rtenneti): Send preface pings when more servers support additional
-  // pings.
-  // WritePingFrame(next_ping_id_);
+  WritePingFrame(next_ping_id_);
 }
 
 void SpdySession::PlanToSendTrailingPing() {
@@ -1562,7 +1715,7 @@ void SpdySession::SendTrailingPing() {
 void SpdySession::WritePingFrame(uint32 unique_id) {
   scoped_ptr<spdy::SpdyPingControlFrame> ping_frame(
       spdy_framer_.CreatePingFrame(next_ping_id_));
-  QueueFrame(ping_frame.get(), SPDY_PRIORITY_HIGHEST, NULL);
+  QueueFrame(ping_frame.release(), SPDY_PRIORITY_HIGHEST, NULL);
 
   if (net_log().IsLoggingAllEvents()) {
     net_log().AddEvent(
@@ -1570,6 +1723,7 @@ void SpdySession::WritePingFrame(uint32 unique_id) {
         make_scoped_refptr(new NetLogSpdyPingParameter(next_ping_id_)));
   }
   if (unique_id % 2 != 0) {
+    last_ping_sent_time_ = base::TimeTicks::Now();
     next_ping_id_ += 2;
     ++pings_in_flight_;
     need_to_send_ping_ = false;
@@ -1586,7 +1740,7 @@ void SpdySession::PlanToCheckPingStatus() {
       FROM_HERE,
       method_factory_.NewRunnableMethod(
           &SpdySession::CheckPingStatus, base::TimeTicks::Now()),
-      hung_interval_ms_);
+      GetHungInterval().InMilliseconds());
 }
 
 void SpdySession::CheckPingStatus(base::TimeTicks last_check_time) {
@@ -1598,8 +1752,7 @@ void SpdySession::CheckPingStatus(base::TimeTicks last_check_time) {
 
   DCHECK(check_ping_status_pending_);
 
-  const base::TimeDelta kHungInterval =
-      base::TimeDelta::FromMilliseconds(hung_interval_ms_);
+  const base::TimeDelta kHungInterval = GetHungInterval();
 
   base::TimeTicks now = base::TimeTicks::Now();
   base::TimeDelta delay = kHungInterval - (now - received_data_time_);
@@ -1617,6 +1770,21 @@ void SpdySession::CheckPingStatus(base::TimeTicks last_check_time) {
       delay.InMilliseconds());
 }
 
+base::TimeDelta SpdySession::GetHungInterval() const {
+  const base::TimeDelta kMaxHungInterval =
+      base::TimeDelta::FromMilliseconds(hung_interval_ms_);
+  if (smoothed_rtt_ == base::TimeDelta())
+    return kMaxHungInterval;
+
+  // Wait for a few round trips, to leave room for the server and for the
+  // queueing behind our own data.
+  const int kHungIntervalRoundTrips = 4;
+  base::TimeDelta interval = std::max(
+      smoothed_rtt_ * kHungIntervalRoundTrips,
+      base::TimeDelta::FromMilliseconds(min_hung_interval_ms_));
+  return std::min(interval, kMaxHungInterval);
+}
+
 void SpdySession::RecordHistograms() {
   UMA_HISTOGRAM_CUSTOM_COUNTS("Net.SpdyStreamsPerSession",
                               streams_initiated_count_,
@@ -29,6 +29,7 @@
 #include "net/spdy/spdy_io_buffer.h"
 #include "net/spdy/spdy_protocol.h"
 #include "net/spdy/spdy_session_pool.h"
+#include "net/spdy/spdy_write_queue.h"
 
 namespace net {
 
@@ -155,6 +156,35 @@ class SpdySession : public base::RefCounted<SpdySession>,
       return max_concurrent_stream_limit_;
   }
 
+  // Sets the largest DATA payload written at a time for a stream. Smaller
+  // frames let the write queue switch between streams more often.
+  static void set_max_data_frame_size(int value) {
+    max_data_frame_size_ = value;
+  }
+  static int max_data_frame_size() { return max_data_frame_size_; }
+
+  // Enable or disable receive window auto-tuning. When enabled, a stream
+  // whose data is consumed fast enough for its receive window to limit the
+  // transfer grows the window, up to max_recv_window_size() for the stream and
+  // max_session_recv_window_memory() for the growth of all the streams of a
+  // session.
+  static void set_recv_window_autotuning(bool enable) {
+    use_recv_window_autotuning_ = enable;
+  }
+  static bool recv_window_autotuning() { return use_recv_window_autotuning_; }
+
+  static void set_max_recv_window_size(int value) {
+    max_recv_window_size_ = value;
+  }
+  static int max_recv_window_size() { return max_recv_window_size_; }
+
+  static void set_max_session_recv_window_memory(int value) {
+    max_session_recv_window_memory_ = value;
+  }
+  static int max_session_recv_window_memory() {
+    return max_session_recv_window_memory_;
+  }
+
   // Enable sending of PING frame with each request.
   static void set_enable_ping_based_connection_checking(bool enable) {
     enable_ping_based_connection_checking_ = enable;
@@ -163,10 +193,39 @@ class SpdySession : public base::RefCounted<SpdySession>,
     return enable_ping_based_connection_checking_;
   }
 
+  // How long a session may be idle before the next request sends a PING to
+  // check it is still alive.  NetworkTuner raises this on slow radios.
+  static void set_connection_at_risk_of_loss_ms(int duration) {
+    connection_at_risk_of_loss_ms_ = duration;
+  }
+  static int connection_at_risk_of_loss_ms() {
+    return connection_at_risk_of_loss_ms_;
+  }
+
+  // How long a PING may go unanswered before the session is closed.
+  static void set_hung_interval_ms(int duration) {
+    hung_interval_ms_ = duration;
+  }
+  static int hung_interval_ms() {
+    return hung_interval_ms_;
+  }
+
   // Send WINDOW_UPDATE frame, called by a stream whenever receive window
   // size is increased.
   void SendWindowUpdate(spdy::SpdyStreamId stream_id, int delta_window_size);
 
+  // Called by a stream that wants to grow its receive window by |delta|
+  // bytes. Returns how much of it fits in the session-wide memory cap.
+  int ReserveRecvWindowGrowth(int delta);
+
+  // The round trip time measured with our PINGs, or zero if none of them has
+  // been answered yet.
+  base::TimeDelta smoothed_rtt() const { return smoothed_rtt_; }
+
+  // Sends a PING to measure the round trip time, unless it is known already
+  // or a PING is in flight.
+  void MeasureRtt();
+
   // If session is closed, no new streams/transactions should be created.
   bool IsClosed() const { return state_ == CLOSED; }
 
@@ -188,6 +247,11 @@ class SpdySession : public base::RefCounted<SpdySession>,
     return frames_received_ > 0;
   }
 
+  // How the session's socket was connected.
+  const LoadTimingInfo::ConnectTiming& connect_timing() const {
+    return connection_->connect_timing();
+  }
+
   // Returns true if the underlying transport socket ever had any reads or
   // writes.
   bool WasEverUsed() const {
@@ -210,6 +274,12 @@ class SpdySession : public base::RefCounted<SpdySession>,
       return unclaimed_pushed_streams_.size();
   }
 
+  // Returns an estimate of the memory held by the header and data
+  // compressors of this session.
+  size_t GetCompressionMemoryUsage() const {
+    return spdy_framer_.GetCompressionMemoryUsage();
+  }
+
   const BoundNetLog& net_log() const { return net_log_; }
 
   int GetPeerAddress(AddressList* address) const;
@@ -219,6 +289,8 @@ class SpdySession : public base::RefCounted<SpdySession>,
   friend class base::RefCounted<SpdySession>;
   // Allow tests to access our innards for testing purposes.
   FRIEND_TEST_ALL_PREFIXES(SpdySessionTest, Ping);
+  FRIEND_TEST_ALL_PREFIXES(SpdySessionTest, HungIntervalFollowsRtt);
+  FRIEND_TEST_ALL_PREFIXES(SpdySessionTest, UnansweredPingClosesSession);
   FRIEND_TEST_ALL_PREFIXES(SpdySessionTest, GetActivePushStream);
 
   struct PendingCreateStream {
@@ -240,7 +312,6 @@ class SpdySession : public base::RefCounted<SpdySession>,
   typedef std::map<int, scoped_refptr<SpdyStream> > ActiveStreamMap;
   // Only HTTP push a stream.
   typedef std::map<std::string, scoped_refptr<SpdyStream> > PushedStreamMap;
-  typedef std::priority_queue<SpdyIOBuffer> OutputQueue;
 
   struct CallbackResultPair {
     CallbackResultPair() : callback(NULL), result(OK) {}
@@ -266,6 +337,11 @@ class SpdySession : public base::RefCounted<SpdySession>,
   virtual ~SpdySession();
 
   void ProcessPendingCreateStreams();
+
+  // Returns true if a stream of |priority| can be created now, without
+  // going over |max_concurrent_streams_|.
+  bool HasStreamSlot(RequestPriority priority) const;
+
   int CreateStreamImpl(
       const GURL& url,
       RequestPriority priority,
@@ -318,9 +394,14 @@ class SpdySession : public base::RefCounted<SpdySession>,
   void PlanToCheckPingStatus();
 
   // Check the status of the connection. It calls |CloseSessionOnError| if we
-  // haven't received any data in |kHungInterval| time period.
+  // haven't received any data in |GetHungInterval()| time period.
   void CheckPingStatus(base::TimeTicks last_check_time);
 
+  // Returns how long we wait for an answer to a PING before declaring the
+  // connection hung. Once the round trip time is known, this is a few round
+  // trips, between |min_hung_interval_ms_| and |hung_interval_ms_|.
+  base::TimeDelta GetHungInterval() const;
+
   // Start reading from the socket.
   // Returns OK on success, or an error on failure.
   net::Error ReadSocket();
@@ -333,7 +414,7 @@ class SpdySession : public base::RefCounted<SpdySession>,
   int GetNewStreamId();
 
   // Queue a frame for sending.
-  // |frame| is the frame to send.
+  // |frame| is the frame to send; the session takes ownership of it.
   // |priority| is the priority for insertion into the queue.
   // |stream| is the stream which this IO is associated with (or NULL).
   void QueueFrame(spdy::SpdyFrame* frame, spdy::SpdyPriority priority,
@@ -381,13 +462,6 @@ class SpdySession : public base::RefCounted<SpdySession>,
   // --------------------------
   // Helper methods for testing
   // --------------------------
-  static void set_connection_at_risk_of_loss_ms(int duration) {
-    connection_at_risk_of_loss_ms_ = duration;
-  }
-  static int connection_at_risk_of_loss_ms() {
-    return connection_at_risk_of_loss_ms_;
-  }
-
   static void set_trailing_ping_delay_time_ms(int duration) {
     trailing_ping_delay_time_ms_ = duration;
   }
@@ -395,11 +469,11 @@ class SpdySession : public base::RefCounted<SpdySession>,
     return trailing_ping_delay_time_ms_;
   }
 
-  static void set_hung_interval_ms(int duration) {
-    hung_interval_ms_ = duration;
+  static void set_min_hung_interval_ms(int duration) {
+    min_hung_interval_ms_ = duration;
   }
-  static int hung_interval_ms() {
-    return hung_interval_ms_;
+  static int min_hung_interval_ms() {
+    return min_hung_interval_ms_;
   }
 
   int64 pings_in_flight() const { return pings_in_flight_; }
@@ -462,7 +536,7 @@ class SpdySession : public base::RefCounted<SpdySession>,
   PushedStreamMap unclaimed_pushed_streams_;
 
   // As we gather data to be sent, we put it into the output queue.
-  OutputQueue queue_;
+  SpdyWriteQueue queue_;
 
   // The packet we are currently sending.
   bool write_pending_;            // Will be true when a write is in progress.
@@ -534,11 +608,23 @@ class SpdySession : public base::RefCounted<SpdySession>,
   // this value for the initial receive window size.
   int initial_recv_window_size_;
 
+  // The receive window growth given to the active streams by auto-tuning.
+  int recv_window_growth_;
+
+  // When our last PING was sent, and the smoothed round trip time of the
+  // PINGs that were answered.
+  base::TimeTicks last_ping_sent_time_;
+  base::TimeDelta smoothed_rtt_;
+
   BoundNetLog net_log_;
 
   static bool use_ssl_;
   static bool use_flow_control_;
   static size_t max_concurrent_stream_limit_;
+  static int max_data_frame_size_;
+  static bool use_recv_window_autotuning_;
+  static int max_recv_window_size_;
+  static int max_session_recv_window_memory_;
 
   // This enables or disables connection health checking system.
   static bool enable_ping_based_connection_checking_;
@@ -569,6 +655,10 @@ class SpdySession : public base::RefCounted<SpdySession>,
   // no data received (of any form), while there is a ping in flight, before we
   // declare the connection to be hung.
   static int hung_interval_ms_;
+
+  // The lower bound of the hung interval derived from the round trip time, so
+  // that a burst of latency on a fast connection doesn't get it closed.
+  static int min_hung_interval_ms_;
 };
 
 class NetLogSpdySynParameter : public NetLog::EventParameters {
@@ -0,0 +1,175 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/memory/linked_ptr.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/spdy/spdy_session.h"
+#include "net/spdy/spdy_stream.h"
+#include "net/spdy/spdy_test_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const int kBodySize = 4 * 1024 * 1024;
+const int kNumIterations = 10;
+
+// Counts the response bytes of a GET and reports when the stream is closed.
+class CountingStreamDelegate : public SpdyStream::Delegate {
+ public:
+  explicit CountingStreamDelegate(CompletionCallback* callback)
+      : callback_(callback),
+        received_bytes_(0) {
+  }
+  virtual ~CountingStreamDelegate() {}
+
+  virtual bool OnSendHeadersComplete(int status) { return true; }
+  virtual int OnSendBody() { return ERR_UNEXPECTED; }
+  virtual int OnSendBodyComplete(int status, bool* eof) {
+    return ERR_UNEXPECTED;
+  }
+  virtual int OnResponseReceived(const spdy::SpdyHeaderBlock& response,
+                                 base::Time response_time,
+                                 int status) {
+    return status;
+  }
+  virtual void OnDataReceived(DrainableIOBuffer* buffer) {
+    if (buffer)
+      received_bytes_ += buffer->BytesRemaining();
+  }
+  virtual void OnDataSent(int length) {}
+  virtual void OnClose(int status) {
+    CompletionCallback* callback = callback_;
+    callback_ = NULL;
+    callback->Run(status);
+  }
+  virtual void set_chunk_callback(ChunkCallback* callback) {}
+
+  int64 received_bytes() const { return received_bytes_; }
+
+ private:
+  CompletionCallback* callback_;
+  int64 received_bytes_;
+};
+
+// Measures a GET whose |kBodySize| bytes body comes in DATA frames of
+// |frame_size| bytes, from the socket reads to the stream delegate.
+void ReceiveBody(const char* name, int frame_size) {
+  MessageLoopForIO message_loop;
+  spdy::SpdyFramer::set_enable_compression_default(false);
+  SpdySession::SetSSLMode(false);
+
+  const std::string payload(frame_size, 'a');
+  const int num_frames = kBodySize / frame_size;
+  scoped_ptr<spdy::SpdyFrame> req(ConstructSpdyGet(NULL, 0, false, 1, LOWEST));
+  scoped_ptr<spdy::SpdyFrame> resp(ConstructSpdyGetSynReply(NULL, 0, 1));
+  scoped_ptr<spdy::SpdyFrame> body(
+      ConstructSpdyBodyFrame(1, payload.data(), frame_size, false));
+  scoped_ptr<spdy::SpdyFrame> last_body(
+      ConstructSpdyBodyFrame(1, payload.data(), frame_size, true));
+
+  MockWrite writes[] = { CreateMockWrite(*req, 0) };
+  std::vector<MockRead> reads;
+  reads.push_back(CreateMockRead(*resp, 1));
+  for (int i = 0; i < num_frames - 1; ++i)
+    reads.push_back(CreateMockRead(*body, i + 2));
+  reads.push_back(CreateMockRead(*last_body, num_frames + 1));
+  reads.push_back(MockRead(true, 0, num_frames + 2));  // EOF
+
+  int64 wire_bytes = 0;
+  for (size_t i = 0; i < reads.size(); ++i)
+    wire_bytes += reads[i].data_len;
+
+  HostPortPair host_port_pair("www.google.com", 80);
+  HostPortProxyPair pair(host_port_pair, ProxyServer::Direct());
+  GURL url("http://www.google.com/");
+  linked_ptr<spdy::SpdyHeaderBlock> headers(new spdy::SpdyHeaderBlock);
+  (*headers)["method"] = "GET";
+  (*headers)["url"] = "/";
+  (*headers)["host"] = "www.google.com";
+  (*headers)["scheme"] = "http";
+  (*headers)["version"] = "HTTP/1.1";
+
+  for (int iteration = 0; iteration < kNumIterations; ++iteration) {
+    SpdySessionDependencies session_deps;
+    scoped_refptr<DeterministicSocketData> data(
+        new DeterministicSocketData(&reads[0], reads.size(),
+                                    writes, arraysize(writes)));
+    data->set_connect_data(MockConnect(false, OK));
+    session_deps.deterministic_socket_factory->AddSocketDataProvider(data);
+    scoped_refptr<HttpNetworkSession> http_session(
+        SpdySessionDependencies::SpdyCreateSessionDeterministic(
+            &session_deps));
+
+    scoped_refptr<SpdySession> session(
+        http_session->spdy_session_pool()->Get(pair, BoundNetLog()));
+    scoped_refptr<TransportSocketParams> transport_params(
+        new TransportSocketParams(host_port_pair, LOWEST, GURL(), false,
+                                  false));
+    scoped_ptr<ClientSocketHandle> connection(new ClientSocketHandle);
+    ASSERT_EQ(OK, connection->Init(host_port_pair.ToString(),
+                                   transport_params, LOWEST, NULL,
+                                   http_session->transport_socket_pool(),
+                                   BoundNetLog()));
+    ASSERT_EQ(OK, session->InitializeWithSocket(connection.release(), false,
+                                                OK));
+
+    scoped_refptr<SpdyStream> stream;
+    ASSERT_EQ(OK, session->CreateStream(url, LOWEST, &stream, BoundNetLog(),
+                                        NULL));
+    TestCompletionCallback callback;
+    CountingStreamDelegate delegate(&callback);
+    stream->SetDelegate(&delegate);
+    stream->set_spdy_headers(headers);
+    ASSERT_EQ(ERR_IO_PENDING, stream->SendRequest(false));
+
+    PerfTimer timer;
+    data->RunFor(reads.size() + arraysize(writes));
+    EXPECT_EQ(OK, callback.WaitForResult());
+    if (iteration == kNumIterations - 1) {
+      double seconds = std::max(timer.Elapsed().InSecondsF(), 1e-6);
+      LogPerfResult(base::StringPrintf("%s_frames", name).c_str(),
+                    reads.size() / seconds, "frames/s");
+      LogPerfResult(base::StringPrintf("%s_bytes", name).c_str(),
+                    wire_bytes / seconds, "bytes/s");
+    }
+    EXPECT_EQ(static_cast<int64>(num_frames) * frame_size,
+              delegate.received_bytes());
+
+    stream = NULL;
+    session = NULL;
+    http_session = NULL;
+    MessageLoop::current()->RunAllPending();
+  }
+
+  spdy::SpdyFramer::set_enable_compression_default(true);
+}
+
+}  // namespace
+
+TEST(SpdySessionPerfTest, SmallDataFrames) {
+  ReceiveBody("Spdy_session_small_data_frames", 256);
+}
+
+TEST(SpdySessionPerfTest, TypicalDataFrames) {
+  ReceiveBody("Spdy_session_typical_data_frames", 4 * 1024);
+}
+
+TEST(SpdySessionPerfTest, LargeDataFrames) {
+  ReceiveBody("Spdy_session_large_data_frames", 64 * 1024);
+}
+
+}  // namespace net
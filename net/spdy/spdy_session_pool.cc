@@ -30,6 +30,29 @@ bool HostPortProxyPairsAreEqual(const HostPortProxyPair& a,
   return a.first.Equals(b.first) && a.second == b.second;
 }
 
+class NetLogSpdyPooledOriginParameter : public NetLog::EventParameters {
+ public:
+  NetLogSpdyPooledOriginParameter(const HostPortPair& origin,
+                                  const NetLog::Source& source)
+      : origin_(origin), source_(source) {}
+
+  virtual Value* ToValue() const {
+    DictionaryValue* dict = new DictionaryValue();
+    dict->SetString("host", origin_.ToString());
+    if (source_.is_valid())
+      dict->Set("source_dependency", source_.ToValue());
+    return dict;
+  }
+
+ private:
+  virtual ~NetLogSpdyPooledOriginParameter() {}
+
+  const HostPortPair origin_;
+  const NetLog::Source source_;
+
+  DISALLOW_COPY_AND_ASSIGN(NetLogSpdyPooledOriginParameter);
+};
+
 }
 
 // The maximum number of sessions to open to a single domain.
@@ -74,6 +97,10 @@ scoped_refptr<SpdySession> SpdySessionPool::Get(
           NetLog::TYPE_SPDY_SESSION_POOL_FOUND_EXISTING_SESSION_FROM_IP_POOL,
           make_scoped_refptr(new NetLogSourceParameter(
           "session", spdy_session->net_log().source())));
+      spdy_session->net_log().AddEvent(
+          NetLog::TYPE_SPDY_SESSION_POOLED_ORIGIN,
+          make_scoped_refptr(new NetLogSpdyPooledOriginParameter(
+              host_port_proxy_pair.first, net_log.source())));
       return spdy_session;
     }
     list = AddSessionList(host_port_proxy_pair);
@@ -146,6 +173,29 @@ bool SpdySessionPool::HasSession(
   return spdy_session.get() != NULL;
 }
 
+bool SpdySessionPool::CanPoolByIP() const {
+  return g_enable_ip_pooling && !aliases_.empty();
+}
+
+void SpdySessionPool::AddPushObserver(PushObserver* observer) {
+  push_observers_.AddObserver(observer);
+}
+
+void SpdySessionPool::RemovePushObserver(PushObserver* observer) {
+  push_observers_.RemoveObserver(observer);
+}
+
+void SpdySessionPool::OnPushedStream(const GURL& url,
+                                     const HttpResponseInfo& response,
+                                     const BoundNetLog& session_net_log) {
+  ObserverList<PushObserver>::Iterator it(push_observers_);
+  PushObserver* observer;
+  while ((observer = it.GetNext()) != NULL) {
+    if (observer->OnPushedStream(url, response, session_net_log))
+      return;
+  }
+}
+
 void SpdySessionPool::Remove(const scoped_refptr<SpdySession>& session) {
   SpdySessionList* list = GetSessionList(session->host_port_proxy_pair());
   DCHECK(list);  // We really shouldn't remove if we've already been removed.
@@ -408,7 +458,8 @@ void SpdySessionPool::CloseCurrentSessions() {
   DCHECK(aliases_.empty());
 }
 
-void SpdySessionPool::CloseIdleSessions() {
+size_t SpdySessionPool::CloseIdleSessions() {
+  size_t freed = 0;
   SpdySessionsMap::const_iterator map_it = sessions_.begin();
   while (map_it != sessions_.end()) {
     SpdySessionList* list = map_it->second;
@@ -419,9 +470,12 @@ void SpdySessionPool::CloseIdleSessions() {
     SpdySessionList::iterator session_it = list->begin();
     const scoped_refptr<SpdySession>& session = *session_it;
     CHECK(session);
-    if (!session->is_active())
+    if (!session->is_active()) {
+      freed += session->GetCompressionMemoryUsage();
       session->CloseSessionOnError(net::ERR_ABORTED, true);
+    }
   }
+  return freed;
 }
 
 }  // namespace net
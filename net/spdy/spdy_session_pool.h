@@ -14,6 +14,7 @@
 #include "base/gtest_prod_util.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/observer_list.h"
 #include "net/base/cert_database.h"
 #include "net/base/host_port_pair.h"
 #include "net/base/ip_endpoint.h"
@@ -24,6 +25,8 @@
 #include "net/proxy/proxy_server.h"
 #include "net/spdy/spdy_settings_storage.h"
 
+class GURL;
+
 namespace net {
 
 class AddressList;
@@ -31,6 +34,7 @@ class BoundNetLog;
 class ClientSocketHandle;
 class HostResolver;
 class HttpNetworkSession;
+class HttpResponseInfo;
 class SpdySession;
 
 // This is a very simple pool for open SpdySessions.
@@ -39,6 +43,21 @@ class SpdySessionPool
       public SSLConfigService::Observer,
       public CertDatabase::Observer {
  public:
+  // Hears about the streams that servers push, so that they can be claimed
+  // before a request for them comes along (for example to fill a cache).
+  class PushObserver {
+   public:
+    // Called when a server pushes |response| for |url| on the session whose
+    // NetLog is |session_net_log|. Returns true if the observer is going to
+    // claim the stream, in which case the other observers are not told.
+    virtual bool OnPushedStream(const GURL& url,
+                                const HttpResponseInfo& response,
+                                const BoundNetLog& session_net_log) = 0;
+
+   protected:
+    virtual ~PushObserver() {}
+  };
+
   explicit SpdySessionPool(HostResolver* host_resolver,
                            SSLConfigService* ssl_config_service);
   virtual ~SpdySessionPool();
@@ -77,14 +96,28 @@ class SpdySessionPool
   // should be creating a new session.
   bool HasSession(const HostPortProxyPair& host_port_proxy_pair) const;
 
+  // Returns true if a host could be given an existing session through IP
+  // pooling once its addresses are known.
+  bool CanPoolByIP() const;
+
   // Close all SpdySessions, including any new ones created in the process of
   // closing the current ones.
   void CloseAllSessions();
   // Close only the currently existing SpdySessions. Let any new ones created
   // continue to live.
   void CloseCurrentSessions();
-  // Close only the idle SpdySessions.
-  void CloseIdleSessions();
+  // Close only the idle SpdySessions. Returns an estimate of the memory their
+  // compressors held.
+  size_t CloseIdleSessions();
+
+  // Observers are told about pushed streams in the order they were added.
+  void AddPushObserver(PushObserver* observer);
+  void RemovePushObserver(PushObserver* observer);
+
+  // Called by a SpdySession when the headers of a pushed stream arrive.
+  void OnPushedStream(const GURL& url,
+                      const HttpResponseInfo& response,
+                      const BoundNetLog& session_net_log);
 
   // Removes a SpdySession from the SpdySessionPool. This should only be called
   // by SpdySession, because otherwise session->state_ is not set to CLOSED.
@@ -171,6 +204,8 @@ class SpdySessionPool
   const scoped_refptr<SSLConfigService> ssl_config_service_;
   HostResolver* resolver_;
 
+  ObserverList<PushObserver> push_observers_;
+
   DISALLOW_COPY_AND_ASSIGN(SpdySessionPool);
 };
 
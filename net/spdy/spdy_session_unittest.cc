@@ -48,7 +48,7 @@ class TestSpdyStreamDelegate : public net::SpdyStream::Delegate {
     return status;
   }
 
-  virtual void OnDataReceived(const char* buffer, int bytes) {
+  virtual void OnDataReceived(DrainableIOBuffer* buffer) {
   }
 
   virtual void OnDataSent(int length) {
@@ -475,6 +475,86 @@ TEST_F(SpdySessionTest, CancelPendingCreateStream) {
   MessageLoop::current()->RunAllPending();
 }
 
+// IDLE streams don't take the last stream the server allows.
+TEST_F(SpdySessionTest, IdleStreamsLeaveASlot) {
+  SpdySessionDependencies session_deps;
+  session_deps.host_resolver->set_synchronous_mode(true);
+
+  MockRead reads[] = {
+    MockRead(false, ERR_IO_PENDING)  // Stall forever.
+  };
+
+  StaticSocketDataProvider data(reads, arraysize(reads), NULL, 0);
+  MockConnect connect_data(false, OK);
+
+  data.set_connect_data(connect_data);
+  session_deps.socket_factory->AddSocketDataProvider(&data);
+
+  SSLSocketDataProvider ssl(false, OK);
+  session_deps.socket_factory->AddSSLSocketDataProvider(&ssl);
+
+  scoped_refptr<HttpNetworkSession> http_session(
+      SpdySessionDependencies::SpdyCreateSession(&session_deps));
+
+  const std::string kTestHost("www.foo.com");
+  const int kTestPort = 80;
+  HostPortPair test_host_port_pair(kTestHost, kTestPort);
+  HostPortProxyPair pair(test_host_port_pair, ProxyServer::Direct());
+
+  // Initialize the SpdySettingsStorage with 2 max concurrent streams.
+  SpdySessionPool* spdy_session_pool(http_session->spdy_session_pool());
+  spdy::SpdySettings settings;
+  spdy::SettingsFlagsAndId id(spdy::SETTINGS_MAX_CONCURRENT_STREAMS);
+  id.set_id(spdy::SETTINGS_MAX_CONCURRENT_STREAMS);
+  id.set_flags(spdy::SETTINGS_FLAG_PLEASE_PERSIST);
+  settings.push_back(spdy::SpdySetting(id, 2));
+  spdy_session_pool->mutable_spdy_settings()->Set(
+      test_host_port_pair, settings);
+
+  scoped_refptr<SpdySession> session =
+      spdy_session_pool->Get(pair, BoundNetLog());
+
+  scoped_refptr<TransportSocketParams> transport_params(
+      new TransportSocketParams(test_host_port_pair,
+                                MEDIUM,
+                                GURL(),
+                                false,
+                                false));
+  scoped_ptr<ClientSocketHandle> connection(new ClientSocketHandle);
+  EXPECT_EQ(OK,
+            connection->Init(test_host_port_pair.ToString(),
+                             transport_params, MEDIUM,
+                             NULL, http_session->transport_socket_pool(),
+                             BoundNetLog()));
+  EXPECT_EQ(OK, session->InitializeWithSocket(connection.release(), false, OK));
+
+  TestCompletionCallback callback;
+  GURL url("http://www.google.com");
+
+  // The second IDLE stream waits, but a MEDIUM one doesn't.
+  scoped_refptr<SpdyStream> idle_stream1;
+  ASSERT_EQ(OK, session->CreateStream(url, IDLE, &idle_stream1,
+                                      BoundNetLog(), &callback));
+  scoped_refptr<SpdyStream> idle_stream2;
+  ASSERT_EQ(ERR_IO_PENDING, session->CreateStream(url, IDLE, &idle_stream2,
+                                                  BoundNetLog(), &callback));
+  scoped_refptr<SpdyStream> medium_stream;
+  ASSERT_EQ(OK, session->CreateStream(url, MEDIUM, &medium_stream,
+                                      BoundNetLog(), &callback));
+
+  // Closing the MEDIUM stream still leaves one IDLE stream open.
+  medium_stream->Cancel();
+  medium_stream = NULL;
+  MessageLoop::current()->RunAllPending();
+  EXPECT_FALSE(idle_stream2.get());
+
+  idle_stream1->Cancel();
+  idle_stream1 = NULL;
+  EXPECT_EQ(OK, callback.WaitForResult());
+  ASSERT_TRUE(idle_stream2.get());
+  idle_stream2->Cancel();
+}
+
 TEST_F(SpdySessionTest, SendSettingsOnNewSession) {
   SpdySessionDependencies session_deps;
   session_deps.host_resolver->set_synchronous_mode(true);
@@ -597,9 +677,11 @@ void IPPoolingTest(bool clean_via_close_current_sessions) {
   // Setup the first session to the first host.
   SpdySessionPool* spdy_session_pool(http_session->spdy_session_pool());
   EXPECT_FALSE(spdy_session_pool->HasSession(test_hosts[0].pair));
+  EXPECT_FALSE(spdy_session_pool->CanPoolByIP());
   scoped_refptr<SpdySession> session =
       spdy_session_pool->Get(test_hosts[0].pair, BoundNetLog());
   EXPECT_TRUE(spdy_session_pool->HasSession(test_hosts[0].pair));
+  EXPECT_TRUE(spdy_session_pool->CanPoolByIP());
 
   HostPortPair test_host_port_pair(test_hosts[0].name, kTestPort);
   scoped_refptr<TransportSocketParams> transport_params(
@@ -666,4 +748,152 @@ TEST_F(SpdySessionTest, IPPoolingCloseCurrentSessions) {
   IPPoolingTest(true);
 }
 
+class TestPushObserver : public SpdySessionPool::PushObserver {
+ public:
+  explicit TestPushObserver(bool claim) : claim_(claim), count_(0) {}
+
+  virtual bool OnPushedStream(const GURL& url,
+                              const HttpResponseInfo& response,
+                              const BoundNetLog& session_net_log) {
+    count_++;
+    return claim_;
+  }
+
+  int count() const { return count_; }
+
+ private:
+  const bool claim_;
+  int count_;
+};
+
+TEST_F(SpdySessionTest, PushObserversStopAtFirstClaim) {
+  SpdySessionDependencies session_deps;
+  scoped_refptr<HttpNetworkSession> http_session(
+      SpdySessionDependencies::SpdyCreateSession(&session_deps));
+  SpdySessionPool* spdy_session_pool(http_session->spdy_session_pool());
+
+  TestPushObserver declining(false);
+  TestPushObserver claiming(true);
+  TestPushObserver last(true);
+  spdy_session_pool->AddPushObserver(&declining);
+  spdy_session_pool->AddPushObserver(&claiming);
+  spdy_session_pool->AddPushObserver(&last);
+
+  HttpResponseInfo response;
+  spdy_session_pool->OnPushedStream(GURL("http://www.google.com/foo.js"),
+                                    response, BoundNetLog());
+  EXPECT_EQ(1, declining.count());
+  EXPECT_EQ(1, claiming.count());
+  EXPECT_EQ(0, last.count());
+
+  spdy_session_pool->RemovePushObserver(&claiming);
+  spdy_session_pool->OnPushedStream(GURL("http://www.google.com/bar.js"),
+                                    response, BoundNetLog());
+  EXPECT_EQ(2, declining.count());
+  EXPECT_EQ(1, claiming.count());
+  EXPECT_EQ(1, last.count());
+
+  spdy_session_pool->RemovePushObserver(&declining);
+  spdy_session_pool->RemovePushObserver(&last);
+}
+
+// A PING that gets no answer closes the session, so that its streams can be
+// retried on a new connection.
+TEST_F(SpdySessionTest, UnansweredPingClosesSession) {
+  SpdySessionDependencies session_deps;
+  session_deps.host_resolver->set_synchronous_mode(true);
+
+  MockConnect connect_data(false, OK);
+  MockRead reads[] = {
+    MockRead(true, ERR_IO_PENDING)  // The server never answers.
+  };
+  scoped_ptr<spdy::SpdyFrame> write_ping(ConstructSpdyPing());
+  MockWrite writes[] = {
+    CreateMockWrite(*write_ping),
+  };
+  StaticSocketDataProvider data(
+      reads, arraysize(reads), writes, arraysize(writes));
+  data.set_connect_data(connect_data);
+  session_deps.socket_factory->AddSocketDataProvider(&data);
+
+  scoped_refptr<HttpNetworkSession> http_session(
+      SpdySessionDependencies::SpdyCreateSession(&session_deps));
+
+  HostPortPair test_host_port_pair("www.google.com", 80);
+  HostPortProxyPair pair(test_host_port_pair, ProxyServer::Direct());
+  SpdySessionPool* spdy_session_pool(http_session->spdy_session_pool());
+  scoped_refptr<SpdySession> session =
+      spdy_session_pool->Get(pair, BoundNetLog());
+
+  scoped_refptr<TransportSocketParams> transport_params(
+      new TransportSocketParams(test_host_port_pair,
+                                MEDIUM,
+                                GURL(),
+                                false,
+                                false));
+  scoped_ptr<ClientSocketHandle> connection(new ClientSocketHandle);
+  EXPECT_EQ(OK,
+            connection->Init(test_host_port_pair.ToString(),
+                             transport_params,
+                             MEDIUM,
+                             NULL,
+                             http_session->transport_socket_pool(),
+                             BoundNetLog()));
+  EXPECT_EQ(OK, session->InitializeWithSocket(connection.release(), false, OK));
+
+  const int old_trailing_ping_delay_time_ms =
+      SpdySession::trailing_ping_delay_time_ms();
+  const int old_hung_interval_ms = SpdySession::hung_interval_ms();
+  SpdySession::set_enable_ping_based_connection_checking(true);
+  SpdySession::set_connection_at_risk_of_loss_ms(0);
+  SpdySession::set_trailing_ping_delay_time_ms(60 * 1000);
+  SpdySession::set_hung_interval_ms(50);
+
+  session->SendPrefacePingIfNoneInFlight();
+  EXPECT_EQ(1, session->pings_in_flight());
+  EXPECT_TRUE(session->check_ping_status_pending());
+
+  MessageLoop::current()->PostDelayedTask(FROM_HERE,
+                                          new MessageLoop::QuitTask(), 200);
+  MessageLoop::current()->Run();
+  EXPECT_FALSE(spdy_session_pool->HasSession(pair));
+  EXPECT_TRUE(session->IsClosed());
+
+  SpdySession::set_connection_at_risk_of_loss_ms(10 * 1000);
+  SpdySession::set_trailing_ping_delay_time_ms(old_trailing_ping_delay_time_ms);
+  SpdySession::set_hung_interval_ms(old_hung_interval_ms);
+  session = NULL;
+}
+
+TEST_F(SpdySessionTest, HungIntervalFollowsRtt) {
+  SpdySessionDependencies session_deps;
+  scoped_refptr<HttpNetworkSession> http_session(
+      SpdySessionDependencies::SpdyCreateSession(&session_deps));
+  HostPortPair test_host_port_pair("www.google.com", 80);
+  HostPortProxyPair pair(test_host_port_pair, ProxyServer::Direct());
+  scoped_refptr<SpdySession> session =
+      http_session->spdy_session_pool()->Get(pair, BoundNetLog());
+
+  const int old_hung_interval_ms = SpdySession::hung_interval_ms();
+  const int old_min_hung_interval_ms = SpdySession::min_hung_interval_ms();
+  SpdySession::set_hung_interval_ms(10000);
+  SpdySession::set_min_hung_interval_ms(2000);
+
+  // Until a PING is answered, the longest interval is used.
+  EXPECT_EQ(10000, session->GetHungInterval().InMilliseconds());
+
+  session->smoothed_rtt_ = base::TimeDelta::FromMilliseconds(100);
+  EXPECT_EQ(2000, session->GetHungInterval().InMilliseconds());
+
+  session->smoothed_rtt_ = base::TimeDelta::FromMilliseconds(1000);
+  EXPECT_EQ(4000, session->GetHungInterval().InMilliseconds());
+
+  session->smoothed_rtt_ = base::TimeDelta::FromMilliseconds(5000);
+  EXPECT_EQ(10000, session->GetHungInterval().InMilliseconds());
+
+  SpdySession::set_hung_interval_ms(old_hung_interval_ms);
+  SpdySession::set_min_hung_interval_ms(old_min_hung_interval_ms);
+  http_session->spdy_session_pool()->Remove(session);
+}
+
 }  // namespace net
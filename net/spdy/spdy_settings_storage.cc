@@ -1,4 +1,4 @@
-// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
@@ -6,9 +6,28 @@
 
 #include <utility>
 
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/values.h"
+
 namespace net {
 
-SpdySettingsStorage::SpdySettingsStorage() {
+namespace {
+
+base::TimeDelta MaxAge() {
+  return base::TimeDelta::FromDays(SpdySettingsStorage::kMaxAgeDays);
+}
+
+}  // namespace
+
+// static
+const size_t SpdySettingsStorage::kMaxEntries = 200;
+
+// static
+const int SpdySettingsStorage::kMaxAgeDays = 30;
+
+SpdySettingsStorage::SpdySettingsStorage() : delegate_(NULL) {
 }
 
 SpdySettingsStorage::~SpdySettingsStorage() {
@@ -16,12 +35,13 @@ SpdySettingsStorage::~SpdySettingsStorage() {
 
 const spdy::SpdySettings& SpdySettingsStorage::Get(
     const HostPortPair& host_port_pair) const {
+  static const spdy::SpdySettings kEmpty;
   SettingsMap::const_iterator it = settings_map_.find(host_port_pair);
-  if (it == settings_map_.end()) {
-    static const spdy::SpdySettings kEmpty;
+  if (it == settings_map_.end())
     return kEmpty;
-  }
-  return it->second;
+  if (base::Time::Now() - it->second.last_update > MaxAge())
+    return kEmpty;
+  return it->second.settings;
 }
 
 void SpdySettingsStorage::Set(const HostPortPair& host_port_pair,
@@ -43,8 +63,116 @@ void SpdySettingsStorage::Set(const HostPortPair& host_port_pair,
   if (persistent_settings.empty())
     return;
 
-  settings_map_[host_port_pair] = persistent_settings;
+  Entry& entry = settings_map_[host_port_pair];
+  entry.settings = persistent_settings;
+  entry.last_update = base::Time::Now();
+  EvictEntries();
+  DirtyNotify();
 }
 
-}  // namespace net
+void SpdySettingsStorage::Serialize(std::string* output) const {
+  const base::Time now = base::Time::Now();
+  ListValue entries;
+  for (SettingsMap::const_iterator it = settings_map_.begin();
+       it != settings_map_.end(); ++it) {
+    if (now - it->second.last_update > MaxAge())
+      continue;
+
+    ListValue* settings = new ListValue;
+    for (spdy::SpdySettings::const_iterator setting =
+             it->second.settings.begin();
+         setting != it->second.settings.end(); ++setting) {
+      DictionaryValue* value = new DictionaryValue;
+      value->SetInteger("id", setting->first.id());
+      value->SetDouble("value", setting->second);
+      settings->Append(value);
+    }
+
+    DictionaryValue* entry = new DictionaryValue;
+    entry->SetString("host", it->first.host());
+    entry->SetInteger("port", it->first.port());
+    entry->SetDouble("last_update", it->second.last_update.ToDoubleT());
+    entry->Set("settings", settings);
+    entries.Append(entry);
+  }
+
+  base::JSONWriter::Write(&entries, false /* no pretty print */, output);
+}
+
+bool SpdySettingsStorage::LoadEntries(const std::string& input) {
+  scoped_ptr<Value> value(
+      base::JSONReader::Read(input, false /* do not allow trailing commas */));
+  if (!value.get() || !value->IsType(Value::TYPE_LIST))
+    return false;
 
+  ListValue* entries = static_cast<ListValue*>(value.get());
+  const base::Time now = base::Time::Now();
+  for (size_t i = 0; i < entries->GetSize(); ++i) {
+    DictionaryValue* entry;
+    std::string host;
+    int port;
+    double last_update;
+    ListValue* settings_list;
+    if (!entries->GetDictionary(i, &entry) ||
+        !entry->GetString("host", &host) ||
+        !entry->GetInteger("port", &port) ||
+        !entry->GetDouble("last_update", &last_update) ||
+        !entry->GetList("settings", &settings_list)) {
+      continue;
+    }
+
+    base::Time last_update_time = base::Time::FromDoubleT(last_update);
+    if (now - last_update_time > MaxAge())
+      continue;
+
+    HostPortPair host_port_pair(host, port);
+    if (settings_map_.find(host_port_pair) != settings_map_.end())
+      continue;
+
+    spdy::SpdySettings settings;
+    for (size_t j = 0; j < settings_list->GetSize(); ++j) {
+      DictionaryValue* setting;
+      int id;
+      double setting_value;
+      if (!settings_list->GetDictionary(j, &setting) ||
+          !setting->GetInteger("id", &id) ||
+          !setting->GetDouble("value", &setting_value) ||
+          (id & ~spdy::kSettingsIdMask) != 0) {
+        continue;
+      }
+      spdy::SettingsFlagsAndId flags_and_id(0);
+      flags_and_id.set_id(id);
+      flags_and_id.set_flags(spdy::SETTINGS_FLAG_PERSISTED);
+      settings.push_back(
+          std::make_pair(flags_and_id, static_cast<uint32>(setting_value)));
+    }
+    if (settings.empty())
+      continue;
+
+    Entry& new_entry = settings_map_[host_port_pair];
+    new_entry.settings = settings;
+    new_entry.last_update = last_update_time;
+  }
+
+  EvictEntries();
+  return true;
+}
+
+void SpdySettingsStorage::EvictEntries() {
+  while (settings_map_.size() > kMaxEntries) {
+    SettingsMap::iterator oldest = settings_map_.begin();
+    for (SettingsMap::iterator it = settings_map_.begin();
+         it != settings_map_.end(); ++it) {
+      if (it->second.last_update < oldest->second.last_update)
+        oldest = it;
+    }
+    settings_map_.erase(oldest);
+  }
+}
+
+void SpdySettingsStorage::DirtyNotify() {
+  if (delegate_)
+    delegate_->SettingsAreDirty(this);
+}
+
+}  // namespace net
@@ -1,4 +1,4 @@
-// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
@@ -7,7 +7,10 @@
 #pragma once
 
 #include <map>
+#include <string>
+
 #include "base/basictypes.h"
+#include "base/time.h"
 #include "net/base/host_port_pair.h"
 #include "net/spdy/spdy_framer.h"
 
@@ -15,11 +18,34 @@ namespace net {
 
 // SpdySettingsStorage stores SpdySettings which have been transmitted between
 // endpoints for the SPDY SETTINGS frame.
+//
+// The settings can be saved across restarts: a Delegate is told when they
+// change, and can Serialize() them and LoadEntries() them back later. Only
+// the |kMaxEntries| most recently updated hosts are kept, and the settings of
+// a host are forgotten |kMaxAgeDays| after they were last updated.
 class SpdySettingsStorage {
  public:
+  class Delegate {
+   public:
+    // Called when the stored settings change. This must not reenter the
+    // SpdySettingsStorage.
+    virtual void SettingsAreDirty(SpdySettingsStorage* storage) = 0;
+
+   protected:
+    virtual ~Delegate() {}
+  };
+
+  // The maximum number of hosts for which settings are stored.
+  static const size_t kMaxEntries;
+
+  // The number of days for which the settings of a host are kept.
+  static const int kMaxAgeDays;
+
   SpdySettingsStorage();
   ~SpdySettingsStorage();
 
+  void set_delegate(Delegate* delegate) { delegate_ = delegate; }
+
   // Get a copy of the SpdySettings stored for a host.
   // If no settings are stored, returns an empty set of settings.
   const spdy::SpdySettings& Get(const HostPortPair& host_port_pair) const;
@@ -28,15 +54,34 @@ class SpdySettingsStorage {
   void Set(const HostPortPair& host_port_pair,
            const spdy::SpdySettings& settings);
 
+  // Writes the stored settings to |output|, as JSON.
+  void Serialize(std::string* output) const;
+
+  // Adds the settings serialized in |input| for the hosts that have no
+  // settings yet. Entries that have expired are skipped. Returns false if
+  // |input| can't be parsed.
+  bool LoadEntries(const std::string& input);
+
  private:
-  typedef std::map<HostPortPair, spdy::SpdySettings> SettingsMap;
+  struct Entry {
+    spdy::SpdySettings settings;
+    base::Time last_update;
+  };
+
+  typedef std::map<HostPortPair, Entry> SettingsMap;
+
+  // Drops the least recently updated entries beyond |kMaxEntries|.
+  void EvictEntries();
+
+  void DirtyNotify();
 
   SettingsMap settings_map_;
 
+  Delegate* delegate_;
+
   DISALLOW_COPY_AND_ASSIGN(SpdySettingsStorage);
 };
 
 }  // namespace net
 
 #endif  // NET_SPDY_SPDY_SETTING_STORAGE_H_
-
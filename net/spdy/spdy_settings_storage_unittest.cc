@@ -0,0 +1,143 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/spdy/spdy_settings_storage.h"
+
+#include <string>
+#include <utility>
+
+#include "base/string_number_conversions.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+class CountingDelegate : public SpdySettingsStorage::Delegate {
+ public:
+  CountingDelegate() : dirty_count_(0) {}
+
+  virtual void SettingsAreDirty(SpdySettingsStorage* storage) {
+    dirty_count_++;
+  }
+
+  int dirty_count() const { return dirty_count_; }
+
+ private:
+  int dirty_count_;
+};
+
+spdy::SpdySettings MakeSettings(uint32 id, uint32 value, uint8 flags) {
+  spdy::SettingsFlagsAndId flags_and_id(0);
+  flags_and_id.set_id(id);
+  flags_and_id.set_flags(flags);
+  spdy::SpdySettings settings;
+  settings.push_back(std::make_pair(flags_and_id, value));
+  return settings;
+}
+
+// Returns a serialized entry for www.google.com:443 updated |age| ago.
+std::string SerializedEntry(base::TimeDelta age) {
+  return base::StringPrintf(
+      "[{\"host\":\"www.google.com\",\"port\":443,\"last_update\":%s,"
+      "\"settings\":[{\"id\":5,\"value\":32.0}]}]",
+      base::DoubleToString((base::Time::Now() - age).ToDoubleT()).c_str());
+}
+
+TEST(SpdySettingsStorageTest, KeepsOnlySettingsToPersist) {
+  SpdySettingsStorage storage;
+  CountingDelegate delegate;
+  storage.set_delegate(&delegate);
+  HostPortPair host_port_pair("www.google.com", 443);
+
+  storage.Set(host_port_pair,
+              MakeSettings(spdy::SETTINGS_CURRENT_CWND, 32, 0));
+  EXPECT_TRUE(storage.Get(host_port_pair).empty());
+  EXPECT_EQ(0, delegate.dirty_count());
+
+  storage.Set(host_port_pair,
+              MakeSettings(spdy::SETTINGS_CURRENT_CWND, 32,
+                           spdy::SETTINGS_FLAG_PLEASE_PERSIST));
+  const spdy::SpdySettings& settings = storage.Get(host_port_pair);
+  ASSERT_EQ(1u, settings.size());
+  EXPECT_EQ(spdy::SETTINGS_FLAG_PERSISTED, settings.front().first.flags());
+  EXPECT_EQ(32u, settings.front().second);
+  EXPECT_EQ(1, delegate.dirty_count());
+}
+
+TEST(SpdySettingsStorageTest, SerializeAndLoad) {
+  SpdySettingsStorage storage;
+  HostPortPair host_port_pair("www.google.com", 443);
+  storage.Set(host_port_pair,
+              MakeSettings(spdy::SETTINGS_CURRENT_CWND, 32,
+                           spdy::SETTINGS_FLAG_PLEASE_PERSIST));
+  storage.Set(HostPortPair("mail.google.com", 443),
+              MakeSettings(spdy::SETTINGS_INITIAL_WINDOW_SIZE, 1 << 20,
+                           spdy::SETTINGS_FLAG_PLEASE_PERSIST));
+  std::string serialized;
+  storage.Serialize(&serialized);
+
+  SpdySettingsStorage loaded;
+  EXPECT_TRUE(loaded.LoadEntries(serialized));
+  const spdy::SpdySettings& settings = loaded.Get(host_port_pair);
+  ASSERT_EQ(1u, settings.size());
+  EXPECT_EQ(spdy::SETTINGS_CURRENT_CWND, settings.front().first.id());
+  EXPECT_EQ(spdy::SETTINGS_FLAG_PERSISTED, settings.front().first.flags());
+  EXPECT_EQ(32u, settings.front().second);
+  ASSERT_EQ(1u, loaded.Get(HostPortPair("mail.google.com", 443)).size());
+  EXPECT_EQ(1u << 20,
+            loaded.Get(HostPortPair("mail.google.com", 443)).front().second);
+
+  EXPECT_FALSE(loaded.LoadEntries("not json"));
+}
+
+TEST(SpdySettingsStorageTest, LoadSkipsExpiredEntries) {
+  HostPortPair host_port_pair("www.google.com", 443);
+  base::TimeDelta max_age =
+      base::TimeDelta::FromDays(SpdySettingsStorage::kMaxAgeDays);
+
+  SpdySettingsStorage fresh;
+  EXPECT_TRUE(fresh.LoadEntries(
+      SerializedEntry(max_age - base::TimeDelta::FromDays(1))));
+  EXPECT_EQ(1u, fresh.Get(host_port_pair).size());
+
+  SpdySettingsStorage expired;
+  EXPECT_TRUE(expired.LoadEntries(
+      SerializedEntry(max_age + base::TimeDelta::FromDays(1))));
+  EXPECT_TRUE(expired.Get(host_port_pair).empty());
+}
+
+TEST(SpdySettingsStorageTest, LoadKeepsNewerSettings) {
+  SpdySettingsStorage storage;
+  HostPortPair host_port_pair("www.google.com", 443);
+  storage.Set(host_port_pair,
+              MakeSettings(spdy::SETTINGS_CURRENT_CWND, 10,
+                           spdy::SETTINGS_FLAG_PLEASE_PERSIST));
+
+  EXPECT_TRUE(storage.LoadEntries(SerializedEntry(base::TimeDelta())));
+  ASSERT_EQ(1u, storage.Get(host_port_pair).size());
+  EXPECT_EQ(10u, storage.Get(host_port_pair).front().second);
+}
+
+TEST(SpdySettingsStorageTest, EvictsLeastRecentlyUpdated) {
+  SpdySettingsStorage storage;
+  // Load an old entry first, so that it's the least recently updated one.
+  EXPECT_TRUE(storage.LoadEntries(
+      SerializedEntry(base::TimeDelta::FromDays(1))));
+  for (size_t i = 0; i < SpdySettingsStorage::kMaxEntries; ++i) {
+    storage.Set(HostPortPair(base::StringPrintf("host%d.com",
+                                                static_cast<int>(i)), 443),
+                MakeSettings(spdy::SETTINGS_CURRENT_CWND, 32,
+                             spdy::SETTINGS_FLAG_PLEASE_PERSIST));
+  }
+
+  EXPECT_TRUE(storage.Get(HostPortPair("www.google.com", 443)).empty());
+  EXPECT_EQ(1u, storage.Get(HostPortPair("host0.com", 443)).size());
+}
+
+}  // namespace
+
+}  // namespace net
@@ -4,6 +4,8 @@
 
 #include "net/spdy/spdy_stream.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/message_loop.h"
 #include "base/values.h"
@@ -45,6 +47,9 @@ SpdyStream::SpdyStream(SpdySession* session,
       stalled_by_flow_control_(false),
       send_window_size_(spdy::kSpdyStreamInitialWindowSize),
       recv_window_size_(spdy::kSpdyStreamInitialWindowSize),
+      recv_window_target_(spdy::kSpdyStreamInitialWindowSize),
+      recv_window_growth_(0),
+      autotune_bytes_consumed_(0),
       pushed_(pushed),
       response_received_(false),
       session_(session),
@@ -78,6 +83,46 @@ void SpdyStream::SetDelegate(Delegate* delegate) {
   }
 }
 
+int SpdyStream::AutoTuneRecvWindow(int bytes_consumed) {
+  base::TimeDelta rtt = session_->smoothed_rtt();
+  if (rtt == base::TimeDelta()) {
+    session_->MeasureRtt();
+    return 0;
+  }
+
+  base::TimeTicks now = base::TimeTicks::Now();
+  if (autotune_start_time_.is_null()) {
+    autotune_start_time_ = now;
+    return 0;
+  }
+
+  autotune_bytes_consumed_ += bytes_consumed;
+  base::TimeDelta elapsed = now - autotune_start_time_;
+  if (elapsed < rtt)
+    return 0;
+
+  int target = GetAutoTunedRecvWindowSize(recv_window_target_,
+                                          autotune_bytes_consumed_,
+                                          elapsed,
+                                          rtt,
+                                          SpdySession::max_recv_window_size());
+  autotune_start_time_ = now;
+  autotune_bytes_consumed_ = 0;
+  if (target <= recv_window_target_)
+    return 0;
+
+  int growth = session_->ReserveRecvWindowGrowth(target - recv_window_target_);
+  if (!growth)
+    return 0;
+  recv_window_target_ += growth;
+  recv_window_growth_ += growth;
+  net_log_.AddEvent(
+      NetLog::TYPE_SPDY_STREAM_RECV_WINDOW_TUNED,
+      make_scoped_refptr(
+          new NetLogIntegerParameter("window_size", recv_window_target_)));
+  return growth;
+}
+
 void SpdyStream::PushedStreamReplayData() {
   if (cancelled_ || !delegate_)
     return;
@@ -93,7 +138,7 @@ void SpdyStream::PushedStreamReplayData() {
     return;
   }
 
-  std::vector<scoped_refptr<IOBufferWithSize> > buffers;
+  std::vector<scoped_refptr<DrainableIOBuffer> > buffers;
   buffers.swap(pending_buffers_);
   for (size_t i = 0; i < buffers.size(); ++i) {
     // It is always possible that a callback to the delegate results in
@@ -101,9 +146,9 @@ void SpdyStream::PushedStreamReplayData() {
     if (!delegate_)
       break;
     if (buffers[i]) {
-      delegate_->OnDataReceived(buffers[i]->data(), buffers[i]->size());
+      delegate_->OnDataReceived(buffers[i]);
     } else {
-      delegate_->OnDataReceived(NULL, 0);
+      delegate_->OnDataReceived(NULL);
       session_->CloseStream(stream_id_, net::OK);
       // Note: |this| may be deleted after calling CloseStream.
       DCHECK_EQ(buffers.size() - 1, i);
@@ -187,6 +232,8 @@ void SpdyStream::IncreaseRecvWindowSize(int delta_window_size) {
   // By the time a read is isued, stream may become inactive.
   if (!session_->IsStreamActive(stream_id_))
     return;
+  if (session_->recv_window_autotuning())
+    delta_window_size += AutoTuneRecvWindow(delta_window_size);
   int new_window_size = recv_window_size_ + delta_window_size;
   if (recv_window_size_ > 0)
     DCHECK(new_window_size > 0);
@@ -214,6 +261,26 @@ void SpdyStream::DecreaseRecvWindowSize(int delta_window_size) {
     session_->ResetStream(stream_id_, spdy::FLOW_CONTROL_ERROR);
 }
 
+// static
+int SpdyStream::GetAutoTunedRecvWindowSize(int window_size,
+                                           int bytes_consumed,
+                                           base::TimeDelta elapsed,
+                                           base::TimeDelta rtt,
+                                           int max_window_size) {
+  if (rtt <= base::TimeDelta() || elapsed < rtt)
+    return window_size;
+
+  // The window has to hold what the server sends during a round trip, plus
+  // as much again so the server does not stall while a WINDOW_UPDATE is on
+  // its way.
+  int64 bytes_per_rtt = static_cast<int64>(bytes_consumed) *
+      rtt.InMicroseconds() / elapsed.InMicroseconds();
+  if (2 * bytes_per_rtt < window_size)
+    return window_size;
+  return static_cast<int>(std::min(static_cast<int64>(window_size) * 2,
+                                   static_cast<int64>(max_window_size)));
+}
+
 int SpdyStream::GetPeerAddress(AddressList* address) const {
   return session_->GetPeerAddress(address);
 }
@@ -288,8 +355,9 @@ int SpdyStream::OnHeaders(const spdy::SpdyHeaderBlock& headers) {
   return rv;
 }
 
-void SpdyStream::OnDataReceived(const char* data, int length) {
-  DCHECK_GE(length, 0);
+void SpdyStream::OnDataReceived(DrainableIOBuffer* buffer) {
+  const int length = buffer ? buffer->BytesRemaining() : 0;
+  DCHECK(!buffer || length > 0);
 
   // If we don't have a response, then the SYN_REPLY did not come through.
   // We cannot pass data up to the caller unless the reply headers have been
@@ -302,10 +370,8 @@ void SpdyStream::OnDataReceived(const char* data, int length) {
   if (!delegate_ || continue_buffering_data_) {
     // It should be valid for this to happen in the server push case.
     // We'll return received data when delegate gets attached to the stream.
-    if (length > 0) {
-      IOBufferWithSize* buf = new IOBufferWithSize(length);
-      memcpy(buf->data(), data, length);
-      pending_buffers_.push_back(make_scoped_refptr(buf));
+    if (buffer) {
+      pending_buffers_.push_back(make_scoped_refptr(buffer));
     } else {
       pending_buffers_.push_back(NULL);
       metrics_.StopStream();
@@ -317,8 +383,8 @@ void SpdyStream::OnDataReceived(const char* data, int length) {
 
   CHECK(!closed());
 
-  // A zero-length read means that the stream is being closed.
-  if (!length) {
+  // A NULL buffer means that the stream is being closed.
+  if (!buffer) {
     metrics_.StopStream();
     session_->CloseStream(stream_id_, net::OK);
     // Note: |this| may be deleted after calling CloseStream.
@@ -336,13 +402,11 @@ void SpdyStream::OnDataReceived(const char* data, int length) {
   if (!delegate_) {
     // It should be valid for this to happen in the server push case.
     // We'll return received data when delegate gets attached to the stream.
-    IOBufferWithSize* buf = new IOBufferWithSize(length);
-    memcpy(buf->data(), data, length);
-    pending_buffers_.push_back(make_scoped_refptr(buf));
+    pending_buffers_.push_back(make_scoped_refptr(buffer));
     return;
   }
 
-  delegate_->OnDataReceived(data, length);
+  delegate_->OnDataReceived(buffer);
 }
 
 // This function is only called when an entire frame is written.
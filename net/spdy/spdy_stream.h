@@ -69,8 +69,10 @@ class SpdyStream
                                    base::Time response_time,
                                    int status) = 0;
 
-    // Called when data is received.
-    virtual void OnDataReceived(const char* data, int length) = 0;
+    // Called when data is received. |buffer| may point into the session's
+    // read buffer, so the delegate can keep a reference to it instead of
+    // copying the data. A NULL |buffer| indicates the end of the stream.
+    virtual void OnDataReceived(DrainableIOBuffer* buffer) = 0;
 
     // Called when data is sent.
     virtual void OnDataSent(int length) = 0;
@@ -129,8 +131,12 @@ class SpdyStream
   int recv_window_size() const { return recv_window_size_; }
   void set_recv_window_size(int window_size) {
     recv_window_size_ = window_size;
+    recv_window_target_ = window_size;
   }
 
+  // The receive window that was added by auto-tuning.
+  int recv_window_growth() const { return recv_window_growth_; }
+
   void set_stalled_by_flow_control(bool stalled) {
     stalled_by_flow_control_ = stalled;
   }
@@ -151,7 +157,8 @@ class SpdyStream
   bool WasEverUsed() const;
 
   // Increases |recv_window_size_| by the given number of bytes, also sends
-  // a WINDOW_UPDATE frame.
+  // a WINDOW_UPDATE frame. With auto-tuning, the update may also grow the
+  // window.
   void IncreaseRecvWindowSize(int delta_window_size);
 
   // Decreases |recv_window_size_| by the given number of bytes, called
@@ -160,6 +167,16 @@ class SpdyStream
   // negative, since that would be a flow control violation.
   void DecreaseRecvWindowSize(int delta_window_size);
 
+  // Returns the receive window to use for a stream whose consumer read
+  // |bytes_consumed| bytes over |elapsed|, on a connection with the round trip
+  // time |rtt|. The window is doubled, up to |max_window_size|, when it does
+  // not cover twice what is consumed in a round trip.
+  static int GetAutoTunedRecvWindowSize(int window_size,
+                                        int bytes_consumed,
+                                        base::TimeDelta elapsed,
+                                        base::TimeDelta rtt,
+                                        int max_window_size);
+
   const BoundNetLog& net_log() const { return net_log_; }
 
   const linked_ptr<spdy::SpdyHeaderBlock>& spdy_headers() const;
@@ -178,11 +195,9 @@ class SpdyStream
   // Called by the SpdySession when response data has been received for this
   // stream.  This callback may be called multiple times as data arrives
   // from the network, and will never be called prior to OnResponseReceived.
-  // |buffer| contains the data received.  The stream must copy any data
-  //          from this buffer before returning from this callback.
-  // |length| is the number of bytes received or an error.
-  //         A zero-length count does not indicate end-of-stream.
-  void OnDataReceived(const char* buffer, int bytes);
+  // |buffer| contains the data received, and may be kept by the stream.
+  //          A NULL |buffer| indicates the end of the stream.
+  void OnDataReceived(DrainableIOBuffer* buffer);
 
   // Called by the SpdySession when a write has completed.  This callback
   // will be called multiple times for each write which completes.  Writes
@@ -269,6 +284,10 @@ class SpdyStream
   // the MessageLoop to replay all the data that the server has already sent.
   void PushedStreamReplayData();
 
+  // Grows the receive window if the consumer of the data keeps up with it.
+  // |bytes_consumed| were just read. Returns how much the window grew.
+  int AutoTuneRecvWindow(int bytes_consumed);
+
   // There is a small period of time between when a server pushed stream is
   // first created, and the pushed data is replayed. Any data received during
   // this time should continue to be buffered.
@@ -283,6 +302,14 @@ class SpdyStream
   int send_window_size_;
   int recv_window_size_;
 
+  // Receive window auto-tuning: the window the stream currently aims for,
+  // how much it grew past the initial window, and the data consumed since
+  // the start of the current measurement.
+  int recv_window_target_;
+  int recv_window_growth_;
+  base::TimeTicks autotune_start_time_;
+  int autotune_bytes_consumed_;
+
   const bool pushed_;
   ScopedBandwidthMetrics metrics_;
   bool response_received_;
@@ -319,7 +346,7 @@ class SpdyStream
   int send_bytes_;
   int recv_bytes_;
   // Data received before delegate is attached.
-  std::vector<scoped_refptr<IOBufferWithSize> > pending_buffers_;
+  std::vector<scoped_refptr<DrainableIOBuffer> > pending_buffers_;
 
   DISALLOW_COPY_AND_ASSIGN(SpdyStream);
 };
@@ -68,8 +68,9 @@ class TestSpdyStreamDelegate : public SpdyStream::Delegate {
     }
     return status;
   }
-  virtual void OnDataReceived(const char* buffer, int bytes) {
-    received_data_ += std::string(buffer, bytes);
+  virtual void OnDataReceived(DrainableIOBuffer* buffer) {
+    if (buffer)
+      received_data_ += std::string(buffer->data(), buffer->BytesRemaining());
   }
   virtual void OnDataSent(int length) {
     data_sent_ += length;
@@ -280,5 +281,27 @@ TEST_F(SpdyStreamTest, PushedStream) {
   EXPECT_EQ(kStreamUrl, stream->GetUrl().spec());
 }
 
+TEST_F(SpdyStreamTest, AutoTunedRecvWindowSize) {
+  const int kWindow = 64 * 1024;
+  const int kMaxWindow = 96 * 1024;
+  const base::TimeDelta kRtt = base::TimeDelta::FromMilliseconds(100);
+  const base::TimeDelta kSecond = base::TimeDelta::FromSeconds(1);
+
+  // Not measured over a full round trip yet.
+  EXPECT_EQ(kWindow, SpdyStream::GetAutoTunedRecvWindowSize(
+      kWindow, kWindow, kRtt / 2, kRtt, kMaxWindow));
+  // No round trip time known.
+  EXPECT_EQ(kWindow, SpdyStream::GetAutoTunedRecvWindowSize(
+      kWindow, kWindow, kSecond, base::TimeDelta(), kMaxWindow));
+  // A slow reader does not need a bigger window.
+  EXPECT_EQ(kWindow, SpdyStream::GetAutoTunedRecvWindowSize(
+      kWindow, kWindow, kSecond, kRtt, kMaxWindow));
+  // A full window per round trip: the window limits the transfer.
+  EXPECT_EQ(kMaxWindow, SpdyStream::GetAutoTunedRecvWindowSize(
+      kWindow, kWindow, kRtt, kRtt, kMaxWindow));
+  EXPECT_EQ(2 * kWindow, SpdyStream::GetAutoTunedRecvWindowSize(
+      kWindow, kWindow / 2, kRtt, kRtt, 4 * kWindow));
+}
+
 
 }  // namespace net
@@ -0,0 +1,144 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/spdy/spdy_write_queue.h"
+
+#include "base/logging.h"
+#include "net/spdy/spdy_stream.h"
+
+namespace net {
+
+namespace {
+
+// The number of DATA frames a priority level may send per round.
+int WeightForLevel(int level) {
+  return 1 << (NUM_PRIORITIES - 1 - level);
+}
+
+}  // namespace
+
+SpdyWriteQueue::Stats::Stats() : frames(0) {}
+
+SpdyWriteQueue::SpdyWriteQueue() : size_(0) {
+  for (int i = 0; i < NUM_PRIORITIES; ++i)
+    credits_[i] = WeightForLevel(i);
+}
+
+SpdyWriteQueue::~SpdyWriteQueue() {}
+
+void SpdyWriteQueue::Push(const SpdyIOBuffer& buffer, bool is_data) {
+  QueuedBuffer queued;
+  queued.buffer = buffer;
+  queued.queued_time = base::TimeTicks::Now();
+  size_++;
+
+  if (!is_data) {
+    control_queue_.push(queued);
+    return;
+  }
+
+  PriorityLevel& level = data_levels_[ClampPriority(buffer.priority())];
+  SpdyStream* stream = buffer.stream().get();
+  for (PriorityLevel::iterator it = level.begin(); it != level.end(); ++it) {
+    if (it->stream == stream) {
+      it->buffers.push_back(queued);
+      return;
+    }
+  }
+  level.push_back(StreamQueue());
+  level.back().stream = stream;
+  level.back().buffers.push_back(queued);
+}
+
+SpdyIOBuffer SpdyWriteQueue::Pop() {
+  DCHECK(!empty());
+  size_--;
+
+  if (!control_queue_.empty()) {
+    QueuedBuffer queued = control_queue_.top();
+    control_queue_.pop();
+    return Dequeue(queued);
+  }
+
+  PriorityLevel& level = data_levels_[NextDataLevel()];
+  StreamQueue& stream_queue = level.front();
+  QueuedBuffer queued = stream_queue.buffers.front();
+  stream_queue.buffers.pop_front();
+
+  // Give the other streams of this level their turn.
+  if (stream_queue.buffers.empty()) {
+    level.pop_front();
+  } else if (level.size() > 1) {
+    level.push_back(stream_queue);
+    level.pop_front();
+  }
+  return Dequeue(queued);
+}
+
+void SpdyWriteQueue::RemovePendingDataForStream(SpdyStream* stream) {
+  for (int i = 0; i < NUM_PRIORITIES; ++i) {
+    PriorityLevel& level = data_levels_[i];
+    for (PriorityLevel::iterator it = level.begin(); it != level.end(); ++it) {
+      if (it->stream == stream) {
+        size_ -= it->buffers.size();
+        level.erase(it);
+        break;
+      }
+    }
+  }
+}
+
+void SpdyWriteQueue::Clear() {
+  while (!control_queue_.empty())
+    control_queue_.pop();
+  for (int i = 0; i < NUM_PRIORITIES; ++i)
+    data_levels_[i].clear();
+  size_ = 0;
+}
+
+const SpdyWriteQueue::Stats& SpdyWriteQueue::stats(int priority) const {
+  return stats_[ClampPriority(priority)];
+}
+
+int SpdyWriteQueue::NextDataLevel() {
+  int first_level = -1;
+  for (int i = 0; i < NUM_PRIORITIES; ++i) {
+    if (data_levels_[i].empty())
+      continue;
+    if (first_level < 0)
+      first_level = i;
+    if (credits_[i] > 0) {
+      credits_[i]--;
+      return i;
+    }
+  }
+  DCHECK_GE(first_level, 0);
+
+  // Every level with data has used its share: start a new round.
+  for (int i = 0; i < NUM_PRIORITIES; ++i)
+    credits_[i] = WeightForLevel(i);
+  credits_[first_level]--;
+  return first_level;
+}
+
+SpdyIOBuffer SpdyWriteQueue::Dequeue(const QueuedBuffer& queued) {
+  base::TimeDelta delay = base::TimeTicks::Now() - queued.queued_time;
+  Stats& stats = stats_[ClampPriority(queued.buffer.priority())];
+  stats.frames++;
+  stats.total_delay += delay;
+  if (delay > stats.max_delay)
+    stats.max_delay = delay;
+  return queued.buffer;
+}
+
+// static
+int SpdyWriteQueue::ClampPriority(int priority) {
+  if (priority < 0)
+    return 0;
+  if (priority >= NUM_PRIORITIES)
+    return NUM_PRIORITIES - 1;
+  return priority;
+}
+
+}  // namespace net
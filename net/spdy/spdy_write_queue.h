@@ -0,0 +1,102 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_SPDY_SPDY_WRITE_QUEUE_H_
+#define NET_SPDY_SPDY_WRITE_QUEUE_H_
+#pragma once
+
+#include <deque>
+#include <queue>
+
+#include "base/basictypes.h"
+#include "base/time.h"
+#include "net/base/request_priority.h"
+#include "net/spdy/spdy_io_buffer.h"
+
+namespace net {
+
+class SpdyStream;
+
+// The queue of frames waiting to be written by a SpdySession.
+//
+// Control frames are always written first, in priority order, so that a new
+// SYN_STREAM (or a PING) does not wait behind the DATA frames of other
+// streams. DATA frames are scheduled with a weighted round-robin: each
+// priority level gets a number of frames per round that doubles with every
+// step up in priority, so lower priorities are slowed down but never
+// starved. Within a priority level, the streams take turns.
+class SpdyWriteQueue {
+ public:
+  // Queueing statistics for one priority level.
+  struct Stats {
+    Stats();
+
+    int frames;
+    base::TimeDelta total_delay;
+    base::TimeDelta max_delay;
+  };
+
+  SpdyWriteQueue();
+  ~SpdyWriteQueue();
+
+  // Adds |buffer| to the queue. |is_data| tells if it holds a DATA frame.
+  void Push(const SpdyIOBuffer& buffer, bool is_data);
+
+  // Removes and returns the next buffer to write. The queue must not be empty.
+  SpdyIOBuffer Pop();
+
+  // Drops the DATA frames of |stream| that are still queued.
+  void RemovePendingDataForStream(SpdyStream* stream);
+
+  // Drops everything.
+  void Clear();
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+
+  // Returns the statistics of the frames popped so far for |priority|.
+  const Stats& stats(int priority) const;
+
+ private:
+  struct QueuedBuffer {
+    SpdyIOBuffer buffer;
+    base::TimeTicks queued_time;
+
+    bool operator<(const QueuedBuffer& other) const {
+      return buffer < other.buffer;
+    }
+  };
+
+  // The DATA frames queued by one stream.
+  struct StreamQueue {
+    SpdyStream* stream;
+    std::deque<QueuedBuffer> buffers;
+  };
+
+  // The streams with DATA frames for one priority level, in turn order.
+  typedef std::deque<StreamQueue> PriorityLevel;
+
+  // Returns the level that should send the next DATA frame.
+  int NextDataLevel();
+
+  // Records the queueing delay of |queued| and returns its buffer.
+  SpdyIOBuffer Dequeue(const QueuedBuffer& queued);
+
+  static int ClampPriority(int priority);
+
+  std::priority_queue<QueuedBuffer> control_queue_;
+  PriorityLevel data_levels_[NUM_PRIORITIES];
+
+  // The number of DATA frames each level may still send in this round.
+  int credits_[NUM_PRIORITIES];
+
+  Stats stats_[NUM_PRIORITIES];
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(SpdyWriteQueue);
+};
+
+}  // namespace net
+
+#endif  // NET_SPDY_SPDY_WRITE_QUEUE_H_
@@ -0,0 +1,101 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/spdy/spdy_write_queue.h"
+
+#include "base/memory/ref_counted.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_log.h"
+#include "net/spdy/spdy_stream.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// Returns a one byte buffer whose content is |tag|.
+SpdyIOBuffer MakeBuffer(char tag, int priority, SpdyStream* stream) {
+  IOBuffer* buffer = new IOBuffer(1);
+  buffer->data()[0] = tag;
+  return SpdyIOBuffer(buffer, 1, priority, stream);
+}
+
+char PopTag(SpdyWriteQueue* queue) {
+  SpdyIOBuffer buffer = queue->Pop();
+  return buffer.buffer()->data()[0];
+}
+
+scoped_refptr<SpdyStream> MakeStream(spdy::SpdyStreamId id) {
+  return new SpdyStream(NULL, id, false, BoundNetLog());
+}
+
+TEST(SpdyWriteQueueTest, ControlFramesFirst) {
+  scoped_refptr<SpdyStream> stream(MakeStream(1));
+  SpdyWriteQueue queue;
+  queue.Push(MakeBuffer('a', HIGHEST, stream), true);
+  queue.Push(MakeBuffer('b', LOWEST, NULL), false);
+  queue.Push(MakeBuffer('c', HIGHEST, NULL), false);
+  EXPECT_EQ(3u, queue.size());
+
+  EXPECT_EQ('c', PopTag(&queue));
+  EXPECT_EQ('b', PopTag(&queue));
+  EXPECT_EQ('a', PopTag(&queue));
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(2, queue.stats(HIGHEST).frames);
+  EXPECT_EQ(1, queue.stats(LOWEST).frames);
+}
+
+TEST(SpdyWriteQueueTest, LowPriorityIsNotStarved) {
+  scoped_refptr<SpdyStream> high(MakeStream(1));
+  scoped_refptr<SpdyStream> low(MakeStream(3));
+  SpdyWriteQueue queue;
+  const int kHighestWeight = 1 << (NUM_PRIORITIES - 1);
+  for (int i = 0; i < 2 * kHighestWeight; ++i)
+    queue.Push(MakeBuffer('h', HIGHEST, high), true);
+  queue.Push(MakeBuffer('l', LOWEST, low), true);
+
+  // The low priority frame goes out once the highest level used up its share,
+  // instead of waiting for all of its frames.
+  for (int i = 0; i < kHighestWeight; ++i)
+    EXPECT_EQ('h', PopTag(&queue));
+  EXPECT_EQ('l', PopTag(&queue));
+  while (!queue.empty())
+    EXPECT_EQ('h', PopTag(&queue));
+}
+
+TEST(SpdyWriteQueueTest, StreamsTakeTurns) {
+  scoped_refptr<SpdyStream> stream1(MakeStream(1));
+  scoped_refptr<SpdyStream> stream3(MakeStream(3));
+  SpdyWriteQueue queue;
+  queue.Push(MakeBuffer('a', MEDIUM, stream1), true);
+  queue.Push(MakeBuffer('b', MEDIUM, stream1), true);
+  queue.Push(MakeBuffer('x', MEDIUM, stream3), true);
+  queue.Push(MakeBuffer('y', MEDIUM, stream3), true);
+
+  EXPECT_EQ('a', PopTag(&queue));
+  EXPECT_EQ('x', PopTag(&queue));
+  EXPECT_EQ('b', PopTag(&queue));
+  EXPECT_EQ('y', PopTag(&queue));
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(SpdyWriteQueueTest, RemovePendingDataForStream) {
+  scoped_refptr<SpdyStream> stream1(MakeStream(1));
+  scoped_refptr<SpdyStream> stream3(MakeStream(3));
+  SpdyWriteQueue queue;
+  queue.Push(MakeBuffer('a', MEDIUM, stream1), true);
+  queue.Push(MakeBuffer('b', MEDIUM, stream1), true);
+  queue.Push(MakeBuffer('x', MEDIUM, stream3), true);
+  queue.Push(MakeBuffer('r', MEDIUM, stream1), false);
+
+  queue.RemovePendingDataForStream(stream1);
+  EXPECT_EQ(2u, queue.size());
+  EXPECT_EQ('r', PopTag(&queue));
+  EXPECT_EQ('x', PopTag(&queue));
+  EXPECT_TRUE(queue.empty());
+}
+
+}  // namespace
+
+}  // namespace net
@@ -0,0 +1,692 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This command-line program replays a synthetic workload against one of the
+// cache backends, with many operations in flight at the same time, and prints
+// the throughput and latency distribution of the run as a single line of JSON,
+// so that the numbers of different builds or backends can be compared.
+//
+// A typical run looks like:
+//
+//   cache_benchmark --backend=disk --workload=zipf --operations=100000
+//
+// See Help() for the full list of options.
+
+#include <math.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/command_line.h"
+#include "base/compiler_specific.h"
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/message_loop.h"
+#include "base/rand_util.h"
+#include "base/string_number_conversions.h"
+#include "base/stringprintf.h"
+#include "base/task.h"
+#include "base/threading/thread.h"
+#include "base/time.h"
+#include "net/base/completion_callback.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/disk_cache/backend_impl.h"
+#include "net/disk_cache/disk_cache.h"
+#include "net/disk_cache/disk_cache_test_util.h"
+#include "net/disk_cache/mem_backend_impl.h"
+#include "net/disk_cache/sharded_backend.h"
+
+using base::TimeDelta;
+using base::TimeTicks;
+
+namespace {
+
+const char kBackend[] = "backend";
+const char kBackendFlags[] = "backend-flags";
+const char kCachePath[] = "cache-path";
+const char kCacheSize[] = "cache-size";
+const char kDoomPercent[] = "doom-percent";
+const char kInFlight[] = "in-flight";
+const char kKeys[] = "keys";
+const char kMaxEntrySize[] = "max-entry-size";
+const char kNoPopulate[] = "no-populate";
+const char kOperations[] = "operations";
+const char kShards[] = "shards";
+const char kWorkload[] = "workload";
+const char kWritePercent[] = "write-percent";
+const char kZipfSkew[] = "zipf-skew";
+
+enum Errors {
+  ALL_GOOD = 0,
+  INVALID_ARGUMENT = 1,
+  INIT_FAILED
+};
+
+// Sparse operations work with pieces of this size, on a 4 MB range.
+const int kSparseChunk = 64 * 1024;
+const int kSparseChunks = 64;
+
+// The doom workload dooms every entry it touches for the first
+// kDoomStormLength operations of every kDoomStormPeriod.
+const int kDoomStormPeriod = 1000;
+const int kDoomStormLength = 100;
+
+enum OperationType {
+  OP_READ,
+  OP_WRITE,
+  OP_SPARSE_READ,
+  OP_SPARSE_WRITE,
+  OP_DOOM,
+  OP_MAX
+};
+
+const char* const kOperationNames[OP_MAX] = {
+  "read",
+  "write",
+  "sparse_read",
+  "sparse_write",
+  "doom",
+};
+
+struct Options {
+  std::string backend;
+  std::string workload;
+  FilePath path;
+  uint32 backend_flags;
+  int cache_size;
+  int shards;
+  int num_keys;
+  int num_operations;
+  int in_flight;
+  int max_entry_size;
+  int write_percent;
+  int doom_percent;
+  double zipf_skew;
+  bool populate;
+};
+
+int Help() {
+  printf("cache_benchmark [options]\n");
+  printf("--backend=disk|memory|sharded (disk)\n");
+  printf("--backend-flags=n: disk_cache::BackendFlags for the backend (0)\n");
+  printf("--cache-path=path: folder for the cache files\n");
+  printf("--cache-size=bytes: maximum size of the cache (80 MB)\n");
+  printf("--shards=n: number of shards for the sharded backend (4)\n");
+  printf("--workload=zipf|mixed|sparse|doom (zipf)\n");
+  printf("--keys=n: number of different keys (10000)\n");
+  printf("--operations=n: number of operations to time (50000)\n");
+  printf("--in-flight=n: maximum number of concurrent operations (32)\n");
+  printf("--max-entry-size=bytes: maximum size of the entries (32 KB)\n");
+  printf("--write-percent=n: percentage of writes\n");
+  printf("--doom-percent=n: percentage of dooms\n");
+  printf("--zipf-skew=s: skew of the key popularity (0.99)\n");
+  printf("--no-populate: don't create all the keys before timing\n");
+  return INVALID_ARGUMENT;
+}
+
+bool GetIntSwitch(const CommandLine& command_line, const char* name,
+                  int* value) {
+  if (!command_line.HasSwitch(name))
+    return true;
+  return base::StringToInt(command_line.GetSwitchValueASCII(name), value) &&
+         *value >= 0;
+}
+
+bool ParseOptions(const CommandLine& command_line, Options* options) {
+  options->backend = "disk";
+  options->workload = "zipf";
+  options->path = GetCacheFilePath().InsertBeforeExtensionASCII("_benchmark");
+  options->backend_flags = 0;
+  options->cache_size = 80 * 1024 * 1024;
+  options->shards = 4;
+  options->num_keys = 10000;
+  options->num_operations = 50000;
+  options->in_flight = 32;
+  options->max_entry_size = 32 * 1024;
+  options->zipf_skew = 0.99;
+  options->populate = !command_line.HasSwitch(kNoPopulate);
+
+  if (command_line.HasSwitch(kBackend))
+    options->backend = command_line.GetSwitchValueASCII(kBackend);
+  if (command_line.HasSwitch(kWorkload))
+    options->workload = command_line.GetSwitchValueASCII(kWorkload);
+  if (command_line.HasSwitch(kCachePath))
+    options->path = command_line.GetSwitchValuePath(kCachePath);
+
+  if (options->workload == "zipf") {
+    options->write_percent = 10;
+    options->doom_percent = 0;
+  } else if (options->workload == "mixed") {
+    options->write_percent = 50;
+    options->doom_percent = 0;
+  } else if (options->workload == "sparse") {
+    options->write_percent = 50;
+    options->doom_percent = 0;
+  } else if (options->workload == "doom") {
+    options->write_percent = 20;
+    options->doom_percent = 10;
+  } else {
+    return false;
+  }
+
+  int flags = 0;
+  if (!GetIntSwitch(command_line, kBackendFlags, &flags) ||
+      !GetIntSwitch(command_line, kCacheSize, &options->cache_size) ||
+      !GetIntSwitch(command_line, kShards, &options->shards) ||
+      !GetIntSwitch(command_line, kKeys, &options->num_keys) ||
+      !GetIntSwitch(command_line, kOperations, &options->num_operations) ||
+      !GetIntSwitch(command_line, kInFlight, &options->in_flight) ||
+      !GetIntSwitch(command_line, kMaxEntrySize, &options->max_entry_size) ||
+      !GetIntSwitch(command_line, kWritePercent, &options->write_percent) ||
+      !GetIntSwitch(command_line, kDoomPercent, &options->doom_percent)) {
+    return false;
+  }
+  options->backend_flags = flags;
+
+  if (command_line.HasSwitch(kZipfSkew) &&
+      (!base::StringToDouble(command_line.GetSwitchValueASCII(kZipfSkew),
+                             &options->zipf_skew) ||
+       options->zipf_skew < 0)) {
+    return false;
+  }
+
+  return options->num_keys > 0 && options->in_flight > 0 &&
+         options->max_entry_size > 0 &&
+         options->write_percent + options->doom_percent <= 100;
+}
+
+// Returns keys following a Zipf distribution: the key with rank k is picked
+// with a probability proportional to 1 / k^skew.
+class KeyGenerator {
+ public:
+  KeyGenerator(int num_keys, double skew) : cdf_(num_keys) {
+    double sum = 0;
+    for (int i = 0; i < num_keys; i++) {
+      sum += 1.0 / pow(static_cast<double>(i + 1), skew);
+      cdf_[i] = sum;
+    }
+    for (int i = 0; i < num_keys; i++)
+      cdf_[i] /= sum;
+  }
+
+  int GetKey() const {
+    double value = base::RandDouble();
+    std::vector<double>::const_iterator it =
+        std::lower_bound(cdf_.begin(), cdf_.end(), value);
+    if (it == cdf_.end())
+      return static_cast<int>(cdf_.size()) - 1;
+    return static_cast<int>(it - cdf_.begin());
+  }
+
+  static std::string KeyName(int key) {
+    return base::StringPrintf("http://www.google.com/benchmark/%d", key);
+  }
+
+ private:
+  std::vector<double> cdf_;
+
+  DISALLOW_COPY_AND_ASSIGN(KeyGenerator);
+};
+
+struct Operation {
+  OperationType type;
+  int key;
+};
+
+class Worker;
+
+// Controls a run of the benchmark: hands out operations to the workers, and
+// collects the results.
+class Benchmark {
+ public:
+  Benchmark(const Options& options, disk_cache::Backend* cache);
+  ~Benchmark();
+
+  // Creates every key on the cache (this part is not timed).
+  void Populate();
+
+  // Runs the timed part of the benchmark.
+  void Run();
+
+  // Returns false if there are no more operations to perform.
+  bool GetNextOperation(Operation* operation);
+
+  // Records the completion of |operation|.
+  void OnOperationDone(const Operation& operation, bool hit,
+                       TimeDelta latency);
+
+  // Notification from a worker that has nothing else to do.
+  void OnWorkerIdle();
+
+  // Prints the results of the last run.
+  void PrintResults() const;
+
+  disk_cache::Backend* cache() { return cache_; }
+  const Options& options() const { return options_; }
+  net::IOBuffer* write_buffer() { return write_buffer_; }
+
+ private:
+  // Starts the workers and runs the message loop until they are done.
+  void RunWorkers(int num_operations);
+  void StartWorkers();
+
+  const Options& options_;
+  disk_cache::Backend* cache_;
+  KeyGenerator keys_;
+  scoped_refptr<net::IOBuffer> write_buffer_;
+  std::vector<Worker*> workers_;
+  bool populating_;
+  int next_operation_;
+  int num_operations_;
+  int idle_workers_;
+  int hits_;
+  int misses_;
+  TimeDelta elapsed_;
+  std::vector<int64> latencies_[OP_MAX];  // In microseconds.
+};
+
+// Performs one operation at a time, one step after another.
+class Worker {
+ public:
+  explicit Worker(Benchmark* benchmark)
+      : benchmark_(benchmark), entry_(NULL), hit_(false),
+        state_(STATE_NONE),
+        read_buffer_(new net::IOBuffer(
+            std::max(benchmark->options().max_entry_size, kSparseChunk))),
+        ALLOW_THIS_IN_INITIALIZER_LIST(
+            callback_(this, &Worker::OnIOComplete)) {
+  }
+
+  // Performs operations until the benchmark runs out of them.
+  void Start() {
+    state_ = STATE_NEXT_OPERATION;
+    DoLoop(net::OK);
+  }
+
+ private:
+  enum State {
+    STATE_NONE,
+    STATE_NEXT_OPERATION,
+    STATE_OPEN,
+    STATE_OPEN_COMPLETE,
+    STATE_CREATE,
+    STATE_CREATE_COMPLETE,
+    STATE_IO,
+    STATE_IO_COMPLETE,
+    STATE_DOOM,
+    STATE_DOOM_COMPLETE
+  };
+
+  void OnIOComplete(int result) {
+    DoLoop(result);
+  }
+
+  void DoLoop(int result) {
+    int rv = result;
+    do {
+      State state = state_;
+      state_ = STATE_NONE;
+      switch (state) {
+        case STATE_NEXT_OPERATION:
+          rv = DoNextOperation();
+          break;
+        case STATE_OPEN:
+          rv = DoOpen();
+          break;
+        case STATE_OPEN_COMPLETE:
+          rv = DoOpenComplete(rv);
+          break;
+        case STATE_CREATE:
+          rv = DoCreate();
+          break;
+        case STATE_CREATE_COMPLETE:
+          rv = DoCreateComplete(rv);
+          break;
+        case STATE_IO:
+          rv = DoIO();
+          break;
+        case STATE_IO_COMPLETE:
+          rv = DoIOComplete(rv);
+          break;
+        case STATE_DOOM:
+          rv = DoDoom();
+          break;
+        case STATE_DOOM_COMPLETE:
+          rv = DoDoomComplete(rv);
+          break;
+        default:
+          NOTREACHED();
+          rv = net::ERR_FAILED;
+          break;
+      }
+    } while (rv != net::ERR_IO_PENDING && state_ != STATE_NONE);
+
+    if (state_ == STATE_NONE && rv != net::ERR_IO_PENDING)
+      benchmark_->OnWorkerIdle();
+  }
+
+  int DoNextOperation() {
+    if (!benchmark_->GetNextOperation(&operation_))
+      return net::OK;
+
+    start_ = TimeTicks::HighResNow();
+    hit_ = false;
+    key_ = KeyGenerator::KeyName(operation_.key);
+    state_ = operation_.type == OP_DOOM ? STATE_DOOM : STATE_OPEN;
+    return net::OK;
+  }
+
+  int DoOpen() {
+    state_ = STATE_OPEN_COMPLETE;
+    return benchmark_->cache()->OpenEntry(key_, &entry_, &callback_);
+  }
+
+  int DoOpenComplete(int result) {
+    if (result == net::OK) {
+      hit_ = true;
+      state_ = STATE_IO;
+      return net::OK;
+    }
+    state_ = STATE_CREATE;
+    return net::OK;
+  }
+
+  int DoCreate() {
+    state_ = STATE_CREATE_COMPLETE;
+    return benchmark_->cache()->CreateEntry(key_, &entry_, &callback_);
+  }
+
+  int DoCreateComplete(int result) {
+    if (result != net::OK) {
+      // Somebody else created the entry (or the cache rejected it).
+      return Done();
+    }
+    // There is nothing to read from a new entry.
+    if (operation_.type == OP_READ)
+      operation_.type = OP_WRITE;
+    else if (operation_.type == OP_SPARSE_READ)
+      operation_.type = OP_SPARSE_WRITE;
+    state_ = STATE_IO;
+    return net::OK;
+  }
+
+  int DoIO() {
+    state_ = STATE_IO_COMPLETE;
+    int64 sparse_offset =
+        static_cast<int64>(base::RandInt(0, kSparseChunks - 1)) * kSparseChunk;
+    switch (operation_.type) {
+      case OP_READ:
+        return entry_->ReadData(1, 0, read_buffer_,
+                                benchmark_->options().max_entry_size,
+                                &callback_);
+      case OP_WRITE: {
+        int size = base::RandInt(1, benchmark_->options().max_entry_size);
+        return entry_->WriteData(1, 0, benchmark_->write_buffer(), size,
+                                 &callback_, true);
+      }
+      case OP_SPARSE_READ:
+        return entry_->ReadSparseData(sparse_offset, read_buffer_,
+                                      kSparseChunk, &callback_);
+      case OP_SPARSE_WRITE:
+        return entry_->WriteSparseData(sparse_offset,
+                                       benchmark_->write_buffer(),
+                                       kSparseChunk, &callback_);
+      default:
+        NOTREACHED();
+        return net::ERR_FAILED;
+    }
+  }
+
+  int DoIOComplete(int result) {
+    entry_->Close();
+    entry_ = NULL;
+    return Done();
+  }
+
+  int DoDoom() {
+    state_ = STATE_DOOM_COMPLETE;
+    return benchmark_->cache()->DoomEntry(key_, &callback_);
+  }
+
+  int DoDoomComplete(int result) {
+    hit_ = (result == net::OK);
+    return Done();
+  }
+
+  int Done() {
+    benchmark_->OnOperationDone(operation_, hit_,
+                                TimeTicks::HighResNow() - start_);
+    state_ = STATE_NEXT_OPERATION;
+    return net::OK;
+  }
+
+  Benchmark* benchmark_;
+  Operation operation_;
+  std::string key_;
+  disk_cache::Entry* entry_;
+  bool hit_;
+  TimeTicks start_;
+  State state_;
+  scoped_refptr<net::IOBuffer> read_buffer_;
+  net::CompletionCallbackImpl<Worker> callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(Worker);
+};
+
+Benchmark::Benchmark(const Options& options, disk_cache::Backend* cache)
+    : options_(options),
+      cache_(cache),
+      keys_(options.num_keys, options.zipf_skew),
+      write_buffer_(new net::IOBuffer(std::max(options.max_entry_size,
+                                               kSparseChunk))),
+      populating_(false),
+      next_operation_(0),
+      num_operations_(0),
+      idle_workers_(0),
+      hits_(0),
+      misses_(0) {
+  CacheTestFillBuffer(write_buffer_->data(),
+                      std::max(options.max_entry_size, kSparseChunk), false);
+  for (int i = 0; i < options.in_flight; i++)
+    workers_.push_back(new Worker(this));
+}
+
+Benchmark::~Benchmark() {
+  for (size_t i = 0; i < workers_.size(); i++)
+    delete workers_[i];
+}
+
+void Benchmark::Populate() {
+  populating_ = true;
+  RunWorkers(options_.num_keys);
+  populating_ = false;
+}
+
+void Benchmark::Run() {
+  hits_ = misses_ = 0;
+  for (int i = 0; i < OP_MAX; i++)
+    latencies_[i].clear();
+
+  TimeTicks start = TimeTicks::HighResNow();
+  RunWorkers(options_.num_operations);
+  elapsed_ = TimeTicks::HighResNow() - start;
+}
+
+bool Benchmark::GetNextOperation(Operation* operation) {
+  if (next_operation_ >= num_operations_)
+    return false;
+
+  int index = next_operation_++;
+  if (populating_) {
+    operation->key = index;
+    operation->type = options_.workload == "sparse" ? OP_SPARSE_WRITE :
+                                                      OP_WRITE;
+    return true;
+  }
+
+  operation->key = keys_.GetKey();
+  if (options_.workload == "doom" &&
+      index % kDoomStormPeriod < kDoomStormLength) {
+    operation->type = OP_DOOM;
+    return true;
+  }
+
+  int value = base::RandInt(0, 99);
+  bool sparse = options_.workload == "sparse";
+  if (value < options_.doom_percent)
+    operation->type = OP_DOOM;
+  else if (value < options_.doom_percent + options_.write_percent)
+    operation->type = sparse ? OP_SPARSE_WRITE : OP_WRITE;
+  else
+    operation->type = sparse ? OP_SPARSE_READ : OP_READ;
+  return true;
+}
+
+void Benchmark::OnOperationDone(const Operation& operation, bool hit,
+                                TimeDelta latency) {
+  if (populating_)
+    return;
+
+  if (hit)
+    hits_++;
+  else
+    misses_++;
+  latencies_[operation.type].push_back(latency.InMicroseconds());
+}
+
+void Benchmark::OnWorkerIdle() {
+  idle_workers_++;
+  if (idle_workers_ == static_cast<int>(workers_.size()))
+    MessageLoop::current()->Quit();
+}
+
+void Benchmark::RunWorkers(int num_operations) {
+  next_operation_ = 0;
+  num_operations_ = num_operations;
+  idle_workers_ = 0;
+
+  // The workers may finish without going back to the message loop (with the
+  // memory only cache), so they are started from a task.
+  MessageLoop::current()->PostTask(
+      FROM_HERE, NewRunnableMethod(this, &Benchmark::StartWorkers));
+  MessageLoop::current()->Run();
+}
+
+void Benchmark::StartWorkers() {
+  for (size_t i = 0; i < workers_.size(); i++)
+    workers_[i]->Start();
+}
+
+// Returns the latency percentiles of |values| as a JSON object.
+std::string LatencyStats(std::vector<int64> values) {
+  if (values.empty())
+    return "{\"count\": 0}";
+
+  std::sort(values.begin(), values.end());
+  size_t count = values.size();
+  return base::StringPrintf(
+      "{\"count\": %u, \"p50\": %lld, \"p99\": %lld, \"p999\": %lld, "
+      "\"max\": %lld}",
+      static_cast<unsigned>(count),
+      static_cast<long long>(values[count * 50 / 100]),
+      static_cast<long long>(values[count * 99 / 100]),
+      static_cast<long long>(values[count * 999 / 1000]),
+      static_cast<long long>(values[count - 1]));
+}
+
+void Benchmark::PrintResults() const {
+  std::vector<int64> all;
+  for (int i = 0; i < OP_MAX; i++)
+    all.insert(all.end(), latencies_[i].begin(), latencies_[i].end());
+
+  double seconds = elapsed_.InMillisecondsF() / 1000;
+  double throughput = seconds > 0 ? all.size() / seconds : 0;
+
+  std::string result = base::StringPrintf(
+      "{\"backend\": \"%s\", \"workload\": \"%s\", \"keys\": %d, "
+      "\"in_flight\": %d, \"operations\": %u, \"seconds\": %.3f, "
+      "\"ops_per_sec\": %.1f, \"hits\": %d, \"misses\": %d, "
+      "\"entries\": %d, \"latency_us\": {\"all\": %s",
+      options_.backend.c_str(), options_.workload.c_str(), options_.num_keys,
+      options_.in_flight, static_cast<unsigned>(all.size()), seconds,
+      throughput, hits_, misses_, cache_->GetEntryCount(),
+      LatencyStats(all).c_str());
+
+  for (int i = 0; i < OP_MAX; i++) {
+    if (latencies_[i].empty())
+      continue;
+    base::StringAppendF(&result, ", \"%s\": %s", kOperationNames[i],
+                        LatencyStats(latencies_[i]).c_str());
+  }
+  result.append("}}");
+  printf("%s\n", result.c_str());
+}
+
+}  // namespace
+
+// The benchmark outlives all the tasks posted to it.
+DISABLE_RUNNABLE_METHOD_REFCOUNT(Benchmark);
+
+int main(int argc, const char* argv[]) {
+  // Setup an AtExitManager so Singleton objects will be destroyed.
+  base::AtExitManager at_exit_manager;
+  MessageLoop message_loop(MessageLoop::TYPE_IO);
+
+  CommandLine::Init(argc, argv);
+  const CommandLine& command_line = *CommandLine::ForCurrentProcess();
+
+  Options options;
+  if (!ParseOptions(command_line, &options))
+    return Help();
+
+  base::Thread cache_thread("CacheThread");
+  if (!cache_thread.StartWithOptions(
+          base::Thread::Options(MessageLoop::TYPE_IO, 0))) {
+    return INIT_FAILED;
+  }
+
+  file_util::Delete(options.path, true);
+
+  uint32 flags = options.backend_flags | disk_cache::kNoRandom;
+  TestCompletionCallback cb;
+  disk_cache::Backend* cache = NULL;
+  int rv = net::ERR_FAILED;
+  if (options.backend == "disk") {
+    rv = disk_cache::BackendImpl::CreateBackend(
+             options.path, true, options.cache_size, net::DISK_CACHE, flags,
+             cache_thread.message_loop_proxy(), NULL, &cache, &cb);
+  } else if (options.backend == "sharded") {
+    rv = disk_cache::ShardedBackend::CreateBackend(
+             options.path, true, options.cache_size, net::DISK_CACHE, flags,
+             options.shards, NULL, &cache, &cb);
+  } else if (options.backend == "memory") {
+    cache = disk_cache::MemBackendImpl::CreateBackend(options.cache_size,
+                                                      NULL);
+    rv = cache ? net::OK : net::ERR_FAILED;
+  } else {
+    return Help();
+  }
+
+  if (cb.GetResult(rv) != net::OK || !cache) {
+    printf("Unable to initialize the cache.\n");
+    return INIT_FAILED;
+  }
+
+  {
+    Benchmark benchmark(options, cache);
+    if (options.populate)
+      benchmark.Populate();
+    benchmark.Run();
+    benchmark.PrintResults();
+  }
+
+  delete cache;
+  file_util::Delete(options.path, true);
+  return ALL_GOOD;
+}
@@ -0,0 +1,327 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/tools/dump_cache/cache_analyzer.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/format_macros.h"
+#include "base/logging.h"
+#include "base/memory/scoped_vector.h"
+#include "base/stl_util-inl.h"
+#include "base/stringprintf.h"
+#include "base/threading/simple_thread.h"
+#include "net/disk_cache/addr.h"
+#include "net/disk_cache/disk_format.h"
+
+namespace {
+
+const char kIndexName[] = "index";
+const char kBlockFilePrefix[] = "data_";
+const char kShardPrefix[] = "shard_";
+
+// The number of buckets of the index table walked by each task.
+const int kBucketsPerTask = 4096;
+
+// The index and block files of a cache folder, mapped read-only.
+class CacheFiles {
+ public:
+  explicit CacheFiles(const FilePath& path) : path_(path) {}
+  ~CacheFiles() {
+    STLDeleteElements(&block_files_);
+  }
+
+  // Maps the files.  Returns false if the index is missing or invalid.
+  bool Init();
+
+  const disk_cache::Index* index() const {
+    return reinterpret_cast<const disk_cache::Index*>(index_file_.data());
+  }
+  int table_len() const { return table_len_; }
+
+  // Returns the first |size| bytes of the block at |address|, or NULL if the
+  // address is invalid or outside of the files.
+  const void* GetBlock(disk_cache::CacheAddr address, size_t size) const;
+
+  const FilePath& path() const { return path_; }
+
+ private:
+  FilePath path_;
+  file_util::MemoryMappedFile index_file_;
+  int table_len_;
+  // Indexed by file number; NULL for the files that don't exist.
+  std::vector<file_util::MemoryMappedFile*> block_files_;
+
+  DISALLOW_COPY_AND_ASSIGN(CacheFiles);
+};
+
+bool CacheFiles::Init() {
+  if (!index_file_.Initialize(path_.AppendASCII(kIndexName)) ||
+      index_file_.length() < sizeof(disk_cache::IndexHeader)) {
+    printf("Unable to map the index of %s\n", path_.MaybeAsASCII().c_str());
+    return false;
+  }
+  const disk_cache::IndexHeader& header = index()->header;
+  if (header.magic != disk_cache::kIndexMagic ||
+      header.version >> 16 != disk_cache::kCurrentVersion >> 16) {
+    printf("Unknown index format in %s\n", path_.MaybeAsASCII().c_str());
+    return false;
+  }
+  table_len_ = header.table_len ? header.table_len :
+                                  disk_cache::kIndexTablesize;
+  if (table_len_ < 0 ||
+      index_file_.length() < sizeof(disk_cache::IndexHeader) +
+                             table_len_ * sizeof(disk_cache::CacheAddr)) {
+    printf("Truncated index in %s\n", path_.MaybeAsASCII().c_str());
+    return false;
+  }
+
+  // Additional block files are chained after the first four, so some of
+  // them may be missing.
+  block_files_.resize(disk_cache::kMaxBlockFile + 1);
+  for (int i = 0; i <= disk_cache::kMaxBlockFile; i++) {
+    FilePath name = path_.AppendASCII(
+        base::StringPrintf("%s%d", kBlockFilePrefix, i));
+    scoped_ptr<file_util::MemoryMappedFile> file(
+        new file_util::MemoryMappedFile);
+    if (file_util::PathExists(name) && file->Initialize(name))
+      block_files_[i] = file.release();
+  }
+  return true;
+}
+
+const void* CacheFiles::GetBlock(disk_cache::CacheAddr address,
+                                 size_t size) const {
+  disk_cache::Addr addr(address);
+  if (!addr.is_initialized() || !addr.is_block_file() || !addr.SanityCheck())
+    return NULL;
+  const file_util::MemoryMappedFile* file = block_files_[addr.FileNumber()];
+  if (!file)
+    return NULL;
+  size_t offset = disk_cache::kBlockHeaderSize +
+                  static_cast<size_t>(addr.start_block()) * addr.BlockSize();
+  if (size > static_cast<size_t>(addr.BlockSize() * addr.num_blocks()) ||
+      offset + size > file->length()) {
+    return NULL;
+  }
+  return file->data() + offset;
+}
+
+int GetSizeBucket(int64 size) {
+  int bucket = 0;
+  for (int64 limit = 1024;
+       size >= limit && bucket < CacheStats::kNumSizeBuckets - 1;
+       limit *= 4) {
+    bucket++;
+  }
+  return bucket;
+}
+
+int GetAgeBucket(base::TimeDelta age) {
+  const base::TimeDelta kLimits[CacheStats::kNumAgeBuckets - 1] = {
+    base::TimeDelta::FromHours(1),
+    base::TimeDelta::FromDays(1),
+    base::TimeDelta::FromDays(7),
+    base::TimeDelta::FromDays(28),
+  };
+  int bucket = 0;
+  while (bucket < CacheStats::kNumAgeBuckets - 1 && age >= kLimits[bucket])
+    bucket++;
+  return bucket;
+}
+
+int GetReuseBucket(int reuse_count) {
+  int bucket = 0;
+  for (int limit = 1;
+       reuse_count >= limit && bucket < CacheStats::kNumReuseBuckets - 1;
+       limit *= 2) {
+    bucket++;
+  }
+  return bucket;
+}
+
+// Walks the entries of the buckets [begin, end) of the index table of a
+// cache folder.
+class ScanTask : public base::DelegateSimpleThread::Delegate {
+ public:
+  ScanTask(const CacheFiles* files, int begin, int end, base::Time now)
+      : files_(files), begin_(begin), end_(end), now_(now) {
+  }
+
+  virtual void Run();
+
+  const CacheStats& stats() const { return stats_; }
+
+ private:
+  void AddEntry(const disk_cache::EntryStore& entry);
+
+  const CacheFiles* files_;
+  const int begin_;
+  const int end_;
+  const base::Time now_;
+  CacheStats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanTask);
+};
+
+void ScanTask::Run() {
+  const disk_cache::Index* index = files_->index();
+  // A longer chain has to loop.
+  const int64 max_chain_length =
+      std::max(index->header.num_entries, 0) + 1;
+
+  for (int i = begin_; i < end_; i++) {
+    disk_cache::CacheAddr address = index->table[i];
+    for (int64 length = 0; address; length++) {
+      if (length == max_chain_length) {
+        stats_.num_errors++;
+        break;
+      }
+      const disk_cache::EntryStore* entry =
+          static_cast<const disk_cache::EntryStore*>(
+              files_->GetBlock(address, sizeof(disk_cache::EntryStore)));
+      if (!entry) {
+        stats_.num_errors++;
+        break;
+      }
+      AddEntry(*entry);
+      address = entry->next;
+    }
+  }
+}
+
+void ScanTask::AddEntry(const disk_cache::EntryStore& entry) {
+  if (entry.flags & disk_cache::CHILD_ENTRY) {
+    stats_.num_sparse_children++;
+  } else {
+    stats_.num_entries++;
+  }
+
+  int64 size = 0;
+  for (int i = 0; i < 4; i++)
+    size += std::max(entry.data_size[i], 0);
+  stats_.total_bytes += size;
+  stats_.size_histogram[GetSizeBucket(size)]++;
+  stats_.reuse_histogram[GetReuseBucket(entry.reuse_count)]++;
+
+  const disk_cache::RankingsNode* rankings =
+      static_cast<const disk_cache::RankingsNode*>(files_->GetBlock(
+          entry.rankings_node, sizeof(disk_cache::RankingsNode)));
+  if (!rankings) {
+    stats_.num_errors++;
+    return;
+  }
+  base::Time last_used = base::Time::FromInternalValue(rankings->last_used);
+  stats_.age_histogram[GetAgeBucket(now_ - last_used)]++;
+}
+
+void PrintHistogram(const char* title, const char* const* labels,
+                    const std::vector<int64>& histogram, int64 total) {
+  printf("%s:\n", title);
+  for (size_t i = 0; i < histogram.size(); i++) {
+    double percent = total ? 100.0 * histogram[i] / total : 0.0;
+    printf("  %-12s %10" PRId64 " (%5.1f%%)\n", labels[i], histogram[i],
+           percent);
+  }
+}
+
+}  // namespace
+
+CacheStats::CacheStats()
+    : num_entries(0),
+      num_sparse_children(0),
+      total_bytes(0),
+      num_errors(0),
+      size_histogram(kNumSizeBuckets),
+      age_histogram(kNumAgeBuckets),
+      reuse_histogram(kNumReuseBuckets) {
+}
+
+CacheStats::~CacheStats() {}
+
+void CacheStats::Add(const CacheStats& other) {
+  num_entries += other.num_entries;
+  num_sparse_children += other.num_sparse_children;
+  total_bytes += other.total_bytes;
+  num_errors += other.num_errors;
+  for (int i = 0; i < kNumSizeBuckets; i++)
+    size_histogram[i] += other.size_histogram[i];
+  for (int i = 0; i < kNumAgeBuckets; i++)
+    age_histogram[i] += other.age_histogram[i];
+  for (int i = 0; i < kNumReuseBuckets; i++)
+    reuse_histogram[i] += other.reuse_histogram[i];
+}
+
+bool AnalyzeCache(const FilePath& path, int num_threads, base::Time now,
+                  CacheStats* stats) {
+  DCHECK_GT(num_threads, 0);
+
+  // A sharded cache keeps a regular cache in each shard_N folder.
+  std::vector<FilePath> folders;
+  for (int i = 0; ; i++) {
+    FilePath shard = path.AppendASCII(
+        base::StringPrintf("%s%d", kShardPrefix, i));
+    if (!file_util::DirectoryExists(shard))
+      break;
+    folders.push_back(shard);
+  }
+  if (folders.empty())
+    folders.push_back(path);
+
+  ScopedVector<CacheFiles> caches;
+  for (size_t i = 0; i < folders.size(); i++) {
+    CacheFiles* files = new CacheFiles(folders[i]);
+    caches.push_back(files);
+    if (!files->Init())
+      return false;
+  }
+
+  // The pages of the files are read by the threads as they touch them.
+  ScopedVector<ScanTask> tasks;
+  base::DelegateSimpleThreadPool pool("dump_cache", num_threads);
+  for (size_t i = 0; i < caches.size(); i++) {
+    for (int begin = 0; begin < caches[i]->table_len();
+         begin += kBucketsPerTask) {
+      int end = std::min(begin + kBucketsPerTask, caches[i]->table_len());
+      ScanTask* task = new ScanTask(caches[i], begin, end, now);
+      tasks.push_back(task);
+      pool.AddWork(task);
+    }
+  }
+  pool.Start();
+  pool.JoinAll();
+
+  *stats = CacheStats();
+  for (size_t i = 0; i < tasks.size(); i++)
+    stats->Add(tasks[i]->stats());
+  return true;
+}
+
+void PrintCacheStats(const CacheStats& stats) {
+  static const char* const kSizeLabels[CacheStats::kNumSizeBuckets] = {
+    "< 1 KB", "< 4 KB", "< 16 KB", "< 64 KB", "< 256 KB", "< 1 MB", "< 4 MB",
+    ">= 4 MB",
+  };
+  static const char* const kAgeLabels[CacheStats::kNumAgeBuckets] = {
+    "< 1 hour", "< 1 day", "< 1 week", "< 4 weeks", ">= 4 weeks",
+  };
+  static const char* const kReuseLabels[CacheStats::kNumReuseBuckets] = {
+    "0", "1", "2-3", "4-7", "8-15", ">= 16",
+  };
+
+  int64 total = stats.num_entries + stats.num_sparse_children;
+  printf("entries: %" PRId64 "\n", stats.num_entries);
+  printf("sparse children: %" PRId64 "\n", stats.num_sparse_children);
+  printf("total bytes: %" PRId64 "\n", stats.total_bytes);
+  printf("average size: %" PRId64 "\n", total ? stats.total_bytes / total : 0);
+  printf("errors: %" PRId64 "\n", stats.num_errors);
+  PrintHistogram("size", kSizeLabels, stats.size_histogram, total);
+  PrintHistogram("time since last use", kAgeLabels, stats.age_histogram,
+                 total);
+  PrintHistogram("reuse count", kReuseLabels, stats.reuse_histogram, total);
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_TOOLS_DUMP_CACHE_CACHE_ANALYZER_H_
+#define NET_TOOLS_DUMP_CACHE_CACHE_ANALYZER_H_
+#pragma once
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/time.h"
+
+class FilePath;
+
+// Statistics about the entries of a cache.
+struct CacheStats {
+  // Entries by total data size: less than 1 KB, 4 KB ... 4 MB, and more.
+  static const int kNumSizeBuckets = 8;
+  // Entries by time since last use: less than an hour, a day, a week, four
+  // weeks, and more.
+  static const int kNumAgeBuckets = 5;
+  // Entries by reuse count: 0, 1, 2-3, 4-7, 8-15, and more.
+  static const int kNumReuseBuckets = 6;
+
+  CacheStats();
+  ~CacheStats();
+
+  void Add(const CacheStats& other);
+
+  int64 num_entries;
+  int64 num_sparse_children;
+  int64 total_bytes;
+  // Entries that can't be read, or chains of entries that loop.
+  int64 num_errors;
+
+  std::vector<int64> size_histogram;
+  std::vector<int64> age_histogram;
+  std::vector<int64> reuse_histogram;
+};
+
+// Reads the index and block files of the cache at |path| with |num_threads|
+// threads, and fills |stats| with what the entries say.  The files are only
+// read, through read-only mappings; sharded caches (with shard_N folders) are
+// handled too.  Ages are measured up to |now|.  Returns false if the cache
+// can't be read at all.
+//
+// Rankings updates that are still in a journal are not seen, so ages may be
+// a little longer than they are.
+bool AnalyzeCache(const FilePath& path, int num_threads, base::Time now,
+                  CacheStats* stats);
+
+// Writes |stats| to stdout.
+void PrintCacheStats(const CacheStats& stats);
+
+#endif  // NET_TOOLS_DUMP_CACHE_CACHE_ANALYZER_H_
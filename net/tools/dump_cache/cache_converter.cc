@@ -0,0 +1,373 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/tools/dump_cache/cache_converter.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/format_macros.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/stl_util-inl.h"
+#include "base/stringprintf.h"
+#include "base/threading/thread.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/disk_cache/backend_impl.h"
+#include "net/disk_cache/entry_impl.h"
+#include "net/disk_cache/sharded_backend.h"
+
+namespace {
+
+const char kShardPrefix[] = "shard_";
+
+// The number of entries copied at a time.
+const int kMaxCopies = 16;
+
+// The size of the reads and writes of stream data.
+const int kBufferSize = 64 * 1024;
+
+// The streams of an entry that hold regular data.
+const int kNumStreams = 3;
+
+// Returns the number of shard_N folders of a sharded cache, or 0.
+int CountShards(const FilePath& path) {
+  int num_shards = 0;
+  while (file_util::DirectoryExists(path.AppendASCII(
+             base::StringPrintf("%s%d", kShardPrefix, num_shards)))) {
+    num_shards++;
+  }
+  return num_shards;
+}
+
+// Opens, or creates, the cache at |path|.  A regular cache runs on
+// |cache_thread|; the shards of a sharded one have threads of their own.
+bool OpenCache(const FilePath& path, int num_shards, base::Thread* cache_thread,
+               scoped_ptr<disk_cache::Backend>* cache) {
+  disk_cache::Backend* backend = NULL;
+  TestCompletionCallback cb;
+  int rv;
+  if (num_shards) {
+    rv = disk_cache::ShardedBackend::CreateBackend(
+        path, false, kint32max, net::DISK_CACHE, disk_cache::kUpgradeMode,
+        num_shards, NULL, &backend, &cb);
+  } else {
+    rv = disk_cache::BackendImpl::CreateBackend(
+        path, false, kint32max, net::DISK_CACHE, disk_cache::kUpgradeMode,
+        cache_thread->message_loop_proxy(), NULL, &backend, &cb);
+  }
+  if (cb.GetResult(rv) != net::OK)
+    return false;
+  cache->reset(backend);
+  return true;
+}
+
+class Converter;
+
+// Copies the data of one entry at a time.
+class EntryCopier {
+ public:
+  EntryCopier(Converter* converter, disk_cache::Backend* dest_cache)
+      : converter_(converter),
+        dest_cache_(dest_cache),
+        state_(STATE_NONE),
+        source_(NULL),
+        dest_(NULL),
+        stream_(0),
+        offset_(0),
+        bytes_(0),
+        success_(false),
+        buf_(new net::IOBuffer(kBufferSize)),
+        ALLOW_THIS_IN_INITIALIZER_LIST(
+            callback_(this, &EntryCopier::OnIOComplete)) {
+  }
+
+  // Copies |source|, and closes it.  Tells the converter when done.
+  void Start(disk_cache::Entry* source);
+
+ private:
+  enum State {
+    STATE_NONE,
+    STATE_CREATE_COMPLETE,
+    STATE_READ,
+    STATE_READ_COMPLETE,
+    STATE_WRITE_COMPLETE,
+  };
+
+  void OnIOComplete(int result);
+  void DoLoop(int result);
+  int DoCreateComplete(int result);
+  int DoRead();
+  int DoReadComplete(int result);
+  int DoWriteComplete(int result);
+  void Finish(bool success);
+
+  Converter* converter_;
+  disk_cache::Backend* dest_cache_;
+  State state_;
+  disk_cache::Entry* source_;
+  disk_cache::Entry* dest_;
+  int stream_;
+  int offset_;
+  int bytes_;
+  bool success_;
+  scoped_refptr<net::IOBuffer> buf_;
+  net::CompletionCallbackImpl<EntryCopier> callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(EntryCopier);
+};
+
+// Enumerates the entries of the source cache, and hands them to idle
+// EntryCopiers.
+class Converter {
+ public:
+  Converter(disk_cache::Backend* source, disk_cache::Backend* dest)
+      : source_(source),
+        iter_(NULL),
+        next_entry_(NULL),
+        opening_(false),
+        enumeration_done_(false),
+        num_active_(0),
+        num_copied_(0),
+        success_(true),
+        ALLOW_THIS_IN_INITIALIZER_LIST(
+            open_callback_(this, &Converter::OnOpenNextEntryComplete)) {
+    for (int i = 0; i < kMaxCopies; i++)
+      idle_copiers_.push_back(new EntryCopier(this, dest));
+  }
+
+  ~Converter() {
+    if (iter_)
+      source_->EndEnumeration(&iter_);
+    STLDeleteElements(&idle_copiers_);
+  }
+
+  // Runs the message loop until all the entries are copied.  Returns false
+  // if any of them failed.
+  bool Run() {
+    OpenNextEntry();
+    if (!enumeration_done_ || num_active_)
+      MessageLoop::current()->Run();
+    return success_;
+  }
+
+  // Called by |copier| when it is done with an entry.
+  void OnCopyDone(EntryCopier* copier, bool success) {
+    DCHECK_GT(num_active_, 0);
+    num_active_--;
+    idle_copiers_.push_back(copier);
+    if (success) {
+      if (++num_copied_ % 1000 == 0)
+        printf("%" PRId64 " entries copied\n", num_copied_);
+    } else {
+      success_ = false;
+    }
+    OpenNextEntry();
+    MaybeQuit();
+  }
+
+  int64 num_copied() const { return num_copied_; }
+
+ private:
+  void OpenNextEntry() {
+    if (opening_ || enumeration_done_ || idle_copiers_.empty())
+      return;
+    opening_ = true;
+    int rv = source_->OpenNextEntry(&iter_, &next_entry_, &open_callback_);
+    if (rv != net::ERR_IO_PENDING)
+      OnOpenNextEntryComplete(rv);
+  }
+
+  void OnOpenNextEntryComplete(int result) {
+    opening_ = false;
+    if (result != net::OK) {
+      // That was the last entry.
+      enumeration_done_ = true;
+      MaybeQuit();
+      return;
+    }
+    EntryCopier* copier = idle_copiers_.back();
+    idle_copiers_.pop_back();
+    num_active_++;
+    copier->Start(next_entry_);
+    next_entry_ = NULL;
+    OpenNextEntry();
+  }
+
+  void MaybeQuit() {
+    if (enumeration_done_ && !num_active_)
+      MessageLoop::current()->PostTask(FROM_HERE, new MessageLoop::QuitTask());
+  }
+
+  disk_cache::Backend* source_;
+  void* iter_;
+  disk_cache::Entry* next_entry_;
+  bool opening_;
+  bool enumeration_done_;
+  int num_active_;
+  int64 num_copied_;
+  bool success_;
+  std::vector<EntryCopier*> idle_copiers_;
+  net::CompletionCallbackImpl<Converter> open_callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(Converter);
+};
+
+void EntryCopier::Start(disk_cache::Entry* source) {
+  DCHECK_EQ(STATE_NONE, state_);
+  source_ = source;
+  stream_ = 0;
+  offset_ = 0;
+  state_ = STATE_CREATE_COMPLETE;
+  int rv = dest_cache_->CreateEntry(source_->GetKey(), &dest_, &callback_);
+  if (rv != net::ERR_IO_PENDING)
+    DoLoop(rv);
+}
+
+void EntryCopier::OnIOComplete(int result) {
+  DoLoop(result);
+}
+
+void EntryCopier::DoLoop(int result) {
+  int rv = result;
+  do {
+    switch (state_) {
+      case STATE_CREATE_COMPLETE:
+        rv = DoCreateComplete(rv);
+        break;
+      case STATE_READ:
+        DCHECK_EQ(net::OK, rv);
+        rv = DoRead();
+        break;
+      case STATE_READ_COMPLETE:
+        rv = DoReadComplete(rv);
+        break;
+      case STATE_WRITE_COMPLETE:
+        rv = DoWriteComplete(rv);
+        break;
+      default:
+        NOTREACHED() << "bad state";
+        break;
+    }
+  } while (rv != net::ERR_IO_PENDING && state_ != STATE_NONE);
+
+  // The converter may start another copy right away.
+  if (state_ == STATE_NONE)
+    converter_->OnCopyDone(this, success_);
+}
+
+int EntryCopier::DoCreateComplete(int result) {
+  if (result != net::OK) {
+    printf("Unable to create entry %s\n", source_->GetKey().c_str());
+    Finish(false);
+    return result;
+  }
+  state_ = STATE_READ;
+  return net::OK;
+}
+
+int EntryCopier::DoRead() {
+  while (stream_ < kNumStreams && offset_ >= source_->GetDataSize(stream_)) {
+    stream_++;
+    offset_ = 0;
+  }
+  if (stream_ == kNumStreams) {
+    Finish(true);
+    return net::OK;
+  }
+
+  bytes_ = std::min(kBufferSize, source_->GetDataSize(stream_) - offset_);
+  state_ = STATE_READ_COMPLETE;
+  return source_->ReadData(stream_, offset_, buf_, bytes_, &callback_);
+}
+
+int EntryCopier::DoReadComplete(int result) {
+  if (result <= 0) {
+    printf("Unable to read entry %s\n", source_->GetKey().c_str());
+    Finish(false);
+    return result;
+  }
+  bytes_ = result;
+  state_ = STATE_WRITE_COMPLETE;
+  return dest_->WriteData(stream_, offset_, buf_, bytes_, &callback_, false);
+}
+
+int EntryCopier::DoWriteComplete(int result) {
+  if (result != bytes_) {
+    printf("Unable to write entry %s\n", source_->GetKey().c_str());
+    Finish(false);
+    return result;
+  }
+  offset_ += result;
+  state_ = STATE_READ;
+  return net::OK;
+}
+
+void EntryCopier::Finish(bool success) {
+  if (success) {
+    // Both kinds of caches store EntryImpls, as CacheDumper expects too.
+    static_cast<disk_cache::EntryImpl*>(dest_)->SetTimes(
+        source_->GetLastUsed(), source_->GetLastModified());
+    dest_->Close();
+  } else if (dest_) {
+    // Don't leave a partial copy behind.
+    dest_->Doom();
+    dest_->Close();
+  }
+  source_->Close();
+  source_ = NULL;
+  dest_ = NULL;
+  success_ = success;
+  state_ = STATE_NONE;
+}
+
+}  // namespace
+
+bool ConvertCache(const FilePath& input_path, const FilePath& output_path,
+                  int num_shards) {
+  if (file_util::PathExists(output_path)) {
+    printf("The output folder must not exist\n");
+    return false;
+  }
+
+  base::Thread input_thread("InputCacheThread");
+  base::Thread output_thread("OutputCacheThread");
+  if (!input_thread.StartWithOptions(
+          base::Thread::Options(MessageLoop::TYPE_IO, 0)) ||
+      !output_thread.StartWithOptions(
+          base::Thread::Options(MessageLoop::TYPE_IO, 0))) {
+    printf("Unable to start the cache threads\n");
+    return false;
+  }
+
+  scoped_ptr<disk_cache::Backend> source;
+  if (!OpenCache(input_path, CountShards(input_path), &input_thread,
+                 &source)) {
+    printf("Unable to open the input cache\n");
+    return false;
+  }
+  scoped_ptr<disk_cache::Backend> dest;
+  if (!OpenCache(output_path, num_shards, &output_thread, &dest)) {
+    printf("Unable to create the output cache\n");
+    return false;
+  }
+
+  bool rv;
+  int64 num_copied;
+  {
+    Converter converter(source.get(), dest.get());
+    rv = converter.Run();
+    num_copied = converter.num_copied();
+  }
+  printf("%" PRId64 " of %d entries copied\n", num_copied,
+         source->GetEntryCount());
+  return rv;
+}
@@ -0,0 +1,23 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_TOOLS_DUMP_CACHE_CACHE_CONVERTER_H_
+#define NET_TOOLS_DUMP_CACHE_CACHE_CONVERTER_H_
+#pragma once
+
+class FilePath;
+
+// Copies every entry of the cache at |input_path| to a new cache at
+// |output_path|, keeping the times of the entries.  The new cache is a
+// ShardedBackend with |num_shards| shards, or a regular one if |num_shards|
+// is 0.  The input cache may be either kind.  Several entries are copied at
+// a time, so that the cache threads of all the shards are kept busy.
+//
+// Sparse data is not copied.  Returns false if either cache can't be
+// opened, or an entry can't be copied.  Runs the MessageLoop of the thread,
+// which must be of TYPE_IO, until done.
+bool ConvertCache(const FilePath& input_path, const FilePath& output_path,
+                  int num_shards);
+
+#endif  // NET_TOOLS_DUMP_CACHE_CACHE_CONVERTER_H_
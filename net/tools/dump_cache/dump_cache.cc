@@ -10,11 +10,17 @@
 
 #include "base/at_exit.h"
 #include "base/command_line.h"
+#include "base/message_loop.h"
 #include "base/process_util.h"
+#include "base/string_number_conversions.h"
 #include "base/string_util.h"
 #include "base/stringprintf.h"
+#include "base/sys_info.h"
+#include "base/time.h"
 #include "base/win/scoped_handle.h"
 #include "net/disk_cache/disk_format.h"
+#include "net/tools/dump_cache/cache_analyzer.h"
+#include "net/tools/dump_cache/cache_converter.h"
 
 enum Errors {
   GENERIC = -1,
@@ -56,6 +62,19 @@ const char kDumpToFiles[] = "dump-to-files";
 // Upgrade an old version to the current one.
 const char kUpgrade[] = "upgrade";
 
+// Displays statistics about the entries, reading the files with several
+// threads.
+const char kAnalyze[] = "analyze";
+
+// Number of threads for --analyze.
+const char kThreads[] = "threads";
+
+// Copies the cache to a new one of the current version, sharded or not.
+const char kConvert[] = "convert";
+
+// Number of shards of the cache created by --convert (0 for none).
+const char kShards[] = "shards";
+
 // Internal use:
 const char kSlave[] = "slave";
 const char kPipe[] = "pipe";
@@ -67,6 +86,9 @@ int Help() {
   printf("--dump-contents: display all entries\n");
   printf("--upgrade: copy contents to the output path\n");
   printf("--dump-to-files: write the contents of the cache to files\n");
+  printf("--analyze [--threads=n]: display statistics about the entries\n");
+  printf("--convert [--shards=n]: copy contents to a new cache at the output\n"
+         "    path, with n shards (0 for a regular cache)\n");
   return INVALID_ARGUMENT;
 }
 
@@ -119,6 +141,38 @@ int main(int argc, const char* argv[]) {
   if (input_path.empty())
     return Help();
 
+  // These read the files of the current version directly, and know about
+  // sharded caches, so they don't need a slave.
+  if (command_line.HasSwitch(kAnalyze)) {
+    int threads = base::SysInfo::NumberOfProcessors();
+    if (command_line.HasSwitch(kThreads) &&
+        (!base::StringToInt(command_line.GetSwitchValueASCII(kThreads),
+                            &threads) || threads < 1)) {
+      return Help();
+    }
+    CacheStats stats;
+    if (!AnalyzeCache(FilePath::FromWStringHack(input_path), threads,
+                      base::Time::Now(), &stats)) {
+      return FILE_ACCESS_ERROR;
+    }
+    PrintCacheStats(stats);
+    return ALL_GOOD;
+  }
+  if (command_line.HasSwitch(kConvert)) {
+    FilePath output = command_line.GetSwitchValuePath(kOutputPath);
+    int shards = 0;
+    if (output.empty() ||
+        (command_line.HasSwitch(kShards) &&
+         (!base::StringToInt(command_line.GetSwitchValueASCII(kShards),
+                             &shards) || shards < 0))) {
+      return Help();
+    }
+    MessageLoop loop(MessageLoop::TYPE_IO);
+    if (!ConvertCache(FilePath::FromWStringHack(input_path), output, shards))
+      return GENERIC;
+    return ALL_GOOD;
+  }
+
   bool upgrade = false;
   bool slave_required = false;
   bool copy_to_text = false;
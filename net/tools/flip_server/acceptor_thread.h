@@ -5,6 +5,8 @@
 #ifndef NET_TOOLS_FLIP_SERVER_ACCEPTOR_THREAD_H_
 #define NET_TOOLS_FLIP_SERVER_ACCEPTOR_THREAD_H_
 
+#include <time.h>
+
 #include <list>
 #include <string>
 #include <vector>
@@ -80,6 +82,8 @@ class SMAcceptorThread : public base::SimpleThread,
   SSLState* ssl_state_;
   bool use_ssl_;
   int idle_socket_timeout_s_;
+  // No connection of this thread has been idle since before this time.
+  time_t oldest_active_time_;
 
   std::vector<SMConnection*> unused_server_connections_;
   std::vector<SMConnection*> tmp_unused_server_connections_;
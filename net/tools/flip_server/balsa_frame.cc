@@ -50,6 +50,7 @@ BalsaFrame::BalsaFrame()
       last_slash_n_loc_(NULL),
       last_recorded_slash_n_loc_(NULL),
       last_slash_n_idx_(0),
+      colon_idx_(0),
       term_chars_(0),
       parse_state_(BalsaFrameEnums::READING_HEADER_AND_FIRSTLINE),
       last_error_(BalsaFrameEnums::NO_ERROR),
@@ -73,10 +74,12 @@ void BalsaFrame::Reset() {
   last_slash_n_loc_ = NULL;
   last_recorded_slash_n_loc_ = NULL;
   last_slash_n_idx_ = 0;
+  colon_idx_ = 0;
   term_chars_ = 0;
   parse_state_ = BalsaFrameEnums::READING_HEADER_AND_FIRSTLINE;
   last_error_ = BalsaFrameEnums::NO_ERROR;
   lines_.clear();
+  colons_.clear();
   if (headers_ != NULL) {
     headers_->Clear();
   }
@@ -496,20 +499,12 @@ inline void BalsaFrame::FindColonsAndParseIntoKeyValue() {
   const char* stream_begin = headers_->OriginalHeaderStreamBegin();
   // The last line is always just a newline (and is uninteresting).
   const Lines::size_type lines_size_m1 = lines_.size() - 1;
-#if __SSE2__
-  const __v16qi colons = { ':', ':', ':', ':', ':', ':', ':', ':',
-                           ':', ':', ':', ':', ':', ':', ':', ':'};
-  const char* header_lines_end_m16 = headers_->OriginalHeaderStreamEnd() - 16;
-#endif  // __SSE2__
-  const char* current = stream_begin + lines_[1].first;
-  // This code is a bit more subtle than it may appear at first glance.
-  // This code looks for a colon in the current line... but it also looks
-  // beyond the current line. If there is no colon in the current line, then
-  // for each subsequent line (until the colon which -has- been found is
-  // associated with a line), no searching for a colon will be performed. In
-  // this way, we minimize the amount of bytes we have scanned for a colon.
+  DCHECK_EQ(lines_.size(), colons_.size());
+  // The colons were already found by ProcessHeaders(), so the lines are not
+  // scanned for them again.
   for (Lines::size_type i = 1; i < lines_size_m1;) {
     const char* line_begin = stream_begin + lines_[i].first;
+    size_t colon_idx = colons_[i];
 
     // Here we handle possible continuations.  Note that we do not replace
     // the '\n' in the line before a continuation (at least, as of now),
@@ -524,6 +519,9 @@ inline void BalsaFrame::FindColonsAndParseIntoKeyValue() {
         // loop.
         break;
       }
+      // The key may end in a continuation line.
+      if (colon_idx == 0)
+        colon_idx = colons_[i];
     }
     const char* line_end = stream_begin + lines_[i - 1].second;
     DCHECK_LT(line_begin - stream_begin, line_end - stream_begin);
@@ -552,53 +550,17 @@ inline void BalsaFrame::FindColonsAndParseIntoKeyValue() {
                               line_end - stream_begin,
                               line_end - stream_begin,
                               0));
-    if (current >= line_end) {
+    if (colon_idx == 0) {
+      // There was no colon in the line. The arguments we passed into the
+      // construction for the HeaderLineDescription object should be OK-- it
+      // assumes that the entire content is 'key' by default (which is true,
+      // as there was no colon, there can be no value). Note that this is a
+      // construct which is technically not allowed by the spec.
       last_error_ = BalsaFrameEnums::HEADER_MISSING_COLON;
       visitor_->HandleHeaderWarning(this);
-      // Then the next colon will not be found within this header line-- time
-      // to try again with another header-line.
       continue;
-    } else if (current < line_begin) {
-      // When this condition is true, the last detected colon was part of a
-      // previous line.  We reset to the beginning of the line as we don't care
-      // about the presence of any colon before the beginning of the current
-      // line.
-      current = line_begin;
-    }
-#if __SSE2__
-    while (current < header_lines_end_m16) {
-      __m128i header_bytes =
-        _mm_loadu_si128(reinterpret_cast<const __m128i *>(current));
-      __m128i colon_cmp =
-        _mm_cmpeq_epi8(header_bytes, reinterpret_cast<__m128i>(colons));
-      int colon_msk = _mm_movemask_epi8(colon_cmp);
-      if (colon_msk == 0) {
-        current += 16;
-        continue;
-      }
-      current += (ffs(colon_msk) - 1);
-      if (current > line_end) {
-        break;
-      }
-      goto found_colon;
     }
-#endif  // __SSE2__
-    for (; current < line_end; ++current) {
-      if (*current != ':') {
-        continue;
-      }
-      goto found_colon;
-    }
-    // If we've gotten to here, then there was no colon
-    // in the line. The arguments we passed into the construction
-    // for the HeaderLineDescription object should be OK-- it assumes
-    // that the entire content is 'key' by default (which is true, as
-    // there was no colon, there can be no value). Note that this is a
-    // construct which is technically not allowed by the spec.
-    last_error_ = BalsaFrameEnums::HEADER_MISSING_COLON;
-    visitor_->HandleHeaderWarning(this);
-    continue;
- found_colon:
+    const char* current = stream_begin + colon_idx;
     DCHECK_EQ(*current, ':');
     DCHECK_LE(current - stream_begin, line_end - stream_begin);
     DCHECK_LE(stream_begin - stream_begin, current - stream_begin);
@@ -1011,6 +973,8 @@ size_t BalsaFrame::ProcessHeaders(const char* message_start,
         const char* const message_end_m16 = message_end - 16;
         __v16qi newlines = { '\n', '\n', '\n', '\n', '\n', '\n', '\n', '\n',
                              '\n', '\n', '\n', '\n', '\n', '\n', '\n', '\n' };
+        const __v16qi colons = { ':', ':', ':', ':', ':', ':', ':', ':',
+                                 ':', ':', ':', ':', ':', ':', ':', ':' };
         while (message_current < message_end_m16) {
           // What this does (using compiler intrinsics):
           //
@@ -1029,6 +993,18 @@ size_t BalsaFrame::ProcessHeaders(const char* message_start,
           __m128i newline_cmp =
             _mm_cmpeq_epi8(msg_bytes, reinterpret_cast<__m128i>(newlines));
           int newline_msk = _mm_movemask_epi8(newline_cmp);
+          if (colon_idx_ == 0) {
+            // Note the line's first colon while its bytes are loaded.  Only
+            // the colons before the first '\n' are in this line.
+            __m128i colon_cmp =
+              _mm_cmpeq_epi8(msg_bytes, reinterpret_cast<__m128i>(colons));
+            int colon_msk = _mm_movemask_epi8(colon_cmp) &
+                            ((newline_msk & -newline_msk) - 1);
+            if (colon_msk != 0) {
+              colon_idx_ = base_idx + (message_current - message_start) +
+                           (ffs(colon_msk) - 1);
+            }
+          }
           if (newline_msk == 0) {
             message_current += 16;
             continue;
@@ -1038,6 +1014,8 @@ size_t BalsaFrame::ProcessHeaders(const char* message_start,
           const size_t message_current_idx = 1 + base_idx + relative_idx;
           lines_.push_back(std::make_pair(last_slash_n_idx_,
                                           message_current_idx));
+          colons_.push_back(colon_idx_);
+          colon_idx_ = 0;
           if (lines_.size() == 1) {
             headers_->WriteFromFramer(checkpoint,
                                       1 + message_current - checkpoint);
@@ -1075,6 +1053,8 @@ size_t BalsaFrame::ProcessHeaders(const char* message_start,
 #endif  // __SSE2__
       while (message_current < message_end) {
         if (*message_current != '\n') {
+          if (*message_current == ':' && colon_idx_ == 0)
+            colon_idx_ = base_idx + (message_current - message_start);
           ++message_current;
           continue;
         }
@@ -1082,6 +1062,8 @@ size_t BalsaFrame::ProcessHeaders(const char* message_start,
         const size_t message_current_idx = 1 + base_idx + relative_idx;
         lines_.push_back(std::make_pair(last_slash_n_idx_,
                                         message_current_idx));
+        colons_.push_back(colon_idx_);
+        colon_idx_ = 0;
         if (lines_.size() == 1) {
           headers_->WriteFromFramer(checkpoint,
                                     1 + message_current - checkpoint);
@@ -248,11 +248,17 @@ class BalsaFrame {
   const char* last_slash_n_loc_;
   const char* last_recorded_slash_n_loc_;
   size_t last_slash_n_idx_;
+  // Where the first colon of the line being scanned is in the header
+  // stream, or 0 if it has none yet.
+  size_t colon_idx_;
   uint32 term_chars_;
   BalsaFrameEnums::ParseState parse_state_;
   BalsaFrameEnums::ErrorCode last_error_;
 
   Lines lines_;
+  // colon_idx_ of each line in lines_, found while looking for the line's
+  // end so that the header bytes are only scanned once.
+  std::vector<size_t> colons_;
 
   BalsaHeaders* headers_;  // This is not reset to NULL in Reset().
   DoNothingBalsaVisitor do_nothing_visitor_;
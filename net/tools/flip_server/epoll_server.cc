@@ -6,6 +6,7 @@
 
 #include <stdlib.h>  // for abort
 #include <errno.h>    // for errno and strerror_r
+#include <string.h>   // for memset
 #include <algorithm>
 #include <iostream>
 #include <utility>
@@ -82,6 +83,8 @@ EpollServer::EpollServer()
   : epoll_fd_(epoll_create(1024)),
     timeout_in_us_(0),
     recorded_now_in_us_(0),
+    alarm_tick_(0),
+    num_alarms_(0),
     ready_list_size_(0),
     wake_cb_(new ReadPipeCallback),
     read_fd_(-1),
@@ -92,6 +95,11 @@ EpollServer::EpollServer()
   CHECK_NE(epoll_fd_, -1);
   LIST_INIT(&ready_list_);
   LIST_INIT(&tmp_list_);
+  for (int i = 0; i < kAlarmWheelSlots; ++i)
+    LIST_INIT(&alarm_wheel_[i]);
+  memset(alarm_slots_used_, 0, sizeof(alarm_slots_used_));
+  LIST_INIT(&expired_alarms_);
+  LIST_INIT(&free_alarm_nodes_);
 
   int pipe_fds[2];
   if (pipe(pipe_fds) < 0) {
@@ -125,21 +133,24 @@ void EpollServer::CleanupFDToCBMap() {
   }
 }
 
-void EpollServer::CleanupTimeToAlarmCBMap() {
-  TimeToAlarmCBMap::iterator erase_it;
-
-  // Call OnShutdown() on alarms. Note that the structure of the loop
-  // is similar to the structure of loop in the function HandleAlarms()
-  for (TimeToAlarmCBMap::iterator i = alarm_map_.begin();
-       i != alarm_map_.end();
-      ) {
-    // Note that OnShutdown() can call UnregisterAlarm() on
-    // other iterators. OnShutdown() should not call UnregisterAlarm()
-    // on self because by definition the iterator is not valid any more.
-    i->second->OnShutdown(this);
-    erase_it = i;
-    ++i;
-    alarm_map_.erase(erase_it);
+void EpollServer::CleanupAlarms() {
+  // Call OnShutdown() on alarms.
+  for (int i = -1; i < kAlarmWheelSlots; ++i) {
+    AlarmList* list = i < 0 ? &expired_alarms_ : &alarm_wheel_[i];
+    while (list->lh_first != NULL) {
+      // Note that OnShutdown() can call UnregisterAlarm() on
+      // other tokens. OnShutdown() should not call UnregisterAlarm()
+      // on self because by definition the token is not valid any more.
+      AlarmNode* node = list->lh_first;
+      AlarmCB* cb = node->cb;
+      UnlinkAlarm(node);
+      cb->OnShutdown(this);
+    }
+  }
+  while (free_alarm_nodes_.lh_first != NULL) {
+    AlarmNode* node = free_alarm_nodes_.lh_first;
+    LIST_REMOVE(node, entry);
+    delete node;
   }
 }
 
@@ -155,7 +166,7 @@ EpollServer::~EpollServer() {
   LIST_INIT(&ready_list_);
   LIST_INIT(&tmp_list_);
 
-  CleanupTimeToAlarmCBMap();
+  CleanupAlarms();
 
   close(read_fd_);
   close(write_fd_);
@@ -363,7 +374,7 @@ void EpollServer::WaitForEventsAndExecuteCallbacks() {
     return;  // COV_NF_LINE
   }
   TrueFalseGuard recursion_guard(&in_wait_for_events_and_execute_callbacks_);
-  if (alarm_map_.empty()) {
+  if (num_alarms_ == 0) {
     // no alarms, this is business as usual.
     WaitForEventsAndCallHandleEvents(timeout_in_us_,
                                      events_,
@@ -379,9 +390,9 @@ void EpollServer::WaitForEventsAndExecuteCallbacks() {
   // a more reasonable amount of work is done here.
   int64 now_in_us  = NowInUsec();
 
-  // Get the first timeout from the alarm_map where it is
+  // Get the first timeout from the alarm wheel where it is
   // stored in absolute time.
-  int64 next_alarm_time_in_us =  alarm_map_.begin()->first;
+  int64 next_alarm_time_in_us = NextAlarmTimeInUsec();
   VLOG(4) << "next_alarm_time = " << next_alarm_time_in_us
           << " now             = " << now_in_us
           << " timeout_in_us = " << timeout_in_us_;
@@ -458,28 +469,51 @@ void EpollServer::VerifyReadyList() const {
 
 void EpollServer::RegisterAlarm(int64 timeout_time_in_us, AlarmCB* ac) {
   CHECK(ac);
+#ifndef NDEBUG
   if (ContainsAlarm(ac)) {
     LOG(FATAL) << "Alarm already exists " << ac;
   }
+  all_alarms_.insert(ac);
+#endif
   VLOG(4) << "RegisteringAlarm at : " << timeout_time_in_us;
 
-  TimeToAlarmCBMap::iterator alarm_iter =
-      alarm_map_.insert(std::make_pair(timeout_time_in_us, ac));
-
-  all_alarms_.insert(ac);
-  // Pass the iterator to the EpollAlarmCallbackInterface.
-  ac->OnRegistration(alarm_iter, this);
+  AlarmNode* node = free_alarm_nodes_.lh_first;
+  if (node != NULL) {
+    LIST_REMOVE(node, entry);
+  } else {
+    node = new AlarmNode;
+  }
+  node->time_in_us = timeout_time_in_us;
+  node->cb = ac;
+  LinkAlarm(node);
+  ++num_alarms_;
+  // Pass the token to the EpollAlarmCallbackInterface.
+  ac->OnRegistration(node, this);
 }
 
 // Unregister a specific alarm callback: iterator_token must be a
-//  valid iterator. The caller must ensure the validity of the iterator.
+//  valid token. The caller must ensure the validity of the token.
 void EpollServer::UnregisterAlarm(const AlarmRegToken& iterator_token) {
-  AlarmCB* cb = iterator_token->second;
-  alarm_map_.erase(iterator_token);
-  all_alarms_.erase(cb);
+  AlarmCB* cb = iterator_token->cb;
+  UnlinkAlarm(iterator_token);
   cb->OnUnregistration();
 }
 
+bool EpollServer::ContainsAlarm(EpollAlarmCallbackInterface* alarm) const {
+#ifndef NDEBUG
+  return all_alarms_.find(alarm) != all_alarms_.end();
+#else
+  for (int i = -1; i < kAlarmWheelSlots; ++i) {
+    const AlarmList* list = i < 0 ? &expired_alarms_ : &alarm_wheel_[i];
+    for (AlarmNode* node = list->lh_first; node; node = node->entry.le_next) {
+      if (node->cb == alarm)
+        return true;
+    }
+  }
+  return false;
+#endif
+}
+
 int EpollServer::NumFDsRegistered() const {
   DCHECK(cb_map_.size() >= 1);
   // Omit the internal FD (read_fd_)
@@ -526,15 +560,13 @@ void EpollServer::LogStateOnCrash() {
   LOG(ERROR) << "timeout_in_us_: " << timeout_in_us_;
 
   // Log sessions with alarms.
-  LOG(ERROR) << alarm_map_.size() << " alarms registered.";
-  for (TimeToAlarmCBMap::iterator it = alarm_map_.begin();
-       it != alarm_map_.end();
-       ++it) {
-    const bool skipped =
-        alarms_reregistered_and_should_be_skipped_.find(it->second)
-        != alarms_reregistered_and_should_be_skipped_.end();
-    LOG(ERROR) << "Alarm " << it->second << " registered at time " << it->first
-               << " and should be skipped = " << skipped;
+  LOG(ERROR) << num_alarms_ << " alarms registered.";
+  for (int i = -1; i < kAlarmWheelSlots; ++i) {
+    const AlarmList* list = i < 0 ? &expired_alarms_ : &alarm_wheel_[i];
+    for (AlarmNode* node = list->lh_first; node; node = node->entry.le_next) {
+      LOG(ERROR) << "Alarm " << node->cb << " registered at time "
+                 << node->time_in_us << " and expired = " << (i < 0);
+    }
   }
 
   LOG(ERROR) << cb_map_.size() << " fd callbacks registered.";
@@ -741,53 +773,107 @@ inline int64 EpollServer::DoRoundingOnNow(int64 now_in_us) const {
   return now_in_us;
 }
 
+int64 EpollServer::NextAlarmTimeInUsec() const {
+  DCHECK_GT(num_alarms_, 0);
+  const int kWords = kAlarmWheelSlots / 64;
+  const int first_slot = alarm_tick_ % kAlarmWheelSlots;
+  // alarm_tick_'s slot also holds the alarms registered for a time that has
+  // already passed, so the times of its alarms are looked at.
+  int64 next_alarm_time_in_us = kint64max;
+  for (AlarmNode* node = alarm_wheel_[first_slot].lh_first; node;
+       node = node->entry.le_next) {
+    next_alarm_time_in_us = std::min(next_alarm_time_in_us, node->time_in_us);
+  }
+  // For the other slots, the tick of the first used one is early enough.
+  // Look for it after alarm_tick_'s slot, wrapping around to the slots
+  // before it in the first word last.
+  for (int i = 0; i <= kWords; ++i) {
+    const int word = (first_slot / 64 + i) % kWords;
+    uint64 bits = alarm_slots_used_[word];
+    if (i == 0)
+      bits &= ~((GG_UINT64_C(2) << (first_slot % 64)) - 1);
+    else if (i == kWords)
+      bits &= (GG_UINT64_C(1) << (first_slot % 64)) - 1;
+    if (bits == 0)
+      continue;
+    const int slot = word * 64 + __builtin_ctzll(bits);
+    const int distance =
+        (slot - first_slot + kAlarmWheelSlots) % kAlarmWheelSlots;
+    return std::min(next_alarm_time_in_us,
+                    (alarm_tick_ + distance) * kMinimumEffectiveAlarmQuantum);
+  }
+  return next_alarm_time_in_us;
+}
+
+void EpollServer::LinkAlarm(AlarmNode* node) {
+  const int64 tick = std::max(node->time_in_us / kMinimumEffectiveAlarmQuantum,
+                              alarm_tick_);
+  node->slot = tick % kAlarmWheelSlots;
+  LIST_INSERT_HEAD(&alarm_wheel_[node->slot], node, entry);
+  alarm_slots_used_[node->slot / 64] |= GG_UINT64_C(1) << (node->slot % 64);
+}
+
+void EpollServer::UnlinkAlarm(AlarmNode* node) {
+  LIST_REMOVE(node, entry);
+  if (node->slot >= 0 && alarm_wheel_[node->slot].lh_first == NULL) {
+    alarm_slots_used_[node->slot / 64] &=
+        ~(GG_UINT64_C(1) << (node->slot % 64));
+  }
+  --num_alarms_;
+#ifndef NDEBUG
+  all_alarms_.erase(node->cb);
+#endif
+  node->cb = NULL;
+  LIST_INSERT_HEAD(&free_alarm_nodes_, node, entry);
+}
+
 void EpollServer::CallAndReregisterAlarmEvents() {
   int64 now_in_us = recorded_now_in_us_;
   DCHECK_NE(0, recorded_now_in_us_);
   now_in_us = DoRoundingOnNow(now_in_us);
-
-  TimeToAlarmCBMap::iterator erase_it;
+  const int64 now_tick = now_in_us / kMinimumEffectiveAlarmQuantum;
+
+  // Take the alarms which are due off the wheel before calling any of them,
+  // so that an alarm reregistered by OnAlarm() for a time which has already
+  // passed waits for the next call instead of being called again here, and
+  // we do not go in an infinite loop.  Going through the ticks from the
+  // last one down leaves expired_alarms_ sorted by tick.
+  DCHECK(expired_alarms_.lh_first == NULL);
+  const int64 first_tick = std::max(alarm_tick_,
+                                    now_tick - kAlarmWheelSlots + 1);
+  for (int64 tick = now_tick; tick >= first_tick; --tick) {
+    const int slot = tick % kAlarmWheelSlots;
+    AlarmNode* node = alarm_wheel_[slot].lh_first;
+    while (node != NULL) {
+      AlarmNode* next = node->entry.le_next;
+      // Alarms a whole turn of the wheel or more away share the slot.
+      if (node->time_in_us <= now_in_us) {
+        LIST_REMOVE(node, entry);
+        node->slot = -1;
+        LIST_INSERT_HEAD(&expired_alarms_, node, entry);
+      }
+      node = next;
+    }
+    if (alarm_wheel_[slot].lh_first == NULL)
+      alarm_slots_used_[slot / 64] &= ~(GG_UINT64_C(1) << (slot % 64));
+  }
+  // now_tick itself may still hold alarms due later in the tick.
+  alarm_tick_ = std::max(alarm_tick_, now_tick);
 
   // execute alarms.
-  for (TimeToAlarmCBMap::iterator i = alarm_map_.begin();
-       i != alarm_map_.end();
-      ) {
-    if (i->first > now_in_us) {
-      break;
-    }
-    AlarmCB* cb = i->second;
-    // Execute the OnAlarm() only if we did not register
-    // it in this loop itself.
-    const bool added_in_this_round =
-        alarms_reregistered_and_should_be_skipped_.find(cb)
-        != alarms_reregistered_and_should_be_skipped_.end();
-    if (added_in_this_round) {
-      ++i;
-      continue;
-    }
-    all_alarms_.erase(cb);
+  while (expired_alarms_.lh_first != NULL) {
+    AlarmNode* node = expired_alarms_.lh_first;
+    AlarmCB* cb = node->cb;
+    UnlinkAlarm(node);
     const int64 new_timeout_time_in_us = cb->OnAlarm();
-
-    erase_it = i;
-    ++i;
-    alarm_map_.erase(erase_it);
-
     if (new_timeout_time_in_us > 0) {
-      // We add to hash_set only if the new timeout is <= now_in_us.
-      // if timeout is > now_in_us then we have no fear that this alarm
-      // can be reexecuted in this loop, and hence we do not need to
-      // worry about a recursive loop.
       DVLOG(3) << "Reregistering alarm "
                << " " << cb
                << " " << new_timeout_time_in_us
                << " " << now_in_us;
-      if (new_timeout_time_in_us <= now_in_us) {
-        alarms_reregistered_and_should_be_skipped_.insert(cb);
-      }
       RegisterAlarm(new_timeout_time_in_us, cb);
     }
   }
-  alarms_reregistered_and_should_be_skipped_.clear();
 }
 
 EpollAlarm::EpollAlarm() : eps_(NULL), registered_(false) {
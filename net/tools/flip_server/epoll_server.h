@@ -123,8 +123,18 @@ class EpollServer {
   typedef EpollAlarmCallbackInterface AlarmCB;
   typedef EpollCallbackInterface CB;
 
-  typedef std::multimap<int64, AlarmCB*> TimeToAlarmCBMap;
-  typedef TimeToAlarmCBMap::iterator AlarmRegToken;
+  // A registered alarm.  It is on one of the lists of the timer wheel while
+  // registered, and on a free list once it has fired or been unregistered,
+  // so that (re)registering an alarm doesn't allocate once the server has
+  // seen as many alarms at once as it will.
+  struct AlarmNode {
+    int64 time_in_us;
+    AlarmCB* cb;
+    // The wheel slot the node is on, or -1 once it has expired.
+    int slot;
+    LIST_ENTRY(AlarmNode) entry;
+  };
+  typedef AlarmNode* AlarmRegToken;
 
   // Summary:
   //   Constructor:
@@ -476,9 +486,10 @@ class EpollServer {
   // Returns true when the EpollServer() is being destroyed.
   bool in_shutdown() const { return in_shutdown_; }
 
-  bool ContainsAlarm(EpollAlarmCallbackInterface* alarm) const {
-    return all_alarms_.find(alarm) != all_alarms_.end();
-  }
+  // Summary:
+  //   Returns true if 'alarm' is registered.  Only cheap in debug builds, so
+  //   it should only be used for checks and tests.
+  bool ContainsAlarm(EpollAlarmCallbackInterface* alarm) const;
 
   // Summary:
   //   A function for implementing the ready list. It invokes OnEvent for each
@@ -490,6 +501,11 @@ class EpollServer {
   // Granularity at which time moves when considering what alarms are on.
   // See function: DoRoundingOnNow() on exact usage.
   static const int kMinimumEffectiveAlarmQuantum;
+
+  // The number of slots on the timer wheel, each kMinimumEffectiveAlarmQuantum
+  // long.  Alarms further away than that share slots with nearer alarms and
+  // are skipped until their time comes around.
+  static const int kAlarmWheelSlots = 4096;
  protected:
 
   virtual int GetFlags(int fd);
@@ -675,14 +691,30 @@ class EpollServer {
   };
 
 
-  // TOOD(sushantj): Having this hash_set is avoidable. We currently have it
-  // only so that we can enforce stringent checks that a caller can not register
-  // the same alarm twice. One option is to have an implementation in which
-  // this hash_set is used only in the debug mode.
   typedef __gnu_cxx::hash_set<AlarmCB*, AlarmCBHash> AlarmCBMap;
+#ifndef NDEBUG
+  // Only kept in debug builds, to enforce that a caller can not register the
+  // same alarm twice without scanning the wheel.
   AlarmCBMap all_alarms_;
+#endif
+
+  LIST_HEAD(AlarmList, AlarmNode);
 
-  TimeToAlarmCBMap alarm_map_;
+  // The timer wheel.  An alarm at time t is on the list of slot
+  // (t / kMinimumEffectiveAlarmQuantum) % kAlarmWheelSlots, or, if that tick
+  // is before alarm_tick_, on the slot of alarm_tick_.  A bit of
+  // alarm_slots_used_ is set for each slot whose list is not empty.
+  AlarmList alarm_wheel_[kAlarmWheelSlots];
+  uint64 alarm_slots_used_[kAlarmWheelSlots / 64];
+  // The tick CallAndReregisterAlarmEvents() last expired alarms up to.
+  int64 alarm_tick_;
+  int num_alarms_;
+
+  // Alarms taken off the wheel by CallAndReregisterAlarmEvents() and waiting
+  // for their OnAlarm() to be called.  They can still be unregistered.
+  AlarmList expired_alarms_;
+
+  AlarmList free_alarm_nodes_;
 
   // The amount of time in microseconds that we'll wait before returning
   // from the WaitForEventsAndExecuteCallbacks() function.
@@ -698,15 +730,6 @@ class EpollServer {
   // ApproximateNowInUs() function. See that function for more details.
   int64 recorded_now_in_us_;
 
-  // This is used to implement CallAndReregisterAlarmEvents. This stores
-  // all alarms that were reregistered because OnAlarm() returned a
-  // value > 0 and the time at which they should be executed is less that
-  // the current time.  By storing such alarms in this map we ensure
-  // that while calling CallAndReregisterAlarmEvents we do not call
-  // OnAlarm on any alarm in this set. This ensures that we do not
-  // go in an infinite loop.
-  AlarmCBMap alarms_reregistered_and_should_be_skipped_;
-
   LIST_HEAD(ReadyList, CBAndEventMask) ready_list_;
   LIST_HEAD(TmpList, CBAndEventMask) tmp_list_;
   int ready_list_size_;
@@ -719,6 +742,15 @@ class EpollServer {
   // TODO(sushantj): Add test for this.
   int64 DoRoundingOnNow(int64 now_in_us) const;
 
+  // Returns a time no later than the earliest registered alarm.  Only valid
+  // when num_alarms_ > 0.
+  int64 NextAlarmTimeInUsec() const;
+
+  // LinkAlarm puts 'node' on the wheel.  UnlinkAlarm takes it off whichever
+  // list it is on and puts it on free_alarm_nodes_.
+  void LinkAlarm(AlarmNode* node);
+  void UnlinkAlarm(AlarmNode* node);
+
 #ifdef EPOLL_SERVER_EVENT_TRACING
   struct EventRecorder {
    public:
@@ -955,7 +987,7 @@ class EpollServer {
  private:
   // Helper functions used in the destructor.
   void CleanupFDToCBMap();
-  void CleanupTimeToAlarmCBMap();
+  void CleanupAlarms();
 
   // The callback registered to the fds below.  As the purpose of their
   // registration is to wake the epoll server it just clears the pipe and
@@ -994,7 +1026,7 @@ class EpollAlarmCallbackInterface {
   // Summary:
   //   Called when the an alarm is registered. Invalidates an AlarmRegToken.
   // Args:
-  //   token: the iterator to the the alarm registered in the alarm map.
+  //   token: the token of the alarm registered on the timer wheel.
   //   WARNING: this token becomes invalid when the alarm fires, is
   //   unregistered, or OnShutdown is called on that alarm.
   //   eps: the epoll server the alarm is registered with.
@@ -136,4 +136,25 @@ void FlipConfig::AddAcceptor(enum FlipHandlerType flip_handler_type,
                                         memory_cache));
 }
 
+FlipAcceptor* FlipConfig::AddAcceptorCopy(const FlipAcceptor& acceptor,
+                                          bool wait_for_iface) {
+  AddAcceptor(acceptor.flip_handler_type_,
+              acceptor.listen_ip_,
+              acceptor.listen_port_,
+              acceptor.ssl_cert_filename_,
+              acceptor.ssl_key_filename_,
+              acceptor.http_server_ip_,
+              acceptor.http_server_port_,
+              acceptor.https_server_ip_,
+              acceptor.https_server_port_,
+              acceptor.spdy_only_,
+              acceptor.accept_backlog_size_,
+              acceptor.disable_nagle_,
+              acceptor.accepts_per_wake_,
+              true,
+              wait_for_iface,
+              acceptor.memory_cache_);
+  return acceptors_.back();
+}
+
 }  // namespace
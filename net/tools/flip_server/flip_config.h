@@ -84,6 +84,12 @@ class FlipConfig {
                    bool wait_for_iface,
                    void *memory_cache);
 
+  // Adds an acceptor like |acceptor| with a listening socket of its own, for
+  // another worker thread, and returns it.  The sockets must be created with
+  // SO_REUSEPORT to share the address.
+  FlipAcceptor* AddAcceptorCopy(const FlipAcceptor& acceptor,
+                                bool wait_for_iface);
+
   std::vector<FlipAcceptor*> acceptors_;
   double server_think_time_in_s_;
   enum logging::LoggingDestination log_destination_;
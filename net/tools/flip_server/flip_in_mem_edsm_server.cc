@@ -14,7 +14,10 @@
 #include "base/command_line.h"
 #include "base/logging.h"
 #include "base/synchronization/lock.h"
+#include "base/sys_info.h"
 #include "base/timer.h"
+#include "net/spdy/spdy_framer.h"
+#include "net/tools/dump_cache/url_utilities.h"
 #include "net/tools/flip_server/acceptor_thread.h"
 #include "net/tools/flip_server/constants.h"
 #include "net/tools/flip_server/flip_config.h"
@@ -22,6 +25,7 @@
 #include "net/tools/flip_server/sm_connection.h"
 #include "net/tools/flip_server/sm_interface.h"
 #include "net/tools/flip_server/spdy_interface.h"
+#include "net/tools/flip_server/spdy_util.h"
 #include "net/tools/flip_server/streamer_interface.h"
 #include "net/tools/flip_server/split.h"
 
@@ -46,6 +50,11 @@ int32 FLAGS_accept_backlog_size = 1024;
 //  SO_REUSEPORT);
 bool FLAGS_reuseport = false;
 
+// The number of threads serving each listener, each with its own EpollServer.
+//  0 runs one per processor.  With reuseport, each thread also gets its own
+//  listening socket, otherwise they all accept from the same one.
+int32 FLAGS_workers = 1;
+
 // Flag to force spdy, even if NPN is not negotiated.
 bool FLAGS_force_spdy = false;
 
@@ -195,15 +204,25 @@ int main (int argc, char**argv)
     cout << "\t  * Leaving the ssl cert and key fields empty will disable ssl"
          << " for the\n"
          << "\t    http and spdy flip servers\n";
+    cout << "\t--sdch-dictionary=<dictionary url>\n";
+    cout << "\t  * SDCH encodes the cached responses against the dictionary"
+         << " cached for\n"
+         << "\t    this url, for clients that have it.\n";
     cout << "\n  Global options:\n";
     cout << "\t--logdest=<file|system|both>\n";
     cout << "\t--logfile=<logfile>\n";
+    cout << "\t--spdy-low-memory-compression\n";
     cout << "\t--wait-for-iface\n";
     cout << "\t  * The flip server will block until the listen ip has been"
          << " raised.\n";
     cout << "\t--ssl-session-expiry=<seconds> (default is 300)\n";
     cout << "\t--ssl-disable-compression\n";
     cout << "\t--idle-timeout=<seconds> (default is 300)\n";
+    cout << "\t--workers=<count> (default is 1, 0 for one per processor)\n";
+    cout << "\t  * The number of threads serving each listen ip:port.\n";
+    cout << "\t--reuseport\n";
+    cout << "\t  * Gives each worker a listening socket of its own, using"
+         << " SO_REUSEPORT.\n";
     cout << "\t--pidfile=<filepath> (default /var/run/flip-server.pid)\n";
     cout << "\t--help\n";
     exit(0);
@@ -272,6 +291,20 @@ int main (int argc, char**argv)
   if (cl.HasSwitch("force_spdy"))
     net::SMConnection::set_force_spdy(true);
 
+  if (cl.HasSwitch("workers")) {
+    FLAGS_workers = atoi(cl.GetSwitchValueASCII("workers").c_str());
+    if (FLAGS_workers <= 0)
+      FLAGS_workers = base::SysInfo::NumberOfProcessors();
+  }
+
+  if (cl.HasSwitch("reuseport"))
+    FLAGS_reuseport = true;
+
+  if (cl.HasSwitch("spdy-low-memory-compression")) {
+    spdy::SpdyFramer::set_compression_memory_mode_default(
+        spdy::SpdyFramer::COMPRESSION_MEMORY_LOW);
+  }
+
   InitLogging(g_proxy_config.log_filename_.c_str(),
               g_proxy_config.log_destination_,
               logging::DONT_LOCK_LOG_FILE,
@@ -293,6 +326,7 @@ int main (int argc, char**argv)
             << (FLAGS_reuseport?"true":"false");
   LOG(INFO) << "Force SPDY              : "
             << (FLAGS_force_spdy?"true":"false");
+  LOG(INFO) << "Workers per listener    : " << FLAGS_workers;
   LOG(INFO) << "SSL session expiry      : "
             << g_proxy_config.ssl_session_expiry_;
   LOG(INFO) << "SSL disable compression : "
@@ -328,10 +362,25 @@ int main (int argc, char**argv)
                                NULL);
   }
 
+  std::string sdch_dictionary_url;
+  std::string sdch_dictionary_path;
+  std::string sdch_dictionary_filename;
+  if (cl.HasSwitch("sdch-dictionary")) {
+    sdch_dictionary_url = cl.GetSwitchValueASCII("sdch-dictionary");
+    sdch_dictionary_path = net::UrlUtilities::GetUrlPath(sdch_dictionary_url);
+    sdch_dictionary_filename = net::EncodeURL(
+        sdch_dictionary_path,
+        net::UrlUtilities::GetUrlHost(sdch_dictionary_url), "GET");
+  }
+
   // Spdy Server Acceptor
   net::MemoryCache spdy_memory_cache;
   if (cl.HasSwitch("spdy-server")) {
     spdy_memory_cache.AddFiles();
+    if (!sdch_dictionary_url.empty()) {
+      spdy_memory_cache.UseSdchDictionary(sdch_dictionary_filename,
+                                          sdch_dictionary_path);
+    }
     std::string value = cl.GetSwitchValueASCII("spdy-server");
     std::vector<std::string> valueArgs = split(value, ',');
     g_proxy_config.AddAcceptor(net::FLIP_HANDLER_SPDY_SERVER,
@@ -351,6 +400,10 @@ int main (int argc, char**argv)
   net::MemoryCache http_memory_cache;
   if (cl.HasSwitch("http-server")) {
     http_memory_cache.AddFiles();
+    if (!sdch_dictionary_url.empty()) {
+      http_memory_cache.UseSdchDictionary(sdch_dictionary_filename,
+                                          sdch_dictionary_path);
+    }
     std::string value = cl.GetSwitchValueASCII("http-server");
     std::vector<std::string> valueArgs = split(value, ',');
     g_proxy_config.AddAcceptor(net::FLIP_HANDLER_HTTP_SERVER,
@@ -368,22 +421,26 @@ int main (int argc, char**argv)
 
   std::vector<net::SMAcceptorThread*> sm_worker_threads_;
 
-  for (i = 0; i < g_proxy_config.acceptors_.size(); i++) {
-    net::FlipAcceptor *acceptor = g_proxy_config.acceptors_[i];
-
-    sm_worker_threads_.push_back(
-        new net::SMAcceptorThread(acceptor,
-                                  (net::MemoryCache *)acceptor->memory_cache_));
-    // Note that spdy_memory_cache is not threadsafe, it is merely
-    // thread compatible. Thus, if ever we are to spawn multiple threads,
-    // we either must make the MemoryCache threadsafe, or use
-    // a separate MemoryCache for each thread.
-    //
-    // The latter is what is currently being done as we spawn
-    // a separate thread for each http and spdy server acceptor.
-
-    sm_worker_threads_.back()->InitWorker();
-    sm_worker_threads_.back()->Start();
+  size_t listener_count = g_proxy_config.acceptors_.size();
+  for (i = 0; i < listener_count; i++) {
+    for (int worker = 0; worker < FLAGS_workers; ++worker) {
+      net::FlipAcceptor *acceptor = g_proxy_config.acceptors_[i];
+      if (worker > 0 && FLAGS_reuseport) {
+        acceptor = g_proxy_config.AddAcceptorCopy(*acceptor, wait_for_iface);
+        if (acceptor->listen_fd_ < 0)
+          break;
+      }
+
+      // Note that the MemoryCache is not threadsafe, it is merely thread
+      // compatible.  All of its files are loaded above, and from then on it is
+      // only read, so the workers of a listener share one.
+      net::MemoryCache* memory_cache =
+          static_cast<net::MemoryCache*>(acceptor->memory_cache_);
+      sm_worker_threads_.push_back(
+          new net::SMAcceptorThread(acceptor, memory_cache));
+      sm_worker_threads_.back()->InitWorker();
+      sm_worker_threads_.back()->Start();
+    }
   }
 
   while (!wantExit) {
@@ -54,7 +54,8 @@ void HttpSM::ProcessHeaders(const BalsaHeaders& headers) {
             << headers.request_uri().as_string() << " " << method;
     std::string filename = EncodeURL(headers.request_uri().as_string(),
                                 host, method);
-    NewStream(stream_id_, 0, filename);
+    NewStream(stream_id_, 0, filename,
+              headers.GetHeader("Avail-Dictionary").as_string());
     stream_id_ += 2;
   } else {
     VLOG(1) << ACCEPTOR_CLIENT_IDENT << "HttpSM: Received Response from "
@@ -198,11 +199,12 @@ int HttpSM::PostAcceptHook() {
 }
 
 void HttpSM::NewStream(uint32 stream_id, uint32 priority,
-                       const std::string& filename) {
+                       const std::string& filename,
+                       const std::string& avail_dictionary) {
   MemCacheIter mci;
   mci.stream_id = stream_id;
   mci.priority = priority;
-  if (!memory_cache_->AssignFileData(filename, &mci)) {
+  if (!memory_cache_->AssignFileData(filename, avail_dictionary, &mci)) {
     // error creating new stream.
     VLOG(2) << ACCEPTOR_CLIENT_IDENT << "Sending ErrorNotFound";
     SendErrorNotFound(stream_id);
@@ -317,6 +319,33 @@ void HttpSM::SendDataFrameImpl(uint32 stream_id, const char* data, int64 len,
   EnqueueDataFrame(df);
 }
 
+void HttpSM::SendCachedDataFrame(const char* data, size_t len) {
+  // The chunk is sent as three frames, which DoWrite() gathers into one
+  // write, so the body itself is never copied.
+  char chunk_buf[32];
+  int chunk_len = snprintf(chunk_buf, sizeof(chunk_buf), "%x\r\n",
+                           (unsigned int)len);
+  DataFrame* df = new DataFrame;
+  char* buffer = new char[chunk_len];
+  memcpy(buffer, chunk_buf, chunk_len);
+  df->data = buffer;
+  df->size = chunk_len;
+  df->delete_when_done = true;
+  EnqueueDataFrame(df);
+
+  df = new DataFrame;
+  df->data = data;
+  df->size = len;
+  df->delete_when_done = false;
+  EnqueueDataFrame(df);
+
+  df = new DataFrame;
+  df->data = "\r\n";
+  df->size = 2;
+  df->delete_when_done = false;
+  EnqueueDataFrame(df);
+}
+
 void HttpSM::EnqueueDataFrame(DataFrame* df) {
   VLOG(2) << ACCEPTOR_CLIENT_IDENT << "HttpSM: Enqueue data frame: stream "
           << stream_id_;
@@ -331,14 +360,13 @@ void HttpSM::GetOutput() {
     return;
   }
   if (!mci->transformed_header) {
-    mci->bytes_sent = SendSynReply(mci->stream_id,
-                                   *(mci->file_data->headers));
+    mci->bytes_sent = SendSynReply(mci->stream_id, mci->headers());
     mci->transformed_header = true;
     VLOG(2) << ACCEPTOR_CLIENT_IDENT << "HttpSM: GetOutput transformed "
             << "header stream_id: [" << mci->stream_id << "]";
     return;
   }
-  if (mci->body_bytes_consumed >= mci->file_data->body.size()) {
+  if (mci->body_bytes_consumed >= mci->body().size()) {
     SendEOF(mci->stream_id);
     output_ordering_.RemoveStreamId(mci->stream_id);
     VLOG(2) << ACCEPTOR_CLIENT_IDENT << "GetOutput remove_stream_id: ["
@@ -346,13 +374,12 @@ void HttpSM::GetOutput() {
     return;
   }
   size_t num_to_write =
-    mci->file_data->body.size() - mci->body_bytes_consumed;
+    mci->body().size() - mci->body_bytes_consumed;
   if (num_to_write > mci->max_segment_size)
     num_to_write = mci->max_segment_size;
 
-  SendDataFrame(mci->stream_id,
-                mci->file_data->body.data() + mci->body_bytes_consumed,
-                num_to_write, 0, true);
+  SendCachedDataFrame(mci->body().data() + mci->body_bytes_consumed,
+                      num_to_write);
   VLOG(2) << ACCEPTOR_CLIENT_IDENT << "HttpSM: GetOutput SendDataFrame["
           << mci->stream_id << "]: " << num_to_write;
   mci->body_bytes_consumed += num_to_write;
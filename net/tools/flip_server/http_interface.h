@@ -95,7 +95,8 @@ class HttpSM : public BalsaVisitorInterface,
   virtual int PostAcceptHook();
 
   virtual void NewStream(uint32 stream_id, uint32 priority,
-                         const std::string& filename);
+                         const std::string& filename,
+                         const std::string& avail_dictionary);
   virtual void SendEOF(uint32 stream_id);
   virtual void SendErrorNotFound(uint32 stream_id);
   virtual size_t SendSynStream(uint32 stream_id, const BalsaHeaders& headers);
@@ -111,6 +112,10 @@ class HttpSM : public BalsaVisitorInterface,
   size_t SendSynStreamImpl(uint32 stream_id, const BalsaHeaders& headers);
   void SendDataFrameImpl(uint32 stream_id, const char* data, int64 len,
                          uint32 flags, bool compress);
+  // Like SendDataFrameImpl, but sends |data| in place rather than copying it,
+  // so |data| must outlive the connection.  Used for bodies in the
+  // MemoryCache, which isn't changed once loaded.
+  void SendCachedDataFrame(const char* data, size_t len);
   void EnqueueDataFrame(DataFrame* df);
   virtual void GetOutput();
 
@@ -11,13 +11,17 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <deque>
 
 #include "base/string_piece.h"
+#include "base/string_split.h"
+#include "net/base/sdch_manager.h"
 #include "net/tools/dump_cache/url_to_filename_encoder.h"
 #include "net/tools/dump_cache/url_utilities.h"
 #include "net/tools/flip_server/balsa_frame.h"
 #include "net/tools/flip_server/balsa_headers.h"
+#include "sdch/open-vcdiff/src/google/vcencoder.h"
 
 // The directory where cache locates);
 std::string FLAGS_cache_base_dir = ".";
@@ -46,10 +50,10 @@ void StoreBodyAndHeadersVisitor::HandleBodyError(BalsaFrame* framer) {
 }
 
 FileData::FileData(BalsaHeaders* h, const std::string& b)
-    : headers(h), body(b) {
+    : headers(h), body(b), sdch_headers(NULL) {
 }
 
-FileData::FileData() {}
+FileData::FileData() : sdch_headers(NULL) {}
 
 FileData::~FileData() {}
 
@@ -59,6 +63,12 @@ void FileData::CopyFrom(const FileData& file_data) {
     filename = file_data.filename;
     related_files = file_data.related_files;
     body = file_data.body;
+    sdch_headers = NULL;
+    if (file_data.sdch_headers) {
+      sdch_headers = new BalsaHeaders;
+      sdch_headers->CopyFrom(*(file_data.sdch_headers));
+    }
+    sdch_body = file_data.sdch_body;
   }
 
 MemoryCache::MemoryCache() {}
@@ -74,6 +84,7 @@ void MemoryCache::CloneFrom(const MemoryCache& mc) {
     out_i->second.CopyFrom(i->second);
     cwd_ = mc.cwd_;
   }
+  sdch_client_hash_ = mc.sdch_client_hash_;
 }
 
 void MemoryCache::AddFiles() {
@@ -219,13 +230,89 @@ FileData* MemoryCache::GetFileData(const std::string& filename) {
   return &(fi->second);
 }
 
+bool MemoryCache::UseSdchDictionary(const std::string& dictionary_filename,
+                                    const std::string& dictionary_path) {
+  FileData* dictionary = GetFileData(dictionary_filename);
+  if (dictionary == NULL) {
+    LOG(ERROR) << "Could not find SDCH dictionary " << dictionary_filename;
+    return false;
+  }
+  // The vcdiff dictionary follows the SDCH headers, which end with an empty
+  // line.
+  const std::string& dictionary_text = dictionary->body;
+  size_t header_end = dictionary_text.find("\n\n");
+  if (header_end == std::string::npos) {
+    LOG(ERROR) << "No SDCH headers in dictionary " << dictionary_filename;
+    return false;
+  }
+  std::string client_hash;
+  std::string server_hash;
+  SdchManager::GenerateHash(dictionary_text, &client_hash, &server_hash);
+  open_vcdiff::HashedDictionary hashed_dictionary(
+      dictionary_text.data() + header_end + 2,
+      dictionary_text.size() - header_end - 2);
+  if (!hashed_dictionary.Init()) {
+    LOG(ERROR) << "Unable to hash SDCH dictionary " << dictionary_filename;
+    return false;
+  }
+
+  int encoded_files = 0;
+  for (Files::iterator i = files_.begin(); i != files_.end(); ++i) {
+    FileData& file_data = i->second;
+    if (&file_data == dictionary || file_data.body.empty())
+      continue;
+    // Leave alone what SpdySM wouldn't compress either.
+    if (file_data.headers->HasHeader("content-encoding"))
+      continue;
+    std::string content_type =
+        file_data.headers->GetHeader("content-type").as_string();
+    if (content_type.empty() || content_type.find("image") != content_type.npos)
+      continue;
+
+    // An SDCH body starts with the server hash of its dictionary.
+    std::string sdch_body(server_hash);
+    sdch_body.push_back('\0');
+    open_vcdiff::VCDiffStreamingEncoder encoder(
+        &hashed_dictionary, open_vcdiff::VCD_STANDARD_FORMAT, true);
+    if (!encoder.StartEncoding(&sdch_body) ||
+        !encoder.EncodeChunk(file_data.body.data(), file_data.body.size(),
+                             &sdch_body) ||
+        !encoder.FinishEncoding(&sdch_body)) {
+      LOG(ERROR) << "Unable to SDCH encode " << i->first;
+      continue;
+    }
+    if (sdch_body.size() >= file_data.body.size())
+      continue;
+
+    file_data.headers->ReplaceOrAppendHeader("get-dictionary",
+                                             dictionary_path);
+    if (!file_data.sdch_headers)
+      file_data.sdch_headers = new BalsaHeaders;
+    file_data.sdch_headers->CopyFrom(*file_data.headers);
+    file_data.sdch_headers->ReplaceOrAppendHeader("content-encoding", "sdch");
+    file_data.sdch_body.swap(sdch_body);
+    ++encoded_files;
+  }
+  sdch_client_hash_ = client_hash;
+  LOG(INFO) << "SDCH encoded " << encoded_files << " files with dictionary "
+            << dictionary_filename;
+  return true;
+}
+
 bool MemoryCache::AssignFileData(const std::string& filename,
+                                 const std::string& avail_dictionary,
                                  MemCacheIter* mci) {
   mci->file_data = GetFileData(filename);
   if (mci->file_data == NULL) {
     LOG(ERROR) << "Could not find file data for " << filename;
     return false;
   }
+  if (!sdch_client_hash_.empty() && !mci->file_data->sdch_body.empty()) {
+    std::vector<std::string> client_hashes;
+    base::SplitString(avail_dictionary, ',', &client_hashes);
+    mci->sdch_encoded = std::find(client_hashes.begin(), client_hashes.end(),
+                                  sdch_client_hash_) != client_hashes.end();
+  }
   return true;
 }
 
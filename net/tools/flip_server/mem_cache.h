@@ -71,6 +71,11 @@ struct FileData {
   // priority, filename
   std::vector< std::pair<int, std::string> > related_files;
   std::string body;
+  // The body encoded against the SDCH dictionary of the MemoryCache, and the
+  // headers to send with it.  These are empty if encoding didn't make the
+  // body smaller.
+  BalsaHeaders* sdch_headers;
+  std::string sdch_body;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -80,6 +85,7 @@ class MemCacheIter {
   MemCacheIter() :
       file_data(NULL),
       priority(0),
+      sdch_encoded(false),
       transformed_header(false),
       body_bytes_consumed(0),
       stream_id(0),
@@ -88,13 +94,25 @@ class MemCacheIter {
   explicit MemCacheIter(FileData* fd) :
       file_data(fd),
       priority(0),
+      sdch_encoded(false),
       transformed_header(false),
       body_bytes_consumed(0),
       stream_id(0),
       max_segment_size(kInitialDataSendersThreshold),
       bytes_sent(0) {}
+
+  // The headers and body to send, which are the SDCH encoded ones if the
+  // client has the dictionary.
+  const BalsaHeaders& headers() const {
+    return sdch_encoded ? *file_data->sdch_headers : *file_data->headers;
+  }
+  const std::string& body() const {
+    return sdch_encoded ? file_data->sdch_body : file_data->body;
+  }
+
   FileData* file_data;
   int priority;
+  bool sdch_encoded;
   bool transformed_header;
   size_t body_bytes_consumed;
   uint32 stream_id;
@@ -122,10 +140,25 @@ class MemoryCache {
 
   FileData* GetFileData(const std::string& filename);
 
-  bool AssignFileData(const std::string& filename, MemCacheIter* mci);
+  // Encodes the cached bodies against the SDCH dictionary cached under
+  // |dictionary_filename|, keeping the encoded ones that are smaller.  The
+  // plain responses name |dictionary_path| in a Get-Dictionary header, so
+  // that clients fetch it.  Returns false if there is no dictionary there.
+  bool UseSdchDictionary(const std::string& dictionary_filename,
+                         const std::string& dictionary_path);
+
+  // Points |mci| at the response cached under |filename|.  The response is
+  // SDCH encoded if |avail_dictionary|, the Avail-Dictionary header of the
+  // request, lists the dictionary.
+  bool AssignFileData(const std::string& filename,
+                      const std::string& avail_dictionary,
+                      MemCacheIter* mci);
 
   Files files_;
   std::string cwd_;
+
+  // The client hash of the dictionary given to UseSdchDictionary(), if any.
+  std::string sdch_client_hash_;
 };
 
 class NotifierInterface {
@@ -6,7 +6,9 @@
 
 #include <errno.h>
 #include <netinet/tcp.h>
+#include <string.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 #include <list>
 #include <string>
@@ -219,6 +221,54 @@ int SMConnection::Send(const char* data, int len, int flags) {
   return rv;
 }
 
+ssize_t SMConnection::SendOutputList(int flags) {
+  // Only what has been queued is gathered; frames are cheap to queue since
+  // cached bodies aren't copied into them.
+  const size_t kMaxIovecs = 64;
+  while (sm_interface_ && output_list_.size() < kMaxIovecs) {
+    size_t queued = output_list_.size();
+    sm_interface_->GetOutput();
+    if (output_list_.size() == queued)
+      break;
+  }
+  struct iovec iov[kMaxIovecs];
+  size_t count = 0;
+  for (OutputList::const_iterator i = output_list_.begin();
+       i != output_list_.end() && count < kMaxIovecs; ++i) {
+    DataFrame* data_frame = *i;
+    if (data_frame->index >= data_frame->size)
+      continue;
+    iov[count].iov_base =
+        const_cast<char*>(data_frame->data + data_frame->index);
+    iov[count].iov_len = data_frame->size - data_frame->index;
+    ++count;
+  }
+  if (output_list_.size() <= count)
+    flags &= ~MSG_MORE;
+  else
+    flags |= MSG_MORE;
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = count;
+  return sendmsg(fd_, &msg, flags);
+}
+
+void SMConnection::ConsumeOutput(size_t bytes) {
+  while (!output_list_.empty()) {
+    DataFrame* data_frame = output_list_.front();
+    size_t left = data_frame->size - data_frame->index;
+    if (bytes < left) {
+      data_frame->index += bytes;
+      return;
+    }
+    bytes -= left;
+    output_list_.pop_front();
+    delete data_frame;
+  }
+  DCHECK_EQ(0u, bytes);
+}
+
 void SMConnection::OnRegistration(EpollServer* eps, int fd, int event_mask) {
   registered_in_epoll_server_ = true;
 }
@@ -569,8 +619,13 @@ bool SMConnection::DoWrite() {
               << ": Adding MSG_MORE flag";
       flags |= MSG_MORE;
     }
-    VLOG(2) << log_prefix_ << "Attempting to send " << size << " bytes.";
-    ssize_t bytes_written = Send(bytes, size, flags);
+    ssize_t bytes_written;
+    if (ssl_) {
+      VLOG(2) << log_prefix_ << "Attempting to send " << size << " bytes.";
+      bytes_written = Send(bytes, size, flags);
+    } else {
+      bytes_written = SendOutputList(flags);
+    }
     int stored_errno = errno;
     if (bytes_written == -1) {
       switch (stored_errno) {
@@ -592,7 +647,7 @@ bool SMConnection::DoWrite() {
     } else if (bytes_written > 0) {
       VLOG(2) << log_prefix_ << ACCEPTOR_CLIENT_IDENT << "Wrote: "
               << bytes_written << " bytes";
-      data_frame->index += bytes_written;
+      ConsumeOutput(bytes_written);
       bytes_sent += bytes_written;
       continue;
     } else if (bytes_written == -2) {
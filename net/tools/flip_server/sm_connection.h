@@ -107,6 +107,11 @@ class SMConnection : public SMConnectionInterface,
 
   bool DoRead();
   bool DoWrite();
+  // Writes as many of the frames at the front of |output_list_| as fit in
+  // one writev, for connections without SSL.  Returns what sendmsg returns.
+  ssize_t SendOutputList(int flags);
+  // Marks |bytes| of |output_list_| as sent, deleting the finished frames.
+  void ConsumeOutput(size_t bytes);
   bool DoConsumeReadData();
   void Reset();
 
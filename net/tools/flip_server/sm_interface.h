@@ -46,8 +46,11 @@ class SMInterface {
 
   virtual int PostAcceptHook() = 0;
 
+  // |avail_dictionary| is the Avail-Dictionary header of the request, which
+  // lists the SDCH dictionaries the client has.
   virtual void NewStream(uint32 stream_id, uint32 priority,
-                         const std::string& filename) = 0;
+                         const std::string& filename,
+                         const std::string& avail_dictionary) = 0;
   virtual void SendEOF(uint32 stream_id) = 0;
   virtual void SendErrorNotFound(uint32 stream_id) = 0;
   virtual size_t SendSynStream(uint32 stream_id,
@@ -190,10 +190,14 @@ int SpdySM::SpdyHandleNewStream(const SpdyControlFrame* frame,
     VLOG(1) << ACCEPTOR_CLIENT_IDENT << "Request: " << method->second
             << " " << uri;
     std::string filename = EncodeURL(uri, host, method->second);
+    SpdyHeaderBlock::iterator avail_dictionary =
+        headers.find("avail-dictionary");
     NewStream(syn_stream->stream_id(),
               reinterpret_cast<const SpdySynStreamControlFrame*>
                   (frame)->priority(),
-              filename);
+              filename,
+              avail_dictionary == headers.end() ? std::string() :
+                                                  avail_dictionary->second);
   } else {
     SpdyHeaderBlock::iterator version = headers.find("version");
     http_data += method->second + " " + uri + " " + version->second + "\r\n";
@@ -358,12 +362,13 @@ int SpdySM::PostAcceptHook() {
 
 void SpdySM::NewStream(uint32 stream_id,
                        uint32 priority,
-                       const std::string& filename) {
+                       const std::string& filename,
+                       const std::string& avail_dictionary) {
   MemCacheIter mci;
   mci.stream_id = stream_id;
   mci.priority = priority;
   if (acceptor_->flip_handler_type_ == FLIP_HANDLER_SPDY_SERVER) {
-    if (!memory_cache_->AssignFileData(filename, &mci)) {
+    if (!memory_cache_->AssignFileData(filename, avail_dictionary, &mci)) {
       // error creating new stream.
       VLOG(1) << ACCEPTOR_CLIENT_IDENT << "Sending ErrorNotFound";
       SendErrorNotFound(stream_id);
@@ -562,7 +567,7 @@ void SpdySM::GetOutput() {
         // this is a server initiated stream.
         // Ideally, we'd do a 'syn-push' here, instead of a syn-reply.
         BalsaHeaders headers;
-        headers.CopyFrom(*(mci->file_data->headers));
+        headers.CopyFrom(mci->headers());
         headers.ReplaceOrAppendHeader("status", "200");
         headers.ReplaceOrAppendHeader("version", "http/1.1");
         headers.SetRequestFirstlineFromStringPieces("PUSH",
@@ -571,34 +576,34 @@ void SpdySM::GetOutput() {
         mci->bytes_sent = SendSynStream(mci->stream_id, headers);
       } else {
         BalsaHeaders headers;
-        headers.CopyFrom(*(mci->file_data->headers));
+        headers.CopyFrom(mci->headers());
         mci->bytes_sent = SendSynReply(mci->stream_id, headers);
       }
       return;
     }
-    if (mci->body_bytes_consumed >= mci->file_data->body.size()) {
+    if (mci->body_bytes_consumed >= mci->body().size()) {
       VLOG(2) << ACCEPTOR_CLIENT_IDENT << "SpdySM: GetOutput "
               << "remove_stream_id: [" << mci->stream_id << "]";
       SendEOF(mci->stream_id);
       return;
     }
     size_t num_to_write =
-      mci->file_data->body.size() - mci->body_bytes_consumed;
+      mci->body().size() - mci->body_bytes_consumed;
     if (num_to_write > mci->max_segment_size)
       num_to_write = mci->max_segment_size;
 
     bool should_compress = false;
-    if (!mci->file_data->headers->HasHeader("content-encoding")) {
-      if (mci->file_data->headers->HasHeader("content-type")) {
+    if (!mci->headers().HasHeader("content-encoding")) {
+      if (mci->headers().HasHeader("content-type")) {
         std::string content_type =
-            mci->file_data->headers->GetHeader("content-type").as_string();
+            mci->headers().GetHeader("content-type").as_string();
         if (content_type.find("image") == content_type.npos)
           should_compress = true;
       }
     }
 
     SendDataFrame(mci->stream_id,
-                  mci->file_data->body.data() + mci->body_bytes_consumed,
+                  mci->body().data() + mci->body_bytes_consumed,
                   num_to_write, 0, should_compress);
     VLOG(2) << ACCEPTOR_CLIENT_IDENT << "SpdySM: GetOutput SendDataFrame["
             << mci->stream_id << "]: " << num_to_write;
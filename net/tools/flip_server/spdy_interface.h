@@ -89,7 +89,8 @@ class SpdySM : public spdy::SpdyFramerVisitorInterface,
   virtual int PostAcceptHook();
   virtual void NewStream(uint32 stream_id,
                          uint32 priority,
-                         const std::string& filename);
+                         const std::string& filename,
+                         const std::string& avail_dictionary);
   void AddToOutputOrder(const MemCacheIter& mci);
   virtual void SendEOF(uint32 stream_id);
   virtual void SendErrorNotFound(uint32 stream_id);
@@ -4,12 +4,36 @@
 
 #include "net/tools/flip_server/spdy_ssl.h"
 
+#include <vector>
+
 #include "base/logging.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/platform_thread.h"
 #include "openssl/err.h"
 #include "openssl/ssl.h"
 
 namespace net {
 
+namespace {
+
+// The locks OpenSSL asks for, so that acceptor threads can use it at the same
+// time.  Created by the first InitSSL() and never freed.
+std::vector<base::Lock*>* g_ssl_locks = NULL;
+
+void SSLLockingCallback(int mode, int n, const char* file, int line) {
+  CHECK_LT(static_cast<size_t>(n), g_ssl_locks->size());
+  if (mode & CRYPTO_LOCK)
+    (*g_ssl_locks)[n]->Acquire();
+  else
+    (*g_ssl_locks)[n]->Release();
+}
+
+unsigned long SSLThreadId() {
+  return static_cast<unsigned long>(base::PlatformThread::CurrentId());
+}
+
+}  // namespace
+
 #define NEXT_PROTO_STRING "\x06spdy/2\x08http/1.1\x08http/1.0"
 #define SSL_CIPHER_LIST "!aNULL:!ADH:!eNull:!LOW:!EXP:RC4+RSA:MEDIUM:HIGH"
 
@@ -35,6 +59,15 @@ void InitSSL(SSLState* state,
   SSL_load_error_strings();
   PrintSslError();
 
+  // Only called on the main thread, before the acceptor threads start.
+  if (!g_ssl_locks) {
+    g_ssl_locks = new std::vector<base::Lock*>(CRYPTO_num_locks());
+    for (size_t i = 0; i < g_ssl_locks->size(); ++i)
+      (*g_ssl_locks)[i] = new base::Lock;
+    CRYPTO_set_locking_callback(SSLLockingCallback);
+    CRYPTO_set_id_callback(SSLThreadId);
+  }
+
   state->ssl_method = SSLv23_method();
   state->ssl_ctx = SSL_CTX_new(state->ssl_method);
   if (!state->ssl_ctx) {
@@ -53,7 +53,8 @@ class StreamerSM : public BalsaVisitorInterface,
   virtual void Cleanup();
   virtual int PostAcceptHook();
   virtual void NewStream(uint32 stream_id, uint32 priority,
-                         const std::string& filename) {}
+                         const std::string& filename,
+                         const std::string& avail_dictionary) {}
   virtual void SendEOF(uint32 stream_id) {}
   virtual void SendErrorNotFound(uint32 stream_id) {}
   virtual void SendOKResponse(uint32 stream_id, std::string output) {}
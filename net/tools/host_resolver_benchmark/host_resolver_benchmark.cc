@@ -0,0 +1,582 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This command-line program drives a HostResolverImpl with many resolutions
+// in flight at the same time, and prints the throughput, the latency
+// distribution and the time the requests spent queued in the job pool as a
+// single line of JSON, so that the numbers of different builds or settings
+// can be compared.
+//
+// By default the lookups are answered by a synthetic resolver procedure that
+// sleeps for a random time, so that runs don't depend on the network. With
+// --system, the real system resolver is used instead, and the names are read
+// from --hosts-file.
+//
+// A typical run looks like:
+//
+//   host_resolver_benchmark --requests=100000 --in-flight=2000 --max-jobs=8
+//
+// See Help() for the full list of options.
+
+#include <math.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/command_line.h"
+#include "base/compiler_specific.h"
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/rand_util.h"
+#include "base/string_number_conversions.h"
+#include "base/string_split.h"
+#include "base/string_util.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/lock.h"
+#include "base/task.h"
+#include "base/threading/platform_thread.h"
+#include "base/time.h"
+#include "net/base/address_list.h"
+#include "net/base/completion_callback.h"
+#include "net/base/host_cache.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/host_resolver_impl.h"
+#include "net/base/host_resolver_proc.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_log.h"
+#include "net/base/net_util.h"
+
+using base::TimeDelta;
+using base::TimeTicks;
+
+namespace {
+
+const char kCacheSize[] = "cache-size";
+const char kCacheTtl[] = "cache-ttl";
+const char kFailurePercent[] = "failure-percent";
+const char kHosts[] = "hosts";
+const char kHostsFile[] = "hosts-file";
+const char kIdlePercent[] = "idle-percent";
+const char kInFlight[] = "in-flight";
+const char kLatency[] = "latency";
+const char kLatencyMs[] = "latency-ms";
+const char kMaxJobs[] = "max-jobs";
+const char kMissPercent[] = "miss-percent";
+const char kRequests[] = "requests";
+const char kSystem[] = "system";
+const char kZipfSkew[] = "zipf-skew";
+
+enum Errors {
+  ALL_GOOD = 0,
+  INVALID_ARGUMENT = 1
+};
+
+struct Options {
+  std::vector<std::string> hostnames;
+  std::string latency;
+  bool system;
+  int num_hosts;
+  int num_requests;
+  int in_flight;
+  int max_jobs;
+  int cache_size;
+  int cache_ttl;
+  int miss_percent;
+  int idle_percent;
+  int failure_percent;
+  int latency_ms;
+  double zipf_skew;
+};
+
+int Help() {
+  printf("host_resolver_benchmark [options]\n");
+  printf("--requests=n: number of resolutions to time (50000)\n");
+  printf("--in-flight=n: maximum number of concurrent resolutions (1000)\n");
+  printf("--max-jobs=n: maximum number of concurrent lookups (8)\n");
+  printf("--hosts=n: number of different popular names (10000)\n");
+  printf("--zipf-skew=s: skew of the name popularity (0.99)\n");
+  printf("--miss-percent=n: percentage of names never seen before (10)\n");
+  printf("--idle-percent=n: percentage of speculative IDLE requests (0)\n");
+  printf("--cache-size=n: maximum number of cache entries (1000)\n");
+  printf("--cache-ttl=seconds: lifetime of the cache entries (60)\n");
+  printf("--latency=fixed|uniform|exponential: distribution of the\n"
+         "    synthetic lookup time (exponential)\n");
+  printf("--latency-ms=n: mean synthetic lookup time (20)\n");
+  printf("--failure-percent=n: percentage of failed synthetic lookups (0)\n");
+  printf("--system: use the system resolver instead of the synthetic one\n");
+  printf("--hosts-file=path: popular names to use, one per line; required\n"
+         "    with --system\n");
+  return INVALID_ARGUMENT;
+}
+
+bool GetIntSwitch(const CommandLine& command_line, const char* name,
+                  int* value) {
+  if (!command_line.HasSwitch(name))
+    return true;
+  return base::StringToInt(command_line.GetSwitchValueASCII(name), value) &&
+         *value >= 0;
+}
+
+bool ReadHostsFile(const FilePath& path, std::vector<std::string>* names) {
+  std::string contents;
+  if (!file_util::ReadFileToString(path, &contents))
+    return false;
+  std::vector<std::string> lines;
+  base::SplitString(contents, '\n', &lines);
+  for (size_t i = 0; i < lines.size(); ++i) {
+    std::string name;
+    TrimWhitespaceASCII(lines[i], TRIM_ALL, &name);
+    if (!name.empty() && name[0] != '#')
+      names->push_back(name);
+  }
+  return !names->empty();
+}
+
+bool ParseOptions(const CommandLine& command_line, Options* options) {
+  options->latency = "exponential";
+  options->system = command_line.HasSwitch(kSystem);
+  options->num_hosts = 10000;
+  options->num_requests = 50000;
+  options->in_flight = 1000;
+  options->max_jobs = 8;
+  options->cache_size = 1000;
+  options->cache_ttl = 60;
+  options->miss_percent = 10;
+  options->idle_percent = 0;
+  options->failure_percent = 0;
+  options->latency_ms = 20;
+  options->zipf_skew = 0.99;
+
+  if (command_line.HasSwitch(kLatency))
+    options->latency = command_line.GetSwitchValueASCII(kLatency);
+  if (options->latency != "fixed" && options->latency != "uniform" &&
+      options->latency != "exponential") {
+    return false;
+  }
+
+  if (!GetIntSwitch(command_line, kHosts, &options->num_hosts) ||
+      !GetIntSwitch(command_line, kRequests, &options->num_requests) ||
+      !GetIntSwitch(command_line, kInFlight, &options->in_flight) ||
+      !GetIntSwitch(command_line, kMaxJobs, &options->max_jobs) ||
+      !GetIntSwitch(command_line, kCacheSize, &options->cache_size) ||
+      !GetIntSwitch(command_line, kCacheTtl, &options->cache_ttl) ||
+      !GetIntSwitch(command_line, kMissPercent, &options->miss_percent) ||
+      !GetIntSwitch(command_line, kIdlePercent, &options->idle_percent) ||
+      !GetIntSwitch(command_line, kFailurePercent,
+                    &options->failure_percent) ||
+      !GetIntSwitch(command_line, kLatencyMs, &options->latency_ms)) {
+    return false;
+  }
+
+  if (command_line.HasSwitch(kZipfSkew) &&
+      (!base::StringToDouble(command_line.GetSwitchValueASCII(kZipfSkew),
+                             &options->zipf_skew) ||
+       options->zipf_skew < 0)) {
+    return false;
+  }
+
+  if (command_line.HasSwitch(kHostsFile)) {
+    if (!ReadHostsFile(command_line.GetSwitchValuePath(kHostsFile),
+                       &options->hostnames)) {
+      return false;
+    }
+    options->num_hosts = static_cast<int>(options->hostnames.size());
+  } else if (options->system) {
+    return false;
+  } else {
+    for (int i = 0; i < options->num_hosts; i++) {
+      options->hostnames.push_back(
+          base::StringPrintf("host%d.benchmark.test", i));
+    }
+  }
+
+  return options->num_hosts > 0 && options->in_flight > 0 &&
+         options->max_jobs > 0 && options->miss_percent <= 100 &&
+         options->idle_percent <= 100 && options->failure_percent <= 100;
+}
+
+// Answers every lookup after sleeping for a random time, with an address
+// derived from the name.
+class SyntheticHostResolverProc : public net::HostResolverProc {
+ public:
+  explicit SyntheticHostResolverProc(const Options& options)
+      : net::HostResolverProc(NULL),
+        latency_(options.latency),
+        latency_ms_(options.latency_ms),
+        failure_percent_(options.failure_percent) {
+  }
+
+  virtual int Resolve(const std::string& host,
+                      net::AddressFamily address_family,
+                      net::HostResolverFlags host_resolver_flags,
+                      net::AddressList* addrlist,
+                      int* os_error) {
+    base::PlatformThread::Sleep(GetLatencyMs());
+    if (base::RandInt(0, 99) < failure_percent_)
+      return net::ERR_NAME_NOT_RESOLVED;
+
+    uint32 hash = 0;
+    for (size_t i = 0; i < host.size(); ++i)
+      hash = hash * 31 + static_cast<unsigned char>(host[i]);
+    net::IPAddressNumber address;
+    address.push_back(10);
+    address.push_back(static_cast<unsigned char>(hash >> 16));
+    address.push_back(static_cast<unsigned char>(hash >> 8));
+    address.push_back(static_cast<unsigned char>(hash));
+    *addrlist = net::AddressList(address, 0, false);
+    return net::OK;
+  }
+
+ private:
+  virtual ~SyntheticHostResolverProc() {}
+
+  int GetLatencyMs() const {
+    if (latency_ == "fixed")
+      return latency_ms_;
+    if (latency_ == "uniform")
+      return base::RandInt(0, 2 * latency_ms_);
+    // Exponential.
+    return static_cast<int>(-latency_ms_ * log(1 - base::RandDouble()));
+  }
+
+  const std::string latency_;
+  const int latency_ms_;
+  const int failure_percent_;
+
+  DISALLOW_COPY_AND_ASSIGN(SyntheticHostResolverProc);
+};
+
+// Measures the time the requests spend in the job pool queue, from the
+// HOST_RESOLVER_IMPL_JOB_POOL_QUEUE events. The events may come from any
+// thread.
+class QueueTimeNetLog : public net::NetLog {
+ public:
+  QueueTimeNetLog() : next_id_(0) {}
+
+  virtual void AddEntry(EventType type,
+                        const TimeTicks& time,
+                        const Source& source,
+                        EventPhase phase,
+                        EventParameters* params) {
+    if (type != TYPE_HOST_RESOLVER_IMPL_JOB_POOL_QUEUE)
+      return;
+
+    base::AutoLock lock(lock_);
+    if (phase == PHASE_BEGIN) {
+      // See net_log_event_type_list.h for the parameters.
+      int priority =
+          static_cast<net::NetLogIntegerParameter*>(params)->value();
+      queued_[source.id] = std::make_pair(time, priority);
+      return;
+    }
+
+    std::map<uint32, std::pair<TimeTicks, int> >::iterator it =
+        queued_.find(source.id);
+    if (it == queued_.end())
+      return;
+    // Evicted and cancelled requests end the event without parameters.
+    if (phase == PHASE_END && params) {
+      int64 queue_time = (time - it->second.first).InMicroseconds();
+      queue_times_[it->second.second == net::IDLE].push_back(queue_time);
+    }
+    queued_.erase(it);
+  }
+
+  virtual uint32 NextID() {
+    base::AutoLock lock(lock_);
+    return next_id_++;
+  }
+
+  virtual LogLevel GetLogLevel() const {
+    return LOG_BASIC;
+  }
+
+  // Returns the queue times of the non IDLE requests, or of the IDLE ones,
+  // in microseconds.
+  std::vector<int64> GetQueueTimes(bool idle) {
+    base::AutoLock lock(lock_);
+    return queue_times_[idle];
+  }
+
+ private:
+  base::Lock lock_;
+  uint32 next_id_;
+  std::map<uint32, std::pair<TimeTicks, int> > queued_;
+  std::vector<int64> queue_times_[2];
+
+  DISALLOW_COPY_AND_ASSIGN(QueueTimeNetLog);
+};
+
+// Returns names following a Zipf distribution: the name with rank k is picked
+// with a probability proportional to 1 / k^skew.
+class NameGenerator {
+ public:
+  NameGenerator(const std::vector<std::string>& names, double skew)
+      : names_(names), cdf_(names.size()), next_miss_(0) {
+    double sum = 0;
+    for (size_t i = 0; i < cdf_.size(); i++) {
+      sum += 1.0 / pow(static_cast<double>(i + 1), skew);
+      cdf_[i] = sum;
+    }
+    for (size_t i = 0; i < cdf_.size(); i++)
+      cdf_[i] /= sum;
+  }
+
+  std::string GetPopularName() const {
+    double value = base::RandDouble();
+    std::vector<double>::const_iterator it =
+        std::lower_bound(cdf_.begin(), cdf_.end(), value);
+    if (it == cdf_.end())
+      return names_.back();
+    return names_[it - cdf_.begin()];
+  }
+
+  // Returns a name that wasn't handed out before.
+  std::string GetNewName() {
+    return base::StringPrintf("miss%d.benchmark.invalid", next_miss_++);
+  }
+
+ private:
+  const std::vector<std::string>& names_;
+  std::vector<double> cdf_;
+  int next_miss_;
+
+  DISALLOW_COPY_AND_ASSIGN(NameGenerator);
+};
+
+class Worker;
+
+// Controls a run of the benchmark: hands out requests to the workers, and
+// collects the results.
+class Benchmark {
+ public:
+  Benchmark(const Options& options, net::HostResolver* resolver);
+  ~Benchmark();
+
+  // Runs the timed part of the benchmark.
+  void Run();
+
+  // Returns false if there are no more requests to make.
+  bool GetNextRequest(net::HostResolver::RequestInfo* info);
+
+  // Records the completion of a request. The requests that succeed
+  // synchronously were answered from the cache.
+  void OnRequestDone(int result, bool synchronous, TimeDelta latency);
+
+  // Notification from a worker that has nothing else to do.
+  void OnWorkerIdle();
+
+  // Prints the results of the last run.
+  void PrintResults(QueueTimeNetLog* net_log) const;
+
+  net::HostResolver* resolver() { return resolver_; }
+
+ private:
+  void StartWorkers();
+
+  const Options& options_;
+  net::HostResolver* resolver_;
+  NameGenerator names_;
+  std::vector<Worker*> workers_;
+  int next_request_;
+  int idle_workers_;
+  int failures_;
+  TimeDelta elapsed_;
+  std::vector<int64> hit_latencies_;  // In microseconds.
+  std::vector<int64> miss_latencies_;  // In microseconds.
+};
+
+// Makes one request at a time, until the benchmark runs out of them.
+class Worker {
+ public:
+  explicit Worker(Benchmark* benchmark)
+      : benchmark_(benchmark),
+        info_(net::HostPortPair("", 80)),
+        ALLOW_THIS_IN_INITIALIZER_LIST(
+            callback_(this, &Worker::OnResolveComplete)) {
+  }
+
+  void Start() {
+    // Requests that complete synchronously are answered from the cache, so
+    // loop instead of recursing.
+    while (benchmark_->GetNextRequest(&info_)) {
+      start_ = TimeTicks::HighResNow();
+      int rv = benchmark_->resolver()->Resolve(info_, &addresses_, &callback_,
+                                               NULL, net::BoundNetLog());
+      if (rv == net::ERR_IO_PENDING)
+        return;
+      benchmark_->OnRequestDone(rv, true, TimeTicks::HighResNow() - start_);
+    }
+    benchmark_->OnWorkerIdle();
+  }
+
+ private:
+  void OnResolveComplete(int result) {
+    benchmark_->OnRequestDone(result, false,
+                              TimeTicks::HighResNow() - start_);
+    Start();
+  }
+
+  Benchmark* benchmark_;
+  net::HostResolver::RequestInfo info_;
+  net::AddressList addresses_;
+  TimeTicks start_;
+  net::CompletionCallbackImpl<Worker> callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(Worker);
+};
+
+Benchmark::Benchmark(const Options& options, net::HostResolver* resolver)
+    : options_(options),
+      resolver_(resolver),
+      names_(options.hostnames, options.zipf_skew),
+      next_request_(0),
+      idle_workers_(0),
+      failures_(0) {
+  for (int i = 0; i < options.in_flight; i++)
+    workers_.push_back(new Worker(this));
+}
+
+Benchmark::~Benchmark() {
+  for (size_t i = 0; i < workers_.size(); i++)
+    delete workers_[i];
+}
+
+void Benchmark::Run() {
+  TimeTicks start = TimeTicks::HighResNow();
+  // The workers may finish without going back to the message loop when
+  // everything is cached, so they are started from a task.
+  MessageLoop::current()->PostTask(
+      FROM_HERE, NewRunnableMethod(this, &Benchmark::StartWorkers));
+  MessageLoop::current()->Run();
+  elapsed_ = TimeTicks::HighResNow() - start;
+}
+
+bool Benchmark::GetNextRequest(net::HostResolver::RequestInfo* info) {
+  if (next_request_ >= options_.num_requests)
+    return false;
+  next_request_++;
+
+  std::string hostname = base::RandInt(0, 99) < options_.miss_percent ?
+      names_.GetNewName() : names_.GetPopularName();
+  *info = net::HostResolver::RequestInfo(net::HostPortPair(hostname, 80));
+  if (base::RandInt(0, 99) < options_.idle_percent) {
+    info->set_priority(net::IDLE);
+    info->set_is_speculative(true);
+  }
+  return true;
+}
+
+void Benchmark::OnRequestDone(int result, bool synchronous,
+                              TimeDelta latency) {
+  if (result != net::OK)
+    failures_++;
+  if (synchronous && result == net::OK)
+    hit_latencies_.push_back(latency.InMicroseconds());
+  else
+    miss_latencies_.push_back(latency.InMicroseconds());
+}
+
+void Benchmark::OnWorkerIdle() {
+  idle_workers_++;
+  if (idle_workers_ == static_cast<int>(workers_.size()))
+    MessageLoop::current()->Quit();
+}
+
+void Benchmark::StartWorkers() {
+  for (size_t i = 0; i < workers_.size(); i++)
+    workers_[i]->Start();
+}
+
+// Returns the percentiles of |values| as a JSON object.
+std::string LatencyStats(std::vector<int64> values) {
+  if (values.empty())
+    return "{\"count\": 0}";
+
+  std::sort(values.begin(), values.end());
+  size_t count = values.size();
+  return base::StringPrintf(
+      "{\"count\": %u, \"p50\": %lld, \"p90\": %lld, \"p99\": %lld, "
+      "\"p999\": %lld, \"max\": %lld}",
+      static_cast<unsigned>(count),
+      static_cast<long long>(values[count * 50 / 100]),
+      static_cast<long long>(values[count * 90 / 100]),
+      static_cast<long long>(values[count * 99 / 100]),
+      static_cast<long long>(values[count * 999 / 1000]),
+      static_cast<long long>(values[count - 1]));
+}
+
+void Benchmark::PrintResults(QueueTimeNetLog* net_log) const {
+  std::vector<int64> all(hit_latencies_);
+  all.insert(all.end(), miss_latencies_.begin(), miss_latencies_.end());
+  std::vector<int64> queued(net_log->GetQueueTimes(false));
+  std::vector<int64> queued_idle(net_log->GetQueueTimes(true));
+  std::vector<int64> queued_all(queued);
+  queued_all.insert(queued_all.end(), queued_idle.begin(), queued_idle.end());
+
+  double seconds = elapsed_.InMillisecondsF() / 1000;
+  double throughput = seconds > 0 ? all.size() / seconds : 0;
+
+  printf("{\"resolver\": \"%s\", \"hosts\": %d, \"in_flight\": %d, "
+         "\"max_jobs\": %d, \"requests\": %u, \"seconds\": %.3f, "
+         "\"requests_per_sec\": %.1f, \"cache_hits\": %u, \"failures\": %d, "
+         "\"latency_us\": {\"all\": %s, \"hit\": %s, \"miss\": %s}, "
+         "\"queue_us\": {\"all\": %s, \"normal\": %s, \"idle\": %s}}\n",
+         options_.system ? "system" : "synthetic", options_.num_hosts,
+         options_.in_flight, options_.max_jobs,
+         static_cast<unsigned>(all.size()), seconds, throughput,
+         static_cast<unsigned>(hit_latencies_.size()), failures_,
+         LatencyStats(all).c_str(), LatencyStats(hit_latencies_).c_str(),
+         LatencyStats(miss_latencies_).c_str(),
+         LatencyStats(queued_all).c_str(), LatencyStats(queued).c_str(),
+         LatencyStats(queued_idle).c_str());
+}
+
+}  // namespace
+
+// The benchmark outlives all the tasks posted to it.
+DISABLE_RUNNABLE_METHOD_REFCOUNT(Benchmark);
+
+int main(int argc, const char* argv[]) {
+  // Setup an AtExitManager so Singleton objects will be destroyed.
+  base::AtExitManager at_exit_manager;
+  MessageLoop message_loop(MessageLoop::TYPE_IO);
+
+  CommandLine::Init(argc, argv);
+  const CommandLine& command_line = *CommandLine::ForCurrentProcess();
+
+  Options options;
+  if (!ParseOptions(command_line, &options))
+    return Help();
+
+  scoped_refptr<net::HostResolverProc> resolver_proc;
+  if (!options.system)
+    resolver_proc = new SyntheticHostResolverProc(options);
+
+  QueueTimeNetLog net_log;
+  {
+    // Failures are not cached, as with the default cache.
+    net::HostResolverImpl resolver(
+        resolver_proc,
+        new net::HostCache(options.cache_size,
+                           TimeDelta::FromSeconds(options.cache_ttl),
+                           TimeDelta()),
+        options.max_jobs, &net_log);
+    // Let every request wait in the queue rather than fail.
+    resolver.SetPoolConstraints(net::HostResolverImpl::POOL_NORMAL,
+                                options.max_jobs, options.num_requests);
+
+    Benchmark benchmark(options, &resolver);
+    benchmark.Run();
+    benchmark.PrintResults(&net_log);
+  }
+
+  return ALL_GOOD;
+}
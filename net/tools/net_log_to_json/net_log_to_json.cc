@@ -0,0 +1,64 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This command-line program converts a log written with
+// --log-net-log-binary to the format written by --log-net-log: one JSON
+// entry per line, which about:net-internals can load.
+//
+//   net_log_to_json <binary log> [<output file>]
+//
+// Without an output file, the entries are written to stdout.
+
+#include <stdio.h>
+
+#include <string>
+
+#include "base/at_exit.h"
+#include "base/command_line.h"
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "net/base/net_log_binary.h"
+
+namespace {
+
+int Usage() {
+  fprintf(stderr, "Usage: net_log_to_json <binary log> [<output file>]\n");
+  return 1;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  base::AtExitManager at_exit_manager;
+  CommandLine::Init(argc, argv);
+  const CommandLine::StringVector& args =
+      CommandLine::ForCurrentProcess()->args();
+  if (args.empty() || args.size() > 2)
+    return Usage();
+
+  std::string data;
+  if (!file_util::ReadFileToString(FilePath(args[0]), &data)) {
+    fprintf(stderr, "Can't read the log.\n");
+    return 1;
+  }
+
+  // Even a log which ends with an error, such as one cut short by a crash,
+  // has the entries before it converted.
+  std::string json;
+  bool valid = net::ConvertNetLogBinaryToJSON(data, &json);
+  if (!valid)
+    fprintf(stderr, "The log is invalid after %d bytes of JSON.\n",
+            static_cast<int>(json.size()));
+
+  if (args.size() == 2) {
+    int size = static_cast<int>(json.size());
+    if (file_util::WriteFile(FilePath(args[1]), json.data(), size) != size) {
+      fprintf(stderr, "Can't write the output file.\n");
+      return 1;
+    }
+  } else {
+    fwrite(json.data(), 1, json.size(), stdout);
+  }
+  return valid ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+#!/usr/bin/python
+# Copyright (c) 2011 The Chromium Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+"""Compiles the rules of an effective-TLD .gperf file into a DAFSA.
+
+Usage: make_dafsa.py <input.gperf> <output.cc>
+
+The rules are stored reversed, so that RegistryControlledDomainService can
+match every registry suffix of a host in a single walk from the end of the
+host.  The reversed rules form a trie; chains of nodes with one child and no
+rule are collapsed into multi-character edges, and identical subtrees are
+merged, which turns the trie into a directed acyclic graph.
+
+The graph is written as a byte array.  Each node is laid out as:
+
+  value        1 byte: 0 if no rule ends here, otherwise 1 + the rule type
+               (0: normal, 1: exception, 2: wildcard).
+  edge count   1 byte.
+  edge index   for each edge, in order of their first character:
+    character  1 byte, the first character of the edge.
+    edge       3 bytes, the big-endian offset of the edge.
+
+No two edges of a node start with the same character, so the index can be
+binary searched.  Each edge is laid out as:
+
+  length       1 byte, the number of characters on the edge.
+  characters   the characters, in the order a walk from the end of the host
+               consumes them.
+  child        3 bytes, the big-endian offset of the node the edge leads to.
+
+The root node is at offset 0.
+"""
+
+import sys
+
+
+def ReadRules(path):
+  """Returns a list of (name, type) from the rules section of a .gperf file."""
+  rules = []
+  in_rules = False
+  for line in open(path):
+    line = line.rstrip('\n')
+    if line == '%%':
+      if in_rules:
+        break
+      in_rules = True
+      continue
+    if not in_rules or not line:
+      continue
+    name, rule_type = line.rsplit(',', 1)
+    rules.append((name.strip(), int(rule_type)))
+  return rules
+
+
+class Node(object):
+  def __init__(self):
+    self.value = None
+    self.children = {}
+
+
+def BuildTrie(rules):
+  root = Node()
+  for name, rule_type in rules:
+    node = root
+    for char in reversed(name):
+      node = node.children.setdefault(char, Node())
+    assert node.value is None, 'Duplicate rule: ' + name
+    node.value = rule_type
+  return root
+
+
+def Compress(node, nodes, ids):
+  """Returns the id of the unique node equal to |node|, with chains collapsed.
+
+  |nodes| is the list of unique nodes, each a (value, edges) tuple where edges
+  is a tuple of (label, child id).  |ids| maps those tuples to their index.
+  """
+  edges = []
+  for char in sorted(node.children):
+    label = char
+    child = node.children[char]
+    while child.value is None and len(child.children) == 1:
+      next_char = list(child.children)[0]
+      label += next_char
+      child = child.children[next_char]
+    edges.append((label, Compress(child, nodes, ids)))
+  key = (node.value, tuple(edges))
+  if key not in ids:
+    ids[key] = len(nodes)
+    nodes.append(key)
+  return ids[key]
+
+
+def EdgeSize(label):
+  return 1 + len(label) + 3
+
+
+def NodeSize(node):
+  value, edges = node
+  return 2 + sum([4 + EdgeSize(label) for label, child in edges])
+
+
+def AppendOffset(output, offset):
+  output.extend([(offset >> 16) & 0xff, (offset >> 8) & 0xff, offset & 0xff])
+
+
+def Encode(root, nodes):
+  """Returns the bytes of the graph, with |root| first."""
+  # Lay the nodes out with the root first, the rest in the order they were
+  # found, which keeps children close to their parents.
+  order = [root] + [i for i in range(len(nodes)) if i != root]
+  offsets = {}
+  size = 0
+  for i in order:
+    offsets[i] = size
+    size += NodeSize(nodes[i])
+  assert size < (1 << 24), 'Graph too large for 3-byte offsets'
+
+  output = []
+  for i in order:
+    value, edges = nodes[i]
+    assert len(edges) < 256
+    if value is None:
+      output.append(0)
+    else:
+      output.append(1 + value)
+    output.append(len(edges))
+    # The edges follow the index.
+    edge_offset = offsets[i] + 2 + 4 * len(edges)
+    for label, child in edges:
+      output.append(ord(label[0]))
+      AppendOffset(output, edge_offset)
+      edge_offset += EdgeSize(label)
+    for label, child in edges:
+      assert len(label) < 256
+      output.append(len(label))
+      output.extend([ord(char) for char in label])
+      AppendOffset(output, offsets[child])
+  return output
+
+
+def WriteSource(path, data, source):
+  out = open(path, 'w')
+  out.write('// Copyright (c) 2011 The Chromium Authors. All rights reserved.\n'
+            '// Use of this source code is governed by a BSD-style license '
+            'that can be\n'
+            '// found in the LICENSE file.\n'
+            '\n'
+            '// This file is generated by net/tools/tld_cleanup/make_dafsa.py\n'
+            '// from %s.\n'
+            '// DO NOT MANUALLY EDIT!\n'
+            '\n'
+            '// The effective-TLD rules as a graph; see make_dafsa.py for the '
+            'format.\n'
+            'const unsigned char kDafsa[%d] = {\n' % (source, len(data)))
+  for i in range(0, len(data), 12):
+    out.write('  ' + ' '.join(['0x%02x,' % byte for byte in data[i:i + 12]]) +
+              '\n')
+  out.write('};\n')
+  out.close()
+
+
+def main(argv):
+  if len(argv) != 3:
+    sys.stderr.write(__doc__)
+    return 1
+  rules = ReadRules(argv[1])
+  nodes = []
+  root = Compress(BuildTrie(rules), nodes, {})
+  data = Encode(root, nodes)
+  WriteSource(argv[2], data, argv[1].split('/')[-1])
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main(sys.argv))
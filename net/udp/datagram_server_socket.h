@@ -7,13 +7,27 @@
 #pragma once
 
 #include "net/base/completion_callback.h"
+#include "net/base/ip_endpoint.h"
 #include "net/udp/datagram_socket.h"
 
 namespace net {
 
-class IPEndPoint;
 class IOBuffer;
 
+// One datagram of a RecvMultipleFrom() or SendMultipleTo() batch.
+struct DatagramPacket {
+  DatagramPacket() : buf(NULL), buf_len(0), length(0) {}
+
+  // For reads, |buf_len| is the size of |buf| and |address| receives the
+  // sender.  For writes, |buf_len| bytes of |buf| are sent to |address|.
+  IOBuffer* buf;
+  int buf_len;
+  IPEndPoint address;
+
+  // The number of bytes received into |buf|.  Only set by reads.
+  int length;
+};
+
 // A UDP Socket.
 class DatagramServerSocket : public DatagramSocket {
  public:
@@ -54,6 +68,21 @@ class DatagramServerSocket : public DatagramSocket {
                      int buf_len,
                      const IPEndPoint& address,
                      CompletionCallback* callback) = 0;
+
+  // Batched forms of RecvFrom() and SendTo(), which handle several datagrams
+  // per system call and per wakeup where the platform allows it.
+  // RecvMultipleFrom() fills as many of the |count| |packets| as there are
+  // datagrams waiting (at least one), and SendMultipleTo() sends |packets| in
+  // order until the socket would block.  Both return the number of packets
+  // handled, a net error code, or ERR_IO_PENDING, in which case |callback|
+  // gets that number.  The caller must keep |packets| and their buffers alive
+  // until then.  ERR_NOT_IMPLEMENTED is returned where there is no support.
+  virtual int RecvMultipleFrom(DatagramPacket* packets,
+                               int count,
+                               CompletionCallback* callback) = 0;
+  virtual int SendMultipleTo(DatagramPacket* packets,
+                             int count,
+                             CompletionCallback* callback) = 0;
 };
 
 }  // namespace net
@@ -32,6 +32,18 @@ int UDPServerSocket::SendTo(IOBuffer* buf,
   return socket_.SendTo(buf, buf_len, address, callback);
 }
 
+int UDPServerSocket::RecvMultipleFrom(DatagramPacket* packets,
+                                      int count,
+                                      CompletionCallback* callback) {
+  return socket_.RecvMultipleFrom(packets, count, callback);
+}
+
+int UDPServerSocket::SendMultipleTo(DatagramPacket* packets,
+                                    int count,
+                                    CompletionCallback* callback) {
+  return socket_.SendMultipleTo(packets, count, callback);
+}
+
 void UDPServerSocket::Close() {
   socket_.Close();
 }
@@ -32,6 +32,12 @@ class UDPServerSocket : public DatagramServerSocket {
                      int buf_len,
                      const IPEndPoint& address,
                      CompletionCallback* callback);
+  virtual int RecvMultipleFrom(DatagramPacket* packets,
+                               int count,
+                               CompletionCallback* callback);
+  virtual int SendMultipleTo(DatagramPacket* packets,
+                             int count,
+                             CompletionCallback* callback);
   virtual void Close();
   virtual int GetPeerAddress(IPEndPoint* address) const;
   virtual int GetLocalAddress(IPEndPoint* address) const;
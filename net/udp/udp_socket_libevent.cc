@@ -7,7 +7,14 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <netdb.h>
+#include <string.h>
 #include <sys/socket.h>
+#if defined(OS_LINUX)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
 
 #include "base/eintr_wrapper.h"
 #include "base/logging.h"
@@ -29,6 +36,24 @@
 
 namespace net {
 
+namespace {
+
+// The most datagrams handled by one RecvMultipleFrom() or SendMultipleTo().
+const int kMaxDatagramsPerCall = 64;
+
+#if defined(OS_LINUX) && defined(__NR_recvmmsg) && defined(__NR_sendmmsg)
+#define USE_MMSG_SYSCALLS 1
+
+// struct mmsghdr, which older C libraries don't declare.  The system calls
+// are made through syscall() for the same reason.
+struct MultipleMessageHeader {
+  struct msghdr msg_hdr;
+  unsigned int msg_len;
+};
+#endif
+
+}  // namespace
+
 UDPSocketLibevent::UDPSocketLibevent(net::NetLog* net_log,
                                      const net::NetLog::Source& source)
     : socket_(kInvalidSocket),
@@ -36,7 +61,13 @@ UDPSocketLibevent::UDPSocketLibevent(net::NetLog* net_log,
       write_watcher_(this),
       read_buf_len_(0),
       recv_from_address_(NULL),
+      read_packets_(NULL),
+      read_packet_count_(0),
       write_buf_len_(0),
+      write_packets_(NULL),
+      write_packet_count_(0),
+      recvmmsg_unsupported_(false),
+      sendmmsg_unsupported_(false),
       read_callback_(NULL),
       write_callback_(NULL),
       net_log_(BoundNetLog::Make(net_log, NetLog::SOURCE_SOCKET)) {
@@ -62,10 +93,14 @@ void UDPSocketLibevent::Close() {
   read_buf_len_ = 0;
   read_callback_ = NULL;
   recv_from_address_ = NULL;
+  read_packets_ = NULL;
+  read_packet_count_ = 0;
   write_buf_ = NULL;
   write_buf_len_ = 0;
   write_callback_ = NULL;
   send_to_address_.reset();
+  write_packets_ = NULL;
+  write_packet_count_ = 0;
 
   bool ok = read_socket_watcher_.StopWatchingFileDescriptor();
   DCHECK(ok);
@@ -157,6 +192,32 @@ int UDPSocketLibevent::RecvFrom(IOBuffer* buf,
   return ERR_IO_PENDING;
 }
 
+int UDPSocketLibevent::RecvMultipleFrom(DatagramPacket* packets,
+                                        int count,
+                                        CompletionCallback* callback) {
+  DCHECK(CalledOnValidThread());
+  DCHECK_NE(kInvalidSocket, socket_);
+  DCHECK(!read_callback_);
+  DCHECK(callback);  // Synchronous operation not supported
+  DCHECK_GT(count, 0);
+
+  int nread = InternalRecvMultipleFrom(packets, count);
+  if (nread != ERR_IO_PENDING)
+    return nread;
+
+  if (!MessageLoopForIO::current()->WatchFileDescriptor(
+          socket_, true, MessageLoopForIO::WATCH_READ,
+          &read_socket_watcher_, &read_watcher_)) {
+    PLOG(ERROR) << "WatchFileDescriptor failed on read";
+    return MapSystemError(errno);
+  }
+
+  read_packets_ = packets;
+  read_packet_count_ = count;
+  read_callback_ = callback;
+  return ERR_IO_PENDING;
+}
+
 int UDPSocketLibevent::Write(IOBuffer* buf,
                              int buf_len,
                              CompletionCallback* callback) {
@@ -206,6 +267,32 @@ int UDPSocketLibevent::SendToOrWrite(IOBuffer* buf,
   return ERR_IO_PENDING;
 }
 
+int UDPSocketLibevent::SendMultipleTo(DatagramPacket* packets,
+                                      int count,
+                                      CompletionCallback* callback) {
+  DCHECK(CalledOnValidThread());
+  DCHECK_NE(kInvalidSocket, socket_);
+  DCHECK(!write_callback_);
+  DCHECK(callback);  // Synchronous operation not supported
+  DCHECK_GT(count, 0);
+
+  int nwrite = InternalSendMultipleTo(packets, count);
+  if (nwrite != ERR_IO_PENDING)
+    return nwrite;
+
+  if (!MessageLoopForIO::current()->WatchFileDescriptor(
+          socket_, true, MessageLoopForIO::WATCH_WRITE,
+          &write_socket_watcher_, &write_watcher_)) {
+    DVLOG(1) << "WatchFileDescriptor failed on write, errno " << errno;
+    return MapSystemError(errno);
+  }
+
+  write_packets_ = packets;
+  write_packet_count_ = count;
+  write_callback_ = callback;
+  return ERR_IO_PENDING;
+}
+
 int UDPSocketLibevent::Connect(const IPEndPoint& address) {
   DCHECK(!is_connected());
   DCHECK(!remote_address_.get());
@@ -269,11 +356,17 @@ void UDPSocketLibevent::DoWriteCallback(int rv) {
 }
 
 void UDPSocketLibevent::DidCompleteRead() {
-  int result = InternalRecvFrom(read_buf_, read_buf_len_, recv_from_address_);
+  int result;
+  if (read_packets_)
+    result = InternalRecvMultipleFrom(read_packets_, read_packet_count_);
+  else
+    result = InternalRecvFrom(read_buf_, read_buf_len_, recv_from_address_);
   if (result != ERR_IO_PENDING) {
     read_buf_ = NULL;
     read_buf_len_ = 0;
     recv_from_address_ = NULL;
+    read_packets_ = NULL;
+    read_packet_count_ = 0;
     bool ok = read_socket_watcher_.StopWatchingFileDescriptor();
     DCHECK(ok);
     DoReadCallback(result);
@@ -293,19 +386,26 @@ int UDPSocketLibevent::CreateSocket(const IPEndPoint& address) {
 }
 
 void UDPSocketLibevent::DidCompleteWrite() {
-  int result = InternalSendTo(write_buf_, write_buf_len_,
-                              send_to_address_.get());
-  if (result >= 0) {
-    base::StatsCounter write_bytes("udp.write_bytes");
-    write_bytes.Add(result);
+  int result;
+  if (write_packets_) {
+    result = InternalSendMultipleTo(write_packets_, write_packet_count_);
   } else {
-    result = MapSystemError(errno);
+    result = InternalSendTo(write_buf_, write_buf_len_,
+                            send_to_address_.get());
+    if (result >= 0) {
+      base::StatsCounter write_bytes("udp.write_bytes");
+      write_bytes.Add(result);
+    } else {
+      result = MapSystemError(errno);
+    }
   }
 
   if (result != ERR_IO_PENDING) {
     write_buf_ = NULL;
     write_buf_len_ = 0;
     send_to_address_.reset();
+    write_packets_ = NULL;
+    write_packet_count_ = 0;
     write_socket_watcher_.StopWatchingFileDescriptor();
     DoWriteCallback(result);
   }
@@ -364,4 +464,115 @@ int UDPSocketLibevent::InternalSendTo(IOBuffer* buf, int buf_len,
                              addr_len));
 }
 
+int UDPSocketLibevent::InternalRecvMultipleFrom(DatagramPacket* packets,
+                                                int count) {
+  count = std::min(count, kMaxDatagramsPerCall);
+
+#if defined(USE_MMSG_SYSCALLS)
+  if (!recvmmsg_unsupported_) {
+    struct sockaddr_storage addr_storage[kMaxDatagramsPerCall];
+    struct iovec iov[kMaxDatagramsPerCall];
+    MultipleMessageHeader headers[kMaxDatagramsPerCall];
+    memset(headers, 0, count * sizeof(headers[0]));
+    for (int i = 0; i < count; ++i) {
+      iov[i].iov_base = packets[i].buf->data();
+      iov[i].iov_len = packets[i].buf_len;
+      headers[i].msg_hdr.msg_name = &addr_storage[i];
+      headers[i].msg_hdr.msg_namelen = sizeof(addr_storage[i]);
+      headers[i].msg_hdr.msg_iov = &iov[i];
+      headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int received = HANDLE_EINTR(syscall(__NR_recvmmsg, socket_, headers,
+                                        count, 0, NULL));
+    if (received >= 0) {
+      int bytes = 0;
+      for (int i = 0; i < received; ++i) {
+        packets[i].length = headers[i].msg_len;
+        bytes += headers[i].msg_len;
+        struct sockaddr* addr =
+            reinterpret_cast<struct sockaddr*>(&addr_storage[i]);
+        if (!packets[i].address.FromSockAddr(addr,
+                                             headers[i].msg_hdr.msg_namelen))
+          return ERR_FAILED;
+      }
+      base::StatsCounter read_bytes("udp.read_bytes");
+      read_bytes.Add(bytes);
+      return received;
+    }
+    if (errno != ENOSYS)
+      return MapSystemError(errno);
+    recvmmsg_unsupported_ = true;
+  }
+#endif
+
+  // One recvfrom() per datagram, until there is nothing left to read.  An
+  // error after the first datagram ends the batch; it is reported by the
+  // next read if it persists.
+  int received = 0;
+  while (received < count) {
+    DatagramPacket* packet = &packets[received];
+    int rv = InternalRecvFrom(packet->buf, packet->buf_len, &packet->address);
+    if (rv < 0)
+      return received > 0 ? received : rv;
+    packet->length = rv;
+    ++received;
+  }
+  return received;
+}
+
+int UDPSocketLibevent::InternalSendMultipleTo(DatagramPacket* packets,
+                                              int count) {
+  count = std::min(count, kMaxDatagramsPerCall);
+
+#if defined(USE_MMSG_SYSCALLS)
+  if (!sendmmsg_unsupported_) {
+    struct sockaddr_storage addr_storage[kMaxDatagramsPerCall];
+    struct iovec iov[kMaxDatagramsPerCall];
+    MultipleMessageHeader headers[kMaxDatagramsPerCall];
+    memset(headers, 0, count * sizeof(headers[0]));
+    for (int i = 0; i < count; ++i) {
+      size_t addr_len = sizeof(addr_storage[i]);
+      struct sockaddr* addr =
+          reinterpret_cast<struct sockaddr*>(&addr_storage[i]);
+      if (!packets[i].address.ToSockAddr(addr, &addr_len))
+        return ERR_FAILED;
+      iov[i].iov_base = packets[i].buf->data();
+      iov[i].iov_len = packets[i].buf_len;
+      headers[i].msg_hdr.msg_name = addr;
+      headers[i].msg_hdr.msg_namelen = addr_len;
+      headers[i].msg_hdr.msg_iov = &iov[i];
+      headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int sent = HANDLE_EINTR(syscall(__NR_sendmmsg, socket_, headers, count,
+                                    0));
+    if (sent >= 0) {
+      int bytes = 0;
+      for (int i = 0; i < sent; ++i)
+        bytes += headers[i].msg_len;
+      base::StatsCounter write_bytes("udp.write_bytes");
+      write_bytes.Add(bytes);
+      return sent;
+    }
+    if (errno != ENOSYS)
+      return MapSystemError(errno);
+    sendmmsg_unsupported_ = true;
+  }
+#endif
+
+  // One sendto() per datagram, until the socket would block.
+  int sent = 0;
+  while (sent < count) {
+    DatagramPacket* packet = &packets[sent];
+    int rv = InternalSendTo(packet->buf, packet->buf_len, &packet->address);
+    if (rv < 0)
+      return sent > 0 ? sent : MapSystemError(errno);
+    base::StatsCounter write_bytes("udp.write_bytes");
+    write_bytes.Add(rv);
+    ++sent;
+  }
+  return sent;
+}
+
 }  // namespace net
@@ -14,6 +14,7 @@
 #include "net/base/ip_endpoint.h"
 #include "net/base/net_log.h"
 #include "net/socket/client_socket.h"
+#include "net/udp/datagram_server_socket.h"
 
 namespace net {
 
@@ -90,6 +91,18 @@ class UDPSocketLibevent : public base::NonThreadSafe {
              const IPEndPoint& address,
              CompletionCallback* callback);
 
+  // Batched forms of RecvFrom() and SendTo(); see
+  // DatagramServerSocket::RecvMultipleFrom().  On Linux they use
+  // recvmmsg()/sendmmsg(), so one system call handles the whole batch.
+  // Elsewhere, or on kernels without these calls, the datagrams are still
+  // handled within a single wakeup, one system call each.
+  int RecvMultipleFrom(DatagramPacket* packets,
+                       int count,
+                       CompletionCallback* callback);
+  int SendMultipleTo(DatagramPacket* packets,
+                     int count,
+                     CompletionCallback* callback);
+
   // Returns true if the socket is already connected or bound.
   bool is_connected() const { return socket_ != kInvalidSocket; }
 
@@ -153,6 +166,10 @@ class UDPSocketLibevent : public base::NonThreadSafe {
   int InternalRecvFrom(IOBuffer* buf, int buf_len, IPEndPoint* address);
   int InternalSendTo(IOBuffer* buf, int buf_len, const IPEndPoint* address);
 
+  // Return the number of datagrams handled or a net error code.
+  int InternalRecvMultipleFrom(DatagramPacket* packets, int count);
+  int InternalSendMultipleTo(DatagramPacket* packets, int count);
+
   int socket_;
 
   // These are mutable since they're just cached copies to make
@@ -173,11 +190,23 @@ class UDPSocketLibevent : public base::NonThreadSafe {
   int read_buf_len_;
   IPEndPoint* recv_from_address_;
 
+  // The packets of a pending RecvMultipleFrom(), or NULL.
+  DatagramPacket* read_packets_;
+  int read_packet_count_;
+
   // The buffer used by InternalWrite() to retry Write requests
   scoped_refptr<IOBuffer> write_buf_;
   int write_buf_len_;
   scoped_ptr<IPEndPoint> send_to_address_;
 
+  // The packets of a pending SendMultipleTo(), or NULL.
+  DatagramPacket* write_packets_;
+  int write_packet_count_;
+
+  // Set once the kernel has reported that it lacks recvmmsg() or sendmmsg().
+  bool recvmmsg_unsupported_;
+  bool sendmmsg_unsupported_;
+
   // External callback; called when read is complete.
   CompletionCallback* read_callback_;
 
@@ -296,6 +296,67 @@ TEST_F(UDPSocketTest, ServerGetPeerAddress) {
   EXPECT_EQ(rv, ERR_SOCKET_NOT_CONNECTED);
 }
 
+// Send a batch of datagrams with SendMultipleTo(), and read them back with
+// RecvMultipleFrom().
+TEST_F(UDPSocketTest, MultipleDatagrams) {
+  IPEndPoint bind_address;
+  CreateUDPAddress("127.0.0.1", 0, &bind_address);
+  UDPServerSocket receiver(NULL, NetLog::Source());
+  ASSERT_EQ(OK, receiver.Listen(bind_address));
+  UDPServerSocket sender(NULL, NetLog::Source());
+  ASSERT_EQ(OK, sender.Listen(bind_address));
+
+  IPEndPoint receiver_address;
+  ASSERT_EQ(OK, receiver.GetLocalAddress(&receiver_address));
+  IPEndPoint sender_address;
+  ASSERT_EQ(OK, sender.GetLocalAddress(&sender_address));
+
+  const char* const kMessages[] = { "first", "second", "third" };
+  const int kCount = arraysize(kMessages);
+  scoped_refptr<StringIOBuffer> send_buffers[kCount];
+  DatagramPacket send_packets[kCount];
+  for (int i = 0; i < kCount; ++i) {
+    send_buffers[i] = new StringIOBuffer(kMessages[i]);
+    send_packets[i].buf = send_buffers[i];
+    send_packets[i].buf_len = send_buffers[i]->size();
+    send_packets[i].address = receiver_address;
+  }
+
+  TestCompletionCallback callback;
+  int sent = 0;
+  while (sent < kCount) {
+    int rv = sender.SendMultipleTo(send_packets + sent, kCount - sent,
+                                   &callback);
+    if (rv == ERR_NOT_IMPLEMENTED)
+      return;  // Not supported on this platform.
+    rv = callback.GetResult(rv);
+    ASSERT_GT(rv, 0);
+    sent += rv;
+  }
+
+  scoped_refptr<IOBufferWithSize> recv_buffers[kCount];
+  DatagramPacket recv_packets[kCount];
+  for (int i = 0; i < kCount; ++i) {
+    recv_buffers[i] = new IOBufferWithSize(kMaxRead);
+    recv_packets[i].buf = recv_buffers[i];
+    recv_packets[i].buf_len = kMaxRead;
+  }
+
+  int received = 0;
+  while (received < kCount) {
+    int rv = callback.GetResult(receiver.RecvMultipleFrom(
+        recv_packets + received, kCount - received, &callback));
+    ASSERT_GT(rv, 0);
+    received += rv;
+  }
+
+  for (int i = 0; i < kCount; ++i) {
+    EXPECT_EQ(kMessages[i], std::string(recv_packets[i].buf->data(),
+                                        recv_packets[i].length));
+    EXPECT_EQ(sender_address, recv_packets[i].address);
+  }
+}
+
 // Close the socket while read is pending.
 TEST_F(UDPSocketTest, CloseWithPendingRead) {
   IPEndPoint bind_address;
@@ -158,6 +158,20 @@ int UDPSocketWin::SendTo(IOBuffer* buf,
   return SendToOrWrite(buf, buf_len, &address, callback);
 }
 
+int UDPSocketWin::RecvMultipleFrom(DatagramPacket* packets,
+                                   int count,
+                                   CompletionCallback* callback) {
+  NOTIMPLEMENTED();
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int UDPSocketWin::SendMultipleTo(DatagramPacket* packets,
+                                 int count,
+                                 CompletionCallback* callback) {
+  NOTIMPLEMENTED();
+  return ERR_NOT_IMPLEMENTED;
+}
+
 int UDPSocketWin::SendToOrWrite(IOBuffer* buf,
                                 int buf_len,
                                 const IPEndPoint* address,
@@ -16,6 +16,7 @@
 #include "net/base/ip_endpoint.h"
 #include "net/base/io_buffer.h"
 #include "net/base/net_log.h"
+#include "net/udp/datagram_server_socket.h"
 
 namespace net {
 
@@ -92,6 +93,15 @@ class UDPSocketWin : public base::NonThreadSafe {
              const IPEndPoint& address,
              CompletionCallback* callback);
 
+  // Batched datagram I/O is not available on Windows; these return
+  // ERR_NOT_IMPLEMENTED.
+  int RecvMultipleFrom(DatagramPacket* packets,
+                       int count,
+                       CompletionCallback* callback);
+  int SendMultipleTo(DatagramPacket* packets,
+                     int count,
+                     CompletionCallback* callback);
+
   // Returns true if the socket is already connected or bound.
   bool is_connected() const { return socket_ != INVALID_SOCKET; }
 
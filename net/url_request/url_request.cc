@@ -5,12 +5,14 @@
 #include "net/url_request/url_request.h"
 
 #include "base/compiler_specific.h"
+#include "base/memory/arena.h"
 #include "base/memory/singleton.h"
 #include "base/message_loop.h"
 #include "base/metrics/stats_counters.h"
 #include "base/synchronization/lock.h"
 #include "net/base/host_port_pair.h"
 #include "net/base/load_flags.h"
+#include "net/base/load_timing_info.h"
 #include "net/base/net_errors.h"
 #include "net/base/net_log.h"
 #include "net/base/network_delegate.h"
@@ -241,6 +243,16 @@ LoadState URLRequest::GetLoadState() const {
   return job_ ? job_->GetLoadState() : LOAD_STATE_IDLE;
 }
 
+void URLRequest::GetLoadTimingInfo(LoadTimingInfo* load_timing_info) const {
+  *load_timing_info = LoadTimingInfo();
+  if (job_) {
+    job_->GetLoadTimingInfo(load_timing_info);
+    load_timing_info->filter_time = job_->filter_time();
+  }
+  load_timing_info->request_start_time = request_start_time_;
+  load_timing_info->request_start = request_start_;
+}
+
 uint64 URLRequest::GetUploadProgress() const {
   if (!job_) {
     // We haven't started or the request was cancelled
@@ -364,6 +376,8 @@ GURL URLRequest::GetSanitizedReferrer() const {
 
 void URLRequest::Start() {
   response_info_.request_time = Time::Now();
+  request_start_time_ = response_info_.request_time;
+  request_start_ = base::TimeTicks::Now();
 
   // Only notify the delegate for the initial request.
   if (context_ && context_->network_delegate()) {
@@ -672,6 +686,22 @@ int64 URLRequest::GetExpectedContentSize() const {
   return expected_content_size;
 }
 
+void URLRequest::SetPriority(RequestPriority priority) {
+#ifdef ANDROID
+  DCHECK_GE(static_cast<int>(priority), static_cast<int>(HIGHEST));
+  DCHECK_LT(static_cast<int>(priority), static_cast<int>(NUM_PRIORITIES));
+#else
+  DCHECK_GE(priority, HIGHEST);
+  DCHECK_LT(priority, NUM_PRIORITIES);
+#endif
+  if (priority_ == priority)
+    return;
+
+  priority_ = priority;
+  if (job_)
+    job_->SetPriority(priority);
+}
+
 URLRequest::UserData* URLRequest::GetUserData(const void* key) const {
   UserDataMap::const_iterator found = user_data_.find(key);
   if (found != user_data_.end())
@@ -683,4 +713,10 @@ void URLRequest::SetUserData(const void* key, UserData* data) {
   user_data_[key] = linked_ptr<UserData>(data);
 }
 
+base::Arena* URLRequest::arena() {
+  if (!arena_.get())
+    arena_.reset(new base::Arena());
+  return arena_.get();
+}
+
 }  // namespace net
@@ -14,6 +14,7 @@
 #include "base/logging.h"
 #include "base/memory/linked_ptr.h"
 #include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/string16.h"
 #include "base/threading/non_thread_safe.h"
 #include "googleurl/src/gurl.h"
@@ -27,6 +28,7 @@
 #include "net/url_request/url_request_status.h"
 
 namespace base {
+class Arena;
 class Time;
 }  // namespace base
 
@@ -42,6 +44,7 @@ namespace net {
 class CookieOptions;
 class HostPortPair;
 class IOBuffer;
+struct LoadTimingInfo;
 class SSLCertRequestInfo;
 class UploadData;
 class URLRequestContext;
@@ -235,6 +238,11 @@ class NET_EXPORT URLRequest : public base::NonThreadSafe {
   UserData* GetUserData(const void* key) const;
   void SetUserData(const void* key, UserData* data);
 
+  // Returns an arena for objects that live as long as the request, so that
+  // they don't each need to be allocated and freed.  They are destroyed with
+  // the request, after its job and its user data.
+  base::Arena* arena();
+
   // Registers a new protocol handler for the given scheme. If the scheme is
   // already handled, this will overwrite the given factory. To delete the
   // protocol factory, use NULL for the factory BUT this WILL NOT put back
@@ -373,6 +381,11 @@ class NET_EXPORT URLRequest : public base::NonThreadSafe {
   // Returns the current upload progress in bytes.
   uint64 GetUploadProgress() const;
 
+  // Fills in |load_timing_info| with the times at which the request went
+  // through each step of loading so far.  After a redirect, the times past
+  // |request_start| are for the load of the latest URL.
+  void GetLoadTimingInfo(LoadTimingInfo* load_timing_info) const;
+
   // Get response header(s) by ID or name.  These methods may only be called
   // once the delegate's OnResponseStarted method has been called.  Headers
   // that appear more than once in the response are coalesced, with values
@@ -552,16 +565,11 @@ class NET_EXPORT URLRequest : public base::NonThreadSafe {
 
   // Returns the priority level for this request.
   RequestPriority priority() const { return priority_; }
-  void set_priority(RequestPriority priority) {
-#ifdef ANDROID
-    DCHECK_GE(static_cast<int>(priority), static_cast<int>(HIGHEST));
-    DCHECK_LT(static_cast<int>(priority), static_cast<int>(NUM_PRIORITIES));
-#else
-    DCHECK_GE(priority, HIGHEST);
-    DCHECK_LT(priority, NUM_PRIORITIES);
-#endif
-    priority_ = priority;
-  }
+
+  // Sets the priority level for this request. This may be called while the
+  // request is in progress; the new priority is passed on to the job, which
+  // can move its pending network operations ahead of (or behind) others.
+  void SetPriority(RequestPriority priority);
 
 #ifdef UNIT_TEST
   URLRequestJob* job() { return job_; }
@@ -647,11 +655,19 @@ class NET_EXPORT URLRequest : public base::NonThreadSafe {
   // The HTTP response info, lazily initialized.
   HttpResponseInfo response_info_;
 
+  // When Start() was called, from the wall clock and as TimeTicks.
+  base::Time request_start_time_;
+  base::TimeTicks request_start_;
+
   // Tells us whether the job is outstanding. This is true from the time
   // Start() is called to the time we dispatch RequestComplete and indicates
   // whether the job is active.
   bool is_pending_;
 
+  // Created on first use.  Declared before |user_data_|, which may point
+  // into it, so that it is destroyed after.
+  scoped_ptr<base::Arena> arena_;
+
   // Externally-defined data accessible by key
   UserDataMap user_data_;
 
@@ -6,8 +6,13 @@
 
 #include "base/string_util.h"
 #include "net/base/cookie_store.h"
+#include "net/base/host_cache.h"
 #include "net/base/host_resolver.h"
+#include "net/base/host_resolver_impl.h"
+#include "net/disk_cache/disk_cache.h"
 #include "net/ftp/ftp_transaction_factory.h"
+#include "net/http/http_cache.h"
+#include "net/http/http_network_session.h"
 #include "net/http/http_transaction_factory.h"
 
 namespace net {
@@ -75,6 +80,28 @@ bool URLRequestContext::IsSNIAvailable() const {
   return ssl_config.tls1_enabled;
 }
 
+size_t URLRequestContext::PurgeMemory(MemoryPressureLevel level) {
+  size_t freed = 0;
+  HostResolverImpl* resolver =
+      host_resolver_ ? host_resolver_->GetAsHostResolverImpl() : NULL;
+  if (resolver && resolver->cache())
+    freed += resolver->cache()->PurgeMemory(level, base::TimeTicks::Now());
+
+  // Generally garbage in the JS engine of the PAC script.
+  if (proxy_service_)
+    proxy_service_->PurgeMemory();
+
+  if (http_transaction_factory_) {
+    HttpCache* cache = http_transaction_factory_->GetCache();
+    if (cache && cache->GetCurrentBackend())
+      freed += cache->GetCurrentBackend()->PurgeMemory(level);
+    HttpNetworkSession* session = http_transaction_factory_->GetSession();
+    if (session)
+      freed += session->PurgeMemory(level);
+  }
+  return freed;
+}
+
 #ifdef ANDROID
 void URLRequestContext::setUID(uid_t uid) {
     valid_uid_ = true;
@@ -13,6 +13,7 @@
 
 #include "base/memory/ref_counted.h"
 #include "base/threading/non_thread_safe.h"
+#include "net/base/memory_pressure_level.h"
 #include "net/base/net_export.h"
 #include "net/base/net_log.h"
 #include "net/base/ssl_config_service.h"
@@ -188,6 +189,12 @@ class NET_EXPORT URLRequestContext
   // Is SNI available in this request context?
   bool IsSNIAvailable() const;
 
+  // Gives back the memory of the caches and connections of this context, as
+  // much as |level| asks for: see HostCache, disk_cache::Backend and
+  // HttpNetworkSession. Returns an estimate of the bytes freed. Objects that
+  // are shared with other contexts are purged for all of them.
+  size_t PurgeMemory(MemoryPressureLevel level);
+
 #ifdef ANDROID
   // Gets the UID of the calling process
   bool getUID(uid_t *uid) const;
@@ -19,6 +19,12 @@
 
 #include "net/url_request/url_request_file_job.h"
 
+#include "build/build_config.h"
+
+#if defined(OS_LINUX)
+#include <fcntl.h>
+#endif
+
 #include "base/compiler_specific.h"
 #include "base/message_loop.h"
 #include "base/platform_file.h"
@@ -26,7 +32,6 @@
 #include "base/synchronization/lock.h"
 #include "base/threading/worker_pool.h"
 #include "base/threading/thread_restrictions.h"
-#include "build/build_config.h"
 #include "googleurl/src/gurl.h"
 #include "net/base/io_buffer.h"
 #include "net/base/load_flags.h"
@@ -40,6 +45,25 @@
 
 namespace net {
 
+namespace {
+
+// The reads kept in flight ahead of the consumer, once a file is read in
+// order, and their size.
+const int kReadaheadReads = 4;
+const int kReadaheadSize = 64 * 1024;
+
+// Tells the OS that |length| bytes from |offset| in |file| are about to be
+// read in order, so that it reads ahead further.
+void AdviseSequentialRead(base::PlatformFile file, int64 offset,
+                          int64 length) {
+#if defined(OS_LINUX)
+  // This is only a hint, so failures are ignored.
+  posix_fadvise(file, offset, length, POSIX_FADV_SEQUENTIAL);
+#endif
+}
+
+}  // namespace
+
 #if defined(OS_WIN)
 class URLRequestFileJob::AsyncResolver
     : public base::RefCountedThreadSafe<URLRequestFileJob::AsyncResolver> {
@@ -336,6 +360,7 @@ void URLRequestFileJob::DidResolve(
     int flags = base::PLATFORM_FILE_OPEN |
                 base::PLATFORM_FILE_READ |
                 base::PLATFORM_FILE_ASYNC;
+    stream_.SetReadahead(kReadaheadReads, kReadaheadSize, false);
     rv = stream_.Open(file_path_, flags);
   }
 
@@ -369,6 +394,11 @@ void URLRequestFileJob::DidResolve(
     }
   }
 
+  if (remaining_bytes_ > 0) {
+    AdviseSequentialRead(stream_.platform_file(),
+                         byte_range_.first_byte_position(), remaining_bytes_);
+  }
+
   set_expected_content_size(remaining_bytes_);
   NotifyHeadersComplete();
 }
@@ -813,6 +813,18 @@ uint64 URLRequestHttpJob::GetUploadProgress() const {
   return transaction_.get() ? transaction_->GetUploadProgress() : 0;
 }
 
+void URLRequestHttpJob::GetLoadTimingInfo(
+    LoadTimingInfo* load_timing_info) const {
+  if (transaction_.get())
+    transaction_->GetLoadTimingInfo(load_timing_info);
+}
+
+void URLRequestHttpJob::SetPriority(RequestPriority priority) {
+  request_info_.priority = priority;
+  if (transaction_.get())
+    transaction_->SetPriority(priority);
+}
+
 bool URLRequestHttpJob::GetMimeType(std::string* mime_type) const {
   DCHECK(transaction_.get());
 
@@ -70,6 +70,8 @@ class URLRequestHttpJob : public URLRequestJob {
   virtual void Kill();
   virtual LoadState GetLoadState() const;
   virtual uint64 GetUploadProgress() const;
+  virtual void GetLoadTimingInfo(LoadTimingInfo* load_timing_info) const;
+  virtual void SetPriority(RequestPriority priority);
   virtual bool GetMimeType(std::string* mime_type) const;
   virtual bool GetCharset(std::string* charset);
   virtual void GetResponseInfo(HttpResponseInfo* info);
@@ -100,6 +100,12 @@ uint64 URLRequestJob::GetUploadProgress() const {
   return 0;
 }
 
+void URLRequestJob::GetLoadTimingInfo(LoadTimingInfo* load_timing_info) const {
+}
+
+void URLRequestJob::SetPriority(RequestPriority priority) {
+}
+
 bool URLRequestJob::GetCharset(std::string* charset) {
   return false;
 }
@@ -459,8 +465,10 @@ bool URLRequestJob::ReadFilteredData(int* bytes_read) {
     int filtered_data_len = filtered_read_buffer_len_;
     Filter::FilterStatus status;
     int output_buffer_size = filtered_data_len;
+    base::TimeTicks filter_start = base::TimeTicks::Now();
     status = filter_->ReadData(filtered_read_buffer_->data(),
                                &filtered_data_len);
+    filter_time_ += base::TimeTicks::Now() - filter_start;
 
     if (filter_needs_more_output_space_ && 0 == filtered_data_len) {
       // filter_needs_more_output_space_ was mistaken... there are no more bytes
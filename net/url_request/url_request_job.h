@@ -18,6 +18,7 @@
 #include "net/base/filter.h"
 #include "net/base/host_port_pair.h"
 #include "net/base/load_states.h"
+#include "net/base/request_priority.h"
 
 namespace net {
 
@@ -25,6 +26,7 @@ class AuthChallengeInfo;
 class HttpRequestHeaders;
 class HttpResponseInfo;
 class IOBuffer;
+struct LoadTimingInfo;
 class URLRequest;
 class UploadData;
 class URLRequestStatus;
@@ -94,6 +96,16 @@ class URLRequestJob : public base::RefCounted<URLRequestJob> {
   // Called to get the upload progress in bytes.
   virtual uint64 GetUploadProgress() const;
 
+  // Called to fill in the times the job has recorded for the steps of the
+  // load.  The default implementation records none.
+  virtual void GetLoadTimingInfo(LoadTimingInfo* load_timing_info) const;
+
+  // The total time spent in the filter so far.
+  base::TimeDelta filter_time() const { return filter_time_; }
+
+  // Called when the priority of the request changes.
+  virtual void SetPriority(RequestPriority priority);
+
   // Called to fetch the charset for this request.  Only makes sense for some
   // types of requests. Returns true on success.  Calling this on a type that
   // doesn't have a charset will return false.
@@ -304,6 +316,7 @@ class URLRequestJob : public base::RefCounted<URLRequestJob> {
   int prefilter_bytes_read_;
   int postfilter_bytes_read_;
   int64 filter_input_byte_count_;
+  base::TimeDelta filter_time_;
 
   // The data stream filter which is enabled on demand.
   scoped_ptr<Filter> filter_;
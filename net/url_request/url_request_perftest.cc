@@ -0,0 +1,734 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// End to end benchmarks of URLRequest, against a server on the loopback
+// interface which runs on a thread of its own.  They go through the whole
+// stack: the cache, the socket pools, the sockets and SSL, so that changes
+// anywhere in it can be judged on the numbers of the system as a whole.
+//
+// Each benchmark logs the requests per second, the throughput of the
+// bodies in MB/s, the CPU time per request and the percentiles of the
+// request latencies.  The CPU time is the one of the whole process, so it
+// includes the work of the server.
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/base_paths.h"
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/path_service.h"
+#include "base/perftimer.h"
+#include "base/process_util.h"
+#include "base/stl_util-inl.h"
+#include "base/string_number_conversions.h"
+#include "base/string_split.h"
+#include "base/string_util.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "crypto/rsa_private_key.h"
+#include "googleurl/src/gurl.h"
+#include "net/base/completion_callback.h"
+#include "net/base/io_buffer.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/load_flags.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_util.h"
+#include "net/base/ssl_config_service.h"
+#include "net/base/x509_certificate.h"
+#include "net/socket/client_socket.h"
+#include "net/socket/ssl_server_socket.h"
+#include "net/socket/tcp_server_socket.h"
+#include "net/url_request/url_request.h"
+#include "net/url_request/url_request_test_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+// The server's thread runs its tasks before the server is destroyed.
+namespace net {
+namespace {
+class LoopbackServer;
+}  // namespace
+}  // namespace net
+DISABLE_RUNNABLE_METHOD_REFCOUNT(net::LoopbackServer);
+
+namespace net {
+
+namespace {
+
+const int kListenBacklog = 64;
+const int kServerReadBufferSize = 16 * 1024;
+const int kClientReadBufferSize = 32 * 1024;
+
+// The largest body the server sends.
+const int kMaxBodySize = 16 * 1024 * 1024;
+
+// The number of connections a browser opens to a host.
+const int kNumRequestsInFlight = 6;
+
+// The server answers:
+//   GET /get?<size>             with <size> bytes which can't be cached.
+//   GET /cacheable?<size>&<id>  with <size> bytes, cacheable for an hour.
+//   POST /upload                with the number of bytes posted.
+// Connections are persistent.
+class LoopbackServer {
+ public:
+  explicit LoopbackServer(bool use_ssl);
+  ~LoopbackServer();
+
+  // Starts listening on an ephemeral port.  Returns false on failure.
+  bool Start();
+
+  GURL GetURL(const std::string& path) const;
+
+  // Returns the number of requests answered so far.
+  int num_requests() const;
+
+ private:
+  class Connection;
+
+  // The methods below run on |thread_|.
+  void StartOnServerThread(base::WaitableEvent* done, bool* result);
+  void StopOnServerThread(base::WaitableEvent* done);
+  void DoAccept();
+  void OnAccept(int result);
+  // Starts serving |accepted_socket_|.
+  void HandleAcceptedSocket();
+  void OnConnectionClosed(Connection* connection);
+  void DidAnswerRequest();
+
+  const bool use_ssl_;
+  base::Thread thread_;
+  int port_;
+
+  scoped_ptr<TCPServerSocket> socket_;
+  scoped_ptr<ClientSocket> accepted_socket_;
+  CompletionCallbackImpl<LoopbackServer> accept_callback_;
+  std::set<Connection*> connections_;
+
+  scoped_refptr<X509Certificate> cert_;
+  scoped_ptr<crypto::RSAPrivateKey> key_;
+
+  // The bodies of all the responses are slices of this.
+  const std::string body_;
+
+  mutable base::Lock lock_;
+  int num_requests_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoopbackServer);
+};
+
+// Reads requests from a socket and writes the responses, one request at a
+// time.
+class LoopbackServer::Connection {
+ public:
+  // |ssl_socket| is |socket| if the SSL handshake must be done first, or
+  // NULL.
+  Connection(LoopbackServer* server, Socket* socket,
+             SSLServerSocket* ssl_socket);
+  ~Connection();
+
+  void Start();
+
+ private:
+  void OnHandshake(int result);
+  void DoRead();
+  void OnRead(int result);
+  void DoWrite();
+  void OnWrite(int result);
+
+  // Queues the responses of the complete requests of |request_data_|.
+  void AnswerRequests();
+  void QueueResponse(const char* status, const char* headers, IOBuffer* body,
+                     int body_size);
+
+  void Close();
+
+  LoopbackServer* server_;
+  scoped_ptr<Socket> socket_;
+  SSLServerSocket* ssl_socket_;
+  scoped_refptr<IOBuffer> read_buf_;
+  std::string request_data_;
+  std::deque<scoped_refptr<DrainableIOBuffer> > write_queue_;
+  bool closed_;
+
+  CompletionCallbackImpl<Connection> handshake_callback_;
+  CompletionCallbackImpl<Connection> read_callback_;
+  CompletionCallbackImpl<Connection> write_callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(Connection);
+};
+
+LoopbackServer::LoopbackServer(bool use_ssl)
+    : use_ssl_(use_ssl),
+      thread_("LoopbackServer"),
+      port_(0),
+      ALLOW_THIS_IN_INITIALIZER_LIST(
+          accept_callback_(this, &LoopbackServer::OnAccept)),
+      body_(kMaxBodySize, 'a'),
+      num_requests_(0) {
+}
+
+LoopbackServer::~LoopbackServer() {
+  if (thread_.IsRunning()) {
+    base::WaitableEvent done(false, false);
+    thread_.message_loop()->PostTask(
+        FROM_HERE, NewRunnableMethod(
+            this, &LoopbackServer::StopOnServerThread, &done));
+    done.Wait();
+    thread_.Stop();
+  }
+}
+
+bool LoopbackServer::Start() {
+  if (use_ssl_) {
+    FilePath certs_dir;
+    PathService::Get(base::DIR_SOURCE_ROOT, &certs_dir);
+    certs_dir = certs_dir.AppendASCII("net").AppendASCII("data")
+        .AppendASCII("ssl").AppendASCII("certificates");
+
+    std::string cert_der;
+    if (!file_util::ReadFileToString(
+            certs_dir.AppendASCII("unittest.selfsigned.der"), &cert_der)) {
+      return false;
+    }
+    cert_ = X509Certificate::CreateFromBytes(cert_der.data(),
+                                             cert_der.size());
+
+    std::string key_string;
+    if (!file_util::ReadFileToString(
+            certs_dir.AppendASCII("unittest.key.bin"), &key_string)) {
+      return false;
+    }
+    std::vector<uint8> key_vector(key_string.begin(), key_string.end());
+    key_.reset(crypto::RSAPrivateKey::CreateFromPrivateKeyInfo(key_vector));
+    if (!cert_ || !key_.get())
+      return false;
+  }
+
+  base::Thread::Options options(MessageLoop::TYPE_IO, 0);
+  if (!thread_.StartWithOptions(options))
+    return false;
+
+  base::WaitableEvent done(false, false);
+  bool result = false;
+  thread_.message_loop()->PostTask(
+      FROM_HERE, NewRunnableMethod(
+          this, &LoopbackServer::StartOnServerThread, &done, &result));
+  done.Wait();
+  return result;
+}
+
+GURL LoopbackServer::GetURL(const std::string& path) const {
+  return GURL(base::StringPrintf("%s://127.0.0.1:%d%s",
+                                 use_ssl_ ? "https" : "http", port_,
+                                 path.c_str()));
+}
+
+int LoopbackServer::num_requests() const {
+  base::AutoLock lock(lock_);
+  return num_requests_;
+}
+
+void LoopbackServer::StartOnServerThread(base::WaitableEvent* done,
+                                         bool* result) {
+  IPAddressNumber address;
+  ParseIPLiteralToNumber("127.0.0.1", &address);
+  IPEndPoint local_address;
+  socket_.reset(new TCPServerSocket(NULL, NetLog::Source()));
+  *result = socket_->Listen(IPEndPoint(address, 0), kListenBacklog) == OK &&
+            socket_->GetLocalAddress(&local_address) == OK;
+  if (*result) {
+    port_ = local_address.port();
+    DoAccept();
+  }
+  done->Signal();
+}
+
+void LoopbackServer::StopOnServerThread(base::WaitableEvent* done) {
+  STLDeleteElements(&connections_);
+  socket_.reset();
+  done->Signal();
+}
+
+void LoopbackServer::DoAccept() {
+  for (;;) {
+    int rv = socket_->Accept(&accepted_socket_, &accept_callback_);
+    if (rv == ERR_IO_PENDING)
+      return;
+    if (rv != OK) {
+      LOG(ERROR) << "Accept failed: " << rv;
+      return;
+    }
+    HandleAcceptedSocket();
+  }
+}
+
+void LoopbackServer::OnAccept(int result) {
+  if (result != OK) {
+    LOG(ERROR) << "Accept failed: " << result;
+    return;
+  }
+  HandleAcceptedSocket();
+  DoAccept();
+}
+
+void LoopbackServer::HandleAcceptedSocket() {
+  Connection* connection;
+  if (use_ssl_) {
+    SSLServerSocket* ssl_socket = CreateSSLServerSocket(
+        accepted_socket_.release(), cert_, key_.get(), SSLConfig());
+    connection = new Connection(this, ssl_socket, ssl_socket);
+  } else {
+    connection = new Connection(this, accepted_socket_.release(), NULL);
+  }
+  connections_.insert(connection);
+  connection->Start();
+}
+
+void LoopbackServer::OnConnectionClosed(Connection* connection) {
+  connections_.erase(connection);
+  MessageLoop::current()->DeleteSoon(FROM_HERE, connection);
+}
+
+void LoopbackServer::DidAnswerRequest() {
+  base::AutoLock lock(lock_);
+  ++num_requests_;
+}
+
+LoopbackServer::Connection::Connection(LoopbackServer* server,
+                                       Socket* socket,
+                                       SSLServerSocket* ssl_socket)
+    : server_(server),
+      socket_(socket),
+      ssl_socket_(ssl_socket),
+      read_buf_(new IOBuffer(kServerReadBufferSize)),
+      closed_(false),
+      ALLOW_THIS_IN_INITIALIZER_LIST(
+          handshake_callback_(this, &Connection::OnHandshake)),
+      ALLOW_THIS_IN_INITIALIZER_LIST(
+          read_callback_(this, &Connection::OnRead)),
+      ALLOW_THIS_IN_INITIALIZER_LIST(
+          write_callback_(this, &Connection::OnWrite)) {
+}
+
+LoopbackServer::Connection::~Connection() {}
+
+void LoopbackServer::Connection::Start() {
+  if (!ssl_socket_) {
+    DoRead();
+    return;
+  }
+  int rv = ssl_socket_->Accept(&handshake_callback_);
+  if (rv != ERR_IO_PENDING)
+    OnHandshake(rv);
+}
+
+void LoopbackServer::Connection::OnHandshake(int result) {
+  if (result != OK) {
+    Close();
+    return;
+  }
+  DoRead();
+}
+
+void LoopbackServer::Connection::DoRead() {
+  int rv = socket_->Read(read_buf_, kServerReadBufferSize, &read_callback_);
+  if (rv != ERR_IO_PENDING)
+    OnRead(rv);
+}
+
+void LoopbackServer::Connection::OnRead(int result) {
+  if (result <= 0) {
+    Close();
+    return;
+  }
+  request_data_.append(read_buf_->data(), result);
+  AnswerRequests();
+  if (write_queue_.empty()) {
+    DoRead();
+  } else {
+    DoWrite();
+  }
+}
+
+void LoopbackServer::Connection::DoWrite() {
+  while (!write_queue_.empty()) {
+    DrainableIOBuffer* buffer = write_queue_.front();
+    int rv = socket_->Write(buffer, buffer->BytesRemaining(),
+                            &write_callback_);
+    if (rv == ERR_IO_PENDING)
+      return;
+    if (rv < 0) {
+      Close();
+      return;
+    }
+    buffer->DidConsume(rv);
+    if (buffer->BytesRemaining() == 0)
+      write_queue_.pop_front();
+  }
+  DoRead();
+}
+
+void LoopbackServer::Connection::OnWrite(int result) {
+  if (result < 0) {
+    Close();
+    return;
+  }
+  DrainableIOBuffer* buffer = write_queue_.front();
+  buffer->DidConsume(result);
+  if (buffer->BytesRemaining() == 0)
+    write_queue_.pop_front();
+  DoWrite();
+}
+
+void LoopbackServer::Connection::AnswerRequests() {
+  for (;;) {
+    size_t headers_end = request_data_.find("\r\n\r\n");
+    if (headers_end == std::string::npos)
+      return;
+    std::string headers = StringToLowerASCII(
+        request_data_.substr(0, headers_end + 2));
+
+    int content_length = 0;
+    const char kContentLength[] = "\r\ncontent-length:";
+    size_t content_length_pos = headers.find(kContentLength);
+    if (content_length_pos != std::string::npos) {
+      content_length_pos += arraysize(kContentLength) - 1;
+      size_t content_length_end = headers.find("\r\n", content_length_pos);
+      std::string value;
+      TrimWhitespaceASCII(
+          headers.substr(content_length_pos,
+                         content_length_end - content_length_pos),
+          TRIM_ALL, &value);
+      base::StringToInt(value, &content_length);
+    }
+    size_t request_size = headers_end + 4 + content_length;
+    if (request_data_.size() < request_size)
+      return;
+
+    // The request line is "<method> <path> HTTP/1.1".
+    std::vector<std::string> request_line;
+    base::SplitString(headers.substr(0, headers.find("\r\n")), ' ',
+                      &request_line);
+    std::string path = request_line.size() == 3 ? request_line[1] : "";
+    request_data_.erase(0, request_size);
+
+    std::string query;
+    size_t query_pos = path.find('?');
+    if (query_pos != std::string::npos) {
+      query = path.substr(query_pos + 1);
+      path.erase(query_pos);
+    }
+    int body_size = 0;
+    base::StringToInt(query.substr(0, query.find('&')), &body_size);
+    body_size = std::max(0, std::min(body_size, kMaxBodySize));
+
+    if (path == "/get" || path == "/cacheable") {
+      QueueResponse("200 OK",
+                    path == "/get" ? "Cache-Control: no-store\r\n" :
+                                     "Cache-Control: max-age=3600\r\n",
+                    new WrappedIOBuffer(server_->body_.data()), body_size);
+    } else if (path == "/upload") {
+      scoped_refptr<StringIOBuffer> body(
+          new StringIOBuffer(base::IntToString(content_length)));
+      QueueResponse("200 OK", "Cache-Control: no-store\r\n", body,
+                    body->size());
+    } else {
+      QueueResponse("404 Not Found", "", NULL, 0);
+    }
+    server_->DidAnswerRequest();
+  }
+}
+
+void LoopbackServer::Connection::QueueResponse(const char* status,
+                                               const char* headers,
+                                               IOBuffer* body,
+                                               int body_size) {
+  std::string response = base::StringPrintf(
+      "HTTP/1.1 %s\r\n"
+      "Content-Type: application/octet-stream\r\n"
+      "Content-Length: %d\r\n"
+      "%s\r\n", status, body_size, headers);
+  scoped_refptr<StringIOBuffer> buffer(new StringIOBuffer(response));
+  write_queue_.push_back(new DrainableIOBuffer(buffer, buffer->size()));
+  if (body_size > 0)
+    write_queue_.push_back(new DrainableIOBuffer(body, body_size));
+}
+
+void LoopbackServer::Connection::Close() {
+  if (closed_)
+    return;
+  closed_ = true;
+  server_->OnConnectionClosed(this);
+}
+
+// Runs requests, a few at a time, and logs how they performed.
+class RequestRunner : public URLRequest::Delegate {
+ public:
+  explicit RequestRunner(URLRequestContext* context)
+      : context_(context),
+        load_flags_(0),
+        upload_size_(0),
+        num_requests_(0),
+        num_started_(0),
+        num_completed_(0),
+        bytes_transferred_(0) {
+  }
+
+  virtual ~RequestRunner() {
+    STLDeleteContainerPairFirstPointers(in_flight_.begin(), in_flight_.end());
+  }
+
+  void set_load_flags(int load_flags) { load_flags_ = load_flags; }
+
+  // Uploads |upload_size| bytes with each request.
+  void set_upload_size(int upload_size) {
+    upload_size_ = upload_size;
+    upload_data_.assign(upload_size, 'u');
+  }
+
+  // Runs |num_requests| requests, for |urls| in turn, |num_in_flight| at a
+  // time.  Logs the results as |name| if it isn't NULL.
+  void Run(const char* name,
+           const std::vector<GURL>& urls,
+           int num_requests,
+           int num_in_flight) {
+    urls_ = urls;
+    num_requests_ = num_requests;
+    num_started_ = 0;
+    num_completed_ = 0;
+    bytes_transferred_ = 0;
+    latencies_.clear();
+
+#if defined(OS_MACOSX)
+    scoped_ptr<base::ProcessMetrics> metrics(
+        base::ProcessMetrics::CreateProcessMetrics(
+            base::GetCurrentProcessHandle(), NULL));
+#else
+    scoped_ptr<base::ProcessMetrics> metrics(
+        base::ProcessMetrics::CreateProcessMetrics(
+            base::GetCurrentProcessHandle()));
+#endif
+    metrics->GetCPUUsage();
+    PerfTimer timer;
+
+    for (int i = 0; i < num_in_flight && num_started_ < num_requests_; ++i)
+      StartRequest();
+    MessageLoop::current()->Run();
+
+    double seconds = std::max(timer.Elapsed().InSecondsF(), 1e-6);
+    double cpu_seconds = metrics->GetCPUUsage() / 100 * seconds;
+    EXPECT_EQ(num_requests_, num_completed_);
+    if (!name)
+      return;
+
+    LogPerfResult(base::StringPrintf("%s_requests", name).c_str(),
+                  num_completed_ / seconds, "requests/s");
+    LogPerfResult(base::StringPrintf("%s_throughput", name).c_str(),
+                  bytes_transferred_ / seconds / (1024 * 1024), "MB/s");
+    LogPerfResult(base::StringPrintf("%s_cpu", name).c_str(),
+                  cpu_seconds * 1000 / std::max(num_completed_, 1),
+                  "ms/request");
+    std::sort(latencies_.begin(), latencies_.end());
+    LogPercentile(name, "p50", 50);
+    LogPercentile(name, "p90", 90);
+    LogPercentile(name, "p99", 99);
+  }
+
+  // URLRequest::Delegate implementation:
+  virtual void OnSSLCertificateError(URLRequest* request,
+                                     int cert_error,
+                                     X509Certificate* cert) {
+    // The server's certificate is self-signed.
+    request->ContinueDespiteLastError();
+  }
+
+  virtual void OnResponseStarted(URLRequest* request) {
+    if (!request->status().is_success() ||
+        request->GetResponseCode() != 200) {
+      ADD_FAILURE() << "Request failed: " << request->status().os_error();
+      RequestDone(request);
+      return;
+    }
+    ReadBody(request);
+  }
+
+  virtual void OnReadCompleted(URLRequest* request, int bytes_read) {
+    if (bytes_read <= 0) {
+      RequestDone(request);
+      return;
+    }
+    bytes_transferred_ += bytes_read;
+    ReadBody(request);
+  }
+
+ private:
+  struct RequestInfo {
+    base::TimeTicks start_time;
+    scoped_refptr<IOBuffer> read_buf;
+  };
+  typedef std::map<URLRequest*, RequestInfo> RequestMap;
+
+  void StartRequest() {
+    URLRequest* request =
+        new URLRequest(urls_[num_started_ % urls_.size()], this);
+    ++num_started_;
+    request->set_context(context_);
+    request->set_load_flags(load_flags_);
+    if (upload_size_ > 0) {
+      request->set_method("POST");
+      request->AppendBytesToUpload(upload_data_.data(), upload_size_);
+    }
+    RequestInfo& info = in_flight_[request];
+    info.start_time = base::TimeTicks::HighResNow();
+    info.read_buf = new IOBuffer(kClientReadBufferSize);
+    request->Start();
+  }
+
+  void ReadBody(URLRequest* request) {
+    IOBuffer* read_buf = in_flight_[request].read_buf;
+    int bytes_read;
+    while (request->Read(read_buf, kClientReadBufferSize, &bytes_read)) {
+      if (bytes_read <= 0) {
+        RequestDone(request);
+        return;
+      }
+      bytes_transferred_ += bytes_read;
+    }
+    if (!request->status().is_io_pending())
+      RequestDone(request);
+  }
+
+  void RequestDone(URLRequest* request) {
+    EXPECT_TRUE(request->status().is_success());
+    bytes_transferred_ += upload_size_;
+    RequestMap::iterator it = in_flight_.find(request);
+    latencies_.push_back(
+        base::TimeTicks::HighResNow() - it->second.start_time);
+    in_flight_.erase(it);
+    MessageLoop::current()->DeleteSoon(FROM_HERE, request);
+
+    ++num_completed_;
+    if (num_started_ < num_requests_) {
+      StartRequest();
+    } else if (in_flight_.empty()) {
+      MessageLoop::current()->Quit();
+    }
+  }
+
+  void LogPercentile(const char* name, const char* suffix,
+                     size_t percentile) {
+    if (latencies_.empty())
+      return;
+    size_t index = (latencies_.size() - 1) * percentile / 100;
+    LogPerfResult(base::StringPrintf("%s_latency_%s", name, suffix).c_str(),
+                  latencies_[index].InMillisecondsF(), "ms");
+  }
+
+  URLRequestContext* context_;
+  int load_flags_;
+  int upload_size_;
+  std::string upload_data_;
+
+  std::vector<GURL> urls_;
+  int num_requests_;
+  int num_started_;
+  int num_completed_;
+  // The bytes of the bodies received, and of the uploads.
+  int64 bytes_transferred_;
+  RequestMap in_flight_;
+  std::vector<base::TimeDelta> latencies_;
+
+  DISALLOW_COPY_AND_ASSIGN(RequestRunner);
+};
+
+// Benchmarks uncached requests for |body_size| bytes.
+void RunDownloads(const char* name, bool use_ssl, int body_size,
+                  int num_requests, int num_in_flight) {
+  MessageLoopForIO message_loop;
+  LoopbackServer server(use_ssl);
+  ASSERT_TRUE(server.Start());
+  scoped_refptr<TestURLRequestContext> context(new TestURLRequestContext());
+
+  std::vector<GURL> urls;
+  urls.push_back(server.GetURL(base::StringPrintf("/get?%d", body_size)));
+  RequestRunner runner(context);
+  runner.set_load_flags(LOAD_DISABLE_CACHE);
+  // Connect first, so that only the requests themselves are measured.
+  runner.Run(NULL, urls, num_in_flight, num_in_flight);
+  runner.Run(name, urls, num_requests, num_in_flight);
+  EXPECT_EQ(num_in_flight + num_requests, server.num_requests());
+}
+
+}  // namespace
+
+TEST(URLRequestPerfTest, HttpSmallObjects) {
+  RunDownloads("URLRequest_http_small_objects", false, 1024, 5000,
+               kNumRequestsInFlight);
+}
+
+TEST(URLRequestPerfTest, HttpLargeDownload) {
+  RunDownloads("URLRequest_http_large_download", false, kMaxBodySize, 20, 1);
+}
+
+TEST(URLRequestPerfTest, HttpUpload) {
+  MessageLoopForIO message_loop;
+  LoopbackServer server(false);
+  ASSERT_TRUE(server.Start());
+  scoped_refptr<TestURLRequestContext> context(new TestURLRequestContext());
+
+  std::vector<GURL> urls;
+  urls.push_back(server.GetURL("/upload"));
+  RequestRunner runner(context);
+  runner.set_upload_size(1024 * 1024);
+  runner.Run(NULL, urls, kNumRequestsInFlight, kNumRequestsInFlight);
+  runner.Run("URLRequest_http_upload", urls, 100, kNumRequestsInFlight);
+}
+
+// Requests which are all answered by the HttpCache.
+TEST(URLRequestPerfTest, HttpCacheHits) {
+  const int kNumURLs = 100;
+
+  MessageLoopForIO message_loop;
+  LoopbackServer server(false);
+  ASSERT_TRUE(server.Start());
+  scoped_refptr<TestURLRequestContext> context(new TestURLRequestContext());
+
+  std::vector<GURL> urls;
+  for (int i = 0; i < kNumURLs; ++i) {
+    urls.push_back(server.GetURL(
+        base::StringPrintf("/cacheable?%d&%d", 16 * 1024, i)));
+  }
+  RequestRunner runner(context);
+  runner.Run(NULL, urls, kNumURLs, kNumRequestsInFlight);
+  EXPECT_EQ(kNumURLs, server.num_requests());
+
+  runner.Run("URLRequest_http_cache_hits", urls, 5000, kNumRequestsInFlight);
+  EXPECT_EQ(kNumURLs, server.num_requests());
+}
+
+// SSLServerSocket is only implemented using NSS.
+#if defined(USE_NSS) || defined(OS_WIN) || defined(OS_MACOSX)
+
+TEST(URLRequestPerfTest, HttpsSmallObjects) {
+  RunDownloads("URLRequest_https_small_objects", true, 1024, 5000,
+               kNumRequestsInFlight);
+}
+
+TEST(URLRequestPerfTest, HttpsLargeDownload) {
+  RunDownloads("URLRequest_https_large_download", true, kMaxBodySize, 20, 1);
+}
+
+#endif
+
+}  // namespace net
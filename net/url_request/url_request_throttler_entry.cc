@@ -103,6 +103,8 @@ bool URLRequestThrottlerEntry::IsEntryOutdated() const {
   if (!HasOneRef())
     return false;
 
+  base::AutoLock auto_lock(lock_);
+
   // If there are send events in the sliding window period, we still need this
   // entry.
   if (!send_log_.empty() &&
@@ -114,14 +116,17 @@ bool URLRequestThrottlerEntry::IsEntryOutdated() const {
 }
 
 void URLRequestThrottlerEntry::DisableBackoffThrottling() {
+  base::AutoLock auto_lock(lock_);
   is_backoff_disabled_ = true;
 }
 
 void URLRequestThrottlerEntry::DetachManager() {
+  base::AutoLock auto_lock(lock_);
   manager_ = NULL;
 }
 
 bool URLRequestThrottlerEntry::IsDuringExponentialBackoff() const {
+  base::AutoLock auto_lock(lock_);
   if (is_backoff_disabled_)
     return false;
 
@@ -130,6 +135,7 @@ bool URLRequestThrottlerEntry::IsDuringExponentialBackoff() const {
 
 int64 URLRequestThrottlerEntry::ReserveSendingTimeForNextRequest(
     const base::TimeTicks& earliest_time) {
+  base::AutoLock auto_lock(lock_);
   base::TimeTicks now = GetTimeNow();
 
   // If a lot of requests were successfully made recently,
@@ -170,6 +176,7 @@ base::TimeTicks
   // returning the calculated back-off release time would probably be the
   // wrong thing to do (i.e. it would likely be too long).  Therefore, we
   // return "now" so that retries are not delayed.
+  base::AutoLock auto_lock(lock_);
   if (is_backoff_disabled_)
     return GetTimeNow();
 
@@ -179,6 +186,7 @@ base::TimeTicks
 void URLRequestThrottlerEntry::UpdateWithResponse(
     const std::string& host,
     const URLRequestThrottlerHeaderInterface* response) {
+  base::AutoLock auto_lock(lock_);
   if (response->GetResponseCode() >= 500) {
     GetBackoffEntry()->InformOfRequest(false);
   } else {
@@ -202,6 +210,7 @@ void URLRequestThrottlerEntry::ReceivedContentWasMalformed() {
   // with a response categorized as "good".  To end up counting one failure,
   // we need to count two failures here against the one success in
   // UpdateWithResponse().
+  base::AutoLock auto_lock(lock_);
   GetBackoffEntry()->InformOfRequest(false);
   GetBackoffEntry()->InformOfRequest(false);
 }
@@ -225,6 +234,7 @@ base::TimeTicks URLRequestThrottlerEntry::GetTimeNow() const {
 
 void URLRequestThrottlerEntry::HandleCustomRetryAfter(
     const std::string& header_value) {
+  lock_.AssertAcquired();
   // Input parameter is the number of seconds to wait in a floating point value.
   double time_in_sec = 0;
   bool conversion_is_ok = base::StringToDouble(header_value, &time_in_sec);
@@ -248,8 +258,9 @@ void URLRequestThrottlerEntry::HandleCustomRetryAfter(
 void URLRequestThrottlerEntry::HandleThrottlingHeader(
     const std::string& header_value,
     const std::string& host) {
+  lock_.AssertAcquired();
   if (header_value == kExponentialThrottlingDisableValue) {
-    DisableBackoffThrottling();
+    is_backoff_disabled_ = true;
     if (manager_)
       manager_->AddToOptOutList(host);
   } else {
@@ -10,6 +10,7 @@
 #include <string>
 
 #include "base/basictypes.h"
+#include "base/synchronization/lock.h"
 #include "net/base/backoff_entry.h"
 #include "net/url_request/url_request_throttler_entry_interface.h"
 
@@ -28,6 +29,9 @@ class URLRequestThrottlerManager;
 // destination and provide guidance (to the application level only) on whether
 // too many requests have been sent and when a good time to send the next one
 // would be. This is never used to deny requests at the network level.
+//
+// Entries may be shared by requests on different threads, so the public
+// methods take a lock.
 class URLRequestThrottlerEntry : public URLRequestThrottlerEntryInterface {
  public:
   // Sliding window period.
@@ -156,6 +160,9 @@ class URLRequestThrottlerEntry : public URLRequestThrottlerEntryInterface {
   // Weak back-reference to the manager object managing us.
   URLRequestThrottlerManager* manager_;
 
+  // Guards all of the above that isn't immutable.
+  mutable base::Lock lock_;
+
   DISALLOW_COPY_AND_ASSIGN(URLRequestThrottlerEntry);
 };
 
@@ -10,8 +10,31 @@
 
 namespace net {
 
+namespace {
+
+// Parameters of the 64-bit FNV-1a hash.
+const uint64 kFnvOffsetBasis = GG_UINT64_C(14695981039346656037);
+const uint64 kFnvPrime = GG_UINT64_C(1099511628211);
+
+uint64 HashChar(uint64 hash, char c) {
+  return (hash ^ static_cast<unsigned char>(c)) * kFnvPrime;
+}
+
+// Hashes |component| of |spec| into |hash|, lowercased. A separator is
+// hashed after it, so that chars moving from one component to the next
+// change the key.
+uint64 HashComponent(uint64 hash,
+                     const std::string& spec,
+                     const url_parse::Component& component) {
+  for (int i = 0; i < component.len; ++i)
+    hash = HashChar(hash, base::ToLowerASCII(spec[component.begin + i]));
+  return HashChar(hash, '\0');
+}
+
+}  // namespace
+
 const unsigned int URLRequestThrottlerManager::kMaximumNumberOfEntries = 1500;
-const unsigned int URLRequestThrottlerManager::kRequestsBetweenCollecting = 200;
+const int URLRequestThrottlerManager::kEntriesToCollectPerRequest = 2;
 
 URLRequestThrottlerManager* URLRequestThrottlerManager::GetInstance() {
   return Singleton<URLRequestThrottlerManager>::get();
@@ -19,16 +42,15 @@ URLRequestThrottlerManager* URLRequestThrottlerManager::GetInstance() {
 
 scoped_refptr<URLRequestThrottlerEntryInterface>
     URLRequestThrottlerManager::RegisterRequestUrl(const GURL &url) {
-  DCHECK(!enable_thread_checks_ || CalledOnValidThread());
-
-  // Normalize the url.
-  std::string url_id = GetIdFromUrl(url);
+  uint64 key = GetKeyFromUrl(url);
+  Shard* shard = GetShard(key);
+  base::AutoLock auto_lock(shard->lock);
 
-  // Periodically garbage collect old entries.
-  GarbageCollectEntriesIfNecessary();
+  // Clean out a few old entries.
+  GarbageCollectSomeEntries(shard);
 
   // Find the entry in the map or create it.
-  scoped_refptr<URLRequestThrottlerEntry>& entry = url_entries_[url_id];
+  scoped_refptr<URLRequestThrottlerEntry>& entry = shard->url_entries[key];
   if (entry.get() == NULL) {
     entry = new URLRequestThrottlerEntry(this);
 
@@ -38,8 +60,12 @@ scoped_refptr<URLRequestThrottlerEntryInterface>
     // disable throttling for entries already handed out (see comment
     // in AddToOptOutList), this is not a problem.
     std::string host = url.host();
-    if (opt_out_hosts_.find(host) != opt_out_hosts_.end() ||
-        IsLocalhost(host)) {
+    bool opted_out;
+    {
+      base::AutoLock opt_out_lock(opt_out_hosts_lock_);
+      opted_out = opt_out_hosts_.find(host) != opt_out_hosts_.end();
+    }
+    if (opted_out || IsLocalhost(host)) {
       // TODO(joi): Once sliding window is separate from back-off throttling,
       // we can simply return a dummy implementation of
       // URLRequestThrottlerEntryInterface here that never blocks anything (and
@@ -57,33 +83,28 @@ void URLRequestThrottlerManager::AddToOptOutList(const std::string& host) {
   // after there are already one or more entries in url_entries_ for that
   // host, the pre-existing entries may still perform back-off throttling.
   // In practice, this would almost never occur.
+  base::AutoLock auto_lock(opt_out_hosts_lock_);
   opt_out_hosts_.insert(host);
 }
 
 void URLRequestThrottlerManager::OverrideEntryForTests(
     const GURL& url,
     URLRequestThrottlerEntry* entry) {
-  // Normalize the url.
-  std::string url_id = GetIdFromUrl(url);
+  uint64 key = GetKeyFromUrl(url);
+  Shard* shard = GetShard(key);
+  base::AutoLock auto_lock(shard->lock);
 
-  // Periodically garbage collect old entries.
-  GarbageCollectEntriesIfNecessary();
+  // Clean out a few old entries.
+  GarbageCollectSomeEntries(shard);
 
-  url_entries_[url_id] = entry;
+  shard->url_entries[key] = entry;
 }
 
 void URLRequestThrottlerManager::EraseEntryForTests(const GURL& url) {
-  // Normalize the url.
-  std::string url_id = GetIdFromUrl(url);
-  url_entries_.erase(url_id);
-}
-
-void URLRequestThrottlerManager::set_enable_thread_checks(bool enable) {
-  enable_thread_checks_ = enable;
-}
-
-bool URLRequestThrottlerManager::enable_thread_checks() const {
-  return enable_thread_checks_;
+  uint64 key = GetKeyFromUrl(url);
+  Shard* shard = GetShard(key);
+  base::AutoLock auto_lock(shard->lock);
+  shard->url_entries.erase(key);
 }
 
 void URLRequestThrottlerManager::set_enforce_throttling(bool enforce) {
@@ -94,73 +115,104 @@ bool URLRequestThrottlerManager::enforce_throttling() {
   return enforce_throttling_;
 }
 
+URLRequestThrottlerManager::Shard::Shard() : next_key_to_collect(0) {}
+
+URLRequestThrottlerManager::Shard::~Shard() {}
+
 // TODO(joi): Turn throttling on by default when appropriate.
 URLRequestThrottlerManager::URLRequestThrottlerManager()
-    : requests_since_last_gc_(0),
-      enforce_throttling_(false),
-      enable_thread_checks_(false) {
-  // Construction/destruction is on main thread (because BrowserMain
-  // retrieves an instance to call InitializeOptions), but is from then on
-  // used on I/O thread.
-  DetachFromThread();
-
-  url_id_replacements_.ClearPassword();
-  url_id_replacements_.ClearUsername();
-  url_id_replacements_.ClearQuery();
-  url_id_replacements_.ClearRef();
+    : enforce_throttling_(false) {
 }
 
 URLRequestThrottlerManager::~URLRequestThrottlerManager() {
-  // Destruction is on main thread (AtExit), but real use is on I/O thread.
-  DetachFromThread();
-
   // Since, for now, the manager object might conceivably go away before
   // the entries, detach the entries' back-pointer to the manager.
   //
   // TODO(joi): Revisit whether to make entries non-refcounted.
-  UrlEntryMap::iterator i = url_entries_.begin();
-  while (i != url_entries_.end()) {
-    if (i->second != NULL) {
-      i->second->DetachManager();
+  for (int i = 0; i < kNumShards; ++i) {
+    base::AutoLock auto_lock(shards_[i].lock);
+    UrlEntryMap::iterator it = shards_[i].url_entries.begin();
+    while (it != shards_[i].url_entries.end()) {
+      if (it->second != NULL) {
+        it->second->DetachManager();
+      }
+      ++it;
     }
-    ++i;
-  }
 
-  // Delete all entries.
-  url_entries_.clear();
+    // Delete all entries.
+    shards_[i].url_entries.clear();
+  }
 }
 
-std::string URLRequestThrottlerManager::GetIdFromUrl(const GURL& url) const {
-  if (!url.is_valid())
-    return url.possibly_invalid_spec();
+uint64 URLRequestThrottlerManager::GetKeyFromUrl(const GURL& url) const {
+  const std::string& spec = url.possibly_invalid_spec();
+  uint64 hash = kFnvOffsetBasis;
+  if (!url.is_valid()) {
+    for (size_t i = 0; i < spec.size(); ++i)
+      hash = HashChar(hash, spec[i]);
+    return hash;
+  }
 
-  GURL id = url.ReplaceComponents(url_id_replacements_);
-  return StringToLowerASCII(id.spec()).c_str();
+  // Username, password, query and ref are left out.
+  const url_parse::Parsed& parsed = url.parsed_for_possibly_invalid_spec();
+  hash = HashComponent(hash, spec, parsed.scheme);
+  hash = HashComponent(hash, spec, parsed.host);
+  hash = HashComponent(hash, spec, parsed.port);
+  return HashComponent(hash, spec, parsed.path);
 }
 
-void URLRequestThrottlerManager::GarbageCollectEntriesIfNecessary() {
-  requests_since_last_gc_++;
-  if (requests_since_last_gc_ < kRequestsBetweenCollecting)
-    return;
-  requests_since_last_gc_ = 0;
+void URLRequestThrottlerManager::GarbageCollectEntries() {
+  for (int i = 0; i < kNumShards; ++i) {
+    base::AutoLock auto_lock(shards_[i].lock);
+    UrlEntryMap& url_entries = shards_[i].url_entries;
+    UrlEntryMap::iterator it = url_entries.begin();
+    while (it != url_entries.end()) {
+      if ((it->second)->IsEntryOutdated()) {
+        url_entries.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+
+    // In case something broke we want to make sure not to grow indefinitely.
+    while (url_entries.size() > kMaximumNumberOfEntries / kNumShards) {
+      url_entries.erase(url_entries.begin());
+    }
+  }
+}
 
-  GarbageCollectEntries();
+int URLRequestThrottlerManager::GetNumberOfEntriesForTests() const {
+  int num_entries = 0;
+  for (int i = 0; i < kNumShards; ++i) {
+    base::AutoLock auto_lock(shards_[i].lock);
+    num_entries += shards_[i].url_entries.size();
+  }
+  return num_entries;
 }
 
-void URLRequestThrottlerManager::GarbageCollectEntries() {
-  UrlEntryMap::iterator i = url_entries_.begin();
-  while (i != url_entries_.end()) {
-    if ((i->second)->IsEntryOutdated()) {
-      url_entries_.erase(i++);
-    } else {
-      ++i;
-    }
+void URLRequestThrottlerManager::GarbageCollectSomeEntries(Shard* shard) {
+  shard->lock.AssertAcquired();
+  UrlEntryMap& url_entries = shard->url_entries;
+  UrlEntryMap::iterator it =
+      url_entries.lower_bound(shard->next_key_to_collect);
+  for (int i = 0; i < kEntriesToCollectPerRequest && !url_entries.empty();
+       ++i) {
+    if (it == url_entries.end())
+      it = url_entries.begin();
+    if ((it->second)->IsEntryOutdated())
+      url_entries.erase(it++);
+    else
+      ++it;
   }
 
   // In case something broke we want to make sure not to grow indefinitely.
-  while (url_entries_.size() > kMaximumNumberOfEntries) {
-    url_entries_.erase(url_entries_.begin());
+  if (url_entries.size() > kMaximumNumberOfEntries / kNumShards) {
+    if (it == url_entries.end())
+      it = url_entries.begin();
+    url_entries.erase(it++);
   }
+
+  shard->next_key_to_collect = (it == url_entries.end()) ? 0 : it->first;
 }
 
 }  // namespace net
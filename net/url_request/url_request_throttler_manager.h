@@ -13,7 +13,7 @@
 #include "base/basictypes.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/singleton.h"
-#include "base/threading/non_thread_safe.h"
+#include "base/synchronization/lock.h"
 #include "googleurl/src/gurl.h"
 #include "net/url_request/url_request_throttler_entry.h"
 
@@ -23,16 +23,16 @@ namespace net {
 // in order to supervise traffic. URL requests for HTTP contents should
 // register their URLs in this manager on each request.
 //
-// URLRequestThrottlerManager maintains a map of URL IDs to URL request
+// URLRequestThrottlerManager maintains a map of URL keys to URL request
 // throttler entries. It creates URL request throttler entries when new URLs
-// are registered, and does garbage collection from time to time in order to
-// clean out outdated entries. URL ID consists of lowercased scheme, host, port
-// and path. All URLs converted to the same ID will share the same entry.
+// are registered, and cleans out outdated entries a few at a time as requests
+// are made. A URL key is a hash of the lowercased scheme, host, port and path,
+// computed straight from the URL's components. All URLs with the same key
+// will share the same entry.
 //
-// NOTE: All usage of this singleton object must be on the same thread,
-// although to allow it to be used as a singleton, construction and destruction
-// can occur on a separate thread.
-class URLRequestThrottlerManager : public base::NonThreadSafe {
+// The map is split into shards, each with its own lock, so that the manager
+// and its entries can be used from any thread.
+class URLRequestThrottlerManager {
  public:
   static URLRequestThrottlerManager* GetInstance();
 
@@ -59,12 +59,6 @@ class URLRequestThrottlerManager : public base::NonThreadSafe {
   // It is only used by unit tests.
   void EraseEntryForTests(const GURL& url);
 
-  // Turns threading model verification on or off.  Any code that correctly
-  // uses the network stack should preferably call this function to enable
-  // verification of correct adherence to the network stack threading model.
-  void set_enable_thread_checks(bool enable);
-  bool enable_thread_checks() const;
-
   // Whether throttling is enabled or not.
   void set_enforce_throttling(bool enforce);
   bool enforce_throttling();
@@ -73,67 +67,69 @@ class URLRequestThrottlerManager : public base::NonThreadSafe {
   URLRequestThrottlerManager();
   ~URLRequestThrottlerManager();
 
-  // Method that allows us to transform a URL into an ID that can be used in our
-  // map. Resulting IDs will be lowercase and consist of the scheme, host, port
-  // and path (without query string, fragment, etc.).
-  // If the URL is invalid, the invalid spec will be returned, without any
-  // transformation.
-  std::string GetIdFromUrl(const GURL& url) const;
-
-  // Method that ensures the map gets cleaned from time to time. The period at
-  // which garbage collecting happens is adjustable with the
-  // kRequestBetweenCollecting constant.
-  void GarbageCollectEntriesIfNecessary();
+  // Method that allows us to transform a URL into a key that can be used in
+  // our map. The key is a hash of the lowercased scheme, host, port and path
+  // (without query string, fragment, etc.); no string is built to compute it.
+  // If the URL is invalid, the key is a hash of the invalid spec, without any
+  // transformation. URLs whose keys collide share an entry, which with 64 bits
+  // is too rare to matter.
+  uint64 GetKeyFromUrl(const GURL& url) const;
 
-  // Method that does the actual work of garbage collecting.
+  // Method that does a full pass of garbage collecting over every shard.
   void GarbageCollectEntries();
 
   // Used by tests.
-  int GetNumberOfEntriesForTests() const { return url_entries_.size(); }
+  int GetNumberOfEntriesForTests() const;
 
  private:
   friend struct DefaultSingletonTraits<URLRequestThrottlerManager>;
 
-  // From each URL we generate an ID composed of the scheme, host, port and path
-  // that allows us to uniquely map an entry to it.
-  typedef std::map<std::string, scoped_refptr<URLRequestThrottlerEntry> >
+  // Maps the key of each URL to its entry. It is ordered, so that
+  // incremental garbage collection can pick up where it left off.
+  typedef std::map<uint64, scoped_refptr<URLRequestThrottlerEntry> >
       UrlEntryMap;
 
   // We maintain a set of hosts that have opted out of exponential
   // back-off throttling.
   typedef std::set<std::string> OptOutHosts;
 
+  // A part of the map, and the lock that guards it.
+  struct Shard {
+    Shard();
+    ~Shard();
+
+    mutable base::Lock lock;
+    UrlEntryMap url_entries;
+    // Key at which the next incremental garbage collection starts.
+    uint64 next_key_to_collect;
+  };
+
+  // Number of shards the map is split into.
+  static const int kNumShards = 8;
   // Maximum number of entries that we are willing to collect in our map.
   static const unsigned int kMaximumNumberOfEntries;
-  // Number of requests that will be made between garbage collection.
-  static const unsigned int kRequestsBetweenCollecting;
+  // Number of entries each request checks for being outdated.
+  static const int kEntriesToCollectPerRequest;
 
-  // Map that contains a list of URL ID and their matching
-  // URLRequestThrottlerEntry.
-  UrlEntryMap url_entries_;
+  Shard* GetShard(uint64 key) { return &shards_[key % kNumShards]; }
 
-  // Set of hosts that have opted out.
-  OptOutHosts opt_out_hosts_;
+  // Checks the next few entries of |shard| for being outdated, erasing those
+  // that are, and erases the next one regardless if |shard| is over its share
+  // of kMaximumNumberOfEntries. Spreading the work over requests keeps any
+  // one request from paying for a pass over the whole map. |shard->lock| must
+  // be held.
+  void GarbageCollectSomeEntries(Shard* shard);
 
-  // This keeps track of how many requests have been made. Used with
-  // GarbageCollectEntries.
-  unsigned int requests_since_last_gc_;
+  Shard shards_[kNumShards];
 
-  // Valid after construction.
-  GURL::Replacements url_id_replacements_;
+  // Set of hosts that have opted out, and the lock that guards it.
+  OptOutHosts opt_out_hosts_;
+  base::Lock opt_out_hosts_lock_;
 
   // Whether we would like to reject outgoing HTTP requests during the back-off
   // period.
   bool enforce_throttling_;
 
-  // Certain tests do not obey the net component's threading policy, so we
-  // keep track of whether we're being used by tests, and turn off certain
-  // checks.
-  //
-  // TODO(joi): See if we can fix the offending unit tests and remove this
-  // workaround.
-  bool enable_thread_checks_;
-
   DISALLOW_COPY_AND_ASSIGN(URLRequestThrottlerManager);
 };
 
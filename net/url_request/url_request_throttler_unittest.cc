@@ -163,7 +163,7 @@ class MockURLRequestThrottlerManager : public URLRequestThrottlerManager {
 
   // Method to process the URL using URLRequestThrottlerManager protected
   // method.
-  std::string DoGetUrlIdFromUrl(const GURL& url) { return GetIdFromUrl(url); }
+  uint64 DoGetKeyFromUrl(const GURL& url) { return GetKeyFromUrl(url); }
 
   // Method to use the garbage collecting method of URLRequestThrottlerManager.
   void DoGarbageCollectEntries() { GarbageCollectEntries(); }
@@ -391,10 +391,17 @@ TEST(URLRequestThrottlerManager, IsUrlStandardised) {
                     __LINE__)};
 
   for (unsigned int i = 0; i < arraysize(test_values); ++i) {
-    std::string temp = manager.DoGetUrlIdFromUrl(test_values[i].url);
-    EXPECT_EQ(temp, test_values[i].result) <<
+    EXPECT_EQ(manager.DoGetKeyFromUrl(GURL(test_values[i].result)),
+              manager.DoGetKeyFromUrl(test_values[i].url)) <<
         "Test case #" << i << " line " << test_values[i].line << " failed";
   }
+
+  // Each component counts.
+  uint64 key = manager.DoGetKeyFromUrl(GURL("http://www.example.com/a"));
+  EXPECT_NE(key, manager.DoGetKeyFromUrl(GURL("https://www.example.com/a")));
+  EXPECT_NE(key, manager.DoGetKeyFromUrl(GURL("http://www.example.org/a")));
+  EXPECT_NE(key, manager.DoGetKeyFromUrl(GURL("http://www.example.com:8/a")));
+  EXPECT_NE(key, manager.DoGetKeyFromUrl(GURL("http://www.example.com/b")));
 }
 
 TEST(URLRequestThrottlerManager, AreEntriesBeingCollected) {
@@ -414,6 +421,18 @@ TEST(URLRequestThrottlerManager, AreEntriesBeingCollected) {
   EXPECT_EQ(3, manager.GetNumberOfEntries());
 }
 
+// Outdated entries also get cleaned out a few at a time as new entries are
+// registered, without a full pass.
+TEST(URLRequestThrottlerManager, AreEntriesCollectedIncrementally) {
+  MockURLRequestThrottlerManager manager;
+
+  for (int i = 0; i < 10; ++i)
+    manager.CreateEntry(true);
+  for (int i = 0; i < 100; ++i)
+    manager.CreateEntry(false);
+  EXPECT_EQ(100, manager.GetNumberOfEntries());
+}
+
 TEST(URLRequestThrottlerManager, IsHostBeingRegistered) {
   MockURLRequestThrottlerManager manager;
 
@@ -0,0 +1,181 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/websockets/websocket_deflater.h"
+
+#include <string.h>
+
+#if defined(USE_SYSTEM_ZLIB)
+#include <zlib.h>
+#else
+#include "third_party/zlib/zlib.h"
+#endif
+
+#include "base/logging.h"
+#include "base/string_tokenizer.h"
+#include "base/string_util.h"
+#include "net/base/net_errors.h"
+
+namespace {
+
+// What a sync flush ends the compressed data with.  It is left out of the
+// messages sent, and put back before they are decompressed.
+const char kFlushMarker[] = { '\x00', '\x00', '\xff', '\xff' };
+
+const char kNoContextTakeover[] = "no_context_takeover";
+
+// The output of zlib is collected in pieces of this size.
+const int kChunkSize = 4096;
+
+}  // namespace
+
+namespace net {
+
+const char WebSocketDeflater::kExtensionName[] = "x-deflate-message";
+
+WebSocketDeflater::WebSocketDeflater() : context_takeover_(true) {
+}
+
+WebSocketDeflater::~WebSocketDeflater() {
+  if (zlib_stream_.get())
+    deflateEnd(zlib_stream_.get());
+}
+
+bool WebSocketDeflater::Init(int window_bits, int mem_level,
+                             bool context_takeover) {
+  DCHECK(!zlib_stream_.get());
+  DCHECK_GE(window_bits, 9);
+  DCHECK_LE(window_bits, MAX_WBITS);
+  zlib_stream_.reset(new z_stream);
+  memset(zlib_stream_.get(), 0, sizeof(z_stream));
+  context_takeover_ = context_takeover;
+
+  // Messages are compressed as they are sent, so use the fastest level.
+  if (deflateInit2(zlib_stream_.get(), Z_BEST_SPEED, Z_DEFLATED, -window_bits,
+                   mem_level, Z_DEFAULT_STRATEGY) != Z_OK) {
+    zlib_stream_.reset();
+    return false;
+  }
+  return true;
+}
+
+bool WebSocketDeflater::CompressMessage(const char* data, int data_len,
+                                        std::string* output) {
+  DCHECK(zlib_stream_.get());
+  output->clear();
+
+  z_stream* stream = zlib_stream_.get();
+  stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  stream->avail_in = data_len;
+  do {
+    size_t offset = output->size();
+    output->resize(offset + kChunkSize);
+    stream->next_out = reinterpret_cast<Bytef*>(&(*output)[offset]);
+    stream->avail_out = kChunkSize;
+    int rv = deflate(stream, Z_SYNC_FLUSH);
+    // Z_BUF_ERROR only means that there was nothing left to flush.
+    if (rv != Z_OK && rv != Z_BUF_ERROR) {
+      DLOG(ERROR) << "Unable to compress the WebSocket message: " << rv;
+      return false;
+    }
+    output->resize(offset + kChunkSize - stream->avail_out);
+  } while (!stream->avail_out);
+  DCHECK(!stream->avail_in);
+
+  // An empty message, right after a flush, has no output at all.
+  if (!output->empty()) {
+    DCHECK_GE(output->size(), sizeof(kFlushMarker));
+    output->resize(output->size() - sizeof(kFlushMarker));
+  }
+  if (!context_takeover_ && deflateReset(stream) != Z_OK)
+    return false;
+  return true;
+}
+
+// static
+std::string WebSocketDeflater::GetOffer(bool context_takeover) {
+  std::string offer(kExtensionName);
+  if (!context_takeover)
+    offer.append("; ").append(kNoContextTakeover);
+  return offer;
+}
+
+// static
+bool WebSocketDeflater::ParseResponse(const std::string& value,
+                                      bool* context_takeover) {
+  StringTokenizer extensions(value, ",");
+  while (extensions.GetNext()) {
+    StringTokenizer params(extensions.token_begin(), extensions.token_end(),
+                           ";");
+    if (!params.GetNext())
+      continue;
+    std::string name;
+    TrimWhitespaceASCII(params.token(), TRIM_ALL, &name);
+    if (!LowerCaseEqualsASCII(name, kExtensionName))
+      continue;
+    while (params.GetNext()) {
+      std::string param;
+      TrimWhitespaceASCII(params.token(), TRIM_ALL, &param);
+      if (LowerCaseEqualsASCII(param, kNoContextTakeover))
+        *context_takeover = false;
+    }
+    return true;
+  }
+  return false;
+}
+
+WebSocketInflater::WebSocketInflater() {
+}
+
+WebSocketInflater::~WebSocketInflater() {
+  if (zlib_stream_.get())
+    inflateEnd(zlib_stream_.get());
+}
+
+bool WebSocketInflater::Init() {
+  DCHECK(!zlib_stream_.get());
+  zlib_stream_.reset(new z_stream);
+  memset(zlib_stream_.get(), 0, sizeof(z_stream));
+
+  // The server may use any window size.
+  if (inflateInit2(zlib_stream_.get(), -MAX_WBITS) != Z_OK) {
+    zlib_stream_.reset();
+    return false;
+  }
+  return true;
+}
+
+int WebSocketInflater::DecompressMessage(const char* data, int data_len,
+                                         int max_size, std::string* output) {
+  DCHECK(zlib_stream_.get());
+  output->clear();
+
+  z_stream* stream = zlib_stream_.get();
+  const char* input[] = { data, kFlushMarker };
+  const int input_len[] = { data_len, sizeof(kFlushMarker) };
+  for (size_t i = 0; i < arraysize(input); ++i) {
+    stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input[i]));
+    stream->avail_in = input_len[i];
+    do {
+      size_t offset = output->size();
+      if (offset > static_cast<size_t>(max_size))
+        return ERR_MSG_TOO_BIG;
+      output->resize(offset + kChunkSize);
+      stream->next_out = reinterpret_cast<Bytef*>(&(*output)[offset]);
+      stream->avail_out = kChunkSize;
+      int rv = inflate(stream, Z_SYNC_FLUSH);
+      output->resize(offset + kChunkSize - stream->avail_out);
+      // Z_BUF_ERROR only means that there was nothing to do.
+      if (rv != Z_OK && rv != Z_BUF_ERROR) {
+        DLOG(ERROR) << "Unable to decompress the WebSocket message: " << rv;
+        return ERR_CONTENT_DECODING_FAILED;
+      }
+    } while (stream->avail_in || !stream->avail_out);
+  }
+  if (output->size() > static_cast<size_t>(max_size))
+    return ERR_MSG_TOO_BIG;
+  return OK;
+}
+
+}  // namespace net
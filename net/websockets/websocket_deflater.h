@@ -0,0 +1,100 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Per-message compression for WebSocket.  When the "x-deflate-message"
+// extension is agreed on in the handshake, each text message may be sent as
+// a length-prefixed frame of type 0x80 holding the message deflated (raw
+// deflate, sync-flushed, with the trailing 00 00 ff ff removed).
+//
+// The client offers the extension with
+//   Sec-WebSocket-Extensions: x-deflate-message
+// adding "; no_context_takeover" if it compresses every message on its own.
+// The server accepts by answering with the extension, and may add
+// "; no_context_takeover" to ask the same of the client.
+
+#ifndef NET_WEBSOCKETS_WEBSOCKET_DEFLATER_H_
+#define NET_WEBSOCKETS_WEBSOCKET_DEFLATER_H_
+#pragma once
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+
+typedef struct z_stream_s z_stream;
+
+namespace net {
+
+// How a WebSocket connection uses the extension.  Compressing costs about
+// (1 << (window_bits + 2)) + (1 << (mem_level + 9)) bytes per connection,
+// and decompressing 32KB more.
+struct WebSocketDeflateParams {
+  bool enabled;
+  // 9 to 15.  The size of the window the sent messages are compressed with.
+  int window_bits;
+  // 1 to 9.  How much memory is kept for compressing.
+  int mem_level;
+  // If true, earlier messages sent are used to compress the later ones,
+  // unless the server asks otherwise.
+  bool context_takeover;
+  // The largest message that is decompressed, and the most of a message
+  // that is kept to compress it once it is complete.  Text messages larger
+  // than this are sent uncompressed.
+  int max_message_size;
+};
+
+class WebSocketDeflater {
+ public:
+  static const char kExtensionName[];
+
+  WebSocketDeflater();
+  ~WebSocketDeflater();
+
+  // Returns false if the compressor cannot be initialized.
+  bool Init(int window_bits, int mem_level, bool context_takeover);
+
+  // Compresses one message of |data_len| bytes into |output|.
+  bool CompressMessage(const char* data, int data_len, std::string* output);
+
+  bool context_takeover() const { return context_takeover_; }
+
+  // Returns the value of the Sec-WebSocket-Extensions header offering the
+  // extension.
+  static std::string GetOffer(bool context_takeover);
+
+  // Returns true if the Sec-WebSocket-Extensions header |value| accepts the
+  // extension.  Sets |context_takeover| to false if the server asks for
+  // every message to be compressed on its own.
+  static bool ParseResponse(const std::string& value, bool* context_takeover);
+
+ private:
+  scoped_ptr<z_stream> zlib_stream_;
+  bool context_takeover_;
+
+  DISALLOW_COPY_AND_ASSIGN(WebSocketDeflater);
+};
+
+class WebSocketInflater {
+ public:
+  WebSocketInflater();
+  ~WebSocketInflater();
+
+  // Returns false if the decompressor cannot be initialized.
+  bool Init();
+
+  // Decompresses one message of |data_len| bytes into |output|.  Returns OK,
+  // ERR_MSG_TOO_BIG if the message is longer than |max_size|, or
+  // ERR_CONTENT_DECODING_FAILED.  The inflater can't be used after an error.
+  int DecompressMessage(const char* data, int data_len, int max_size,
+                        std::string* output);
+
+ private:
+  scoped_ptr<z_stream> zlib_stream_;
+
+  DISALLOW_COPY_AND_ASSIGN(WebSocketInflater);
+};
+
+}  // namespace net
+
+#endif  // NET_WEBSOCKETS_WEBSOCKET_DEFLATER_H_
@@ -0,0 +1,110 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/websockets/websocket_deflater.h"
+
+#include <string>
+
+#include "net/base/net_errors.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const char kMessage[] =
+    "{\"symbol\": \"GOOG\", \"price\": 585.25, \"volume\": 1200}";
+
+}  // namespace
+
+TEST(WebSocketDeflaterTest, RoundTrip) {
+  WebSocketDeflater deflater;
+  ASSERT_TRUE(deflater.Init(15, 8, true));
+  WebSocketInflater inflater;
+  ASSERT_TRUE(inflater.Init());
+
+  std::string compressed;
+  std::string message;
+  ASSERT_TRUE(deflater.CompressMessage(kMessage, strlen(kMessage),
+                                       &compressed));
+  EXPECT_EQ(OK, inflater.DecompressMessage(compressed.data(),
+                                           compressed.size(), 1024, &message));
+  EXPECT_EQ(kMessage, message);
+
+  // The second copy refers back to the first one.
+  std::string second;
+  ASSERT_TRUE(deflater.CompressMessage(kMessage, strlen(kMessage), &second));
+  EXPECT_LT(second.size(), compressed.size());
+  EXPECT_EQ(OK, inflater.DecompressMessage(second.data(), second.size(),
+                                           1024, &message));
+  EXPECT_EQ(kMessage, message);
+
+  ASSERT_TRUE(deflater.CompressMessage("", 0, &compressed));
+  EXPECT_EQ(OK, inflater.DecompressMessage(compressed.data(),
+                                           compressed.size(), 1024, &message));
+  EXPECT_EQ("", message);
+}
+
+TEST(WebSocketDeflaterTest, NoContextTakeover) {
+  WebSocketDeflater deflater;
+  ASSERT_TRUE(deflater.Init(9, 1, false));
+  EXPECT_FALSE(deflater.context_takeover());
+
+  std::string first;
+  std::string second;
+  ASSERT_TRUE(deflater.CompressMessage(kMessage, strlen(kMessage), &first));
+  ASSERT_TRUE(deflater.CompressMessage(kMessage, strlen(kMessage), &second));
+  EXPECT_EQ(first, second);
+
+  // Each message can be decompressed on its own.
+  WebSocketInflater inflater;
+  ASSERT_TRUE(inflater.Init());
+  std::string message;
+  EXPECT_EQ(OK, inflater.DecompressMessage(second.data(), second.size(),
+                                           1024, &message));
+  EXPECT_EQ(kMessage, message);
+}
+
+TEST(WebSocketDeflaterTest, MessageTooBig) {
+  const std::string large(100 * 1024, 'a');
+  WebSocketDeflater deflater;
+  ASSERT_TRUE(deflater.Init(15, 8, true));
+  std::string compressed;
+  ASSERT_TRUE(deflater.CompressMessage(large.data(), large.size(),
+                                       &compressed));
+
+  WebSocketInflater inflater;
+  ASSERT_TRUE(inflater.Init());
+  std::string message;
+  EXPECT_EQ(ERR_MSG_TOO_BIG,
+            inflater.DecompressMessage(compressed.data(), compressed.size(),
+                                       64 * 1024, &message));
+}
+
+TEST(WebSocketDeflaterTest, BadData) {
+  WebSocketInflater inflater;
+  ASSERT_TRUE(inflater.Init());
+  std::string message;
+  EXPECT_EQ(ERR_CONTENT_DECODING_FAILED,
+            inflater.DecompressMessage("\xff\xff\xff", 3, 1024, &message));
+}
+
+TEST(WebSocketDeflaterTest, Negotiation) {
+  EXPECT_EQ("x-deflate-message", WebSocketDeflater::GetOffer(true));
+  EXPECT_EQ("x-deflate-message; no_context_takeover",
+            WebSocketDeflater::GetOffer(false));
+
+  bool context_takeover = true;
+  EXPECT_TRUE(WebSocketDeflater::ParseResponse("x-deflate-message",
+                                               &context_takeover));
+  EXPECT_TRUE(context_takeover);
+  EXPECT_TRUE(WebSocketDeflater::ParseResponse(
+      "foo, X-Deflate-Message ; no_context_takeover", &context_takeover));
+  EXPECT_FALSE(context_takeover);
+  EXPECT_FALSE(WebSocketDeflater::ParseResponse("deflate-stream",
+                                                &context_takeover));
+  EXPECT_FALSE(WebSocketDeflater::ParseResponse("", &context_takeover));
+}
+
+}  // namespace net
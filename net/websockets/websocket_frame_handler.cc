@@ -9,12 +9,40 @@
 
 #include "net/base/io_buffer.h"
 #include "net/base/net_errors.h"
+#include "net/websockets/websocket_deflater.h"
+
+namespace {
+
+const char kTextFrameType = '\x00';
+const char kCompressedFrameType = '\x80';
+const char kTextFrameEnd = '\xff';
+
+// Appends a length-prefixed frame of |type| holding |message| to |output|.
+void AppendLengthPrefixedFrame(char type, const std::string& message,
+                               std::string* output) {
+  output->push_back(type);
+  // The length is sent in 7-bit groups, the most significant first, with the
+  // high bit set on all but the last.
+  char length[5];
+  int i = arraysize(length);
+  size_t n = message.size();
+  length[--i] = n & 0x7f;
+  while (n >>= 7)
+    length[--i] = 0x80 | (n & 0x7f);
+  output->append(length + i, arraysize(length) - i);
+  output->append(message);
+}
+
+}  // namespace
 
 namespace net {
 
 WebSocketFrameHandler::WebSocketFrameHandler()
     : current_buffer_size_(0),
-      original_current_buffer_size_(0) {
+      original_current_buffer_size_(0),
+      current_buffer_count_(0),
+      max_message_size_(0),
+      in_unfiltered_frame_(false) {
 }
 
 WebSocketFrameHandler::~WebSocketFrameHandler() {
@@ -26,6 +54,20 @@ void WebSocketFrameHandler::AppendData(const char* data, int length) {
   pending_buffers_.push_back(buffer);
 }
 
+void WebSocketFrameHandler::SetDeflater(WebSocketDeflater* deflater,
+                                        int max_message_size) {
+  DCHECK(!inflater_.get());
+  deflater_.reset(deflater);
+  max_message_size_ = max_message_size;
+}
+
+void WebSocketFrameHandler::SetInflater(WebSocketInflater* inflater,
+                                        int max_message_size) {
+  DCHECK(!deflater_.get());
+  inflater_.reset(inflater);
+  max_message_size_ = max_message_size;
+}
+
 int WebSocketFrameHandler::UpdateCurrentBuffer(bool buffered) {
   if (current_buffer_)
     return 0;
@@ -37,23 +79,86 @@ int WebSocketFrameHandler::UpdateCurrentBuffer(bool buffered) {
   scoped_refptr<IOBufferWithSize> buffer = pending_buffers_.front();
 
   int buffer_size = 0;
+  int buffer_count = 1;
   if (buffered) {
-    std::vector<FrameInfo> frame_info;
-    buffer_size =
-        ParseWebSocketFrame(buffer->data(), buffer->size(), &frame_info);
-    if (buffer_size <= 0)
-      return buffer_size;
+    // A frame may be split across the pending buffers.
+    // TODO(ukai): don't copy data.
+    if (pending_buffers_.size() > 1) {
+      int total_size = 0;
+      for (PendingDataQueue::iterator it = pending_buffers_.begin();
+           it != pending_buffers_.end(); ++it)
+        total_size += (*it)->size();
+      buffer = new IOBufferWithSize(total_size);
+      int offset = 0;
+      for (PendingDataQueue::iterator it = pending_buffers_.begin();
+           it != pending_buffers_.end(); ++it) {
+        memcpy(buffer->data() + offset, (*it)->data(), (*it)->size());
+        offset += (*it)->size();
+      }
+      pending_buffers_.clear();
+      pending_buffers_.push_back(buffer);
+    }
 
+    bool filtered = deflater_.get() || inflater_.get();
+    std::vector<FrameInfo> frame_info;
+    if (in_unfiltered_frame_) {
+      const char* frame_end = static_cast<const char*>(
+          memchr(buffer->data(), kTextFrameEnd, buffer->size()));
+      buffer_size = frame_end ? frame_end - buffer->data() + 1 : buffer->size();
+      in_unfiltered_frame_ = !frame_end;
+    } else {
+      buffer_size =
+          ParseWebSocketFrame(buffer->data(), buffer->size(), &frame_info);
+      if (buffer_size < 0)
+        return buffer_size;
+      if (!buffer_size) {
+        if (!filtered || buffer->size() < max_message_size_)
+          return 0;
+        // Only text frames can be passed on before they are complete.
+        if (buffer->data()[0] != kTextFrameType)
+          return ERR_MSG_TOO_BIG;
+        buffer_size = buffer->size();
+        in_unfiltered_frame_ = true;
+      }
+    }
     original_current_buffer_size_ = buffer_size;
-
-    // TODO(ukai): filter(e.g. compress or decompress) frame messages.
+    if (!frame_info.empty()) {
+      buffer_count = frame_info.size();
+      if (filtered) {
+        std::string output;
+        int rv = FilterFrames(frame_info, &output);
+        if (rv != OK)
+          return rv;
+        buffer_size = output.size();
+        buffer = new IOBufferWithSize(buffer_size);
+        memcpy(buffer->data(), output.data(), buffer_size);
+      }
+    }
   } else {
-    original_current_buffer_size_ = buffer->size();
     buffer_size = buffer->size();
+    PendingDataQueue::iterator end = pending_buffers_.begin() + 1;
+    for (; end != pending_buffers_.end() &&
+           buffer_size + (*end)->size() <= kMaxCoalescedBufferSize; ++end) {
+      buffer_size += (*end)->size();
+      ++buffer_count;
+    }
+    if (buffer_count > 1) {
+      buffer = new IOBufferWithSize(buffer_size);
+      int offset = 0;
+      for (PendingDataQueue::iterator it = pending_buffers_.begin();
+           it != end; ++it) {
+        memcpy(buffer->data() + offset, (*it)->data(), (*it)->size());
+        offset += (*it)->size();
+      }
+      pending_buffers_.erase(pending_buffers_.begin(), end);
+      pending_buffers_.push_front(buffer);
+    }
+    original_current_buffer_size_ = buffer_size;
   }
 
   current_buffer_ = buffer;
   current_buffer_size_ = buffer_size;
+  current_buffer_count_ = buffer_count;
   return buffer_size;
 }
 
@@ -82,6 +187,47 @@ void WebSocketFrameHandler::ReleaseCurrentBuffer() {
   current_buffer_ = NULL;
   current_buffer_size_ = 0;
   original_current_buffer_size_ = 0;
+  current_buffer_count_ = 0;
+}
+
+int WebSocketFrameHandler::FilterFrames(const std::vector<FrameInfo>& frames,
+                                        std::string* output) {
+  std::string message;
+  for (std::vector<FrameInfo>::const_iterator it = frames.begin();
+       it != frames.end(); ++it) {
+    char type = it->frame_start[0];
+    if (deflater_.get() && type == kTextFrameType) {
+      if (!deflater_->CompressMessage(it->message_start, it->message_length,
+                                      &message)) {
+        return ERR_UNEXPECTED;
+      }
+      size_t frame_start = output->size();
+      AppendLengthPrefixedFrame(kCompressedFrameType, message, output);
+      // Unless the deflater remembers what it was given, a message that
+      // doesn't get smaller may be sent as it is.
+      if (deflater_->context_takeover() ||
+          output->size() - frame_start <
+              static_cast<size_t>(it->frame_length)) {
+        continue;
+      }
+      output->resize(frame_start);
+    } else if (inflater_.get() && type == kCompressedFrameType) {
+      int rv = inflater_->DecompressMessage(it->message_start,
+                                            it->message_length,
+                                            max_message_size_, &message);
+      if (rv != OK)
+        return rv;
+      // It couldn't be a text message.
+      if (message.find(kTextFrameEnd) != std::string::npos)
+        return ERR_CONTENT_DECODING_FAILED;
+      output->push_back(kTextFrameType);
+      output->append(message);
+      output->push_back(kTextFrameEnd);
+      continue;
+    }
+    output->append(it->frame_start, it->frame_length);
+  }
+  return OK;
 }
 
 /* static */
@@ -7,15 +7,19 @@
 #pragma once
 
 #include <deque>
+#include <string>
 #include <vector>
 
 #include "base/basictypes.h"
 #include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
 
 namespace net {
 
 class IOBuffer;
 class IOBufferWithSize;
+class WebSocketDeflater;
+class WebSocketInflater;
 
 // Handles WebSocket frame messages.
 class WebSocketFrameHandler {
@@ -35,9 +39,28 @@ class WebSocketFrameHandler {
   // For receiving, this is data from network.
   void AppendData(const char* data, int len);
 
+  // The most data UpdateCurrentBuffer(false) puts into one IOBuffer by
+  // joining pending buffers.
+  static const int kMaxCoalescedBufferSize = 16 * 1024;
+
+  // Makes UpdateCurrentBuffer(true) compress the text frames it finds with
+  // |deflater| (for sending).  Takes ownership of |deflater|.
+  // A text frame is kept until it is complete, unless |max_message_size| of
+  // it is pending: then it is passed on as it is.
+  void SetDeflater(WebSocketDeflater* deflater, int max_message_size);
+
+  // Makes UpdateCurrentBuffer(true) decompress the compressed frames it finds
+  // with |inflater| into text frames (for receiving), failing on messages
+  // larger than |max_message_size|.  Takes ownership of |inflater|.
+  void SetInflater(WebSocketInflater* inflater, int max_message_size);
+
   // Updates current IOBuffer.
-  // If |buffered| is true, it tries to find WebSocket frames.
-  // Otherwise, it just picks the first buffer in |pending_buffers_|.
+  // If |buffered| is true, it tries to find WebSocket frames, and
+  // compresses or decompresses them if SetDeflater() or SetInflater() was
+  // called.
+  // Otherwise, it picks the first buffer in |pending_buffers_|, joined with
+  // the buffers after it while they fit in kMaxCoalescedBufferSize, so that
+  // a burst of small messages goes out in one write.
   // Returns available size of data, 0 if no more data or current buffer was
   // not released, and negative if some error occurred.
   int UpdateCurrentBuffer(bool buffered);
@@ -54,6 +77,10 @@ class WebSocketFrameHandler {
   // compressed or decompressed.
   int GetOriginalBufferSize() const { return original_current_buffer_size_; }
 
+  // Returns how many buffers given to AppendData(), or how many frames if it
+  // is buffered, went into current IOBuffer.
+  int GetCurrentBufferCount() const { return current_buffer_count_; }
+
   // Releases current IOBuffer.
   void ReleaseCurrentBuffer();
 
@@ -66,14 +93,26 @@ class WebSocketFrameHandler {
  private:
   typedef std::deque< scoped_refptr<IOBufferWithSize> > PendingDataQueue;
 
+  // Appends |frames| to |output|, compressed or decompressed.
+  int FilterFrames(const std::vector<FrameInfo>& frames, std::string* output);
+
   scoped_refptr<IOBuffer> current_buffer_;
   int current_buffer_size_;
 
   int original_current_buffer_size_;
 
+  int current_buffer_count_;
+
   // Deque of IOBuffers in pending.
   PendingDataQueue pending_buffers_;
 
+  scoped_ptr<WebSocketDeflater> deflater_;
+  scoped_ptr<WebSocketInflater> inflater_;
+  int max_message_size_;
+
+  // True while passing on the rest of a text frame too large to filter.
+  bool in_unfiltered_frame_;
+
   DISALLOW_COPY_AND_ASSIGN(WebSocketFrameHandler);
 };
 
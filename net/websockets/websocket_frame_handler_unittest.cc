@@ -2,8 +2,12 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <string>
+
 #include "base/memory/scoped_ptr.h"
 #include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/websockets/websocket_deflater.h"
 #include "net/websockets/websocket_frame_handler.h"
 
 #include "testing/gmock/include/gmock/gmock.h"
@@ -43,6 +47,116 @@ TEST(WebSocketFrameHandlerTest, Basic) {
   EXPECT_EQ(0, handler->UpdateCurrentBuffer(true));
 }
 
+TEST(WebSocketFrameHandlerTest, CoalescePendingBuffers) {
+  const char kHello[] = "\0hello\xff";
+  const int kHelloLen = sizeof(kHello) - 1;
+  const int kMaxSize = WebSocketFrameHandler::kMaxCoalescedBufferSize;
+  const std::string large(kMaxSize - 1, 'x');
+
+  WebSocketFrameHandler handler;
+  handler.AppendData(kHello, kHelloLen);
+  handler.AppendData(kHello, kHelloLen);
+  handler.AppendData(large.data(), large.size());
+
+  // The first two buffers go out together, but the third doesn't fit.
+  EXPECT_EQ(2 * kHelloLen, handler.UpdateCurrentBuffer(false));
+  EXPECT_EQ(2, handler.GetCurrentBufferCount());
+  EXPECT_EQ(2 * kHelloLen, handler.GetOriginalBufferSize());
+  EXPECT_EQ(0, memcmp(handler.GetCurrentBuffer()->data(), kHello, kHelloLen));
+  EXPECT_EQ(0, memcmp(handler.GetCurrentBuffer()->data() + kHelloLen,
+                      kHello, kHelloLen));
+  handler.ReleaseCurrentBuffer();
+  EXPECT_EQ(0, handler.GetCurrentBufferCount());
+
+  handler.AppendData(kHello, kHelloLen);
+  EXPECT_EQ(kMaxSize - 1, handler.UpdateCurrentBuffer(false));
+  EXPECT_EQ(1, handler.GetCurrentBufferCount());
+  handler.ReleaseCurrentBuffer();
+
+  EXPECT_EQ(kHelloLen, handler.UpdateCurrentBuffer(false));
+  EXPECT_EQ(1, handler.GetCurrentBufferCount());
+  handler.ReleaseCurrentBuffer();
+  EXPECT_EQ(0, handler.UpdateCurrentBuffer(false));
+}
+
+TEST(WebSocketFrameHandlerTest, Deflate) {
+  const char kInputData[] = "\0hello, hello, hello\xff\0hello, hello\xff";
+  const int kInputDataLen = sizeof(kInputData) - 1;
+
+  WebSocketFrameHandler sender;
+  WebSocketDeflater* deflater = new WebSocketDeflater;
+  ASSERT_TRUE(deflater->Init(15, 8, true));
+  sender.SetDeflater(deflater, 1024);
+  WebSocketFrameHandler receiver;
+  WebSocketInflater* inflater = new WebSocketInflater;
+  ASSERT_TRUE(inflater->Init());
+  receiver.SetInflater(inflater, 1024);
+
+  // The frames are only compressed once they are complete.
+  sender.AppendData(kInputData, 10);
+  EXPECT_EQ(0, sender.UpdateCurrentBuffer(true));
+  sender.AppendData(kInputData + 10, kInputDataLen - 10);
+  int compressed_len = sender.UpdateCurrentBuffer(true);
+  EXPECT_GT(compressed_len, 0);
+  EXPECT_LT(compressed_len, kInputDataLen);
+  EXPECT_EQ(kInputDataLen, sender.GetOriginalBufferSize());
+  EXPECT_EQ(2, sender.GetCurrentBufferCount());
+  EXPECT_EQ('\x80', sender.GetCurrentBuffer()->data()[0]);
+
+  receiver.AppendData(sender.GetCurrentBuffer()->data(), compressed_len);
+  sender.ReleaseCurrentBuffer();
+  EXPECT_EQ(kInputDataLen, receiver.UpdateCurrentBuffer(true));
+  EXPECT_EQ(compressed_len, receiver.GetOriginalBufferSize());
+  EXPECT_EQ(std::string(kInputData, kInputDataLen),
+            std::string(receiver.GetCurrentBuffer()->data(),
+                        receiver.GetCurrentBufferSize()));
+  receiver.ReleaseCurrentBuffer();
+  EXPECT_EQ(0, receiver.UpdateCurrentBuffer(true));
+
+  // The closing frame is passed on as it is.
+  sender.AppendData("\xff\0", 2);
+  EXPECT_EQ(2, sender.UpdateCurrentBuffer(true));
+  EXPECT_EQ(0, memcmp(sender.GetCurrentBuffer()->data(), "\xff\0", 2));
+}
+
+TEST(WebSocketFrameHandlerTest, DeflateLargeFrame) {
+  const std::string message(100, 'x');
+
+  WebSocketFrameHandler sender;
+  WebSocketDeflater* deflater = new WebSocketDeflater;
+  ASSERT_TRUE(deflater->Init(15, 8, true));
+  sender.SetDeflater(deflater, 64);
+
+  // Too much of the frame to keep: it is sent uncompressed as it comes.
+  sender.AppendData("\0", 1);
+  sender.AppendData(message.data(), 50);
+  EXPECT_EQ(0, sender.UpdateCurrentBuffer(true));
+  sender.AppendData(message.data(), 50);
+  EXPECT_EQ(101, sender.UpdateCurrentBuffer(true));
+  EXPECT_EQ(101, sender.GetOriginalBufferSize());
+  sender.ReleaseCurrentBuffer();
+
+  sender.AppendData("\xff\0a\xff", 4);
+  EXPECT_EQ(1, sender.UpdateCurrentBuffer(true));
+  EXPECT_EQ('\xff', sender.GetCurrentBuffer()->data()[0]);
+  sender.ReleaseCurrentBuffer();
+
+  // The next frame is compressed again.
+  EXPECT_GT(sender.UpdateCurrentBuffer(true), 0);
+  EXPECT_EQ(3, sender.GetOriginalBufferSize());
+  EXPECT_EQ('\x80', sender.GetCurrentBuffer()->data()[0]);
+}
+
+TEST(WebSocketFrameHandlerTest, InflateBadFrame) {
+  WebSocketFrameHandler receiver;
+  WebSocketInflater* inflater = new WebSocketInflater;
+  ASSERT_TRUE(inflater->Init());
+  receiver.SetInflater(inflater, 1024);
+
+  receiver.AppendData("\x80\x03\xff\xff\xff", 5);
+  EXPECT_EQ(ERR_CONTENT_DECODING_FAILED, receiver.UpdateCurrentBuffer(true));
+}
+
 TEST(WebSocketFrameHandlerTest, ParseFrame) {
   std::vector<WebSocketFrameHandler::FrameInfo> frames;
   const char kInputData[] = "\0hello, world\xff\xff\0";
@@ -172,6 +172,14 @@ size_t WebSocketHandshakeRequestHandler::original_length() const {
   return original_length_;
 }
 
+void WebSocketHandshakeRequestHandler::GetHeaders(
+    const char* const headers_to_get[],
+    size_t headers_to_get_len,
+    std::vector<std::string>* values) const {
+  DCHECK(!headers_.empty());
+  FetchHeaders(headers_, headers_to_get, headers_to_get_len, values);
+}
+
 void WebSocketHandshakeRequestHandler::AppendHeaderIfMissing(
     const std::string& name, const std::string& value) {
   DCHECK(!headers_.empty());
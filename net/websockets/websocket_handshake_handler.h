@@ -36,6 +36,10 @@ class WebSocketHandshakeRequestHandler {
 
   size_t original_length() const;
 
+  // Gets the headers value.
+  void GetHeaders(const char* const headers_to_get[],
+                  size_t headers_to_get_len,
+                  std::vector<std::string>* values) const;
   // Appends the header value pair for |name| and |value|, if |name| doesn't
   // exist.
   void AppendHeaderIfMissing(const std::string& name,
@@ -30,6 +30,17 @@ const char* const kCookieHeaders[] = {
 const char* const kSetCookieHeaders[] = {
   "set-cookie", "set-cookie2"
 };
+const char* const kExtensionsHeaders[] = {
+  "sec-websocket-extensions"
+};
+
+net::WebSocketDeflateParams g_deflate_params = {
+  false,  // enabled
+  15,  // window_bits
+  8,  // mem_level
+  true,  // context_takeover
+  64 * 1024,  // max_message_size
+};
 
 net::SocketStreamJob* WebSocketJobFactory(
     const GURL& url, net::SocketStream::Delegate* delegate) {
@@ -59,6 +70,11 @@ void WebSocketJob::EnsureInit() {
   g_websocket_job_init.Get();
 }
 
+// static
+void WebSocketJob::set_deflate_params(const WebSocketDeflateParams& params) {
+  g_deflate_params = params;
+}
+
 WebSocketJob::WebSocketJob(SocketStream::Delegate* delegate)
     : delegate_(delegate),
       state_(INITIALIZED),
@@ -68,6 +84,9 @@ WebSocketJob::WebSocketJob(SocketStream::Delegate* delegate)
       handshake_response_(new WebSocketHandshakeResponseHandler),
       handshake_request_sent_(0),
       response_cookies_save_index_(0),
+      deflate_params_(g_deflate_params),
+      deflate_offered_(false),
+      deflate_enabled_(false),
       send_frame_handler_(new WebSocketFrameHandler),
       receive_frame_handler_(new WebSocketFrameHandler) {
 }
@@ -104,16 +123,17 @@ bool WebSocketJob::SendData(const char* data, int len) {
         // larger message than max_pending_send_allowed should not be buffered.
         // If we don't call OnSentData, WebCore::SocketStreamHandle would stop
         // sending more data when pending data reaches max_pending_send_allowed.
-        // TODO(ukai): Fix this to support compression for larger message.
+        // When compressing, frames are buffered until they are complete,
+        // but no more than max_pending_send_allowed of a frame, so that
+        // larger messages are sent uncompressed.
+        // Messages given while a write is in flight are joined into one
+        // buffer by |send_frame_handler_|, so they share the next write.
         int err = 0;
         if (!send_frame_handler_->GetCurrentBuffer() &&
-            (err = send_frame_handler_->UpdateCurrentBuffer(false)) > 0) {
+            (err = send_frame_handler_->UpdateCurrentBuffer(
+                deflate_enabled_)) > 0) {
           DCHECK(!current_buffer_);
-          current_buffer_ = new DrainableIOBuffer(
-              send_frame_handler_->GetCurrentBuffer(),
-              send_frame_handler_->GetCurrentBufferSize());
-          return socket_->SendData(
-              current_buffer_->data(), current_buffer_->BytesRemaining());
+          return SendCurrentBuffer();
         }
         return err >= 0;
       }
@@ -222,13 +242,9 @@ void WebSocketJob::OnReceivedData(
   DCHECK(state_ == OPEN || state_ == CLOSING);
   std::string received_data;
   receive_frame_handler_->AppendData(data, len);
-  // Don't buffer receiving data for now.
-  // TODO(ukai): fix performance of WebSocketFrameHandler.
-  while (receive_frame_handler_->UpdateCurrentBuffer(false) > 0) {
-    received_data +=
-        std::string(receive_frame_handler_->GetCurrentBuffer()->data(),
-                    receive_frame_handler_->GetCurrentBufferSize());
-    receive_frame_handler_->ReleaseCurrentBuffer();
+  if (!TakeReceivedFrames(&received_data)) {
+    socket_->Close();
+    return;
   }
   if (delegate_ && !received_data.empty())
       delegate_->OnReceivedData(
@@ -305,6 +321,19 @@ void WebSocketJob::OnCanGetCookiesCompleted(int policy) {
       }
     }
 
+    if (deflate_params_.enabled) {
+      // Leave any extensions the renderer asked for to the renderer.
+      std::vector<std::string> extensions;
+      handshake_request_->GetHeaders(
+          kExtensionsHeaders, arraysize(kExtensionsHeaders), &extensions);
+      if (extensions.empty()) {
+        handshake_request_->AppendHeaderIfMissing(
+            "Sec-WebSocket-Extensions",
+            WebSocketDeflater::GetOffer(deflate_params_.context_takeover));
+        deflate_offered_ = true;
+      }
+    }
+
     const std::string& handshake_request = handshake_request_->GetRawRequest();
     handshake_request_sent_ = 0;
     socket_->net_log()->AddEvent(
@@ -383,15 +412,10 @@ void WebSocketJob::SaveNextCookie() {
     // Actual handshake should be done in WebKit.
     handshake_response_->RemoveHeaders(
         kSetCookieHeaders, arraysize(kSetCookieHeaders));
+    if (deflate_offered_)
+      EnableDeflateIfAccepted();
     std::string received_data = handshake_response_->GetResponse();
-    // Don't buffer receiving data for now.
-    // TODO(ukai): fix performance of WebSocketFrameHandler.
-    while (receive_frame_handler_->UpdateCurrentBuffer(false) > 0) {
-      received_data +=
-          std::string(receive_frame_handler_->GetCurrentBuffer()->data(),
-                      receive_frame_handler_->GetCurrentBufferSize());
-      receive_frame_handler_->ReleaseCurrentBuffer();
-    }
+    bool frames_ok = TakeReceivedFrames(&received_data);
 
     state_ = OPEN;
     if (delegate_)
@@ -402,6 +426,8 @@ void WebSocketJob::SaveNextCookie() {
 
     WebSocketThrottle::GetInstance()->RemoveFromQueue(this);
     WebSocketThrottle::GetInstance()->WakeupSocketIfNecessary();
+    if (!frames_ok && socket_)
+      socket_->Close();
     return;
   }
 
@@ -482,17 +508,79 @@ void WebSocketJob::SendPending() {
   if (current_buffer_)
     return;
   // Current buffer is done.  Try next buffer if any.
-  // Don't buffer sending data. See comment on case OPEN in SendData().
-  if (send_frame_handler_->UpdateCurrentBuffer(false) <= 0) {
-    // No more data to send.
-    if (state_ == CLOSING)
+  // Don't buffer sending data unless it is compressed. See comment on case
+  // OPEN in SendData().
+  int rv = send_frame_handler_->UpdateCurrentBuffer(deflate_enabled_);
+  if (rv <= 0) {
+    // No more data to send, or it can't be sent.
+    if (rv < 0 || state_ == CLOSING)
       socket_->Close();
     return;
   }
+  SendCurrentBuffer();
+}
+
+void WebSocketJob::EnableDeflateIfAccepted() {
+  std::vector<std::string> extensions;
+  handshake_response_->GetHeaders(
+      kExtensionsHeaders, arraysize(kExtensionsHeaders), &extensions);
+  // The renderer didn't ask for the extension, so it mustn't see the answer.
+  handshake_response_->RemoveHeaders(
+      kExtensionsHeaders, arraysize(kExtensionsHeaders));
+
+  bool context_takeover = deflate_params_.context_takeover;
+  bool accepted = false;
+  for (size_t i = 0; i < extensions.size() && !accepted; ++i)
+    accepted = WebSocketDeflater::ParseResponse(extensions[i],
+                                                &context_takeover);
+  if (!accepted)
+    return;
+
+  scoped_ptr<WebSocketDeflater> deflater(new WebSocketDeflater);
+  scoped_ptr<WebSocketInflater> inflater(new WebSocketInflater);
+  if (!deflater->Init(deflate_params_.window_bits, deflate_params_.mem_level,
+                      context_takeover) ||
+      !inflater->Init()) {
+    // The server will send compressed frames that can't be read.
+    LOG(ERROR) << "Unable to initialize WebSocket compression.";
+    return;
+  }
+  // The renderer stops sending once max_pending_send_allowed() bytes haven't
+  // been acknowledged, so no more than that can be kept for compressing.
+  send_frame_handler_->SetDeflater(
+      deflater.release(),
+      std::min(deflate_params_.max_message_size,
+               socket_->max_pending_send_allowed()));
+  receive_frame_handler_->SetInflater(inflater.release(),
+                                      deflate_params_.max_message_size);
+  deflate_enabled_ = true;
+}
+
+bool WebSocketJob::TakeReceivedFrames(std::string* received_data) {
+  // Don't buffer receiving data for now, unless it has to be decompressed.
+  // TODO(ukai): fix performance of WebSocketFrameHandler.
+  int rv;
+  while ((rv = receive_frame_handler_->UpdateCurrentBuffer(
+              deflate_enabled_)) > 0) {
+    received_data->append(receive_frame_handler_->GetCurrentBuffer()->data(),
+                          receive_frame_handler_->GetCurrentBufferSize());
+    receive_frame_handler_->ReleaseCurrentBuffer();
+  }
+  return rv >= 0;
+}
+
+bool WebSocketJob::SendCurrentBuffer() {
+  int messages = send_frame_handler_->GetCurrentBufferCount();
+  if (messages > 1 && socket_->net_log()->IsLoggingAllEvents()) {
+    socket_->net_log()->AddEvent(
+        NetLog::TYPE_WEB_SOCKET_SEND_COALESCED,
+        make_scoped_refptr(new NetLogIntegerParameter("messages", messages)));
+  }
   current_buffer_ = new DrainableIOBuffer(
       send_frame_handler_->GetCurrentBuffer(),
       send_frame_handler_->GetCurrentBufferSize());
-  socket_->SendData(current_buffer_->data(), current_buffer_->BytesRemaining());
+  return socket_->SendData(current_buffer_->data(),
+                           current_buffer_->BytesRemaining());
 }
 
 }  // namespace net
@@ -13,6 +13,7 @@
 #include "net/base/address_list.h"
 #include "net/base/completion_callback.h"
 #include "net/socket_stream/socket_stream_job.h"
+#include "net/websockets/websocket_deflater.h"
 
 class GURL;
 
@@ -44,6 +45,10 @@ class WebSocketJob : public SocketStreamJob, public SocketStream::Delegate {
 
   static void EnsureInit();
 
+  // Sets how the connections made from now on use per-message compression.
+  // It is off by default.
+  static void set_deflate_params(const WebSocketDeflateParams& params);
+
   State state() const { return state_; }
   virtual void Connect();
   virtual bool SendData(const char* data, int len);
@@ -81,6 +86,11 @@ class WebSocketJob : public SocketStreamJob, public SocketStream::Delegate {
   void OnReceivedHandshakeResponse(
       SocketStream* socket, const char* data, int len);
   void SaveCookiesAndNotifyHeaderComplete();
+  // Turns compression on if the server agreed to it.
+  void EnableDeflateIfAccepted();
+  // Appends the frames received so far to |received_data|.  Returns false if
+  // they couldn't be decompressed.
+  bool TakeReceivedFrames(std::string* received_data);
   void SaveNextCookie();
   void OnCanSetCookieCompleted(int policy);
 
@@ -93,6 +103,8 @@ class WebSocketJob : public SocketStreamJob, public SocketStream::Delegate {
   void DoCallback();
 
   void SendPending();
+  // Sends the current buffer of |send_frame_handler_|.
+  bool SendCurrentBuffer();
 
   SocketStream::Delegate* delegate_;
   State state_;
@@ -108,6 +120,11 @@ class WebSocketJob : public SocketStreamJob, public SocketStream::Delegate {
   std::vector<std::string> response_cookies_;
   size_t response_cookies_save_index_;
 
+  const WebSocketDeflateParams deflate_params_;
+  // True if the request offered compression, and if the server agreed.
+  bool deflate_offered_;
+  bool deflate_enabled_;
+
   scoped_ptr<WebSocketFrameHandler> send_frame_handler_;
   scoped_refptr<DrainableIOBuffer> current_buffer_;
   scoped_ptr<WebSocketFrameHandler> receive_frame_handler_;
@@ -505,6 +505,107 @@ TEST_F(WebSocketJobTest, HandshakeWithCookieButNotAllowed) {
   CloseWebSocketJob();
 }
 
+TEST_F(WebSocketJobTest, DeflateHandshake) {
+  WebSocketDeflateParams params = {
+    true,  // enabled
+    15,  // window_bits
+    8,  // mem_level
+    true,  // context_takeover
+    1024,  // max_message_size
+  };
+  WebSocketJob::set_deflate_params(params);
+  GURL url("ws://example.com/demo");
+  MockSocketStreamDelegate delegate;
+  InitWebSocketJob(url, &delegate);
+  params.enabled = false;
+  WebSocketJob::set_deflate_params(params);
+
+  static const char* kHandshakeRequestMessage =
+      "GET /demo HTTP/1.1\r\n"
+      "Host: example.com\r\n"
+      "Connection: Upgrade\r\n"
+      "Sec-WebSocket-Key2: 12998 5 Y3 1  .P00\r\n"
+      "Sec-WebSocket-Protocol: sample\r\n"
+      "Upgrade: WebSocket\r\n"
+      "Sec-WebSocket-Key1: 4 @1  46546xW%0l 1 5\r\n"
+      "Origin: http://example.com\r\n"
+      "\r\n"
+      "^n:ds[4U";
+
+  static const char* kHandshakeRequestExpected =
+      "GET /demo HTTP/1.1\r\n"
+      "Host: example.com\r\n"
+      "Connection: Upgrade\r\n"
+      "Sec-WebSocket-Key2: 12998 5 Y3 1  .P00\r\n"
+      "Sec-WebSocket-Protocol: sample\r\n"
+      "Upgrade: WebSocket\r\n"
+      "Sec-WebSocket-Key1: 4 @1  46546xW%0l 1 5\r\n"
+      "Origin: http://example.com\r\n"
+      "Sec-WebSocket-Extensions: x-deflate-message\r\n"
+      "\r\n"
+      "^n:ds[4U";
+
+  bool sent = websocket_->SendData(kHandshakeRequestMessage,
+                                   strlen(kHandshakeRequestMessage));
+  EXPECT_TRUE(sent);
+  MessageLoop::current()->RunAllPending();
+  EXPECT_EQ(kHandshakeRequestExpected, socket_->sent_data());
+  websocket_->OnSentData(socket_.get(), strlen(kHandshakeRequestExpected));
+  EXPECT_EQ(strlen(kHandshakeRequestMessage), delegate.amount_sent());
+
+  static const char* kHandshakeResponseMessage =
+      "HTTP/1.1 101 WebSocket Protocol Handshake\r\n"
+      "Upgrade: WebSocket\r\n"
+      "Connection: Upgrade\r\n"
+      "Sec-WebSocket-Origin: http://example.com\r\n"
+      "Sec-WebSocket-Location: ws://example.com/demo\r\n"
+      "Sec-WebSocket-Protocol: sample\r\n"
+      "Sec-WebSocket-Extensions: x-deflate-message\r\n"
+      "\r\n"
+      "8jKS'y:G*Co,Wxa-";
+
+  static const char* kHandshakeResponseExpected =
+      "HTTP/1.1 101 WebSocket Protocol Handshake\r\n"
+      "Upgrade: WebSocket\r\n"
+      "Connection: Upgrade\r\n"
+      "Sec-WebSocket-Origin: http://example.com\r\n"
+      "Sec-WebSocket-Location: ws://example.com/demo\r\n"
+      "Sec-WebSocket-Protocol: sample\r\n"
+      "\r\n"
+      "8jKS'y:G*Co,Wxa-";
+
+  websocket_->OnReceivedData(socket_.get(),
+                             kHandshakeResponseMessage,
+                             strlen(kHandshakeResponseMessage));
+  MessageLoop::current()->RunAllPending();
+  EXPECT_EQ(kHandshakeResponseExpected, delegate.received_data());
+  EXPECT_EQ(WebSocketJob::OPEN, GetWebSocketJobState());
+
+  // Text frames are sent compressed, and the renderer is told of the bytes
+  // it gave.
+  static const char kFrame[] = "\0hello, hello, hello, hello\xff";
+  const size_t kFrameLen = sizeof(kFrame) - 1;
+  sent = websocket_->SendData(kFrame, kFrameLen);
+  EXPECT_TRUE(sent);
+  std::string compressed =
+      socket_->sent_data().substr(strlen(kHandshakeRequestExpected));
+  ASSERT_FALSE(compressed.empty());
+  EXPECT_EQ('\x80', compressed[0]);
+  EXPECT_LT(compressed.size(), kFrameLen);
+  websocket_->OnSentData(socket_.get(), compressed.size());
+  EXPECT_EQ(strlen(kHandshakeRequestMessage) + kFrameLen,
+            delegate.amount_sent());
+  MessageLoop::current()->RunAllPending();
+
+  // A compressed frame from the server reaches the renderer as a text frame.
+  websocket_->OnReceivedData(socket_.get(), compressed.data(),
+                             compressed.size());
+  EXPECT_EQ(std::string(kHandshakeResponseExpected) + kFrame,
+            delegate.received_data());
+
+  CloseWebSocketJob();
+}
+
 TEST_F(WebSocketJobTest, HSTSUpgrade) {
   GURL url("ws://upgrademe.com/");
   MockSocketStreamDelegate delegate;
@@ -1185,6 +1185,12 @@ VCDiffResult VCDiffDeltaFileWindow::DecodeCopy(size_t size,
   // address is now based at start of target window
   const char* const target_segment_ptr = parent_->decoded_target()->data() +
                                          target_window_start_pos_;
+  if ((size > 1) && (target_bytes_decoded - address == 1)) {
+    // A recursive copy of the last byte decoded is a run of that byte, which
+    // can be written in one pass instead of in doubling pieces.
+    RunByte(target_segment_ptr[address], size);
+    return RESULT_SUCCESS;
+  }
   while (size > (target_bytes_decoded - address)) {
     // Recursive copy that extends into the yet-to-be-copied target data
     const size_t partial_copy_size = target_bytes_decoded - address;
@@ -60,6 +60,33 @@
         [ 'OS == "win"', { 'include_dirs': [ 'open-vcdiff/vsprojects' ] } ],
       ],
     },
+    {
+      # The encoder is kept out of the sdch library, which only clients
+      # link, and is for servers that encode responses.
+      'target_name': 'sdch_encoder',
+      'type': '<(library)',
+      'dependencies': [
+        'sdch',
+      ],
+      'sources': [
+        'open-vcdiff/src/google/vcencoder.h',
+        'open-vcdiff/src/vcencoder.cc',
+      ],
+      'include_dirs': [
+        'open-vcdiff/src',
+      ],
+      'direct_dependent_settings': {
+        'include_dirs': [
+          'open-vcdiff/src',
+        ],
+      },
+      'conditions': [
+        [ 'OS == "linux"', { 'include_dirs': [ 'linux' ] } ],
+        [ 'OS == "freebsd" or OS == "openbsd"', { 'include_dirs': [ 'bsd' ] } ],
+        [ 'OS == "mac"', { 'include_dirs': [ 'mac' ] } ],
+        [ 'OS == "win"', { 'include_dirs': [ 'open-vcdiff/vsprojects' ] } ],
+      ],
+    },
   ],
 }
 
@@ -59,24 +59,37 @@ FtpDirectoryListingResponseDelegate::FtpDirectoryListingResponseDelegate(
     WebURLLoader* loader,
     const WebURLResponse& response)
     : client_(client),
-      loader_(loader) {
+      loader_(loader),
+      parser_(base::Time::Now()),
+      parsing_failed_(false) {
   Init(response.url());
 }
 
 void FtpDirectoryListingResponseDelegate::OnReceivedData(const char* data,
                                                          int data_len) {
-  buffer_.append(data, data_len);
+  std::vector<FtpDirectoryListingEntry> entries;
+  int rv = parser_.ConsumeData(data, data_len, &entries);
+  SendEntriesToClient(rv, entries);
 }
 
 void FtpDirectoryListingResponseDelegate::OnCompletedRequest() {
   std::vector<FtpDirectoryListingEntry> entries;
-  int rv = net::ParseFtpDirectoryListing(buffer_, base::Time::Now(), &entries);
+  int rv = parser_.ProcessEndOfInput(&entries);
+  SendEntriesToClient(rv, entries);
+}
+
+void FtpDirectoryListingResponseDelegate::SendEntriesToClient(
+    int rv,
+    const std::vector<FtpDirectoryListingEntry>& entries) {
+  if (parsing_failed_)
+    return;
   if (rv != net::OK) {
+    parsing_failed_ = true;
     SendDataToClient("<script>onListingParsingError();</script>\n");
     return;
   }
   for (size_t i = 0; i < entries.size(); i++) {
-    FtpDirectoryListingEntry entry = entries[i];
+    const FtpDirectoryListingEntry& entry = entries[i];
 
     // Skip the current and parent directory entries in the listing. Our header
     // always includes them.
@@ -4,8 +4,12 @@
 
 #include "webkit/glue/glue_serialize.h"
 
+#include <string.h>
+
 #include <string>
+#include <vector>
 
+#include "base/logging.h"
 #include "base/pickle.h"
 #include "base/utf_string_conversions.h"
 #include "googleurl/src/gurl.h"
@@ -30,17 +34,54 @@ using WebKit::WebVector;
 
 namespace webkit_glue {
 
+// The room made up front for a serialized item, when there's no better guess.
+const size_t kSerializedItemSizeHint = 1024;
+
+// A Pickle that can make room up front, and go back to fill in the length of
+// what was written after it.
+class HistoryPickle : public Pickle {
+ public:
+  HistoryPickle() {}
+  HistoryPickle(const char* data, int len) : Pickle(data, len) {}
+
+  // Makes room for |length| more bytes of payload, so that writing them
+  // doesn't reallocate.
+  void Reserve(size_t length) {
+    if (size() + length > capacity())
+      Resize(size() + length);
+  }
+
+  // Writes an int to be set later with SetIntAt, and returns its offset.
+  size_t WriteIntPlaceholder() {
+    size_t offset = payload_size();
+    WriteInt(0);
+    return offset;
+  }
+
+  void SetIntAt(size_t offset, int value) {
+    DCHECK_LE(offset + sizeof(value), payload_size());
+    memcpy(payload() + offset, &value, sizeof(value));
+  }
+
+  size_t payload_length() const { return payload_size(); }
+};
+
 struct SerializeObject {
-  SerializeObject() : iter(NULL) {}
+  explicit SerializeObject(size_t size_hint) : iter(NULL) {
+    pickle.Reserve(size_hint);
+  }
   SerializeObject(const char* data, int len) : pickle(data, len), iter(NULL) {}
 
   std::string GetAsString() {
     return std::string(static_cast<const char*>(pickle.data()), pickle.size());
   }
 
-  Pickle pickle;
+  HistoryPickle pickle;
   mutable void* iter;
   mutable int version;
+  // The URL strings of the item being read or written and of its ancestors,
+  // which later ones can refer to.  See WriteURLString.
+  mutable std::vector<WebString> url_strings;
 };
 
 // TODO(mpcomplete): obsolete versions 1 and 2 after 1/1/2008.
@@ -57,12 +98,14 @@ struct SerializeObject {
 // 8: Adds support for file range and modification time
 // 9: Adds support for itemSequenceNumbers
 // 10: Adds support for blob
+// 11: Writes repeated URL strings as references to earlier ones, and the size
+//     of each child item before it, so that readers can skip children.
 // Should be const, but unit tests may modify it.
 //
 // NOTE: If the version is -1, then the pickle contains only a URL string.
 // See CreateHistoryStateForURL.
 //
-int kVersion = 10;
+int kVersion = 11;
 
 // A bunch of convenience functions to read/write to SerializeObjects.
 // The serializers assume the input data is in the correct format and so does
@@ -177,15 +220,8 @@ inline void WriteString(const WebString& str, SerializeObject* obj) {
   }
 }
 
-// This reads a serialized WebString from obj. If a string can't be read,
-// WebString() is returned.
-inline WebString ReadString(const SerializeObject* obj) {
-  int length;
-
-  // Versions 1, 2, and 3 all start with an integer.
-  if (!obj->pickle.ReadInt(&obj->iter, &length))
-    return WebString();
-
+// Reads the data of a serialized WebString whose length field was |length|.
+inline WebString ReadStringData(const SerializeObject* obj, int length) {
   // Starting with version 2, -1 means WebString().
   if (length == -1)
     return WebString();
@@ -203,6 +239,56 @@ inline WebString ReadString(const SerializeObject* obj) {
                    bytes / sizeof(WebUChar));
 }
 
+// This reads a serialized WebString from obj. If a string can't be read,
+// WebString() is returned.
+inline WebString ReadString(const SerializeObject* obj) {
+  int length;
+
+  // Versions 1, 2, and 3 all start with an integer.
+  if (!obj->pickle.ReadInt(&obj->iter, &length))
+    return WebString();
+  return ReadStringData(obj, length);
+}
+
+// Starting with version 11, a URL string that is equal to an earlier one of
+// the same item or of its ancestors is written as -2 - <index of the earlier
+// one> in the length field.  Only the strings that were written out in full
+// count, so readers find the same index.
+inline void WriteURLString(const WebString& str, SerializeObject* obj) {
+  if (kVersion >= 11 && !str.isEmpty()) {
+    for (size_t i = 0; i < obj->url_strings.size(); ++i) {
+      const WebString& earlier = obj->url_strings[i];
+      if (earlier.length() == str.length() &&
+          !memcmp(earlier.data(), str.data(),
+                  str.length() * sizeof(WebUChar))) {
+        obj->pickle.WriteInt(-2 - static_cast<int>(i));
+        return;
+      }
+    }
+    obj->url_strings.push_back(str);
+  }
+  WriteString(str, obj);
+}
+
+inline WebString ReadURLString(const SerializeObject* obj) {
+  if (obj->version < 11)
+    return ReadString(obj);
+
+  int length;
+  if (!obj->pickle.ReadInt(&obj->iter, &length))
+    return WebString();
+  if (length <= -2) {
+    size_t index = static_cast<size_t>(-2 - length);
+    if (index >= obj->url_strings.size())
+      return WebString();
+    return obj->url_strings[index];
+  }
+  WebString str = ReadStringData(obj, length);
+  if (!str.isEmpty())
+    obj->url_strings.push_back(str);
+  return str;
+}
+
 // Writes a Vector of Strings into a SerializeObject for serialization.
 static void WriteStringVector(
     const WebVector<WebString>& data, SerializeObject* obj) {
@@ -301,8 +387,8 @@ static void WriteHistoryItem(
   // older versions. Similarly, this should NOT save fields with sensitive
   // data, such as password fields.
   WriteInteger(kVersion, obj);
-  WriteString(item.urlString(), obj);
-  WriteString(item.originalURLString(), obj);
+  WriteURLString(item.urlString(), obj);
+  WriteURLString(item.originalURLString(), obj);
   WriteString(item.target(), obj);
   WriteString(item.parent(), obj);
   WriteString(item.title(), obj);
@@ -312,7 +398,7 @@ static void WriteHistoryItem(
   WriteInteger(item.scrollOffset().y, obj);
   WriteBoolean(item.isTargetItem(), obj);
   WriteInteger(item.visitCount(), obj);
-  WriteString(item.referrer(), obj);
+  WriteURLString(item.referrer(), obj);
 
   WriteStringVector(item.documentState(), obj);
 
@@ -331,13 +417,26 @@ static void WriteHistoryItem(
   // compatibility with the format.
   WriteFormData(item.httpBody(), obj);
   WriteString(item.httpContentType(), obj);
-  WriteString(item.referrer(), obj);
+  WriteURLString(item.referrer(), obj);
 
-  // Subitems
+  // Subitems.  The URL strings of a child can't be referred to by its
+  // siblings, so that readers may skip it.
   const WebVector<WebHistoryItem>& children = item.children();
   WriteInteger(static_cast<int>(children.size()), obj);
-  for (size_t i = 0, c = children.size(); i < c; ++i)
-    WriteHistoryItem(children[i], obj);
+  size_t num_url_strings = obj->url_strings.size();
+  for (size_t i = 0, c = children.size(); i < c; ++i) {
+    if (kVersion >= 11) {
+      size_t size_offset = obj->pickle.WriteIntPlaceholder();
+      size_t start = obj->pickle.payload_length();
+      WriteHistoryItem(children[i], obj);
+      obj->pickle.SetIntAt(
+          size_offset,
+          static_cast<int>(obj->pickle.payload_length() - start));
+    } else {
+      WriteHistoryItem(children[i], obj);
+    }
+    obj->url_strings.resize(num_url_strings);
+  }
 }
 
 // Creates a new HistoryItem tree based on the serialized string.
@@ -345,7 +444,8 @@ static void WriteHistoryItem(
 static WebHistoryItem ReadHistoryItem(
     const SerializeObject* obj,
     bool include_form_data,
-    bool include_scroll_offset) {
+    bool include_scroll_offset,
+    bool include_children) {
   // See note in WriteHistoryItem. on this.
   obj->version = ReadInteger(obj);
 
@@ -363,8 +463,8 @@ static WebHistoryItem ReadHistoryItem(
   WebHistoryItem item;
   item.initialize();
 
-  item.setURLString(ReadString(obj));
-  item.setOriginalURLString(ReadString(obj));
+  item.setURLString(ReadURLString(obj));
+  item.setOriginalURLString(ReadURLString(obj));
   item.setTarget(ReadString(obj));
   item.setParent(ReadString(obj));
   item.setTitle(ReadString(obj));
@@ -378,7 +478,7 @@ static WebHistoryItem ReadHistoryItem(
 
   item.setIsTargetItem(ReadBoolean(obj));
   item.setVisitCount(ReadInteger(obj));
-  item.setReferrer(ReadString(obj));
+  item.setReferrer(ReadURLString(obj));
 
   item.setDocumentState(ReadStringVector(obj));
 
@@ -397,18 +497,42 @@ static WebHistoryItem ReadHistoryItem(
   // The extra referrer string is read for backwards compat.
   const WebHTTPBody& http_body = ReadFormData(obj);
   const WebString& http_content_type = ReadString(obj);
-  ALLOW_UNUSED const WebString& unused_referrer = ReadString(obj);
+  ALLOW_UNUSED const WebString& unused_referrer = ReadURLString(obj);
   if (include_form_data) {
     item.setHTTPBody(http_body);
     item.setHTTPContentType(http_content_type);
   }
 
   // Subitems
+  int version = obj->version;
   int num_children = ReadInteger(obj);
-  for (int i = 0; i < num_children; ++i)
-    item.appendToChildren(ReadHistoryItem(obj,
-                                          include_form_data,
-                                          include_scroll_offset));
+  size_t num_url_strings = obj->url_strings.size();
+  for (int i = 0; i < num_children; ++i) {
+    if (version < 11) {
+      // The child has to be parsed to find where it ends.
+      const WebHistoryItem& child = ReadHistoryItem(obj,
+                                                    include_form_data,
+                                                    include_scroll_offset,
+                                                    true);
+      if (include_children)
+        item.appendToChildren(child);
+      continue;
+    }
+
+    int size = ReadInteger(obj);
+    const char* start = static_cast<const char*>(obj->iter);
+    if (!obj->pickle.IteratorHasRoomFor(start, size))
+      break;
+    if (include_children) {
+      item.appendToChildren(ReadHistoryItem(obj,
+                                            include_form_data,
+                                            include_scroll_offset,
+                                            true));
+      obj->url_strings.resize(num_url_strings);
+    }
+    // Whatever the child read, carry on right after it.
+    obj->iter = const_cast<char*>(start + size);
+  }
 
   return item;
 }
@@ -418,7 +542,16 @@ std::string HistoryItemToString(const WebHistoryItem& item) {
   if (item.isNull())
     return std::string();
 
-  SerializeObject obj;
+  SerializeObject obj(kSerializedItemSizeHint);
+  WriteHistoryItem(item, &obj);
+  return obj.GetAsString();
+}
+
+// Like HistoryItemToString, for an item that was read from |serialized_item|.
+static std::string HistoryItemToStringLike(
+    const WebHistoryItem& item,
+    const std::string& serialized_item) {
+  SerializeObject obj(serialized_item.size());
   WriteHistoryItem(item, &obj);
   return obj.GetAsString();
 }
@@ -427,22 +560,31 @@ std::string HistoryItemToString(const WebHistoryItem& item) {
 // This assumes that the given serialized string has all the required key,value
 // pairs, and does minimal error checking. If |include_form_data| is true,
 // the form data from a post is restored, otherwise the form data is empty.
-// If |include_scroll_offset| is true, the scroll offset is restored.
+// If |include_scroll_offset| is true, the scroll offset is restored.  If
+// |include_children| is false, the child items are left out; with version 11
+// and later, they are skipped without being parsed.
 static WebHistoryItem HistoryItemFromString(
     const std::string& serialized_item,
     bool include_form_data,
-    bool include_scroll_offset) {
+    bool include_scroll_offset,
+    bool include_children) {
   if (serialized_item.empty())
     return WebHistoryItem();
 
   SerializeObject obj(serialized_item.data(),
                       static_cast<int>(serialized_item.length()));
-  return ReadHistoryItem(&obj, include_form_data, include_scroll_offset);
+  return ReadHistoryItem(&obj, include_form_data, include_scroll_offset,
+                         include_children);
 }
 
 WebHistoryItem HistoryItemFromString(
     const std::string& serialized_item) {
-  return HistoryItemFromString(serialized_item, true, true);
+  return HistoryItemFromString(serialized_item, true, true, true);
+}
+
+WebHistoryItem HistoryItemFromStringWithoutChildren(
+    const std::string& serialized_item) {
+  return HistoryItemFromString(serialized_item, true, true, false);
 }
 
 // For testing purposes only.
@@ -457,7 +599,7 @@ void HistoryItemToVersionedString(const WebHistoryItem& item, int version,
   int real_version = kVersion;
   kVersion = version;
 
-  SerializeObject obj;
+  SerializeObject obj(kSerializedItemSizeHint);
   WriteHistoryItem(item, &obj);
   *serialized_item = obj.GetAsString();
 
@@ -470,7 +612,7 @@ std::string CreateHistoryStateForURL(const GURL& url) {
   // serialization of the given URL with a dummy version number of -1.  This
   // will be interpreted by ReadHistoryItem as a request to create a default
   // WebHistoryItem.
-  SerializeObject obj;
+  SerializeObject obj(0);
   WriteInteger(-1, &obj);
   WriteGURL(url, &obj);
   return obj.GetAsString();
@@ -480,13 +622,13 @@ std::string RemoveFormDataFromHistoryState(const std::string& content_state) {
   // TODO(darin): We should avoid using the WebKit API here, so that we do not
   // need to have WebKit initialized before calling this method.
   const WebHistoryItem& item =
-      HistoryItemFromString(content_state, false, true);
+      HistoryItemFromString(content_state, false, true, true);
   if (item.isNull()) {
     // Couldn't parse the string, return an empty string.
     return std::string();
   }
 
-  return HistoryItemToString(item);
+  return HistoryItemToStringLike(item, content_state);
 }
 
 std::string RemoveScrollOffsetFromHistoryState(
@@ -494,13 +636,13 @@ std::string RemoveScrollOffsetFromHistoryState(
   // TODO(darin): We should avoid using the WebKit API here, so that we do not
   // need to have WebKit initialized before calling this method.
   const WebHistoryItem& item =
-      HistoryItemFromString(content_state, true, false);
+      HistoryItemFromString(content_state, true, false, true);
   if (item.isNull()) {
     // Couldn't parse the string, return an empty string.
     return std::string();
   }
 
-  return HistoryItemToString(item);
+  return HistoryItemToStringLike(item, content_state);
 }
 
 }  // namespace webkit_glue
@@ -21,6 +21,11 @@ std::string HistoryItemToString(
 WebKit::WebHistoryItem HistoryItemFromString(
     const std::string& serialized_item);
 
+// Like HistoryItemFromString, but leaves out the items of the child frames.
+// With the current format they are skipped without being parsed.
+WebKit::WebHistoryItem HistoryItemFromStringWithoutChildren(
+    const std::string& serialized_item);
+
 // For testing purposes only.
 void HistoryItemToVersionedString(
     const WebKit::WebHistoryItem& item, int version,
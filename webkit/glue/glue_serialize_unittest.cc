@@ -159,6 +159,47 @@ TEST_F(GlueSerializeTest, HistoryItemSerializeTest) {
   HistoryItemExpectEqual(item, deserialized_item);
 }
 
+// Makes sure that the URL strings shared by a tree of items are only written
+// once, and are read back in the right places.
+TEST_F(GlueSerializeTest, SharedURLStringsTest) {
+  WebHistoryItem item = MakeHistoryItem(true, false);
+  item.setOriginalURLString(item.urlString());
+  WebHistoryItem child = MakeHistoryItem(false, true);
+  child.setReferrer(item.urlString());
+  child.setOriginalURLString(WebString::fromUTF8("originalURLString"));
+  item.appendToChildren(child);
+  item.appendToChildren(MakeHistoryItem(false, false));
+
+  const std::string& serialized_item = webkit_glue::HistoryItemToString(item);
+  const WebHistoryItem& deserialized_item =
+      webkit_glue::HistoryItemFromString(serialized_item);
+  ASSERT_FALSE(deserialized_item.isNull());
+  HistoryItemExpectEqual(item, deserialized_item);
+
+  std::string old_serialized_item;
+  webkit_glue::HistoryItemToVersionedString(item, 10, &old_serialized_item);
+  EXPECT_LT(serialized_item.size(), old_serialized_item.size());
+  HistoryItemExpectEqual(
+      item, webkit_glue::HistoryItemFromString(old_serialized_item));
+}
+
+// Checks that the children can be left out, with the current format and with
+// the previous one.
+TEST_F(GlueSerializeTest, WithoutChildrenTest) {
+  WebHistoryItem item = MakeHistoryItem(true, true);
+  item.appendToChildren(MakeHistoryItem(true, true));
+  WebHistoryItem expected = MakeHistoryItem(true, false);
+
+  for (int version = 10; version <= 11; ++version) {
+    std::string serialized_item;
+    webkit_glue::HistoryItemToVersionedString(item, version, &serialized_item);
+    const WebHistoryItem& deserialized_item =
+        webkit_glue::HistoryItemFromStringWithoutChildren(serialized_item);
+    ASSERT_FALSE(deserialized_item.isNull());
+    HistoryItemExpectEqual(expected, deserialized_item);
+  }
+}
+
 // Checks that broken messages don't take out our process.
 TEST_F(GlueSerializeTest, BadMessagesTest) {
   {
@@ -1,9 +1,16 @@
-// Copyright (c) 2006-2009 The Chromium Authors. All rights reserved.
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
 #include "webkit/glue/image_decoder.h"
 
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/message_loop_proxy.h"
+#include "base/task.h"
+#include "base/threading/worker_pool.h"
+#include "skia/ext/image_operations.h"
 #include "third_party/WebKit/Source/WebKit/chromium/public/WebData.h"
 #include "third_party/WebKit/Source/WebKit/chromium/public/WebImage.h"
 #include "third_party/WebKit/Source/WebKit/chromium/public/WebSize.h"
@@ -18,24 +25,113 @@ using WebKit::WebImage;
 
 namespace webkit_glue {
 
-ImageDecoder::ImageDecoder() : desired_icon_size_(0, 0) {
+ImageDecoder::Request::Request(const gfx::Size& desired_size,
+                               ScaleMode scale_mode,
+                               const std::string& data,
+                               DecodeCallback* callback)
+    : desired_size_(desired_size),
+      scale_mode_(scale_mode),
+      data_(data),
+      callback_(callback),
+      origin_loop_(base::MessageLoopProxy::CreateForCurrentThread()) {
+}
+
+ImageDecoder::Request::~Request() {
+}
+
+void ImageDecoder::Request::Cancel() {
+  DCHECK(origin_loop_->BelongsToCurrentThread());
+  callback_.reset();
+}
+
+void ImageDecoder::Request::DecodeOnWorkerThread() {
+  SkBitmap bitmap = DecodeImage(
+      reinterpret_cast<const unsigned char*>(data_.data()), data_.size(),
+      desired_size_, scale_mode_);
+  // The encoded data is not needed anymore; don't keep it around until the
+  // result is delivered.
+  std::string().swap(data_);
+  origin_loop_->PostTask(FROM_HERE, NewRunnableMethod(
+      this, &Request::DeliverResult, bitmap));
+}
+
+void ImageDecoder::Request::DeliverResult(const SkBitmap& bitmap) {
+  // The callback may cancel or release us.
+  scoped_refptr<Request> protect(this);
+  scoped_ptr<DecodeCallback> callback(callback_.release());
+  if (callback.get())
+    callback->Run(bitmap);
+}
+
+ImageDecoder::ImageDecoder()
+    : desired_icon_size_(0, 0),
+      scale_mode_(KEEP_SIZE) {
 }
 
 ImageDecoder::ImageDecoder(const gfx::Size& desired_icon_size)
-    : desired_icon_size_(desired_icon_size) {
+    : desired_icon_size_(desired_icon_size),
+      scale_mode_(KEEP_SIZE) {
+}
+
+ImageDecoder::ImageDecoder(const gfx::Size& desired_icon_size,
+                           ScaleMode scale_mode)
+    : desired_icon_size_(desired_icon_size),
+      scale_mode_(scale_mode) {
 }
 
 ImageDecoder::~ImageDecoder() {
 }
 
 SkBitmap ImageDecoder::Decode(const unsigned char* data, size_t size) const {
+  return DecodeImage(data, size, desired_icon_size_, scale_mode_);
+}
+
+scoped_refptr<ImageDecoder::Request> ImageDecoder::DecodeAsync(
+    const std::string& data,
+    DecodeCallback* callback) const {
+  scoped_refptr<Request> request(
+      new Request(desired_icon_size_, scale_mode_, data, callback));
+  base::WorkerPool::PostTask(
+      FROM_HERE, NewRunnableMethod(request.get(),
+                                   &Request::DecodeOnWorkerThread),
+      false);
+  return request;
+}
+
+// static
+SkBitmap ImageDecoder::DecodeImage(const unsigned char* data, size_t size,
+                                   const gfx::Size& desired_size,
+                                   ScaleMode scale_mode) {
+  // For an .ico, WebImage picks the frame that is closest to |desired_size|,
+  // and only that frame is decoded.
   const WebImage& image = WebImage::fromData(
-      WebData(reinterpret_cast<const char*>(data), size), desired_icon_size_);
+      WebData(reinterpret_cast<const char*>(data), size), desired_size);
 #if WEBKIT_USING_SKIA
-  return image.getSkBitmap();
+  SkBitmap bitmap = image.getSkBitmap();
 #elif WEBKIT_USING_CG
-  return gfx::CGImageToSkBitmap(image.getCGImageRef());
+  SkBitmap bitmap = gfx::CGImageToSkBitmap(image.getCGImageRef());
 #endif
+
+  if (scale_mode == KEEP_SIZE || desired_size.IsEmpty() || bitmap.empty() ||
+      (bitmap.width() <= desired_size.width() &&
+       bitmap.height() <= desired_size.height())) {
+    return bitmap;
+  }
+
+  // Shrink along the dimension that is the furthest over, so that the other
+  // one fits too.
+  int width = desired_size.width();
+  int height = desired_size.height();
+  if (static_cast<int64>(bitmap.width()) * desired_size.height() >
+      static_cast<int64>(bitmap.height()) * desired_size.width()) {
+    height = std::max(1, static_cast<int>(
+        static_cast<int64>(bitmap.height()) * width / bitmap.width()));
+  } else {
+    width = std::max(1, static_cast<int>(
+        static_cast<int64>(bitmap.width()) * height / bitmap.height()));
+  }
+  return skia::ImageOperations::Resize(
+      bitmap, skia::ImageOperations::RESIZE_LANCZOS3, width, height);
 }
 
 }  // namespace webkit_glue
@@ -1,12 +1,24 @@
-// Copyright (c) 2010 The Chromium Authors. All rights reserved.
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#ifndef WEBKIT_GLUE_IMAGE_DECODER_H_
+#define WEBKIT_GLUE_IMAGE_DECODER_H_
+
+#include <string>
+
 #include "base/basictypes.h"
+#include "base/callback.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
 #include "ui/gfx/size.h"
 
 class SkBitmap;
 
+namespace base {
+class MessageLoopProxy;
+}
+
 namespace webkit_glue {
 
 // Provides an interface to WebKit's image decoders.
@@ -16,22 +28,77 @@ namespace webkit_glue {
 // the other way around.
 class ImageDecoder {
  public:
+  // What to do with an image that is larger than the desired size.
+  enum ScaleMode {
+    // Return it as it is; only the frame of an .ico is picked by size.
+    KEEP_SIZE,
+    // Shrink it, keeping its aspect ratio, so that it fits in the desired
+    // size. Smaller images are returned as they are.
+    SHRINK_TO_FIT,
+  };
+
+  typedef Callback1<const SkBitmap&>::Type DecodeCallback;
+
+  // A decode started by DecodeAsync().
+  class Request : public base::RefCountedThreadSafe<Request> {
+   public:
+    // Deletes the callback without running it. Must be called on the thread
+    // that started the decode.
+    void Cancel();
+
+   private:
+    friend class ImageDecoder;
+    friend class base::RefCountedThreadSafe<Request>;
+
+    Request(const gfx::Size& desired_size, ScaleMode scale_mode,
+            const std::string& data, DecodeCallback* callback);
+    ~Request();
+
+    // Runs on the worker thread.
+    void DecodeOnWorkerThread();
+    // Runs back on |origin_loop_|.
+    void DeliverResult(const SkBitmap& bitmap);
+
+    const gfx::Size desired_size_;
+    const ScaleMode scale_mode_;
+    std::string data_;
+    scoped_ptr<DecodeCallback> callback_;
+    scoped_refptr<base::MessageLoopProxy> origin_loop_;
+
+    DISALLOW_COPY_AND_ASSIGN(Request);
+  };
+
   // Use the constructor with desired_size when you think you may have an .ico
   // format and care about which size you get back. Otherwise, use the 0-arg
   // constructor.
   ImageDecoder();
   ImageDecoder(const gfx::Size& desired_icon_size);
+  ImageDecoder(const gfx::Size& desired_icon_size, ScaleMode scale_mode);
   ~ImageDecoder();
 
   // Call this function to decode the image. If successful, the decoded image
   // will be returned. Otherwise, an empty bitmap will be returned.
   SkBitmap Decode(const unsigned char* data, size_t size) const;
 
+  // Like Decode(), but decodes a copy of |data| on a worker thread, and runs
+  // |callback| with the image on the calling thread, which must have a
+  // MessageLoop. Takes ownership of |callback|.
+  scoped_refptr<Request> DecodeAsync(const std::string& data,
+                                     DecodeCallback* callback) const;
+
  private:
+  static SkBitmap DecodeImage(const unsigned char* data, size_t size,
+                              const gfx::Size& desired_size,
+                              ScaleMode scale_mode);
+
   // Size will be empty to get the largest possible size.
   gfx::Size desired_icon_size_;
 
+  ScaleMode scale_mode_;
+
   DISALLOW_COPY_AND_ASSIGN(ImageDecoder);
 };
 
 }  // namespace webkit_glue
+
+#endif  // WEBKIT_GLUE_IMAGE_DECODER_H_
@@ -35,22 +35,34 @@ ImageResourceFetcher::ImageResourceFetcher(
 ImageResourceFetcher::~ImageResourceFetcher() {
   if (!fetcher_->completed())
     fetcher_->Cancel();
+  if (decode_request_)
+    decode_request_->Cancel();
 }
 
 void ImageResourceFetcher::OnURLFetchComplete(
     const WebURLResponse& response,
     const std::string& data) {
-  SkBitmap bitmap;
   if (!response.isNull() && response.httpStatusCode() == 200) {
-    // Request succeeded, try to convert it to an image.
-    ImageDecoder decoder(gfx::Size(image_size_, image_size_));
-    bitmap = decoder.Decode(
-        reinterpret_cast<const unsigned char*>(data.data()), data.size());
-  } // else case:
-    // If we get here, it means no image from server or couldn't decode the
-    // response as an image. The delegate will see a null image, indicating
-    // that an error occurred.
+    // Request succeeded, try to convert it to an image, off this
+    // thread.
+    ImageDecoder decoder(gfx::Size(image_size_, image_size_),
+                         ImageDecoder::SHRINK_TO_FIT);
+    decode_request_ = decoder.DecodeAsync(
+        data, NewCallback(this, &ImageResourceFetcher::OnImageDecoded));
+    return;
+  }
+  // If we get here, it means no image from server. The delegate will see a
+  // null image, indicating that an error occurred.
+  RunCallback(SkBitmap());
+}
+
+void ImageResourceFetcher::OnImageDecoded(const SkBitmap& bitmap) {
+  // An empty bitmap means the response couldn't be decoded as an image.
+  decode_request_ = NULL;
+  RunCallback(bitmap);
+}
 
+void ImageResourceFetcher::RunCallback(const SkBitmap& bitmap) {
   // Take care to clear callback_ before running the callback as it may lead to
   // our destruction.
   scoped_ptr<Callback> callback;
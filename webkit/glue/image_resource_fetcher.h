@@ -7,6 +7,8 @@
 
 #include "base/basictypes.h"
 #include "base/callback.h"
+#include "base/memory/ref_counted.h"
+#include "webkit/glue/image_decoder.h"
 #include "webkit/glue/resource_fetcher.h"
 
 class SkBitmap;
@@ -36,10 +38,16 @@ class ImageResourceFetcher {
   int id() const { return id_; }
 
  private:
-  // ResourceFetcher::Callback. Decodes the image and invokes callback_.
+  // ResourceFetcher::Callback. Starts decoding the image.
   void OnURLFetchComplete(const WebKit::WebURLResponse& response,
                           const std::string& data);
 
+  // ImageDecoder::DecodeCallback. Invokes callback_.
+  void OnImageDecoded(const SkBitmap& bitmap);
+
+  // Runs callback_ with |bitmap|.
+  void RunCallback(const SkBitmap& bitmap);
+
   scoped_ptr<Callback> callback_;
 
   // Unique identifier for the request.
@@ -48,11 +56,14 @@ class ImageResourceFetcher {
   // URL of the image.
   const GURL image_url_;
 
-  // The size of the image. This is only a hint that is used if the image
-  // contains multiple sizes. A value of 0 results in using the first frame
-  // of the image.
+  // The size of the image. This picks the frame of an image that contains
+  // multiple sizes, and larger images are shrunk to fit in it. A value of 0
+  // results in using the first frame of the image, as it is.
   const int image_size_;
 
+  // The decode of the downloaded image, while it runs on a worker thread.
+  scoped_refptr<ImageDecoder::Request> decode_request_;
+
   // Does the actual download.
   scoped_ptr<ResourceFetcher> fetcher_;
 
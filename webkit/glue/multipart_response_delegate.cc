@@ -63,16 +63,16 @@ MultipartResponseDelegate::MultipartResponseDelegate(
       loader_(loader),
       original_response_(response),
       encoded_data_length_(0),
-      boundary_("--"),
+      header_scan_offset_(0),
       first_received_data_(true),
       processing_headers_(false),
       stop_sending_(false),
       has_sent_first_response_(false) {
   // Some servers report a boundary prefixed with "--".  See bug 5786.
   if (StartsWithASCII(boundary, "--", true)) {
-    boundary_.assign(boundary);
+    SetBoundary(boundary);
   } else {
-    boundary_.append(boundary);
+    SetBoundary("--" + boundary);
   }
 }
 
@@ -110,39 +110,45 @@ void MultipartResponseDelegate::OnReceivedData(const char* data,
   }
   DCHECK(!first_received_data_);
 
+  // Everything in data_ before |pos| has been handled.  It is dropped once,
+  // at the end, rather than after every part.
+  size_t pos = 0;
+
   // Headers
   if (processing_headers_) {
-    // Eat leading \r\n
-    int pos = PushOverLine(data_, 0);
+    // Eat leading \r\n.  The lines seen so far have to be scanned again
+    // when that happens.
+    pos = PushOverLine(data_, 0);
     if (pos)
-      data_ = data_.substr(pos);
+      header_scan_offset_ = 0;
 
-    if (ParseHeaders()) {
+    if (ParseHeaders(&pos)) {
       // Successfully parsed headers.
       processing_headers_ = false;
     } else {
       // Get more data before trying again.
+      data_.erase(0, pos);
       return;
     }
   }
   DCHECK(!processing_headers_);
 
   size_t boundary_pos;
-  while ((boundary_pos = FindBoundary()) != std::string::npos) {
+  while ((boundary_pos = FindBoundary(pos)) != std::string::npos) {
     if (client_) {
       // Strip out trailing \n\r characters in the buffer preceding the
       // boundary on the same lines as Firefox.
-      size_t data_length = boundary_pos;
-      if (boundary_pos > 0 && data_[boundary_pos - 1] == '\n') {
+      size_t data_length = boundary_pos - pos;
+      if (data_length > 0 && data_[boundary_pos - 1] == '\n') {
         data_length--;
-        if (boundary_pos > 1 && data_[boundary_pos - 2] == '\r') {
+        if (boundary_pos - pos > 1 && data_[boundary_pos - 2] == '\r') {
           data_length--;
         }
       }
       if (data_length > 0) {
         // Send the last data chunk.
         client_->didReceiveData(loader_,
-                                data_.data(),
+                                data_.data() + pos,
                                 static_cast<int>(data_length),
                                 encoded_data_length_);
         encoded_data_length_ = 0;
@@ -157,11 +163,10 @@ void MultipartResponseDelegate::OnReceivedData(const char* data,
     }
 
     // We can now throw out data up through the boundary
-    int offset = PushOverLine(data_, boundary_end_pos);
-    data_ = data_.substr(boundary_end_pos + offset);
+    pos = boundary_end_pos + PushOverLine(data_, boundary_end_pos);
 
     // Ok, back to parsing headers
-    if (!ParseHeaders()) {
+    if (!ParseHeaders(&pos)) {
       processing_headers_ = true;
       break;
     }
@@ -169,20 +174,22 @@ void MultipartResponseDelegate::OnReceivedData(const char* data,
 
   // At this point, we should send over any data we have, but keep enough data
   // buffered to handle a boundary that may have been truncated.
-  if (!processing_headers_ && data_.length() > boundary_.length()) {
+  size_t remaining = data_.length() - pos;
+  if (!processing_headers_ && remaining > boundary_.length()) {
     // If the last character is a new line character, go ahead and just send
     // everything we have buffered.  This matches an optimization in Gecko.
-    int send_length = data_.length() - boundary_.length();
+    size_t send_length = remaining - boundary_.length();
     if (data_[data_.length() - 1] == '\n')
-      send_length = data_.length();
+      send_length = remaining;
     if (client_)
       client_->didReceiveData(loader_,
-                              data_.data(),
-                              send_length,
+                              data_.data() + pos,
+                              static_cast<int>(send_length),
                               encoded_data_length_);
-    data_ = data_.substr(send_length);
+    pos += send_length;
     encoded_data_length_ = 0;
   }
+  data_.erase(0, pos);
 }
 
 void MultipartResponseDelegate::OnCompletedRequest() {
@@ -208,12 +215,13 @@ int MultipartResponseDelegate::PushOverLine(const std::string& data,
   return offset;
 }
 
-bool MultipartResponseDelegate::ParseHeaders() {
+bool MultipartResponseDelegate::ParseHeaders(size_t* pos) {
   int line_feed_increment = 1;
 
-  // Grab the headers being liberal about line endings.
-  size_t line_start_pos = 0;
-  size_t line_end_pos = data_.find('\n');
+  // Grab the headers being liberal about line endings.  The lines before
+  // |header_scan_offset_| were seen by the last call.
+  size_t line_start_pos = *pos + header_scan_offset_;
+  size_t line_end_pos = data_.find('\n', line_start_pos);
   while (line_end_pos != std::string::npos) {
     // Handle CRLF
     if (line_end_pos > line_start_pos && data_[line_end_pos - 1] == '\r') {
@@ -232,13 +240,16 @@ bool MultipartResponseDelegate::ParseHeaders() {
     line_end_pos = data_.find('\n', line_start_pos);
   }
   // Truncated in the middle of a header, stop parsing.
-  if (line_end_pos == std::string::npos)
+  if (line_end_pos == std::string::npos) {
+    header_scan_offset_ = line_start_pos - *pos;
     return false;
+  }
+  header_scan_offset_ = 0;
 
   // Eat headers
   std::string headers("\n");
-  headers.append(data_, 0, line_end_pos);
-  data_ = data_.substr(line_end_pos);
+  headers.append(data_, *pos, line_end_pos - *pos);
+  *pos = line_end_pos;
 
   // Create a WebURLResponse based on the original set of headers + the
   // replacement headers.  We only replace the same few headers that gecko
@@ -279,22 +290,43 @@ bool MultipartResponseDelegate::ParseHeaders() {
 
 // Boundaries are supposed to be preceeded with --, but it looks like gecko
 // doesn't require the dashes to exist.  See nsMultiMixedConv::FindToken.
-size_t MultipartResponseDelegate::FindBoundary() {
-  size_t boundary_pos = data_.find(boundary_);
+size_t MultipartResponseDelegate::FindBoundary(size_t pos) {
+  // Boyer-Moore-Horspool: compare the last character of the token first, and
+  // skip ahead by how far that character is from the end of the token.
+  const size_t last = boundary_.length() - 1;
+  size_t boundary_pos = std::string::npos;
+  for (size_t i = pos; i + last < data_.length();
+       i += boundary_skip_[static_cast<unsigned char>(data_[i + last])]) {
+    if (data_[i + last] == boundary_[last] &&
+        data_.compare(i, last, boundary_, 0, last) == 0) {
+      boundary_pos = i;
+      break;
+    }
+  }
   if (boundary_pos != std::string::npos) {
     // Back up over -- for backwards compat
     // TODO(tc): Don't we only want to do this once?  Gecko code doesn't seem
     // to care.
-    if (boundary_pos >= 2) {
+    if (boundary_pos >= pos + 2) {
       if ('-' == data_[boundary_pos - 1] && '-' == data_[boundary_pos - 2]) {
         boundary_pos -= 2;
-        boundary_ = "--" + boundary_;
+        SetBoundary("--" + boundary_);
       }
     }
   }
   return boundary_pos;
 }
 
+void MultipartResponseDelegate::SetBoundary(const std::string& boundary) {
+  DCHECK(!boundary.empty());
+  boundary_ = boundary;
+  const size_t last = boundary_.length() - 1;
+  for (size_t i = 0; i < arraysize(boundary_skip_); ++i)
+    boundary_skip_[i] = boundary_.length();
+  for (size_t i = 0; i < last; ++i)
+    boundary_skip_[static_cast<unsigned char>(boundary_[i])] = last - i;
+}
+
 bool MultipartResponseDelegate::ReadMultipartBoundary(
     const WebURLResponse& response,
     std::string* multipart_boundary) {
@@ -111,14 +111,19 @@ class MultipartResponseDelegate {
   // lf, or cr. Returns the number of characters to skip over (0, 1 or 2).
   int PushOverLine(const std::string& data, size_t pos);
 
-  // Tries to parse http headers from the start of data_.  Returns true if it
-  // succeeds and sends a didReceiveResponse to m_client.  Returns false if
-  // the header is incomplete (in which case we just wait for more data).
-  bool ParseHeaders();
+  // Tries to parse http headers from data_, starting at |*pos|.  Returns true
+  // if it succeeds, moves |*pos| past the headers and sends a
+  // didReceiveResponse to m_client.  Returns false if the header is
+  // incomplete (in which case we just wait for more data); the complete lines
+  // are remembered so that they are not scanned again.
+  bool ParseHeaders(size_t* pos);
 
-  // Find the next boundary in data_.  Returns std::string::npos if there's no
-  // full token.
-  size_t FindBoundary();
+  // Find the next boundary in data_, at or after |pos|.  Returns
+  // std::string::npos if there's no full token.
+  size_t FindBoundary(size_t pos);
+
+  // Sets boundary_, and the table used to search for it.
+  void SetBoundary(const std::string& boundary);
 
   // Transferred data size accumulated between client callbacks.
   int encoded_data_length_;
@@ -127,9 +132,17 @@ class MultipartResponseDelegate {
   // gets split in the middle of a header.
   std::string data_;
 
+  // The length of the complete header lines at the start of data_, while
+  // we're truncated in the middle of a header.
+  size_t header_scan_offset_;
+
   // Multipart boundary token
   std::string boundary_;
 
+  // How far the Boyer-Moore-Horspool search for boundary_ can skip ahead,
+  // given the character aligned with the end of the token.
+  size_t boundary_skip_[256];
+
   // true until we get our first on received data call
   bool first_received_data_;
 
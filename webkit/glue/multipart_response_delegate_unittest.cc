@@ -35,9 +35,18 @@ class MultipartResponseDelegateTester {
     return delegate_->PushOverLine(data, pos);
   }
 
-  bool ParseHeaders() { return delegate_->ParseHeaders(); }
-  size_t FindBoundary() { return delegate_->FindBoundary(); }
-  std::string& boundary() { return delegate_->boundary_; }
+  // Parses the headers at the start of data(), and drops them.
+  bool ParseHeaders() {
+    delegate_->header_scan_offset_ = 0;
+    size_t pos = 0;
+    bool rv = delegate_->ParseHeaders(&pos);
+    delegate_->data_.erase(0, pos);
+    return rv;
+  }
+  size_t FindBoundary() { return delegate_->FindBoundary(0); }
+  void SetBoundary(const std::string& boundary) {
+    delegate_->SetBoundary(boundary);
+  }
   std::string& data() { return delegate_->data_; }
 
  private:
@@ -194,7 +203,7 @@ TEST(MultipartResponseTest, Functions) {
     { "bound", "--boundbound", 0 },
   };
   for (size_t i = 0; i < ARRAYSIZE_UNSAFE(boundary_tests); ++i) {
-    delegate_tester.boundary().assign(boundary_tests[i].boundary);
+    delegate_tester.SetBoundary(boundary_tests[i].boundary);
     delegate_tester.data().assign(boundary_tests[i].data);
     EXPECT_EQ(boundary_tests[i].position,
               delegate_tester.FindBoundary());
@@ -469,6 +478,40 @@ TEST(MultipartResponseTest, SmallChunk) {
   EXPECT_EQ(2, client.received_data_);
 }
 
+TEST(MultipartResponseTest, ByteByByte) {
+  // Headers and boundaries split across many reads, and many parts in a
+  // single read.
+  WebURLResponse response;
+  response.initialize();
+  response.setMIMEType("multipart/x-mixed-replace");
+  MockWebURLLoaderClient client;
+  MultipartResponseDelegate delegate(&client, NULL, response, "bound");
+
+  string data("--bound\r\n"
+              "Content-type: image/png\r\n"
+              "Content-length: 20\r\n\r\n"
+              "datadatadatadatadata\r\n"
+              "--bound\r\n"
+              "Content-type: image/jpg\r\n\r\n"
+              "foofoofoofoofoo\r\n");
+  for (size_t i = 0; i < data.length(); ++i)
+    delegate.OnReceivedData(data.c_str() + i, 1, 1);
+  EXPECT_EQ(2, client.received_response_);
+  EXPECT_EQ(string("image/jpg"), client.GetResponseHeader("content-type"));
+  EXPECT_EQ(string("foofoofoofoofoo\r\n"), client.data_);
+
+  string parts;
+  for (int i = 0; i < 100; ++i)
+    parts.append("--bound\r\nContent-type: text/plain\r\n\r\nbar\r\n");
+  parts.append("--bound\r\n\r\nlast--bound--");
+  delegate.OnReceivedData(parts.c_str(), static_cast<int>(parts.length()),
+                          static_cast<int>(parts.length()));
+  EXPECT_EQ(103, client.received_response_);
+  EXPECT_EQ(string("last"), client.data_);
+  EXPECT_EQ(static_cast<int>(data.length() + parts.length()),
+            client.total_encoded_data_length_);
+}
+
 TEST(MultipartResponseTest, MultipleBoundaries) {
   // Test multiple boundaries back to back
   WebURLResponse response;
@@ -12,6 +12,7 @@
 #include "base/process_util.h"
 #include "base/string_util.h"
 #include "base/time.h"
+#include "base/timer.h"
 #include "net/base/data_url.h"
 #include "net/base/load_flags.h"
 #include "net/base/mime_util.h"
@@ -55,6 +56,13 @@ namespace webkit_glue {
 
 namespace {
 
+// After the first chunk of data, which is passed to WebKit right away, small
+// chunks are batched until this many bytes are waiting...
+const size_t kMaxBatchedDataBytes = 32 * 1024;
+
+// ...or the oldest of them has waited this long.
+const int kMaxBatchDelayMs = 10;
+
 class HeaderFlattener : public WebHTTPHeaderVisitor {
  public:
   explicit HeaderFlattener(int load_flags)
@@ -317,6 +325,12 @@ class WebURLLoaderImpl::Context : public base::RefCounted<Context>,
   bool CanHandleDataURL(const GURL& url) const;
   void HandleDataURL();
 
+  // Passes data to the client, or to the delegate that handles it.
+  void DeliverData(const char* data, int data_length, int encoded_data_length);
+
+  // Delivers the batched data, if any.
+  void FlushBatchedData();
+
   WebURLLoaderImpl* loader_;
   WebURLRequest request_;
   WebURLLoaderClient* client_;
@@ -325,13 +339,23 @@ class WebURLLoaderImpl::Context : public base::RefCounted<Context>,
   scoped_ptr<MultipartResponseDelegate> multipart_delegate_;
   scoped_ptr<ResourceLoaderBridge> completed_bridge_;
 
+  // Data received but not delivered yet, and its encoded length.
+  std::string batched_data_;
+  int batched_encoded_data_length_;
+  bool has_delivered_data_;
+  bool defers_loading_;
+  base::OneShotTimer<Context> batch_timer_;
+
   // TODO(japhet): Storing this is a temporary hack for site isolation logging.
   WebURL response_url_;
 };
 
 WebURLLoaderImpl::Context::Context(WebURLLoaderImpl* loader)
     : loader_(loader),
-      client_(NULL) {
+      client_(NULL),
+      batched_encoded_data_length_(0),
+      has_delivered_data_(false),
+      defers_loading_(false) {
 }
 
 void WebURLLoaderImpl::Context::Cancel() {
@@ -345,6 +369,9 @@ void WebURLLoaderImpl::Context::Cancel() {
   if (multipart_delegate_.get())
     multipart_delegate_->Cancel();
 
+  batch_timer_.Stop();
+  batched_data_.clear();
+
   // Do not make any further calls to the client.
   client_ = NULL;
   loader_ = NULL;
@@ -353,6 +380,15 @@ void WebURLLoaderImpl::Context::Cancel() {
 void WebURLLoaderImpl::Context::SetDefersLoading(bool value) {
   if (bridge_.get())
     bridge_->SetDefersLoading(value);
+
+  // The batched data must not be delivered while loading is deferred.
+  defers_loading_ = value;
+  if (defers_loading_) {
+    batch_timer_.Stop();
+  } else if (!batched_data_.empty() && !batch_timer_.IsRunning()) {
+    batch_timer_.Start(TimeDelta::FromMilliseconds(kMaxBatchDelayMs), this,
+                       &Context::FlushBatchedData);
+  }
 }
 
 void WebURLLoaderImpl::Context::Start(
@@ -608,6 +644,36 @@ void WebURLLoaderImpl::Context::OnReceivedData(const char* data,
   // Temporary logging, see site_isolation_metrics.h/cc.
   SiteIsolationMetrics::SniffCrossOriginHTML(response_url_, data, data_length);
 
+  // The first chunk goes out right away, so that the time to first byte
+  // doesn't suffer.  After that, small chunks are batched: each delivery
+  // costs WebKit a round of parsing and layout.
+  if (!has_delivered_data_) {
+    has_delivered_data_ = true;
+    DeliverData(data, data_length, encoded_data_length);
+    return;
+  }
+
+  if (static_cast<size_t>(data_length) >= kMaxBatchedDataBytes) {
+    // Not worth copying.
+    FlushBatchedData();
+    if (client_)
+      DeliverData(data, data_length, encoded_data_length);
+    return;
+  }
+
+  batched_data_.append(data, data_length);
+  batched_encoded_data_length_ += encoded_data_length;
+  if (batched_data_.size() >= kMaxBatchedDataBytes) {
+    FlushBatchedData();
+  } else if (!batch_timer_.IsRunning() && !defers_loading_) {
+    batch_timer_.Start(TimeDelta::FromMilliseconds(kMaxBatchDelayMs), this,
+                       &Context::FlushBatchedData);
+  }
+}
+
+void WebURLLoaderImpl::Context::DeliverData(const char* data,
+                                            int data_length,
+                                            int encoded_data_length) {
   if (ftp_listing_delegate_.get()) {
     // The FTP listing delegate will make the appropriate calls to
     // client_->didReceiveData and client_->didReceiveResponse.
@@ -621,8 +687,23 @@ void WebURLLoaderImpl::Context::OnReceivedData(const char* data,
   }
 }
 
+void WebURLLoaderImpl::Context::FlushBatchedData() {
+  batch_timer_.Stop();
+  if (batched_data_.empty() || !client_)
+    return;
+
+  // The client may cancel us, or receive more data, from inside the call.
+  std::string data;
+  data.swap(batched_data_);
+  int encoded_data_length = batched_encoded_data_length_;
+  batched_encoded_data_length_ = 0;
+  DeliverData(data.data(), static_cast<int>(data.size()), encoded_data_length);
+}
+
 void WebURLLoaderImpl::Context::OnReceivedCachedMetadata(
     const char* data, int len) {
+  // Keep the order in which the bridge sent things.
+  FlushBatchedData();
   if (client_)
     client_->didReceiveCachedMetadata(loader_, data, len);
 }
@@ -631,6 +712,8 @@ void WebURLLoaderImpl::Context::OnCompletedRequest(
     const net::URLRequestStatus& status,
     const std::string& security_info,
     const base::Time& completion_time) {
+  FlushBatchedData();
+
   if (ftp_listing_delegate_.get()) {
     ftp_listing_delegate_->OnCompletedRequest();
     ftp_listing_delegate_.reset(NULL);